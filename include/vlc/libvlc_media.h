@@ -135,6 +135,30 @@ typedef struct libvlc_media_stats_t
     int         i_lost_abuffers;
 } libvlc_media_stats_t;
 
+/**
+ * Statistics of a decoded track
+ *
+ * The percentiles cover about the last second, and are -1 when no sample
+ * was taken. Durations are in microseconds.
+ */
+typedef struct libvlc_media_es_stats_t
+{
+    int         i_id; /**< track ID, as in libvlc_media_track_t */
+    libvlc_track_type_t i_type;
+
+    /* Decoder queue, in blocks */
+    unsigned    i_fifo_depth;
+    unsigned    i_fifo_depth_max; /**< highest depth since the last poll */
+
+    /* 50th, 95th and 99th percentiles */
+    int64_t     i_decode_time_us[3]; /**< time spent decoding a block */
+    int64_t     i_latency_us[3]; /**< from the demuxer to the output */
+
+    /* Audio output drift (positive if late), audio tracks only */
+    bool        b_drift;
+    int64_t     i_drift_us;
+} libvlc_media_es_stats_t;
+
 typedef struct libvlc_audio_track_t
 {
     unsigned    i_channels;
@@ -272,6 +296,11 @@ typedef enum libvlc_media_parse_flag_t
      * when the input is asking for credentials.
      */
     libvlc_media_do_interact    = 0x08,
+    /**
+     * Parse this media before the other pending ones, for instance because
+     * it is currently displayed.
+     */
+    libvlc_media_parse_prioritize = 0x10,
 } libvlc_media_parse_flag_t;
 
 /**
@@ -616,6 +645,22 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API bool libvlc_media_get_stats(libvlc_media_t *p_md,
                                        libvlc_media_stats_t *p_stats);
 
+/**
+ * Get the current statistics about the decoded tracks of the media
+ *
+ * The statistics are updated about once per second while the media plays.
+ *
+ * \version LibVLC 4.0.0 and later.
+ *
+ * \param p_md: media descriptor object
+ * \param p_stats: array of track statistics (allocated by the caller)
+ * \param i_max: number of entries of the array
+ * \return the number of entries filled
+ */
+LIBVLC_API unsigned libvlc_media_get_es_stats(libvlc_media_t *p_md,
+                                              libvlc_media_es_stats_t *p_stats,
+                                              unsigned i_max);
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * vlc_arena.h: arena memory allocator
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_ARENA_H
+#define VLC_ARENA_H 1
+
+/**
+ * \defgroup arena Arena allocator
+ * \ingroup os
+ * @{
+ * \file
+ * Allocation of objects that are all released together.
+ *
+ * An arena carves allocations out of large chunks of memory. There is no
+ * way to release a single allocation: vlc_arena_Clean() releases all of
+ * them at once. This suits parsers building trees of many small objects
+ * that die together, such as style sheets or manifests.
+ *
+ * An arena is not thread-safe.
+ */
+
+struct vlc_arena_chunk;
+
+typedef struct vlc_arena
+{
+    struct vlc_arena_chunk *chunks;
+    size_t chunk_size;
+} vlc_arena_t;
+
+/**
+ * Initializes an arena.
+ *
+ * This function does not allocate any memory.
+ *
+ * \param chunk_size size of the chunks to allocate from the heap,
+ * or 0 for the default
+ */
+VLC_API void vlc_arena_Init(vlc_arena_t *arena, size_t chunk_size);
+
+/**
+ * Releases all the allocations of an arena.
+ *
+ * The arena can be reused afterwards, as if it had just been initialized.
+ */
+VLC_API void vlc_arena_Clean(vlc_arena_t *arena);
+
+/**
+ * Allocates memory from an arena.
+ *
+ * The memory is suitably aligned for any type, and is not initialized.
+ *
+ * \return the allocated memory, or NULL on error
+ */
+VLC_API void *vlc_arena_Alloc(vlc_arena_t *arena, size_t size)
+VLC_USED VLC_MALLOC;
+
+/**
+ * Allocates zeroed memory from an arena, like calloc().
+ *
+ * \return the allocated memory, or NULL on error
+ */
+VLC_API void *vlc_arena_Calloc(vlc_arena_t *arena, size_t count, size_t size)
+VLC_USED VLC_MALLOC;
+
+/**
+ * Resizes an allocation from an arena.
+ *
+ * The last allocation grows in place if the current chunk has room.
+ * Otherwise, the data is copied to a new allocation and the old one is
+ * wasted until vlc_arena_Clean().
+ *
+ * \param ptr allocation to resize, or NULL
+ * \param old_size current size of the allocation
+ * \param size new size
+ * \return the resized allocation, or NULL on error (ptr is left intact)
+ */
+VLC_API void *vlc_arena_Realloc(vlc_arena_t *arena, void *ptr,
+                                size_t old_size, size_t size) VLC_USED;
+
+/**
+ * Duplicates a string into an arena.
+ *
+ * \return the copy, or NULL on error
+ */
+VLC_API char *vlc_arena_Strdup(vlc_arena_t *arena, const char *str)
+VLC_USED VLC_MALLOC;
+
+/** @} */
+
+#endif
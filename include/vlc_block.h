@@ -231,6 +231,34 @@ static inline block_t *block_Duplicate( const block_t *p_block )
     return p_dup;
 }
 
+/**
+ * Shares a block payload.
+ *
+ * Creates another block referencing the same payload, without copying it.
+ * Each block keeps its own properties and payload boundaries, and can be
+ * released independently. The payload is freed with the last reference.
+ *
+ * Shared payloads are read-only: block_Realloc() copies instead of growing
+ * them in place, and block_Unshare() must be used before writing to them.
+ *
+ * @return the new reference on success, NULL on error.
+ */
+VLC_API block_t *block_Share(block_t *) VLC_USED;
+
+/**
+ * Checks whether a block payload is referenced by other blocks.
+ */
+VLC_API bool block_IsShared(const block_t *) VLC_USED;
+
+/**
+ * Makes a block payload writeable.
+ *
+ * If the payload is shared, replaces the block with a private copy.
+ *
+ * @return a writeable block, or NULL on error (the block is released).
+ */
+VLC_API block_t *block_Unshare(block_t *) VLC_USED;
+
 /**
  * Wraps heap in a block.
  *
@@ -480,6 +508,7 @@ VLC_API block_t *block_FifoGet(block_fifo_t *) VLC_USED;
  */
 VLC_API block_t *block_FifoShow(block_fifo_t *);
 
+struct vlc_mem_account;
 typedef struct block_fifo_t vlc_fifo_t;
 
 static inline vlc_queue_t *vlc_fifo_queue(const vlc_fifo_t *fifo)
@@ -626,6 +655,19 @@ VLC_API size_t vlc_fifo_GetCount(const vlc_fifo_t *) VLC_USED;
  */
 VLC_API size_t vlc_fifo_GetBytes(const vlc_fifo_t *) VLC_USED;
 
+/**
+ * Sets the memory account of a FIFO.
+ *
+ * The blocks queued in the FIFO are accounted to the account, see
+ * \ref memstats.
+ *
+ * @warning The FIFO must be locked by the calling thread using
+ * vlc_fifo_Lock(). Otherwise behaviour is undefined.
+ *
+ * @param account memory account, or NULL to stop the accounting
+ */
+VLC_API void vlc_fifo_SetAccount(vlc_fifo_t *, struct vlc_mem_account *);
+
 VLC_USED static inline bool vlc_fifo_IsEmpty(const vlc_fifo_t *fifo)
 {
     return vlc_queue_IsEmpty(vlc_fifo_queue(fifo));
@@ -682,6 +724,88 @@ static inline size_t block_FifoCount (block_fifo_t *fifo)
     return depth;
 }
 
+/**
+ * \defgroup block_spsc Single-producer single-consumer block FIFO
+ *
+ * Lock-free variant of the block FIFO for links with exactly one producer
+ * thread and one consumer thread. Queuing and dequeuing do not take any
+ * lock, and the producer wakes the consumer up only when the FIFO turns
+ * from empty to non-empty.
+ *
+ * Unlike vlc_fifo_t, there is no lock to protect the state of the
+ * owner: links that need to wait on other conditions than the FIFO state,
+ * or with more than one producer, must use vlc_fifo_t.
+ * @{
+ */
+
+typedef struct vlc_spsc_fifo vlc_spsc_fifo_t;
+
+/**
+ * Creates a single-producer single-consumer FIFO.
+ *
+ * \return the FIFO, or NULL on memory error
+ */
+VLC_API vlc_spsc_fifo_t *vlc_spsc_fifo_New(void) VLC_USED;
+
+/**
+ * Destroys a FIFO, releasing the blocks still queued.
+ *
+ * Neither the producer nor the consumer may use the FIFO anymore.
+ */
+VLC_API void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *);
+
+/**
+ * Queues a block or a chain of blocks.
+ *
+ * Only the producer thread may call this function.
+ *
+ * \param block block or chain of blocks (cannot be NULL)
+ */
+VLC_API void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *, block_t *block);
+
+/**
+ * Dequeues the first block, without waiting.
+ *
+ * Only the consumer thread may call this function.
+ *
+ * \return the first block, or NULL if the FIFO is empty
+ */
+VLC_API block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Dequeues the first block, waiting for one if needed.
+ *
+ * Only the consumer thread may call this function.
+ *
+ * \return the first block, or NULL if the FIFO is empty and was killed
+ * with vlc_spsc_fifo_Kill()
+ */
+VLC_API block_t *vlc_spsc_fifo_DequeueKillable(vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Marks the FIFO as dead.
+ *
+ * The consumer dequeues the remaining blocks, then
+ * vlc_spsc_fifo_DequeueKillable() returns NULL instead of waiting.
+ */
+VLC_API void vlc_spsc_fifo_Kill(vlc_spsc_fifo_t *);
+
+/**
+ * Counts the queued blocks.
+ *
+ * The value may be outdated as soon as it is returned.
+ */
+VLC_API size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *) VLC_USED;
+
+/**
+ * Counts the bytes of the queued blocks.
+ *
+ * The value may be outdated as soon as it is returned.
+ */
+VLC_API size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *) VLC_USED;
+
+/** @} */
+
 /** @} */
 
 /** @} */
@@ -75,6 +75,8 @@ struct decoder_owner_callbacks
 
             /* cf.decoder_QueueAudio */
             void    (*queue)( decoder_t *, block_t * );
+            /* cf. decoder_NewAudioBuffer, optional: block_Alloc() if NULL */
+            block_t*(*buffer_new)( decoder_t *, size_t length );
         } audio;
         struct
         {
@@ -474,6 +476,9 @@ static inline int decoder_UpdateAudioFormat( decoder_t *dec )
  * This function will return a new audio buffer usable by a decoder as an
  * output buffer. It must be released with block_Release() or returned it to
  * the caller as a decoder_QueueAudio parameter.
+ *
+ * The owner may recycle the buffers of a stream, as their size is constant
+ * for a given output format.
  */
 VLC_API block_t * decoder_NewAudioBuffer( decoder_t *, int i_nb_samples ) VLC_USED;
 
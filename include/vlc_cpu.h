@@ -55,6 +55,9 @@ unsigned vlc_CPU_raw(void);
 #  define VLC_CPU_AVX2   0x00004000
 #  define VLC_CPU_XOP    0x00008000
 #  define VLC_CPU_FMA4   0x00010000
+/** AVX-512 Foundation, CD, BW, DQ and VL, i.e. the x86-64-v4 subset */
+#  define VLC_CPU_AVX512 0x00020000
+#  define VLC_CPU_AVX_VNNI 0x00040000
 
 # if defined (__MMX__)
 #  define vlc_CPU_MMX() (1)
@@ -122,6 +125,19 @@ unsigned vlc_CPU_raw(void);
 #  define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
 # endif
 
+# if defined (__AVX512F__) && defined (__AVX512CD__) \
+  && defined (__AVX512BW__) && defined (__AVX512DQ__) && defined (__AVX512VL__)
+#  define vlc_CPU_AVX512() (1)
+# else
+#  define vlc_CPU_AVX512() ((vlc_CPU() & VLC_CPU_AVX512) != 0)
+# endif
+
+# ifdef __AVXVNNI__
+#  define vlc_CPU_AVX_VNNI() (1)
+# else
+#  define vlc_CPU_AVX_VNNI() ((vlc_CPU() & VLC_CPU_AVX_VNNI) != 0)
+# endif
+
 # ifdef __3dNOW__
 #  define vlc_CPU_3dNOW() (1)
 # else
@@ -183,6 +199,7 @@ unsigned vlc_CPU_raw(void);
 #  define HAVE_FPU 1
 #  define VLC_CPU_ARM_NEON 0x1
 #  define VLC_CPU_ARM_SVE  0x2
+#  define VLC_CPU_ARM_SVE2 0x4
 
 #  ifdef __ARM_NEON
 #   define vlc_CPU_ARM_NEON() (1)
@@ -196,6 +213,12 @@ unsigned vlc_CPU_raw(void);
 #   define vlc_CPU_ARM_SVE()   ((vlc_CPU() & VLC_CPU_ARM_SVE) != 0)
 #  endif
 
+#  ifdef __ARM_FEATURE_SVE2
+#   define vlc_CPU_ARM_SVE2()  (1)
+#  else
+#   define vlc_CPU_ARM_SVE2()  ((vlc_CPU() & VLC_CPU_ARM_SVE2) != 0)
+#  endif
+
 # elif defined (__sparc__)
 #  define HAVE_FPU 1
 
@@ -212,4 +235,61 @@ unsigned vlc_CPU_raw(void);
 
 # endif
 
+/**
+ * \defgroup cpu_dispatch CPU dispatch
+ * Selection of the best implementation of a function for the running CPU.
+ *
+ * A module builds one table per function, listing its implementations
+ * from the most to the least demanding, each with the CPU flags it
+ * requires. The last entry requires no flags and is the fallback:
+ * \code
+ * static const VLC_CPU_TABLE(amplify_fn) impls[] = {
+ * #ifdef HAVE_AVX2_IMPL
+ *     { VLC_CPU_AVX2, Amplify_AVX2 },
+ * #endif
+ *     { 0, Amplify_C },
+ * };
+ *
+ * sys->amplify = vlc_CPU_Select(impls);
+ * \endcode
+ *
+ * The pointer is resolved once, normally when the module is opened, so that
+ * the processing loops do not check the CPU flags.
+ * @{
+ */
+
+/**
+ * Type of an entry in an implementation table.
+ *
+ * \param type function pointer type
+ */
+#define VLC_CPU_TABLE(type) struct { unsigned cpu; type func; }
+
+static inline size_t vlc_CPU_SelectIndex(const unsigned *cpu, size_t stride,
+                                         size_t count)
+{
+    const unsigned flags = vlc_CPU();
+
+    for (size_t i = 0; i < count - 1; i++)
+    {
+        unsigned required = *(const unsigned *)((const char *)cpu
+                                                + i * stride);
+        if ((flags & required) == required)
+            return i;
+    }
+    return count - 1;
+}
+
+/**
+ * Selects the best implementation from a table.
+ *
+ * \param tab array of VLC_CPU_TABLE() entries, ending with the fallback
+ * \return the function of the first entry supported by the CPU
+ */
+#define vlc_CPU_Select(tab) \
+    ((tab)[vlc_CPU_SelectIndex(&(tab)[0].cpu, sizeof ((tab)[0]), \
+                               ARRAY_SIZE(tab))].func)
+
+/** @} */
+
 #endif /* !VLC_CPU_H */
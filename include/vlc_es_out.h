@@ -24,6 +24,7 @@
 #define VLC_ES_OUT_H 1
 
 #include <assert.h>
+#include <vlc_block.h>
 
 /**
  * \defgroup es_out ES output
@@ -137,6 +138,11 @@ struct es_out_callbacks
      * Private control callback, must be NULL for es_out created from modules.
      */
     int          (*priv_control)(es_out_t *, int query, va_list);
+    /**
+     * Optional callback sending a chain of blocks for the same ES at once.
+     * If NULL, es_out_SendChain() falls back to one send() per block.
+     */
+    int          (*send_chain)(es_out_t *, es_out_id_t *, block_t *);
 };
 
 struct es_out_t
@@ -161,6 +167,30 @@ static inline int es_out_Send( es_out_t *out, es_out_id_t *id,
     return out->cbs->send( out, id, p_block );
 }
 
+/**
+ * Sends a chain of blocks (linked by p_next) to the same ES.
+ *
+ * This is equivalent to calling es_out_Send() for each block in order, but
+ * lets the es_out take its locks and do its checks once per chain.
+ */
+static inline int es_out_SendChain( es_out_t *out, es_out_id_t *id,
+                                    block_t *p_chain )
+{
+    if( out->cbs->send_chain != NULL )
+        return out->cbs->send_chain( out, id, p_chain );
+
+    int i_ret = VLC_SUCCESS;
+    while( p_chain != NULL )
+    {
+        block_t *p_block = p_chain;
+        p_chain = p_block->p_next;
+        p_block->p_next = NULL;
+        if( out->cbs->send( out, id, p_block ) != VLC_SUCCESS )
+            i_ret = VLC_EGENERIC;
+    }
+    return i_ret;
+}
+
 static inline int es_out_vaControl( es_out_t *out, int i_query, va_list args )
 {
     return out->cbs->control( out, NULL, i_query, args );
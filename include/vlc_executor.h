@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * vlc_executor.h: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_EXECUTOR_H
+#define VLC_EXECUTOR_H 1
+
+#include <vlc_list.h>
+
+/**
+ * \defgroup executor Executor
+ * \ingroup threads
+ * @{
+ * \file
+ * Pool of worker threads running short tasks.
+ *
+ * Each worker thread owns a queue of tasks. A task submitted from a worker
+ * thread is queued in the queue of that worker; other tasks are distributed
+ * among the workers. Idle workers steal the oldest tasks from the other
+ * queues.
+ *
+ * The worker threads are started on demand, up to the limit set at creation.
+ * LibVLC provides a pool sized after the number of CPUs, meant for the
+ * parallel work of the modules, see vlc_executor_Get().
+ */
+
+typedef struct vlc_executor vlc_executor_t;
+typedef struct vlc_task_group vlc_task_group_t;
+
+/**
+ * A task to run on the executor.
+ *
+ * The storage is owned by the submitter. It must remain valid until the task
+ * has run, or until it has been cancelled.
+ */
+struct vlc_runnable {
+    /**
+     * Function to run on a worker thread.
+     *
+     * The function may release the storage of the runnable.
+     */
+    void (*run)(void *userdata);
+    void *userdata; /**< data passed to run() */
+
+    /* Private, for the executor */
+    struct vlc_list node;
+    vlc_task_group_t *group;
+};
+
+/**
+ * Creates an executor.
+ *
+ * \param max_threads maximum number of worker threads (must be positive)
+ * \return an executor, or NULL on error
+ */
+VLC_API vlc_executor_t *vlc_executor_New(unsigned max_threads);
+
+/**
+ * Deletes an executor.
+ *
+ * The tasks still queued are run, then the worker threads are joined.
+ * No tasks can be submitted anymore.
+ */
+VLC_API void vlc_executor_Delete(vlc_executor_t *executor);
+
+/**
+ * Gets the executor shared by all the objects of a LibVLC instance.
+ *
+ * This executor has one worker thread per CPU at most. It remains valid as
+ * long as the LibVLC instance.
+ */
+VLC_API vlc_executor_t *vlc_executor_Get(vlc_object_t *obj);
+#define vlc_executor_Get(o) vlc_executor_Get(VLC_OBJECT(o))
+
+/**
+ * Queues a task.
+ *
+ * \retval VLC_SUCCESS the task will be run
+ * \retval VLC_ENOMEM no worker thread could be started
+ */
+VLC_API int vlc_executor_Submit(vlc_executor_t *executor,
+                                struct vlc_runnable *runnable);
+
+/**
+ * Cancels a queued task.
+ *
+ * \retval true the task was removed from its queue and will not run
+ * \retval false the task is running or has already run
+ */
+VLC_API bool vlc_executor_Cancel(vlc_executor_t *executor,
+                                 struct vlc_runnable *runnable);
+
+/**
+ * Calls a function for each index in [0, count).
+ *
+ * The calls are spread over the worker threads of the executor. The calling
+ * thread performs some of the calls, and returns once all calls have
+ * returned. The order of the calls and the thread performing each call are
+ * unspecified, so the calls must not depend on each other.
+ *
+ * This can be called from a task running on the executor.
+ */
+VLC_API void vlc_executor_ParallelFor(vlc_executor_t *executor, size_t count,
+                                      void (*func)(void *opaque, size_t index),
+                                      void *opaque);
+
+/**
+ * Creates a group of tasks.
+ *
+ * A group tracks the completion of a set of tasks, and can cancel them all
+ * at once.
+ */
+VLC_API vlc_task_group_t *vlc_task_group_New(vlc_executor_t *executor);
+
+/**
+ * Deletes a group of tasks.
+ *
+ * This cancels the queued tasks of the group, and waits for the running ones.
+ */
+VLC_API void vlc_task_group_Delete(vlc_task_group_t *group);
+
+/**
+ * Queues a task as part of a group.
+ *
+ * \return same as vlc_executor_Submit()
+ */
+VLC_API int vlc_task_group_Submit(vlc_task_group_t *group,
+                                  struct vlc_runnable *runnable);
+
+/**
+ * Cancels the tasks of a group.
+ *
+ * The queued tasks of the group are removed and will not run. The running
+ * ones can poll vlc_task_group_IsCancelled() to stop early.
+ * The group remains cancelled until it is deleted.
+ */
+VLC_API void vlc_task_group_Cancel(vlc_task_group_t *group);
+
+/**
+ * Checks if a group of tasks has been cancelled.
+ */
+VLC_API bool vlc_task_group_IsCancelled(vlc_task_group_t *group);
+
+/**
+ * Waits for all the tasks of a group to complete.
+ *
+ * While waiting, the calling thread runs the queued tasks of the group.
+ */
+VLC_API void vlc_task_group_Wait(vlc_task_group_t *group);
+
+/** @} */
+
+#endif
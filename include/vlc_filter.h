@@ -51,12 +51,18 @@ struct filter_subpicture_callbacks
     subpicture_t *(*buffer_new)(filter_t *);
 };
 
+struct filter_audio_callbacks
+{
+    block_t *(*buffer_new)(filter_t *, size_t length);
+};
+
 typedef struct filter_owner_t
 {
     union
     {
         const struct filter_video_callbacks *video;
         const struct filter_subpicture_callbacks *sub;
+        const struct filter_audio_callbacks *audio;
     };
     void *sys;
 } filter_owner_t;
@@ -180,6 +186,23 @@ static inline picture_t *filter_NewPicture( filter_t *p_filter )
     return pic;
 }
 
+/**
+ * This function will return a new audio buffer usable by p_filter as an
+ * output buffer. You have to release it using block_Release or by returning
+ * it to the caller as a pf_audio_filter return value.
+ *
+ * \param p_filter filter_t object
+ * \param length payload size in bytes
+ * \return new audio buffer on success or NULL on failure
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter,
+                                              size_t length )
+{
+    if ( p_filter->owner.audio != NULL && p_filter->owner.audio->buffer_new != NULL )
+        return p_filter->owner.audio->buffer_new( p_filter, length );
+    return block_Alloc( length );
+}
+
 /**
  * Flush a filter
  *
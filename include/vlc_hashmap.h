@@ -0,0 +1,419 @@
+/*****************************************************************************
+ * vlc_hashmap.h: open-addressing hash maps
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_HASHMAP_H
+#define VLC_HASHMAP_H 1
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * \defgroup hashmap Hash maps
+ * \ingroup cext
+ * @{
+ * \file
+ * Hash maps of pointers, keyed by strings or by integers.
+ *
+ * The entries are stored in a single array with linear probing and Robin
+ * Hood ordering: an entry never sits further from its home slot than the
+ * entries it passes, which bounds the probe lengths. Removal shifts the
+ * following entries back instead of leaving tombstones.
+ *
+ * Inserting or removing an entry invalidates the pointers returned by the
+ * lookup functions and the ongoing iterations.
+ */
+
+struct vlc_hashmap_slot
+{
+    uint32_t hash;
+    uint32_t dist; /**< distance to the home slot plus one, 0 if free */
+    union
+    {
+        char *str;
+        uint64_t num;
+    } key;
+    void *value;
+};
+
+typedef struct vlc_hashmap
+{
+    struct vlc_hashmap_slot *slots;
+    size_t mask; /**< number of slots minus one */
+    size_t count;
+    bool str_keys;
+} vlc_hashmap_t;
+
+/**
+ * Initializes an empty hash map with string keys.
+ *
+ * The map keeps a copy of each key. No memory is allocated until the first
+ * insertion.
+ */
+static inline void vlc_hashmap_init_str(vlc_hashmap_t *map)
+{
+    map->slots = NULL;
+    map->mask = 0;
+    map->count = 0;
+    map->str_keys = true;
+}
+
+/**
+ * Initializes an empty hash map with integer keys.
+ */
+static inline void vlc_hashmap_init_int(vlc_hashmap_t *map)
+{
+    vlc_hashmap_init_str(map);
+    map->str_keys = false;
+}
+
+/**
+ * Removes all entries from a hash map, and releases its memory.
+ *
+ * \param pf_free callback releasing each value, or NULL
+ * \param opaque data passed to the callback
+ */
+static inline void vlc_hashmap_clear(vlc_hashmap_t *map,
+                                     void (*pf_free)(void *value,
+                                                     void *opaque),
+                                     void *opaque)
+{
+    if (map->slots != NULL)
+    {
+        for (size_t i = 0; i <= map->mask; i++)
+        {
+            struct vlc_hashmap_slot *slot = &map->slots[i];
+
+            if (slot->dist == 0)
+                continue;
+            if (pf_free != NULL)
+                pf_free(slot->value, opaque);
+            if (map->str_keys)
+                free(slot->key.str);
+        }
+        free(map->slots);
+    }
+    map->slots = NULL;
+    map->mask = 0;
+    map->count = 0;
+}
+
+/** Returns the number of entries in a hash map. */
+static inline size_t vlc_hashmap_count(const vlc_hashmap_t *map)
+{
+    return map->count;
+}
+
+static inline uint32_t vlc_hashmap_hash_str_(const char *str)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u;
+
+    while (*str)
+        hash = (hash ^ (unsigned char)*str++) * 16777619u;
+    return hash;
+}
+
+static inline uint32_t vlc_hashmap_hash_int_(uint64_t num)
+{
+    /* Fibonacci hashing: the high bits are well mixed */
+    return (num * UINT64_C(0x9E3779B97F4A7C15)) >> 32;
+}
+
+static inline bool vlc_hashmap_match_(const vlc_hashmap_t *map,
+                                      const struct vlc_hashmap_slot *slot,
+                                      uint32_t hash, const char *str,
+                                      uint64_t num)
+{
+    if (slot->hash != hash)
+        return false;
+    return map->str_keys ? strcmp(slot->key.str, str) == 0
+                         : slot->key.num == num;
+}
+
+static inline struct vlc_hashmap_slot *
+vlc_hashmap_find_(const vlc_hashmap_t *map, uint32_t hash, const char *str,
+                  uint64_t num)
+{
+    if (map->slots == NULL)
+        return NULL;
+
+    for (size_t i = hash & map->mask, dist = 1;; i = (i + 1) & map->mask,
+         dist++)
+    {
+        struct vlc_hashmap_slot *slot = &map->slots[i];
+
+        /* Robin Hood: the key would have displaced this entry */
+        if (slot->dist < dist)
+            return NULL;
+        if (vlc_hashmap_match_(map, slot, hash, str, num))
+            return slot;
+    }
+}
+
+static inline void vlc_hashmap_place_(vlc_hashmap_t *map,
+                                      struct vlc_hashmap_slot entry)
+{
+    entry.dist = 1;
+
+    for (size_t i = entry.hash & map->mask;; i = (i + 1) & map->mask)
+    {
+        struct vlc_hashmap_slot *slot = &map->slots[i];
+
+        if (slot->dist == 0)
+        {
+            *slot = entry;
+            return;
+        }
+        if (slot->dist < entry.dist)
+        {   /* Take from the rich, give to the poor */
+            struct vlc_hashmap_slot tmp = *slot;
+            *slot = entry;
+            entry = tmp;
+        }
+        entry.dist++;
+    }
+}
+
+static inline bool vlc_hashmap_grow_(vlc_hashmap_t *map)
+{
+    size_t size = map->mask + 1;
+
+    /* Keep the load factor below 7/8 */
+    if (map->slots != NULL && (map->count + 1) * 8 <= size * 7)
+        return true;
+
+    size_t new_size = (map->slots != NULL) ? size * 2 : 8;
+    struct vlc_hashmap_slot *slots =
+        (struct vlc_hashmap_slot *)calloc(new_size, sizeof (*slots));
+    if (unlikely(slots == NULL))
+        return false;
+
+    struct vlc_hashmap_slot *old = map->slots;
+
+    map->slots = slots;
+    map->mask = new_size - 1;
+    if (old != NULL)
+    {
+        for (size_t i = 0; i < size; i++)
+            if (old[i].dist != 0)
+                vlc_hashmap_place_(map, old[i]);
+        free(old);
+    }
+    return true;
+}
+
+static inline void vlc_hashmap_erase_(vlc_hashmap_t *map,
+                                      struct vlc_hashmap_slot *slot)
+{
+    size_t i = slot - map->slots;
+
+    if (map->str_keys)
+        free(slot->key.str);
+
+    /* Shift the following displaced entries back */
+    for (;;)
+    {
+        size_t next = (i + 1) & map->mask;
+        struct vlc_hashmap_slot *follow = &map->slots[next];
+
+        if (follow->dist <= 1)
+            break;
+        map->slots[i] = *follow;
+        map->slots[i].dist--;
+        i = next;
+    }
+    map->slots[i].dist = 0;
+    map->count--;
+}
+
+/**
+ * Looks up a string key.
+ *
+ * \return a pointer to the value of the key, or NULL if not found
+ */
+static inline void **vlc_hashmap_str_lookup(const vlc_hashmap_t *map,
+                                            const char *key)
+{
+    assert(map->str_keys);
+    struct vlc_hashmap_slot *slot =
+        vlc_hashmap_find_(map, vlc_hashmap_hash_str_(key), key, 0);
+    return (slot != NULL) ? &slot->value : NULL;
+}
+
+/**
+ * Gets the value of a string key.
+ *
+ * \return the value, or NULL if not found
+ */
+static inline void *vlc_hashmap_str_get(const vlc_hashmap_t *map,
+                                        const char *key)
+{
+    void **value = vlc_hashmap_str_lookup(map, key);
+    return (value != NULL) ? *value : NULL;
+}
+
+/**
+ * Inserts or replaces the value of a string key.
+ *
+ * The previous value of the key, if any, is not released.
+ *
+ * \retval 0 on success
+ * \retval VLC_ENOMEM on memory error
+ */
+static inline int vlc_hashmap_str_insert(vlc_hashmap_t *map, const char *key,
+                                         void *value)
+{
+    assert(map->str_keys);
+
+    uint32_t hash = vlc_hashmap_hash_str_(key);
+    struct vlc_hashmap_slot *slot = vlc_hashmap_find_(map, hash, key, 0);
+    if (slot != NULL)
+    {
+        slot->value = value;
+        return 0;
+    }
+
+    struct vlc_hashmap_slot entry;
+    entry.hash = hash;
+    entry.key.str = strdup(key);
+    entry.value = value;
+    if (unlikely(entry.key.str == NULL) || !vlc_hashmap_grow_(map))
+    {
+        free(entry.key.str);
+        return VLC_ENOMEM;
+    }
+    vlc_hashmap_place_(map, entry);
+    map->count++;
+    return 0;
+}
+
+/**
+ * Removes a string key.
+ *
+ * \return the value of the removed key, or NULL if not found
+ */
+static inline void *vlc_hashmap_str_remove(vlc_hashmap_t *map,
+                                           const char *key)
+{
+    assert(map->str_keys);
+    struct vlc_hashmap_slot *slot =
+        vlc_hashmap_find_(map, vlc_hashmap_hash_str_(key), key, 0);
+    if (slot == NULL)
+        return NULL;
+
+    void *value = slot->value;
+    vlc_hashmap_erase_(map, slot);
+    return value;
+}
+
+/**
+ * Looks up an integer key.
+ *
+ * \return a pointer to the value of the key, or NULL if not found
+ */
+static inline void **vlc_hashmap_int_lookup(const vlc_hashmap_t *map,
+                                            uint64_t key)
+{
+    assert(!map->str_keys);
+    struct vlc_hashmap_slot *slot =
+        vlc_hashmap_find_(map, vlc_hashmap_hash_int_(key), NULL, key);
+    return (slot != NULL) ? &slot->value : NULL;
+}
+
+/**
+ * Gets the value of an integer key.
+ *
+ * \return the value, or NULL if not found
+ */
+static inline void *vlc_hashmap_int_get(const vlc_hashmap_t *map,
+                                        uint64_t key)
+{
+    void **value = vlc_hashmap_int_lookup(map, key);
+    return (value != NULL) ? *value : NULL;
+}
+
+/**
+ * Inserts or replaces the value of an integer key.
+ *
+ * \retval 0 on success
+ * \retval VLC_ENOMEM on memory error
+ */
+static inline int vlc_hashmap_int_insert(vlc_hashmap_t *map, uint64_t key,
+                                         void *value)
+{
+    assert(!map->str_keys);
+
+    uint32_t hash = vlc_hashmap_hash_int_(key);
+    struct vlc_hashmap_slot *slot = vlc_hashmap_find_(map, hash, NULL, key);
+    if (slot != NULL)
+    {
+        slot->value = value;
+        return 0;
+    }
+
+    if (!vlc_hashmap_grow_(map))
+        return VLC_ENOMEM;
+
+    struct vlc_hashmap_slot entry;
+    entry.hash = hash;
+    entry.key.num = key;
+    entry.value = value;
+    vlc_hashmap_place_(map, entry);
+    map->count++;
+    return 0;
+}
+
+/**
+ * Removes an integer key.
+ *
+ * \return the value of the removed key, or NULL if not found
+ */
+static inline void *vlc_hashmap_int_remove(vlc_hashmap_t *map, uint64_t key)
+{
+    assert(!map->str_keys);
+    struct vlc_hashmap_slot *slot =
+        vlc_hashmap_find_(map, vlc_hashmap_hash_int_(key), NULL, key);
+    if (slot == NULL)
+        return NULL;
+
+    void *value = slot->value;
+    vlc_hashmap_erase_(map, slot);
+    return value;
+}
+
+/**
+ * Iterates over the entries of a hash map, in unspecified order.
+ *
+ * \param slot a struct vlc_hashmap_slot pointer, set to each entry in turn:
+ *             the key is slot->key.str or slot->key.num, the value is
+ *             slot->value
+ */
+#define vlc_hashmap_foreach(slot, map) \
+    for (slot = (map)->slots; \
+         (map)->slots != NULL && slot <= &(map)->slots[(map)->mask]; \
+         slot++) \
+        if (slot->dist != 0)
+
+/** @} */
+
+#endif
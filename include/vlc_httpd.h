@@ -138,6 +138,13 @@ VLC_API void httpd_RedirectDelete( httpd_redirect_t * );
 
 typedef struct httpd_stream_t httpd_stream_t;
 VLC_API httpd_stream_t * httpd_StreamNew( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
+/**
+ * Creates a stream keeping all the data sent to it. New connections receive
+ * it from its start, and are closed once they got all of it after
+ * httpd_StreamEnd(). This suits resources generated while being served.
+ */
+VLC_API httpd_stream_t * httpd_StreamNewReplay( httpd_host_t *, const char *psz_url, const char *psz_mime, const char *psz_user, const char *psz_password ) VLC_USED;
+VLC_API void httpd_StreamEnd( httpd_stream_t * );
 VLC_API void httpd_StreamDelete( httpd_stream_t * );
 VLC_API int httpd_StreamHeader( httpd_stream_t *, uint8_t *p_data, int i_data );
 VLC_API int httpd_StreamSend( httpd_stream_t *, const block_t *p_block );
@@ -33,6 +33,7 @@
 #include <vlc_epg.h>
 #include <vlc_events.h>
 #include <vlc_list.h>
+#include <vlc_memstats.h>
 
 #include <string.h>
 
@@ -192,6 +193,8 @@ struct input_item_node_t
     input_item_t *         p_item;
     int                    i_children;
     input_item_node_t      **pp_children;
+    bool                   b_partial; /**< More subtrees of the same item
+                                           follow (see doc/browsing.txt) */
 };
 
 VLC_API void input_item_CopyOptions( input_item_t *p_child, input_item_t *p_parent );
@@ -466,6 +469,7 @@ typedef enum input_item_meta_request_option_t
     META_REQUEST_OPTION_FETCH_NETWORK = 0x08,
     META_REQUEST_OPTION_FETCH_ANY     = 0x0C,
     META_REQUEST_OPTION_DO_INTERACT   = 0x10,
+    META_REQUEST_OPTION_PRIORITY      = 0x20, /**< before pending requests */
 } input_item_meta_request_option_t;
 
 /* status of the on_preparse_ended() callback */
@@ -500,6 +504,45 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+/**
+ * Startup milestones of an input, from its start to its first output
+ */
+enum input_startup_milestone
+{
+    INPUT_STARTUP_SOURCE_OPENED,    /**< access and demuxer opened */
+    INPUT_STARTUP_TRACKS_SELECTED,  /**< tracks created and selected */
+    INPUT_STARTUP_DECODER_OPENED,   /**< first decoder opened */
+    INPUT_STARTUP_FIRST_DECODED,    /**< first frame decoded */
+    INPUT_STARTUP_FIRST_OUTPUT,     /**< first picture displayed or first
+                                         audio buffer played */
+};
+#define INPUT_STARTUP_COUNT (INPUT_STARTUP_FIRST_OUTPUT + 1)
+
+/** Maximum number of elementary streams with statistics */
+#define INPUT_STATS_MAX_ES 16
+
+/** Percentiles of the per-ES timings: 50th, 95th and 99th */
+#define INPUT_STATS_PERCENTILE_COUNT 3
+
+/**
+ * Statistics of a decoded elementary stream
+ *
+ * The percentiles cover the interval since the previous statistics update,
+ * and are VLC_TICK_INVALID if no sample was taken.
+ */
+struct input_es_stats_t
+{
+    int i_id; /**< ES input ID */
+    int i_cat; /**< ES category (enum es_format_category_e) */
+
+    unsigned i_fifo_depth; /**< blocks in the decoder FIFO */
+    unsigned i_fifo_depth_max; /**< highest FIFO depth since the previous
+                                    update */
+    vlc_tick_t decode_time[INPUT_STATS_PERCENTILE_COUNT];
+    vlc_tick_t latency[INPUT_STATS_PERCENTILE_COUNT]; /**< demux to output */
+    vlc_tick_t drift; /**< audio output drift, or VLC_TICK_INVALID */
+};
+
 struct input_stats_t
 {
     /* Input */
@@ -517,6 +560,8 @@ struct input_stats_t
     /* Decoders */
     int64_t i_decoded_audio;
     int64_t i_decoded_video;
+    int64_t i_pooled_abuffers; /**< audio buffers recycled by the decoders */
+    int64_t i_allocated_abuffers; /**< audio buffers allocated (pool miss) */
 
     /* Vout */
     int64_t i_displayed_pictures;
@@ -525,6 +570,23 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Startup, delays since the input was started, or VLC_TICK_INVALID if
+     * the milestone was not reached */
+    vlc_tick_t startup[INPUT_STARTUP_COUNT];
+
+    /* Input clock of a live source, VLC_TICK_INVALID if the pace is
+     * controlled */
+    vlc_tick_t clock_drift; /**< stream clock drift from the system clock */
+    vlc_tick_t clock_jitter; /**< clock references arrival jitter */
+
+    /* Heap allocations per second and per pipeline stage (process-wide),
+     * only counted with the "mem-stats" option */
+    float f_allocations[VLC_MEM_STAGE_COUNT];
+
+    /* Elementary streams with a decoder */
+    unsigned i_es;
+    struct input_es_stats_t es[INPUT_STATS_MAX_ES];
 };
 
 /**
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * vlc_memstats.h: memory accounting
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MEMSTATS_H
+#define VLC_MEMSTATS_H 1
+
+/**
+ * \defgroup memstats Memory accounting
+ * \ingroup os
+ * @{
+ * \file
+ * Accounting of the memory held by the blocks, the pictures and the
+ * buffers of the objects.
+ *
+ * The accounting is enabled with the "mem-stats" option. The core always
+ * accounts the blocks and the software pictures. Objects holding large
+ * buffers or queues account them with their own account, so that the
+ * memory piling up can be attributed to its owner.
+ *
+ * Each account keeps the current number of allocations, the current size
+ * and the peak size, updated without locking.
+ */
+
+typedef struct vlc_mem_account vlc_mem_account_t;
+
+/**
+ * Creates an account.
+ *
+ * \param owner object owning the accounted memory
+ * \param name short description of the memory, e.g. "decoder FIFO"
+ * \return the account, or NULL if the accounting is disabled
+ */
+VLC_API vlc_mem_account_t *vlc_mem_account_New(vlc_object_t *owner,
+                                               const char *name);
+#define vlc_mem_account_New(o, n) vlc_mem_account_New(VLC_OBJECT(o), n)
+
+/**
+ * Deletes an account.
+ *
+ * \param account the account (NULL is ignored)
+ */
+VLC_API void vlc_mem_account_Delete(vlc_mem_account_t *account);
+
+/**
+ * Accounts allocations.
+ *
+ * \param account the account (NULL is ignored)
+ * \param count number of allocations
+ * \param bytes total size of the allocations
+ */
+VLC_API void vlc_mem_account_Add(vlc_mem_account_t *account, size_t count,
+                                 size_t bytes);
+
+/**
+ * Accounts deallocations.
+ *
+ * \param account the account (NULL is ignored)
+ * \param count number of allocations
+ * \param bytes total size of the allocations
+ */
+VLC_API void vlc_mem_account_Sub(vlc_mem_account_t *account, size_t count,
+                                 size_t bytes);
+
+/** Memory usage of an account */
+struct vlc_mem_usage
+{
+    char name[64]; /**< account name, and owner object type */
+    const void *owner; /**< owner object, or NULL for the core accounts */
+    size_t count; /**< live allocations */
+    size_t bytes; /**< current size */
+    size_t peak; /**< highest size */
+};
+
+/**
+ * Gets the memory usage of all accounts.
+ *
+ * The core accounts for the blocks and the pictures come first.
+ *
+ * \param tab table to fill
+ * \param max size of the table
+ * \return the number of accounts, which may exceed max
+ */
+VLC_API size_t vlc_mem_GetUsage(struct vlc_mem_usage *tab, size_t max);
+
+/**
+ * Pipeline stages, to which the allocations are attributed.
+ *
+ * When the accounting is enabled, the core counts the heap allocations of
+ * blocks (block cache misses), pictures, subpictures and ES format copies,
+ * per stage of the thread doing them. In steady state, a well-behaved
+ * pipeline recycles its buffers and does not allocate anymore.
+ */
+enum vlc_mem_stage
+{
+    VLC_MEM_STAGE_OTHER,
+    VLC_MEM_STAGE_DEMUX,
+    VLC_MEM_STAGE_PACKETIZER,
+    VLC_MEM_STAGE_DECODER,
+    VLC_MEM_STAGE_VOUT,
+    VLC_MEM_STAGE_AOUT,
+};
+#define VLC_MEM_STAGE_COUNT (VLC_MEM_STAGE_AOUT + 1)
+
+/**
+ * Sets the pipeline stage of the calling thread.
+ *
+ * \param stage the new stage
+ * \return the previous stage, to be restored afterwards if needed
+ */
+VLC_API enum vlc_mem_stage vlc_mem_SetStage(enum vlc_mem_stage stage);
+
+/**
+ * Gets the number of allocations per pipeline stage.
+ *
+ * The counters only increase, from the time the accounting was enabled.
+ *
+ * \param tab table of VLC_MEM_STAGE_COUNT counters to fill
+ */
+VLC_API void vlc_mem_GetAllocations(uint64_t tab[VLC_MEM_STAGE_COUNT]);
+
+/** @} */
+
+#endif
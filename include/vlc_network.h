@@ -292,6 +292,28 @@ VLC_API int vlc_getaddrinfo (const char *, unsigned,
 VLC_API int vlc_getaddrinfo_i11e(const char *, unsigned,
                                  const struct addrinfo *, struct addrinfo **);
 
+/**
+ * Resolves a host name through the process-wide DNS cache.
+ *
+ * This behaves as vlc_getaddrinfo_i11e(), but a recent resolution of the same
+ * name with the same hints is reused if the "dns-cache-ttl" option allows.
+ * The cache is bypassed if the object is NULL.
+ *
+ * \warning The result must be released with vlc_dns_Free(), not with
+ * freeaddrinfo().
+ */
+VLC_API int vlc_dns_Resolve(vlc_object_t *, const char *, unsigned,
+                            const struct addrinfo *, struct addrinfo **);
+VLC_API void vlc_dns_Free(struct addrinfo *);
+
+/**
+ * Resolves a host name in the background, so that a later TCP connection to
+ * it does not wait for the DNS.
+ *
+ * This is meant to warm up the addresses of the media likely played next.
+ */
+VLC_API void vlc_dns_Prefetch(vlc_object_t *, const char *);
+
 static inline bool
 net_SockAddrIsMulticast (const struct sockaddr *addr, socklen_t len)
 {
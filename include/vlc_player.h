@@ -3077,6 +3077,23 @@ struct vlc_player_cbs
      * @param data opaque pointer set by vlc_player_AddListener()
      */
     void (*on_playback_restore_queried)(vlc_player_t *player, void *data);
+
+    /**
+     * Called when the current media reached a startup milestone
+     *
+     * Each milestone is reported once per media, in order to attribute the
+     * delay between vlc_player_Start() and the first output. The delays are
+     * also available from the input_stats_t startup array.
+     *
+     * @note the statistics must be enabled (the "stats" option)
+     *
+     * @param player locked player instance
+     * @param milestone the reached milestone
+     * @param delay delay since the media was started
+     * @param data opaque pointer set by vlc_player_AddListener()
+     */
+    void (*on_startup_milestone)(vlc_player_t *player,
+        enum input_startup_milestone milestone, vlc_tick_t delay, void *data);
 };
 
 /**
@@ -120,6 +120,15 @@ struct stream_t
      */
     int         (*pf_readdir)(stream_t *, input_item_node_t *);
 
+    /**
+     * Directory batch size.
+     *
+     * Set by vlc_stream_ReadDirBatch(), 0 if the whole directory must be
+     * read at once. A directory supporting partial reads may return 1 from
+     * \ref stream_t.pf_readdir after adding that many items to the node.
+     */
+    size_t      i_readdir_batch;
+
     int         (*pf_demux)(stream_t *);
 
     /**
@@ -146,6 +155,15 @@ struct stream_t
     void *p_sys;
 };
 
+/**
+ * Byte range of a stream (see STREAM_SET_READAHEAD_PLAN)
+ */
+struct vlc_stream_range
+{
+    uint64_t offset; /**< Offset of the first byte */
+    uint64_t length; /**< Length in bytes */
+};
+
 /**
  * Possible commands to send to vlc_stream_Control() and vlc_stream_vaControl()
  */
@@ -168,6 +186,7 @@ enum stream_query_e
     STREAM_GET_CONTENT_TYPE,    /**< arg1= char **         res=can fail */
     STREAM_GET_SIGNAL,      /**< arg1=double *pf_quality, arg2=double *pf_strength   res=can fail */
     STREAM_GET_TAGS,        /**< arg1=const block_t ** res=can fail */
+    STREAM_GET_BUFFERED,    /**< arg1=const void **, arg2=size_t * res=can fail */
 
     STREAM_SET_PAUSE_STATE = 0x200, /**< arg1= bool        res=can fail */
     STREAM_SET_TITLE,       /**< arg1= int          res=can fail */
@@ -175,6 +194,7 @@ enum stream_query_e
 
     /* XXX only data read through vlc_stream_Read/Block will be recorded */
     STREAM_SET_RECORD_STATE,     /**< arg1=bool, arg2=const char *psz_ext (if arg1 is true)  res=can fail */
+    STREAM_SET_READAHEAD_PLAN,   /**< arg1= const struct vlc_stream_range *, arg2= size_t  res=can fail */
 
     STREAM_SET_PRIVATE_ID_STATE = 0x1000, /* arg1= int i_private_data, bool b_selected    res=can fail */
     STREAM_SET_PRIVATE_ID_CA,             /* arg1= void * */
@@ -324,6 +344,24 @@ VLC_API char *vlc_stream_ReadLine(stream_t *);
  */
 VLC_API int vlc_stream_ReadDir(stream_t *s, input_item_node_t *node);
 
+/**
+ * Reads a directory in batches.
+ *
+ * This function works like vlc_stream_ReadDir(), except that the directory
+ * may stop after adding about \p max items, so that the caller can handle
+ * them before the whole directory is read. The function must then be called
+ * again, with a new node, to read the next items.
+ *
+ * \param s directory object to read from
+ * \param node node to store the items into
+ * \param max number of items to read before returning (0 for all)
+ * \retval 1 more items remain to be read
+ * \retval VLC_SUCCESS the whole directory has been read
+ * \retval negative an error occurred
+ */
+VLC_API int vlc_stream_ReadDirBatch(stream_t *s, input_item_node_t *node,
+                                    size_t max);
+
 /**
  * Closes a byte stream.
  * \param s byte stream to close
@@ -340,6 +378,50 @@ VLC_USED static inline int vlc_stream_GetSize( stream_t *s, uint64_t *size )
     return vlc_stream_Control( s, STREAM_GET_SIZE, size );
 }
 
+/**
+ * Gets the data already buffered at the current stream offset, if any.
+ *
+ * Unlike vlc_stream_Peek(), this never blocks nor copies. The returned run
+ * is contiguous and remains valid until the next read/peek/seek operation on
+ * the same stream. Use vlc_stream_Seek() to consume it.
+ *
+ * Stream filters that change the data (e.g. adf, aribcam, inflate) must
+ * refuse this query, as the source data is not what they output.
+ *
+ * \param bufp storage space for the buffer address [OUT]
+ * \param lenp storage space for the number of bytes available [OUT]
+ * \return VLC_SUCCESS if some data is buffered, an error code otherwise
+ */
+VLC_USED static inline int vlc_stream_GetBuffered( stream_t *s,
+                                                   const void **bufp,
+                                                   size_t *lenp )
+{
+    return vlc_stream_Control( s, STREAM_GET_BUFFERED, bufp, lenp );
+}
+
+/**
+ * Announces the byte ranges that will be read next.
+ *
+ * Demuxers that know their upcoming reads from an index (e.g. sample tables)
+ * can pass them as a hint, so that the access and the stream filters fetch
+ * those ranges instead of guessing from the read pattern. The plan replaces
+ * the previous one, and an empty plan clears it.
+ *
+ * This does not move the stream offset: the ranges must still be seeked to
+ * and read as usual. The ranges are copied if needed.
+ *
+ * \param ranges ranges sorted by offset, not overlapping
+ * \param count number of ranges
+ * \return VLC_SUCCESS if the hint was taken into account, an error code
+ * otherwise
+ */
+static inline int vlc_stream_SetReadAheadPlan( stream_t *s,
+                                        const struct vlc_stream_range *ranges,
+                                        size_t count )
+{
+    return vlc_stream_Control( s, STREAM_SET_READAHEAD_PLAN, ranges, count );
+}
+
 static inline int64_t stream_Size( stream_t *s )
 {
     uint64_t i_pos;
@@ -104,6 +104,17 @@ struct vlc_spu_highlight_t
  */
 VLC_API subpicture_region_t * subpicture_region_New( const video_format_t *p_fmt );
 
+/**
+ * This function will create a new subpicture region sharing an existing
+ * picture instead of allocating one.
+ *
+ * The picture is held by the region: its pixels must not be modified while
+ * the region is in use. The region format is taken from the picture.
+ *
+ * You must use subpicture_region_Delete to destroy it.
+ */
+VLC_API subpicture_region_t * subpicture_region_ForPicture( picture_t *p_picture );
+
 /**
  * This function will destroy a subpicture region allocated by
  * subpicture_region_New.
@@ -43,6 +43,23 @@ typedef struct vlc_thumbnailer_request_t vlc_thumbnailer_request_t;
  */
 typedef void(*vlc_thumbnailer_cb)( void* data, picture_t* thumbnail );
 
+/**
+ * \brief vlc_thumbnailer_batch_cb defines a callback invoked for each
+ * thumbnail of a batch request, on completion or error
+ *
+ * This callback will be called once per requested time, in the order of the
+ * requested times, provided vlc_thumbnailer_RequestBatch returned a non-NULL
+ * request. The picture follows the same rules as for vlc_thumbnailer_cb.
+ *
+ * \param data Is the opaque pointer passed as vlc_thumbnailer_RequestBatch
+ *             last parameter
+ * \param index The index of the requested time
+ * \param thumbnail The generated thumbnail, or NULL in case of failure or
+ *                  timeout
+ */
+typedef void(*vlc_thumbnailer_batch_cb)( void* data, size_t index,
+                                         picture_t* thumbnail );
+
 
 /**
  * \brief vlc_thumbnailer_Create Creates a thumbnailer object
@@ -59,6 +76,9 @@ enum vlc_thumbnailer_seek_speed
     VLC_THUMBNAILER_SEEK_PRECISE,
     /** Fast, but potentially imprecise */
     VLC_THUMBNAILER_SEEK_FAST,
+    /** Fastest, the thumbnail is the keyframe found at or before the
+     * requested time, and the other frames are not decoded */
+    VLC_THUMBNAILER_SEEK_KEYFRAME,
 };
 
 /**
@@ -112,6 +132,34 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
                               input_item_t *input_item, vlc_tick_t timeout,
                               vlc_thumbnailer_cb cb, void* user_data );
 
+/**
+ * \brief vlc_thumbnailer_RequestBatch Requests thumbnails at several times
+ * \param thumbnailer A thumbnailer object
+ * \param times The times at which the thumbnails should be taken
+ * \param count The number of times, must not be 0
+ * \param speed The seeking speed \sa{enum vlc_thumbnailer_seek_speed}
+ * \param input_item The input item to generate the thumbnails for
+ * \param timeout A timeout value for the whole batch, or VLC_TICK_INVALID to
+ *                disable timeout
+ * \param cb A user callback to be called for each thumbnail
+ * \param user_data An opaque value, provided as pf_cb's first parameter
+ * \return An opaque request object, or NULL in case of failure
+ *
+ * The input item is opened only once, and seeked to each time in turn, which
+ * is much faster than as many single requests, for instance to generate the
+ * previews of a seek bar. Sorting the times increases the efficiency.
+ * If this function returns a valid request object, the callback is guaranteed
+ * to be called once per time, even in case of later failure.
+ * The returned request object must not be used after the last callback has
+ * been invoked. The times array is copied.
+ */
+VLC_API vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data );
+
 /**
  * \brief vlc_thumbnailer_Cancel Cancel a thumbnail request
  * \param thumbnailer A thumbnailer object
@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * vlc_tracer.h: tracing interface
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TRACER_H
+#define VLC_TRACER_H 1
+
+/**
+ * \defgroup tracer Tracer
+ * \ingroup os
+ * @{
+ * \file
+ * Timing instrumentation of the playback pipeline.
+ *
+ * A tracer module, selected with the "tracer" option, receives timed spans
+ * and counters from the core and the modules. Without a tracer, the tracer
+ * of every object is NULL and the helpers below return immediately, without
+ * even reading the clock.
+ *
+ * Objects should look their tracer up once, with vlc_object_get_tracer(),
+ * and keep it for their lifetime.
+ */
+
+struct vlc_tracer;
+
+enum vlc_trace_type
+{
+    VLC_TRACE_SPAN, /**< timed section */
+    VLC_TRACE_COUNTER, /**< sampled value */
+};
+
+/**
+ * Trace event.
+ *
+ * The strings must be static, or at least remain valid for the lifetime of
+ * the tracer.
+ */
+struct vlc_trace_event
+{
+    enum vlc_trace_type type;
+    const char *category; /**< subsystem, e.g. "decoder" */
+    const char *name; /**< step or value name */
+    const void *object; /**< originating object, or NULL */
+    unsigned long thread; /**< originating thread ID */
+    vlc_tick_t ts; /**< span start date, or counter date */
+    vlc_tick_t duration; /**< span duration */
+    int64_t value; /**< counter value */
+};
+
+/**
+ * Tracer module operations.
+ *
+ * The trace callback is invoked concurrently from any thread.
+ */
+struct vlc_tracer_operations
+{
+    void (*trace)(void *sys, const struct vlc_trace_event *event);
+    void (*destroy)(void *sys);
+};
+
+/**
+ * Gets the tracer of an object.
+ *
+ * \return the tracer of the LibVLC instance, or NULL if tracing is disabled
+ */
+VLC_API struct vlc_tracer *vlc_object_get_tracer(vlc_object_t *obj);
+#define vlc_object_get_tracer(o) vlc_object_get_tracer(VLC_OBJECT(o))
+
+/**
+ * Emits a trace event.
+ *
+ * The thread member of the event is set by this function.
+ */
+VLC_API void vlc_tracer_Emit(struct vlc_tracer *tracer,
+                             struct vlc_trace_event *event);
+
+/**
+ * Starts a span.
+ *
+ * \return the start date to pass to vlc_tracer_End()
+ */
+static inline vlc_tick_t vlc_tracer_Begin(struct vlc_tracer *tracer)
+{
+    return (tracer != NULL) ? vlc_tick_now() : VLC_TICK_INVALID;
+}
+
+/**
+ * Ends a span started with vlc_tracer_Begin().
+ */
+static inline void vlc_tracer_End(struct vlc_tracer *tracer,
+                                  const char *category, const char *name,
+                                  const void *object, vlc_tick_t start)
+{
+    if (tracer == NULL)
+        return;
+
+    struct vlc_trace_event event;
+
+    event.type = VLC_TRACE_SPAN;
+    event.category = category;
+    event.name = name;
+    event.object = object;
+    event.ts = start;
+    event.duration = vlc_tick_now() - start;
+    event.value = 0;
+    vlc_tracer_Emit(tracer, &event);
+}
+
+/**
+ * Samples a counter.
+ */
+static inline void vlc_tracer_Counter(struct vlc_tracer *tracer,
+                                      const char *category, const char *name,
+                                      const void *object, int64_t value)
+{
+    if (tracer == NULL)
+        return;
+
+    struct vlc_trace_event event;
+
+    event.type = VLC_TRACE_COUNTER;
+    event.category = category;
+    event.name = name;
+    event.object = object;
+    event.ts = vlc_tick_now();
+    event.duration = 0;
+    event.value = value;
+    vlc_tracer_Emit(tracer, &event);
+}
+
+/** @} */
+
+#endif
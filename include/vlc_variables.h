@@ -746,6 +746,53 @@ static inline void *var_InheritAddress( vlc_object_t *obj, const char *name )
 VLC_API int var_InheritURational(vlc_object_t *obj, unsigned *num,
                                  unsigned *den, const char *name);
 
+/**
+ * Returns the generation of the inheritable values.
+ *
+ * The generation changes whenever a variable is created, destroyed or set on
+ * any object, or a configuration item is changed. It is never zero.
+ */
+VLC_API unsigned var_GetGeneration(void) VLC_USED;
+
+/**
+ * Snapshot of inherited values.
+ *
+ * Code reading the same options repeatedly can inherit them once into plain
+ * fields of its own, and refresh them only when the snapshot is stale:
+ * \code
+ * if (var_SnapshotUpdate(&sys->snapshot))
+ *     sys->osd = var_InheritBool(obj, "osd");
+ * \endcode
+ * Any variable or configuration change invalidates all snapshots.
+ */
+typedef struct vlc_var_snapshot
+{
+    unsigned generation;
+} vlc_var_snapshot_t;
+
+/** Initializes a snapshot as stale. */
+static inline void var_SnapshotInit(vlc_var_snapshot_t *snapshot)
+{
+    snapshot->generation = 0;
+}
+
+/**
+ * Checks whether a snapshot is stale, and marks it up to date.
+ *
+ * \retval true if the values must be inherited again
+ * \retval false if the values are still current
+ */
+VLC_USED
+static inline bool var_SnapshotUpdate(vlc_var_snapshot_t *snapshot)
+{
+    unsigned generation = var_GetGeneration();
+
+    if (snapshot->generation == generation)
+        return false;
+    snapshot->generation = generation;
+    return true;
+}
+
 /**
  * Parses a string with multiple options.
  *
@@ -120,6 +120,55 @@ static inline void video_splitter_DeletePicture( video_splitter_t *p_splitter,
         picture_Release(pp_picture[i]);
 }
 
+static inline void video_splitter_DestroyView(picture_t *view)
+{
+    picture_Release((picture_t *)view->p_sys);
+}
+
+/**
+ * It will create an output picture referencing a part of the source picture.
+ *
+ * No pixels are copied: the output shares the planes of the source, which is
+ * held until the output is released. The chroma of the source must describe
+ * its planes, and x must be a multiple of the chroma macro-pixel width.
+ *
+ * \param index output the picture is created for, also defining its size
+ * \param x horizontal offset in the source, in pixels of the first plane
+ * \param y vertical offset in the source, in lines of the first plane
+ */
+static inline picture_t *video_splitter_NewView(video_splitter_t *splitter,
+                                                int index, picture_t *src,
+                                                unsigned x, unsigned y)
+{
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription(src->format.i_chroma);
+    if (desc == NULL || desc->plane_count == 0)
+        return NULL;
+
+    picture_resource_t res = {
+        .p_sys = src,
+        .pf_destroy = video_splitter_DestroyView,
+    };
+    for (int i = 0; i < src->i_planes; i++) {
+        const plane_t *p = &src->p[i];
+        const unsigned offset_x = x * desc->p[i].w.num / desc->p[i].w.den;
+        const unsigned offset_y = y * desc->p[i].h.num / desc->p[i].h.den;
+
+        res.p[i].p_pixels = p->p_pixels + offset_y * p->i_pitch
+                                        + offset_x * desc->pixel_size;
+        res.p[i].i_lines = p->i_lines - offset_y;
+        res.p[i].i_pitch = p->i_pitch;
+    }
+
+    picture_t *view = picture_NewFromResource(&splitter->p_output[index].fmt,
+                                              &res);
+    if (view == NULL)
+        return NULL;
+    picture_Hold(src);
+    picture_CopyProperties(view, src);
+    return view;
+}
+
 /* */
 video_splitter_t * video_splitter_New( vlc_object_t *, const char *psz_name, const video_format_t * );
 void video_splitter_Delete( video_splitter_t * );
@@ -703,6 +703,66 @@ bool libvlc_media_get_stats(libvlc_media_t *p_md,
     return true;
 }
 
+static_assert(
+    ARRAY_SIZE(((libvlc_media_es_stats_t *)0)->i_decode_time_us)
+        == INPUT_STATS_PERCENTILE_COUNT &&
+    ARRAY_SIZE(((libvlc_media_es_stats_t *)0)->i_latency_us)
+        == INPUT_STATS_PERCENTILE_COUNT,
+    "Mismatch between libvlc_media_es_stats_t and input_es_stats_t" );
+
+static int64_t es_stats_GetUs( vlc_tick_t duration )
+{
+    return duration != VLC_TICK_INVALID ? US_FROM_VLC_TICK( duration ) : -1;
+}
+
+unsigned libvlc_media_get_es_stats( libvlc_media_t *p_md,
+                                    libvlc_media_es_stats_t *p_stats,
+                                    unsigned i_max )
+{
+    input_item_t *item = p_md->p_input_item;
+    unsigned count = 0;
+
+    vlc_mutex_lock( &item->lock );
+
+    const input_stats_t *p_itm_stats = item->p_stats;
+    if( p_itm_stats != NULL )
+        count = __MIN( p_itm_stats->i_es, i_max );
+
+    for( unsigned i = 0; i < count; i++ )
+    {
+        const struct input_es_stats_t *es = &p_itm_stats->es[i];
+        libvlc_media_es_stats_t *out = &p_stats[i];
+
+        out->i_id = es->i_id;
+        switch( es->i_cat )
+        {
+            case VIDEO_ES:
+                out->i_type = libvlc_track_video;
+                break;
+            case AUDIO_ES:
+                out->i_type = libvlc_track_audio;
+                break;
+            case SPU_ES:
+                out->i_type = libvlc_track_text;
+                break;
+            default:
+                out->i_type = libvlc_track_unknown;
+        }
+        out->i_fifo_depth = es->i_fifo_depth;
+        out->i_fifo_depth_max = es->i_fifo_depth_max;
+        for( size_t j = 0; j < INPUT_STATS_PERCENTILE_COUNT; j++ )
+        {
+            out->i_decode_time_us[j] = es_stats_GetUs( es->decode_time[j] );
+            out->i_latency_us[j] = es_stats_GetUs( es->latency[j] );
+        }
+        out->b_drift = es->drift != VLC_TICK_INVALID;
+        out->i_drift_us = out->b_drift ? US_FROM_VLC_TICK( es->drift ) : 0;
+    }
+
+    vlc_mutex_unlock( &item->lock );
+    return count;
+}
+
 // Get event manager from a media descriptor object
 libvlc_event_manager_t *
 libvlc_media_event_manager( libvlc_media_t * p_md )
@@ -765,6 +825,8 @@ static int media_parse(libvlc_media_t *media, bool b_async,
             parse_scope |= META_REQUEST_OPTION_FETCH_NETWORK;
         if (parse_flag & libvlc_media_do_interact)
             parse_scope |= META_REQUEST_OPTION_DO_INTERACT;
+        if (parse_flag & libvlc_media_parse_prioritize)
+            parse_scope |= META_REQUEST_OPTION_PRIORITY;
 
         ret = libvlc_MetadataRequest(libvlc, item, parse_scope,
                                      &input_preparser_callbacks, media,
@@ -309,6 +309,19 @@ typedef struct
     unsigned            cur_seekpoint;
     unsigned            updates;
 
+    /* Titles info parsed in the background (non menu mode) */
+    struct
+    {
+        vlc_thread_t    thread;
+        bool            b_running;
+        atomic_bool     b_abort;
+        atomic_bool     b_pending;  /* titles to publish */
+        bool            b_complete; /* all titles parsed */
+        vlc_mutex_t     lock;
+        input_title_t   **pp_title; /* parsed, not published yet */
+        char            *psz_key;   /* titles cache key */
+    } scan;
+
     /* Events */
     DECL_ARRAY(BD_EVENT) events_delayed;
 
@@ -526,6 +539,8 @@ static int   blurayControl(demux_t *, int, va_list);
 static int   blurayDemux(demux_t *);
 
 static void  blurayInitTitles(demux_t *p_demux, uint32_t menu_titles);
+static void  blurayPublishTitles(demux_t *p_demux);
+static void  blurayCacheTitles(demux_sys_t *p_sys);
 static int   bluraySetTitle(demux_t *p_demux, int i_title);
 
 static void  blurayOverlayProc(void *ptr, const BD_OVERLAY * const overlay);
@@ -870,6 +885,7 @@ static int blurayOpen(vlc_object_t *object)
     vlc_mouse_Init(&p_sys->oldmouse);
 
     vlc_mutex_init(&p_sys->pl_info_lock);
+    vlc_mutex_init(&p_sys->scan.lock);
     vlc_mutex_init(&p_sys->bdj.lock);
     vlc_mutex_init(&p_sys->read_block_lock); /* used during bd_open_stream() */
 
@@ -1100,6 +1116,17 @@ static void blurayClose(vlc_object_t *object)
 
     setTitleInfo(p_sys, NULL);
 
+    /* The titles scan uses libbluray */
+    if (p_sys->scan.b_running) {
+        atomic_store(&p_sys->scan.b_abort, true);
+        vlc_join(p_sys->scan.thread, NULL);
+        blurayPublishTitles(p_demux);
+        if (p_sys->scan.b_complete)
+            blurayCacheTitles(p_sys);
+    }
+    free(p_sys->scan.pp_title);
+    free(p_sys->scan.psz_key);
+
     /*
      * Close libbluray first.
      * This will close all the overlays before we release p_vout
@@ -2239,6 +2266,188 @@ static void blurayUpdateTitleInfo(input_title_t *t, BLURAY_TITLE_INFO *title_inf
     }
 }
 
+/*
+ * Titles of the recently played discs. Parsing the titles info reads every
+ * playlist, which takes a while on slow drives, so it is only done once per
+ * disc (until evicted).
+ */
+#define BLURAY_TITLES_CACHE_SIZE 4
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned    i_next;
+    struct
+    {
+        char           *psz_key;
+        unsigned       i_title;
+        input_title_t  **pp_title;
+    } entries[BLURAY_TITLES_CACHE_SIZE];
+} bluray_titles_cache = { .lock = VLC_STATIC_MUTEX };
+
+static char *blurayTitlesKey(const BLURAY_DISC_INFO *di, uint32_t i_title)
+{
+#if BLURAY_VERSION >= BLURAY_VERSION_CODE(1, 0, 0)
+    char *psz_key = NULL;
+    char psz_id[2 * sizeof(di->disc_id) + 1];
+    bool b_id = false;
+
+    for (size_t i = 0; i < sizeof(di->disc_id); i++) {
+        sprintf(&psz_id[2 * i], "%02x", di->disc_id[i]);
+        b_id |= di->disc_id[i] != 0;
+    }
+
+    /* The AACS disc ID is unique, the volume identifier hopefully enough */
+    if (b_id) {
+        if (asprintf(&psz_key, "aacs:%s:%"PRIu32, psz_id, i_title) == -1)
+            psz_key = NULL;
+    } else if (di->udf_volume_id != NULL && di->udf_volume_id[0]) {
+        if (asprintf(&psz_key, "udf:%s:%"PRIu32, di->udf_volume_id,
+                     i_title) == -1)
+            psz_key = NULL;
+    }
+    return psz_key;
+#else
+    VLC_UNUSED(di); VLC_UNUSED(i_title);
+    return NULL;
+#endif
+}
+
+static bool blurayCacheLookup(demux_sys_t *p_sys)
+{
+    bool b_found = false;
+
+    if (p_sys->scan.psz_key == NULL)
+        return false;
+
+    vlc_mutex_lock(&bluray_titles_cache.lock);
+    for (unsigned i = 0; i < BLURAY_TITLES_CACHE_SIZE; i++) {
+        const char *psz_key = bluray_titles_cache.entries[i].psz_key;
+        if (psz_key == NULL || strcmp(psz_key, p_sys->scan.psz_key))
+            continue;
+
+        for (unsigned j = 0; j < bluray_titles_cache.entries[i].i_title; j++) {
+            input_title_t *t =
+                vlc_input_title_Duplicate(bluray_titles_cache.entries[i].pp_title[j]);
+            if (!t)
+                break;
+            TAB_APPEND(p_sys->i_title, p_sys->pp_title, t);
+        }
+        b_found = true;
+        break;
+    }
+    vlc_mutex_unlock(&bluray_titles_cache.lock);
+
+    if (b_found && p_sys->i_title == 0)
+        b_found = false;
+    return b_found;
+}
+
+static void blurayCacheTitles(demux_sys_t *p_sys)
+{
+    if (p_sys->scan.psz_key == NULL || p_sys->i_title == 0)
+        return;
+
+    input_title_t **pp_title = vlc_alloc(p_sys->i_title, sizeof(*pp_title));
+    char *psz_key = strdup(p_sys->scan.psz_key);
+    unsigned i_title = 0;
+
+    if (pp_title && psz_key) {
+        for (; i_title < p_sys->i_title; i_title++) {
+            pp_title[i_title] = vlc_input_title_Duplicate(p_sys->pp_title[i_title]);
+            if (!pp_title[i_title])
+                break;
+        }
+    }
+    if (i_title < p_sys->i_title) {
+        while (i_title > 0)
+            vlc_input_title_Delete(pp_title[--i_title]);
+        free(pp_title);
+        free(psz_key);
+        return;
+    }
+
+    vlc_mutex_lock(&bluray_titles_cache.lock);
+    unsigned i_entry = bluray_titles_cache.i_next;
+    for (unsigned i = 0; i < BLURAY_TITLES_CACHE_SIZE; i++) {
+        const char *psz = bluray_titles_cache.entries[i].psz_key;
+        if (psz != NULL && !strcmp(psz, psz_key)) {
+            i_entry = i;
+            break;
+        }
+    }
+    if (i_entry == bluray_titles_cache.i_next)
+        bluray_titles_cache.i_next = (i_entry + 1) % BLURAY_TITLES_CACHE_SIZE;
+
+    /* replace the oldest (or same) entry */
+    free(bluray_titles_cache.entries[i_entry].psz_key);
+    for (unsigned i = 0; i < bluray_titles_cache.entries[i_entry].i_title; i++)
+        vlc_input_title_Delete(bluray_titles_cache.entries[i_entry].pp_title[i]);
+    free(bluray_titles_cache.entries[i_entry].pp_title);
+
+    bluray_titles_cache.entries[i_entry].psz_key = psz_key;
+    bluray_titles_cache.entries[i_entry].i_title = i_title;
+    bluray_titles_cache.entries[i_entry].pp_title = pp_title;
+    vlc_mutex_unlock(&bluray_titles_cache.lock);
+}
+
+static void *blurayScanTitles(void *data)
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    unsigned i;
+
+    for (i = 0; i < p_sys->i_title; i++) {
+        if (atomic_load(&p_sys->scan.b_abort))
+            break;
+        if (i == p_sys->i_longest_title)
+            continue; /* parsed already */
+
+        /* libbluray serializes its calls, this can run during playback */
+        BLURAY_TITLE_INFO *title_info = bd_get_title_info(p_sys->bluray, i, 0);
+        if (!title_info)
+            continue;
+
+        input_title_t *t = vlc_input_title_New();
+        if (t)
+            blurayUpdateTitleInfo(t, title_info);
+        bd_free_title_info(title_info);
+        if (!t)
+            continue;
+
+        vlc_mutex_lock(&p_sys->scan.lock);
+        p_sys->scan.pp_title[i] = t;
+        vlc_mutex_unlock(&p_sys->scan.lock);
+        atomic_store(&p_sys->scan.b_pending, true);
+    }
+
+    p_sys->scan.b_complete = i == p_sys->i_title;
+    return NULL;
+}
+
+/* Replaces the titles placeholders with the parsed titles, from the demux
+ * thread only */
+static void blurayPublishTitles(demux_t *p_demux)
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if (!atomic_exchange(&p_sys->scan.b_pending, false))
+        return;
+
+    vlc_mutex_lock(&p_sys->scan.lock);
+    for (unsigned i = 0; i < p_sys->i_title; i++) {
+        input_title_t *t = p_sys->scan.pp_title[i];
+        if (t == NULL)
+            continue;
+        p_sys->scan.pp_title[i] = NULL;
+        vlc_input_title_Delete(p_sys->pp_title[i]);
+        p_sys->pp_title[i] = t;
+    }
+    vlc_mutex_unlock(&p_sys->scan.lock);
+
+    p_sys->updates |= INPUT_UPDATE_TITLE_LIST;
+}
+
 static void blurayInitTitles(demux_t *p_demux, uint32_t menu_titles)
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2250,6 +2459,13 @@ static void blurayInitTitles(demux_t *p_demux, uint32_t menu_titles)
     if (!p_sys->b_menu) {
         i_title = bd_get_titles(p_sys->bluray, TITLES_RELEVANT, 60);
         p_sys->i_longest_title = bd_get_main_title(p_sys->bluray);
+
+        if (di)
+            p_sys->scan.psz_key = blurayTitlesKey(di, i_title);
+        if (blurayCacheLookup(p_sys)) {
+            msg_Dbg(p_demux, "using cached titles for %s", p_sys->scan.psz_key);
+            return;
+        }
     }
 
     for (uint32_t i = 0; i < i_title; i++) {
@@ -2258,9 +2474,15 @@ static void blurayInitTitles(demux_t *p_demux, uint32_t menu_titles)
             break;
 
         if (!p_sys->b_menu) {
-            BLURAY_TITLE_INFO *title_info = bd_get_title_info(p_sys->bluray, i, 0);
-            blurayUpdateTitleInfo(t, title_info);
-            bd_free_title_info(title_info);
+            /* Only the main title is needed to start playback, the others
+             * are parsed in the background. */
+            if (i == p_sys->i_longest_title) {
+                BLURAY_TITLE_INFO *title_info = bd_get_title_info(p_sys->bluray, i, 0);
+                if (title_info) {
+                    blurayUpdateTitleInfo(t, title_info);
+                    bd_free_title_info(title_info);
+                }
+            }
 
         } else if (i == 0) {
             t->psz_name = strdup(_("Top Menu"));
@@ -2284,6 +2506,31 @@ static void blurayInitTitles(demux_t *p_demux, uint32_t menu_titles)
 
         TAB_APPEND(p_sys->i_title, p_sys->pp_title, t);
     }
+
+    if (p_sys->b_menu || p_sys->i_title == 0)
+        return;
+
+    p_sys->scan.pp_title = calloc(p_sys->i_title, sizeof(input_title_t *));
+    if (p_sys->scan.pp_title &&
+        vlc_clone(&p_sys->scan.thread, blurayScanTitles, p_demux,
+                  VLC_THREAD_PRIORITY_LOW) == 0) {
+        p_sys->scan.b_running = true;
+        return;
+    }
+
+    /* Fallback to synchronous parsing */
+    free(p_sys->scan.pp_title);
+    p_sys->scan.pp_title = NULL;
+    for (unsigned i = 0; i < p_sys->i_title; i++) {
+        if (i == p_sys->i_longest_title)
+            continue;
+        BLURAY_TITLE_INFO *title_info = bd_get_title_info(p_sys->bluray, i, 0);
+        if (title_info) {
+            blurayUpdateTitleInfo(p_sys->pp_title[i], title_info);
+            bd_free_title_info(title_info);
+        }
+    }
+    blurayCacheTitles(p_sys);
 }
 
 static void blurayRestartParser(demux_t *p_demux, bool b_flush, bool b_random_access)
@@ -2506,6 +2753,8 @@ static int blurayControl(demux_t *p_demux, int query, va_list args)
         int *pi_title_offset    = va_arg(args, int *);
         int *pi_chapter_offset  = va_arg(args, int *);
 
+        blurayPublishTitles(p_demux);
+
         /* */
         *pi_title_offset   = 0;
         *pi_chapter_offset = 0;
@@ -3089,6 +3338,8 @@ static int blurayDemux(demux_t *p_demux)
     demux_sys_t *p_sys = p_demux->p_sys;
     BD_EVENT e;
 
+    blurayPublishTitles(p_demux);
+
     if(p_sys->b_draining)
     {
         bool b_empty = false;
@@ -28,10 +28,17 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+
+/** Data read ahead from a pre-opened input */
+#define CONCAT_PREBUF_SIZE 65536
 
 struct access_entry
 {
     struct access_entry *next;
+    uint64_t start; /**< Offset of the input, or UINT64_MAX if unknown */
+    uint64_t size; /**< Size of the input, or UINT64_MAX if unknown */
     char mrl[1];
 };
 
@@ -40,6 +47,16 @@ typedef struct
     stream_t *access;
     struct access_entry *next;
     struct access_entry *first;
+    block_t *prebuf; /**< Data read ahead from the current input */
+
+    /* Background opening of the next input */
+    bool preopen;
+    struct access_entry *preopen_entry; /**< Entry being opened, or NULL */
+    vlc_thread_t preopen_thread;
+    vlc_interrupt_t *preopen_interrupt;
+    stream_t *preopen_access; /**< Owned by the thread until it is joined */
+    block_t *preopen_prebuf;
+
     bool can_seek;
     bool can_seek_fast;
     bool can_pause;
@@ -48,34 +65,174 @@ typedef struct
     vlc_tick_t caching;
 } access_sys_t;
 
-static stream_t *GetAccess(stream_t *access)
+static void *PreopenThread(void *data)
 {
+    stream_t *access = data;
     access_sys_t *sys = access->p_sys;
-    stream_t *a = sys->access;
+    stream_t *a;
+    block_t *prebuf = NULL;
+
+    vlc_interrupt_set(sys->preopen_interrupt);
 
+    a = vlc_access_NewMRL(VLC_OBJECT(access), sys->preopen_entry->mrl);
     if (a != NULL)
+    {   /* Read ahead, so that the input is flowing once it is needed. */
+        if (a->pf_read != NULL)
+        {
+            prebuf = block_Alloc(CONCAT_PREBUF_SIZE);
+            if (likely(prebuf != NULL))
+            {
+                ssize_t val = vlc_stream_Read(a, prebuf->p_buffer,
+                                              prebuf->i_buffer);
+                if (val > 0)
+                    prebuf->i_buffer = val;
+                else
+                {
+                    block_Release(prebuf);
+                    prebuf = NULL;
+                }
+            }
+        }
+        else if (a->pf_block != NULL)
+            prebuf = vlc_stream_ReadBlock(a);
+    }
+
+    sys->preopen_access = a;
+    sys->preopen_prebuf = prebuf;
+    return NULL;
+}
+
+/**
+ * Starts opening the next input in the background.
+ */
+static void StartPreopen(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    assert(sys->preopen_entry == NULL);
+    if (!sys->preopen || sys->next == NULL)
+        return;
+
+    sys->preopen_interrupt = vlc_interrupt_create();
+    if (unlikely(sys->preopen_interrupt == NULL))
+        return;
+
+    sys->preopen_entry = sys->next;
+    sys->preopen_access = NULL;
+    sys->preopen_prebuf = NULL;
+
+    if (vlc_clone(&sys->preopen_thread, PreopenThread, access,
+                  VLC_THREAD_PRIORITY_LOW))
     {
-        if (!vlc_stream_Eof(a))
-            return a;
+        vlc_interrupt_destroy(sys->preopen_interrupt);
+        sys->preopen_entry = NULL;
+    }
+}
+
+/**
+ * Waits for the background opening of the next input.
+ *
+ * @param keep whether to keep the pre-opened input, or to discard it
+ * @return the pre-opened input (if kept), or NULL
+ */
+static stream_t *StopPreopen(stream_t *access, bool keep)
+{
+    access_sys_t *sys = access->p_sys;
 
+    if (sys->preopen_entry == NULL)
+        return NULL;
+
+    if (keep)
+    {   /* Let the input thread interrupt the wait */
+        void *data[2];
+
+        vlc_interrupt_forward_start(sys->preopen_interrupt, data);
+        vlc_join(sys->preopen_thread, NULL);
+        vlc_interrupt_forward_stop(data);
+    }
+    else
+    {
+        vlc_interrupt_kill(sys->preopen_interrupt);
+        vlc_join(sys->preopen_thread, NULL);
+    }
+    vlc_interrupt_destroy(sys->preopen_interrupt);
+    sys->preopen_entry = NULL;
+
+    stream_t *a = sys->preopen_access;
+
+    if (keep && a != NULL)
+    {
+        assert(sys->prebuf == NULL);
+        sys->prebuf = sys->preopen_prebuf;
+        return a;
+    }
+
+    if (sys->preopen_prebuf != NULL)
+        block_Release(sys->preopen_prebuf);
+    if (a != NULL)
         vlc_stream_Delete(a);
+    return NULL;
+}
+
+static void DropPrebuf(stream_t *);
+
+static void CloseAccess(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+
+    DropPrebuf(access);
+    if (sys->access != NULL)
+    {
+        vlc_stream_Delete(sys->access);
         sys->access = NULL;
     }
+}
 
-    if (sys->next == NULL)
-        return NULL;
+static stream_t *OpenAccess(stream_t *access, struct access_entry *e)
+{
+    access_sys_t *sys = access->p_sys;
+    stream_t *a = NULL;
+
+    assert(sys->access == NULL);
+
+    if (sys->preopen_entry == e)
+        a = StopPreopen(access, true);
+    else
+        StopPreopen(access, false);
 
-    a = vlc_access_NewMRL(VLC_OBJECT(access), sys->next->mrl);
+    if (a == NULL)
+        a = vlc_access_NewMRL(VLC_OBJECT(access), e->mrl);
     if (a == NULL)
         return NULL;
 
     sys->access = a;
-    sys->next = sys->next->next;
+    sys->next = e->next;
+    StartPreopen(access);
     return a;
 }
 
+static stream_t *GetAccess(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    stream_t *a = sys->access;
+
+    if (a != NULL)
+    {
+        if (sys->prebuf != NULL || !vlc_stream_Eof(a))
+            return a;
+
+        CloseAccess(access);
+    }
+
+    if (sys->next == NULL)
+        return NULL;
+
+    return OpenAccess(access, sys->next);
+}
+
 static ssize_t Read(stream_t *access, void *buf, size_t len)
 {
+    access_sys_t *sys = access->p_sys;
     stream_t *a = GetAccess(access);
     if (a == NULL)
         return 0;
@@ -86,11 +243,28 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     if (unlikely(a->pf_read == NULL))
         return 0;
 
+    block_t *prebuf = sys->prebuf;
+    if (prebuf != NULL)
+    {
+        if (len > prebuf->i_buffer)
+            len = prebuf->i_buffer;
+        memcpy(buf, prebuf->p_buffer, len);
+        prebuf->p_buffer += len;
+        prebuf->i_buffer -= len;
+        if (prebuf->i_buffer == 0)
+        {
+            block_Release(prebuf);
+            sys->prebuf = NULL;
+        }
+        return len;
+    }
+
     return vlc_stream_ReadPartial(a, buf, len);
 }
 
 static block_t *Block(stream_t *access, bool *restrict eof)
 {
+    access_sys_t *sys = access->p_sys;
     stream_t *a = GetAccess(access);
     if (a == NULL)
     {
@@ -98,19 +272,57 @@ static block_t *Block(stream_t *access, bool *restrict eof)
         return NULL;
     }
 
+    block_t *prebuf = sys->prebuf;
+    if (prebuf != NULL)
+    {
+        sys->prebuf = NULL;
+        return prebuf;
+    }
+
     return vlc_stream_ReadBlock(a);
 }
 
-static int Seek(stream_t *access, uint64_t position)
+static void DropPrebuf(stream_t *access)
 {
     access_sys_t *sys = access->p_sys;
 
-    if (sys->access != NULL)
+    if (sys->prebuf != NULL)
     {
-        vlc_stream_Delete(sys->access);
-        sys->access = NULL;
+        block_Release(sys->prebuf);
+        sys->prebuf = NULL;
+    }
+}
+
+static int Seek(stream_t *access, uint64_t position)
+{
+    access_sys_t *sys = access->p_sys;
+
+    CloseAccess(access);
+
+    if (sys->size != UINT64_MAX)
+    {   /* All sizes are known: go straight to the right input. The last
+         * input may have grown since it was probed (e.g. a live recording). */
+        struct access_entry *e = sys->first;
+
+        if (e == NULL)
+            return VLC_EGENERIC;
+        while (e->next != NULL && position - e->start >= e->size)
+            e = e->next;
+
+        stream_t *a = OpenAccess(access, e);
+        if (a == NULL)
+            return VLC_EGENERIC;
+        DropPrebuf(access); /* read ahead from the start */
+        return vlc_stream_Seek(a, position - e->start) ? VLC_EGENERIC
+                                                       : VLC_SUCCESS;
     }
 
+    /* Probe each input in turn, without opening any ahead. */
+    bool preopen = sys->preopen;
+    int ret = VLC_EGENERIC;
+
+    StopPreopen(access, false);
+    sys->preopen = false;
     sys->next = sys->first;
 
     for (uint64_t offset = 0;;)
@@ -130,17 +342,19 @@ static int Seek(stream_t *access, uint64_t position)
             break;
         if (position - offset < size)
         {
-            if (vlc_stream_Seek(a, position - offset))
-                break;
-            return VLC_SUCCESS;
+            if (vlc_stream_Seek(a, position - offset) == 0)
+                ret = VLC_SUCCESS;
+            break;
         }
 
         offset += size;
-        vlc_stream_Delete(a);
-        sys->access = NULL;
+        CloseAccess(access);
     }
 
-    return VLC_EGENERIC;
+    sys->preopen = preopen;
+    if (ret == VLC_SUCCESS)
+        StartPreopen(access);
+    return ret;
 }
 
 static int Control(stream_t *access, int query, va_list args)
@@ -200,6 +414,9 @@ static int Open(vlc_object_t *obj)
     bool read_cb = true;
 
     sys->access = NULL;
+    sys->prebuf = NULL;
+    sys->preopen = var_InheritBool(access, "concat-preopen");
+    sys->preopen_entry = NULL;
     sys->can_seek = true;
     sys->can_seek_fast = true;
     sys->can_pause = true;
@@ -251,14 +468,15 @@ static int Open(vlc_object_t *obj)
         if (sys->can_control_pace)
             vlc_stream_Control(a, STREAM_CAN_CONTROL_PACE,
                                &sys->can_control_pace);
+        e->start = sys->size;
+        if (vlc_stream_GetSize(a, &e->size))
+            e->size = UINT64_MAX;
         if (sys->size != UINT64_MAX)
         {
-            uint64_t size;
-
-            if (vlc_stream_GetSize(a, &size))
+            if (e->size == UINT64_MAX)
                 sys->size = UINT64_MAX;
             else
-                sys->size += size;
+                sys->size += e->size;
         }
 
         vlc_tick_t caching;
@@ -288,8 +506,8 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
-    if (sys->access != NULL)
-        vlc_stream_Delete(sys->access);
+    StopPreopen(access, false);
+    CloseAccess(access);
 
     for (struct access_entry *e = sys->first, *next; e != NULL; e = next)
     {
@@ -303,6 +521,10 @@ static void Close(vlc_object_t *obj)
 #define INPUT_LIST_TEXT N_("Inputs list")
 #define INPUT_LIST_LONGTEXT N_( \
     "Comma-separated list of input URLs to concatenate.")
+#define PREOPEN_TEXT N_("Open inputs ahead")
+#define PREOPEN_LONGTEXT N_( \
+    "Open and start reading each input in the background, while the " \
+    "previous one is still being read.")
 
 vlc_module_begin()
     set_shortname(N_("Concatenation"))
@@ -310,6 +532,7 @@ vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_ACCESS)
     add_string("concat-list", NULL, INPUT_LIST_TEXT, INPUT_LIST_LONGTEXT, true)
+    add_bool("concat-preopen", true, PREOPEN_TEXT, PREOPEN_LONGTEXT, true)
     set_capability("access", 0)
     set_callbacks(Open, Close)
     add_shortcut("concast", "list")
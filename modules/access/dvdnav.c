@@ -1253,6 +1253,124 @@ static char *DemuxGetLanguageCode( demux_t *p_demux, const char *psz_var )
     return strdup(LANGUAGE_DEFAULT);
 }
 
+/*
+ * Titles of the recently played discs. Describing the chapters of every
+ * title reads all the IFO files, which takes a while on slow drives and on
+ * protected discs, so it is only done once per disc (until evicted).
+ */
+#define DVD_TITLES_CACHE_SIZE 4
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned    i_next;
+    struct
+    {
+        char           *psz_key;
+        int            i_title;
+        input_title_t  **pp_title;
+    } entries[DVD_TITLES_CACHE_SIZE];
+} dvd_titles_cache = { .lock = VLC_STATIC_MUTEX };
+
+static char *DemuxTitlesKey( demux_t *p_demux, int32_t i_titles )
+{
+#if DVDNAV_VERSION >= 60000
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const char *psz_title = NULL, *psz_serial = NULL;
+    char *psz_key;
+
+    /* The volume name alone is often generic */
+    if( dvdnav_get_serial_string( p_sys->dvdnav, &psz_serial )
+            != DVDNAV_STATUS_OK || psz_serial == NULL || !*psz_serial )
+        return NULL;
+    if( dvdnav_get_title_string( p_sys->dvdnav, &psz_title )
+            != DVDNAV_STATUS_OK || psz_title == NULL )
+        psz_title = "";
+
+    if( asprintf( &psz_key, "%s:%s:%"PRId32, psz_title, psz_serial,
+                  i_titles ) == -1 )
+        return NULL;
+    return psz_key;
+#else
+    VLC_UNUSED(p_demux); VLC_UNUSED(i_titles);
+    return NULL;
+#endif
+}
+
+static bool DemuxTitlesCacheLookup( demux_t *p_demux, const char *psz_key )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    bool b_found = false;
+
+    vlc_mutex_lock( &dvd_titles_cache.lock );
+    for( unsigned i = 0; i < DVD_TITLES_CACHE_SIZE; i++ )
+    {
+        const char *psz = dvd_titles_cache.entries[i].psz_key;
+        if( psz == NULL || strcmp( psz, psz_key ) )
+            continue;
+
+        for( int j = 0; j < dvd_titles_cache.entries[i].i_title; j++ )
+        {
+            input_title_t *t =
+                vlc_input_title_Duplicate( dvd_titles_cache.entries[i].pp_title[j] );
+            if( !t )
+                break;
+            TAB_APPEND( p_sys->i_title, p_sys->title, t );
+        }
+        b_found = true;
+        break;
+    }
+    vlc_mutex_unlock( &dvd_titles_cache.lock );
+    return b_found;
+}
+
+/* Caches the titles (but the menu) */
+static void DemuxTitlesCacheStore( demux_t *p_demux, const char *psz_key )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    int i_title = p_sys->i_title - 1;
+
+    if( i_title <= 0 )
+        return;
+
+    input_title_t **pp_title = vlc_alloc( i_title, sizeof(*pp_title) );
+    char *psz_dup = strdup( psz_key );
+    int i = 0;
+
+    if( pp_title && psz_dup )
+    {
+        for( ; i < i_title; i++ )
+        {
+            pp_title[i] = vlc_input_title_Duplicate( p_sys->title[i + 1] );
+            if( !pp_title[i] )
+                break;
+        }
+    }
+    if( i < i_title )
+    {
+        while( i > 0 )
+            vlc_input_title_Delete( pp_title[--i] );
+        free( pp_title );
+        free( psz_dup );
+        return;
+    }
+
+    vlc_mutex_lock( &dvd_titles_cache.lock );
+    /* replace the oldest entry */
+    unsigned i_entry = dvd_titles_cache.i_next;
+    dvd_titles_cache.i_next = (i_entry + 1) % DVD_TITLES_CACHE_SIZE;
+
+    free( dvd_titles_cache.entries[i_entry].psz_key );
+    for( int j = 0; j < dvd_titles_cache.entries[i_entry].i_title; j++ )
+        vlc_input_title_Delete( dvd_titles_cache.entries[i_entry].pp_title[j] );
+    free( dvd_titles_cache.entries[i_entry].pp_title );
+
+    dvd_titles_cache.entries[i_entry].psz_key = psz_dup;
+    dvd_titles_cache.entries[i_entry].i_title = i_title;
+    dvd_titles_cache.entries[i_entry].pp_title = pp_title;
+    vlc_mutex_unlock( &dvd_titles_cache.lock );
+}
+
 static void DemuxTitles( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1279,6 +1397,14 @@ static void DemuxTitles( demux_t *p_demux )
     /* Find out number of titles/chapters */
     dvdnav_get_number_of_titles( p_sys->dvdnav, &i_titles );
 
+    char *psz_key = DemuxTitlesKey( p_demux, i_titles );
+    if( psz_key != NULL && DemuxTitlesCacheLookup( p_demux, psz_key ) )
+    {
+        msg_Dbg( p_demux, "using cached titles for %s", psz_key );
+        free( psz_key );
+        return;
+    }
+
     if( i_titles > 90 )
         msg_Err( p_demux, "This is probably an Arccos Protected DVD. This could take time..." );
 
@@ -1312,6 +1438,12 @@ static void DemuxTitles( demux_t *p_demux )
         free( p_chapters_time );
         TAB_APPEND( p_sys->i_title, p_sys->title, t );
     }
+
+    if( psz_key != NULL )
+    {
+        DemuxTitlesCacheStore( p_demux, psz_key );
+        free( psz_key );
+    }
 }
 
 /*****************************************************************************
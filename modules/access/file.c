@@ -51,10 +51,14 @@
 #   include <unistd.h>
 #endif
 #include <dirent.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include "fs.h"
 #include <vlc_access.h>
+#include <vlc_block.h>
 #ifdef _WIN32
 # include <vlc_charset.h>
 #endif
@@ -67,6 +71,14 @@ typedef struct
     int fd;
 
     bool b_pace_control;
+
+    /* Read-ahead advice window */
+    uint64_t offset;
+    uint64_t advised;
+    size_t window;
+#ifdef HAVE_LINUX_IO_URING_H
+    struct file_uring *uring;
+#endif
 } access_sys_t;
 
 #if !defined (_WIN32) && !defined (__OS2__)
@@ -125,7 +137,47 @@ static bool IsRemote (const char *path)
 # define posix_fadvise(fd, off, len, adv)
 #endif
 
+/* The read-ahead advice window starts small so that probing and seeking do
+ * not pull in unneeded data, and doubles while reading stays sequential. */
+#define FILE_ADVISE_MIN  (256 << 10)
+#define FILE_ADVISE_MAX  (16 << 20)
+/* Length of each memory mapping in mmap mode */
+#define FILE_MMAP_CHUNK  (1 << 20)
+
+static void FileAdviseReset (access_sys_t *sys, uint64_t offset)
+{
+    sys->offset = offset;
+    sys->advised = offset;
+    sys->window = FILE_ADVISE_MIN;
+}
+
+/**
+ * Accounts for consumed data, and asks the kernel for the next window
+ * ahead of time, i.e. once half of the previous window is consumed.
+ * The advised range thus follows the actual consumption rate.
+ */
+static void FileAdvise (access_sys_t *sys, size_t len)
+{
+    sys->offset += len;
+
+    if (sys->offset + sys->window / 2 < sys->advised)
+        return;
+    if (sys->advised < sys->offset)
+        sys->advised = sys->offset;
+
+    posix_fadvise (sys->fd, sys->advised, sys->window, POSIX_FADV_WILLNEED);
+    sys->advised += sys->window;
+    if (sys->window < FILE_ADVISE_MAX)
+        sys->window *= 2;
+}
+
 static ssize_t Read (stream_t *, void *, size_t);
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *, bool *);
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+static block_t *Block (stream_t *, bool *);
+#endif
 static int FileSeek (stream_t *, uint64_t);
 static int FileControl (stream_t *, int, va_list);
 
@@ -210,6 +262,10 @@ int FileOpen( vlc_object_t *p_this )
     p_access->pf_control = FileControl;
     p_access->p_sys = p_sys;
     p_sys->fd = fd;
+    FileAdviseReset (p_sys, 0);
+#ifdef HAVE_LINUX_IO_URING_H
+    p_sys->uring = NULL;
+#endif
 
     if (S_ISREG (st.st_mode) || S_ISBLK (st.st_mode))
     {
@@ -218,8 +274,9 @@ int FileOpen( vlc_object_t *p_this )
 
         /* Demuxers will need the beginning of the file for probing. */
         posix_fadvise (fd, 0, 4096, POSIX_FADV_WILLNEED);
-        /* In most cases, we only read the file once. */
+        /* In most cases, we only read the file once, and in order. */
         posix_fadvise (fd, 0, 0, POSIX_FADV_NOREUSE);
+        posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
 #ifdef F_NOCACHE
         fcntl (fd, F_NOCACHE, 0);
 #endif
@@ -228,6 +285,27 @@ int FileOpen( vlc_object_t *p_this )
             fcntl (fd, F_RDAHEAD, 0);
         else
             fcntl (fd, F_RDAHEAD, 1);
+#endif
+#ifdef HAVE_LINUX_IO_URING_H
+        if (var_InheritBool (p_access, "file-uring"))
+            p_sys->uring = FileUringNew (p_access, fd,
+                           var_InheritInteger (p_access, "file-uring-depth"));
+        if (p_sys->uring != NULL)
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = Block;
+        }
+        else
+#endif
+#ifdef HAVE_MMAP
+        /* Mapped pages are handed out without copying, but a concurrent
+         * truncation of the file would raise SIGBUS, hence opt-in only. */
+        if (S_ISREG (st.st_mode) && !IsRemote(fd, p_access->psz_filepath)
+         && var_InheritBool (p_access, "file-mmap"))
+        {
+            p_access->pf_read = NULL;
+            p_access->pf_block = MmapBlock;
+        }
 #endif
     }
     else
@@ -250,7 +328,7 @@ void FileClose (vlc_object_t * p_this)
 {
     stream_t     *p_access = (stream_t*)p_this;
 
-    if (p_access->pf_read == NULL)
+    if (p_access->pf_readdir != NULL)
     {
         DirClose (p_this);
         return;
@@ -258,6 +336,10 @@ void FileClose (vlc_object_t * p_this)
 
     access_sys_t *p_sys = p_access->p_sys;
 
+#ifdef HAVE_LINUX_IO_URING_H
+    if (p_sys->uring != NULL)
+        FileUringDelete (p_sys->uring);
+#endif
     vlc_close (p_sys->fd);
 }
 
@@ -281,9 +363,66 @@ static ssize_t Read (stream_t *p_access, void *p_buffer, size_t i_len)
         val = 0;
     }
 
+    if (p_access->pf_seek != NULL)
+        FileAdvise (p_sys, val);
     return val;
 }
 
+#ifdef HAVE_MMAP
+static block_t *MmapBlock (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    struct stat st;
+
+    if (fstat (p_sys->fd, &st))
+    {
+        msg_Err (p_access, "read error: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    if ((uint64_t)st.st_size <= p_sys->offset)
+    {
+        *eof = true;
+        return NULL;
+    }
+
+    /* The mapping offset must be page-aligned. */
+    uint64_t base = p_sys->offset & ~(uint64_t)(sysconf (_SC_PAGESIZE) - 1);
+    size_t skip = p_sys->offset - base;
+    size_t length = __MIN((uint64_t)FILE_MMAP_CHUNK,
+                          st.st_size - p_sys->offset);
+
+    /* Blocks are writable by their owners: use a private mapping. */
+    void *addr = mmap (NULL, skip + length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, p_sys->fd, base);
+    if (addr == MAP_FAILED)
+    {
+        msg_Err (p_access, "cannot map file: %s", vlc_strerror_c(errno));
+        *eof = true;
+        return NULL;
+    }
+
+    block_t *block = block_mmap_Alloc (addr, skip + length);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    block->p_buffer += skip;
+    block->i_buffer -= skip;
+    FileAdvise (p_sys, length);
+    return block;
+}
+#endif
+
+#ifdef HAVE_LINUX_IO_URING_H
+static block_t *Block (stream_t *p_access, bool *restrict eof)
+{
+    access_sys_t *p_sys = p_access->p_sys;
+
+    return FileUringBlock (p_access, p_sys->uring, eof);
+}
+#endif
+
 /*****************************************************************************
  * Seek: seek to a specific location in a file
  *****************************************************************************/
@@ -291,8 +430,13 @@ static int FileSeek (stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_LINUX_IO_URING_H
+    if (sys->uring != NULL)
+        FileUringSeek (sys->uring, i_pos);
+#endif
     if (lseek(sys->fd, i_pos, SEEK_SET) == (off_t)-1)
         return VLC_EGENERIC;
+    FileAdviseReset (sys, i_pos);
     return VLC_SUCCESS;
 }
 
@@ -0,0 +1,502 @@
+/*****************************************************************************
+ * file_uring.c: io_uring read-ahead for the file access
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+/* Only built if configure found the header (see HAVE_LINUX_IO_URING) */
+#ifdef HAVE_LINUX_IO_URING_H
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+#include <vlc_atomic.h>
+#include "fs.h"
+
+/** Size of each read-ahead request */
+#define FILE_URING_CHUNK (128 << 10)
+
+enum
+{
+    FILE_URING_FREE, /**< available for submission */
+    FILE_URING_BUSY, /**< submitted to the kernel */
+    FILE_URING_DONE, /**< completed, not delivered yet */
+    FILE_URING_LENT, /**< delivered as a block, not released yet */
+};
+
+struct file_uring_req
+{
+    block_t block;
+    struct file_uring *uring;
+    struct iovec iov;
+    uint64_t offset;
+    int result;
+    int state;
+    bool stale; /**< result will not be delivered (seek or short read) */
+};
+
+struct file_uring
+{
+    vlc_atomic_rc_t rc; /**< one for the access, one per lent block */
+    vlc_mutex_t lock; /**< protects request states against block releases */
+
+    int ring;
+    int fd;
+    bool fixed; /**< buffers are registered with the ring */
+
+    void *sq_map;
+    size_t sq_len;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+
+    void *cq_map;
+    size_t cq_len;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+
+    unsigned depth; /**< number of requests */
+    unsigned window; /**< current read-ahead depth */
+    unsigned busy; /**< number of requests in the kernel */
+    uint64_t submit_offset;
+    uint64_t read_offset;
+
+    uint8_t *arena;
+    struct file_uring_req reqs[];
+};
+
+static int uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int uring_enter(int fd, unsigned submit, unsigned complete,
+                       unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, submit, complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, const void *arg,
+                          unsigned count)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+static void FileUringRelease(struct file_uring *u)
+{
+    if (!vlc_atomic_rc_dec(&u->rc))
+        return;
+
+    free(u->arena);
+    free(u);
+}
+
+static void FileUringReleaseBlock(block_t *block)
+{
+    struct file_uring_req *req =
+        container_of(block, struct file_uring_req, block);
+    struct file_uring *u = req->uring;
+
+    vlc_mutex_lock(&u->lock);
+    assert(req->state == FILE_URING_LENT);
+    req->state = FILE_URING_FREE;
+    vlc_mutex_unlock(&u->lock);
+
+    FileUringRelease(u);
+}
+
+static const struct vlc_block_callbacks file_uring_cbs =
+{
+    FileUringReleaseBlock,
+};
+
+/**
+ * Collects completed requests.
+ */
+static void FileUringReap(struct file_uring *u)
+{
+    unsigned head = *u->cq_head;
+    unsigned tail = atomic_load_explicit((_Atomic unsigned *)u->cq_tail,
+                                         memory_order_acquire);
+
+    if (head == tail)
+        return;
+
+    vlc_mutex_lock(&u->lock);
+    while (head != tail)
+    {
+        const struct io_uring_cqe *cqe = &u->cqes[head & u->cq_mask];
+        struct file_uring_req *req = &u->reqs[cqe->user_data];
+
+        assert(req->state == FILE_URING_BUSY);
+        req->result = cqe->res;
+        req->state = req->stale ? FILE_URING_FREE : FILE_URING_DONE;
+        u->busy--;
+        head++;
+    }
+    vlc_mutex_unlock(&u->lock);
+
+    atomic_store_explicit((_Atomic unsigned *)u->cq_head, head,
+                          memory_order_release);
+}
+
+/**
+ * Queues read-ahead requests up to the current window.
+ */
+static int FileUringSubmit(stream_t *access, struct file_uring *u)
+{
+    unsigned tail = *u->sq_tail;
+    unsigned count = 0;
+
+    vlc_mutex_lock(&u->lock);
+    for (unsigned i = 0; i < u->depth && u->busy < u->window; i++)
+    {
+        struct file_uring_req *req = &u->reqs[i];
+
+        if (req->state != FILE_URING_FREE)
+            continue;
+
+        unsigned idx = tail & u->sq_mask;
+        struct io_uring_sqe *sqe = &u->sqes[idx];
+
+        memset(sqe, 0, sizeof (*sqe));
+        sqe->fd = u->fd;
+        sqe->off = u->submit_offset;
+        sqe->user_data = i;
+        if (u->fixed)
+        {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = (uintptr_t)req->iov.iov_base;
+            sqe->len = req->iov.iov_len;
+            sqe->buf_index = i;
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_READV;
+            sqe->addr = (uintptr_t)&req->iov;
+            sqe->len = 1;
+        }
+        u->sq_array[idx] = idx;
+        tail++;
+
+        req->offset = u->submit_offset;
+        req->state = FILE_URING_BUSY;
+        req->stale = false;
+        u->submit_offset += FILE_URING_CHUNK;
+        u->busy++;
+        count++;
+    }
+    vlc_mutex_unlock(&u->lock);
+
+    if (count == 0)
+        return 0;
+
+    atomic_store_explicit((_Atomic unsigned *)u->sq_tail, tail,
+                          memory_order_release);
+
+    while (count > 0)
+    {
+        int val = uring_enter(u->ring, count, 0, 0);
+        if (val < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                continue;
+            msg_Err(access, "io_uring submission error: %s",
+                    vlc_strerror_c(errno));
+            return -1;
+        }
+        count -= val;
+    }
+    return 0;
+}
+
+/**
+ * Finds the request for the current read offset.
+ */
+static struct file_uring_req *FileUringFind(struct file_uring *u)
+{
+    for (unsigned i = 0; i < u->depth; i++)
+    {
+        struct file_uring_req *req = &u->reqs[i];
+
+        if ((req->state == FILE_URING_BUSY || req->state == FILE_URING_DONE)
+         && !req->stale && req->offset == u->read_offset)
+            return req;
+    }
+    return NULL;
+}
+
+/**
+ * Drops all pending read-ahead, and resumes reading at the current offset.
+ */
+static void FileUringRestart(struct file_uring *u)
+{
+    vlc_mutex_lock(&u->lock);
+    for (unsigned i = 0; i < u->depth; i++)
+    {
+        struct file_uring_req *req = &u->reqs[i];
+
+        if (req->state == FILE_URING_BUSY)
+            req->stale = true;
+        else if (req->state == FILE_URING_DONE)
+            req->state = FILE_URING_FREE;
+    }
+    vlc_mutex_unlock(&u->lock);
+    u->submit_offset = u->read_offset;
+}
+
+/**
+ * Reads synchronously, if all buffers are held downstream.
+ */
+static block_t *FileUringReadSync(stream_t *access, struct file_uring *u,
+                                  bool *restrict eof)
+{
+    block_t *block = block_Alloc(FILE_URING_CHUNK);
+    if (unlikely(block == NULL))
+        return NULL;
+
+    ssize_t val = pread(u->fd, block->p_buffer, block->i_buffer,
+                        u->read_offset);
+    if (val <= 0)
+    {
+        if (val < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+            {
+                block_Release(block);
+                return NULL;
+            }
+            msg_Err(access, "read error: %s", vlc_strerror_c(errno));
+        }
+        block_Release(block);
+        *eof = true;
+        return NULL;
+    }
+
+    block->i_buffer = val;
+    u->read_offset += val;
+    u->submit_offset = u->read_offset;
+    return block;
+}
+
+block_t *FileUringBlock(stream_t *access, struct file_uring *u,
+                        bool *restrict eof)
+{
+    struct file_uring_req *req;
+
+    for (;;)
+    {
+        FileUringReap(u);
+
+        req = FileUringFind(u);
+        if (req == NULL)
+            FileUringRestart(u);
+
+        if (FileUringSubmit(access, u))
+        {
+            *eof = true;
+            return NULL;
+        }
+
+        if (req == NULL)
+        {
+            req = FileUringFind(u);
+            if (req == NULL)
+                return FileUringReadSync(access, u, eof);
+        }
+
+        if (req->state == FILE_URING_DONE)
+            break;
+
+        struct pollfd ufd = { .fd = u->ring, .events = POLLIN };
+
+        if (vlc_poll_i11e(&ufd, 1, -1) < 0 && errno == EINTR)
+            return NULL;
+    }
+
+    int val = req->result;
+
+    if (val <= 0)
+    {
+        if (val < 0)
+            msg_Err(access, "read error: %s", vlc_strerror_c(-val));
+
+        vlc_mutex_lock(&u->lock);
+        req->state = FILE_URING_FREE;
+        vlc_mutex_unlock(&u->lock);
+        *eof = true;
+        return NULL;
+    }
+
+    vlc_mutex_lock(&u->lock);
+    req->state = FILE_URING_LENT;
+    vlc_mutex_unlock(&u->lock);
+    vlc_atomic_rc_inc(&u->rc);
+
+    u->read_offset += val;
+    if (u->window < u->depth)
+        u->window *= 2;
+    if (u->window > u->depth)
+        u->window = u->depth;
+
+    return block_Init(&req->block, &file_uring_cbs, req->iov.iov_base, val);
+}
+
+void FileUringSeek(struct file_uring *u, uint64_t offset)
+{
+    u->read_offset = offset;
+    u->window = 1;
+}
+
+static void FileUringUnmap(struct file_uring *u)
+{
+    if (u->sqes != NULL)
+        munmap(u->sqes, u->sqes_len);
+    if (u->cq_map != NULL)
+        munmap(u->cq_map, u->cq_len);
+    if (u->sq_map != NULL)
+        munmap(u->sq_map, u->sq_len);
+    vlc_close(u->ring);
+}
+
+struct file_uring *FileUringNew(stream_t *access, int fd, unsigned depth)
+{
+    struct file_uring *u = malloc(sizeof (*u) + depth * sizeof (u->reqs[0]));
+    if (unlikely(u == NULL))
+        return NULL;
+
+    struct io_uring_params p;
+    struct iovec iov[depth];
+
+    memset(&p, 0, sizeof (p));
+    u->ring = uring_setup(depth, &p);
+    if (u->ring == -1)
+    {
+        msg_Dbg(access, "io_uring not available: %s", vlc_strerror_c(errno));
+        free(u);
+        return NULL;
+    }
+
+    u->sq_len = p.sq_off.array + p.sq_entries * sizeof (unsigned);
+    u->cq_len = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+    u->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+    u->sq_map = mmap(NULL, u->sq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, u->ring, IORING_OFF_SQ_RING);
+    u->cq_map = mmap(NULL, u->cq_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, u->ring, IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, u->ring, IORING_OFF_SQES);
+    if (u->sq_map == MAP_FAILED)
+        u->sq_map = NULL;
+    if (u->cq_map == MAP_FAILED)
+        u->cq_map = NULL;
+    if (u->sqes == MAP_FAILED)
+        u->sqes = NULL;
+    if (u->sq_map == NULL || u->cq_map == NULL || u->sqes == NULL)
+        goto error;
+
+    u->sq_head = (unsigned *)((char *)u->sq_map + p.sq_off.head);
+    u->sq_tail = (unsigned *)((char *)u->sq_map + p.sq_off.tail);
+    u->sq_mask = *(unsigned *)((char *)u->sq_map + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)((char *)u->sq_map + p.sq_off.array);
+    u->cq_head = (unsigned *)((char *)u->cq_map + p.cq_off.head);
+    u->cq_tail = (unsigned *)((char *)u->cq_map + p.cq_off.tail);
+    u->cq_mask = *(unsigned *)((char *)u->cq_map + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)((char *)u->cq_map + p.cq_off.cqes);
+
+    u->arena = aligned_alloc(4096, depth * FILE_URING_CHUNK);
+    if (unlikely(u->arena == NULL))
+        goto error;
+
+    for (unsigned i = 0; i < depth; i++)
+    {
+        struct file_uring_req *req = &u->reqs[i];
+
+        req->uring = u;
+        req->iov.iov_base = u->arena + i * FILE_URING_CHUNK;
+        req->iov.iov_len = FILE_URING_CHUNK;
+        req->state = FILE_URING_FREE;
+        iov[i] = req->iov;
+    }
+
+    /* Registered buffers are pinned, and count against RLIMIT_MEMLOCK. */
+    u->fixed = uring_register(u->ring, IORING_REGISTER_BUFFERS, iov,
+                              depth) == 0;
+    if (!u->fixed)
+        msg_Dbg(access, "cannot register buffers: %s",
+                vlc_strerror_c(errno));
+
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+
+    vlc_atomic_rc_init(&u->rc);
+    vlc_mutex_init(&u->lock);
+    u->fd = fd;
+    u->depth = depth;
+    u->window = 1;
+    u->busy = 0;
+    u->read_offset = u->submit_offset = (offset > 0) ? offset : 0;
+    msg_Dbg(access, "using io_uring with %u x %u bytes %s buffers", depth,
+            FILE_URING_CHUNK, u->fixed ? "registered" : "heap");
+    return u;
+
+error:
+    msg_Err(access, "cannot map io_uring: %s", vlc_strerror_c(errno));
+    FileUringUnmap(u);
+    free(u);
+    return NULL;
+}
+
+void FileUringDelete(struct file_uring *u)
+{
+    /* The kernel writes to the buffers until the requests complete */
+    while (u->busy > 0)
+    {
+        if (uring_enter(u->ring, 0, u->busy, IORING_ENTER_GETEVENTS) < 0
+         && errno != EINTR)
+            break;
+        FileUringReap(u);
+    }
+
+    FileUringUnmap(u);
+    if (unlikely(u->busy > 0))
+        return; /* leak rather than free buffers still in use */
+    FileUringRelease(u);
+}
+
+#endif /* HAVE_LINUX_IO_URING_H */
@@ -39,6 +39,21 @@ vlc_module_begin ()
     set_capability( "access", 50 )
     add_shortcut( "file", "fd", "stream" )
     set_callbacks( FileOpen, FileClose )
+#ifdef HAVE_LINUX_IO_URING_H
+    add_bool("file-uring", false, N_("Asynchronous I/O"),
+             N_("Read files ahead asynchronously with io_uring. This is "
+                "experimental, and disabled by default."), true)
+    add_integer("file-uring-depth", 4, N_("Asynchronous read-ahead depth"),
+                N_("Number of read requests to keep queued for each file"),
+                true)
+        change_integer_range(1, 64)
+#endif
+#ifdef HAVE_MMAP
+    add_bool("file-mmap", false, N_("Memory-mapped I/O"),
+             N_("Read local files through memory mappings instead of "
+                "copying their data. The file must not be truncated "
+                "while it is being read."), true)
+#endif
 
     add_submodule()
     set_section( N_("Directory" ), NULL )
@@ -23,6 +23,15 @@
 int FileOpen (vlc_object_t *);
 void FileClose (vlc_object_t *);
 
+#ifdef HAVE_LINUX_IO_URING_H
+struct file_uring;
+
+struct file_uring *FileUringNew(stream_t *, int fd, unsigned depth);
+void FileUringDelete(struct file_uring *);
+block_t *FileUringBlock(stream_t *, struct file_uring *, bool *eof);
+void FileUringSeek(struct file_uring *, uint64_t offset);
+#endif
+
 int DirOpen (vlc_object_t *);
 int DirInit (stream_t *p_access, DIR *handle);
 int DirRead (stream_t *, input_item_node_t *);
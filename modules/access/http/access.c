@@ -37,31 +37,97 @@
 #include <vlc_url.h>
 
 #include "connmgr.h"
+#include "message.h"
 #include "resource.h"
 #include "file.h"
 #include "live.h"
+#include "ranged.h"
+
+/* Planned ranges closer than this are fetched with a single request */
+#define PLAN_MAX_GAP (64 << 10)
 
 typedef struct
 {
     struct vlc_http_mgr *manager;
     struct vlc_http_resource *resource;
+    struct vlc_http_ranged *ranged;
+    struct vlc_stream_range *plan; /**< Ranges announced by the demuxer */
+    size_t plan_count;
 } access_sys_t;
 
 static block_t *FileRead(stream_t *access, bool *restrict eof)
 {
     access_sys_t *sys = access->p_sys;
 
-    block_t *b = vlc_http_file_read(sys->resource);
+    block_t *b;
+
+    if (sys->ranged != NULL)
+    {
+        b = vlc_http_ranged_read(sys->ranged);
+        if (b == vlc_http_error)
+        {   /* Carry on sequentially over the connection of the file */
+            uintmax_t offset = vlc_http_ranged_tell(sys->ranged);
+
+            msg_Warn(access, "parallel ranged fetching failed at %ju, "
+                     "falling back to sequential reading", offset);
+            vlc_http_ranged_destroy(sys->ranged);
+            sys->ranged = NULL;
+
+            if (vlc_http_file_seek(sys->resource, offset) == 0)
+                b = vlc_http_file_read(sys->resource);
+            else
+                b = NULL;
+        }
+    }
+    else
+        b = vlc_http_file_read(sys->resource);
+
     if (b == NULL)
         *eof = true;
     return b;
 }
 
+/**
+ * Finds the last byte of the planned ranges starting at the given offset.
+ *
+ * \return the offset of the last byte, or UINTMAX_MAX if unplanned
+ */
+static uintmax_t FilePlanEnd(const access_sys_t *sys, uint64_t pos)
+{
+    uintmax_t end = UINTMAX_MAX;
+
+    for (size_t i = 0; i < sys->plan_count; i++)
+    {
+        const struct vlc_stream_range *r = &sys->plan[i];
+
+        if (end == UINTMAX_MAX)
+        {
+            if (pos >= r->offset && pos - r->offset < r->length)
+                end = r->offset + r->length - 1;
+        }
+        else if (r->offset <= end + 1 + PLAN_MAX_GAP)
+            end = __MAX(end, r->offset + r->length - 1);
+        else
+            break;
+    }
+
+    /* Reads past a bounded request need the file size to carry on */
+    uintmax_t size = vlc_http_file_get_size(sys->resource);
+    if (size == (uintmax_t)-1 || end + 1 >= size)
+        end = UINTMAX_MAX;
+    return end;
+}
+
 static int FileSeek(stream_t *access, uint64_t pos)
 {
     access_sys_t *sys = access->p_sys;
 
-    if (vlc_http_file_seek(sys->resource, pos))
+    if (sys->ranged != NULL)
+        return vlc_http_ranged_seek(sys->ranged, pos) ? VLC_EGENERIC
+                                                      : VLC_SUCCESS;
+    /* Request only the planned range, so that the connection can be reused
+     * for the next one, rather than closed in the middle of a response. */
+    if (vlc_http_file_seek_range(sys->resource, pos, FilePlanEnd(sys, pos)))
         return VLC_EGENERIC;
     return VLC_SUCCESS;
 }
@@ -107,6 +173,29 @@ static int FileControl(stream_t *access, int query, va_list args)
         case STREAM_SET_PAUSE_STATE:
             break;
 
+        case STREAM_SET_READAHEAD_PLAN:
+        {
+            const struct vlc_stream_range *ranges =
+                va_arg(args, const struct vlc_stream_range *);
+            size_t count = va_arg(args, size_t);
+
+            if (sys->ranged != NULL)
+                return VLC_EGENERIC; /* already fetching ahead */
+
+            struct vlc_stream_range *plan = NULL;
+            if (count > 0)
+            {
+                plan = vlc_alloc(count, sizeof (*plan));
+                if (unlikely(plan == NULL))
+                    return VLC_ENOMEM;
+                memcpy(plan, ranges, count * sizeof (*plan));
+            }
+            free(sys->plan);
+            sys->plan = plan;
+            sys->plan_count = count;
+            break;
+        }
+
         default:
             return VLC_EGENERIC;
     }
@@ -162,6 +251,9 @@ static int Open(vlc_object_t *obj)
 
     sys->manager = NULL;
     sys->resource = NULL;
+    sys->ranged = NULL;
+    sys->plan = NULL;
+    sys->plan_count = 0;
 
     void *jar = NULL;
     if (var_InheritBool(obj, "http-forward-cookies"))
@@ -251,6 +343,15 @@ static int Open(vlc_object_t *obj)
     }
     else
     {
+        unsigned connections = var_InheritInteger(obj, "http-connections");
+        if (connections > 1)
+        {
+            sys->ranged = vlc_http_ranged_create(obj, sys->resource, jar,
+                                                 connections);
+            if (sys->ranged == NULL)
+                msg_Dbg(access, "parallel ranged fetching not available");
+        }
+
         access->pf_block = FileRead;
         access->pf_seek = FileSeek;
         access->pf_control = FileControl;
@@ -275,8 +376,11 @@ static void Close(vlc_object_t *obj)
     stream_t *access = (stream_t *)obj;
     access_sys_t *sys = access->p_sys;
 
+    if (sys->ranged != NULL)
+        vlc_http_ranged_destroy(sys->ranged);
     vlc_http_res_destroy(sys->resource);
     vlc_http_mgr_destroy(sys->manager);
+    free(sys->plan);
     free(sys);
 }
 
@@ -306,4 +410,10 @@ vlc_module_begin()
                   "e.g. \"FooBar/1.2.3\"."), true)
         change_safe()
         change_private()
+    add_integer_with_range("http-connections", 1, 1, 16,
+                           N_("Parallel connections"),
+                           N_("Fetch files over this many connections at "
+                              "once, with concurrent byte range requests. "
+                              "This helps with servers that limit the "
+                              "bandwidth of each connection."), true)
 vlc_module_end()
@@ -82,7 +82,7 @@ struct vlc_http_stream *vlc_chunked_open(struct vlc_http_stream *,
  * however be sent with the TLS False Start. This is handled by the TLS stack
  * and does not require a combined function call.
  *
- * \param ctx opaque context pointer for the HTTP connection
+ * \param obj object for the HTTP connection logs and the name resolution
  * \param hostname HTTP server or proxy hostname to connect to
  * \param port TCP port number to connect to
  * \param proxy true of the hostname and port correspond to an HTTP proxy,
@@ -96,7 +96,7 @@ struct vlc_http_stream *vlc_chunked_open(struct vlc_http_stream *,
  * \return an HTTP stream on success, NULL on error
  * \note *connp is undefined on error.
  */
-struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
+struct vlc_http_stream *vlc_h1_request(vlc_object_t *obj, const char *hostname,
                                        unsigned port, bool proxy,
                                        const struct vlc_http_msg *req,
                                        bool idempotent,
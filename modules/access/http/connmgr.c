@@ -24,7 +24,9 @@
 
 #include <assert.h>
 #include <vlc_common.h>
+#include <vlc_list.h>
 #include <vlc_network.h>
+#include <vlc_strings.h>
 #include <vlc_tls.h>
 #include <vlc_url.h>
 #include "transport.h"
@@ -96,88 +98,403 @@ static char *vlc_http_proxy_find(const char *hostname, unsigned port,
 }
 
 
-struct vlc_http_mgr
+/* Idle HTTP/1 connections and shared HTTP/2 connections are closed after this
+ * much time without new requests. */
+#define VLC_HTTP_IDLE_TIMEOUT VLC_TICK_FROM_SEC(30)
+/* Maximum number of idle HTTP/1 connections per pool */
+#define VLC_HTTP_IDLE_MAX 8
+
+/**
+ * Pooled connection.
+ *
+ * HTTP/1 connections belong either to a single manager, or to the idle list
+ * of the pool. HTTP/2 connections are either private to a single manager, or
+ * shared by all managers of the pool.
+ */
+struct vlc_http_pool_conn
+{
+    struct vlc_list node;
+    struct vlc_http_conn *conn;
+    vlc_tick_t deadline; /**< Expiry time (idle or shared connections) */
+    unsigned refs; /**< Users of a shared connection */
+    bool removed; /**< Shared connection is no longer listed */
+    bool http2;
+    bool secure;
+    unsigned port;
+    char host[];
+};
+
+/**
+ * Connection pool.
+ *
+ * There is one pool per LibVLC instance, alive as long as one of its
+ * managers.
+ */
+struct vlc_http_pool
 {
-    struct vlc_logger *logger;
-    vlc_object_t *obj;
+    struct vlc_list node;
+    vlc_object_t *obj; /**< LibVLC instance */
+    unsigned refs;
     vlc_tls_client_t *creds;
+    struct vlc_list shared; /**< Shared HTTP/2 connections */
+    struct vlc_list idle; /**< Idle HTTP/1 connections */
+    unsigned idle_count;
+};
+
+static vlc_mutex_t vlc_http_pools_lock = VLC_STATIC_MUTEX;
+static struct vlc_list vlc_http_pools = VLC_LIST_INITIALIZER(&vlc_http_pools);
+
+struct vlc_http_mgr
+{
+    struct vlc_http_pool *pool;
     struct vlc_http_cookie_jar_t *jar;
-    struct vlc_http_conn *conn;
+    struct vlc_list conns; /**< Connections owned by this manager */
+    bool private;
 };
 
-static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
-                                               const char *host, unsigned port)
+static struct vlc_http_pool_conn *
+vlc_http_pool_conn_create(struct vlc_http_conn *conn, bool http2,
+                          bool secure, const char *host, unsigned port)
+{
+    size_t len = strlen(host) + 1;
+    struct vlc_http_pool_conn *pc = malloc(sizeof (*pc) + len);
+
+    if (unlikely(pc == NULL))
+        return NULL;
+
+    pc->conn = conn;
+    pc->deadline = VLC_TICK_INVALID;
+    pc->refs = 0;
+    pc->removed = false;
+    pc->http2 = http2;
+    pc->secure = secure;
+    pc->port = port;
+    memcpy(pc->host, host, len);
+    return pc;
+}
+
+static void vlc_http_pool_conn_release(struct vlc_http_pool_conn *pc)
+{
+    vlc_http_conn_release(pc->conn);
+    free(pc);
+}
+
+static bool vlc_http_pool_conn_match(const struct vlc_http_pool_conn *pc,
+                                     bool secure, const char *host,
+                                     unsigned port)
+{
+    return pc->secure == secure && pc->port == port
+        && !vlc_ascii_strcasecmp(pc->host, host);
+}
+
+/**
+ * Closes expired connections.
+ *
+ * @note The pools lock must be held.
+ */
+static void vlc_http_pool_prune(struct vlc_http_pool *pool)
+{
+    vlc_tick_t now = vlc_tick_now();
+    struct vlc_http_pool_conn *pc;
+
+    vlc_list_foreach(pc, &pool->idle, node)
+        if (pc->deadline <= now)
+        {
+            vlc_list_remove(&pc->node);
+            pool->idle_count--;
+            vlc_http_pool_conn_release(pc);
+        }
+
+    vlc_list_foreach(pc, &pool->shared, node)
+        if (pc->deadline <= now)
+        {
+            vlc_list_remove(&pc->node);
+            pc->removed = true;
+            if (pc->refs == 0)
+                vlc_http_pool_conn_release(pc);
+        }
+}
+
+static struct vlc_http_pool *vlc_http_pool_hold(vlc_object_t *obj)
+{
+    vlc_object_t *instance = VLC_OBJECT(vlc_object_instance(obj));
+    struct vlc_http_pool *pool;
+
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    vlc_list_foreach(pool, &vlc_http_pools, node)
+        if (pool->obj == instance)
+        {
+            pool->refs++;
+            goto out;
+        }
+
+    pool = malloc(sizeof (*pool));
+    if (likely(pool != NULL))
+    {
+        pool->obj = instance;
+        pool->refs = 1;
+        pool->creds = NULL;
+        vlc_list_init(&pool->shared);
+        vlc_list_init(&pool->idle);
+        pool->idle_count = 0;
+        vlc_list_append(&pool->node, &vlc_http_pools);
+    }
+out:
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+    return pool;
+}
+
+static void vlc_http_pool_release(struct vlc_http_pool *pool)
+{
+    struct vlc_http_pool_conn *pc;
+
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    assert(pool->refs > 0);
+    if (--pool->refs > 0)
+    {
+        vlc_mutex_unlock(&vlc_http_pools_lock);
+        return;
+    }
+    vlc_list_remove(&pool->node);
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+
+    vlc_list_foreach(pc, &pool->idle, node)
+        vlc_http_pool_conn_release(pc);
+    vlc_list_foreach(pc, &pool->shared, node)
+    {
+        assert(pc->refs == 0);
+        vlc_http_pool_conn_release(pc);
+    }
+    if (pool->creds != NULL)
+        vlc_tls_ClientDelete(pool->creds);
+    free(pool);
+}
+
+/**
+ * Gets the TLS credentials of a pool, loading them if needed.
+ */
+static vlc_tls_client_t *vlc_http_pool_get_creds(struct vlc_http_pool *pool)
+{
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    vlc_tls_client_t *creds = pool->creds;
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+
+    if (creds != NULL)
+        return creds;
+
+    /* Load the x509 credentials without blocking the other managers */
+    creds = vlc_tls_ClientCreate(pool->obj);
+    if (creds == NULL)
+        return NULL;
+
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    if (pool->creds == NULL)
+        pool->creds = creds;
+    else
+    {   /* Another manager won the race */
+        vlc_tls_ClientDelete(creds);
+        creds = pool->creds;
+    }
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+    return creds;
+}
+
+/**
+ * Sends a request through an existing connection.
+ *
+ * @return the initial response header, or NULL if the connection is busy,
+ * closing or reset
+ */
+static struct vlc_http_msg *vlc_http_conn_request(struct vlc_http_conn *conn,
+                                                  const struct vlc_http_msg *req)
+{
+    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
+    if (stream == NULL)
+        return NULL;
+
+    /* NOTE: If the request were not idempotent, we would not know if it
+     * was processed by the other end. Thus POST is not used/supported so
+     * far, and CONNECT is treated as if it were idempotent (which works
+     * fine here). */
+    return vlc_http_msg_get_initial(stream);
+}
+
+/**
+ * Sends a request through a shared HTTP/2 connection of the pool.
+ */
+static struct vlc_http_msg *vlc_http_pool_reuse_shared(struct vlc_http_pool *pool,
+                                                       bool secure,
+                                                       const char *host,
+                                                       unsigned port,
+                                                       const struct vlc_http_msg *req)
 {
-    (void) host; (void) port;
-    return mgr->conn;
+    struct vlc_http_pool_conn *pc;
+    struct vlc_http_msg *resp = NULL;
+
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    vlc_list_foreach(pc, &pool->shared, node)
+        if (vlc_http_pool_conn_match(pc, secure, host, port))
+        {
+            pc->refs++;
+            vlc_mutex_unlock(&vlc_http_pools_lock);
+
+            resp = vlc_http_conn_request(pc->conn, req);
+
+            vlc_mutex_lock(&vlc_http_pools_lock);
+            pc->refs--;
+
+            if (resp != NULL)
+            {
+                pc->deadline = vlc_tick_now() + VLC_HTTP_IDLE_TIMEOUT;
+                break;
+            }
+
+            /* Get rid of closing or reset connection */
+            if (!pc->removed)
+            {
+                vlc_list_remove(&pc->node);
+                pc->removed = true;
+            }
+            if (pc->refs == 0)
+                vlc_http_pool_conn_release(pc);
+            break;
+        }
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+    return resp;
 }
 
-static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
-                                 struct vlc_http_conn *conn)
+/**
+ * Sends a request through an idle HTTP/1 connection of the pool.
+ *
+ * If successful, the connection is moved to the manager.
+ */
+static struct vlc_http_msg *vlc_http_pool_reuse_idle(struct vlc_http_mgr *mgr,
+                                                     bool secure,
+                                                     const char *host,
+                                                     unsigned port,
+                                                     const struct vlc_http_msg *req)
 {
-    assert(mgr->conn == conn);
-    mgr->conn = NULL;
+    struct vlc_http_pool *pool = mgr->pool;
 
-    vlc_http_conn_release(conn);
+    for (;;)
+    {
+        struct vlc_http_pool_conn *found = NULL, *pc;
+
+        vlc_mutex_lock(&vlc_http_pools_lock);
+        /* Most recently used last: least likely to be closed by the peer */
+        vlc_list_foreach(pc, &pool->idle, node)
+            if (vlc_http_pool_conn_match(pc, secure, host, port))
+                found = pc;
+        if (found != NULL)
+        {
+            vlc_list_remove(&found->node);
+            pool->idle_count--;
+        }
+        vlc_mutex_unlock(&vlc_http_pools_lock);
+
+        if (found == NULL)
+            return NULL;
+
+        struct vlc_http_msg *resp = vlc_http_conn_request(found->conn, req);
+        if (resp != NULL)
+        {
+            vlc_list_append(&found->node, &mgr->conns);
+            return resp;
+        }
+        vlc_http_pool_conn_release(found);
+    }
 }
 
 static
-struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
+struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr, bool secure,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
-    struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
-    if (conn == NULL)
-        return NULL;
+    struct vlc_http_pool_conn *pc;
+
+    /* Own connections first */
+    vlc_list_foreach(pc, &mgr->conns, node)
+        if (vlc_http_pool_conn_match(pc, secure, host, port))
+        {
+            struct vlc_http_msg *resp = vlc_http_conn_request(pc->conn, req);
+            if (resp != NULL)
+                return resp;
+
+            /* Get rid of closing or reset connection */
+            vlc_list_remove(&pc->node);
+            vlc_http_pool_conn_release(pc);
+        }
+
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    vlc_http_pool_prune(mgr->pool);
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+
+    if (secure && !mgr->private)
+    {
+        struct vlc_http_msg *resp =
+            vlc_http_pool_reuse_shared(mgr->pool, secure, host, port, req);
+        if (resp != NULL)
+            return resp;
+    }
 
-    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
+    return vlc_http_pool_reuse_idle(mgr, secure, host, port, req);
+}
+
+/**
+ * Adds a new connection to a manager, or to its pool if shared.
+ */
+static int vlc_http_mgr_add(struct vlc_http_mgr *mgr, struct vlc_http_conn *conn,
+                            bool http2, bool secure, const char *host,
+                            unsigned port)
+{
+    struct vlc_http_pool_conn *pc = vlc_http_pool_conn_create(conn, http2,
+                                                              secure, host,
+                                                              port);
+    bool shared = http2 && !mgr->private;
+
+    if (unlikely(pc == NULL))
     {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
-
-        /* NOTE: If the request were not idempotent, we would not know if it
-         * was processed by the other end. Thus POST is not used/supported so
-         * far, and CONNECT is treated as if it were idempotent (which works
-         * fine here). */
+        vlc_http_conn_release(conn);
+        return -1;
+    }
+
+    if (shared)
+    {
+        vlc_mutex_lock(&vlc_http_pools_lock);
+        pc->deadline = vlc_tick_now() + VLC_HTTP_IDLE_TIMEOUT;
+        vlc_list_append(&pc->node, &mgr->pool->shared);
+        vlc_mutex_unlock(&vlc_http_pools_lock);
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
-    return NULL;
+    else
+        vlc_list_append(&pc->node, &mgr->conns);
+    return 0;
 }
 
 static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const char *host, unsigned port,
                                               const struct vlc_http_msg *req)
 {
+    struct vlc_http_pool *pool = mgr->pool;
     vlc_tls_t *tls;
     bool http2 = true;
 
-    if (mgr->creds == NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTP to HTTPS not implemented */
-
-    if (mgr->creds == NULL)
-    {   /* First TLS connection: load x509 credentials */
-        mgr->creds = vlc_tls_ClientCreate(mgr->obj);
-        if (mgr->creds == NULL)
-            return NULL;
-    }
-
     /* TODO? non-idempotent request support */
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, true, host, port, req);
     if (resp != NULL)
         return resp; /* existing connection reused */
 
+    vlc_tls_client_t *creds = vlc_http_pool_get_creds(pool);
+    if (creds == NULL)
+        return NULL;
+
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
-                                      host, port, &http2, proxy);
+        tls = vlc_https_connect_proxy(creds, creds, host, port, &http2, proxy);
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(creds, host, port, &http2);
 
     if (tls == NULL)
         return NULL;
@@ -192,9 +509,9 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
      * NOTE: We do not enforce TLS version 1.2 for HTTP 2.0 explicitly.
      */
     if (http2)
-        conn = vlc_h2_conn_create(mgr->logger, tls);
+        conn = vlc_h2_conn_create(pool->obj->logger, tls);
     else
-        conn = vlc_h1_conn_create(mgr->logger, tls, false);
+        conn = vlc_h1_conn_create(pool->obj->logger, tls, false);
 
     if (unlikely(conn == NULL))
     {
@@ -202,22 +519,23 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (vlc_http_mgr_add(mgr, conn, http2, true, host, port))
+        return NULL;
 
-    return vlc_http_mgr_reuse(mgr, host, port, req);
+    return vlc_http_mgr_reuse(mgr, true, host, port, req);
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
-        return NULL; /* switch from HTTPS to HTTP not implemented */
-
-    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
+    struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, false, host, port,
+                                                   req);
     if (resp != NULL)
         return resp;
 
+    /* Connections outlive their manager, so they log via the instance */
+    vlc_object_t *obj = mgr->pool->obj;
     struct vlc_http_conn *conn;
     struct vlc_http_stream *stream;
 
@@ -230,7 +548,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         free(proxy);
 
         if (url.psz_host != NULL)
-            stream = vlc_h1_request(mgr->logger, url.psz_host,
+            stream = vlc_h1_request(obj, url.psz_host,
                                     url.i_port ? url.i_port : 80, true, req,
                                     true, &conn);
         else
@@ -239,7 +557,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         vlc_UrlClean(&url);
     }
     else
-        stream = vlc_h1_request(mgr->logger, host, port ? port : 80, false,
+        stream = vlc_h1_request(obj, host, port ? port : 80, false,
                                 req, true, &conn);
 
     if (stream == NULL)
@@ -252,7 +570,11 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    if (vlc_http_mgr_add(mgr, conn, false, false, host, port))
+    {
+        vlc_http_msg_destroy(resp);
+        return NULL;
+    }
     return resp;
 }
 
@@ -271,26 +593,74 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
     return mgr->jar;
 }
 
-struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
-                                         struct vlc_http_cookie_jar_t *jar)
+static struct vlc_http_mgr *vlc_http_mgr_new(vlc_object_t *obj,
+                                             struct vlc_http_cookie_jar_t *jar,
+                                             bool private)
 {
     struct vlc_http_mgr *mgr = malloc(sizeof (*mgr));
     if (unlikely(mgr == NULL))
         return NULL;
 
-    mgr->logger = obj->logger;
-    mgr->obj = obj;
-    mgr->creds = NULL;
+    mgr->pool = vlc_http_pool_hold(obj);
+    if (unlikely(mgr->pool == NULL))
+    {
+        free(mgr);
+        return NULL;
+    }
+
     mgr->jar = jar;
-    mgr->conn = NULL;
+    vlc_list_init(&mgr->conns);
+    mgr->private = private;
     return mgr;
 }
 
+struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
+                                         struct vlc_http_cookie_jar_t *jar)
+{
+    return vlc_http_mgr_new(obj, jar, false);
+}
+
+struct vlc_http_mgr *vlc_http_mgr_create_private(vlc_object_t *obj,
+                                                 struct vlc_http_cookie_jar_t *jar)
+{
+    return vlc_http_mgr_new(obj, jar, true);
+}
+
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
 {
-    if (mgr->conn != NULL)
-        vlc_http_mgr_release(mgr, mgr->conn);
-    if (mgr->creds != NULL)
-        vlc_tls_ClientDelete(mgr->creds);
+    struct vlc_http_pool *pool = mgr->pool;
+    struct vlc_http_pool_conn *pc;
+    vlc_tick_t deadline = vlc_tick_now() + VLC_HTTP_IDLE_TIMEOUT;
+
+    /* Keep the HTTP/1 connections that are still usable for later managers.
+     * HTTP/2 connections of private managers are closed. */
+    vlc_mutex_lock(&vlc_http_pools_lock);
+    vlc_list_foreach(pc, &mgr->conns, node)
+    {
+        vlc_list_remove(&pc->node);
+
+        if (pc->http2 || pc->conn->tls == NULL)
+        {
+            vlc_http_pool_conn_release(pc);
+            continue;
+        }
+
+        if (pool->idle_count >= VLC_HTTP_IDLE_MAX)
+        {   /* Evict the least recently used connection */
+            struct vlc_http_pool_conn *old =
+                vlc_list_first_entry_or_null(&pool->idle,
+                                             struct vlc_http_pool_conn, node);
+            vlc_list_remove(&old->node);
+            pool->idle_count--;
+            vlc_http_pool_conn_release(old);
+        }
+
+        pc->deadline = deadline;
+        vlc_list_append(&pc->node, &pool->idle);
+        pool->idle_count++;
+    }
+    vlc_mutex_unlock(&vlc_http_pools_lock);
+
+    vlc_http_pool_release(pool);
     free(mgr);
 }
@@ -59,17 +59,36 @@ struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
  *
  * Allocates an HTTP client connections manager.
  *
+ * Managers of the same LibVLC instance share a connection pool: HTTP/1
+ * connections that are still usable are kept alive after their manager is
+ * destroyed, and reused by later managers for the same origin, while HTTP/2
+ * connections are used concurrently by all managers. Unused connections are
+ * closed after some time.
+ *
  * @param obj parent VLC object
  * @param jar HTTP cookies jar (NULL to disable cookies)
  */
 struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
                                          struct vlc_http_cookie_jar_t *jar);
 
+/**
+ * Creates an HTTP connection manager with private HTTP/2 connections
+ *
+ * This is the same as vlc_http_mgr_create(), except that HTTP/2 connections
+ * are neither shared with, nor taken from other managers. This is meant for
+ * concurrent requests that must not be multiplexed over a single connection.
+ */
+struct vlc_http_mgr *vlc_http_mgr_create_private(vlc_object_t *obj,
+                                                 struct vlc_http_cookie_jar_t *jar);
+
 /**
  * Destroys an HTTP connection manager
  *
  * Deallocates an HTTP client connections manager created by
- * vlc_http_msg_destroy(). Any remaining connection is closed and destroyed.
+ * vlc_http_mgr_create(). Connections that can be reused are returned to the
+ * pool, and others are closed and destroyed.
+ *
+ * @note All HTTP streams of the manager must have been closed.
  */
 void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr);
 
@@ -43,13 +43,21 @@ struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t end; /**< Last requested byte, or UINTMAX_MAX */
+};
+
+struct vlc_http_file_range
+{
+    uintmax_t offset;
+    uintmax_t end;
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
                              struct vlc_http_msg *req, void *opaque)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
-    const uintmax_t *offset = opaque;
+    const struct vlc_http_file_range *range = opaque;
+    const uintmax_t *offset = &range->offset;
 
     if (file->resource.response != NULL)
     {
@@ -69,6 +77,11 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
         }
     }
 
+    if (range->end != UINTMAX_MAX)
+        return vlc_http_msg_add_header(req, "Range",
+                                       "bytes=%" PRIuMAX "-%" PRIuMAX,
+                                       *offset, range->end);
+
     if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", *offset)
      && *offset != 0)
         return -1;
@@ -78,7 +91,8 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
 static int vlc_http_file_resp(const struct vlc_http_resource *res,
                               const struct vlc_http_msg *resp, void *opaque)
 {
-    const uintmax_t *offset = opaque;
+    const struct vlc_http_file_range *range = opaque;
+    const uintmax_t *offset = &range->offset;
 
     if (vlc_http_msg_get_status(resp) == 206)
     {
@@ -126,6 +140,7 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->end = UINTMAX_MAX;
     return &file->resource;
 }
 
@@ -201,9 +216,11 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *res)
     return vlc_http_msg_can_seek(res->response);
 }
 
-int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+int vlc_http_file_seek_range(struct vlc_http_resource *res, uintmax_t offset,
+                             uintmax_t end)
 {
-    struct vlc_http_msg *resp = vlc_http_res_open(res, &offset);
+    struct vlc_http_file_range range = { offset, end };
+    struct vlc_http_msg *resp = vlc_http_res_open(res, &range);
     if (resp == NULL)
         return -1;
 
@@ -226,9 +243,16 @@ int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
 
     res->response = resp;
     file->offset = offset;
+    /* The server may have ignored the range and sent the whole entity */
+    file->end = (status == 206) ? end : UINTMAX_MAX;
     return 0;
 }
 
+int vlc_http_file_seek(struct vlc_http_resource *res, uintmax_t offset)
+{
+    return vlc_http_file_seek_range(res, offset, UINTMAX_MAX);
+}
+
 block_t *vlc_http_file_read(struct vlc_http_resource *res)
 {
     struct vlc_http_file *file = (struct vlc_http_file *)res;
@@ -246,6 +270,15 @@ block_t *vlc_http_file_read(struct vlc_http_resource *res)
             return NULL;
     }
 
+    if (block == NULL && file->end != UINTMAX_MAX
+     && file->offset == file->end + 1
+     && file->offset < vlc_http_msg_get_file_size(res->response))
+    {   /* End of the requested range: carry on with the rest of the file */
+        if (vlc_http_file_seek(res, file->offset))
+            return NULL;
+        return vlc_http_file_read(res);
+    }
+
     if (block == NULL)
         return NULL; /* End of stream */
 
@@ -72,6 +72,21 @@ bool vlc_http_file_can_seek(struct vlc_http_resource *);
  */
 int vlc_http_file_seek(struct vlc_http_resource *, uintmax_t offset);
 
+/**
+ * Sets the read offset and the end of the next request.
+ *
+ * Only the given range is requested, so that the response completes and the
+ * connection can be reused for the following request. Reading beyond the
+ * range transparently requests the rest of the file.
+ *
+ * @param offset byte offset of next read
+ * @param end offset of the last byte to request, or UINTMAX_MAX for no limit
+ * @retval 0 if seek succeeded
+ * @retval -1 if seek failed
+ */
+int vlc_http_file_seek_range(struct vlc_http_resource *, uintmax_t offset,
+                             uintmax_t end);
+
 /**
  * Reads data.
  *
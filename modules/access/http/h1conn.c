@@ -219,6 +219,8 @@ static struct vlc_http_msg *vlc_h1_stream_wait(struct vlc_http_stream *stream)
                 vlc_http_msg_destroy(resp);
                 return vlc_h1_stream_fatal(conn);
             }
+            /* The chunked decoder tracks the end of the message body */
+            conn->content_length = 0;
         }
     }
     else
@@ -274,7 +276,8 @@ static void vlc_h1_stream_close(struct vlc_http_stream *stream, bool abort)
 
     assert(conn->active);
 
-    if (abort)
+    /* Do not reuse the connection if the response body was not fully read */
+    if (abort || conn->connection_close || conn->content_length != 0)
         vlc_h1_stream_fatal(conn);
 
     conn->active = false;
@@ -337,7 +340,7 @@ struct vlc_http_conn *vlc_h1_conn_create(void *ctx, vlc_tls_t *tls, bool proxy)
     return &conn->conn;
 }
 
-struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
+struct vlc_http_stream *vlc_h1_request(vlc_object_t *obj, const char *hostname,
                                        unsigned port, bool proxy,
                                        const struct vlc_http_msg *req,
                                        bool idempotent,
@@ -348,10 +351,11 @@ struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
         .ai_socktype = SOCK_STREAM,
         .ai_protocol = IPPROTO_TCP,
     }, *res;
+    void *ctx = obj->logger;
 
     vlc_http_dbg(ctx, "resolving %s ...", hostname);
 
-    int val = vlc_getaddrinfo_i11e(hostname, port, &hints, &res);
+    int val = vlc_dns_Resolve(obj, hostname, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         vlc_http_err(ctx, "cannot resolve %s: %s", hostname,
@@ -385,7 +389,7 @@ struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
             else
                 vlc_http_conn_release(conn);
 
-            freeaddrinfo(res);
+            vlc_dns_Free(res);
             return stream;
         }
 
@@ -396,6 +400,6 @@ struct vlc_http_stream *vlc_h1_request(void *ctx, const char *hostname,
     }
 
     /* All address info failed. */
-    freeaddrinfo(res);
+    vlc_dns_Free(res);
     return NULL;
 }
@@ -45,6 +45,10 @@
 #define CO(c) ((c)->opaque)
 #define SO(s) CO((s)->conn)
 
+/* Receive window auto-tuning */
+#define VLC_H2_MAX_RECV_WINDOW (16 << 20) /* Maximum stream receive window */
+#define VLC_H2_RECV_BUDGET     (64 << 20) /* Extra window per connection */
+
 /** HTTP/2 connection */
 struct vlc_h2_conn
 {
@@ -59,6 +63,11 @@ struct vlc_h2_conn
     uint32_t init_send_cwnd; /**< Initial send congestion window */
     uint64_t send_cwnd; /**< Send congestion window */
 
+    size_t recv_budget; /**< Window growth left for all streams */
+    vlc_tick_t rtt; /**< Round-trip time estimate (or VLC_TICK_INVALID) */
+    vlc_tick_t ping_date; /**< Outstanding PING send time */
+    uint64_t ping_opaque; /**< Outstanding PING payload */
+
     vlc_mutex_t lock; /**< State machine lock */
     vlc_thread_t thread; /**< Receive thread */
 };
@@ -80,6 +89,8 @@ struct vlc_h2_stream
     struct vlc_http_msg *recv_hdr; /**< Latest received headers (or NULL) */
 
     size_t recv_cwnd; /**< Free space in receive congestion window */
+    size_t recv_window; /**< Receive congestion window size */
+    vlc_tick_t recv_credit_date; /**< Time of last receive window credit */
     struct vlc_h2_frame *recv_head; /**< Earliest pending received buffer */
     struct vlc_h2_frame **recv_tailp; /**< Tail of receive queue */
     vlc_cond_t recv_wait;
@@ -100,6 +111,18 @@ static int vlc_h2_conn_queue_prio(struct vlc_h2_conn *conn,
     return vlc_h2_output_send_prio(conn->out, f);
 }
 
+/** Sends a PING to measure the round-trip time, unless one is pending. */
+static void vlc_h2_conn_ping(struct vlc_h2_conn *conn)
+{
+    if (conn->ping_date != VLC_TICK_INVALID)
+        return;
+
+    conn->ping_opaque++;
+    if (vlc_h2_conn_queue(conn, vlc_h2_frame_ping(conn->ping_opaque)))
+        return;
+    conn->ping_date = vlc_tick_now();
+}
+
 
 /* Stream callbacks */
 
@@ -323,10 +346,40 @@ static block_t *vlc_h2_stream_read(struct vlc_http_stream *stream)
     }
 
     /* Credit the receive window if missing credit exceeds 50%. */
-    uint_fast32_t credit = VLC_H2_INIT_WINDOW - s->recv_cwnd;
-    if (credit >= (VLC_H2_INIT_WINDOW / 2)
-     && !vlc_h2_conn_queue(conn, vlc_h2_frame_window_update(s->id, credit)))
-        s->recv_cwnd += credit;
+    uint_fast32_t credit = s->recv_window - s->recv_cwnd;
+    if (credit >= (s->recv_window / 2))
+    {
+        vlc_tick_t now = vlc_tick_now();
+        size_t growth = 0;
+
+        /* If half of the window was consumed within two round trips, the
+         * window limits the throughput: double it, within the budget. */
+        if (conn->rtt != VLC_TICK_INVALID
+         && now - s->recv_credit_date < 2 * conn->rtt)
+        {
+            growth = __MIN(s->recv_window,
+                           VLC_H2_MAX_RECV_WINDOW - s->recv_window);
+            growth = __MIN(growth, conn->recv_budget);
+        }
+
+        if (!vlc_h2_conn_queue(conn,
+                              vlc_h2_frame_window_update(s->id,
+                                                         credit + growth)))
+        {
+            s->recv_cwnd += credit + growth;
+            s->recv_credit_date = now;
+
+            if (growth > 0)
+            {
+                s->recv_window += growth;
+                conn->recv_budget -= growth;
+                vlc_http_dbg(SO(s), "stream %"PRIu32" receive window: %zu",
+                             s->id, s->recv_window);
+                /* Refresh the round-trip time estimate */
+                vlc_h2_conn_ping(conn);
+            }
+        }
+    }
 
     vlc_h2_stream_unlock(s);
 
@@ -374,6 +427,7 @@ static void vlc_h2_stream_close(struct vlc_http_stream *stream, bool aborted)
         conn->streams = s->older;
         destroy = (conn->streams == NULL) && conn->released;
     }
+    conn->recv_budget += s->recv_window - VLC_H2_INIT_WINDOW;
     vlc_mutex_unlock(&conn->lock);
 
     if (s->recv_hdr != NULL || s->recv_head != NULL || !s->recv_end)
@@ -431,6 +485,8 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
     s->recv_err = 0;
     s->recv_hdr = NULL;
     s->recv_cwnd = VLC_H2_INIT_WINDOW;
+    s->recv_window = VLC_H2_INIT_WINDOW;
+    s->recv_credit_date = vlc_tick_now();
     s->recv_head = NULL;
     s->recv_tailp = &s->recv_head;
     vlc_cond_init(&s->recv_wait);
@@ -513,6 +569,20 @@ static int vlc_h2_ping(void *ctx, uint_fast64_t opaque)
     return vlc_h2_conn_queue_prio(conn, vlc_h2_frame_pong(opaque));
 }
 
+/** Reports a ping acknowledgement from HTTP/2 peer */
+static void vlc_h2_pong(void *ctx, uint_fast64_t opaque)
+{
+    struct vlc_h2_conn *conn = ctx;
+
+    if (conn->ping_date == VLC_TICK_INVALID || opaque != conn->ping_opaque)
+        return; /* not ours */
+
+    conn->rtt = vlc_tick_now() - conn->ping_date;
+    conn->ping_date = VLC_TICK_INVALID;
+    vlc_http_dbg(CO(conn), "round-trip time: %"PRId64" us",
+                 US_FROM_VLC_TICK(conn->rtt));
+}
+
 /** Reports a local HTTP/2 connection failure */
 static void vlc_h2_error(void *ctx, uint_fast32_t code)
 {
@@ -579,6 +649,7 @@ static const struct vlc_h2_parser_cbs vlc_h2_parser_callbacks =
     vlc_h2_setting,
     vlc_h2_settings_done,
     vlc_h2_ping,
+    vlc_h2_pong,
     vlc_h2_error,
     vlc_h2_reset,
     vlc_h2_window_status,
@@ -722,8 +793,9 @@ static void *vlc_h2_recv_thread(void *data)
     vlc_cleanup_pop();
     vlc_h2_parse_destroy(parser);
 fail:
-    /* Terminate any remaining stream */
+    /* Terminate any remaining stream, and refuse new ones */
     vlc_mutex_lock(&conn->lock);
+    conn->next_id = 0x80000000;
     for (struct vlc_h2_stream *s = conn->streams; s != NULL; s = s->older)
         vlc_h2_stream_reset(s, VLC_H2_CANCEL);
     vlc_mutex_unlock(&conn->lock);
@@ -783,20 +855,28 @@ struct vlc_http_conn *vlc_h2_conn_create(void *ctx, struct vlc_tls *tls)
     conn->released = false;
     conn->init_send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
     conn->send_cwnd = VLC_H2_DEFAULT_INIT_WINDOW;
+    conn->recv_budget = VLC_H2_RECV_BUDGET;
+    conn->rtt = VLC_TICK_INVALID;
+    conn->ping_date = VLC_TICK_INVALID;
+    conn->ping_opaque = 0;
 
     if (unlikely(conn->out == NULL))
         goto error;
 
     vlc_mutex_init(&conn->lock);
 
-    if (vlc_h2_conn_queue(conn, vlc_h2_frame_settings())
-     || vlc_clone(&conn->thread, vlc_h2_recv_thread, conn,
+    if (vlc_h2_conn_queue(conn, vlc_h2_frame_settings()))
+        goto error_out;
+
+    /* Measure the round-trip time early, for receive window tuning */
+    vlc_h2_conn_ping(conn);
+
+    if (vlc_clone(&conn->thread, vlc_h2_recv_thread, conn,
                   VLC_THREAD_PRIORITY_INPUT))
-    {
-        vlc_h2_output_destroy(conn->out);
-        goto error;
-    }
+        goto error_out;
     return &conn->conn;
+error_out:
+    vlc_h2_output_destroy(conn->out);
 error:
     free(conn);
     return NULL;
@@ -811,15 +811,16 @@ static int vlc_h2_parse_frame_ping(struct vlc_h2_parser *p,
         return vlc_h2_parse_error(p, VLC_H2_FRAME_SIZE_ERROR);
     }
 
+    memcpy(&opaque, vlc_h2_frame_payload(f), 8);
+
     if (vlc_h2_frame_flags(f) & VLC_H2_PING_ACK)
     {
         free(f);
+        p->cbs->pong(p->opaque, opaque);
         return 0;
     }
 
-    memcpy(&opaque, vlc_h2_frame_payload(f), 8);
     free(f);
-
     return p->cbs->ping(p->opaque, opaque);
 }
 
@@ -102,6 +102,7 @@ struct vlc_h2_parser_cbs
     void (*setting)(void *ctx, uint_fast16_t id, uint_fast32_t value);
     int  (*settings_done)(void *ctx);
     int  (*ping)(void *ctx, uint_fast64_t opaque);
+    void (*pong)(void *ctx, uint_fast64_t opaque);
     void (*error)(void *ctx, uint_fast32_t code);
     int  (*reset)(void *ctx, uint_fast32_t last_seq, uint_fast32_t code);
     void (*window_status)(void *ctx, uint32_t *rcwd);
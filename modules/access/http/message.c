@@ -293,6 +293,15 @@ block_t *vlc_http_msg_read(struct vlc_http_msg *m)
     return vlc_http_stream_read(m->payload);
 }
 
+void vlc_http_msg_close(struct vlc_http_msg *m)
+{
+    if (m->payload == NULL)
+        return;
+
+    vlc_http_stream_close(m->payload, true);
+    m->payload = NULL;
+}
+
 /* Serialization and deserialization */
 
 char *vlc_http_msg_format(const struct vlc_http_msg *m, size_t *restrict lenp,
@@ -288,6 +288,15 @@ struct vlc_http_msg *vlc_http_msg_get_final(struct vlc_http_msg *) VLC_USED;
  */
 struct block_t *vlc_http_msg_read(struct vlc_http_msg *) VLC_USED;
 
+/**
+ * Closes HTTP data.
+ *
+ * Discards the rest of the payload of an HTTP message, and releases the
+ * underlying stream. The message headers remain available. Subsequent reads
+ * return end-of-stream.
+ */
+void vlc_http_msg_close(struct vlc_http_msg *);
+
 /** @} */
 
 /**
@@ -0,0 +1,636 @@
+/*****************************************************************************
+ * ranged.c: HTTP read-only file over parallel range requests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+#include "conn.h"
+#include "connmgr.h"
+#include "message.h"
+#include "resource.h"
+#include "file.h"
+#include "ranged.h"
+
+#pragma GCC visibility push(default)
+
+/* Chunk sizes are adapted so that each request lasts about that long.
+ * Longer requests would delay the reassembly after a seek, and shorter ones
+ * would waste more time on round trips. */
+#define RANGED_CHUNK_DURATION VLC_TICK_FROM_SEC(2)
+#define RANGED_CHUNK_MIN      (256 << 10)
+#define RANGED_CHUNK_MAX      (4 << 20)
+/* Attempts to fetch a given chunk before giving up */
+#define RANGED_RETRIES        3
+
+struct vlc_http_chunk
+{
+    struct vlc_http_chunk *next;
+    struct vlc_http_worker *worker; /**< Fetching worker, or NULL */
+    uintmax_t offset; /**< File offset of the chunk */
+    size_t length; /**< Total bytes in the chunk */
+    size_t received; /**< Bytes received from the server */
+    size_t consumed; /**< Bytes read or skipped by the reader */
+    block_t *head; /**< Received but not consumed data */
+    block_t **tailp;
+    unsigned retries;
+    bool failed;
+    bool cancelled;
+};
+
+struct vlc_http_range_res
+{
+    struct vlc_http_resource resource;
+    const struct vlc_http_ranged *ranged;
+};
+
+struct vlc_http_worker
+{
+    struct vlc_http_ranged *ranged;
+    struct vlc_http_mgr *manager;
+    struct vlc_http_resource *resource;
+    vlc_interrupt_t *interrupt;
+    vlc_thread_t thread;
+};
+
+struct vlc_http_ranged
+{
+    struct vlc_logger *logger;
+    uintmax_t size;
+    char *etag; /**< Entity tag, verbatim */
+    bool etag_weak;
+    time_t mtime;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait_data; /**< Reader waiting for data */
+    vlc_cond_t wait_work; /**< Workers waiting for chunks to fetch */
+    struct vlc_http_chunk *chunks; /**< Chunks, from the read offset on */
+    struct vlc_http_chunk **tailp;
+    unsigned chunks_count;
+    unsigned chunks_max;
+    uintmax_t offset; /**< Read offset */
+    uintmax_t next; /**< Offset of the next chunk to create */
+    size_t chunk_size;
+    bool interrupted;
+    bool dead;
+
+    unsigned workers_count;
+    struct vlc_http_worker workers[];
+};
+
+struct vlc_http_range
+{
+    uintmax_t start;
+    uintmax_t end; /* inclusive */
+};
+
+static int vlc_http_range_req(const struct vlc_http_resource *res,
+                              struct vlc_http_msg *req, void *opaque)
+{
+    const struct vlc_http_ranged *ranged =
+        container_of(res, struct vlc_http_range_res, resource)->ranged;
+    const struct vlc_http_range *range = opaque;
+
+    /* Fail rather than mix chunks from different versions of the entity.
+     * If-Match compares strongly, so a weak tag would never match (RFC7232
+     * §3.1): fall back to the modification time, or to If-Range, whereby a
+     * changed entity yields a full (200) response instead of the range. */
+    if (ranged->etag != NULL && !ranged->etag_weak)
+        vlc_http_msg_add_header(req, "If-Match", "%s", ranged->etag);
+    else if (ranged->mtime != -1)
+        vlc_http_msg_add_time(req, "If-Unmodified-Since", &ranged->mtime);
+    else if (ranged->etag != NULL)
+        vlc_http_msg_add_header(req, "If-Range", "%s", ranged->etag);
+
+    return vlc_http_msg_add_header(req, "Range",
+                                   "bytes=%" PRIuMAX "-%" PRIuMAX,
+                                   range->start, range->end);
+}
+
+static int vlc_http_range_resp(const struct vlc_http_resource *res,
+                               const struct vlc_http_msg *resp, void *opaque)
+{
+    const struct vlc_http_range *range = opaque;
+
+    if (vlc_http_msg_get_status(resp) != 206)
+        return -1; /* ignored range, changed entity, or error */
+
+    const char *str = vlc_http_msg_get_header(resp, "Content-Range");
+    uintmax_t start, end;
+
+    if (str == NULL
+     || sscanf(str, "bytes %" SCNuMAX "-%" SCNuMAX, &start, &end) != 2
+     || start != range->start || start > end)
+        return -1;
+
+    (void) res;
+    return 0;
+}
+
+static const struct vlc_http_resource_cbs vlc_http_range_callbacks =
+{
+    vlc_http_range_req,
+    vlc_http_range_resp,
+};
+
+static struct vlc_http_resource *
+vlc_http_range_res_create(const struct vlc_http_ranged *ranged,
+                          struct vlc_http_mgr *mgr,
+                          const struct vlc_http_resource *file)
+{
+    struct vlc_http_range_res *res = malloc(sizeof (*res));
+    char *uri;
+
+    if (unlikely(res == NULL))
+        return NULL;
+
+    if (unlikely(asprintf(&uri, "http%s://%s%s", file->secure ? "s" : "",
+                          file->authority, file->path) == -1))
+    {
+        free(res);
+        return NULL;
+    }
+
+    int val = vlc_http_res_init(&res->resource, &vlc_http_range_callbacks,
+                                mgr, uri, file->agent, file->referrer);
+    free(uri);
+    if (val)
+    {
+        free(res);
+        return NULL;
+    }
+
+    res->ranged = ranged;
+    if (file->username != NULL
+     && vlc_http_res_set_login(&res->resource, file->username,
+                               file->password))
+    {
+        vlc_http_res_destroy(&res->resource);
+        return NULL;
+    }
+    return &res->resource;
+}
+
+static void vlc_http_chunk_destroy(struct vlc_http_chunk *c)
+{
+    block_ChainRelease(c->head);
+    free(c);
+}
+
+/**
+ * Queues data received for a chunk.
+ *
+ * Data beyond the chunk is discarded, and so is data that the reader skipped.
+ */
+static void vlc_http_chunk_append(struct vlc_http_chunk *c, block_t *block)
+{
+    size_t size = block->i_buffer;
+
+    if (size > c->length - c->received)
+        block->i_buffer = size = c->length - c->received;
+
+    if (c->consumed > c->received)
+    {
+        size_t skip = __MIN(size, c->consumed - c->received);
+
+        block->p_buffer += skip;
+        block->i_buffer -= skip;
+    }
+
+    c->received += size;
+
+    if (block->i_buffer == 0)
+    {
+        block_Release(block);
+        return;
+    }
+
+    block->p_next = NULL;
+    *(c->tailp) = block;
+    c->tailp = &block->p_next;
+}
+
+/**
+ * Skips data from a chunk up to the given chunk position.
+ */
+static void vlc_http_chunk_skip(struct vlc_http_chunk *c, size_t consumed)
+{
+    size_t skip = consumed - c->consumed;
+
+    assert(consumed >= c->consumed && consumed <= c->length);
+
+    while (skip > 0 && c->head != NULL)
+    {
+        block_t *block = c->head;
+
+        if (block->i_buffer > skip)
+        {
+            block->p_buffer += skip;
+            block->i_buffer -= skip;
+            break;
+        }
+
+        skip -= block->i_buffer;
+        c->head = block->p_next;
+        if (c->head == NULL)
+            c->tailp = &c->head;
+        block_Release(block);
+    }
+    c->consumed = consumed;
+}
+
+/**
+ * Removes the first chunk.
+ *
+ * If a worker is still fetching the chunk, the fetch is cancelled and the
+ * worker destroys the chunk.
+ */
+static void vlc_http_ranged_drop(struct vlc_http_ranged *r)
+{
+    struct vlc_http_chunk *c = r->chunks;
+
+    r->chunks = c->next;
+    if (r->chunks == NULL)
+        r->tailp = &r->chunks;
+    r->chunks_count--;
+
+    if (c->worker != NULL)
+    {
+        c->cancelled = true;
+        vlc_interrupt_raise(c->worker->interrupt);
+    }
+    else
+        vlc_http_chunk_destroy(c);
+}
+
+/**
+ * Picks a chunk to fetch.
+ *
+ * Incomplete chunks that are not being fetched come first, so that holes
+ * left by failed requests are filled before new chunks are requested.
+ */
+static struct vlc_http_chunk *vlc_http_ranged_pick(struct vlc_http_ranged *r)
+{
+    for (struct vlc_http_chunk *c = r->chunks; c != NULL; c = c->next)
+        if (c->worker == NULL && !c->failed && c->received < c->length)
+            return c;
+
+    if (r->next >= r->size || r->chunks_count >= r->chunks_max)
+        return NULL;
+
+    struct vlc_http_chunk *c = malloc(sizeof (*c));
+    if (unlikely(c == NULL))
+        return NULL;
+
+    c->next = NULL;
+    c->worker = NULL;
+    c->offset = r->next;
+    c->length = __MIN(r->chunk_size, r->size - r->next);
+    c->received = 0;
+    c->consumed = 0;
+    c->head = NULL;
+    c->tailp = &c->head;
+    c->retries = 0;
+    c->failed = false;
+    c->cancelled = false;
+
+    *(r->tailp) = c;
+    r->tailp = &c->next;
+    r->chunks_count++;
+    r->next += c->length;
+    return c;
+}
+
+static void vlc_http_ranged_adapt(struct vlc_http_ranged *r, size_t length,
+                                  vlc_tick_t duration)
+{
+    uintmax_t target = (uintmax_t)length * RANGED_CHUNK_DURATION
+                       / __MAX(duration, 1);
+
+    vlc_mutex_lock(&r->lock);
+    target = (r->chunk_size + target) / 2;
+    r->chunk_size = VLC_CLIP(target, RANGED_CHUNK_MIN, RANGED_CHUNK_MAX);
+    vlc_mutex_unlock(&r->lock);
+}
+
+static void vlc_http_ranged_fetch(struct vlc_http_worker *w,
+                                  struct vlc_http_chunk *c)
+{
+    struct vlc_http_ranged *r = w->ranged;
+    /* Only the fetching worker changes the offset and received bytes */
+    const size_t requested = c->length - c->received;
+    struct vlc_http_range range = {
+        .start = c->offset + c->received,
+        .end = c->offset + c->length - 1,
+    };
+    vlc_tick_t start = vlc_tick_now();
+
+    struct vlc_http_msg *resp = vlc_http_res_open(w->resource, &range);
+    if (resp == NULL)
+        return;
+
+    while (c->received < c->length)
+    {
+        block_t *block = vlc_http_msg_read(resp);
+        if (block == NULL || block == vlc_http_error)
+            break;
+
+        vlc_mutex_lock(&r->lock);
+        if (c->cancelled)
+        {
+            vlc_mutex_unlock(&r->lock);
+            block_Release(block);
+            break;
+        }
+        vlc_http_chunk_append(c, block);
+        vlc_cond_signal(&r->wait_data);
+        vlc_mutex_unlock(&r->lock);
+    }
+    vlc_http_msg_destroy(resp);
+
+    if (c->received == c->length && requested == c->length)
+        vlc_http_ranged_adapt(r, c->length, vlc_tick_now() - start);
+}
+
+static void *vlc_http_ranged_thread(void *data)
+{
+    struct vlc_http_worker *w = data;
+    struct vlc_http_ranged *r = w->ranged;
+
+    vlc_interrupt_set(w->interrupt);
+
+    vlc_mutex_lock(&r->lock);
+    while (!r->dead)
+    {
+        struct vlc_http_chunk *c = vlc_http_ranged_pick(r);
+        if (c == NULL)
+        {
+            vlc_cond_wait(&r->wait_work, &r->lock);
+            continue;
+        }
+
+        c->worker = w;
+        vlc_mutex_unlock(&r->lock);
+
+        vlc_http_ranged_fetch(w, c);
+
+        vlc_mutex_lock(&r->lock);
+        c->worker = NULL;
+
+        if (c->cancelled)
+            vlc_http_chunk_destroy(c);
+        else if (c->received < c->length && !r->dead
+              && ++c->retries >= RANGED_RETRIES)
+        {
+            vlc_http_err(r->logger, "chunk %ju-%ju failed", c->offset,
+                         c->offset + c->length - 1);
+            c->failed = true;
+            vlc_cond_signal(&r->wait_data);
+        }
+    }
+    vlc_mutex_unlock(&r->lock);
+    return NULL;
+}
+
+static void vlc_http_ranged_wake_up(void *data)
+{
+    struct vlc_http_ranged *r = data;
+
+    vlc_mutex_lock(&r->lock);
+    r->interrupted = true;
+    vlc_cond_signal(&r->wait_data);
+    vlc_mutex_unlock(&r->lock);
+}
+
+block_t *vlc_http_ranged_read(struct vlc_http_ranged *r)
+{
+    block_t *block = NULL;
+
+    r->interrupted = false;
+    vlc_interrupt_register(vlc_http_ranged_wake_up, r);
+    vlc_mutex_lock(&r->lock);
+
+    while (r->offset < r->size && !r->interrupted)
+    {
+        struct vlc_http_chunk *c = r->chunks;
+
+        if (c != NULL && c->head != NULL)
+        {
+            block = c->head;
+            c->head = block->p_next;
+            if (c->head == NULL)
+                c->tailp = &c->head;
+            block->p_next = NULL;
+
+            c->consumed += block->i_buffer;
+            r->offset += block->i_buffer;
+
+            if (c->consumed == c->length)
+            {
+                vlc_http_ranged_drop(r);
+                vlc_cond_signal(&r->wait_work);
+            }
+            break;
+        }
+
+        if (c != NULL && c->failed)
+        {
+            block = vlc_http_error;
+            break;
+        }
+
+        vlc_cond_wait(&r->wait_data, &r->lock);
+    }
+
+    vlc_mutex_unlock(&r->lock);
+    vlc_interrupt_unregister();
+    return block;
+}
+
+uintmax_t vlc_http_ranged_tell(struct vlc_http_ranged *r)
+{
+    vlc_mutex_lock(&r->lock);
+    uintmax_t offset = r->offset;
+    vlc_mutex_unlock(&r->lock);
+    return offset;
+}
+
+int vlc_http_ranged_seek(struct vlc_http_ranged *r, uintmax_t offset)
+{
+    struct vlc_http_chunk *c;
+
+    vlc_mutex_lock(&r->lock);
+
+    /* Drop the chunks before the new offset */
+    while ((c = r->chunks) != NULL && c->offset + c->length <= offset)
+        vlc_http_ranged_drop(r);
+
+    if (c != NULL && offset >= c->offset + c->consumed)
+    {   /* Forward within the fetched range: keep the chunks */
+        vlc_http_chunk_skip(c, offset - c->offset);
+
+        for (; c != NULL; c = c->next)
+        {
+            c->retries = 0;
+            c->failed = false;
+        }
+    }
+    else
+    {   /* Backward or out of the fetched range: start over */
+        while (r->chunks != NULL)
+            vlc_http_ranged_drop(r);
+        r->next = offset;
+    }
+
+    r->offset = offset;
+    vlc_cond_broadcast(&r->wait_work);
+    vlc_mutex_unlock(&r->lock);
+    return 0;
+}
+
+static void vlc_http_ranged_kill(struct vlc_http_ranged *r)
+{
+    vlc_mutex_lock(&r->lock);
+    r->dead = true;
+    vlc_cond_broadcast(&r->wait_work);
+    vlc_mutex_unlock(&r->lock);
+
+    for (unsigned i = 0; i < r->workers_count; i++)
+        vlc_interrupt_raise(r->workers[i].interrupt);
+    for (unsigned i = 0; i < r->workers_count; i++)
+        vlc_join(r->workers[i].thread, NULL);
+}
+
+static void vlc_http_worker_clean(struct vlc_http_worker *w)
+{
+    if (w->interrupt != NULL)
+        vlc_interrupt_destroy(w->interrupt);
+    if (w->resource != NULL)
+        vlc_http_res_destroy(w->resource);
+    if (w->manager != NULL)
+        vlc_http_mgr_destroy(w->manager);
+}
+
+void vlc_http_ranged_destroy(struct vlc_http_ranged *r)
+{
+    vlc_http_ranged_kill(r);
+
+    while (r->chunks != NULL)
+        vlc_http_ranged_drop(r);
+    for (unsigned i = 0; i < r->workers_count; i++)
+        vlc_http_worker_clean(&r->workers[i]);
+
+    free(r->etag);
+    free(r);
+}
+
+struct vlc_http_ranged *vlc_http_ranged_create(vlc_object_t *obj,
+                                               struct vlc_http_resource *file,
+                                               struct vlc_http_cookie_jar_t *jar,
+                                               unsigned connections)
+{
+    assert(connections >= 2);
+
+    if (!vlc_http_file_can_seek(file))
+        return NULL;
+
+    uintmax_t size = vlc_http_file_get_size(file);
+    if (size == (uintmax_t)-1 || size <= RANGED_CHUNK_MIN)
+        return NULL; /* unknown size, or too small to be worth it */
+
+    struct vlc_http_ranged *r = malloc(sizeof (*r)
+                                       + connections * sizeof (r->workers[0]));
+    if (unlikely(r == NULL))
+        return NULL;
+
+    r->logger = obj->logger;
+    r->size = size;
+    r->etag = NULL;
+    r->etag_weak = false;
+    r->mtime = vlc_http_msg_get_mtime(file->response);
+
+    const char *etag = vlc_http_msg_get_header(file->response, "ETag");
+    if (etag != NULL)
+    {
+        r->etag = strdup(etag);
+        if (unlikely(r->etag == NULL))
+        {
+            free(r);
+            return NULL;
+        }
+        r->etag_weak = !strncmp(etag, "W/", 2);
+    }
+
+    vlc_mutex_init(&r->lock);
+    vlc_cond_init(&r->wait_data);
+    vlc_cond_init(&r->wait_work);
+    r->chunks = NULL;
+    r->tailp = &r->chunks;
+    r->chunks_count = 0;
+    r->chunks_max = 2 * connections;
+    r->offset = 0;
+    r->next = 0;
+    r->chunk_size = RANGED_CHUNK_MIN;
+    r->interrupted = false;
+    r->dead = false;
+    r->workers_count = 0;
+
+    for (unsigned i = 0; i < connections; i++)
+    {
+        struct vlc_http_worker *w = &r->workers[i];
+
+        w->ranged = r;
+        w->manager = vlc_http_mgr_create_private(obj, jar);
+        w->resource = NULL;
+        w->interrupt = NULL;
+
+        if (w->manager != NULL)
+            w->resource = vlc_http_range_res_create(r, w->manager, file);
+        if (w->resource != NULL)
+            w->interrupt = vlc_interrupt_create();
+
+        if (w->interrupt == NULL
+         || vlc_clone(&w->thread, vlc_http_ranged_thread, w,
+                      VLC_THREAD_PRIORITY_INPUT))
+        {
+            vlc_http_worker_clean(w);
+            vlc_http_ranged_destroy(r);
+            return NULL;
+        }
+        r->workers_count++;
+    }
+
+    /* The chunks are fetched over the connections of the workers from now on */
+    vlc_http_msg_close(file->response);
+
+    vlc_http_dbg(r->logger, "fetching %ju bytes over %u connections", size,
+                 connections);
+    return r;
+}
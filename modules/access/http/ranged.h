@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * ranged.h: HTTP read-only file over parallel range requests
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <stdint.h>
+
+/**
+ * \defgroup http_ranged Parallel ranged files
+ * HTTP read-only files fetched over several connections
+ * \ingroup http_res
+ *
+ * Servers and object stores often throttle each connection. A ranged reader
+ * works around this by fetching consecutive chunks of a file with concurrent
+ * byte range requests, each over its own connection, and by reassembling the
+ * chunks in order.
+ * @{
+ */
+
+struct vlc_http_ranged;
+struct vlc_http_resource;
+struct vlc_http_cookie_jar_t;
+struct block_t;
+
+/**
+ * Creates a ranged reader.
+ *
+ * The reader fetches the same entity as an HTTP file that was already opened
+ * successfully. The file must support seeking and have a known size, larger
+ * than a single chunk.
+ * The chunk requests are conditional on the validators of the file response
+ * (strong ETag, else modification time, else weak ETag), so that a changed
+ * entity fails cleanly. The payload of the file response is closed: once the
+ * reader fails, the file must be seeked before it is read again.
+ *
+ * @param obj parent VLC object
+ * @param file opened HTTP file (see vlc_http_file_create())
+ * @param jar HTTP cookies jar (NULL to disable cookies)
+ * @param connections number of concurrent connections (at least 2)
+ *
+ * @return a ranged reader, or NULL on error
+ */
+struct vlc_http_ranged *vlc_http_ranged_create(vlc_object_t *obj,
+                                               struct vlc_http_resource *file,
+                                               struct vlc_http_cookie_jar_t *jar,
+                                               unsigned connections);
+
+/**
+ * Destroys a ranged reader.
+ *
+ * Cancels all pending requests and closes all connections.
+ */
+void vlc_http_ranged_destroy(struct vlc_http_ranged *);
+
+/**
+ * Gets the read offset.
+ *
+ * @return byte offset of the next read
+ */
+uintmax_t vlc_http_ranged_tell(struct vlc_http_ranged *);
+
+/**
+ * Sets the read offset.
+ *
+ * Cancels the requests of chunks before or beyond the new offset.
+ *
+ * @param offset byte offset of next read
+ * @retval 0 if seek succeeded
+ * @retval -1 if seek failed
+ */
+int vlc_http_ranged_seek(struct vlc_http_ranged *, uintmax_t offset);
+
+/**
+ * Reads data.
+ *
+ * Waits for data at the current offset, and updates the offset.
+ *
+ * @return a data block, NULL on end of file or if interrupted
+ * @retval vlc_http_error if a chunk could not be fetched
+ */
+struct block_t *vlc_http_ranged_read(struct vlc_http_ranged *);
+
+/** @} */
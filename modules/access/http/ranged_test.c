@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * ranged_test.c: HTTP parallel ranged file test
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
+#undef NDEBUG
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include "conn.h"
+#include "resource.h"
+#include "file.h"
+#include "ranged.h"
+#include "message.h"
+
+const char vlc_module_name[] = "test_http_ranged";
+
+static const char url[] = "https://www.example.com:8443/dir/file.ext";
+static const uintmax_t file_size = 3000000;
+static atomic_uint requests = ATOMIC_VAR_INIT(0);
+static atomic_bool changed = ATOMIC_VAR_INIT(false);
+
+static unsigned char file_byte(uintmax_t offset)
+{
+    return offset % 251;
+}
+
+static void test_read(struct vlc_http_ranged *r, uintmax_t offset,
+                      uintmax_t length)
+{
+    while (length > 0)
+    {
+        block_t *block = vlc_http_ranged_read(r);
+        assert(block != NULL && block->i_buffer > 0);
+        assert(offset + block->i_buffer <= file_size);
+
+        size_t size = __MIN(block->i_buffer, length);
+        for (size_t i = 0; i < size; i++)
+            assert(block->p_buffer[i] == file_byte(offset + i));
+
+        offset += size;
+        length -= size;
+        block_Release(block);
+    }
+}
+
+int main(void)
+{
+    vlc_object_t obj = { .logger = NULL };
+    struct vlc_http_resource *f;
+    struct vlc_http_ranged *r;
+
+    f = vlc_http_file_create(NULL, url, NULL, NULL);
+    assert(f != NULL);
+    assert(vlc_http_file_get_status(f) == 206);
+    assert(vlc_http_file_get_size(f) == file_size);
+
+    /* Sequential read */
+    r = vlc_http_ranged_create(&obj, f, NULL, 4);
+    assert(r != NULL);
+    assert(vlc_http_file_read(f) == NULL); /* initial response closed */
+    test_read(r, 0, file_size);
+    assert(vlc_http_ranged_read(r) == NULL);
+    assert(atomic_load(&requests) >= 2);
+
+    /* Backward seek */
+    assert(vlc_http_ranged_seek(r, 12345) == 0);
+    test_read(r, 12345, 100000);
+
+    /* Forward seek within and beyond the fetched range */
+    assert(vlc_http_ranged_seek(r, 150000) == 0);
+    test_read(r, 150000, 1000);
+    assert(vlc_http_ranged_seek(r, 2500000) == 0);
+    test_read(r, 2500000, file_size - 2500000);
+    assert(vlc_http_ranged_read(r) == NULL);
+
+    /* Seek beyond the end */
+    assert(vlc_http_ranged_seek(r, file_size + 1) == 0);
+    assert(vlc_http_ranged_read(r) == NULL);
+
+    /* Destroy with pending requests */
+    assert(vlc_http_ranged_seek(r, 0) == 0);
+    test_read(r, 0, 1);
+    vlc_http_ranged_destroy(r);
+
+    /* Changed entity: the chunks fail, and the file takes over */
+    r = vlc_http_ranged_create(&obj, f, NULL, 4);
+    assert(r != NULL);
+    atomic_store(&changed, true);
+    assert(vlc_http_ranged_read(r) == vlc_http_error);
+    assert(vlc_http_ranged_tell(r) == 0);
+    vlc_http_ranged_destroy(r);
+    atomic_store(&changed, false);
+
+    assert(vlc_http_file_seek(f, 0) == 0);
+    block_t *block = vlc_http_file_read(f);
+    assert(block != NULL && block->i_buffer > 0);
+    assert(block->p_buffer[0] == file_byte(0));
+    block_Release(block);
+
+    vlc_http_file_destroy(f);
+    return 0;
+}
+
+/* Callback for vlc_http_msg_h2_frame */
+#include "h2frame.h"
+
+struct vlc_h2_frame *
+vlc_h2_frame_headers(uint_fast32_t id, uint_fast32_t mtu, bool eos,
+                     unsigned count, const char *const tab[][2])
+{
+    (void) id; (void) mtu; (void) count, (void) tab;
+    assert(!eos);
+    return NULL;
+}
+
+void vlc_http_err(void *ctx, const char *fmt, ...)
+{
+    (void) ctx; (void) fmt;
+}
+
+void vlc_http_dbg(void *ctx, const char *fmt, ...)
+{
+    (void) ctx; (void) fmt;
+}
+
+/* Callback for the HTTP request */
+#include "connmgr.h"
+
+struct test_stream
+{
+    struct vlc_http_stream stream;
+    uintmax_t offset;
+    uintmax_t end; /* inclusive */
+    bool replied;
+    bool failed;
+};
+
+static struct vlc_http_msg *stream_read_headers(struct vlc_http_stream *s)
+{
+    struct test_stream *ts = container_of(s, struct test_stream, stream);
+    char *answer;
+
+    assert(!ts->replied);
+    ts->replied = true;
+
+    if (ts->failed)
+        answer = strdup("HTTP/1.1 412 Precondition Failed\r\n\r\n");
+    else if (asprintf(&answer, "HTTP/1.1 206 Partial Content\r\n"
+                      "Content-Range: bytes %ju-%ju/%ju\r\n"
+                      "ETag: \"foobar42\"\r\n\r\n",
+                      ts->offset, ts->end, file_size) < 0)
+        answer = NULL;
+    if (answer == NULL)
+        abort();
+
+    struct vlc_http_msg *m = vlc_http_msg_headers(answer);
+    assert(m != NULL);
+    free(answer);
+    vlc_http_msg_attach(m, s);
+    return m;
+}
+
+static struct block_t *stream_read(struct vlc_http_stream *s)
+{
+    struct test_stream *ts = container_of(s, struct test_stream, stream);
+
+    if (ts->offset > ts->end)
+        return NULL;
+
+    size_t size = __MIN(7919, ts->end + 1 - ts->offset);
+    block_t *block = block_Alloc(size);
+    assert(block != NULL);
+
+    for (size_t i = 0; i < size; i++)
+        block->p_buffer[i] = file_byte(ts->offset + i);
+    ts->offset += size;
+    return block;
+}
+
+static void stream_close(struct vlc_http_stream *s, bool abort)
+{
+    free(container_of(s, struct test_stream, stream));
+    (void) abort;
+}
+
+static const struct vlc_http_stream_cbs stream_callbacks =
+{
+    stream_read_headers,
+    stream_read,
+    stream_close,
+};
+
+static char manager;
+
+struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
+                                          const char *host, unsigned port,
+                                          const struct vlc_http_msg *req)
+{
+    struct test_stream *ts = malloc(sizeof (*ts));
+    const char *str;
+    uintmax_t start, end = file_size - 1;
+
+    assert(ts != NULL);
+    assert(https);
+    assert(!strcmp(host, "www.example.com"));
+    assert(port == 8443);
+
+    str = vlc_http_msg_get_path(req);
+    assert(!strcmp(str, "/dir/file.ext"));
+    str = vlc_http_msg_get_header(req, "Range");
+    assert(str != NULL);
+
+    if (mgr != NULL)
+    {   /* Chunk request */
+        assert(mgr == (void *)&manager);
+        assert(sscanf(str, "bytes=%ju-%ju", &start, &end) == 2);
+        assert(start <= end && end < file_size);
+        str = vlc_http_msg_get_header(req, "If-Match");
+        assert(str != NULL && !strcmp(str, "\"foobar42\""));
+        atomic_fetch_add(&requests, 1);
+    }
+    else
+        assert(sscanf(str, "bytes=%ju-", &start) == 1 && start == 0);
+
+    ts->stream.cbs = &stream_callbacks;
+    ts->offset = start;
+    ts->end = end;
+    ts->replied = false;
+    /* A changed entity fails the preconditions of the chunk requests */
+    ts->failed = mgr != NULL && atomic_load(&changed);
+    return vlc_http_msg_get_initial(&ts->stream);
+}
+
+struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
+{
+    (void) mgr;
+    return NULL;
+}
+
+struct vlc_http_mgr *vlc_http_mgr_create_private(vlc_object_t *obj,
+                                                 struct vlc_http_cookie_jar_t *jar)
+{
+    (void) obj;
+    assert(jar == NULL);
+    return (void *)&manager;
+}
+
+void vlc_http_mgr_destroy(struct vlc_http_mgr *mgr)
+{
+    assert(mgr == (void *)&manager);
+}
@@ -49,6 +49,9 @@
 #define AUTO_GUID_TEXT N_("Set NFS uid/guid automatically")
 #define AUTO_GUID_LONGTEXT N_("If uid/gid are not specified in " \
     "the url, VLC will automatically set a uid/gid.")
+#define READ_AHEAD_TEXT N_("Read-ahead requests")
+#define READ_AHEAD_LONGTEXT N_("Number of concurrent read requests. " \
+    "More requests hide the network latency, at the cost of memory.")
 
 static int Open(vlc_object_t *);
 static void Close(vlc_object_t *);
@@ -59,11 +62,28 @@ vlc_module_begin()
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_ACCESS)
     add_bool("nfs-auto-guid", true, AUTO_GUID_TEXT, AUTO_GUID_LONGTEXT, true)
+    add_integer_with_range("nfs-read-ahead", 8, 1, 32, READ_AHEAD_TEXT,
+                           READ_AHEAD_LONGTEXT, true)
     set_capability("access", 0)
     add_shortcut("nfs")
     set_callbacks(Open, Close)
 vlc_module_end()
 
+#define NFS_READ_SIZE 262144
+
+typedef struct
+{
+    stream_t *              p_access;
+    uint8_t *               p_buf;
+    uint64_t                i_offset;
+    size_t                  i_len; /* requested bytes */
+    size_t                  i_size; /* received bytes */
+    size_t                  i_pos; /* consumed bytes */
+    bool                    b_pending;
+    bool                    b_queued;
+    bool                    b_discard; /* result is not wanted anymore */
+} nfs_read_req;
+
 typedef struct
 {
     struct rpc_context *    p_mount; /* used to to get exports mount point */
@@ -79,21 +99,20 @@ typedef struct
     bool                    b_error;
     bool                    b_auto_guid;
 
+    nfs_read_req *          p_reads;
+    nfs_read_req **         pp_read_queue; /* requests in file order */
+    unsigned                i_read_ahead;
+    unsigned                i_read_head;
+    unsigned                i_read_count;
+    uint64_t                i_read_offset; /* offset of the next request */
+    bool                    b_read_done;
+
     union {
         struct
         {
             char **         ppsz_names;
             int             i_count;
         } exports;
-        struct
-        {
-            uint8_t *p_buf;
-            size_t i_len;
-        } read;
-        struct
-        {
-            bool b_done;
-        } seek;
     } res;
 } access_sys_t;
 
@@ -174,75 +193,177 @@ vlc_mount_mainloop(stream_t *p_access, bool (*pf_until_cb)(stream_t *))
 }
 
 static void
-nfs_read_cb(int i_status, struct nfs_context *p_nfs, void *p_data,
-            void *p_private_data)
+nfs_pread_cb(int i_status, struct nfs_context *p_nfs, void *p_data,
+             void *p_private_data)
 {
     VLC_UNUSED(p_nfs);
-    stream_t *p_access = p_private_data;
+    nfs_read_req *p_req = p_private_data;
+    stream_t *p_access = p_req->p_access;
     access_sys_t *p_sys = p_access->p_sys;
     assert(p_sys->p_nfs == p_nfs);
+    assert(p_req->b_pending);
+
+    p_req->b_pending = false;
+    p_sys->b_read_done = true;
+
+    if (p_req->b_discard)
+    {   /* Cancelled by a seek: ignore the result */
+        p_req->b_discard = false;
+        return;
+    }
+
     if (NFS_CHECK_STATUS(p_access, i_status, p_data))
         return;
 
-    if (i_status == 0)
-        p_sys->b_eof = true;
-    else
-    {
-        p_sys->res.read.i_len = i_status;
-        memcpy(p_sys->res.read.p_buf, p_data, i_status);
-    }
+    assert((size_t)i_status <= p_req->i_len);
+    p_req->i_size = i_status;
+    memcpy(p_req->p_buf, p_data, i_status);
 }
 
 static bool
-nfs_read_finished_cb(stream_t *p_access)
+nfs_pread_finished_cb(stream_t *p_access)
 {
     access_sys_t *p_sys = p_access->p_sys;
-    return p_sys->res.read.i_len > 0 || p_sys->b_eof;
+    return p_sys->b_read_done;
 }
 
-static ssize_t
-FileRead(stream_t *p_access, void *p_buf, size_t i_len)
+static int
+vlc_nfs_read_wait(stream_t *p_access)
 {
     access_sys_t *p_sys = p_access->p_sys;
 
-    if (p_sys->b_eof)
-        return 0;
+    p_sys->b_read_done = false;
+    return vlc_nfs_mainloop(p_access, nfs_pread_finished_cb);
+}
 
-    p_sys->res.read.i_len = 0;
-    p_sys->res.read.p_buf = p_buf;
-    if (nfs_read_async(p_sys->p_nfs, p_sys->p_nfsfh, i_len, nfs_read_cb,
-                       p_access) < 0)
-    {
-        msg_Err(p_access, "nfs_read_async failed");
-        return -1;
-    }
+static nfs_read_req *
+vlc_nfs_read_queue_head(access_sys_t *p_sys)
+{
+    assert(p_sys->i_read_count > 0);
+    return p_sys->pp_read_queue[p_sys->i_read_head];
+}
 
-    if (vlc_nfs_mainloop(p_access, nfs_read_finished_cb) < 0)
-        return -1;
+static void
+vlc_nfs_read_pop(access_sys_t *p_sys)
+{
+    nfs_read_req *p_req = vlc_nfs_read_queue_head(p_sys);
 
-    return p_sys->res.read.i_len;
+    p_req->b_queued = false;
+    p_req->b_discard = p_req->b_pending;
+    p_sys->i_read_head = (p_sys->i_read_head + 1) % p_sys->i_read_ahead;
+    p_sys->i_read_count--;
 }
 
+/* Cancels all queued read requests */
 static void
-nfs_seek_cb(int i_status, struct nfs_context *p_nfs, void *p_data,
-            void *p_private_data)
+vlc_nfs_read_flush(access_sys_t *p_sys, uint64_t i_offset)
+{
+    while (p_sys->i_read_count > 0)
+        vlc_nfs_read_pop(p_sys);
+    p_sys->i_read_offset = i_offset;
+}
+
+/* Queues read requests ahead of the current position */
+static int
+vlc_nfs_read_ahead(stream_t *p_access)
 {
-    VLC_UNUSED(p_nfs);
-    stream_t *p_access = p_private_data;
     access_sys_t *p_sys = p_access->p_sys;
-    assert(p_sys->p_nfs == p_nfs);
-    (void) p_data;
-    if (NFS_CHECK_STATUS(p_access, i_status, p_data))
-        return;
 
-    p_sys->res.seek.b_done = true;
+    for (unsigned i = 0; i < p_sys->i_read_ahead; i++)
+    {
+        nfs_read_req *p_req = &p_sys->p_reads[i];
+
+        if (p_req->b_queued || p_req->b_pending)
+            continue;
+        /* Do not read ahead past the end, but keep one request to detect
+         * the actual end of file */
+        if (p_sys->i_read_count > 0
+         && p_sys->i_read_offset >= p_sys->stat.nfs_size)
+            break;
+
+        p_req->i_offset = p_sys->i_read_offset;
+        p_req->i_len = NFS_READ_SIZE;
+        p_req->i_size = 0;
+        p_req->i_pos = 0;
+
+        if (nfs_pread_async(p_sys->p_nfs, p_sys->p_nfsfh, p_req->i_offset,
+                            p_req->i_len, nfs_pread_cb, p_req) < 0)
+        {
+            msg_Err(p_access, "nfs_pread_async failed");
+            return -1;
+        }
+
+        p_req->b_pending = true;
+        p_req->b_queued = true;
+        p_sys->pp_read_queue[(p_sys->i_read_head + p_sys->i_read_count)
+                             % p_sys->i_read_ahead] = p_req;
+        p_sys->i_read_count++;
+        p_sys->i_read_offset += p_req->i_len;
+    }
+    return 0;
 }
 
-static bool
-nfs_seek_finished_cb(stream_t *p_access)
+static ssize_t
+FileRead(stream_t *p_access, void *p_buf, size_t i_len)
 {
     access_sys_t *p_sys = p_access->p_sys;
-    return p_sys->res.seek.b_done;
+
+    for (;;)
+    {
+        if (p_sys->b_error)
+            return -1;
+
+        if (p_sys->b_eof)
+            return 0;
+
+        if (vlc_nfs_read_ahead(p_access) < 0)
+            return -1;
+
+        if (p_sys->i_read_count == 0)
+        {   /* All requests were cancelled and are still pending */
+            if (vlc_nfs_read_wait(p_access) < 0)
+                return -1;
+            continue;
+        }
+
+        nfs_read_req *p_req = vlc_nfs_read_queue_head(p_sys);
+
+        while (p_req->b_pending)
+            if (vlc_nfs_read_wait(p_access) < 0)
+                return -1;
+
+        if (p_sys->b_error)
+            return -1;
+
+        if (p_req->i_pos < p_req->i_size)
+        {
+            if (i_len > p_req->i_size - p_req->i_pos)
+                i_len = p_req->i_size - p_req->i_pos;
+
+            memcpy(p_buf, p_req->p_buf + p_req->i_pos, i_len);
+            p_req->i_pos += i_len;
+
+            if (p_req->i_pos == p_req->i_len)
+                vlc_nfs_read_pop(p_sys);
+            return i_len;
+        }
+
+        if (p_req->i_size == 0)
+        {   /* End of file */
+            p_sys->b_eof = true;
+            vlc_nfs_read_flush(p_sys, p_req->i_offset);
+            return 0;
+        }
+
+        if (p_req->i_size == p_req->i_len)
+        {   /* Fully consumed (skipped by a seek) */
+            vlc_nfs_read_pop(p_sys);
+            continue;
+        }
+
+        /* Short read: restart the read-ahead after the received data */
+        vlc_nfs_read_flush(p_sys, p_req->i_offset + p_req->i_pos);
+    }
 }
 
 static int
@@ -250,17 +371,29 @@ FileSeek(stream_t *p_access, uint64_t i_pos)
 {
     access_sys_t *p_sys = p_access->p_sys;
 
-    p_sys->res.seek.b_done = false;
-    if (nfs_lseek_async(p_sys->p_nfs, p_sys->p_nfsfh, i_pos, SEEK_SET,
-                        nfs_seek_cb, p_access) < 0)
+    /* Keep the queued requests after the new position, if any */
+    while (p_sys->i_read_count > 0)
     {
-        msg_Err(p_access, "nfs_seek_async failed");
-        return VLC_EGENERIC;
-    }
+        nfs_read_req *p_req = vlc_nfs_read_queue_head(p_sys);
+
+        if (i_pos < p_req->i_offset + p_req->i_pos)
+        {   /* Backward seek */
+            vlc_nfs_read_flush(p_sys, i_pos);
+            break;
+        }
 
-    if (vlc_nfs_mainloop(p_access, nfs_seek_finished_cb) < 0)
-        return VLC_EGENERIC;
+        if (i_pos < p_req->i_offset + p_req->i_len)
+        {
+            p_req->i_pos = i_pos - p_req->i_offset;
+            if (!p_req->b_pending && p_req->i_pos > p_req->i_size)
+                vlc_nfs_read_flush(p_sys, i_pos);
+            break;
+        }
+        vlc_nfs_read_pop(p_sys);
+    }
 
+    if (p_sys->i_read_count == 0)
+        p_sys->i_read_offset = i_pos;
     p_sys->b_eof = false;
 
     return VLC_SUCCESS;
@@ -692,6 +825,25 @@ Open(vlc_object_t *p_obj)
 
         if (p_sys->p_nfsfh != NULL)
         {
+            unsigned i_count = var_InheritInteger(p_access, "nfs-read-ahead");
+
+            p_sys->p_reads = vlc_obj_calloc(p_obj, i_count,
+                                            sizeof (*p_sys->p_reads));
+            p_sys->pp_read_queue = vlc_obj_calloc(p_obj, i_count,
+                                            sizeof (*p_sys->pp_read_queue));
+            if (unlikely(p_sys->p_reads == NULL
+                      || p_sys->pp_read_queue == NULL))
+                goto error;
+
+            for (unsigned i = 0; i < i_count; i++)
+            {
+                p_sys->p_reads[i].p_access = p_access;
+                p_sys->p_reads[i].p_buf = vlc_obj_malloc(p_obj, NFS_READ_SIZE);
+                if (unlikely(p_sys->p_reads[i].p_buf == NULL))
+                    goto error;
+            }
+            p_sys->i_read_ahead = i_count;
+
             p_access->pf_read = FileRead;
             p_access->pf_seek = FileSeek;
             p_access->pf_control = FileControl;
@@ -749,6 +901,9 @@ Close(vlc_object_t *p_obj)
     stream_t *p_access = (stream_t *)p_obj;
     access_sys_t *p_sys = p_access->p_sys;
 
+    /* Ignore the results of pending read requests */
+    vlc_nfs_read_flush(p_sys, 0);
+
     if (p_sys->p_nfsfh != NULL)
         nfs_close(p_sys->p_nfs, p_sys->p_nfsfh);
 
@@ -61,6 +61,10 @@
 #define NACK_INTERVAL 5 /*ms*/
 /* Calculate and print stats once per second */
 #define STATS_INTERVAL 1000 /*ms*/
+/* The max number of bonded paths */
+#define RIST_MAX_PATHS 4
+/* The max number of datagrams read or delivered at once */
+#define RIST_BATCH 16
 
 static const int nack_type[] = {
     0, 1,
@@ -75,9 +79,28 @@ enum NACK_TYPE {
     NACK_FMT_BITMASK
 };
 
+/* A network path which the stream is received from */
+struct rist_path
+{
+    int              fd_in;
+    int              fd_nack;
+    int              fd_rtcp_m;
+    bool             b_ismulticast;
+    struct sockaddr_storage peer_sockaddr;
+    socklen_t        peer_socklen;
+    /* stat variables */
+    uint32_t         i_packets;
+    uint32_t         i_first_packets;
+    uint32_t         i_duplicate_packets;
+};
+
 typedef struct
 {
     struct rist_flow *flow;
+    struct rist_path paths[RIST_MAX_PATHS];
+    unsigned         i_paths;
+    block_t         *pending;
+    uint8_t         *rx_buf;
     char             sender_name[MAX_CNAME];
     enum NACK_TYPE   nack_type;
     uint64_t         last_data_rx;
@@ -86,7 +109,6 @@ typedef struct
     int              i_max_packet_size;
     int              i_poll_timeout;
     int              i_poll_timeout_current;
-    bool             b_ismulticast;
     bool             b_sendnacks;
     bool             b_sendblindnacks;
     bool             b_disablenacks;
@@ -107,6 +129,7 @@ typedef struct
     uint32_t         i_recovered_packets;
     uint32_t         i_reordered_packets;
     uint32_t         i_total_packets;
+    uint32_t         i_late_packets;
 } stream_sys_t;
 
 static int Control(stream_t *p_access, int i_query, va_list args)
@@ -161,63 +184,77 @@ static void rist_WriteTo_i11e_Locked(vlc_mutex_t lock, int fd, const void *buf,
     vlc_mutex_unlock( &lock );
 }
 
-static struct rist_flow *rist_udp_receiver(stream_t *p_access, vlc_url_t *parsed_url, bool b_ismulticast)
+static void rist_path_close(struct rist_path *path)
+{
+    if (path->fd_in >= 0)
+        net_Close(path->fd_in);
+    if (path->fd_nack >= 0)
+        net_Close(path->fd_nack);
+    if (path->fd_rtcp_m >= 0)
+        net_Close(path->fd_rtcp_m);
+}
+
+static int rist_path_open(stream_t *p_access, struct rist_path *path,
+                          const vlc_url_t *parsed_url)
 {
-    stream_sys_t *p_sys = p_access->p_sys;
     msg_Info( p_access, "Opening Rist Flow Receiver at %s:%d and %s:%d",
              parsed_url->psz_host, parsed_url->i_port,
              parsed_url->psz_host, parsed_url->i_port+1);
 
-    p_sys->flow = rist_init_rx();
-    if (!p_sys->flow)
-        return NULL;
+    memset(path, 0, sizeof (*path));
+    path->fd_nack = -1;
+    path->fd_rtcp_m = -1;
+    path->b_ismulticast = is_multicast_address(parsed_url->psz_host);
 
-    p_sys->flow->fd_in = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port, NULL,
+    path->fd_in = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port, NULL,
                 0, IPPROTO_UDP);
-    if (p_sys->flow->fd_in < 0)
+    if (path->fd_in < 0)
     {
         msg_Err( p_access, "cannot open input socket" );
         goto fail;
     }
 
-    if (b_ismulticast)
+    if (path->b_ismulticast)
     {
-        p_sys->flow->fd_rtcp_m = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port + 1,
+        path->fd_rtcp_m = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port + 1,
             NULL, 0, IPPROTO_UDP);
-        if (p_sys->flow->fd_rtcp_m < 0)
+        if (path->fd_rtcp_m < 0)
         {
             msg_Err( p_access, "cannot open multicast nack socket" );
             goto fail;
         }
-        p_sys->flow->fd_nack = net_ConnectDgram(p_access, parsed_url->psz_host,
+        path->fd_nack = net_ConnectDgram(p_access, parsed_url->psz_host,
             parsed_url->i_port + 1, -1, IPPROTO_UDP );
     }
     else
     {
-        p_sys->flow->fd_nack = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port + 1,
+        path->fd_nack = net_OpenDgram(p_access, parsed_url->psz_host, parsed_url->i_port + 1,
             NULL, 0, IPPROTO_UDP);
     }
-    if (p_sys->flow->fd_nack < 0)
+    if (path->fd_nack < 0)
     {
         msg_Err( p_access, "cannot open nack socket" );
         goto fail;
     }
 
-    populate_cname(p_sys->flow->fd_nack, p_sys->flow->cname);
-    msg_Info(p_access, "our cname is %s", p_sys->flow->cname);
-
-    return  p_sys->flow;
+    return 0;
 
 fail:
-    if (p_sys->flow->fd_in != -1)
-        vlc_close(p_sys->flow->fd_in);
-    if (p_sys->flow->fd_nack != -1)
-        vlc_close(p_sys->flow->fd_nack);
-    if (p_sys->flow->fd_rtcp_m != -1)
-        vlc_close(p_sys->flow->fd_rtcp_m);
-    free(p_sys->flow->buffer);
-    free(p_sys->flow);
-    return NULL;
+    rist_path_close(path);
+    return -1;
+}
+
+static int rist_path_open_url(stream_t *p_access, struct rist_path *path, const char *url)
+{
+    vlc_url_t parsed_url;
+    int ret = -1;
+
+    if (vlc_UrlParse(&parsed_url, url) == -1)
+        msg_Err(p_access, "Failed to parse input URL (%s)", url);
+    else
+        ret = rist_path_open(p_access, path, &parsed_url);
+    vlc_UrlClean(&parsed_url);
+    return ret;
 }
 
 static int is_index_in_range(struct rist_flow *flow, uint16_t idx)
@@ -229,7 +266,8 @@ static int is_index_in_range(struct rist_flow *flow, uint16_t idx)
     }
 }
 
-static void send_rtcp_feedback(stream_t *p_access, struct rist_flow *flow)
+static void send_rtcp_feedback(stream_t *p_access, struct rist_flow *flow,
+                               struct rist_path *path)
 {
     stream_sys_t *p_sys = p_access->p_sys;
     int namelen = strlen(flow->cname) + 1;
@@ -262,16 +300,16 @@ static void send_rtcp_feedback(stream_t *p_access, struct rist_flow *flow)
     strlcpy((char *)p_sdes_name, flow->cname, namelen);
 
     /* Write to Socket */
-    rist_WriteTo_i11e_Locked(p_sys->lock, flow->fd_nack, buf, rtcp_feedback_size,
-        (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
+    rist_WriteTo_i11e_Locked(p_sys->lock, path->fd_nack, buf, rtcp_feedback_size,
+        (struct sockaddr *)&path->peer_sockaddr, path->peer_socklen);
     free(buf);
     buf = NULL;
 }
 
-static void send_bbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uint16_t nack_count)
+static void send_bbnack(stream_t *p_access, struct rist_path *path, block_t *pkt_nacks,
+    uint16_t nack_count)
 {
     stream_sys_t *p_sys = p_access->p_sys;
-    struct rist_flow *flow = p_sys->flow;
     int len = 0;
 
     int bbnack_bufsize = RTCP_FB_HEADER_SIZE +
@@ -301,16 +339,16 @@ static void send_bbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uin
 
     /* Write to Socket */
     if (p_sys->b_sendnacks && p_sys->b_disablenacks == false)
-        rist_WriteTo_i11e_Locked(p_sys->lock, fd_nack, buf, len,
-            (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
+        rist_WriteTo_i11e_Locked(p_sys->lock, path->fd_nack, buf, len,
+            (struct sockaddr *)&path->peer_sockaddr, path->peer_socklen);
     free(buf);
     buf = NULL;
 }
 
-static void send_rbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uint16_t nack_count)
+static void send_rbnack(stream_t *p_access, struct rist_path *path, block_t *pkt_nacks,
+    uint16_t nack_count)
 {
     stream_sys_t *p_sys = p_access->p_sys;
-    struct rist_flow *flow = p_sys->flow;
     int len = 0;
 
     int rbnack_bufsize = RTCP_FB_HEADER_SIZE +
@@ -341,8 +379,8 @@ static void send_rbnack(stream_t *p_access, int fd_nack, block_t *pkt_nacks, uin
 
     /* Write to Socket */
     if (p_sys->b_sendnacks && p_sys->b_disablenacks == false)
-        rist_WriteTo_i11e_Locked(p_sys->lock, fd_nack, buf, len,
-            (struct sockaddr *)&flow->peer_sockaddr, flow->peer_socklen);
+        rist_WriteTo_i11e_Locked(p_sys->lock, path->fd_nack, buf, len,
+            (struct sockaddr *)&path->peer_sockaddr, path->peer_socklen);
     free(buf);
     buf = NULL;
 }
@@ -476,8 +514,8 @@ static void print_sockaddr_info(stream_t *p_access, struct sockaddr *x)
     }
 }
 
-static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_in, size_t len,
-    struct sockaddr *peer, socklen_t slen)
+static void rtcp_input(stream_t *p_access, struct rist_flow *flow, struct rist_path *path,
+    uint8_t *buf_in, size_t len, struct sockaddr *peer, socklen_t slen)
 {
     stream_sys_t *p_sys = p_access->p_sys;
     uint8_t  ptype;
@@ -527,7 +565,7 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
                 {
                     if (p_sys->b_sendnacks == false)
                         p_sys->b_sendnacks = true;
-                    if (p_sys->b_ismulticast)
+                    if (path->b_ismulticast)
                         return;
                     /* Check for changes in source IP address or port */
                     int8_t name_length = rtcp_sdes_get_name_length(buf);
@@ -540,17 +578,17 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
                         return;
                     }
                     bool ip_port_changed = false;
-                    if (sockaddr_cmp((struct sockaddr *)&flow->peer_sockaddr, peer) != 0)
+                    if (sockaddr_cmp((struct sockaddr *)&path->peer_sockaddr, peer) != 0)
                     {
                         ip_port_changed = true;
-                        if(flow->peer_socklen > 0)
+                        if(path->peer_socklen > 0)
                             print_sockaddr_info_change(p_access,
-                                (struct sockaddr *)&flow->peer_sockaddr, peer);
+                                (struct sockaddr *)&path->peer_sockaddr, peer);
                         else
                             print_sockaddr_info(p_access, peer);
                         vlc_mutex_lock( &p_sys->lock );
-                        memcpy(&flow->peer_sockaddr, peer, sizeof(struct sockaddr_storage));
-                        flow->peer_socklen = slen;
+                        memcpy(&path->peer_sockaddr, peer, sizeof(struct sockaddr_storage));
+                        path->peer_socklen = slen;
                         vlc_mutex_unlock( &p_sys->lock );
                     }
 
@@ -582,7 +620,7 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
             case RTCP_PT_SR:
                 if (p_sys->b_sendnacks == false)
                     p_sys->b_sendnacks = true;
-                if (p_sys->b_ismulticast)
+                if (path->b_ismulticast)
                         return;
                 break;
 
@@ -593,7 +631,8 @@ static void rtcp_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf_
     }
 }
 
-static bool rist_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf, size_t len)
+static bool rist_input(stream_t *p_access, struct rist_flow *flow, struct rist_path *path,
+    uint8_t *buf, size_t len)
 {
     stream_sys_t *p_sys = p_access->p_sys;
 
@@ -616,6 +655,29 @@ static bool rist_input(stream_t *p_access, struct rist_flow *flow, uint8_t *buf,
     bool retrasnmitted = false;
     bool success = true;
 
+    path->i_packets++;
+    if (p_sys->i_paths > 1 && flow->reset == 0)
+    {
+        /* With bonded paths, every packet is normally received more than once.
+         * Only the first copy is kept, whichever path it came from. */
+        if (is_index_in_range(flow, idx) && flow->buffer[idx].buffer != NULL)
+        {
+            path->i_duplicate_packets++;
+            return false;
+        }
+        /* Copies from a slower path may also arrive after the packet was
+         * delivered or given up on: this is not a discontinuity. */
+        if (!is_index_in_range(flow, idx)
+         && (uint16_t)(flow->ri - idx) < RIST_QUEUE_SIZE / 2
+         && (uint32_t)(flow->hi_timestamp - pkt_ts) <= flow->rtp_latency)
+        {
+            p_sys->i_late_packets++;
+            path->i_duplicate_packets++;
+            return false;
+        }
+    }
+    path->i_first_packets++;
+
     if (flow->reset == 1)
     {
         msg_Info(p_access, "Traffic detected after buffer reset");
@@ -769,9 +831,84 @@ static block_t *rist_dequeue(stream_t *p_access, struct rist_flow *flow)
         p_sys->b_flag_discontinuity = true;
     }
 
+    if (pktout != NULL && p_sys->b_flag_discontinuity)
+    {
+        pktout->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        p_sys->b_flag_discontinuity = false;
+    }
     return pktout;
 }
 
+/* Delivers all the packets that are due at once, up to a discontinuity */
+static block_t *rist_dequeue_all(stream_t *p_access, struct rist_flow *flow)
+{
+    stream_sys_t *p_sys = p_access->p_sys;
+    block_t *chain = p_sys->pending, **pp = &chain;
+    unsigned count = 0;
+
+    p_sys->pending = NULL;
+    if (chain == NULL)
+        chain = rist_dequeue(p_access, flow);
+    while (*pp != NULL)
+    {
+        pp = &(*pp)->p_next;
+        if (++count >= RIST_BATCH)
+            break;
+
+        block_t *pkt = rist_dequeue(p_access, flow);
+        if (pkt != NULL && (pkt->i_flags & BLOCK_FLAG_DISCONTINUITY))
+        {
+            p_sys->pending = pkt;
+            break;
+        }
+        *pp = pkt;
+    }
+
+    return (chain != NULL) ? block_ChainGather(chain) : NULL;
+}
+
+/* Reads the pending datagrams of a path into the receive buffer */
+static int rist_read_batch(stream_t *p_access, struct rist_path *path, size_t *lengths)
+{
+    stream_sys_t *p_sys = p_access->p_sys;
+    uint8_t *buf = p_sys->rx_buf;
+    size_t size = p_sys->i_max_packet_size;
+#ifdef HAVE_RECVMMSG
+    struct mmsghdr msgs[RIST_BATCH];
+    struct iovec iovs[RIST_BATCH];
+
+    for (unsigned i = 0; i < RIST_BATCH; i++)
+    {
+        iovs[i].iov_base = buf + i * size;
+        iovs[i].iov_len = size;
+        memset(&msgs[i].msg_hdr, 0, sizeof (msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    /* The socket is known to be readable: do not wait */
+    int count = recvmmsg(path->fd_in, msgs, RIST_BATCH, MSG_DONTWAIT, NULL);
+    if (count < 0)
+    {
+        if (errno != EAGAIN && errno != EINTR)
+            msg_Err(p_access, "socket %d error: %s", path->fd_in, vlc_strerror_c(errno));
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++)
+        lengths[i] = msgs[i].msg_len;
+    return count;
+#else
+    ssize_t r = rist_Read_i11e(path->fd_in, buf, size);
+    if (unlikely(r == -1)) {
+        msg_Err(p_access, "socket %d error: %s\n", path->fd_in, gai_strerror(errno));
+        return 0;
+    }
+    lengths[0] = r;
+    return 1;
+#endif
+}
+
 static void *rist_thread(void *data)
 {
     stream_t *p_access = data;
@@ -784,13 +921,22 @@ static void *rist_thread(void *data)
                                                   &p_sys->dead)) != NULL) {
         /* there are two bytes per nack */
         uint16_t nack_count = (uint16_t)pkt_nacks->i_buffer/2;
-        switch(p_sys->nack_type) {
-            case NACK_FMT_BITMASK:
-                send_bbnack(p_access, p_sys->flow->fd_nack, pkt_nacks, nack_count);
-                break;
+        /* The retransmission may come through any path: ask all of them */
+        for (unsigned i = 0; i < p_sys->i_paths; i++)
+        {
+            struct rist_path *path = &p_sys->paths[i];
 
-            default:
-                send_rbnack(p_access, p_sys->flow->fd_nack, pkt_nacks, nack_count);
+            if (p_sys->i_paths > 1 && !path->b_ismulticast && path->peer_socklen == 0)
+                continue; /* no sender known on this path yet */
+
+            switch(p_sys->nack_type) {
+                case NACK_FMT_BITMASK:
+                    send_bbnack(p_access, path, pkt_nacks, nack_count);
+                    break;
+
+                default:
+                    send_rbnack(p_access, path, pkt_nacks, nack_count);
+            }
         }
 
         if (nack_count > 1)
@@ -807,7 +953,7 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     uint64_t now;
     *eof = false;
     block_t *pktout = NULL;
-    struct pollfd pfd[3];
+    struct pollfd pfd[3 * RIST_MAX_PATHS];
     int ret;
     ssize_t r;
     struct sockaddr_storage peer;
@@ -820,16 +966,17 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
         return NULL;
     }
 
-    int poll_sockets = 2;
-    pfd[0].fd = flow->fd_in;
-    pfd[0].events = POLLIN;
-    pfd[1].fd = flow->fd_nack;
-    pfd[1].events = POLLIN;
-    if (p_sys->b_ismulticast)
+    int poll_sockets = 0;
+    for (unsigned i = 0; i < p_sys->i_paths; i++)
     {
-        pfd[2].fd = flow->fd_rtcp_m;
-        pfd[2].events = POLLIN;
-        poll_sockets++;
+        struct rist_path *path = &p_sys->paths[i];
+
+        pfd[poll_sockets].fd = path->fd_in;
+        pfd[poll_sockets++].events = POLLIN;
+        pfd[poll_sockets].fd = path->fd_nack;
+        pfd[poll_sockets++].events = POLLIN;
+        pfd[poll_sockets].fd = path->fd_rtcp_m; /* -1 is ignored */
+        pfd[poll_sockets++].events = POLLIN;
     }
 
     /* The protocol uses a fifo buffer with a fixed time delay.
@@ -846,7 +993,7 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     else if (ret == 0)
     {
         /* Poll timeout, check the queue for the next packet that needs to be delivered */
-        pktout = rist_dequeue(p_access, flow);
+        pktout = rist_dequeue_all(p_access, flow);
         /* if there is data, we need to come back faster to finish emptying it */
         if (pktout) {
             p_sys->i_poll_timeout_current = 0;
@@ -858,63 +1005,67 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     }
     else
     {
+        uint8_t *buf = p_sys->rx_buf;
+        bool queued = false;
 
-        uint8_t *buf = malloc(p_sys->i_max_packet_size);
-        if ( unlikely( buf == NULL ) )
-            return NULL;
-
-        /* Process rctp incoming data */
-        if (pfd[1].revents & POLLIN)
+        for (unsigned i = 0; i < p_sys->i_paths; i++)
         {
-            r = rist_ReadFrom_i11e(flow->fd_nack, buf, p_sys->i_max_packet_size,
-                (struct sockaddr *)&peer, &slen);
-            if (unlikely(r == -1)) {
-                msg_Err(p_access, "socket %d error: %s\n", flow->fd_nack, gai_strerror(errno));
-            }
-            else {
-                if (p_sys->b_ismulticast == false)
-                    rtcp_input(p_access, flow, buf, r, (struct sockaddr *)&peer, slen);
+            struct rist_path *path = &p_sys->paths[i];
+            const struct pollfd *ufd = &pfd[3 * i];
+
+            /* Process rctp incoming data */
+            if (ufd[1].revents & POLLIN)
+            {
+                slen = sizeof(struct sockaddr_storage);
+                r = rist_ReadFrom_i11e(path->fd_nack, buf, p_sys->i_max_packet_size,
+                    (struct sockaddr *)&peer, &slen);
+                if (unlikely(r == -1)) {
+                    msg_Err(p_access, "socket %d error: %s\n", path->fd_nack, gai_strerror(errno));
+                }
+                else {
+                    if (path->b_ismulticast == false)
+                        rtcp_input(p_access, flow, path, buf, r, (struct sockaddr *)&peer, slen);
+                }
             }
-        }
-        if (p_sys->b_ismulticast && pfd[2].revents & POLLIN)
-        {
-            r = rist_ReadFrom_i11e(flow->fd_rtcp_m, buf, p_sys->i_max_packet_size,
-                (struct sockaddr *)&peer, &slen);
-            if (unlikely(r == -1)) {
-                msg_Err(p_access, "mcast socket %d error: %s\n",flow->fd_rtcp_m, gai_strerror(errno));
+            if (path->b_ismulticast && ufd[2].revents & POLLIN)
+            {
+                slen = sizeof(struct sockaddr_storage);
+                r = rist_ReadFrom_i11e(path->fd_rtcp_m, buf, p_sys->i_max_packet_size,
+                    (struct sockaddr *)&peer, &slen);
+                if (unlikely(r == -1)) {
+                    msg_Err(p_access, "mcast socket %d error: %s\n",path->fd_rtcp_m, gai_strerror(errno));
+                }
+                else {
+                    rtcp_input(p_access, flow, path, buf, r, (struct sockaddr *)&peer, slen);
+                }
             }
-            else {
-                rtcp_input(p_access, flow, buf, r, (struct sockaddr *)&peer, slen);
+
+            /* Process regular incoming data */
+            if (ufd[0].revents & POLLIN)
+            {
+                size_t lengths[RIST_BATCH];
+                int count = rist_read_batch(p_access, path, lengths);
+
+                /* rist_input will process and queue the pkts */
+                for (int j = 0; j < count; j++)
+                    if (rist_input(p_access, flow, path,
+                                   buf + j * p_sys->i_max_packet_size, lengths[j]))
+                        queued = true;
             }
         }
 
-        /* Process regular incoming data */
-        if (pfd[0].revents & POLLIN)
+        if (queued)
         {
-            r = rist_Read_i11e(flow->fd_in, buf, p_sys->i_max_packet_size);
-            if (unlikely(r == -1)) {
-                msg_Err(p_access, "socket %d error: %s\n", flow->fd_in, gai_strerror(errno));
-            }
-            else
-            {
-                /* rist_input will process and queue the pkt */
-                if (rist_input(p_access, flow, buf, r))
-                {
-                    /* Check the queue for the next packet that needs to be delivered */
-                    pktout = rist_dequeue(p_access, flow);
-                    if (pktout) {
-                        p_sys->i_poll_timeout_current = 0;
-                        p_sys->i_poll_timeout_zero_count++;
-                    } else {
-                        p_sys->i_poll_timeout_current = p_sys->i_poll_timeout;
-                        p_sys->i_poll_timeout_nonzero_count++;
-                    }
-                }
+            /* Check the queue for the next packets that need to be delivered */
+            pktout = rist_dequeue_all(p_access, flow);
+            if (pktout) {
+                p_sys->i_poll_timeout_current = 0;
+                p_sys->i_poll_timeout_zero_count++;
+            } else {
+                p_sys->i_poll_timeout_current = p_sys->i_poll_timeout;
+                p_sys->i_poll_timeout_nonzero_count++;
             }
         }
-
-        free(buf);
-        buf = NULL;
     }
 
     now = vlc_tick_now();
@@ -957,6 +1108,22 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
                 "Score %.2f, Link Quality %.2f%%", p_sys->i_total_packets,
                 p_sys->i_recovered_packets, p_sys->i_nack_packets, p_sys->i_reordered_packets,
                 p_sys->i_lost_packets, ratio, quality);
+        if (p_sys->i_paths > 1)
+        {
+            for (unsigned i = 0; i < p_sys->i_paths; i++)
+            {
+                struct rist_path *path = &p_sys->paths[i];
+
+                msg_Dbg(p_access, "STATS: Path %u: Received %u, First %u, Duplicate %u",
+                    i, path->i_packets, path->i_first_packets, path->i_duplicate_packets);
+                path->i_packets = 0;
+                path->i_first_packets = 0;
+                path->i_duplicate_packets = 0;
+            }
+            if (p_sys->i_late_packets > 0)
+                msg_Dbg(p_access, "STATS: %u late duplicate(s)", p_sys->i_late_packets);
+            p_sys->i_late_packets = 0;
+        }
         p_sys->i_last_stat = now;
         p_sys->vbr_ratio = 0;
         p_sys->vbr_ratio_count = 0;
@@ -973,7 +1140,8 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
     {
         /* msg_Dbg(p_access, "Calling RTCP Feedback %lu<%d ms using timer", interval,
         VLC_TICK_FROM_MS(RTCP_INTERVAL)); */
-        send_rtcp_feedback(p_access, flow);
+        for (unsigned i = 0; i < p_sys->i_paths; i++)
+            send_rtcp_feedback(p_access, flow, &p_sys->paths[i]);
         flow->feedback_time = now;
     }
 
@@ -996,30 +1164,21 @@ static block_t *BlockRIST(stream_t *p_access, bool *restrict eof)
         flow->reset = 1;
     }
 
-    if (pktout)
-    {
-        if (p_sys->b_flag_discontinuity) {
-            pktout->i_flags |= BLOCK_FLAG_DISCONTINUITY;
-            p_sys->b_flag_discontinuity = false;
-        }
-        return pktout;
-    }
-    else
-        return NULL;
+    return pktout;
 }
 
 static void Clean( stream_t *p_access )
 {
     stream_sys_t *p_sys = p_access->p_sys;
 
+    for (unsigned i = 0; i < p_sys->i_paths; i++)
+        rist_path_close(&p_sys->paths[i]);
+    if (p_sys->pending != NULL)
+        block_Release(p_sys->pending);
+    free(p_sys->rx_buf);
+
     if (p_sys->flow)
     {
-        if (p_sys->flow->fd_in >= 0)
-            net_Close (p_sys->flow->fd_in);
-        if (p_sys->flow->fd_nack >= 0)
-            net_Close (p_sys->flow->fd_nack);
-        if (p_sys->flow->fd_rtcp_m >= 0)
-            net_Close (p_sys->flow->fd_rtcp_m);
         for (int i=0; i<RIST_QUEUE_SIZE; i++) {
             struct rtp_pkt *pkt = &(p_sys->flow->buffer[i]);
             if (pkt->buffer && pkt->buffer->i_buffer > 0) {
@@ -1065,15 +1224,42 @@ static int Open(vlc_object_t *p_this)
     }
 
     /* Initialize rist flow */
-    p_sys->b_ismulticast = is_multicast_address(parsed_url.psz_host);
-    p_sys->flow = rist_udp_receiver(p_access, &parsed_url, p_sys->b_ismulticast);
-    vlc_UrlClean( &parsed_url );
-    if (!p_sys->flow)
+    p_sys->flow = rist_init_rx();
+    if (!p_sys->flow || rist_path_open(p_access, &p_sys->paths[0], &parsed_url))
     {
+        vlc_UrlClean( &parsed_url );
         msg_Err( p_access, "Failed to open rist flow (%s)",
             p_access->psz_url );
         goto failed;
     }
+    vlc_UrlClean( &parsed_url );
+    p_sys->i_paths = 1;
+
+    populate_cname(p_sys->paths[0].fd_nack, p_sys->flow->cname);
+    msg_Info(p_access, "our cname is %s", p_sys->flow->cname);
+
+    /* Additional paths carrying the same stream */
+    char *psz_paths = var_InheritString( p_access, "bonding-paths" );
+    char *psz_save;
+    for (char *psz = strtok_r(psz_paths, ",", &psz_save); psz != NULL;
+         psz = strtok_r(NULL, ",", &psz_save))
+    {
+        char *url;
+
+        if (p_sys->i_paths >= RIST_MAX_PATHS)
+        {
+            msg_Warn(p_access, "ignoring path %s (too many paths)", psz);
+            continue;
+        }
+        if (asprintf(&url, "rist://%s", psz) < 0)
+            break;
+        if (rist_path_open_url(p_access, &p_sys->paths[p_sys->i_paths], url) == 0)
+            p_sys->i_paths++;
+        free(url);
+    }
+    free(psz_paths);
+    if (p_sys->i_paths > 1)
+        msg_Info(p_access, "receiving over %u bonded paths", p_sys->i_paths);
 
     p_sys->b_flag_discontinuity = false;
     p_sys->b_disablenacks = var_InheritBool( p_access, "disable-nacks" );
@@ -1084,6 +1270,9 @@ static int Open(vlc_object_t *p_this)
         p_sys->b_sendnacks = false;
     p_sys->nack_type = var_InheritInteger( p_access, "nack-type" );
     p_sys->i_max_packet_size = var_InheritInteger( p_access, "packet-size" );
+    p_sys->rx_buf = vlc_alloc(RIST_BATCH, p_sys->i_max_packet_size);
+    if (unlikely(p_sys->rx_buf == NULL))
+        goto failed;
     p_sys->i_poll_timeout = var_InheritInteger( p_access, "maximum-jitter" );
     p_sys->flow->retry_interval = var_InheritInteger( p_access, "retry-interval" );
     p_sys->flow->max_retries = var_InheritInteger( p_access, "max-retries" );
@@ -1144,6 +1333,9 @@ vlc_module_begin ()
         change_integer_list( nack_type, nack_type_names )
     add_bool( "disable-nacks", false, "Disable NACK output packets",
         "Use this to disable packet recovery", true )
+    add_string( "bonding-paths", NULL, N_("RIST bonded paths"),
+        N_("Comma-separated list of additional addresses (host:port) receiving the same " \
+        "stream, e.g. over other networks. Packets are de-duplicated by sequence number."), true )
     add_bool( "mcast-blind-nacks", false, "Do not check for a valid rtcp message from the encoder",
         "Send nack messages even when we have not confirmed that the encoder is on our local " \
         "network.", true )
@@ -38,6 +38,9 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <sys/socket.h>
+#endif
 
 #include "rtp.h"
 #ifdef HAVE_SRTP
@@ -46,6 +49,9 @@
 
 #define DEFAULT_MRU (1500u - (20 + 8))
 
+/* Upper bound on the number of datagrams fetched by a single recvmmsg() */
+#define RTP_BATCH 32
+
 /**
  * Processes a packet received from the RTP socket.
  */
@@ -100,6 +106,93 @@ static int rtp_timeout (vlc_tick_t deadline)
     return t;
 }
 
+#ifdef HAVE_RECVMMSG
+static void rtp_release_blocks (void *data)
+{
+    block_t **blocks = data;
+
+    for (unsigned i = 0; i < RTP_BATCH; i++)
+        if (blocks[i] != NULL)
+        {
+            block_Release (blocks[i]);
+            blocks[i] = NULL;
+        }
+}
+
+/**
+ * Receives all pending datagrams (up to RTP_BATCH) with a single system call.
+ * Each datagram is received directly into its own block.
+ *
+ * @param spare preallocated blocks, reused across calls
+ * @param mru pointer to the maximum receive unit (may grow)
+ * @return false if no blocks could be allocated, true otherwise
+ */
+static bool rtp_recv_batch (demux_t *demux, int fd, block_t **spare,
+                            size_t *mru, int trunc_flag)
+{
+    struct mmsghdr msgs[RTP_BATCH];
+    struct iovec iov[RTP_BATCH];
+    unsigned count = 0;
+
+    while (count < RTP_BATCH)
+    {
+        if (spare[count] == NULL)
+        {
+            spare[count] = block_Alloc (*mru);
+            if (unlikely(spare[count] == NULL))
+                break;
+        }
+
+        iov[count].iov_base = spare[count]->p_buffer;
+        iov[count].iov_len = *mru;
+        memset (&msgs[count], 0, sizeof (msgs[count]));
+        msgs[count].msg_hdr.msg_iov = &iov[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+        count++;
+    }
+
+    if (unlikely(count == 0))
+        return false;
+
+    int val = recvmmsg (fd, msgs, count, MSG_DONTWAIT | trunc_flag, NULL);
+    if (val == -1)
+    {
+        if (errno != EAGAIN)
+            msg_Warn (demux, "RTP network error: %s", vlc_strerror_c(errno));
+        return true;
+    }
+
+    bool truncated = false;
+
+    for (int i = 0; i < val; i++)
+    {
+        block_t *block = spare[i];
+        size_t len = msgs[i].msg_len;
+
+        spare[i] = NULL;
+        if (msgs[i].msg_hdr.msg_flags & trunc_flag)
+        {
+            msg_Err(demux, "%zu bytes packet truncated (MRU was %zu)",
+                    len, *mru);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (len > *mru)
+            {
+                *mru = len;
+                truncated = true;
+            }
+        }
+        else
+            block->i_buffer = len;
+
+        rtp_process (demux, block);
+    }
+
+    if (truncated) /* spare blocks are too small now */
+        rtp_release_blocks (spare);
+    return true;
+}
+#endif
+
 /**
  * RTP/RTCP session thread for datagram sockets
  */
@@ -119,16 +212,23 @@ void *rtp_dgram_thread (void *opaque)
     {
         .iov_len = DEFAULT_MRU,
     };
+#ifndef HAVE_RECVMMSG
     struct msghdr msg =
     {
         .msg_iov = &iov,
         .msg_iovlen = 1,
     };
+#endif
 
     struct pollfd ufd[1];
     ufd[0].fd = rtp_fd;
     ufd[0].events = POLLIN;
 
+#ifdef HAVE_RECVMMSG
+    block_t *spare[RTP_BATCH] = { NULL };
+
+    vlc_cleanup_push (rtp_release_blocks, spare);
+#endif
     for (;;)
     {
         int n = poll (ufd, 1, rtp_timeout (deadline));
@@ -143,8 +243,23 @@ void *rtp_dgram_thread (void *opaque)
         {
             n--;
             if (unlikely(ufd[0].revents & POLLHUP))
+            {
+                vlc_restorecancel (canc);
                 break; /* RTP socket dead (DCCP only) */
+            }
 
+#ifdef HAVE_RECVMMSG
+            if (!rtp_recv_batch (demux, rtp_fd, spare, &iov.iov_len,
+                                 trunc_flag))
+            {
+                if (iov.iov_len == DEFAULT_MRU)
+                {
+                    vlc_restorecancel (canc);
+                    break; /* we are totallly screwed */
+                }
+                iov.iov_len = DEFAULT_MRU; /* retry with shrunk MRU */
+            }
+#else
             block_t *block = block_Alloc (iov.iov_len);
             if (unlikely(block == NULL))
             {
@@ -178,6 +293,7 @@ void *rtp_dgram_thread (void *opaque)
                           vlc_strerror_c(errno));
                 block_Release (block);
             }
+#endif
         }
 
     dequeue:
@@ -185,5 +301,9 @@ void *rtp_dgram_thread (void *opaque)
             deadline = VLC_TICK_INVALID;
         vlc_restorecancel (canc);
     }
+#ifdef HAVE_RECVMMSG
+    vlc_cleanup_pop ();
+    rtp_release_blocks (spare);
+#endif
     return NULL;
 }
@@ -48,6 +48,7 @@ static rtp_source_t *
 rtp_source_create (demux_t *, const rtp_session_t *, uint32_t, uint16_t);
 static void
 rtp_source_destroy (demux_t *, const rtp_session_t *, rtp_source_t *);
+static void rtp_source_flush (rtp_source_t *);
 
 static void rtp_decode (demux_t *, const rtp_session_t *, rtp_source_t *);
 
@@ -148,8 +149,19 @@ struct rtp_source_t
     uint16_t bad_seq; /* tentatively next expected sequence for resync */
     uint16_t max_seq; /* next expected sequence */
 
-    uint16_t last_seq; /* sequence of the next dequeued packet */
-    block_t *blocks; /* re-ordered blocks queue */
+    uint16_t last_seq; /* sequence of the last dequeued packet */
+    uint16_t first_seq; /* lower bound of the earliest queued packet */
+    bool     discontinuity; /* whether to flag the next dequeued packet */
+    unsigned queued; /* number of re-ordered blocks */
+    unsigned ring_mask; /* re-ordering ring size minus one */
+    block_t **ring; /* re-ordered blocks, indexed by sequence number */
+
+    /* Statistics */
+    uint64_t received;
+    uint64_t lost;
+    uint64_t late;
+    uint64_t duplicates;
+
     void    *opaque[]; /* Per-source private payload data */
 };
 
@@ -160,19 +172,39 @@ static rtp_source_t *
 rtp_source_create (demux_t *demux, const rtp_session_t *session,
                    uint32_t ssrc, uint16_t init_seq)
 {
+    demux_sys_t *sys = demux->p_sys;
     rtp_source_t *source;
 
     source = malloc (sizeof (*source) + (sizeof (void *) * session->ptc));
     if (source == NULL)
         return NULL;
 
+    /* The ring must span the largest accepted forward jump. */
+    unsigned size = 64;
+    while (size <= sys->max_dropout)
+        size <<= 1;
+
+    source->ring = calloc (size, sizeof (*source->ring));
+    if (source->ring == NULL)
+    {
+        free (source);
+        return NULL;
+    }
+
     source->ssrc = ssrc;
     source->jitter = 0;
     source->ref_rtp = 0;
     source->ref_ntp = UINT64_C (1) << 62;
     source->max_seq = source->bad_seq = init_seq;
     source->last_seq = init_seq - 1;
-    source->blocks = NULL;
+    source->first_seq = init_seq;
+    source->discontinuity = false;
+    source->queued = 0;
+    source->ring_mask = size - 1;
+    source->received = 0;
+    source->lost = 0;
+    source->late = 0;
+    source->duplicates = 0;
 
     /* Initializes all payload */
     for (unsigned i = 0; i < session->ptc; i++)
@@ -191,10 +223,15 @@ rtp_source_destroy (demux_t *demux, const rtp_session_t *session,
                     rtp_source_t *source)
 {
     msg_Dbg (demux, "removing RTP source (%08x)", source->ssrc);
+    msg_Dbg (demux, " %"PRIu64" packets received, %"PRIu64" lost, "
+             "%"PRIu64" late, %"PRIu64" duplicate, jitter %"PRIu32,
+             source->received, source->lost, source->late,
+             source->duplicates, source->jitter);
 
     for (unsigned i = 0; i < session->ptc; i++)
         session->ptv[i].destroy (demux, source->opaque[i]);
-    block_ChainRelease (source->blocks);
+    rtp_source_flush (source);
+    free (source->ring);
     free (source);
 }
 
@@ -210,6 +247,56 @@ static inline uint32_t rtp_timestamp (const block_t *block)
     return GetDWBE (block->p_buffer + 4);
 }
 
+static inline block_t **rtp_source_slot (rtp_source_t *src, uint16_t seq)
+{
+    return &src->ring[seq & src->ring_mask];
+}
+
+/**
+ * Finds the earliest re-ordered block of a source.
+ * The search starts from the previous result, hence amortized O(1).
+ */
+static block_t *rtp_source_first (rtp_source_t *src)
+{
+    if (src->queued == 0)
+        return NULL;
+
+    for (;;)
+    {
+        block_t *block = *rtp_source_slot (src, src->first_seq);
+        if (block != NULL)
+            return block;
+        src->first_seq++;
+    }
+}
+
+/**
+ * Removes a re-ordered block of a source.
+ */
+static void rtp_source_remove (rtp_source_t *src, block_t *block)
+{
+    block_t **slot = rtp_source_slot (src, rtp_seq (block));
+
+    assert (*slot == block);
+    assert (src->queued > 0);
+    *slot = NULL;
+    src->queued--;
+}
+
+/**
+ * Discards all re-ordered blocks of a source.
+ */
+static void rtp_source_flush (rtp_source_t *src)
+{
+    block_t *block;
+
+    while ((block = rtp_source_first (src)) != NULL)
+    {
+        rtp_source_remove (src, block);
+        block_Release (block);
+    }
+}
+
 static const struct rtp_pt_t *
 rtp_find_ptype (const rtp_session_t *session, rtp_source_t *source,
                 const block_t *block, void **pt_data)
@@ -335,10 +422,11 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
         if (seq == src->bad_seq)
         {
             src->max_seq = src->bad_seq = seq + 1;
-            src->last_seq = seq - 0x7fffe; /* hack for rtp_decode() */
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
             msg_Warn (demux, "sequence resynchronized");
-            block_ChainRelease (src->blocks);
-            src->blocks = NULL;
+            rtp_source_flush (src);
+            src->first_seq = seq;
         }
         else
         {
@@ -352,23 +440,46 @@ rtp_queue (demux_t *demux, rtp_session_t *session, block_t *block)
 
     /* Queues the block in sequence order,
      * hence there is a single queue for all payload types. */
-    block_t **pp = &src->blocks;
-    for (block_t *prev = *pp; prev != NULL; prev = *pp)
+    uint16_t offset = seq - (uint16_t)(src->last_seq + 1);
+    if (offset >= 0x8000)
+    {   /* Trash too late packets (and PIM Assert duplicates) */
+        msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")", seq);
+        src->late++;
+        goto drop;
+    }
+
+    /* Make room in the ring, giving up on the oldest missing packets */
+    while (offset > src->ring_mask)
     {
-        delta_seq = seq - rtp_seq (prev);
-        if (delta_seq < 0)
+        block_t *first = rtp_source_first (src);
+        if (first == NULL)
+        {   /* Nothing left to wait for */
+            src->lost += (uint16_t)(seq - (uint16_t)(src->last_seq + 1));
+            src->last_seq = seq - 1;
+            src->discontinuity = true;
+            offset = 0;
             break;
-        if (delta_seq == 0)
-        {
-            msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
-            goto drop; /* duplicate */
         }
-        pp = &prev->p_next;
+        rtp_decode (demux, session, src);
+        offset = seq - (uint16_t)(src->last_seq + 1);
     }
-    block->p_next = *pp;
-    *pp = block;
 
-    /*rtp_decode (demux, session, src);*/
+    block_t **slot = rtp_source_slot (src, seq);
+    if (*slot != NULL)
+    {
+        assert (rtp_seq (*slot) == seq);
+        msg_Dbg (demux, "duplicate packet (sequence: %"PRIu16")", seq);
+        src->duplicates++;
+        goto drop; /* duplicate */
+    }
+
+    if (src->queued == 0
+     || (uint16_t)(seq - (uint16_t)(src->last_seq + 1))
+      < (uint16_t)(src->first_seq - (uint16_t)(src->last_seq + 1)))
+        src->first_seq = seq;
+    *slot = block;
+    src->queued++;
+    src->received++;
     return;
 
 drop:
@@ -419,7 +530,7 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
          * LibVLC E/S-out clock synchronization. Here, we need to bother about
          * re-ordering packets, as decoders can't cope with mis-ordered data.
          */
-        while (((block = src->blocks)) != NULL)
+        while (((block = rtp_source_first (src))) != NULL)
         {
             if ((int16_t)(rtp_seq (block) - (src->last_seq + 1)) <= 0)
             {   /* Next (or earlier) block ready, no need to wait */
@@ -467,26 +578,27 @@ bool rtp_dequeue (demux_t *demux, const rtp_session_t *session,
 static void
 rtp_decode (demux_t *demux, const rtp_session_t *session, rtp_source_t *src)
 {
-    block_t *block = src->blocks;
+    block_t *block = rtp_source_first (src);
 
     assert (block);
-    src->blocks = block->p_next;
-    block->p_next = NULL;
+    rtp_source_remove (src, block);
 
     /* Discontinuity detection */
     uint16_t delta_seq = rtp_seq (block) - (src->last_seq + 1);
+    assert (delta_seq < 0x8000); /* late packets are never queued */
     if (delta_seq != 0)
     {
-        if (delta_seq >= 0x8000)
-        {   /* Trash too late packets (and PIM Assert duplicates) */
-            msg_Dbg (demux, "ignoring late packet (sequence: %"PRIu16")",
-                      rtp_seq (block));
-            goto drop;
-        }
         msg_Warn (demux, "%"PRIu16" packet(s) lost", delta_seq);
+        src->lost += delta_seq;
+        src->discontinuity = true;
+    }
+    if (src->discontinuity)
+    {
         block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+        src->discontinuity = false;
     }
     src->last_seq = rtp_seq (block);
+    src->first_seq = src->last_seq + 1;
 
     /* Match the payload type */
     void *pt_data;
@@ -36,6 +36,7 @@
 #include <vlc_access.h>
 #include <vlc_network.h>
 #include <vlc_block.h>
+#include <vlc_memstream.h>
 #include <vlc_queue.h>
 #include <vlc_rand.h>
 #include <vlc_url.h>
@@ -54,6 +55,7 @@
 #define VLEN 100
 #define KEEPALIVE_INTERVAL 60
 #define KEEPALIVE_MARGIN 5
+#define TS_PIDS 8192
 
 static int satip_open(vlc_object_t *);
 static void satip_close(vlc_object_t *);
@@ -63,6 +65,10 @@ static void satip_close(vlc_object_t *);
 
 #define SATIP_HOST_TEXT N_("Host")
 
+#define PID_FILTER_TEXT N_("Filter PIDs")
+#define PID_FILTER_LONGTEXT N_("Only request the PIDs selected by the " \
+    "demultiplexer from the server, rather than the whole transport stream.")
+
 vlc_module_begin()
     set_shortname("satip")
     set_description( N_("SAT>IP Receiver Plugin") )
@@ -74,6 +80,8 @@ vlc_module_begin()
     add_bool("satip-multicast", false, MULTICAST_TEXT, MULTICAST_LONGTEXT, true)
     add_string("satip-host", "", SATIP_HOST_TEXT, SATIP_HOST_TEXT, true)
     change_safe()
+    add_bool("satip-pid-filter", true, PID_FILTER_TEXT, PID_FILTER_LONGTEXT,
+             true)
     add_shortcut("rtsp", "satip")
 vlc_module_end()
 
@@ -113,6 +121,14 @@ typedef struct
     uint16_t last_seq_nr;
 
     bool woken;
+
+    /* PID filtering, requested by the demultiplexer */
+    vlc_mutex_t pids_lock;
+    bool pid_filter;
+    bool pids_dirty;
+    bool pids_filtered; /* only the applied PIDs are streamed (not all) */
+    uint32_t pids_wanted[TS_PIDS / 32];
+    uint32_t pids_applied[TS_PIDS / 32]; /* owned by the thread */
 } access_sys_t;
 
 VLC_FORMAT(3, 4)
@@ -434,6 +450,87 @@ static void satip_teardown(void *data) {
     }
 }
 
+static bool pid_get(const uint32_t *set, unsigned pid)
+{
+    return (set[pid / 32] >> (pid % 32)) & 1;
+}
+
+static void pid_set(uint32_t *set, unsigned pid, bool on)
+{
+    if (on)
+        set[pid / 32] |= UINT32_C(1) << (pid % 32);
+    else
+        set[pid / 32] &= ~(UINT32_C(1) << (pid % 32));
+}
+
+/* Appends the PIDs of a set to a comma-separated list */
+static void pids_append(struct vlc_memstream *ms, const char *name,
+                        const uint32_t *set, const uint32_t *mask)
+{
+    bool first = true;
+
+    for (unsigned pid = 0; pid < TS_PIDS; pid++) {
+        if (!pid_get(set, pid) || (mask != NULL && pid_get(mask, pid)))
+            continue;
+
+        if (first)
+            vlc_memstream_printf(ms, "%s%s=", ms->length > 0 ? "&" : "", name);
+        vlc_memstream_printf(ms, first ? "%u" : ",%u", pid);
+        first = false;
+    }
+}
+
+/* Updates the PIDs streamed by the server, with a single PLAY request */
+static void satip_update_pids(stream_t *access)
+{
+    access_sys_t *sys = access->p_sys;
+    uint32_t wanted[TS_PIDS / 32];
+    struct vlc_memstream query;
+
+    vlc_mutex_lock(&sys->pids_lock);
+    memcpy(wanted, sys->pids_wanted, sizeof (wanted));
+    sys->pids_dirty = false;
+    vlc_mutex_unlock(&sys->pids_lock);
+
+    if (vlc_memstream_open(&query))
+        return;
+
+    if (!sys->pids_filtered) {
+        /* Switch from the whole transport stream to the selected PIDs */
+        pids_append(&query, "pids", wanted, NULL);
+    } else {
+        pids_append(&query, "addpids", wanted, sys->pids_applied);
+        pids_append(&query, "delpids", sys->pids_applied, wanted);
+    }
+
+    if (vlc_memstream_close(&query))
+        return;
+
+    if (query.length == 0) {
+        free(query.ptr);
+        return;
+    }
+
+    msg_Dbg(access, "updating PIDs: %s", query.ptr);
+    net_Printf(access, sys->tcp_sock,
+            "PLAY %s?%s RTSP/1.0\r\n"
+            "CSeq: %d\r\n"
+            "Session: %s\r\n\r\n",
+            sys->control, query.ptr, sys->cseq++, sys->session_id);
+    free(query.ptr);
+
+    if (rtsp_handle(access, NULL) != RTSP_RESULT_OK) {
+        msg_Warn(access, "Failed to update RTSP session PIDs");
+        vlc_mutex_lock(&sys->pids_lock);
+        sys->pid_filter = false;
+        vlc_mutex_unlock(&sys->pids_lock);
+        return;
+    }
+
+    memcpy(sys->pids_applied, wanted, sizeof (wanted));
+    sys->pids_filtered = true;
+}
+
 #define RECV_TIMEOUT VLC_TICK_FROM_SEC(2)
 static void *satip_thread(void *data) {
     stream_t *access = data;
@@ -524,6 +621,12 @@ static void *satip_thread(void *data) {
         vlc_queue_Enqueue(&sys->queue, block);
 #endif
 
+        vlc_mutex_lock(&sys->pids_lock);
+        bool update = sys->pid_filter && sys->pids_dirty;
+        vlc_mutex_unlock(&sys->pids_lock);
+        if (update)
+            satip_update_pids(access);
+
         if (sys->keepalive_interval > 0 && vlc_tick_now() > next_keepalive) {
             net_Printf(access, sys->tcp_sock,
                     "OPTIONS %s RTSP/1.0\r\n"
@@ -556,6 +659,7 @@ static block_t* satip_block(stream_t *access, bool *restrict eof) {
 }
 
 static int satip_control(stream_t *access, int i_query, va_list args) {
+    access_sys_t *sys = access->p_sys;
     bool *pb_bool;
 
     switch(i_query)
@@ -572,6 +676,40 @@ static int satip_control(stream_t *access, int i_query, va_list args) {
                 VLC_TICK_FROM_MS(var_InheritInteger(access, "live-caching"));
             break;
 
+        case STREAM_SET_PRIVATE_ID_STATE:
+        {
+            unsigned pid = va_arg(args, int);
+            bool on = va_arg(args, int);
+            int ret = VLC_SUCCESS;
+
+            if (unlikely(pid >= TS_PIDS))
+                return VLC_EGENERIC;
+
+            /* The streaming thread sends the update to the server */
+            vlc_mutex_lock(&sys->pids_lock);
+            if (sys->pid_filter) {
+                if (pid_get(sys->pids_wanted, pid) != on) {
+                    pid_set(sys->pids_wanted, pid, on);
+                    sys->pids_dirty = true;
+                }
+            } else
+                ret = VLC_EGENERIC;
+            vlc_mutex_unlock(&sys->pids_lock);
+            return ret;
+        }
+
+        case STREAM_GET_PRIVATE_ID_STATE:
+        {
+            unsigned pid = va_arg(args, int);
+            bool *on = va_arg(args, bool *);
+
+            vlc_mutex_lock(&sys->pids_lock);
+            *on = pid < TS_PIDS && (!sys->pid_filter
+                                    || pid_get(sys->pids_wanted, pid));
+            vlc_mutex_unlock(&sys->pids_lock);
+            break;
+        }
+
         default:
             return VLC_EGENERIC;
 
@@ -636,6 +774,7 @@ static int satip_open(vlc_object_t *obj)
     sys->udp_sock = -1;
     sys->rtcp_sock = -1;
     sys->tcp_sock = -1;
+    vlc_mutex_init(&sys->pids_lock);
 
     /* convert url to lowercase, some famous m3u playlists for satip contain
      * uppercase parameters while most (all?) satip servers do only understand
@@ -651,6 +790,11 @@ static int satip_open(vlc_object_t *obj)
     for (unsigned i = 0; i < strlen(psz_lower_url); i++)
         psz_lower_url[i] = tolower(psz_lower_url[i]);
 
+    /* Follow the demultiplexer selection only if the whole transport stream
+     * was requested; explicit PID lists are left alone. */
+    sys->pid_filter = var_InheritBool(access, "satip-pid-filter")
+                   && strstr(psz_lower_url, "pids=all") != NULL;
+
     vlc_UrlParse(&url, psz_lower_url);
     if (url.i_port <= 0)
         url.i_port = RTSP_DEFAULT_PORT;
@@ -32,7 +32,11 @@
 # include <sys/shm.h>
 # include <xcb/shm.h>
 #endif
+#ifdef HAVE_XCB_DAMAGE
+# include <xcb/damage.h>
+#endif
 #include <vlc_common.h>
+#include <vlc_block.h>
 #include <vlc_demux.h>
 #include <vlc_plugin.h>
 
@@ -60,6 +64,11 @@
 #define FOLLOW_MOUSE_LONGTEXT N_( \
     "Follow the mouse when capturing a subscreen." )
 
+#define DAMAGE_TEXT N_("Skip unchanged frames")
+#define DAMAGE_LONGTEXT N_( \
+    "Only capture the screen when its content changed, " \
+    "and at least once per second otherwise.")
+
 static int  Open (vlc_object_t *);
 static void Close (vlc_object_t *);
 
@@ -89,6 +98,9 @@ vlc_module_begin ()
         change_safe ()
     add_bool ("screen-follow-mouse", false, FOLLOW_MOUSE_TEXT,
               FOLLOW_MOUSE_LONGTEXT, true)
+#ifdef HAVE_XCB_DAMAGE
+    add_bool ("screen-damage", true, DAMAGE_TEXT, DAMAGE_LONGTEXT, true)
+#endif
 
     add_shortcut ("screen", "window")
 vlc_module_end ()
@@ -101,6 +113,33 @@ static int Control (demux_t *, int, va_list);
 static es_out_id_t *InitES (demux_t *, uint_fast16_t, uint_fast16_t,
                             uint_fast8_t, uint8_t *);
 
+#ifdef HAVE_SYS_SHM_H
+#define SCREEN_SHM_SEGMENTS 8
+
+struct screen_shm_pool;
+
+/** Shared memory segment, attached once to both VLC and the X server */
+struct screen_shm_seg
+{
+    block_t block;
+    struct screen_shm_pool *pool;
+    void *addr; /**< VLC mapping, or NULL if not allocated */
+    size_t size;
+    xcb_shm_seg_t xid;
+    bool busy; /**< Whether a block refers to the segment */
+};
+
+struct screen_shm_pool
+{
+    vlc_mutex_t lock;
+    unsigned refs; /**< Demux and busy segments */
+    struct screen_shm_seg segv[SCREEN_SHM_SEGMENTS];
+};
+#endif
+
+/** Minimum refresh interval of unchanged content */
+#define SCREEN_IDLE_REFRESH VLC_TICK_FROM_SEC(1)
+
 typedef struct
 {
     /* All owned by timer thread while timer is armed: */
@@ -110,14 +149,21 @@ typedef struct
     xcb_window_t      window; /**< Captured window XID  */
     xcb_pixmap_t      pixmap; /**< Pixmap for composited capture */
 #ifdef HAVE_SYS_SHM_H
-    xcb_shm_seg_t     segment; /**< SHM segment XID */
+    struct screen_shm_pool *shm_pool; /**< Shared memory segments */
 #endif
+#ifdef HAVE_XCB_DAMAGE
+    xcb_damage_damage_t damage; /**< Damage XID, or XCB_NONE */
+    uint8_t           damage_event; /**< Damage notification event type */
+    bool              damaged; /**< Whether the content changed */
+#endif
+    vlc_tick_t        last_capture; /**< Date of the last captured frame */
     int16_t           x, y; /**< Requested capture top-left coordinates */
     uint16_t          w, h; /**< Requested capture pixel dimensions */
     uint8_t           bpp; /**< Actual bytes per pixel *es */
     bool              shm; /**< Whether to use MIT-SHM */
     bool              follow_mouse;
     uint16_t          cur_w, cur_h; /**< Actual capture pixel dimensions */
+    int               cur_x, cur_y; /**< Actual capture coordinates */
     /* Timer does not use this, only input thread: */
     vlc_timer_t       timer;
 } demux_sys_t;
@@ -138,6 +184,162 @@ static bool CheckSHM (xcb_connection_t *conn)
 #endif
 }
 
+#ifdef HAVE_SYS_SHM_H
+static struct screen_shm_pool *CreateSHMPool (void)
+{
+    struct screen_shm_pool *pool = malloc (sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_mutex_init (&pool->lock);
+    pool->refs = 1;
+    for (unsigned i = 0; i < SCREEN_SHM_SEGMENTS; i++)
+    {
+        pool->segv[i].pool = pool;
+        pool->segv[i].addr = NULL;
+        pool->segv[i].busy = false;
+    }
+    return pool;
+}
+
+/** Drops a pool reference, from the demux or from a busy segment */
+static void ReleaseSHMPool (struct screen_shm_pool *pool)
+{
+    bool last;
+
+    vlc_mutex_lock (&pool->lock);
+    assert(pool->refs > 0);
+    last = --pool->refs == 0;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (!last)
+        return;
+
+    for (unsigned i = 0; i < SCREEN_SHM_SEGMENTS; i++)
+        if (pool->segv[i].addr != NULL)
+            shmdt (pool->segv[i].addr);
+    free (pool);
+}
+
+static void SHMBlockRelease (block_t *block)
+{
+    struct screen_shm_seg *seg = container_of(block, struct screen_shm_seg,
+                                              block);
+    struct screen_shm_pool *pool = seg->pool;
+
+    vlc_mutex_lock (&pool->lock);
+    assert(seg->busy);
+    seg->busy = false;
+    vlc_mutex_unlock (&pool->lock);
+    ReleaseSHMPool (pool);
+}
+
+static const struct vlc_block_callbacks SHMBlockCallbacks = {
+    SHMBlockRelease,
+};
+
+/**
+ * Allocates a shared memory segment and attaches it to the X server.
+ */
+static int AllocSHM (demux_t *demux, struct screen_shm_seg *seg, size_t size)
+{
+    demux_sys_t *sys = demux->p_sys;
+    xcb_connection_t *conn = sys->conn;
+
+    if (seg->addr != NULL)
+    {   /* Too small: replace it */
+        xcb_shm_detach (conn, seg->xid);
+        shmdt (seg->addr);
+        seg->addr = NULL;
+    }
+
+    int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (id == -1)
+    {
+        msg_Err (demux, "shared memory allocation error: %s",
+                 vlc_strerror_c(errno));
+        return -1;
+    }
+
+    void *addr = shmat (id, NULL, 0 /* read/write */);
+    if (-1 == (intptr_t)addr)
+    {
+        msg_Err (demux, "shared memory attachment error: %s",
+                 vlc_strerror_c(errno));
+        shmctl (id, IPC_RMID, 0);
+        return -1;
+    }
+
+    /* The segment can only be marked for deletion once the X server has
+     * attached it too. */
+    xcb_generic_error_t *err;
+
+    seg->xid = xcb_generate_id (conn);
+    err = xcb_request_check (conn, xcb_shm_attach_checked (conn, seg->xid, id,
+                                                           0 /* read/write */));
+    shmctl (id, IPC_RMID, 0);
+    if (err != NULL)
+    {
+        msg_Err (demux, "shared memory server attachment error");
+        free (err);
+        shmdt (addr);
+        return -1;
+    }
+
+    seg->addr = addr;
+    seg->size = size;
+    return 0;
+}
+
+/**
+ * Captures a frame into one of the free shared memory segments.
+ */
+static block_t *CaptureSHM (demux_t *demux, xcb_drawable_t drawable,
+                            int x, int y, unsigned w, unsigned h)
+{
+    demux_sys_t *sys = demux->p_sys;
+    struct screen_shm_pool *pool = sys->shm_pool;
+    struct screen_shm_seg *seg = NULL;
+    size_t size = w * h * sys->bpp;
+
+    /* Prefer a free segment that is already large enough */
+    vlc_mutex_lock (&pool->lock);
+    for (unsigned i = 0; i < SCREEN_SHM_SEGMENTS; i++)
+    {
+        struct screen_shm_seg *s = &pool->segv[i];
+
+        if (s->busy)
+            continue;
+        if (seg == NULL || (s->addr != NULL && s->size >= size))
+            seg = s;
+        if (s->addr != NULL && s->size >= size)
+            break;
+    }
+    vlc_mutex_unlock (&pool->lock);
+
+    if (seg == NULL)
+        return NULL; /* all segments in use */
+    if ((seg->addr == NULL || seg->size < size)
+     && AllocSHM (demux, seg, size))
+        return NULL;
+
+    xcb_shm_get_image_reply_t *img;
+
+    img = xcb_shm_get_image_reply (sys->conn,
+        xcb_shm_get_image (sys->conn, drawable, x, y, w, h, ~0,
+                           XCB_IMAGE_FORMAT_Z_PIXMAP, seg->xid, 0), NULL);
+    if (img == NULL)
+        return NULL;
+    free (img);
+
+    vlc_mutex_lock (&pool->lock);
+    seg->busy = true;
+    pool->refs++;
+    vlc_mutex_unlock (&pool->lock);
+    return block_Init (&seg->block, &SHMBlockCallbacks, seg->addr, size);
+}
+#endif
+
 /**
  * Probes and initializes.
  */
@@ -151,6 +353,9 @@ static int Open (vlc_object_t *obj)
     if (p_sys == NULL)
         return VLC_ENOMEM;
     demux->p_sys = p_sys;
+#ifdef HAVE_SYS_SHM_H
+    p_sys->shm_pool = NULL;
+#endif
 
     /* Connect to X server */
     char *display = var_InheritString (obj, "x11-display");
@@ -220,10 +425,38 @@ static int Open (vlc_object_t *obj)
 
     /* Window properties */
     p_sys->pixmap = xcb_generate_id (conn);
+    p_sys->shm = CheckSHM (conn);
 #ifdef HAVE_SYS_SHM_H
-    p_sys->segment = xcb_generate_id (conn);
+    if (p_sys->shm)
+    {
+        p_sys->shm_pool = CreateSHMPool ();
+        if (unlikely(p_sys->shm_pool == NULL))
+            goto error;
+    }
+#endif
+#ifdef HAVE_XCB_DAMAGE
+    p_sys->damage = XCB_NONE;
+    p_sys->damaged = true;
+    if (var_InheritBool (obj, "screen-damage"))
+    {
+        xcb_damage_query_version_reply_t *r =
+            xcb_damage_query_version_reply (conn,
+                xcb_damage_query_version (conn, 1, 1), NULL);
+        if (r != NULL)
+        {
+            const xcb_query_extension_reply_t *ext =
+                xcb_get_extension_data (conn, &xcb_damage_id);
+
+            p_sys->damage = xcb_generate_id (conn);
+            p_sys->damage_event = ext->first_event + XCB_DAMAGE_NOTIFY;
+            xcb_damage_create (conn, p_sys->damage, p_sys->window,
+                               XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+            msg_Dbg (obj, "using Damage extension v%"PRIu32".%"PRIu32,
+                     r->major_version, r->minor_version);
+            free (r);
+        }
+    }
 #endif
-    p_sys->shm = CheckSHM (conn);
     p_sys->w = var_InheritInteger (obj, "screen-width");
     p_sys->h = var_InheritInteger (obj, "screen-height");
     if (p_sys->w != 0 || p_sys->h != 0)
@@ -247,7 +480,10 @@ static int Open (vlc_object_t *obj)
 
     p_sys->cur_w = 0;
     p_sys->cur_h = 0;
+    p_sys->cur_x = 0;
+    p_sys->cur_y = 0;
     p_sys->bpp = 0;
+    p_sys->last_capture = VLC_TICK_INVALID;
     p_sys->es = NULL;
     if (vlc_timer_create (&p_sys->timer, Demux, demux))
         goto error;
@@ -259,6 +495,10 @@ static int Open (vlc_object_t *obj)
     return VLC_SUCCESS;
 
 error:
+#ifdef HAVE_SYS_SHM_H
+    if (p_sys->shm_pool != NULL)
+        ReleaseSHMPool (p_sys->shm_pool);
+#endif
     xcb_disconnect (p_sys->conn);
     free (p_sys);
     return VLC_EGENERIC;
@@ -274,7 +514,13 @@ static void Close (vlc_object_t *obj)
     demux_sys_t *p_sys = demux->p_sys;
 
     vlc_timer_destroy (p_sys->timer);
+    /* Disconnecting detaches the shared memory segments from the server.
+     * The segments themselves remain mapped until the last block is gone. */
     xcb_disconnect (p_sys->conn);
+#ifdef HAVE_SYS_SHM_H
+    if (p_sys->shm_pool != NULL)
+        ReleaseSHMPool (p_sys->shm_pool);
+#endif
     free (p_sys);
 }
 
@@ -335,6 +581,21 @@ static void Demux (void *opaque)
     demux_t *demux = opaque;
     demux_sys_t *sys = demux->p_sys;
     xcb_connection_t *conn = sys->conn;
+    vlc_tick_t now = vlc_tick_now ();
+
+#ifdef HAVE_XCB_DAMAGE
+    if (sys->damage != XCB_NONE)
+    {   /* Check for content changes since the last capture */
+        xcb_generic_event_t *ev;
+
+        while ((ev = xcb_poll_for_event (conn)) != NULL)
+        {
+            if ((ev->response_type & 0x7f) == sys->damage_event)
+                sys->damaged = true;
+            free (ev);
+        }
+    }
+#endif
 
     /* Determine capture region */
     xcb_get_geometry_cookie_t gc;
@@ -428,6 +689,7 @@ discard:
             sys->cur_w = w;
             sys->cur_h = h;
             sys->bpp /= 8; /* bits -> bytes */
+            sys->last_capture = VLC_TICK_INVALID;
         }
     }
 
@@ -436,52 +698,32 @@ discard:
         (sys->window != geo->root) ? sys->pixmap : sys->window;
     free (geo);
 
-    block_t *block = NULL;
-#ifdef HAVE_SYS_SHM_H
-    if (sys->shm)
-    {   /* Capture screen through shared memory */
-        size_t size = w * h * sys->bpp;
-        int id = shmget (IPC_PRIVATE, size, IPC_CREAT | 0777);
-        if (id == -1) /* XXX: fallback */
-        {
-            msg_Err (demux, "shared memory allocation error: %s",
-                     vlc_strerror_c(errno));
-            goto noshm;
-        }
-
-        /* Attach the segment to X and capture */
-        xcb_shm_get_image_reply_t *img;
-        xcb_shm_get_image_cookie_t ck;
-
-        xcb_shm_attach (conn, sys->segment, id, 0 /* read/write */);
-        ck = xcb_shm_get_image (conn, drawable, x, y, w, h, ~0,
-                                XCB_IMAGE_FORMAT_Z_PIXMAP, sys->segment, 0);
-        xcb_shm_detach (conn, sys->segment);
-        img = xcb_shm_get_image_reply (conn, ck, NULL);
-        xcb_flush (conn); /* ensure eventual detach */
-
-        if (img == NULL)
-        {
-            shmctl (id, IPC_RMID, 0);
-            goto noshm;
-        }
-        free (img);
-
-        /* Attach the segment to VLC */
-        void *shm = shmat (id, NULL, 0 /* read/write */);
-        shmctl (id, IPC_RMID, 0);
-        if (-1 == (intptr_t)shm)
-        {
-            msg_Err (demux, "shared memory attachment error: %s",
-                     vlc_strerror_c(errno));
+#ifdef HAVE_XCB_DAMAGE
+    if (sys->damage != XCB_NONE)
+    {
+        if (!sys->damaged && x == sys->cur_x && y == sys->cur_y
+         && sys->last_capture != VLC_TICK_INVALID
+         && now - sys->last_capture < SCREEN_IDLE_REFRESH)
+        {   /* Unchanged content: nothing to capture */
+            if (sys->es != NULL)
+                es_out_SetPCR (demux->out, now);
             return;
         }
 
-        block = block_shm_Alloc (shm, size);
-        if (unlikely(block == NULL))
-            shmdt (shm);
+        /* Reset the damage before capturing, so that any later change
+         * triggers a new notification. */
+        xcb_damage_subtract (conn, sys->damage, XCB_NONE, XCB_NONE);
+        sys->damaged = false;
     }
-noshm:
+#endif
+    sys->cur_x = x;
+    sys->cur_y = y;
+    sys->last_capture = now;
+
+    block_t *block = NULL;
+#ifdef HAVE_SYS_SHM_H
+    if (sys->shm) /* Capture screen through shared memory */
+        block = CaptureSHM (demux, drawable, x, y, w, h);
 #endif
     if (block == NULL)
     {   /* Capture screen through socket (fallback) */
@@ -505,7 +747,7 @@ noshm:
     /* Send block - zero copy */
     if (sys->es != NULL)
     {
-        block->i_pts = block->i_dts = vlc_tick_now ();
+        block->i_pts = block->i_dts = now;
 
         es_out_SetPCR(demux->out, block->i_pts);
         es_out_Send (demux->out, sys->es, block);
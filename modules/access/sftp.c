@@ -57,6 +57,9 @@ static void Close( vlc_object_t* );
 #define PASS_TEXT N_("Password")
 #define PASS_LONGTEXT N_("Password that will be used for the connection, " \
         "if no username or password are set in URL.")
+#define READ_AHEAD_TEXT N_("Read-ahead requests")
+#define READ_AHEAD_LONGTEXT N_("Number of concurrent read requests. " \
+        "More requests hide the network latency, at the cost of memory.")
 
 vlc_module_begin ()
     set_shortname( "SFTP" )
@@ -67,6 +70,8 @@ vlc_module_begin ()
     add_integer( "sftp-port", 22, PORT_TEXT, PORT_LONGTEXT, true )
     add_string( "sftp-user", NULL, USER_TEXT, USER_LONGTEXT, false )
     add_password("sftp-pwd", NULL, PASS_TEXT, PASS_LONGTEXT)
+    add_integer_with_range( "sftp-read-ahead", 64, 1, 256, READ_AHEAD_TEXT,
+                            READ_AHEAD_LONGTEXT, true )
     add_shortcut( "sftp" )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -81,6 +86,9 @@ static int      Control( stream_t *, int, va_list );
 
 static int DirRead( stream_t *, input_item_node_t * );
 
+/* Largest read request issued by libssh2 */
+#define SFTP_READ_SIZE 30000
+
 typedef struct
 {
     int i_socket;
@@ -89,6 +97,12 @@ typedef struct
     LIBSSH2_SFTP_HANDLE* file;
     uint64_t filesize;
     char *psz_base_url;
+
+    /* libssh2 pipelines as many read requests as fit in the read buffer */
+    uint8_t *p_buf;
+    size_t i_buf_size;
+    size_t i_buf_pos;
+    size_t i_buf_len;
 } access_sys_t;
 
 static int AuthKeyAgent( stream_t *p_access, const char *psz_username )
@@ -479,6 +493,12 @@ static int Open( vlc_object_t* p_this )
         p_sys->file = libssh2_sftp_open( p_sys->sftp_session, psz_path, LIBSSH2_FXF_READ, 0 );
         p_sys->filesize = attributes.filesize;
 
+        p_sys->i_buf_size = SFTP_READ_SIZE
+                          * var_InheritInteger( p_access, "sftp-read-ahead" );
+        p_sys->p_buf = malloc( p_sys->i_buf_size );
+        if( !p_sys->p_buf )
+            goto error;
+
         ACCESS_SET_CALLBACKS( Read, NULL, Control, Seek );
     }
     else
@@ -535,6 +555,7 @@ static void Close( vlc_object_t* p_this )
     SSHSessionDestroy( p_access );
 
     free( p_sys->psz_base_url );
+    free( p_sys->p_buf );
 }
 
 
@@ -542,22 +563,45 @@ static ssize_t Read( stream_t *p_access, void *buf, size_t len )
 {
     access_sys_t *p_sys = p_access->p_sys;
 
-    ssize_t val = libssh2_sftp_read(  p_sys->file, buf, len );
-    if( val < 0 )
+    if( p_sys->i_buf_pos == p_sys->i_buf_len )
     {
-        msg_Err( p_access, "read failed" );
-        return 0;
+        /* Large reads let libssh2 keep several requests in flight */
+        ssize_t val = libssh2_sftp_read( p_sys->file, (char *)p_sys->p_buf,
+                                         p_sys->i_buf_size );
+        if( val < 0 )
+        {
+            msg_Err( p_access, "read failed" );
+            return 0;
+        }
+
+        p_sys->i_buf_pos = 0;
+        p_sys->i_buf_len = val;
     }
 
-    return val;
+    if( len > p_sys->i_buf_len - p_sys->i_buf_pos )
+        len = p_sys->i_buf_len - p_sys->i_buf_pos;
+
+    memcpy( buf, p_sys->p_buf + p_sys->i_buf_pos, len );
+    p_sys->i_buf_pos += len;
+    return len;
 }
 
 
 static int Seek( stream_t* p_access, uint64_t i_pos )
 {
     access_sys_t *sys = p_access->p_sys;
+    uint64_t i_end = libssh2_sftp_tell64( sys->file );
+
+    /* Forward seek within the buffered data */
+    if( i_pos <= i_end && i_end - i_pos <= sys->i_buf_len - sys->i_buf_pos )
+    {
+        sys->i_buf_pos = sys->i_buf_len - (i_end - i_pos);
+        return VLC_SUCCESS;
+    }
 
-    libssh2_sftp_seek( sys->file, i_pos );
+    /* Seeking discards the read requests in flight */
+    libssh2_sftp_seek64( sys->file, i_pos );
+    sys->i_buf_pos = sys->i_buf_len = 0;
     return VLC_SUCCESS;
 }
 
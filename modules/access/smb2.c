@@ -58,6 +58,10 @@
 
 #include "smb_common.h"
 
+#define READ_AHEAD_TEXT N_("Read-ahead requests")
+#define READ_AHEAD_LONGTEXT N_("Number of concurrent read requests. " \
+    "More requests hide the network latency, at the cost of memory.")
+
 static int Open(vlc_object_t *);
 static void Close(vlc_object_t *);
 
@@ -71,10 +75,30 @@ vlc_module_begin()
     add_string("smb-user", NULL, SMB_USER_TEXT, SMB_USER_LONGTEXT, false)
     add_password("smb-pwd", NULL, SMB_PASS_TEXT, SMB_PASS_LONGTEXT)
     add_string("smb-domain", NULL, SMB_DOMAIN_TEXT, SMB_DOMAIN_LONGTEXT, false)
+    add_integer_with_range("smb-read-ahead", 8, 1, 32, READ_AHEAD_TEXT,
+                           READ_AHEAD_LONGTEXT, true)
     add_shortcut("smb", "smb2")
     set_callbacks(Open, Close)
 vlc_module_end()
 
+/* Limit the read size since smb2_pread_async() will complete only after
+ * reading the whole requested data and not when whatever data is available
+ * (high read size means a faster I/O but a higher latency). */
+#define SMB2_READ_SIZE 262144
+
+struct smb2_read_req
+{
+    stream_t *access;
+    uint8_t *buf;
+    uint64_t offset;
+    size_t len; /* requested bytes */
+    size_t size; /* received bytes */
+    size_t pos; /* consumed bytes */
+    bool pending;
+    bool queued;
+    bool discard; /* result is not wanted anymore */
+};
+
 struct access_sys
 {
     struct smb2_context *   smb2;
@@ -87,6 +111,13 @@ struct access_sys
     bool                    smb2_connected;
     int                     error_status;
 
+    struct smb2_read_req   *reads;
+    struct smb2_read_req  **read_queue; /* requests in file order */
+    unsigned                read_ahead;
+    unsigned                read_head;
+    unsigned                read_count;
+    uint64_t                read_offset; /* offset of the next request */
+
     bool res_done;
     union {
         struct
@@ -218,16 +249,110 @@ smb2_generic_cb(struct smb2_context *smb2, int status, void *data,
 }
 
 static void
-smb2_read_cb(struct smb2_context *smb2, int status, void *data,
-             void *private_data)
+smb2_pread_cb(struct smb2_context *smb2, int status, void *data,
+              void *private_data)
 {
-    VLC_UNUSED(data);
-    VLC_SMB2_GENERIC_CB();
+    struct smb2_read_req *req = private_data;
+    stream_t *access = req->access;
+    struct access_sys *sys = access->p_sys;
 
-    if (status == 0)
-        sys->eof = true;
-    else
-        sys->res.read.len = status;
+    VLC_UNUSED(smb2); VLC_UNUSED(data);
+    assert(sys->smb2 == smb2);
+    assert(req->pending);
+
+    req->pending = false;
+    sys->res_done = true;
+
+    if (req->discard)
+    {   /* Cancelled by a seek: ignore the result */
+        req->discard = false;
+        return;
+    }
+
+    if (VLC_SMB2_CHECK_STATUS(access, status))
+        return;
+
+    req->size = status;
+}
+
+static struct smb2_read_req *
+vlc_smb2_read_queue_head(struct access_sys *sys)
+{
+    assert(sys->read_count > 0);
+    return sys->read_queue[sys->read_head];
+}
+
+static void
+vlc_smb2_read_pop(struct access_sys *sys)
+{
+    struct smb2_read_req *req = vlc_smb2_read_queue_head(sys);
+
+    req->queued = false;
+    req->discard = req->pending;
+    sys->read_head = (sys->read_head + 1) % sys->read_ahead;
+    sys->read_count--;
+}
+
+/* Cancels all queued read requests */
+static void
+vlc_smb2_read_flush(struct access_sys *sys, uint64_t offset)
+{
+    while (sys->read_count > 0)
+        vlc_smb2_read_pop(sys);
+    sys->read_offset = offset;
+}
+
+/* Queues read requests ahead of the current position */
+static int
+vlc_smb2_read_ahead(stream_t *access)
+{
+    struct access_sys *sys = access->p_sys;
+
+    for (unsigned i = 0; i < sys->read_ahead; i++)
+    {
+        struct smb2_read_req *req = &sys->reads[i];
+
+        if (req->queued || req->pending)
+            continue;
+        /* Do not read ahead past the end, but keep one request to detect
+         * the actual end of file */
+        if (sys->read_count > 0 && sys->read_offset >= sys->smb2_size)
+            break;
+
+        req->offset = sys->read_offset;
+        req->len = SMB2_READ_SIZE;
+        req->size = 0;
+        req->pos = 0;
+
+        if (smb2_pread_async(sys->smb2, sys->smb2fh, req->buf, req->len,
+                             req->offset, smb2_pread_cb, req) < 0)
+        {
+            VLC_SMB2_SET_ERROR(access, "smb2_pread_async", 1);
+            return -1;
+        }
+
+        req->pending = true;
+        req->queued = true;
+        sys->read_queue[(sys->read_head + sys->read_count)
+                        % sys->read_ahead] = req;
+        sys->read_count++;
+        sys->read_offset += req->len;
+    }
+    return 0;
+}
+
+/* Waits for all pending read requests, ignoring their results */
+static void
+vlc_smb2_read_drain(stream_t *access)
+{
+    struct access_sys *sys = access->p_sys;
+
+    vlc_smb2_read_flush(sys, 0);
+
+    for (unsigned i = 0; i < sys->read_ahead; i++)
+        while (sys->reads[i].pending)
+            if (vlc_smb2_mainloop(access, true) < 0)
+                return;
 }
 
 static ssize_t
@@ -235,30 +360,62 @@ FileRead(stream_t *access, void *buf, size_t len)
 {
     struct access_sys *sys = access->p_sys;
 
-    if (sys->error_status != 0)
-        return -1;
+    for (;;)
+    {
+        if (sys->error_status != 0)
+            return -1;
 
-    if (sys->eof)
-        return 0;
+        if (sys->eof)
+            return 0;
 
-    /* Limit the read size since smb2_read_async() will complete only after
-     * reading the whole requested data and not when whatever data is available
-     * (high read size means a faster I/O but a higher latency). */
-    if (len > 262144)
-        len = 262144;
+        if (vlc_smb2_read_ahead(access))
+            return -1;
 
-    sys->res.read.len = 0;
-    if (smb2_read_async(sys->smb2, sys->smb2fh, buf, len,
-                        smb2_read_cb, access) < 0)
-    {
-        VLC_SMB2_SET_ERROR(access, "smb2_read_async", 1);
-        return -1;
-    }
+        if (sys->read_count == 0)
+        {   /* All requests were cancelled and are still pending */
+            if (vlc_smb2_mainloop(access, false) < 0)
+                return -1;
+            continue;
+        }
 
-    if (vlc_smb2_mainloop(access, false) < 0)
-        return -1;
+        struct smb2_read_req *req = vlc_smb2_read_queue_head(sys);
+
+        while (req->pending)
+            if (vlc_smb2_mainloop(access, false) < 0)
+                return -1;
+
+        if (sys->error_status != 0)
+            return -1;
+
+        if (req->pos < req->size)
+        {
+            if (len > req->size - req->pos)
+                len = req->size - req->pos;
+
+            memcpy(buf, req->buf + req->pos, len);
+            req->pos += len;
+
+            if (req->pos == req->len)
+                vlc_smb2_read_pop(sys);
+            return len;
+        }
+
+        if (req->size == 0)
+        {   /* End of file */
+            sys->eof = true;
+            vlc_smb2_read_flush(sys, req->offset);
+            return 0;
+        }
 
-    return sys->res.read.len;
+        if (req->size == req->len)
+        {   /* Fully consumed (skipped by a seek) */
+            vlc_smb2_read_pop(sys);
+            continue;
+        }
+
+        /* Short read: restart the read-ahead after the received data */
+        vlc_smb2_read_flush(sys, req->offset + req->pos);
+    }
 }
 
 static int
@@ -269,11 +426,29 @@ FileSeek(stream_t *access, uint64_t i_pos)
     if (sys->error_status != 0)
         return VLC_EGENERIC;
 
-    if (smb2_lseek(sys->smb2, sys->smb2fh, i_pos, SEEK_SET, NULL) < 0)
+    /* Keep the queued requests after the new position, if any */
+    while (sys->read_count > 0)
     {
-        VLC_SMB2_SET_ERROR(access, "smb2_seek_async", 1);
-        return VLC_EGENERIC;
+        struct smb2_read_req *req = vlc_smb2_read_queue_head(sys);
+
+        if (i_pos < req->offset + req->pos)
+        {   /* Backward seek */
+            vlc_smb2_read_flush(sys, i_pos);
+            break;
+        }
+
+        if (i_pos < req->offset + req->len)
+        {
+            req->pos = i_pos - req->offset;
+            if (!req->pending && req->pos > req->size)
+                vlc_smb2_read_flush(sys, i_pos);
+            break;
+        }
+        vlc_smb2_read_pop(sys);
     }
+
+    if (sys->read_count == 0)
+        sys->read_offset = i_pos;
     sys->eof = false;
 
     return VLC_SUCCESS;
@@ -426,6 +601,8 @@ vlc_smb2_close_fh(stream_t *access)
 
     assert(sys->smb2fh);
 
+    vlc_smb2_read_drain(access);
+
     if (smb2_close_async(sys->smb2, sys->smb2fh, smb2_generic_cb, access) < 0)
     {
         VLC_SMB2_SET_ERROR(access, "smb2_close_async", 1);
@@ -703,6 +880,23 @@ Open(vlc_object_t *p_obj)
 
     if (sys->smb2fh != NULL)
     {
+        unsigned count = var_InheritInteger(access, "smb-read-ahead");
+
+        sys->reads = vlc_obj_calloc(p_obj, count, sizeof (*sys->reads));
+        sys->read_queue = vlc_obj_calloc(p_obj, count,
+                                         sizeof (*sys->read_queue));
+        if (unlikely(sys->reads == NULL || sys->read_queue == NULL))
+            goto error;
+
+        for (unsigned i = 0; i < count; i++)
+        {
+            sys->reads[i].access = access;
+            sys->reads[i].buf = vlc_obj_malloc(p_obj, SMB2_READ_SIZE);
+            if (unlikely(sys->reads[i].buf == NULL))
+                goto error;
+        }
+        sys->read_ahead = count;
+
         access->pf_read = FileRead;
         access->pf_seek = FileSeek;
         access->pf_control = FileControl;
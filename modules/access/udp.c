@@ -35,6 +35,8 @@
 # include "config.h"
 #endif
 
+#include <errno.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_access.h>
@@ -47,16 +49,38 @@
 #ifdef HAVE_SYS_UIO_H
 # include <sys/uio.h>
 #endif
+#ifdef HAVE_RECVMMSG
+# include <sys/socket.h>
+# include <time.h>
+#endif
+#include "udp.h"
 
 /* Buffer can be max theoretical datagram content minus anticipated MTU.
  * IPv6 headers are larger than IPv4, ignore IPv6 jumbograms.
  */
 #define MRU 65507u
 
+/* Upper bound on the number of datagrams fetched by a single recvmmsg() */
+#define BATCH_MAX 64
+
 typedef struct {
     int fd;
     int timeout;
 
+#ifdef HAVE_RECVMMSG
+    /* Block (batched) mode */
+    unsigned batch;
+    size_t mtu;
+    bool timestamps;
+    block_t *spare[BATCH_MAX];
+    block_t *queue;
+    block_t **queue_last;
+#endif
+
+#ifdef __linux__
+    struct udp_ring_sub *ring; /**< Shared packet ring subscription */
+#endif
+
     size_t length;
     char *offset;
     char buf[MRU];
@@ -132,6 +156,162 @@ static ssize_t Read(stream_t *access, void *buf, size_t len)
     return val;
 }
 
+#ifdef HAVE_RECVMMSG
+static void FlushSpare(access_sys_t *sys)
+{
+    for (unsigned i = 0; i < BATCH_MAX; i++)
+        if (sys->spare[i] != NULL)
+        {
+            block_Release(sys->spare[i]);
+            sys->spare[i] = NULL;
+        }
+}
+
+/**
+ * Fetches as many pending datagrams as possible (up to sys->batch) with a
+ * single system call. Each datagram is received directly into its own
+ * block, so that no copy is needed afterwards.
+ */
+static int RecvBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+    struct pollfd ufd[1];
+
+    ufd[0].fd = sys->fd;
+    ufd[0].events = POLLIN;
+
+    switch (vlc_poll_i11e(ufd, 1, sys->timeout)) {
+        case 0:
+            msg_Err(access, "receive time-out");
+            *eof = true;
+            /* fall through */
+        case -1:
+            return -1;
+    }
+
+    struct mmsghdr msgs[BATCH_MAX];
+    struct iovec iov[BATCH_MAX];
+#ifdef SO_TIMESTAMPNS
+    union {
+        char buf[CMSG_SPACE(sizeof (struct timespec))];
+        struct cmsghdr align;
+    } control[BATCH_MAX];
+#endif
+    unsigned count = 0;
+
+    while (count < sys->batch) {
+        block_t *block = sys->spare[count];
+
+        if (block == NULL) {
+            block = block_Alloc(sys->mtu);
+            if (unlikely(block == NULL))
+                break;
+            sys->spare[count] = block;
+        }
+
+        iov[count].iov_base = block->p_buffer;
+        iov[count].iov_len = sys->mtu;
+        memset(&msgs[count], 0, sizeof (msgs[count]));
+        msgs[count].msg_hdr.msg_iov = &iov[count];
+        msgs[count].msg_hdr.msg_iovlen = 1;
+#ifdef SO_TIMESTAMPNS
+        if (sys->timestamps) {
+            msgs[count].msg_hdr.msg_control = control[count].buf;
+            msgs[count].msg_hdr.msg_controllen = sizeof (control[count].buf);
+        }
+#endif
+        count++;
+    }
+
+    if (unlikely(count == 0))
+        return -1;
+
+    int val = recvmmsg(sys->fd, msgs, count, MSG_DONTWAIT, NULL);
+    if (val <= 0)
+        return -1;
+
+#ifdef SO_TIMESTAMPNS
+    vlc_tick_t offset = 0;
+
+    if (sys->timestamps) {
+        /* Kernel time stamps are in wall clock time; convert them */
+        struct timespec now;
+
+        timespec_get(&now, TIME_UTC);
+        offset = vlc_tick_now() - vlc_tick_from_timespec(&now);
+    }
+#endif
+
+    size_t mtu = sys->mtu;
+
+    for (int i = 0; i < val; i++) {
+        block_t *block = sys->spare[i];
+        size_t len = msgs[i].msg_len;
+
+        block->i_buffer = len;
+
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+            msg_Err(access, "%zu bytes packet truncated (MTU was %zu)",
+                    len, sys->mtu);
+            block->i_flags |= BLOCK_FLAG_CORRUPTED;
+            if (mtu < MRU)
+                mtu = MRU;
+        }
+
+#ifdef SO_TIMESTAMPNS
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+             cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+            if (cmsg->cmsg_level == SOL_SOCKET
+             && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof (ts));
+                block->i_dts = vlc_tick_from_timespec(&ts) + offset;
+            }
+#endif
+        *sys->queue_last = block;
+        sys->queue_last = &block->p_next;
+    }
+
+    /* Shift the unused pre-allocated blocks down for the next batch */
+    memmove(sys->spare, sys->spare + val,
+            (BATCH_MAX - val) * sizeof (*sys->spare));
+    memset(sys->spare + (BATCH_MAX - val), 0, val * sizeof (*sys->spare));
+
+    if (mtu != sys->mtu) {
+        FlushSpare(sys);
+        sys->mtu = mtu;
+    }
+    return 0;
+}
+
+static block_t *BlockBatch(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    if (sys->queue == NULL && RecvBatch(access, eof))
+        return NULL;
+
+    block_t *block = sys->queue;
+
+    sys->queue = block->p_next;
+    if (sys->queue == NULL)
+        sys->queue_last = &sys->queue;
+    block->p_next = NULL;
+    return block;
+}
+#endif
+
+#ifdef __linux__
+static block_t *BlockRing(stream_t *access, bool *restrict eof)
+{
+    access_sys_t *sys = access->p_sys;
+
+    return UdpRingBlock(sys->ring, sys->timeout, eof);
+}
+#endif
+
 /*****************************************************************************
  * Open: open the socket
  *****************************************************************************/
@@ -206,17 +386,63 @@ static int Open( vlc_object_t *p_this )
 
     sys->fd = net_OpenDgram( p_access, psz_bind_addr, i_bind_port,
                              psz_server_addr, i_server_port, IPPROTO_UDP );
-    free( psz_name );
     if( sys->fd == -1 )
     {
         msg_Err( p_access, "cannot open socket" );
+        free( psz_name );
         return VLC_EGENERIC;
     }
 
+#ifdef __linux__
+    sys->ring = NULL;
+    if( var_InheritBool( p_access, "udp-ring" ) )
+    {
+        sys->ring = UdpRingJoin( p_access, sys->fd, psz_bind_addr,
+                                 i_bind_port, psz_server_addr );
+        if( sys->ring == NULL )
+            msg_Dbg( p_access, "not using the packet ring" );
+    }
+#endif
+    free( psz_name );
+
     sys->timeout = var_InheritInteger( p_access, "udp-timeout");
     if( sys->timeout > 0)
         sys->timeout *= 1000;
 
+#ifdef HAVE_RECVMMSG
+    int64_t batch = var_InheritInteger( p_access, "udp-batch" );
+    sys->batch = VLC_CLIP( batch, 0, BATCH_MAX );
+    sys->mtu = var_InheritInteger( p_access, "mtu" );
+    if( sys->mtu == 0 || sys->mtu > MRU )
+        sys->mtu = MRU;
+    sys->timestamps = var_InheritBool( p_access, "udp-timestamps" );
+    memset( sys->spare, 0, sizeof( sys->spare ) );
+    sys->queue = NULL;
+    sys->queue_last = &sys->queue;
+
+    if( sys->batch > 0 )
+    {
+#ifdef SO_TIMESTAMPNS
+        if( sys->timestamps
+         && setsockopt( sys->fd, SOL_SOCKET, SO_TIMESTAMPNS,
+                        &(int){ 1 }, sizeof (int) ) )
+            msg_Warn( p_access, "cannot enable kernel time stamps: %s",
+                      vlc_strerror_c( errno ) );
+#endif
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockBatch;
+        msg_Dbg( p_access, "receiving up to %u datagrams per call",
+                 sys->batch );
+    }
+#endif
+#ifdef __linux__
+    if( sys->ring != NULL )
+    {
+        p_access->pf_read = NULL;
+        p_access->pf_block = BlockRing;
+    }
+#endif
+
     return VLC_SUCCESS;
 }
 
@@ -228,10 +454,32 @@ static void Close( vlc_object_t *p_this )
     stream_t     *p_access = (stream_t*)p_this;
     access_sys_t *sys = p_access->p_sys;
 
+#ifdef HAVE_RECVMMSG
+    block_ChainRelease( sys->queue );
+    FlushSpare( sys );
+#endif
+#ifdef __linux__
+    if( sys->ring != NULL )
+        UdpRingLeave( sys->ring );
+#endif
     net_Close( sys->fd );
 }
 
 #define TIMEOUT_TEXT N_("UDP Source timeout (sec)")
+#define BATCH_TEXT N_("UDP receive batch size")
+#define BATCH_LONGTEXT N_( \
+    "Maximum number of datagrams fetched with a single system call. " \
+    "Each datagram is then delivered as a separate block. " \
+    "0 disables batching.")
+#define TIMESTAMPS_TEXT N_("Kernel receive time stamps")
+#define TIMESTAMPS_LONGTEXT N_( \
+    "Tag each received datagram with its kernel arrival time " \
+    "(only used in batched mode).")
+#define RING_TEXT N_("Shared packet ring")
+#define RING_LONGTEXT N_( \
+    "Receive IPv4 multicast datagrams of all UDP inputs through a single " \
+    "memory-mapped packet socket ring. This requires the CAP_NET_RAW " \
+    "capability; otherwise, regular sockets are used.")
 
 vlc_module_begin()
     set_shortname(N_("UDP"))
@@ -242,6 +490,15 @@ vlc_module_begin()
     add_obsolete_integer("server-port") /* since 2.0.0 */
     add_obsolete_integer("udp-buffer") /* since 3.0.0 */
     add_integer("udp-timeout", -1, TIMEOUT_TEXT, NULL, true)
+#ifdef HAVE_RECVMMSG
+    add_integer_with_range("udp-batch", 0, 0, BATCH_MAX,
+                           BATCH_TEXT, BATCH_LONGTEXT, true)
+    add_bool("udp-timestamps", false, TIMESTAMPS_TEXT, TIMESTAMPS_LONGTEXT,
+             true)
+#endif
+#ifdef __linux__
+    add_bool("udp-ring", false, RING_TEXT, RING_LONGTEXT, true)
+#endif
 
     set_capability("access", 0)
     add_shortcut("udp", "udpstream", "udp4", "udp6")
@@ -0,0 +1,55 @@
+/*****************************************************************************
+ * udp.h: UDP input internal interfaces
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef __linux__
+/**
+ * Shared packet ring.
+ *
+ * A single memory-mapped packet socket ring (PACKET_MMAP) receives the
+ * datagrams of all IPv4 multicast inputs of the process. A thread
+ * dispatches them to the subscribed inputs by destination group and port.
+ */
+struct udp_ring_sub;
+
+/**
+ * Subscribes to the datagrams of a multicast group.
+ *
+ * The group must already be joined by a regular UDP socket. The socket then
+ * only keeps the group membership: its own copies of datagrams are dropped.
+ *
+ * @param fd UDP socket joined to the group
+ * @param group IPv4 multicast group (numeric)
+ * @param port UDP destination port
+ * @param source IPv4 source address (numeric), or NULL for any source
+ * @return a subscription, or NULL on error (e.g. insufficient privileges)
+ */
+struct udp_ring_sub *UdpRingJoin(stream_t *, int fd, const char *group,
+                                 unsigned port, const char *source);
+void UdpRingLeave(struct udp_ring_sub *);
+
+/**
+ * Waits for and dequeues the next datagram.
+ *
+ * @param timeout time-out (milliseconds), or -1 for infinite
+ * @param eof set on time-out
+ * @return a datagram, or NULL on time-out or interruption
+ */
+block_t *UdpRingBlock(struct udp_ring_sub *, int timeout, bool *eof);
+#endif
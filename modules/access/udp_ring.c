@@ -0,0 +1,453 @@
+/*****************************************************************************
+ * udp_ring.c: shared packet ring for the UDP input
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_stream.h>
+#include <vlc_fs.h>
+#include <vlc_network.h>
+#include <vlc_interrupt.h>
+#include "udp.h"
+
+#define UDP_RING_BLOCK_SIZE (1 << 20)
+#define UDP_RING_BLOCKS     64
+#define UDP_RING_FRAME_SIZE 2048
+#define UDP_RING_BUCKETS    256
+/** Maximum queued payload per subscription, beyond which datagrams drop */
+#define UDP_RING_MAX_QUEUED (8 << 20)
+
+struct udp_ring;
+
+struct udp_ring_sub
+{
+    struct udp_ring_sub *next; /**< Next subscription in the same bucket */
+    struct udp_ring *ring;
+    stream_t *access;
+    uint32_t group; /**< Destination address (network byte order) */
+    uint32_t source; /**< Source address (network byte order) or INADDR_ANY */
+    uint16_t port; /**< Destination port (network byte order) */
+
+    /* Protected by the ring lock: */
+    block_t *queue;
+    block_t **queue_last;
+    size_t queued; /**< Queued payload bytes */
+    unsigned long dropped;
+    bool signaled; /**< Whether the pipe is readable */
+
+    int pipe[2];
+};
+
+struct udp_ring
+{
+    vlc_mutex_t lock;
+    unsigned refs; /**< Protected by udp_ring_lock */
+    int fd;
+    uint8_t *map;
+    vlc_thread_t thread;
+    struct udp_ring_sub *buckets[UDP_RING_BUCKETS];
+};
+
+static vlc_mutex_t udp_ring_lock = VLC_STATIC_MUTEX;
+static struct udp_ring *udp_ring = NULL;
+
+static unsigned UdpRingHash(uint32_t group, uint16_t port)
+{
+    uint32_t h = ntohl(group) ^ ntohs(port);
+
+    h ^= h >> 16;
+    return (h ^ (h >> 8)) % UDP_RING_BUCKETS;
+}
+
+static void UdpRingQueue(struct udp_ring_sub *sub, const uint8_t *data,
+                         size_t len)
+{
+    if (sub->queued + len > UDP_RING_MAX_QUEUED)
+    {
+        sub->dropped++;
+        return;
+    }
+
+    block_t *block = block_Alloc(len);
+    if (unlikely(block == NULL))
+    {
+        sub->dropped++;
+        return;
+    }
+
+    memcpy(block->p_buffer, data, len);
+    *sub->queue_last = block;
+    sub->queue_last = &block->p_next;
+    sub->queued += len;
+
+    if (!sub->signaled)
+    {
+        sub->signaled = true;
+        if (write(sub->pipe[1], &(char){ 0 }, 1) < 0)
+            sub->signaled = false;
+    }
+}
+
+/**
+ * Dispatches one IPv4 datagram to the matching subscriptions.
+ */
+static void UdpRingPacket(struct udp_ring *ring, const uint8_t *ip, size_t len)
+{
+    if (len < 20 || (ip[0] >> 4) != 4)
+        return;
+
+    size_t ihl = (ip[0] & 0xf) * 4;
+    if (ihl < 20 || len < ihl + 8 || ip[9] != IPPROTO_UDP)
+        return;
+    if (GetWBE(ip + 6) & 0x3fff)
+        return; /* fragment */
+
+    uint32_t src, dst;
+    uint16_t port;
+    const uint8_t *udp = ip + ihl;
+    size_t ulen = GetWBE(udp + 4);
+
+    memcpy(&src, ip + 12, 4);
+    memcpy(&dst, ip + 16, 4);
+    memcpy(&port, udp + 2, 2);
+
+    if (ulen < 8 || ulen > len - ihl)
+        return; /* truncated */
+
+    for (struct udp_ring_sub *sub = ring->buckets[UdpRingHash(dst, port)];
+         sub != NULL; sub = sub->next)
+        if (sub->group == dst && sub->port == port
+         && (sub->source == htonl(INADDR_ANY) || sub->source == src))
+            UdpRingQueue(sub, udp + 8, ulen - 8);
+}
+
+static void UdpRingDispatch(struct udp_ring *ring,
+                            const struct tpacket_block_desc *bd)
+{
+    const uint8_t *pkt = (const uint8_t *)bd + bd->hdr.bh1.offset_to_first_pkt;
+
+    vlc_mutex_lock(&ring->lock);
+    for (uint32_t n = bd->hdr.bh1.num_pkts; n > 0; n--)
+    {
+        const struct tpacket3_hdr *h = (const void *)pkt;
+        const struct sockaddr_ll *sll =
+            (const void *)(pkt + TPACKET_ALIGN(sizeof (*h)));
+
+        if (sll->sll_pkttype != PACKET_OUTGOING)
+            UdpRingPacket(ring, pkt + h->tp_mac, h->tp_snaplen);
+        pkt += h->tp_next_offset;
+    }
+    vlc_mutex_unlock(&ring->lock);
+}
+
+static void *UdpRingThread(void *data)
+{
+    struct udp_ring *ring = data;
+    struct pollfd ufd = { .fd = ring->fd, .events = POLLIN | POLLERR };
+
+    for (unsigned i = 0;; i = (i + 1) % UDP_RING_BLOCKS)
+    {
+        struct tpacket_block_desc *bd =
+            (void *)(ring->map + i * UDP_RING_BLOCK_SIZE);
+        volatile uint32_t *status = &bd->hdr.bh1.block_status;
+
+        while (!(*status & TP_STATUS_USER))
+            poll(&ufd, 1, -1);
+        atomic_thread_fence(memory_order_acquire);
+
+        int canc = vlc_savecancel();
+        UdpRingDispatch(ring, bd);
+        vlc_restorecancel(canc);
+
+        /* Give the block back to the kernel */
+        atomic_thread_fence(memory_order_release);
+        *status = TP_STATUS_KERNEL;
+    }
+    vlc_assert_unreachable();
+}
+
+static struct udp_ring *UdpRingCreate(vlc_object_t *obj)
+{
+    struct udp_ring *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->fd = vlc_socket(PF_PACKET, SOCK_DGRAM, htons(ETH_P_IP), false);
+    if (ring->fd == -1)
+    {
+        msg_Warn(obj, "cannot create packet socket: %s",
+                 vlc_strerror_c(errno));
+        free(ring);
+        return NULL;
+    }
+
+    /* Only keep unfragmented UDP datagrams to IPv4 multicast groups */
+    static const struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9), /* protocol */
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6), /* flags & fragment offset */
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x3fff, 4, 0),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 16), /* destination */
+        BPF_STMT(BPF_ALU | BPF_AND | BPF_K, 0xf0000000),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0xe0000000, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xffff),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    const struct sock_fprog prog = {
+        .len = ARRAY_SIZE(code),
+        .filter = (struct sock_filter *)code,
+    };
+    struct tpacket_req3 req = {
+        .tp_block_size = UDP_RING_BLOCK_SIZE,
+        .tp_block_nr = UDP_RING_BLOCKS,
+        .tp_frame_size = UDP_RING_FRAME_SIZE,
+        .tp_frame_nr = (UDP_RING_BLOCK_SIZE / UDP_RING_FRAME_SIZE)
+                       * UDP_RING_BLOCKS,
+        .tp_retire_blk_tov = 10, /* ms */
+    };
+    struct sockaddr_ll addr = {
+        .sll_family = AF_PACKET,
+        .sll_protocol = htons(ETH_P_IP),
+        .sll_ifindex = 0, /* all interfaces */
+    };
+
+    if (setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION,
+                   &(int){ TPACKET_V3 }, sizeof (int))
+     || setsockopt(ring->fd, SOL_SOCKET, SO_ATTACH_FILTER,
+                   &prog, sizeof (prog))
+     || setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof (req)))
+    {
+        msg_Warn(obj, "cannot set up packet ring: %s", vlc_strerror_c(errno));
+        goto error;
+    }
+
+    ring->map = mmap(NULL, UDP_RING_BLOCK_SIZE * UDP_RING_BLOCKS,
+                     PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->map == MAP_FAILED)
+    {
+        msg_Warn(obj, "cannot map packet ring: %s", vlc_strerror_c(errno));
+        goto error;
+    }
+
+    if (bind(ring->fd, (struct sockaddr *)&addr, sizeof (addr)))
+    {
+        msg_Warn(obj, "cannot bind packet socket: %s", vlc_strerror_c(errno));
+        goto error_map;
+    }
+
+    vlc_mutex_init(&ring->lock);
+    ring->refs = 0;
+    memset(ring->buckets, 0, sizeof (ring->buckets));
+
+    if (vlc_clone(&ring->thread, UdpRingThread, ring,
+                  VLC_THREAD_PRIORITY_INPUT))
+        goto error_map;
+
+    msg_Dbg(obj, "receiving multicast through a %u KiB packet ring",
+            (UDP_RING_BLOCK_SIZE * UDP_RING_BLOCKS) >> 10);
+    return ring;
+
+error_map:
+    munmap(ring->map, UDP_RING_BLOCK_SIZE * UDP_RING_BLOCKS);
+error:
+    vlc_close(ring->fd);
+    free(ring);
+    return NULL;
+}
+
+static void UdpRingDestroy(struct udp_ring *ring)
+{
+    vlc_cancel(ring->thread);
+    vlc_join(ring->thread, NULL);
+    munmap(ring->map, UDP_RING_BLOCK_SIZE * UDP_RING_BLOCKS);
+    vlc_close(ring->fd);
+    free(ring);
+}
+
+struct udp_ring_sub *UdpRingJoin(stream_t *access, int fd, const char *group,
+                                 unsigned port, const char *source)
+{
+    struct in_addr grp, src = { .s_addr = htonl(INADDR_ANY) };
+
+    if (inet_pton(AF_INET, group, &grp) != 1
+     || !IN_MULTICAST(ntohl(grp.s_addr)) || port == 0 || port > 65535)
+        return NULL;
+    if (source != NULL && source[0] != '\0'
+     && inet_pton(AF_INET, source, &src) != 1)
+        return NULL;
+
+    struct udp_ring_sub *sub = malloc(sizeof (*sub));
+    if (unlikely(sub == NULL))
+        return NULL;
+
+    if (vlc_pipe(sub->pipe))
+    {
+        free(sub);
+        return NULL;
+    }
+    fcntl(sub->pipe[1], F_SETFL, fcntl(sub->pipe[1], F_GETFL) | O_NONBLOCK);
+
+    sub->access = access;
+    sub->group = grp.s_addr;
+    sub->source = src.s_addr;
+    sub->port = htons(port);
+    sub->queue = NULL;
+    sub->queue_last = &sub->queue;
+    sub->queued = 0;
+    sub->dropped = 0;
+    sub->signaled = false;
+
+    vlc_mutex_lock(&udp_ring_lock);
+    struct udp_ring *ring = udp_ring;
+    if (ring == NULL)
+    {
+        ring = UdpRingCreate(VLC_OBJECT(access));
+        if (ring == NULL)
+        {
+            vlc_mutex_unlock(&udp_ring_lock);
+            vlc_close(sub->pipe[1]);
+            vlc_close(sub->pipe[0]);
+            free(sub);
+            return NULL;
+        }
+        udp_ring = ring;
+    }
+    ring->refs++;
+    sub->ring = ring;
+
+    unsigned h = UdpRingHash(sub->group, sub->port);
+
+    vlc_mutex_lock(&ring->lock);
+    sub->next = ring->buckets[h];
+    ring->buckets[h] = sub;
+    vlc_mutex_unlock(&ring->lock);
+    vlc_mutex_unlock(&udp_ring_lock);
+
+    /* The socket only keeps the group membership: drop its own copies. */
+    static const struct sock_filter drop[] = {
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    const struct sock_fprog prog = {
+        .len = ARRAY_SIZE(drop),
+        .filter = (struct sock_filter *)drop,
+    };
+
+    if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof (prog)))
+        msg_Warn(access, "cannot filter out socket datagrams: %s",
+                 vlc_strerror_c(errno));
+    return sub;
+}
+
+void UdpRingLeave(struct udp_ring_sub *sub)
+{
+    struct udp_ring *ring = sub->ring;
+    struct udp_ring_sub **pp = &ring->buckets[UdpRingHash(sub->group,
+                                                          sub->port)];
+    bool last;
+
+    vlc_mutex_lock(&udp_ring_lock);
+    vlc_mutex_lock(&ring->lock);
+    while (*pp != sub)
+        pp = &(*pp)->next;
+    *pp = sub->next;
+    vlc_mutex_unlock(&ring->lock);
+
+    assert(ring->refs > 0);
+    last = --ring->refs == 0;
+    if (last)
+        udp_ring = NULL;
+    vlc_mutex_unlock(&udp_ring_lock);
+
+    if (last)
+        UdpRingDestroy(ring);
+
+    block_ChainRelease(sub->queue);
+    vlc_close(sub->pipe[1]);
+    vlc_close(sub->pipe[0]);
+    free(sub);
+}
+
+block_t *UdpRingBlock(struct udp_ring_sub *sub, int timeout, bool *eof)
+{
+    struct udp_ring *ring = sub->ring;
+
+    for (;;)
+    {
+        block_t *block;
+        unsigned long dropped;
+
+        vlc_mutex_lock(&ring->lock);
+        block = sub->queue;
+        if (block != NULL)
+        {
+            sub->queue = block->p_next;
+            if (sub->queue == NULL)
+                sub->queue_last = &sub->queue;
+            sub->queued -= block->i_buffer;
+            block->p_next = NULL;
+        }
+        else if (sub->signaled)
+        {   /* Empty queue: consume the wake-up, wait for the next one */
+            char c;
+
+            if (read(sub->pipe[0], &c, 1) == 1)
+                sub->signaled = false;
+        }
+        dropped = sub->dropped;
+        sub->dropped = 0;
+        vlc_mutex_unlock(&ring->lock);
+
+        if (dropped > 0)
+            msg_Warn(sub->access, "%lu datagram(s) dropped", dropped);
+        if (block != NULL)
+            return block;
+
+        struct pollfd ufd = { .fd = sub->pipe[0], .events = POLLIN };
+
+        switch (vlc_poll_i11e(&ufd, 1, timeout))
+        {
+            case 0:
+                msg_Err(sub->access, "receive time-out");
+                *eof = true;
+                /* fall through */
+            case -1:
+                return NULL;
+        }
+    }
+}
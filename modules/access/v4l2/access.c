@@ -46,7 +46,7 @@ typedef struct
         uint32_t bufc;
         uint32_t blocksize;
     };
-    struct buffer_t *bufv;
+    struct vlc_v4l2_buffers *bufv;
     vlc_v4l2_ctrl_t *controls;
 } access_sys_t;
 
@@ -191,7 +191,7 @@ void AccessClose( vlc_object_t *obj )
     access_sys_t *sys = access->p_sys;
 
     if (sys->bufv != NULL)
-        StopMmap (sys->fd, sys->bufv, sys->bufc);
+        StopMmap (sys->bufv);
     ControlsDeinit(vlc_object_parent(obj), sys->controls);
     v4l2_close (sys->fd);
     free( sys );
@@ -217,7 +217,7 @@ static block_t *MMapBlock (stream_t *access, bool *restrict eof)
     if (AccessPoll (access))
         return NULL;
 
-    block_t *block = GrabVideo (VLC_OBJECT(access), sys->fd, sys->bufv);
+    block_t *block = GrabVideo (VLC_OBJECT(access), sys->bufv);
     if( block != NULL )
     {
         block->i_pts = block->i_dts = vlc_tick_now();
@@ -577,12 +577,69 @@ vlc_tick_t GetBufferPTS (const struct v4l2_buffer *buf)
     return pts;
 }
 
+struct vlc_v4l2_buffer
+{
+    block_t block;
+    struct vlc_v4l2_buffers *pool;
+    void *start;
+    size_t length;
+    uint32_t index;
+};
+
+struct vlc_v4l2_buffers
+{
+    vlc_mutex_t lock;
+    int fd; /**< device, or -1 once streaming is stopped */
+    bool zero_copy;
+    uint32_t lent; /**< buffers held by blocks */
+    uint32_t count;
+    struct vlc_v4l2_buffer bufv[];
+};
+
+static void ReleaseMmap (struct vlc_v4l2_buffers *pool)
+{
+    for (uint32_t i = 0; i < pool->count; i++)
+        v4l2_munmap (pool->bufv[i].start, pool->bufv[i].length);
+    free (pool);
+}
+
+static void MmapBlockRelease (block_t *block)
+{
+    struct vlc_v4l2_buffer *vb = container_of(block, struct vlc_v4l2_buffer,
+                                              block);
+    struct vlc_v4l2_buffers *pool = vb->pool;
+    bool last;
+
+    vlc_mutex_lock (&pool->lock);
+    if (pool->fd != -1)
+    {   /* Give the buffer back to the driver */
+        struct v4l2_buffer buf = {
+            .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+            .memory = V4L2_MEMORY_MMAP,
+            .index = vb->index,
+        };
+
+        v4l2_ioctl (pool->fd, VIDIOC_QBUF, &buf);
+    }
+    assert(pool->lent > 0);
+    pool->lent--;
+    last = pool->fd == -1 && pool->lent == 0;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (last)
+        ReleaseMmap (pool);
+}
+
+static const struct vlc_block_callbacks MmapBlockCallbacks = {
+    MmapBlockRelease,
+};
+
 /*****************************************************************************
  * GrabVideo: Grab a video frame
  *****************************************************************************/
-block_t *GrabVideo (vlc_object_t *demux, int fd,
-                    const struct buffer_t *restrict bufv)
+block_t *GrabVideo (vlc_object_t *demux, struct vlc_v4l2_buffers *pool)
 {
+    int fd = pool->fd;
     struct v4l2_buffer buf = {
         .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
         .memory = V4L2_MEMORY_MMAP,
@@ -604,18 +661,38 @@ block_t *GrabVideo (vlc_object_t *demux, int fd,
         }
     }
 
+    struct vlc_v4l2_buffer *vb = &pool->bufv[buf.index];
+    block_t *block;
+
+    /* Lend the buffer itself, as long as the driver keeps enough buffers to
+     * capture the next frames. Otherwise, fall back to copying. */
+    vlc_mutex_lock (&pool->lock);
+    if (pool->zero_copy && pool->lent + 2 < pool->count)
+    {
+        pool->lent++;
+        vlc_mutex_unlock (&pool->lock);
+
+        block = block_Init (&vb->block, &MmapBlockCallbacks, vb->start,
+                            buf.bytesused);
+        block->i_pts = block->i_dts = GetBufferPTS (&buf);
+        return block;
+    }
+    vlc_mutex_unlock (&pool->lock);
+
     /* Copy frame */
-    block_t *block = block_Alloc (buf.bytesused);
-    if (unlikely(block == NULL))
-        return NULL;
-    block->i_pts = block->i_dts = GetBufferPTS (&buf);
-    memcpy (block->p_buffer, bufv[buf.index].start, buf.bytesused);
+    block = block_Alloc (buf.bytesused);
+    if (likely(block != NULL))
+    {
+        block->i_pts = block->i_dts = GetBufferPTS (&buf);
+        memcpy (block->p_buffer, vb->start, buf.bytesused);
+    }
 
     /* Unlock */
     if (v4l2_ioctl (fd, VIDIOC_QBUF, &buf) < 0)
     {
         msg_Err (demux, "queue error: %s", vlc_strerror_c(errno));
-        block_Release (block);
+        if (block != NULL)
+            block_Release (block);
         return NULL;
     }
     return block;
@@ -648,10 +725,17 @@ int StartUserPtr (vlc_object_t *obj, int fd)
 
 /**
  * Allocates memory-mapped buffers, queues them and start streaming.
+ *
+ * Captured frames are handed out without copying, in blocks that wrap the
+ * memory-mapped buffers, and that give the buffers back to the driver when
+ * released. The buffers remain mapped until the last such block is released,
+ * even after StopMmap().
+ *
  * @param n requested buffers count [IN], allocated buffers count [OUT]
- * @return array of allocated buffers (use free()), or NULL on error.
+ * @return buffers pool (use StopMmap()), or NULL on error.
  */
-struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
+struct vlc_v4l2_buffers *StartMmap (vlc_object_t *obj, int fd,
+                                    uint32_t *restrict n)
 {
     struct v4l2_requestbuffers req = {
         .count = *n,
@@ -671,41 +755,52 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         return NULL;
     }
 
-    struct buffer_t *bufv = vlc_alloc (req.count, sizeof (*bufv));
-    if (unlikely(bufv == NULL))
+    struct vlc_v4l2_buffers *pool = malloc (sizeof (*pool)
+                                    + req.count * sizeof (pool->bufv[0]));
+    if (unlikely(pool == NULL))
         return NULL;
 
-    uint32_t bufc = 0;
-    while (bufc < req.count)
+    vlc_mutex_init (&pool->lock);
+    pool->fd = fd;
+    /* With libv4l2, the mappings may be emulated and tied to the device.
+     * They cannot outlive it, nor be shared safely with other threads. */
+    pool->zero_copy = v4l2_mmap == mmap;
+    pool->lent = 0;
+    pool->count = 0;
+
+    while (pool->count < req.count)
     {
+        struct vlc_v4l2_buffer *vb = &pool->bufv[pool->count];
         struct v4l2_buffer buf = {
             .type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
             .memory = V4L2_MEMORY_MMAP,
-            .index = bufc,
+            .index = pool->count,
         };
 
         if (v4l2_ioctl (fd, VIDIOC_QUERYBUF, &buf) < 0)
         {
-            msg_Err (obj, "cannot query buffer %"PRIu32": %s", bufc,
+            msg_Err (obj, "cannot query buffer %"PRIu32": %s", pool->count,
                      vlc_strerror_c(errno));
             goto error;
         }
 
-        bufv[bufc].start = v4l2_mmap (NULL, buf.length, PROT_READ | PROT_WRITE,
-                                      MAP_SHARED, fd, buf.m.offset);
-        if (bufv[bufc].start == MAP_FAILED)
+        vb->start = v4l2_mmap (NULL, buf.length, PROT_READ | PROT_WRITE,
+                               MAP_SHARED, fd, buf.m.offset);
+        if (vb->start == MAP_FAILED)
         {
-            msg_Err (obj, "cannot map buffer %"PRIu32": %s", bufc,
+            msg_Err (obj, "cannot map buffer %"PRIu32": %s", pool->count,
                      vlc_strerror_c(errno));
             goto error;
         }
-        bufv[bufc].length = buf.length;
-        bufc++;
+        vb->pool = pool;
+        vb->length = buf.length;
+        vb->index = pool->count;
+        pool->count++;
 
         /* Some drivers refuse to queue buffers before they are mapped. Bug? */
         if (v4l2_ioctl (fd, VIDIOC_QBUF, &buf) < 0)
         {
-            msg_Err (obj, "cannot queue buffer %"PRIu32": %s", bufc,
+            msg_Err (obj, "cannot queue buffer %"PRIu32": %s", pool->count,
                      vlc_strerror_c(errno));
             goto error;
         }
@@ -717,20 +812,33 @@ struct buffer_t *StartMmap (vlc_object_t *obj, int fd, uint32_t *restrict n)
         msg_Err (obj, "cannot start streaming: %s", vlc_strerror_c(errno));
         goto error;
     }
-    *n = bufc;
-    return bufv;
+    if (!pool->zero_copy)
+        msg_Dbg (obj, "copying frames out of emulated buffers");
+    *n = pool->count;
+    return pool;
 error:
-    StopMmap (fd, bufv, bufc);
+    StopMmap (pool);
     return NULL;
 }
 
-void StopMmap (int fd, struct buffer_t *bufv, uint32_t bufc)
+/**
+ * Stops streaming.
+ *
+ * The device must not be closed before this function returns, but it can be
+ * closed immediately afterwards, even if some captured blocks are still alive.
+ */
+void StopMmap (struct vlc_v4l2_buffers *pool)
 {
     enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    bool last;
 
+    vlc_mutex_lock (&pool->lock);
     /* STREAMOFF implicitly dequeues all buffers */
-    v4l2_ioctl (fd, VIDIOC_STREAMOFF, &type);
-    for (uint32_t i = 0; i < bufc; i++)
-        v4l2_munmap (bufv[i].start, bufv[i].length);
-    free (bufv);
+    v4l2_ioctl (pool->fd, VIDIOC_STREAMOFF, &type);
+    pool->fd = -1;
+    last = pool->lent == 0;
+    vlc_mutex_unlock (&pool->lock);
+
+    if (last)
+        ReleaseMmap (pool);
 }
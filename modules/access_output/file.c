@@ -48,6 +48,7 @@
 #include <vlc_network.h>
 #include <vlc_strings.h>
 #include <vlc_dialog.h>
+#include <vlc_tick.h>
 
 #ifndef O_LARGEFILE
 #   define O_LARGEFILE 0
@@ -58,14 +59,299 @@
 
 #define SOUT_CFG_PREFIX "sout-file-"
 
+#define WRITER_CHUNKS 4
+#define WRITER_ALIGN  4096
+
+/* Asynchronous writer: the data is gathered into a few large aligned chunks
+ * and written by a dedicated thread, so that the muxer does not stall on the
+ * disk latency as long as one chunk remains free. */
+typedef struct
+{
+    int             fd;
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;      /* signaled to the I/O thread */
+    vlc_cond_t      done;      /* signaled by the I/O thread */
+
+    uint8_t        *chunks[WRITER_CHUNKS];
+    size_t          lengths[WRITER_CHUNKS];
+    size_t          i_chunk;   /* size of each chunk */
+    unsigned        i_first;   /* oldest queued chunk */
+    unsigned        i_queued;  /* chunk being filled is i_first + i_queued */
+    bool            b_closing;
+    int             i_error;   /* errno of the first failed write */
+
+    bool            b_direct;
+    off_t           i_offset;  /* written by the I/O thread */
+    off_t           i_alloc;   /* preallocated up to there */
+    off_t           i_prealloc;
+
+    /* backpressure statistics */
+    unsigned        i_stalls;
+    vlc_tick_t      i_stall_time;
+    vlc_tick_t      i_stall_max;
+    unsigned        i_queued_max;
+    uint64_t        i_written;
+} file_writer_t;
+
+typedef struct
+{
+    int             fd;
+    file_writer_t  *writer; /* NULL when writing synchronously */
+} sout_access_out_sys_t;
+
+static void WriterNoDirect(file_writer_t *w)
+{
+#ifdef O_DIRECT
+    fcntl(w->fd, F_SETFL, fcntl(w->fd, F_GETFL) & ~O_DIRECT);
+#endif
+    w->b_direct = false;
+}
+
+static ssize_t WriterFullWrite(file_writer_t *w, const uint8_t *p, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len)
+    {
+        ssize_t val = write(w->fd, p + done, len - done);
+        if (val < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno == EINVAL && w->b_direct)
+            {   /* unaligned offset or length, give up O_DIRECT */
+                WriterNoDirect(w);
+                continue;
+            }
+            return -1;
+        }
+        done += val;
+    }
+    return done;
+}
+
+static void *WriterThread(void *data)
+{
+    file_writer_t *w = data;
+
+    vlc_mutex_lock(&w->lock);
+    for (;;)
+    {
+        while (w->i_queued == 0 && !w->b_closing)
+            vlc_cond_wait(&w->wait, &w->lock);
+        if (w->i_queued == 0)
+            break;
+
+        unsigned i = w->i_first;
+        size_t len = w->lengths[i];
+        vlc_mutex_unlock(&w->lock);
+
+#if defined(FALLOC_FL_KEEP_SIZE)
+        if (w->i_prealloc > 0 && w->i_offset + (off_t)len > w->i_alloc)
+        {   /* keep the file extents contiguous ahead of the writes */
+            if (fallocate(w->fd, FALLOC_FL_KEEP_SIZE, w->i_alloc,
+                          w->i_prealloc) == 0)
+                w->i_alloc += w->i_prealloc;
+            else
+                w->i_prealloc = 0;
+        }
+#endif
+        if (w->b_direct && (len % WRITER_ALIGN))
+            WriterNoDirect(w); /* last partial chunk */
+
+        ssize_t val = WriterFullWrite(w, w->chunks[i], len);
+        int err = errno;
+
+        vlc_mutex_lock(&w->lock);
+        if (val < 0)
+        {
+            if (w->i_error == 0)
+                w->i_error = err;
+        }
+        else
+        {
+            w->i_offset += val;
+            w->i_written += val;
+        }
+        w->lengths[i] = 0;
+        w->i_first = (i + 1) % WRITER_CHUNKS;
+        w->i_queued--;
+        vlc_cond_signal(&w->done);
+    }
+    vlc_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+/* Queues the chunk being filled, waiting for a free one if needed. */
+static void WriterPush(file_writer_t *w)
+{
+    vlc_mutex_lock(&w->lock);
+    if (w->i_queued >= WRITER_CHUNKS - 1)
+    {
+        vlc_tick_t start = vlc_tick_now();
+
+        while (w->i_queued >= WRITER_CHUNKS - 1)
+            vlc_cond_wait(&w->done, &w->lock);
+
+        vlc_tick_t wait = vlc_tick_now() - start;
+        w->i_stalls++;
+        w->i_stall_time += wait;
+        if (wait > w->i_stall_max)
+            w->i_stall_max = wait;
+    }
+    w->i_queued++;
+    if (w->i_queued > w->i_queued_max)
+        w->i_queued_max = w->i_queued;
+    vlc_cond_signal(&w->wait);
+    vlc_mutex_unlock(&w->lock);
+}
+
+/* Writes out everything buffered and waits for the I/O thread to be idle,
+ * so that the file descriptor can be used directly. */
+static int WriterDrain(file_writer_t *w)
+{
+    vlc_mutex_lock(&w->lock);
+    unsigned cur = (w->i_first + w->i_queued) % WRITER_CHUNKS;
+    vlc_mutex_unlock(&w->lock);
+
+    if (w->lengths[cur] > 0)
+        WriterPush(w);
+
+    vlc_mutex_lock(&w->lock);
+    while (w->i_queued > 0)
+        vlc_cond_wait(&w->done, &w->lock);
+    int err = w->i_error;
+    vlc_mutex_unlock(&w->lock);
+    return err;
+}
+
+static ssize_t WriteAsync(sout_access_out_t *p_access, block_t *p_buffer)
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    file_writer_t *w = p_sys->writer;
+    size_t i_write = 0;
+
+    vlc_mutex_lock(&w->lock);
+    int err = w->i_error;
+    /* the chunk being filled is never touched by the I/O thread */
+    unsigned cur = (w->i_first + w->i_queued) % WRITER_CHUNKS;
+    vlc_mutex_unlock(&w->lock);
+
+    if (err)
+    {
+        block_ChainRelease(p_buffer);
+        msg_Err(p_access, "cannot write: %s", vlc_strerror_c(err));
+        return -1;
+    }
+
+    while (p_buffer != NULL)
+    {
+        size_t copy = __MIN(p_buffer->i_buffer, w->i_chunk - w->lengths[cur]);
+
+        memcpy(w->chunks[cur] + w->lengths[cur], p_buffer->p_buffer, copy);
+        w->lengths[cur] += copy;
+        p_buffer->p_buffer += copy;
+        p_buffer->i_buffer -= copy;
+        i_write += copy;
+
+        if (w->lengths[cur] == w->i_chunk)
+        {
+            WriterPush(w);
+            cur = (cur + 1) % WRITER_CHUNKS;
+        }
+
+        if (p_buffer->i_buffer == 0)
+        {
+            block_t *p_next = p_buffer->p_next;
+            block_Release(p_buffer);
+            p_buffer = p_next;
+        }
+    }
+    return i_write;
+}
+
+static file_writer_t *WriterNew(sout_access_out_t *p_access, int fd,
+                                size_t size, bool direct, off_t prealloc)
+{
+    file_writer_t *w = calloc(1, sizeof (*w));
+    if (unlikely(w == NULL))
+        return NULL;
+
+    w->fd = fd;
+    w->i_chunk = (size / WRITER_CHUNKS + WRITER_ALIGN - 1)
+               & ~(size_t)(WRITER_ALIGN - 1);
+    for (unsigned i = 0; i < WRITER_CHUNKS; i++)
+    {
+        w->chunks[i] = aligned_alloc(WRITER_ALIGN, w->i_chunk);
+        if (unlikely(w->chunks[i] == NULL))
+            goto error;
+    }
+
+    w->b_direct = direct;
+    w->i_offset = lseek(fd, 0, SEEK_CUR);
+    if (w->i_offset < 0)
+        w->i_offset = 0;
+    w->i_alloc = w->i_offset;
+    w->i_prealloc = prealloc;
+    vlc_mutex_init(&w->lock);
+    vlc_cond_init(&w->wait);
+    vlc_cond_init(&w->done);
+
+    if (vlc_clone(&w->thread, WriterThread, w, VLC_THREAD_PRIORITY_OUTPUT))
+    {
+        msg_Err(p_access, "cannot spawn file writer thread");
+        goto error;
+    }
+    msg_Dbg(p_access, "asynchronous writing with %u chunks of %zu bytes%s",
+            WRITER_CHUNKS, w->i_chunk, direct ? ", direct I/O" : "");
+    return w;
+
+error:
+    for (unsigned i = 0; i < WRITER_CHUNKS; i++)
+        aligned_free(w->chunks[i]);
+    free(w);
+    return NULL;
+}
+
+static void WriterDelete(sout_access_out_t *p_access, file_writer_t *w)
+{
+    int err = WriterDrain(w);
+    if (err)
+        msg_Err(p_access, "cannot write: %s", vlc_strerror_c(err));
+
+    vlc_mutex_lock(&w->lock);
+    w->b_closing = true;
+    vlc_cond_signal(&w->wait);
+    vlc_mutex_unlock(&w->lock);
+    vlc_join(w->thread, NULL);
+
+    msg_Dbg(p_access, "wrote %"PRIu64" bytes, up to %u/%u chunks queued, "
+            "%u stalls for %"PRId64" ms (longest %"PRId64" ms)", w->i_written,
+            w->i_queued_max, WRITER_CHUNKS - 1, w->i_stalls,
+            MS_FROM_VLC_TICK(w->i_stall_time),
+            MS_FROM_VLC_TICK(w->i_stall_max));
+    if (w->i_stall_max >= VLC_TICK_FROM_MS(100))
+        msg_Warn(p_access, "output stalled %u times on the disk, "
+                 "consider a larger buffer", w->i_stalls);
+
+    for (unsigned i = 0; i < WRITER_CHUNKS; i++)
+        aligned_free(w->chunks[i]);
+    free(w);
+}
+
 /*****************************************************************************
  * Read: standard read on a file descriptor.
  *****************************************************************************/
 static ssize_t Read( sout_access_out_t *p_access, block_t *p_buffer )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
     ssize_t val;
 
+    if (p_sys->writer != NULL && WriterDrain(p_sys->writer))
+        return -1;
+
     do
         val = read(fd, p_buffer->p_buffer, p_buffer->i_buffer);
     while (val == -1 && errno == EINTR);
@@ -77,7 +363,8 @@ static ssize_t Read( sout_access_out_t *p_access, block_t *p_buffer )
  *****************************************************************************/
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
     size_t i_write = 0;
 
     while( p_buffer )
@@ -110,7 +397,8 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 
 static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 {
-    int *fdp = access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *sys = access->p_sys;
+    int fd = sys->fd;
     ssize_t total = 0;
 
     while (block != NULL)
@@ -149,7 +437,8 @@ static ssize_t WritePipe(sout_access_out_t *access, block_t *block)
 #ifdef S_ISSOCK
 static ssize_t Send(sout_access_out_t *access, block_t *block)
 {
-    int *fdp = access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *sys = access->p_sys;
+    int fd = sys->fd;
     size_t total = 0;
 
     while (block != NULL)
@@ -188,8 +477,19 @@ static ssize_t Send(sout_access_out_t *access, block_t *block)
  *****************************************************************************/
 static int Seek( sout_access_out_t *p_access, off_t i_pos )
 {
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int fd = p_sys->fd;
+    file_writer_t *w = p_sys->writer;
 
+    if (w != NULL)
+    {
+        if (WriterDrain(w))
+            return -1;
+        /* the I/O thread is idle until the next chunk is queued */
+        if (w->b_direct && (i_pos % WRITER_ALIGN))
+            WriterNoDirect(w);
+        w->i_offset = i_pos;
+    }
     return lseek(fd, i_pos, SEEK_SET);
 }
 
@@ -219,8 +519,13 @@ static int Control( sout_access_out_t *p_access, int i_query, va_list args )
 
 static const char *const ppsz_sout_options[] = {
     "append",
+    "buffer",
+#ifdef O_DIRECT
+    "direct",
+#endif
     "format",
     "overwrite",
+    "prealloc",
 #ifdef O_SYNC
     "sync",
 #endif
@@ -234,15 +539,17 @@ static int Open( vlc_object_t *p_this )
 {
     sout_access_out_t   *p_access = (sout_access_out_t*)p_this;
     int fd;
-    int *fdp = vlc_obj_malloc(p_this, sizeof (*fdp));
+    sout_access_out_sys_t *p_sys = vlc_obj_malloc(p_this, sizeof (*p_sys));
 
-    if (unlikely(fdp == NULL))
+    if (unlikely(p_sys == NULL))
         return VLC_ENOMEM;
 
     config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
 
     bool overwrite = var_GetBool (p_access, SOUT_CFG_PREFIX"overwrite");
     bool append = var_GetBool( p_access, SOUT_CFG_PREFIX "append" );
+    int64_t i_buffer = var_GetInteger( p_access, SOUT_CFG_PREFIX "buffer" );
+    bool direct = false;
 
     if (!strcmp (p_access->psz_access, "fd"))
     {
@@ -297,6 +604,15 @@ static int Open( vlc_object_t *p_this )
 #ifdef O_SYNC
         if (var_GetBool (p_access, SOUT_CFG_PREFIX"sync"))
             flags |= O_SYNC;
+#endif
+#ifdef O_DIRECT
+        /* appended data starts at an unaligned offset */
+        if (i_buffer > 0 && !append
+         && var_GetBool (p_access, SOUT_CFG_PREFIX"direct"))
+        {
+            flags |= O_DIRECT;
+            direct = true;
+        }
 #endif
         do
         {
@@ -321,8 +637,9 @@ static int Open( vlc_object_t *p_this )
             return VLC_EGENERIC;
     }
 
-    *fdp = fd;
-    p_access->p_sys = fdp;
+    p_sys->fd = fd;
+    p_sys->writer = NULL;
+    p_access->p_sys = p_sys;
 
     struct stat st;
 
@@ -335,10 +652,28 @@ static int Open( vlc_object_t *p_this )
 
     p_access->pf_read  = Read;
 
+    if (append)
+        lseek (fd, 0, SEEK_END);
+
     if (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode))
     {
         p_access->pf_write = Write;
         p_access->pf_seek  = Seek;
+
+        if (i_buffer > 0)
+        {
+            int64_t prealloc = var_GetInteger (p_access,
+                                               SOUT_CFG_PREFIX"prealloc");
+
+            p_sys->writer = WriterNew (p_access, fd, i_buffer * 1024, direct,
+                                       __MAX(prealloc, 0) * 1024 * 1024);
+            if (p_sys->writer == NULL)
+            {
+                vlc_close (fd);
+                return VLC_EGENERIC;
+            }
+            p_access->pf_write = WriteAsync;
+        }
     }
 #ifdef S_ISSOCK
     else if (S_ISSOCK(st.st_mode))
@@ -354,10 +689,12 @@ static int Open( vlc_object_t *p_this )
     }
     p_access->pf_control = Control;
 
-    msg_Dbg( p_access, "file access output opened (%s)", p_access->psz_path );
-    if (append)
-        lseek (fd, 0, SEEK_END);
+#ifdef O_DIRECT
+    if (direct && p_sys->writer == NULL)
+        fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_DIRECT);
+#endif
 
+    msg_Dbg( p_access, "file access output opened (%s)", p_access->psz_path );
     return VLC_SUCCESS;
 }
 
@@ -367,9 +704,11 @@ static int Open( vlc_object_t *p_this )
 static void Close( vlc_object_t * p_this )
 {
     sout_access_out_t *p_access = (sout_access_out_t*)p_this;
-    int *fdp = p_access->p_sys, fd = *fdp;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    vlc_close(fd);
+    if (p_sys->writer != NULL)
+        WriterDelete(p_access, p_sys->writer);
+    vlc_close(p_sys->fd);
     msg_Dbg( p_access, "file access output closed" );
 }
 
@@ -384,6 +723,17 @@ static void Close( vlc_object_t * p_this )
     "on the file path")
 #define SYNC_TEXT N_("Synchronous writing")
 #define SYNC_LONGTEXT N_( "Open the file with synchronous writing.")
+#define BUFFER_TEXT N_("Write buffer size (KiB)")
+#define BUFFER_LONGTEXT N_( "Gather the output into large writes done " \
+    "by a separate thread, so that slow storage does not stall the " \
+    "stream output. 0 writes synchronously.")
+#define DIRECT_TEXT N_("Direct I/O")
+#define DIRECT_LONGTEXT N_( "Bypass the operating system page cache when " \
+    "writing with a buffer.")
+#define PREALLOC_TEXT N_("Preallocation step (MiB)")
+#define PREALLOC_LONGTEXT N_( "Reserve the disk space of the file by steps " \
+    "of this size when writing with a buffer, to limit fragmentation. " \
+    "0 disables preallocation.")
 
 vlc_module_begin ()
     set_description( N_("File stream output") )
@@ -402,5 +752,15 @@ vlc_module_begin ()
     add_bool( SOUT_CFG_PREFIX "sync", false, SYNC_TEXT,SYNC_LONGTEXT,
               false )
 #endif
+    add_integer( SOUT_CFG_PREFIX "buffer", 0, BUFFER_TEXT, BUFFER_LONGTEXT,
+                 true )
+        change_integer_range( 0, 1024 * 1024 )
+#ifdef O_DIRECT
+    add_bool( SOUT_CFG_PREFIX "direct", false, DIRECT_TEXT, DIRECT_LONGTEXT,
+              true )
+#endif
+    add_integer( SOUT_CFG_PREFIX "prealloc", 0, PREALLOC_TEXT,
+                 PREALLOC_LONGTEXT, true )
+        change_integer_range( 0, 1024 * 1024 )
     set_callbacks( Open, Close )
 vlc_module_end ()
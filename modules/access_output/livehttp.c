@@ -43,6 +43,8 @@
 #include <vlc_fs.h>
 #include <vlc_strings.h>
 #include <vlc_charset.h>
+#include <vlc_httpd.h>
+#include <vlc_memstream.h>
 
 #include <gcrypt.h>
 #include <vlc_gcrypt.h>
@@ -102,6 +104,12 @@ static void Close( vlc_object_t * );
 #define RANDOMIV_TEXT N_("Use randomized IV for encryption")
 #define RANDOMIV_LONGTEXT N_("Generate IV instead using segment-number as IV")
 
+#define HTTP_TEXT N_("Serve over HTTP")
+#define HTTP_LONGTEXT N_("Keep the segments in memory and serve them and the "\
+                         "index with the HTTP server (see http-host and "\
+                         "http-port) instead of writing files. The path and "\
+                         "the index are then the URLs they are served at.")
+
 #define INTITIAL_SEG_TEXT N_("Number of first segment")
 #define INITIAL_SEG_LONGTEXT N_("The number of the first segment generated")
 
@@ -125,6 +133,8 @@ vlc_module_begin ()
               NOCACHE_TEXT, NOCACHE_LONGTEXT, true )
     add_bool( SOUT_CFG_PREFIX "generate-iv", false,
               RANDOMIV_TEXT, RANDOMIV_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "http", false,
+              HTTP_TEXT, HTTP_LONGTEXT, true )
     add_string( SOUT_CFG_PREFIX "index", NULL,
                 INDEX_TEXT, INDEX_LONGTEXT, false )
     add_string( SOUT_CFG_PREFIX "index-url", NULL,
@@ -156,6 +166,7 @@ static const char *const ppsz_sout_options[] = {
     "key-loadfile",
     "generate-iv",
     "initial-segment-number",
+    "http",
     NULL
 };
 
@@ -171,6 +182,7 @@ typedef struct output_segment
     vlc_tick_t segment_length;
     uint32_t i_segment_number;
     uint8_t aes_ivs[16];
+    httpd_stream_t *p_stream;
 } output_segment_t;
 
 typedef struct
@@ -202,6 +214,15 @@ typedef struct
     uint8_t stuffing_bytes[16];
     ssize_t stuffing_size;
     vlc_array_t segments_t;
+
+    /* in memory segments served over HTTP */
+    bool b_http;
+    httpd_host_t *p_httpd_host;
+    httpd_file_t *p_httpd_file;
+    httpd_stream_t *p_curstream;
+    vlc_mutex_t index_lock;
+    char *psz_index;
+    size_t i_index;
 } sout_access_out_sys_t;
 
 static int LoadCryptFile( sout_access_out_t *p_access);
@@ -209,6 +230,8 @@ static int CryptSetup( sout_access_out_t *p_access, char *keyfile );
 static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer );
 static ssize_t writeSegment( sout_access_out_t *p_access );
 static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys );
+static int HttpSetup( sout_access_out_t *p_access );
+static char *httpPath( char *psz_path );
 /*****************************************************************************
  * Open: open the file
  *****************************************************************************/
@@ -246,8 +269,17 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_ratecontrol = var_GetBool( p_access, SOUT_CFG_PREFIX "ratecontrol") ;
     p_sys->b_caching = var_GetBool( p_access, SOUT_CFG_PREFIX "caching") ;
     p_sys->b_generate_iv = var_GetBool( p_access, SOUT_CFG_PREFIX "generate-iv") ;
+    p_sys->b_http = var_GetBool( p_access, SOUT_CFG_PREFIX "http") ;
     p_sys->b_segment_has_data = false;
 
+    if( p_sys->b_http )
+    {
+        /* nothing else would ever release the segments */
+        p_sys->b_delsegs = true;
+        if( p_sys->i_numsegs == 0 )
+            p_sys->i_numsegs = 5;
+    }
+
     vlc_array_init( &p_sys->segments_t );
 
     p_sys->stuffing_size = 0;
@@ -264,10 +296,25 @@ static int Open( vlc_object_t *p_this )
             free( p_sys );
             return VLC_ENOMEM;
         }
+        if( p_sys->b_http )
+        {
+            psz_tmp = httpPath( psz_tmp );
+            if( !psz_tmp )
+            {
+                free( p_sys );
+                return VLC_ENOMEM;
+            }
+        }
         p_sys->psz_indexPath = psz_tmp;
-        if( p_sys->i_initial_segment != 1 )
+        if( p_sys->i_initial_segment != 1 && !p_sys->b_http )
             vlc_unlink( p_sys->psz_indexPath );
     }
+    else if( p_sys->b_http )
+    {
+        msg_Err( p_access, "no index URL specified" );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
 
     p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
     p_sys->psz_keyfile  = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "key-loadfile" );
@@ -292,6 +339,21 @@ static int Open( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
+    if( p_sys->b_http && HttpSetup( p_access ) != VLC_SUCCESS )
+    {
+        msg_Err( p_access, "cannot serve the index at %s",
+                 p_sys->psz_indexPath );
+        if( p_sys->key_uri )
+        {
+            gcry_cipher_close( p_sys->aes_ctx );
+            free( p_sys->key_uri );
+        }
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_indexPath );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
     p_sys->i_handle = -1;
     p_sys->i_segment = p_sys->i_initial_segment-1;
     p_sys->psz_cursegPath = NULL;
@@ -469,6 +531,76 @@ static int CryptKey( sout_access_out_t *p_access, uint32_t i_segment )
 }
 
 
+/************************************************************************
+ * IndexCallback: Serve the last published index
+ ************************************************************************/
+static int IndexCallback( httpd_file_sys_t *p_args, httpd_file_t *f,
+                          uint8_t *p_request, uint8_t **pp_data, int *pi_data )
+{
+    VLC_UNUSED(f); VLC_UNUSED(p_request);
+    sout_access_out_sys_t *p_sys = (sout_access_out_sys_t *)p_args;
+
+    vlc_mutex_lock( &p_sys->index_lock );
+    *pp_data = NULL;
+    *pi_data = 0;
+    if( p_sys->psz_index )
+    {
+        *pp_data = malloc( p_sys->i_index );
+        if( *pp_data )
+        {
+            memcpy( *pp_data, p_sys->psz_index, p_sys->i_index );
+            *pi_data = p_sys->i_index;
+        }
+    }
+    vlc_mutex_unlock( &p_sys->index_lock );
+
+    return VLC_SUCCESS;
+}
+
+/************************************************************************
+ * HttpSetup: Start serving the index, segments are added as they open
+ ************************************************************************/
+static int HttpSetup( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    vlc_mutex_init( &p_sys->index_lock );
+    p_sys->psz_index = NULL;
+    p_sys->i_index = 0;
+    p_sys->p_curstream = NULL;
+
+    p_sys->p_httpd_host = vlc_http_HostNew( VLC_OBJECT(p_access) );
+    if( !p_sys->p_httpd_host )
+        return VLC_EGENERIC;
+
+    p_sys->p_httpd_file = httpd_FileNew( p_sys->p_httpd_host,
+                                         p_sys->psz_indexPath,
+                                         "application/vnd.apple.mpegurl",
+                                         NULL, NULL, IndexCallback,
+                                         (httpd_file_sys_t *)p_sys );
+    if( !p_sys->p_httpd_file )
+    {
+        httpd_HostDelete( p_sys->p_httpd_host );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/************************************************************************
+ * httpPath: Make an absolute URL path out of a path
+ ************************************************************************/
+static char *httpPath( char *psz_path )
+{
+    char *psz_url;
+
+    if( psz_path == NULL || psz_path[0] == '/' )
+        return psz_path;
+    if( asprintf( &psz_url, "/%s", psz_path ) < 0 )
+        psz_url = NULL;
+    free( psz_path );
+    return psz_url;
+}
+
 #define SEG_NUMBER_PLACEHOLDER "#"
 /*****************************************************************************
  * formatSegmentPath: create segment path name based on seg #
@@ -501,6 +633,8 @@ static char *formatSegmentPath( char *psz_path, uint32_t i_seg )
 
 static void destroySegment( output_segment_t *segment )
 {
+    if( segment->p_stream )
+        httpd_StreamDelete( segment->p_stream );
     free( segment->psz_filename );
     free( segment->psz_duration );
     free( segment->psz_uri );
@@ -550,6 +684,70 @@ static bool isFirstItemRemovable( sout_access_out_sys_t *p_sys, uint32_t i_first
     return duration >= (first->segment_length + (p_sys->i_numsegs * p_sys->segment_max_length));
 }
 
+/************************************************************************
+ * writeIndex: Replace the index file by the new one
+ ************************************************************************/
+static int writeIndex( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                       char *psz_index, size_t i_index )
+{
+    int val;
+    FILE *fp;
+    char *psz_idxTmp;
+    if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
+    {
+        free( psz_index );
+        return -1;
+    }
+
+    fp = vlc_fopen( psz_idxTmp, "wt");
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
+        free( psz_idxTmp );
+        free( psz_index );
+        return -1;
+    }
+
+    val = fwrite( psz_index, 1, i_index, fp ) == i_index ? 0 : -1;
+    free( psz_index );
+    if ( fclose( fp ) )
+        val = -1;
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        free( psz_idxTmp );
+        return -1;
+    }
+
+    val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
+
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_idxTmp );
+        msg_Err( p_access, "Error moving LiveHttp index file" );
+    }
+    else
+        msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+
+    free( psz_idxTmp );
+    return 0;
+}
+
+/************************************************************************
+ * publishIndex: Serve the new index from now on
+ ************************************************************************/
+static void publishIndex( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys,
+                          char *psz_index, size_t i_index )
+{
+    vlc_mutex_lock( &p_sys->index_lock );
+    free( p_sys->psz_index );
+    p_sys->psz_index = psz_index;
+    p_sys->i_index = i_index;
+    vlc_mutex_unlock( &p_sys->index_lock );
+
+    msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+}
+
 /************************************************************************
  * updateIndexAndDel: If necessary, update index file & delete old segments
  ************************************************************************/
@@ -574,33 +772,17 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     // First update index
     if ( p_sys->psz_indexPath )
     {
-        int val;
-        FILE *fp;
-        char *psz_idxTmp;
-        if ( asprintf( &psz_idxTmp, "%s.tmp", p_sys->psz_indexPath ) < 0)
-            return -1;
-
-        fp = vlc_fopen( psz_idxTmp, "wt");
-        if ( !fp )
-        {
-            msg_Err( p_access, "cannot open index file `%s'", psz_idxTmp );
-            free( psz_idxTmp );
+        struct vlc_memstream ms;
+        if ( vlc_memstream_open( &ms ) )
             return -1;
-        }
 
-        if ( fprintf( fp, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
+        vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-TARGETDURATION:%.0f\n#EXT-X-VERSION:3\n#EXT-X-ALLOW-CACHE:%s"
                           "%s\n#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n%s", ceil(secf_from_vlc_tick( p_sys->segment_max_length )) ,
                           p_sys->b_caching ? "YES" : "NO",
                           p_sys->i_numsegs > 0 ? "" : b_isend ? "\n#EXT-X-PLAYLIST-TYPE:VOD" : "\n#EXT-X-PLAYLIST-TYPE:EVENT",
                           i_firstseg, ((p_sys->i_initial_segment > 1) && (p_sys->i_initial_segment == i_firstseg)) ? "#EXT-X-DISCONTINUITY\n" : ""
-                          ) < 0 )
-        {
-            free( psz_idxTmp );
-            fclose( fp );
-            return -1;
-        }
-        char *psz_current_uri=NULL;
-
+                          );
+        const char *psz_current_uri = NULL;
 
         for ( uint32_t i = i_firstseg; i <= p_sys->i_segment; i++ )
         {
@@ -612,9 +794,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                 ( !psz_current_uri ||  strcmp( psz_current_uri, segment->psz_key_uri ) )
               )
             {
-                int ret = 0;
-                free( psz_current_uri );
-                psz_current_uri = strdup( segment->psz_key_uri );
+                psz_current_uri = segment->psz_key_uri;
                 if( p_sys->b_generate_iv )
                 {
                     unsigned long long iv_hi = segment->aes_ivs[0];
@@ -626,55 +806,27 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
                         iv_lo <<= 8;
                         iv_lo |= segment->aes_ivs[8+j] & 0xff;
                     }
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
-                                   segment->psz_key_uri, iv_hi, iv_lo );
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\",IV=0X%16.16llx%16.16llx\n",
+                                          segment->psz_key_uri, iv_hi, iv_lo );
 
                 } else {
-                    ret = fprintf( fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
-                }
-                if( ret < 0 )
-                {
-                    free( psz_current_uri );
-                    free( psz_idxTmp );
-                    fclose( fp );
-                    return -1;
+                    vlc_memstream_printf( &ms, "#EXT-X-KEY:METHOD=AES-128,URI=\"%s\"\n", segment->psz_key_uri );
                 }
             }
 
-            val = fprintf( fp, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
-            if ( val < 0 )
-            {
-                free( psz_current_uri );
-                free( psz_idxTmp );
-                fclose( fp );
-                return -1;
-            }
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n", segment->psz_duration, segment->psz_uri);
         }
-        free( psz_current_uri );
 
         if ( b_isend )
-        {
-            if ( fputs ( STR_ENDLIST, fp ) < 0)
-            {
-                free( psz_idxTmp );
-                fclose( fp ) ;
-                return -1;
-            }
+            vlc_memstream_puts( &ms, STR_ENDLIST );
 
-        }
-        fclose( fp );
-
-        val = vlc_rename ( psz_idxTmp, p_sys->psz_indexPath);
-
-        if ( val < 0 )
-        {
-            vlc_unlink( psz_idxTmp );
-            msg_Err( p_access, "Error moving LiveHttp index file" );
-        }
-        else
-            msg_Dbg( p_access, "LiveHttpIndexComplete: %s" , p_sys->psz_indexPath );
+        if ( vlc_memstream_close( &ms ) )
+            return -1;
 
-        free( psz_idxTmp );
+        if ( p_sys->b_http )
+            publishIndex( p_access, p_sys, ms.ptr, ms.length );
+        else if ( writeIndex( p_access, p_sys, ms.ptr, ms.length ) )
+            return -1;
     }
 
     // Then take care of deletion
@@ -687,7 +839,7 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
          msg_Dbg( p_access, "Removing segment number %d", segment->i_segment_number );
          vlc_array_remove( &p_sys->segments_t, 0 );
 
-         if ( segment->psz_filename )
+         if ( segment->psz_filename && !p_sys->b_http )
          {
              vlc_unlink( segment->psz_filename );
          }
@@ -700,12 +852,34 @@ static int updateIndexAndDel( sout_access_out_t *p_access, sout_access_out_sys_t
     return 0;
 }
 
+static bool isSegmentOpen( const sout_access_out_sys_t *p_sys )
+{
+    return p_sys->i_handle >= 0 || p_sys->p_curstream != NULL;
+}
+
+/*****************************************************************************
+ * writeBlock: Write to the segment file, or to the segment HTTP stream
+ *****************************************************************************/
+static ssize_t writeBlock( sout_access_out_sys_t *p_sys, const block_t *p_block )
+{
+    if( p_sys->p_curstream )
+    {
+        if( httpd_StreamSend( p_sys->p_curstream, p_block ) != VLC_SUCCESS )
+        {
+            errno = ENOMEM;
+            return -1;
+        }
+        return p_block->i_buffer;
+    }
+    return vlc_write( p_sys->i_handle, p_block->p_buffer, p_block->i_buffer );
+}
+
 /*****************************************************************************
  * closeCurrentSegment: Close the segment file
  *****************************************************************************/
 static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sys_t *p_sys, bool b_isend )
 {
-    if ( p_sys->i_handle >= 0 )
+    if ( isSegmentOpen( p_sys ) )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, vlc_array_count( &p_sys->segments_t ) - 1 );
 
@@ -719,7 +893,14 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
                msg_Err( p_access, "Couldn't encrypt 16 bytes: %s", gpg_strerror(err) );
             } else {
 
-            int ret = vlc_write( p_sys->i_handle, p_sys->stuffing_bytes, 16 );
+            block_t *p_stuffing = block_Alloc( 16 );
+            ssize_t ret = -1;
+            if( p_stuffing )
+            {
+                memcpy( p_stuffing->p_buffer, p_sys->stuffing_bytes, 16 );
+                ret = writeBlock( p_sys, p_stuffing );
+                block_Release( p_stuffing );
+            }
             if( ret != 16 )
                 msg_Err( p_access, "Couldn't write 16 bytes" );
             }
@@ -727,8 +908,17 @@ static void closeCurrentSegment( sout_access_out_t *p_access, sout_access_out_sy
         }
 
 
-        vlc_close( p_sys->i_handle );
-        p_sys->i_handle = -1;
+        if( p_sys->p_curstream )
+        {
+            /* the clients of the segment can now tell it is complete */
+            httpd_StreamEnd( p_sys->p_curstream );
+            p_sys->p_curstream = NULL;
+        }
+        else
+        {
+            vlc_close( p_sys->i_handle );
+            p_sys->i_handle = -1;
+        }
 
         if( ! ( us_asprintf( &segment->psz_duration, "%.2f", secf_from_vlc_tick( p_sys->current_segment_length )) ) )
         {
@@ -803,7 +993,8 @@ static void Close( vlc_object_t * p_this )
     {
         output_segment_t *segment = vlc_array_item_at_index( &p_sys->segments_t, 0 );
         vlc_array_remove( &p_sys->segments_t, 0 );
-        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename
+         && !p_sys->b_http )
         {
             msg_Dbg( p_access, "Removing segment number %d name %s", segment->i_segment_number, segment->psz_filename );
             vlc_unlink( segment->psz_filename );
@@ -812,6 +1003,13 @@ static void Close( vlc_object_t * p_this )
         destroySegment( segment );
     }
 
+    if( p_sys->b_http )
+    {
+        httpd_FileDelete( p_sys->p_httpd_file );
+        httpd_HostDelete( p_sys->p_httpd_host );
+        free( p_sys->psz_index );
+    }
+
     free( p_sys->psz_indexUrl );
     free( p_sys->psz_indexPath );
     free( p_sys );
@@ -855,8 +1053,12 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
 
     segment->i_segment_number = i_newseg;
     segment->psz_filename = formatSegmentPath( p_access->psz_path, i_newseg );
+    if( p_sys->b_http )
+        segment->psz_filename = httpPath( segment->psz_filename );
     char *psz_idxFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl : p_access->psz_path;
     segment->psz_uri = formatSegmentPath( psz_idxFormat , i_newseg );
+    if( p_sys->b_http && !p_sys->psz_indexUrl )
+        segment->psz_uri = httpPath( segment->psz_uri );
 
     if ( unlikely( !segment->psz_filename ) )
     {
@@ -865,8 +1067,23 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
         return -1;
     }
 
-    fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
-                     O_TRUNC, 0666 );
+    if ( p_sys->b_http )
+    {
+        /* served as it is written, and kept whole until deleted */
+        segment->p_stream = httpd_StreamNewReplay( p_sys->p_httpd_host,
+                                                   segment->psz_filename,
+                                                   NULL, NULL, NULL );
+        if ( !segment->p_stream )
+        {
+            msg_Err( p_access, "cannot serve `%s'", segment->psz_filename );
+            destroySegment( segment );
+            return -1;
+        }
+        fd = 0;
+    }
+    else
+        fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                         O_TRUNC, 0666 );
     if ( fd == -1 )
     {
         msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
@@ -892,7 +1109,10 @@ static ssize_t openNextFile( sout_access_out_t *p_access, sout_access_out_sys_t
     msg_Dbg( p_access, "Successfully opened livehttp file: %s (%"PRIu32")" , segment->psz_filename, i_newseg );
 
     p_sys->psz_cursegPath = strdup(segment->psz_filename);
-    p_sys->i_handle = fd;
+    if ( p_sys->b_http )
+        p_sys->p_curstream = segment->p_stream;
+    else
+        p_sys->i_handle = fd;
     p_sys->i_segment = i_newseg;
     p_sys->b_segment_has_data = false;
     return fd;
@@ -911,7 +1131,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
     block_ChainProperties( p_sys->full_segments, NULL, NULL, &current_length );
     block_ChainProperties( p_sys->ongoing_segment, NULL, NULL, &ongoing_length );
 
-    if( p_sys->i_handle > 0 &&
+    if( isSegmentOpen( p_sys ) &&
        (( p_buffer->i_length + current_length + ongoing_length ) >= p_sys->segment_max_length ) )
     {
         writevalue = writeSegment( p_access );
@@ -924,7 +1144,7 @@ static int CheckSegmentChange( sout_access_out_t *p_access, block_t *p_buffer )
         return writevalue;
     }
 
-    if ( unlikely( p_sys->i_handle < 0 ) )
+    if ( unlikely( !isSegmentOpen( p_sys ) ) )
     {
         if ( openNextFile( p_access, p_sys ) < 0 )
            return -1;
@@ -980,7 +1200,7 @@ static ssize_t writeSegment( sout_access_out_t *p_access )
 
         }
 
-        ssize_t val = vlc_write( p_sys->i_handle, output->p_buffer, output->i_buffer );
+        ssize_t val = writeBlock( p_sys, output );
         if ( val == -1 )
         {
            if ( errno == EINTR )
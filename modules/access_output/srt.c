@@ -31,12 +31,35 @@
 #include <vlc_block.h>
 #include <vlc_network.h>
 
+#define SRT_PARAM_LISTEN "srt-listen"
+/* Pending connections of callers, in listener mode */
+#define SRT_LISTEN_BACKLOG 10
+#define SRT_STATS_PERIOD VLC_TICK_FROM_SEC(10)
+
+typedef struct
+{
+    SRTSOCKET     sock;
+    unsigned      i_dropped; /* chunks not sent, the send buffer was full */
+    char          psz_addr[NI_MAXNUMERICHOST];
+} srt_caller_t;
+
 typedef struct
 {
     SRTSOCKET     sock;
     int           i_poll_id;
     bool          b_interrupted;
     vlc_mutex_t   lock;
+
+    /* data short of a full chunk, sent with the next one */
+    size_t        i_chunk_size;
+    block_t      *p_pending;
+
+    /* listener mode: sock is the listener, the data goes to all callers */
+    bool          b_listener;
+    int           i_callers;
+    srt_caller_t **pp_callers;
+
+    vlc_tick_t    i_stats_date;
 } sout_access_out_sys_t;
 
 static void srt_wait_interrupted(void *p_data)
@@ -58,35 +81,15 @@ static void srt_wait_interrupted(void *p_data)
     vlc_mutex_unlock( &p_sys->lock );
 }
 
-static bool srt_schedule_reconnect(sout_access_out_t *p_access)
+/* Splits the access path in address and port, the address must be freed */
+static char *srt_parse_dst( sout_access_out_t *p_access, int *pi_port )
 {
-    vlc_object_t *access_obj = (vlc_object_t *) p_access;
-    int stat;
-    char *psz_dst_addr = NULL;
-    int i_dst_port;
-    int i_latency=var_InheritInteger( p_access, SRT_PARAM_LATENCY );
-    int i_payload_size = var_InheritInteger( p_access, SRT_PARAM_PAYLOAD_SIZE );
-    char *psz_passphrase = var_InheritString( p_access, SRT_PARAM_PASSPHRASE );
-    bool passphrase_needs_free = true;
-    int i_max_bandwidth_limit =
-    var_InheritInteger( p_access, SRT_PARAM_BANDWIDTH_OVERHEAD_LIMIT );
-    char *url = NULL;
-    srt_params_t params;
-    struct addrinfo hints = {
-        .ai_socktype = SOCK_DGRAM,
-    }, *res = NULL;
-
-    sout_access_out_sys_t *p_sys = p_access->p_sys;
-    bool failed = false;
-
-    i_dst_port = SRT_DEFAULT_PORT;
-    char *psz_parser = psz_dst_addr = strdup( p_access->psz_path );
+    *pi_port = SRT_DEFAULT_PORT;
+    char *psz_parser, *psz_dst_addr = strdup( p_access->psz_path );
     if( !psz_dst_addr )
-    {
-        failed = true;
-        goto out;
-    }
+        return NULL;
 
+    psz_parser = psz_dst_addr;
     if ( psz_parser[0] == '[' )
         psz_parser = strchr( psz_parser, ']' );
 
@@ -94,35 +97,24 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
     if ( psz_parser != NULL )
     {
         *psz_parser++ = '\0';
-        i_dst_port = atoi( psz_parser );
-    }
-
-    stat = vlc_getaddrinfo( psz_dst_addr, i_dst_port, &hints, &res );
-    if ( stat )
-    {
-        msg_Err( p_access, "Cannot resolve [%s]:%d (reason: %s)",
-                 psz_dst_addr,
-                 i_dst_port,
-                 gai_strerror( stat ) );
-
-        failed = true;
-        goto out;
-    }
-
-    /* Always start with a fresh socket */
-    if ( p_sys->sock != SRT_INVALID_SOCK )
-    {
-        srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
-        srt_close( p_sys->sock );
+        *pi_port = atoi( psz_parser );
     }
+    return psz_dst_addr;
+}
 
-    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
-    if ( p_sys->sock == SRT_INVALID_SOCK )
-    {
-        msg_Err( p_access, "Failed to open socket." );
-        failed = true;
-        goto out;
-    }
+/* Sets the sender options on a new (caller or listener) socket */
+static void srt_configure( sout_access_out_t *p_access, SRTSOCKET sock,
+                           const char *psz_dst_addr )
+{
+    vlc_object_t *access_obj = (vlc_object_t *) p_access;
+    int i_latency=var_InheritInteger( p_access, SRT_PARAM_LATENCY );
+    int i_payload_size = var_InheritInteger( p_access, SRT_PARAM_PAYLOAD_SIZE );
+    char *psz_passphrase = var_InheritString( p_access, SRT_PARAM_PASSPHRASE );
+    bool passphrase_needs_free = true;
+    int i_max_bandwidth_limit =
+    var_InheritInteger( p_access, SRT_PARAM_BANDWIDTH_OVERHEAD_LIMIT );
+    char *url = NULL;
+    srt_params_t params;
 
     if (psz_dst_addr) {
         url = strdup( psz_dst_addr );
@@ -140,44 +132,97 @@ static bool srt_schedule_reconnect(sout_access_out_t *p_access)
     }
 
     /* Make SRT non-blocking */
-    srt_setsockopt( p_sys->sock, 0, SRTO_SNDSYN,
+    srt_setsockopt( sock, 0, SRTO_SNDSYN,
         &(bool) { false }, sizeof( bool ) );
-    srt_setsockopt( p_sys->sock, 0, SRTO_RCVSYN,
+    srt_setsockopt( sock, 0, SRTO_RCVSYN,
         &(bool) { false }, sizeof( bool ) );
 
     /* Make sure TSBPD mode is enable (SRT mode) */
-    srt_setsockopt( p_sys->sock, 0, SRTO_TSBPDMODE,
+    srt_setsockopt( sock, 0, SRTO_TSBPDMODE,
         &(int) { 1 }, sizeof( int ) );
 
     /* This is an access_out so it is always a sender */
-    srt_setsockopt( p_sys->sock, 0, SRTO_SENDER,
+    srt_setsockopt( sock, 0, SRTO_SENDER,
         &(int) { 1 }, sizeof( int ) );
 
     /* Set latency */
-    srt_set_socket_option( access_obj, SRT_PARAM_LATENCY, p_sys->sock,
+    srt_set_socket_option( access_obj, SRT_PARAM_LATENCY, sock,
             SRTO_TSBPDDELAY, &i_latency, sizeof(i_latency) );
 
     /* set passphrase */
     if (psz_passphrase != NULL && psz_passphrase[0] != '\0') {
         int i_key_length = var_InheritInteger( access_obj, SRT_PARAM_KEY_LENGTH );
 
-        srt_set_socket_option( access_obj, SRT_PARAM_KEY_LENGTH, p_sys->sock,
+        srt_set_socket_option( access_obj, SRT_PARAM_KEY_LENGTH, sock,
                 SRTO_PBKEYLEN, &i_key_length, sizeof(i_key_length) );
 
-        srt_set_socket_option( access_obj, SRT_PARAM_PASSPHRASE, p_sys->sock,
+        srt_set_socket_option( access_obj, SRT_PARAM_PASSPHRASE, sock,
                 SRTO_PASSPHRASE, psz_passphrase, strlen(psz_passphrase) );
     }
 
     /* set maximumu payload size */
-    srt_set_socket_option( access_obj, SRT_PARAM_PAYLOAD_SIZE, p_sys->sock,
+    srt_set_socket_option( access_obj, SRT_PARAM_PAYLOAD_SIZE, sock,
             SRTO_PAYLOADSIZE, &i_payload_size, sizeof(i_payload_size) );
 
     /* set maximum bandwidth limit*/
     srt_set_socket_option( access_obj, SRT_PARAM_BANDWIDTH_OVERHEAD_LIMIT,
-            p_sys->sock, SRTO_OHEADBW, &i_max_bandwidth_limit,
+            sock, SRTO_OHEADBW, &i_max_bandwidth_limit,
             sizeof(i_max_bandwidth_limit) );
 
-    srt_setsockopt( p_sys->sock, 0, SRTO_SENDER, &(int) { 1 }, sizeof(int) );
+    srt_setsockopt( sock, 0, SRTO_SENDER, &(int) { 1 }, sizeof(int) );
+
+    if (passphrase_needs_free)
+        free( psz_passphrase );
+    free( url );
+}
+
+static bool srt_schedule_reconnect(sout_access_out_t *p_access)
+{
+    int stat;
+    char *psz_dst_addr = NULL;
+    int i_dst_port;
+    struct addrinfo hints = {
+        .ai_socktype = SOCK_DGRAM,
+    }, *res = NULL;
+
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    bool failed = false;
+
+    psz_dst_addr = srt_parse_dst( p_access, &i_dst_port );
+    if( !psz_dst_addr )
+    {
+        failed = true;
+        goto out;
+    }
+
+    stat = vlc_getaddrinfo( psz_dst_addr, i_dst_port, &hints, &res );
+    if ( stat )
+    {
+        msg_Err( p_access, "Cannot resolve [%s]:%d (reason: %s)",
+                 psz_dst_addr,
+                 i_dst_port,
+                 gai_strerror( stat ) );
+
+        failed = true;
+        goto out;
+    }
+
+    /* Always start with a fresh socket */
+    if ( p_sys->sock != SRT_INVALID_SOCK )
+    {
+        srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
+        srt_close( p_sys->sock );
+    }
+
+    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+    if ( p_sys->sock == SRT_INVALID_SOCK )
+    {
+        msg_Err( p_access, "Failed to open socket." );
+        failed = true;
+        goto out;
+    }
+
+    srt_configure( p_access, p_sys->sock, psz_dst_addr );
 
     srt_epoll_add_usock( p_sys->i_poll_id, p_sys->sock,
         &(int) { SRT_EPOLL_ERR | SRT_EPOLL_OUT });
@@ -202,23 +247,263 @@ out:
         p_sys->sock = SRT_INVALID_SOCK;
     }
 
-    if (passphrase_needs_free)
-        free( psz_passphrase );
     free( psz_dst_addr );
-    free( url );
     freeaddrinfo( res );
 
     return !failed;
 }
 
+/* Regroups the data in chunks of the chunk size, in a single block. What is
+ * left is kept for the next call, so that only full packets are sent. */
+static block_t *srt_pack( sout_access_out_sys_t *p_sys, block_t *p_buffer )
+{
+    if ( p_sys->p_pending )
+    {
+        p_sys->p_pending->p_next = p_buffer;
+        p_buffer = p_sys->p_pending;
+        p_sys->p_pending = NULL;
+    }
+    if ( !p_buffer )
+        return NULL;
+
+    p_buffer = block_ChainGather( p_buffer );
+    if ( unlikely(!p_buffer) )
+        return NULL;
+
+    size_t i_left = p_buffer->i_buffer % p_sys->i_chunk_size;
+    if ( i_left == p_buffer->i_buffer )
+    {
+        p_sys->p_pending = p_buffer;
+        return NULL;
+    }
+
+    if ( i_left > 0 )
+    {
+        p_buffer->i_buffer -= i_left;
+        p_sys->p_pending = block_Alloc( i_left );
+        if ( likely(p_sys->p_pending) )
+            memcpy( p_sys->p_pending->p_buffer,
+                    p_buffer->p_buffer + p_buffer->i_buffer, i_left );
+    }
+    return p_buffer;
+}
+
+static void srt_log_stats( sout_access_out_t *p_access, SRTSOCKET sock,
+                           const char *psz_peer, unsigned i_dropped )
+{
+    SRT_TRACEBSTATS stats;
+
+    /* the interval counters are cleared for the next period */
+    if ( srt_bstats( sock, &stats, 1 ) == SRT_ERROR )
+        return;
+
+    msg_Dbg( p_access, "%s: %.2f Mb/s, RTT %.1f ms, %d retransmitted, "
+             "%d dropped (%u with a full send buffer), send buffer %d "
+             "packets (%d ms)", psz_peer, stats.mbpsSendRate, stats.msRTT,
+             stats.pktRetrans, stats.pktSndDrop, i_dropped, stats.pktSndBuf,
+             stats.msSndBuf );
+}
+
+/* Logs the statistics of the connections, every SRT_STATS_PERIOD */
+static void srt_stats( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    vlc_tick_t now = vlc_tick_now();
+
+    if ( now < p_sys->i_stats_date + SRT_STATS_PERIOD )
+        return;
+    p_sys->i_stats_date = now;
+
+    if ( !p_sys->b_listener )
+    {
+        if ( srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED )
+            srt_log_stats( p_access, p_sys->sock, p_access->psz_path, 0 );
+        return;
+    }
+
+    msg_Dbg( p_access, "%d caller(s)", p_sys->i_callers );
+    for ( int i = 0; i < p_sys->i_callers; i++ )
+    {
+        srt_caller_t *p_caller = p_sys->pp_callers[i];
+
+        srt_log_stats( p_access, p_caller->sock, p_caller->psz_addr,
+                       p_caller->i_dropped );
+        p_caller->i_dropped = 0;
+    }
+}
+
+static void srt_caller_close( sout_access_out_sys_t *p_sys, int i )
+{
+    srt_caller_t *p_caller = p_sys->pp_callers[i];
+
+    TAB_ERASE( p_sys->i_callers, p_sys->pp_callers, i );
+    srt_close( p_caller->sock );
+    free( p_caller );
+}
+
+/* Accepts the pending callers, the listener does not block */
+static void srt_accept_callers( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for ( ;; )
+    {
+        struct sockaddr_storage addr;
+        int i_addr_len = sizeof( addr );
+        SRTSOCKET sock = srt_accept( p_sys->sock, (struct sockaddr *)&addr,
+                                     &i_addr_len );
+        if ( sock == SRT_INVALID_SOCK )
+        {
+            if ( srt_getlasterror( NULL ) != SRT_EASYNCRCV )
+                msg_Warn( p_access, "Failed to accept caller (reason: %s)",
+                          srt_getlasterror_str() );
+            break;
+        }
+
+        srt_caller_t *p_caller = malloc( sizeof( *p_caller ) );
+        if ( unlikely(p_caller == NULL) )
+        {
+            srt_close( sock );
+            break;
+        }
+        p_caller->sock = sock;
+        p_caller->i_dropped = 0;
+        if ( vlc_getnameinfo( (struct sockaddr *)&addr, i_addr_len,
+                              p_caller->psz_addr, sizeof( p_caller->psz_addr ),
+                              NULL, NI_NUMERICHOST ) )
+            strcpy( p_caller->psz_addr, "?" );
+
+        /* The data is sent from the sout thread, never wait for a caller */
+        srt_setsockopt( sock, 0, SRTO_SNDSYN, &(bool) { false },
+                        sizeof( bool ) );
+
+        TAB_APPEND( p_sys->i_callers, p_sys->pp_callers, p_caller );
+        msg_Info( p_access, "SRT caller %s connected (%d caller(s))",
+                  p_caller->psz_addr, p_sys->i_callers );
+    }
+}
+
+/* Sends the chunks of a packed block to every connected caller */
+static void srt_send_callers( sout_access_out_t *p_access, const block_t *p_data )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    for ( int i = p_sys->i_callers - 1; i >= 0; i-- )
+    {
+        srt_caller_t *p_caller = p_sys->pp_callers[i];
+
+        for ( size_t i_off = 0; i_off < p_data->i_buffer;
+              i_off += p_sys->i_chunk_size )
+        {
+            if ( srt_sendmsg2( p_caller->sock,
+                               (char *)p_data->p_buffer + i_off,
+                               __MIN( p_sys->i_chunk_size,
+                                      p_data->i_buffer - i_off ),
+                               NULL ) != SRT_ERROR )
+                continue;
+
+            if ( srt_getlasterror( NULL ) == SRT_EASYNCSND )
+            {
+                /* This caller is too slow, the others must not wait */
+                p_caller->i_dropped++;
+                continue;
+            }
+
+            msg_Info( p_access, "SRT caller %s disconnected (reason: %s)",
+                      p_caller->psz_addr, srt_getlasterror_str() );
+            srt_caller_close( p_sys, i );
+            break;
+        }
+    }
+}
+
+/* Opens the listener, callers connect to it at the access address */
+static bool srt_listen_open( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    int i_port;
+    struct addrinfo hints = {
+        .ai_socktype = SOCK_DGRAM,
+        .ai_flags = AI_PASSIVE,
+    }, *res = NULL;
+    bool failed = false;
+
+    char *psz_addr = srt_parse_dst( p_access, &i_port );
+    if ( !psz_addr )
+        return false;
+
+    int stat = vlc_getaddrinfo( psz_addr, i_port, &hints, &res );
+    if ( stat )
+    {
+        msg_Err( p_access, "Cannot resolve [%s]:%d (reason: %s)",
+                 psz_addr, i_port, gai_strerror( stat ) );
+        free( psz_addr );
+        return false;
+    }
+
+    p_sys->sock = srt_socket( res->ai_family, SOCK_DGRAM, 0 );
+    if ( p_sys->sock == SRT_INVALID_SOCK )
+    {
+        msg_Err( p_access, "Failed to open socket." );
+        failed = true;
+        goto out;
+    }
+
+    /* The callers sockets inherit the options of the listener */
+    srt_configure( p_access, p_sys->sock, psz_addr );
+
+    if ( srt_bind( p_sys->sock, res->ai_addr, res->ai_addrlen ) == SRT_ERROR
+      || srt_listen( p_sys->sock, SRT_LISTEN_BACKLOG ) == SRT_ERROR )
+    {
+        msg_Err( p_access, "Failed to listen on [%s]:%d (reason: %s)",
+                 psz_addr, i_port, srt_getlasterror_str() );
+        srt_close( p_sys->sock );
+        p_sys->sock = SRT_INVALID_SOCK;
+        failed = true;
+        goto out;
+    }
+
+    msg_Dbg( p_access, "Waiting for SRT callers on [%s]:%d", psz_addr, i_port );
+
+out:
+    free( psz_addr );
+    freeaddrinfo( res );
+    return !failed;
+}
+
+static ssize_t WriteListener( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_len = 0;
+
+    for ( const block_t *p = p_buffer; p != NULL; p = p->p_next )
+        i_len += p->i_buffer;
+
+    srt_accept_callers( p_access );
+
+    block_t *p_data = srt_pack( p_sys, p_buffer );
+    if ( p_data )
+    {
+        srt_send_callers( p_access, p_data );
+        block_Release( p_data );
+    }
+
+    srt_stats( p_access );
+    return i_len;
+}
+
 static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
 {
     sout_access_out_sys_t *p_sys = p_access->p_sys;
     int i_len = 0;
-    size_t i_chunk_size = var_InheritInteger( p_access, SRT_PARAM_CHUNK_SIZE);
+    size_t i_chunk_size = p_sys->i_chunk_size;
     int i_poll_timeout = var_InheritInteger( p_access, SRT_PARAM_POLL_TIMEOUT );
     bool b_interrupted = false;
 
+    p_buffer = srt_pack( p_sys, p_buffer );
+    if ( !p_buffer )
+        return 0;
+
     vlc_interrupt_register( srt_wait_interrupted, p_access);
 
     while( p_buffer )
@@ -333,6 +618,7 @@ out:
     vlc_mutex_unlock( &p_sys->lock );
 
     if ( i_len <= 0 ) block_ChainRelease( p_buffer );
+    if ( i_len > 0 ) srt_stats( p_access );
     return i_len;
 }
 
@@ -380,6 +666,15 @@ static int Open( vlc_object_t *p_this )
 
     p_access->p_sys = p_sys;
 
+    p_sys->sock = SRT_INVALID_SOCK;
+    p_sys->i_chunk_size = var_InheritInteger( p_access, SRT_PARAM_CHUNK_SIZE );
+    if ( p_sys->i_chunk_size == 0 )
+        p_sys->i_chunk_size = SRT_DEFAULT_CHUNK_SIZE;
+    p_sys->p_pending = NULL;
+    p_sys->b_listener = var_InheritBool( p_access, SRT_PARAM_LISTEN );
+    TAB_INIT( p_sys->i_callers, p_sys->pp_callers );
+    p_sys->i_stats_date = vlc_tick_now();
+
     p_sys->i_poll_id = srt_epoll_create();
     if ( p_sys->i_poll_id == -1 )
     {
@@ -389,6 +684,15 @@ static int Open( vlc_object_t *p_this )
         goto failed;
     }
 
+    if ( p_sys->b_listener )
+    {
+        if ( !srt_listen_open( p_access ) )
+            goto failed;
+        p_access->pf_write = WriteListener;
+        p_access->pf_control = Control;
+        return VLC_SUCCESS;
+    }
+
     if ( !srt_schedule_reconnect( p_access ) )
     {
         msg_Err( p_access, "Failed to schedule connect");
@@ -413,6 +717,21 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
+    /* Flush the last partial chunk, if there is still somebody */
+    if ( p_sys->p_pending )
+    {
+        if ( p_sys->b_listener )
+            srt_send_callers( p_access, p_sys->p_pending );
+        else if ( srt_getsockstate( p_sys->sock ) == SRTS_CONNECTED )
+            srt_sendmsg2( p_sys->sock, (char *)p_sys->p_pending->p_buffer,
+                          p_sys->p_pending->i_buffer, NULL );
+        block_Release( p_sys->p_pending );
+    }
+
+    while ( p_sys->i_callers > 0 )
+        srt_caller_close( p_sys, 0 );
+    TAB_CLEAN( p_sys->i_callers, p_sys->pp_callers );
+
     srt_epoll_remove_usock( p_sys->i_poll_id, p_sys->sock );
     srt_close( p_sys->sock );
     srt_epoll_release( p_sys->i_poll_id );
@@ -444,6 +763,10 @@ vlc_module_begin()
     add_integer( SRT_PARAM_KEY_LENGTH, SRT_DEFAULT_KEY_LENGTH, SRT_KEY_LENGTH_TEXT,
             SRT_KEY_LENGTH_TEXT, false )
     change_integer_list( srt_key_lengths, srt_key_length_names )
+    add_bool( SRT_PARAM_LISTEN, false, N_( "Listen for SRT callers" ),
+            N_( "Wait for any number of receivers to connect at the "
+                "address, and send them all the same stream, instead of "
+                "connecting to a receiver." ), true )
 
     set_capability( "sout access", 0 )
     add_shortcut( "srt" )
@@ -36,7 +36,6 @@
 #include <assert.h>
 #include <errno.h>
 
-#include <vlc_queue.h>
 #include <vlc_sout.h>
 #include <vlc_block.h>
 
@@ -46,10 +45,17 @@
 #elif defined (HAVE_SYS_SOCKET_H)
 #   include <sys/socket.h>
 #endif
+#ifdef HAVE_SENDMMSG
+#   include <netinet/in.h>
+#   include <netinet/udp.h>
+#endif
 
 #include <vlc_network.h>
 
 #define MAX_EMPTY_BLOCKS 200
+/* Upper bound on the number of datagrams sent by a single system call
+ * (also the UDP segmentation offload segment limit) */
+#define BATCH_MAX 64
 
 /*****************************************************************************
  * Module descriptor
@@ -71,6 +77,16 @@ static void Close( vlc_object_t * );
                           "helps reducing the scheduling load on " \
                           "heavily-loaded systems." )
 
+#define BATCH_TEXT N_("Batching window (ms)")
+#define BATCH_LONGTEXT N_("All packets due within this time window are " \
+                          "sent together with a single system call. " \
+                          "This reduces the number of wake-ups and " \
+                          "system calls at the expense of some jitter. " \
+                          "0 disables batching." )
+#define GSO_TEXT N_("UDP segmentation offload")
+#define GSO_LONGTEXT N_("Let the kernel split batches of equally sized " \
+                        "packets, if supported.")
+
 vlc_module_begin ()
     set_description( N_("UDP stream output") )
     set_shortname( "UDP" )
@@ -79,6 +95,11 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "caching", DEFAULT_PTS_DELAY / 1000, CACHING_TEXT, CACHING_LONGTEXT, true )
     add_integer( SOUT_CFG_PREFIX "group", 1, GROUP_TEXT, GROUP_LONGTEXT,
                                  true )
+#ifdef HAVE_SENDMMSG
+    add_integer( SOUT_CFG_PREFIX "batch", 0, BATCH_TEXT, BATCH_LONGTEXT,
+                 true )
+    add_bool( SOUT_CFG_PREFIX "gso", true, GSO_TEXT, GSO_LONGTEXT, true )
+#endif
 
     set_capability( "sout access", 0 )
     add_shortcut( "udp" )
@@ -92,6 +113,10 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "caching",
     "group",
+#ifdef HAVE_SENDMMSG
+    "batch",
+    "gso",
+#endif
     NULL
 };
 
@@ -107,16 +132,22 @@ static ssize_t Write   ( sout_access_out_t *, block_t * );
 static int Control( sout_access_out_t *, int, va_list );
 
 static void* ThreadWrite( void * );
+#ifdef HAVE_SENDMMSG
+static void* ThreadWriteBatch( void * );
+#endif
 
 typedef struct
 {
     vlc_tick_t    i_caching;
     int           i_handle;
     bool          b_mtu_warning;
-    bool          dead;
     size_t        i_mtu;
+#ifdef HAVE_SENDMMSG
+    vlc_tick_t    i_batch_window;
+    bool          b_gso;
+#endif
 
-    vlc_queue_t   queue;
+    vlc_spsc_fifo_t *queue; /* Write() to the sending thread */
     block_t      *p_buffer;
 
     vlc_thread_t  thread;
@@ -208,14 +239,29 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_handle = i_handle;
     p_sys->i_mtu = var_CreateGetInteger( p_this, "mtu" );
     p_sys->b_mtu_warning = false;
-    p_sys->dead = false;
-    vlc_queue_Init(&p_sys->queue, offsetof (block_t, p_next));
+    p_sys->queue = vlc_spsc_fifo_New();
+    if( unlikely(p_sys->queue == NULL) )
+    {
+        net_Close (i_handle);
+        free (p_sys);
+        return VLC_ENOMEM;
+    }
     p_sys->p_buffer = NULL;
 
-    if( vlc_clone( &p_sys->thread, ThreadWrite, p_access,
+    void *(*entry)(void *) = ThreadWrite;
+#ifdef HAVE_SENDMMSG
+    p_sys->i_batch_window = VLC_TICK_FROM_MS(
+                     var_GetInteger( p_access, SOUT_CFG_PREFIX "batch" ) );
+    p_sys->b_gso = var_GetBool( p_access, SOUT_CFG_PREFIX "gso" );
+    if( p_sys->i_batch_window > 0 )
+        entry = ThreadWriteBatch;
+#endif
+
+    if( vlc_clone( &p_sys->thread, entry, p_access,
                            VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         msg_Err( p_access, "cannot spawn sout access thread" );
+        vlc_spsc_fifo_Delete( p_sys->queue );
         net_Close (i_handle);
         free (p_sys);
         return VLC_EGENERIC;
@@ -235,8 +281,9 @@ static void Close( vlc_object_t * p_this )
     sout_access_out_t     *p_access = (sout_access_out_t*)p_this;
     sout_access_out_sys_t *p_sys = p_access->p_sys;
 
-    vlc_queue_Kill(&p_sys->queue, &p_sys->dead);
+    vlc_spsc_fifo_Kill( p_sys->queue );
     vlc_join( p_sys->thread, NULL );
+    vlc_spsc_fifo_Delete( p_sys->queue );
 
     if( p_sys->p_buffer ) block_Release( p_sys->p_buffer );
 
@@ -291,7 +338,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                          now - p_sys->p_buffer->i_dts
                           - p_sys->i_caching );
             }
-            vlc_queue_Enqueue(&p_sys->queue, p_sys->p_buffer);
+            vlc_spsc_fifo_Queue( p_sys->queue, p_sys->p_buffer );
             p_sys->p_buffer = NULL;
         }
 
@@ -333,7 +380,7 @@ static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
                              vlc_tick_now() - p_sys->p_buffer->i_dts
                               - p_sys->i_caching );
                 }
-                vlc_queue_Enqueue(&p_sys->queue, p_sys->p_buffer);
+                vlc_spsc_fifo_Queue( p_sys->queue, p_sys->p_buffer );
                 p_sys->p_buffer = NULL;
             }
         }
@@ -360,8 +407,7 @@ static void* ThreadWrite( void *data )
     unsigned i_dropped_packets = 0;
     block_t *p_pk;
 
-    while ((p_pk = vlc_queue_DequeueKillable(&p_sys->queue,
-                                             &p_sys->dead)) != NULL)
+    while ((p_pk = vlc_spsc_fifo_DequeueKillable(p_sys->queue)) != NULL)
     {
         vlc_tick_t    i_date;
 
@@ -419,3 +465,181 @@ static void* ThreadWrite( void *data )
     }
     return NULL;
 }
+
+#ifdef HAVE_SENDMMSG
+/*****************************************************************************
+ * SendBatch: send a group of packets with as few system calls as possible.
+ *****************************************************************************/
+static void SendBatch( sout_access_out_t *p_access, block_t **pp_pk,
+                       unsigned i_count )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    struct iovec iov[BATCH_MAX];
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        iov[i].iov_base = pp_pk[i]->p_buffer;
+        iov[i].iov_len = pp_pk[i]->i_buffer;
+    }
+
+#ifdef UDP_SEGMENT
+    if( p_sys->b_gso && i_count > 1 )
+    {
+        /* All segments but the last one must have the same size */
+        const size_t i_segment = iov[0].iov_len;
+        size_t i_total = 0;
+        bool b_uniform = true;
+
+        for( unsigned i = 0; i < i_count && b_uniform; i++ )
+        {
+            i_total += iov[i].iov_len;
+            if( iov[i].iov_len > i_segment
+             || ( i + 1 < i_count && iov[i].iov_len != i_segment ) )
+                b_uniform = false;
+        }
+
+        if( b_uniform && i_total <= 65507 )
+        {
+            union {
+                char buf[CMSG_SPACE(sizeof (uint16_t))];
+                struct cmsghdr align;
+            } control;
+            struct msghdr msg = {
+                .msg_iov = iov,
+                .msg_iovlen = i_count,
+                .msg_control = control.buf,
+                .msg_controllen = sizeof (control.buf),
+            };
+            struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+            uint16_t i_gso_size = i_segment;
+
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof (i_gso_size));
+            memcpy( CMSG_DATA(cmsg), &i_gso_size, sizeof (i_gso_size) );
+
+            if( sendmsg( p_sys->i_handle, &msg, 0 ) >= 0 )
+                return;
+
+            if( errno != EINVAL && errno != EIO && errno != ENOPROTOOPT )
+            {
+                msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+                return;
+            }
+
+            msg_Warn( p_access, "UDP segmentation offload not available: %s",
+                      vlc_strerror_c(errno) );
+            p_sys->b_gso = false;
+        }
+    }
+#endif
+
+    struct mmsghdr msgs[BATCH_MAX];
+
+    memset( msgs, 0, i_count * sizeof (*msgs) );
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for( unsigned i_sent = 0; i_sent < i_count; )
+    {
+        int val = sendmmsg( p_sys->i_handle, msgs + i_sent,
+                            i_count - i_sent, 0 );
+        if( val == -1 )
+        {
+            msg_Warn( p_access, "send error: %s", vlc_strerror_c(errno) );
+            break;
+        }
+        i_sent += val;
+    }
+}
+
+/*****************************************************************************
+ * ThreadWriteBatch: Write groups of packets on the network.
+ *****************************************************************************
+ * The first packet of a batch is sent at its due time, together with all the
+ * queued packets due within the batching window. A packet carrying a PCR
+ * always starts a new batch, so that it is never sent ahead of time.
+ *****************************************************************************/
+static void* ThreadWriteBatch( void *data )
+{
+    sout_access_out_t *p_access = data;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    vlc_tick_t i_date_last = -1;
+    unsigned i_dropped_packets = 0;
+    block_t *pp_batch[BATCH_MAX];
+    block_t *p_pk = NULL;
+
+    for( ;; )
+    {
+        if( p_pk == NULL )
+        {
+            p_pk = vlc_spsc_fifo_DequeueKillable( p_sys->queue );
+            if( p_pk == NULL )
+                break;
+        }
+
+        vlc_tick_t i_date = p_sys->i_caching + p_pk->i_dts;
+        if( i_date_last > 0 )
+        {
+            if( i_date - i_date_last > VLC_TICK_FROM_SEC(2) )
+            {
+                if( !i_dropped_packets )
+                    msg_Dbg( p_access, "mmh, hole (%"PRId64" > 2s) -> drop",
+                             i_date - i_date_last );
+
+                block_Release( p_pk );
+                p_pk = NULL;
+
+                i_date_last = i_date;
+                i_dropped_packets++;
+                continue;
+            }
+            else if( i_date - i_date_last < VLC_TICK_FROM_MS(-1) )
+            {
+                if( !i_dropped_packets )
+                    msg_Dbg( p_access, "mmh, packets in the past (%"PRId64")",
+                             i_date_last - i_date );
+            }
+        }
+
+        vlc_tick_wait( i_date );
+
+        const vlc_tick_t i_deadline = i_date + p_sys->i_batch_window;
+        unsigned i_count = 0;
+
+        do
+        {
+            pp_batch[i_count++] = p_pk;
+            i_date_last = p_sys->i_caching + p_pk->i_dts;
+
+            p_pk = vlc_spsc_fifo_Dequeue( p_sys->queue );
+        }
+        while( p_pk != NULL && i_count < BATCH_MAX
+            && !(p_pk->i_flags & BLOCK_FLAG_CLOCK)
+            && p_sys->i_caching + p_pk->i_dts <= i_deadline
+            && p_pk->i_dts + p_sys->i_caching >= i_date_last );
+
+        SendBatch( p_access, pp_batch, i_count );
+
+        if( i_dropped_packets )
+        {
+            msg_Dbg( p_access, "dropped %i packets", i_dropped_packets );
+            i_dropped_packets = 0;
+        }
+
+        i_date = vlc_tick_now() - i_date;
+        if ( i_date > VLC_TICK_FROM_MS(20) )
+        {
+            msg_Dbg( p_access, "packet has been sent too late (%"PRId64 ")",
+                     i_date );
+        }
+
+        for( unsigned i = 0; i < i_count; i++ )
+            block_Release( pp_batch[i] );
+    }
+    return NULL;
+}
+#endif
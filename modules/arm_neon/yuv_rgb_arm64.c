@@ -0,0 +1,188 @@
+/*****************************************************************************
+ * yuv_rgb_arm64.c : AArch64 NEON YUV to RGB conversion functions
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <arm_neon.h>
+
+#include "arm_neon/chroma_neon.h"
+
+/*
+ * These are the AArch64 counterparts of the ARMv7 assembly routines
+ * (i420_rgb.S, i420_rv16.S, nv12_rgb.S and nv21_rgb.S). They use the same
+ * coefficients, scaled by 64, and the same memory layout requirements: the
+ * width is rounded up to a multiple of 16 pixels and two lines are converted
+ * at a time.
+ */
+
+enum chroma_layout
+{
+    CHROMA_PLANAR, /* I420: separate U and V planes */
+    CHROMA_UV,     /* NV12: interleaved U and V */
+    CHROMA_VU,     /* NV21: interleaved V and U */
+};
+
+struct chroma_factors
+{
+    int16x8_t r, g, b;
+};
+
+static inline void chroma_factors (struct chroma_factors *c,
+                                   uint8x8_t u, uint8x8_t v)
+{
+    /* Products may exceed INT16_MAX, but the sums do not. */
+    uint16x8_t r = vmull_u8 (v, vdup_n_u8 (115));
+    uint16x8_t g = vmlal_u8 (vmull_u8 (u, vdup_n_u8 (14)), v, vdup_n_u8 (34));
+    uint16x8_t b = vmull_u8 (u, vdup_n_u8 (135));
+
+    c->r = vaddq_s16 (vdupq_n_s16 (-15872), vreinterpretq_s16_u16 (r));
+    c->g = vsubq_s16 (vdupq_n_s16 (4992), vreinterpretq_s16_u16 (g));
+    c->b = vaddq_s16 (vdupq_n_s16 (-18432), vreinterpretq_s16_u16 (b));
+}
+
+/* Computes 16 pixels from 16 luma and 8 pairs of chroma samples. */
+static inline void yuv_pixels (uint8x16_t *r, uint8x16_t *g, uint8x16_t *b,
+                               const uint8_t *y,
+                               const struct chroma_factors *c)
+{
+    uint8x8x2_t luma = vld2_u8 (y);
+    int16x8_t y0 = vreinterpretq_s16_u16 (vmull_u8 (luma.val[0],
+                                                    vdup_n_u8 (74)));
+    int16x8_t y1 = vreinterpretq_s16_u16 (vmull_u8 (luma.val[1],
+                                                    vdup_n_u8 (74)));
+
+    /* Even and odd pixels are computed apart, then interleaved back. */
+    uint8x8x2_t rr = vzip_u8 (vqrshrun_n_s16 (vqaddq_s16 (y0, c->r), 6),
+                              vqrshrun_n_s16 (vqaddq_s16 (y1, c->r), 6));
+    uint8x8x2_t gg = vzip_u8 (vqrshrun_n_s16 (vqaddq_s16 (y0, c->g), 6),
+                              vqrshrun_n_s16 (vqaddq_s16 (y1, c->g), 6));
+    uint8x8x2_t bb = vzip_u8 (vqrshrun_n_s16 (vqaddq_s16 (y0, c->b), 6),
+                              vqrshrun_n_s16 (vqaddq_s16 (y1, c->b), 6));
+
+    *r = vcombine_u8 (rr.val[0], rr.val[1]);
+    *g = vcombine_u8 (gg.val[0], gg.val[1]);
+    *b = vcombine_u8 (bb.val[0], bb.val[1]);
+}
+
+static inline void store_rgba (uint8_t *out, const uint8_t *y,
+                               const struct chroma_factors *c)
+{
+    uint8x16x4_t px;
+
+    yuv_pixels (&px.val[0], &px.val[1], &px.val[2], y, c);
+    px.val[3] = vdupq_n_u8 (255);
+    vst4q_u8 (out, px);
+}
+
+static inline void store_rv16 (uint8_t *out, const uint8_t *y,
+                               const struct chroma_factors *c)
+{
+    uint8x16_t r, g, b;
+    uint8x16x2_t px;
+
+    yuv_pixels (&r, &g, &b, y, c);
+    /* R5G6B5, little endian */
+    px.val[0] = vsriq_n_u8 (vshlq_n_u8 (g, 3), b, 3);
+    px.val[1] = vsriq_n_u8 (r, g, 5);
+    vst2q_u8 (out, px);
+}
+
+static inline void yuv420_rgb (struct yuv_pack *const out,
+                               const struct yuv_planes *const in,
+                               int width, int height,
+                               enum chroma_layout layout, bool rv16)
+{
+    const size_t bpp = rv16 ? 2 : 4;
+    const size_t cpitch = (layout == CHROMA_PLANAR) ? in->pitch / 2
+                                                    : in->pitch;
+
+    width = (width + 15) & ~15;
+
+    for (int j = 0; j < height; j += 2)
+    {
+        const uint8_t *y1 = (const uint8_t *)in->y + j * in->pitch;
+        const uint8_t *y2 = y1 + in->pitch;
+        const uint8_t *u = (const uint8_t *)in->u + (j / 2) * cpitch;
+        const uint8_t *v = (const uint8_t *)in->v + (j / 2) * cpitch;
+        uint8_t *o1 = (uint8_t *)out->yuv + j * out->pitch;
+        uint8_t *o2 = o1 + out->pitch;
+
+        for (int i = 0; i < width; i += 16)
+        {
+            struct chroma_factors c;
+
+            if (layout == CHROMA_PLANAR)
+                chroma_factors (&c, vld1_u8 (u + i / 2), vld1_u8 (v + i / 2));
+            else
+            {
+                uint8x8x2_t uv = vld2_u8 (u + i);
+
+                if (layout == CHROMA_UV)
+                    chroma_factors (&c, uv.val[0], uv.val[1]);
+                else
+                    chroma_factors (&c, uv.val[1], uv.val[0]);
+            }
+
+            if (rv16)
+            {
+                store_rv16 (o1 + i * bpp, y1 + i, &c);
+                store_rv16 (o2 + i * bpp, y2 + i, &c);
+            }
+            else
+            {
+                store_rgba (o1 + i * bpp, y1 + i, &c);
+                store_rgba (o2 + i * bpp, y2 + i, &c);
+            }
+        }
+    }
+}
+
+void i420_rgb_neon (struct yuv_pack *const out,
+                    const struct yuv_planes *const in,
+                    int width, int height)
+{
+    yuv420_rgb (out, in, width, height, CHROMA_PLANAR, false);
+}
+
+void i420_rv16_neon (struct yuv_pack *const out,
+                     const struct yuv_planes *const in,
+                     int width, int height)
+{
+    yuv420_rgb (out, in, width, height, CHROMA_PLANAR, true);
+}
+
+void nv12_rgb_neon (struct yuv_pack *const out,
+                    const struct yuv_planes *const in,
+                    int width, int height)
+{
+    yuv420_rgb (out, in, width, height, CHROMA_UV, false);
+}
+
+void nv21_rgb_neon (struct yuv_pack *const out,
+                    const struct yuv_planes *const in,
+                    int width, int height)
+{
+    /* The semi-planar chroma plane address is passed as U in both cases. */
+    yuv420_rgb (out, in, width, height, CHROMA_VU, false);
+}
@@ -339,7 +339,6 @@ static void DoWork( filter_t * p_filter,
     float * p_out;
     uint8_t * p_overflow;
     uint8_t * p_end_overflow;
-    uint8_t * p_slide;
 
     size_t i_overflow_size;     /* in bytes */
     size_t i_out_size;          /* in bytes */
@@ -362,27 +361,15 @@ static void DoWork( filter_t * p_filter,
     memset( p_out, 0, i_out_size );
     memcpy( p_out, p_overflow, __MIN( i_out_size, i_overflow_size ) );
 
-    p_slide = (uint8_t *) p_sys->p_overflow_buffer;
-    while( p_slide < p_end_overflow )
+    /* Shift the rest of the overflow, zeroing the freed tail */
+    if( i_out_size < i_overflow_size )
     {
-        size_t i_bytes_copied;
-
-        if( p_slide + i_out_size < p_end_overflow )
-        {
-            memset( p_slide, 0, i_out_size );
-            if( p_slide + 2 * i_out_size < p_end_overflow )
-                i_bytes_copied = i_out_size;
-            else
-                i_bytes_copied = p_end_overflow - ( p_slide + i_out_size );
-            memcpy( p_slide, p_slide + i_out_size, i_bytes_copied );
-        }
-        else
-        {
-            i_bytes_copied = p_end_overflow - p_slide;
-            memset( p_slide, 0, i_bytes_copied );
-        }
-        p_slide += i_bytes_copied;
+        memmove( p_overflow, p_overflow + i_out_size,
+                 i_overflow_size - i_out_size );
+        memset( p_end_overflow - i_out_size, 0, i_out_size );
     }
+    else
+        memset( p_overflow, 0, i_overflow_size );
 
     /* apply the atomic operations */
     for( i = 0; i < p_sys->i_nb_atomic_operations; i++ )
@@ -512,7 +499,7 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
         aout_FormatNbChannels( &(p_filter->fmt_out.audio) ) /
         aout_FormatNbChannels( &(p_filter->fmt_in.audio) );
 
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
@@ -47,6 +47,7 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
+static block_t *FilterS16( filter_t *, block_t * );
 
 static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
@@ -272,8 +273,10 @@ static int OpenFilter( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     void (*do_work)(filter_t *, block_t *, block_t *) = NULL;
 
-    if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
-        p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format ||
+    /* S16N input is converted while mixing, saving a conversion pass */
+    if( ( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 &&
+          p_filter->fmt_in.audio.i_format != VLC_CODEC_S16N ) ||
+        p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32 ||
         p_filter->fmt_in.audio.i_rate != p_filter->fmt_out.audio.i_rate ||
         aout_FormatNbChannels( &p_filter->fmt_in.audio) < 2 )
         return VLC_EGENERIC;
@@ -345,7 +348,10 @@ static int OpenFilter( vlc_object_t *p_this )
     if( do_work == NULL )
         return VLC_EGENERIC;
 
-    p_filter->pf_audio_filter = Filter;
+    if( p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N )
+        p_filter->pf_audio_filter = FilterS16;
+    else
+        p_filter->pf_audio_filter = Filter;
     p_filter->p_sys = (void *)do_work;
     return VLC_SUCCESS;
 }
@@ -353,6 +359,26 @@ static int OpenFilter( vlc_object_t *p_this )
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
+static block_t *AllocOutput( filter_t *p_filter, block_t *p_block )
+{
+    size_t i_out_size = p_block->i_nb_samples *
+      p_filter->fmt_out.audio.i_bitspersample *
+        p_filter->fmt_out.audio.i_channels / 8;
+
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
+    if( !p_out )
+    {
+        msg_Warn( p_filter, "can't get output buffer" );
+        return NULL;
+    }
+
+    p_out->i_nb_samples = p_block->i_nb_samples;
+    p_out->i_dts = p_block->i_dts;
+    p_out->i_pts = p_block->i_pts;
+    p_out->i_length = p_block->i_length;
+    return p_out;
+}
+
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
     void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
@@ -364,26 +390,15 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         return NULL;
     }
 
-    size_t i_out_size = p_block->i_nb_samples *
-      p_filter->fmt_out.audio.i_bitspersample *
-        p_filter->fmt_out.audio.i_channels / 8;
-
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = AllocOutput( p_filter, p_block );
     if( !p_out )
     {
-        msg_Warn( p_filter, "can't get output buffer" );
         block_Release( p_block );
         return NULL;
     }
 
-    p_out->i_nb_samples = p_block->i_nb_samples;
-    p_out->i_dts = p_block->i_dts;
-    p_out->i_pts = p_block->i_pts;
-    p_out->i_length = p_block->i_length;
-
     int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
     int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
-    p_out->i_nb_samples = p_block->i_nb_samples;
     p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
     work( p_filter, p_block, p_out );
@@ -393,3 +408,54 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     return p_out;
 }
 
+/* Frames converted to FL32 at a time, small enough to stay in cache */
+#define S16_CHUNK 128
+
+static block_t *FilterS16( filter_t *p_filter, block_t *p_block )
+{
+    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+
+    if( !p_block || !p_block->i_nb_samples )
+    {
+        if( p_block )
+            block_Release( p_block );
+        return NULL;
+    }
+
+    block_t *p_out = AllocOutput( p_filter, p_block );
+    if( !p_out )
+    {
+        block_Release( p_block );
+        return NULL;
+    }
+
+    const unsigned i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    const unsigned i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    const int16_t *p_src = (const int16_t *)p_block->p_buffer;
+    float *p_dest = (float *)p_out->p_buffer;
+    float buf[S16_CHUNK * AOUT_CHAN_MAX];
+
+    for( size_t i = 0; i < p_block->i_nb_samples; i += S16_CHUNK )
+    {
+        const size_t i_frames = __MIN( p_block->i_nb_samples - i, S16_CHUNK );
+        block_t in, out;
+
+        /* Same conversion as the format converter, since this is exact */
+        for( size_t j = 0; j < i_frames * i_input_nb; j++ )
+            buf[j] = *(p_src++) / 32768.f;
+
+        block_Init( &in, NULL, buf, i_frames * i_input_nb * sizeof(float) );
+        in.i_nb_samples = i_frames;
+        block_Init( &out, NULL, p_dest,
+                    i_frames * i_output_nb * sizeof(float) );
+        out.i_nb_samples = i_frames;
+
+        work( p_filter, &in, &out );
+        p_dest += i_frames * i_output_nb;
+    }
+
+    p_out->i_buffer = p_out->i_nb_samples * i_output_nb * sizeof(float);
+    block_Release( p_block );
+
+    return p_out;
+}
@@ -88,6 +88,7 @@ struct filter_spatialaudio
     filter_spatialaudio()
         : speakers(NULL)
         , i_inputPTS(0)
+        , b_viewpointChanged(true)
         , inBuf(NULL)
         , outBuf(NULL)
     {}
@@ -119,8 +120,9 @@ struct filter_spatialaudio
     CAmbisonicZoomer zoomer;
 
     CAmbisonicSpeaker *speakers;
+    CBFormat inData;
 
-    std::vector<float> inputSamples;
+    std::vector<float> inputSamples; // pending partial block
     vlc_tick_t i_inputPTS;
     unsigned i_order;
     unsigned i_nondiegetic;
@@ -136,6 +138,7 @@ struct filter_spatialaudio
     float f_phi;
     float f_roll;
     float f_zoom;
+    bool b_viewpointChanged;
 };
 
 static std::string getHRTFPath(filter_t *p_filter)
@@ -162,19 +165,83 @@ static std::string getHRTFPath(filter_t *p_filter)
     return HRTFPath;
 }
 
+/**
+ * Renders one block of AMB_BLOCK_TIME_LEN interleaved frames.
+ */
+static void ProcessBlock(filter_spatialaudio *p_sys, const float *p_src,
+                         float *p_dest)
+{
+    for (unsigned i = 0; i < p_sys->i_inputNb; ++i)
+        for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
+            p_sys->inBuf[i][j] = p_src[j * p_sys->i_inputNb + i];
+
+    // Compute
+    switch (p_sys->mode)
+    {
+        case filter_spatialaudio::BINAURALIZER:
+            p_sys->binauralizer.Process(p_sys->inBuf, p_sys->outBuf);
+            break;
+        case filter_spatialaudio::AMBISONICS_DECODER:
+        case filter_spatialaudio::AMBISONICS_BINAURAL_DECODER:
+        {
+            CBFormat *inData = &p_sys->inData;
+
+            for (unsigned i = 0; i < p_sys->i_inputNb - p_sys->i_nondiegetic; ++i)
+                inData->InsertStream(p_sys->inBuf[i], i, AMB_BLOCK_TIME_LEN);
+
+            /* The rotation and zoom matrices only change with the view point */
+            if (p_sys->b_viewpointChanged)
+            {
+                Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
+                p_sys->processor.SetOrientation(ori);
+                p_sys->processor.Refresh();
+
+                p_sys->zoomer.SetZoom(p_sys->f_zoom);
+                p_sys->zoomer.Refresh();
+                p_sys->b_viewpointChanged = false;
+            }
+            p_sys->processor.Process(inData, inData->GetSampleCount());
+            p_sys->zoomer.Process(inData, inData->GetSampleCount());
+
+            if (p_sys->mode == filter_spatialaudio::AMBISONICS_DECODER)
+                p_sys->speakerDecoder.Process(inData, inData->GetSampleCount(), p_sys->outBuf);
+            else
+                p_sys->binauralDecoder.Process(inData, p_sys->outBuf);
+            break;
+        }
+        default:
+            vlc_assert_unreachable();
+    }
+
+    // Interleave the results.
+    for (unsigned i = 0; i < p_sys->i_outputNb; ++i)
+        for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
+            p_dest[j * p_sys->i_outputNb + i] = p_sys->outBuf[i][j];
+
+    if (p_sys->i_nondiegetic == 2)
+    {
+        for (unsigned i = 0; i < p_sys->i_lr_channels * 2; i += 2)
+            for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
+            {
+                p_dest[j * p_sys->i_outputNb + i] =
+                        p_dest[j * p_sys->i_outputNb + i] / 2.f
+                        + p_sys->inBuf[p_sys->i_inputNb - 2][j] / 2.f; //left
+                p_dest[j * p_sys->i_outputNb + i + 1] =
+                        p_dest[j * p_sys->i_outputNb + i + 1] / 2.f
+                        + p_sys->inBuf[p_sys->i_inputNb - 1][j] / 2.f; //right
+            }
+    }
+}
+
 static block_t *Mix( filter_t *p_filter, block_t *p_buf )
 {
     filter_spatialaudio *p_sys = reinterpret_cast<filter_spatialaudio *>(p_filter->p_sys);
 
-    const size_t i_prevSize = p_sys->inputSamples.size();
-    p_sys->inputSamples.resize(i_prevSize + p_buf->i_nb_samples * p_sys->i_inputNb);
-    memcpy((char*)(p_sys->inputSamples.data() + i_prevSize), (char*)p_buf->p_buffer, p_buf->i_buffer);
-
-    const size_t i_inputBlockSize = sizeof(float) * p_sys->i_inputNb * AMB_BLOCK_TIME_LEN;
+    const size_t i_pending = p_sys->inputSamples.size() / p_sys->i_inputNb;
+    const size_t i_nbBlocks = (i_pending + p_buf->i_nb_samples) / AMB_BLOCK_TIME_LEN;
     const size_t i_outputBlockSize = sizeof(float) * p_sys->i_outputNb * AMB_BLOCK_TIME_LEN;
-    const size_t i_nbBlocks = p_sys->inputSamples.size() * sizeof(float) / i_inputBlockSize;
 
-    block_t *p_out_buf = block_Alloc(i_outputBlockSize * i_nbBlocks);
+    block_t *p_out_buf = filter_NewAudioBuffer(p_filter, i_outputBlockSize * i_nbBlocks);
     if (unlikely(p_out_buf == NULL))
     {
         block_Release(p_buf);
@@ -190,77 +257,38 @@ static block_t *Mix( filter_t *p_filter, block_t *p_buf )
     p_out_buf->i_length = vlc_tick_from_samples(p_out_buf->i_nb_samples, p_filter->fmt_in.audio.i_rate);
 
     float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (float *)p_sys->inputSamples.data();
+    const float *p_src = (const float *)p_buf->p_buffer;
+    size_t i_frames = p_buf->i_nb_samples;
 
     for (unsigned b = 0; b < i_nbBlocks; ++b)
     {
-        for (unsigned i = 0; i < p_sys->i_inputNb; ++i)
-        {
-            for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
-            {
-                float val = p_src[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_inputNb + i];
-                p_sys->inBuf[i][j] = val;
-            }
-        }
-
-        // Compute
-        switch (p_sys->mode)
+        if (!p_sys->inputSamples.empty())
         {
-            case filter_spatialaudio::BINAURALIZER:
-                p_sys->binauralizer.Process(p_sys->inBuf, p_sys->outBuf);
-                break;
-            case filter_spatialaudio::AMBISONICS_DECODER:
-            case filter_spatialaudio::AMBISONICS_BINAURAL_DECODER:
-            {
-                CBFormat inData;
-                inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN);
-
-                for (unsigned i = 0; i < p_sys->i_inputNb - p_sys->i_nondiegetic; ++i)
-                    inData.InsertStream(p_sys->inBuf[i], i, AMB_BLOCK_TIME_LEN);
-
-                Orientation ori(p_sys->f_teta, p_sys->f_phi, p_sys->f_roll);
-                p_sys->processor.SetOrientation(ori);
-                p_sys->processor.Refresh();
-                p_sys->processor.Process(&inData, inData.GetSampleCount());
-
-                p_sys->zoomer.SetZoom(p_sys->f_zoom);
-                p_sys->zoomer.Refresh();
-                p_sys->zoomer.Process(&inData, inData.GetSampleCount());
-
-                if (p_sys->mode == filter_spatialaudio::AMBISONICS_DECODER)
-                    p_sys->speakerDecoder.Process(&inData, inData.GetSampleCount(), p_sys->outBuf);
-                else
-                    p_sys->binauralDecoder.Process(&inData, p_sys->outBuf);
-                break;
-            }
-            default:
-                vlc_assert_unreachable();
+            /* Complete the block left over by the previous call */
+            const size_t i_missing = AMB_BLOCK_TIME_LEN
+                                   - p_sys->inputSamples.size() / p_sys->i_inputNb;
+
+            p_sys->inputSamples.insert(p_sys->inputSamples.end(), p_src,
+                                       p_src + i_missing * p_sys->i_inputNb);
+            ProcessBlock(p_sys, p_sys->inputSamples.data(), p_dest);
+            p_sys->inputSamples.clear();
+            p_src += i_missing * p_sys->i_inputNb;
+            i_frames -= i_missing;
         }
-
-        // Interleave the results.
-        for (unsigned i = 0; i < p_sys->i_outputNb; ++i)
-            for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
-                p_dest[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_outputNb + i] = p_sys->outBuf[i][j];
-
-        if (p_sys->i_nondiegetic == 2)
+        else
         {
-            for (unsigned i = 0; i < p_sys->i_lr_channels * 2; i += 2)
-                for (unsigned j = 0; j < AMB_BLOCK_TIME_LEN; ++j)
-                {
-                    p_dest[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_outputNb + i] =
-                            p_dest[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_outputNb + i]  / 2.f
-                            + p_sys->inBuf[p_sys->i_inputNb - 2][j] / 2.f; //left
-                    p_dest[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_outputNb + i + 1] =
-                            p_dest[(b * AMB_BLOCK_TIME_LEN + j) * p_sys->i_outputNb + i + 1]  / 2.f
-                            + p_sys->inBuf[p_sys->i_inputNb - 1][j] / 2.f; //right
-                }
+            /* Render straight from the input buffer */
+            ProcessBlock(p_sys, p_src, p_dest);
+            p_src += AMB_BLOCK_TIME_LEN * p_sys->i_inputNb;
+            i_frames -= AMB_BLOCK_TIME_LEN;
         }
+        p_dest += AMB_BLOCK_TIME_LEN * p_sys->i_outputNb;
     }
 
-    p_sys->inputSamples.erase(p_sys->inputSamples.begin(),
-                              p_sys->inputSamples.begin() + i_inputBlockSize * i_nbBlocks / sizeof(float));
+    p_sys->inputSamples.insert(p_sys->inputSamples.end(), p_src,
+                               p_src + i_frames * p_sys->i_inputNb);
 
-    assert(p_sys->inputSamples.size() < i_inputBlockSize);
+    assert(p_sys->inputSamples.size() < AMB_BLOCK_TIME_LEN * p_sys->i_inputNb);
 
     p_sys->i_inputPTS = p_out_buf->i_pts + p_out_buf->i_length;
 
@@ -288,6 +316,7 @@ static void ChangeViewpoint( filter_t *p_filter, const vlc_viewpoint_t *p_vp)
         p_sys->f_zoom = 0.f; // no unzoom as it does not really make sense.
     else
         p_sys->f_zoom = (FIELD_OF_VIEW_DEGREES_DEFAULT - p_vp->fov) / (FIELD_OF_VIEW_DEGREES_DEFAULT - FIELD_OF_VIEW_DEGREES_MIN);
+    p_sys->b_viewpointChanged = true;
 #undef RAD
 }
 
@@ -540,6 +569,13 @@ static int Open(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+    if (!p_sys->inData.Configure(p_sys->i_order, true, AMB_BLOCK_TIME_LEN))
+    {
+        msg_Err(p_filter, "Error creating the B-format buffer.");
+        delete p_sys;
+        return VLC_EGENERIC;
+    }
+
     p_filter->p_sys = p_sys;
     p_filter->pf_audio_filter = Mix;
     p_filter->pf_flush = Flush;
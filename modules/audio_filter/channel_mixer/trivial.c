@@ -61,7 +61,7 @@ static block_t *Upmix( filter_t *p_filter, block_t *p_in_buf )
 
     assert( i_input_nb < i_output_nb );
 
-    block_t *p_out_buf = block_Alloc(
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter,
                               p_in_buf->i_buffer * i_output_nb / i_input_nb );
     if( unlikely(p_out_buf == NULL) )
     {
@@ -138,7 +138,7 @@ static block_t *Extract( filter_t *p_filter, block_t *p_in_buf )
                       * p_filter->fmt_out.audio.i_bitspersample
                       * i_out_channels / 8;
 
-    block_t *p_out_buf = block_Alloc( i_out_size );
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_out_size );
     if( unlikely(p_out_buf == NULL) )
     {
         block_Release( p_in_buf );
@@ -177,7 +177,8 @@ static int Create( vlc_object_t *p_this )
     if( infmt->i_physical_channels == 0 )
     {
         assert( infmt->i_channels > 0 );
-        if( outfmt->i_physical_channels == 0 )
+        if( outfmt->i_physical_channels == 0
+         || infmt->i_format != outfmt->i_format )
             return VLC_EGENERIC;
         if( aout_FormatNbChannels( outfmt ) == infmt->i_channels )
         {
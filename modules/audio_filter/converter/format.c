@@ -38,6 +38,20 @@
 #include <vlc_aout.h>
 #include <vlc_block.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define FORMAT_SSE2 1
+#endif
+#if defined(FORMAT_SSE2) && defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define FORMAT_AVX2 1
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define FORMAT_NEON64 1
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -81,11 +95,269 @@ static int Open(vlc_object_t *object)
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * SIMD kernels
+ *****************************************************************************
+ * Each kernel converts as many samples as it can by whole vectors and returns
+ * that count; the scalar loops of the converters finish the remainder.
+ * Results are bit-exact with the scalar code (except for NaN inputs), and the
+ * kernels work in place as long as the destination does not run ahead of the
+ * source.
+ *****************************************************************************/
+#ifdef FORMAT_SSE2
+__attribute__ ((__target__ ("sse2")))
+static size_t S16toFl32_SSE2(float *dst, const int16_t *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        /* Sign-extend by moving each sample to the high half */
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Fl32toS16_SSE2(int16_t *dst, const float *src, size_t n)
+{
+    /* Rounding to nearest even then saturating packs gives the same result
+     * as Walken's trick. Clamp first as out of range conversions yield
+     * INT32_MIN whatever the sign. */
+    const __m128 scale = _mm_set1_ps(32768.f);
+    const __m128 vmin = _mm_set1_ps(-32768.f);
+    const __m128 vmax = _mm_set1_ps(32767.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+
+        a = _mm_min_ps(_mm_max_ps(a, vmin), vmax);
+        b = _mm_min_ps(_mm_max_ps(b, vmin), vmax);
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packs_epi32(_mm_cvtps_epi32(a),
+                                         _mm_cvtps_epi32(b)));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t S32toFl32_SSE2(float *dst, const int32_t *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(s), scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static size_t Fl32toS32_SSE2(int32_t *dst, const float *src, size_t n)
+{
+    const __m128 scale = _mm_set1_ps(2147483648.f);
+    const __m128 half = _mm_set1_ps(.5f);
+    const __m128 mhalf = _mm_set1_ps(-.5f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 s = _mm_mul_ps(_mm_loadu_ps(src + i), scale);
+        __m128i r = _mm_cvtps_epi32(s);
+        /* lroundf() rounds halfway cases away from zero: fix up the ties
+         * that were rounded towards zero to the even neighbour. */
+        __m128 d = _mm_sub_ps(s, _mm_cvtepi32_ps(r));
+        __m128 up = _mm_and_ps(_mm_cmpeq_ps(d, half), _mm_cmpgt_ps(s, zero));
+        __m128 down = _mm_and_ps(_mm_cmpeq_ps(d, mhalf),
+                                 _mm_cmplt_ps(s, zero));
+
+        r = _mm_sub_epi32(r, _mm_castps_si128(up));
+        r = _mm_add_epi32(r, _mm_castps_si128(down));
+        /* Positive overflow converted to INT32_MIN: wrap it to INT32_MAX */
+        r = _mm_add_epi32(r, _mm_castps_si128(_mm_cmpge_ps(s, scale)));
+        _mm_storeu_si128((__m128i *)(dst + i), r);
+    }
+    return i;
+}
+#endif
+
+#ifdef FORMAT_AVX2
+__attribute__ ((__target__ ("avx2")))
+static size_t S16toFl32_AVX2(float *dst, const int16_t *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i lo = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i)));
+        __m256i hi = _mm256_cvtepi16_epi32(
+                        _mm_loadu_si128((const __m128i *)(src + i + 8)));
+
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo),
+                                                scale));
+        _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi),
+                                                    scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t Fl32toS16_AVX2(int16_t *dst, const float *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 vmin = _mm256_set1_ps(-32768.f);
+    const __m256 vmax = _mm256_set1_ps(32767.f);
+    size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale);
+
+        a = _mm256_min_ps(_mm256_max_ps(a, vmin), vmax);
+        b = _mm256_min_ps(_mm256_max_ps(b, vmin), vmax);
+
+        /* Packing works per 128-bit lane: restore the sample order */
+        __m256i p = _mm256_packs_epi32(_mm256_cvtps_epi32(a),
+                                       _mm256_cvtps_epi32(b));
+        p = _mm256_permute4x64_epi64(p, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)(dst + i), p);
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t S32toFl32_AVX2(float *dst, const int32_t *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i s = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s),
+                                                scale));
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static size_t Fl32toS32_AVX2(int32_t *dst, const float *src, size_t n)
+{
+    const __m256 scale = _mm256_set1_ps(2147483648.f);
+    const __m256 half = _mm256_set1_ps(.5f);
+    const __m256 mhalf = _mm256_set1_ps(-.5f);
+    const __m256 zero = _mm256_setzero_ps();
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256 s = _mm256_mul_ps(_mm256_loadu_ps(src + i), scale);
+        __m256i r = _mm256_cvtps_epi32(s);
+        __m256 d = _mm256_sub_ps(s, _mm256_cvtepi32_ps(r));
+        __m256 up = _mm256_and_ps(_mm256_cmp_ps(d, half, _CMP_EQ_OQ),
+                                  _mm256_cmp_ps(s, zero, _CMP_GT_OQ));
+        __m256 down = _mm256_and_ps(_mm256_cmp_ps(d, mhalf, _CMP_EQ_OQ),
+                                    _mm256_cmp_ps(s, zero, _CMP_LT_OQ));
+
+        r = _mm256_sub_epi32(r, _mm256_castps_si256(up));
+        r = _mm256_add_epi32(r, _mm256_castps_si256(down));
+        r = _mm256_add_epi32(r, _mm256_castps_si256(
+                                    _mm256_cmp_ps(s, scale, _CMP_GE_OQ)));
+        _mm256_storeu_si256((__m256i *)(dst + i), r);
+    }
+    return i;
+}
+#endif
+
+#ifdef FORMAT_NEON64
+static size_t S16toFl32_NEON64(float *dst, const int16_t *src, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        int16x8_t s = vld1q_s16(src + i);
+        /* Fixed-point conversion with 15 fractional bits divides exactly */
+        vst1q_f32(dst + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(s)), 15));
+        vst1q_f32(dst + i + 4, vcvtq_n_f32_s32(vmovl_high_s16(s), 15));
+    }
+    return i;
+}
+
+static size_t Fl32toS16_NEON64(int16_t *dst, const float *src, size_t n)
+{
+    const float32x4_t scale = vdupq_n_f32(32768.f);
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        /* Conversions saturate, so does narrowing */
+        int32x4_t a = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(src + i), scale));
+        int32x4_t b = vcvtnq_s32_f32(vmulq_f32(vld1q_f32(src + i + 4),
+                                               scale));
+        vst1q_s16(dst + i, vqmovn_high_s32(vqmovn_s32(a), b));
+    }
+    return i;
+}
+
+static size_t S32toFl32_NEON64(float *dst, const int32_t *src, size_t n)
+{
+    const float32x4_t scale = vdupq_n_f32(1.f / 2147483648.f);
+    size_t i = 0;
+
+    for (; i + 4 <= n; i += 4)
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vld1q_s32(src + i)),
+                                     scale));
+    return i;
+}
+
+static size_t Fl32toS32_NEON64(int32_t *dst, const float *src, size_t n)
+{
+    const float32x4_t scale = vdupq_n_f32(2147483648.f);
+    size_t i = 0;
+
+    /* Round half away from zero and saturate, exactly like the C code */
+    for (; i + 4 <= n; i += 4)
+        vst1q_s32(dst + i, vcvtaq_s32_f32(vmulq_f32(vld1q_f32(src + i),
+                                                    scale)));
+    return i;
+}
+#endif
+
+#if defined(FORMAT_AVX2)
+# define FORMAT_SIMD(name, dst, src, n) \
+    (vlc_CPU_AVX2() ? name##_AVX2(dst, src, n) : \
+     vlc_CPU_SSE2() ? name##_SSE2(dst, src, n) : 0)
+#elif defined(FORMAT_SSE2)
+# define FORMAT_SIMD(name, dst, src, n) \
+    (vlc_CPU_SSE2() ? name##_SSE2(dst, src, n) : 0)
+#elif defined(FORMAT_NEON64)
+# define FORMAT_SIMD(name, dst, src, n) name##_NEON64(dst, src, n)
+#else
+# define FORMAT_SIMD(name, dst, src, n) \
+    ((void)(dst), (void)(src), (void)(n), (size_t)0)
+#endif
+
 
 /*** from U8 ***/
 static block_t *U8toS16(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -102,7 +374,7 @@ out:
 
 static block_t *U8toFl32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -119,7 +391,7 @@ out:
 
 static block_t *U8toS32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -136,7 +408,7 @@ out:
 
 static block_t *U8toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 8);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 8);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -167,14 +439,17 @@ static block_t *S16toU8(filter_t *filter, block_t *b)
 
 static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
     block_CopyProperties(bdst, bsrc);
     int16_t *src = (int16_t *)bsrc->p_buffer;
     float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    size_t done = FORMAT_SIMD(S16toFl32, dst, src, bsrc->i_buffer / 2);
+    src += done;
+    dst += done;
+    for (size_t i = bsrc->i_buffer / 2 - done; i--;)
 #if 0
         /* Slow version */
         *dst++ = (float)*src++ / 32768.f;
@@ -195,7 +470,7 @@ out:
 
 static block_t *S16toS32(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -212,7 +487,7 @@ out:
 
 static block_t *S16toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 4);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -254,7 +529,10 @@ static block_t *Fl32toS16(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     float   *src = (float *)b->p_buffer;
     int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
+    size_t done = FORMAT_SIMD(Fl32toS16, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;) {
 #if 0
         /* Slow version. */
         if (*src >= 1.0) *dst = 32767;
@@ -281,7 +559,10 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 {
     float   *src = (float *)b->p_buffer;
     int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    size_t done = FORMAT_SIMD(Fl32toS32, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;)
     {
         float s = *(src++) * 2147483648.f;
         if (s >= 2147483647.f)
@@ -298,7 +579,7 @@ static block_t *Fl32toS32(filter_t *filter, block_t *b)
 
 static block_t *Fl32toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
@@ -344,14 +625,17 @@ static block_t *S32toFl32(filter_t *filter, block_t *b)
     VLC_UNUSED(filter);
     int32_t *src = (int32_t*)b->p_buffer;
     float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
+    size_t done = FORMAT_SIMD(S32toFl32, dst, src, b->i_buffer / 4);
+    src += done;
+    dst += done;
+    for (size_t i = b->i_buffer / 4 - done; i--;)
         *dst++ = (float)(*src++) / 2147483648.f;
     return b;
 }
 
 static block_t *S32toFl64(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
+    block_t *bdst = filter_NewAudioBuffer(filter, bsrc->i_buffer * 2);
     if (unlikely(bdst == NULL))
         goto out;
 
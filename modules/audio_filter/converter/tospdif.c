@@ -50,8 +50,35 @@ vlc_module_begin ()
     set_callbacks( Open, Close )
 vlc_module_end ()
 
+/* Output bursts have a constant size for a given stream. They are recycled
+ * rather than reallocated for every frame, as TrueHD and E-AC3 bursts are
+ * fairly large (up to 60 KiB). The pool outlives the filter as long as
+ * bursts are queued in the audio output. */
+#define SPDIF_POOL_MAX 8
+
+struct spdif_pool;
+
+struct spdif_burst
+{
+    block_t self;
+    struct spdif_pool *pool;
+    struct spdif_burst *next;
+    size_t i_capacity;
+    uint8_t p_data[];
+};
+
+struct spdif_pool
+{
+    vlc_mutex_t lock;
+    unsigned i_refs;
+    unsigned i_count;
+    size_t i_size;
+    struct spdif_burst *p_free;
+};
+
 typedef struct
 {
+    struct spdif_pool *p_pool;
     block_t *p_out_buf;
     size_t i_out_offset;
 
@@ -86,6 +113,110 @@ typedef struct
 #define SPDIF_SUCCESS VLC_SUCCESS
 #define SPDIF_ERROR VLC_EGENERIC
 
+static void spdif_pool_Release( struct spdif_pool *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    bool b_last = --p_pool->i_refs == 0;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( !b_last )
+        return;
+
+    while( p_pool->p_free != NULL )
+    {
+        struct spdif_burst *p_burst = p_pool->p_free;
+        p_pool->p_free = p_burst->next;
+        free( p_burst );
+    }
+    free( p_pool );
+}
+
+static void spdif_burst_Release( block_t *p_block )
+{
+    struct spdif_burst *p_burst =
+        container_of( p_block, struct spdif_burst, self );
+    struct spdif_pool *p_pool = p_burst->pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( p_burst->i_capacity == p_pool->i_size
+     && p_pool->i_count < SPDIF_POOL_MAX )
+    {
+        p_burst->next = p_pool->p_free;
+        p_pool->p_free = p_burst;
+        p_pool->i_count++;
+        p_burst = NULL;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    free( p_burst );
+    spdif_pool_Release( p_pool );
+}
+
+static const struct vlc_block_callbacks spdif_burst_cbs =
+{
+    spdif_burst_Release,
+};
+
+static struct spdif_pool *spdif_pool_New( void )
+{
+    struct spdif_pool *p_pool = malloc( sizeof( *p_pool ) );
+    if( unlikely( p_pool == NULL ) )
+        return NULL;
+
+    vlc_mutex_init( &p_pool->lock );
+    p_pool->i_refs = 1;
+    p_pool->i_count = 0;
+    p_pool->i_size = 0;
+    p_pool->p_free = NULL;
+    return p_pool;
+}
+
+static block_t *spdif_pool_Get( struct spdif_pool *p_pool, size_t i_size )
+{
+    struct spdif_burst *p_burst = NULL, *p_stale = NULL;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( i_size > p_pool->i_size )
+    {
+        /* Larger bursts (e.g. DTS-HD period change): drop the smaller ones */
+        p_stale = p_pool->p_free;
+        p_pool->p_free = NULL;
+        p_pool->i_count = 0;
+        p_pool->i_size = i_size;
+    }
+    else if( p_pool->p_free != NULL )
+    {
+        p_burst = p_pool->p_free;
+        p_pool->p_free = p_burst->next;
+        p_pool->i_count--;
+    }
+    size_t i_capacity = p_pool->i_size;
+    p_pool->i_refs++;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    while( p_stale != NULL )
+    {
+        struct spdif_burst *p_next = p_stale->next;
+        free( p_stale );
+        p_stale = p_next;
+    }
+
+    if( p_burst == NULL )
+    {
+        p_burst = malloc( sizeof( *p_burst ) + i_capacity );
+        if( unlikely( p_burst == NULL ) )
+        {
+            spdif_pool_Release( p_pool );
+            return NULL;
+        }
+        p_burst->pool = p_pool;
+        p_burst->i_capacity = i_capacity;
+    }
+
+    return block_Init( &p_burst->self, &spdif_burst_cbs, p_burst->p_data,
+                       i_size );
+}
+
 static bool is_big_endian( filter_t *p_filter, block_t *p_in_buf )
 {
     switch( p_filter->fmt_in.audio.i_format )
@@ -179,7 +310,7 @@ static int write_init( filter_t *p_filter, block_t *p_in_buf,
     assert( p_sys->p_out_buf == NULL );
     assert( i_out_size > SPDIF_HEADER_SIZE && ( i_out_size & 3 ) == 0 );
 
-    p_sys->p_out_buf = block_Alloc( i_out_size );
+    p_sys->p_out_buf = spdif_pool_Get( p_sys->p_pool, i_out_size );
     if( !p_sys->p_out_buf )
         return VLC_ENOMEM;
     p_sys->p_out_buf->i_dts = p_in_buf->i_dts;
@@ -616,6 +747,13 @@ static int Open( vlc_object_t *p_this )
     if( unlikely( p_sys == NULL ) )
         return VLC_ENOMEM;
 
+    p_sys->p_pool = spdif_pool_New();
+    if( unlikely( p_sys->p_pool == NULL ) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
     p_filter->pf_audio_filter = DoWork;
     p_filter->pf_flush = Flush;
 
@@ -626,6 +764,9 @@ static void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_sys_t *p_sys = p_filter->p_sys;
+
     Flush( p_filter );
-    free( p_filter->p_sys );
+    spdif_pool_Release( p_sys->p_pool );
+    free( p_sys );
 }
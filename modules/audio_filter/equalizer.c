@@ -29,16 +29,23 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_charset.h>
+#include <vlc_cpu.h>
 
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
 #include "equalizer_presets.h"
 
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define EQZ_SSE2 1
+#endif
+
 /* TODO:
  *  - optimize a bit (you can hardly do slower ;)
  *  - add tables for more bands (15 and 32 would be cool), maybe with auto coeffs
@@ -100,6 +107,8 @@ vlc_module_end ()
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
+#define EQZ_CHANNELS_MAX 32
+
 typedef struct
 {
     /* Filter static config */
@@ -113,13 +122,14 @@ typedef struct
     float f_gamp;   /* Global preamp */
     bool b_2eqz;
 
-    /* Filter state */
-    float x[32][2];
-    float y[32][128][2];
+    /* Filter state, with channels interleaved so that each channel of a
+     * sample frame goes to a SIMD lane */
+    float x[2][EQZ_CHANNELS_MAX];
+    float y[EQZ_BANDS_MAX][2][EQZ_CHANNELS_MAX];
 
     /* Second filter state */
-    float x2[32][2];
-    float y2[32][128][2];
+    float x2[2][EQZ_CHANNELS_MAX];
+    float y2[EQZ_BANDS_MAX][2][EQZ_CHANNELS_MAX];
 
     vlc_mutex_t lock;
 } filter_sys_t;
@@ -149,6 +159,9 @@ static int Open( vlc_object_t *p_this )
 {
     filter_t     *p_filter = (filter_t *)p_this;
 
+    if( aout_FormatNbChannels( &p_filter->fmt_in.audio ) > EQZ_CHANNELS_MAX )
+        return VLC_EGENERIC;
+
     /* Allocate structure */
     filter_sys_t *p_sys = p_filter->p_sys = malloc( sizeof( *p_sys ) );
     if( !p_sys )
@@ -278,7 +291,7 @@ static int EqzInit( filter_t *p_filter, int i_rate )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     eqz_config_t cfg;
-    int i, ch;
+    int i;
     vlc_value_t val1, val2, val3;
     vlc_object_t *p_aout = vlc_object_parent(p_filter);
     int i_ret = VLC_ENOMEM;
@@ -314,21 +327,10 @@ static int EqzInit( filter_t *p_filter, int i_rate )
     }
 
     /* Filter state */
-    for( ch = 0; ch < 32; ch++ )
-    {
-        p_sys->x[ch][0]  =
-        p_sys->x[ch][1]  =
-        p_sys->x2[ch][0] =
-        p_sys->x2[ch][1] = 0.0f;
-
-        for( i = 0; i < p_sys->i_band; i++ )
-        {
-            p_sys->y[ch][i][0]  =
-            p_sys->y[ch][i][1]  =
-            p_sys->y2[ch][i][0] =
-            p_sys->y2[ch][i][1] = 0.0f;
-        }
-    }
+    memset( p_sys->x, 0, sizeof(p_sys->x) );
+    memset( p_sys->y, 0, sizeof(p_sys->y) );
+    memset( p_sys->x2, 0, sizeof(p_sys->x2) );
+    memset( p_sys->y2, 0, sizeof(p_sys->y2) );
 
     var_Create( p_aout, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
     var_Create( p_aout, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
@@ -383,6 +385,103 @@ error:
     return i_ret;
 }
 
+#ifdef EQZ_SSE2
+/* Filters 4 channels of one sample frame through all the bands of a pass,
+ * with the same operations as the C code for each channel */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128 EqzPassSSE2( int i_band, const __m128 *alpha,
+                                  const __m128 *beta, const __m128 *gamma,
+                                  const __m128 *amp, float hx[2][EQZ_CHANNELS_MAX],
+                                  float hy[][2][EQZ_CHANNELS_MAX], int ch,
+                                  __m128 x )
+{
+    const __m128 dx = _mm_sub_ps( x, _mm_loadu_ps( &hx[1][ch] ) );
+    __m128 o = _mm_setzero_ps();
+
+    for( int j = 0; j < i_band; j++ )
+    {
+        const __m128 y1 = _mm_loadu_ps( &hy[j][0][ch] );
+        const __m128 y2 = _mm_loadu_ps( &hy[j][1][ch] );
+        const __m128 y = _mm_sub_ps( _mm_add_ps( _mm_mul_ps( alpha[j], dx ),
+                                                 _mm_mul_ps( gamma[j], y1 ) ),
+                                     _mm_mul_ps( beta[j], y2 ) );
+
+        _mm_storeu_ps( &hy[j][1][ch], y1 );
+        _mm_storeu_ps( &hy[j][0][ch], y );
+        o = _mm_add_ps( o, _mm_mul_ps( y, amp[j] ) );
+    }
+    _mm_storeu_ps( &hx[1][ch], _mm_loadu_ps( &hx[0][ch] ) );
+    _mm_storeu_ps( &hx[0][ch], x );
+    return o;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void EqzFilterSSE2( filter_sys_t *p_sys, float *out, const float *in,
+                           int i_samples, int i_channels )
+{
+    __m128 alpha[EQZ_BANDS_MAX], beta[EQZ_BANDS_MAX];
+    __m128 gamma[EQZ_BANDS_MAX], amp[EQZ_BANDS_MAX];
+    const __m128 in_factor = _mm_set1_ps( EQZ_IN_FACTOR );
+    const __m128 gamp = _mm_set1_ps( p_sys->f_gamp );
+    const __m128 gamp2 = _mm_set1_ps( p_sys->f_gamp * p_sys->f_gamp );
+
+    for( int j = 0; j < p_sys->i_band; j++ )
+    {
+        alpha[j] = _mm_set1_ps( p_sys->f_alpha[j] );
+        beta[j]  = _mm_set1_ps( p_sys->f_beta[j] );
+        gamma[j] = _mm_set1_ps( p_sys->f_gamma[j] );
+        amp[j]   = _mm_set1_ps( p_sys->f_amp[j] );
+    }
+
+    for( int i = 0; i < i_samples; i++ )
+    {
+        for( int ch = 0; ch < i_channels; ch += 4 )
+        {
+            /* Unused lanes of the last group filter silence */
+            const int i_lanes = __MIN( i_channels - ch, 4 );
+            float buf[4] = { 0.f, 0.f, 0.f, 0.f };
+            __m128 x, o;
+
+            if( i_lanes == 4 )
+                x = _mm_loadu_ps( &in[ch] );
+            else
+            {
+                memcpy( buf, &in[ch], i_lanes * sizeof(float) );
+                x = _mm_loadu_ps( buf );
+            }
+
+            o = EqzPassSSE2( p_sys->i_band, alpha, beta, gamma, amp,
+                             p_sys->x, p_sys->y, ch, x );
+
+            /* We add source PCM + filtered PCM */
+            if( p_sys->b_2eqz )
+            {
+                const __m128 x2 = _mm_add_ps( _mm_mul_ps( in_factor, x ), o );
+
+                o = EqzPassSSE2( p_sys->i_band, alpha, beta, gamma, amp,
+                                 p_sys->x2, p_sys->y2, ch, x2 );
+                o = _mm_mul_ps( gamp2, _mm_add_ps( _mm_mul_ps( in_factor, x2 ),
+                                                   o ) );
+            }
+            else
+                o = _mm_mul_ps( gamp, _mm_add_ps( _mm_mul_ps( in_factor, x ),
+                                                  o ) );
+
+            if( i_lanes == 4 )
+                _mm_storeu_ps( &out[ch], o );
+            else
+            {
+                _mm_storeu_ps( buf, o );
+                memcpy( &out[ch], buf, i_lanes * sizeof(float) );
+            }
+        }
+
+        in  += i_channels;
+        out += i_channels;
+    }
+}
+#endif
+
 static void EqzFilter( filter_t *p_filter, float *out, float *in,
                        int i_samples, int i_channels )
 {
@@ -390,6 +489,14 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
     int i, ch, j;
 
     vlc_mutex_lock( &p_sys->lock );
+#ifdef EQZ_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        EqzFilterSSE2( p_sys, out, in, i_samples, i_channels );
+        vlc_mutex_unlock( &p_sys->lock );
+        return;
+    }
+#endif
     for( i = 0; i < i_samples; i++ )
     {
         for( ch = 0; ch < i_channels; ch++ )
@@ -399,17 +506,17 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
 
             for( j = 0; j < p_sys->i_band; j++ )
             {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+                float y = p_sys->f_alpha[j] * ( x - p_sys->x[1][ch] ) +
+                          p_sys->f_gamma[j] * p_sys->y[j][0][ch] -
+                          p_sys->f_beta[j]  * p_sys->y[j][1][ch];
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+                p_sys->y[j][1][ch] = p_sys->y[j][0][ch];
+                p_sys->y[j][0][ch] = y;
 
                 o += y * p_sys->f_amp[j];
             }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+            p_sys->x[1][ch] = p_sys->x[0][ch];
+            p_sys->x[0][ch] = x;
 
             /* Second filter */
             if( p_sys->b_2eqz )
@@ -418,17 +525,17 @@ static void EqzFilter( filter_t *p_filter, float *out, float *in,
                 o = 0.0f;
                 for( j = 0; j < p_sys->i_band; j++ )
                 {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
+                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[1][ch] ) +
+                              p_sys->f_gamma[j] * p_sys->y2[j][0][ch] -
+                              p_sys->f_beta[j]  * p_sys->y2[j][1][ch];
 
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
+                    p_sys->y2[j][1][ch] = p_sys->y2[j][0][ch];
+                    p_sys->y2[j][0][ch] = y;
 
                     o += y * p_sys->f_amp[j];
                 }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
+                p_sys->x2[1][ch] = p_sys->x2[0][ch];
+                p_sys->x2[0][ch] = x2;
 
                 /* We add source PCM + filtered PCM */
                 out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
@@ -30,11 +30,21 @@
 #endif
 
 #include <math.h>
+#include <string.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define EQ_SSE2 1
+#endif
+
+/* State is kept for groups of channels matching the SIMD width */
+#define EQ_LANES 4
 
 /*****************************************************************************
  * Module descriptor
@@ -44,7 +54,7 @@ static void Close( vlc_object_t * );
 static void CalcPeakEQCoeffs( float, float, float, float, float * );
 static void CalcShelfEQCoeffs( float, float, float, int, float, float * );
 static void ProcessEQ( const float *, float *, float *, unsigned, unsigned,
-                       const float *, unsigned );
+                       unsigned, const float *, unsigned );
 static block_t *DoWork( filter_t *, block_t * );
 
 vlc_module_begin ()
@@ -94,6 +104,7 @@ typedef struct
     float   coeffs[5*5];
     /* State */
     float  *p_state;
+    unsigned i_state_channels;
 } filter_sys_t;
 
 
@@ -145,8 +156,15 @@ static int Open( vlc_object_t *p_this )
                       i_samplerate, p_sys->coeffs+3*5);
     CalcShelfEQCoeffs(p_sys->f_highf, 1, p_sys->f_highgain, 0,
                       i_samplerate, p_sys->coeffs+4*5);
-    p_sys->p_state = (float*)calloc( p_filter->fmt_in.audio.i_channels*5*4,
+    p_sys->i_state_channels = (p_filter->fmt_in.audio.i_channels
+                               + EQ_LANES - 1) & ~(EQ_LANES - 1);
+    p_sys->p_state = (float*)calloc( p_sys->i_state_channels*5*4,
                                      sizeof(float) );
+    if( unlikely(p_sys->p_state == NULL) )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
 
     return VLC_SUCCESS;
 }
@@ -168,7 +186,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
     ProcessEQ( (float*)p_in_buf->p_buffer, (float*)p_in_buf->p_buffer,
-               p_sys->p_state,
+               p_sys->p_state, p_sys->i_state_channels,
                p_filter->fmt_in.audio.i_channels, p_in_buf->i_nb_samples,
                p_sys->coeffs, 5 );
     return p_in_buf;
@@ -275,16 +293,81 @@ static void CalcShelfEQCoeffs( float f0, float slope, float gainDB, int high,
     coeffs[4] = a2/a0;
 }
 
+#ifdef EQ_SSE2
+__attribute__ ((__target__ ("sse2")))
+static void ProcessEQSSE2( const float *src, float *dest, float *state,
+                           unsigned stride, unsigned channels,
+                           unsigned samples, const float *coeffs,
+                           unsigned eqCount )
+{
+    for (unsigned i = 0; i < samples; i++)
+    {
+        for (unsigned chn = 0; chn < channels; chn += EQ_LANES)
+        {
+            /* Unused lanes of the last group filter silence */
+            const unsigned lanes = __MIN(channels - chn, EQ_LANES);
+            float buf[EQ_LANES] = { 0.f, 0.f, 0.f, 0.f };
+            const float *coeffs1 = coeffs;
+            float *state1 = state + chn;
+            __m128 x;
+
+            if (lanes == EQ_LANES)
+                x = _mm_loadu_ps(src + chn);
+            else
+            {
+                memcpy(buf, src + chn, lanes * sizeof(float));
+                x = _mm_loadu_ps(buf);
+            }
+
+            /* Direct form 1 IIRs, with the same operations as ProcessEQ() */
+            for (unsigned eq = 0; eq < eqCount; eq++)
+            {
+                const __m128 x1 = _mm_loadu_ps(state1);
+                const __m128 x2 = _mm_loadu_ps(state1 + stride);
+                const __m128 y1 = _mm_loadu_ps(state1 + 2 * stride);
+                const __m128 y2 = _mm_loadu_ps(state1 + 3 * stride);
+                __m128 y;
+
+                y = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(coeffs1[0])),
+                               _mm_mul_ps(x1, _mm_set1_ps(coeffs1[1])));
+                y = _mm_add_ps(y, _mm_mul_ps(x2, _mm_set1_ps(coeffs1[2])));
+                y = _mm_sub_ps(y, _mm_mul_ps(y1, _mm_set1_ps(coeffs1[3])));
+                y = _mm_sub_ps(y, _mm_mul_ps(y2, _mm_set1_ps(coeffs1[4])));
+                coeffs1 += 5;
+
+                _mm_storeu_ps(state1 + stride, x1);
+                _mm_storeu_ps(state1, x);
+                _mm_storeu_ps(state1 + 3 * stride, y1);
+                _mm_storeu_ps(state1 + 2 * stride, y);
+                x = y;
+                state1 += 4 * stride;
+            }
+
+            if (lanes == EQ_LANES)
+                _mm_storeu_ps(dest + chn, x);
+            else
+            {
+                _mm_storeu_ps(buf, x);
+                memcpy(dest + chn, buf, lanes * sizeof(float));
+            }
+        }
+        src += channels;
+        dest += channels;
+    }
+}
+#endif
+
 /*
   src is assumed to be interleaved
   dest is assumed to be interleaved
-  size of state is 4*channels*eqCount
+  state is laid out as [eqCount][4][stride], stride being the channel count
+  rounded up to a multiple of EQ_LANES
   samples is not premultiplied by channels
   size of coeffs is 5*eqCount
 */
-void ProcessEQ( const float *src, float *dest, float *state,
-                unsigned channels, unsigned samples, const float *coeffs,
-                unsigned eqCount )
+static void ProcessEQ( const float *src, float *dest, float *state,
+                       unsigned stride, unsigned channels, unsigned samples,
+                       const float *coeffs, unsigned eqCount )
 {
     unsigned i, chn, eq;
     float   b0, b1, b2, a1, a2;
@@ -292,12 +375,20 @@ void ProcessEQ( const float *src, float *dest, float *state,
     const float *src1 = src;
     float *dest1 = dest;
 
+#ifdef EQ_SSE2
+    if (vlc_CPU_SSE2())
+    {
+        ProcessEQSSE2(src, dest, state, stride, channels, samples, coeffs,
+                      eqCount);
+        return;
+    }
+#endif
     for (i = 0; i < samples; i++)
     {
-        float *state1 = state;
         for (chn = 0; chn < channels; chn++)
         {
             const float *coeffs1 = coeffs;
+            float *state1 = state + chn;
             x = *src1++;
             /* Direct form 1 IIRs */
             for (eq = 0; eq < eqCount; eq++)
@@ -308,16 +399,16 @@ void ProcessEQ( const float *src, float *dest, float *state,
                 a1 = coeffs1[3];
                 a2 = coeffs1[4];
                 coeffs1 += 5;
-                y = x*b0 + state1[0]*b1 + state1[1]*b2 - state1[2]*a1 - state1[3]*a2;
-                state1[1] = state1[0];
+                y = x*b0 + state1[0]*b1 + state1[stride]*b2
+                  - state1[2*stride]*a1 - state1[3*stride]*a2;
+                state1[stride] = state1[0];
                 state1[0] = x;
-                state1[3] = state1[2];
-                state1[2] = y;
+                state1[3*stride] = state1[2*stride];
+                state1[2*stride] = y;
                 x = y;
-                state1 += 4;
+                state1 += 4*stride;
             }
             *dest1++ = y;
         }
     }
 }
-
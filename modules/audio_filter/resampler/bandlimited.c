@@ -41,9 +41,15 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
+#include <vlc_cpu.h>
 
 #include <assert.h>
 
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define BANDLIMITED_SSE2 1
+#endif
+
 #include "bandlimited.h"
 
 /*****************************************************************************
@@ -62,14 +68,36 @@ static void ResampleFloat( filter_t *p_filter,
                            double d_factor, bool b_factor_old,
                            int i_nb_channels, int i_bytes_per_frame );
 
+/* Largest number of phases of the precomputed polyphase filter */
+#define PHASES_MAX 1024
+/* Largest number of coefficients of the precomputed polyphase filter */
+#define COEFFS_MAX (1 << 18)
+
 /*****************************************************************************
  * Local structures
  *****************************************************************************/
+typedef struct
+{
+    uint32_t i_offset;                    /* first coefficient in p_coeffs */
+    uint16_t i_left, i_right;                      /* taps of each wing */
+} phase_t;
+
 typedef struct
 {
     int32_t *p_buf;                        /* this filter introduces a delay */
     size_t i_buf_size;
 
+    /* Filter coefficients for one output sample, when not precomputed */
+    float *p_wings;
+    unsigned i_wings_in_rate, i_wings_out_rate;
+
+    /* Polyphase filter for a rational ratio of the current rates: one set
+     * of wings per remainder, which is always a multiple of i_phase_gcd */
+    float *p_coeffs;
+    phase_t *p_phases;
+    unsigned i_phase_gcd;
+    bool b_phase_up;
+
     double d_old_factor;
     size_t i_old_wing;
 
@@ -79,6 +107,8 @@ typedef struct
     date_t end_date;
 } filter_sys_t;
 
+static int UpdateWings( filter_sys_t *, unsigned, unsigned );
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -143,8 +173,8 @@ static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
                                  p_filter->fmt_out.audio.i_bitspersample / 8;
     size_t i_out_size = i_bytes_per_frame * ( 1 + ( p_in_buf->i_nb_samples *
               p_filter->fmt_out.audio.i_rate / p_filter->fmt_in.audio.i_rate) )
-            + p_filter->p_sys->i_buf_size;
-    block_t *p_out_buf = block_Alloc( i_out_size );
+            + p_sys->i_buf_size;
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out_buf )
     {
         block_Release( p_in_buf );
@@ -166,7 +196,7 @@ static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
 
     size_t i_in_nb = p_in_buf->i_nb_samples;
     size_t i_in, i_out = 0;
-    double d_factor, d_scale_factor, d_old_scale_factor;
+    double d_factor;
     size_t i_filter_wing;
 
 #if 0
@@ -178,6 +208,13 @@ static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
     /* Same format in and out... */
     assert( p_filter->fmt_in.audio.i_bytes_per_frame == i_bytes_per_frame );
 
+    if( UpdateWings( p_sys, p_filter->fmt_in.audio.i_rate, i_out_rate ) )
+    {
+        block_Release( p_out_buf );
+        block_Release( p_in_buf );
+        return NULL;
+    }
+
     /* Prepare the source buffer */
     if( p_sys->i_old_wing )
     {   /* Copy all our samples in p_in_buf */
@@ -202,11 +239,6 @@ static block_t *Resample( filter_t * p_filter, block_t * p_in_buf )
     d_factor = (double)i_out_rate / p_filter->fmt_in.audio.i_rate;
     i_filter_wing = ((SMALL_FILTER_NMULT+1)/2.0) * __MAX(1.0,1.0/d_factor) + 1;
 
-    /* Account for increased filter gain when using factors less than 1 */
-    d_old_scale_factor = SMALL_FILTER_SCALE *
-        p_sys->d_old_factor + 0.5;
-    d_scale_factor = SMALL_FILTER_SCALE * d_factor + 0.5;
-
     /* Apply the old rate until we have enough samples for the new one */
     i_in = p_sys->i_old_wing;
     p_in += p_sys->i_old_wing * i_nb_channels;
@@ -297,12 +329,16 @@ static int OpenFilter( vlc_object_t *p_this )
     }
 
     /* Allocate the memory needed to store the module's structure */
-    p_filter->p_sys = p_sys = malloc( sizeof(struct filter_sys_t) );
+    p_filter->p_sys = p_sys = malloc( sizeof(*p_sys) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
 
     p_sys->p_buf = NULL;
     p_sys->i_buf_size = 0;
+    p_sys->p_wings = NULL;
+    p_sys->i_wings_in_rate = p_sys->i_wings_out_rate = 0;
+    p_sys->p_coeffs = NULL;
+    p_sys->p_phases = NULL;
 
     p_sys->i_old_wing = 0;
     p_sys->b_first = true;
@@ -328,18 +364,26 @@ static int OpenFilter( vlc_object_t *p_this )
 static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    free( p_filter->p_sys->p_buf );
-    free( p_filter->p_sys );
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    free( p_sys->p_coeffs );
+    free( p_sys->p_phases );
+    free( p_sys->p_wings );
+    free( p_sys->p_buf );
+    free( p_sys );
 }
 
-static void FilterFloatUP( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                            float *p_out, uint32_t ui_remainder,
-                            uint32_t ui_output_rate, int16_t Inc, int i_nb_channels )
+/* Computes the interpolated coefficients of one wing of the filter when
+ * upsampling, and returns their number */
+static unsigned WingFloatUP( const float Imp[], const float ImpD[],
+                             uint16_t Nwing, float *p_coeffs,
+                             uint32_t ui_remainder, uint32_t ui_output_rate,
+                             int16_t Inc )
 {
     const float *Hp, *Hdp, *End;
-    float t, temp;
+    float t;
     uint32_t ui_linear_remainder;
-    int i;
+    unsigned n = 0;
 
     Hp = &Imp[(ui_remainder<<Nhc)/ui_output_rate];
     Hdp = &ImpD[(ui_remainder<<Nhc)/ui_output_rate];
@@ -363,27 +407,25 @@ static void FilterFloatUP( const float Imp[], const float ImpD[], uint16_t Nwing
         t = *Hp;                /* Get filter coeff */
                                 /* t is now interp'd filter coeff */
         t += *Hdp * ui_linear_remainder / ui_output_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
+        p_coeffs[n++] = t;
         Hdp += Npc;             /* Filter coeff differences step */
         Hp += Npc;              /* Filter coeff step */
-        p_in += (Inc * i_nb_channels); /* Input signal step */
     }
+    return n;
 }
 
-static void FilterFloatUD( const float Imp[], const float ImpD[], uint16_t Nwing, float *p_in,
-                           float *p_out, uint32_t ui_remainder,
-                           uint32_t ui_output_rate, uint32_t ui_input_rate,
-                           int16_t Inc, int i_nb_channels )
+/* Computes the interpolated coefficients of one wing of the filter when
+ * downsampling, and returns their number */
+static unsigned WingFloatUD( const float Imp[], const float ImpD[],
+                             uint16_t Nwing, float *p_coeffs,
+                             uint32_t ui_remainder, uint32_t ui_output_rate,
+                             uint32_t ui_input_rate, int16_t Inc )
 {
     const float *Hp, *Hdp, *End;
-    float t, temp;
+    float t;
     uint32_t ui_linear_remainder;
-    int i, ui_counter = 0;
+    int ui_counter = 0;
+    unsigned n = 0;
 
     Hp = Imp + (ui_remainder<<Nhc) / ui_input_rate;
     Hdp = ImpD  + (ui_remainder<<Nhc) / ui_input_rate;
@@ -411,12 +453,7 @@ static void FilterFloatUD( const float Imp[], const float ImpD[], uint16_t Nwing
           ((ui_output_rate * ui_counter + ui_remainder)<< Nhc) /
           ui_input_rate * ui_input_rate;
         t += *Hdp * ui_linear_remainder / ui_input_rate / Npc;
-        for( i = 0; i < i_nb_channels; i++ )
-        {
-            temp = t;
-            temp *= *(p_in+i);  /* Mult coeff by input sample */
-            *(p_out+i) += temp; /* The filter output */
-        }
+        p_coeffs[n++] = t;
 
         ui_counter++;
 
@@ -426,7 +463,175 @@ static void FilterFloatUD( const float Imp[], const float ImpD[], uint16_t Nwing
         /* Filter coeff differences step */
         Hdp = ImpD + ((ui_output_rate * ui_counter + ui_remainder)<< Nhc)
                      / ui_input_rate;
+    }
+    return n;
+}
+
+/* Upper bound of the taps of one wing, whatever the remainder and the
+ * filtering direction */
+static unsigned WingMaxTaps( unsigned i_in_rate, unsigned i_out_rate )
+{
+    return (uint64_t)SMALL_FILTER_NWING * __MAX(i_in_rate, i_out_rate)
+           / ((uint64_t)Npc * i_out_rate) + 2;
+}
+
+/* Computes both wings for the given remainder, the left one first */
+static void Wings( unsigned *pi_left, unsigned *pi_right, float *p_coeffs,
+                   uint32_t ui_remainder, uint32_t ui_input_rate,
+                   uint32_t ui_output_rate, bool b_up )
+{
+    if( b_up )
+    {
+        *pi_left = WingFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
+                                SMALL_FILTER_NWING, p_coeffs, ui_remainder,
+                                ui_output_rate, -1 );
+        *pi_right = WingFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
+                                 SMALL_FILTER_NWING, p_coeffs + *pi_left,
+                                 ui_output_rate - ui_remainder,
+                                 ui_output_rate, 1 );
+    }
+    else
+    {
+        *pi_left = WingFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
+                                SMALL_FILTER_NWING, p_coeffs, ui_remainder,
+                                ui_output_rate, ui_input_rate, -1 );
+        *pi_right = WingFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
+                                 SMALL_FILTER_NWING, p_coeffs + *pi_left,
+                                 ui_output_rate - ui_remainder,
+                                 ui_output_rate, ui_input_rate, 1 );
+    }
+}
 
+/*****************************************************************************
+ * UpdateWings: prepare the filter coefficients for the current rates
+ *****************************************************************************
+ * The remainder only takes out_rate / gcd(in_rate, out_rate) values, so for
+ * the usual rational ratios (e.g. 160 for 44.1 -> 48 kHz) the coefficients
+ * of every phase are computed once. Otherwise, as when the audio output
+ * corrects the drift by nudging the input rate, they are computed again for
+ * every output sample.
+ *****************************************************************************/
+static int UpdateWings( filter_sys_t *p_sys, unsigned i_in_rate,
+                        unsigned i_out_rate )
+{
+    if( i_in_rate == p_sys->i_wings_in_rate
+     && i_out_rate == p_sys->i_wings_out_rate )
+        return VLC_SUCCESS;
+
+    const unsigned i_taps = 2 * WingMaxTaps( i_in_rate, i_out_rate );
+    float *p_wings = realloc( p_sys->p_wings, i_taps * sizeof(float) );
+    if( unlikely(p_wings == NULL) )
+        return VLC_ENOMEM;
+    p_sys->p_wings = p_wings;
+    p_sys->i_wings_in_rate = i_in_rate;
+    p_sys->i_wings_out_rate = i_out_rate;
+
+    free( p_sys->p_coeffs );
+    free( p_sys->p_phases );
+    p_sys->p_coeffs = NULL;
+    p_sys->p_phases = NULL;
+
+    const unsigned i_gcd = GCD( i_in_rate, i_out_rate );
+    const unsigned i_phases = i_out_rate / i_gcd;
+    if( i_phases > PHASES_MAX || (uint64_t)i_phases * i_taps > COEFFS_MAX )
+        return VLC_SUCCESS;
+
+    float *p_coeffs = vlc_alloc( i_phases * i_taps, sizeof(float) );
+    phase_t *p_phases = vlc_alloc( i_phases, sizeof(*p_phases) );
+    if( unlikely(p_coeffs == NULL || p_phases == NULL) )
+    {
+        free( p_coeffs );
+        free( p_phases );
+        return VLC_SUCCESS;
+    }
+
+    const bool b_up = i_out_rate >= i_in_rate;
+    uint32_t i_offset = 0;
+    for( unsigned i = 0; i < i_phases; i++ )
+    {
+        unsigned i_left, i_right;
+
+        Wings( &i_left, &i_right, p_coeffs + i_offset, i * i_gcd,
+               i_in_rate, i_out_rate, b_up );
+        p_phases[i].i_offset = i_offset;
+        p_phases[i].i_left = i_left;
+        p_phases[i].i_right = i_right;
+        i_offset += i_left + i_right;
+    }
+
+    p_sys->p_coeffs = p_coeffs;
+    p_sys->p_phases = p_phases;
+    p_sys->i_phase_gcd = i_gcd;
+    p_sys->b_phase_up = b_up;
+    return VLC_SUCCESS;
+}
+
+#ifdef BANDLIMITED_SSE2
+__attribute__ ((__target__ ("sse2")))
+static void FilterWingSSE2( const float *p_coeffs, unsigned i_taps,
+                            const float *p_in, float *p_out, int Inc,
+                            int i_nb_channels )
+{
+    const ptrdiff_t i_step = Inc * i_nb_channels;
+    int i = 0;
+
+    for( ; i + 4 <= i_nb_channels; i += 4 )
+    {
+        const float *p = p_in + i;
+        __m128 acc = _mm_loadu_ps( p_out + i );
+
+        for( unsigned k = 0; k < i_taps; k++, p += i_step )
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( p_coeffs[k] ),
+                                               _mm_loadu_ps( p ) ) );
+        _mm_storeu_ps( p_out + i, acc );
+    }
+
+    if( i + 2 <= i_nb_channels )
+    {
+        const float *p = p_in + i;
+        __m128 acc = _mm_castpd_ps( _mm_load_sd( (double *)(p_out + i) ) );
+
+        for( unsigned k = 0; k < i_taps; k++, p += i_step )
+        {
+            __m128 in = _mm_castpd_ps( _mm_load_sd( (const double *)p ) );
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( p_coeffs[k] ),
+                                               in ) );
+        }
+        _mm_store_sd( (double *)(p_out + i), _mm_castps_pd( acc ) );
+        i += 2;
+    }
+
+    if( i < i_nb_channels )
+    {
+        const float *p = p_in + i;
+
+        for( unsigned k = 0; k < i_taps; k++, p += i_step )
+            p_out[i] += p_coeffs[k] * *p;
+    }
+}
+#endif
+
+/* Accumulates the inner product of one wing with the input samples into
+ * every channel of the output frame */
+static void FilterWing( const float *p_coeffs, unsigned i_taps,
+                        const float *p_in, float *p_out, int Inc,
+                        int i_nb_channels )
+{
+#ifdef BANDLIMITED_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        FilterWingSSE2( p_coeffs, i_taps, p_in, p_out, Inc, i_nb_channels );
+        return;
+    }
+#endif
+    for( unsigned k = 0; k < i_taps; k++ )
+    {
+        for( int i = 0; i < i_nb_channels; i++ )
+        {
+            float temp = p_coeffs[k];
+            temp *= *(p_in+i);  /* Mult coeff by input sample */
+            *(p_out+i) += temp; /* The filter output */
+        }
         p_in += (Inc * i_nb_channels); /* Input signal step */
     }
 }
@@ -485,48 +690,31 @@ static void ResampleFloat( filter_t *p_filter,
                                i_out, i_nb_channels, i_bytes_per_frame ) )
                 return;
 
-            if( d_factor >= 1 )
+            /* WingFloatUP() is faster if we can use it */
+            const bool b_up = d_factor >= 1;
+            const float *p_wings = p_sys->p_wings;
+            unsigned i_left, i_right;
+
+            if( p_sys->p_phases != NULL && p_sys->b_phase_up == b_up
+             && p_sys->i_remainder % p_sys->i_phase_gcd == 0 )
             {
-                /* FilterFloatUP() is faster if we can use it */
-
-                /* Perform left-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUP( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate,
-                               1, i_nb_channels );
+                const phase_t *p_phase =
+                    &p_sys->p_phases[p_sys->i_remainder / p_sys->i_phase_gcd];
 
-#if 0
-                /* Normalize for unity filter gain */
-                for( i = 0; i < i_nb_channels; i++ )
-                {
-                    *(p_out+i) *= d_old_scale_factor;
-                }
-#endif
+                p_wings = p_sys->p_coeffs + p_phase->i_offset;
+                i_left = p_phase->i_left;
+                i_right = p_phase->i_right;
             }
             else
-            {
-                /* Perform left-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in, p_out,
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               -1, i_nb_channels );
-                /* Perform right-wing inner product */
-                FilterFloatUD( SMALL_FILTER_FLOAT_IMP, SMALL_FILTER_FLOAT_IMPD,
-                               SMALL_FILTER_NWING, p_in + i_nb_channels, p_out,
-                               p_filter->fmt_out.audio.i_rate -
-                               p_sys->i_remainder,
-                               p_filter->fmt_out.audio.i_rate, p_filter->fmt_in.audio.i_rate,
-                               1, i_nb_channels );
-            }
+                Wings( &i_left, &i_right, p_sys->p_wings, p_sys->i_remainder,
+                       p_filter->fmt_in.audio.i_rate,
+                       p_filter->fmt_out.audio.i_rate, b_up );
+
+            /* Perform left-wing inner product */
+            FilterWing( p_wings, i_left, p_in, p_out, -1, i_nb_channels );
+            /* Perform right-wing inner product */
+            FilterWing( p_wings + i_left, i_right, p_in + i_nb_channels,
+                        p_out, 1, i_nb_channels );
 
             p_out += i_nb_channels;
             i_out++;
@@ -36,6 +36,8 @@
 #include <stdatomic.h>
 #include <string.h> /* for memset */
 #include <limits.h> /* form INT_MIN */
+#include <math.h>
+#include <float.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -129,6 +131,11 @@ typedef struct
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    /* FFT cross correlation, for long overlaps and searches */
+    unsigned  fft_size;
+    float    *fft_buf;      /* fft_size interleaved complex values */
+    float    *fft_twiddle;  /* fft_size / 2 interleaved complex values */
+    float     fft_norm;     /* brings the window weights down to about 1 */
 #ifdef PITCH_SHIFTER
     /* pitch */
     filter_t * resampler;
@@ -136,16 +143,16 @@ typedef struct
 #endif
 } filter_sys_t;
 
+/* Relative cost of an FFT butterfly, compared to a multiply-add */
+#define FFT_COST 10
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
-static unsigned best_overlap_offset_float( filter_t *p_filter )
+static void pre_correlate_float( filter_sys_t *p )
 {
-    filter_sys_t *p = p_filter->p_sys;
-    float *pw, *po, *ppc, *search_start;
-    float best_corr = INT_MIN;
-    unsigned best_off = 0;
-    unsigned i, off;
+    float *pw, *po, *ppc;
+    unsigned i;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -154,14 +161,34 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
       *ppc++ = *pw++ * *po++;
     }
+}
+
+static unsigned best_overlap_offset_float( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const float *ppc, *search_start;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    unsigned i, off;
+    const unsigned count = p->samples_overlap - p->samples_per_frame;
+
+    pre_correlate_float( p );
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
+    ppc = p->buf_pre_corr;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
+      /* Independent partial sums, so that the compiler can vectorize */
+      float corr4[4] = { 0, 0, 0, 0 };
+      const float *ps = search_start;
+      for( i = 0; i + 4 <= count; i += 4 ) {
+        corr4[0] += ppc[i]     * ps[i];
+        corr4[1] += ppc[i + 1] * ps[i + 1];
+        corr4[2] += ppc[i + 2] * ps[i + 2];
+        corr4[3] += ppc[i + 3] * ps[i + 3];
+      }
+      float corr = ( corr4[0] + corr4[1] ) + ( corr4[2] + corr4[3] );
+      for( ; i < count; i++ ) {
+        corr += ppc[i] * ps[i];
       }
       if( corr > best_corr ) {
         best_corr = corr;
@@ -173,6 +200,115 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     return best_off * p->bytes_per_frame;
 }
 
+/* In-place radix-2 FFT of n interleaved complex values */
+static void fft_float( float *buf, const float *twiddle, unsigned n,
+                       bool inverse )
+{
+    for( unsigned i = 1, j = 0; i < n; i++ ) {
+      unsigned bit = n >> 1;
+      for( ; j & bit; bit >>= 1 )
+        j ^= bit;
+      j |= bit;
+      if( i < j ) {
+        float re = buf[2 * i], im = buf[2 * i + 1];
+        buf[2 * i]     = buf[2 * j];
+        buf[2 * i + 1] = buf[2 * j + 1];
+        buf[2 * j]     = re;
+        buf[2 * j + 1] = im;
+      }
+    }
+
+    const float sign = inverse ? -1.f : 1.f;
+    for( unsigned len = 2; len <= n; len <<= 1 ) {
+      const unsigned half = len >> 1, step = n / len;
+      for( unsigned start = 0; start < n; start += len ) {
+        for( unsigned k = 0; k < half; k++ ) {
+          const float wr = twiddle[2 * k * step];
+          const float wi = sign * twiddle[2 * k * step + 1];
+          float *a = &buf[2 * ( start + k )];
+          float *b = &buf[2 * ( start + k + half )];
+          const float tr = b[0] * wr - b[1] * wi;
+          const float ti = b[0] * wi + b[1] * wr;
+          b[0] = a[0] - tr;
+          b[1] = a[1] - ti;
+          a[0] += tr;
+          a[1] += ti;
+        }
+      }
+    }
+}
+
+/*
+ * Same search as best_overlap_offset_float(), with the cross correlation of
+ * all offsets computed at once in the frequency domain. The pre-correlation
+ * and the search window are both real, so they share one complex FFT.
+ */
+static unsigned best_overlap_offset_fft( filter_t *p_filter )
+{
+    filter_sys_t *p = p_filter->p_sys;
+    const unsigned n = p->fft_size;
+    const unsigned count = p->samples_overlap - p->samples_per_frame;
+    const unsigned window = count + ( p->frames_search - 1 ) * p->samples_per_frame;
+    const float *ppc = p->buf_pre_corr;
+    const float *search_start = (float *)p->buf_queue + p->samples_per_frame;
+    float *x = p->fft_buf;
+    float energy = 0;
+    unsigned i;
+
+    pre_correlate_float( p );
+
+    /* Both signals must have similar magnitudes, or the smaller one is lost
+     * in rounding errors when the spectra are split */
+    for( i = 0; i < count; i++ ) {
+      x[2 * i]     = ppc[i] * p->fft_norm;
+      x[2 * i + 1] = search_start[i];
+      energy += x[2 * i] * x[2 * i];
+    }
+    for( ; i < window; i++ ) {
+      x[2 * i]     = 0;
+      x[2 * i + 1] = search_start[i];
+    }
+    for( i = 0; i < window; i++ )
+      energy += x[2 * i + 1] * x[2 * i + 1];
+    memset( &x[2 * window], 0, ( n - window ) * 2 * sizeof( *x ) );
+
+    fft_float( x, p->fft_twiddle, n, false );
+
+    /* Split the spectra of the pre-correlation (A) and the search window (B),
+     * and replace them with their cross spectrum conj(A).B */
+    for( unsigned k = 0; k <= n / 2; k++ ) {
+      const unsigned nk = ( n - k ) & ( n - 1 );
+      const float ar = ( x[2 * k] + x[2 * nk] ) * .5f;
+      const float ai = ( x[2 * k + 1] - x[2 * nk + 1] ) * .5f;
+      const float br = ( x[2 * k + 1] + x[2 * nk + 1] ) * .5f;
+      const float bi = ( x[2 * nk] - x[2 * k] ) * .5f;
+      const float cr = ar * br + ai * bi;
+      const float ci = ar * bi - ai * br;
+      x[2 * k]      = cr;
+      x[2 * k + 1]  = ci;
+      x[2 * nk]     = cr;
+      x[2 * nk + 1] = -ci;
+    }
+
+    fft_float( x, p->fft_twiddle, n, true );
+
+    /* The real part now holds the correlation for each sample lag, scaled by
+     * n. Differences below the rounding errors are ties, which go to the
+     * first offset as in the direct search (e.g. with silence). */
+    const float tolerance = FLT_EPSILON * n * ctz( n ) * energy;
+    float best_corr = INT_MIN;
+    unsigned best_off = 0;
+    for( unsigned off = 0; off < p->frames_search; off++ ) {
+      const float corr = x[2 * off * p->samples_per_frame];
+      if( corr > best_corr + tolerance ) {
+        best_corr = corr;
+        best_off  = off;
+      }
+    }
+
+    return best_off * p->bytes_per_frame;
+}
+
 /*****************************************************************************
  * output_overlap: blend end of previous stride with beginning of current stride
  *****************************************************************************/
@@ -352,6 +488,39 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+
+        /* The direct search costs a multiply-add per overlap sample and
+         * offset, the FFT search about FFT_COST * N log2(N) of them */
+        unsigned window = p->samples_overlap - p->samples_per_frame
+                        + ( p->frames_search - 1 ) * p->samples_per_frame;
+        unsigned fft_size = 2, fft_log2 = 1;
+        while( fft_size < window )
+        {
+            fft_size <<= 1;
+            fft_log2++;
+        }
+        uint64_t direct_cost = (uint64_t)p->frames_search
+                             * ( p->samples_overlap - p->samples_per_frame );
+        free( p->fft_buf );
+        free( p->fft_twiddle );
+        p->fft_buf = p->fft_twiddle = NULL;
+        p->fft_size = 0;
+        if( direct_cost > FFT_COST * fft_size * fft_log2 )
+        {
+            p->fft_buf     = vlc_alloc( 2 * fft_size, sizeof( float ) );
+            p->fft_twiddle = vlc_alloc( fft_size, sizeof( float ) );
+            if( !p->fft_buf || !p->fft_twiddle )
+                return VLC_ENOMEM;
+            for( i = 0; i < fft_size / 2; i++ )
+            {
+                double phase = -2. * M_PI * i / fft_size;
+                p->fft_twiddle[2 * i]     = cos( phase );
+                p->fft_twiddle[2 * i + 1] = sin( phase );
+            }
+            p->fft_size = fft_size;
+            p->fft_norm = 4.f / ( (float)frames_overlap * frames_overlap );
+            p->best_overlap_offset = best_overlap_offset_fft;
+        }
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -381,13 +550,13 @@ static int reinit_buffers( filter_t *p_filter )
     p->frames_stride_scaled = p->bytes_stride_scaled / p->bytes_per_frame;
 
     msg_Dbg( VLC_OBJECT(p_filter),
-             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search, %i queue, %s mode",
+             "%.3f scale, %.3f stride_in, %i stride_out, %i standing, %i overlap, %i search%s, %i queue, %s mode",
              p->scale,
              p->frames_stride_scaled,
              (int)( p->bytes_stride / p->bytes_per_frame ),
              (int)( p->bytes_standing / p->bytes_per_frame ),
              (int)( p->bytes_overlap / p->bytes_per_frame ),
-             p->frames_search,
+             p->frames_search, p->fft_size ? " (FFT)" : "",
              (int)( p->bytes_queue_max / p->bytes_per_frame ),
              "fl32");
 
@@ -430,6 +599,9 @@ static int Open( vlc_object_t *p_this )
     p_sys->table_blend    = NULL;
     p_sys->buf_pre_corr   = NULL;
     p_sys->table_window   = NULL;
+    p_sys->fft_size       = 0;
+    p_sys->fft_buf        = NULL;
+    p_sys->fft_twiddle    = NULL;
     p_sys->bytes_overlap  = 0;
     p_sys->bytes_queued   = 0;
     p_sys->bytes_to_slide = 0;
@@ -525,6 +697,8 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->table_blend );
     free( p_sys->buf_pre_corr );
     free( p_sys->table_window );
+    free( p_sys->fft_buf );
+    free( p_sys->fft_twiddle );
     free( p_sys );
 }
 
@@ -570,7 +744,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
                                    p_in_buf->i_buffer, 0 );
     if( i_outsize > 0 )
     {
-        p_out_buf = block_Alloc( i_outsize );
+        p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
         if( p_out_buf == NULL )
         {
             block_Release( p_in_buf );
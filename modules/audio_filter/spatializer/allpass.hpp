@@ -14,6 +14,7 @@ public:
         allpass();
     void    setbuffer(float *buf, int size);
     inline  float    process(float inp);
+    inline  void     processblock(float *inout, int n);
     void    mute();
     void    setfeedback(float val);
     float    getfeedback();
@@ -42,6 +43,33 @@ inline float allpass::process(float input)
     return output;
 }
 
+// Filters n samples in place, n being at most the buffer size
+inline void allpass::processblock(float *__restrict inout, int n)
+{
+    while (n > 0)
+    {
+        int count = bufsize - bufidx;
+        if (count > n)
+            count = n;
+
+        float *__restrict buf = buffer + bufidx;
+        for (int i = 0; i < count; i++)
+        {
+            float input = inout[i];
+            float bufout = block_undenormalise( buf[i] );
+
+            inout[i] = -input + bufout;
+            buf[i] = input + (bufout*feedback);
+        }
+
+        bufidx += count;
+        if (bufidx >= bufsize)
+            bufidx = 0;
+        inout += count;
+        n -= count;
+    }
+}
+
 #endif//_allpass
 
 //ends
@@ -19,6 +19,7 @@ public:
     comb();
     void    setbuffer(float *buf, int size);
     inline  float    process(float inp);
+    inline  void     processblock(const float *inp, float *out, int n);
     void    mute();
     void    setdamp(float val);
     float    getdamp();
@@ -55,6 +56,35 @@ inline float comb::process(float input)
     return output;
 }
 
+// Accumulates the output of n samples into out. As n must not exceed the
+// buffer size, no sample written here is read back within the block.
+inline void comb::processblock(const float *__restrict input,
+                               float *__restrict output, int n)
+{
+    while (n > 0)
+    {
+        int count = bufsize - bufidx;
+        if (count > n)
+            count = n;
+
+        float *__restrict buf = buffer + bufidx;
+        for (int i = 0; i < count; i++)
+        {
+            float out = block_undenormalise( buf[i] );
+
+            output[i] += out;
+            buf[i] = input[i] + block_undenormalise(out*damp2)*feedback;
+        }
+
+        bufidx += count;
+        if (bufidx >= bufsize)
+            bufidx = 0;
+        input += count;
+        output += count;
+        n -= count;
+    }
+}
+
 #endif //_comb_
 
 //ends
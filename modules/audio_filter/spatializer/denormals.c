@@ -19,3 +19,44 @@ float undenormalise( float f )
         return 0.0;
     return f;
 }
+
+#if defined(__SSE_MATH__)
+# include <xmmintrin.h>
+
+unsigned long denormals_disable( void )
+{
+    unsigned csr = _mm_getcsr();
+
+    _mm_setcsr( csr | 0x8040 ); /* FTZ | DAZ */
+    return csr;
+}
+
+void denormals_restore( unsigned long csr )
+{
+    _mm_setcsr( csr );
+}
+#elif defined(__aarch64__)
+unsigned long denormals_disable( void )
+{
+    unsigned long fpcr;
+
+    __asm__ volatile ("mrs %0, fpcr" : "=r" (fpcr));
+    __asm__ volatile ("msr fpcr, %0" : : "r" (fpcr | (1ul << 24))); /* FZ */
+    return fpcr;
+}
+
+void denormals_restore( unsigned long fpcr )
+{
+    __asm__ volatile ("msr fpcr, %0" : : "r" (fpcr));
+}
+#else
+unsigned long denormals_disable( void )
+{
+    return 0;
+}
+
+void denormals_restore( unsigned long mode )
+{
+    (void) mode;
+}
+#endif
@@ -8,11 +8,25 @@
 #ifndef _denormals_
 #define _denormals_
 
+/* Where the FPU can flush denormals to zero by itself, there is no need to
+ * check every sample: see denormals_disable(). */
+#if defined(__SSE_MATH__) || defined(__aarch64__)
+# define DENORMALS_FTZ 1
+# define block_undenormalise(f) (f)
+#else
+# define block_undenormalise(f) undenormalise(f)
+#endif
 
 #ifdef __cplusplus
-extern "C"
+extern "C" {
 #endif
 float undenormalise( float );
+/* Flushes denormals to zero in the calling thread, returns the former mode */
+unsigned long denormals_disable( void );
+void denormals_restore( unsigned long );
+#ifdef __cplusplus
+}
+#endif
 
 #endif//_denormals_
 
@@ -155,6 +155,70 @@ void revmodel::processmix(float *inputL, float *outputL, long /* numsamples */,
         outputL[1] += (outR*wet1 + outL*wet2 + inputR*dry);
 }
 
+/*****************************************************************************
+ *  Transforms a block of audio, one filter at a time
+ * /param float *input      input buffer
+ * /param float *output     output buffer, may be the input buffer
+ * /param long numsamples   number of frames to be processed
+ * /param int skip          number of channels in the audio stream
+ *****************************************************************************/
+void revmodel::processblock(const float *input, float *output, long numsamples, int skip)
+{
+    /* Shorter than every delay line, so that the filters need not run
+     * sample by sample */
+    static const int blocksize = 128;
+    static_assert(blocksize <= allpasstuningL4 && blocksize <= combtuningL1,
+                  "block longer than a delay line");
+
+    float in[blocksize], inR[blocksize];
+    float outL[blocksize], outR[blocksize];
+
+    unsigned long fpmode = denormals_disable();
+
+    while (numsamples > 0)
+    {
+        int count = (numsamples < blocksize) ? numsamples : blocksize;
+
+        for (int j = 0; j < count; j++)
+        {
+            /* TODO this module supports only 2 audio channels, let's improve this */
+            float inputR = input[j * skip + (skip > 1)];
+
+            inR[j] = inputR;
+            in[j] = (input[j * skip] + inputR) * gain;
+            outL[j] = outR[j] = 0;
+        }
+
+        // Accumulate comb filters in parallel
+        for (int i = 0; i < numcombs; i++)
+        {
+            combL[i].processblock(in, outL, count);
+            combR[i].processblock(in, outR, count);
+        }
+
+        // Feed through allpasses in series
+        for (int i = 0; i < numallpasses; i++)
+        {
+            allpassL[i].processblock(outL, count);
+            allpassR[i].processblock(outR, count);
+        }
+
+        // Calculate output REPLACING anything already there
+        for (int j = 0; j < count; j++)
+        {
+            output[j * skip] = outL[j]*wet1 + outR[j]*wet2 + inR[j]*dry;
+            if (skip > 1)
+                output[j * skip + 1] = outR[j]*wet1 + outL[j]*wet2 + inR[j]*dry;
+        }
+
+        input += count * skip;
+        output += count * skip;
+        numsamples -= count;
+    }
+
+    denormals_restore(fpmode);
+}
+
 void revmodel::update()
 {
 // Recalculate internal values after parameter change
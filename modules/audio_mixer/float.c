@@ -33,6 +33,23 @@
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_aout_volume.h>
+#include <vlc_cpu.h>
+
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define VOLUME_SSE2 1
+#endif
+#if defined(VOLUME_SSE2) && defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define VOLUME_AVX2 1
+#endif
+#if defined(VOLUME_AVX2) && defined(HAVE_AVX512_INTRINSICS)
+# define VOLUME_AVX512 1
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define VOLUME_NEON64 1
+#endif
 
 /*****************************************************************************
  * Local prototypes
@@ -80,6 +97,226 @@ static void FilterFL64( audio_volume_t *p_volume, block_t *p_buffer,
     (void) p_volume;
 }
 
+#ifdef VOLUME_SSE2
+__attribute__ ((__target__ ("sse2")))
+static void FilterFL32_SSE2( audio_volume_t *p_volume, block_t *p_buffer,
+                             float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m128 mult = _mm_set1_ps( f_multiplier );
+
+    for( ; i >= 8; i -= 8, p += 8 )
+    {
+        _mm_storeu_ps( p, _mm_mul_ps( _mm_loadu_ps( p ), mult ) );
+        _mm_storeu_ps( p + 4, _mm_mul_ps( _mm_loadu_ps( p + 4 ), mult ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= f_multiplier;
+
+    (void) p_volume;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void FilterFL64_SSE2( audio_volume_t *p_volume, block_t *p_buffer,
+                             float f_multiplier )
+{
+    double *p = (double *)p_buffer->p_buffer;
+    double mult = f_multiplier;
+    if( mult == 1. )
+        return; /* nothing to do */
+
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m128d vmult = _mm_set1_pd( mult );
+
+    for( ; i >= 4; i -= 4, p += 4 )
+    {
+        _mm_storeu_pd( p, _mm_mul_pd( _mm_loadu_pd( p ), vmult ) );
+        _mm_storeu_pd( p + 2, _mm_mul_pd( _mm_loadu_pd( p + 2 ), vmult ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= mult;
+
+    (void) p_volume;
+}
+#endif
+
+#ifdef VOLUME_AVX2
+__attribute__ ((__target__ ("avx2")))
+static void FilterFL32_AVX2( audio_volume_t *p_volume, block_t *p_buffer,
+                             float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m256 mult = _mm256_set1_ps( f_multiplier );
+
+    for( ; i >= 16; i -= 16, p += 16 )
+    {
+        _mm256_storeu_ps( p, _mm256_mul_ps( _mm256_loadu_ps( p ), mult ) );
+        _mm256_storeu_ps( p + 8,
+                          _mm256_mul_ps( _mm256_loadu_ps( p + 8 ), mult ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= f_multiplier;
+
+    (void) p_volume;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void FilterFL64_AVX2( audio_volume_t *p_volume, block_t *p_buffer,
+                             float f_multiplier )
+{
+    double *p = (double *)p_buffer->p_buffer;
+    double mult = f_multiplier;
+    if( mult == 1. )
+        return; /* nothing to do */
+
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m256d vmult = _mm256_set1_pd( mult );
+
+    for( ; i >= 8; i -= 8, p += 8 )
+    {
+        _mm256_storeu_pd( p, _mm256_mul_pd( _mm256_loadu_pd( p ), vmult ) );
+        _mm256_storeu_pd( p + 4,
+                          _mm256_mul_pd( _mm256_loadu_pd( p + 4 ), vmult ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= mult;
+
+    (void) p_volume;
+}
+#endif
+
+#ifdef VOLUME_AVX512
+__attribute__ ((__target__ ("avx512f")))
+static void FilterFL32_AVX512( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m512 mult = _mm512_set1_ps( f_multiplier );
+
+    for( ; i >= 16; i -= 16, p += 16 )
+        _mm512_storeu_ps( p, _mm512_mul_ps( _mm512_loadu_ps( p ), mult ) );
+
+    /* Masked tail: no scalar loop */
+    const __mmask16 tail = (1u << i) - 1;
+    _mm512_mask_storeu_ps( p, tail,
+                           _mm512_mul_ps( _mm512_maskz_loadu_ps( tail, p ),
+                                          mult ) );
+    (void) p_volume;
+}
+
+__attribute__ ((__target__ ("avx512f")))
+static void FilterFL64_AVX512( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_multiplier )
+{
+    double *p = (double *)p_buffer->p_buffer;
+    double mult = f_multiplier;
+    if( mult == 1. )
+        return; /* nothing to do */
+
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+    const __m512d vmult = _mm512_set1_pd( mult );
+
+    for( ; i >= 8; i -= 8, p += 8 )
+        _mm512_storeu_pd( p, _mm512_mul_pd( _mm512_loadu_pd( p ), vmult ) );
+
+    const __mmask8 tail = (1u << i) - 1;
+    _mm512_mask_storeu_pd( p, tail,
+                           _mm512_mul_pd( _mm512_maskz_loadu_pd( tail, p ),
+                                          vmult ) );
+    (void) p_volume;
+}
+#endif
+
+#ifdef VOLUME_NEON64
+static void FilterFL32_NEON64( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_multiplier )
+{
+    if( f_multiplier == 1.f )
+        return; /* nothing to do */
+
+    float *p = (float *)p_buffer->p_buffer;
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+
+    for( ; i >= 8; i -= 8, p += 8 )
+    {
+        vst1q_f32( p, vmulq_n_f32( vld1q_f32( p ), f_multiplier ) );
+        vst1q_f32( p + 4, vmulq_n_f32( vld1q_f32( p + 4 ), f_multiplier ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= f_multiplier;
+
+    (void) p_volume;
+}
+
+static void FilterFL64_NEON64( audio_volume_t *p_volume, block_t *p_buffer,
+                               float f_multiplier )
+{
+    double *p = (double *)p_buffer->p_buffer;
+    double mult = f_multiplier;
+    if( mult == 1. )
+        return; /* nothing to do */
+
+    size_t i = p_buffer->i_buffer / sizeof(*p);
+
+    for( ; i >= 4; i -= 4, p += 4 )
+    {
+        vst1q_f64( p, vmulq_n_f64( vld1q_f64( p ), mult ) );
+        vst1q_f64( p + 2, vmulq_n_f64( vld1q_f64( p + 2 ), mult ) );
+    }
+    for( ; i > 0; i-- )
+        *(p++) *= mult;
+
+    (void) p_volume;
+}
+#endif
+
+typedef void (*amplify_fn)( audio_volume_t *, block_t *, float );
+
+/* NEON is always available when VOLUME_NEON64 is defined */
+static const VLC_CPU_TABLE(amplify_fn) fl32_impls[] = {
+#ifdef VOLUME_AVX512
+    { VLC_CPU_AVX512, FilterFL32_AVX512 },
+#endif
+#ifdef VOLUME_AVX2
+    { VLC_CPU_AVX2, FilterFL32_AVX2 },
+#endif
+#ifdef VOLUME_SSE2
+    { VLC_CPU_SSE2, FilterFL32_SSE2 },
+#endif
+#ifdef VOLUME_NEON64
+    { 0, FilterFL32_NEON64 },
+#endif
+    { 0, FilterFL32 },
+};
+
+static const VLC_CPU_TABLE(amplify_fn) fl64_impls[] = {
+#ifdef VOLUME_AVX512
+    { VLC_CPU_AVX512, FilterFL64_AVX512 },
+#endif
+#ifdef VOLUME_AVX2
+    { VLC_CPU_AVX2, FilterFL64_AVX2 },
+#endif
+#ifdef VOLUME_SSE2
+    { VLC_CPU_SSE2, FilterFL64_SSE2 },
+#endif
+#ifdef VOLUME_NEON64
+    { 0, FilterFL64_NEON64 },
+#endif
+    { 0, FilterFL64 },
+};
+
 /**
  * Initializes the mixer
  */
@@ -90,10 +327,10 @@ static int Create( vlc_object_t *p_this )
     switch (p_volume->format)
     {
         case VLC_CODEC_FL32:
-            p_volume->amplify = FilterFL32;
+            p_volume->amplify = vlc_CPU_Select( fl32_impls );
             break;
         case VLC_CODEC_FL64:
-            p_volume->amplify = FilterFL64;
+            p_volume->amplify = vlc_CPU_Select( fl64_impls );
             break;
         default:
             return -1;
@@ -47,6 +47,9 @@ typedef struct
     vlc_fourcc_t format; /**< Sample format */
     uint8_t chans_table[AOUT_CHAN_MAX]; /**< Channels order table */
     uint8_t chans_to_reorder; /**< Number of channels to reorder */
+    bool mmap; /**< Memory-mapped transfers */
+    snd_pcm_uframes_t period_size; /**< Frames per period */
+    bool tstamp; /**< Delay corrected with the status time stamp */
 
     bool soft_mute;
     float soft_gain;
@@ -83,6 +86,21 @@ static const char *const channels_text[] = {
     N_("Surround 5.0"), N_("Surround 5.1"), N_("Surround 7.1"),
 };
 
+#define MMAP_TEXT N_("Memory-mapped access")
+#define MMAP_LONGTEXT N_( \
+    "Write the samples directly into the device ring buffer, if supported.")
+
+#define BUFFER_TIME_TEXT N_("Buffer duration (ms)")
+#define BUFFER_TIME_LONGTEXT N_( \
+    "Duration of the device buffer, bounding the output latency. " \
+    "Short buffers are more sensitive to underruns. " \
+    "Use 0 for the default.")
+
+#define PERIOD_TIME_TEXT N_("Period duration (ms)")
+#define PERIOD_TIME_LONGTEXT N_( \
+    "Interval between device interrupts with a custom buffer duration. " \
+    "Use 0 for a quarter of the buffer.")
+
 #define PASSTHROUGH_TEXT N_("Audio passthrough mode")
 static const int passthrough_modes[] = {
     PASSTHROUGH_NONE, PASSTHROUGH_SPDIF, PASSTHROUGH_HDMI,
@@ -104,6 +122,11 @@ vlc_module_begin ()
     add_integer("alsa-passthrough", PASSTHROUGH_NONE, PASSTHROUGH_TEXT,
                 PASSTHROUGH_TEXT, false)
         change_integer_list(passthrough_modes, passthrough_modes_text)
+    add_bool("alsa-mmap", false, MMAP_TEXT, MMAP_LONGTEXT, true)
+    add_integer_with_range("alsa-buffer-time", 0, 0, 1000,
+                           BUFFER_TIME_TEXT, BUFFER_TIME_LONGTEXT, true)
+    add_integer_with_range("alsa-period-time", 0, 0, 1000,
+                           PERIOD_TIME_TEXT, PERIOD_TIME_LONGTEXT, true)
     add_sw_gain ()
     set_capability( "audio output", 150 )
     set_callbacks( Open, Close )
@@ -446,8 +469,21 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
         goto error;
     }
 
-    val = snd_pcm_hw_params_set_access (pcm, hw,
-                                        SND_PCM_ACCESS_RW_INTERLEAVED);
+    sys->mmap = var_InheritBool (aout, "alsa-mmap");
+    if (sys->mmap)
+    {
+        val = snd_pcm_hw_params_set_access (pcm, hw,
+                                            SND_PCM_ACCESS_MMAP_INTERLEAVED);
+        if (val)
+        {
+            msg_Warn (aout, "cannot set memory-mapped access: %s",
+                      snd_strerror (val));
+            sys->mmap = false;
+        }
+    }
+    if (!sys->mmap)
+        val = snd_pcm_hw_params_set_access (pcm, hw,
+                                            SND_PCM_ACCESS_RW_INTERLEAVED);
     if (val)
     {
         msg_Err (aout, "cannot set access mode: %s", snd_strerror (val));
@@ -522,17 +558,36 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     }
     sys->rate = fmt->i_rate;
 
-#if 1 /* work-around for period-long latency outputs (e.g. PulseAudio): */
-    param = AOUT_MIN_PREPARE_TIME;
+    /* Custom buffering for low latency outputs */
+    unsigned buffer_time = var_InheritInteger (aout, "alsa-buffer-time");
+    unsigned period_time = var_InheritInteger (aout, "alsa-period-time");
+
+    const bool custom_buffer = buffer_time > 0;
+
+    if (custom_buffer)
+    {
+        buffer_time *= 1000;
+        period_time *= 1000;
+        if (period_time == 0 || period_time > buffer_time / 2)
+            period_time = buffer_time / 4;
+    }
+    else
+    {
+        buffer_time = AOUT_MAX_ADVANCE_TIME;
+        /* work-around for period-long latency outputs (e.g. PulseAudio): */
+        period_time = AOUT_MIN_PREPARE_TIME;
+    }
+
+    param = period_time;
     val = snd_pcm_hw_params_set_period_time_near (pcm, hw, &param, NULL);
     if (val)
     {
         msg_Err (aout, "cannot set period: %s", snd_strerror (val));
         goto error;
     }
-#endif
+
     /* Set buffer size */
-    param = AOUT_MAX_ADVANCE_TIME;
+    param = buffer_time;
     val = snd_pcm_hw_params_set_buffer_time_near (pcm, hw, &param, NULL);
     if (val)
     {
@@ -585,6 +640,21 @@ static int Start (audio_output_t *aout, audio_sample_format_t *restrict fmt)
     }
     /* END REVISIT */
 
+    if (snd_pcm_hw_params_get_period_size (hw, &sys->period_size, NULL))
+        sys->period_size = 1;
+
+    /* With a custom buffer, time stamp the status, so that the delay need
+     * not be up to a period old with devices updating the position on
+     * interrupts only. */
+#if SND_LIB_VERSION >= 0x01001d /* 1.0.29 */
+    sys->tstamp = custom_buffer
+     && snd_pcm_sw_params_set_tstamp_mode (pcm, sw, SND_PCM_TSTAMP_ENABLE) == 0
+     && snd_pcm_sw_params_set_tstamp_type (pcm, sw,
+                                           SND_PCM_TSTAMP_TYPE_MONOTONIC) == 0;
+#else
+    sys->tstamp = false;
+#endif
+
     /* Commit software parameters. */
     val = snd_pcm_sw_params (pcm, sw);
     if (val)
@@ -631,6 +701,32 @@ static int TimeGet (audio_output_t *aout, vlc_tick_t *restrict delay)
     aout_sys_t *sys = aout->sys;
     snd_pcm_sframes_t frames;
 
+    if (sys->tstamp)
+    {
+        snd_pcm_status_t *status;
+
+        snd_pcm_status_alloca (&status);
+        if (snd_pcm_status (sys->pcm, status) == 0
+         && snd_pcm_status_get_state (status) == SND_PCM_STATE_RUNNING)
+        {
+            snd_htimestamp_t ts;
+
+            snd_pcm_status_get_htstamp (status, &ts);
+            if (ts.tv_sec != 0 || ts.tv_nsec != 0)
+            {
+                /* Account for the playback since the status time stamp */
+                vlc_tick_t elapsed = vlc_tick_now ()
+                                   - vlc_tick_from_timespec (&ts);
+
+                *delay = vlc_tick_from_samples (
+                            snd_pcm_status_get_delay (status), sys->rate);
+                if (elapsed > 0 && elapsed < *delay)
+                    *delay -= elapsed;
+                return 0;
+            }
+        }
+    }
+
     int val = snd_pcm_delay (sys->pcm, &frames);
     if (val)
     {
@@ -641,6 +737,50 @@ static int TimeGet (audio_output_t *aout, vlc_tick_t *restrict delay)
     return 0;
 }
 
+/**
+ * Copies frames directly into the device ring buffer.
+ * \return the number of frames written, or a negative ALSA error code
+ */
+static snd_pcm_sframes_t WriteMmap (snd_pcm_t *pcm, const void *buf,
+                                    snd_pcm_uframes_t count,
+                                    snd_pcm_uframes_t period)
+{
+    snd_pcm_sframes_t avail = snd_pcm_avail_update (pcm);
+    if (avail < 0)
+        return avail;
+
+    if ((snd_pcm_uframes_t)avail < __MIN(count, period))
+    {   /* Not enough room yet: wait for the next period */
+        int val = snd_pcm_wait (pcm, -1);
+        return (val < 0) ? val : 0;
+    }
+
+    const snd_pcm_channel_area_t *areas;
+    snd_pcm_uframes_t offset, frames = count;
+
+    int val = snd_pcm_mmap_begin (pcm, &areas, &offset, &frames);
+    if (val < 0)
+        return val;
+
+    /* Interleaved access: the first area describes the whole frames */
+    uint8_t *dst = (uint8_t *)areas[0].addr
+                 + (areas[0].first + offset * areas[0].step) / 8;
+    memcpy (dst, buf, snd_pcm_frames_to_bytes (pcm, frames));
+
+    snd_pcm_sframes_t written = snd_pcm_mmap_commit (pcm, offset, frames);
+    if (written < 0)
+        return written;
+
+    /* Unlike writes, commits do not apply the start threshold */
+    if (snd_pcm_state (pcm) == SND_PCM_STATE_PREPARED)
+    {
+        val = snd_pcm_start (pcm);
+        if (val < 0)
+            return val;
+    }
+    return written;
+}
+
 /**
  * Queues one audio buffer to the hardware.
  */
@@ -661,7 +801,12 @@ static void Play(audio_output_t *aout, block_t *block, vlc_tick_t date)
     {
         snd_pcm_sframes_t frames;
 
-        frames = snd_pcm_writei (pcm, block->p_buffer, block->i_nb_samples);
+        if (sys->mmap)
+            frames = WriteMmap (pcm, block->p_buffer, block->i_nb_samples,
+                                sys->period_size);
+        else
+            frames = snd_pcm_writei (pcm, block->p_buffer,
+                                     block->i_nb_samples);
         if (frames >= 0)
         {
             size_t bytes = snd_pcm_frames_to_bytes (pcm, frames);
@@ -137,6 +137,8 @@ vlc_module_begin ()
     add_integer( "avcodec-threads", 0, THREADS_TEXT, THREADS_LONGTEXT, true );
 #endif
     add_string( "avcodec-options", NULL, AV_OPTIONS_TEXT, AV_OPTIONS_LONGTEXT, true )
+    add_integer_with_range( "avcodec-hw-surfaces", 0, 0, 32,
+                            HW_SURFACES_TEXT, HW_SURFACES_LONGTEXT, true )
 
 
 #ifdef ENABLE_SOUT
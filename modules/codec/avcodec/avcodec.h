@@ -112,6 +112,11 @@ int ffmpeg_OpenCodec( decoder_t *p_dec, AVCodecContext *, const AVCodec * );
 #define THREADS_TEXT N_( "Threads" )
 #define THREADS_LONGTEXT N_( "Number of threads used for decoding, 0 meaning auto" )
 
+#define HW_SURFACES_TEXT N_( "Extra hardware surfaces" )
+#define HW_SURFACES_LONGTEXT N_( "Number of hardware decoding surfaces " \
+    "allocated in addition to the ones needed by the codec, so that decoding " \
+    "does not stall when filters or the display hold pictures longer." )
+
 /*
  * Encoder options
  */
@@ -373,7 +373,7 @@ const directx_va_mode_t *directx_va_Setup(vlc_va_t *va, const directx_sys_t *dx_
         msg_Err(va, "FindVideoServiceConversion failed");
         return NULL;
     }
-    *surfaces = surface_count;
+    *surfaces = va_pool_SurfaceCount(va, surface_count);
     return res;
 }
 
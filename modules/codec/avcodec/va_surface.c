@@ -38,7 +38,7 @@
 
 #include "avcodec.h"
 
-#define MAX_GET_RETRIES  ((VLC_TICK_FROM_SEC(1) + VOUT_OUTMEM_SLEEP) / VOUT_OUTMEM_SLEEP)
+#define MAX_GET_WAIT  VLC_TICK_FROM_SEC(1)
 
 struct vlc_va_surface_t {
     size_t               index;
@@ -58,6 +58,18 @@ struct va_pool_t
     struct va_pool_cfg callbacks;
 
     atomic_uintptr_t  poolrefs; // 1 ref for the pool creator, 1 ref per surface alive
+
+    vlc_va_t     *va; // only valid until va_pool_Close()
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait; // signaled when a surface is back in the pool
+
+    /* surface waiting statistics, wait_* and timeout_count are protected by
+     * the lock */
+    atomic_uint  get_count;
+    unsigned     wait_count;
+    unsigned     timeout_count;
+    vlc_tick_t   wait_total;
+    vlc_tick_t   wait_max;
 };
 
 static void va_pool_AddRef(va_pool_t *va_pool)
@@ -136,20 +148,42 @@ static vlc_va_surface_t *GetSurface(va_pool_t *va_pool)
 
 vlc_va_surface_t *va_pool_Get(va_pool_t *va_pool)
 {
-    unsigned tries = MAX_GET_RETRIES;
     vlc_va_surface_t *surface;
 
     if (va_pool->surface_count == 0)
         return NULL;
 
+    atomic_fetch_add_explicit(&va_pool->get_count, 1, memory_order_relaxed);
+    surface = GetSurface(va_pool);
+    if (surface != NULL)
+        return surface;
+
+    /* Pool empty: the pictures are held downstream (filters, display) */
+    vlc_tick_t start = vlc_tick_now();
+    vlc_tick_t deadline = start + MAX_GET_WAIT;
+
+    vlc_mutex_lock(&va_pool->lock);
     while ((surface = GetSurface(va_pool)) == NULL)
-    {
-        if (--tries == 0)
-            return NULL;
-        /* Pool empty. Wait for some time as in src/input/decoder.c.
-         * XXX: Both this and the core should use a semaphore or a CV. */
-        vlc_tick_sleep(VOUT_OUTMEM_SLEEP);
-    }
+        if (vlc_cond_timedwait(&va_pool->wait, &va_pool->lock, deadline))
+        {
+            surface = GetSurface(va_pool);
+            break;
+        }
+
+    vlc_tick_t waited = vlc_tick_now() - start;
+    unsigned wait_count = ++va_pool->wait_count;
+    va_pool->wait_total += waited;
+    if (waited > va_pool->wait_max)
+        va_pool->wait_max = waited;
+    if (surface == NULL)
+        va_pool->timeout_count++;
+    vlc_mutex_unlock(&va_pool->lock);
+
+    if (surface == NULL)
+        msg_Warn(va_pool->va, "no free surface after %"PRId64" ms (%zu surfaces, "
+                 "%u/%u requests waited), consider raising --avcodec-hw-surfaces",
+                 MS_FROM_VLC_TICK(waited), va_pool->surface_count, wait_count,
+                 atomic_load_explicit(&va_pool->get_count, memory_order_relaxed));
     return surface;
 }
 
@@ -160,12 +194,32 @@ void va_surface_AddRef(vlc_va_surface_t *surface)
 
 void va_surface_Release(vlc_va_surface_t *surface)
 {
-    if (atomic_fetch_sub(&surface->refcount, 1) != 1)
+    uintptr_t refs = atomic_fetch_sub(&surface->refcount, 1);
+
+    if (refs == 2)
+    {
+        /* the surface is free again */
+        va_pool_t *va_pool = surface->va_pool;
+
+        vlc_mutex_lock(&va_pool->lock);
+        vlc_cond_signal(&va_pool->wait);
+        vlc_mutex_unlock(&va_pool->lock);
+        return;
+    }
+    if (refs != 1)
         return;
 
     va_pool_Release(surface->va_pool);
 }
 
+size_t va_pool_SurfaceCount(vlc_va_t *va, size_t count)
+{
+    int64_t extra = var_InheritInteger(va, "avcodec-hw-surfaces");
+    if (extra > 0)
+        count += extra;
+    return __MIN(count, MAX_SURFACE_COUNT);
+}
+
 size_t va_surface_GetIndex(const vlc_va_surface_t *surface)
 {
     return surface->index;
@@ -173,6 +227,14 @@ size_t va_surface_GetIndex(const vlc_va_surface_t *surface)
 
 void va_pool_Close(va_pool_t *va_pool)
 {
+    if (va_pool->wait_count > 0)
+        msg_Dbg(va_pool->va, "%u/%u surface requests waited (%u timeouts), "
+                "%"PRId64" ms max, %"PRId64" ms average",
+                va_pool->wait_count, atomic_load(&va_pool->get_count),
+                va_pool->timeout_count, MS_FROM_VLC_TICK(va_pool->wait_max),
+                MS_FROM_VLC_TICK(va_pool->wait_total / va_pool->wait_count));
+    va_pool->va = NULL;
+
     for (unsigned i = 0; i < va_pool->surface_count; i++)
         va_surface_Release(&va_pool->surface[i]);
     va_pool->surface_count = 0;
@@ -197,6 +259,14 @@ va_pool_t * va_pool_Create(vlc_va_t *va, const struct va_pool_cfg *cbs)
 
     va_pool->surface_count = 0;
     atomic_init(&va_pool->poolrefs, 1);
+    va_pool->va = va;
+    vlc_mutex_init(&va_pool->lock);
+    vlc_cond_init(&va_pool->wait);
+    atomic_init(&va_pool->get_count, 0);
+    va_pool->wait_count = 0;
+    va_pool->timeout_count = 0;
+    va_pool->wait_total = 0;
+    va_pool->wait_max = 0;
 
     return va_pool;
 }
@@ -83,8 +83,19 @@ void va_pool_Close(va_pool_t *);
  */
 int va_pool_SetupDecoder(vlc_va_t *, va_pool_t *, AVCodecContext *, const video_format_t *, size_t count);
 
+/**
+ * Get the number of surfaces to allocate for a decoder that needs count
+ * surfaces, including the extra surfaces requested by the user.
+ *
+ * The surfaces are bound to the decoder when it is created, so the pool
+ * cannot grow afterwards.
+ */
+size_t va_pool_SurfaceCount(vlc_va_t *, size_t count);
+
 /**
  * Get a reference to an available surface or NULL on timeout
+ *
+ * Waits up to one second for a surface to be released.
  */
 vlc_va_surface_t *va_pool_Get(va_pool_t *);
 
@@ -281,6 +281,7 @@ static int Create(vlc_va_t *va, AVCodecContext *ctx, enum PixelFormat hwfmt, con
         goto error;
 
     fmt_out->i_chroma = i_vlc_chroma;
+    count = va_pool_SurfaceCount(va, count);
     int err = va_pool_SetupDecoder(va, sys->va_pool, ctx, fmt_out, count);
     if (err != VLC_SUCCESS)
         goto error;
@@ -303,7 +304,7 @@ static int Create(vlc_va_t *va, AVCodecContext *ctx, enum PixelFormat hwfmt, con
 
     msg_Info(va, "Using %s", vaQueryVendorString(sys->hw_ctx.display));
 
-    sys->vctx = vlc_video_context_Create( dec_device, VLC_VIDEO_CONTEXT_VAAPI, 0, NULL );
+    sys->vctx = vlc_vaapi_VideoContextCreate( dec_device );
     if (sys->vctx == NULL)
         goto error;
 
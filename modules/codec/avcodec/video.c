@@ -55,6 +55,7 @@ struct frame_info_s
 {
     bool b_eos;
     bool b_display;
+    vlc_tick_t i_sent; /* when the packet was sent to the decoder */
 };
 
 /*****************************************************************************
@@ -90,6 +91,10 @@ typedef struct
     int64_t i_last_output_frame;
     vlc_tick_t i_last_late_delay;
 
+    /* worst decoding latency seen so far */
+    vlc_tick_t i_max_latency;
+    unsigned   i_max_delay_frames;
+
     /* for direct rendering */
     bool        b_direct_rendering;
     atomic_bool b_dr_failure;
@@ -489,10 +494,7 @@ static int OpenVideoCodec( decoder_t *p_dec )
     }
 
     if( var_InheritBool(p_dec, "low-delay") )
-    {
         ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
-        ctx->active_thread_type = FF_THREAD_SLICE;
-    }
 
     ret = ffmpeg_OpenCodec( p_dec, ctx, codec );
     if( ret < 0 )
@@ -658,6 +660,10 @@ int InitVideoDec( vlc_object_t *obj )
             break;
     }
 
+    /* Frame threads delay the output by one frame per thread */
+    if( var_InheritBool( p_dec, "low-delay" ) )
+        p_context->thread_type &= ~FF_THREAD_FRAME;
+
     if( p_context->thread_type & FF_THREAD_FRAME )
         p_dec->i_extra_picture_buffers = 2 * p_context->thread_count;
 
@@ -665,6 +671,8 @@ int InitVideoDec( vlc_object_t *obj )
     date_Init(&p_sys->pts, 1, 30001);
     p_sys->b_first_frame = true;
     p_sys->i_late_frames = 0;
+    p_sys->i_max_latency = 0;
+    p_sys->i_max_delay_frames = 0;
     p_sys->b_from_preroll = false;
     p_sys->i_last_output_frame = -1;
     p_sys->framedrop = FRAMEDROP_NONE;
@@ -1131,6 +1139,7 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
             struct frame_info_s *p_frame_info = &p_sys->frame_info[p_context->reordered_opaque % FRAME_INFO_DEPTH];
             p_frame_info->b_eos = p_block && (p_block->i_flags & BLOCK_FLAG_END_OF_SEQUENCE);
             p_frame_info->b_display = b_need_output_picture;
+            p_frame_info->i_sent = vlc_tick_now();
 
             p_context->reordered_opaque++;
             i_used = ret != AVERROR(EAGAIN) ? pkt.size : 0;
@@ -1183,6 +1192,26 @@ static int DecodeBlock( decoder_t *p_dec, block_t **pp_block )
         if( p_frame_info->b_eos )
             p_sys->b_first_frame = true;
 
+        if( !b_drained && p_context->reordered_opaque
+                          - frame->reordered_opaque <= FRAME_INFO_DEPTH )
+        {
+            vlc_tick_t latency = vlc_tick_now() - p_frame_info->i_sent;
+            unsigned frames = p_context->reordered_opaque - 1
+                            - frame->reordered_opaque;
+            /* only report significant changes */
+            if( latency > p_sys->i_max_latency + p_sys->i_max_latency / 4
+             || frames > p_sys->i_max_delay_frames )
+            {
+                p_sys->i_max_latency = __MAX( latency, p_sys->i_max_latency );
+                p_sys->i_max_delay_frames = __MAX( frames,
+                                                   p_sys->i_max_delay_frames );
+                msg_Dbg( p_dec, "decoding latency up to %"PRId64" us, "
+                         "%u frame(s) delay",
+                         US_FROM_VLC_TICK(p_sys->i_max_latency),
+                         p_sys->i_max_delay_frames );
+            }
+        }
+
         vlc_mutex_lock(&p_sys->lock);
 
         /* Compute the PTS */
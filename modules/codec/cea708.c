@@ -368,10 +368,20 @@ struct cea708_text_row_t
     cea708_pen_style_t styles[CEA708_WINDOW_MAX_COLS];
     uint8_t firstcol;
     uint8_t lastcol;
+    /* Rendered text, kept until the row is modified */
+    text_segment_t *p_segments;
+    bool b_segments_newline;
 };
 
+static void cea708_text_row_Invalidate( cea708_text_row_t *p_row )
+{
+    text_segment_ChainDelete( p_row->p_segments );
+    p_row->p_segments = NULL;
+}
+
 static void cea708_text_row_Delete( cea708_text_row_t *p_row )
 {
+    cea708_text_row_Invalidate( p_row );
     free( p_row );
 }
 
@@ -382,6 +392,7 @@ static cea708_text_row_t * cea708_text_row_New( void )
     {
         p_row->firstcol = CEA708_WINDOW_MAX_COLS;
         p_row->lastcol = 0;
+        p_row->p_segments = NULL;
         memset(p_row->characters, 0, 4 * CEA708_WINDOW_MAX_COLS);
     }
     return p_row;
@@ -675,6 +686,7 @@ static void CEA708_Window_Scroll( cea708_window_t *p_w )
                          (row->lastcol - row->firstcol + 1) * sizeof(cea708_pen_style_t) );
                 row->firstcol++;
                 row->lastcol++;
+                cea708_text_row_Invalidate( row );
             }
             break;
         case CEA708_WA_DIRECTION_RTL:
@@ -692,6 +704,7 @@ static void CEA708_Window_Scroll( cea708_window_t *p_w )
                          (row->lastcol - row->firstcol + 1) * sizeof(cea708_pen_style_t) );
                 row->firstcol--;
                 row->lastcol--;
+                cea708_text_row_Invalidate( row );
             }
             break;
         case CEA708_WA_DIRECTION_TB:
@@ -837,6 +850,7 @@ static void CEA708_Window_Write( const uint8_t c[4], cea708_window_t *p_w )
         p_row->firstcol = p_w->col;
     if( p_w->col > p_row->lastcol )
         p_row->lastcol = p_w->col;
+    cea708_text_row_Invalidate( p_row );
 
     CEA708_Window_Forward( p_w );
 
@@ -1008,11 +1022,22 @@ static void CEA708SpuConvert( const cea708_window_t *p_w,
     text_segment_t **pp_last = &p_region->p_segments;
     for( uint8_t i=first; i<=last; i++ )
     {
-        if( !p_w->rows[i] )
+        cea708_text_row_t *p_row = p_w->rows[i];
+        if( !p_row )
             continue;
 
-        *pp_last = CEA708RowToSegments( p_w->rows[i], i < p_w->i_lastrow );
-        if( *pp_last )
+        /* Only rows modified since the last output are rendered again */
+        const bool b_newline = i < p_w->i_lastrow;
+        if( p_row->p_segments && p_row->b_segments_newline != b_newline )
+            cea708_text_row_Invalidate( p_row );
+        if( !p_row->p_segments )
+        {
+            p_row->p_segments = CEA708RowToSegments( p_row, b_newline );
+            p_row->b_segments_newline = b_newline;
+        }
+
+        *pp_last = text_segment_Copy( p_row->p_segments );
+        while( *pp_last )
             pp_last  = &((*pp_last)->p_next);
     }
 
@@ -34,8 +34,6 @@
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
 
-#include <vlc_bits.h>
-
 #include "../demux/mpeg/timestamps.h"
 
 #define DEBUG_CVDSUB 1
@@ -555,6 +553,16 @@ static subpicture_t *DecodePacket( decoder_t *p_dec, block_t *p_data )
     return p_spu;
 }
 
+static inline uint8_t GetNibble( const uint8_t *p_src, const uint8_t *p_end,
+                                 unsigned *pi_nibble )
+{
+    const uint8_t *p = &p_src[*pi_nibble >> 1];
+    const unsigned i_shift = ( *pi_nibble & 0x1 ) ? 0 : 4;
+
+    (*pi_nibble)++;
+    return p < p_end ? ( *p >> i_shift ) & 0xf : 0;
+}
+
 /*****************************************************************************
  * ParseImage: parse and render the image part of the subtitle
  *****************************************************************************
@@ -583,49 +591,42 @@ static void RenderImage( decoder_t *p_dec, block_t *p_data,
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
     uint8_t *p_dest = p_region->p_picture->Y_PIXELS;
+    const int i_pitch = p_region->p_picture->Y_PITCH;
+    const uint8_t *p_end = p_data->p_buffer + p_data->i_buffer;
+    const uint8_t *p_src = p_data->p_buffer + p_sys->i_image_offset;
     int i_field;            /* The subtitles are interlaced */
     int i_row, i_column;    /* scanline row/column number */
-    uint8_t i_color, i_count;
-    bs_t bs;
-
-    bs_init( &bs, p_data->p_buffer + p_sys->i_image_offset,
-             p_data->i_buffer - p_sys->i_image_offset );
 
     for( i_field = 0; i_field < 2; i_field++ )
     {
         for( i_row = i_field; i_row < p_sys->i_height; i_row += 2 )
         {
-            for( i_column = 0; i_column < p_sys->i_width; i_column++ )
+            uint8_t *p_line = &p_dest[i_row * i_pitch];
+            unsigned i_nibble = 0;
+
+            for( i_column = 0; i_column < p_sys->i_width; )
             {
-                uint8_t i_val = bs_read( &bs, 4 );
+                uint8_t i_val = GetNibble( p_src, p_end, &i_nibble );
 
                 if( i_val == 0 )
                 {
                     /* Fill the rest of the line with next color */
-                    i_color = bs_read( &bs, 4 );
+                    uint8_t i_color = GetNibble( p_src, p_end, &i_nibble );
 
-                    memset( &p_dest[i_row * p_region->p_picture->Y_PITCH +
-                                    i_column], i_color,
+                    memset( &p_line[i_column], i_color,
                             p_sys->i_width - i_column );
-                    i_column = p_sys->i_width;
-                    continue;
+                    break;
                 }
-                else
-                {
-                    /* Normal case: get color and repeat count */
-                    i_count = (i_val >> 2);
-                    i_color = i_val & 0x3;
 
-                    i_count = __MIN( i_count, p_sys->i_width - i_column );
+                /* Normal case: get color and repeat count */
+                int i_count = __MIN( i_val >> 2, p_sys->i_width - i_column );
 
-                    memset( &p_dest[i_row * p_region->p_picture->Y_PITCH +
-                                    i_column], i_color, i_count );
-                    i_column += i_count - 1;
-                    continue;
-                }
+                memset( &p_line[i_column], i_val & 0x3, i_count );
+                i_column += i_count;
             }
 
-            bs_align( &bs );
+            /* Lines are byte aligned */
+            p_src += ( i_nibble + 1 ) >> 1;
         }
     }
 }
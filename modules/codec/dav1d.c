@@ -54,6 +54,10 @@ static void CloseDecoder(vlc_object_t *);
 #define THREAD_FRAMES_LONGTEXT N_( "Max number of threads used for frame decoding, default 0=auto" )
 #define THREAD_TILES_TEXT N_("Tiles Threads")
 #define THREAD_TILES_LONGTEXT N_( "Max number of threads used for tile decoding, default 0=auto" )
+#define FRAME_DELAY_TEXT N_("Max frame delay")
+#define FRAME_DELAY_LONGTEXT N_( "Max number of frames decoded in parallel, " \
+    "which bounds the decoding latency and the number of pictures held " \
+    "by the decoder, default 0=auto (1 in low delay mode)" )
 
 
 vlc_module_begin ()
@@ -68,6 +72,9 @@ vlc_module_begin ()
                 THREAD_FRAMES_TEXT, THREAD_FRAMES_LONGTEXT, false)
     add_integer("dav1d-thread-tiles", 0,
                 THREAD_TILES_TEXT, THREAD_TILES_LONGTEXT, false)
+    add_integer("dav1d-max-frame-delay", 0,
+                FRAME_DELAY_TEXT, FRAME_DELAY_LONGTEXT, false)
+        change_integer_range(0, 16)
 vlc_module_end ()
 
 /*****************************************************************************
@@ -78,6 +85,7 @@ typedef struct
     Dav1dSettings s;
     Dav1dContext *c;
     cc_data_t cc;
+    bool b_bad_picture;
 } decoder_sys_t;
 
 struct user_data_s
@@ -124,6 +132,37 @@ static vlc_fourcc_t FindVlcChroma(const Dav1dPicture *img)
     return 0;
 }
 
+/* dav1d decodes straight into the pool pictures: the planes must be
+ * aligned, padded to a multiple of 128 pixels, and the chroma planes must
+ * share the same pitch. */
+static bool CheckPicture(const Dav1dPicture *img, const picture_t *pic)
+{
+    const unsigned pixel_size = img->p.bpc > 8 ? 2 : 1;
+    const unsigned width = (img->p.w + 0x7F) & ~0x7F;
+    const unsigned height = (img->p.h + 0x7F) & ~0x7F;
+    const int planes = img->p.layout == DAV1D_PIXEL_LAYOUT_I400 ? 1 : 3;
+    const unsigned ss_hor = img->p.layout == DAV1D_PIXEL_LAYOUT_I420 ||
+                            img->p.layout == DAV1D_PIXEL_LAYOUT_I422;
+    const unsigned ss_ver = img->p.layout == DAV1D_PIXEL_LAYOUT_I420;
+
+    if (pic->i_planes < planes)
+        return false;
+
+    for (int i = 0; i < planes; i++)
+    {
+        const plane_t *p = &pic->p[i];
+        unsigned w = i ? width >> ss_hor : width;
+        unsigned h = i ? height >> ss_ver : height;
+
+        if (((uintptr_t)p->p_pixels % DAV1D_PICTURE_ALIGNMENT)
+         || (p->i_pitch % DAV1D_PICTURE_ALIGNMENT)
+         || p->i_pitch < (int)(w * pixel_size) || p->i_lines <= (int)h)
+            return false;
+    }
+
+    return planes == 1 || pic->p[1].i_pitch == pic->p[2].i_pitch;
+}
+
 static int NewPicture(Dav1dPicture *img, void *cookie)
 {
     decoder_t *dec = cookie;
@@ -133,7 +172,9 @@ static int NewPicture(Dav1dPicture *img, void *cookie)
     v->i_visible_width  = img->p.w;
     v->i_visible_height = img->p.h;
     v->i_width  = (img->p.w + 0x7F) & ~0x7F;
-    v->i_height = (img->p.h + 0x7F) & ~0x7F;
+    /* One more line leaves room for the DAV1D_PICTURE_ALIGNMENT bytes that
+     * the assembly may access past the end of the last plane. */
+    v->i_height = ((img->p.h + 0x7F) & ~0x7F) + 1;
 
     if( !v->i_sar_num || !v->i_sar_den )
     {
@@ -186,18 +227,27 @@ static int NewPicture(Dav1dPicture *img, void *cookie)
         picture_t *pic = decoder_NewPicture(dec);
         if (likely(pic != NULL))
         {
+            if (unlikely(!CheckPicture(img, pic)))
+            {
+                decoder_sys_t *p_sys = dec->p_sys;
+                if (!p_sys->b_bad_picture)
+                    msg_Err(dec, "unsuitable picture buffer for direct decoding");
+                p_sys->b_bad_picture = true;
+                picture_Release(pic);
+                return DAV1D_ERR(EINVAL);
+            }
+
             img->data[0] = pic->p[0].p_pixels;
             img->stride[0] = pic->p[0].i_pitch;
             img->data[1] = pic->p[1].p_pixels;
             img->data[2] = pic->p[2].p_pixels;
-            assert(pic->p[1].i_pitch == pic->p[2].i_pitch);
             img->stride[1] = pic->p[1].i_pitch;
             img->allocator_data = pic;
 
             return 0;
         }
     }
-    return -1;
+    return DAV1D_ERR(ENOMEM);
 }
 
 static void ExtractCaptions(decoder_t *dec, const Dav1dPicture *img)
@@ -380,13 +430,39 @@ static int OpenDecoder(vlc_object_t *p_this)
     if (!p_sys)
         return VLC_ENOMEM;
 
+    const unsigned cpus = __MAX(1, vlc_GetCPUCount());
+    unsigned delay = var_InheritInteger(p_this, "dav1d-max-frame-delay");
+    if (delay == 0)
+    {
+        if (var_InheritBool(p_this, "low-delay"))
+            delay = 1;
+        else
+        {   /* frame threads scale poorly past a few frames in flight, while
+             * each of those costs a picture and a frame of latency */
+            delay = 1;
+            while (delay < 8 && delay * delay < cpus)
+                delay++;
+        }
+    }
+
     dav1d_default_settings(&p_sys->s);
+#if DAV1D_API_VERSION_MAJOR >= 6
+    unsigned threads = var_InheritInteger(p_this, "dav1d-thread-frames")
+                     * __MAX(1, var_InheritInteger(p_this, "dav1d-thread-tiles"));
+    p_sys->s.n_threads = threads ? __MIN(threads, 256) : __MIN(cpus, 256);
+    p_sys->s.max_frame_delay = delay;
+    const unsigned frames = __MIN(delay, p_sys->s.n_threads);
+#else
     p_sys->s.n_tile_threads = var_InheritInteger(p_this, "dav1d-thread-tiles");
     if (p_sys->s.n_tile_threads == 0)
-        p_sys->s.n_tile_threads = VLC_CLIP(vlc_GetCPUCount(), 1, 4);
+        p_sys->s.n_tile_threads = VLC_CLIP(cpus, 1, 4);
     p_sys->s.n_frame_threads = var_InheritInteger(p_this, "dav1d-thread-frames");
     if (p_sys->s.n_frame_threads == 0)
-        p_sys->s.n_frame_threads = __MAX(1, vlc_GetCPUCount());
+        p_sys->s.n_frame_threads = VLC_CLIP(cpus / p_sys->s.n_tile_threads,
+                                            1, delay);
+    const unsigned frames = p_sys->s.n_frame_threads;
+#endif
+    p_sys->b_bad_picture = false;
     p_sys->s.allocator.cookie = dec;
     p_sys->s.allocator.alloc_picture_callback = NewPicture;
     p_sys->s.allocator.release_picture_callback = FreePicture;
@@ -397,12 +473,18 @@ static int OpenDecoder(vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+#if DAV1D_API_VERSION_MAJOR >= 6
+    msg_Dbg(p_this, "Using dav1d version %s with %d threads, %u frame(s) delay",
+            dav1d_version(), p_sys->s.n_threads, frames);
+#else
     msg_Dbg(p_this, "Using dav1d version %s with %d/%d frame/tile threads",
             dav1d_version(), p_sys->s.n_frame_threads, p_sys->s.n_tile_threads);
+#endif
 
     dec->pf_decode = Decode;
     dec->pf_flush = FlushDecoder;
-    dec->i_extra_picture_buffers = (p_sys->s.n_frame_threads - 1);
+    /* each frame in flight beyond the first holds a pool picture */
+    dec->i_extra_picture_buffers = frames - 1;
 
     dec->fmt_out.video.i_width = dec->fmt_in.video.i_width;
     dec->fmt_out.video.i_height = dec->fmt_in.video.i_height;
@@ -1059,9 +1059,65 @@ static void decode_display_definition( decoder_t *p_dec, bs_t *s, uint16_t i_seg
 
 static void dvbsub_render_pdata( decoder_t *, dvbsub_region_t *, int, int,
                                  uint8_t *, int );
-static void dvbsub_pdata2bpp( bs_t *, uint8_t *, int, int * );
-static void dvbsub_pdata4bpp( bs_t *, uint8_t *, int, int * );
-static void dvbsub_pdata8bpp( bs_t *, uint8_t *, int, int * );
+/* Pixel data bit reader: the RLE codes are at most 8 bits wide, and are read
+ * from a 32 bits cache refilled a byte at a time rather than through the
+ * generic bs_t callbacks. Reads beyond the end return zeroes. */
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *p_end;
+    uint32_t cache;
+    unsigned bits; /* valid bits in cache, including padding beyond the end */
+    unsigned pad;  /* padding bits in cache */
+} dvbsub_bits_t;
+
+static void dvbsub_bits_init( dvbsub_bits_t *b, const uint8_t *p, size_t i )
+{
+    b->p = p;
+    b->p_end = p + i;
+    b->cache = 0;
+    b->bits = 0;
+    b->pad = 0;
+}
+
+static inline bool dvbsub_bits_eof( const dvbsub_bits_t *b )
+{
+    return b->p == b->p_end && b->bits <= b->pad;
+}
+
+static inline unsigned dvbsub_bits_read( dvbsub_bits_t *b, unsigned n )
+{
+    assert( n > 0 && n <= 8 );
+    if( unlikely(b->bits < n) )
+    {
+        while( b->bits <= 24 )
+        {
+            if( b->p < b->p_end )
+                b->cache |= (uint32_t)*(b->p++) << (24 - b->bits);
+            else
+                b->pad += 8;
+            b->bits += 8;
+        }
+    }
+
+    unsigned v = b->cache >> (32 - n);
+    b->cache <<= n;
+    b->bits -= n;
+    if( b->pad > b->bits )
+        b->pad = b->bits;
+    return v;
+}
+
+static inline void dvbsub_bits_align( dvbsub_bits_t *b )
+{
+    unsigned n = b->bits & 7;
+    if( n )
+        dvbsub_bits_read( b, n );
+}
+
+static void dvbsub_pdata2bpp( dvbsub_bits_t *, uint8_t *, int, int * );
+static void dvbsub_pdata4bpp( dvbsub_bits_t *, uint8_t *, int, int * );
+static void dvbsub_pdata8bpp( dvbsub_bits_t *, uint8_t *, int, int * );
 
 static void decode_object( decoder_t *p_dec, bs_t *s, uint16_t i_segment_length )
 {
@@ -1205,7 +1261,7 @@ static void dvbsub_render_pdata( decoder_t *p_dec, dvbsub_region_t *p_region,
 {
     uint8_t *p_pixbuf;
     int i_offset = 0;
-    bs_t bs;
+    dvbsub_bits_t bs;
 
     /* Sanity check */
     if( !p_region->p_pixbuf )
@@ -1221,14 +1277,14 @@ static void dvbsub_render_pdata( decoder_t *p_dec, dvbsub_region_t *p_region,
     }
 
     p_pixbuf = p_region->p_pixbuf + i_y * p_region->i_width;
-    bs_init( &bs, p_field, i_field );
+    dvbsub_bits_init( &bs, p_field, i_field );
 
-    while( !bs_eof( &bs ) )
+    while( !dvbsub_bits_eof( &bs ) )
     {
         /* Sanity check */
         if( i_y >= p_region->i_height ) return;
 
-        switch( bs_read( &bs, 8 ) )
+        switch( dvbsub_bits_read( &bs, 8 ) )
         {
         case 0x10:
             dvbsub_pdata2bpp( &bs, p_pixbuf + i_x, p_region->i_width - i_x,
@@ -1259,31 +1315,31 @@ static void dvbsub_render_pdata( decoder_t *p_dec, dvbsub_region_t *p_region,
     }
 }
 
-static void dvbsub_pdata2bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
+static void dvbsub_pdata2bpp( dvbsub_bits_t *s, uint8_t *p, int i_width, int *pi_off )
 {
     bool b_stop = false;
 
-    while( !b_stop && !bs_eof( s ) )
+    while( !b_stop && !dvbsub_bits_eof( s ) )
     {
         int i_count = 0, i_color = 0;
 
-        i_color = bs_read( s, 2 );
+        i_color = dvbsub_bits_read( s, 2 );
         if( i_color != 0x00 )
         {
             i_count = 1;
         }
         else
         {
-            if( bs_read( s, 1 ) == 0x01 )         // Switch1
+            if( dvbsub_bits_read( s, 1 ) == 0x01 )         // Switch1
             {
-                i_count = 3 + bs_read( s, 3 );
-                i_color = bs_read( s, 2 );
+                i_count = 3 + dvbsub_bits_read( s, 3 );
+                i_color = dvbsub_bits_read( s, 2 );
             }
             else
             {
-                if( bs_read( s, 1 ) == 0x00 )     //Switch2
+                if( dvbsub_bits_read( s, 1 ) == 0x00 )     //Switch2
                 {
-                    switch( bs_read( s, 2 ) )     //Switch3
+                    switch( dvbsub_bits_read( s, 2 ) )     //Switch3
                     {
                     case 0x00:
                         b_stop = true;
@@ -1292,12 +1348,12 @@ static void dvbsub_pdata2bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
                         i_count = 2;
                         break;
                     case 0x02:
-                        i_count =  12 + bs_read( s, 4 );
-                        i_color = bs_read( s, 2 );
+                        i_count =  12 + dvbsub_bits_read( s, 4 );
+                        i_color = dvbsub_bits_read( s, 2 );
                         break;
                     case 0x03:
-                        i_count =  29 + bs_read( s, 8 );
-                        i_color = bs_read( s, 2 );
+                        i_count =  29 + dvbsub_bits_read( s, 8 );
+                        i_color = dvbsub_bits_read( s, 2 );
                         break;
                     default:
                         break;
@@ -1322,18 +1378,18 @@ static void dvbsub_pdata2bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         (*pi_off) += i_count;
     }
 
-    bs_align( s );
+    dvbsub_bits_align( s );
 }
 
-static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
+static void dvbsub_pdata4bpp( dvbsub_bits_t *s, uint8_t *p, int i_width, int *pi_off )
 {
     bool b_stop = false;
 
-    while( !b_stop && !bs_eof( s ) )
+    while( !b_stop && !dvbsub_bits_eof( s ) )
     {
         int i_count = 0, i_color = 0;
 
-        i_color = bs_read( s, 4 );
+        i_color = dvbsub_bits_read( s, 4 );
         if( i_color != 0x00 )
         {
             /* Add 1 pixel */
@@ -1341,9 +1397,9 @@ static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         }
         else
         {
-            if( bs_read( s, 1 ) == 0x00 )           // Switch1
+            if( dvbsub_bits_read( s, 1 ) == 0x00 )           // Switch1
             {
-                i_count = bs_read( s, 3 );
+                i_count = dvbsub_bits_read( s, 3 );
                 if( i_count != 0x00 )
                 {
                     i_count += 2;
@@ -1352,14 +1408,14 @@ static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
             }
             else
             {
-                if( bs_read( s, 1 ) == 0x00)        //Switch2
+                if( dvbsub_bits_read( s, 1 ) == 0x00)        //Switch2
                 {
-                    i_count =  4 + bs_read( s, 2 );
-                    i_color = bs_read( s, 4 );
+                    i_count =  4 + dvbsub_bits_read( s, 2 );
+                    i_color = dvbsub_bits_read( s, 4 );
                 }
                 else
                 {
-                    switch ( bs_read( s, 2 ) )     //Switch3
+                    switch ( dvbsub_bits_read( s, 2 ) )     //Switch3
                     {
                     case 0x0:
                         i_count = 1;
@@ -1368,12 +1424,12 @@ static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
                         i_count = 2;
                         break;
                     case 0x2:
-                        i_count = 9 + bs_read( s, 4 );
-                        i_color = bs_read( s, 4 );
+                        i_count = 9 + dvbsub_bits_read( s, 4 );
+                        i_color = dvbsub_bits_read( s, 4 );
                         break;
                     case 0x3:
-                        i_count= 25 + bs_read( s, 8 );
-                        i_color = bs_read( s, 4 );
+                        i_count= 25 + dvbsub_bits_read( s, 8 );
+                        i_color = dvbsub_bits_read( s, 4 );
                         break;
                     }
                 }
@@ -1391,18 +1447,18 @@ static void dvbsub_pdata4bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         (*pi_off) += i_count;
     }
 
-    bs_align( s );
+    dvbsub_bits_align( s );
 }
 
-static void dvbsub_pdata8bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
+static void dvbsub_pdata8bpp( dvbsub_bits_t *s, uint8_t *p, int i_width, int *pi_off )
 {
     bool b_stop = false;
 
-    while( !b_stop && !bs_eof( s ) )
+    while( !b_stop && !dvbsub_bits_eof( s ) )
     {
         int i_count = 0, i_color = 0;
 
-        i_color = bs_read( s, 8 );
+        i_color = dvbsub_bits_read( s, 8 );
         if( i_color != 0x00 )
         {
             /* Add 1 pixel */
@@ -1410,16 +1466,16 @@ static void dvbsub_pdata8bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         }
         else
         {
-            if( bs_read( s, 1 ) == 0x00 )           // Switch1
+            if( dvbsub_bits_read( s, 1 ) == 0x00 )           // Switch1
             {
-                i_count = bs_read( s, 7 );
+                i_count = dvbsub_bits_read( s, 7 );
                 if( i_count == 0x00 )
                     b_stop = true;
             }
             else
             {
-                i_count = bs_read( s, 7 );
-                i_color = bs_read( s, 8 );
+                i_count = dvbsub_bits_read( s, 7 );
+                i_color = dvbsub_bits_read( s, 8 );
             }
         }
 
@@ -1434,7 +1490,7 @@ static void dvbsub_pdata8bpp( bs_t *s, uint8_t *p, int i_width, int *pi_off )
         (*pi_off) += i_count;
     }
 
-    bs_align( s );
+    dvbsub_bits_align( s );
 }
 
 static void free_all( decoder_t *p_dec )
@@ -495,6 +495,43 @@ jpeg_GetOrientation( j_decompress_ptr cinfo )
     return 0;     /* No EXIF Orientation tag found */
 }
 
+/*
+ * Selects DCT-domain downscaling, if the image handler requested a smaller
+ * output size. The decoded image is never smaller than the requested size,
+ * the remaining scaling is left to the converter.
+ */
+static void jpeg_SetScale( decoder_t *p_dec, j_decompress_ptr cinfo,
+                           bool b_swap )
+{
+    unsigned i_width = var_GetInteger( p_dec, "image-decode-width" );
+    unsigned i_height = var_GetInteger( p_dec, "image-decode-height" );
+
+    if( b_swap )
+    {
+        unsigned i_tmp = i_width;
+        i_width = i_height;
+        i_height = i_tmp;
+    }
+
+    if( i_width == 0 && i_height == 0 )
+        return;
+
+    /* 1/2, 1/4 and 1/8 are supported by all libjpeg flavours */
+    unsigned i_denom = 1;
+    while( i_denom < 8
+        && ( cinfo->image_width + 2 * i_denom - 1 ) / ( 2 * i_denom ) >= i_width
+        && ( cinfo->image_height + 2 * i_denom - 1 ) / ( 2 * i_denom ) >= i_height )
+        i_denom *= 2;
+
+    if( i_denom > 1 )
+    {
+        msg_Dbg( p_dec, "decoding %ux%u image at 1/%u scale",
+                 cinfo->image_width, cinfo->image_height, i_denom );
+        cinfo->scale_num = 1;
+        cinfo->scale_denom = i_denom;
+    }
+}
+
 /*
  * This function must be fed with a complete compressed frame.
  */
@@ -527,6 +564,12 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
 
     p_sys->p_jpeg.out_color_space = JCS_RGB;
 
+    int i_otag; /* Orientation tag has valid range of 1-8. 1 is normal orientation, 0 = unspecified = normal */
+    i_otag = jpeg_GetOrientation( &p_sys->p_jpeg );
+
+    jpeg_SetScale( p_dec, &p_sys->p_jpeg,
+                   i_otag > 1 && ORIENT_IS_SWAP( ORIENT_FROM_EXIF( i_otag ) ) );
+
     jpeg_start_decompress(&p_sys->p_jpeg);
 
     /* Set output properties */
@@ -535,8 +578,6 @@ static int DecodeBlock(decoder_t *p_dec, block_t *p_block)
     p_dec->fmt_out.video.i_sar_num = 1;
     p_dec->fmt_out.video.i_sar_den = 1;
 
-    int i_otag; /* Orientation tag has valid range of 1-8. 1 is normal orientation, 0 = unspecified = normal */
-    i_otag = jpeg_GetOrientation( &p_sys->p_jpeg );
     if ( i_otag > 1 )
     {
         msg_Dbg( p_dec, "Jpeg orientation is %d", i_otag );
@@ -71,8 +71,8 @@ typedef struct
 static int  ParseControlSeq( decoder_t *, vlc_tick_t i_pts,
                              void(*pf_queue)(decoder_t *, subpicture_t *) );
 static int  ParseRLE       ( decoder_t *, subpicture_data_t *,
-                             const spu_properties_t *, uint16_t * );
-static int  Render         ( decoder_t *, subpicture_t *, const uint16_t *,
+                             const spu_properties_t *, picture_t * );
+static int  Render         ( decoder_t *, subpicture_t *, subpicture_region_t *,
                              const subpicture_data_t *, const spu_properties_t * );
 
 /*****************************************************************************
@@ -196,9 +196,9 @@ static void OutputPicture( decoder_t *p_dec,
                            const spu_properties_t *p_spu_properties,
                            void(*pf_queue)(decoder_t *, subpicture_t *) )
 {
-    decoder_sys_t *p_sys = p_dec->p_sys;
     subpicture_t *p_spu;
-    uint16_t *p_pixeldata;
+    subpicture_region_t *p_region;
+    video_format_t fmt;
 
     /* Allocate the subpicture internal data. */
     p_spu = decoder_NewSubpicture( p_dec, NULL );
@@ -220,41 +220,45 @@ static void OutputPicture( decoder_t *p_dec,
         p_spu->b_ephemer = true;
     }
 
-    /* we are going to expand the RLE stuff so that we won't need to read
-     * nibbles later on. This will speed things up a lot. Plus, we'll only
-     * need to do this stupid interlacing stuff once.
-     *
-     * Rationale for the "p_spudec->i_rle_size * 4*sizeof(*spu_data.p_data)":
-     *  one byte gaves two nibbles and may be used twice (once per field)
-     * generating 4 codes.
-     */
-    p_pixeldata = vlc_alloc( p_sys->i_rle_size, sizeof(*p_pixeldata) * 2 * 2 );
+    /* The RLE data is decoded straight into the palette indexes of a full
+     * size region, which is only copied if it has to be cropped. */
+    video_format_Init( &fmt, VLC_CODEC_YUVP );
+    fmt.i_sar_num = 0; /* 0 means use aspect ratio of background video */
+    fmt.i_sar_den = 1;
+    fmt.i_width = fmt.i_visible_width = p_spu_properties->i_width;
+    fmt.i_height = fmt.i_visible_height = p_spu_properties->i_height;
+    fmt.i_x_offset = fmt.i_y_offset = 0;
+
+    p_region = subpicture_region_New( &fmt );
+    if( !p_region )
+    {
+        msg_Err( p_dec, "cannot allocate SPU region" );
+        subpicture_Delete( p_spu );
+        return;
+    }
 
     /* We try to display it */
     subpicture_data_t render_spu_data = *p_spu_data; /* Need a copy */
-    if( ParseRLE( p_dec, &render_spu_data, p_spu_properties, p_pixeldata ) )
+    if( ParseRLE( p_dec, &render_spu_data, p_spu_properties, p_region->p_picture ) )
     {
         /* There was a parse error, delete the subpicture */
+        subpicture_region_Delete( p_region );
         subpicture_Delete( p_spu );
-        free( p_pixeldata );
         return;
     }
 
 #ifdef DEBUG_SPUDEC
     msg_Dbg( p_dec, "total size: 0x%x, RLE offsets: 0x%x 0x%x",
-             p_sys->i_spu_size,
+             ((decoder_sys_t *)p_dec->p_sys)->i_spu_size,
              render_spu_data.pi_offset[0], render_spu_data.pi_offset[1] );
 #endif
 
-    if( Render( p_dec, p_spu, p_pixeldata, &render_spu_data, p_spu_properties ) )
+    if( Render( p_dec, p_spu, p_region, &render_spu_data, p_spu_properties ) )
     {
         subpicture_Delete( p_spu );
-        free( p_pixeldata );
         return;
     }
 
-    free( p_pixeldata );
-
     if( p_spu_data->p_pxctli && p_spu )
         ParsePXCTLI( p_dec, p_spu_data, p_spu );
 
@@ -594,23 +598,32 @@ static int ParseControlSeq( decoder_t *p_dec, vlc_tick_t i_pts,
 /*****************************************************************************
  * ParseRLE: parse the RLE part of the subtitle
  *****************************************************************************
- * This part parses the subtitle graphical data and stores it in a more
- * convenient structure for later decoding. For more information on the
- * subtitles format, see http://sam.zoy.org/doc/dvd/subtitles/index.html
+ * This part decodes the subtitle graphical data straight into the palette
+ * indexes of a picture. For more information on the subtitles format, see
+ * http://sam.zoy.org/doc/dvd/subtitles/index.html
  *****************************************************************************/
+
+/* Number of nibbles of a RLE code, from the 6 first bits of the code. */
+static const uint8_t pi_rle_nibbles[64] =
+{
+    4, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
 static int ParseRLE( decoder_t *p_dec,
                      subpicture_data_t *p_spu_data,
                      const spu_properties_t *p_spu_properties,
-                     uint16_t *p_pixeldata )
+                     picture_t *p_picture )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
 
     const unsigned int i_width = p_spu_properties->i_width;
     const unsigned int i_height = p_spu_properties->i_height;
+    const uint8_t *p_src = &p_sys->buffer[4];
     unsigned int i_x, i_y;
 
-    uint16_t *p_dest = p_pixeldata;
-
     /* The subtitles are interlaced, we need two offsets */
     unsigned int  i_id = 0;                   /* Start on the even SPU layer */
     unsigned int  pi_table[ 2 ];
@@ -630,21 +643,28 @@ static int ParseRLE( decoder_t *p_dec,
 
     for( i_y = 0 ; i_y < i_height ; i_y++ )
     {
+        uint8_t *p_line = &p_picture->p->p_pixels[i_y * p_picture->p->i_pitch];
         unsigned int i_code;
         pi_offset = pi_table + i_id;
 
         for( i_x = 0 ; i_x < i_width ; i_x += i_code >> 2 )
         {
-            i_code = 0;
-            for( unsigned int i_min = 1; i_min <= 0x40 && i_code < i_min; i_min <<= 2 )
+            /* Read 16 bits from the current nibble (the SPU buffer is padded
+             * for it); the length of the code only depends on its leading
+             * zero nibbles */
+            const uint8_t *p = &p_src[*pi_offset >> 1];
+            unsigned int i_bits = ( p[0] << 16 ) | ( p[1] << 8 ) | p[2];
+            i_bits = ( i_bits >> ( ( *pi_offset & 0x1 ) ? 4 : 8 ) ) & 0xffff;
+
+            const unsigned int i_nibbles = pi_rle_nibbles[i_bits >> 10];
+            if( ( ( *pi_offset + i_nibbles - 1 ) >> 1 ) >= p_sys->i_spu_size )
             {
-                if( (*pi_offset >> 1) >= p_sys->i_spu_size )
-                {
-                    msg_Err( p_dec, "out of bounds while reading rle" );
-                    return VLC_EGENERIC;
-                }
-                i_code = AddNibble( i_code, &p_sys->buffer[4], pi_offset );
+                msg_Err( p_dec, "out of bounds while reading rle" );
+                return VLC_EGENERIC;
             }
+            *pi_offset += i_nibbles;
+            i_code = i_bits >> ( 16 - 4 * i_nibbles );
+
             if( i_code < 0x0004 )
             {
                 /* If the 14 first bits are set to 0, then it's a
@@ -652,13 +672,15 @@ static int ParseRLE( decoder_t *p_dec,
                 i_code |= ( i_width - i_x ) << 2;
             }
 
-            if( ( (i_code >> 2) + i_x + i_y * i_width ) > i_height * i_width )
+            if( (i_code >> 2) > i_width - i_x )
             {
-                msg_Err( p_dec, "out of bounds, %i at (%i,%i) is out of %ix%i",
-                         i_code >> 2, i_x, i_y, i_width, i_height );
+                msg_Err( p_dec, "i_x overflowed, %i > %i",
+                         i_x + (i_code >> 2), i_width );
                 return VLC_EGENERIC;
             }
 
+            memset( &p_line[i_x], i_code & 0x3, i_code >> 2 );
+
             /* Try to find the border color */
             if( p_spu_data->pi_alpha[ i_code & 0x3 ] != 0x00 )
             {
@@ -695,32 +717,17 @@ static int ParseRLE( decoder_t *p_dec,
                     else
                     {
                         /* We can't be sure the current lines will be skipped,
-                         * so we store the code just in case. */
-                      *p_dest++ = i_code;
+                         * so we count them just in case. */
                       i_skipped_bottom++;
                     }
                 }
                 else
                 {
-                    /* We got a valid code, store it */
-                    *p_dest++ = i_code;
-
                     /* Valid code means no blank line */
                     b_empty_top = false;
                     i_skipped_bottom = 0;
                 }
             }
-            else
-            {
-                *p_dest++ = i_code;
-            }
-        }
-
-        /* Check that we didn't go too far */
-        if( i_x > i_width )
-        {
-            msg_Err( p_dec, "i_x overflowed, %i > %i", i_x, i_width );
-            return VLC_EGENERIC;
         }
 
         /* Byte-align the stream */
@@ -733,23 +740,6 @@ static int ParseRLE( decoder_t *p_dec,
         i_id = ~i_id & 0x1;
     }
 
-    /* We shouldn't get any padding bytes */
-    if( i_y < i_height )
-    {
-        msg_Err( p_dec, "padding bytes found in RLE sequence" );
-        msg_Err( p_dec, "send mail to <sam@zoy.org> if you "
-                        "want to help debugging this" );
-
-        /* Skip them just in case */
-        while( i_y < i_height )
-        {
-            *p_dest++ = i_width << 2;
-            i_y++;
-        }
-
-        return VLC_EGENERIC;
-    }
-
 #ifdef DEBUG_SPUDEC
     msg_Dbg( p_dec, "valid subtitle, size: %ix%i, position: %i,%i",
              p_spu_properties->i_width, p_spu_properties->i_height,
@@ -833,64 +823,56 @@ static int ParseRLE( decoder_t *p_dec,
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Render: set the colors and the position of the decoded region
+ *****************************************************************************
+ * The region is attached to the subpicture, or deleted on error.
+ *****************************************************************************/
 static int Render( decoder_t *p_dec, subpicture_t *p_spu,
-                    const uint16_t *p_pixeldata,
-                    const subpicture_data_t *p_spu_data,
-                    const spu_properties_t *p_spu_properties )
+                   subpicture_region_t *p_region,
+                   const subpicture_data_t *p_spu_data,
+                   const spu_properties_t *p_spu_properties )
 {
-    uint8_t *p_p;
-    int i_x, i_y, i_len, i_color, i_pitch;
-    const uint16_t *p_source = p_pixeldata;
-    video_format_t fmt;
-    video_palette_t palette;
+    video_palette_t *p_palette = p_region->fmt.p_palette;
 
-    /* Create a new subpicture region */
-    video_format_Init( &fmt, VLC_CODEC_YUVP );
-    fmt.i_sar_num = 0; /* 0 means use aspect ratio of background video */
-    fmt.i_sar_den = 1;
-    fmt.i_width = fmt.i_visible_width = p_spu_properties->i_width;
-    fmt.i_height = fmt.i_visible_height = p_spu_properties->i_height -
-        p_spu_data->i_y_top_offset - p_spu_data->i_y_bottom_offset;
-    fmt.i_x_offset = fmt.i_y_offset = 0;
-    fmt.p_palette = &palette;
-    fmt.p_palette->i_entries = 4;
-    for( i_x = 0; i_x < fmt.p_palette->i_entries; i_x++ )
+    p_palette->i_entries = 4;
+    for( int i = 0; i < p_palette->i_entries; i++ )
     {
-        fmt.p_palette->palette[i_x][0] = p_spu_data->pi_yuv[i_x][0];
-        fmt.p_palette->palette[i_x][1] = p_spu_data->pi_yuv[i_x][1];
-        fmt.p_palette->palette[i_x][2] = p_spu_data->pi_yuv[i_x][2];
-        fmt.p_palette->palette[i_x][3] = p_spu_data->pi_alpha[i_x] * 0x11;
+        p_palette->palette[i][0] = p_spu_data->pi_yuv[i][0];
+        p_palette->palette[i][1] = p_spu_data->pi_yuv[i][1];
+        p_palette->palette[i][2] = p_spu_data->pi_yuv[i][2];
+        p_palette->palette[i][3] = p_spu_data->pi_alpha[i] * 0x11;
     }
 
-    p_spu->p_region = subpicture_region_New( &fmt );
-    if( !p_spu->p_region )
+    /* Drop the blank lines found by the auto crop */
+    if( p_spu_data->i_y_top_offset || p_spu_data->i_y_bottom_offset )
     {
-        fmt.p_palette = NULL;
-        video_format_Clean( &fmt );
-        msg_Err( p_dec, "cannot allocate SPU region" );
-        return VLC_EGENERIC;
-    }
+        video_format_t fmt = p_region->fmt;
+        fmt.i_height = fmt.i_visible_height = p_spu_properties->i_height -
+            p_spu_data->i_y_top_offset - p_spu_data->i_y_bottom_offset;
 
-    p_spu->p_region->i_x = p_spu_properties->i_x;
-    p_spu->p_region->i_y = p_spu_properties->i_y + p_spu_data->i_y_top_offset;
-    p_p = p_spu->p_region->p_picture->p->p_pixels;
-    i_pitch = p_spu->p_region->p_picture->p->i_pitch;
-
-    /* Draw until we reach the bottom of the subtitle */
-    for( i_y = 0; i_y < (int)fmt.i_height * i_pitch; i_y += i_pitch )
-    {
-        /* Draw until we reach the end of the line */
-        for( i_x = 0 ; i_x < (int)fmt.i_width; i_x += i_len )
+        subpicture_region_t *p_crop = subpicture_region_New( &fmt );
+        if( !p_crop )
         {
-            /* Get the RLE part, then draw the line */
-            i_color = *p_source & 0x3;
-            i_len = *p_source++ >> 2;
-            memset( p_p + i_x + i_y, i_color, i_len );
+            msg_Err( p_dec, "cannot allocate SPU region" );
+            subpicture_region_Delete( p_region );
+            return VLC_EGENERIC;
         }
+
+        const plane_t *p_src = &p_region->p_picture->p[0];
+        plane_t *p_dst = &p_crop->p_picture->p[0];
+        for( unsigned i = 0; i < fmt.i_height; i++ )
+            memcpy( &p_dst->p_pixels[i * p_dst->i_pitch],
+                    &p_src->p_pixels[(i + p_spu_data->i_y_top_offset) * p_src->i_pitch],
+                    fmt.i_width );
+
+        subpicture_region_Delete( p_region );
+        p_region = p_crop;
     }
 
-    fmt.p_palette = NULL;
-    video_format_Clean( &fmt );
+    p_region->i_x = p_spu_properties->i_x;
+    p_region->i_y = p_spu_properties->i_y + p_spu_data->i_y_top_offset;
+    p_spu->p_region = p_region;
 
     return VLC_SUCCESS;
 }
@@ -34,8 +34,8 @@ typedef struct
 
     block_t *p_block;
 
-    /* We will never overflow */
-    uint8_t buffer[65536];
+    /* We will never overflow; the padding covers the RLE look-ahead */
+    uint8_t buffer[65536 + 8];
 } decoder_sys_t;
 
 /*****************************************************************************
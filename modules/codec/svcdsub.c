@@ -33,7 +33,6 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
-#include <vlc_bits.h>
 
 #include "../demux/mpeg/timestamps.h"
 
@@ -508,6 +507,58 @@ static subpicture_t *DecodePacket( decoder_t *p_dec, block_t *p_data )
     return p_spu;
 }
 
+/* Expansion of one image byte, svcd_rle[pending][byte], pending meaning that
+ * the previous byte ended with a color 0 whose count is in this byte. */
+typedef struct
+{
+    uint8_t i_pixels;
+    bool    b_pending;
+    uint8_t p_pixels[10];
+} svcd_rle_t;
+
+static svcd_rle_t svcd_rle[2][256];
+static vlc_once_t svcd_rle_once = VLC_STATIC_ONCE;
+
+static void SVCDSubRleInit( void )
+{
+    for( unsigned i_pending = 0; i_pending < 2; i_pending++ )
+    {
+        for( unsigned i_byte = 0; i_byte < 256; i_byte++ )
+        {
+            svcd_rle_t *p_rle = &svcd_rle[i_pending][i_byte];
+            bool b_count = i_pending;
+
+            for( int i_shift = 6; i_shift >= 0; i_shift -= 2 )
+            {
+                const uint8_t i_val = ( i_byte >> i_shift ) & 0x3;
+
+                if( b_count )
+                {
+                    /* Color 0 repeated 1 to 4 times */
+                    for( unsigned i = 0; i <= i_val; i++ )
+                        p_rle->p_pixels[p_rle->i_pixels++] = 0;
+                    b_count = false;
+                }
+                else if( i_val == 0 )
+                    b_count = true;
+                else
+                    p_rle->p_pixels[p_rle->i_pixels++] = i_val;
+            }
+            p_rle->b_pending = b_count;
+        }
+    }
+}
+
+static inline uint8_t SVCDSubReadBits( const uint8_t *p_src, const uint8_t *p_end,
+                                       unsigned *pi_bit )
+{
+    const uint8_t *p = &p_src[*pi_bit >> 3];
+    const unsigned i_shift = 6 - ( *pi_bit & 0x7 );
+
+    *pi_bit += 2;
+    return p < p_end ? ( *p >> i_shift ) & 0x3 : 0;
+}
+
 /*****************************************************************************
  * SVCDSubRenderImage: reorders bytes of image data in subpicture region.
  *****************************************************************************
@@ -531,40 +582,66 @@ static void SVCDSubRenderImage( decoder_t *p_dec, block_t *p_data,
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
     uint8_t *p_dest = p_region->p_picture->Y_PIXELS;
+    const int i_pitch = p_region->p_picture->Y_PITCH;
+    const uint8_t *p_end = p_data->p_buffer + p_data->i_buffer;
+    const uint8_t *p_src;
     int i_field;            /* The subtitles are interlaced */
     int i_row, i_column;    /* scanline row/column number */
-    uint8_t i_color, i_count;
-    bs_t bs;
 
-    bs_init( &bs, p_data->p_buffer + p_sys->i_image_offset,
-             p_data->i_buffer - p_sys->i_image_offset );
+    vlc_once( &svcd_rle_once, SVCDSubRleInit );
 
+    p_src = p_data->p_buffer + p_sys->i_image_offset;
     for( i_field = 0; i_field < 2; i_field++ )
     {
         for( i_row = i_field; i_row < p_sys->i_height; i_row += 2 )
         {
-            for( i_column = 0; i_column < p_sys->i_width; i_column++ )
+            uint8_t *p_line = &p_dest[i_row * i_pitch];
+            bool b_pending = false;
+            unsigned i_bit = 0;
+
+            /* Expand whole bytes as long as they cannot reach the end of
+             * the line, where the padding bits are */
+            for( i_column = 0;
+                 i_column + 10 <= p_sys->i_width && p_src < p_end; )
+            {
+                const svcd_rle_t *p_rle = &svcd_rle[b_pending][*p_src++];
+
+                memcpy( &p_line[i_column], p_rle->p_pixels,
+                        sizeof(p_rle->p_pixels) );
+                i_column += p_rle->i_pixels;
+                b_pending = p_rle->b_pending;
+            }
+
+            /* Then the end of the line one code at a time */
+            while( i_column < p_sys->i_width )
             {
-                i_color = bs_read( &bs, 2 );
-                if( i_color == 0 && (i_count = bs_read( &bs, 2 )) )
+                if( !b_pending )
                 {
-                    i_count = __MIN( i_count, p_sys->i_width - i_column );
-                    memset( &p_dest[i_row * p_region->p_picture->Y_PITCH +
-                                    i_column], 0, i_count + 1 );
-                    i_column += i_count;
-                    continue;
+                    uint8_t i_color = SVCDSubReadBits( p_src, p_end, &i_bit );
+                    if( i_color != 0 )
+                    {
+                        p_line[i_column++] = i_color;
+                        continue;
+                    }
                 }
+                b_pending = false;
 
-                p_dest[i_row * p_region->p_picture->Y_PITCH + i_column] = i_color;
+                int i_count = SVCDSubReadBits( p_src, p_end, &i_bit ) + 1;
+                i_count = __MIN( i_count, p_sys->i_width - i_column );
+                memset( &p_line[i_column], 0, i_count );
+                i_column += i_count;
             }
 
-            bs_align( &bs );
+            /* Lines are byte aligned */
+            p_src += ( i_bit + 7 ) >> 3;
         }
 
         /* odd field */
-        bs_init( &bs, p_data->p_buffer + p_sys->i_image_offset +
-                 p_sys->second_field_offset,
-                 p_data->i_buffer - p_sys->i_image_offset -
-                 p_sys->second_field_offset );
+        if( p_sys->second_field_offset >
+            p_data->i_buffer - p_sys->i_image_offset )
+            p_src = p_end;
+        else
+            p_src = p_data->p_buffer + p_sys->i_image_offset +
+                    p_sys->second_field_offset;
     }
 }
@@ -131,7 +131,6 @@ static int yyerror(yyscan_t scanner, vlc_css_parser_t *p, const char *msg)
 %type <rule> invalid_rule
 %type <rule> rule
 %type <rule> valid_rule
-%destructor { vlc_css_rules_Delete($$); } <rule>
 
 %type <string> ident_or_string
 %type <string> property
@@ -145,12 +144,10 @@ static int yyerror(yyscan_t scanner, vlc_css_parser_t *p, const char *msg)
 %type <selector> class
 %type <selector> attrib
 %type <selector> pseudo
-%destructor { vlc_css_selectors_Delete($$); } <selector> <selectorList>
 
 %type <declarationList> declaration_list
 %type <declarationList> decl_list
 %type <declaration> declaration
-%destructor { vlc_css_declarations_Delete($$); } <declaration> <declarationList>
 
 %type <boolean> prio
 
@@ -163,7 +160,6 @@ static int yyerror(yyscan_t scanner, vlc_css_parser_t *p, const char *msg)
 %type <term> term
 %type <term> unary_term
 %type <term> function
-%destructor { vlc_css_expression_Delete($$); } <expr>
 
 %type <string> element_name
 %type <string> attr_name
@@ -189,9 +185,7 @@ maybe_sgml:
 
 maybe_charset:
    /* empty */
-  | charset {
-    vlc_css_rules_Delete($1);
-  }
+  | charset { }
   ;
 
 closing_brace:
@@ -249,7 +243,6 @@ rule:
 font_face:
     FONT_FACE_SYM maybe_space
     '{' maybe_space declaration_list closing_brace {
-        vlc_css_declarations_Delete( $5 );
         $$ = NULL;
     }
     | FONT_FACE_SYM error invalid_block {
@@ -278,7 +271,7 @@ unary_operator:
 
 ruleset:
     selector_list '{' maybe_space declaration_list closing_brace {
-        $$ = vlc_css_rule_New();
+        $$ = vlc_css_rule_New( css_parser );
         if($$)
         {
             $$->p_selectors = $1;
@@ -299,15 +292,9 @@ selector_list:
             $$ = $1;
             vlc_css_selector_Append( $$, $4 );
         }
-        else
-        {
-            vlc_css_selectors_Delete( $1 );
-            vlc_css_selectors_Delete( $4 );
-            $$ = NULL;
-        }
+        else $$ = NULL;
     }
   | selector_list error {
-        vlc_css_selectors_Delete( $1 );
         $$ = NULL;
     }
    ;
@@ -346,26 +333,21 @@ selector:
         else $$ = $3;
     }
     | selector error {
-        vlc_css_selectors_Delete( $1 );
         $$ = NULL;
     }
     ;
 
 simple_selector:
     element_name {
-        $$ = vlc_css_selector_New( SELECTOR_SIMPLE, $1 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_SIMPLE, $1 );
         free( $1 );
     }
     | element_name specifier_list {
-        $$ = vlc_css_selector_New( SELECTOR_SIMPLE, $1 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_SIMPLE, $1 );
         if( $$ && $2 )
         {
             vlc_css_selector_AddSpecifier( $$, $2 );
         }
-        else
-        {
-            vlc_css_selectors_Delete( $2 );
-        }
         free( $1 );
     }
     | specifier_list {
@@ -393,14 +375,13 @@ specifier_list:
         else $$ = $2;
     }
     | specifier_list error {
-        vlc_css_selectors_Delete( $1 );
         $$ = NULL;
     }
 ;
 
 specifier:
     IDSEL {
-        $$ = vlc_css_selector_New( SPECIFIER_ID, $1 );
+        $$ = vlc_css_selector_New( css_parser, SPECIFIER_ID, $1 );
         free( $1 );
     }
     /* Case when #fffaaa like token is lexed as HEX instead of IDSEL */
@@ -408,7 +389,7 @@ specifier:
         if ($1[0] >= '0' && $1[0] <= '9') {
             $$ = NULL;
         } else {
-            $$ = vlc_css_selector_New( SPECIFIER_ID, $1 );
+            $$ = vlc_css_selector_New( css_parser, SPECIFIER_ID, $1 );
         }
         free( $1 );
     }
@@ -419,7 +400,7 @@ specifier:
 
 class:
     '.' IDENT {
-        $$ = vlc_css_selector_New( SPECIFIER_CLASS, $2 );
+        $$ = vlc_css_selector_New( css_parser, SPECIFIER_CLASS, $2 );
         free( $2 );
     }
   ;
@@ -432,15 +413,15 @@ attr_name:
 
 attrib:
     '[' maybe_space attr_name ']' {
-        $$ = vlc_css_selector_New( SPECIFIER_ATTRIB, $3 );
+        $$ = vlc_css_selector_New( css_parser, SPECIFIER_ATTRIB, $3 );
         free( $3 );
     }
     | '[' maybe_space attr_name match maybe_space ident_or_string maybe_space ']' {
-        $$ = vlc_css_selector_New( SPECIFIER_ATTRIB, $3 );
+        $$ = vlc_css_selector_New( css_parser, SPECIFIER_ATTRIB, $3 );
         if( $$ )
         {
             $$->match = $4;
-            $$->p_matchsel = vlc_css_selector_New( SPECIFIER_ID, $6 );
+            $$->p_matchsel = vlc_css_selector_New( css_parser, SPECIFIER_ID, $6 );
         }
         free( $3 );
         free( $6 );
@@ -475,18 +456,18 @@ ident_or_string:
 
 pseudo:
     ':' IDENT {
-        $$ = vlc_css_selector_New( SELECTOR_PSEUDOCLASS, $2 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_PSEUDOCLASS, $2 );
         free( $2 );
     }
     | ':' ':' IDENT {
-        $$ = vlc_css_selector_New( SELECTOR_PSEUDOELEMENT, $3 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_PSEUDOELEMENT, $3 );
         free( $3 );
     }
     // used by :nth-*
     | ':' FUNCTION maybe_space maybe_unary_operator NUMBER maybe_space ')' {
         if(*$2 != 0)
             $2[strlen($2) - 1] = 0;
-        $$ = vlc_css_selector_New( SELECTOR_PSEUDOCLASS, $2 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_PSEUDOCLASS, $2 );
         $5.val *= $4;
         free( $2 );
         vlc_css_term_Clean( $5 );
@@ -495,21 +476,19 @@ pseudo:
     | ':' ':' FUNCTION maybe_space selector maybe_space ')' {
         if(*$3 != 0)
             $3[strlen($3) - 1] = 0;
-        $$ = vlc_css_selector_New( SELECTOR_PSEUDOELEMENT, $3 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_PSEUDOELEMENT, $3 );
         free( $3 );
         if( $$ && $5 )
         {
             vlc_css_selector_AddSpecifier( $$, $5 );
             $5->combinator = RELATION_SELF;
         }
-        else
-            vlc_css_selectors_Delete( $5 );
     }
     // used by :nth-*(odd/even) and :lang
     | ':' FUNCTION maybe_space IDENT maybe_space ')' {
         if(*$2 != 0)
             $2[strlen($2) - 1] = 0;
-        $$ = vlc_css_selector_New( SELECTOR_PSEUDOCLASS, $2 );
+        $$ = vlc_css_selector_New( css_parser, SELECTOR_PSEUDOCLASS, $2 );
         free( $2 );
         free( $4 );
     }
@@ -546,11 +525,9 @@ decl_list:
         $$ = $1;
     }
     | declaration invalid_block_list maybe_space {
-        vlc_css_declarations_Delete( $1 );
         $$ = NULL;
     }
     | declaration invalid_block_list ';' maybe_space {
-        vlc_css_declarations_Delete( $1 );
         $$ = NULL;
     }
     | error ';' maybe_space {
@@ -577,11 +554,9 @@ decl_list:
 
 declaration:
     property ':' maybe_space expr prio {
-        $$ = vlc_css_declaration_New( $1 );
+        $$ = vlc_css_declaration_New( css_parser, $1 );
         if( $$ )
             $$->expr = $4;
-        else
-            vlc_css_expression_Delete( $4 );
         free( $1 );
     }
     |
@@ -592,7 +567,6 @@ declaration:
     |
     property ':' maybe_space error expr prio {
         free( $1 );
-        vlc_css_expression_Delete( $5 );
         /* The default movable type template has letter-spacing: .none;  Handle this by looking for
         error tokens at the start of an expr, recover the expr and then treat as an error, cleaning
         up and deleting the shifted expr.  */
@@ -601,7 +575,6 @@ declaration:
     |
     property ':' maybe_space expr prio error {
         free( $1 );
-        vlc_css_expression_Delete( $4 );
         /* When we encounter something like p {color: red !important fail;} we should drop the declaration */
         $$ = NULL;
     }
@@ -643,25 +616,22 @@ prio:
 
 expr:
     term {
-        $$ = vlc_css_expression_New( $1 );
+        $$ = vlc_css_expression_New( css_parser, $1 );
         if( !$$ )
             vlc_css_term_Clean( $1 );
     }
     | expr operator term {
         $$ = $1;
-        if( !$1 || !vlc_css_expression_AddTerm($1, $2, $3) )
+        if( !$1 || !vlc_css_expression_AddTerm(css_parser, $1, $2, $3) )
             vlc_css_term_Clean( $3 );
     }
     | expr invalid_block_list {
-        vlc_css_expression_Delete( $1 );
         $$ = NULL;
     }
     | expr invalid_block_list error {
-        vlc_css_expression_Delete( $1 );
         $$ = NULL;
     }
     | expr error {
-        vlc_css_expression_Delete( $1 );
         $$ = NULL;
     }
   ;
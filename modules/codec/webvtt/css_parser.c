@@ -44,14 +44,9 @@ static void vlc_css_rules_Debug( const vlc_css_rule_t *p_rule, int depth );
 
 void vlc_css_term_Clean( vlc_css_term_t a )
 {
+    /* The function expression, if any, belongs to the arena */
     if( a.type >= TYPE_STRING )
         free( a.psz );
-
-    if( a.type == TYPE_FUNCTION )
-    {
-        if( a.function )
-            vlc_css_expression_Delete( a.function );
-    }
 }
 
 static void vlc_css_term_Debug( const vlc_css_term_t a, int depth )
@@ -67,13 +62,15 @@ static void vlc_css_term_Debug( const vlc_css_term_t a, int depth )
     else printf("%x %f\n", a.type, a.val);
 }
 
-bool vlc_css_expression_AddTerm( vlc_css_expr_t *p_expr,
-                                        char op, vlc_css_term_t a )
+bool vlc_css_expression_AddTerm( vlc_css_parser_t *p_parser, vlc_css_expr_t *p_expr,
+                                 char op, vlc_css_term_t a )
 {
     if( p_expr->i_count >= p_expr->i_alloc )
     {
         size_t i_realloc = (p_expr->i_alloc == 0) ? 1 : p_expr->i_alloc + 4;
-        void *reac = realloc( p_expr->seq, i_realloc * sizeof(p_expr->seq[0]) );
+        void *reac = vlc_arena_Realloc( &p_parser->arena, p_expr->seq,
+                                        p_expr->i_alloc * sizeof(p_expr->seq[0]),
+                                        i_realloc * sizeof(p_expr->seq[0]) );
         if( reac )
         {
             p_expr->seq = reac;
@@ -84,22 +81,21 @@ bool vlc_css_expression_AddTerm( vlc_css_expr_t *p_expr,
     if( p_expr->i_count >= p_expr->i_alloc )
         return false;
 
+    /* Move the string from the lexer into the arena */
+    if( a.type >= TYPE_STRING && a.psz )
+    {
+        char *psz = vlc_arena_Strdup( &p_parser->arena, a.psz );
+        if( !psz )
+            return false;
+        free( a.psz );
+        a.psz = psz;
+    }
+
     p_expr->seq[p_expr->i_count].op = op;
     p_expr->seq[p_expr->i_count++].term = a;
     return true;
 }
 
-void vlc_css_expression_Delete( vlc_css_expr_t *p_expr )
-{
-    if( p_expr )
-    {
-        for(size_t i=0; i<p_expr->i_count; i++)
-            vlc_css_term_Clean( p_expr->seq[i].term );
-        free( p_expr->seq );
-    }
-    free( p_expr );
-}
-
 static void vlc_css_expression_Debug( const vlc_css_expr_t *p_expr, int depth )
 {
     if( p_expr )
@@ -111,31 +107,16 @@ static void vlc_css_expression_Debug( const vlc_css_expr_t *p_expr, int depth )
     }
 }
 
-vlc_css_expr_t * vlc_css_expression_New( vlc_css_term_t term )
+vlc_css_expr_t * vlc_css_expression_New( vlc_css_parser_t *p_parser, vlc_css_term_t term )
 {
-    vlc_css_expr_t *p_expr = calloc(1, sizeof(*p_expr));
-    if(!vlc_css_expression_AddTerm( p_expr, 0, term ))
-    {
-        free(p_expr);
+    vlc_css_expr_t *p_expr = vlc_arena_Calloc( &p_parser->arena, 1, sizeof(*p_expr) );
+    if( !p_expr || !vlc_css_expression_AddTerm( p_parser, p_expr, 0, term ) )
         p_expr = NULL;
-    }
     return p_expr;
 }
 
 CHAIN_APPEND_IMPL(vlc_css_declarations_Append, vlc_css_declaration_t)
 
-void vlc_css_declarations_Delete( vlc_css_declaration_t *p_decl )
-{
-    while( p_decl )
-    {
-        vlc_css_declaration_t *p_next = p_decl->p_next;
-        vlc_css_expression_Delete( p_decl->expr );
-        free( p_decl->psz_property );
-        free( p_decl );
-        p_decl = p_next;
-    }
-}
-
 static void vlc_css_declarations_Debug( const vlc_css_declaration_t *p_decl, int depth )
 {
     while( p_decl )
@@ -147,10 +128,14 @@ static void vlc_css_declarations_Debug( const vlc_css_declaration_t *p_decl, int
     }
 }
 
-vlc_css_declaration_t * vlc_css_declaration_New( const char *psz )
+vlc_css_declaration_t * vlc_css_declaration_New( vlc_css_parser_t *p_parser, const char *psz )
 {
-    vlc_css_declaration_t *p_decl = calloc(1, sizeof(*p_decl));
-    p_decl->psz_property = strdup(psz);
+    vlc_css_declaration_t *p_decl = vlc_arena_Calloc( &p_parser->arena, 1, sizeof(*p_decl) );
+    if( !p_decl )
+        return NULL;
+    p_decl->psz_property = vlc_arena_Strdup( &p_parser->arena, psz );
+    if( !p_decl->psz_property )
+        return NULL;
     return p_decl;
 }
 
@@ -167,19 +152,6 @@ vlc_css_selector_AddSpecifier( vlc_css_selector_t *p_sel, vlc_css_selector_t *p_
     }
 }
 
-void vlc_css_selectors_Delete( vlc_css_selector_t *p_sel )
-{
-    while( p_sel )
-    {
-        vlc_css_selector_t *p_next = p_sel->p_next;
-        free( p_sel->psz_name );
-        vlc_css_selectors_Delete( p_sel->specifiers.p_first );
-        vlc_css_selectors_Delete( p_sel->p_matchsel );
-        free( p_sel );
-        p_sel = p_next;
-    }
-}
-
 static void vlc_css_selectors_Debug( const vlc_css_selector_t *p_sel, int depth )
 {
     while( p_sel )
@@ -191,28 +163,20 @@ static void vlc_css_selectors_Debug( const vlc_css_selector_t *p_sel, int depth
     }
 }
 
-vlc_css_selector_t * vlc_css_selector_New( int type, const char *psz )
+vlc_css_selector_t * vlc_css_selector_New( vlc_css_parser_t *p_parser, int type, const char *psz )
 {
-    vlc_css_selector_t *p_sel = calloc(1, sizeof(*p_sel));
-    p_sel->psz_name = strdup(psz);
+    vlc_css_selector_t *p_sel = vlc_arena_Calloc( &p_parser->arena, 1, sizeof(*p_sel) );
+    if( !p_sel )
+        return NULL;
+    p_sel->psz_name = vlc_arena_Strdup( &p_parser->arena, psz );
+    if( !p_sel->psz_name )
+        return NULL;
     p_sel->type = type;
     p_sel->combinator = RELATION_SELF;
     p_sel->specifiers.pp_append = &p_sel->specifiers.p_first;
     return p_sel;
 }
 
-void vlc_css_rules_Delete( vlc_css_rule_t *p_rule )
-{
-    while(p_rule)
-    {
-        vlc_css_rule_t *p_next = p_rule->p_next;
-        vlc_css_selectors_Delete( p_rule->p_selectors );
-        vlc_css_declarations_Delete( p_rule->p_declarations );
-        free(p_rule);
-        p_rule = p_next;
-    }
-}
-
 static void vlc_css_rules_Debug( const vlc_css_rule_t *p_rule, int depth )
 {
     int j = 0;
@@ -225,9 +189,9 @@ static void vlc_css_rules_Debug( const vlc_css_rule_t *p_rule, int depth )
     }
 }
 
-vlc_css_rule_t * vlc_css_rule_New( void )
+vlc_css_rule_t * vlc_css_rule_New( vlc_css_parser_t *p_parser )
 {
-    vlc_css_rule_t *p_rule = calloc(1, sizeof(*p_rule));
+    vlc_css_rule_t *p_rule = vlc_arena_Calloc( &p_parser->arena, 1, sizeof(*p_rule) );
     return p_rule;
 }
 
@@ -245,12 +209,15 @@ void vlc_css_parser_Debug( const vlc_css_parser_t *p_parser )
 
 void vlc_css_parser_Clean( vlc_css_parser_t *p_parser )
 {
-    vlc_css_rules_Delete( p_parser->rules.p_first );
+    vlc_arena_Clean( &p_parser->arena );
+    p_parser->rules.p_first = NULL;
+    p_parser->rules.pp_append = &p_parser->rules.p_first;
 }
 
 void vlc_css_parser_Init( vlc_css_parser_t *p_parser )
 {
     memset(p_parser, 0, sizeof(vlc_css_parser_t));
+    vlc_arena_Init( &p_parser->arena, 0 );
     p_parser->rules.pp_append = &p_parser->rules.p_first;
 }
 
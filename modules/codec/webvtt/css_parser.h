@@ -23,6 +23,8 @@
 //#define YYDEBUG 1
 //#define CSS_PARSER_DEBUG
 
+#include <vlc_arena.h>
+
 typedef struct vlc_css_parser_t vlc_css_parser_t;
 typedef struct vlc_css_selector_t vlc_css_selector_t;
 typedef struct vlc_css_declaration_t vlc_css_declaration_t;
@@ -133,6 +135,8 @@ struct vlc_css_rule_t
 
 struct vlc_css_parser_t
 {
+    /* Storage for the rules and everything they refer to */
+    vlc_arena_t arena;
     struct
     {
         vlc_css_rule_t *p_first;
@@ -142,22 +146,22 @@ struct vlc_css_parser_t
 
 #define CHAIN_APPEND_DECL(n, t) void n( t *p_a, t *p_b )
 
+/* Rules, selectors, declarations and expressions are allocated from the
+ * parser arena, and released all at once by vlc_css_parser_Clean().
+ * Terms own their heap string until they are added to an expression. */
 void vlc_css_term_Clean( vlc_css_term_t a );
-bool vlc_css_expression_AddTerm( vlc_css_expr_t *p_expr, char op, vlc_css_term_t a );
-void vlc_css_expression_Delete( vlc_css_expr_t *p_expr );
-vlc_css_expr_t * vlc_css_expression_New( vlc_css_term_t term );
+bool vlc_css_expression_AddTerm( vlc_css_parser_t *p_parser, vlc_css_expr_t *p_expr,
+                                 char op, vlc_css_term_t a );
+vlc_css_expr_t * vlc_css_expression_New( vlc_css_parser_t *p_parser, vlc_css_term_t term );
 
 CHAIN_APPEND_DECL(vlc_css_declarations_Append, vlc_css_declaration_t);
-void vlc_css_declarations_Delete( vlc_css_declaration_t *p_decl );
-vlc_css_declaration_t * vlc_css_declaration_New( const char *psz );
+vlc_css_declaration_t * vlc_css_declaration_New( vlc_css_parser_t *p_parser, const char *psz );
 
 CHAIN_APPEND_DECL(vlc_css_selector_Append, vlc_css_selector_t);
 void vlc_css_selector_AddSpecifier( vlc_css_selector_t *p_sel, vlc_css_selector_t *p_spec );
-void vlc_css_selectors_Delete( vlc_css_selector_t *p_sel );
-vlc_css_selector_t * vlc_css_selector_New( int type, const char *psz );
+vlc_css_selector_t * vlc_css_selector_New( vlc_css_parser_t *p_parser, int type, const char *psz );
 
-void vlc_css_rules_Delete( vlc_css_rule_t *p_rule );
-vlc_css_rule_t * vlc_css_rule_New( void );
+vlc_css_rule_t * vlc_css_rule_New( vlc_css_parser_t *p_parser );
 
 void vlc_css_parser_AddRule( vlc_css_parser_t *p_parser, vlc_css_rule_t *p_rule );
 void vlc_css_parser_Debug( const vlc_css_parser_t *p_parser );
@@ -156,7 +156,8 @@ typedef struct
     webvtt_dom_tag_t *p_root;
 #ifdef HAVE_CSS
     /* CSS */
-    vlc_css_rule_t *p_css_rules;
+    vlc_css_parser_t css;
+    bool b_css_timed; /* rules depend on :past/:future */
 #endif
 } decoder_sys_t;
 
@@ -1369,7 +1370,7 @@ static text_style_t * ComputeStyle( decoder_t *p_dec, const webvtt_dom_node_t *p
                 {
 #ifdef HAVE_CSS
                     decoder_sys_t *p_sys = p_dec->p_sys;
-                    if( p_sys->p_css_rules == NULL ) /* Only auto style when no CSS sheet */
+                    if( p_sys->css.rules.p_first == NULL ) /* Only auto style when no CSS sheet */
 #endif
                     {
                         if( p_style || (p_style = text_style_Create( STYLE_NO_DEFAULTS )) )
@@ -1681,6 +1682,29 @@ static void ClearCSSStyles( webvtt_dom_node_t *p_node )
 }
 
 #ifdef HAVE_CSS
+static bool IsTimedSelector( const vlc_css_selector_t *p_sel )
+{
+    for( ; p_sel; p_sel = p_sel->p_next )
+    {
+        if( p_sel->type == SELECTOR_PSEUDOCLASS &&
+            ( !strcmp( p_sel->psz_name, "past" ) ||
+              !strcmp( p_sel->psz_name, "future" ) ) )
+            return true;
+        if( IsTimedSelector( p_sel->specifiers.p_first ) ||
+            IsTimedSelector( p_sel->p_matchsel ) )
+            return true;
+    }
+    return false;
+}
+
+static bool HasTimedCSSRules( const vlc_css_rule_t *p_rule )
+{
+    for( ; p_rule; p_rule = p_rule->p_next )
+        if( IsTimedSelector( p_rule->p_selectors ) )
+            return true;
+    return false;
+}
+
 static void ApplyCSSRules( decoder_t *p_dec, const vlc_css_rule_t *p_rule,
                            vlc_tick_t i_playbacktime )
 {
@@ -1721,14 +1745,18 @@ static void ApplyCSSRules( decoder_t *p_dec, const vlc_css_rule_t *p_rule,
 }
 #endif
 
-static void RenderRegions( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop )
+static void RenderRegions( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop,
+                           bool b_apply_css )
 {
     subpicture_t *p_spu = NULL;
     substext_updater_region_t *p_updtregion = NULL;
     decoder_sys_t *p_sys = p_dec->p_sys;
 
 #ifdef HAVE_CSS
-    ApplyCSSRules( p_dec, p_sys->p_css_rules, i_start );
+    if( b_apply_css )
+        ApplyCSSRules( p_dec, p_sys->css.rules.p_first, i_start );
+#else
+    VLC_UNUSED(b_apply_css);
 #endif
 
     const webvtt_dom_cue_t *p_rlcue = NULL;
@@ -1865,6 +1893,16 @@ static void Render( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop )
     if( timedtags.i_count )
         qsort( timedtags.pp_elems, timedtags.i_count, sizeof(*timedtags.pp_elems), timedtagsArrayCmp );
 
+    /* Styles only need to be computed again for each timed tag interval
+     * when some rules match on :past or :future. Otherwise, the styles
+     * computed for the first interval are kept for the following ones. */
+#ifdef HAVE_CSS
+    const bool b_timed = p_sys->b_css_timed;
+#else
+    const bool b_timed = false;
+#endif
+    bool b_styled = false;
+
     vlc_tick_t i_substart = i_start;
     for( size_t i=0; i<timedtags.i_count; i++ )
     {
@@ -1872,17 +1910,19 @@ static void Render( decoder_t *p_dec, vlc_tick_t i_start, vlc_tick_t i_stop )
                  (const webvtt_dom_tag_t *) vlc_array_item_at_index( &timedtags, i );
          if( p_tag->i_start != i_substart ) /* might be duplicates */
          {
-             if( i > 0 )
+             if( i > 0 && b_timed )
                  ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
-             RenderRegions( p_dec, i_substart, p_tag->i_start );
+             RenderRegions( p_dec, i_substart, p_tag->i_start,
+                            b_timed || !b_styled );
+             b_styled = true;
              i_substart = p_tag->i_start;
          }
     }
     if( i_substart != i_stop )
     {
-        if( i_substart != i_start )
+        if( i_substart != i_start && b_timed )
             ClearCSSStyles( (webvtt_dom_node_t *)p_sys->p_root );
-        RenderRegions( p_dec, i_substart, i_stop );
+        RenderRegions( p_dec, i_substart, i_stop, b_timed || !b_styled );
     }
 
     vlc_array_clear( &timedtags );
@@ -1983,21 +2023,14 @@ static void ParserHeaderHandler( void *priv, enum webvtt_header_line_e s,
         {
             if( vlc_memstream_close( &ctx->css ) == VLC_SUCCESS )
             {
-                vlc_css_parser_t p;
-                vlc_css_parser_Init(&p);
-                vlc_css_parser_ParseBytes( &p,
+                /* The rules are appended to those of previous style blocks */
+                vlc_css_parser_ParseBytes( &p_sys->css,
                                           (const uint8_t *) ctx->css.ptr,
                                            ctx->css.length );
+                p_sys->b_css_timed = HasTimedCSSRules( p_sys->css.rules.p_first );
 #  ifdef CSS_PARSER_DEBUG
-                vlc_css_parser_Debug( &p );
+                vlc_css_parser_Debug( &p_sys->css );
 #  endif
-                vlc_css_rule_t **pp_append = &p_sys->p_css_rules;
-                while( *pp_append )
-                    pp_append = &((*pp_append)->p_next);
-                *pp_append = p.rules.p_first;
-                p.rules.p_first = NULL;
-
-                vlc_css_parser_Clean(&p);
                 free( ctx->css.ptr );
             }
         }
@@ -2106,7 +2139,7 @@ void webvtt_CloseDecoder( vlc_object_t *p_this )
     webvtt_domnode_ChainDelete( (webvtt_dom_node_t *) p_sys->p_root );
 
 #ifdef HAVE_CSS
-    vlc_css_rules_Delete( p_sys->p_css_rules );
+    vlc_css_parser_Clean( &p_sys->css );
 #endif
 
     free( p_sys );
@@ -2135,6 +2168,10 @@ int webvtt_OpenDecoder( vlc_object_t *p_this )
         return VLC_ENOMEM;
     }
     p_sys->p_root->psz_tag = strdup( "video" );
+#ifdef HAVE_CSS
+    vlc_css_parser_Init( &p_sys->css );
+    p_sys->b_css_timed = false;
+#endif
 
     p_dec->pf_decode = DecodeBlock;
     p_dec->pf_flush  = Flush;
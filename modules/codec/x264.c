@@ -407,6 +407,15 @@ static void x264_log( void *, int i_level, const char *psz, va_list );
 #define LOOKAHEAD_LONGTEXT N_("Framecount to use on frametype lookahead. " \
     "Currently default can cause sync-issues on unmuxable output, like rtsp-output without ts-mux" )
 
+#define LOOKAHEAD_THREADS_TEXT N_("Lookahead threads")
+#define LOOKAHEAD_THREADS_LONGTEXT N_("Number of threads for the frametype " \
+    "lookahead (0: auto).")
+
+#define SLICED_THREADS_TEXT N_("Sliced threads")
+#define SLICED_THREADS_LONGTEXT N_("Run each thread on a slice of the " \
+    "frame rather than on a whole frame. This removes the frame delay " \
+    "of frame threading, for low latency encoding.")
+
 #define HRD_TEXT N_("HRD-timing information")
 #define TUNE_TEXT N_("Default tune setting used" )
 #define PRESET_TEXT N_("Default preset setting used" )
@@ -664,6 +673,13 @@ vlc_module_begin ()
                  LOOKAHEAD_LONGTEXT, true )
         change_integer_range( 0, 60 )
 
+    add_integer( SOUT_CFG_PREFIX "lookahead-threads", 0, LOOKAHEAD_THREADS_TEXT,
+                 LOOKAHEAD_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 16 )
+
+    add_bool( SOUT_CFG_PREFIX "sliced-threads", false, SLICED_THREADS_TEXT,
+              SLICED_THREADS_LONGTEXT, true )
+
     add_bool( SOUT_CFG_PREFIX "intra-refresh", false, INTRAREFRESH_TEXT,
               INTRAREFRESH_LONGTEXT, true )
 
@@ -747,7 +763,8 @@ static const char *const ppsz_sout_options[] = {
     "qpmin", "quiet", "ratetol", "ref", "scenecut",
     "sps-id", "ssim", "stats", "subme", "trellis",
     "verbose", "vbv-bufsize", "vbv-init", "vbv-maxrate", "weightb", "weightp",
-    "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead", "slices",
+    "aq-mode", "aq-strength", "psy-rd", "psy", "profile", "lookahead",
+    "lookahead-threads", "sliced-threads", "slices",
     "slice-max-size", "slice-max-mbs", "intra-refresh", "mbtree", "hrd",
     "tune","preset", "opengop", "bluray-compat", "frame-packing", "options",
     "fullrange",
@@ -1329,6 +1346,11 @@ static int  Open ( vlc_object_t *p_this )
        threads = 1, however VLC usage differs and uses threads = 0 (auto) by
        default unless ofcourse transcode threads is explicitly specified.. */
     p_sys->param.i_threads = p_enc->i_threads;
+    i_val = var_GetInteger( p_enc, SOUT_CFG_PREFIX "lookahead-threads" );
+    if( i_val > 0 )
+        p_sys->param.i_lookahead_threads = i_val;
+    if( var_GetBool( p_enc, SOUT_CFG_PREFIX "sliced-threads" ) )
+        p_sys->param.b_sliced_threads = true;
 
     psz_val = var_GetString( p_enc, SOUT_CFG_PREFIX "stats" );
     if( psz_val )
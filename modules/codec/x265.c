@@ -42,14 +42,45 @@
 static int  Open (vlc_object_t *);
 static void Close(vlc_object_t *);
 
+#define SOUT_CFG_PREFIX "sout-x265-"
+
+#define FRAME_THREADS_TEXT N_("Frame threads")
+#define FRAME_THREADS_LONGTEXT N_("Number of frames encoded in parallel " \
+    "(0: one per CPU). Each one adds a frame of latency.")
+#define LOOKAHEAD_TEXT N_("Lookahead")
+#define LOOKAHEAD_LONGTEXT N_("Number of frames for the slice-type decision " \
+    "and the rate control lookahead (-1: default).")
+#define LOOKAHEAD_THREADS_TEXT N_("Lookahead threads")
+#define LOOKAHEAD_THREADS_LONGTEXT N_("Number of threads dedicated to the " \
+    "lookahead (0: shared with the frame encoders).")
+#define ZEROLATENCY_TEXT N_("Low latency")
+#define ZEROLATENCY_LONGTEXT N_("Tune for low latency: a single frame " \
+    "thread, no B-frames and no lookahead.")
+
 vlc_module_begin ()
     set_description(N_("H.265/HEVC encoder (x265)"))
     set_capability("encoder", 200)
     set_callbacks(Open, Close)
     set_category(CAT_INPUT)
     set_subcategory(SUBCAT_INPUT_VCODEC)
+
+    add_integer(SOUT_CFG_PREFIX "frame-threads", 0, FRAME_THREADS_TEXT,
+                FRAME_THREADS_LONGTEXT, true)
+        change_integer_range(0, 16)
+    add_integer(SOUT_CFG_PREFIX "lookahead", -1, LOOKAHEAD_TEXT,
+                LOOKAHEAD_LONGTEXT, true)
+        change_integer_range(-1, 250)
+    add_integer(SOUT_CFG_PREFIX "lookahead-threads", 0, LOOKAHEAD_THREADS_TEXT,
+                LOOKAHEAD_THREADS_LONGTEXT, true)
+        change_integer_range(0, 16)
+    add_bool(SOUT_CFG_PREFIX "zerolatency", false, ZEROLATENCY_TEXT,
+             ZEROLATENCY_LONGTEXT, true)
 vlc_module_end ()
 
+static const char *const ppsz_sout_options[] = {
+    "frame-threads", "lookahead", "lookahead-threads", "zerolatency", NULL
+};
+
 typedef struct
 {
     x265_encoder    *h;
@@ -134,6 +165,17 @@ static block_t *Encode(encoder_t *p_enc, picture_t *p_pict)
     return p_block;
 }
 
+/* Set through the parser, as the fields vary between x265 builds */
+static void SetParam(encoder_t *p_enc, x265_param *param, const char *name,
+                     int value)
+{
+    char buf[12];
+
+    snprintf(buf, sizeof (buf), "%d", value);
+    if (x265_param_parse(param, name, buf) != 0)
+        msg_Warn(p_enc, "cannot set x265 %s to %s", name, buf);
+}
+
 static int  Open (vlc_object_t *p_this)
 {
     encoder_t     *p_enc = (encoder_t *)p_this;
@@ -150,10 +192,18 @@ static int  Open (vlc_object_t *p_this)
 
     p_enc->fmt_in.i_codec = VLC_CODEC_I420;
 
-    x265_param *param = &p_sys->param;
-    x265_param_default(param);
+    config_ChainParse(p_enc, SOUT_CFG_PREFIX, ppsz_sout_options, p_enc->p_cfg);
 
-    param->frameNumThreads = vlc_GetCPUCount();
+    x265_param *param = &p_sys->param;
+    bool zerolatency = var_GetBool(p_enc, SOUT_CFG_PREFIX "zerolatency");
+    if (x265_param_default_preset(param, NULL,
+                                  zerolatency ? "zerolatency" : NULL) < 0)
+        x265_param_default(param);
+
+    int threads = var_GetInteger(p_enc, SOUT_CFG_PREFIX "frame-threads");
+    if (threads == 0)
+        threads = zerolatency ? 1 : vlc_GetCPUCount();
+    param->frameNumThreads = threads;
     param->bEnableWavefront = 0; // buggy in x265, use frame threading for now
     param->maxCUSize = 16; /* use smaller macroblock */
 
@@ -187,6 +237,14 @@ static int  Open (vlc_object_t *p_this)
         return VLC_EGENERIC;
     }
 
+    int lookahead = var_GetInteger(p_enc, SOUT_CFG_PREFIX "lookahead");
+    if (lookahead >= 0)
+        SetParam(p_enc, param, "rc-lookahead", lookahead);
+    int lookahead_threads = var_GetInteger(p_enc,
+                                           SOUT_CFG_PREFIX "lookahead-threads");
+    if (lookahead_threads > 0)
+        SetParam(p_enc, param, "lookahead-threads", lookahead_threads);
+
     if (p_enc->fmt_out.i_bitrate > 0) {
         param->rc.bitrate = p_enc->fmt_out.i_bitrate / 1000;
         param->rc.rateControlMode = X265_RC_ABR;
@@ -149,6 +149,16 @@ typedef enum {
 } ttxt_key_id;
 
 #define MAX_SLICES 32
+#define MAX_ROWS   25
+#define MAX_COLUMNS 41
+
+/* Last rendered RGBA row, reused as long as its characters do not change */
+typedef struct
+{
+    vbi_char          text[MAX_COLUMNS];
+    picture_t        *p_picture; /* NULL for transparent rows */
+    bool              b_valid;
+} zvbi_row_t;
 
 typedef struct
 {
@@ -171,6 +181,15 @@ typedef struct
         int pgno, subno;
     }                 nav_link[6];
     int               i_key[3];
+
+    /* Row cache of the RGBA rendering, only accessed by the decoder thread */
+    zvbi_row_t        rows[MAX_ROWS];
+    int               i_rows_page;
+    int               i_rows_columns;
+    bool              b_rows_opaque;
+    vbi_rgba          rows_color_map[40];
+    int               i_rows_first;
+    int               i_rows_last;
 } decoder_sys_t;
 
 static int Decode( decoder_t *, block_t * );
@@ -178,13 +197,16 @@ static int Decode( decoder_t *, block_t * );
 static subpicture_t *Subpicture( decoder_t *p_dec, video_format_t *p_fmt,
                                  bool b_text,
                                  int i_columns, int i_rows,
-                                 int i_align, vlc_tick_t i_pts );
+                                 vlc_tick_t i_pts );
 
 static void EventHandler( vbi_event *ev, void *user_data );
 static int OpaquePage( picture_t *p_src, const vbi_page *p_page,
                        const video_format_t *p_fmt, bool b_opaque, const int text_offset );
 static int get_first_visible_row( vbi_char *p_text, int rows, int columns);
 static int get_last_visible_row( vbi_char *p_text, int rows, int columns);
+static void RowsFlush( decoder_sys_t *p_sys );
+static bool RowsUpdate( decoder_sys_t *p_sys, vbi_page *p_page, bool b_opaque,
+                        int i_first_row, int i_num_rows );
 
 /* Properties callbacks */
 static int RequestPage( vlc_object_t *p_this, char const *psz_cmd,
@@ -288,6 +310,7 @@ static void Close( vlc_object_t *p_this )
     var_DelCallback( p_dec, "vbi-opaque", Opaque, p_sys );
     var_DelCallback( p_dec, "vbi-page", RequestPage, p_sys );
 
+    RowsFlush( p_sys );
     if( p_sys->p_vbi_dec )
         vbi_decoder_delete( p_sys->p_vbi_dec );
     free( p_sys );
@@ -371,16 +394,16 @@ static int Decode( decoder_t *p_dec, block_t *p_block )
     const unsigned int i_level = p_sys->i_level > 3 ? 3 : p_sys->i_level;
     vlc_mutex_unlock( &p_sys->lock );
 
-    /* Try to see if the page we want is in the cache yet */
     memset( &p_page, 0, sizeof(vbi_page) );
+    if( i_wanted_page == p_sys->i_last_page && !p_sys->b_update )
+        goto error;
+
+    /* Try to see if the page we want is in the cache yet */
     b_cached = vbi_fetch_vt_page( p_sys->p_vbi_dec, &p_page,
                                   vbi_dec2bcd( i_wanted_page ),
                                   i_wanted_subpage, level_zvbi_values[i_level],
                                   25, true );
 
-    if( i_wanted_page == p_sys->i_last_page && !p_sys->b_update )
-        goto error;
-
     if( !b_cached )
     {
         if( p_sys->b_text && p_sys->i_last_page != i_wanted_page )
@@ -388,7 +411,7 @@ static int Decode( decoder_t *p_dec, block_t *p_block )
             /* We need to reset the subtitle */
             p_spu = Subpicture( p_dec, &fmt, true,
                                 p_page.columns, p_page.rows,
-                                i_align, p_block->i_pts );
+                                p_block->i_pts );
             if( !p_spu )
                 goto error;
 
@@ -420,11 +443,27 @@ static int Decode( decoder_t *p_dec, block_t *p_block )
              i_first_row + 1, i_first_row + i_num_rows, p_page.rows );
 #endif
 
+    if( !p_sys->b_text )
+    {
+        if( p_page.rows > MAX_ROWS || p_page.columns > MAX_COLUMNS )
+            goto error;
+
+        vlc_mutex_lock( &p_sys->lock );
+        memcpy( p_sys->nav_link, &p_page.nav_link, sizeof( p_sys->nav_link )) ;
+        vlc_mutex_unlock( &p_sys->lock );
+
+        /* Most updates (clock, header, unchanged subtitle rows) do not touch
+         * the visible part of the page: keep the displayed subpicture, and
+         * the render cache the SPU compositor built for it. */
+        if( !RowsUpdate( p_sys, &p_page, b_opaque, i_first_row, i_num_rows ) )
+            goto error;
+    }
+
     /* If there is a page or sub to render, then we do that here */
     /* Create the subpicture unit */
     p_spu = Subpicture( p_dec, &fmt, p_sys->b_text,
                         p_page.columns, i_num_rows,
-                        i_align, p_block->i_pts );
+                        p_block->i_pts );
     if( !p_spu )
         goto error;
 
@@ -474,26 +513,31 @@ static int Decode( decoder_t *p_dec, block_t *p_block )
     }
     else
     {
-        picture_t *p_pic = p_spu->p_region->p_picture;
-
-        /* ZVBI is stupid enough to assume pitch == width */
-        p_pic->p->i_pitch = 4 * fmt.i_width;
-
         /* Maintain subtitle postion */
-        p_spu->p_region->i_y = i_first_row*10;
         p_spu->i_original_picture_width = p_page.columns*12;
         p_spu->i_original_picture_height = p_page.rows*10;
 
-        vbi_draw_vt_page_region( &p_page, ZVBI_PIXFMT_RGBA32,
-                          p_spu->p_region->p_picture->p->p_pixels, -1,
-                          0, i_first_row, p_page.columns, i_num_rows,
-                          1, 1);
-
-        vlc_mutex_lock( &p_sys->lock );
-        memcpy( p_sys->nav_link, &p_page.nav_link, sizeof( p_sys->nav_link )) ;
-        vlc_mutex_unlock( &p_sys->lock );
+        /* One region per non transparent row, sharing the cached rendering */
+        subpicture_region_t **pp_last = &p_spu->p_region;
+        for( int i_row = i_first_row; i_row < i_first_row + i_num_rows; i_row++ )
+        {
+            picture_t *p_pic = p_sys->rows[i_row].p_picture;
+            if( p_pic == NULL )
+                continue;
 
-        OpaquePage( p_pic, &p_page, &fmt, b_opaque, i_first_row * p_page.columns );
+            subpicture_region_t *p_region = subpicture_region_ForPicture( p_pic );
+            if( p_region == NULL )
+            {
+                subpicture_Delete( p_spu );
+                RowsFlush( p_sys );
+                goto error;
+            }
+            p_region->i_x = 0;
+            p_region->i_y = i_row * 10;
+            p_region->i_align = i_align;
+            *pp_last = p_region;
+            pp_last = &p_region->p_next;
+        }
     }
 
 exit:
@@ -511,7 +555,7 @@ error:
 
 static subpicture_t *Subpicture( decoder_t *p_dec, video_format_t *p_fmt,
                                  bool b_text,
-                                 int i_columns, int i_rows, int i_align,
+                                 int i_columns, int i_rows,
                                  vlc_tick_t i_pts )
 {
     video_format_t fmt;
@@ -543,24 +587,26 @@ static subpicture_t *Subpicture( decoder_t *p_dec, video_format_t *p_fmt,
     }
     fmt.i_x_offset = fmt.i_y_offset = 0;
 
-    p_spu->p_region = subpicture_region_New( &fmt );
-    if( p_spu->p_region == NULL )
+    /* RGBA pages are made of row regions, added by the caller */
+    if( b_text )
     {
-        msg_Err( p_dec, "cannot allocate SPU region" );
-        subpicture_Delete( p_spu );
-        return NULL;
-    }
+        p_spu->p_region = subpicture_region_New( &fmt );
+        if( p_spu->p_region == NULL )
+        {
+            msg_Err( p_dec, "cannot allocate SPU region" );
+            subpicture_Delete( p_spu );
+            return NULL;
+        }
 
-    p_spu->p_region->i_x = 0;
-    p_spu->p_region->i_y = 0;
+        p_spu->p_region->i_x = 0;
+        p_spu->p_region->i_y = 0;
+    }
 
     p_spu->i_start = i_pts;
     p_spu->i_stop = b_text ? i_pts + VLC_TICK_FROM_SEC(10): 0;
     p_spu->b_ephemer = true;
     p_spu->b_absolute = b_text ? false : true;
 
-    if( !b_text )
-        p_spu->p_region->i_align = i_align;
     p_spu->i_original_picture_width = fmt.i_width;
     p_spu->i_original_picture_height = fmt.i_height;
 
@@ -610,6 +656,94 @@ static void EventHandler( vbi_event *ev, void *user_data )
         msg_Dbg( p_dec, "Network ID changed" );
 }
 
+static void RowsFlush( decoder_sys_t *p_sys )
+{
+    for( int i = 0; i < MAX_ROWS; i++ )
+    {
+        if( p_sys->rows[i].p_picture )
+            picture_Release( p_sys->rows[i].p_picture );
+        p_sys->rows[i].p_picture = NULL;
+        p_sys->rows[i].b_valid = false;
+    }
+    p_sys->i_rows_first = -1;
+}
+
+/* Renders the visible rows whose characters changed since the last page.
+ * Row pictures may still be displayed: they are replaced, never redrawn.
+ * Returns false if the visible part of the page is unchanged. */
+static bool RowsUpdate( decoder_sys_t *p_sys, vbi_page *p_page, bool b_opaque,
+                        int i_first_row, int i_num_rows )
+{
+    const int i_columns = p_page->columns;
+    bool b_changed = false;
+
+    if( p_sys->i_rows_page != p_page->pgno ||
+        p_sys->i_rows_columns != i_columns ||
+        p_sys->b_rows_opaque != b_opaque ||
+        memcmp( p_sys->rows_color_map, p_page->color_map,
+                sizeof( p_sys->rows_color_map ) ) )
+    {
+        RowsFlush( p_sys );
+        p_sys->i_rows_page = p_page->pgno;
+        p_sys->i_rows_columns = i_columns;
+        p_sys->b_rows_opaque = b_opaque;
+        memcpy( p_sys->rows_color_map, p_page->color_map,
+                sizeof( p_sys->rows_color_map ) );
+    }
+
+    if( p_sys->i_rows_first != i_first_row ||
+        p_sys->i_rows_last != i_first_row + i_num_rows )
+    {
+        p_sys->i_rows_first = i_first_row;
+        p_sys->i_rows_last = i_first_row + i_num_rows;
+        b_changed = true;
+    }
+
+    for( int i_row = i_first_row; i_row < i_first_row + i_num_rows; i_row++ )
+    {
+        zvbi_row_t *p_row = &p_sys->rows[i_row];
+        vbi_char *p_text = &p_page->text[i_row * i_columns];
+
+        if( p_row->b_valid &&
+            !memcmp( p_row->text, p_text, i_columns * sizeof(*p_text) ) )
+            continue;
+
+        b_changed = true;
+        memcpy( p_row->text, p_text, i_columns * sizeof(*p_text) );
+        p_row->b_valid = true;
+        if( p_row->p_picture )
+        {
+            picture_Release( p_row->p_picture );
+            p_row->p_picture = NULL;
+        }
+
+        /* Fully transparent rows get no region */
+        if( get_first_visible_row( p_text, 1, i_columns ) < 0 )
+            continue;
+
+        video_format_t fmt;
+        video_format_Init( &fmt, VLC_CODEC_RGBA );
+        fmt.i_width = fmt.i_visible_width = i_columns * 12;
+        fmt.i_height = fmt.i_visible_height = 10;
+        fmt.i_bits_per_pixel = 32;
+
+        picture_t *p_pic = picture_NewFromFormat( &fmt );
+        if( p_pic == NULL )
+        {
+            p_row->b_valid = false;
+            continue;
+        }
+
+        vbi_draw_vt_page_region( p_page, ZVBI_PIXFMT_RGBA32,
+                                 p_pic->p->p_pixels, p_pic->p->i_pitch,
+                                 0, i_row, i_columns, 1, 1, 1 );
+        OpaquePage( p_pic, p_page, &fmt, b_opaque, i_row * i_columns );
+        p_row->p_picture = p_pic;
+    }
+
+    return b_changed;
+}
+
 static int get_first_visible_row( vbi_char *p_text, int rows, int columns)
 {
     for ( int i = 0; i < rows * columns; i++ )
@@ -50,6 +50,7 @@
 
 #include <vlc_fs.h>
 #include <vlc_network.h>
+#include <vlc_interrupt.h>
 #include <vlc_url.h>
 #include <vlc_charset.h>
 
@@ -64,6 +65,21 @@
 #define MAX_LINE_LENGTH 1024
 #define STATUS_CHANGE "status change: "
 
+/* Player events clients can subscribe to */
+enum
+{
+    RC_EVENT_STATE  = 1 << 0,
+    RC_EVENT_RATE   = 1 << 1,
+    RC_EVENT_TIME   = 1 << 2,
+    RC_EVENT_VOLUME = 1 << 3,
+    RC_EVENT_MEDIA  = 1 << 4,
+};
+
+static const char *const event_names[] =
+{
+    "state", "rate", "time", "volume", "media",
+};
+
 struct intf_sys_t
 {
     vlc_thread_t thread;
@@ -78,6 +94,22 @@ struct intf_sys_t
     enum vlc_player_state   last_state;
     bool                    b_input_buffering;
 
+    /* event subscriptions, coalesced over the event interval
+     * (protected by status_lock) */
+    unsigned                events;
+    unsigned                pending;
+    vlc_timer_t             event_timer;
+    vlc_tick_t              event_interval;
+    enum vlc_player_state   ev_state;
+    float                   ev_rate;
+    float                   ev_position;
+    vlc_tick_t              ev_time;
+    float                   ev_volume;
+
+    /* buffered command input */
+    size_t                  i_input;
+    char                    input[4 * MAX_LINE_LENGTH];
+
 #ifndef _WIN32
 # ifdef AF_LOCAL
     char *psz_unix_path;
@@ -90,6 +122,18 @@ struct intf_sys_t
     int i_socket;
 };
 
+static void rc_write(intf_thread_t *p_intf, const char *msg, size_t len)
+{
+    if( p_intf->p_sys->i_socket == -1 )
+#ifdef _WIN32
+        utf8_fprintf( stdout, "%s", msg );
+#else
+        vlc_write( 1, msg, len );
+#endif
+    else
+        net_Write( p_intf, p_intf->p_sys->i_socket, msg, len );
+}
+
 VLC_FORMAT(2, 3)
 static void msg_print(intf_thread_t *p_intf, const char *psz_fmt, ...)
 {
@@ -105,15 +149,7 @@ static void msg_print(intf_thread_t *p_intf, const char *psz_fmt, ...)
     if( len < 0 )
         return;
 
-    if( p_intf->p_sys->i_socket == -1 )
-#ifdef _WIN32
-        utf8_fprintf( stdout, "%s", msg );
-#else
-        vlc_write( 1, msg, len );
-#endif
-    else
-        net_Write( p_intf, p_intf->p_sys->i_socket, msg, len );
-
+    rc_write( p_intf, msg, len );
     free( msg );
 }
 #define msg_rc(...) msg_print(p_intf, __VA_ARGS__)
@@ -282,6 +318,10 @@ static void Help( intf_thread_t *p_intf)
     msg_rc("%s", _("| strack [X] . . . . . . . . .  set/get subtitle track"));
     msg_rc("%s", _("| key [hotkey name] . . . . . .  simulate hotkey press"));
     msg_rc(  "| ");
+    msg_rc("%s", _("| subscribe [X,...] . . . . .  report events as JSON"));
+    msg_rc("%s", _("|   (state, rate, time, volume, media or all)"));
+    msg_rc("%s", _("| unsubscribe [X,...] . . . . .  stop reporting events"));
+    msg_rc(  "| ");
     msg_rc("%s", _("| help . . . . . . . . . . . . . . . this help message"));
     msg_rc("%s", _("| logout . . . . . . .  exit (if in socket connection)"));
     msg_rc("%s", _("| quit . . . . . . . . . . . . . . . . . . .  quit vlc"));
@@ -289,6 +329,169 @@ static void Help( intf_thread_t *p_intf)
     msg_rc("%s", _("+----[ end of help ]"));
 }
 
+/********************************************************************
+ * Event subscriptions
+ ********************************************************************
+ * Subscribed events are written as JSON lines, at most once per event
+ * interval: a burst of changes only sends the latest value of each.
+ ********************************************************************/
+
+/** status_lock must be held */
+static void EventPost(intf_thread_t *intf, unsigned event)
+{
+    intf_sys_t *sys = intf->p_sys;
+
+    if (!(sys->events & event))
+        return;
+    if (sys->pending == 0)
+        vlc_timer_schedule(sys->event_timer, false, sys->event_interval,
+                           VLC_TIMER_FIRE_ONCE);
+    sys->pending |= event;
+}
+
+/* Formats a non-negative value with a fixed number of decimals,
+ * independently of the locale. */
+static int EventPrintFixed(char *buf, size_t size, float value,
+                           unsigned scale)
+{
+    long v = lroundf(value * scale);
+    int digits = scale == 1000 ? 3 : 4;
+
+    if (v < 0)
+        v = 0;
+    return snprintf(buf, size, "%ld.%0*ld", v / (long)scale, digits,
+                    v % (long)scale);
+}
+
+static void EventFlush(void *data)
+{
+    intf_thread_t *intf = data;
+    intf_sys_t *sys = intf->p_sys;
+    char buf[512], num[32];
+    size_t len = 0;
+
+    vlc_mutex_lock(&sys->status_lock);
+    unsigned events = sys->pending & sys->events;
+    sys->pending = 0;
+
+    if (events & RC_EVENT_STATE)
+    {
+        static const char *const states[] = {
+            [VLC_PLAYER_STATE_STOPPED] = "stopped",
+            [VLC_PLAYER_STATE_STARTED] = "started",
+            [VLC_PLAYER_STATE_PLAYING] = "playing",
+            [VLC_PLAYER_STATE_PAUSED] = "paused",
+            [VLC_PLAYER_STATE_STOPPING] = "stopping",
+        };
+        len += snprintf(buf + len, sizeof (buf) - len,
+                        "{\"event\":\"state\",\"state\":\"%s\"}\r\n",
+                        states[sys->ev_state]);
+    }
+    if (events & RC_EVENT_MEDIA)
+        len += snprintf(buf + len, sizeof (buf) - len,
+                        "{\"event\":\"media\"}\r\n");
+    if (events & RC_EVENT_RATE)
+    {
+        EventPrintFixed(num, sizeof (num), sys->ev_rate, 1000);
+        len += snprintf(buf + len, sizeof (buf) - len,
+                        "{\"event\":\"rate\",\"rate\":%s}\r\n", num);
+    }
+    if (events & RC_EVENT_TIME)
+    {
+        EventPrintFixed(num, sizeof (num), sys->ev_position, 10000);
+        len += snprintf(buf + len, sizeof (buf) - len,
+                        "{\"event\":\"time\",\"time\":%"PRId64
+                        ",\"position\":%s}\r\n",
+                        MS_FROM_VLC_TICK(sys->ev_time), num);
+    }
+    if (events & RC_EVENT_VOLUME)
+        len += snprintf(buf + len, sizeof (buf) - len,
+                        "{\"event\":\"volume\",\"volume\":%ld}\r\n",
+                        lroundf(sys->ev_volume * 100));
+
+    if (len > 0)
+        rc_write(intf, buf, len);
+    vlc_mutex_unlock(&sys->status_lock);
+}
+
+static unsigned EventParse(intf_thread_t *intf, const char *arg)
+{
+    unsigned mask = 0;
+    char list[strlen(arg) + 1], *saveptr;
+
+    strcpy(list, arg);
+    for (char *name = strtok_r(list, ", ", &saveptr); name != NULL;
+         name = strtok_r(NULL, ", ", &saveptr))
+    {
+        size_t i;
+
+        if (strcmp(name, "all") == 0)
+        {
+            mask |= (1 << ARRAY_SIZE(event_names)) - 1;
+            continue;
+        }
+        for (i = 0; i < ARRAY_SIZE(event_names); i++)
+            if (strcmp(name, event_names[i]) == 0)
+                break;
+        if (i < ARRAY_SIZE(event_names))
+            mask |= 1 << i;
+        else
+            msg_print(intf, _("Unknown event `%s'."), name);
+    }
+    return mask;
+}
+
+static void Subscribe(intf_thread_t *intf, char const *psz_cmd,
+                      vlc_value_t newval)
+{
+    intf_sys_t *sys = intf->p_sys;
+    const char *arg = newval.psz_string;
+    bool subscribe = strcmp(psz_cmd, "subscribe") == 0;
+    unsigned mask = EventParse(intf, *arg ? arg : "all");
+
+    if (subscribe)
+    {
+        vlc_player_t *player = vlc_playlist_GetPlayer(sys->playlist);
+        enum vlc_player_state state;
+        float rate, position, volume;
+        vlc_tick_t time;
+
+        /* The player lock is taken before the status lock */
+        vlc_player_Lock(player);
+        state = vlc_player_GetState(player);
+        rate = vlc_player_GetRate(player);
+        time = vlc_player_GetTime(player);
+        position = vlc_player_GetPosition(player);
+        volume = vlc_player_aout_GetVolume(player);
+
+        vlc_mutex_lock(&sys->status_lock);
+        sys->ev_state = state;
+        sys->ev_rate = rate;
+        sys->ev_time = time != VLC_TICK_INVALID ? time : 0;
+        sys->ev_position = position >= 0.f ? position : 0.f;
+        sys->ev_volume = volume;
+
+        /* Report the current values of new subscriptions once */
+        mask &= ~sys->events;
+        sys->events |= mask;
+        mask &= ~RC_EVENT_MEDIA;
+        if (sys->ev_volume < 0.f)
+            mask &= ~RC_EVENT_VOLUME;
+        for (unsigned i = 0; i < ARRAY_SIZE(event_names); i++)
+            if (mask & (1 << i))
+                EventPost(intf, 1 << i);
+        vlc_mutex_unlock(&sys->status_lock);
+        vlc_player_Unlock(player);
+    }
+    else
+    {
+        vlc_mutex_lock(&sys->status_lock);
+        sys->events &= ~mask;
+        sys->pending &= sys->events;
+        vlc_mutex_unlock(&sys->status_lock);
+    }
+}
+
 /********************************************************************
  * Status callback routines
  ********************************************************************/
@@ -314,7 +517,27 @@ player_on_state_changed(vlc_player_t *player,
         break;
     }
     intf_thread_t *p_intf = data;
-    msg_rc(STATUS_CHANGE "( %s state: %d )", psz_cmd, state);
+    intf_sys_t *sys = p_intf->p_sys;
+    vlc_mutex_lock(&sys->status_lock);
+    if (sys->events)
+    {
+        sys->ev_state = state;
+        EventPost(p_intf, RC_EVENT_STATE);
+    }
+    else
+        msg_rc(STATUS_CHANGE "( %s state: %d )", psz_cmd, state);
+    vlc_mutex_unlock(&sys->status_lock);
+}
+
+static void
+player_on_current_media_changed(vlc_player_t *player,
+                                input_item_t *new_media, void *data)
+{ VLC_UNUSED(player); VLC_UNUSED(new_media);
+    intf_thread_t *intf = data;
+    intf_sys_t *sys = intf->p_sys;
+    vlc_mutex_lock(&sys->status_lock);
+    EventPost(intf, RC_EVENT_MEDIA);
+    vlc_mutex_unlock(&sys->status_lock);
 }
 
 static void
@@ -334,18 +557,30 @@ player_on_rate_changed(vlc_player_t *player, float new_rate, void *data)
     intf_thread_t *p_intf = data;
     intf_sys_t *sys = p_intf->p_sys;
     vlc_mutex_lock(&sys->status_lock);
-    msg_rc(STATUS_CHANGE "( new rate: %.3f )", new_rate);
+    if (sys->events)
+    {
+        sys->ev_rate = new_rate;
+        EventPost(p_intf, RC_EVENT_RATE);
+    }
+    else
+        msg_rc(STATUS_CHANGE "( new rate: %.3f )", new_rate);
     vlc_mutex_unlock(&sys->status_lock);
 }
 
 static void
 player_on_position_changed(vlc_player_t *player,
                            vlc_tick_t new_time, float new_pos, void *data)
-{ VLC_UNUSED(player); VLC_UNUSED(new_pos);
+{ VLC_UNUSED(player);
     intf_thread_t *p_intf = data;
     intf_sys_t *sys = p_intf->p_sys;
     vlc_mutex_lock(&sys->status_lock);
-    if (sys->b_input_buffering)
+    if (sys->events)
+    {
+        sys->ev_time = new_time;
+        sys->ev_position = new_pos;
+        EventPost(p_intf, RC_EVENT_TIME);
+    }
+    else if (sys->b_input_buffering)
         msg_rc(STATUS_CHANGE "( time: %"PRId64"s )",
                SEC_FROM_VLC_TICK(new_time));
     sys->b_input_buffering = false;
@@ -356,10 +591,17 @@ static void
 player_aout_on_volume_changed(audio_output_t *aout, float volume, void *data)
 { VLC_UNUSED(aout);
     intf_thread_t *p_intf = data;
-    vlc_mutex_lock(&p_intf->p_sys->status_lock);
-    msg_rc(STATUS_CHANGE "( audio volume: %ld )",
-            lroundf(volume * 100));
-    vlc_mutex_unlock(&p_intf->p_sys->status_lock);
+    intf_sys_t *sys = p_intf->p_sys;
+    vlc_mutex_lock(&sys->status_lock);
+    if (sys->events)
+    {
+        sys->ev_volume = volume;
+        EventPost(p_intf, RC_EVENT_VOLUME);
+    }
+    else
+        msg_rc(STATUS_CHANGE "( audio volume: %ld )",
+                lroundf(volume * 100));
+    vlc_mutex_unlock(&sys->status_lock);
 }
 
 static void PlayerDoVoid(intf_thread_t *intf, void (*cb)(vlc_player_t *))
@@ -1208,6 +1450,13 @@ static void Statistics(intf_thread_t *intf)
                   item->p_stats->i_demux_corrupted);
         msg_print(intf, _("| discontinuities  :    %5"PRIi64),
                   item->p_stats->i_demux_discontinuity);
+        if (item->p_stats->clock_jitter != VLC_TICK_INVALID)
+        {
+            msg_print(intf, _("| clock drift      :  %7.1f ms"),
+                      MS_FROM_VLC_TICK((double) item->p_stats->clock_drift));
+            msg_print(intf, _("| clock jitter     :  %7.1f ms"),
+                      MS_FROM_VLC_TICK((double) item->p_stats->clock_jitter));
+        }
         msg_print(intf, "|");
 
         /* Video */
@@ -1228,6 +1477,10 @@ static void Statistics(intf_thread_t *intf)
                   item->p_stats->i_played_abuffers);
         msg_print(intf, _("| buffers lost     :    %5"PRIi64),
                   item->p_stats->i_lost_abuffers);
+        msg_print(intf, _("| buffers recycled :    %5"PRIi64),
+                  item->p_stats->i_pooled_abuffers);
+        msg_print(intf, _("| buffers allocated:    %5"PRIi64),
+                  item->p_stats->i_allocated_abuffers);
         msg_print(intf, "|");
 
         vlc_mutex_unlock(&item->lock);
@@ -1241,16 +1494,27 @@ static void Quit(intf_thread_t *intf)
     libvlc_Quit(vlc_object_instance(intf));
 }
 
+/* Closes the client connection, and drops its subscriptions */
+static void CloseConnection(intf_thread_t *intf)
+{
+    intf_sys_t *sys = intf->p_sys;
+
+    vlc_mutex_lock(&sys->status_lock);
+    net_Close(sys->i_socket);
+    sys->i_socket = -1;
+    sys->events = 0;
+    sys->pending = 0;
+    sys->i_input = 0;
+    vlc_mutex_unlock(&sys->status_lock);
+}
+
 static void LogOut(intf_thread_t *intf)
 {
     intf_sys_t *sys = intf->p_sys;
 
     /* Close connection */
     if (sys->i_socket != -1)
-    {
-        net_Close(sys->i_socket);
-        sys->i_socket = -1;
-    }
+        CloseConnection(intf);
 }
 
 static void IsPlaying(intf_thread_t *intf)
@@ -1307,6 +1571,8 @@ static const struct
 } string_cmds[] =
 {
     { "intf", Intf },
+    { "subscribe", Subscribe },
+    { "unsubscribe", Subscribe },
     { "add", Playlist },
     { "repeat", Playlist },
     { "loop", Playlist },
@@ -1500,43 +1766,67 @@ static bool ReadCommand(intf_thread_t *p_intf, char *p_buffer, int *pi_size)
     }
 #endif
 
-    while( *pi_size < MAX_LINE_LENGTH )
+    intf_sys_t *p_sys = p_intf->p_sys;
+
+    /* Read as much as available, so that a batch of commands sent at once
+     * costs one system call rather than one per byte. */
+    for( ;; )
     {
-        if( p_intf->p_sys->i_socket == -1 )
+        size_t i_len = 0;
+
+        while( i_len < p_sys->i_input && i_len < MAX_LINE_LENGTH
+            && p_sys->input[i_len] != '\r' && p_sys->input[i_len] != '\n' )
+            i_len++;
+
+        if( i_len < p_sys->i_input || i_len == MAX_LINE_LENGTH )
         {
-            if( read( 0/*STDIN_FILENO*/, p_buffer + *pi_size, 1 ) <= 0 )
+            size_t i_skip = i_len;
+
+            if( i_len < p_sys->i_input && (p_sys->input[i_len] == '\r'
+                                        || p_sys->input[i_len] == '\n') )
+                i_skip++;
+            memcpy( p_buffer, p_sys->input, i_len );
+            p_buffer[i_len] = 0;
+            *pi_size = i_len;
+            p_sys->i_input -= i_skip;
+            memmove( p_sys->input, p_sys->input + i_skip, p_sys->i_input );
+            return true;
+        }
+
+        char *p_end = p_sys->input + p_sys->i_input;
+        size_t i_room = sizeof( p_sys->input ) - p_sys->i_input;
+        ssize_t i_read;
+
+        if( p_sys->i_socket == -1 )
+        {
+            i_read = read( 0/*STDIN_FILENO*/, p_end, i_room );
+            if( i_read <= 0 && (i_read == 0 || errno != EINTR) )
             {   /* Standard input closed: exit */
                 libvlc_Quit( vlc_object_instance(p_intf) );
-                p_buffer[*pi_size] = 0;
+                memcpy( p_buffer, p_sys->input, p_sys->i_input );
+                p_buffer[p_sys->i_input] = 0;
+                *pi_size = p_sys->i_input;
+                p_sys->i_input = 0;
                 return true;
             }
         }
         else
-        {   /* Connection closed */
-            if( net_Read( p_intf, p_intf->p_sys->i_socket, p_buffer + *pi_size,
-                          1 ) <= 0 )
-            {
-                net_Close( p_intf->p_sys->i_socket );
-                p_intf->p_sys->i_socket = -1;
-                p_buffer[*pi_size] = 0;
+        {
+            i_read = vlc_recv_i11e( p_sys->i_socket, p_end, i_room, 0 );
+            if( i_read <= 0
+             && (i_read == 0 || (errno != EINTR && errno != EAGAIN)) )
+            {   /* Connection closed */
+                memcpy( p_buffer, p_sys->input, p_sys->i_input );
+                p_buffer[p_sys->i_input] = 0;
+                *pi_size = p_sys->i_input;
+                CloseConnection( p_intf );
                 return true;
             }
         }
 
-        if( p_buffer[ *pi_size ] == '\r' || p_buffer[ *pi_size ] == '\n' )
-            break;
-
-        (*pi_size)++;
-    }
-
-    if( *pi_size == MAX_LINE_LENGTH ||
-        p_buffer[ *pi_size ] == '\r' || p_buffer[ *pi_size ] == '\n' )
-    {
-        p_buffer[ *pi_size ] = 0;
-        return true;
+        if( i_read > 0 )
+            p_sys->i_input += i_read;
     }
-
-    return false;
 }
 
 /*****************************************************************************
@@ -1594,12 +1884,17 @@ static void *Run( void *data )
         canc = vlc_savecancel( );
 
         vlc_player_Lock(player);
+        /* Subscribers get events instead of status changes */
+        vlc_mutex_lock( &p_sys->status_lock );
+        bool b_status = p_sys->events == 0;
+        vlc_mutex_unlock( &p_sys->status_lock );
+
         /* Manage the input part */
         if( item == NULL )
         {
             item = vlc_player_GetCurrentMedia(player);
             /* New input has been registered */
-            if( item )
+            if( item && b_status )
             {
                 char *psz_uri = input_item_GetURI( item );
                 msg_rc( STATUS_CHANGE "( new input: %s )", psz_uri );
@@ -1613,14 +1908,15 @@ static void *Run( void *data )
                 item = NULL;
 
             p_sys->last_state = VLC_PLAYER_STATE_STOPPED;
-            msg_rc( STATUS_CHANGE "( stop state: 0 )" );
+            if( b_status )
+                msg_rc( STATUS_CHANGE "( stop state: 0 )" );
         }
 
         if( item != NULL )
         {
             enum vlc_player_state state = vlc_player_GetState(player);
 
-            if (p_sys->last_state != state)
+            if (p_sys->last_state != state && b_status)
             {
                 switch (state)
                 {
@@ -1835,6 +2131,18 @@ static int Activate( vlc_object_t *p_this )
     vlc_mutex_init( &p_sys->status_lock );
     p_sys->last_state = VLC_PLAYER_STATE_STOPPED;
     p_sys->b_input_buffering = false;
+    p_sys->events = 0;
+    p_sys->pending = 0;
+    p_sys->event_interval =
+        VLC_TICK_FROM_MS( var_InheritInteger( p_intf, "rc-event-interval" ) );
+    p_sys->i_input = 0;
+    if( vlc_timer_create( &p_sys->event_timer, EventFlush, p_intf ) )
+    {
+        net_ListenClose( pi_socket );
+        free( psz_unix_path );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
     p_sys->playlist = vlc_intf_GetMainPlaylist(p_intf);;
     vlc_player_t *player = vlc_playlist_GetPlayer(p_sys->playlist);
 
@@ -1856,6 +2164,7 @@ static int Activate( vlc_object_t *p_this )
 
     static struct vlc_player_cbs const player_cbs =
     {
+        .on_current_media_changed = player_on_current_media_changed,
         .on_state_changed = player_on_state_changed,
         .on_buffering_changed = player_on_buffering_changed,
         .on_rate_changed = player_on_rate_changed,
@@ -1889,6 +2198,7 @@ error:
         vlc_player_RemoveListener(player, p_sys->player_listener);
         vlc_player_Unlock(player);
     }
+    vlc_timer_destroy( p_sys->event_timer );
     net_ListenClose( pi_socket );
     free( psz_unix_path );
     free( p_sys );
@@ -1911,6 +2221,7 @@ static void Deactivate( vlc_object_t *p_this )
 
     vlc_cancel( p_sys->thread );
     vlc_join( p_sys->thread, NULL );
+    vlc_timer_destroy( p_sys->event_timer );
 
     net_ListenClose( p_sys->pi_socket_listen );
     if( p_sys->i_socket != -1 )
@@ -1932,6 +2243,11 @@ static void Deactivate( vlc_object_t *p_this )
 #define POS_LONGTEXT N_("Show the current position in seconds within the " \
                         "stream from time to time." )
 
+#define EVENT_INTERVAL_TEXT N_("Event interval (ms)")
+#define EVENT_INTERVAL_LONGTEXT N_("Subscribed events are reported at " \
+    "most once per interval. Only the latest value of an event that " \
+    "changes more often is reported.")
+
 #define TTY_TEXT N_("Fake TTY")
 #define TTY_LONGTEXT N_("Force the rc module to use stdin as if it was a TTY.")
 
@@ -1958,6 +2274,9 @@ vlc_module_begin()
     set_subcategory(SUBCAT_INTERFACE_MAIN)
     set_description(N_("Remote control interface"))
     add_bool("rc-show-pos", false, POS_TEXT, POS_LONGTEXT, true)
+    add_integer("rc-event-interval", 100, EVENT_INTERVAL_TEXT,
+                EVENT_INTERVAL_LONGTEXT, true)
+        change_integer_range(1, 60000)
 
 #ifdef _WIN32
     add_bool("rc-quiet", false, QUIET_TEXT, QUIET_LONGTEXT, false)
@@ -26,6 +26,7 @@
 #include "PlaylistManager.h"
 #include "SegmentTracker.hpp"
 #include "SharedResources.hpp"
+#include "plumbing/DemuxWorkers.hpp"
 #include "playlist/AbstractPlaylist.hpp"
 #include "playlist/BasePeriod.h"
 #include "playlist/BaseAdaptationSet.h"
@@ -41,6 +42,7 @@
 #include <vlc_stream.h>
 #include <vlc_demux.h>
 #include <vlc_threads.h>
+#include <vlc_input_item.h>
 
 #include <algorithm>
 #include <ctime>
@@ -67,6 +69,7 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     b_thread = false;
     b_buffering = false;
     b_canceled = false;
+    workers = NULL;
     nextPlaylistupdate = 0;
     demux.i_nzpcr = VLC_TICK_INVALID;
     demux.i_firstpcr = VLC_TICK_INVALID;
@@ -81,7 +84,12 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     cached.playlistStart = 0;
     cached.playlistEnd = 0;
     cached.playlistLength = 0;
+    cached.rapPlaylistStart = 0;
+    cached.rapDemuxStart = 0;
     cached.lastupdate = 0;
+    latency.lastcheck = VLC_TICK_INVALID;
+    latency.edge = 0;
+    latency.edgetime = VLC_TICK_INVALID;
 }
 
 PlaylistManager::~PlaylistManager   ()
@@ -164,6 +172,20 @@ bool PlaylistManager::start()
     if(b_thread)
         return false;
 
+    /* One demux worker per stream, if allowed */
+    size_t maxworkers = var_InheritInteger(p_demux, "adaptive-demuxers");
+    if(maxworkers > 1 && streams.size() > 1)
+    {
+        workers = new (std::nothrow) DemuxWorkers();
+        if(workers && !workers->start(std::min(maxworkers, streams.size())))
+        {
+            delete workers;
+            workers = NULL;
+        }
+        if(workers)
+            msg_Dbg(p_demux, "demuxing streams using %zu threads", workers->count());
+    }
+
     b_thread = !vlc_clone(&thread, managerThread,
                           static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
     if(!b_thread)
@@ -191,6 +213,8 @@ void PlaylistManager::stop()
         vlc_join(thread, NULL);
         b_thread = false;
     }
+    delete workers;
+    workers = NULL;
 }
 
 struct PrioritizedAbstractStream
@@ -231,6 +255,8 @@ AbstractStream::buffering_status PlaylistManager::bufferize(vlc_tick_t i_nzdeadl
     }
     std::sort(prioritized_streams.begin(), prioritized_streams.end(), streamCompare);
 
+    /* Streams to run, in priority order */
+    std::vector<AbstractStream *> runnable;
     for(it=prioritized_streams.begin(); it!=prioritized_streams.end(); ++it)
     {
         AbstractStream *st = (*it).st;
@@ -249,7 +275,22 @@ AbstractStream::buffering_status PlaylistManager::bufferize(vlc_tick_t i_nzdeadl
             /* initial */
         }
 
-        AbstractStream::buffering_status i_ret = st->bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
+        runnable.push_back(st);
+    }
+
+    std::vector<AbstractStream::buffering_status> results;
+    if(workers && runnable.size() > 1)
+        workers->bufferize(runnable, i_nzdeadline, i_min_buffering,
+                           i_extra_buffering, results);
+
+    for(size_t i=0; i<runnable.size(); i++)
+    {
+        AbstractStream::buffering_status i_ret;
+        if(results.empty())
+            i_ret = runnable[i]->bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
+        else
+            i_ret = results[i];
+
         if(i_return != AbstractStream::buffering_ongoing) /* Buffering streams need to keep going */
         {
             if(i_ret > i_return)
@@ -442,6 +483,7 @@ int PlaylistManager::doDemux(vlc_tick_t increment)
     AbstractStream::status status = dequeue(demux.i_nzpcr, &i_nzbarrier);
 
     updateControlsPosition();
+    updateLatencyControl();
 
     switch(status)
     {
@@ -671,6 +713,76 @@ void PlaylistManager::Run()
     vlc_mutex_unlock(&lock);
 }
 
+void PlaylistManager::updateLatencyControl()
+{
+    const vlc_tick_t target = bufferingLogic->getTargetLatency(playlist);
+    if(!target)
+        return;
+
+    const vlc_tick_t now = vlc_tick_now();
+    if(latency.lastcheck != VLC_TICK_INVALID &&
+       now - latency.lastcheck < VLC_TICK_FROM_SEC(1))
+        return;
+    latency.lastcheck = now;
+
+    /* fails while the core is buffering */
+    vlc_tick_t system, delay;
+    if(es_out_Control(p_demux->out, ES_OUT_GET_PCR_SYSTEM, &system, &delay) != VLC_SUCCESS)
+        return;
+
+    vlc_tick_t start, edge, demuxToPlaylist;
+    {
+        vlc_mutex_locker locker(&cached.lock);
+        if(!cached.b_live || cached.playlistStart == cached.playlistEnd)
+            return;
+        start = cached.playlistStart;
+        edge = cached.playlistEnd;
+        demuxToPlaylist = cached.rapPlaylistStart - cached.rapDemuxStart;
+    }
+
+    /* The edge only moves on playlist updates, extrapolate in between */
+    if(edge != latency.edge || latency.edgetime == VLC_TICK_INVALID)
+    {
+        latency.edge = edge;
+        latency.edgetime = now;
+    }
+    edge += now - latency.edgetime;
+
+    const vlc_tick_t playbackTime = getCurrentDemuxTime() - delay + demuxToPlaylist;
+    if(playbackTime < start || playbackTime > edge)
+        return; /* not on the playlist timeline */
+
+    const vlc_tick_t current = edge - playbackTime;
+    if(p_demux->p_input_item)
+    {
+        input_item_AddInfo(p_demux->p_input_item, _("Live"), _("Latency"),
+                           "%" PRId64 " ms", MS_FROM_VLC_TICK(current));
+        input_item_AddInfo(p_demux->p_input_item, _("Live"), _("Target latency"),
+                           "%" PRId64 " ms", MS_FROM_VLC_TICK(target));
+    }
+
+    const vlc_tick_t skip = bufferingLogic->getLatencyCorrection(playlist, current);
+    if(skip <= 0)
+        return;
+
+    msg_Dbg(p_demux, "live latency %" PRId64 "ms over target %" PRId64 "ms, "
+                     "skipping %" PRId64 "ms", MS_FROM_VLC_TICK(current),
+                     MS_FROM_VLC_TICK(target), MS_FROM_VLC_TICK(skip));
+
+    setBufferingRunState(false);
+    if(setPosition(getCurrentDemuxTime() + skip))
+    {
+        vlc_mutex_lock(&demux.lock);
+        demux.i_nzpcr = VLC_TICK_INVALID;
+        demux.i_firstpcr = VLC_TICK_INVALID;
+        es_out_Control(p_demux->out, ES_OUT_RESET_PCR);
+        vlc_mutex_unlock(&demux.lock);
+        vlc_mutex_locker locker(&cached.lock);
+        cached.lastupdate = 0;
+    }
+    setBufferingRunState(true);
+}
+
 void * PlaylistManager::managerThread(void *opaque)
 {
     static_cast<PlaylistManager *>(opaque)->Run();
@@ -700,6 +812,8 @@ void PlaylistManager::updateControlsPosition()
                 break;
         }
     }
+    cached.rapPlaylistStart = rapPlaylistStart;
+    cached.rapDemuxStart = rapDemuxStart;
 
     /*
      * Relative position:
@@ -833,7 +947,7 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
 
 AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
 {
-    DefaultBufferingLogic *bl = new DefaultBufferingLogic();
+    TargetLatencyBufferingLogic *bl = new TargetLatencyBufferingLogic();
     if(bl)
     {
         unsigned v = var_InheritInteger(p_demux, "adaptive-livedelay");
@@ -842,6 +956,10 @@ AbstractBufferingLogic *PlaylistManager::createBufferingLogic() const
         v = var_InheritInteger(p_demux, "adaptive-maxbuffer");
         if(v)
             bl->setUserMaxBuffering(VLC_TICK_FROM_MS(v));
+        v = var_InheritInteger(p_demux, "adaptive-targetlatency");
+        if(v)
+            bl->setUserTargetLatency(VLC_TICK_FROM_MS(v));
+        bl->setFastStart(var_InheritBool(p_demux, "adaptive-faststart"));
     }
     return bl;
 }
@@ -39,6 +39,8 @@ namespace adaptive
         class AbstractConnectionManager;
     }
 
+    class DemuxWorkers;
+
     using namespace playlist;
     using namespace logic;
 
@@ -86,6 +88,7 @@ namespace adaptive
             void unsetPeriod();
 
             void updateControlsPosition();
+            void updateLatencyControl();
 
             /* local factories */
             virtual AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType,
@@ -125,9 +128,19 @@ namespace adaptive
                 vlc_tick_t  playlistStart;
                 vlc_tick_t  playlistEnd;
                 vlc_tick_t  playlistLength;
+                vlc_tick_t  rapPlaylistStart;
+                vlc_tick_t  rapDemuxStart;
                 time_t      lastupdate;
             } cached;
 
+            /* Live latency control, demux thread only */
+            struct
+            {
+                vlc_tick_t  lastcheck;
+                vlc_tick_t  edge;
+                vlc_tick_t  edgetime;
+            } latency;
+
         private:
             void setBufferingRunState(bool);
             void Run();
@@ -138,6 +151,7 @@ namespace adaptive
             vlc_cond_t   waitcond;
             bool         b_buffering;
             bool         b_canceled;
+            DemuxWorkers *workers;
     };
 
 }
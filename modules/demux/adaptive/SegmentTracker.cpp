@@ -23,6 +23,7 @@
 #endif
 
 #include "SegmentTracker.hpp"
+#include "SharedResources.hpp"
 #include "playlist/AbstractPlaylist.hpp"
 #include "playlist/BaseRepresentation.h"
 #include "playlist/BaseAdaptationSet.h"
@@ -30,6 +31,7 @@
 #include "playlist/SegmentChunk.hpp"
 #include "logic/AbstractAdaptationLogic.h"
 #include "logic/BufferingLogic.hpp"
+#include "logic/Representationselectors.hpp"
 
 #include <cassert>
 #include <limits>
@@ -96,6 +98,10 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
+    prefetched.chunk = NULL;
+    prefetched.rep = NULL;
+    prefetched.number = 0;
+    skipFragments = 0;
 }
 
 SegmentTracker::~SegmentTracker()
@@ -103,6 +109,48 @@ SegmentTracker::~SegmentTracker()
     reset();
 }
 
+BaseRepresentation * SegmentTracker::getStartRepresentation() const
+{
+    /* Fast start plays the lowest one until a first download rate is
+     * known, provided we can switch on the next segment */
+    if(bufferingLogic->isFastStart() && adaptationSet->isSegmentAligned())
+    {
+        RepresentationSelector selector(0, 0);
+        BaseRepresentation *rep = selector.lowest(adaptationSet);
+        if(rep)
+            return rep;
+    }
+    return logic->getNextRepresentation(adaptationSet, NULL);
+}
+
+void SegmentTracker::prefetchFirstSegment(BaseRepresentation *rep,
+                                          AbstractConnectionManager *connManager)
+{
+    dropPrefetched();
+
+    /* Without index, media segments are known before the init one is read */
+    if(rep->getSegment(BaseRepresentation::INFOTYPE_INDEX))
+        return;
+
+    uint64_t number;
+    bool b_gap;
+    ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                            next, &number, &b_gap);
+    if(!segment)
+        return;
+
+    prefetched.chunk = segment->toChunk(resources, connManager, number, rep);
+    prefetched.rep = rep;
+    prefetched.number = number;
+}
+
+void SegmentTracker::dropPrefetched()
+{
+    delete prefetched.chunk;
+    prefetched.chunk = NULL;
+    prefetched.rep = NULL;
+}
+
 void SegmentTracker::setAdaptationLogic(AbstractAdaptationLogic *logic_)
 {
     logic = logic_;
@@ -113,12 +161,12 @@ StreamFormat SegmentTracker::getCurrentFormat() const
 {
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
     if(rep)
     {
         /* Ensure ephemere content is updated/loaded */
         if(rep->needsUpdate())
-            (void) rep->runLocalUpdates(resources);
+            (void) runLocalUpdates(rep);
         return rep->getStreamFormat();
     }
     return StreamFormat();
@@ -128,7 +176,7 @@ std::list<std::string> SegmentTracker::getCurrentCodecs() const
 {
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
     if(rep)
         return rep->getCodecs();
     return std::list<std::string>();
@@ -153,7 +201,7 @@ bool SegmentTracker::segmentsListReady() const
 {
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
     if(rep && rep->getPlaylist()->isLive())
     {
         assert(curNumber != std::numeric_limits<uint64_t>::max());
@@ -165,6 +213,8 @@ bool SegmentTracker::segmentsListReady() const
 void SegmentTracker::reset()
 {
     notify(SegmentTrackerEvent(curRepresentation, NULL));
+    dropPrefetched();
+    skipFragments = 0;
     curRepresentation = NULL;
     init_sent = false;
     index_sent = false;
@@ -193,6 +243,8 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     if( !switch_allowed ||
        (curRepresentation && !curRepresentation->getAdaptationSet()->isSegmentAligned()) )
         rep = curRepresentation;
+    else if(!curRepresentation)
+        rep = getStartRepresentation();
     else
         rep = logic->getNextRepresentation(adaptationSet, curRepresentation);
 
@@ -213,7 +265,7 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     bool b_updated = false;
     /* Ensure ephemere content is updated/loaded */
     if(rep->needsUpdate())
-        b_updated = rep->runLocalUpdates(resources);
+        b_updated = runLocalUpdates(rep);
 
     if(curNumber == std::numeric_limits<uint64_t>::max())
     {
@@ -262,7 +314,12 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         init_sent = true;
         segment = rep->getSegment(BaseRepresentation::INFOTYPE_INIT);
         if(segment)
-            return segment->toChunk(resources, connManager, next, rep);
+        {
+            SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+            if(chunk && bufferingLogic->isFastStart())
+                prefetchFirstSegment(rep, connManager);
+            return chunk;
+        }
     }
 
     if(!index_sent)
@@ -287,7 +344,23 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
         initializing = false;
     }
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+    SegmentChunk *chunk;
+    if(prefetched.chunk && prefetched.rep == rep && prefetched.number == next)
+    {
+        chunk = prefetched.chunk;
+        prefetched.chunk = NULL;
+    }
+    else
+    {
+        dropPrefetched();
+        chunk = segment->toChunk(resources, connManager, next, rep);
+    }
+
+    if(chunk)
+    {
+        chunk->skipFragments = skipFragments;
+        skipFragments = 0;
+    }
 
     /* Notify new segment length for stats / logic */
     if(chunk)
@@ -319,15 +392,54 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     return chunk;
 }
 
+bool SegmentTracker::switchWithinSegment(size_t size, vlc_tick_t time,
+                                         unsigned fragments)
+{
+    /* Too early for a meaningful rate */
+    if(!curRepresentation || initializing || time < VLC_TICK_FROM_MS(500) ||
+       !adaptationSet->isSegmentAligned())
+        return false;
+
+    const uint64_t bps = size * 8 * CLOCK_FREQ / time;
+    if(bps >= curRepresentation->getBandwidth())
+        return false;
+
+    RepresentationSelector selector(0, 0);
+    BaseRepresentation *rep = selector.select(adaptationSet, bps);
+    if(!rep || rep->getBandwidth() >= curRepresentation->getBandwidth() ||
+       rep->getStreamFormat() != curRepresentation->getStreamFormat())
+        return false;
+
+    if(rep->needsUpdate() && !runLocalUpdates(rep))
+        return false;
+
+    uint64_t number = curNumber;
+    if(!rep->consistentSegmentNumber())
+        number = rep->translateSegmentNumber(number, curRepresentation);
+
+    /* Let the logic know about the aborted download */
+    logic->updateDownloadRate(adaptationSet->getID(), size, time);
+
+    notify(SegmentTrackerEvent(curRepresentation, rep));
+    curRepresentation = rep;
+    dropPrefetched();
+    init_sent = false;
+    index_sent = false;
+    initializing = true;
+    next = number;
+    skipFragments = fragments;
+    return true;
+}
+
 bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool tryonly)
 {
     uint64_t segnumber;
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
 
     /* Stream might not have been loaded at all (HLS) or expired */
-    if(rep && rep->needsUpdate() && !rep->runLocalUpdates(resources))
+    if(rep && rep->needsUpdate() && !runLocalUpdates(rep))
     {
         msg_Err(rep->getAdaptationSet()->getPlaylist()->getVLCObject(),
                 "Failed to update Representation %s", rep->getID().str().c_str());
@@ -352,6 +464,8 @@ void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
         index_sent = false;
         init_sent = false;
     }
+    dropPrefetched();
+    skipFragments = 0;
     curNumber = next = segnumber;
 }
 
@@ -361,7 +475,7 @@ vlc_tick_t SegmentTracker::getPlaybackTime() const
 
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
 
     if(rep &&
        rep->getPlaybackTimeDurationBySegmentNumber(next, &time, &duration))
@@ -383,12 +497,12 @@ vlc_tick_t SegmentTracker::getMinAheadTime() const
 {
     BaseRepresentation *rep = curRepresentation;
     if(!rep)
-        rep = logic->getNextRepresentation(adaptationSet, NULL);
+        rep = getStartRepresentation();
     if(rep)
     {
         /* Ensure ephemere content is updated/loaded */
         if(rep->needsUpdate())
-            (void) rep->runLocalUpdates(resources);
+            (void) runLocalUpdates(rep);
 
         uint64_t startnumber = bufferingLogic->getStartSegmentNumber(rep);
         if(startnumber != std::numeric_limits<uint64_t>::max())
@@ -397,6 +511,14 @@ vlc_tick_t SegmentTracker::getMinAheadTime() const
     return 0;
 }
 
+bool SegmentTracker::runLocalUpdates(BaseRepresentation *rep) const
+{
+    /* streams can be updated from different demux workers, while
+     * the updates also set playlist wide properties */
+    vlc_mutex_locker locker(resources->getUpdateLock());
+    return rep->runLocalUpdates(resources);
+}
+
 void SegmentTracker::notifyBufferingState(bool enabled) const
 {
     notify(SegmentTrackerEvent(adaptationSet->getID(), enabled));
@@ -423,7 +545,7 @@ void SegmentTracker::updateSelected()
 {
     if(curRepresentation && curRepresentation->needsUpdate())
     {
-        curRepresentation->runLocalUpdates(resources);
+        runLocalUpdates(curRepresentation);
         curRepresentation->scheduleNextUpdate(curNumber);
     }
 }
@@ -130,6 +130,7 @@ namespace adaptive
             bool segmentsListReady() const;
             void reset();
             SegmentChunk* getNextChunk(bool, AbstractConnectionManager *);
+            bool switchWithinSegment(size_t, vlc_tick_t, unsigned);
             bool setPositionByTime(vlc_tick_t, bool, bool);
             void setPositionByNumber(uint64_t, bool);
             vlc_tick_t getPlaybackTime() const; /* Current segment start time if selected */
@@ -144,18 +145,30 @@ namespace adaptive
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            bool runLocalUpdates(BaseRepresentation *) const;
+            BaseRepresentation * getStartRepresentation() const;
+            void prefetchFirstSegment(BaseRepresentation *, AbstractConnectionManager *);
+            void dropPrefetched();
             bool first;
             bool initializing;
             bool index_sent;
             bool init_sent;
             uint64_t next;
             uint64_t curNumber;
+            unsigned skipFragments;
             StreamFormat format;
             SharedResources *resources;
             AbstractAdaptationLogic *logic;
             const AbstractBufferingLogic *bufferingLogic;
             BaseAdaptationSet *adaptationSet;
             BaseRepresentation *curRepresentation;
+            /* media chunk requested along with the init one */
+            struct
+            {
+                SegmentChunk *chunk;
+                BaseRepresentation *rep;
+                uint64_t number;
+            } prefetched;
             std::list<SegmentTrackerListenerInterface *> listeners;
     };
 }
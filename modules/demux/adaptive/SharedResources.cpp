@@ -24,6 +24,7 @@
 #include "SharedResources.hpp"
 #include "http/AuthStorage.hpp"
 #include "http/HTTPConnectionManager.h"
+#include "http/ChunkCache.hpp"
 #include "encryption/Keyring.hpp"
 
 #include <vlc_common.h>
@@ -38,11 +39,16 @@ SharedResources::SharedResources(vlc_object_t *obj, bool local)
     if(m && local)
         m->setLocalConnectionsAllowed();
     connManager = m;
+    int64_t cachesize = var_InheritInteger(obj, "adaptive-cache");
+    chunkCache = (cachesize > 0) ? ChunkCache::Hold(cachesize * 1024 * 1024) : NULL;
+    vlc_mutex_init(&updatelock);
 }
 
 SharedResources::~SharedResources()
 {
     delete connManager;
+    if(chunkCache)
+        ChunkCache::Release(chunkCache);
     delete encryptionKeyring;
     delete authStorage;
 }
@@ -61,3 +67,13 @@ AbstractConnectionManager * SharedResources::getConnManager()
 {
     return connManager;
 }
+
+ChunkCache * SharedResources::getChunkCache()
+{
+    return chunkCache;
+}
+
+vlc_mutex_t * SharedResources::getUpdateLock()
+{
+    return &updatelock;
+}
@@ -28,6 +28,7 @@ namespace adaptive
     {
         class AuthStorage;
         class AbstractConnectionManager;
+        class ChunkCache;
     }
 
     namespace encryption
@@ -46,11 +47,17 @@ namespace adaptive
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
             AbstractConnectionManager *getConnManager();
+            /* process wide, may be NULL */
+            ChunkCache  *getChunkCache();
+            /* serializes playlist updates from concurrent streams */
+            vlc_mutex_t *getUpdateLock();
 
         private:
             AuthStorage *authStorage;
             Keyring *encryptionKeyring;
             AbstractConnectionManager *connManager;
+            ChunkCache *chunkCache;
+            vlc_mutex_t updatelock;
     };
 }
 
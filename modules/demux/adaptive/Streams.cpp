@@ -45,6 +45,7 @@ AbstractStream::AbstractStream(demux_t * demux_)
     p_realdemux = demux_;
     format = StreamFormat::UNKNOWN;
     currentChunk = NULL;
+    fragmentswitch = false;
     eof = false;
     valid = true;
     disabled = false;
@@ -91,6 +92,7 @@ bool AbstractStream::init(const StreamFormat &format_, SegmentTracker *tracker,
                     segmentTracker->registerListener(this);
                     segmentTracker->notifyBufferingState(true);
                     connManager = conn;
+                    fragmentswitch = var_InheritBool(p_realdemux, "adaptive-fragmentswitch");
                     fakeesout->setExpectedTimestamp(segmentTracker->getPlaybackTime());
                     declaredCodecs();
                     return true;
@@ -525,6 +527,53 @@ block_t * AbstractStream::readNextBlock()
 
     demuxfirstchunk = false;
 
+    if(b_segment_head_chunk)
+        fragmentscanner.reset();
+
+    if(fragmentswitch && currentChunk->getStreamFormat() == StreamFormat(StreamFormat::MP4))
+    {
+        std::vector<mp4::FragmentScanner::Boundary> boundaries;
+        fragmentscanner.scan(block->p_buffer, block->i_buffer, &boundaries);
+        if(currentChunk->skipFragments)
+        {
+            /* Drop the fragments already read from the previous representation */
+            std::vector<mp4::FragmentScanner::Boundary>::const_iterator it;
+            for(it = boundaries.begin(); it != boundaries.end(); ++it)
+                if((*it).index == currentChunk->skipFragments)
+                    break;
+            if(it == boundaries.end())
+            {
+                block_Release(block);
+                return readNextBlock();
+            }
+            block->p_buffer += (*it).offset;
+            block->i_buffer -= (*it).offset;
+            currentChunk->skipFragments = 0;
+        }
+        else if(!boundaries.empty())
+        {
+            /* Download slower than playback, leave at the next fragment */
+            const mp4::FragmentScanner::Boundary &boundary = boundaries.front();
+            size_t size;
+            vlc_tick_t time;
+            if(currentChunk->getDownloadProgress(&size, &time) &&
+               segmentTracker->switchWithinSegment(size, time, boundary.index))
+            {
+                msg_Info(p_realdemux, "Switching representation after fragment %u",
+                         boundary.index);
+                delete currentChunk;
+                currentChunk = NULL;
+                block->i_buffer = boundary.offset;
+                if(block->i_buffer == 0)
+                {
+                    block_Release(block);
+                    return readNextBlock();
+                }
+                return checkBlock(block, b_segment_head_chunk);
+            }
+        }
+    }
+
     if (currentChunk->isEmpty())
     {
         delete currentChunk;
@@ -29,6 +29,7 @@
 #include "plumbing/Demuxer.hpp"
 #include "plumbing/SourceStream.hpp"
 #include "plumbing/FakeESOut.hpp"
+#include "mp4/FragmentScanner.hpp"
 
 #include <string>
 
@@ -124,6 +125,8 @@ namespace adaptive
         SegmentTracker *segmentTracker;
 
         SegmentChunk *currentChunk;
+        mp4::FragmentScanner fragmentscanner; /* of currentChunk */
+        bool fragmentswitch;
         bool eof;
         std::string language;
         std::string description;
@@ -77,14 +77,45 @@ static void Close   (vlc_object_t *);
 
 #define ADAPT_MAXBUFFER_TEXT N_("Max buffering (ms)")
 
+#define ADAPT_TARGETLATENCY_TEXT N_("Target live latency (ms)")
+#define ADAPT_TARGETLATENCY_LONGTEXT N_("Distance to the live edge to hold, " \
+    "skipping forward when playback drifts behind. 0 uses the latency " \
+    "advertised by the playlist, if any")
+
 #define ADAPT_LOGIC_TEXT N_("Adaptive Logic")
 
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_HTTP2_TEXT N_("Share HTTPS connections")
+#define ADAPT_HTTP2_LONGTEXT N_("Use the HTTP/2 capable transport, so that " \
+    "all the requests to a server share a single TLS session")
+
 #define ADAPT_LOWLATENCY_TEXT N_("Low latency")
 #define ADAPT_LOWLATENCY_LONGTEXT N_("Overrides low latency parameters")
 
+#define ADAPT_DOWNLOADERS_TEXT N_("Parallel downloads")
+#define ADAPT_DOWNLOADERS_LONGTEXT N_("Number of segments, from different " \
+    "streams, downloaded concurrently")
+
+#define ADAPT_FASTSTART_TEXT N_("Fast start")
+#define ADAPT_FASTSTART_LONGTEXT N_("Start from the lowest representation, " \
+    "fetching the first segment along with the initialization one, and " \
+    "live streams as close to the edge as the minimum buffering allows")
+
+#define ADAPT_FRAGMENTSWITCH_TEXT N_("Switch within segments")
+#define ADAPT_FRAGMENTSWITCH_LONGTEXT N_("Abort fragmented MP4 segments " \
+    "downloading slower than playback at the next fragment, and resume " \
+    "from the same fragment of a lower representation")
+
+#define ADAPT_CACHE_TEXT N_("Shared segment cache (MiB)")
+#define ADAPT_CACHE_LONGTEXT N_("Size of the cache of downloaded segments " \
+    "and keys shared by all the adaptive streams of the process, 0 disables it")
+
+#define ADAPT_DEMUXERS_TEXT N_("Parallel demuxing")
+#define ADAPT_DEMUXERS_LONGTEXT N_("Number of threads demuxing the " \
+    "streams, 1 demuxes all of them from the buffering thread")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
@@ -137,14 +168,31 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_bool   ( "adaptive-http2", false, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true );
         add_integer( "adaptive-livedelay",
                      MS_FROM_VLC_TICK(AbstractBufferingLogic::DEFAULT_LIVE_BUFFERING),
                      ADAPT_BUFFER_TEXT, ADAPT_BUFFER_LONGTEXT, true );
         add_integer( "adaptive-maxbuffer",
                      MS_FROM_VLC_TICK(AbstractBufferingLogic::DEFAULT_MAX_BUFFERING),
                      ADAPT_MAXBUFFER_TEXT, NULL, true );
+        add_integer( "adaptive-targetlatency", 0,
+                     ADAPT_TARGETLATENCY_TEXT, ADAPT_TARGETLATENCY_LONGTEXT, true )
+            change_integer_range( 0, 3600000 )
         add_integer( "adaptive-lowlatency", -1, ADAPT_LOWLATENCY_TEXT, ADAPT_LOWLATENCY_LONGTEXT, true );
             change_integer_list(rgi_latency, ppsz_latency)
+        add_integer( "adaptive-downloaders", 3, ADAPT_DOWNLOADERS_TEXT,
+                     ADAPT_DOWNLOADERS_LONGTEXT, true )
+            change_integer_range( 1, 8 )
+        add_integer( "adaptive-demuxers", 4, ADAPT_DEMUXERS_TEXT,
+                     ADAPT_DEMUXERS_LONGTEXT, true )
+            change_integer_range( 1, 16 )
+        add_bool   ( "adaptive-faststart", false, ADAPT_FASTSTART_TEXT,
+                     ADAPT_FASTSTART_LONGTEXT, true )
+        add_bool   ( "adaptive-fragmentswitch", false, ADAPT_FRAGMENTSWITCH_TEXT,
+                     ADAPT_FRAGMENTSWITCH_LONGTEXT, true )
+        add_integer( "adaptive-cache", 32, ADAPT_CACHE_TEXT,
+                     ADAPT_CACHE_LONGTEXT, true )
+            change_integer_range( 0, 1024 )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -24,6 +24,8 @@
 
 #include "Keyring.hpp"
 #include "../tools/Retrieve.hpp"
+#include "../SharedResources.hpp"
+#include "../http/ChunkCache.hpp"
 
 #include <vlc_block.h>
 
@@ -50,8 +52,15 @@ KeyringKey Keyring::getKey(SharedResources *resources, const std::string &uri)
     if(it == keys.end())
     {
         /* Pretty bad inside the lock */
-        msg_Dbg(obj, "Retrieving AES key %s", uri.c_str());
-        block_t *p_block = Retrieve::HTTP(resources, uri);
+        ChunkCache *cache = resources->getChunkCache();
+        block_t *p_block = cache ? cache->get(uri) : NULL;
+        if(!p_block)
+        {
+            msg_Dbg(obj, "Retrieving AES key %s", uri.c_str());
+            p_block = Retrieve::HTTP(resources, uri);
+            if(p_block && p_block->i_buffer == 16 && cache)
+                cache->store(uri, p_block);
+        }
         if(p_block)
         {
             if(p_block->i_buffer == 16)
@@ -29,6 +29,8 @@
 #include "HTTPConnection.hpp"
 #include "HTTPConnectionManager.h"
 #include "Downloader.hpp"
+#include "ChunkCache.hpp"
+#include "../encryption/CommonEncryption.hpp"
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -70,6 +72,16 @@ enum RequestStatus AbstractChunkSource::getRequestStatus() const
     return requeststatus;
 }
 
+bool AbstractChunkSource::getDownloadProgress(size_t *, vlc_tick_t *) const
+{
+    return false;
+}
+
+bool AbstractChunkSource::setDecryption(encryption::CommonEncryptionSession *)
+{
+    return false;
+}
+
 AbstractChunk::AbstractChunk(AbstractChunkSource *source_)
 {
     bytesRead = 0;
@@ -122,6 +134,11 @@ block_t * AbstractChunk::doRead(size_t size, bool b_block)
     return block;
 }
 
+bool AbstractChunk::getDownloadProgress(size_t *pi_size, vlc_tick_t *pi_time) const
+{
+    return source && source->getDownloadProgress(pi_size, pi_time);
+}
+
 bool AbstractChunk::isEmpty() const
 {
     return !source->hasMoreData();
@@ -296,13 +313,17 @@ HTTPChunkBufferedSource::HTTPChunkBufferedSource(const std::string& url, Abstrac
     HTTPChunkSource(url, manager, sourceid, access),
     p_head     (NULL),
     pp_tail    (&p_head),
-    buffered     (0)
+    buffered     (0),
+    downloaded   (0)
 {
     vlc_cond_init(&avail);
     done = false;
     eof = false;
     held = false;
     downloadstart = 0;
+    cacheentry = NULL;
+    decryption = NULL;
+    p_held = NULL;
 }
 
 HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
@@ -315,6 +336,13 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
     if(held) /* wait release if not in queue but currently downloaded */
         vlc_cond_wait(&avail, &lock);
 
+    if(cacheentry)
+    {
+        cacheentry->finish(false);
+        cacheentry->release();
+        cacheentry = NULL;
+    }
+
     if(p_head)
     {
         block_ChainRelease(p_head);
@@ -322,6 +350,13 @@ HTTPChunkBufferedSource::~HTTPChunkBufferedSource()
         pp_tail = &p_head;
     }
     buffered = 0;
+    if(p_held)
+    {
+        block_Release(p_held);
+        p_held = NULL;
+    }
+    delete decryption;
+    decryption = NULL;
     vlc_mutex_unlock(&lock);
 }
 
@@ -344,13 +379,41 @@ void HTTPChunkBufferedSource::release()
     vlc_cond_signal(&avail);
 }
 
+void HTTPChunkBufferedSource::setCacheEntry(ChunkCacheEntry *entry)
+{
+    vlc_mutex_locker locker( &lock );
+    if(cacheentry)
+        cacheentry->release();
+    cacheentry = entry;
+}
+
+void HTTPChunkBufferedSource::finishCacheEntry()
+{
+    if(!cacheentry)
+        return;
+    /* only share complete and successful downloads */
+    const bool b_success = (requeststatus == RequestStatus::Success &&
+                            (!contentLength || downloaded == contentLength));
+    cacheentry->finish(b_success);
+    cacheentry->release();
+    cacheentry = NULL;
+}
+
 void HTTPChunkBufferedSource::bufferize(size_t readsize)
 {
     vlc_mutex_lock(&lock);
+    const bool b_wasprepared = prepared;
     if(!prepare())
     {
         done = true;
         eof = true;
+        if(cacheentry)
+        {
+            cacheentry->setPrepared(requeststatus, std::string());
+            cacheentry->finish(false);
+            cacheentry->release();
+            cacheentry = NULL;
+        }
         vlc_cond_signal(&avail);
         vlc_mutex_unlock(&lock);
         return;
@@ -359,9 +422,15 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     if(readsize < HTTPChunkSource::CHUNK_SIZE)
         readsize = HTTPChunkSource::CHUNK_SIZE;
 
+    if(decryption) /* whole cipher blocks, only the last one can be partial */
+        readsize &= ~((size_t)15);
+
     if(contentLength && readsize > contentLength - buffered)
         readsize = contentLength - buffered;
 
+    if(!b_wasprepared && cacheentry)
+        cacheentry->setPrepared(requeststatus, connection->getContentType());
+
     vlc_mutex_unlock(&lock);
 
     block_t *p_block = block_Alloc(readsize);
@@ -382,24 +451,41 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     {
         block_Release(p_block);
         p_block = NULL;
-        vlc_mutex_locker locker( &lock );
-        done = true;
-        rate.size = buffered + consumed;
-        rate.time = vlc_tick_now() - downloadstart;
-        downloadstart = 0;
     }
     else
     {
         p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
-        buffered += p_block->i_buffer;
-        block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        downloaded += p_block->i_buffer;
+        if(cacheentry) /* shares the data as received */
+        {
+            block_t *p_dup = block_Duplicate(p_block);
+            if(p_dup)
+                cacheentry->append(p_dup);
+            else
+                cacheentry->finish(false);
+        }
+    }
+
+    const bool b_done = (ret <= 0 || (size_t) ret < readsize);
+
+    /* decrypt here, in the download thread, and not when reading */
+    if(decryption)
+        p_block = decrypt(p_block, b_done);
+
+    {
+        vlc_mutex_locker locker( &lock );
+        for(block_t *p = p_block; p; p = p->p_next)
+            buffered += p->i_buffer;
+        if(p_block)
+            block_ChainLastAppend(&pp_tail, p_block);
+        if(b_done)
         {
             done = true;
-            rate.size = buffered + consumed;
+            rate.size = downloaded;
             rate.time = vlc_tick_now() - downloadstart;
             downloadstart = 0;
+            finishCacheEntry();
         }
     }
 
@@ -421,6 +507,58 @@ bool HTTPChunkBufferedSource::prepare()
     return true;
 }
 
+bool HTTPChunkBufferedSource::getDownloadProgress(size_t *pi_size, vlc_tick_t *pi_time) const
+{
+    vlc_mutex_locker locker( &lock );
+    if(done || !downloadstart)
+        return false;
+    *pi_size = downloaded;
+    *pi_time = vlc_tick_now() - downloadstart;
+    return true;
+}
+
+bool HTTPChunkBufferedSource::setDecryption(encryption::CommonEncryptionSession *session)
+{
+    vlc_mutex_locker locker( &lock );
+    if(prepared || decryption) /* must be set before the download starts */
+        return false;
+    decryption = session;
+    return true;
+}
+
+block_t * HTTPChunkBufferedSource::decrypt(block_t *p_block, bool b_last)
+{
+    /* Padding can only be removed from the last block, which we might
+     * only know from the next read, so we always keep one in advance */
+    block_t *p_ready = p_held;
+    p_held = NULL;
+
+    if(p_ready)
+        p_ready->i_buffer = decryption->decrypt(p_ready->p_buffer, p_ready->i_buffer,
+                                                b_last && !p_block);
+    if(p_block)
+    {
+        if(b_last)
+        {
+            p_block->i_buffer = decryption->decrypt(p_block->p_buffer,
+                                                    p_block->i_buffer, true);
+        }
+        else
+        {
+            p_held = p_block;
+            p_block = NULL;
+        }
+    }
+
+    if(b_last)
+        decryption->close();
+
+    if(!p_ready)
+        return p_block;
+    p_ready->p_next = p_block;
+    return p_ready;
+}
+
 bool HTTPChunkBufferedSource::hasMoreData() const
 {
     vlc_mutex_locker locker( &lock );
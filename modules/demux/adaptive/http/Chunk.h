@@ -36,11 +36,17 @@ typedef struct block_t block_t;
 
 namespace adaptive
 {
+    namespace encryption
+    {
+        class CommonEncryptionSession;
+    }
+
     namespace http
     {
         class AbstractConnection;
         class AbstractConnectionManager;
         class AbstractChunk;
+        class ChunkCacheEntry;
 
         class AbstractChunkSource
         {
@@ -54,6 +60,10 @@ namespace adaptive
                 const BytesRange &  getBytesRange   () const;
                 virtual std::string getContentType  () const;
                 enum RequestStatus  getRequestStatus() const;
+                /* bytes received and time spent, while downloading */
+                virtual bool        getDownloadProgress(size_t *, vlc_tick_t *) const;
+                /* takes ownership and returns cleartext, when supported */
+                virtual bool        setDecryption(encryption::CommonEncryptionSession *);
 
             protected:
                 enum RequestStatus  requeststatus;
@@ -71,6 +81,7 @@ namespace adaptive
                 size_t              getBytesRead            () const;
                 uint64_t            getStartByteInFile      () const;
                 bool                isEmpty                 () const;
+                bool                getDownloadProgress     (size_t *, vlc_tick_t *) const;
 
                 virtual block_t *   readBlock       ();
                 virtual block_t *   read            (size_t);
@@ -126,8 +137,11 @@ namespace adaptive
                 virtual block_t *  readBlock       (); /* reimpl */
                 virtual block_t *  read            (size_t); /* reimpl */
                 virtual bool       hasMoreData     () const; /* impl */
+                virtual bool       getDownloadProgress(size_t *, vlc_tick_t *) const; /* reimpl */
+                virtual bool       setDecryption(encryption::CommonEncryptionSession *); /* reimpl */
                 void               hold();
                 void               release();
+                void               setCacheEntry(ChunkCacheEntry *);
 
             protected:
                 virtual bool       prepare(); /* reimpl */
@@ -135,9 +149,15 @@ namespace adaptive
                 bool               isDone() const;
 
             private:
+                void               finishCacheEntry();
+                block_t *          decrypt(block_t *, bool);
+                ChunkCacheEntry    *cacheentry; /* copy of the download, if shared */
+                encryption::CommonEncryptionSession *decryption;
+                block_t            *p_held; /* not yet decrypted, might be the last */
                 block_t            *p_head; /* read cache buffer */
                 block_t           **pp_tail;
                 size_t              buffered; /* read cache size */
+                size_t              downloaded; /* received bytes */
                 bool                done;
                 bool                eof;
                 vlc_tick_t          downloadstart;
@@ -0,0 +1,434 @@
+/*
+ * ChunkCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "ChunkCache.hpp"
+
+#include <vlc_block.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace adaptive::http;
+
+ChunkCacheEntry::ChunkCacheEntry(ChunkCache *cache_, const std::string &key_)
+{
+    cache = cache_;
+    key = key_;
+    size = 0;
+    state = PENDING;
+    prepared = false;
+    status = RequestStatus::Success;
+    refs = 1;
+    vlc_mutex_init(&lock);
+    vlc_cond_init(&avail);
+}
+
+ChunkCacheEntry::~ChunkCacheEntry()
+{
+    std::vector<block_t *>::const_iterator it;
+    for(it = blocks.begin(); it != blocks.end(); ++it)
+        block_Release(*it);
+}
+
+void ChunkCacheEntry::hold()
+{
+    refs++;
+}
+
+void ChunkCacheEntry::release()
+{
+    if(--refs == 0)
+        delete this;
+}
+
+void ChunkCacheEntry::setPrepared(enum RequestStatus status_, const std::string &type)
+{
+    vlc_mutex_locker locker(&lock);
+    status = status_;
+    contentType = type;
+    prepared = true;
+    vlc_cond_broadcast(&avail);
+}
+
+void ChunkCacheEntry::append(block_t *p_block)
+{
+    vlc_mutex_locker locker(&lock);
+    if(state != PENDING)
+    {
+        block_Release(p_block);
+        return;
+    }
+    p_block->p_next = NULL;
+    size += p_block->i_buffer;
+    blocks.push_back(p_block);
+    vlc_cond_broadcast(&avail);
+}
+
+void ChunkCacheEntry::finish(bool b_success)
+{
+    vlc_mutex_lock(&lock);
+    if(state != PENDING)
+    {
+        vlc_mutex_unlock(&lock);
+        return;
+    }
+    state = b_success ? COMPLETE : FAILED;
+    prepared = true;
+    vlc_cond_broadcast(&avail);
+    vlc_mutex_unlock(&lock);
+
+    cache->finished(this, b_success);
+}
+
+block_t * ChunkCacheEntry::read(size_t *pi_index, size_t *pi_offset, size_t max)
+{
+    vlc_mutex_locker locker(&lock);
+
+    while(*pi_index >= blocks.size() && state == PENDING)
+        vlc_cond_wait(&avail, &lock);
+
+    if(*pi_index >= blocks.size())
+        return NULL;
+
+    const block_t *src = blocks[*pi_index];
+    const size_t toread = std::min(max, src->i_buffer - *pi_offset);
+    block_t *p_block = block_Alloc(toread);
+    if(!p_block)
+        return NULL;
+    memcpy(p_block->p_buffer, &src->p_buffer[*pi_offset], toread);
+    *pi_offset += toread;
+    if(*pi_offset == src->i_buffer)
+    {
+        (*pi_index)++;
+        *pi_offset = 0;
+    }
+    return p_block;
+}
+
+bool ChunkCacheEntry::hasMoreData(size_t index) const
+{
+    vlc_mutex_locker locker(&lock);
+    return index < blocks.size() || state == PENDING;
+}
+
+enum RequestStatus ChunkCacheEntry::getRequestStatus() const
+{
+    vlc_mutex_locker locker(&lock);
+    return status;
+}
+
+std::string ChunkCacheEntry::getContentType() const
+{
+    vlc_mutex_locker locker(&lock);
+    while(!prepared)
+        vlc_cond_wait(&avail, &lock);
+    return contentType;
+}
+
+size_t ChunkCacheEntry::getSize() const
+{
+    vlc_mutex_locker locker(&lock);
+    return size;
+}
+
+bool ChunkCacheEntry::isComplete() const
+{
+    vlc_mutex_locker locker(&lock);
+    return state == COMPLETE;
+}
+
+CachedChunkSource::CachedChunkSource(ChunkCacheEntry *entry_)
+    : AbstractChunkSource()
+{
+    entry = entry_;
+    index = 0;
+    offset = 0;
+    eof = false;
+}
+
+CachedChunkSource::~CachedChunkSource()
+{
+    entry->release();
+}
+
+block_t * CachedChunkSource::readBlock()
+{
+    if(eof)
+        return NULL;
+    block_t *p_block = entry->read(&index, &offset, HTTPChunkSource::CHUNK_SIZE);
+    if(!p_block)
+        eof = true;
+    requeststatus = entry->getRequestStatus();
+    return p_block;
+}
+
+block_t * CachedChunkSource::read(size_t readsize)
+{
+    if(eof || !readsize)
+        return NULL;
+
+    block_t *p_block = block_Alloc(readsize);
+    if(!p_block)
+    {
+        eof = true;
+        return NULL;
+    }
+
+    size_t copied = 0;
+    while(copied < readsize)
+    {
+        block_t *p_part = entry->read(&index, &offset, readsize - copied);
+        if(!p_part)
+        {
+            eof = true;
+            break;
+        }
+        memcpy(&p_block->p_buffer[copied], p_part->p_buffer, p_part->i_buffer);
+        copied += p_part->i_buffer;
+        block_Release(p_part);
+    }
+    requeststatus = entry->getRequestStatus();
+
+    if(copied == 0)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    p_block->i_buffer = copied;
+    return p_block;
+}
+
+bool CachedChunkSource::hasMoreData() const
+{
+    /* must turn false with the last block, as for the HTTP sources */
+    return !eof && entry->hasMoreData(index);
+}
+
+std::string CachedChunkSource::getContentType() const
+{
+    return entry->getContentType();
+}
+
+vlc::threads::mutex ChunkCache::instancelock;
+ChunkCache * ChunkCache::instance = NULL;
+
+ChunkCache::ChunkCache(size_t maxsize_)
+{
+    size = 0;
+    maxsize = maxsize_;
+    users = 0;
+    vlc_mutex_init(&lock);
+}
+
+ChunkCache::~ChunkCache()
+{
+    std::map<std::string, ChunkCacheEntry *>::const_iterator it;
+    for(it = entries.begin(); it != entries.end(); ++it)
+        (*it).second->release();
+}
+
+ChunkCache * ChunkCache::Hold(size_t maxsize)
+{
+    vlc::threads::mutex_locker locker(instancelock);
+    if(!instance)
+    {
+        instance = new (std::nothrow) ChunkCache(maxsize);
+        if(!instance)
+            return NULL;
+    }
+    else
+    {
+        vlc_mutex_locker cachelocker(&instance->lock);
+        instance->maxsize = std::max(instance->maxsize, maxsize);
+    }
+    instance->users++;
+    return instance;
+}
+
+void ChunkCache::Release(ChunkCache *cache)
+{
+    vlc::threads::mutex_locker locker(instancelock);
+    if(cache == instance && --instance->users == 0)
+    {
+        delete instance;
+        instance = NULL;
+    }
+}
+
+std::string ChunkCache::makeKey(const std::string &url, const BytesRange &range)
+{
+    if(!range.isValid())
+        return url;
+    std::stringstream ss;
+    ss << url << '@' << range.getStartByte() << '-' << range.getEndByte();
+    return ss.str();
+}
+
+AbstractChunkSource * ChunkCache::getSource(const std::string &url, const BytesRange &range)
+{
+    vlc_mutex_locker locker(&lock);
+    std::map<std::string, ChunkCacheEntry *>::iterator it = entries.find(makeKey(url, range));
+    if(it == entries.end())
+        return NULL;
+
+    ChunkCacheEntry *entry = (*it).second;
+    vlc_mutex_lock(&entry->lock);
+    const bool b_failed = (entry->state == ChunkCacheEntry::FAILED);
+    vlc_mutex_unlock(&entry->lock);
+    if(b_failed)
+        return NULL;
+
+    CachedChunkSource *source = new (std::nothrow) CachedChunkSource(entry);
+    if(!source)
+        return NULL;
+    entry->hold();
+    source->setBytesRange(range);
+
+    std::list<ChunkCacheEntry *>::iterator lit = std::find(lru.begin(), lru.end(), entry);
+    if(lit != lru.end() && lit != lru.begin())
+        lru.splice(lru.begin(), lru, lit);
+
+    return source;
+}
+
+void ChunkCache::provide(HTTPChunkBufferedSource *source, const std::string &url,
+                         const BytesRange &range)
+{
+    const std::string key = makeKey(url, range);
+    ChunkCacheEntry *entry;
+    {
+        vlc_mutex_locker locker(&lock);
+        if(entries.find(key) != entries.end())
+            return;
+        entry = new (std::nothrow) ChunkCacheEntry(this, key);
+        if(!entry)
+            return;
+        entries.insert(std::pair<std::string, ChunkCacheEntry *>(key, entry));
+        entry->hold();
+    }
+    /* not started yet, and not nested under our lock */
+    source->setCacheEntry(entry);
+}
+
+block_t * ChunkCache::get(const std::string &url)
+{
+    AbstractChunkSource *source = NULL;
+    {
+        vlc_mutex_locker locker(&lock);
+        std::map<std::string, ChunkCacheEntry *>::const_iterator it = entries.find(url);
+        if(it != entries.end() && (*it).second->isComplete())
+        {
+            (*it).second->hold();
+            source = new (std::nothrow) CachedChunkSource((*it).second);
+            if(!source)
+                (*it).second->release();
+        }
+    }
+    if(!source)
+        return NULL;
+
+    block_t *p_chain = NULL;
+    block_t **pp_tail = &p_chain;
+    block_t *p_block;
+    while((p_block = source->readBlock()))
+        block_ChainLastAppend(&pp_tail, p_block);
+    delete source;
+
+    return p_chain ? block_ChainGather(p_chain) : NULL;
+}
+
+void ChunkCache::store(const std::string &url, const block_t *p_block)
+{
+    block_t *p_dup = block_Duplicate(p_block);
+    if(!p_dup)
+        return;
+
+    ChunkCacheEntry *entry;
+    {
+        vlc_mutex_locker locker(&lock);
+        if(entries.find(url) != entries.end())
+        {
+            block_Release(p_dup);
+            return;
+        }
+        entry = new (std::nothrow) ChunkCacheEntry(this, url);
+        if(!entry)
+        {
+            block_Release(p_dup);
+            return;
+        }
+        entries.insert(std::pair<std::string, ChunkCacheEntry *>(url, entry));
+        entry->hold();
+    }
+    entry->setPrepared(RequestStatus::Success, std::string());
+    entry->append(p_dup);
+    entry->finish(true);
+    entry->release();
+}
+
+void ChunkCache::finished(ChunkCacheEntry *entry, bool b_success)
+{
+    const size_t entrysize = entry->getSize();
+
+    vlc_mutex_locker locker(&lock);
+    std::map<std::string, ChunkCacheEntry *>::iterator it = entries.find(entry->key);
+    if(it == entries.end() || (*it).second != entry)
+        return;
+
+    if(!b_success || entrysize > maxsize)
+    {
+        remove(it);
+        return;
+    }
+
+    size += entrysize;
+    lru.push_front(entry);
+    evict();
+}
+
+void ChunkCache::evict()
+{
+    while(size > maxsize && !lru.empty())
+    {
+        std::map<std::string, ChunkCacheEntry *>::iterator it = entries.find(lru.back()->key);
+        if(it == entries.end())
+        {
+            lru.pop_back();
+            continue;
+        }
+        remove(it);
+    }
+}
+
+void ChunkCache::remove(std::map<std::string, ChunkCacheEntry *>::iterator it)
+{
+    ChunkCacheEntry *entry = (*it).second;
+    entries.erase(it);
+    std::list<ChunkCacheEntry *>::iterator lit = std::find(lru.begin(), lru.end(), entry);
+    if(lit != lru.end())
+    {
+        lru.erase(lit);
+        size -= entry->getSize();
+    }
+    entry->release();
+}
@@ -0,0 +1,141 @@
+/*
+ * ChunkCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef CHUNKCACHE_HPP
+#define CHUNKCACHE_HPP
+
+#include "Chunk.h"
+
+#include <vlc_common.h>
+#include <vlc_cxx_helpers.hpp>
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace adaptive
+{
+    namespace http
+    {
+        class ChunkCache;
+
+        /* Data of one URL and byte range, filled by the source downloading
+         * it and read by any number of CachedChunkSource */
+        class ChunkCacheEntry
+        {
+            friend class ChunkCache;
+
+            public:
+                void hold();
+                void release();
+
+                /* downloader side */
+                void setPrepared(enum RequestStatus, const std::string &);
+                void append(block_t *);
+                void finish(bool);
+
+                /* readers side, blocking until available */
+                block_t * read(size_t *, size_t *, size_t);
+                bool hasMoreData(size_t) const;
+                enum RequestStatus getRequestStatus() const;
+                std::string getContentType() const;
+                size_t getSize() const;
+                bool isComplete() const;
+
+            private:
+                ChunkCacheEntry(ChunkCache *, const std::string &);
+                ~ChunkCacheEntry();
+                enum State
+                {
+                    PENDING,
+                    COMPLETE,
+                    FAILED,
+                };
+                ChunkCache *cache;
+                std::string key;
+                std::vector<block_t *> blocks;
+                size_t size;
+                enum State state;
+                bool prepared;
+                enum RequestStatus status;
+                std::string contentType;
+                std::atomic<unsigned> refs;
+                mutable vlc_mutex_t lock;
+                mutable vlc_cond_t avail;
+        };
+
+        class CachedChunkSource : public AbstractChunkSource
+        {
+            public:
+                CachedChunkSource(ChunkCacheEntry *);
+                virtual ~CachedChunkSource();
+
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual std::string getContentType  () const; /* reimpl */
+
+            private:
+                ChunkCacheEntry *entry;
+                size_t index;
+                size_t offset;
+                bool   eof;
+        };
+
+        /* Process wide cache of downloaded chunks, shared by all the
+         * adaptive demuxers and bounded in size. Requests for a chunk
+         * already being downloaded wait for that download instead. */
+        class ChunkCache
+        {
+            friend class ChunkCacheEntry;
+
+            public:
+                static ChunkCache * Hold(size_t);
+                static void Release(ChunkCache *);
+
+                AbstractChunkSource * getSource(const std::string &, const BytesRange &);
+                void provide(HTTPChunkBufferedSource *, const std::string &,
+                             const BytesRange &);
+                /* for small, complete resources */
+                block_t * get(const std::string &);
+                void store(const std::string &, const block_t *);
+
+            private:
+                ChunkCache(size_t);
+                ~ChunkCache();
+                static std::string makeKey(const std::string &, const BytesRange &);
+                void finished(ChunkCacheEntry *, bool);
+                void evict();
+                void remove(std::map<std::string, ChunkCacheEntry *>::iterator);
+                std::map<std::string, ChunkCacheEntry *> entries;
+                std::list<ChunkCacheEntry *> lru; /* complete ones, recent first */
+                size_t size;
+                size_t maxsize;
+                unsigned users;
+                vlc_mutex_t lock;
+
+                static vlc::threads::mutex instancelock;
+                static ChunkCache *instance;
+        };
+    }
+}
+
+#endif // CHUNKCACHE_HPP
@@ -24,6 +24,7 @@
 
 #include <vlc_common.h>
 #include <list>
+#include <vector>
 
 namespace adaptive
 {
@@ -36,7 +37,7 @@ namespace adaptive
             public:
                 Downloader();
                 ~Downloader();
-                bool start();
+                bool start(unsigned = 1);
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
 
@@ -44,12 +45,16 @@ namespace adaptive
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                HTTPChunkBufferedSource * nextSource() const;
+                bool isDownloading(const HTTPChunkBufferedSource *) const;
+                std::vector<vlc_thread_t> threads;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   updatedcond;
                 bool         killed;
                 std::list<HTTPChunkBufferedSource *> chunks;
+                /* sources being downloaded, one per worker thread */
+                std::list<HTTPChunkBufferedSource *> current;
         };
 
     }
@@ -31,6 +31,14 @@
 #include <sstream>
 #include <algorithm>
 #include <vlc_stream.h>
+#include <vlc_block.h>
+
+extern "C"
+{
+#include "../../../access/http/connmgr.h"
+#include "../../../access/http/message.h"
+#include "../../../access/http/resource.h"
+}
 
 using namespace adaptive::http;
 
@@ -585,6 +593,160 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
+LibVLCHTTPConnection::LibVLCHTTPConnection(vlc_object_t *p_object_,
+                                           LibVLCHTTPConnectionFactory *factory_)
+    : AbstractConnection(p_object_)
+{
+    factory = factory_;
+    resource = NULL;
+    p_block = NULL;
+    char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
+    useragent = psz_useragent ? std::string(psz_useragent) : std::string("");
+    free(psz_useragent);
+    char *psz_referer = var_InheritString(p_object_, "http-referrer");
+    referer = psz_referer ? std::string(psz_referer) : std::string("");
+    free(psz_referer);
+}
+
+LibVLCHTTPConnection::~LibVLCHTTPConnection()
+{
+    reset();
+}
+
+void LibVLCHTTPConnection::reset()
+{
+    if(p_block)
+        block_Release(p_block);
+    p_block = NULL;
+    if(resource)
+        factory->close(resource);
+    resource = NULL;
+    bytesRead = 0;
+    contentLength = 0;
+    contentType = std::string();
+    bytesRange = BytesRange();
+}
+
+bool LibVLCHTTPConnection::canReuse(const ConnectionParams &params_) const
+{
+    /* The underlying session is shared anyway, only keep the origin */
+    return available && !params_.usesAccess() &&
+           params_.getScheme() == params.getScheme() &&
+           params_.getHostname() == params.getHostname() &&
+           params_.getPort() == params.getPort();
+}
+
+enum RequestStatus
+    LibVLCHTTPConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    params.setPath(path);
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    std::string url = params.getUrl();
+    int status = -1;
+
+    for(unsigned i = 0; i <= HTTPConnection::MAX_REDIRECTS; i++)
+    {
+        resource = factory->open(p_object, url, useragent, referer, range, &status);
+        if(!resource)
+            return RequestStatus::GenericError;
+
+        char *psz_redirect = vlc_http_res_get_redirect(resource);
+        if(!psz_redirect)
+            break;
+
+        factory->close(resource);
+        resource = NULL;
+        url = std::string(psz_redirect);
+        free(psz_redirect);
+
+        if(ConnectionParams(url).isLocal() && !params.isLocal())
+            return RequestStatus::GenericError;
+    }
+
+    if(!resource)
+        return RequestStatus::GenericError;
+
+    if(status >= 400)
+    {
+        reset();
+        if(status == 401 || status == 403)
+            return RequestStatus::Unauthorized;
+        if(status == 404)
+            return RequestStatus::NotFound;
+        return RequestStatus::GenericError;
+    }
+
+    char *psz_type = vlc_http_res_get_type(resource);
+    if(psz_type)
+    {
+        contentType = std::string(psz_type);
+        free(psz_type);
+    }
+
+    uintmax_t i_size = vlc_http_msg_get_size(resource->response);
+    if(i_size != UINTMAX_MAX)
+        contentLength = i_size;
+
+    if(range.isValid())
+    {
+        bytesRange = range;
+        if(range.getEndByte() > 0)
+            contentLength = range.getEndByte() - range.getStartByte() + 1;
+    }
+
+    return RequestStatus::Success;
+}
+
+ssize_t LibVLCHTTPConnection::read(void *p_buffer, size_t len)
+{
+    if( !resource )
+        return VLC_EGENERIC;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if(len > toRead)
+        len = toRead;
+
+    /* Callers consider a short read as the end of the chunk */
+    size_t copied = 0;
+    while(copied < len)
+    {
+        if(!p_block)
+        {
+            p_block = vlc_http_res_read(resource);
+            if(!p_block)
+                break;
+            continue;
+        }
+
+        size_t size = std::min(len - copied, p_block->i_buffer);
+        memcpy(static_cast<uint8_t *>(p_buffer) + copied, p_block->p_buffer, size);
+        copied += size;
+        p_block->p_buffer += size;
+        p_block->i_buffer -= size;
+        if(p_block->i_buffer == 0)
+        {
+            block_Release(p_block);
+            p_block = NULL;
+        }
+    }
+
+    bytesRead += copied;
+    return copied;
+}
+
+void LibVLCHTTPConnection::setUsed( bool b )
+{
+    available = !b;
+    if(available && contentLength == bytesRead)
+        reset();
+}
+
 NativeConnectionFactory::NativeConnectionFactory( AuthStorage *auth )
     : AbstractConnectionFactory()
 {
@@ -642,16 +804,154 @@ AbstractConnection * StreamUrlConnectionFactory::createConnection(vlc_object_t *
     return new (std::nothrow) StreamUrlConnection(p_object);
 }
 
+struct adaptive_http_resource
+{
+    struct vlc_http_resource resource;
+    uintmax_t start;
+    uintmax_t end; /* or 0 if unbounded */
+    bool ranged;
+};
+
+static int adaptive_http_res_req(const struct vlc_http_resource *resource,
+                                 struct vlc_http_msg *req, void *)
+{
+    const adaptive_http_resource *res =
+            reinterpret_cast<const adaptive_http_resource *>(resource);
+    if(!res->ranged)
+        return 0;
+    if(res->end)
+        return vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-%" PRIuMAX,
+                                       res->start, res->end);
+    return vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", res->start);
+}
+
+static int adaptive_http_res_resp(const struct vlc_http_resource *resource,
+                                  const struct vlc_http_msg *resp, void *)
+{
+    const adaptive_http_resource *res =
+            reinterpret_cast<const adaptive_http_resource *>(resource);
+    if(!res->ranged)
+        return 0;
+
+    int status = vlc_http_msg_get_status(resp);
+    if(status == 206)
+    {
+        const char *str = vlc_http_msg_get_header(resp, "Content-Range");
+        uintmax_t start, end;
+        if(str && sscanf(str, "bytes %" SCNuMAX "-%" SCNuMAX, &start, &end) == 2 &&
+           start == res->start)
+            return 0;
+    }
+    else if(status >= 300 || res->start == 0)
+        return 0; /* redirections & errors are checked later */
+
+    /* The server ignored or garbled the range */
+    errno = EIO;
+    return -1;
+}
+
+static const struct vlc_http_resource_cbs adaptive_http_res_cbs =
+{
+    adaptive_http_res_req,
+    adaptive_http_res_resp,
+};
+
+LibVLCHTTPConnectionFactory::LibVLCHTTPConnectionFactory( AuthStorage *auth )
+    : AbstractConnectionFactory()
+{
+    authStorage = auth;
+    vlc_mutex_init(&lock);
+}
+
+LibVLCHTTPConnectionFactory::~LibVLCHTTPConnectionFactory()
+{
+    std::map<std::string, struct vlc_http_mgr *>::const_iterator it;
+    for(it = managers.begin(); it != managers.end(); ++it)
+        vlc_http_mgr_destroy((*it).second);
+}
+
+AbstractConnection * LibVLCHTTPConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                                   const ConnectionParams &params)
+{
+    if(params.getScheme() != "https" || params.getHostname().empty())
+        return NULL;
+    return new (std::nothrow) LibVLCHTTPConnection(p_object, this);
+}
+
+struct vlc_http_mgr * LibVLCHTTPConnectionFactory::getManager(vlc_object_t *p_object,
+                                                              const std::string &url)
+{
+    ConnectionParams params(url);
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << params.getScheme() << "://" << params.getHostname() << ":" << params.getPort();
+
+    std::map<std::string, struct vlc_http_mgr *>::const_iterator it = managers.find(os.str());
+    if(it != managers.end())
+        return (*it).second;
+
+    struct vlc_http_mgr *mgr = vlc_http_mgr_create(p_object, authStorage->getCookieJar());
+    if(mgr)
+        managers.insert(std::pair<std::string, struct vlc_http_mgr *>(os.str(), mgr));
+    return mgr;
+}
+
+struct vlc_http_resource * LibVLCHTTPConnectionFactory::open(vlc_object_t *p_object,
+                                                             const std::string &url,
+                                                             const std::string &ua,
+                                                             const std::string &ref,
+                                                             const BytesRange &range,
+                                                             int *status)
+{
+    /* released with vlc_http_res_destroy() */
+    adaptive_http_resource *res = static_cast<adaptive_http_resource *>
+                                  (malloc(sizeof(*res)));
+    if(!res)
+        return NULL;
+
+    res->ranged = range.isValid();
+    res->start = res->ranged ? range.getStartByte() : 0;
+    res->end = res->ranged ? range.getEndByte() : 0;
+
+    /* The managers are not reentrant: requests are serialized, while
+     * the responses are read concurrently from the shared sessions. */
+    vlc_mutex_locker locker(&lock);
+    struct vlc_http_mgr *mgr = getManager(p_object, url);
+    if(!mgr || vlc_http_res_init(&res->resource, &adaptive_http_res_cbs, mgr,
+                                 url.c_str(), ua.empty() ? NULL : ua.c_str(),
+                                 ref.empty() ? NULL : ref.c_str()))
+    {
+        free(res);
+        return NULL;
+    }
+
+    *status = vlc_http_res_get_status(&res->resource);
+    if(*status < 0)
+    {
+        vlc_http_res_destroy(&res->resource);
+        return NULL;
+    }
+    return &res->resource;
+}
+
+void LibVLCHTTPConnectionFactory::close(struct vlc_http_resource *res)
+{
+    vlc_mutex_locker locker(&lock);
+    vlc_http_res_destroy(res);
+}
+
 ConnectionFactory::ConnectionFactory( AuthStorage *authstorage )
 {
     native = new NativeConnectionFactory( authstorage );
     streamurl = new StreamUrlConnectionFactory();
+    libvlchttp = new LibVLCHTTPConnectionFactory( authstorage );
 }
 
 ConnectionFactory::~ConnectionFactory()
 {
     delete native;
     delete streamurl;
+    delete libvlchttp;
 }
 
 AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
@@ -660,6 +960,12 @@ AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
     bool b_streamurl = var_InheritBool(p_object, "adaptive-use-access");
     if(!b_streamurl && !params.usesAccess())
     {
+        if(var_InheritBool(p_object, "adaptive-http2"))
+        {
+            AbstractConnection *conn = libvlchttp->createConnection(p_object, params);
+            if(conn)
+                return conn;
+        }
         return native->createConnection(p_object, params);
     }
     else
@@ -29,6 +29,10 @@
 #include "BytesRange.hpp"
 #include <vlc_common.h>
 #include <string>
+#include <map>
+
+struct vlc_http_mgr;
+struct vlc_http_resource;
 
 namespace adaptive
 {
@@ -132,6 +136,31 @@ namespace adaptive
                 stream_t *p_streamurl;
        };
 
+       class LibVLCHTTPConnectionFactory;
+
+       class LibVLCHTTPConnection : public AbstractConnection
+       {
+            public:
+                LibVLCHTTPConnection(vlc_object_t *, LibVLCHTTPConnectionFactory *);
+                virtual ~LibVLCHTTPConnection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const;
+
+                virtual enum RequestStatus
+                                request     (const std::string& path, const BytesRange & = BytesRange());
+                virtual ssize_t read        (void *p_buffer, size_t len);
+
+                virtual void    setUsed( bool );
+
+            protected:
+                void reset();
+                LibVLCHTTPConnectionFactory *factory;
+                struct vlc_http_resource *resource;
+                block_t *p_block; /* partially consumed data */
+                std::string useragent;
+                std::string referer;
+       };
+
        class AbstractConnectionFactory
        {
            public:
@@ -158,6 +187,26 @@ namespace adaptive
                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
        };
 
+       /* Keeps one libvlc HTTP manager per origin, so that all the requests
+        * to a server multiplex over a single HTTP/2 session */
+       class LibVLCHTTPConnectionFactory : public AbstractConnectionFactory
+       {
+           public:
+               LibVLCHTTPConnectionFactory( AuthStorage * );
+               virtual ~LibVLCHTTPConnectionFactory();
+               virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+               struct vlc_http_resource * open(vlc_object_t *, const std::string &,
+                                               const std::string &, const std::string &,
+                                               const BytesRange &, int *);
+               void close(struct vlc_http_resource *);
+
+           private:
+               struct vlc_http_mgr * getManager(vlc_object_t *, const std::string &);
+               AuthStorage *authStorage;
+               vlc_mutex_t lock;
+               std::map<std::string, struct vlc_http_mgr *> managers;
+       };
+
        class ConnectionFactory : public AbstractConnectionFactory
        {
            public:
@@ -167,6 +216,7 @@ namespace adaptive
            private:
                NativeConnectionFactory *native;
                StreamUrlConnectionFactory *streamurl;
+               LibVLCHTTPConnectionFactory *libvlchttp;
        };
     }
 }
@@ -65,15 +65,16 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
 {
     vlc_mutex_init(&lock);
     downloader = new (std::nothrow) Downloader();
-    downloader->start();
+    downloader->start(var_InheritInteger(p_object, "adaptive-downloaders"));
     factory = new ConnectionFactory(storage);
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
-    delete factory;
+    /* connections may use sessions owned by the factory */
     this->closeAllConnections();
+    delete factory;
 }
 
 void HTTPConnectionManager::closeAllConnections      ()
@@ -47,6 +47,7 @@ AbstractBufferingLogic::AbstractBufferingLogic()
     userMinBuffering = 0;
     userMaxBuffering = 0;
     userLiveDelay = 0;
+    userFastStart = false;
 }
 
 void AbstractBufferingLogic::setLowDelay(bool b)
@@ -54,6 +55,16 @@ void AbstractBufferingLogic::setLowDelay(bool b)
     userLowLatency = b;
 }
 
+void AbstractBufferingLogic::setFastStart(bool b)
+{
+    userFastStart = b;
+}
+
+bool AbstractBufferingLogic::isFastStart() const
+{
+    return userFastStart;
+}
+
 void AbstractBufferingLogic::setUserMinBuffering(vlc_tick_t v)
 {
     userMinBuffering = v;
@@ -139,6 +150,16 @@ vlc_tick_t DefaultBufferingLogic::getLiveDelay(const AbstractPlaylist *p) const
     return std::max(delay, getMinBuffering(p));
 }
 
+vlc_tick_t DefaultBufferingLogic::getTargetLatency(const AbstractPlaylist *) const
+{
+    return 0;
+}
+
+vlc_tick_t DefaultBufferingLogic::getLatencyCorrection(const AbstractPlaylist *, vlc_tick_t)
+{
+    return 0;
+}
+
 uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *rep) const
 {
     AbstractPlaylist *playlist = rep->getPlaylist();
@@ -361,6 +382,9 @@ uint64_t DefaultBufferingLogic::getLiveStartSegmentNumber(BaseRepresentation *re
 
 vlc_tick_t DefaultBufferingLogic::getBufferingOffset(const AbstractPlaylist *p) const
 {
+    /* start from the closest boundary still giving the minimum buffering */
+    if(p->isLive() && userFastStart)
+        return getMinBuffering(p);
     return p->isLive() ? getLiveDelay(p) : getMaxBuffering(p);
 }
 
@@ -370,3 +394,92 @@ bool DefaultBufferingLogic::isLowLatency(const AbstractPlaylist *p) const
         return userLowLatency.value();
     return p->isLowLatency();
 }
+
+const vlc_tick_t TargetLatencyBufferingLogic::MIN_JUMP_MARGIN = VLC_TICK_FROM_SEC(2);
+const vlc_tick_t TargetLatencyBufferingLogic::JUMP_COOLDOWN = VLC_TICK_FROM_SEC(5);
+
+TargetLatencyBufferingLogic::TargetLatencyBufferingLogic()
+    : DefaultBufferingLogic()
+{
+    userTargetLatency = 0;
+    smoothedLatency = 0;
+    jumpMargin = 0;
+    lastJump = VLC_TICK_INVALID;
+    b_checkJump = false;
+}
+
+void TargetLatencyBufferingLogic::setUserTargetLatency(vlc_tick_t v)
+{
+    userTargetLatency = v;
+}
+
+vlc_tick_t TargetLatencyBufferingLogic::getTargetLatency(const AbstractPlaylist *p) const
+{
+    if(!p->isLive())
+        return 0;
+    if(userTargetLatency)
+        return userTargetLatency;
+    return p->targetLatency.Get();
+}
+
+vlc_tick_t TargetLatencyBufferingLogic::getMinBuffering(const AbstractPlaylist *p) const
+{
+    vlc_tick_t buffering = DefaultBufferingLogic::getMinBuffering(p);
+    const vlc_tick_t target = getTargetLatency(p);
+    /* We can't buffer more than our distance to the live edge */
+    if(target)
+        buffering = std::min(buffering, std::max(target, BUFFERING_LOWEST_LIMIT));
+    return buffering;
+}
+
+vlc_tick_t TargetLatencyBufferingLogic::getLiveDelay(const AbstractPlaylist *p) const
+{
+    const vlc_tick_t target = getTargetLatency(p);
+    if(!target)
+        return DefaultBufferingLogic::getLiveDelay(p);
+    return std::max(target, getMinBuffering(p));
+}
+
+vlc_tick_t TargetLatencyBufferingLogic::getMaxLatency(const AbstractPlaylist *p) const
+{
+    const vlc_tick_t target = getTargetLatency(p);
+    vlc_tick_t maxlatency;
+    if(!userTargetLatency && p->maxLatency.Get() > target)
+        maxlatency = p->maxLatency.Get();
+    else
+        maxlatency = target + std::max(target / 2, MIN_JUMP_MARGIN);
+    return std::max(maxlatency, target + jumpMargin);
+}
+
+vlc_tick_t TargetLatencyBufferingLogic::getLatencyCorrection(const AbstractPlaylist *p,
+                                                             vlc_tick_t latency)
+{
+    const vlc_tick_t target = getTargetLatency(p);
+    if(!target)
+        return 0;
+
+    const vlc_tick_t now = vlc_tick_now();
+    if(lastJump != VLC_TICK_INVALID && now - lastJump < JUMP_COOLDOWN)
+        return 0;
+
+    if(b_checkJump)
+    {
+        /* Segments granularity can prevent from getting any closer.
+         * Widen the margin instead of jumping again to the same place. */
+        b_checkJump = false;
+        if(latency > getMaxLatency(p))
+            jumpMargin = latency - target + MIN_JUMP_MARGIN;
+        smoothedLatency = latency;
+        return 0;
+    }
+
+    smoothedLatency = smoothedLatency ? (smoothedLatency * 3 + latency) / 4
+                                      : latency;
+    if(smoothedLatency <= getMaxLatency(p) || latency <= target)
+        return 0;
+
+    lastJump = now;
+    b_checkJump = true;
+    smoothedLatency = 0;
+    return latency - target;
+}
@@ -46,10 +46,14 @@ namespace adaptive
                 virtual vlc_tick_t getMinBuffering(const AbstractPlaylist *) const = 0;
                 virtual vlc_tick_t getMaxBuffering(const AbstractPlaylist *) const = 0;
                 virtual vlc_tick_t getLiveDelay(const AbstractPlaylist *) const = 0;
+                virtual vlc_tick_t getTargetLatency(const AbstractPlaylist *) const = 0;
+                virtual vlc_tick_t getLatencyCorrection(const AbstractPlaylist *, vlc_tick_t) = 0;
                 void setUserMinBuffering(vlc_tick_t);
                 void setUserMaxBuffering(vlc_tick_t);
                 void setUserLiveDelay(vlc_tick_t);
                 void setLowDelay(bool);
+                void setFastStart(bool);
+                bool isFastStart() const;
                 static const vlc_tick_t BUFFERING_LOWEST_LIMIT;
                 static const vlc_tick_t DEFAULT_MIN_BUFFERING;
                 static const vlc_tick_t DEFAULT_MAX_BUFFERING;
@@ -60,6 +64,7 @@ namespace adaptive
                 vlc_tick_t userMaxBuffering;
                 vlc_tick_t userLiveDelay;
                 Undef<bool> userLowLatency;
+                bool userFastStart;
         };
 
         class DefaultBufferingLogic : public AbstractBufferingLogic
@@ -71,12 +76,38 @@ namespace adaptive
                 virtual vlc_tick_t getMinBuffering(const AbstractPlaylist *) const; /* impl */
                 virtual vlc_tick_t getMaxBuffering(const AbstractPlaylist *) const; /* impl */
                 virtual vlc_tick_t getLiveDelay(const AbstractPlaylist *) const; /* impl */
+                virtual vlc_tick_t getTargetLatency(const AbstractPlaylist *) const; /* impl */
+                virtual vlc_tick_t getLatencyCorrection(const AbstractPlaylist *, vlc_tick_t); /* impl */
 
             protected:
                 vlc_tick_t getBufferingOffset(const AbstractPlaylist *) const;
                 uint64_t getLiveStartSegmentNumber(BaseRepresentation *) const;
                 bool isLowLatency(const AbstractPlaylist *) const;
         };
+
+        /* Holds live playback at a target distance from the live edge,
+         * skipping forward when it drifts too far behind */
+        class TargetLatencyBufferingLogic : public DefaultBufferingLogic
+        {
+            public:
+                TargetLatencyBufferingLogic();
+                virtual ~TargetLatencyBufferingLogic() {}
+                virtual vlc_tick_t getMinBuffering(const AbstractPlaylist *) const; /* reimpl */
+                virtual vlc_tick_t getLiveDelay(const AbstractPlaylist *) const; /* reimpl */
+                virtual vlc_tick_t getTargetLatency(const AbstractPlaylist *) const; /* reimpl */
+                virtual vlc_tick_t getLatencyCorrection(const AbstractPlaylist *, vlc_tick_t); /* reimpl */
+                void setUserTargetLatency(vlc_tick_t);
+                static const vlc_tick_t MIN_JUMP_MARGIN;
+                static const vlc_tick_t JUMP_COOLDOWN;
+
+            protected:
+                vlc_tick_t getMaxLatency(const AbstractPlaylist *) const;
+                vlc_tick_t userTargetLatency;
+                vlc_tick_t smoothedLatency;
+                vlc_tick_t jumpMargin;
+                vlc_tick_t lastJump;
+                bool       b_checkJump;
+        };
     }
 }
 
@@ -80,16 +80,22 @@ void RateBasedAdaptationLogic::updateDownloadRate(const ID &, size_t size, vlc_t
 {
     if(unlikely(time == 0))
         return;
+
+    /* Downloads can complete concurrently */
+    vlc_mutex_lock(&lock);
+
     /* Accumulate up to observation window */
     dllength += time;
     dlsize += size;
 
     if(dllength < VLC_TICK_FROM_MS(250))
+    {
+        vlc_mutex_unlock(&lock);
         return;
+    }
 
     const size_t bps = CLOCK_FREQ * dlsize * 8 / dllength;
 
-    vlc_mutex_lock(&lock);
     bpsAvg = average.push(bps);
 
 //    BwDebug(msg_Dbg(p_obj, "alpha1 %lf alpha0 %lf dmax %ld ds %ld", alpha,
@@ -0,0 +1,104 @@
+/*
+ * FragmentScanner.cpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "FragmentScanner.hpp"
+
+#include <algorithm>
+
+using namespace adaptive::mp4;
+
+FragmentScanner::FragmentScanner()
+{
+    reset();
+}
+
+void FragmentScanner::reset()
+{
+    boxleft = 0;
+    headerlen = 0;
+    headersplit = false;
+    fragments = 0;
+    valid = true;
+}
+
+unsigned FragmentScanner::getFragmentsCount() const
+{
+    return fragments;
+}
+
+void FragmentScanner::scan(const uint8_t *p, size_t n, std::vector<Boundary> *starts)
+{
+    size_t i = 0;
+    while(i < n && valid)
+    {
+        if(boxleft)
+        {
+            const size_t skip = std::min(boxleft, (uint64_t)(n - i));
+            boxleft -= skip;
+            i += skip;
+            continue;
+        }
+
+        const size_t boxstart = i;
+        if(headerlen == 0)
+            headersplit = false;
+
+        size_t needed = (headerlen >= 8 && GetDWBE(header) == 1) ? 16 : 8;
+        while(headerlen < needed && i < n)
+        {
+            header[headerlen++] = p[i++];
+            if(headerlen == 8 && GetDWBE(header) == 1)
+                needed = 16;
+        }
+        if(headerlen < needed)
+        {
+            headersplit = true; /* completed from the next buffer */
+            break;
+        }
+
+        uint64_t size = GetDWBE(header);
+        if(size == 1)
+            size = GetQWBE(&header[8]);
+        if(size < headerlen) /* 0 is up to the end, nothing more to find */
+        {
+            valid = false;
+            break;
+        }
+
+        if(VLC_FOURCC(header[4], header[5], header[6], header[7]) ==
+           VLC_FOURCC('m','o','o','f'))
+        {
+            /* a header spanning buffers has no usable start offset */
+            if(!headersplit)
+            {
+                Boundary b;
+                b.offset = boxstart;
+                b.index = fragments;
+                starts->push_back(b);
+            }
+            fragments++;
+        }
+        boxleft = size - headerlen;
+        headerlen = 0;
+    }
+}
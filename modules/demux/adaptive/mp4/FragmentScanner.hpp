@@ -0,0 +1,57 @@
+/*
+ * FragmentScanner.hpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef FRAGMENTSCANNER_HPP
+#define FRAGMENTSCANNER_HPP
+
+#include <vlc_common.h>
+#include <vector>
+
+namespace adaptive
+{
+    namespace mp4
+    {
+        /* Follows the top level boxes of a segment received block by block,
+         * without buffering, to locate the start of each movie fragment */
+        class FragmentScanner
+        {
+            public:
+                FragmentScanner();
+                void reset();
+                struct Boundary
+                {
+                    size_t offset;  /* in the scanned buffer */
+                    unsigned index; /* of the fragment in the segment */
+                };
+                /* appends the moof beginnings found in the buffer */
+                void scan(const uint8_t *, size_t, std::vector<Boundary> *);
+                unsigned getFragmentsCount() const;
+
+            private:
+                uint64_t boxleft;
+                uint8_t  header[16];
+                size_t   headerlen;
+                bool     headersplit;
+                unsigned fragments;
+                bool     valid;
+        };
+    }
+}
+
+#endif // FRAGMENTSCANNER_HPP
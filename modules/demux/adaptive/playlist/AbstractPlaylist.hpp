@@ -75,6 +75,8 @@ namespace adaptive
                 Property<vlc_tick_t>                   maxSegmentDuration;
                 Property<vlc_tick_t>                   timeShiftBufferDepth;
                 Property<vlc_tick_t>                   suggestedPresentationDelay;
+                Property<vlc_tick_t>                   targetLatency;
+                Property<vlc_tick_t>                   maxLatency;
 
             protected:
                 vlc_object_t                       *p_object;
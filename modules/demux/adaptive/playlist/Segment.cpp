@@ -34,6 +34,8 @@
 #include "../http/BytesRange.hpp"
 #include "../http/HTTPConnectionManager.h"
 #include "../http/Downloader.hpp"
+#include "../http/ChunkCache.hpp"
+#include "../SharedResources.hpp"
 #include <cassert>
 
 using namespace adaptive::http;
@@ -82,12 +84,35 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                                 size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
+    const BytesRange range = (startByte != endByte) ? BytesRange(startByte, endByte)
+                                                    : BytesRange();
+    ChunkCache *cache = res ? res->getChunkCache() : NULL;
+
+    /* Already downloaded or being downloaded by another stream or instance */
+    AbstractChunkSource *cached = cache ? cache->getSource(url, range) : NULL;
+    if(cached)
+    {
+        SegmentChunk *chunk = createChunk(cached, rep);
+        if(chunk)
+        {
+            chunk->discontinuity = discontinuity;
+            if(!prepareChunk(res, chunk, rep))
+            {
+                delete chunk;
+                return NULL;
+            }
+            return chunk;
+        }
+        delete cached;
+        return NULL;
+    }
+
     HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
                                                                                  rep->getAdaptationSet()->getID());
     if( source )
     {
-        if(startByte != endByte)
-            source->setBytesRange(BytesRange(startByte, endByte));
+        if(range.isValid())
+            source->setBytesRange(range);
 
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
@@ -98,6 +123,8 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                 delete chunk;
                 return NULL;
             }
+            if(cache)
+                cache->provide(source, url, range);
             connManager->start(source);
             return chunk;
         }
@@ -39,6 +39,8 @@ SegmentChunk::SegmentChunk(AbstractChunkSource *source, BaseRepresentation *rep_
 {
     rep = rep_;
     encryptionSession = NULL;
+    discontinuity = false;
+    skipFragments = 0;
 }
 
 SegmentChunk::~SegmentChunk()
@@ -78,5 +80,9 @@ StreamFormat SegmentChunk::getStreamFormat() const
 void SegmentChunk::setEncryptionSession(CommonEncryptionSession *s)
 {
     delete encryptionSession;
+    encryptionSession = NULL;
+    /* Let the downloader decrypt if it can, otherwise we do on read */
+    if(s && source->setDecryption(s))
+        return;
     encryptionSession = s;
 }
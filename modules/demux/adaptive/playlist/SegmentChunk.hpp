@@ -46,6 +46,7 @@ namespace adaptive
             void         setEncryptionSession(CommonEncryptionSession *);
             StreamFormat getStreamFormat() const;
             bool discontinuity;
+            unsigned skipFragments; /* to drop, resuming within the segment */
 
         protected:
             bool         decrypt(block_t **);
@@ -44,99 +44,84 @@ SegmentTimeline::SegmentTimeline(uint64_t scale)
 
 SegmentTimeline::~SegmentTimeline()
 {
-    std::list<Element *>::iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        delete *it;
 }
 
-void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
+void SegmentTimeline::appendElement(const Element &element)
 {
-    Element *element = new (std::nothrow) Element(number, d, r, t);
-    if(element)
+    totalLength += element.d * (element.r + 1);
+    if(!elements.empty())
     {
-        if(!elements.empty() && !t)
+        Element &last = elements.back();
+        if(last.d == element.d && last.end() == element.t &&
+           last.number + last.r + 1 == element.number)
         {
-            const Element *el = elements.back();
-            element->t = el->t + (el->d * (el->r + 1));
+            last.r += element.r + 1;
+            return;
         }
-        elements.push_back(element);
-        totalLength += (d * (r + 1));
     }
+    elements.push_back(element);
 }
 
-stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
+void SegmentTimeline::addElement(uint64_t number, stime_t d, uint64_t r, stime_t t)
 {
-    stime_t totalscaledtime = 0;
+    if(!elements.empty() && !t)
+        t = elements.back().end();
+    appendElement(Element(number, d, r, t));
+}
 
-    if(!elements.size() ||
-       minElementNumber() > number ||
-       maxElementNumber() < number)
+std::deque<SegmentTimeline::Element>::const_iterator
+SegmentTimeline::findByNumber(uint64_t number) const
+{
+    /* last element starting at or before number */
+    auto it = std::upper_bound(elements.begin(), elements.end(), number,
+                               [](uint64_t n, const Element &el) { return n < el.number; });
+    if(it == elements.begin())
+        return elements.end();
+    return --it;
+}
+
+stime_t SegmentTimeline::getMinAheadScaledTime(uint64_t number) const
+{
+    auto it = findByNumber(number);
+    if(it == elements.end() || maxElementNumber() < number)
         return 0;
 
-    std::list<Element *>::const_reverse_iterator it;
-    for(it = elements.rbegin(); it != elements.rend(); ++it)
-    {
-        const Element *el = *it;
-        if(number > el->number + el->r)
-            break;
-        else if(number < el->number + el->r)
-            totalscaledtime += (el->d * (el->r + 1));
-        else /* within repeat range */
-            totalscaledtime += el->d * (el->number + el->r - number);
-    }
+    stime_t totalscaledtime = it->d * (it->number + it->r - number);
+    for(++it; it != elements.end(); ++it)
+        totalscaledtime += it->d * (it->r + 1);
 
     return totalscaledtime;
 }
 
 uint64_t SegmentTimeline::getElementNumberByScaledPlaybackTime(stime_t scaled) const
 {
-    const Element *prevel = NULL;
-    std::list<Element *>::const_iterator it;
-
-    if(!elements.size())
+    if(elements.empty())
         return 0;
 
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(scaled >= el->t)
-        {
-            if((uint64_t)scaled < el->t + (el->d * el->r))
-                return el->number + (scaled - el->t) / el->d;
-        }
-        /* might have been discontinuity */
-        else
-        {
-            if(prevel) /* > prev but < current */
-                return prevel->number + prevel->r;
-            else /* << first of the list */
-                return el->number;
-        }
-        prevel = el;
-    }
+    auto it = std::upper_bound(elements.begin(), elements.end(), scaled,
+                               [](stime_t time, const Element &el) { return time < el.t; });
+    /* << first of the list */
+    if(it == elements.begin())
+        return elements.front().number;
 
-    /* time is >> any of the list */
-    return prevel->number + prevel->r;
+    const Element &el = *(--it);
+    if(scaled < el.end())
+        return el.number + (scaled - el.t) / el.d;
+
+    /* might have been discontinuity, or >> any of the list */
+    return el.number + el.r;
 }
 
 bool SegmentTimeline::getScaledPlaybackTimeDurationBySegmentNumber(uint64_t number,
                                                                    stime_t *time, stime_t *duration) const
 {
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-    {
-        const Element *el = *it;
-        if(number >= el->number)
-        {
-            if(number <= el->number + el->r)
-            {
-                *time = el->t + el->d * (number - el->number);
-                *duration = el->d;
-                return true;
-            }
-        }
-    }
-    return false;
+    auto it = findByNumber(number);
+    if(it == elements.end() || number > it->number + it->r)
+        return false;
+
+    *time = it->t + it->d * (number - it->number);
+    *duration = it->d;
+    return true;
 }
 
 stime_t SegmentTimeline::getScaledPlaybackTimeByElementNumber(uint64_t number) const
@@ -156,15 +141,15 @@ uint64_t SegmentTimeline::maxElementNumber() const
     if(elements.empty())
         return 0;
 
-    const Element *e = elements.back();
-    return e->number + e->r;
+    const Element &e = elements.back();
+    return e.number + e.r;
 }
 
 uint64_t SegmentTimeline::minElementNumber() const
 {
     if(elements.empty())
         return 0;
-    return elements.front()->number;
+    return elements.front().number;
 }
 
 void SegmentTimeline::pruneByPlaybackTime(vlc_tick_t time)
@@ -179,26 +164,26 @@ size_t SegmentTimeline::pruneBySequenceNumber(uint64_t number)
     size_t prunednow = 0;
     while(elements.size())
     {
-        Element *el = elements.front();
-        if(el->number >= number)
+        Element &el = elements.front();
+        if(el.number >= number)
         {
             break;
         }
-        else if(el->number + el->r >= number)
+        else if(el.number + el.r >= number)
         {
-            uint64_t count = number - el->number;
-            el->number += count;
-            el->t += count * el->d;
-            el->r -= count;
+            uint64_t count = number - el.number;
+            el.number += count;
+            el.t += count * el.d;
+            el.r -= count;
+            totalLength -= count * el.d;
             prunednow += count;
             break;
         }
         else
         {
-            prunednow += el->r + 1;
+            prunednow += el.r + 1;
+            totalLength -= (el.d * (el.r + 1));
             elements.pop_front();
-            totalLength -= (el->d * (el->r + 1));
-            delete el;
         }
     }
 
@@ -209,40 +194,30 @@ void SegmentTimeline::updateWith(SegmentTimeline &other)
 {
     if(elements.empty())
     {
-        while(other.elements.size())
-        {
-            elements.push_back(other.elements.front());
-            other.elements.pop_front();
-        }
+        elements.swap(other.elements);
+        std::swap(totalLength, other.totalLength);
         return;
     }
 
-    Element *last = elements.back();
-    while(other.elements.size())
+    for(const Element &el : other.elements)
     {
-        Element *el = other.elements.front();
-        other.elements.pop_front();
-
-        if(last->contains(el->t)) /* Same element, but prev could have been middle of repeat */
+        Element &last = elements.back();
+        if(last.contains(el.t)) /* Same element, but prev could have been middle of repeat */
         {
-            const uint64_t count = (el->t - last->t) / last->d;
-            totalLength -= (last->d * (last->r + 1));
-            last->r = std::max(last->r, el->r + count);
-            totalLength += (last->d * (last->r + 1));
-            delete el;
+            const uint64_t count = (el.t - last.t) / last.d;
+            totalLength -= (last.d * (last.r + 1));
+            last.r = std::max(last.r, el.r + count);
+            totalLength += (last.d * (last.r + 1));
         }
-        else if(el->t < last->t)
+        else if(el.t > last.t) /* Did not exist in previous list */
         {
-            delete el;
-        }
-        else /* Did not exist in previous list */
-        {
-            totalLength += (el->d * (el->r + 1));
-            elements.push_back(el);
-            el->number = last->number + last->r + 1;
-            last = el;
+            Element added = el;
+            added.number = last.number + last.r + 1;
+            appendElement(added);
         }
     }
+    other.elements.clear();
+    other.totalLength = 0;
 }
 
 void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
@@ -251,9 +226,8 @@ void SegmentTimeline::debug(vlc_object_t *obj, int indent) const
     ss << std::string(indent, ' ') << "Timeline";
     msg_Dbg(obj, "%s", ss.str().c_str());
 
-    std::list<Element *>::const_iterator it;
-    for(it = elements.begin(); it != elements.end(); ++it)
-        (*it)->debug(obj, indent + 1);
+    for(const Element &el : elements)
+        el.debug(obj, indent + 1);
 }
 
 SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, stime_t t_)
@@ -264,9 +238,14 @@ SegmentTimeline::Element::Element(uint64_t number_, stime_t d_, uint64_t r_, sti
     r = r_;
 }
 
+stime_t SegmentTimeline::Element::end() const
+{
+    return t + (stime_t)(r + 1) * d;
+}
+
 bool SegmentTimeline::Element::contains(stime_t time) const
 {
-    if(time >= t && time < t + (stime_t)(r + 1) * d)
+    if(time >= t && time < end())
         return true;
     return false;
 }
@@ -25,7 +25,7 @@
 
 #include "SegmentInfoCommon.h"
 #include <vlc_common.h>
-#include <list>
+#include <deque>
 
 namespace adaptive
 {
@@ -33,8 +33,6 @@ namespace adaptive
     {
         class SegmentTimeline : public TimescaleAble
         {
-            class Element;
-
             public:
                 SegmentTimeline(TimescaleAble *);
                 SegmentTimeline(uint64_t);
@@ -53,20 +51,26 @@ namespace adaptive
                 void debug(vlc_object_t *, int = 0) const;
 
             private:
-                std::list<Element *> elements;
-                stime_t totalLength;
-
                 class Element
                 {
                     public:
                         Element(uint64_t, stime_t, uint64_t, stime_t);
                         void debug(vlc_object_t *, int = 0) const;
                         bool contains(stime_t) const;
+                        stime_t end() const;
                         stime_t  t;
                         stime_t  d;
                         uint64_t r;
                         uint64_t number;
                 };
+
+                /* Sorted by number and time, contiguous runs of the
+                 * same duration are packed into a single repeated element */
+                std::deque<Element> elements;
+                stime_t totalLength;
+
+                void appendElement(const Element &);
+                std::deque<Element>::const_iterator findByNumber(uint64_t) const;
         };
     }
 }
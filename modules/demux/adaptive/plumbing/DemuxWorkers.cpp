@@ -0,0 +1,137 @@
+/*
+ * DemuxWorkers.cpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "DemuxWorkers.hpp"
+
+using namespace adaptive;
+
+DemuxWorkers::DemuxWorkers()
+{
+    vlc_mutex_init(&lock);
+    vlc_cond_init(&waitcond);
+    vlc_cond_init(&donecond);
+    killed = false;
+    job.streams = NULL;
+    job.results = NULL;
+    job.next = 0;
+    job.pending = 0;
+    job.i_nzdeadline = VLC_TICK_INVALID;
+    job.i_min_buffering = 0;
+    job.i_extra_buffering = 0;
+}
+
+DemuxWorkers::~DemuxWorkers()
+{
+    vlc_mutex_lock(&lock);
+    killed = true;
+    vlc_cond_broadcast(&waitcond);
+    vlc_mutex_unlock(&lock);
+
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = threads.begin(); it != threads.end(); ++it)
+        vlc_join(*it, NULL);
+}
+
+bool DemuxWorkers::start(unsigned count)
+{
+    while(threads.size() < count)
+    {
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, workerThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        threads.push_back(thread_handle);
+    }
+    return !threads.empty();
+}
+
+size_t DemuxWorkers::count() const
+{
+    return threads.size();
+}
+
+void DemuxWorkers::bufferize(const std::vector<AbstractStream *> &streams,
+                             vlc_tick_t i_nzdeadline,
+                             vlc_tick_t i_min_buffering,
+                             vlc_tick_t i_extra_buffering,
+                             std::vector<AbstractStream::buffering_status> &results)
+{
+    results.assign(streams.size(), AbstractStream::buffering_end);
+    if(streams.empty())
+        return;
+
+    vlc_mutex_lock(&lock);
+    job.streams = &streams;
+    job.results = &results;
+    job.next = 0;
+    job.pending = streams.size();
+    job.i_nzdeadline = i_nzdeadline;
+    job.i_min_buffering = i_min_buffering;
+    job.i_extra_buffering = i_extra_buffering;
+    vlc_cond_broadcast(&waitcond);
+
+    while(job.pending)
+        vlc_cond_wait(&donecond, &lock);
+
+    job.streams = NULL;
+    job.results = NULL;
+    vlc_mutex_unlock(&lock);
+}
+
+void * DemuxWorkers::workerThread(void *opaque)
+{
+    DemuxWorkers *instance = static_cast<DemuxWorkers *>(opaque);
+    int canc = vlc_savecancel();
+    instance->Run();
+    vlc_restorecancel( canc );
+    return NULL;
+}
+
+void DemuxWorkers::Run()
+{
+    vlc_mutex_lock(&lock);
+    while(1)
+    {
+        while(!killed && (!job.streams || job.next >= job.streams->size()))
+            vlc_cond_wait(&waitcond, &lock);
+
+        if(killed)
+            break;
+
+        const size_t index = job.next++;
+        AbstractStream *st = job.streams->at(index);
+        const vlc_tick_t i_nzdeadline = job.i_nzdeadline;
+        const vlc_tick_t i_min_buffering = job.i_min_buffering;
+        const vlc_tick_t i_extra_buffering = job.i_extra_buffering;
+        vlc_mutex_unlock(&lock);
+
+        AbstractStream::buffering_status status =
+                st->bufferize(i_nzdeadline, i_min_buffering, i_extra_buffering);
+
+        vlc_mutex_lock(&lock);
+        job.results->at(index) = status;
+        if(--job.pending == 0)
+            vlc_cond_signal(&donecond);
+    }
+    vlc_mutex_unlock(&lock);
+}
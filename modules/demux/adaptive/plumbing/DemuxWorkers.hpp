@@ -0,0 +1,68 @@
+/*
+ * DemuxWorkers.hpp
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef DEMUXWORKERS_HPP
+#define DEMUXWORKERS_HPP
+
+#include "../Streams.hpp"
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vector>
+
+namespace adaptive
+{
+    /* Pool running the bufferize() pass of several streams at once, so that
+     * each stream demuxes into its own FakeESOut queue on its own thread.
+     * A stream is only handled by one worker at a time, and a pass returns
+     * once every stream is done, keeping the dequeuing side unchanged. */
+    class DemuxWorkers
+    {
+        public:
+            DemuxWorkers();
+            ~DemuxWorkers();
+            bool start(unsigned);
+            size_t count() const;
+            void bufferize(const std::vector<AbstractStream *> &,
+                           vlc_tick_t, vlc_tick_t, vlc_tick_t,
+                           std::vector<AbstractStream::buffering_status> &);
+
+        private:
+            static void * workerThread(void *);
+            void Run();
+            std::vector<vlc_thread_t> threads;
+            vlc_mutex_t  lock;
+            vlc_cond_t   waitcond;
+            vlc_cond_t   donecond;
+            bool         killed;
+            /* current pass */
+            struct
+            {
+                const std::vector<AbstractStream *> *streams;
+                std::vector<AbstractStream::buffering_status> *results;
+                size_t      next;
+                size_t      pending;
+                vlc_tick_t  i_nzdeadline;
+                vlc_tick_t  i_min_buffering;
+                vlc_tick_t  i_extra_buffering;
+            } job;
+    };
+}
+
+#endif // DEMUXWORKERS_HPP
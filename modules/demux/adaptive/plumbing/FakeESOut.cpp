@@ -42,6 +42,7 @@ namespace adaptive
             static void es_out_Del( es_out_t *, es_out_id_t * );
             static int es_out_Control( es_out_t *, input_source_t *in, int, va_list );
             static void es_out_Destroy( es_out_t * );
+            static int es_out_SendChain( es_out_t *, es_out_id_t *, block_t * );
             static const struct es_out_callbacks cbs;
             struct Private
             {
@@ -59,6 +60,7 @@ const struct es_out_callbacks EsOutCallbacks::cbs =
     EsOutCallbacks::es_out_Control,
     EsOutCallbacks::es_out_Destroy,
     nullptr,
+    EsOutCallbacks::es_out_SendChain,
 };
 
 es_out_id_t * EsOutCallbacks::es_out_Add(es_out_t *fakees, input_source_t *, const es_format_t *p_fmt)
@@ -91,6 +93,12 @@ void EsOutCallbacks::es_out_Destroy(es_out_t *fakees)
     me->esOutDestroy();
 }
 
+int EsOutCallbacks::es_out_SendChain(es_out_t *fakees, es_out_id_t *p_es, block_t *p_chain)
+{
+    AbstractFakeEsOut *me = container_of(fakees, Private, es_out)->fake;
+    return me->esOutSendChain(p_es, p_chain);
+}
+
 AbstractFakeEsOut::AbstractFakeEsOut()
 {
     EsOutCallbacks::Private *priv = new EsOutCallbacks::Private;
@@ -507,6 +515,36 @@ int FakeESOut::esOutSend(es_out_id_t *p_es, block_t *p_block)
     return VLC_EGENERIC;
 }
 
+int FakeESOut::esOutSendChain(es_out_id_t *p_es, block_t *p_chain)
+{
+    vlc_mutex_locker locker(&lock);
+
+    FakeESOutID *es_id = reinterpret_cast<FakeESOutID *>( p_es );
+    assert(!es_id->scheduledForDeletion());
+
+    /* Commands are ordered by time, so they are still queued per block */
+    int i_ret = VLC_SUCCESS;
+    while( p_chain )
+    {
+        block_t *p_block = p_chain;
+        p_chain = p_block->p_next;
+        p_block->p_next = nullptr;
+
+        p_block->i_dts = fixTimestamp( p_block->i_dts );
+        p_block->i_pts = fixTimestamp( p_block->i_pts );
+
+        AbstractCommand *command = commandsqueue->factory()->createEsOutSendCommand( es_id, p_block );
+        if( likely(command) )
+            commandsqueue->Schedule( command );
+        else
+        {
+            block_Release( p_block );
+            i_ret = VLC_EGENERIC;
+        }
+    }
+    return i_ret;
+}
+
 void FakeESOut::esOutDel(es_out_id_t *p_es)
 {
     vlc_mutex_locker locker(&lock);
@@ -50,6 +50,7 @@ namespace adaptive
             virtual void esOutDel( es_out_id_t * ) = 0;
             virtual int esOutControl( int, va_list ) = 0;
             virtual void esOutDestroy() = 0;
+            virtual int esOutSendChain( es_out_id_t *, block_t * ) = 0;
     };
 
     class FakeESOut : public AbstractFakeEsOut
@@ -102,6 +103,7 @@ namespace adaptive
             virtual void esOutDel( es_out_id_t * ); /* impl */
             virtual int esOutControl( int, va_list ); /* impl */
             virtual void esOutDestroy(); /* impl */
+            virtual int esOutSendChain( es_out_id_t *, block_t * ); /* impl */
             es_out_t *real_es_out;
             FakeESOutID * createNewID( const es_format_t * );
             ExtraFMTInfoInterface *extrainfo;
@@ -53,6 +53,15 @@ ssize_t AbstractChunksSourceStream::read_Callback(stream_t *s, void *buf, size_t
     return me->Read(reinterpret_cast<uint8_t *>(buf), size);
 }
 
+block_t * AbstractChunksSourceStream::block_Callback(stream_t *s, bool *eof)
+{
+    AbstractChunksSourceStream *me = reinterpret_cast<AbstractChunksSourceStream *>(s->p_sys);
+    block_t *p_block = me->ReadBlock();
+    if(!p_block)
+        *eof = me->b_eof;
+    return p_block;
+}
+
 int AbstractChunksSourceStream::seek_Callback(stream_t *s, uint64_t i_pos)
 {
     AbstractChunksSourceStream *me = reinterpret_cast<AbstractChunksSourceStream *>(s->p_sys);
@@ -107,6 +116,7 @@ stream_t * AbstractChunksSourceStream::makeStream()
     {
         p_stream->pf_control = control_Callback;
         p_stream->pf_read = read_Callback;
+        p_stream->pf_block = block_Callback; /* hands over the chunks blocks */
         p_stream->pf_readdir = NULL;
         p_stream->pf_seek = seek_Callback;
         p_stream->p_sys = this;
@@ -193,6 +203,18 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
     return i_copied;
 }
 
+block_t * ChunksSourceStream::ReadBlock()
+{
+    block_t *p_ret = p_block;
+    p_block = NULL;
+    if(!p_ret && !b_eof)
+    {
+        p_ret = source->readNextBlock();
+        b_eof = !p_ret;
+    }
+    return p_ret;
+}
+
 int ChunksSourceStream::Seek(uint64_t)
 {
     return VLC_EGENERIC;
@@ -268,6 +290,38 @@ ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
     return i_copied;
 }
 
+block_t * BufferedChunksSourceStream::ReadBlock()
+{
+    const size_t i_remain = block_BytestreamRemaining(&bs) - i_bytestream_offset;
+    if(i_remain)
+    {
+        /* Data still in the backlog (partial reads or seek back) */
+        block_t *p_block = block_Alloc(i_remain);
+        if(p_block)
+        {
+            block_PeekOffsetBytes(&bs, i_bytestream_offset, p_block->p_buffer, i_remain);
+            i_bytestream_offset += i_remain;
+        }
+        return p_block;
+    }
+
+    if(b_eof)
+        return NULL;
+
+    /* Pass the downloaded block without copy. As we no longer own it,
+     * seeking back is only possible after that block */
+    block_t *p_block = source->readNextBlock();
+    if(!p_block)
+    {
+        b_eof = true;
+        return NULL;
+    }
+    block_BytestreamEmpty(&bs);
+    i_global_offset += i_bytestream_offset + p_block->i_buffer;
+    i_bytestream_offset = 0;
+    return p_block;
+}
+
 int BufferedChunksSourceStream::Seek(uint64_t i_seek)
 {
     if(i_seek < i_global_offset ||
@@ -110,7 +110,7 @@ Node* DOMParser::processNode(bool b_strict)
                         lifo.top()->addSubNode(node);
                     lifo.push(node);
 
-                    node->setName(std::string(data));
+                    node->setName(data);
                     addAttributesToNode(node);
                 }
 
@@ -162,11 +162,7 @@ void    DOMParser::addAttributesToNode      (Node *node)
     const char *attrName;
 
     while((attrName = xml_ReaderNextAttr(this->vlc_reader, &attrValue)) != NULL)
-    {
-        std::string key     = attrName;
-        std::string value   = attrValue;
-        node->addAttribute(key, value);
-    }
+        node->addAttribute(attrName, attrValue);
 }
 void    DOMParser::print                    (Node *node, int offset)
 {
@@ -62,30 +62,47 @@ void                                Node::setName               (const std::stri
     this->name = name;
 }
 
-bool                                Node::hasAttribute        (const std::string& name) const
+std::vector<std::pair<std::string, std::string>>::const_iterator
+                                    Node::findAttribute       (const std::string& name) const
 {
-    if(this->attributes.find(name) != this->attributes.end())
-        return true;
+    std::vector<std::pair<std::string, std::string>>::const_iterator it;
+    for(it = attributes.begin(); it != attributes.end(); ++it)
+    {
+        if(it->first == name)
+            break;
+    }
+    return it;
+}
 
-    return false;
+bool                                Node::hasAttribute        (const std::string& name) const
+{
+    return findAttribute(name) != attributes.end();
 }
 const std::string&                  Node::getAttributeValue     (const std::string& key) const
 {
-    std::map<std::string, std::string>::const_iterator  it = this->attributes.find( key );
+    std::vector<std::pair<std::string, std::string>>::const_iterator it = findAttribute( key );
 
     if ( it != this->attributes.end() )
         return it->second;
     return EmptyString;
 }
 
-void                                Node::addAttribute          ( const std::string& key, const std::string& value)
+void                                Node::addAttribute          ( const char *key, const char *value)
 {
-    this->attributes[key] = value;
+    for(size_t i = 0; i < attributes.size(); i++)
+    {
+        if(attributes[i].first == key)
+        {
+            attributes[i].second = value;
+            return;
+        }
+    }
+    attributes.emplace_back(key, value);
 }
 std::vector<std::string>            Node::getAttributeKeys      () const
 {
     std::vector<std::string> keys;
-    std::map<std::string, std::string>::const_iterator it;
+    std::vector<std::pair<std::string, std::string>>::const_iterator it;
 
     for(it = this->attributes.begin(); it != this->attributes.end(); ++it)
     {
@@ -104,11 +121,6 @@ void Node::setText(const std::string &text)
     this->text = text;
 }
 
-const std::map<std::string,std::string>&   Node::getAttributes         () const
-{
-    return this->attributes;
-}
-
 int Node::getType() const
 {
     return this->type;
@@ -27,7 +27,7 @@
 
 #include <vector>
 #include <string>
-#include <map>
+#include <utility>
 
 namespace adaptive
 {
@@ -44,12 +44,11 @@ namespace adaptive
                 const std::string&                  getName             () const;
                 void                                setName             (const std::string& name);
                 bool                                hasAttribute        (const std::string& name) const;
-                void                                addAttribute        (const std::string& key, const std::string& value);
+                void                                addAttribute        (const char *key, const char *value);
                 const std::string&                  getAttributeValue   (const std::string& key) const;
                 std::vector<std::string>            getAttributeKeys    () const;
                 const std::string&                  getText             () const;
                 void                                setText( const std::string &text );
-                const std::map<std::string, std::string>& getAttributes () const;
                 int                                 getType() const;
                 void                                setType( int type );
                 std::vector<std::string>            toString(int) const;
@@ -57,7 +56,10 @@ namespace adaptive
             private:
                 static const std::string            EmptyString;
                 std::vector<Node *>                 subNodes;
-                std::map<std::string, std::string>  attributes;
+                /* few per element, linear lookups beat a map */
+                std::vector<std::pair<std::string, std::string>> attributes;
+                std::vector<std::pair<std::string, std::string>>::const_iterator
+                                                    findAttribute       (const std::string& name) const;
                 std::string                         name;
                 std::string                         text;
                 int                                 type;
@@ -30,6 +30,7 @@
 #include <assert.h>
 #include <ctype.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -37,6 +38,7 @@
 #include <vlc_input.h>
 
 #include <vlc_dialog.h>
+#include <vlc_interrupt.h>
 
 #include <vlc_meta.h>
 #include <vlc_codecs.h>
@@ -118,7 +120,6 @@ typedef struct
 
 typedef struct
 {
-    vlc_fourcc_t i_id;
     uint32_t     i_flags;
     uint64_t     i_pos;
     uint32_t     i_length;
@@ -126,16 +127,69 @@ typedef struct
 
 } avi_entry_t;
 
+/* The index is stored in pages of entries relative to the page start */
+#define AVI_INDEX_PAGE_ENTRIES 1024
+#define AVI_INDEX_KEYFRAME     0x80000000 /* in i_length */
+
+typedef struct
+{
+    uint32_t     i_offset;      /* from the page position */
+    uint32_t     i_length;
+    uint32_t     i_lengthtotal; /* from the page cumulated length */
+
+} avi_index_entry_t;
+
+typedef struct
+{
+    uint32_t     i_first;       /* number of the first entry */
+    uint32_t     i_count;
+    uint64_t     i_pos;
+    uint64_t     i_lengthtotal;
+
+    /* Without entries, the page is i_count chunks of the same i_length,
+     * i_stride bytes apart (CBR streams) */
+    uint32_t     i_stride;
+    uint32_t     i_length;
+    avi_index_entry_t *p_entry;
+
+} avi_index_page_t;
+
 typedef struct
 {
     uint32_t        i_size;
-    uint32_t        i_max;
-    avi_entry_t     *p_entry;
+    uint64_t        i_lengthtotal;  /* of all the entries */
+
+    unsigned        i_pages;
+    unsigned        i_pages_max;
+    unsigned        i_page_last;    /* last page looked up */
+    avi_index_page_t *p_pages;
 
 } avi_index_t;
 static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static void avi_index_Append( avi_index_t *, uint64_t *, avi_entry_t * );
+static void avi_index_Get( avi_index_t *, unsigned, avi_entry_t * );
+
+static inline uint64_t avi_index_GetPos( avi_index_t *p_index, unsigned i )
+{
+    avi_entry_t entry;
+    avi_index_Get( p_index, i, &entry );
+    return entry.i_pos;
+}
+
+static inline uint32_t avi_index_GetLength( avi_index_t *p_index, unsigned i )
+{
+    avi_entry_t entry;
+    avi_index_Get( p_index, i, &entry );
+    return entry.i_length;
+}
+
+static inline bool avi_index_IsKeyframe( avi_index_t *p_index, unsigned i )
+{
+    avi_entry_t entry;
+    avi_index_Get( p_index, i, &entry );
+    return entry.i_flags & AVIIF_KEYFRAME;
+}
 
 typedef struct
 {
@@ -194,6 +248,18 @@ typedef struct
 
     unsigned int       i_attachment;
     input_attachment_t **attachment;
+
+    /* index created in background */
+    struct
+    {
+        bool             b_running;
+        vlc_thread_t     thread;
+        vlc_interrupt_t *p_interrupt;
+        atomic_bool      b_done;
+        bool             b_success;
+        avi_index_t     *p_index;    /* for each track */
+        uint64_t         i_last_pos;
+    } indexer;
 } demux_sys_t;
 
 #define __EVEN(x) (((x) & 1) ? (x) + 1 : (x))
@@ -213,12 +279,14 @@ static int AVI_StreamBytesSet ( demux_t *,
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( vlc_fourcc_t , uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static int  AVI_IndexerStart ( demux_t * );
+static void AVI_IndexerJoin  ( demux_t *, bool b_abort );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
@@ -271,6 +339,8 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    AVI_IndexerJoin( p_demux, true );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -692,7 +762,11 @@ static int Open( vlc_object_t * p_this )
 aviindex:
         if( p_sys->b_fastseekable )
         {
-            AVI_IndexCreate( p_demux );
+            /* Play with the current index until the new one is ready */
+            if( !b_index )
+                AVI_IndexLoad( p_demux );
+            if( AVI_IndexerStart( p_demux ) )
+                AVI_IndexCreate( p_demux );
         }
         else if( p_sys->b_seekable )
         {
@@ -716,7 +790,7 @@ aviindex:
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         const avi_track_t *tk = p_sys->track[i];
-        if( tk->fmt.i_cat == VIDEO_ES && tk->idx.p_entry )
+        if( tk->fmt.i_cat == VIDEO_ES )
             i_idx_totalframes = __MAX(i_idx_totalframes, tk->idx.i_size);
     }
     if( i_idx_totalframes != p_avih->i_totalframes &&
@@ -790,9 +864,7 @@ aviindex:
             p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
             tk->i_rate == p_auds->p_wf->nSamplesPerSec )
         {
-            int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+            int64_t i_track_length = tk->idx.i_lengthtotal;
             vlc_tick_t i_length = VLC_TICK_FROM_US( p_avih->i_totalframes *
                                                     p_avih->i_microsecperframe );
 
@@ -975,6 +1047,8 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    if( p_sys->indexer.b_running && atomic_load( &p_sys->indexer.b_done ) )
+        AVI_IndexerJoin( p_demux, false );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -1032,7 +1106,7 @@ static int Demux_Seekable( demux_t *p_demux )
         toread[i_track].b_ok = tk->b_activated && !tk->b_eof;
         if( tk->i_idxposc < tk->idx.i_size )
         {
-            toread[i_track].i_posf = tk->idx.p_entry[tk->i_idxposc].i_pos;
+            toread[i_track].i_posf = avi_index_GetPos( &tk->idx, tk->i_idxposc );
            if( tk->i_idxposb > 0 )
            {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1120,7 +1194,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
                     return VLC_DEMUXER_EGENERIC;
 
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1135,7 +1209,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1144,7 +1218,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1162,7 +1236,6 @@ static int Demux_Seekable( demux_t *p_demux )
 
                     /* add this chunk to the index */
                     avi_entry_t index;
-                    index.i_id     = avi_pk.i_fourcc;
                     index.i_flags  = AVI_GetKeyFlag(tk->fmt.i_codec, avi_pk.i_peek);
                     index.i_pos    = avi_pk.i_pos;
                     index.i_length = avi_pk.i_size;
@@ -1176,7 +1249,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1196,6 +1269,9 @@ static int Demux_Seekable( demux_t *p_demux )
         /* Set the track to use */
         tk = p_sys->track[i_track];
 
+        avi_entry_t entry;
+        avi_index_Get( &tk->idx, tk->i_idxposc, &entry );
+
         /* read thoses data */
         if( tk->i_samplesize )
         {
@@ -1213,13 +1289,12 @@ static int Demux_Seekable( demux_t *p_demux )
                     i_toread = __MAX( i_toread, 100 );
                 }
             }
-            i_size = __MIN( tk->idx.p_entry[tk->i_idxposc].i_length -
-                                tk->i_idxposb,
+            i_size = __MIN( entry.i_length - tk->i_idxposb,
                             (size_t) i_toread );
         }
         else
         {
-            i_size = tk->idx.p_entry[tk->i_idxposc].i_length;
+            i_size = entry.i_length;
         }
 
         if( tk->i_idxposb == 0 )
@@ -1237,7 +1312,7 @@ static int Demux_Seekable( demux_t *p_demux )
         }
 
         p_frame->i_pts = VLC_TICK_0 + AVI_GetPTS( tk );
-        if( tk->idx.p_entry[tk->i_idxposc].i_flags&AVIIF_KEYFRAME )
+        if( entry.i_flags&AVIIF_KEYFRAME )
         {
             p_frame->i_flags = BLOCK_FLAG_TYPE_I;
         }
@@ -1255,8 +1330,7 @@ static int Demux_Seekable( demux_t *p_demux )
             }
             toread[i_track].i_toread -= i_size;
             tk->i_idxposb += i_size;
-            if( tk->i_idxposb >=
-                    tk->idx.p_entry[tk->i_idxposc].i_length )
+            if( tk->i_idxposb >= entry.i_length )
             {
                 tk->i_idxposb = 0;
                 tk->i_idxposc++;
@@ -1264,7 +1338,7 @@ static int Demux_Seekable( demux_t *p_demux )
         }
         else
         {
-            int i_length = tk->idx.p_entry[tk->i_idxposc].i_length;
+            int i_length = entry.i_length;
 
             tk->i_idxposc++;
             if( tk->fmt.i_cat == AUDIO_ES )
@@ -1277,7 +1351,7 @@ static int Demux_Seekable( demux_t *p_demux )
         if( tk->i_idxposc < tk->idx.i_size)
         {
             toread[i_track].i_posf =
-                tk->idx.p_entry[tk->i_idxposc].i_pos;
+                avi_index_GetPos( &tk->idx, tk->i_idxposc );
             if( tk->i_idxposb > 0 )
             {
                 toread[i_track].i_posf += 8 + tk->i_idxposb;
@@ -1356,7 +1430,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
     {
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1373,18 +1447,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1411,7 +1485,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1522,8 +1596,8 @@ static int Seek( demux_t *p_demux, vlc_tick_t i_date, double f_ratio, bool b_acc
                 goto failandresetpos;
             }
 
-            while( i_pos >= p_stream->idx.p_entry[p_stream->i_idxposc].i_pos +
-               p_stream->idx.p_entry[p_stream->i_idxposc].i_length + 8 )
+            while( i_pos >= avi_index_GetPos( &p_stream->idx, p_stream->i_idxposc ) +
+               avi_index_GetLength( &p_stream->idx, p_stream->i_idxposc ) + 8 )
             {
                 /* search after i_idxposc */
                 if( AVI_StreamChunkSet( p_demux,
@@ -1631,6 +1705,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         case DEMUX_SET_POSITION:
             f = va_arg( args, double );
             b = va_arg( args, int );
+            AVI_IndexerJoin( p_demux, false );
             if ( !p_sys->b_seekable )
             {
                 return VLC_EGENERIC;
@@ -1651,6 +1726,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
             i64 = va_arg( args, vlc_tick_t );
             b = va_arg( args, int );
+            AVI_IndexerJoin( p_demux, false );
             if( !p_sys->b_seekable )
             {
                 return VLC_EGENERIC;
@@ -1788,13 +1864,13 @@ static vlc_tick_t AVI_GetPTS( avi_track_t *tk )
         if( idx >= tk->idx.i_size )
         {
             /* use the last entry */
-            idx = tk->idx.i_size - 1;
-            i_count = tk->idx.p_entry[idx].i_lengthtotal
-                    + tk->idx.p_entry[idx].i_length;
+            i_count = tk->idx.i_lengthtotal;
         }
         else
         {
-            i_count = tk->idx.p_entry[idx].i_lengthtotal;
+            avi_entry_t entry;
+            avi_index_Get( &tk->idx, idx, &entry );
+            i_count = entry.i_lengthtotal;
         }
         return AVI_GetDPTS( tk, i_count + tk->i_idxposb );
     }
@@ -1817,7 +1893,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
     {
         if (vlc_stream_Seek(p_demux->s, p_sys->i_movi_lastchunk_pos))
             return VLC_EGENERIC;
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1830,7 +1906,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1838,7 +1914,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1852,7 +1928,6 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
             /* add this chunk to the index */
             avi_entry_t index;
-            index.i_id     = avi_pk.i_fourcc;
             index.i_flags  = AVI_GetKeyFlag(tk_pk->fmt.i_codec, avi_pk.i_peek);
             index.i_pos    = avi_pk.i_pos;
             index.i_length = avi_pk.i_size;
@@ -1864,7 +1939,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1907,9 +1982,10 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
     demux_sys_t *p_sys = p_demux->p_sys;
     avi_track_t *p_stream = p_sys->track[i_stream];
 
+    avi_entry_t entry;
+
     if( ( p_stream->idx.i_size > 0 )
-        &&( i_byte < p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_lengthtotal +
-                p_stream->idx.p_entry[p_stream->idx.i_size - 1].i_length ) )
+        &&( i_byte < p_stream->idx.i_lengthtotal ) )
     {
         /* index is valid to find the ck */
         /* uses dichototmie to be fast enougth */
@@ -1918,15 +1994,15 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
         int i_idxmin  = 0;
         for( ;; )
         {
-            if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal > i_byte )
+            avi_index_Get( &p_stream->idx, i_idxposc, &entry );
+            if( entry.i_lengthtotal > i_byte )
             {
                 i_idxmax  = i_idxposc ;
                 i_idxposc = ( i_idxmin + i_idxposc ) / 2 ;
             }
             else
             {
-                if( p_stream->idx.p_entry[i_idxposc].i_lengthtotal +
-                        p_stream->idx.p_entry[i_idxposc].i_length <= i_byte)
+                if( entry.i_lengthtotal + entry.i_length <= i_byte)
                 {
                     i_idxmin  = i_idxposc ;
                     i_idxposc = (i_idxmax + i_idxposc ) / 2 ;
@@ -1934,8 +2010,7 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
                 else
                 {
                     p_stream->i_idxposc = i_idxposc;
-                    p_stream->i_idxposb = i_byte -
-                            p_stream->idx.p_entry[i_idxposc].i_lengthtotal;
+                    p_stream->i_idxposb = i_byte - entry.i_lengthtotal;
                     return VLC_SUCCESS;
                 }
             }
@@ -1953,12 +2028,11 @@ static int AVI_StreamBytesSet( demux_t    *p_demux,
             {
                 return VLC_EGENERIC;
             }
+            avi_index_Get( &p_stream->idx, p_stream->i_idxposc, &entry );
 
-        } while( p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal +
-                    p_stream->idx.p_entry[p_stream->i_idxposc].i_length <= i_byte );
+        } while( entry.i_lengthtotal + entry.i_length <= i_byte );
 
-        p_stream->i_idxposb = i_byte -
-                       p_stream->idx.p_entry[p_stream->i_idxposc].i_lengthtotal;
+        p_stream->i_idxposb = i_byte - entry.i_lengthtotal;
         return VLC_SUCCESS;
     }
 }
@@ -1992,7 +2066,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             {
                 if( tk->i_blocksize > 0 )
                 {
-                    tk->i_blockno += ( tk->idx.p_entry[i].i_length + tk->i_blocksize - 1 ) / tk->i_blocksize;
+                    tk->i_blockno += ( avi_index_GetLength( &tk->idx, i ) + tk->i_blocksize - 1 ) / tk->i_blocksize;
                 }
                 else
                 {
@@ -2013,8 +2087,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             //if( i_date < i_oldpts || 1 )
             {
                 while( p_stream->i_idxposc > 0 &&
-                   !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
-                                                                AVIIF_KEYFRAME ) )
+                   !avi_index_IsKeyframe( &p_stream->idx, p_stream->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
                                             i_stream,
@@ -2028,8 +2101,7 @@ static int AVI_TrackSeek( demux_t *p_demux,
             else
             {
                 while( p_stream->i_idxposc < p_stream->idx.i_size &&
-                        !( p_stream->idx.p_entry[p_stream->i_idxposc].i_flags &
-                                                                AVIIF_KEYFRAME ) )
+                        !avi_index_IsKeyframe( &p_stream->idx, p_stream->i_idxposc ) )
                 {
                     if( AVI_StreamChunkSet( p_demux,
                                             i_stream,
@@ -2161,17 +2233,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2188,12 +2260,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2218,7 +2290,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2226,7 +2298,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2234,11 +2306,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2263,14 +2335,136 @@ static int AVI_PacketSearch( demux_t *p_demux )
  ****************************************************************************/
 static void avi_index_Init( avi_index_t *p_index )
 {
-    p_index->i_size  = 0;
-    p_index->i_max   = 0;
-    p_index->p_entry = NULL;
+    p_index->i_size        = 0;
+    p_index->i_lengthtotal = 0;
+    p_index->i_pages       = 0;
+    p_index->i_pages_max   = 0;
+    p_index->i_page_last   = 0;
+    p_index->p_pages       = NULL;
 }
 static void avi_index_Clean( avi_index_t *p_index )
 {
-    free( p_index->p_entry );
+    for( unsigned i = 0; i < p_index->i_pages; i++ )
+        free( p_index->p_pages[i].p_entry );
+    free( p_index->p_pages );
+}
+
+static avi_index_page_t *avi_index_GetPage( avi_index_t *p_index, unsigned i )
+{
+    assert( i < p_index->i_size );
+
+    /* Entries are mostly read one after the other */
+    unsigned i_page = p_index->i_page_last;
+    for( unsigned j = 0; j < 2 && i_page < p_index->i_pages; j++, i_page++ )
+    {
+        avi_index_page_t *p_page = &p_index->p_pages[i_page];
+        if( i >= p_page->i_first && i - p_page->i_first < p_page->i_count )
+        {
+            p_index->i_page_last = i_page;
+            return p_page;
+        }
+    }
+
+    unsigned i_min = 0, i_max = p_index->i_pages;
+    while( i_max - i_min > 1 )
+    {
+        unsigned i_mid = ( i_min + i_max ) / 2;
+        if( p_index->p_pages[i_mid].i_first <= i )
+            i_min = i_mid;
+        else
+            i_max = i_mid;
+    }
+    p_index->i_page_last = i_min;
+    return &p_index->p_pages[i_min];
+}
+
+static void avi_index_Get( avi_index_t *p_index, unsigned i, avi_entry_t *p_entry )
+{
+    const avi_index_page_t *p_page = avi_index_GetPage( p_index, i );
+    const unsigned j = i - p_page->i_first;
+    uint32_t i_length;
+
+    if( p_page->p_entry )
+    {
+        const avi_index_entry_t *p_pentry = &p_page->p_entry[j];
+        i_length = p_pentry->i_length;
+        p_entry->i_pos = p_page->i_pos + p_pentry->i_offset;
+        p_entry->i_lengthtotal = p_page->i_lengthtotal + p_pentry->i_lengthtotal;
+    }
+    else
+    {
+        i_length = p_page->i_length;
+        p_entry->i_pos = p_page->i_pos + (uint64_t)j * p_page->i_stride;
+        p_entry->i_lengthtotal = p_page->i_lengthtotal +
+                                 (uint64_t)j * ( i_length & ~AVI_INDEX_KEYFRAME );
+    }
+    p_entry->i_flags  = ( i_length & AVI_INDEX_KEYFRAME ) ? AVIIF_KEYFRAME : 0;
+    p_entry->i_length = i_length & ~AVI_INDEX_KEYFRAME;
+}
+
+static void avi_index_SetKeyframes( avi_index_t *p_index )
+{
+    for( unsigned i = 0; i < p_index->i_pages; i++ )
+    {
+        avi_index_page_t *p_page = &p_index->p_pages[i];
+        if( p_page->p_entry )
+        {
+            for( unsigned j = 0; j < p_page->i_count; j++ )
+                p_page->p_entry[j].i_length |= AVI_INDEX_KEYFRAME;
+        }
+        else
+        {
+            p_page->i_length |= AVI_INDEX_KEYFRAME;
+        }
+    }
+}
+
+/* Stores the entries of a constant page, so that it can hold any entry */
+static int avi_index_PageExpand( avi_index_page_t *p_page )
+{
+    p_page->p_entry = vlc_alloc( AVI_INDEX_PAGE_ENTRIES, sizeof(*p_page->p_entry) );
+    if( !p_page->p_entry )
+        return VLC_ENOMEM;
+
+    const uint32_t i_length = p_page->i_length & ~AVI_INDEX_KEYFRAME;
+    for( unsigned j = 0; j < p_page->i_count; j++ )
+    {
+        p_page->p_entry[j].i_offset      = j * p_page->i_stride;
+        p_page->p_entry[j].i_length      = p_page->i_length;
+        p_page->p_entry[j].i_lengthtotal = j * i_length;
+    }
+    return VLC_SUCCESS;
+}
+
+static avi_index_page_t *avi_index_PageNew( avi_index_t *p_index )
+{
+    if( p_index->i_pages > 0 )
+    {
+        /* Give back the unused entries of the previous page */
+        avi_index_page_t *p_last = &p_index->p_pages[p_index->i_pages - 1];
+        if( p_last->p_entry && p_last->i_count < AVI_INDEX_PAGE_ENTRIES )
+        {
+            avi_index_entry_t *p_entry =
+                vlc_reallocarray( p_last->p_entry, p_last->i_count,
+                                  sizeof(*p_last->p_entry) );
+            if( p_entry )
+                p_last->p_entry = p_entry;
+        }
+    }
+
+    if( p_index->i_pages >= p_index->i_pages_max )
+    {
+        unsigned i_max = p_index->i_pages_max + 64;
+        avi_index_page_t *p_pages =
+            vlc_reallocarray( p_index->p_pages, i_max, sizeof(*p_pages) );
+        if( !p_pages )
+            return NULL;
+        p_index->p_pages     = p_pages;
+        p_index->i_pages_max = i_max;
+    }
+    return &p_index->p_pages[p_index->i_pages++];
 }
+
 static void avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
                               avi_entry_t *p_entry )
 {
@@ -2278,28 +2472,63 @@ static void avi_index_Append( avi_index_t *p_index, uint64_t *pi_last_pos,
     if( *pi_last_pos < p_entry->i_pos )
          *pi_last_pos = p_entry->i_pos;
 
-    /* add the entry */
-    if( p_index->i_size >= p_index->i_max )
+    /* calculate cumulate length */
+    p_entry->i_lengthtotal = p_index->i_lengthtotal;
+
+    const uint32_t i_length = __MIN( p_entry->i_length, ~AVI_INDEX_KEYFRAME ) |
+        ( ( p_entry->i_flags & AVIIF_KEYFRAME ) ? AVI_INDEX_KEYFRAME : 0 );
+
+    /* add the entry to the last page if it can be coded there */
+    avi_index_page_t *p_page = NULL;
+    if( p_index->i_pages > 0 )
+    {
+        p_page = &p_index->p_pages[p_index->i_pages - 1];
+        if( p_page->i_count >= AVI_INDEX_PAGE_ENTRIES ||
+            p_entry->i_pos < p_page->i_pos ||
+            p_entry->i_pos - p_page->i_pos > UINT32_MAX ||
+            p_entry->i_lengthtotal - p_page->i_lengthtotal > UINT32_MAX )
+            p_page = NULL;
+    }
+
+    if( p_page == NULL )
     {
-        p_index->i_max += 16384;
-        p_index->p_entry = realloc_or_free( p_index->p_entry,
-                                            p_index->i_max * sizeof( *p_index->p_entry ) );
-        if( !p_index->p_entry )
+        p_page = avi_index_PageNew( p_index );
+        if( !p_page )
             return;
+        p_page->i_first       = p_index->i_size;
+        p_page->i_count       = 0;
+        p_page->i_pos         = p_entry->i_pos;
+        p_page->i_lengthtotal = p_entry->i_lengthtotal;
+        p_page->i_stride      = 0;
+        p_page->i_length      = i_length;
+        p_page->p_entry       = NULL;
     }
-    /* calculate cumulate length */
-    if( p_index->i_size > 0 )
+
+    const uint32_t i_offset = p_entry->i_pos - p_page->i_pos;
+    if( !p_page->p_entry )
     {
-        p_entry->i_lengthtotal =
-            p_index->p_entry[p_index->i_size - 1].i_length +
-                p_index->p_entry[p_index->i_size - 1].i_lengthtotal;
+        if( p_page->i_count == 1 && i_length == p_page->i_length )
+            p_page->i_stride = i_offset;
+
+        if( i_length != p_page->i_length ||
+            i_offset != (uint64_t)p_page->i_count * p_page->i_stride )
+        {
+            if( avi_index_PageExpand( p_page ) )
+                return;
+        }
     }
-    else
+
+    if( p_page->p_entry )
     {
-        p_entry->i_lengthtotal = 0;
+        avi_index_entry_t *p_pentry = &p_page->p_entry[p_page->i_count];
+        p_pentry->i_offset      = i_offset;
+        p_pentry->i_length      = i_length;
+        p_pentry->i_lengthtotal = p_entry->i_lengthtotal - p_page->i_lengthtotal;
     }
+    p_page->i_count++;
 
-    p_index->p_entry[p_index->i_size++] = *p_entry;
+    p_index->i_size++;
+    p_index->i_lengthtotal += i_length & ~AVI_INDEX_KEYFRAME;
 }
 
 static int AVI_IndexFind_idx1( demux_t *p_demux,
@@ -2391,7 +2620,6 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
             (i_cat == p_sys->track[i_stream]->fmt.i_cat || i_cat == UNKNOWN_ES ) )
         {
             avi_entry_t index;
-            index.i_id     = p_idx1->entry[i_index].i_fourcc;
             index.i_flags  = p_idx1->entry[i_index].i_flags&(~AVIIF_FIXKEYFRAME);
             index.i_pos    = p_idx1->entry[i_index].i_pos + i_offset;
             index.i_length = p_idx1->entry[i_index].i_length;
@@ -2406,18 +2634,20 @@ static int AVI_IndexLoad_idx1( demux_t *p_demux,
     {
         for( unsigned i = 0; i < p_index[i_index].i_size; i++ )
         {
+            avi_entry_t entry;
             vlc_tick_t i_length;
+            avi_index_Get( &p_index[i_index], i, &entry );
             if( p_sys->track[i_index]->i_samplesize )
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index],
-                                        p_index[i_index].p_entry[i].i_lengthtotal );
+                                        entry.i_lengthtotal );
             }
             else
             {
                 i_length = AVI_GetDPTS( p_sys->track[i_index], i );
             }
             msg_Dbg( p_demux, "index stream %d @%ld time %ld", i_index,
-                     p_index[i_index].p_entry[i].i_pos, i_length );
+                     entry.i_pos, i_length );
         }
     }
 #endif
@@ -2437,7 +2667,6 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.std[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.std[i].i_offset - 8;
             index.i_length = p_indx->idx.std[i].i_size&0x7fffffff;
@@ -2450,7 +2679,6 @@ static void __Parse_indx( demux_t *p_demux, avi_index_t *p_index, uint64_t *pi_m
     {
         for( unsigned i = 0; i < p_indx->i_entriesinuse; i++ )
         {
-            index.i_id     = p_indx->i_id;
             index.i_flags  = p_indx->idx.field[i].i_size & 0x80000000 ? 0 : AVIIF_KEYFRAME;
             index.i_pos    = p_indx->i_baseoffset + p_indx->idx.field[i].i_offset - 8;
             index.i_length = p_indx->idx.field[i].i_size;
@@ -2568,12 +2796,11 @@ static void AVI_IndexLoad( demux_t *p_demux )
         /* Fix key flag */
         bool b_key = false;
         for( unsigned j = 0; !b_key && j < p_index->i_size; j++ )
-            b_key = p_index->p_entry[j].i_flags & AVIIF_KEYFRAME;
+            b_key = avi_index_IsKeyframe( p_index, j );
         if( !b_key )
         {
             msg_Err( p_demux, "no key frame set for track %u", i );
-            for( unsigned j = 0; j < p_index->i_size; j++ )
-                p_index->p_entry[j].i_flags |= AVIIF_KEYFRAME;
+            avi_index_SetKeyframes( p_index );
         }
 
         /* */
@@ -2582,7 +2809,11 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* Builds the index from the chunks found in s, which can be another
+ * stream than the demuxer one */
+static int AVI_IndexScan( demux_t *p_demux, stream_t *s,
+                          avi_index_t p_index[], uint64_t *pi_last_pos,
+                          bool b_progress )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
@@ -2597,26 +2828,26 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0, true );
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0, true );
+    if( !p_movi )
+        p_movi = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_movi, 0, true );
 
     if( !p_movi )
     {
         msg_Err( p_demux, "cannot find p_movi" );
-        return;
+        return VLC_EGENERIC;
     }
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
-
     i_movi_end = __MIN( (uint32_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
+                        stream_Size( s ) );
 
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
+    if( vlc_stream_Seek( s, p_movi->i_chunk_pos + 12 ) )
+        return VLC_EGENERIC;
     msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
 
 
     /* Only show dialog if AVI is > 10MB */
     i_dialog_update = vlc_tick_now();
-    if( stream_Size( p_demux->s ) > 10000000 )
+    if( b_progress && stream_Size( s ) > 10000000 )
     {
         p_dialog_id =
             vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
@@ -2628,21 +2859,24 @@ static void AVI_IndexCreate( demux_t *p_demux )
     {
         avi_packet_t pk;
 
+        if( vlc_killed() )
+            break;
+
         /* Don't update/check dialog too often */
         if( p_dialog_id != NULL && vlc_tick_now() - i_dialog_update > VLC_TICK_FROM_MS(100) )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
                 break;
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
+            double f_current = vlc_stream_Tell( s );
+            double f_size    = stream_Size( s );
             double f_pos     = f_current / f_size;
             vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
 
             i_dialog_update = vlc_tick_now();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2651,12 +2885,11 @@ static void AVI_IndexCreate( demux_t *p_demux )
             avi_track_t *tk = p_sys->track[pk.i_stream];
 
             avi_entry_t index;
-            index.i_id      = pk.i_fourcc;
             index.i_flags   = AVI_GetKeyFlag(tk->fmt.i_codec, pk.i_peek);
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+            avi_index_Append( &p_index[pk.i_stream], pi_last_pos, &index );
         }
         else
         {
@@ -2670,7 +2903,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
                                             AVIFOURCC_RIFF, 1, true );
 
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( !p_sysx || vlc_stream_Seek( p_demux->s,
+                    if( !p_sysx || vlc_stream_Seek( s,
                                          p_sysx->i_chunk_pos + 24 ) )
                         goto print_stat;
                     break;
@@ -2687,7 +2920,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
                     goto print_stat;
@@ -2696,7 +2929,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
         }
 
         if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+            AVI_PacketNext( s ) )
         {
             break;
         }
@@ -2709,8 +2942,158 @@ print_stat:
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
     {
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
+                i_stream, p_index[i_stream].i_size );
+    }
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    assert( p_sys->i_track <= 100 );
+    avi_index_t p_index[p_sys->i_track];
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_index[i] );
+
+    if( AVI_IndexScan( p_demux, p_demux->s, p_index,
+                       &p_sys->i_movi_lastchunk_pos, true ) )
+        return;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        p_sys->track[i]->idx = p_index[i];
+    }
+    /* don't replace it by the file indexes when seeking */
+    p_sys->b_indexloaded = true;
+}
+
+/*****************************************************************************
+ * Background index creation: playback goes on with the current index
+ *****************************************************************************/
+static void *AVI_IndexerThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    vlc_interrupt_set( p_sys->indexer.p_interrupt );
+
+    stream_t *s = vlc_stream_NewURL( p_demux, p_demux->psz_url );
+    if( s )
+    {
+        const vlc_tick_t i_start = vlc_tick_now();
+        if( AVI_IndexScan( p_demux, s, p_sys->indexer.p_index,
+                           &p_sys->indexer.i_last_pos, false ) == VLC_SUCCESS &&
+            !vlc_killed() )
+        {
+            msg_Dbg( p_demux, "index created in %"PRId64" ms",
+                     MS_FROM_VLC_TICK(vlc_tick_now() - i_start) );
+            p_sys->indexer.b_success = true;
+        }
+        vlc_stream_Delete( s );
+    }
+
+    atomic_store( &p_sys->indexer.b_done, true );
+    return NULL;
+}
+
+static int AVI_IndexerStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_demux->psz_url || !*p_demux->psz_url )
+        return VLC_EGENERIC;
+
+    p_sys->indexer.p_index = vlc_alloc( p_sys->i_track,
+                                        sizeof(*p_sys->indexer.p_index) );
+    if( !p_sys->indexer.p_index )
+        return VLC_ENOMEM;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_sys->indexer.p_index[i] );
+
+    p_sys->indexer.p_interrupt = vlc_interrupt_create();
+    if( unlikely(p_sys->indexer.p_interrupt == NULL) )
+    {
+        free( p_sys->indexer.p_index );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->indexer.i_last_pos = p_sys->i_movi_lastchunk_pos;
+    p_sys->indexer.b_success = false;
+    atomic_init( &p_sys->indexer.b_done, false );
+
+    if( vlc_clone( &p_sys->indexer.thread, AVI_IndexerThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_interrupt_destroy( p_sys->indexer.p_interrupt );
+        free( p_sys->indexer.p_index );
+        return VLC_EGENERIC;
+    }
+    p_sys->indexer.b_running = true;
+    return VLC_SUCCESS;
+}
+
+/* Moves the track to the same chunk in the new index, chunks being sorted
+ * by position */
+static void AVI_TrackSetIndex( avi_track_t *tk, avi_index_t *p_index )
+{
+    uint64_t i_pos = 0;
+    if( tk->i_idxposc < tk->idx.i_size )
+        i_pos = avi_index_GetPos( &tk->idx, tk->i_idxposc );
+    else if( tk->idx.i_size > 0 )
+        i_pos = avi_index_GetPos( &tk->idx, tk->idx.i_size - 1 ) + 1;
+
+    unsigned i_min = 0, i_max = p_index->i_size;
+    while( i_min < i_max )
+    {
+        unsigned i_mid = ( i_min + i_max ) / 2;
+        if( avi_index_GetPos( p_index, i_mid ) < i_pos )
+            i_min = i_mid + 1;
+        else
+            i_max = i_mid;
+    }
+
+    if( i_min >= p_index->i_size || avi_index_GetPos( p_index, i_min ) != i_pos )
+        tk->i_idxposb = 0;
+    if( i_min != tk->i_idxposc )
+        tk->i_next_block_flags |= BLOCK_FLAG_DISCONTINUITY;
+    tk->i_idxposc = i_min;
+
+    avi_index_Clean( &tk->idx );
+    tk->idx = *p_index;
+}
+
+/* Waits for the background index, and uses it unless aborting */
+static void AVI_IndexerJoin( demux_t *p_demux, bool b_abort )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->indexer.b_running )
+        return;
+
+    if( b_abort )
+        vlc_interrupt_kill( p_sys->indexer.p_interrupt );
+    vlc_join( p_sys->indexer.thread, NULL );
+    vlc_interrupt_destroy( p_sys->indexer.p_interrupt );
+    p_sys->indexer.b_running = false;
+
+    if( !b_abort && p_sys->indexer.b_success )
+    {
+        msg_Dbg( p_demux, "using the created index" );
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            AVI_TrackSetIndex( p_sys->track[i], &p_sys->indexer.p_index[i] );
+        p_sys->i_movi_lastchunk_pos = __MAX( p_sys->i_movi_lastchunk_pos,
+                                             p_sys->indexer.i_last_pos );
+        p_sys->i_length = AVI_MovieGetLength( p_demux );
+        p_sys->b_indexloaded = true;
+    }
+    else
+    {
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            avi_index_Clean( &p_sys->indexer.p_index[i] );
     }
+    free( p_sys->indexer.p_index );
 }
 
 /* */
@@ -3000,16 +3383,14 @@ static vlc_tick_t  AVI_MovieGetLength( demux_t *p_demux )
         vlc_tick_t i_length;
 
         /* fix length for each stream */
-        if( tk->idx.i_size < 1 || !tk->idx.p_entry )
+        if( tk->idx.i_size < 1 )
         {
             continue;
         }
 
         if( tk->i_samplesize )
         {
-            i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
+            i_length = AVI_GetDPTS( tk, tk->idx.i_lengthtotal );
         }
         else
         {
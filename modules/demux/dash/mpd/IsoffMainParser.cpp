@@ -98,6 +98,7 @@ MPD * IsoffMainParser::parse()
     {
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
+        parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription"), mpd);
         parseMPDBaseUrl(mpd, root);
         parsePeriods(mpd, root);
         mpd->debug();
@@ -107,51 +108,38 @@ MPD * IsoffMainParser::parse()
 
 void    IsoffMainParser::parseMPDAttributes   (MPD *mpd, xml::Node *node)
 {
-    const std::map<std::string, std::string> & attr = node->getAttributes();
+    if(node->hasAttribute("mediaPresentationDuration"))
+        mpd->duration.Set(IsoTime(node->getAttributeValue("mediaPresentationDuration")));
 
-    std::map<std::string, std::string>::const_iterator it;
+    if(node->hasAttribute("minBufferTime"))
+        mpd->setMinBuffering(IsoTime(node->getAttributeValue("minBufferTime")));
 
-    it = attr.find("mediaPresentationDuration");
-    if(it != attr.end())
-        mpd->duration.Set(IsoTime(it->second));
-
-    it = attr.find("minBufferTime");
-    if(it != attr.end())
-        mpd->setMinBuffering(IsoTime(it->second));
-
-    it = attr.find("minimumUpdatePeriod");
-    if(it != attr.end())
+    if(node->hasAttribute("minimumUpdatePeriod"))
     {
         mpd->b_needsUpdates = true;
-        vlc_tick_t minupdate = IsoTime(it->second);
+        vlc_tick_t minupdate = IsoTime(node->getAttributeValue("minimumUpdatePeriod"));
         if(minupdate > 0)
             mpd->minUpdatePeriod.Set(minupdate);
     }
     else mpd->b_needsUpdates = false;
 
-    it = attr.find("maxSegmentDuration");
-    if(it != attr.end())
-        mpd->maxSegmentDuration.Set(IsoTime(it->second));
+    if(node->hasAttribute("maxSegmentDuration"))
+        mpd->maxSegmentDuration.Set(IsoTime(node->getAttributeValue("maxSegmentDuration")));
 
-    it = attr.find("type");
-    if(it != attr.end())
-        mpd->setType(it->second);
+    if(node->hasAttribute("type"))
+        mpd->setType(node->getAttributeValue("type"));
 
-    it = attr.find("availabilityStartTime");
-    if(it != attr.end())
-        mpd->availabilityStartTime.Set(UTCTime(it->second).mtime());
+    if(node->hasAttribute("availabilityStartTime"))
+        mpd->availabilityStartTime.Set(UTCTime(node->getAttributeValue("availabilityStartTime")).mtime());
 
-    it = attr.find("availabilityEndTime");
-    if(it != attr.end())
-        mpd->availabilityEndTime.Set(UTCTime(it->second).mtime());
+    if(node->hasAttribute("availabilityEndTime"))
+        mpd->availabilityEndTime.Set(UTCTime(node->getAttributeValue("availabilityEndTime")).mtime());
 
-    it = attr.find("timeShiftBufferDepth");
-        if(it != attr.end())
-            mpd->timeShiftBufferDepth.Set(IsoTime(it->second));
+    if(node->hasAttribute("timeShiftBufferDepth"))
+        mpd->timeShiftBufferDepth.Set(IsoTime(node->getAttributeValue("timeShiftBufferDepth")));
 
-    it = attr.find("suggestedPresentationDelay");
-    if(it != attr.end())
-        mpd->suggestedPresentationDelay.Set(IsoTime(it->second));
+    if(node->hasAttribute("suggestedPresentationDelay"))
+        mpd->suggestedPresentationDelay.Set(IsoTime(node->getAttributeValue("suggestedPresentationDelay")));
 }
 
 void IsoffMainParser::parsePeriods(MPD *mpd, Node *root)
@@ -494,7 +482,7 @@ void IsoffMainParser::parseTimeline(Node *node, MediaSegmentTemplate *templ)
     SegmentTimeline *timeline = new (std::nothrow) SegmentTimeline(templ);
     if(timeline)
     {
-        std::vector<Node *> elements = DOMHelper::getElementByTagName(node, "S", false);
+        std::vector<Node *> elements = DOMHelper::getChildElementByTagName(node, "S");
         std::vector<Node *>::const_iterator it;
         for(it = elements.begin(); it != elements.end(); ++it)
         {
@@ -550,6 +538,24 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node * node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    /* Latency values are in milliseconds */
+    Node *latency = DOMHelper::getFirstChildElementByName(node, "Latency");
+    if(latency)
+    {
+        if(latency->hasAttribute("target"))
+            mpd->targetLatency.Set(VLC_TICK_FROM_MS(
+                Integer<int64_t>(latency->getAttributeValue("target"))));
+        if(latency->hasAttribute("max"))
+            mpd->maxLatency.Set(VLC_TICK_FROM_MS(
+                Integer<int64_t>(latency->getAttributeValue("max"))));
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Unknown);
@@ -29,21 +29,36 @@
 #include <vlc_input_item.h>
 #include <vlc_plugin.h>
 
+/* Number of items posted at once when the directory supports partial reads,
+ * so that large playlists are inserted while they are being read */
+#define DIRECTORY_BATCH 1000
+
 static int Demux( demux_t *p_demux )
 {
     input_item_node_t *p_node = input_item_node_Create( p_demux->p_input_item );
+    if( unlikely(p_node == NULL) )
+        return VLC_DEMUXER_EGENERIC;
 
-    if( vlc_stream_ReadDir( p_demux->s, p_node ) )
+    bool *pb_started = p_demux->p_sys;
+    int ret = vlc_stream_ReadDirBatch( p_demux->s, p_node, DIRECTORY_BATCH );
+    if( ret < 0 )
     {
         msg_Warn( p_demux, "unable to read directory" );
-        input_item_node_Delete( p_node );
-        return VLC_EGENERIC;
+        if( !*pb_started )
+        {
+            input_item_node_Delete( p_node );
+            return VLC_DEMUXER_EGENERIC;
+        }
+        /* terminate the subtrees posted so far */
+        ret = VLC_SUCCESS;
     }
 
+    *pb_started = true;
+    p_node->b_partial = ret > 0;
     if (es_out_Control(p_demux->out, ES_OUT_POST_SUBNODE, p_node))
         input_item_node_Delete(p_node);
 
-    return VLC_SUCCESS;
+    return ret > 0 ? VLC_DEMUXER_SUCCESS : VLC_DEMUXER_EOF;
 }
 
 static int Control(demux_t *demux, int query, va_list args)
@@ -79,6 +94,12 @@ static int Import_Dir( vlc_object_t *p_this )
     if( p_demux->p_input_item == NULL )
         return VLC_ETIMEOUT;
 
+    bool *pb_started = vlc_obj_malloc( p_this, sizeof (*pb_started) );
+    if( unlikely(pb_started == NULL) )
+        return VLC_ENOMEM;
+    *pb_started = false;
+
+    p_demux->p_sys = pb_started;
     p_demux->pf_demux = Demux;
     p_demux->pf_control = Control;
 
@@ -39,10 +39,14 @@ namespace hls
                 HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
                 virtual ~HLSSegment();
                 vlc_tick_t getUTCTime() const;
+                uint64_t getMediaSequence() const;
+                unsigned getPartIndex() const;
                 virtual int compare(ISegment *) const; /* reimpl */
 
             protected:
                 vlc_tick_t utcTime;
+                uint64_t mediaSequence; /* parent segment's, for parts */
+                unsigned partIndex;
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *); /* reimpl */
         };
@@ -159,7 +159,7 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, rep->getUpdateUrl().toString());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -218,6 +218,11 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
 
     rep->setTimescale(100);
+
+    /* Parts numbering can only be chosen once, updates must keep it */
+    if(!rep->b_loaded)
+        rep->b_lowLatency = std::any_of(tagslist.cbegin(), tagslist.cend(),
+                                        [](auto t) {return t->getType() == AttributesTag::EXTXPARTINF;});
     rep->b_loaded = true;
 
     vlc_tick_t totalduration = 0;
@@ -229,6 +234,77 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     const SingleValueTag *ctx_byterange = NULL;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
+    std::list<const AttributesTag *> ctx_parts;
+    const AttributesTag *ctx_preloadhint = NULL;
+
+    auto addSegment = [&](const std::string &uri, uint64_t msn, unsigned part,
+                          double duration, bool b_hasrange,
+                          std::pair<std::size_t,std::size_t> range) -> HLSSegment *
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, rep->getSegmentNumber(msn, part));
+        if(!segment)
+            return NULL;
+
+        segment->mediaSequence = msn;
+        segment->partIndex = part;
+        segment->setSourceUrl(uri);
+
+        const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
+        segment->duration.Set(duration * (uint64_t) rep->getTimescale());
+        segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
+        nzStartTime += nzDuration;
+        totalduration += nzDuration;
+        if(absReferenceTime != VLC_TICK_INVALID)
+        {
+            segment->utcTime = absReferenceTime;
+            absReferenceTime += nzDuration;
+        }
+
+        segmentList->addSegment(segment);
+
+        if(b_hasrange)
+        {
+            if(range.first == 0) /* first == offset, second = size */
+                range.first = prevbyterangeoffset;
+            prevbyterangeoffset = range.first + range.second;
+            segment->setByteRange(range.first, prevbyterangeoffset - 1);
+        }
+
+        if(discontinuity)
+        {
+            segment->discontinuity = true;
+            discontinuity = false;
+        }
+
+        if(encryption.method != CommonEncryption::Method::NONE)
+            segment->setEncryption(encryption);
+
+        return segment;
+    };
+
+    /* Parts of the segment with that msn, listed before its URI
+     * or ahead of it when it is not complete yet */
+    auto addParts = [&](uint64_t msn)
+    {
+        unsigned part = 0;
+        for(const AttributesTag *parttag : ctx_parts)
+        {
+            const Attribute *uriAttr = parttag->getAttributeByName("URI");
+            const Attribute *durAttr = parttag->getAttributeByName("DURATION");
+            const Attribute *rangeAttr = parttag->getAttributeByName("BYTERANGE");
+            const Attribute *gapAttr = parttag->getAttributeByName("GAP");
+            const unsigned index = part++;
+            if(!uriAttr || !durAttr || index >= Representation::PARTS_MAX ||
+               (gapAttr && gapAttr->value == "YES"))
+                continue;
+            std::pair<std::size_t,std::size_t> range;
+            if(rangeAttr)
+                range = rangeAttr->unescapeQuotes().getByteRange();
+            addSegment(uriAttr->quotedString(), msn, index,
+                       durAttr->floatingPoint(), !!rangeAttr, range);
+        }
+        return part;
+    };
 
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
@@ -259,12 +335,6 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                     break;
                 }
 
-                HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber++);
-                if(!segment)
-                    break;
-
-                segment->setSourceUrl(uritag->getValue().value);
-
                 /* Need to use EXTXTARGETDURATION as default as some can't properly set segment one */
                 double duration = rep->targetDuration;
                 if(ctx_extinf)
@@ -274,37 +344,40 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
                         duration = durAttribute->floatingPoint();
                     ctx_extinf = NULL;
                 }
-                const vlc_tick_t nzDuration = vlc_tick_from_sec( duration );
-                segment->duration.Set(duration * (uint64_t) rep->getTimescale());
-                segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
-                nzStartTime += nzDuration;
-                totalduration += nzDuration;
-                if(absReferenceTime != VLC_TICK_INVALID)
-                {
-                    segment->utcTime = absReferenceTime;
-                    absReferenceTime += nzDuration;
-                }
 
-                segmentList->addSegment(segment);
-
-                if(ctx_byterange)
-                {
-                    std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
-                    if(range.first == 0) /* first == size, second = offset */
-                        range.first = prevbyterangeoffset;
-                    prevbyterangeoffset = range.first + range.second;
-                    segment->setByteRange(range.first, prevbyterangeoffset - 1);
-                    ctx_byterange = NULL;
-                }
+                const uint64_t msn = sequenceNumber++;
 
-                if(discontinuity)
+                /* Prefer listed parts, as some could have been published
+                 * since the previous reload and never retrieved */
+                if(!ctx_parts.empty())
                 {
-                    segment->discontinuity = true;
-                    discontinuity = false;
+                    const vlc_tick_t nzPartsStart = nzStartTime;
+                    const vlc_tick_t absPartsStart = absReferenceTime;
+                    const std::size_t partsbyterangeoffset = prevbyterangeoffset;
+                    addParts(msn);
+                    ctx_parts.clear();
+                    /* stay in sync with the whole segments timeline */
+                    nzStartTime = nzPartsStart + vlc_tick_from_sec( duration );
+                    if(absPartsStart != VLC_TICK_INVALID)
+                        absReferenceTime = absPartsStart + vlc_tick_from_sec( duration );
+                    prevbyterangeoffset = partsbyterangeoffset;
+                    if(ctx_byterange)
+                    {
+                        std::pair<std::size_t,std::size_t> range = ctx_byterange->getValue().getByteRange();
+                        if(range.first == 0)
+                            range.first = prevbyterangeoffset;
+                        prevbyterangeoffset = range.first + range.second;
+                        ctx_byterange = NULL;
+                    }
+                    break;
                 }
 
-                if(encryption.method != CommonEncryption::Method::NONE)
-                    segment->setEncryption(encryption);
+                std::pair<std::size_t,std::size_t> range;
+                if(ctx_byterange)
+                    range = ctx_byterange->getValue().getByteRange();
+                addSegment(uritag->getValue().value, msn, 0, duration,
+                           ctx_byterange != NULL, range);
+                ctx_byterange = NULL;
             }
             break;
 
@@ -354,6 +427,54 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
             }
             break;
 
+            case AttributesTag::EXTXPART:
+                if(rep->b_lowLatency)
+                    ctx_parts.push_back(static_cast<const AttributesTag *>(tag));
+                break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+            {
+                const AttributesTag *hinttag = static_cast<const AttributesTag *>(tag);
+                const Attribute *typeAttr = hinttag->getAttributeByName("TYPE");
+                if(rep->b_lowLatency && typeAttr && typeAttr->value == "PART")
+                    ctx_preloadhint = hinttag;
+            }
+            break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *targetAttr = static_cast<const AttributesTag *>(tag)
+                                              ->getAttributeByName("PART-TARGET");
+                if(targetAttr)
+                    rep->partTargetDuration = vlc_tick_from_sec(targetAttr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *ctrltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *blockAttr = ctrltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                const Attribute *skipAttr = ctrltag->getAttributeByName("CAN-SKIP-UNTIL");
+                rep->b_canBlockReload = (blockAttr && blockAttr->value == "YES");
+                rep->canSkipUntil = skipAttr ? vlc_tick_from_sec(skipAttr->floatingPoint()) : 0;
+                /* Server recommended distance to the live edge */
+                const Attribute *holdAttr = ctrltag->getAttributeByName(rep->b_lowLatency ? "PART-HOLD-BACK"
+                                                                                          : "HOLD-BACK");
+                if(holdAttr)
+                    rep->getPlaylist()->targetLatency.Set(vlc_tick_from_sec(holdAttr->floatingPoint()));
+            }
+            break;
+
+            case AttributesTag::EXTXSKIP:
+            {
+                /* Delta update, the oldest segments were left out */
+                const Attribute *skippedAttr = static_cast<const AttributesTag *>(tag)
+                                               ->getAttributeByName("SKIPPED-SEGMENTS");
+                if(skippedAttr)
+                    sequenceNumber += skippedAttr->decimal();
+            }
+            break;
+
             case Tag::EXTXDISCONTINUITY:
                 discontinuity  = true;
                 break;
@@ -364,6 +485,31 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    /* Parts of the incomplete segment at the live edge, and the part the
+     * server announced, which will be retrieved as soon as published */
+    unsigned nextpart = 0;
+    if(!ctx_parts.empty() || ctx_preloadhint)
+    {
+        nextpart = addParts(sequenceNumber);
+        if(ctx_preloadhint && nextpart < Representation::PARTS_MAX)
+        {
+            const Attribute *uriAttr = ctx_preloadhint->getAttributeByName("URI");
+            const Attribute *startAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-START");
+            const Attribute *lengthAttr = ctx_preloadhint->getAttributeByName("BYTERANGE-LENGTH");
+            if(uriAttr && (!startAttr || lengthAttr))
+            {
+                std::pair<std::size_t,std::size_t> range;
+                if(startAttr)
+                    range = std::make_pair(startAttr->decimal(), lengthAttr->decimal());
+                const double duration = secf_from_vlc_tick(rep->partTargetDuration);
+                addSegment(uriAttr->quotedString(), sequenceNumber, nextpart,
+                           duration, startAttr != NULL, range);
+            }
+        }
+    }
+    rep->nextMSN = sequenceNumber;
+    rep->nextPart = nextpart;
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -33,6 +33,7 @@
 #include "../../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
@@ -46,6 +47,13 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
     nextUpdateTime = 0;
     targetDuration = 0;
     streamFormat = StreamFormat::UNKNOWN;
+    b_lowLatency = false;
+    b_canBlockReload = false;
+    partTargetDuration = 0;
+    canSkipUntil = 0;
+    nextMSN = 0;
+    nextPart = 0;
+    nextBlockingUpdate = 0;
 }
 
 Representation::~Representation ()
@@ -87,6 +95,50 @@ Url Representation::getPlaylistUrl() const
     }
 }
 
+Url Representation::getUpdateUrl() const
+{
+    Url url = getPlaylistUrl();
+    if(!b_loaded || !b_canBlockReload || !isLive())
+        return url;
+
+    /* Blocking playlist reload, server holds the request until that part
+     * or segment is available */
+    std::string str = url.toString();
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << str << ((str.find('?') == std::string::npos) ? '?' : '&')
+       << "_HLS_msn=" << nextMSN;
+    if(b_lowLatency)
+        os << "&_HLS_part=" << nextPart;
+    /* Delta update, we already have the oldest segments */
+    if(canSkipUntil > 0)
+        os << "&_HLS_skip=YES";
+    return Url(os.str());
+}
+
+uint64_t Representation::getSegmentNumber(uint64_t msn, unsigned part) const
+{
+    return b_lowLatency ? msn * PARTS_MAX + part : msn;
+}
+
+ISegment * Representation::getNextSegment(SegmentInfoType type, uint64_t i_pos,
+                                          uint64_t *pi_newpos, bool *pb_gap) const
+{
+    ISegment *seg = BaseRepresentation::getNextSegment(type, i_pos, pi_newpos, pb_gap);
+    if(seg && *pb_gap && b_lowLatency && i_pos > 0)
+    {
+        /* Parts numbering leaves holes between parent segments, which
+         * are not missing media */
+        const HLSSegment *hlsSeg = dynamic_cast<HLSSegment *>(seg);
+        const HLSSegment *prevSeg =
+                dynamic_cast<HLSSegment *>(getSegment(type, i_pos - 1));
+        if(hlsSeg && prevSeg && hlsSeg->getPartIndex() == 0 &&
+           hlsSeg->getMediaSequence() == prevSeg->getMediaSequence() + 1)
+            *pb_gap = false;
+    }
+    return seg;
+}
+
 void Representation::debug(vlc_object_t *obj, int indent) const
 {
     BaseRepresentation::debug(obj, indent);
@@ -126,22 +178,41 @@ void Representation::scheduleNextUpdate(uint64_t number)
 
     nextUpdateTime = now + SEC_FROM_VLC_TICK(minbuffer);
 
-    msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "s",
-            getID().str().c_str(), (int64_t) nextUpdateTime - now);
+    if(b_canBlockReload)
+    {
+        /* The server holds the reload until new media, so reload right away,
+         * with a guard against servers returning early */
+        vlc_tick_t guard = b_lowLatency && partTargetDuration
+                         ? partTargetDuration / 2 : VLC_TICK_FROM_MS(500);
+        nextBlockingUpdate = vlc_tick_now() + guard;
+        msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next blocking "
+                "update for msn %" PRIu64 " part %u", getID().str().c_str(), nextMSN, nextPart);
+    }
+    else
+    {
+        msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "s",
+                getID().str().c_str(), (int64_t) nextUpdateTime - now);
+    }
 
     debug(playlist->getVLCObject(), 0);
 }
 
+bool Representation::updateDue() const
+{
+    if(b_canBlockReload)
+        return vlc_tick_now() >= nextBlockingUpdate;
+    return nextUpdateTime < time(NULL);
+}
+
 bool Representation::needsUpdate() const
 {
-    return !b_failed && (!b_loaded || (isLive() && nextUpdateTime < time(NULL)));
+    return !b_failed && (!b_loaded || (isLive() && updateDue()));
 }
 
 bool Representation::runLocalUpdates(SharedResources *res)
 {
-    const time_t now = time(NULL);
     AbstractPlaylist *playlist = getPlaylist();
-    if(!b_loaded || (isLive() && nextUpdateTime < now))
+    if(!b_loaded || (isLive() && updateDue()))
     {
         M3U8Parser parser(res);
         if(!parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this))
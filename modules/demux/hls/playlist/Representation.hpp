@@ -52,8 +52,17 @@ namespace hls
                 virtual void debug(vlc_object_t *, int) const;  /* reimpl */
                 virtual bool runLocalUpdates(SharedResources *); /* reimpl */
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const; /* reimpl */
+                virtual ISegment * getNextSegment(SegmentInfoType, uint64_t,
+                                                  uint64_t *, bool *) const; /* reimpl */
+
+                /* Low latency playlists number parts as MSN * PARTS_MAX + part index */
+                static const unsigned PARTS_MAX = 1000;
+                uint64_t getSegmentNumber(uint64_t msn, unsigned part = 0) const;
 
             private:
+                Url getUpdateUrl() const;
+                bool updateDue() const;
+
                 StreamFormat streamFormat;
                 bool b_live;
                 bool b_loaded;
@@ -61,6 +70,15 @@ namespace hls
                 time_t nextUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+
+                /* Low latency (EXT-X-PART-INF, EXT-X-SERVER-CONTROL) */
+                bool b_lowLatency;
+                bool b_canBlockReload;
+                vlc_tick_t partTargetDuration;
+                vlc_tick_t canSkipUntil;
+                uint64_t nextMSN; /* next blocking reload _HLS_msn/_HLS_part */
+                unsigned nextPart;
+                vlc_tick_t nextBlockingUpdate;
         };
     }
 }
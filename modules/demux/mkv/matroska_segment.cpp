@@ -67,6 +67,9 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
 
 matroska_segment_c::~matroska_segment_c()
 {
+    /* the indexer parses from our segment element */
+    _seeker.stop_indexer();
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -687,6 +690,16 @@ bool matroska_segment_c::Preload( )
     if( cluster )
         EnsureDuration();
 
+    /* Without Cues, find the keyframes before the first seek needs them.
+     * Only the segments of the opened file can be reopened by URL. */
+    if( cluster && !b_cues && sys.b_seekable &&
+        &es == &sys.streams.front()->estream )
+    {
+        if( !_seeker.load_index( *this ) && sys.b_fastseekable &&
+            var_InheritBool( &sys.demuxer, "mkv-index-clusters" ) )
+            _seeker.start_indexer( *this, cluster->GetElementPosition() );
+    }
+
     return true;
 }
 
@@ -28,6 +28,12 @@
 #include "util.hpp"
 #include "stream_io_callback.hpp"
 
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_strings.h>
+#include <vlc_configuration.h>
+
+#include <cerrno>
 #include <sstream>
 #include <limits>
 
@@ -50,6 +56,22 @@ namespace {
 
 namespace mkv {
 
+SegmentSeeker::SegmentSeeker()
+{
+    _indexer.p_segment   = NULL;
+    _indexer.b_running   = false;
+    _indexer.p_interrupt = NULL;
+    _indexer.i_rate      = 0;
+    _indexer.i_start_fpos = _indexer.i_end_fpos = 0;
+    _indexer.i_merged_clusters = _indexer.i_merged_seekpoints = 0;
+    vlc_mutex_init( &_indexer.lock );
+}
+
+SegmentSeeker::~SegmentSeeker()
+{
+    stop_indexer();
+}
+
 SegmentSeeker::cluster_positions_t::iterator
 SegmentSeeker::add_cluster_position( fptr_t fpos )
 {
@@ -301,6 +323,8 @@ SegmentSeeker::get_seekpoints( matroska_segment_c& ms, vlc_tick_t target_pts,
         }
     };
 
+    merge_indexer();
+
     for( vlc_tick_t needle_pts = target_pts; ; )
     {
         seekpoint_pair_t seekpoints = get_seekpoints_around( needle_pts, priority_tracks );
@@ -519,4 +543,418 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
         ms.es.I_O().setFilePointer( fpos );
 }
 
+// -----------------------------------------------------------------------
+// background indexing
+// -----------------------------------------------------------------------
+
+#define INDEX_CACHE_MAGIC   "VLCMKVIX"
+#define INDEX_CACHE_VERSION 1
+
+/* identifies the segment the cached index belongs to */
+static std::vector<uint8_t> IndexKey( matroska_segment_c& ms )
+{
+    std::vector<uint8_t> key;
+    uint64_t i_size;
+
+    if( vlc_stream_GetSize( ms.sys.demuxer.s, &i_size ) != VLC_SUCCESS )
+        return key;
+
+    key.resize( 24 );
+    SetQWBE( &key[0],  i_size );
+    SetQWBE( &key[8],  ms.segment->GetElementPosition() );
+    SetQWBE( &key[16], ms.i_timescale );
+    if( ms.p_segment_uid )
+        key.insert( key.end(), ms.p_segment_uid->GetBuffer(),
+                    ms.p_segment_uid->GetBuffer() + ms.p_segment_uid->GetSize() );
+    return key;
+}
+
+static std::string IndexCachePath( demux_t *p_demux, std::vector<uint8_t> const& key,
+                                   bool b_create )
+{
+    if( key.empty() || p_demux->psz_url == NULL || !*p_demux->psz_url ||
+        !var_InheritBool( p_demux, "mkv-index-cache" ) )
+        return std::string();
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return std::string();
+
+    std::string dir = std::string( psz_cachedir ) + DIR_SEP "mkv";
+    if( b_create )
+    {
+        vlc_mkdir( psz_cachedir, 0700 );
+        vlc_mkdir( dir.c_str(), 0700 );
+    }
+    free( psz_cachedir );
+
+    /* one file per segment of the media */
+    vlc_hash_md5_t md5;
+    uint8_t digest[VLC_HASH_MD5_DIGEST_SIZE];
+    char psz_hash[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, p_demux->psz_url, strlen( p_demux->psz_url ) );
+    vlc_hash_md5_Update( &md5, &key[8], 8 );
+    vlc_hash_md5_Finish( &md5, digest, sizeof(digest) );
+    vlc_hex_encode_binary( digest, sizeof(digest), psz_hash );
+
+    return dir + DIR_SEP + psz_hash + ".index";
+}
+
+static bool WriteU32( FILE *p_file, uint32_t i_value )
+{
+    uint8_t buf[4];
+    SetDWBE( buf, i_value );
+    return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+}
+
+static bool WriteU64( FILE *p_file, uint64_t i_value )
+{
+    uint8_t buf[8];
+    SetQWBE( buf, i_value );
+    return fwrite( buf, sizeof(buf), 1, p_file ) == 1;
+}
+
+static bool ReadU32( FILE *p_file, uint32_t *pi_value )
+{
+    uint8_t buf[4];
+    if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+        return false;
+    *pi_value = GetDWBE( buf );
+    return true;
+}
+
+static bool ReadU64( FILE *p_file, uint64_t *pi_value )
+{
+    uint8_t buf[8];
+    if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+        return false;
+    *pi_value = GetQWBE( buf );
+    return true;
+}
+
+bool
+SegmentSeeker::load_index( matroska_segment_c& ms )
+{
+    demux_t *p_demux = &ms.sys.demuxer;
+    std::vector<uint8_t> const key = IndexKey( ms );
+    std::string const path = IndexCachePath( p_demux, key, false );
+
+    if( path.empty() )
+        return false;
+
+    FILE *p_file = vlc_fopen( path.c_str(), "rb" );
+    if( p_file == NULL )
+        return false;
+
+    char magic[8];
+    uint32_t i_version, i_key, i_count;
+    uint64_t i_start, i_end;
+    std::vector<uint8_t> file_key;
+    cluster_positions_t cluster_positions;
+    track_seekpoints_t  seekpoints;
+    bool b_ok = false;
+
+    if( fread( magic, sizeof(magic), 1, p_file ) != 1 ||
+        memcmp( magic, INDEX_CACHE_MAGIC, sizeof(magic) ) ||
+        !ReadU32( p_file, &i_version ) || i_version != INDEX_CACHE_VERSION ||
+        !ReadU32( p_file, &i_key ) || i_key != key.size() )
+        goto end;
+
+    file_key.resize( i_key );
+    if( fread( &file_key[0], i_key, 1, p_file ) != 1 || file_key != key ||
+        !ReadU64( p_file, &i_start ) || !ReadU64( p_file, &i_end ) ||
+        i_end < i_start || !ReadU32( p_file, &i_count ) )
+        goto end;
+
+    for( uint32_t i = 0; i < i_count; i++ )
+    {
+        uint64_t i_fpos;
+        if( !ReadU64( p_file, &i_fpos ) )
+            goto end;
+        cluster_positions.push_back( i_fpos );
+    }
+
+    if( !ReadU32( p_file, &i_count ) )
+        goto end;
+
+    for( uint32_t i = 0; i < i_count; i++ )
+    {
+        uint32_t i_track;
+        uint64_t i_fpos, i_pts;
+        if( !ReadU32( p_file, &i_track ) || !ReadU64( p_file, &i_fpos ) ||
+            !ReadU64( p_file, &i_pts ) )
+            goto end;
+        seekpoints.push_back( track_seekpoints_t::value_type( i_track,
+                              Seekpoint( i_fpos, vlc_tick_t( i_pts ) ) ) );
+    }
+
+    for( cluster_positions_t::const_iterator it = cluster_positions.begin(); it != cluster_positions.end(); ++it )
+        add_cluster_position( *it );
+
+    for( track_seekpoints_t::const_iterator it = seekpoints.begin(); it != seekpoints.end(); ++it )
+        add_seekpoint( it->first, it->second );
+
+    if( i_end > i_start )
+        mark_range_as_searched( Range( i_start, i_end ) );
+
+    msg_Dbg( p_demux, "loaded %zu clusters index from %s", cluster_positions.size(), path.c_str() );
+    b_ok = true;
+
+end:
+    fclose( p_file );
+    return b_ok;
+}
+
+void
+SegmentSeeker::save_index( demux_t *p_demux, std::vector<uint8_t> const& key ) const
+{
+    std::string const path = IndexCachePath( p_demux, key, true );
+
+    if( path.empty() )
+        return;
+
+    std::string const tmp = path + ".part";
+    FILE *p_file = vlc_fopen( tmp.c_str(), "wb" );
+
+    if( p_file == NULL )
+    {
+        msg_Warn( p_demux, "cannot save clusters index to %s: %s",
+                  tmp.c_str(), vlc_strerror_c( errno ) );
+        return;
+    }
+
+    Indexer const& idx = _indexer;
+
+    bool b_ok = fwrite( INDEX_CACHE_MAGIC, 8, 1, p_file ) == 1 &&
+                WriteU32( p_file, INDEX_CACHE_VERSION ) &&
+                WriteU32( p_file, key.size() ) &&
+                fwrite( &key[0], key.size(), 1, p_file ) == 1 &&
+                WriteU64( p_file, idx.i_start_fpos ) &&
+                WriteU64( p_file, idx.i_end_fpos ) &&
+                WriteU32( p_file, idx.cluster_positions.size() );
+
+    for( cluster_positions_t::const_iterator it = idx.cluster_positions.begin();
+         b_ok && it != idx.cluster_positions.end(); ++it )
+        b_ok = WriteU64( p_file, *it );
+
+    b_ok = b_ok && WriteU32( p_file, idx.seekpoints.size() );
+
+    for( track_seekpoints_t::const_iterator it = idx.seekpoints.begin();
+         b_ok && it != idx.seekpoints.end(); ++it )
+        b_ok = WriteU32( p_file, it->first ) &&
+               WriteU64( p_file, it->second.fpos ) &&
+               WriteU64( p_file, it->second.pts );
+
+    if( fclose( p_file ) )
+        b_ok = false;
+
+    if( b_ok && vlc_rename( tmp.c_str(), path.c_str() ) == 0 )
+        msg_Dbg( p_demux, "saved clusters index to %s", path.c_str() );
+    else
+        vlc_unlink( tmp.c_str() );
+}
+
+void
+SegmentSeeker::start_indexer( matroska_segment_c& ms, fptr_t start_fpos )
+{
+    Indexer& idx = _indexer;
+
+    if( idx.b_running || ms.sys.demuxer.psz_url == NULL )
+        return;
+
+    idx.p_interrupt = vlc_interrupt_create();
+    if( unlikely( idx.p_interrupt == NULL ) )
+        return;
+
+    idx.p_segment = &ms;
+    idx.i_rate    = VLC_CLIP( var_InheritInteger( &ms.sys.demuxer, "mkv-index-rate" ), 0, INT_MAX / 1024 );
+    idx.key       = IndexKey( ms );
+    idx.i_start_fpos = idx.i_end_fpos = start_fpos;
+
+    idx.track_ids.clear();
+    for( matroska_segment_c::tracks_map_t::const_iterator it = ms.tracks.begin(); it != ms.tracks.end(); ++it )
+        idx.track_ids.push_back( it->first );
+
+    if( vlc_clone( &idx.thread, IndexerThread, this, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_interrupt_destroy( idx.p_interrupt );
+        idx.p_interrupt = NULL;
+        return;
+    }
+    idx.b_running = true;
+}
+
+void
+SegmentSeeker::stop_indexer()
+{
+    if( !_indexer.b_running )
+        return;
+
+    vlc_interrupt_kill( _indexer.p_interrupt );
+    vlc_join( _indexer.thread, NULL );
+    vlc_interrupt_destroy( _indexer.p_interrupt );
+    _indexer.p_interrupt = NULL;
+    _indexer.b_running = false;
+}
+
+void
+SegmentSeeker::merge_indexer()
+{
+    Indexer& idx = _indexer;
+
+    if( !idx.b_running )
+        return;
+
+    vlc_mutex_locker lock_guard( &idx.lock );
+
+    for( ; idx.i_merged_clusters < idx.cluster_positions.size(); idx.i_merged_clusters++ )
+        add_cluster_position( idx.cluster_positions[ idx.i_merged_clusters ] );
+
+    for( ; idx.i_merged_seekpoints < idx.seekpoints.size(); idx.i_merged_seekpoints++ )
+        add_seekpoint( idx.seekpoints[ idx.i_merged_seekpoints ].first,
+                       idx.seekpoints[ idx.i_merged_seekpoints ].second );
+
+    if( idx.i_end_fpos > idx.i_start_fpos )
+        mark_range_as_searched( Range( idx.i_start_fpos, idx.i_end_fpos ) );
+}
+
+void *
+SegmentSeeker::IndexerThread( void *data )
+{
+    static_cast<SegmentSeeker*>( data )->index_clusters();
+    return NULL;
+}
+
+/* Walks the clusters on a stream of its own, reading only the block
+ * headers, and publishes the keyframes found after each cluster. */
+void
+SegmentSeeker::index_clusters()
+{
+    Indexer& idx = _indexer;
+    matroska_segment_c& ms = *idx.p_segment;
+    demux_t *p_demux = &ms.sys.demuxer;
+
+    vlc_interrupt_set( idx.p_interrupt );
+
+    stream_t *s = vlc_stream_NewURL( p_demux, p_demux->psz_url );
+    if( s == NULL )
+        return;
+
+    vlc_stream_io_callback io( s, true );
+    EbmlStream es( io );
+    EbmlParser ep( &es, ms.segment, p_demux );
+
+    vlc_tick_t const i_start = vlc_tick_now();
+    bool b_complete = false;
+
+    try
+    {
+        io.setFilePointer( idx.i_start_fpos );
+
+        while( !vlc_killed() )
+        {
+            EbmlElement *el = ep.Get();
+            if( el == NULL )
+            {
+                b_complete = !vlc_killed();
+                break;
+            }
+
+            MKV_CHECKED_PTR_DECL( p_cluster, KaxCluster, el );
+            if( p_cluster == NULL )
+                continue;
+
+            fptr_t const i_cluster_pos = p_cluster->GetElementPosition();
+            track_seekpoints_t seekpoints;
+            bool b_timecode = false;
+
+            ep.Down();
+            while( EbmlElement *el2 = ep.Get() )
+            {
+                if( MKV_CHECKED_PTR_DECL( p_tc, KaxClusterTimecode, el2 ) )
+                {
+                    p_tc->ReadData( es.I_O(), SCOPE_ALL_DATA );
+                    p_cluster->InitTimecode( static_cast<uint64>( *p_tc ), ms.i_timescale );
+                    b_timecode = true;
+                }
+                else if( !b_timecode )
+                    continue;
+                else if( MKV_CHECKED_PTR_DECL( p_sblock, KaxSimpleBlock, el2 ) )
+                {
+                    p_sblock->ReadData( es.I_O(), SCOPE_PARTIAL_DATA );
+                    p_sblock->SetParent( *p_cluster );
+
+                    if( p_sblock->IsKeyframe() )
+                        seekpoints.push_back( track_seekpoints_t::value_type( p_sblock->TrackNum(),
+                            Seekpoint( p_sblock->GetElementPosition(), VLC_TICK_FROM_NS( p_sblock->GlobalTimecode() ) ) ) );
+                }
+                else if( MKV_IS_ID( el2, KaxBlockGroup ) )
+                {
+                    /* a block without reference is a keyframe */
+                    track_seekpoints_t::value_type group( 0, Seekpoint() );
+                    bool b_key = true;
+
+                    ep.Down();
+                    while( EbmlElement *el3 = ep.Get() )
+                    {
+                        if( MKV_CHECKED_PTR_DECL( p_block, KaxBlock, el3 ) )
+                        {
+                            p_block->ReadData( es.I_O(), SCOPE_PARTIAL_DATA );
+                            p_block->SetParent( *p_cluster );
+                            group = track_seekpoints_t::value_type( p_block->TrackNum(),
+                                Seekpoint( p_block->GetElementPosition(), VLC_TICK_FROM_NS( p_block->GlobalTimecode() ) ) );
+                        }
+                        else if( MKV_IS_ID( el3, KaxReferenceBlock ) )
+                            b_key = false;
+                    }
+                    ep.Up();
+
+                    if( b_key && group.second.trust_level != Seekpoint::DISABLED )
+                        seekpoints.push_back( group );
+                }
+            }
+            ep.Up();
+
+            /* blocks of unknown tracks are not seekpoints */
+            track_seekpoints_t::iterator last = seekpoints.begin();
+            for( track_seekpoints_t::const_iterator it = seekpoints.begin(); it != seekpoints.end(); ++it )
+            {
+                if( std::find( idx.track_ids.begin(), idx.track_ids.end(), it->first ) != idx.track_ids.end() )
+                    *last++ = *it;
+            }
+            seekpoints.erase( last, seekpoints.end() );
+
+            fptr_t const i_end_fpos = es.I_O().getFilePointer();
+            {
+                vlc_mutex_locker lock_guard( &idx.lock );
+
+                idx.cluster_positions.push_back( i_cluster_pos );
+                idx.seekpoints.insert( idx.seekpoints.end(), seekpoints.begin(), seekpoints.end() );
+                idx.i_end_fpos = std::max( idx.i_end_fpos, i_end_fpos );
+            }
+
+            if( idx.i_rate )
+            {
+                vlc_tick_t i_wait = i_start - vlc_tick_now() +
+                    vlc_tick_from_samples( i_end_fpos - idx.i_start_fpos, idx.i_rate * 1024 );
+                if( i_wait > 0 && vlc_msleep_i11e( i_wait ) )
+                    break;
+            }
+        }
+    }
+    catch( ... )
+    {
+        msg_Err( p_demux, "error while indexing clusters, giving up" );
+        b_complete = false;
+    }
+
+    msg_Dbg( p_demux, "indexed %zu clusters up to %" PRIu64 " in %" PRId64 " ms",
+             idx.cluster_positions.size(), idx.i_end_fpos,
+             MS_FROM_VLC_TICK( vlc_tick_now() - i_start ) );
+
+    if( b_complete )
+        save_index( p_demux, idx.key );
+}
+
 } // namespace
@@ -25,6 +25,8 @@
 
 #include "mkv.hpp"
 
+#include <vlc_interrupt.h>
+
 #include <algorithm>
 #include <vector>
 #include <map>
@@ -88,6 +90,9 @@ class SegmentSeeker
         };
 
     public:
+        SegmentSeeker();
+        ~SegmentSeeker();
+
         typedef std::vector<track_id_t> track_ids_t;
         typedef std::vector<Range> ranges_t;
         typedef std::vector<Seekpoint> seekpoints_t;
@@ -119,11 +124,47 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        /* background indexing of the clusters, for segments without Cues */
+        void start_indexer( matroska_segment_c&, fptr_t start_fpos );
+        void stop_indexer();
+        void merge_indexer();
+
+        bool load_index( matroska_segment_c& );
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
         cluster_positions_t _cluster_positions;
         cluster_map_t       _clusters;
+
+    private:
+        typedef std::vector<std::pair<track_id_t, Seekpoint> > track_seekpoints_t;
+
+        static void *IndexerThread( void * );
+        void index_clusters();
+        void save_index( demux_t *, std::vector<uint8_t> const& key ) const;
+
+        struct Indexer
+        {
+            matroska_segment_c *p_segment;
+            bool                b_running;
+            vlc_thread_t        thread;
+            vlc_interrupt_t    *p_interrupt;
+            unsigned            i_rate;
+            track_ids_t         track_ids;
+            std::vector<uint8_t> key;
+
+            /* shared with the indexer thread */
+            vlc_mutex_t         lock;
+            fptr_t              i_start_fpos;
+            fptr_t              i_end_fpos;
+            cluster_positions_t cluster_positions;
+            track_seekpoints_t  seekpoints;
+
+            /* already merged in the seeker */
+            size_t              i_merged_clusters;
+            size_t              i_merged_seekpoints;
+        } _indexer;
 };
 
 } // namespace
@@ -80,6 +80,22 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-index-clusters", true,
+            N_("Index clusters in the background"),
+            N_("Find the keyframes of local files without Cues in the background, "
+               "so that seeking does not need to scan the file."), true );
+
+    add_integer( "mkv-index-rate", 16384,
+            N_("Background indexing rate (KiB/s)"),
+            N_("Maximum amount of the file the background indexer goes through "
+               "per second, 0 for no limit."), true );
+        change_integer_range( 0, INT_MAX / 1024 )
+
+    add_bool( "mkv-index-cache", false,
+            N_("Keep the clusters index"),
+            N_("Save the clusters index of files without Cues in the user cache "
+               "directory, so that they do not need to be indexed again."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -114,6 +114,9 @@ var_InheritFourcc(vlc_object_t *obj, const char *name)
     X(add_video_track_at, vlc_tick_t, add_integer, var_InheritInteger, VLC_TICK_INVALID ) \
     X(add_audio_track_at, vlc_tick_t, add_integer, var_InheritInteger, VLC_TICK_INVALID ) \
     X(add_spu_track_at, vlc_tick_t, add_integer, var_InheritInteger, VLC_TICK_INVALID ) \
+    X(open_delay, vlc_tick_t, add_integer, var_InheritInteger, 0) \
+    X(seek_delay, vlc_tick_t, add_integer, var_InheritInteger, 0) \
+    X(read_delay, vlc_tick_t, add_integer, var_InheritInteger, 0) \
 
 struct demux_sys
 {
@@ -254,6 +257,8 @@ Control(demux_t *demux, int query, va_list args)
         case DEMUX_SET_POSITION:
             if (!sys->can_seek)
                 return VLC_EGENERIC;
+            if (sys->seek_delay > 0)
+                vlc_tick_sleep(sys->seek_delay);
             sys->pts = sys->video_pts = sys->audio_pts = va_arg(args, double) * sys->length;
             return VLC_SUCCESS;
         case DEMUX_GET_LENGTH:
@@ -265,6 +270,8 @@ Control(demux_t *demux, int query, va_list args)
         case DEMUX_SET_TIME:
             if (!sys->can_seek)
                 return VLC_EGENERIC;
+            if (sys->seek_delay > 0)
+                vlc_tick_sleep(sys->seek_delay);
             sys->pts = sys->video_pts = sys->audio_pts = va_arg(args, vlc_tick_t);
             return VLC_SUCCESS;
         case DEMUX_GET_TITLE_INFO:
@@ -356,48 +363,26 @@ CreateAudioBlock(demux_t *demux, struct mock_track *track, vlc_tick_t length)
     (void) demux;
 }
 
-struct video_block
-{
-    block_t b;
-    picture_t *pic;
-};
-
-static void
-video_block_free_cb(block_t *b)
-{
-    struct video_block *video = container_of(b, struct video_block, b);
-    picture_Release(video->pic);
-    free(video);
-}
-
 static block_t *
 CreateVideoBlock(demux_t *demux, struct mock_track *track)
 {
     struct demux_sys *sys = demux->p_sys;
-    picture_t *pic = picture_NewFromFormat(&track->fmt.video);
-    if (!pic)
-        return NULL;
+    picture_t layout;
 
-    struct video_block *video = malloc(sizeof(*video));
-    if (!video)
-    {
-        picture_Release(pic);
+    /* Use the picture layout, but recycled blocks rather than pictures */
+    if (picture_Setup(&layout, &track->fmt.video))
         return NULL;
-    }
-    video->pic = pic;
-
-    static const struct vlc_block_callbacks cbs =
-    {
-        .free = video_block_free_cb
-    };
 
     size_t block_len = 0;
-    for (int i = 0; i < pic->i_planes; ++i)
-        block_len += pic->p[i].i_lines * pic->p[i].i_pitch;
-    memset(pic->p[0].p_pixels, (sys->video_pts / VLC_TICK_FROM_MS(10)) % 255,
+    for (int i = 0; i < layout.i_planes; ++i)
+        block_len += layout.p[i].i_lines * layout.p[i].i_pitch;
+
+    block_t *b = block_Alloc(block_len);
+    if (!b)
+        return NULL;
+    memset(b->p_buffer, (sys->video_pts / VLC_TICK_FROM_MS(10)) % 255,
            block_len);
-    return block_Init(&video->b, &cbs, pic->p[0].p_pixels, block_len);
-    (void) demux;
+    return b;
 }
 
 static block_t *
@@ -650,6 +635,10 @@ Demux(demux_t *demux)
     if (sys->error)
         return VLC_DEMUXER_EGENERIC;
 
+    /* Simulate a slow access or a costly demuxer */
+    if (sys->read_delay > 0)
+        vlc_tick_sleep(sys->read_delay);
+
     if (sys->audio_track_count > 0
      && (sys->video_track_count > 0 || sys->sub_track_count > 0))
         sys->pts = __MIN(sys->audio_pts, sys->video_pts);
@@ -785,6 +774,9 @@ Open(vlc_object_t *obj)
     if (sys->chapter_count > 0 && sys->title_count == 0)
         sys->title_count++;
 
+    if (sys->open_delay > 0)
+        vlc_tick_sleep(sys->open_delay);
+
     const bool length_ok = sys->length >= 0;
     const bool tracks_ok = sys->video_track_count >= 0 &&
                            sys->audio_track_count >= 0 &&
@@ -93,6 +93,97 @@ bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index, stime_t *pi_tim
     return true;
 }
 
+#define FRAGMENTS_INDEX_MAGIC   "VLCMP4FI"
+#define FRAGMENTS_INDEX_VERSION 1
+#define FRAGMENTS_INDEX_HEADER  32
+
+int MP4_Fragments_Index_Write( const mp4_fragments_index_t *p_index, FILE *p_file,
+                               const uint8_t *p_key, uint32_t i_key )
+{
+    uint8_t hdr[FRAGMENTS_INDEX_HEADER];
+    memcpy( hdr, FRAGMENTS_INDEX_MAGIC, 8 );
+    SetDWBE( &hdr[8], FRAGMENTS_INDEX_VERSION );
+    SetDWBE( &hdr[12], i_key );
+    SetDWBE( &hdr[16], p_index->i_tracks );
+    SetDWBE( &hdr[20], p_index->i_entries );
+    SetQWBE( &hdr[24], p_index->i_last_time );
+
+    if( fwrite( hdr, sizeof(hdr), 1, p_file ) != 1 ||
+        ( i_key && fwrite( p_key, i_key, 1, p_file ) != 1 ) )
+        return VLC_EGENERIC;
+
+    for( size_t i=0; i<p_index->i_entries; i++ )
+    {
+        uint8_t buf[8];
+        SetQWBE( buf, p_index->pi_pos[i] );
+        if( fwrite( buf, sizeof(buf), 1, p_file ) != 1 )
+            return VLC_EGENERIC;
+        for( unsigned j=0; j<p_index->i_tracks; j++ )
+        {
+            SetQWBE( buf, p_index->p_times[i * p_index->i_tracks + j] );
+            if( fwrite( buf, sizeof(buf), 1, p_file ) != 1 )
+                return VLC_EGENERIC;
+        }
+    }
+
+    return VLC_SUCCESS;
+}
+
+mp4_fragments_index_t * MP4_Fragments_Index_Read( FILE *p_file,
+                                                  const uint8_t *p_key, uint32_t i_key )
+{
+    uint8_t hdr[FRAGMENTS_INDEX_HEADER];
+    if( fread( hdr, sizeof(hdr), 1, p_file ) != 1 ||
+        memcmp( hdr, FRAGMENTS_INDEX_MAGIC, 8 ) ||
+        GetDWBE( &hdr[8] ) != FRAGMENTS_INDEX_VERSION ||
+        GetDWBE( &hdr[12] ) != i_key )
+        return NULL;
+
+    for( uint32_t i=0; i<i_key; i++ )
+    {
+        int c = fgetc( p_file );
+        if( c == EOF || c != p_key[i] )
+            return NULL;
+    }
+
+    const unsigned i_tracks = GetDWBE( &hdr[16] );
+    const unsigned i_entries = GetDWBE( &hdr[20] );
+
+    /* Do not trust the entries count further than the file size */
+    long i_start = ftell( p_file );
+    if( i_start < 0 || fseek( p_file, 0, SEEK_END ) )
+        return NULL;
+    long i_end = ftell( p_file );
+    if( i_end < i_start || fseek( p_file, i_start, SEEK_SET ) ||
+        (uint64_t)(i_end - i_start) / 8 / ((uint64_t)i_tracks + 1) < i_entries )
+        return NULL;
+
+    mp4_fragments_index_t *p_index = MP4_Fragments_Index_New( i_tracks, i_entries );
+    if( !p_index )
+        return NULL;
+    p_index->i_last_time = GetQWBE( &hdr[24] );
+
+    for( size_t i=0; i<i_entries; i++ )
+    {
+        uint8_t buf[8];
+        if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+            goto error;
+        p_index->pi_pos[i] = GetQWBE( buf );
+        for( unsigned j=0; j<i_tracks; j++ )
+        {
+            if( fread( buf, sizeof(buf), 1, p_file ) != 1 )
+                goto error;
+            p_index->p_times[i * i_tracks + j] = GetQWBE( buf );
+        }
+    }
+
+    return p_index;
+
+error:
+    MP4_Fragments_Index_Delete( p_index );
+    return NULL;
+}
+
 #ifdef MP4_VERBOSE
 void MP4_Fragments_Index_Dump( vlc_object_t *p_obj, const mp4_fragments_index_t *p_index,
                                uint32_t i_movie_timescale )
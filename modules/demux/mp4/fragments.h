@@ -42,6 +42,13 @@ stime_t MP4_Fragment_Index_GetTrackDuration( mp4_fragments_index_t *p_index, uns
 bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index,
                                  stime_t *pi_time, uint64_t *pi_pos, unsigned i_track_index );
 
+/* Persistent form of the index. The key identifies the indexed file, and
+ * must match on reading. */
+int MP4_Fragments_Index_Write( const mp4_fragments_index_t *p_index, FILE *p_file,
+                               const uint8_t *p_key, uint32_t i_key );
+mp4_fragments_index_t * MP4_Fragments_Index_Read( FILE *p_file,
+                                                  const uint8_t *p_key, uint32_t i_key );
+
 #ifdef MP4_VERBOSE
 void MP4_Fragments_Index_Dump( vlc_object_t *p_obj, const mp4_fragments_index_t *p_index,
                                 uint32_t i_movie_timescale );
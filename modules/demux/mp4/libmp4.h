@@ -39,6 +39,7 @@ typedef int64_t stime_t;
 #define BRAND_isom VLC_FOURCC( 'i', 's', 'o', 'm' )
 #define BRAND_iso2 VLC_FOURCC( 'i', 's', 'o', '2' )
 #define BRAND_iso6 VLC_FOURCC( 'i', 's', 'o', '6' )
+#define BRAND_cmfc VLC_FOURCC( 'c', 'm', 'f', 'c' ) /* CMAF track */
 #define BRAND_qt__ VLC_FOURCC( 'q', 't', ' ', ' ' )
 #define BRAND_f4v  VLC_FOURCC( 'f', '4', 'v', ' ' ) /* Adobe Flash */
 #define BRAND_dash VLC_FOURCC( 'd', 'a', 's', 'h' )
@@ -35,8 +35,15 @@
 #include <vlc_plugin.h>
 #include <vlc_dialog.h>
 #include <vlc_url.h>
+#include <vlc_fs.h>
+#include <vlc_strings.h>
+#include <vlc_hash.h>
+#include <vlc_interrupt.h>
+#include <vlc_configuration.h>
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
+#include <stdatomic.h>
 #include "attachments.h"
 #include "heif.h"
 #include "../../codec/cc.h"
@@ -53,6 +60,17 @@ static void Close( vlc_object_t * );
 #define MP4_M4A_TEXT     N_("M4A audio only")
 #define MP4_M4A_LONGTEXT N_("Ignore non audio tracks from iTunes audio files")
 
+#define MP4_FRAGINDEX_TEXT     N_("Index fragments in the background")
+#define MP4_FRAGINDEX_LONGTEXT N_("Build the fragments index of seekable " \
+    "fragmented files without random access index in the background, " \
+    "so that seeking does not need to scan the file.")
+#define MP4_FRAGINDEX_RATE_TEXT     N_("Background indexing rate (KiB/s)")
+#define MP4_FRAGINDEX_RATE_LONGTEXT N_("Maximum amount of fragment headers " \
+    "read per second while indexing in the background (0 is unlimited).")
+#define MP4_FRAGINDEX_CACHE_TEXT     N_("Keep fragments index")
+#define MP4_FRAGINDEX_CACHE_LONGTEXT N_("Save the fragments index in the " \
+    "cache directory, and reuse it the next time the same file is opened.")
+
 #define HEIF_DURATION_TEXT N_("Duration in seconds")
 #define HEIF_DURATION_LONGTEXT N_( \
     "Duration in seconds before simulating an end of file. " \
@@ -68,6 +86,13 @@ vlc_module_begin ()
 
     add_category_hint("Hacks", NULL)
     add_bool( CFG_PREFIX"m4a-audioonly", false, MP4_M4A_TEXT, MP4_M4A_LONGTEXT, true )
+    add_bool( CFG_PREFIX"fragments-index", false,
+              MP4_FRAGINDEX_TEXT, MP4_FRAGINDEX_LONGTEXT, true )
+    add_integer( CFG_PREFIX"fragments-index-rate", 1024,
+                 MP4_FRAGINDEX_RATE_TEXT, MP4_FRAGINDEX_RATE_LONGTEXT, true )
+        change_integer_range( 0, INT_MAX / 1024 )
+    add_bool( CFG_PREFIX"fragments-index-cache", false,
+              MP4_FRAGINDEX_CACHE_TEXT, MP4_FRAGINDEX_CACHE_LONGTEXT, true )
 
     add_submodule()
         set_category( CAT_INPUT )
@@ -140,6 +165,24 @@ typedef struct
     } hacks;
 
     mp4_fragments_index_t *p_fragsindex;
+
+    /* background fragments indexing */
+    struct
+    {
+        bool            b_running;
+        vlc_thread_t    thread;
+        vlc_interrupt_t *p_interrupt;
+        atomic_bool     b_hurry;  /* someone waits, ignore rate limit */
+        unsigned        i_rate;   /* KiB/s, 0 for unlimited */
+        mp4_fragments_index_t *p_index; /* result, valid after join */
+    } fragsindexer;
+
+    /* read-ahead plan, announced to non fast-seekable streams */
+    struct
+    {
+        struct vlc_stream_range *p_ranges; /* last announced, then scratch */
+        size_t           i_count;
+    } readahead;
 } demux_sys_t;
 
 #define DEMUX_INCREMENT VLC_TICK_FROM_MS(250) /* How far the pcr will go, each round */
@@ -163,6 +206,7 @@ static void MP4_TrackSelect  ( demux_t *, mp4_track_t *, bool );
 static int  MP4_TrackSeek   ( demux_t *, mp4_track_t *, vlc_tick_t );
 
 static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
+static uint64_t MP4_TrackGetSamplePos( mp4_track_t *, uint32_t );
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *, uint32_t * );
 static int      MP4_TrackNextSample( demux_t *, mp4_track_t *, uint32_t );
 static void     MP4_TrackSetELST( demux_t *, mp4_track_t *, vlc_tick_t );
@@ -176,10 +220,15 @@ static void MP4_GetDefaultSizeAndDuration( MP4_Box_t *p_moov,
                                            uint32_t *pi_default_duration );
 
 static stime_t GetMoovTrackDuration( demux_sys_t *p_sys, unsigned i_track_ID );
+static stime_t GetCumulatedDuration( demux_t *p_demux );
 
 static int  ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented );
 static int  ProbeFragmentsChecked( demux_t *p_demux );
 static int  ProbeIndex( demux_t *p_demux );
+static bool FragIndexCacheLoad( demux_t *p_demux );
+static void FragIndexCacheSave( demux_t *p_demux );
+static void FragIndexerStart( demux_t *p_demux );
+static bool FragIndexerJoin( demux_t *p_demux, bool b_abort );
 
 static int FragCreateTrunIndex( demux_t *, MP4_Box_t *, MP4_Box_t *, stime_t );
 
@@ -1170,6 +1219,19 @@ static int Open( vlc_object_t * p_this )
     p_sys->asfpacketsys.pf_updatetime = NULL;
     p_sys->asfpacketsys.pf_setaspectratio = NULL;
 
+    /* Reuse or build the fragments index if no seek index is available */
+    if( p_sys->b_fragmented && p_sys->b_seekable && !p_sys->b_fragments_probed &&
+        !MP4_BoxGet( p_sys->p_root, "sidx" ) )
+    {
+        if( FragIndexCacheLoad( p_demux ) )
+        {
+            if( !MP4_BoxGet( p_sys->p_moov, "mvex/mehd" ) )
+                p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
+        }
+        else if( var_InheritBool( p_demux, CFG_PREFIX"fragments-index" ) )
+            FragIndexerStart( p_demux );
+    }
+
     return VLC_SUCCESS;
 
 error:
@@ -1442,6 +1504,83 @@ end:
     return VLC_DEMUXER_EGENERIC;
 }
 
+/* Announces the remainder of the current chunk of each selected track,
+ * which is what the next rounds will read, so that badly interleaved files
+ * do not make the read-ahead bounce between the tracks with large reads */
+static void MP4_UpdateReadAheadPlan( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->readahead.p_ranges == NULL )
+    {
+        p_sys->readahead.p_ranges =
+            vlc_alloc( 2 * p_sys->i_tracks, sizeof(struct vlc_stream_range) );
+        if( p_sys->readahead.p_ranges == NULL )
+            return;
+    }
+
+    struct vlc_stream_range *p_last = p_sys->readahead.p_ranges;
+    struct vlc_stream_range *p_plan = &p_last[p_sys->i_tracks];
+    size_t i_count = 0;
+
+    for( unsigned i_track = 0; i_track < p_sys->i_tracks; i_track++ )
+    {
+        mp4_track_t *tk = &p_sys->track[i_track];
+        if( !tk->b_ok || !tk->b_selected || MP4_isMetadata( tk ) ||
+            tk->i_sample >= tk->i_sample_count ||
+            tk->i_chunk >= tk->i_chunk_count )
+            continue;
+
+        const mp4_chunk_t *ck = &tk->chunk[tk->i_chunk];
+        uint64_t i_start = MP4_TrackGetPos( tk );
+        uint64_t i_end = MP4_TrackGetSamplePos( tk, ck->i_sample_first +
+                                                    ck->i_sample_count );
+        if( i_end <= i_start )
+            continue;
+
+        /* insert sorted by offset, merging overlaps */
+        size_t i = i_count;
+        while( i > 0 && p_plan[i - 1].offset > i_start )
+        {
+            p_plan[i] = p_plan[i - 1];
+            i--;
+        }
+        p_plan[i].offset = i_start;
+        p_plan[i].length = i_end - i_start;
+        i_count++;
+    }
+
+    size_t i_merged = 0;
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( i_merged > 0 )
+        {
+            struct vlc_stream_range *prev = &p_plan[i_merged - 1];
+            uint64_t i_prev_end = prev->offset + prev->length;
+            if( p_plan[i].offset <= i_prev_end )
+            {
+                uint64_t i_end = __MAX( i_prev_end,
+                                        p_plan[i].offset + p_plan[i].length );
+                prev->length = i_end - prev->offset;
+                continue;
+            }
+        }
+        p_plan[i_merged++] = p_plan[i];
+    }
+
+    /* Only the chunk ends change the plan, not the reads within chunks */
+    bool b_changed = i_merged != p_sys->readahead.i_count;
+    for( size_t i = 0; !b_changed && i < i_merged; i++ )
+        b_changed = p_plan[i].offset + p_plan[i].length !=
+                    p_last[i].offset + p_last[i].length;
+    if( !b_changed )
+        return;
+
+    memcpy( p_last, p_plan, i_merged * sizeof(*p_plan) );
+    p_sys->readahead.i_count = i_merged;
+    vlc_stream_SetReadAheadPlan( p_demux->s, p_plan, i_merged );
+}
+
 static int DemuxMoov( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -1562,6 +1701,9 @@ static int DemuxMoov( demux_t *p_demux )
     /* */
     MP4_UpdateSeekpoint( p_demux, i_nztime + DEMUX_INCREMENT );
 
+    if( p_sys->b_seekable && !p_sys->b_fastseekable )
+        MP4_UpdateReadAheadPlan( p_demux );
+
     return i_status;
 }
 
@@ -2149,6 +2291,8 @@ static void Close ( vlc_object_t * p_this )
 
     msg_Dbg( p_demux, "freeing all memory" );
 
+    FragIndexerJoin( p_demux, true );
+
     FragResetContext( p_sys );
 
     MP4_BoxFree( p_sys->p_root );
@@ -2164,6 +2308,7 @@ static void Close ( vlc_object_t * p_this )
     for( i_track = 0; i_track < p_sys->i_tracks; i_track++ )
         MP4_TrackClean( p_demux->out, &p_sys->track[i_track] );
     free( p_sys->track );
+    free( p_sys->readahead.p_ranges );
 
     free( p_sys );
 }
@@ -2499,18 +2644,10 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, the box table is kept
+         * for the whole demuxer lifetime, so no need to copy it */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2552,6 +2689,15 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
+        /* A chunk can only split a single stts entry with the next one, so
+         * all extracts fit in entries + chunks slots: allocate them at once
+         * instead of two small arrays per chunk */
+        size_t i_pool = (size_t)stts->i_entry_count + p_demux_track->i_chunk_count;
+        size_t i_pool_used = 0;
+        p_demux_track->p_chunks_tts_dts = vlc_alloc( i_pool, 2 * sizeof( uint32_t ) );
+        if( i_pool && !p_demux_track->p_chunks_tts_dts )
+            return VLC_ENOMEM;
+
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
@@ -2572,17 +2718,16 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
             if ( i_ret == VLC_EGENERIC )
                 return i_ret;
 
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            /* take them from the pool */
+            if( ck->i_entries_dts > i_pool - i_pool_used )
             {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
+                msg_Err( p_demux, "invalid stts extract for i_entry=%"PRIu32, ck->i_entries_dts );
                 ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
+                return VLC_EGENERIC;
             }
+            ck->p_sample_count_dts = &p_demux_track->p_chunks_tts_dts[i_pool_used];
+            ck->p_sample_delta_dts = &p_demux_track->p_chunks_tts_dts[i_pool + i_pool_used];
+            i_pool_used += ck->i_entries_dts;
 
             /* now copy */
             i_sample_count = ck->i_sample_count;
@@ -2661,6 +2806,13 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
+        /* same bound and storage as the stts extracts */
+        size_t i_pool = (size_t)ctts->i_entry_count + p_demux_track->i_chunk_count;
+        size_t i_pool_used = 0;
+        p_demux_track->p_chunks_tts_pts = vlc_alloc( i_pool, 2 * sizeof( uint32_t ) );
+        if( i_pool && !p_demux_track->p_chunks_tts_pts )
+            return VLC_ENOMEM;
+
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
@@ -2677,17 +2829,17 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
             if ( i_ret == VLC_EGENERIC )
                 return i_ret;
 
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            /* take them from the pool */
+            if( ck->i_entries_pts > i_pool - i_pool_used )
             {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
+                msg_Err( p_demux, "invalid ctts extract for i_entry=%"PRIu32, ck->i_entries_pts );
                 ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
+                return VLC_EGENERIC;
             }
+            ck->p_sample_count_pts = &p_demux_track->p_chunks_tts_pts[i_pool_used];
+            ck->p_sample_offset_pts =
+                (int32_t *) &p_demux_track->p_chunks_tts_pts[i_pool + i_pool_used];
+            i_pool_used += ck->i_entries_pts;
 
             /* now copy */
             i_sample_count = ck->i_sample_count;
@@ -3534,10 +3686,6 @@ static void MP4_TrackSetup( demux_t *p_demux, mp4_track_t *p_track,
 
 static void DestroyChunk( mp4_chunk_t *ck )
 {
-    free( ck->p_sample_count_dts );
-    free( ck->p_sample_delta_dts );
-    free( ck->p_sample_count_pts );
-    free( ck->p_sample_offset_pts );
     free( ck->p_sample_size );
 }
 
@@ -3559,9 +3707,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
             DestroyChunk( &p_track->chunk[i_chunk] );
     }
     free( p_track->chunk );
-
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
+    free( p_track->p_chunks_tts_dts );
+    free( p_track->p_chunks_tts_pts );
 
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
@@ -3878,6 +4025,13 @@ static uint32_t MP4_TrackGetReadSize( mp4_track_t *p_track, uint32_t *pi_nb_samp
 }
 
 static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
+{
+    return MP4_TrackGetSamplePos( p_track, p_track->i_sample );
+}
+
+/* Position of a sample within the current chunk (or of its end) */
+static uint64_t MP4_TrackGetSamplePos( mp4_track_t *p_track,
+                                       uint32_t i_sample_end )
 {
     unsigned int i_sample;
     uint64_t i_pos;
@@ -3887,7 +4041,7 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
     if( p_track->i_sample_size )
     {
         /* chunk offset in samples */
-        uint32_t i_samples = p_track->i_sample -
+        uint32_t i_samples = i_sample_end -
                              p_track->chunk[p_track->i_chunk].i_sample_first;
 
         if( p_track->fmt.i_cat == AUDIO_ES )
@@ -3913,7 +4067,7 @@ static uint64_t MP4_TrackGetPos( mp4_track_t *p_track )
     else
     {
         for( i_sample = p_track->chunk[p_track->i_chunk].i_sample_first;
-             i_sample < p_track->i_sample; i_sample++ )
+             i_sample < i_sample_end; i_sample++ )
         {
             i_pos += p_track->p_sample_size[i_sample];
         }
@@ -4212,6 +4366,48 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return true;
 }
 
+/* Fills the fragments index times of a moof, pi_track_times carrying each
+ * track end time (track scaled) from one moof to the next */
+static void FragIndexMoof( demux_sys_t *p_sys, MP4_Box_t *p_moof, unsigned index,
+                           stime_t *pi_track_times, stime_t *p_times )
+{
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        MP4_Box_t *p_tfdt = NULL;
+        MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
+        if( p_traf )
+            p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
+
+        if( p_tfdt && BOXDATA(p_tfdt) )
+        {
+            pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
+        }
+        else if( index == 0 ) /* Set first fragment time offset from moov */
+        {
+            stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
+            pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
+        }
+
+        p_times[i] = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
+
+        stime_t i_duration = 0;
+        if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
+            pi_track_times[i] += i_duration;
+    }
+}
+
+static stime_t FragIndexLastTime( demux_sys_t *p_sys, const stime_t *pi_track_times )
+{
+    stime_t i_last_time = 0;
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
+        if( i_last_time < i_movietime )
+            i_last_time = i_movietime;
+    }
+    return i_last_time;
+}
+
 static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4224,7 +4420,12 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
     if( !p_vroot )
         return VLC_EGENERIC;
 
-    if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
+    if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) &&
+        FragIndexCacheLoad( p_demux ) )
+    {
+        *pb_fragmented = true;
+    }
+    else if( p_sys->b_seekable && (p_sys->b_fastseekable || b_force) )
     {
         MP4_ReadBoxContainerChildren( p_demux->s, p_vroot, NULL ); /* Get the rest of the file */
         p_sys->b_fragments_probed = true;
@@ -4256,45 +4457,18 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                 if( p_moof->i_type != ATOM_moof )
                     continue;
 
-                for( unsigned i=0; i<p_sys->i_tracks; i++ )
-                {
-                    MP4_Box_t *p_tfdt = NULL;
-                    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, p_sys->track[i].i_track_ID );
-                    if( p_traf )
-                        p_tfdt = MP4_BoxGet( p_traf, "tfdt" );
-
-                    if( p_tfdt && BOXDATA(p_tfdt) )
-                    {
-                        pi_track_times[i] = p_tfdt->data.p_tfdt->i_base_media_decode_time;
-                    }
-                    else if( index == 0 ) /* Set first fragment time offset from moov */
-                    {
-                        stime_t i_duration = GetMoovTrackDuration( p_sys, p_sys->track[i].i_track_ID );
-                        pi_track_times[i] = MP4_rescale( i_duration, p_sys->i_timescale, p_sys->track[i].i_timescale );
-                    }
-
-                    stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                    p_sys->p_fragsindex->p_times[index * p_sys->i_tracks + i] = i_movietime;
-
-                    stime_t i_duration = 0;
-                    if( GetMoofTrackDuration( p_sys->p_moov, p_moof, p_sys->track[i].i_track_ID, &i_duration ) )
-                        pi_track_times[i] += i_duration;
-                }
-
+                FragIndexMoof( p_sys, p_moof, index, pi_track_times,
+                               &p_sys->p_fragsindex->p_times[index * p_sys->i_tracks] );
                 p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
             }
 
-            for( unsigned i=0; i<p_sys->i_tracks; i++ )
-            {
-                stime_t i_movietime = MP4_rescale( pi_track_times[i], p_sys->track[i].i_timescale, p_sys->i_timescale );
-                if( p_sys->p_fragsindex->i_last_time < i_movietime )
-                    p_sys->p_fragsindex->i_last_time = i_movietime;
-            }
+            p_sys->p_fragsindex->i_last_time = FragIndexLastTime( p_sys, pi_track_times );
 
             free( pi_track_times );
 #ifdef MP4_VERBOSE
             MP4_Fragments_Index_Dump( VLC_OBJECT(p_demux), p_sys->p_fragsindex, p_sys->i_timescale );
 #endif
+            FragIndexCacheSave( p_demux );
         }
     }
     else
@@ -4327,6 +4501,14 @@ static int ProbeFragmentsChecked( demux_t *p_demux )
     if( p_sys->b_fragments_probed )
         return VLC_SUCCESS;
 
+    if( FragIndexerJoin( p_demux, false ) )
+    {
+        p_sys->b_fragments_probed = true;
+        if( !MP4_BoxGet( p_sys->p_moov, "mvex/mehd") )
+            p_sys->i_cumulated_duration = GetCumulatedDuration( p_demux );
+        return VLC_SUCCESS;
+    }
+
     if( !p_sys->b_fastseekable )
     {
         const char *psz_msg = _(
@@ -4362,6 +4544,306 @@ static int ProbeFragmentsChecked( demux_t *p_demux )
     return i_ret;
 }
 
+/* Identifies the indexed file: the index is only reused for the same
+ * size, movie box and tracks */
+static uint8_t * FragIndexCacheKey( demux_t *p_demux, stream_t *s, uint32_t *pi_key )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    uint64_t i_size;
+
+    if( vlc_stream_GetSize( s, &i_size ) != VLC_SUCCESS )
+        return NULL;
+
+    *pi_key = 8 + 8 + 8 + 4 + 4 + 8 * p_sys->i_tracks;
+    uint8_t *p_key = malloc( *pi_key );
+    if( !p_key )
+        return NULL;
+
+    SetQWBE( &p_key[0], i_size );
+    SetQWBE( &p_key[8], p_sys->p_moov->i_pos );
+    SetQWBE( &p_key[16], p_sys->p_moov->i_size );
+    SetDWBE( &p_key[24], p_sys->i_timescale );
+    SetDWBE( &p_key[28], p_sys->i_tracks );
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        SetDWBE( &p_key[32 + 8 * i], p_sys->track[i].i_track_ID );
+        SetDWBE( &p_key[36 + 8 * i], p_sys->track[i].i_timescale );
+    }
+    return p_key;
+}
+
+static char * FragIndexCachePath( demux_t *p_demux, bool b_create )
+{
+    if( !var_InheritBool( p_demux, CFG_PREFIX"fragments-index-cache" ) ||
+        !p_demux->psz_url || !*p_demux->psz_url )
+        return NULL;
+
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_cachedir )
+        return NULL;
+
+    vlc_hash_md5_t md5;
+    char psz_hash[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, p_demux->psz_url, strlen( p_demux->psz_url ) );
+    vlc_hash_FinishHex( &md5, psz_hash );
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s" DIR_SEP "mp4", psz_cachedir ) < 0 )
+        psz_path = NULL;
+    if( psz_path && b_create )
+    {
+        vlc_mkdir( psz_cachedir, 0700 );
+        vlc_mkdir( psz_path, 0700 );
+    }
+    free( psz_path );
+
+    if( asprintf( &psz_path, "%s" DIR_SEP "mp4" DIR_SEP "%s.fragments",
+                  psz_cachedir, psz_hash ) < 0 )
+        psz_path = NULL;
+    free( psz_cachedir );
+    return psz_path;
+}
+
+static bool FragIndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    mp4_fragments_index_t *p_index = NULL;
+
+    char *psz_path = FragIndexCachePath( p_demux, false );
+    if( !psz_path )
+        return false;
+
+    uint32_t i_key;
+    uint8_t *p_key = FragIndexCacheKey( p_demux, p_demux->s, &i_key );
+    FILE *p_file = p_key ? vlc_fopen( psz_path, "rb" ) : NULL;
+    if( p_file )
+    {
+        p_index = MP4_Fragments_Index_Read( p_file, p_key, i_key );
+        fclose( p_file );
+    }
+    free( p_key );
+
+    if( p_index && p_index->i_tracks != p_sys->i_tracks )
+    {
+        MP4_Fragments_Index_Delete( p_index );
+        p_index = NULL;
+    }
+
+    if( p_index )
+    {
+        msg_Dbg( p_demux, "loaded %u fragments index from %s",
+                 p_index->i_entries, psz_path );
+        MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+        p_sys->p_fragsindex = p_index;
+        p_sys->b_fragments_probed = true;
+    }
+    free( psz_path );
+    return p_index != NULL;
+}
+
+static void FragIndexCacheSaveIndex( demux_t *p_demux, stream_t *s,
+                                     const mp4_fragments_index_t *p_index )
+{
+    char *psz_path = FragIndexCachePath( p_demux, true );
+    if( !psz_path )
+        return;
+
+    char *psz_tmp;
+    uint32_t i_key;
+    uint8_t *p_key = FragIndexCacheKey( p_demux, s, &i_key );
+    if( p_key && asprintf( &psz_tmp, "%s.part", psz_path ) >= 0 )
+    {
+        FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+        if( p_file )
+        {
+            int i_ret = MP4_Fragments_Index_Write( p_index, p_file, p_key, i_key );
+            if( fclose( p_file ) )
+                i_ret = VLC_EGENERIC;
+            if( i_ret == VLC_SUCCESS && vlc_rename( psz_tmp, psz_path ) == 0 )
+                msg_Dbg( p_demux, "saved fragments index to %s", psz_path );
+            else
+                vlc_unlink( psz_tmp );
+        }
+        else
+            msg_Warn( p_demux, "cannot save fragments index to %s: %s",
+                      psz_tmp, vlc_strerror_c(errno) );
+        free( psz_tmp );
+    }
+    free( p_key );
+    free( psz_path );
+}
+
+static void FragIndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    FragIndexCacheSaveIndex( p_demux, p_demux->s, p_sys->p_fragsindex );
+}
+
+/* Builds the fragments index on its own stream, one moof at a time.
+ * Only reads the demuxer state that is constant after opening. */
+static void *FragIndexerThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const unsigned i_tracks = p_sys->i_tracks;
+    const unsigned i_rate = p_sys->fragsindexer.i_rate;
+    uint64_t *pi_pos = NULL;
+    stime_t *p_times = NULL;
+    unsigned i_entries = 0, i_alloc = 0;
+
+    vlc_interrupt_set( p_sys->fragsindexer.p_interrupt );
+
+    stime_t *pi_track_times = calloc( i_tracks, sizeof(*pi_track_times) );
+    stream_t *s = vlc_stream_NewURL( p_demux, p_demux->psz_url );
+    if( !pi_track_times || !s ||
+        vlc_stream_Seek( s, p_sys->p_moov->i_pos + p_sys->p_moov->i_size ) != VLC_SUCCESS )
+        goto end;
+
+    const vlc_tick_t i_start = vlc_tick_now();
+    uint64_t i_read = 0;
+
+    for( ;; )
+    {
+        MP4_Box_t *p_chunk = MP4_BoxGetNextChunk( s );
+        if( !p_chunk )
+            break;
+
+        for( MP4_Box_t *p_moof = p_chunk->p_first; p_moof; p_moof = p_moof->p_next )
+        {
+            /* Data boxes are skipped, only their header is actually read */
+            if( p_moof->i_type != ATOM_moof )
+            {
+                i_read += p_moof->i_type == ATOM_mdat ? 16 : p_moof->i_size;
+                continue;
+            }
+            i_read += p_moof->i_size;
+
+            if( i_entries == i_alloc )
+            {
+                unsigned i_new = i_alloc ? i_alloc * 2 : 256;
+                uint64_t *pi_newpos = NULL;
+                stime_t *p_newtimes = NULL;
+                if( i_new > i_alloc )
+                {
+                    pi_newpos = vlc_reallocarray( pi_pos, i_new, sizeof(*pi_pos) );
+                    if( pi_newpos )
+                        pi_pos = pi_newpos;
+                    p_newtimes = vlc_reallocarray( p_times, (size_t)i_new * i_tracks,
+                                                   sizeof(*p_times) );
+                    if( p_newtimes )
+                        p_times = p_newtimes;
+                }
+                if( !pi_newpos || !p_newtimes )
+                {
+                    MP4_BoxFree( p_chunk );
+                    i_entries = 0;
+                    goto end;
+                }
+                i_alloc = i_new;
+            }
+
+            FragIndexMoof( p_sys, p_moof, i_entries, pi_track_times,
+                           &p_times[(size_t)i_entries * i_tracks] );
+            pi_pos[i_entries++] = p_moof->i_pos;
+        }
+        MP4_BoxFree( p_chunk );
+
+        while( i_rate && !atomic_load( &p_sys->fragsindexer.b_hurry ) )
+        {
+            vlc_tick_t i_wait = i_start + vlc_tick_from_samples( i_read, i_rate * 1024 )
+                              - vlc_tick_now();
+            if( i_wait <= 0 )
+                break;
+            if( vlc_msleep_i11e( __MIN(i_wait, VLC_TICK_FROM_MS(100)) ) )
+                goto end;
+        }
+
+        if( vlc_killed() )
+            goto end;
+    }
+
+    if( !vlc_killed() && i_entries )
+    {
+        mp4_fragments_index_t *p_index = MP4_Fragments_Index_New( i_tracks, i_entries );
+        if( p_index )
+        {
+            memcpy( p_index->pi_pos, pi_pos, i_entries * sizeof(*pi_pos) );
+            memcpy( p_index->p_times, p_times,
+                    (size_t)i_entries * i_tracks * sizeof(*p_times) );
+            p_index->i_last_time = FragIndexLastTime( p_sys, pi_track_times );
+            msg_Dbg( p_demux, "indexed %u fragments in %"PRId64" ms", i_entries,
+                     MS_FROM_VLC_TICK(vlc_tick_now() - i_start) );
+            FragIndexCacheSaveIndex( p_demux, s, p_index );
+            p_sys->fragsindexer.p_index = p_index;
+        }
+    }
+
+end:
+    if( s )
+        vlc_stream_Delete( s );
+    free( pi_track_times );
+    free( pi_pos );
+    free( p_times );
+    return NULL;
+}
+
+static void FragIndexerStart( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_demux->psz_url || !*p_demux->psz_url )
+        return;
+
+    p_sys->fragsindexer.p_interrupt = vlc_interrupt_create();
+    if( unlikely(p_sys->fragsindexer.p_interrupt == NULL) )
+        return;
+
+    atomic_init( &p_sys->fragsindexer.b_hurry, false );
+    int64_t i_rate = var_InheritInteger( p_demux, CFG_PREFIX"fragments-index-rate" );
+    p_sys->fragsindexer.i_rate = VLC_CLIP( i_rate, 0, INT_MAX / 1024 );
+    p_sys->fragsindexer.p_index = NULL;
+
+    if( vlc_clone( &p_sys->fragsindexer.thread, FragIndexerThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_interrupt_destroy( p_sys->fragsindexer.p_interrupt );
+        return;
+    }
+    p_sys->fragsindexer.b_running = true;
+}
+
+/* Waits for the background index, and uses it unless aborting */
+static bool FragIndexerJoin( demux_t *p_demux, bool b_abort )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->fragsindexer.b_running )
+        return false;
+
+    if( b_abort )
+        vlc_interrupt_kill( p_sys->fragsindexer.p_interrupt );
+    else
+        atomic_store( &p_sys->fragsindexer.b_hurry, true );
+
+    vlc_join( p_sys->fragsindexer.thread, NULL );
+    vlc_interrupt_destroy( p_sys->fragsindexer.p_interrupt );
+    p_sys->fragsindexer.b_running = false;
+
+    mp4_fragments_index_t *p_index = p_sys->fragsindexer.p_index;
+    p_sys->fragsindexer.p_index = NULL;
+    if( !p_index || b_abort )
+    {
+        MP4_Fragments_Index_Delete( p_index );
+        return false;
+    }
+
+    msg_Dbg( p_demux, "using background fragments index" );
+    MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
+    p_sys->p_fragsindex = p_index;
+    return true;
+}
+
 static void FragResetContext( demux_sys_t *p_sys )
 {
     if( p_sys->context.p_fragment_atom )
@@ -138,12 +138,15 @@ typedef struct
     uint32_t         i_sample_count;
 
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
+    /* backing storage of the chunks stts/ctts extracts, one block per table */
+    uint32_t       *p_chunks_tts_dts;
+    uint32_t       *p_chunks_tts_pts;
 
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-//                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* points into the stsz box, XXX perhaps add
+//                              file offset if take too much time to do sumations each time*/
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
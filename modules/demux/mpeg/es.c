@@ -363,6 +363,10 @@ static int Demux( demux_t *p_demux )
                      p_block_out ? p_sys->i_time_offset + p_block_out->i_dts
                                  : VLC_TICK_INVALID );
 
+    /* Send all the packetized blocks at once, then the PCR of the last one */
+    block_t *p_chain = p_block_out;
+    vlc_tick_t i_pcr = VLC_TICK_INVALID;
+
     while( p_block_out )
     {
         block_t *p_next = p_block_out->p_next;
@@ -388,7 +392,7 @@ static int Demux( demux_t *p_demux )
         if( p_block_out->i_dts != VLC_TICK_INVALID )
         {
             p_block_out->i_dts += p_sys->i_time_offset;
-            es_out_SetPCR( p_demux->out, p_block_out->i_dts );
+            i_pcr = p_block_out->i_dts;
         }
         /* Re-estimate bitrate */
         if( p_sys->b_estimate_bitrate && p_sys->i_pts > VLC_TICK_FROM_MS(500) )
@@ -396,12 +400,15 @@ static int Demux( demux_t *p_demux )
                                    / (p_sys->i_pts - 1);
         p_sys->i_bytes += p_block_out->i_buffer;
 
-
-        p_block_out->p_next = NULL;
-        es_out_Send( p_demux->out, p_sys->p_es, p_block_out );
-
         p_block_out = p_next;
     }
+
+    if( p_chain )
+    {
+        es_out_SendChain( p_demux->out, p_sys->p_es, p_chain );
+        if( i_pcr != VLC_TICK_INVALID )
+            es_out_SetPCR( p_demux->out, i_pcr );
+    }
     return ret;
 }
 
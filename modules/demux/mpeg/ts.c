@@ -44,6 +44,7 @@
 #include "ts_psip.h"
 
 #include "ts_hotfixes.h"
+#include "ts_sync.h"
 #include "ts_sl.h"
 #include "ts_metadata.h"
 #include "sections.h"
@@ -120,6 +121,19 @@ static void Close ( vlc_object_t * );
 #define TS_OFFSETFIX_TEXT   "Try to fix too early PCR (or late DTS)"
 #define TS_GENERATED_PCR_OFFSET_TEXT "Offset in ms for generated PCR"
 
+#define BULK_TEXT N_("Packets read at once")
+#define BULK_LONGTEXT N_( \
+    "Number of TS packets fetched from the input in a single read. " \
+    "Packets are then parsed in place, without a separate allocation. " \
+    "Larger values reduce overhead on high bitrate streams, " \
+    "1 reads packets one by one." )
+
+#define INDEX_TEXT N_("Seek index entries")
+#define INDEX_LONGTEXT N_( \
+    "Maximum number of PCR positions remembered per program while " \
+    "playing, to seek without searching the whole file. " \
+    "The index gets sparser once full, 0 disables it." )
+
 #define PCR_TEXT N_("Trust in-stream PCR")
 #define PCR_LONGTEXT N_("Use the stream PCR as a reference.")
 
@@ -163,6 +177,10 @@ vlc_module_begin ()
     add_bool( "ts-pcr-offsetfix", true, TS_OFFSETFIX_TEXT, NULL, true )
     add_integer_with_range( "ts-generated-pcr-offset", 120, 0, 500,
                             TS_GENERATED_PCR_OFFSET_TEXT, NULL, true )
+    add_integer_with_range( "ts-bulk-read", 64, 1, 512,
+                            BULK_TEXT, BULK_LONGTEXT, true )
+    add_integer_with_range( "ts-index-entries", 16384, 0, 1 << 20,
+                            INDEX_TEXT, INDEX_LONGTEXT, true )
 
     add_obsolete_bool( "ts-silent" );
 
@@ -196,7 +214,9 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
-static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
+static block_t* PeekTSPacket( demux_t *p_demux, block_t *p_view );
+static void FlushTSPacketView( demux_t *p_demux );
+static int SeekToTime( demux_t *p_demux, ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
@@ -220,8 +240,10 @@ static int DetectPacketSize( demux_t *p_demux, unsigned *pi_header_size, int i_o
 
     for( int i_sync = 0; i_sync < TS_PACKET_SIZE_MAX; i_sync++ )
     {
-        if( p_peek[i_offset + i_sync] != 0x47 )
-            continue;
+        i_sync += ts_sync_Find( &p_peek[i_offset + i_sync],
+                                TS_PACKET_SIZE_MAX - i_sync, 0 );
+        if( i_sync >= TS_PACKET_SIZE_MAX )
+            break;
 
         /* Check next 3 sync bytes */
         int i_peek = i_offset + TS_PACKET_SIZE_MAX * 3 + i_sync + 1;
@@ -404,10 +426,14 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->bulk.i_count = 1;
+    p_sys->bulk.i_start = p_sys->bulk.i_end = 0;
+    p_sys->bulk.b_pending = false;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
+    p_sys->i_index_max = var_InheritInteger( p_demux, "ts-index-entries" );
 
-    vlc_dictionary_init( &p_sys->attachments, 0 );
+    vlc_hashmap_init_str( &p_sys->attachments );
 
     p_sys->patfix.i_first_dts = -1;
     p_sys->patfix.i_timesourcepid = 0;
@@ -502,6 +528,8 @@ static int Open( vlc_object_t *p_this )
     p_sys->b_lowdelay = var_InheritBool( p_demux, "low-delay" );
     p_sys->b_ignore_time_for_positions = var_InheritBool( p_demux, "ts-seek-percent" );
     p_sys->b_cc_check = var_InheritBool( p_demux, "ts-cc-check" );
+    if( !p_sys->b_lowdelay )
+        p_sys->bulk.i_count = var_InheritInteger( p_demux, "ts-bulk-read" );
 
     p_sys->standard = TS_STANDARD_AUTO;
     char *psz_standard = var_InheritString( p_demux, "ts-standard" );
@@ -549,7 +577,7 @@ static int Open( vlc_object_t *p_this )
 /*****************************************************************************
  * Close
  *****************************************************************************/
-static void FreeDictAttachment( void *p_value, void *p_obj )
+static void FreeAttachment( void *p_value, void *p_obj )
 {
     VLC_UNUSED(p_obj);
     vlc_input_attachment_Delete( (input_attachment_t *) p_value );
@@ -588,7 +616,7 @@ static void Close( vlc_object_t *p_this )
     ts_pid_list_Release( p_demux, &p_sys->pids );
 
     /* Clear up attachments */
-    vlc_dictionary_clear( &p_sys->attachments, FreeDictAttachment, NULL );
+    vlc_hashmap_clear( &p_sys->attachments, FreeAttachment, NULL );
 
     free( p_sys );
 }
@@ -631,13 +659,29 @@ static int Demux( demux_t *p_demux )
         GetPID(p_sys, 0)->u.p_pat->b_generated = true;
     }
 
+    /* Once the PAT is known and ES are created, packets from PIDs nobody
+     * selected can be dropped before any PID lookup (emulated HW filter) */
+    const bool b_fast_reject = !p_sys->b_access_control &&
+                               p_sys->seltype != PROGRAM_ALL &&
+                               p_sys->es_creation == CREATE_ES &&
+                               p_sys->b_end_preparse &&
+                               SEEN(GetPID(p_sys, 0));
+    if( b_fast_reject )
+        ts_pid_list_UpdateInterest( &p_sys->pids );
+
     /* We read at most 100 TS packet or until a frame is completed */
     for( unsigned i_pkt = 0; i_pkt < p_sys->i_ts_read; i_pkt++ )
     {
         bool         b_frame = false;
         int          i_header = 0;
+        block_t      view;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+
+        if( p_sys->bulk.i_count > 1 && !p_sys->b_start_record )
+            p_pkt = PeekTSPacket( p_demux, &view );
+        else
+            p_pkt = ReadTSPacket( p_demux );
+        if( !p_pkt )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -657,6 +701,13 @@ static int Demux( demux_t *p_demux )
             continue;
         }
 
+        if( b_fast_reject &&
+            !ts_pid_IsInteresting( &p_sys->pids, PIDGet( p_pkt ) ) )
+        {
+            block_Release( p_pkt );
+            continue;
+        }
+
         /* Reject any fully uncorrected packet. Even PID can be incorrect */
         if( p_pkt->p_buffer[1]&0x80 )
         {
@@ -731,7 +782,12 @@ static int Demux( demux_t *p_demux )
 
             if( p_pid->u.p_stream->transport == TS_TRANSPORT_PES )
             {
-                b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
+                /* Payload is kept in the PES chain: the packet can no
+                 * longer be a view over the input buffer */
+                if( p_pkt == &view )
+                    p_pkt = block_Duplicate( &view );
+                if( likely(p_pkt) )
+                    b_frame = GatherPESData( p_demux, p_pid, p_pkt, i_header );
             }
             else if( p_pid->u.p_stream->transport == TS_TRANSPORT_SECTIONS )
             {
@@ -767,6 +823,8 @@ static int Demux( demux_t *p_demux )
             break;
     }
 
+    FlushTSPacketView( p_demux );
+
     demux_UpdateTitleFromStream( p_demux );
     return VLC_DEMUXER_SUCCESS;
 }
@@ -813,6 +871,9 @@ void UpdatePESFilters( demux_t *p_demux, bool b_all )
     demux_sys_t *p_sys = p_demux->p_sys;
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
+    /* Invalidate the fast reject map */
+    p_sys->pids.b_interest_dirty = true;
+
     /* We need 3 pass to avoid loss on deselect/relesect with hw filters and
        because pid could be shared and its state altered by another unselected pmt
        First clear flag on every referenced pid
@@ -896,7 +957,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     bool b_bool, *pb_bool;
     int64_t i64;
     int i_int;
-    const ts_pmt_t *p_pmt = NULL;
+    ts_pmt_t *p_pmt = NULL;
     const ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
 
     for( int i=0; i<p_pat->programs.i_size && !p_pmt; i++ )
@@ -1067,6 +1128,10 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             stime_t i_start = (p_pmt->pcr.i_first > -1) ? p_pmt->pcr.i_first :
                               p_pmt->pcr.i_first_dts;
             stime_t i_last = TimeStampWrapAround( p_pmt->pcr.i_first, p_pmt->i_last_dts );
+            /* Played past the last probed DTS */
+            const ts_index_entry_t *p_last = ts_index_Last( &p_pmt->index );
+            if( p_last && p_last->i_time > i_last )
+                i_last = p_last->i_time;
             i_last += p_pmt->pcr.i_pcroffset;
             *va_arg( args, vlc_tick_t * ) = FROM_SCALE(i_last - i_start);
             return VLC_SUCCESS;
@@ -1184,7 +1249,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         input_attachment_t ***ppp_attach = va_arg( args, input_attachment_t *** );
         int *pi_int = va_arg( args, int * );
 
-        *pi_int = vlc_dictionary_keys_count( &p_sys->attachments );
+        *pi_int = vlc_hashmap_count( &p_sys->attachments );
         if( *pi_int <= 0 )
             return VLC_EGENERIC;
 
@@ -1193,17 +1258,14 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             return VLC_EGENERIC;
 
         *pi_int = 0;
-        for( int i = 0; i < p_sys->attachments.i_size; i++ )
+        struct vlc_hashmap_slot *p_slot;
+        vlc_hashmap_foreach( p_slot, &p_sys->attachments )
         {
-            for( vlc_dictionary_entry_t *p_entry = p_sys->attachments.p_entries[i];
-                                         p_entry; p_entry = p_entry->p_next )
-            {
-                msg_Err(p_demux, "GET ATTACHMENT %s", p_entry->psz_key);
-                (*ppp_attach)[*pi_int] = vlc_input_attachment_Duplicate(
-                                                (input_attachment_t *) p_entry->p_value );
-                if( (*ppp_attach)[*pi_int] )
-                    (*pi_int)++;
-            }
+            msg_Err(p_demux, "GET ATTACHMENT %s", p_slot->key.str);
+            (*ppp_attach)[*pi_int] = vlc_input_attachment_Duplicate(
+                                            (input_attachment_t *) p_slot->value );
+            if( (*ppp_attach)[*pi_int] )
+                (*pi_int)++;
         }
 
         return VLC_SUCCESS;
@@ -1451,6 +1513,29 @@ static block_t * ConvertPESBlock( demux_t *p_demux, ts_es_t *p_es,
     return p_block;
 }
 
+static block_t * DuplicateChain( const block_t *p_chain )
+{
+    block_t *p_dups = NULL;
+    block_t **pp_last = &p_dups;
+    for( ; p_chain; p_chain = p_chain->p_next )
+    {
+        block_t *p_dup = block_Duplicate( p_chain );
+        if( p_dup )
+            block_ChainLastAppend( &pp_last, p_dup );
+    }
+    return p_dups;
+}
+
+static void SendDuplicateChain( demux_t *p_demux, ts_es_t *p_es,
+                                const block_t *p_chain )
+{
+    if( !p_es->id )
+        return;
+    block_t *p_dups = DuplicateChain( p_chain );
+    if( p_dups )
+        es_out_SendChain( p_demux->out, p_es->id, p_dups );
+}
+
 /****************************************************************************
  * fanouts current block to all subdecoders / shared pid es
  ****************************************************************************/
@@ -1458,66 +1543,48 @@ static void SendDataChain( demux_t *p_demux, ts_es_t *p_es, block_t *p_chain )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    while( p_chain )
-    {
-        block_t *p_block = p_chain;
-        p_chain = p_block->p_next;
-        p_block->p_next = NULL;
+    if( !p_chain )
+        return;
 
+    for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+    {
         /* clean up any private flag */
         p_block->i_flags &= ~BLOCK_FLAG_PRIVATE_MASK;
 
         if( p_sys->b_lowdelay )
             p_block->i_flags |= BLOCK_FLAG_AU_END;
+    }
+
+    if( p_es->i_next_block_flags )
+    {
+        p_chain->i_flags |= p_es->i_next_block_flags;
+        p_es->i_next_block_flags = 0;
+    }
+
+    /* The whole chain goes to each es at once */
+    for( ts_es_t *p_es_send = p_es; p_es_send; p_es_send = p_es_send->p_next )
+    {
+        if( !p_es_send->p_program->b_selected )
+            continue;
 
-        ts_es_t *p_es_send = p_es;
-        if( p_es_send->i_next_block_flags )
+        /* Send a copy to each extra es */
+        for( ts_es_t *p_extra_es = p_es_send->p_extraes; p_extra_es;
+             p_extra_es = p_extra_es->p_next )
+            SendDuplicateChain( p_demux, p_extra_es, p_chain );
+
+        if( p_es_send->p_next )
         {
-            p_block->i_flags |= p_es_send->i_next_block_flags;
-            p_es_send->i_next_block_flags = 0;
+            SendDuplicateChain( p_demux, p_es_send, p_chain );
         }
-
-        while( p_es_send )
+        else if( p_es_send->id )
         {
-            if( p_es_send->p_program->b_selected )
-            {
-                /* Send a copy to each extra es */
-                ts_es_t *p_extra_es = p_es_send->p_extraes;
-                while( p_extra_es )
-                {
-                    if( p_extra_es->id )
-                    {
-                        block_t *p_dup = block_Duplicate( p_block );
-                        if( p_dup )
-                            es_out_Send( p_demux->out, p_extra_es->id, p_dup );
-                    }
-                    p_extra_es = p_extra_es->p_next;
-                }
-
-                if( p_es_send->p_next )
-                {
-                    if( p_es_send->id )
-                    {
-                        block_t *p_dup = block_Duplicate( p_block );
-                        if( p_dup )
-                            es_out_Send( p_demux->out, p_es_send->id, p_dup );
-                    }
-                }
-                else
-                {
-                    if( p_es_send->id )
-                    {
-                        es_out_Send( p_demux->out, p_es_send->id, p_block );
-                        p_block = NULL;
-                    }
-                }
-            }
-            p_es_send = p_es_send->p_next;
+            es_out_SendChain( p_demux->out, p_es_send->id, p_chain );
+            p_chain = NULL;
         }
-
-        if( p_block )
-            block_Release( p_block );
     }
+
+    if( p_chain )
+        block_ChainRelease( p_chain );
 }
 
 /****************************************************************************
@@ -1801,26 +1868,23 @@ static block_t* ReadTSPacket( demux_t *p_demux )
 
             i_peek = vlc_stream_Peek( p_sys->stream, &p_peek,
                     p_sys->i_packet_size * 10 );
-            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size + 1 )
+            if( i_peek < 0 || (unsigned)i_peek < p_sys->i_packet_size +
+                                                 p_sys->i_packet_header_size + 1 )
             {
                 msg_Dbg( p_demux, "eof ?" );
                 return NULL;
             }
 
-            while( i_skip < i_peek - p_sys->i_packet_size )
-            {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
-                {
-                    break;
-                }
-                i_skip++;
-            }
+            /* Look for two consecutive sync bytes */
+            const unsigned i_scan = i_peek - p_sys->i_packet_size
+                                           - p_sys->i_packet_header_size;
+            i_skip = ts_sync_Find( &p_peek[p_sys->i_packet_header_size],
+                                   i_scan, p_sys->i_packet_size );
             msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
             if (vlc_stream_Read( p_sys->stream, NULL, i_skip ) != i_skip)
                 return NULL;
 
-            if( i_skip < i_peek - p_sys->i_packet_size )
+            if( i_skip < i_scan )
             {
                 break;
             }
@@ -1834,6 +1898,74 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+static void TSPacketViewRelease( block_t *p_view )
+{
+    /* The view points into the stream peek buffer, which is released
+     * by the stream itself once consumed */
+    VLC_UNUSED(p_view);
+}
+
+static const struct vlc_block_callbacks ts_packet_view_cbs =
+{
+    TSPacketViewRelease,
+};
+
+/* Consumes the packet previously returned by PeekTSPacket() */
+static void FlushTSPacketView( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->bulk.b_pending )
+    {
+        vlc_stream_Read( p_sys->stream, NULL, p_sys->i_packet_size );
+        p_sys->bulk.b_pending = false;
+    }
+}
+
+/* Returns the next TS packet as a view over the stream peek buffer.
+ * Packets are peeked by groups of bulk.i_count, so that a single input
+ * read serves many packets, and no per packet allocation happens.
+ * The view is only valid until the next stream call, and must be
+ * duplicated to be kept. */
+static block_t* PeekTSPacket( demux_t *p_demux, block_t *p_view )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const uint8_t *p_peek;
+
+    FlushTSPacketView( p_demux );
+
+    const uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    size_t i_want = p_sys->i_packet_size;
+    bool b_refill = i_pos < p_sys->bulk.i_start ||
+                    i_pos + p_sys->i_packet_size > p_sys->bulk.i_end;
+    if( b_refill )
+        i_want *= p_sys->bulk.i_count;
+
+    ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_peek, i_want );
+    if( i_peek < (ssize_t)p_sys->i_packet_size ||
+        p_peek[p_sys->i_packet_header_size] != 0x47 )
+    {
+        /* EOF, truncated or unsynchronized: use the slow path */
+        p_sys->bulk.i_start = p_sys->bulk.i_end = 0;
+        return ReadTSPacket( p_demux );
+    }
+
+    if( b_refill )
+    {
+        p_sys->bulk.i_start = i_pos;
+        p_sys->bulk.i_end = i_pos + i_peek;
+    }
+
+    /* That memory belongs to the stream peek buffer, which is never reused
+     * before the packet gets consumed, so it can be modified in place
+     * (CSA descrambling) */
+    uint8_t *p_data = (uint8_t *)p_peek + p_sys->i_packet_header_size;
+    block_Init( p_view, &ts_packet_view_cbs, p_data,
+                p_sys->i_packet_size - p_sys->i_packet_header_size );
+    p_sys->bulk.b_pending = true;
+    return p_view;
+}
+
 static stime_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1936,26 +2068,12 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
     }
 }
 
-static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaledtime )
+/* Binary search of i_scaledtime between the given packet offsets */
+static bool SeekToTimeBisect( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_scaledtime,
+                              uint64_t i_head_pos, uint64_t i_tail_pos )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    /* Deal with common but worst binary search case */
-    if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
-        return vlc_stream_Seek( p_sys->stream, 0 );
-
-    const int64_t i_stream_size = stream_Size( p_sys->stream );
-    if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
-        return VLC_EGENERIC;
-
-    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
-
-    /* Find the time position by using binary search algorithm. */
-    uint64_t i_head_pos = 0;
-    uint64_t i_tail_pos = (uint64_t) i_stream_size - p_sys->i_packet_size;
-    if( i_head_pos >= i_tail_pos )
-        return VLC_EGENERIC;
-
     bool b_found = false;
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
@@ -1971,6 +2089,7 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
         while( i_pos < i_tail_pos )
         {
             stime_t i_pcr = -1;
+            bool b_real_pcr = false;
             block_t *p_pkt = ReadTSPacket( p_demux );
             if( !p_pkt )
             {
@@ -1994,7 +2113,10 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
                     if( p_pkt->i_buffer >= 4 + 2 + 5 )
                     {
                         if( p_pmt->i_pid_pcr == i_pid )
+                        {
                             i_pcr = GetPCR( p_pkt );
+                            b_real_pcr = ( i_pcr != -1 );
+                        }
                         i_skip += 1 + __MIN(p_pkt->p_buffer[4], 182);
                     }
                 }
@@ -2017,7 +2139,13 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
 
             if( i_pcr != -1 )
             {
-                stime_t i_diff = i_scaledtime - TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                stime_t i_program_pcr = TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr );
+                /* Probes are as good as played PCR for the next seeks */
+                if( b_real_pcr )
+                    ts_index_Add( &p_pmt->index, i_program_pcr,
+                                  i_pos - p_sys->i_packet_size );
+
+                stime_t i_diff = i_scaledtime - i_program_pcr;
                 if ( i_diff < 0 )
                     i_tail_pos = (i_splitpos >= p_sys->i_packet_size) ? i_splitpos - p_sys->i_packet_size : 0;
                 else if( i_diff < TO_SCALE(VLC_TICK_0 + VLC_TICK_FROM_MS(500)) )
@@ -2032,6 +2160,53 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
             i_tail_pos = (i_splitpos >= p_sys->i_packet_size) ? i_splitpos - p_sys->i_packet_size : 0;
     }
 
+    return b_found;
+}
+
+static int SeekToTime( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_scaledtime )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Deal with common but worst binary search case */
+    if( p_pmt->pcr.i_first == i_scaledtime && p_sys->b_canseek )
+        return vlc_stream_Seek( p_sys->stream, 0 );
+
+    const int64_t i_stream_size = stream_Size( p_sys->stream );
+    if( !p_sys->b_canfastseek || i_stream_size < p_sys->i_packet_size )
+        return VLC_EGENERIC;
+
+    const uint64_t i_initial_pos = vlc_stream_Tell( p_sys->stream );
+
+    /* Find the time position by using binary search algorithm. */
+    uint64_t i_head_pos = 0;
+    uint64_t i_tail_pos = (uint64_t) i_stream_size - p_sys->i_packet_size;
+    if( i_head_pos >= i_tail_pos )
+        return VLC_EGENERIC;
+
+    /* Start from the indexed PCR when close enough, or restrict the search
+     * between the surrounding ones */
+    const ts_index_entry_t *p_before, *p_after;
+    ts_index_Lookup( &p_pmt->index, i_scaledtime, &p_before, &p_after );
+    if( p_before &&
+        i_scaledtime - p_before->i_time < TO_SCALE(VLC_TICK_0 + VLC_TICK_FROM_MS(500)) &&
+        vlc_stream_Seek( p_sys->stream, p_before->i_pos ) == VLC_SUCCESS )
+        return VLC_SUCCESS;
+
+    bool b_found;
+    if( p_before || p_after )
+    {
+        uint64_t i_head = p_before ? p_before->i_pos : i_head_pos;
+        uint64_t i_tail = p_after ? __MIN(p_after->i_pos, i_tail_pos) : i_tail_pos;
+        b_found = SeekToTimeBisect( p_demux, p_pmt, i_scaledtime, i_head, i_tail );
+        /* The index may be wrong after an undetected discontinuity */
+        if( !b_found )
+            b_found = SeekToTimeBisect( p_demux, p_pmt, i_scaledtime,
+                                        i_head_pos, i_tail_pos );
+    }
+    else
+        b_found = SeekToTimeBisect( p_demux, p_pmt, i_scaledtime,
+                                    i_head_pos, i_tail_pos );
+
     if( !b_found )
     {
         msg_Dbg( p_demux, "Seek():cannot find a time position." );
@@ -2352,6 +2527,21 @@ static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr)
     }
 }
 
+/* Remembers where the PCR of the packet being processed was found */
+static void PCRIndexAdd( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_program_pcr )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->b_canfastseek || p_pmt->pcr.i_first == -1 )
+        return;
+
+    /* A peeked packet is not consumed yet */
+    uint64_t i_pos = vlc_stream_Tell( p_sys->stream );
+    if( !p_sys->bulk.b_pending )
+        i_pos -= p_sys->i_packet_size;
+    ts_index_Add( &p_pmt->index, i_program_pcr, i_pos );
+}
+
 static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
@@ -2379,6 +2569,7 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
             {
                 /* ? update PCR for the whole group program ? */
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                PCRIndexAdd( p_demux, p_pmt, i_program_pcr );
             }
         }
         else /* set PCR provided by current pid to program(s) referencing it */
@@ -2389,6 +2580,7 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
                 /* We've found a target group for update */
                 PCRCheckDTS( p_demux, p_pmt, i_pcr );
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                PCRIndexAdd( p_demux, p_pmt, i_program_pcr );
             }
         }
 
@@ -20,6 +20,8 @@
 #ifndef VLC_TS_H
 #define VLC_TS_H
 
+#include <vlc_hashmap.h>
+
 #ifdef HAVE_ARIBB24
     typedef struct arib_instance_t arib_instance_t;
 #endif
@@ -71,9 +73,21 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* bulk reading of packets, see PeekTSPacket() */
+    struct
+    {
+        unsigned i_count;   /* packets per input read */
+        uint64_t i_start;   /* stream range currently in the peek buffer */
+        uint64_t i_end;
+        bool     b_pending; /* last view not consumed yet */
+    } bulk;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
+    /* PCR index entries cap per program, 0 when disabled */
+    size_t      i_index_max;
+
     ts_standards_e standard;
 
     struct
@@ -138,7 +152,7 @@ struct demux_sys_t
     vdr_info_t  vdr;
 
     /* downloadable content */
-    vlc_dictionary_t attachments;
+    vlc_hashmap_t attachments; /* input_attachment_t by name */
 
     /* */
     bool        b_start_record;
@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * ts_index.c : MPEG TS time to byte offset index
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "ts_index.h"
+
+void ts_index_Init( ts_index_t *p_index, size_t i_max )
+{
+    p_index->p_entries = NULL;
+    p_index->i_count = 0;
+    p_index->i_alloc = 0;
+    p_index->i_max = i_max;
+    p_index->i_interval = TS_INDEX_INTERVAL;
+}
+
+void ts_index_Clean( ts_index_t *p_index )
+{
+    free( p_index->p_entries );
+    ts_index_Init( p_index, p_index->i_max );
+}
+
+/* Returns the first entry with a time greater than i_time */
+static size_t ts_index_UpperBound( const ts_index_t *p_index, stime_t i_time )
+{
+    size_t i_low = 0, i_high = p_index->i_count;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->p_entries[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* Drops every other entry, keeping the first one */
+static void ts_index_Decimate( ts_index_t *p_index )
+{
+    size_t j = 0;
+    for( size_t i = 0; i < p_index->i_count; i += 2 )
+        p_index->p_entries[j++] = p_index->p_entries[i];
+    p_index->i_count = j;
+    p_index->i_interval *= 2;
+}
+
+void ts_index_Add( ts_index_t *p_index, stime_t i_time, uint64_t i_pos )
+{
+    if( p_index->i_max == 0 )
+        return;
+
+    size_t k = ts_index_UpperBound( p_index, i_time );
+
+    /* Keep time and offset both increasing, which rejects discontinuities,
+     * and enforce the spacing */
+    if( k > 0 )
+    {
+        const ts_index_entry_t *p_prev = &p_index->p_entries[k - 1];
+        if( i_time - p_prev->i_time < p_index->i_interval ||
+            p_prev->i_pos >= i_pos )
+            return;
+    }
+    if( k < p_index->i_count )
+    {
+        const ts_index_entry_t *p_next = &p_index->p_entries[k];
+        if( p_next->i_time - i_time < p_index->i_interval ||
+            p_next->i_pos <= i_pos )
+            return;
+    }
+
+    if( p_index->i_count >= p_index->i_max )
+    {
+        ts_index_Decimate( p_index );
+        ts_index_Add( p_index, i_time, i_pos );
+        return;
+    }
+
+    if( p_index->i_count == p_index->i_alloc )
+    {
+        size_t i_alloc = __MIN( p_index->i_max,
+                                __MAX( 64, p_index->i_alloc * 2 ) );
+        ts_index_entry_t *p_realloc =
+            realloc( p_index->p_entries, i_alloc * sizeof(*p_realloc) );
+        if( unlikely(p_realloc == NULL) )
+            return;
+        p_index->p_entries = p_realloc;
+        p_index->i_alloc = i_alloc;
+    }
+
+    memmove( &p_index->p_entries[k + 1], &p_index->p_entries[k],
+             (p_index->i_count - k) * sizeof(*p_index->p_entries) );
+    p_index->p_entries[k].i_time = i_time;
+    p_index->p_entries[k].i_pos = i_pos;
+    p_index->i_count++;
+}
+
+void ts_index_Lookup( const ts_index_t *p_index, stime_t i_time,
+                      const ts_index_entry_t **pp_before,
+                      const ts_index_entry_t **pp_after )
+{
+    size_t k = ts_index_UpperBound( p_index, i_time );
+    *pp_before = k > 0 ? &p_index->p_entries[k - 1] : NULL;
+    *pp_after = k < p_index->i_count ? &p_index->p_entries[k] : NULL;
+}
@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * ts_index.h : MPEG TS time to byte offset index
+ *****************************************************************************
+ * Copyright (C) 2024 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+#include "timestamps.h"
+
+/* Minimum spacing between two entries, doubled each time the index
+ * gets full and is decimated */
+#define TS_INDEX_INTERVAL TO_SCALE_NZ(VLC_TICK_FROM_SEC(1))
+
+typedef struct
+{
+    stime_t  i_time; /* program time, wrapped around the first PCR */
+    uint64_t i_pos;  /* offset of the TS packet carrying that PCR */
+} ts_index_entry_t;
+
+/* Sorted PCR to byte offset pairs, filled as PCR are seen
+ * (playback or seek probes), in any order */
+typedef struct
+{
+    ts_index_entry_t *p_entries;
+    size_t  i_count;
+    size_t  i_alloc;
+    size_t  i_max;      /* entries cap, 0 disables the index */
+    stime_t i_interval;
+} ts_index_t;
+
+void ts_index_Init( ts_index_t *, size_t i_max );
+void ts_index_Clean( ts_index_t * );
+void ts_index_Add( ts_index_t *, stime_t i_time, uint64_t i_pos );
+/* Returns the closest entries before (time <= i_time) and after
+ * (time > i_time), or NULL */
+void ts_index_Lookup( const ts_index_t *, stime_t i_time,
+                      const ts_index_entry_t **pp_before,
+                      const ts_index_entry_t **pp_after );
+
+static inline const ts_index_entry_t * ts_index_Last( const ts_index_t *p_index )
+{
+    return p_index->i_count ? &p_index->p_entries[p_index->i_count - 1] : NULL;
+}
+
+#endif
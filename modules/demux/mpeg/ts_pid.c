@@ -31,6 +31,7 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define PID_ALLOC_CHUNK 16
 
@@ -44,6 +45,42 @@ void ts_pid_list_Init( ts_pid_list_t *p_list )
     p_list->i_all_alloc = 0;
     p_list->i_last_pid = 0;
     p_list->p_last = NULL;
+    memset( p_list->interest, 0, sizeof(p_list->interest) );
+    p_list->b_interest_dirty = true;
+}
+
+static void ts_pid_SetInterest( ts_pid_list_t *p_list, const ts_pid_t *p_pid )
+{
+    bool b_interest;
+
+    switch( p_pid->type )
+    {
+        case TYPE_FREE:
+        case TYPE_STREAM:
+            b_interest = p_pid->i_flags & FLAG_FILTERED;
+            break;
+        default: /* PSI, SI, PSIP */
+            b_interest = true;
+            break;
+    }
+
+    if( b_interest )
+        p_list->interest[p_pid->i_pid >> 5] |= UINT32_C(1) << (p_pid->i_pid & 31);
+}
+
+void ts_pid_list_UpdateInterest( ts_pid_list_t *p_list )
+{
+    if( !p_list->b_interest_dirty )
+        return;
+
+    memset( p_list->interest, 0, sizeof(p_list->interest) );
+    /* PAT is always needed */
+    p_list->interest[0] |= 1;
+    ts_pid_SetInterest( p_list, &p_list->base_si );
+    for( int i = 0; i < p_list->i_all; i++ )
+        ts_pid_SetInterest( p_list, p_list->pp_all[i] );
+
+    p_list->b_interest_dirty = false;
 }
 
 void ts_pid_list_Release( demux_t *p_demux, ts_pid_list_t *p_list )
@@ -237,6 +274,9 @@ bool PIDSetup( demux_t *p_demux, ts_pid_type_t i_type, ts_pid_t *pid, ts_pid_t *
 
         pid->i_refcount++;
         pid->type = i_type;
+
+        demux_sys_t *p_sys = p_demux->p_sys;
+        p_sys->pids.b_interest_dirty = true;
     }
     else if( pid->type == i_type && pid->i_refcount < UINT16_MAX )
     {
@@ -309,6 +349,9 @@ void PIDRelease( demux_t *p_demux, ts_pid_t *pid )
 
         SetPIDFilter( p_demux->p_sys, pid, false );
         PIDReset( pid );
+
+        demux_sys_t *p_sys = p_demux->p_sys;
+        p_sys->pids.b_interest_dirty = true;
     }
 }
 
@@ -327,6 +370,7 @@ int SetPIDFilter( demux_sys_t *p_sys, ts_pid_t *p_pid, bool b_selected )
         p_pid->i_flags |= FLAG_FILTERED;
     else
         p_pid->i_flags &= ~FLAG_FILTERED;
+    p_sys->pids.b_interest_dirty = true;
 
     return UpdateHWFilter( p_sys, p_pid );
 }
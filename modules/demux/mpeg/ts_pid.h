@@ -96,6 +96,9 @@ struct ts_pid_list_t
     /* last recently used */
     uint16_t   i_last_pid;
     ts_pid_t  *p_last;
+    /* bitmap of the PIDs which packets need processing */
+    uint32_t   interest[8192 / 32];
+    bool       b_interest_dirty;
 
 };
 
@@ -106,6 +109,14 @@ void ts_pid_list_Release( demux_t *, ts_pid_list_t * );
 /* creates missing pid on the fly */
 ts_pid_t * ts_pid_Get( ts_pid_list_t *, uint16_t i_pid );
 
+/* rebuilds the interest bitmap from the PIDs types and filters, if needed */
+void ts_pid_list_UpdateInterest( ts_pid_list_t * );
+
+static inline bool ts_pid_IsInteresting( const ts_pid_list_t *p_list, uint16_t i_pid )
+{
+    return p_list->interest[i_pid >> 5] & (UINT32_C(1) << (i_pid & 31));
+}
+
 /* returns NULL on end. requires context */
 typedef struct
 {
@@ -506,6 +506,25 @@ static void EITCallBack( demux_t *p_demux, dvbpsi_eit_t *p_eit )
              p_eit->i_ts_id, p_eit->i_network_id,
              p_eit->i_segment_last_section_number, p_eit->i_last_table_id );
 
+    /* Schedule tables are repeated all day long for every service: skip the
+     * versions already sent. The present/following table is re-evaluated as
+     * its current event also depends on the network time. */
+    if( p_eit->i_table_id >= 0x50 && p_eit->i_table_id <= 0x5f )
+    {
+        ts_pat_t *p_pat = ts_pid_Get(&p_sys->pids, 0)->u.p_pat;
+        ts_pmt_t *p_pmt = ts_pat_Get_pmt(p_pat, p_eit->i_extension);
+        if( p_pmt )
+        {
+            int8_t *pi_version = &p_pmt->eit.i_schedule_version[p_eit->i_table_id - 0x50];
+            if( *pi_version == p_eit->i_version )
+            {
+                dvbpsi_eit_delete( p_eit );
+                return;
+            }
+            *pi_version = p_eit->i_version;
+        }
+    }
+
     /* Use table ID for segmenting our EPG tables updates. 1 table id has 256 sections which
      * represents 8 segements of 32 sections each. Thus a max of 24 hours per table ID
      * (Should be even better with tableid+segmentid compound if dvbpsi would export segment id)
@@ -739,15 +758,18 @@ static void ARIB_CDT_RawCallback( dvbpsi_t *p_handle, const dvbpsi_psi_section_t
                                   i_onid, i_logo_id, i_logo_type ) > -1 )
                     {
                         uint8_t *p_png; size_t i_png;
-                        if( !vlc_dictionary_has_key( &p_sys->attachments, psz_name ) &&
+                        if( vlc_hashmap_str_lookup( &p_sys->attachments, psz_name ) == NULL &&
                             ts_arib_inject_png_palette( &p_dmb[7], i_size, &p_png, &i_png ) )
                         {
                             input_attachment_t *p_att = vlc_input_attachment_New(
                                                         psz_name, "image/png", NULL, p_png, i_png );
                             if( p_att )
                             {
-                                vlc_dictionary_insert( &p_sys->attachments, psz_name, p_att );
-                                p_sys->updates |= INPUT_UPDATE_META;
+                                if( vlc_hashmap_str_insert( &p_sys->attachments,
+                                                            psz_name, p_att ) == 0 )
+                                    p_sys->updates |= INPUT_UPDATE_META;
+                                else
+                                    vlc_input_attachment_Delete( p_att );
                             }
                             free( p_png );
                         }
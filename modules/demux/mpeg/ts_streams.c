@@ -124,6 +124,8 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
     pmt->i_last_dts = TS_TICK_UNKNOWN;
     pmt->i_last_dts_byte = 0;
 
+    ts_index_Init( &pmt->index, p_demux->p_sys->i_index_max );
+
     pmt->p_atsc_si_basepid      = NULL;
     pmt->p_si_sdt_pid = NULL;
 
@@ -137,6 +139,7 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
 
     pmt->eit.i_event_length = 0;
     pmt->eit.i_event_start = 0;
+    memset( pmt->eit.i_schedule_version, -1, sizeof(pmt->eit.i_schedule_version) );
 
     pmt->arib.i_download_id = -1;
     pmt->arib.i_logo_id = -1;
@@ -161,6 +164,7 @@ void ts_pmt_Del( demux_t *p_demux, ts_pmt_t *pmt )
     for( int i=0; i<pmt->od.objects.i_size; i++ )
         ODFree( pmt->od.objects.p_elems[i] );
     ARRAY_RESET( pmt->od.objects );
+    ts_index_Clean( &pmt->index );
     if( pmt->i_number > -1 )
         es_out_Control( p_demux->out, ES_OUT_DEL_GROUP, pmt->i_number );
 
@@ -24,6 +24,7 @@ typedef struct ts_sections_processor_t ts_sections_processor_t;
 
 #include "mpeg4_iod.h"
 #include "timestamps.h"
+#include "ts_index.h"
 
 #include <vlc_common.h>
 #include <vlc_es.h>
@@ -71,11 +72,16 @@ struct ts_pmt_t
     {
         time_t i_event_start;
         time_t i_event_length;
+        /* last version of the schedule tables 0x50-0x5f, or -1 */
+        int8_t i_schedule_version[16];
     } eit;
 
     stime_t i_last_dts;
     uint64_t i_last_dts_byte;
 
+    /* PCR to byte offset, for seeking */
+    ts_index_t index;
+
     /* ARIB specific */
     struct
     {
@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * ts_sync.h: TS sync byte scanning
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_SYNC_H
+#define VLC_TS_SYNC_H
+
+#include <vlc_cpu.h>
+
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+#if defined(HAVE_AVX2_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+# include <immintrin.h>
+# define TS_SYNC_AVX2 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+#endif
+
+#define TS_SYNC_BYTE 0x47
+
+/*
+ * All the scanners below look for the first offset i < i_len such that
+ * p[i] == 0x47 and, if i_stride is not 0, p[i + i_stride] == 0x47 too.
+ * The caller must ensure that p[i_len - 1 + i_stride] is readable.
+ * They return i_len if no such offset exists.
+ */
+
+static inline size_t ts_sync_Find_C( const uint8_t *p, size_t i_offset,
+                                     size_t i_len, size_t i_stride )
+{
+    for( ; i_offset < i_len; i_offset++ )
+    {
+        if( p[i_offset] == TS_SYNC_BYTE &&
+            p[i_offset + i_stride] == TS_SYNC_BYTE )
+            break;
+    }
+    return i_offset;
+}
+
+#ifdef TS_SYNC_AVX2
+__attribute__ ((__target__ ("avx2")))
+static inline size_t ts_sync_Find_AVX2( const uint8_t *p, size_t i_len,
+                                        size_t i_stride )
+{
+    const __m256i sync = _mm256_set1_epi8( TS_SYNC_BYTE );
+    size_t i = 0;
+
+    for( ; i + 32 <= i_len; i += 32 )
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i *)&p[i] );
+        __m256i b = _mm256_loadu_si256( (const __m256i *)&p[i + i_stride] );
+        uint32_t mask = _mm256_movemask_epi8(
+                            _mm256_and_si256( _mm256_cmpeq_epi8( a, sync ),
+                                              _mm256_cmpeq_epi8( b, sync ) ) );
+        if( mask )
+            return i + __builtin_ctz( mask );
+    }
+    return ts_sync_Find_C( p, i, i_len, i_stride );
+}
+#endif
+
+static inline size_t ts_sync_Find( const uint8_t *p, size_t i_len,
+                                   size_t i_stride )
+{
+    size_t i = 0;
+
+#ifdef TS_SYNC_AVX2
+    if( vlc_CPU_AVX2() )
+        return ts_sync_Find_AVX2( p, i_len, i_stride );
+#endif
+#if defined(__SSE2__)
+    const __m128i sync = _mm_set1_epi8( TS_SYNC_BYTE );
+
+    for( ; i + 16 <= i_len; i += 16 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)&p[i] );
+        __m128i b = _mm_loadu_si128( (const __m128i *)&p[i + i_stride] );
+        unsigned mask = _mm_movemask_epi8(
+                            _mm_and_si128( _mm_cmpeq_epi8( a, sync ),
+                                           _mm_cmpeq_epi8( b, sync ) ) );
+        if( mask )
+            return i + __builtin_ctz( mask );
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t sync = vdupq_n_u8( TS_SYNC_BYTE );
+
+    for( ; i + 16 <= i_len; i += 16 )
+    {
+        uint8x16_t eq = vandq_u8( vceqq_u8( vld1q_u8( &p[i] ), sync ),
+                                  vceqq_u8( vld1q_u8( &p[i + i_stride] ), sync ) );
+        if( vmaxvq_u8( eq ) )
+            break; /* locate the exact byte below */
+    }
+#endif
+    return ts_sync_Find_C( p, i, i_len, i_stride );
+}
+
+#endif
@@ -125,6 +125,7 @@ static int  Control( demux_t *, int, va_list );
 
 /* Bitstream manipulation */
 static int  Ogg_ReadPage     ( demux_t *, ogg_page * );
+static int64_t Ogg_GetPagePosition( demux_t *, const ogg_page * );
 static void Ogg_DecodePacket ( demux_t *, logical_stream_t *, ogg_packet * );
 static unsigned Ogg_OpusPacketDuration( ogg_packet * );
 static void Ogg_QueueBlocks( demux_t *, logical_stream_t *, block_t * );
@@ -513,6 +514,11 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            /* Remember that page so that seeking back there needs no search */
+            OggSeek_IndexAddGranule( p_stream,
+                                     ogg_page_granulepos( &p_sys->current_page ),
+                                     Ogg_GetPagePosition( p_demux, &p_sys->current_page ) );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -925,6 +931,17 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
     return VLC_SUCCESS;
 }
 
+/* Offset of the page last returned by Ogg_ReadPage(), out of the bytes
+ * read but not yet consumed by the sync layer */
+static int64_t Ogg_GetPagePosition( demux_t *p_demux, const ogg_page *p_oggpage )
+{
+    demux_sys_t *p_ogg = p_demux->p_sys;
+
+    return vlc_stream_Tell( p_demux->s )
+         - ( p_ogg->oy.fill - p_ogg->oy.returned )
+         - p_oggpage->header_len - p_oggpage->body_len;
+}
+
 static void Ogg_SetNextFrame( demux_t *p_demux, logical_stream_t *p_stream,
                               ogg_packet *p_oggpacket )
 {
@@ -2203,7 +2220,7 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
         p_stream->p_es = NULL;
 
         /* initialise kframe index */
-        p_stream->idx=NULL;
+        oggseek_index_init( p_stream );
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2309,10 +2326,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_clean( p_stream );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -92,8 +92,15 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_first_frame_index;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* keyframe index for seeking, created as we discover keyframes,
+     * sorted by both time and page position */
+    struct
+    {
+        demux_index_entry_t *p_entries;
+        size_t i_count;
+        size_t i_alloc;
+        vlc_tick_t i_interval;
+    } idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -60,115 +60,138 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
-
-void oggseek_index_entries_free ( demux_index_entry_t *idx )
+void oggseek_index_init ( logical_stream_t *p_stream )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
+    p_stream->idx.p_entries = NULL;
+    p_stream->idx.i_count = 0;
+    p_stream->idx.i_alloc = 0;
+    p_stream->idx.i_interval = OGGSEEK_INDEX_INTERVAL;
 }
 
+/* free all entries in index */
+
+void oggseek_index_clean ( logical_stream_t *p_stream )
+{
+    free( p_stream->idx.p_entries );
+    oggseek_index_init( p_stream );
+}
 
-/* internal function to create a new list member */
+/* internal function returning the first entry after i_pagepos */
 
-static demux_index_entry_t *index_entry_new( void )
+static size_t index_upper_bound( const logical_stream_t *p_stream, int64_t i_pagepos )
 {
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
+    while ( i_low < i_high )
+    {
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_pagepos <= i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
+   time stamps). Entries breaking the time order (chains, discontinuities)
+   or too close to another one are dropped, and the index gets sparser
+   once full */
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
                                              vlc_tick_t i_timestamp,
                                              int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
-
     if ( p_stream == NULL ) return NULL;
 
-    idx = p_stream->idx;
-
     if ( i_timestamp == VLC_TICK_INVALID || i_pagepos < 1 ) return NULL;
 
-    if ( idx == NULL )
-    {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
+    demux_index_entry_t *p_entries = p_stream->idx.p_entries;
+    size_t i = index_upper_bound( p_stream, i_pagepos );
 
-    while ( idx != NULL )
-    {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
+    if ( i > 0 && ( p_entries[i - 1].i_pagepos == i_pagepos ||
+         i_timestamp - p_entries[i - 1].i_value < p_stream->idx.i_interval ) )
+        return NULL;
+    if ( i < p_stream->idx.i_count &&
+         p_entries[i].i_value - i_timestamp < p_stream->idx.i_interval )
+        return NULL;
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
-    {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
+    if ( p_stream->idx.i_count >= OGGSEEK_INDEX_MAX )
     {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        size_t j = 0;
+        for ( size_t k = 0; k < p_stream->idx.i_count; k += 2 )
+            p_entries[j++] = p_entries[k];
+        p_stream->idx.i_count = j;
+        p_stream->idx.i_interval *= 2;
+        return OggSeek_IndexAdd( p_stream, i_timestamp, i_pagepos );
     }
 
-    if ( idx->p_next != NULL )
+    if ( p_stream->idx.i_count == p_stream->idx.i_alloc )
     {
-        idx->p_next->p_prev = idx;
+        size_t i_alloc = __MIN( OGGSEEK_INDEX_MAX,
+                                __MAX( 64, p_stream->idx.i_alloc * 2 ) );
+        p_entries = realloc( p_entries, i_alloc * sizeof(*p_entries) );
+        if ( !p_entries ) return NULL;
+        p_stream->idx.p_entries = p_entries;
+        p_stream->idx.i_alloc = i_alloc;
     }
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
+    /* new entry; insert before i */
+    memmove( &p_entries[i + 1], &p_entries[i],
+             ( p_stream->idx.i_count - i ) * sizeof(*p_entries) );
+    p_entries[i].i_value = i_timestamp;
+    p_entries[i].i_pagepos = i_pagepos;
+    p_stream->idx.i_count++;
 
-    return idx;
+    return &p_entries[i];
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, vlc_tick_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+/* Any page is a valid starting point when there are no keyframes */
+void OggSeek_IndexAddGranule ( logical_stream_t *p_stream, int64_t i_granule,
+                               int64_t i_pagepos )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    if ( i_granule <= 0 || i_pagepos < p_stream->i_data_start ||
+         p_stream->fmt.i_cat != AUDIO_ES || p_stream->b_oggds ||
+         Ogg_GetKeyframeGranule( p_stream, 0xFF00FF00 ) != 0xFF00FF00 )
+        return;
+
+    vlc_tick_t i_time = Ogg_GranuleToTime( p_stream, i_granule,
+                                           !p_stream->b_contiguous, false );
+    if ( i_time != VLC_TICK_INVALID && i_time >= 0 )
+        OggSeek_IndexAdd( p_stream, i_time, i_pagepos );
+}
+
+/* Returns the last entry before i_timestamp, and narrows the positions
+   around it */
+static const demux_index_entry_t *OggSeekIndexFind ( logical_stream_t *p_stream,
+                                                     vlc_tick_t i_timestamp,
+                                                     int64_t *pi_pos_lower,
+                                                     int64_t *pi_pos_upper )
+{
+    const demux_index_entry_t *p_entries = p_stream->idx.p_entries;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
 
-    while ( idx != NULL )
+    while ( i_low < i_high )
     {
-        if ( idx->i_value <= i_timestamp )
-        {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
-        }
-        idx = idx->p_next;
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_entries[i_mid].i_value <= i_timestamp )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
 
-    return false;
+    if ( i_low < p_stream->idx.i_count )
+        *pi_pos_upper = p_entries[i_low].i_pagepos;
+    if ( i_low == 0 )
+        return NULL;
+    *pi_pos_lower = p_entries[i_low - 1].i_pagepos;
+    return &p_entries[i_low - 1];
+}
+
+/* Whether decoding from that entry reaches i_timestamp without delay */
+static bool OggSeekIndexIsClose ( const logical_stream_t *p_stream,
+                                  const demux_index_entry_t *p_entry,
+                                  vlc_tick_t i_timestamp )
+{
+    return p_entry && i_timestamp - p_entry->i_value <= p_stream->idx.i_interval;
 }
 
 /*********************************************************************
@@ -694,6 +717,7 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
             /* found a page */
+            OggSeek_IndexAddGranule( p_stream, current.i_granule, current.i_pos );
 
             if ( current.i_timestamp <= i_targettime )
             {
@@ -784,9 +808,12 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( i_lowerpos != -1 ) b_found = true;
 
     /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    if ( !b_found )
     {
-        b_found = true;
+        const demux_index_entry_t *p_entry =
+            OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos );
+        if ( OggSeekIndexIsClose( p_stream, p_entry, i_time ) )
+            b_found = true;
     }
 
     /* Or try to be smart with audio fixed bitrate streams */
@@ -796,14 +823,17 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
         /* But only if there's no keyframe/preload requirements */
         /* FIXME: add function to get preload time by codec, ex: opus */
         i_lowerpos = VLC_TICK_0 + (i_time - VLC_TICK_0) * p_sys->i_bitrate / INT64_C(8000000);
+        i_upperpos = -1;
         b_found = true;
     }
 
-    /* or search */
+    /* or search, within the known bounds */
     if ( !b_found && b_fastseek )
     {
         i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                            p_stream->i_data_start, p_sys->i_total_length );
+                        i_lowerpos != -1 ? i_lowerpos : p_stream->i_data_start,
+                        i_upperpos != -1 ? i_upperpos : p_sys->i_total_length );
+        i_upperpos = -1;
         b_found = ( i_lowerpos != -1 );
     }
 
@@ -889,15 +919,21 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     }
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
+    const demux_index_entry_t *p_entry = NULL;
     OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
+        p_entry = OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
     );
 
     i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
     i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
 
-    int64_t i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                       i_offset_lower, i_offset_upper);
+    /* No need to search when an already known page is close enough */
+    int64_t i_pagepos;
+    if ( OggSeekIndexIsClose( p_stream, p_entry, i_time ) )
+        i_pagepos = i_offset_lower;
+    else
+        i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
+                                           i_offset_lower, i_offset_upper);
     if ( i_pagepos >= 0 )
     {
         /* be sure to clear any state or read+pagein() will fail on same # */
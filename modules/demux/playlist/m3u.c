@@ -281,6 +281,7 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
     struct entry_meta_s meta;
     entry_meta_Init( &meta );
     char *    (*pf_dup) (const char *) = p_demux->p_sys;
+    size_t      i_entries = 0;
 
     psz_line = vlc_stream_ReadLine( p_demux->s );
     while( psz_line )
@@ -352,6 +353,15 @@ static int ReadDir( stream_t *p_demux, input_item_node_t *p_subitems )
             /* Cleanup state after entry */
             entry_meta_Clean( &meta );
             entry_meta_Init( &meta );
+
+            /* Let the caller handle this batch, the next call resumes at
+             * the next line */
+            if( p_demux->i_readdir_batch != 0
+             && ++i_entries >= p_demux->i_readdir_batch )
+            {
+                free( psz_line );
+                return 1;
+            }
         }
 
  nextline:
@@ -50,6 +50,11 @@ static void Close( vlc_object_t *p_this );
     N_("Force the subtiles format. Selecting \"auto\" means autodetection and should always work.")
 #define SUB_DESCRIPTION_LONGTEXT \
     N_("Override the default track description.")
+#define SUB_LAZY_TEXT N_("Load subtitles text on demand")
+#define SUB_LAZY_LONGTEXT \
+    N_("Only index the subtitles timings when opening, and read the text " \
+       "of each subtitle from the file when it is due. This saves memory " \
+       "with very large SubRip, SubViewer, SSA/ASS, MicroDVD and SBV files.")
 
 static const char *const ppsz_sub_type[] =
 {
@@ -70,6 +75,7 @@ vlc_module_begin ()
         change_string_list( ppsz_sub_type, ppsz_sub_type )
     add_string( "sub-description", NULL, N_("Subtitle description"),
                 SUB_DESCRIPTION_LONGTEXT, true )
+    add_bool( "sub-lazy", false, SUB_LAZY_TEXT, SUB_LAZY_LONGTEXT, true )
     set_callbacks( Open, Close )
 
     add_shortcut( "subtitle" )
@@ -109,9 +115,19 @@ typedef struct
     size_t  i_line_count;
     size_t  i_line;
     char    **line;
+
+    /* Lines read one by one from s up to i_end instead, see TextStream().
+     * Only the last line is kept, for TextPreviousLine() */
+    stream_t *s;
+    uint64_t i_end;
+    uint64_t i_last_pos;
+    char    *psz_last;
+    bool    b_last_back;
 } text_t;
 
 static int  TextLoad( text_t *, stream_t *s );
+static void TextStream( text_t *, stream_t *s, uint64_t i_end );
+static uint64_t TextTell( const text_t * );
 static void TextUnload( text_t * );
 
 typedef struct
@@ -120,6 +136,11 @@ typedef struct
     vlc_tick_t i_stop;
 
     char    *psz_text;
+
+    /* Source of the subtitle when its text is loaded on demand */
+    uint64_t i_offset;
+    size_t   i_size;
+    size_t   i_index;
 } subtitle_t;
 
 typedef struct
@@ -175,6 +196,10 @@ typedef struct
     subs_properties_t props;
 
     block_t * (*pf_convert)( const subtitle_t * );
+
+    /* subtitles text is parsed when due */
+    bool        b_lazy;
+    int         (*pf_read)( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t*, size_t );
 } demux_sys_t;
 
 static int  ParseMicroDvd   ( vlc_object_t *, subs_properties_t *, text_t *, subtitle_t *, size_t );
@@ -312,6 +337,7 @@ static int Open ( vlc_object_t *p_this )
     p_sys->f_rate = 1.0;
 
     p_sys->pf_convert = ToTextBlock;
+    p_sys->b_lazy = false;
 
     p_sys->subtitles.i_current= 0;
     p_sys->subtitles.i_count  = 0;
@@ -623,8 +649,32 @@ static int Open ( vlc_object_t *p_this )
             break;
         }
     }
+    p_sys->pf_read = pf_read;
 
-    msg_Dbg( p_demux, "loading all subtitles..." );
+    /* Only formats with self contained entries can be parsed again
+     * individually */
+    if( var_InheritBool( p_demux, "sub-lazy" ) )
+    {
+        switch( p_sys->props.i_type )
+        {
+            case SUB_TYPE_MICRODVD:
+            case SUB_TYPE_SUBRIP:
+            case SUB_TYPE_SSA1:
+            case SUB_TYPE_SSA2_4:
+            case SUB_TYPE_ASS:
+            case SUB_TYPE_SUBVIEWER:
+            case SUB_TYPE_SBV:
+                vlc_stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_lazy );
+                break;
+            default:
+                break;
+        }
+        if( !p_sys->b_lazy )
+            msg_Warn( p_demux, "cannot load this subtitle file on demand" );
+    }
+
+    msg_Dbg( p_demux, p_sys->b_lazy ? "indexing all subtitles..."
+                                     : "loading all subtitles..." );
 
     if( e_bom == UTF8BOM && /* skip BOM */
         vlc_stream_Read( p_demux->s, NULL, 3 ) != 3 )
@@ -633,9 +683,12 @@ static int Open ( vlc_object_t *p_this )
         return VLC_EGENERIC;
     }
 
-    /* Load the whole file */
+    /* Load the whole file, or read it line by line */
     text_t txtlines;
-    TextLoad( &txtlines, p_demux->s );
+    if( p_sys->b_lazy )
+        TextStream( &txtlines, p_demux->s, UINT64_MAX );
+    else
+        TextLoad( &txtlines, p_demux->s );
 
     /* Parse it */
     for( size_t i_max = 0; i_max < SIZE_MAX - 500 * sizeof(subtitle_t); )
@@ -653,11 +706,23 @@ static int Open ( vlc_object_t *p_this )
             p_sys->subtitles.p_array = p_realloc;
         }
 
+        subtitle_t *p_subtitle = &p_sys->subtitles.p_array[p_sys->subtitles.i_count];
+        uint64_t i_offset = p_sys->b_lazy ? TextTell( &txtlines ) : 0;
+
         if( pf_read( VLC_OBJECT(p_demux), &p_sys->props, &txtlines,
-                     &p_sys->subtitles.p_array[p_sys->subtitles.i_count],
-                     p_sys->subtitles.i_count ) )
+                     p_subtitle, p_sys->subtitles.i_count ) )
             break;
 
+        if( p_sys->b_lazy )
+        {
+            /* Only keep where it comes from */
+            p_subtitle->i_offset = i_offset;
+            p_subtitle->i_size = TextTell( &txtlines ) - i_offset;
+            p_subtitle->i_index = p_sys->subtitles.i_count;
+            free( p_subtitle->psz_text );
+            p_subtitle->psz_text = NULL;
+        }
+
         p_sys->subtitles.i_count++;
     }
     /* Unload */
@@ -835,6 +900,37 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
     return VLC_EGENERIC;
 }
 
+/*****************************************************************************
+ * LoadText: parse again the text of a subtitle indexed on demand
+ *****************************************************************************/
+static char *LoadText( demux_t *p_demux, const subtitle_t *p_subtitle )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( vlc_stream_Seek( p_demux->s, p_subtitle->i_offset ) != VLC_SUCCESS )
+        return NULL;
+
+    text_t txt;
+    TextStream( &txt, p_demux->s, p_subtitle->i_offset + p_subtitle->i_size );
+
+    /* Parsers may update properties (SSA header), which were already
+     * complete after indexing */
+    subs_properties_t props = p_sys->props;
+    props.psz_header = NULL;
+
+    subtitle_t subtitle = { .psz_text = NULL };
+    if( p_sys->pf_read( VLC_OBJECT(p_demux), &props, &txt, &subtitle,
+                        p_subtitle->i_index ) != VLC_SUCCESS )
+        subtitle.psz_text = NULL;
+
+    TextUnload( &txt );
+    free( props.psz_header );
+
+    if( subtitle.psz_text == NULL )
+        msg_Warn( p_demux, "cannot load subtitle %zu", p_subtitle->i_index );
+    return subtitle.psz_text;
+}
+
 /*****************************************************************************
  * Demux: Send subtitle to decoder
  *****************************************************************************/
@@ -858,7 +954,19 @@ static int Demux( demux_t *p_demux )
 
         if( p_subtitle->i_start >= 0 )
         {
-            block_t *p_block = p_sys->pf_convert( p_subtitle );
+            block_t *p_block = NULL;
+            if( p_subtitle->psz_text )
+                p_block = p_sys->pf_convert( p_subtitle );
+            else if( p_sys->b_lazy )
+            {
+                subtitle_t loaded = *p_subtitle;
+                loaded.psz_text = LoadText( p_demux, p_subtitle );
+                if( loaded.psz_text )
+                {
+                    p_block = p_sys->pf_convert( &loaded );
+                    free( loaded.psz_text );
+                }
+            }
             if( p_block )
             {
                 p_block->i_dts =
@@ -912,6 +1020,8 @@ static int TextLoad( text_t *txt, stream_t *s )
     i_line_max          = 500;
     txt->i_line_count   = 0;
     txt->i_line         = 0;
+    txt->s              = NULL;
+    txt->psz_last       = NULL;
     txt->line           = calloc( i_line_max, sizeof( char * ) );
     if( !txt->line )
         return VLC_ENOMEM;
@@ -944,6 +1054,18 @@ static int TextLoad( text_t *txt, stream_t *s )
 
     return VLC_SUCCESS;
 }
+static void TextStream( text_t *txt, stream_t *s, uint64_t i_end )
+{
+    txt->i_line_count = 0;
+    txt->i_line       = 0;
+    txt->line         = NULL;
+    txt->s            = s;
+    txt->i_end        = i_end;
+    txt->i_last_pos   = 0;
+    txt->psz_last     = NULL;
+    txt->b_last_back  = false;
+}
+
 static void TextUnload( text_t *txt )
 {
     if( txt->i_line_count )
@@ -952,12 +1074,37 @@ static void TextUnload( text_t *txt )
             free( txt->line[i] );
         free( txt->line );
     }
+    free( txt->psz_last );
+    txt->psz_last     = NULL;
     txt->i_line       = 0;
     txt->i_line_count = 0;
 }
 
+/* Offset of the next line of a streamed text */
+static uint64_t TextTell( const text_t *txt )
+{
+    return txt->b_last_back ? txt->i_last_pos : vlc_stream_Tell( txt->s );
+}
+
 static char *TextGetLine( text_t *txt )
 {
+    if( txt->s )
+    {
+        if( txt->b_last_back )
+        {
+            txt->b_last_back = false;
+            return txt->psz_last;
+        }
+        free( txt->psz_last );
+        txt->psz_last = NULL;
+
+        txt->i_last_pos = vlc_stream_Tell( txt->s );
+        if( txt->i_last_pos >= txt->i_end )
+            return NULL;
+        txt->psz_last = vlc_stream_ReadLine( txt->s );
+        return txt->psz_last;
+    }
+
     if( txt->i_line >= txt->i_line_count )
         return( NULL );
 
@@ -965,6 +1112,13 @@ static char *TextGetLine( text_t *txt )
 }
 static void TextPreviousLine( text_t *txt )
 {
+    if( txt->s )
+    {
+        if( txt->psz_last )
+            txt->b_last_back = true;
+        return;
+    }
+
     if( txt->i_line > 0 )
         txt->i_line--;
 }
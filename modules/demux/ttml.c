@@ -41,6 +41,28 @@
 
 //#define TTML_DEMUX_DEBUG
 
+/*
+ * Children of body and div elements are usually in both document and time
+ * order. For such elements with many children, an index of their begin
+ * times and of the running maximum of their end times lets the output
+ * skip the children which are not active, without visiting each of them.
+ */
+#define TT_INDEX_MIN_CHILDREN 16
+
+struct tt_index_entry
+{
+    const tt_node_t *p_node;
+    vlc_tick_t i_begin;
+    vlc_tick_t i_maxend;
+};
+
+struct tt_child_index
+{
+    const tt_node_t *p_parent;
+    struct tt_index_entry *p_entries;
+    size_t i_count;
+};
+
 typedef struct
 {
     xml_t*          p_xml;
@@ -65,8 +87,114 @@ typedef struct
         size_t   i_count;
         size_t   i_current;
     } times;
+
+    /* Ordered by parent node */
+    struct
+    {
+        struct tt_child_index *p_array;
+        size_t i_count;
+    } index;
 } demux_sys_t;
 
+static vlc_tick_t tt_index_Begin( const tt_node_t *p_node )
+{
+    return tt_time_Valid( &p_node->timings.begin )
+         ? tt_time_Convert( &p_node->timings.begin ) : INT64_MIN;
+}
+
+static vlc_tick_t tt_index_End( const tt_node_t *p_node )
+{
+    return tt_time_Valid( &p_node->timings.end )
+         ? tt_time_Convert( &p_node->timings.end ) : INT64_MAX;
+}
+
+static int tt_index_Compare( const void *a_, const void *b_ )
+{
+    const struct tt_child_index *a = a_, *b = b_;
+    if( a->p_parent == b->p_parent )
+        return 0;
+    return ( (uintptr_t) a->p_parent < (uintptr_t) b->p_parent ) ? -1 : 1;
+}
+
+static void tt_index_Add( demux_sys_t *p_sys, const tt_node_t *p_node )
+{
+    size_t i_count = 0;
+    vlc_tick_t i_last = INT64_MIN;
+
+    /* Only body and div, which have no significant text content */
+    if( tt_node_NameCompare( p_node->psz_node_name, "body" ) &&
+        tt_node_NameCompare( p_node->psz_node_name, "div" ) )
+        return;
+
+    for( const tt_basenode_t *p_child = p_node->p_child;
+                              p_child; p_child = p_child->p_next )
+    {
+        if( p_child->i_type != TT_NODE_TYPE_ELEMENT )
+            continue;
+        vlc_tick_t i_begin = tt_index_Begin( (const tt_node_t *) p_child );
+        if( i_begin < i_last )
+            return; /* not in time order */
+        i_last = i_begin;
+        i_count++;
+    }
+
+    if( i_count < TT_INDEX_MIN_CHILDREN )
+        return;
+
+    struct tt_child_index *p_realloc =
+        realloc( p_sys->index.p_array,
+                 sizeof(*p_realloc) * (p_sys->index.i_count + 1) );
+    if( unlikely(p_realloc == NULL) )
+        return;
+    p_sys->index.p_array = p_realloc;
+
+    struct tt_child_index *p_index = &p_realloc[p_sys->index.i_count];
+    p_index->p_entries = vlc_alloc( i_count, sizeof(*p_index->p_entries) );
+    if( unlikely(p_index->p_entries == NULL) )
+        return;
+    p_index->p_parent = p_node;
+    p_index->i_count = 0;
+
+    vlc_tick_t i_maxend = INT64_MIN;
+    for( const tt_basenode_t *p_child = p_node->p_child;
+                              p_child; p_child = p_child->p_next )
+    {
+        if( p_child->i_type != TT_NODE_TYPE_ELEMENT )
+            continue;
+        const tt_node_t *p_elem = (const tt_node_t *) p_child;
+        struct tt_index_entry *p_entry = &p_index->p_entries[p_index->i_count++];
+        if( tt_index_End( p_elem ) > i_maxend )
+            i_maxend = tt_index_End( p_elem );
+        p_entry->p_node = p_elem;
+        p_entry->i_begin = tt_index_Begin( p_elem );
+        p_entry->i_maxend = i_maxend;
+    }
+    p_sys->index.i_count++;
+}
+
+static void tt_index_Build( demux_sys_t *p_sys, const tt_node_t *p_node )
+{
+    tt_index_Add( p_sys, p_node );
+
+    for( const tt_basenode_t *p_child = p_node->p_child;
+                              p_child; p_child = p_child->p_next )
+    {
+        if( p_child->i_type == TT_NODE_TYPE_ELEMENT )
+            tt_index_Build( p_sys, (const tt_node_t *) p_child );
+    }
+}
+
+static const struct tt_child_index *tt_index_Find( const demux_sys_t *p_sys,
+                                                   const tt_node_t *p_node )
+{
+    if( p_sys == NULL || p_sys->index.i_count == 0 )
+        return NULL;
+
+    const struct tt_child_index key = { .p_parent = p_node };
+    return bsearch( &key, p_sys->index.p_array, p_sys->index.i_count,
+                    sizeof(key), tt_index_Compare );
+}
+
 static char *tt_genTiming( tt_time_t t )
 {
     if( !tt_time_Valid( &t ) )
@@ -171,7 +299,8 @@ static void tt_node_AttributesToText( struct vlc_memstream *p_stream, const tt_n
     }
 }
 
-static void tt_node_ToText( struct vlc_memstream *p_stream, const tt_basenode_t *p_basenode,
+static void tt_node_ToText( struct vlc_memstream *p_stream, const demux_sys_t *p_sys,
+                            const tt_basenode_t *p_basenode,
                             const tt_time_t *playbacktime )
 {
     if( p_basenode->i_type == TT_NODE_TYPE_ELEMENT )
@@ -197,10 +326,35 @@ static void tt_node_ToText( struct vlc_memstream *p_stream, const tt_basenode_t
                                   tt_time_Convert( &p_node->timings.end ) );
 #endif
 
-            for( const tt_basenode_t *p_child = p_node->p_child;
-                                   p_child; p_child = p_child->p_next )
+            const struct tt_child_index *p_index = tt_time_Valid( playbacktime )
+                                                 ? tt_index_Find( p_sys, p_node )
+                                                 : NULL;
+            if( p_index )
             {
-                tt_node_ToText( p_stream, p_child, playbacktime );
+                const vlc_tick_t i_time = tt_time_Convert( playbacktime );
+
+                /* Skip the children which all ended */
+                size_t i_low = 0, i_high = p_index->i_count;
+                while( i_low < i_high )
+                {
+                    size_t i_mid = i_low + (i_high - i_low) / 2;
+                    if( p_index->p_entries[i_mid].i_maxend <= i_time )
+                        i_low = i_mid + 1;
+                    else
+                        i_high = i_mid;
+                }
+
+                for( size_t i = i_low; i < p_index->i_count &&
+                     p_index->p_entries[i].i_begin <= i_time; i++ )
+                    tt_node_ToText( p_stream, p_sys,
+                                    (const tt_basenode_t *) p_index->p_entries[i].p_node,
+                                    playbacktime );
+            }
+            else
+            {
+                for( const tt_basenode_t *p_child = p_node->p_child;
+                                       p_child; p_child = p_child->p_next )
+                    tt_node_ToText( p_stream, p_sys, p_child, playbacktime );
             }
 
             vlc_memstream_puts( p_stream, "</" );
@@ -374,7 +528,7 @@ static int Demux( demux_t* p_demux )
         if( vlc_memstream_open( &stream ) )
             return VLC_DEMUXER_EGENERIC;
 
-        tt_node_ToText( &stream, (tt_basenode_t *) p_sys->p_rootnode,
+        tt_node_ToText( &stream, p_sys, (tt_basenode_t *) p_sys->p_rootnode,
                         &p_sys->times.p_array[p_sys->times.i_current] );
 
         if( vlc_memstream_close( &stream ) == VLC_SUCCESS )
@@ -510,6 +664,11 @@ int tt_OpenDemux( vlc_object_t* p_this )
     tt_timings_Resolve( (tt_basenode_t *) p_sys->p_rootnode, &p_sys->temporal_extent,
                         &p_sys->times.p_array, &p_sys->times.i_count );
 
+    tt_index_Build( p_sys, p_sys->p_rootnode );
+    if( p_sys->index.i_count > 1 )
+        qsort( p_sys->index.p_array, p_sys->index.i_count,
+               sizeof(*p_sys->index.p_array), tt_index_Compare );
+
 #ifdef TTML_DEMUX_DEBUG
     {
         struct vlc_memstream stream;
@@ -519,7 +678,7 @@ int tt_OpenDemux( vlc_object_t* p_this )
 
         tt_time_t t;
         tt_time_Init( &t );
-        tt_node_ToText( &stream, (tt_basenode_t*)p_sys->p_rootnode, &t /* invalid */ );
+        tt_node_ToText( &stream, p_sys, (tt_basenode_t*)p_sys->p_rootnode, &t /* invalid */ );
 
         vlc_memstream_putc( &stream, '\0' );
 
@@ -570,5 +729,9 @@ void tt_CloseDemux( vlc_object_t* p_this )
 
     free( p_sys->times.p_array );
 
+    for( size_t i = 0; i < p_sys->index.i_count; i++ )
+        free( p_sys->index.p_array[i].p_entries );
+    free( p_sys->index.p_array );
+
     free( p_sys );
 }
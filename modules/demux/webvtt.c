@@ -61,6 +61,7 @@ typedef struct
         webvtt_cue_t *p_array;
         size_t  i_alloc;
         size_t  i_count;
+        vlc_tick_t *p_maxstop; /* highest end time up to each cue */
     } cues;
 
     struct
@@ -313,12 +314,34 @@ static int index_Compare( const void *a_, const void *b_ )
 
 static size_t getIndexByTime( demux_sys_t *p_sys, vlc_tick_t i_time )
 {
-    for( size_t i=0; i<p_sys->index.i_count; i++ )
+    size_t i_low = 0, i_high = p_sys->index.i_count;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->index.p_array[i_mid].time < i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return ( i_low < p_sys->index.i_count ) ? i_low : 0;
+}
+
+/* Returns the first cue that can still be active at the given time */
+static size_t getFirstCueByTime( demux_sys_t *p_sys, vlc_tick_t i_time )
+{
+    if( p_sys->cues.p_maxstop == NULL )
+        return 0;
+
+    size_t i_low = 0, i_high = p_sys->cues.i_count;
+    while( i_low < i_high )
     {
-        if( p_sys->index.p_array[i].time >= i_time )
-            return i;
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_sys->cues.p_maxstop[i_mid] <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
-    return 0;
+    return i_low;
 }
 
 static void BuildIndex( demux_t *p_demux )
@@ -344,6 +367,20 @@ static void BuildIndex( demux_t *p_demux )
         else
             p_sys->index.p_array[i].active = --i_overlaps;
     }
+
+    /* Cues are ordered by start time only: keep the running maximum of end
+     * times, so that the cues which ended before a given time are skipped */
+    p_sys->cues.p_maxstop = vlc_alloc( p_sys->cues.i_count, sizeof(vlc_tick_t) );
+    if( p_sys->cues.p_maxstop )
+    {
+        vlc_tick_t i_maxstop = INT64_MIN;
+        for( size_t i=0; i<p_sys->cues.i_count; i++ )
+        {
+            if( p_sys->cues.p_array[i].i_stop > i_maxstop )
+                i_maxstop = p_sys->cues.p_array[i].i_stop;
+            p_sys->cues.p_maxstop[i] = i_maxstop;
+        }
+    }
 }
 
 static block_t *demux_From( demux_t *p_demux, vlc_tick_t i_start )
@@ -352,7 +389,7 @@ static block_t *demux_From( demux_t *p_demux, vlc_tick_t i_start )
 
     block_t *p_list = NULL;
     block_t **pp_append = &p_list;
-    for( size_t i=0; i<p_sys->cues.i_count; i++ )
+    for( size_t i=getFirstCueByTime( p_sys, i_start ); i<p_sys->cues.i_count; i++ )
     {
         const webvtt_cue_t *p_cue = &p_sys->cues.p_array[i];
         if( p_cue->i_start > i_start )
@@ -731,6 +768,7 @@ void webvtt_CloseDemux( vlc_object_t *p_this )
     for( size_t i=0; i< p_sys->cues.i_count; i++ )
         webvtt_cue_Clean( &p_sys->cues.p_array[i] );
     free( p_sys->cues.p_array );
+    free( p_sys->cues.p_maxstop );
 
     free( p_sys->index.p_array );
 
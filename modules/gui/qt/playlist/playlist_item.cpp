@@ -24,10 +24,7 @@ PlaylistItem::PlaylistItem(vlc_playlist_item_t* item)
 {
     d = new Data();
     if (item)
-    {
         d->item.reset(item);
-        sync();
-    }
 }
 
 bool PlaylistItem::isSelected() const
@@ -42,26 +39,31 @@ void PlaylistItem::setSelected(bool selected)
 
 QString PlaylistItem::getTitle() const
 {
+    ensureSynced();
     return d->title;
 }
 
 QString PlaylistItem::getArtist() const
 {
+    ensureSynced();
     return d->artist;
 }
 
 QString PlaylistItem::getAlbum() const
 {
+    ensureSynced();
     return d->album;
 }
 
 QUrl PlaylistItem::getArtwork() const
 {
+    ensureSynced();
     return d->artwork;
 }
 
 vlc_tick_t PlaylistItem::getDuration() const
 {
+    ensureSynced();
     return d->duration;
 }
 
@@ -77,6 +79,18 @@ void PlaylistItem::sync() {
         d->artwork = vlc_meta_Get(media->p_meta, vlc_meta_ArtworkURL);
     }
     vlc_mutex_unlock(&media->lock);
+    d->synced = true;
+}
+
+void PlaylistItem::invalidate()
+{
+    d->synced = false;
+}
+
+void PlaylistItem::ensureSynced() const
+{
+    if (!d->synced && d->item)
+        const_cast<PlaylistItem *>(this)->sync();
 }
 
 PlaylistItem::operator bool() const
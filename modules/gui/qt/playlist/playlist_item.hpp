@@ -41,9 +41,12 @@ using PlaylistItemPtr = vlc_shared_data_ptr_type(vlc_playlist_item_t,
 /**
  * Playlist item wrapper.
  *
- * It contains both the PlaylistItemPtr and cached data saved while the playlist
- * is locked, so that the fields may be read without synchronization or race
- * conditions.
+ * It contains both the PlaylistItemPtr and cached data, so that the fields may
+ * be read without synchronization or race conditions.
+ *
+ * The cached data are read from the input item on first access (i.e. only for
+ * the rows actually displayed), not when the wrapper is created from a
+ * playlist callback, so that huge playlists do not lock every input item.
  */
 class PlaylistItem
 {
@@ -77,13 +80,19 @@ public:
     vlc_tick_t getDuration() const;
 
 
+    /* read the metadata from the input item now */
     void sync();
+    /* read the metadata again on next access */
+    void invalidate();
 
 private:
+    void ensureSynced() const;
+
     struct Data : public QSharedData {
         PlaylistItemPtr item;
 
         bool selected = false;
+        bool synced = false;
 
         /* cached values */
         QString title;
@@ -91,7 +100,7 @@ private:
         QString album;
         QUrl artwork;
 
-        vlc_tick_t duration;
+        vlc_tick_t duration = 0;
     };
 
     QExplicitlySharedDataPointer<Data> d;
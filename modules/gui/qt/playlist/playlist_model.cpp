@@ -24,6 +24,7 @@
 #include "playlist_model_p.hpp"
 #include <algorithm>
 #include <assert.h>
+#include <QHash>
 
 namespace vlc {
 namespace playlist {
@@ -34,6 +35,7 @@ static QVector<PlaylistItem> toVec(vlc_playlist_item_t *const items[],
                                    size_t len)
 {
     QVector<PlaylistItem> vec;
+    vec.reserve(len);
     for (size_t i = 0; i < len; ++i)
         vec.push_back(items[i]);
     return vec;
@@ -117,7 +119,13 @@ on_playlist_items_updated(vlc_playlist_t *playlist, size_t index,
             return;
         int count = updated.size();
         for (int i = 0; i < count; ++i)
-            that->m_items[index + i] = updated[i]; /* sync metadata */
+        {
+            PlaylistItem &item = that->m_items[index + i];
+            if (item.raw() == updated[i].raw())
+                item.invalidate(); /* sync metadata when next displayed */
+            else
+                item = updated[i];
+        }
         that->notifyItemsChanged(index, count);
     });
 }
@@ -175,8 +183,53 @@ PlaylistListModelPrivate::~PlaylistListModelPrivate()
 void PlaylistListModelPrivate::onItemsReset(const QVector<PlaylistItem>& newContent)
 {
     Q_Q(PlaylistListModel);
+
+    /* Keep the existing wrappers (selection and cached metadata) for the items
+     * which are still in the playlist */
+    QHash<const vlc_playlist_item_t *, int> oldRows;
+    oldRows.reserve(m_items.size());
+    for (int i = 0; i < m_items.size(); ++i)
+        oldRows.insert(m_items[i].raw(), i);
+
+    int count = newContent.size();
+    QVector<PlaylistItem> items;
+    items.reserve(count);
+    QVector<int> newRows(m_items.size(), -1);
+    bool reordered = count == m_items.size();
+    for (int i = 0; i < count; ++i)
+    {
+        auto it = oldRows.constFind(newContent[i].raw());
+        if (it == oldRows.cend())
+        {
+            reordered = false;
+            items.push_back(newContent[i]);
+        }
+        else
+        {
+            items.push_back(m_items[it.value()]);
+            newRows[it.value()] = i;
+        }
+    }
+
+    if (reordered)
+    {
+        /* The core notifies a sort or a shuffle as a reset: a layout change
+         * keeps the views (scroll position, delegates) instead of rebuilding
+         * them */
+        emit q->layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+        const QModelIndexList from = q->persistentIndexList();
+        QModelIndexList to;
+        to.reserve(from.size());
+        for (const QModelIndex &index : from)
+            to.push_back(q->index(newRows[index.row()], index.column()));
+        m_items = std::move(items);
+        q->changePersistentIndexList(from, to);
+        emit q->layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+        return;
+    }
+
     q->beginResetModel();
-    m_items = newContent;
+    m_items = std::move(items);
     q->endResetModel();
 
     emit q->countChanged(m_items.size());
@@ -188,8 +241,13 @@ void PlaylistListModelPrivate::onItemsAdded(const QVector<PlaylistItem>& added,
     Q_Q(PlaylistListModel);
     int count = added.size();
     q->beginInsertRows({}, index, index + count - 1);
-    m_items.insert(index, count, nullptr);
-    std::move(added.cbegin(), added.cend(), m_items.begin() + index);
+    if (index == static_cast<size_t>(m_items.size()))
+        m_items.append(added);
+    else
+    {
+        m_items.insert(index, count, nullptr);
+        std::copy(added.cbegin(), added.cend(), m_items.begin() + index);
+    }
     q->endInsertRows();
 
     emit q->countChanged(m_items.size());
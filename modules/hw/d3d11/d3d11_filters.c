@@ -49,8 +49,6 @@
 #define D3D11_VIDEO_PROCESSOR_FILTER_CAPS_SATURATION   0x8
 #endif
 
-#define PROCESSOR_SLICES 2
-
 struct filter_level
 {
     atomic_int   level;
@@ -74,11 +72,10 @@ typedef struct
     d3d11_processor_t              d3d_proc;
 
     union {
-        ID3D11Texture2D            *texture;
-        ID3D11Resource             *resource;
-    } out[PROCESSOR_SLICES];
-    ID3D11VideoProcessorInputView  *procInput[PROCESSOR_SLICES];
-    ID3D11VideoProcessorOutputView *procOutput[PROCESSOR_SLICES];
+        ID3D11Texture2D            *outTexture;
+        ID3D11Resource             *outResource;
+    };
+    ID3D11VideoProcessorOutputView *procOutput;
 } filter_sys_t;
 
 #define THRES_TEXT N_("Brightness threshold")
@@ -101,25 +98,39 @@ static const char *const ppsz_filter_options[] = {
     "brightness-threshold", NULL
 };
 
-static bool ApplyFilter( filter_sys_t *p_sys,
+static bool SetupFilter( filter_sys_t *p_sys,
                          D3D11_VIDEO_PROCESSOR_FILTER filter,
-                         struct filter_level *p_level,
-                         ID3D11VideoProcessorInputView *input,
-                         ID3D11VideoProcessorOutputView *output,
-                         const video_format_t *fmt)
+                         struct filter_level *p_level)
 {
-    HRESULT hr;
-
     int level = atomic_load(&p_level->level);
-    if (level == p_level->Range.Default)
-        return false;
+    bool enable = level != p_level->Range.Default;
 
     ID3D11VideoContext_VideoProcessorSetStreamFilter(p_sys->d3d_proc.d3dvidctx,
                                                      p_sys->d3d_proc.videoProcessor,
                                                      0,
                                                      filter,
-                                                     TRUE,
+                                                     enable,
                                                      level);
+    return enable;
+}
+
+static bool ApplyFilters( filter_sys_t *p_sys,
+                          ID3D11VideoProcessorInputView *input,
+                          ID3D11VideoProcessorOutputView *output,
+                          const video_format_t *fmt)
+{
+    HRESULT hr;
+
+    /* all the adjustments are done by the same processor stream, in a single
+     * blit */
+    size_t count = 0;
+    count += SetupFilter( p_sys, D3D11_VIDEO_PROCESSOR_FILTER_CONTRAST,   &p_sys->Contrast );
+    count += SetupFilter( p_sys, D3D11_VIDEO_PROCESSOR_FILTER_BRIGHTNESS, &p_sys->Brightness );
+    count += SetupFilter( p_sys, D3D11_VIDEO_PROCESSOR_FILTER_HUE,        &p_sys->Hue );
+    count += SetupFilter( p_sys, D3D11_VIDEO_PROCESSOR_FILTER_SATURATION, &p_sys->Saturation );
+    if (count == 0)
+        return false;
+
     ID3D11VideoContext_VideoProcessorSetStreamAutoProcessingMode(p_sys->d3d_proc.d3dvidctx,
                                                                  p_sys->d3d_proc.videoProcessor,
                                                                  0, FALSE);
@@ -192,7 +203,6 @@ static void InitLevel(filter_t *filter, struct filter_level *range, const char *
 
 static picture_t *AllocPicture( filter_t *p_filter )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
     d3d11_video_context_t *vctx_sys = GetD3D11ContextPrivate( p_filter->vctx_out );
 
     const d3d_format_t *cfg = NULL;
@@ -209,14 +219,8 @@ static picture_t *AllocPicture( filter_t *p_filter )
     if (unlikely(cfg == NULL))
         return NULL;
 
-    picture_t *pic = D3D11_AllocPicture(VLC_OBJECT(p_filter), &p_filter->fmt_out.video, p_filter->vctx_out, cfg);
-    if (unlikely(pic == NULL))
-        return NULL;
-
-    struct d3d11_pic_context *pic_ctx = container_of(pic->context, struct d3d11_pic_context, s);
-    D3D11_AllocateResourceView(p_filter, p_sys->d3d_dev->d3ddevice, cfg, pic_ctx->picsys.texture, 0, pic_ctx->picsys.renderSrc);
-
-    return pic;
+    /* D3D11_AllocPicture() also allocates the shader resource views */
+    return D3D11_AllocPicture(VLC_OBJECT(p_filter), &p_filter->fmt_out.video, p_filter->vctx_out, cfg);
 }
 
 static picture_t *Filter(filter_t *p_filter, picture_t *p_pic)
@@ -247,64 +251,17 @@ static picture_t *Filter(filter_t *p_filter, picture_t *p_pic)
 
     picture_CopyProperties( p_outpic, p_pic );
 
-    ID3D11VideoProcessorInputView *inputs[4] = {
-        p_src_sys->processorInput,
-        p_sys->procInput[0],
-        p_sys->procInput[1],
-        p_sys->procInput[0]
-    };
-
-    ID3D11VideoProcessorOutputView *outputs[4] = {
-        p_sys->procOutput[0],
-        p_sys->procOutput[1],
-        p_sys->procOutput[0],
-        p_sys->procOutput[1]
-    };
-
     d3d11_device_lock( p_sys->d3d_dev );
 
-    size_t idx = 0, count = 0;
-    /* contrast */
-    if ( ApplyFilter( p_sys,
-                      D3D11_VIDEO_PROCESSOR_FILTER_CONTRAST, &p_sys->Contrast,
-                      inputs[idx], outputs[idx], &p_filter->fmt_out.video ) )
-    {
-        idx++;
-        count++;
-    }
-    /* brightness */
-    if ( ApplyFilter( p_sys,
-                      D3D11_VIDEO_PROCESSOR_FILTER_BRIGHTNESS, &p_sys->Brightness,
-                      inputs[idx], outputs[idx], &p_filter->fmt_out.video ) )
-    {
-        idx++;
-        count++;
-    }
-    /* hue */
-    if ( ApplyFilter( p_sys,
-                      D3D11_VIDEO_PROCESSOR_FILTER_HUE, &p_sys->Hue,
-                      inputs[idx], outputs[idx], &p_filter->fmt_out.video ) )
-    {
-        idx++;
-        count++;
-    }
-    /* saturation */
-    if ( ApplyFilter( p_sys,
-                      D3D11_VIDEO_PROCESSOR_FILTER_SATURATION, &p_sys->Saturation,
-                      inputs[idx], outputs[idx], &p_filter->fmt_out.video ) )
-    {
-        idx++;
-        count++;
-    }
-
-    if (count == 0)
+    if ( ApplyFilters( p_sys, p_src_sys->processorInput, p_sys->procOutput,
+                       &p_filter->fmt_out.video ) )
     {
         ID3D11DeviceContext_CopySubresourceRegion(p_sys->d3d_dev->d3dcontext,
                                                   p_out_sys->resource[KNOWN_DXGI_INDEX],
                                                   p_out_sys->slice_index,
                                                   0, 0, 0,
-                                                  p_src_sys->resource[KNOWN_DXGI_INDEX],
-                                                  p_src_sys->slice_index,
+                                                  p_sys->outResource,
+                                                  0,
                                                   NULL);
     }
     else
@@ -313,8 +270,8 @@ static picture_t *Filter(filter_t *p_filter, picture_t *p_pic)
                                                   p_out_sys->resource[KNOWN_DXGI_INDEX],
                                                   p_out_sys->slice_index,
                                                   0, 0, 0,
-                                                  p_sys->out[outputs[idx] == p_sys->procOutput[0] ? 1 : 0].resource,
-                                                  0,
+                                                  p_src_sys->resource[KNOWN_DXGI_INDEX],
+                                                  p_src_sys->slice_index,
                                                   NULL);
     }
 
@@ -465,52 +422,25 @@ static int D3D11OpenAdjust(vlc_object_t *obj)
     texDesc.Height = filter->fmt_out.video.i_height;
     texDesc.Width  = filter->fmt_out.video.i_width;
 
-    hr = ID3D11Device_CreateTexture2D( sys->d3d_dev->d3ddevice, &texDesc, NULL, &sys->out[0].texture );
+    hr = ID3D11Device_CreateTexture2D( sys->d3d_dev->d3ddevice, &texDesc, NULL, &sys->outTexture );
     if (FAILED(hr)) {
         msg_Err(filter, "CreateTexture2D failed. (hr=0x%lX)", hr);
         goto error;
     }
-    hr = ID3D11Device_CreateTexture2D( sys->d3d_dev->d3ddevice, &texDesc, NULL, &sys->out[1].texture );
-    if (FAILED(hr)) {
-        ID3D11Texture2D_Release(sys->out[0].texture);
-        msg_Err(filter, "CreateTexture2D failed. (hr=0x%lX)", hr);
-        goto error;
-    }
 
     D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC outDesc = {
         .ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D,
     };
 
-    D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC inDesc = {
-        .FourCC = 0,
-        .ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D,
-        .Texture2D.MipSlice = 0,
-    };
-
-    for (int i=0; i<PROCESSOR_SLICES; i++)
+    hr = ID3D11VideoDevice_CreateVideoProcessorOutputView(sys->d3d_proc.d3dviddev,
+                                                         sys->outResource,
+                                                         sys->d3d_proc.procEnumerator,
+                                                         &outDesc,
+                                                         &sys->procOutput);
+    if (FAILED(hr))
     {
-        hr = ID3D11VideoDevice_CreateVideoProcessorOutputView(sys->d3d_proc.d3dviddev,
-                                                             sys->out[i].resource,
-                                                             sys->d3d_proc.procEnumerator,
-                                                             &outDesc,
-                                                             &sys->procOutput[i]);
-        if (FAILED(hr))
-        {
-            msg_Dbg(filter,"Failed to create processor output. (hr=0x%lX)", hr);
-            goto error;
-        }
-
-        hr = ID3D11VideoDevice_CreateVideoProcessorInputView(sys->d3d_proc.d3dviddev,
-                                                             sys->out[i].resource,
-                                                             sys->d3d_proc.procEnumerator,
-                                                             &inDesc,
-                                                             &sys->procInput[i]);
-
-        if (FAILED(hr))
-        {
-            msg_Dbg(filter,"Failed to create processor input. (hr=0x%lX)", hr);
-            goto error;
-        }
+        msg_Dbg(filter,"Failed to create processor output. (hr=0x%lX)", hr);
+        goto error;
     }
 
     filter->pf_video_filter = Filter;
@@ -519,18 +449,10 @@ static int D3D11OpenAdjust(vlc_object_t *obj)
 
     return VLC_SUCCESS;
 error:
-    for (int i=0; i<PROCESSOR_SLICES; i++)
-    {
-        if (sys->procInput[i])
-            ID3D11VideoProcessorInputView_Release(sys->procInput[i]);
-        if (sys->procOutput[i])
-            ID3D11VideoProcessorOutputView_Release(sys->procOutput[i]);
-    }
-
-    if (sys->out[0].texture)
-        ID3D11Texture2D_Release(sys->out[0].texture);
-    if (sys->out[1].texture)
-        ID3D11Texture2D_Release(sys->out[1].texture);
+    if (sys->procOutput)
+        ID3D11VideoProcessorOutputView_Release(sys->procOutput);
+    if (sys->outTexture)
+        ID3D11Texture2D_Release(sys->outTexture);
     D3D11_ReleaseProcessor(&sys->d3d_proc);
     free(sys);
 
@@ -550,15 +472,8 @@ static void D3D11CloseAdjust(vlc_object_t *obj)
     var_DelCallback( filter, "brightness-threshold",
                                              AdjustCallback, sys );
 
-    for (int i=0; i<PROCESSOR_SLICES; i++)
-    {
-        if (sys->procInput[i])
-            ID3D11VideoProcessorInputView_Release(sys->procInput[i]);
-        if (sys->procOutput[i])
-            ID3D11VideoProcessorOutputView_Release(sys->procOutput[i]);
-    }
-    ID3D11Texture2D_Release(sys->out[0].texture);
-    ID3D11Texture2D_Release(sys->out[1].texture);
+    ID3D11VideoProcessorOutputView_Release(sys->procOutput);
+    ID3D11Texture2D_Release(sys->outTexture);
     D3D11_ReleaseProcessor( &sys->d3d_proc );
     vlc_video_context_Release(filter->vctx_out);
 
@@ -122,6 +122,14 @@ error:
 
 void D3D11_ReleaseProcessor(d3d11_processor_t *out)
 {
+    for (size_t i = 0; i < ARRAY_SIZE(out->inputs); i++)
+    {
+        if (out->inputs[i].view)
+        {
+            ID3D11VideoProcessorInputView_Release(out->inputs[i].view);
+            out->inputs[i].view = NULL;
+        }
+    }
     if (out->videoProcessor)
     {
         ID3D11VideoProcessor_Release(out->videoProcessor);
@@ -150,6 +158,20 @@ HRESULT D3D11_Assert_ProcessorInput(vlc_object_t *o, d3d11_processor_t *d3d_proc
     if (p_sys->processorInput)
         return S_OK;
 
+    /* decoders create a new picture context for each picture, reuse the view
+     * of the same texture slice when there is one */
+    for (size_t i = 0; i < ARRAY_SIZE(d3d_proc->inputs); i++)
+    {
+        if (d3d_proc->inputs[i].view != NULL &&
+            d3d_proc->inputs[i].resource == p_sys->resource[KNOWN_DXGI_INDEX] &&
+            d3d_proc->inputs[i].slice_index == p_sys->slice_index)
+        {
+            p_sys->processorInput = d3d_proc->inputs[i].view;
+            ID3D11VideoProcessorInputView_AddRef(p_sys->processorInput);
+            return S_OK;
+        }
+    }
+
     D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC inDesc = {
         .FourCC = 0,
         .ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D,
@@ -163,10 +185,24 @@ HRESULT D3D11_Assert_ProcessorInput(vlc_object_t *o, d3d11_processor_t *d3d_proc
                                                          d3d_proc->procEnumerator,
                                                          &inDesc,
                                                          &p_sys->processorInput);
-#ifndef NDEBUG
     if (FAILED(hr))
+    {
+#ifndef NDEBUG
         msg_Dbg(o,"Failed to create processor input for slice %d. (hr=0x%lX)", p_sys->slice_index, hr);
 #endif
+        return hr;
+    }
+
+    /* the view holds a reference to the texture, so the cached resource
+     * pointer cannot be reused by another texture while it's cached */
+    unsigned idx = d3d_proc->next_input;
+    d3d_proc->next_input = (idx + 1) % ARRAY_SIZE(d3d_proc->inputs);
+    if (d3d_proc->inputs[idx].view)
+        ID3D11VideoProcessorInputView_Release(d3d_proc->inputs[idx].view);
+    d3d_proc->inputs[idx].resource    = p_sys->resource[KNOWN_DXGI_INDEX];
+    d3d_proc->inputs[idx].slice_index = p_sys->slice_index;
+    d3d_proc->inputs[idx].view        = p_sys->processorInput;
+    ID3D11VideoProcessorInputView_AddRef(p_sys->processorInput);
     return hr;
 }
 #endif
@@ -28,12 +28,24 @@
 #include "../../video_chroma/d3d11_fmt.h"
 
 #ifdef ID3D11VideoContext_VideoProcessorBlt
+/* number of input views kept per processor, enough for a whole decoder
+ * texture array */
+#define D3D11_PROCESSOR_INPUT_VIEWS  32
+
 typedef struct
 {
     ID3D11VideoDevice              *d3dviddev;
     ID3D11VideoContext             *d3dvidctx;
     ID3D11VideoProcessorEnumerator *procEnumerator;
     ID3D11VideoProcessor           *videoProcessor;
+
+    /* input views per texture array slice, reused across pictures */
+    struct {
+        ID3D11Resource                 *resource;
+        unsigned                       slice_index;
+        ID3D11VideoProcessorInputView  *view;
+    } inputs[D3D11_PROCESSOR_INPUT_VIEWS];
+    unsigned                       next_input; /* oldest cached view */
 } d3d11_processor_t;
 
 int D3D11_CreateProcessor(vlc_object_t *, d3d11_device_t *,
@@ -28,7 +28,6 @@
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
 #include <vlc_messages.h>
-#include <vlc_picture_pool.h>
 #include <vlc_atomic.h>
 
 #define FFNV_LOG_FUNC(logctx, msg, ...)        msg_Err((vlc_object_t*)logctx, msg, __VA_ARGS__)
@@ -74,19 +73,37 @@ vlc_module_end ()
 /* */
 #define MAX_HXXX_SURFACES (16 + 1)
 #define NVDEC_DISPLAY_SURFACES 1
-#define MAX_POOL_SIZE     4 // number of in-flight buffers, if more are needed the decoder waits
+// Output buffers are allocated on demand, between these two bounds. Buffers in
+// flight are the ones queued for display or held by the video output, and at
+// most a DPB worth of pictures output in a row, e.g. when draining.
+#define MIN_POOL_SIZE     4 // number of buffers allocated upfront
+#define MAX_POOL_SIZE     32 // if more are needed the decoder waits
+#define NVDEC_VOUT_PICTURES 4 // pictures held by the video output
 
 #define OUTPUT_WIDTH_ALIGN   16
 
-typedef struct nvdec_pool_t {
+typedef struct nvdec_pool_t nvdec_pool_t;
+
+typedef struct nvdec_pool_buffer_t {
+    nvdec_pool_t                *pool;
+    CUdeviceptr                 devicePtr;
+} nvdec_pool_buffer_t;
+
+struct nvdec_pool_t {
     vlc_video_context           *vctx;
     decoder_device_nvdec_t      *nvdec_dev;
+    video_format_t              fmt;
+    size_t                      buffer_size;
 
-    CUdeviceptr                 outputDevicePtr[MAX_POOL_SIZE];
-    picture_pool_t              *picture_pool;
+    vlc_mutex_t                 lock;
+    vlc_cond_t                  wait;
+    unsigned                    max_count; ///< maximum number of buffers
+    unsigned                    count; ///< number of allocated buffers
+    unsigned                    free_count;
 
     vlc_atomic_rc_t             rc;
-} nvdec_pool_t;
+    nvdec_pool_buffer_t         *free[]; ///< unused buffers, max_count entries
+};
 
 typedef struct pic_pool_context_nvdec_t {
   pic_context_nvdec_t ctx;
@@ -128,11 +145,19 @@ typedef struct nvdec_ctx {
 
 static void nvdec_pool_Destroy(nvdec_pool_t *pool)
 {
-    for (size_t i=0; i < ARRAY_SIZE(pool->outputDevicePtr); i++)
-        CALL_CUDA_POOL(cuMemFree, pool->outputDevicePtr[i]);
+    // all buffers are back, since pictures hold a reference to the pool
+    assert(pool->free_count == pool->count);
+
+    CALL_CUDA_POOL(cuCtxPushCurrent, pool->nvdec_dev->cuCtx);
+    for (unsigned i=0; i < pool->free_count; i++)
+    {
+        CALL_CUDA_POOL(cuMemFree, pool->free[i]->devicePtr);
+        free(pool->free[i]);
+    }
+    CALL_CUDA_POOL(cuCtxPopCurrent, NULL);
 
-    picture_pool_Release(pool->picture_pool);
     vlc_video_context_Release(pool->vctx);
+    free(pool);
 }
 
 static void nvdec_pool_AddRef(nvdec_pool_t *pool)
@@ -148,72 +173,96 @@ static void nvdec_pool_Release(nvdec_pool_t *pool)
     nvdec_pool_Destroy(pool);
 }
 
+static nvdec_pool_buffer_t *nvdec_pool_AllocBuffer(nvdec_pool_t *pool)
+{
+    nvdec_pool_buffer_t *buf = malloc(sizeof(*buf));
+    if (unlikely(buf == NULL))
+        return NULL;
+
+    buf->pool = pool;
+    buf->devicePtr = 0;
+
+    int ret = CALL_CUDA_POOL(cuCtxPushCurrent, pool->nvdec_dev->cuCtx);
+    if (ret == CUDA_SUCCESS)
+    {
+        ret = CALL_CUDA_POOL(cuMemAlloc, &buf->devicePtr, pool->buffer_size);
+        CALL_CUDA_POOL(cuCtxPopCurrent, NULL);
+    }
+    if (ret != CUDA_SUCCESS || buf->devicePtr == 0)
+    {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
 static nvdec_pool_t* nvdec_pool_Create(vlc_video_context *vctx,
                                        const video_format_t *fmt,
                                        size_t buffer_pitch,
-                                       size_t buffer_height)
+                                       size_t buffer_height,
+                                       unsigned max_count)
 {
-    vlc_decoder_device *dec_dev = NULL;
-    nvdec_pool_t *pool = calloc(1, sizeof(*pool));
-    if (!pool)
-        goto error;
-
-    dec_dev = vlc_video_context_HoldDevice(vctx);
+    vlc_decoder_device *dec_dev = vlc_video_context_HoldDevice(vctx);
     if (dec_dev == NULL)
-        goto error;
+        return NULL;
+
+    nvdec_pool_t *pool = malloc(sizeof(*pool) + max_count * sizeof(pool->free[0]));
+    if (!pool)
+    {
+        vlc_decoder_device_Release(dec_dev);
+        return NULL;
+    }
 
     pool->nvdec_dev = GetNVDECOpaqueDevice(dec_dev);
     assert(pool->nvdec_dev != NULL);
+    // the video context holds the device for the lifetime of the pool
+    vlc_decoder_device_Release(dec_dev);
 
-    int ret = CALL_CUDA_POOL(cuCtxPushCurrent, pool->nvdec_dev->cuCtx);
-    if (ret != CUDA_SUCCESS)
-        goto error;
+    pool->fmt = *fmt;
+    pool->buffer_size = buffer_pitch * buffer_height;
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
+    pool->max_count = max_count;
+    pool->count = 0;
+    pool->free_count = 0;
 
-    picture_t *pics[ARRAY_SIZE(pool->outputDevicePtr)] = {0};
-    for (size_t i=0; i < ARRAY_SIZE(pool->outputDevicePtr); i++)
+    while (pool->count < __MIN(MIN_POOL_SIZE, max_count))
     {
-        ret = CALL_CUDA_POOL(cuMemAlloc,
-                             &pool->outputDevicePtr[i],
-                             buffer_pitch * buffer_height);
-        if (ret != CUDA_SUCCESS || pool->outputDevicePtr[i] == 0)
-            goto free_pool;
-
-        picture_resource_t res = {
-            .p_sys = pool->outputDevicePtr[i],
-        };
-        pics[i] = picture_NewFromResource(fmt, &res);
-        if (!pics[i])
-            goto free_pool;
+        nvdec_pool_buffer_t *buf = nvdec_pool_AllocBuffer(pool);
+        if (buf == NULL)
+            break;
+        pool->free[pool->free_count++] = buf;
+        pool->count++;
     }
 
-    pool->picture_pool = picture_pool_New(ARRAY_SIZE(pool->outputDevicePtr), pics);
-    if (!pool->picture_pool)
-        goto free_pool;
-
-    CALL_CUDA_POOL(cuCtxPopCurrent, NULL);
-    vlc_decoder_device_Release(dec_dev);
-
     pool->vctx = vctx;
     vlc_video_context_Hold(pool->vctx);
-
     vlc_atomic_rc_init(&pool->rc);
-    return pool;
 
-free_pool:
-    for (size_t i=0; i < ARRAY_SIZE(pool->outputDevicePtr); i++)
+    if (pool->count == 0)
     {
-        if (pool->outputDevicePtr[i] != 0)
-            CALL_CUDA_POOL(cuMemFree, pool->outputDevicePtr[i]);
-        if (pics[i] != NULL)
-            picture_Release(pics[i]);
+        nvdec_pool_Release(pool);
+        return NULL;
     }
-    CALL_CUDA_POOL(cuCtxPopCurrent, NULL);
-error:
-    if (dec_dev)
-        vlc_decoder_device_Release(dec_dev);
-    if (pool)
-        free(pool);
-    return NULL;
+    return pool;
+}
+
+static void nvdec_pool_PutBuffer(nvdec_pool_t *pool, nvdec_pool_buffer_t *buf)
+{
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->free_count < pool->count);
+    pool->free[pool->free_count++] = buf;
+    vlc_cond_signal(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+}
+
+static void nvdec_pool_ReleaseBuffer(picture_t *pic)
+{
+    nvdec_pool_buffer_t *buf = pic->p_sys;
+    nvdec_pool_t *pool = buf->pool;
+
+    nvdec_pool_PutBuffer(pool, buf);
+    nvdec_pool_Release(pool);
 }
 
 static void nvdec_picture_CtxDestroy(struct picture_context_t *picctx)
@@ -238,9 +287,47 @@ static struct picture_context_t *nvdec_picture_CtxClone(struct picture_context_t
 
 static picture_t* nvdec_pool_Wait(nvdec_pool_t *pool)
 {
-    picture_t *pic = picture_pool_Wait(pool->picture_pool);
-    if (!pic)
+    nvdec_pool_buffer_t *buf = NULL;
+
+    vlc_mutex_lock(&pool->lock);
+    while (buf == NULL)
+    {
+        if (pool->free_count > 0)
+        {
+            buf = pool->free[--pool->free_count];
+            break;
+        }
+        if (pool->count >= pool->max_count)
+        {
+            vlc_cond_wait(&pool->wait, &pool->lock);
+            continue;
+        }
+
+        // grow the pool, outside the lock as allocating may take a while
+        pool->count++;
+        vlc_mutex_unlock(&pool->lock);
+        buf = nvdec_pool_AllocBuffer(pool);
+        vlc_mutex_lock(&pool->lock);
+        if (buf == NULL)
+        {
+            // out of memory: do with the buffers allocated so far
+            pool->count--;
+            pool->max_count = pool->count;
+        }
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    picture_resource_t res = {
+        .p_sys = buf,
+        .pf_destroy = nvdec_pool_ReleaseBuffer,
+    };
+    picture_t *pic = picture_NewFromResource(&pool->fmt, &res);
+    if (unlikely(pic == NULL))
+    {
+        nvdec_pool_PutBuffer(pool, buf);
         return NULL;
+    }
+    nvdec_pool_AddRef(pool); // released with the buffer
 
     pic_pool_context_nvdec_t *picctx = malloc(sizeof(*picctx));
     if (!picctx)
@@ -252,6 +339,7 @@ static picture_t* nvdec_pool_Wait(nvdec_pool_t *pool)
         pool->vctx,
     };
     vlc_video_context_Hold(picctx->ctx.ctx.vctx);
+    picctx->ctx.devicePtr = buf->devicePtr;
 
     picctx->pool = pool;
     nvdec_pool_AddRef(picctx->pool);
@@ -347,6 +435,24 @@ static int CUtoFMT(video_format_t *fmt, const CUVIDEOFORMAT *p_format)
     return VLC_SUCCESS;
 }
 
+static unsigned GetOutputPoolSize(decoder_t *p_dec)
+{
+    nvdec_ctx_t *p_sys = p_dec->p_sys;
+    // the decode surfaces include the picture being decoded
+    unsigned dpb_size = p_sys->i_nb_surface - 1;
+
+    if (p_dec->fmt_in.i_codec == VLC_CODEC_H264)
+    {
+        uint8_t depth;
+        unsigned delay;
+        if (h264_helper_get_current_dpb_values(&p_sys->hh, &depth, &delay) == VLC_SUCCESS)
+            dpb_size = depth;
+    }
+
+    unsigned count = NVDEC_DISPLAY_SURFACES + NVDEC_VOUT_PICTURES + dpb_size;
+    return __MIN(count, MAX_POOL_SIZE);
+}
+
 static int CUDAAPI HandleVideoSequence(void *p_opaque, CUVIDEOFORMAT *p_format)
 {
     decoder_t *p_dec = (decoder_t *) p_opaque;
@@ -431,7 +537,8 @@ static int CUDAAPI HandleVideoSequence(void *p_opaque, CUVIDEOFORMAT *p_format)
         p_sys->out_pool = nvdec_pool_Create(p_sys->vctx_out,
                                             &p_dec->fmt_out.video,
                                             ByteWidth,
-                                            Height);
+                                            Height,
+                                            GetOutputPoolSize(p_dec));
         if (p_sys->out_pool == NULL)
             goto cuda_error;
     }
@@ -502,7 +609,6 @@ static int CUDAAPI HandlePictureDisplay(void *p_opaque, CUVIDPARSERDISPINFO *p_d
         if (result != VLC_SUCCESS)
             goto error;
 
-        picctx->devicePtr = (CUdeviceptr)p_pic->p_sys;
         picctx->bufferPitch = p_sys->outputPitch;
         picctx->bufferHeight = p_sys->decoderHeight;
 
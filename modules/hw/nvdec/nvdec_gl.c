@@ -59,7 +59,6 @@ typedef struct {
     vlc_decoder_device *device;
     CUcontext cuConverterCtx;
     CUgraphicsResource cu_res[PICTURE_PLANE_MAX]; // Y, UV for NV12/P010
-    CUarray mappedArray[PICTURE_PLANE_MAX];
 } converter_sys_t;
 
 #define CALL_CUDA(func, ...) CudaCheckErr(VLC_OBJECT(interop->gl), devsys->cudaFunctions, devsys->cudaFunctions->func(__VA_ARGS__), #func)
@@ -85,16 +84,22 @@ static int tc_nvdec_gl_allocate_texture(const struct vlc_gl_interop *interop, GL
         if (interop->vt->GetError() != GL_NO_ERROR)
         {
             msg_Err(interop->gl, "could not alloc PBO buffers");
-            return VLC_EGENERIC;
+            result = VLC_EGENERIC;
+            break;
         }
 
+        // the textures stay registered until they are released, only the
+        // mapping is done for each picture
+        if (p_sys->cu_res[i] != NULL)
+        {
+            CALL_CUDA(cuGraphicsUnregisterResource, p_sys->cu_res[i]);
+            p_sys->cu_res[i] = NULL;
+        }
         result = CALL_CUDA(cuGraphicsGLRegisterImage, &p_sys->cu_res[i], textures[i], interop->tex_target, CU_GRAPHICS_REGISTER_FLAGS_WRITE_DISCARD);
 
-        result = CALL_CUDA(cuGraphicsMapResources, 1, &p_sys->cu_res[i], 0);
-        result = CALL_CUDA(cuGraphicsSubResourceGetMappedArray, &p_sys->mappedArray[i], p_sys->cu_res[i], 0, 0);
-        result = CALL_CUDA(cuGraphicsUnmapResources, 1, &p_sys->cu_res[i], 0);
-
         interop->vt->BindTexture(interop->tex_target, 0);
+        if (result != VLC_SUCCESS)
+            break;
     }
 
     CALL_CUDA(cuCtxPopCurrent, NULL);
@@ -119,6 +124,19 @@ tc_nvdec_gl_update(const struct vlc_gl_interop *interop, GLuint textures[],
     if (result != VLC_SUCCESS)
         return result;
 
+    // map all the planes at once, the arrays are only valid while mapped
+    result = CALL_CUDA(cuGraphicsMapResources, interop->tex_count, p_sys->cu_res, 0);
+    if (result != VLC_SUCCESS)
+        goto error;
+
+    CUarray mappedArray[PICTURE_PLANE_MAX];
+    for (unsigned i = 0; i < interop->tex_count; i++)
+    {
+        result = CALL_CUDA(cuGraphicsSubResourceGetMappedArray, &mappedArray[i], p_sys->cu_res[i], 0, 0);
+        if (result != VLC_SUCCESS)
+            goto unmap;
+    }
+
     // copy the planes from the pic context to mappedArray
     size_t srcY = 0;
     for (unsigned i = 0; i < interop->tex_count; i++)
@@ -129,7 +147,7 @@ tc_nvdec_gl_update(const struct vlc_gl_interop *interop, GLuint textures[],
             .srcPitch       = srcpic->bufferPitch,
             .srcY           = srcY,
             .dstMemoryType = CU_MEMORYTYPE_ARRAY,
-            .dstArray = p_sys->mappedArray[i],
+            .dstArray = mappedArray[i],
             .WidthInBytes = tex_widths[0],
             .Height = tex_heights[i],
         };
@@ -137,10 +155,13 @@ tc_nvdec_gl_update(const struct vlc_gl_interop *interop, GLuint textures[],
             cu_cpy.WidthInBytes *= 2;
         result = CALL_CUDA(cuMemcpy2DAsync, &cu_cpy, 0);
         if (result != VLC_SUCCESS)
-            goto error;
+            goto unmap;
         srcY += srcpic->bufferHeight;
     }
 
+unmap:
+    // unmapping orders the copies before any subsequent OpenGL use
+    CALL_CUDA(cuGraphicsUnmapResources, interop->tex_count, p_sys->cu_res, 0);
 error:
     CALL_CUDA(cuCtxPopCurrent, NULL);
     return result;
@@ -150,7 +171,19 @@ static void Close(vlc_object_t *obj)
 {
     struct vlc_gl_interop *interop = (void *)obj;
     converter_sys_t *p_sys = interop->priv;
-    vlc_decoder_device_Release(p_sys->device);
+    vlc_decoder_device *device = p_sys->device;
+    decoder_device_nvdec_t *devsys = GetNVDECOpaqueDevice(device);
+
+    if (CALL_CUDA(cuCtxPushCurrent, p_sys->cuConverterCtx ? p_sys->cuConverterCtx : devsys->cuCtx) == VLC_SUCCESS)
+    {
+        for (size_t i=0; i < ARRAY_SIZE(p_sys->cu_res); i++)
+            if (p_sys->cu_res[i] != NULL)
+                CALL_CUDA(cuGraphicsUnregisterResource, p_sys->cu_res[i]);
+        CALL_CUDA(cuCtxPopCurrent, NULL);
+    }
+    if (p_sys->cuConverterCtx)
+        CALL_CUDA(cuCtxDestroy, p_sys->cuConverterCtx);
+    vlc_decoder_device_Release(device);
 }
 
 static int Open(vlc_object_t *obj)
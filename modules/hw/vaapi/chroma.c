@@ -35,13 +35,9 @@
 #include "../../video_chroma/copy.h"
 #include "filters.h"
 
-# define DEST_PICS_POOL_SZ 3
-
 typedef struct
 {
     VADisplay           dpy;
-    picture_pool_t *    dest_pics;
-    VASurfaceID *       va_surface_ids;
     copy_cache_t        cache;
 
     bool                derive_failed;
@@ -242,7 +238,9 @@ UploadSurface(filter_t *filter, picture_t *src)
     VADisplay const va_dpy = p_sys->dpy;
     VAImage         dest_img;
     void *          dest_buf;
-    picture_t *     dest_pic = picture_pool_Wait(p_sys->dest_pics);
+    picture_t *     dest_pic =
+        vlc_vaapi_PoolGetShared(VLC_OBJECT(filter), filter->vctx_out,
+                                &filter->fmt_out.video);
 
     if (!dest_pic)
     {
@@ -351,7 +349,7 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
             return VLC_EGENERIC;
         }
 
-        filter->vctx_out = vlc_video_context_Create( dec_device, VLC_VIDEO_CONTEXT_VAAPI, 0, NULL );
+        filter->vctx_out = vlc_vaapi_VideoContextCreate( dec_device );
         vlc_decoder_device_Release(dec_device);
         if (!filter->vctx_out)
         {
@@ -360,25 +358,12 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
         }
 
         filter_sys->dpy = dec_device->opaque;
-
-        filter_sys->dest_pics =
-            vlc_vaapi_PoolNew(obj, filter->vctx_out, filter_sys->dpy,
-                              DEST_PICS_POOL_SZ, &filter_sys->va_surface_ids,
-                              &filter->fmt_out.video);
-        if (!filter_sys->dest_pics)
-        {
-            vlc_video_context_Release(filter->vctx_out);
-            filter->vctx_out = NULL;
-            free(filter_sys);
-            return VLC_EGENERIC;
-        }
     }
     else
     {
         /* Don't fetch the vaapi instance since it may be not created yet at
          * this point (in case of cpu rendering) */
         filter_sys->dpy = NULL;
-        filter_sys->dest_pics = NULL;
     }
 
     if (CopyInitCache(&filter_sys->cache, filter->fmt_in.video.i_width
@@ -386,7 +371,6 @@ vlc_vaapi_OpenChroma(vlc_object_t *obj)
     {
         if (is_upload)
         {
-            picture_pool_Release(filter_sys->dest_pics);
             vlc_video_context_Release(filter->vctx_out);
             filter->vctx_out = NULL;
         }
@@ -410,8 +394,6 @@ vlc_vaapi_CloseChroma(vlc_object_t *obj)
     filter_t *filter = (filter_t *)obj;
     filter_sys_t *const filter_sys = filter->p_sys;
 
-    if (filter_sys->dest_pics)
-        picture_pool_Release(filter_sys->dest_pics);
     CopyCleanCache(&filter_sys->cache);
     if (filter->vctx_out)
         vlc_video_context_Release(filter->vctx_out);
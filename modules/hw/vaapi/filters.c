@@ -43,19 +43,15 @@ struct  va_filter_desc
     VAConfigID          conf;
     VAContextID         ctx;
     VABufferID          buf;
-    VASurfaceID *       surface_ids;
 };
 
 typedef struct
 {
     struct va_filter_desc       va;
-    picture_pool_t *            dest_pics;
     bool                        b_pipeline_fast;
     void *                      p_data;
 } filter_sys_t;
 
-#define DEST_PICS_POOL_SZ       3
-
 struct  range
 {
     float       min_value;
@@ -157,19 +153,30 @@ struct  basic_filter_data
 
 struct  deint_mode
 {
-    char                        name[5];
+    char const *                name;
     VAProcDeinterlacingType     type;
     bool                        b_double_rate;
+    bool                        b_keep_progressive;
 };
 
+/* VA has no phosphor: it is mapped to the closest algorithms, so that the
+ * pictures stay on the GPU rather than going through the software filter. */
 static struct deint_mode const  deint_modes[] =
 {
-    { "x",     VAProcDeinterlacingMotionAdaptive,     true },
-    { "x",     VAProcDeinterlacingMotionCompensated,  true },
-    { "bob",   VAProcDeinterlacingBob,                true },
-    { "mean",  VAProcDeinterlacingWeave,              false }
+    { "x",        VAProcDeinterlacingMotionAdaptive,     true,  false },
+    { "x",        VAProcDeinterlacingMotionCompensated,  true,  false },
+    { "bob",      VAProcDeinterlacingBob,                true,  false },
+    { "mean",     VAProcDeinterlacingWeave,              false, false },
+    { "phosphor", VAProcDeinterlacingMotionAdaptive,     true,  false },
+    { "phosphor", VAProcDeinterlacingBob,                true,  false },
 };
 
+/* VA has no inverse telecine either, and no deinterlacer recovers the film
+ * frames. Rather than doubling the frame rate, keep it: the progressive
+ * (soft-telecined) pictures are passed through, and the others are bobbed. */
+static struct deint_mode const  deint_mode_ivtc =
+    { "bob", VAProcDeinterlacingBob, false, true };
+
 #define METADATA_SIZE 3
 
 struct  deint_data
@@ -195,6 +202,7 @@ struct  deint_data
     } meta[METADATA_SIZE];
 
     bool                b_double_rate;
+    bool                b_keep_progressive;
     unsigned int        cur_frame;
 };
 
@@ -211,7 +219,9 @@ Filter(filter_t * filter, picture_t * src,
 {
     filter_sys_t *const filter_sys = filter->p_sys;
     VABufferID          pipeline_buf = VA_INVALID_ID;
-    picture_t *const    dest = picture_pool_Wait(filter_sys->dest_pics);
+    picture_t *const    dest =
+        vlc_vaapi_PoolGetShared(VLC_OBJECT(filter), filter->vctx_out,
+                                &filter->fmt_out.video);
     if (!dest)
         return NULL;
 
@@ -317,13 +327,6 @@ Open(filter_t * filter,
     filter_sys->va.dpy = filter_sys->va.dec_device->opaque;
     assert(filter_sys->va.dec_device);
 
-    filter_sys->dest_pics =
-        vlc_vaapi_PoolNew(VLC_OBJECT(filter), filter->vctx_in,
-                          filter_sys->va.dpy, DEST_PICS_POOL_SZ,
-                          &filter_sys->va.surface_ids, &filter->fmt_out.video);
-    if (!filter_sys->dest_pics)
-        goto error;
-
     filter_sys->va.conf =
         vlc_vaapi_CreateConfigChecked(VLC_OBJECT(filter), filter_sys->va.dpy,
                                       VAProfileNone, VAEntrypointVideoProc,
@@ -331,13 +334,15 @@ Open(filter_t * filter,
     if (filter_sys->va.conf == VA_INVALID_ID)
         goto error;
 
+    /* The output surfaces come from the pools shared through the video
+     * context, so that they are recycled across the whole filter chain: the
+     * processing context is not bound to any render target. */
     filter_sys->va.ctx =
         vlc_vaapi_CreateContext(VLC_OBJECT(filter),
                                 filter_sys->va.dpy, filter_sys->va.conf,
                                 filter->fmt_out.video.i_width,
                                 filter->fmt_out.video.i_height,
-                                0, filter_sys->va.surface_ids,
-                                DEST_PICS_POOL_SZ);
+                                0, NULL, 0);
     if (filter_sys->va.ctx == VA_INVALID_ID)
         goto error;
 
@@ -392,8 +397,6 @@ error:
     if (filter_sys->va.conf != VA_INVALID_ID)
         vlc_vaapi_DestroyConfig(VLC_OBJECT(filter),
                                 filter_sys->va.dpy, filter_sys->va.conf);
-    if (filter_sys->dest_pics)
-        picture_pool_Release(filter_sys->dest_pics);
     if (filter_sys->va.dec_device)
         vlc_decoder_device_Release(filter_sys->va.dec_device);
     free(filter_sys);
@@ -404,7 +407,6 @@ static void
 Close(filter_t *filter, filter_sys_t * filter_sys)
 {
     vlc_object_t * obj = VLC_OBJECT(filter);
-    picture_pool_Release(filter_sys->dest_pics);
     vlc_vaapi_DestroyBuffer(obj, filter_sys->va.dpy, filter_sys->va.buf);
     vlc_vaapi_DestroyContext(obj, filter_sys->va.dpy, filter_sys->va.ctx);
     vlc_vaapi_DestroyConfig(obj, filter_sys->va.dpy, filter_sys->va.conf);
@@ -823,6 +825,9 @@ Deinterlace(filter_t * filter, picture_t * src)
     if (p_deint_data->history.num_pics < p_deint_data->history.sz)
         return NULL;
 
+    if (p_deint_data->b_keep_progressive && src->b_progressive)
+        return picture_Hold(src);
+
     picture_t *const    dest =
         Filter(filter, src,
                Deinterlace_UpdateFilterParams,
@@ -940,6 +945,15 @@ OpenDeinterlace_GetMode(filter_t * filter, char const * deint_mode,
                         unsigned int num_caps)
 {
     bool fallback = false;
+    if (deint_mode && !strcmp(deint_mode, "ivtc")
+     && OpenDeinterlace_IsValidType(filter, caps, num_caps, &deint_mode_ivtc))
+    {
+        *p_deint_mode = deint_mode_ivtc;
+        msg_Warn(filter, "inverse telecine not supported, using %s "
+                 "deinterlace method at the frame rate instead",
+                 deint_mode_ivtc.name);
+        return VLC_SUCCESS;
+    }
     if (deint_mode && strcmp(deint_mode, "auto"))
     {
         for (unsigned int i = 0; i < ARRAY_SIZE(deint_modes); ++i)
@@ -1024,6 +1038,7 @@ OpenDeinterlace_InitFilterParams(filter_t * filter, void * p_data,
     *pp_va_params = p_va_param;
 
     p_deint_data->b_double_rate = deint_mode.b_double_rate;
+    p_deint_data->b_keep_progressive = deint_mode.b_keep_progressive;
 
     return VLC_SUCCESS;
 }
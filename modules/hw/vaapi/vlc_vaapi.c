@@ -414,19 +414,160 @@ struct pic_sys_vaapi_instance
     VASurfaceID render_targets[];
 };
 
+/* Surfaces of one format shared by all the pictures allocated from a video
+ * context. Surfaces are only created when none is free, so that the pool size
+ * follows the peak usage of the whole filter chain. */
+#define SHARED_POOL_MAX_SURFACES 32
+
+struct vaapi_shared_pool
+{
+    struct vaapi_shared_pool *next;
+    vlc_decoder_device *dec_device;
+    VADisplay dpy;
+
+    vlc_fourcc_t i_chroma;
+    unsigned width;
+    unsigned height;
+    unsigned va_rt_format;
+    int va_fourcc;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned refs;
+    unsigned allocated;
+    unsigned free_count;
+    VASurfaceID free_surfaces[SHARED_POOL_MAX_SURFACES];
+};
+
+struct vaapi_vctx
+{
+    vlc_mutex_t lock;
+    struct vaapi_shared_pool *pools;
+};
+
 typedef struct
 {
     struct pic_sys_vaapi_instance *instance;
+    struct vaapi_shared_pool *shared;
     struct vaapi_pic_ctx ctx;
 } picture_sys_t;
 
+static void
+SharedPoolRelease(struct vaapi_shared_pool *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    bool last = --pool->refs == 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    if (!last)
+        return;
+
+    /* No pictures are left: every surface is back in the free list */
+    assert(pool->free_count == pool->allocated);
+    if (pool->free_count > 0)
+        vaDestroySurfaces(pool->dpy, pool->free_surfaces, pool->free_count);
+    vlc_decoder_device_Release(pool->dec_device);
+    free(pool);
+}
+
+static void
+SharedPoolPut(struct vaapi_shared_pool *pool, VASurfaceID surface)
+{
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->free_count < pool->allocated);
+    pool->free_surfaces[pool->free_count++] = surface;
+    vlc_cond_signal(&pool->wait);
+    vlc_mutex_unlock(&pool->lock);
+
+    SharedPoolRelease(pool);
+}
+
+static struct vaapi_shared_pool *
+SharedPoolHold(vlc_video_context *vctx, const video_format_t *restrict fmt)
+{
+    struct vaapi_vctx *priv =
+        vlc_video_context_GetPrivate(vctx, VLC_VIDEO_CONTEXT_VAAPI);
+    struct vaapi_shared_pool *pool;
+
+    assert(priv != NULL);
+    vlc_mutex_lock(&priv->lock);
+    for (pool = priv->pools; pool != NULL; pool = pool->next)
+        if (pool->i_chroma == fmt->i_chroma
+         && pool->width == fmt->i_visible_width
+         && pool->height == fmt->i_visible_height)
+        {
+            vlc_mutex_lock(&pool->lock);
+            pool->refs++;
+            vlc_mutex_unlock(&pool->lock);
+            goto out;
+        }
+
+    pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        goto out;
+
+    pool->dec_device = vlc_video_context_HoldDevice(vctx);
+    pool->dpy = pool->dec_device->opaque;
+    pool->i_chroma = fmt->i_chroma;
+    pool->width = fmt->i_visible_width;
+    pool->height = fmt->i_visible_height;
+    vlc_chroma_to_vaapi(fmt->i_chroma, &pool->va_rt_format, &pool->va_fourcc);
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait);
+    pool->refs = 2; /* the video context and the caller */
+    pool->allocated = 0;
+    pool->free_count = 0;
+    pool->next = priv->pools;
+    priv->pools = pool;
+out:
+    vlc_mutex_unlock(&priv->lock);
+    return pool;
+}
+
+static void
+vaapi_vctx_destroy_cb(void *opaque)
+{
+    struct vaapi_vctx *priv = opaque;
+
+    while (priv->pools != NULL)
+    {
+        struct vaapi_shared_pool *pool = priv->pools;
+
+        priv->pools = pool->next;
+        SharedPoolRelease(pool);
+    }
+}
+
+static const struct vlc_video_context_operations vaapi_vctx_ops =
+{
+    vaapi_vctx_destroy_cb,
+};
+
+vlc_video_context *
+vlc_vaapi_VideoContextCreate(vlc_decoder_device *dec_device)
+{
+    vlc_video_context *vctx =
+        vlc_video_context_Create(dec_device, VLC_VIDEO_CONTEXT_VAAPI,
+                                 sizeof (struct vaapi_vctx), &vaapi_vctx_ops);
+    if (vctx == NULL)
+        return NULL;
+
+    struct vaapi_vctx *priv =
+        vlc_video_context_GetPrivate(vctx, VLC_VIDEO_CONTEXT_VAAPI);
+    vlc_mutex_init(&priv->lock);
+    priv->pools = NULL;
+    return vctx;
+}
+
 static void
 pool_pic_destroy_cb(picture_t *pic)
 {
     picture_sys_t *p_sys = pic->p_sys;
     struct pic_sys_vaapi_instance *instance = p_sys->instance;
 
-    if (atomic_fetch_sub(&instance->pic_refcount, 1) == 1)
+    if (p_sys->shared != NULL)
+        SharedPoolPut(p_sys->shared, p_sys->ctx.ctx.surface);
+    else if (atomic_fetch_sub(&instance->pic_refcount, 1) == 1)
     {
         vaDestroySurfaces(p_sys->ctx.ctx.va_dpy, instance->render_targets,
                           instance->num_render_targets);
@@ -505,6 +646,7 @@ vlc_vaapi_PoolNew(vlc_object_t *o, vlc_video_context *vctx,
             goto error_pic;
         }
         p_sys->instance = instance;
+        p_sys->shared = NULL;
         p_sys->ctx.ctx.s = (picture_context_t) {
             pic_sys_ctx_destroy_cb, pic_ctx_copy_cb,
             vctx, // it will be held during PicSetContext
@@ -546,6 +688,81 @@ error:
     return NULL;
 }
 
+picture_t *
+vlc_vaapi_PoolGetShared(vlc_object_t *o, vlc_video_context *vctx,
+                        const video_format_t *restrict fmt)
+{
+    struct vaapi_shared_pool *pool = SharedPoolHold(vctx, fmt);
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    picture_sys_t *p_sys = malloc(sizeof *p_sys);
+    if (unlikely(p_sys == NULL))
+    {
+        SharedPoolRelease(pool);
+        return NULL;
+    }
+
+    VASurfaceID surface;
+
+    vlc_mutex_lock(&pool->lock);
+    while (pool->free_count == 0
+        && pool->allocated >= SHARED_POOL_MAX_SURFACES)
+        vlc_cond_wait(&pool->wait, &pool->lock);
+
+    if (pool->free_count > 0)
+        surface = pool->free_surfaces[--pool->free_count];
+    else
+    {
+        VASurfaceAttrib fourcc_attribs[1] = {
+            {
+                .type = VASurfaceAttribPixelFormat,
+                .flags = VA_SURFACE_ATTRIB_SETTABLE,
+                .value.type    = VAGenericValueTypeInteger,
+                .value.value.i = pool->va_fourcc,
+            }
+        };
+        VAStatus status = vaCreateSurfaces(pool->dpy, pool->va_rt_format,
+                                           pool->width, pool->height,
+                                           &surface, 1, fourcc_attribs, 1);
+        if (status != VA_STATUS_SUCCESS)
+        {
+            vlc_mutex_unlock(&pool->lock);
+            msg_Err(o, "vaCreateSurfaces: %s", vaErrorStr(status));
+            free(p_sys);
+            SharedPoolRelease(pool);
+            return NULL;
+        }
+        pool->allocated++;
+        msg_Dbg(o, "shared %ux%u %4.4s surface pool grown to %u",
+                pool->width, pool->height, (const char *)&pool->i_chroma,
+                pool->allocated);
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    p_sys->instance = NULL;
+    p_sys->shared = pool;
+    p_sys->ctx.ctx.s = (picture_context_t) {
+        pic_sys_ctx_destroy_cb, pic_ctx_copy_cb,
+        vctx, // it will be held during PicSetContext
+    };
+    p_sys->ctx.ctx.surface = surface;
+    p_sys->ctx.ctx.va_dpy = pool->dpy;
+    p_sys->ctx.picref = NULL;
+
+    picture_resource_t rsc = {
+        .p_sys = p_sys,
+        .pf_destroy = pool_pic_destroy_cb,
+    };
+    picture_t *pic = picture_NewFromResource(fmt, &rsc);
+    if (unlikely(pic == NULL))
+    {
+        free(p_sys);
+        SharedPoolPut(pool, surface);
+    }
+    return pic;
+}
+
 #define ASSERT_VAAPI_CHROMA(pic) do { \
     assert(vlc_vaapi_IsChromaOpaque(pic->format.i_chroma)); \
 } while(0)
@@ -173,8 +173,22 @@ vlc_vaapi_PoolNew(vlc_object_t *o, vlc_video_context *vctx,
                   VADisplay dpy, unsigned count, VASurfaceID **render_targets,
                   const video_format_t *restrict fmt);
 
+/* Creates a VAAPI video context. Pictures of the context can be allocated from
+ * surface pools shared by all the users of the context (see
+ * vlc_vaapi_PoolGetShared()). */
+vlc_video_context *
+vlc_vaapi_VideoContextCreate(vlc_decoder_device *dec_device);
+
+/* Gets a picture backed by a VASurfaceID from the pool of the video context
+ * matching the format. The pool grows when no surface is free, up to a fixed
+ * limit, then waits for a picture to be released. The video context must be
+ * created by vlc_vaapi_VideoContextCreate(). */
+picture_t *
+vlc_vaapi_PoolGetShared(vlc_object_t *o, vlc_video_context *vctx,
+                        const video_format_t *restrict fmt);
+
 /* Attachs the VASurface to the picture context, the picture must be allocated
- * by a vaapi pool (see vlc_vaapi_PoolNew()) */
+ * by a vaapi pool (see vlc_vaapi_PoolNew() and vlc_vaapi_PoolGetShared()) */
 void
 vlc_vaapi_PicAttachContext(picture_t *pic);
 
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * json.c: Chrome/Perfetto JSON trace output
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_fs.h>
+#include <vlc_tracer.h>
+
+/* Events are written in the JSON array format of the Trace Event Format,
+ * which chrome://tracing and ui.perfetto.dev both load:
+ * https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+ */
+
+#define TRACE_FILENAME "vlc-trace.json"
+
+typedef struct
+{
+    FILE *stream;
+    vlc_mutex_t lock;
+    unsigned long pid;
+    bool first;
+} vlc_tracer_sys_t;
+
+static void Trace(void *opaque, const struct vlc_trace_event *event)
+{
+    vlc_tracer_sys_t *sys = opaque;
+    FILE *stream = sys->stream;
+
+    vlc_mutex_lock(&sys->lock);
+    fputs(sys->first ? "\n" : ",\n", stream);
+    sys->first = false;
+
+    fprintf(stream, "{\"name\":\"%s\",\"cat\":\"%s\",\"pid\":%lu,"
+            "\"tid\":%lu,\"ts\":%"PRId64, event->name, event->category,
+            sys->pid, event->thread, US_FROM_VLC_TICK(event->ts));
+
+    switch (event->type)
+    {
+        case VLC_TRACE_SPAN:
+            fprintf(stream, ",\"ph\":\"X\",\"dur\":%"PRId64,
+                    US_FROM_VLC_TICK(event->duration));
+            if (event->object != NULL)
+                fprintf(stream, ",\"args\":{\"object\":\"%p\"}",
+                        event->object);
+            break;
+        case VLC_TRACE_COUNTER:
+            /* The ID separates the counters of each object */
+            fputs(",\"ph\":\"C\"", stream);
+            if (event->object != NULL)
+                fprintf(stream, ",\"id\":\"%p\"", event->object);
+            fprintf(stream, ",\"args\":{\"value\":%"PRId64"}", event->value);
+            break;
+    }
+    putc('}', stream);
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void Close(void *opaque)
+{
+    vlc_tracer_sys_t *sys = opaque;
+
+    fputs("\n]\n", sys->stream);
+    fclose(sys->stream);
+    free(sys);
+}
+
+static const struct vlc_tracer_operations json_ops =
+{
+    Trace,
+    Close
+};
+
+static const struct vlc_tracer_operations *Open(vlc_object_t *obj,
+                                                void **restrict sysp)
+{
+    vlc_tracer_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return NULL;
+
+    char *path = var_InheritString(obj, "json-tracer-file");
+    const char *filename = (path != NULL) ? path : TRACE_FILENAME;
+
+    msg_Dbg(obj, "opening trace file `%s'", filename);
+    sys->stream = vlc_fopen(filename, "wt");
+    if (sys->stream == NULL)
+    {
+        msg_Err(obj, "error opening trace file `%s': %s", filename,
+                vlc_strerror_c(errno));
+        free(path);
+        free(sys);
+        return NULL;
+    }
+    free(path);
+
+    vlc_mutex_init(&sys->lock);
+    sys->pid = getpid();
+    sys->first = true;
+    fputc('[', sys->stream);
+
+    *sysp = sys;
+    return &json_ops;
+}
+
+#define FILE_TEXT N_("Trace file name")
+#define FILE_LONGTEXT N_("File to write the trace events to, in the " \
+    "Chrome/Perfetto JSON format (default: " TRACE_FILENAME ").")
+
+vlc_module_begin()
+    set_shortname(N_("JSON tracer"))
+    set_description(N_("Chrome/Perfetto JSON tracer"))
+    set_category(CAT_ADVANCED)
+    set_subcategory(SUBCAT_ADVANCED_MISC)
+    set_capability("tracer", 0)
+    set_callback(Open)
+
+    add_savefile("json-tracer-file", NULL, FILE_TEXT, FILE_LONGTEXT)
+vlc_module_end()
@@ -31,9 +31,12 @@
 # include "config.h"
 #endif
 
+#include <math.h>
+
 #include <vlc_common.h>
 
 #include <vlc_interface.h>
+#include <vlc_memstream.h>
 #include <vlc_playlist.h>
 #include <vlc_player.h>
 
@@ -451,6 +454,185 @@ static int vlclua_playlist_list(lua_State *L)
     return 1;
 }
 
+static void json_write_string(struct vlc_memstream *ms, const char *str)
+{
+    vlc_memstream_putc(ms, '"');
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            vlc_memstream_putc(ms, '\\');
+            vlc_memstream_putc(ms, *p);
+        }
+        else if (*p < 0x20)
+            vlc_memstream_printf(ms, "\\u%04x", *p);
+        else
+            vlc_memstream_putc(ms, *p);
+    }
+    vlc_memstream_putc(ms, '"');
+}
+
+/* Serializes the playlist as the HTTP interface playlist.json does, without
+ * building a Lua table of every item first. */
+static int vlclua_playlist_json(lua_State *L)
+{
+    vlc_playlist_t *playlist = vlclua_get_playlist_internal(L);
+    struct vlc_memstream ms;
+
+    if (vlc_memstream_open(&ms))
+        return luaL_error(L, "out of memory");
+
+    vlc_memstream_putc(&ms, '[');
+
+    vlc_playlist_Lock(playlist);
+
+    size_t count = vlc_playlist_Count(playlist);
+    ssize_t current = vlc_playlist_GetCurrentIndex(playlist);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        input_item_t *media = vlc_playlist_item_GetMedia(item);
+        char *name = input_item_GetTitleFbName(media);
+
+        if (i > 0)
+            vlc_memstream_putc(&ms, ',');
+        vlc_memstream_printf(&ms, "{\"type\":\"leaf\",\"id\":\"%"PRIu64"\","
+                             "\"uri\":", vlc_playlist_item_GetId(item));
+        json_write_string(&ms, media->psz_uri != NULL ? media->psz_uri : "");
+        vlc_memstream_puts(&ms, ",\"name\":");
+        json_write_string(&ms, name != NULL ? name : "");
+        vlc_memstream_printf(&ms, ",\"duration\":%lld",
+            media->i_duration < 0 ? -1LL
+                : (long long)floor(secf_from_vlc_tick(media->i_duration)));
+        if ((ssize_t)i == current)
+            vlc_memstream_puts(&ms, ",\"current\":\"current\"");
+        vlc_memstream_putc(&ms, '}');
+        free(name);
+    }
+
+    vlc_playlist_Unlock(playlist);
+
+    vlc_memstream_putc(&ms, ']');
+    if (vlc_memstream_close(&ms))
+        return luaL_error(L, "out of memory");
+
+    lua_pushlstring(L, ms.ptr, ms.length);
+    free(ms.ptr);
+    return 1;
+}
+
+/* Playlist revision: incremented on every change of the items or of the
+ * current item, so that clients only fetch the playlist again when it has
+ * changed. The listener is added on first use, and removed when the Lua
+ * state is closed. */
+struct vlclua_playlist_watch
+{
+    vlc_playlist_t *playlist;
+    vlc_playlist_listener_id *listener;
+    uint64_t revision; /* protected by the playlist lock */
+};
+
+static void watch_on_items_reset(vlc_playlist_t *playlist,
+                                 vlc_playlist_item_t *const items[],
+                                 size_t count, void *data)
+{
+    struct vlclua_playlist_watch *watch = data;
+    watch->revision++;
+    (void) playlist; (void) items; (void) count;
+}
+
+static void watch_on_items_added(vlc_playlist_t *playlist, size_t index,
+                                 vlc_playlist_item_t *const items[],
+                                 size_t count, void *data)
+{
+    struct vlclua_playlist_watch *watch = data;
+    watch->revision++;
+    (void) playlist; (void) index; (void) items; (void) count;
+}
+
+static void watch_on_items_moved(vlc_playlist_t *playlist, size_t index,
+                                 size_t count, size_t target, void *data)
+{
+    struct vlclua_playlist_watch *watch = data;
+    watch->revision++;
+    (void) playlist; (void) index; (void) count; (void) target;
+}
+
+static void watch_on_items_removed(vlc_playlist_t *playlist, size_t index,
+                                   size_t count, void *data)
+{
+    struct vlclua_playlist_watch *watch = data;
+    watch->revision++;
+    (void) playlist; (void) index; (void) count;
+}
+
+static void watch_on_current_index_changed(vlc_playlist_t *playlist,
+                                           ssize_t index, void *data)
+{
+    struct vlclua_playlist_watch *watch = data;
+    watch->revision++;
+    (void) playlist; (void) index;
+}
+
+static const struct vlc_playlist_callbacks watch_cbs = {
+    .on_items_reset = watch_on_items_reset,
+    .on_items_added = watch_on_items_added,
+    .on_items_moved = watch_on_items_moved,
+    .on_items_removed = watch_on_items_removed,
+    .on_items_updated = watch_on_items_added,
+    .on_current_index_changed = watch_on_current_index_changed,
+};
+
+static int vlclua_playlist_watch_gc(lua_State *L)
+{
+    struct vlclua_playlist_watch *watch = lua_touserdata(L, 1);
+
+    if (watch->listener != NULL)
+    {
+        vlc_playlist_Lock(watch->playlist);
+        vlc_playlist_RemoveListener(watch->playlist, watch->listener);
+        vlc_playlist_Unlock(watch->playlist);
+    }
+    return 0;
+}
+
+static int vlclua_playlist_revision(lua_State *L)
+{
+    vlc_playlist_t *playlist = vlclua_get_playlist_internal(L);
+    struct vlclua_playlist_watch *watch =
+        vlclua_get_object(L, vlclua_playlist_revision);
+
+    if (watch == NULL)
+    {
+        lua_pushlightuserdata(L, vlclua_playlist_revision);
+        watch = lua_newuserdata(L, sizeof (*watch));
+        watch->playlist = playlist;
+        watch->listener = NULL;
+        watch->revision = 0;
+
+        lua_newtable(L);
+        lua_pushcfunction(L, vlclua_playlist_watch_gc);
+        lua_setfield(L, -2, "__gc");
+        lua_setmetatable(L, -2);
+        lua_rawset(L, LUA_REGISTRYINDEX);
+
+        vlc_playlist_Lock(playlist);
+        watch->listener = vlc_playlist_AddListener(playlist, &watch_cbs,
+                                                   watch, false);
+        vlc_playlist_Unlock(playlist);
+        if (watch->listener == NULL)
+            return luaL_error(L, "cannot watch the playlist");
+    }
+
+    vlc_playlist_Lock(playlist);
+    uint64_t revision = watch->revision;
+    vlc_playlist_Unlock(playlist);
+
+    lua_pushinteger(L, revision);
+    return 1;
+}
+
 static int vlclua_playlist_current(lua_State *L)
 {
     vlc_playlist_t *playlist = vlclua_get_playlist_internal(L);
@@ -600,6 +782,8 @@ static const luaL_Reg vlclua_playlist_reg[] = {
     { "enqueue", vlclua_playlist_enqueue },
     { "get", vlclua_playlist_get },
     { "list", vlclua_playlist_list },
+    { "json", vlclua_playlist_json },
+    { "revision", vlclua_playlist_revision },
     { "current", vlclua_playlist_current },
     { "current_item", vlclua_playlist_current_item },
     { "sort", vlclua_playlist_sort },
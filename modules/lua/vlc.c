@@ -652,17 +652,128 @@ int vlclua_add_modules_path( lua_State *L, const char *psz_filename )
     return 0;
 }
 
+/* Compiled chunks of local scripts, shared by all Lua states of the process.
+ * Playlist and meta scripts are loaded again for every probed input, and
+ * loading them from precompiled bytecode skips reading and parsing. */
+struct vlclua_chunk
+{
+    struct vlclua_chunk *next;
+    char *name; /* chunk name: '@' followed by the file path */
+    time_t mtime;
+    off_t size;
+    size_t length;
+    char *data;
+};
+
+static vlc_mutex_t vlclua_chunks_lock = VLC_STATIC_MUTEX;
+static struct vlclua_chunk *vlclua_chunks = NULL;
+
+struct vlclua_dump
+{
+    char *data;
+    size_t length;
+};
+
+static int vlclua_chunk_write( lua_State *L, const void *p, size_t size,
+                               void *opaque )
+{
+    struct vlclua_dump *dump = opaque;
+    char *data = realloc( dump->data, dump->length + size );
+
+    (void) L;
+    if( unlikely(data == NULL) )
+        return 1;
+    memcpy( data + dump->length, p, size );
+    dump->data = data;
+    dump->length += size;
+    return 0;
+}
+
+static struct vlclua_chunk *vlclua_chunk_find( const char *path )
+{
+    for( struct vlclua_chunk *c = vlclua_chunks; c != NULL; c = c->next )
+        if( !strcmp( c->name + 1, path ) )
+            return c;
+    return NULL;
+}
+
+/** Replacement for luaL_loadfile, caching the compiled chunks */
+static int vlclua_loadfile( lua_State *L, const char *path )
+{
+    struct stat st;
+    if( stat( path, &st ) )
+        return luaL_loadfile( L, path );
+
+    vlc_mutex_lock( &vlclua_chunks_lock );
+    struct vlclua_chunk *c = vlclua_chunk_find( path );
+    if( c != NULL && c->mtime == st.st_mtime && c->size == st.st_size )
+    {
+        int ret = luaL_loadbuffer( L, c->data, c->length, c->name );
+        vlc_mutex_unlock( &vlclua_chunks_lock );
+        return ret;
+    }
+    vlc_mutex_unlock( &vlclua_chunks_lock );
+
+    int ret = luaL_loadfile( L, path );
+    if( ret )
+        return ret;
+
+    struct vlclua_dump dump = { NULL, 0 };
+#if LUA_VERSION_NUM >= 503
+    if( lua_dump( L, vlclua_chunk_write, &dump, 0 ) )
+#else
+    if( lua_dump( L, vlclua_chunk_write, &dump ) )
+#endif
+    {
+        free( dump.data );
+        return 0;
+    }
+
+    vlc_mutex_lock( &vlclua_chunks_lock );
+    c = vlclua_chunk_find( path );
+    if( c == NULL )
+    {
+        c = malloc( sizeof (*c) );
+        if( unlikely(c == NULL) || asprintf( &c->name, "@%s", path ) == -1 )
+        {
+            vlc_mutex_unlock( &vlclua_chunks_lock );
+            free( c );
+            free( dump.data );
+            return 0;
+        }
+        c->next = vlclua_chunks;
+        vlclua_chunks = c;
+    }
+    else
+        free( c->data );
+
+    c->mtime = st.st_mtime;
+    c->size = st.st_size;
+    c->length = dump.length;
+    c->data = dump.data;
+    vlc_mutex_unlock( &vlclua_chunks_lock );
+    return 0;
+}
+
+static int vlclua_dolocalfile( lua_State *L, const char *path )
+{
+    int ret = vlclua_loadfile( L, path );
+    if( !ret )
+        ret = lua_pcall( L, 0, LUA_MULTRET, 0 );
+    return ret;
+}
+
 /** Replacement for luaL_dofile, using VLC's input capabilities */
 int vlclua_dofile( vlc_object_t *p_this, lua_State *L, const char *curi )
 {
     char *uri = ToLocaleDup( curi );
     if( !strstr( uri, "://" ) ) {
-        int ret = luaL_dofile( L, uri );
+        int ret = vlclua_dolocalfile( L, uri );
         free( uri );
         return ret;
     }
     if( !strncasecmp( uri, "file://", 7 ) ) {
-        int ret = luaL_dofile( L, uri + 7 );
+        int ret = vlclua_dolocalfile( L, uri + 7 );
         free( uri );
         return ret;
     }
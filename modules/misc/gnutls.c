@@ -38,6 +38,7 @@
 #include <vlc_tls.h>
 #include <vlc_block.h>
 #include <vlc_dialog.h>
+#include <vlc_list.h>
 
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
@@ -47,8 +48,87 @@ typedef struct vlc_tls_gnutls
     vlc_tls_t tls;
     gnutls_session_t session;
     vlc_object_t *obj;
+    char *host; /**< client only, to resume the session later */
+    bool resumable;
 } vlc_tls_gnutls_t;
 
+/*
+ * Client sessions resumption data (tickets), by server host name.
+ *
+ * The client credentials are not kept across accesses, so the cache is
+ * global to the process.
+ */
+#define RESUME_CACHE_MAX 32
+
+struct gnutls_resume_entry
+{
+    struct vlc_list node; /**< most recent first */
+    char *host;
+    gnutls_datum_t data;
+};
+
+static vlc_mutex_t resume_lock = VLC_STATIC_MUTEX;
+static struct vlc_list resume_entries = VLC_LIST_INITIALIZER(&resume_entries);
+static unsigned resume_count;
+
+static void gnutls_ResumeEntryDelete(struct gnutls_resume_entry *entry)
+{
+    vlc_list_remove(&entry->node);
+    resume_count--;
+    gnutls_free(entry->data.data);
+    free(entry->host);
+    free(entry);
+}
+
+static struct gnutls_resume_entry *gnutls_ResumeLookup(const char *host)
+{
+    struct gnutls_resume_entry *entry;
+
+    vlc_list_foreach(entry, &resume_entries, node)
+        if (!strcmp(entry->host, host))
+            return entry;
+    return NULL;
+}
+
+static void gnutls_ResumeLoad(vlc_tls_gnutls_t *priv)
+{
+    vlc_mutex_lock(&resume_lock);
+    struct gnutls_resume_entry *entry = gnutls_ResumeLookup(priv->host);
+    if (entry != NULL
+     && gnutls_session_set_data(priv->session, entry->data.data,
+                                entry->data.size) == 0)
+        msg_Dbg(priv->obj, "trying to resume TLS session with %s",
+                priv->host);
+    vlc_mutex_unlock(&resume_lock);
+}
+
+static void gnutls_ResumeStore(vlc_tls_gnutls_t *priv)
+{
+    struct gnutls_resume_entry *entry = malloc(sizeof (*entry));
+    if (unlikely(entry == NULL))
+        return;
+
+    entry->host = strdup(priv->host);
+    if (unlikely(entry->host == NULL)
+     || gnutls_session_get_data2(priv->session, &entry->data) != 0)
+    {
+        free(entry->host);
+        free(entry);
+        return;
+    }
+
+    vlc_mutex_lock(&resume_lock);
+    struct gnutls_resume_entry *old = gnutls_ResumeLookup(priv->host);
+    if (old != NULL)
+        gnutls_ResumeEntryDelete(old);
+    if (resume_count >= RESUME_CACHE_MAX)
+        gnutls_ResumeEntryDelete(vlc_list_last_entry_or_null(&resume_entries,
+                                              struct gnutls_resume_entry, node));
+    vlc_list_prepend(&entry->node, &resume_entries);
+    resume_count++;
+    vlc_mutex_unlock(&resume_lock);
+}
+
 static void gnutls_Banner(vlc_object_t *obj)
 {
     msg_Dbg(obj, "using GnuTLS v%s (built with v"GNUTLS_VERSION")",
@@ -207,7 +287,12 @@ static void gnutls_Close (vlc_tls_t *tls)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
 
+    /* TLS 1.3 tickets are only received after the handshake */
+    if (priv->resumable)
+        gnutls_ResumeStore(priv);
+
     gnutls_deinit(priv->session);
+    free(priv->host);
     free(priv);
 }
 
@@ -295,6 +380,8 @@ static vlc_tls_gnutls_t *gnutls_SessionOpen(vlc_object_t *obj, int type,
 
     priv->session = session;
     priv->obj = obj;
+    priv->host = NULL;
+    priv->resumable = false;
 
     vlc_tls_t *tls = &priv->tls;
 
@@ -388,16 +475,22 @@ static vlc_tls_t *gnutls_ClientSessionOpen(vlc_tls_client_t *crd,
     gnutls_dh_set_prime_bits (session, 1024);
 
     if (likely(hostname != NULL))
+    {
         /* fill Server Name Indication */
         gnutls_server_name_set (session, GNUTLS_NAME_DNS,
                                 hostname, strlen (hostname));
 
+        priv->host = strdup(hostname);
+        if (likely(priv->host != NULL))
+            gnutls_ResumeLoad(priv);
+    }
+
     return &priv->tls;
 }
 
-static int gnutls_ClientHandshake(vlc_tls_t *tls,
-                                  const char *host, const char *service,
-                                  char **restrict alp)
+static int gnutls_ClientHandshakeVerify(vlc_tls_t *tls,
+                                        const char *host, const char *service,
+                                        char **restrict alp)
 {
     vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
     vlc_object_t *obj = priv->obj;
@@ -529,6 +622,23 @@ error:
     return -1;
 }
 
+static int gnutls_ClientHandshake(vlc_tls_t *tls,
+                                  const char *host, const char *service,
+                                  char **restrict alp)
+{
+    vlc_tls_gnutls_t *priv = (vlc_tls_gnutls_t *)tls;
+
+    int val = gnutls_ClientHandshakeVerify(tls, host, service, alp);
+    if (val == 0 && priv->host != NULL)
+    {
+        /* only keep the tickets of authenticated servers */
+        priv->resumable = true;
+        if (gnutls_session_is_resumed(priv->session))
+            msg_Dbg(priv->obj, " - session resumed");
+    }
+    return val;
+}
+
 static void gnutls_ClientDestroy(vlc_tls_client_t *crd)
 {
     gnutls_certificate_credentials_t x509 = crd->sys;
@@ -24,20 +24,34 @@
 
 #include "medialibrary.h"
 
+#include <algorithm>
+
 MetadataExtractor::MetadataExtractor( vlc_object_t* parent )
     : m_currentCtx( nullptr )
     , m_obj( parent )
 {
 }
 
-void MetadataExtractor::onParserEnded( ParseContext& ctx, int status )
+void MetadataExtractor::onParserEnded( ParseContext& ctx,
+                                       input_item_preparse_status status )
 {
-    vlc::threads::mutex_locker lock( ctx.mde->m_mutex );
+    vlc::threads::mutex_locker lock( m_mutex );
+
+    // Nobody waits for this request anymore
+    auto it = std::find_if( begin( m_abandoned ), end( m_abandoned ),
+                            [&ctx]( const std::unique_ptr<ParseContext>& c ) {
+                                return c.get() == &ctx;
+                            });
+    if ( it != end( m_abandoned ) )
+    {
+        m_abandoned.erase( it );
+        return;
+    }
 
-    // We need to probe the item now, but not from the input thread
-    ctx.success = status == VLC_SUCCESS;
-    ctx.needsProbing = true;
-    ctx.mde->m_cond.signal();
+    // We need to probe the item now, but not from the preparser thread
+    ctx.status = status;
+    ctx.done = true;
+    m_cond.signal();
 }
 
 void MetadataExtractor::populateItem( medialibrary::parser::IItem& item, input_item_t* inputItem )
@@ -112,7 +126,9 @@ void MetadataExtractor::populateItem( medialibrary::parser::IItem& item, input_i
     }
 }
 
-void MetadataExtractor::onParserEnded( input_item_t *, int status, void *data )
+void MetadataExtractor::onParserEnded( input_item_t *,
+                                       input_item_preparse_status status,
+                                       void *data )
 {
     auto* ctx = static_cast<ParseContext*>( data );
     ctx->mde->onParserEnded( *ctx, status );
@@ -123,7 +139,9 @@ void MetadataExtractor::onParserSubtreeAdded( input_item_t *,
                                               void *data )
 {
     auto* ctx = static_cast<ParseContext*>( data );
-    ctx->mde->addSubtree( *ctx, subtree );
+    vlc::threads::mutex_locker lock( ctx->mde->m_mutex );
+    if ( ctx->item != nullptr )
+        ctx->mde->addSubtree( *ctx, subtree );
 }
 
 void MetadataExtractor::addSubtree( ParseContext& ctx, input_item_node_t *root )
@@ -131,63 +149,75 @@ void MetadataExtractor::addSubtree( ParseContext& ctx, input_item_node_t *root )
     for ( auto i = 0; i < root->i_children; ++i )
     {
         auto it = root->pp_children[i]->p_item;
-        auto& subItem = ctx.item.createSubItem( it->psz_uri, i );
+        auto& subItem = ctx.item->createSubItem( it->psz_uri,
+                                                 ctx.nbSubItems + i );
         populateItem( subItem, it );
     }
+    ctx.nbSubItems += root->i_children;
 }
 
 medialibrary::parser::Status MetadataExtractor::run( medialibrary::parser::IItem& item )
 {
-    ParseContext ctx( this, item );
+    auto ctx = std::make_unique<ParseContext>( this, item );
 
-    ctx.inputItem = {
+    ctx->inputItem = {
         input_item_New( item.mrl().c_str(), NULL ),
         &input_item_Release
     };
-    if ( ctx.inputItem == nullptr )
+    if ( ctx->inputItem == nullptr )
         return medialibrary::parser::Status::Fatal;
 
-    const input_item_parser_cbs_t cbs = {
+    static const input_preparser_callbacks_t cbs = {
         &MetadataExtractor::onParserEnded,
         &MetadataExtractor::onParserSubtreeAdded,
     };
-    m_currentCtx = &ctx;
-    ctx.inputItem->i_preparse_depth = 1;
-    ctx.inputParser = {
-        input_item_Parse( ctx.inputItem.get(), m_obj, &cbs,
-                          std::addressof( ctx ) ),
-        &input_item_parser_id_Release
-    };
-    if ( ctx.inputParser == nullptr )
+    ctx->inputItem->i_preparse_depth = 1;
+
+    {
+        vlc::threads::mutex_locker lock( m_mutex );
+        m_currentCtx = ctx.get();
+    }
+
+    // Share the preparser workers (and their "preparse-threads" bound) with
+    // the rest of the instance. No art is fetched here: the container
+    // headers are enough for the tags, the tracks and the duration.
+    if ( libvlc_MetadataRequest( vlc_object_instance( m_obj ),
+                                 ctx->inputItem.get(),
+                                 META_REQUEST_OPTION_SCOPE_ANY, &cbs,
+                                 ctx.get(), -1, ctx.get() ) != VLC_SUCCESS )
     {
+        vlc::threads::mutex_locker lock( m_mutex );
         m_currentCtx = nullptr;
         return medialibrary::parser::Status::Fatal;
     }
 
     {
         vlc::threads::mutex_locker lock( m_mutex );
-        auto deadline = vlc_tick_now() + VLC_TICK_FROM_SEC( 5 );
-        while ( ctx.needsProbing == false && ctx.inputParser != nullptr )
+        while ( ctx->done == false && ctx->item != nullptr )
+            m_cond.wait( m_mutex );
+        m_currentCtx = nullptr;
+
+        if ( ctx->done == false )
         {
-            auto res = m_cond.timedwait( m_mutex, deadline );
-            if ( res != 0 )
-            {
-                msg_Dbg( m_obj, "Timed out while extracting %s metadata",
-                         item.mrl().c_str() );
-                break;
-            }
+            // Interrupted by stop(), the preparser still owns a reference
+            m_abandoned.push_back( std::move( ctx ) );
+            return medialibrary::parser::Status::Fatal;
         }
-        m_currentCtx = nullptr;
+        if ( ctx->item == nullptr )
+            return medialibrary::parser::Status::Fatal;
     }
 
-    if ( !ctx.success || ctx.inputParser == nullptr )
+    if ( ctx->status == ITEM_PREPARSE_TIMEOUT )
+        msg_Dbg( m_obj, "Timed out while extracting %s metadata",
+                 item.mrl().c_str() );
+    if ( ctx->status != ITEM_PREPARSE_DONE )
         return medialibrary::parser::Status::Fatal;
 
     if ( item.fileType() == medialibrary::IFile::Type::Playlist &&
          item.nbSubItems() == 0 )
         return medialibrary::parser::Status::Fatal;
 
-    populateItem( item, ctx.inputItem.get() );
+    populateItem( item, ctx->inputItem.get() );
 
     return medialibrary::parser::Status::Success;
 }
@@ -219,5 +249,9 @@ void MetadataExtractor::stop()
 {
     vlc::threads::mutex_locker lock{ m_mutex };
     if ( m_currentCtx != nullptr )
-        input_item_parser_id_Interrupt( m_currentCtx->inputParser.get() );
+    {
+        m_currentCtx->item = nullptr;
+        libvlc_MetadataCancel( vlc_object_instance( m_obj ), m_currentCtx );
+        m_cond.signal();
+    }
 }
@@ -50,23 +50,23 @@ private:
     struct ParseContext
     {
         ParseContext( MetadataExtractor* mde, medialibrary::parser::IItem& item )
-            : needsProbing( false )
-            , success( false )
+            : done( false )
+            , status( ITEM_PREPARSE_FAILED )
+            , nbSubItems( 0 )
             , mde( mde )
-            , item( item )
+            , item( &item )
             , inputItem( nullptr, &input_item_Release )
-            , inputParser( nullptr, &input_item_parser_id_Release )
         {
         }
 
-        bool needsProbing;
-        bool success;
+        bool done;
+        input_item_preparse_status status;
+        // Subtrees of large playlists are posted in several parts
+        int nbSubItems;
         MetadataExtractor* mde;
-        medialibrary::parser::IItem& item;
+        // nullptr once the request was abandoned by stop()
+        medialibrary::parser::IItem* item;
         std::unique_ptr<input_item_t, decltype(&input_item_Release)> inputItem;
-        // Needs to be last to be destroyed first, otherwise a late callback
-        // could use some already destroyed fields
-        std::unique_ptr<input_item_parser_id_t, decltype(&input_item_parser_id_Release)> inputParser;
     };
 
 public:
@@ -84,11 +84,12 @@ private:
     virtual void onRestarted() override;
     virtual void stop() override;
 
-    void onParserEnded( ParseContext& ctx, int status );
+    void onParserEnded( ParseContext& ctx, input_item_preparse_status status );
     void addSubtree( ParseContext& ctx, input_item_node_t *root );
     void populateItem( medialibrary::parser::IItem& item, input_item_t* inputItem );
 
-    static void onParserEnded( input_item_t *, int status, void *user_data );
+    static void onParserEnded( input_item_t *, input_item_preparse_status status,
+                               void *user_data );
     static void onParserSubtreeAdded( input_item_t *, input_item_node_t *subtree,
                                       void *user_data );
 
@@ -96,6 +97,9 @@ private:
     vlc::threads::condition_variable m_cond;
     vlc::threads::mutex m_mutex;
     ParseContext* m_currentCtx;
+    // Requests left to the preparser by stop(), released once they end, or
+    // with the extractor if the preparser dropped them
+    std::vector<std::unique_ptr<ParseContext>> m_abandoned;
     vlc_object_t* m_obj;
 };
 
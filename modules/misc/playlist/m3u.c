@@ -67,17 +67,22 @@ static void DoExport( struct vlc_playlist_export *p_export,
         vlc_playlist_item_t *item =
             vlc_playlist_view_Get(p_export->playlist_view, i);
 
-        /* General info */
+        /* General info, written straight from the media without copies */
         input_item_t *media = vlc_playlist_item_GetMedia(item);
+        vlc_mutex_lock(&media->lock);
 
-        char *psz_uri = input_item_GetURI(media);
+        const char *psz_uri = media->psz_uri;
         assert( psz_uri );
 
-        char *psz_name = input_item_GetName(media);
+        const char *psz_name = media->psz_name;
         if( psz_name && strcmp( psz_uri, psz_name ) )
         {
-            char *psz_artist = input_item_GetArtist(media);
-            vlc_tick_t i_duration = input_item_GetDuration(media);
+            const char *psz_artist =
+                input_item_GetMetaLocked(media, vlc_meta_Artist);
+            vlc_tick_t i_duration = media->i_duration;
+            if( i_duration == INPUT_DURATION_INDEFINITE
+             || i_duration == INPUT_DURATION_UNSET )
+                i_duration = 0;
             if( psz_artist && *psz_artist )
             {
                 /* write EXTINF with artist */
@@ -90,12 +95,9 @@ static void DoExport( struct vlc_playlist_export *p_export,
                 pf_fprintf( p_export->file, "#EXTINF:%"PRIu64",%s\n",
                             SEC_FROM_VLC_TICK(i_duration), psz_name);
             }
-            free( psz_artist );
         }
-        free( psz_name );
 
         /* VLC specific options */
-        vlc_mutex_lock(&media->lock);
         for( int j = 0; j < media->i_options; j++ )
         {
             pf_fprintf( p_export->file, "#EXTVLCOPT:%s\n",
@@ -103,7 +105,6 @@ static void DoExport( struct vlc_playlist_export *p_export,
                         media->ppsz_options[j] + 1 :
                         media->ppsz_options[j] );
         }
-        vlc_mutex_unlock(&media->lock);
 
         /* We cannot really know if relative or absolute URL is better. As a
          * heuristic, we write a relative URL if the item is in the same
@@ -114,7 +115,7 @@ static void DoExport( struct vlc_playlist_export *p_export,
             skip = prefix_len;
 
         fprintf( p_export->file, "%s\n", psz_uri + skip );
-        free( psz_uri );
+        vlc_mutex_unlock(&media->lock);
     }
 }
 
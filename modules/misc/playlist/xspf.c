@@ -39,14 +39,18 @@
 
 int xspf_export_playlist( vlc_object_t *p_this );
 
-static char *input_xml( input_item_t *p_item, char *(*func)(input_item_t *) )
+/* the media lock must be held */
+static void xspf_export_meta( FILE *p_file, const char *psz_tag,
+                              input_item_t *p_input, vlc_meta_type_t type )
 {
-    char *tmp = func( p_item );
-    if( tmp == NULL )
-        return NULL;
-    char *ret = vlc_xml_encode( tmp );
-    free( tmp );
-    return ret;
+    const char *psz = input_item_GetMetaLocked( p_input, type );
+    if( psz == NULL || *psz == '\0' )
+        return;
+    char *psz_xml = vlc_xml_encode( psz );
+    if( psz_xml == NULL )
+        return;
+    fprintf( p_file, "\t\t\t<%s>%s</%s>\n", psz_tag, psz_xml, psz_tag );
+    free( psz_xml );
 }
 
 /**
@@ -57,20 +61,24 @@ static char *input_xml( input_item_t *p_item, char *(*func)(input_item_t *) )
  */
 static void xspf_export_item( input_item_t *p_input, FILE *p_file, uint64_t id)
 {
-    char *psz;
     vlc_tick_t i_duration;
 
+    /* read the media once, without copying its fields */
+    vlc_mutex_lock( &p_input->lock );
+
     fputs( "\t\t<track>\n", p_file );
 
     /* -> the location */
 
-    char *psz_uri = input_xml( p_input, input_item_GetURI );
+    char *psz_uri = p_input->psz_uri ? vlc_xml_encode( p_input->psz_uri )
+                                     : NULL;
     if( psz_uri && *psz_uri )
         fprintf( p_file, "\t\t\t<location>%s</location>\n", psz_uri );
 
     /* -> the name/title (only if different from uri)*/
-    psz = input_xml( p_input, input_item_GetTitle );
-    if( psz && strcmp( psz_uri, psz ) )
+    const char *psz_title = input_item_GetMetaLocked( p_input, vlc_meta_Title );
+    char *psz = psz_title ? vlc_xml_encode( psz_title ) : NULL;
+    if( psz && ( psz_uri == NULL || strcmp( psz_uri, psz ) ) )
         fprintf( p_file, "\t\t\t<title>%s</title>\n", psz );
     free( psz );
     free( psz_uri );
@@ -81,47 +89,31 @@ static void xspf_export_item( input_item_t *p_input, FILE *p_file, uint64_t id)
     }
 
     /* -> the artist/creator */
-    psz = input_xml( p_input, input_item_GetArtist );
-    if( psz && *psz )
-        fprintf( p_file, "\t\t\t<creator>%s</creator>\n", psz );
-    free( psz );
+    xspf_export_meta( p_file, "creator", p_input, vlc_meta_Artist );
 
     /* -> the album */
-    psz = input_xml( p_input, input_item_GetAlbum );
-    if( psz && *psz )
-        fprintf( p_file, "\t\t\t<album>%s</album>\n", psz );
-    free( psz );
+    xspf_export_meta( p_file, "album", p_input, vlc_meta_Album );
 
     /* -> the track number */
-    psz = input_xml( p_input, input_item_GetTrackNum );
-    if( psz )
+    const char *psz_tracknum =
+        input_item_GetMetaLocked( p_input, vlc_meta_TrackNumber );
+    if( psz_tracknum )
     {
-        int i_tracknum = atoi( psz );
-
-        free( psz );
+        int i_tracknum = atoi( psz_tracknum );
         if( i_tracknum > 0 )
             fprintf( p_file, "\t\t\t<trackNum>%i</trackNum>\n", i_tracknum );
     }
 
     /* -> the description */
-    psz = input_xml( p_input, input_item_GetDescription );
-    if( psz && *psz )
-        fprintf( p_file, "\t\t\t<annotation>%s</annotation>\n", psz );
-    free( psz );
+    xspf_export_meta( p_file, "annotation", p_input, vlc_meta_Description );
 
-    psz = input_xml( p_input, input_item_GetURL );
-    if( psz && *psz )
-        fprintf( p_file, "\t\t\t<info>%s</info>\n", psz );
-    free( psz );
+    xspf_export_meta( p_file, "info", p_input, vlc_meta_URL );
 
-    psz = input_xml( p_input, input_item_GetArtURL );
-    if( psz && *psz )
-        fprintf( p_file, "\t\t\t<image>%s</image>\n", psz );
-    free( psz );
+    xspf_export_meta( p_file, "image", p_input, vlc_meta_ArtworkURL );
 
 xspfexportitem_end:
     /* -> the duration */
-    i_duration = input_item_GetDuration( p_input );
+    i_duration = p_input->i_duration;
     if( i_duration > 0 )
         fprintf( p_file, "\t\t\t<duration>%"PRIu64"</duration>\n",
                  MS_FROM_VLC_TICK(i_duration) );
@@ -151,6 +143,8 @@ xspfexportitem_end:
     }
     fputs( "\t\t\t</extension>\n", p_file );
     fputs( "\t\t</track>\n", p_file );
+
+    vlc_mutex_unlock( &p_input->lock );
 }
 
 /**
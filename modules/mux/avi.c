@@ -482,6 +482,10 @@ static int PrepareSamples( const avi_stream_t *p_stream,
         unsigned gshift = ctz(p_fmt->video.i_gmask);
         unsigned bshift = ctz(p_fmt->video.i_bmask);
 
+        *pp_block = block_Unshare( *pp_block );
+        if( !*pp_block )
+            return VLC_ENOMEM;
+
         uint8_t *p_data = (*pp_block)->p_buffer;
         for( size_t i=0; i<(*pp_block)->i_buffer / 3; i++ )
         {
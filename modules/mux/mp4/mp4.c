@@ -32,6 +32,7 @@
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_block.h>
+#include <vlc_aout.h>
 
 #include <assert.h>
 #include <time.h>
@@ -53,6 +54,25 @@
     "Create \"Fast Start\" files. " \
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
+#define RESERVE_TEXT N_("Fast Start reserved duration (s)")
+#define RESERVE_LONGTEXT N_(\
+    "Reserve room for the \"Fast Start\" header, for files up to this " \
+    "duration, before the media data. If the header fits at close time, " \
+    "it is written there, instead of moving all the media data. 0 disables " \
+    "the reservation.")
+
+#define CMAF_TEXT N_("Low latency CMAF chunks")
+#define CMAF_LONGTEXT N_(\
+    "Write CMAF segments made of small moof and mdat chunks, for low " \
+    "latency DASH or HLS packaging. Each segment starts with a styp box " \
+    "and is the only point flagged for joining the stream.")
+#define CHUNK_TEXT N_("CMAF chunk duration (ms)")
+#define CHUNK_LONGTEXT N_(\
+    "Duration of the CMAF chunks. 0 writes one chunk for every frame.")
+#define SEGMENT_TEXT N_("CMAF segment duration (ms)")
+#define SEGMENT_LONGTEXT N_(\
+    "Minimum duration of the CMAF segments. Segments start on the next " \
+    "video key frame past this duration.")
 
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
@@ -69,6 +89,9 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", false,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer(SOUT_CFG_PREFIX "faststart-reserve", 0,
+                RESERVE_TEXT, RESERVE_LONGTEXT, true)
+        change_integer_range(0, 86400)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -79,6 +102,13 @@ add_submodule ()
     set_subcategory(SUBCAT_SOUT_MUX)
     set_shortname("MP4 Frag")
     add_shortcut("mp4frag", "mp4stream")
+    add_bool(SOUT_CFG_PREFIX "cmaf", false, CMAF_TEXT, CMAF_LONGTEXT, true)
+    add_integer(SOUT_CFG_PREFIX "chunk-duration", 0,
+                CHUNK_TEXT, CHUNK_LONGTEXT, true)
+        change_integer_range(0, 60000)
+    add_integer(SOUT_CFG_PREFIX "segment-duration", 2000,
+                SEGMENT_TEXT, SEGMENT_LONGTEXT, true)
+        change_integer_range(1, 600000)
     set_capability("sout mux", 0)
     set_callbacks(Open, CloseFrag)
 
@@ -88,7 +118,8 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "faststart-reserve", "cmaf", "chunk-duration",
+    "segment-duration", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -158,12 +189,15 @@ typedef struct
     mp4mux_handle_t *muxh;
     bool b_3gp;
     bool b_fast_start;
+    vlc_tick_t i_reserve_duration;
 
     /* global */
     bool     b_header_sent;
 
     uint64_t i_mdat_pos;
     uint64_t i_pos;
+    uint64_t i_free_pos; /* room reserved for the moov */
+    uint64_t i_free_size;
     vlc_tick_t  i_read_duration;
     vlc_tick_t  i_start_dts;
 
@@ -174,6 +208,13 @@ typedef struct
     /* mp4frag */
     vlc_tick_t     i_written_duration;
     uint32_t       i_mfhd_sequence;
+
+    /* CMAF chunks */
+    bool           b_cmaf;
+    vlc_tick_t     i_chunk_length;
+    vlc_tick_t     i_segment_length;
+    vlc_tick_t     i_segment_start;
+    bool           b_segment_started;
 } sout_mux_sys_t;
 
 static void mp4_stream_Delete(mp4_stream_t *p_stream)
@@ -224,6 +265,67 @@ static block_t *ConvertSUBT(block_t *);
 static bool CreateCurrentEdit(mp4_stream_t *, vlc_tick_t, bool);
 static int MuxStream(sout_mux_t *p_mux, sout_input_t *p_input, mp4_stream_t *p_stream);
 
+/* Upper bound of the moov size for the given duration: every sample costs
+ * at most stsz + stts + ctts + co64 + stsc + stss entries. */
+#define MOOV_SAMPLE_SIZE     48
+#define MOOV_TRACK_OVERHEAD  2048
+#define MOOV_OVERHEAD        4096
+
+static uint64_t EstimateMoovSize(sout_mux_t *p_mux, vlc_tick_t i_duration)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    uint64_t i_size = MOOV_OVERHEAD;
+    double f_seconds = secf_from_vlc_tick(i_duration);
+
+    for (unsigned i = 0; i < p_sys->i_nb_streams; i++)
+    {
+        const es_format_t *p_fmt =
+            mp4mux_track_GetFmt(p_sys->pp_streams[i]->tinfo);
+        double f_rate;
+
+        switch (p_fmt->i_cat)
+        {
+            case VIDEO_ES:
+                f_rate = (double) p_fmt->video.i_frame_rate /
+                         p_fmt->video.i_frame_rate_base;
+                break;
+            case AUDIO_ES:
+                if (aout_BitsPerSample(p_fmt->i_codec) != 0)
+                    /* PCM: constant sample size, a chunk per block */
+                    f_rate = 50;
+                else
+                    /* unknown frame lengths: assume the smallest common ones */
+                    f_rate = (double) p_fmt->audio.i_rate /
+                             (p_fmt->audio.i_frame_length ?
+                              p_fmt->audio.i_frame_length : 576);
+                break;
+            default:
+                f_rate = 2;
+                break;
+        }
+        i_size += MOOV_TRACK_OVERHEAD +
+                  (uint64_t)(f_rate * f_seconds + 1) * MOOV_SAMPLE_SIZE;
+    }
+    return i_size;
+}
+
+static int WriteFreeBox(sout_mux_t *p_mux, uint64_t i_size)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    assert(i_size >= 8 && i_size <= UINT32_MAX);
+    block_t *p_free = block_Alloc(i_size);
+    if(!p_free)
+        return VLC_ENOMEM;
+    memset(p_free->p_buffer, 0, i_size);
+    SetDWBE(p_free->p_buffer, i_size);
+    memcpy(&p_free->p_buffer[4], "free", 4);
+
+    p_sys->i_pos += i_size;
+    sout_AccessOutWrite(p_mux->p_access, p_free);
+    return VLC_SUCCESS;
+}
+
 static int WriteSlowStartHeader(sout_mux_t *p_mux)
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
@@ -241,6 +343,21 @@ static int WriteSlowStartHeader(sout_mux_t *p_mux)
         box_send(p_mux, box);
     }
 
+    /* Then the room for the moov, if the duration is known in advance */
+    if (p_sys->b_fast_start && p_sys->i_reserve_duration > 0)
+    {
+        uint64_t i_size = EstimateMoovSize(p_mux, p_sys->i_reserve_duration);
+        if (i_size > UINT32_MAX)
+            i_size = UINT32_MAX;
+        msg_Dbg(p_mux, "reserving %"PRIu64" bytes for the moov", i_size);
+
+        p_sys->i_free_pos = p_sys->i_pos;
+        if (WriteFreeBox(p_mux, i_size) != VLC_SUCCESS)
+            return VLC_ENOMEM;
+        p_sys->i_free_size = i_size;
+        p_sys->i_mdat_pos = p_sys->i_pos;
+    }
+
     /* Now add mdat header */
     box = box_new("mdat");
     if(!box)
@@ -286,13 +403,28 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_nb_streams = 0;
     p_sys->pp_streams   = NULL;
     p_sys->i_mdat_pos   = 0;
+    p_sys->i_free_pos   = 0;
+    p_sys->i_free_size  = 0;
     p_sys->b_header_sent = false;
 
+    p_sys->b_fast_start = var_GetBool(p_mux, SOUT_CFG_PREFIX "faststart");
+    p_sys->i_reserve_duration = vlc_tick_from_sec(
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "faststart-reserve"));
+
     p_sys->i_read_duration   = 0;
     p_sys->i_written_duration= 0;
     p_sys->i_start_dts = VLC_TICK_INVALID;
     p_sys->i_mfhd_sequence = 1;
 
+    p_sys->b_cmaf = (options & FRAGMENTED) &&
+                    var_GetBool(p_mux, SOUT_CFG_PREFIX "cmaf");
+    p_sys->i_chunk_length = VLC_TICK_FROM_MS(
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "chunk-duration"));
+    p_sys->i_segment_length = VLC_TICK_FROM_MS(
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "segment-duration"));
+    p_sys->i_segment_start = 0;
+    p_sys->b_segment_started = false;
+
     p_mux->p_sys        = p_sys;
     p_mux->pf_control   = Control;
     p_mux->pf_addstream = AddStream;
@@ -307,6 +439,11 @@ static int Open(vlc_object_t *p_this)
     else
     {
         mp4mux_SetBrand(p_sys->muxh, BRAND_isom, 0x0);
+        if(p_sys->b_cmaf)
+        {
+            mp4mux_AddExtraBrand(p_sys->muxh, BRAND_iso6);
+            mp4mux_AddExtraBrand(p_sys->muxh, BRAND_cmfc);
+        }
     }
 
     return VLC_SUCCESS;
@@ -315,6 +452,8 @@ static int Open(vlc_object_t *p_this)
 /*****************************************************************************
  * Close:
  *****************************************************************************/
+#define FASTSTART_COPY_SIZE (1 << 20)
+
 static void Close(vlc_object_t *p_this)
 {
     sout_mux_t      *p_mux = (sout_mux_t*)p_this;
@@ -349,13 +488,37 @@ static void Close(vlc_object_t *p_this)
     uint64_t i_moov_pos = p_sys->i_pos;
     bo_t *moov = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
 
+    /* Use the reserved room if the moov fits: the remainder, if any, must be
+     * large enough for a free box header */
+    if (p_sys->b_fast_start && moov && moov->b && p_sys->i_free_size > 0 &&
+        (bo_size(moov) == p_sys->i_free_size ||
+         bo_size(moov) + 8 <= p_sys->i_free_size))
+    {
+        uint64_t i_left = p_sys->i_free_size - bo_size(moov);
+
+        msg_Dbg(p_this, "writing moov in %"PRIu64" reserved bytes (%"PRIu64
+                " unused)", p_sys->i_free_size, i_left);
+        i_moov_pos = p_sys->i_free_pos;
+        if (i_left > 0)
+        {
+            uint8_t free_hdr[8];
+            SetDWBE(free_hdr, i_left);
+            memcpy(&free_hdr[4], "free", 4);
+            bo_add_mem(moov, sizeof(free_hdr), free_hdr);
+        }
+        p_sys->b_fast_start = false;
+    }
+    else if (p_sys->b_fast_start && p_sys->i_free_size > 0)
+        msg_Warn(p_this, "reserved space too small for the moov (%"PRIu64
+                 " bytes), moving the media data", p_sys->i_free_size);
+
     /* Check we need to create "fast start" files */
-    p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
     while (p_sys->b_fast_start && moov && moov->b)
     {
         /* Move data to the end of the file so we can fit the moov header
-         * at the start */
+         * at the start, in place of the reserved room if any */
         uint64_t i_mdatsize = p_sys->i_pos - p_sys->i_mdat_pos;
+        uint64_t i_room, i_shift;
 
         /* moving samples will need new moov with 64bit atoms ? */
         if(!b_64bitext && p_sys->i_pos + bo_size(moov) > UINT32_MAX)
@@ -371,10 +534,12 @@ static void Close(vlc_object_t *p_this)
             }
         }
         /* We now know our final MOOV size */
+        i_room = bo_size(moov) > p_sys->i_free_size ? p_sys->i_free_size : 0;
+        i_shift = bo_size(moov) - i_room;
 
         /* Fix-up samples to chunks table in MOOV header to they point to next MDAT location */
-        mp4mux_ShiftSamples(p_sys->muxh, bo_size(moov));
-        msg_Dbg(p_this,"Moving data by %"PRIu64, (uint64_t)bo_size(moov));
+        mp4mux_ShiftSamples(p_sys->muxh, i_shift);
+        msg_Dbg(p_this,"Moving data by %"PRIu64, i_shift);
         bo_t *shifted = mp4mux_GetMoov(p_sys->muxh, VLC_OBJECT(p_mux), 0);
         if(!shifted)
         {
@@ -389,8 +554,13 @@ static void Close(vlc_object_t *p_this)
         /* Make space, move MDAT data by moov size towards the end */
         while (i_mdatsize > 0)
         {
-            size_t i_chunk = __MIN(32768, i_mdatsize);
+            size_t i_chunk = __MIN(FASTSTART_COPY_SIZE, i_mdatsize);
             block_t *p_buf = block_Alloc(i_chunk);
+            if (!p_buf)
+            {
+                p_sys->b_fast_start = false;
+                break;
+            }
             sout_AccessOutSeek(p_mux->p_access,
                                 p_sys->i_mdat_pos + i_mdatsize - i_chunk);
             ssize_t i_read = sout_AccessOutRead(p_mux->p_access, p_buf);
@@ -402,7 +572,7 @@ static void Close(vlc_object_t *p_this)
                 break;
             }
             sout_AccessOutSeek(p_mux->p_access, p_sys->i_mdat_pos + i_mdatsize +
-                               bo_size(moov) - i_chunk);
+                               i_shift - i_chunk);
             sout_AccessOutWrite(p_mux->p_access, p_buf);
             i_mdatsize -= i_chunk;
         }
@@ -411,8 +581,8 @@ static void Close(vlc_object_t *p_this)
             continue;
 
         /* Update pos pointers */
-        i_moov_pos = p_sys->i_mdat_pos;
-        p_sys->i_mdat_pos += bo_size(moov);
+        i_moov_pos = p_sys->i_mdat_pos - i_room;
+        p_sys->i_mdat_pos += i_shift;
 
         p_sys->b_fast_start = false;
     }
@@ -1284,6 +1454,77 @@ static void FlushHeader(sout_mux_t *p_mux)
     p_sys->b_header_sent = true;
 }
 
+/* CMAF: the segments are aligned on the key frames of the first video
+ * track having some, or only on time otherwise */
+static const mp4_stream_t *GetSegmentReference(sout_mux_sys_t *p_sys)
+{
+    for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+    {
+        const mp4_stream_t *p_stream = p_sys->pp_streams[i];
+        if (p_stream->b_hasiframes &&
+            mp4mux_track_GetFmt(p_stream->tinfo)->i_cat == VIDEO_ES)
+            return p_stream;
+    }
+    return NULL;
+}
+
+/* Returns the start time of the next segment, INT64_MAX if not queued yet */
+static vlc_tick_t GetSegmentBoundary(sout_mux_sys_t *p_sys,
+                                     const mp4_stream_t *p_ref)
+{
+    const vlc_tick_t i_target = p_sys->i_segment_start + p_sys->i_segment_length;
+    if (p_ref == NULL)
+        return i_target;
+
+    vlc_tick_t i_time = p_ref->i_written_duration;
+    for (const mp4_fragentry_t *p_entry = p_ref->read.p_first;
+         p_entry; p_entry = p_entry->p_next)
+    {
+        if (i_time >= i_target && (p_entry->p_block->i_flags & BLOCK_FLAG_TYPE_I))
+            return i_time;
+        i_time += p_entry->p_block->i_length;
+    }
+    return INT64_MAX;
+}
+
+static bo_t *GetStypBox(void)
+{
+    bo_t *styp = box_new("styp");
+    if (!styp)
+        return NULL;
+    bo_add_fourcc(styp, "cmfs");
+    bo_add_32be  (styp, 0);
+    bo_add_fourcc(styp, "cmfs");
+    bo_add_fourcc(styp, "msdh");
+    if (!styp->b)
+    {
+        free(styp);
+        return NULL;
+    }
+    box_fix(styp, bo_size(styp));
+    return styp;
+}
+
+/* Producer reference time, matching the wall clock to the decode time of
+ * the following fragment on the reference track */
+static bo_t *GetPrftBox(const mp4_stream_t *p_stream)
+{
+    bo_t *prft = box_full_new("prft", 1, 0);
+    if (!prft)
+        return NULL;
+    bo_add_32be(prft, mp4mux_track_GetID(p_stream->tinfo));
+    bo_add_64be(prft, NTPtime64());
+    bo_add_64be(prft, samples_from_vlc_tick(p_stream->i_written_duration,
+                                            mp4mux_track_GetTimescale(p_stream->tinfo)));
+    if (!prft->b)
+    {
+        free(prft);
+        return NULL;
+    }
+    box_fix(prft, bo_size(prft));
+    return prft;
+}
+
 static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
@@ -1323,8 +1564,46 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
     if (!p_sys->b_header_sent)
         FlushHeader(p_mux);
 
+    /* CMAF: chunk barrier, and styp/prft boxes ahead of the moof */
+    bo_t *head = NULL;
+    vlc_tick_t i_segment_start = p_sys->i_segment_start;
+    if (p_sys->b_cmaf && b_has_samples)
+    {
+        const mp4_stream_t *p_ref = GetSegmentReference(p_sys);
+        const vlc_tick_t i_ref_time = p_ref ? p_ref->i_written_duration
+                                            : p_sys->i_written_duration;
+        vlc_tick_t i_boundary = GetSegmentBoundary(p_sys, p_ref);
+        const bool b_new_segment = !p_sys->b_segment_started ||
+                                   i_ref_time >= i_boundary;
+        if (b_new_segment)
+        {
+            /* the boundary is recomputed from the new segment start */
+            p_sys->i_segment_start = i_ref_time;
+            i_boundary = GetSegmentBoundary(p_sys, p_ref);
+            p_sys->i_segment_start = i_segment_start;
+            i_segment_start = i_ref_time;
+            head = GetStypBox();
+        }
+
+        i_barrier_time = p_sys->i_chunk_length
+                       ? p_sys->i_written_duration + p_sys->i_chunk_length
+                       : INT64_MAX;
+        if (i_boundary < i_barrier_time)
+            i_barrier_time = i_boundary;
+
+        bo_t *prft = GetPrftBox(p_ref ? p_ref : p_sys->pp_streams[0]);
+        if (head)
+            box_gather(head, prft);
+        else
+            head = prft;
+
+        if (head && head->b)
+            head->b->i_flags = b_new_segment ? BLOCK_FLAG_TYPE_I : 0;
+    }
+    const uint64_t i_moof_pos = p_sys->i_pos + (head ? bo_size(head) : 0);
+
     if (b_has_samples)
-        moof = GetMoofBox(p_mux, &i_mdat_size, (b_flush)?0:i_barrier_time, p_sys->i_pos);
+        moof = GetMoofBox(p_mux, &i_mdat_size, (b_flush)?0:i_barrier_time, i_moof_pos);
 
     if (moof && i_mdat_size == 0)
     {
@@ -1332,11 +1611,27 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
         FREENULL(moof);
     }
 
+    if (!moof && head)
+        bo_free(head);
+
     if (moof)
     {
+        if (head)
+        {
+            /* chunks within a segment are not a joining point */
+            moof->b->i_flags &= ~BLOCK_FLAG_TYPE_I;
+            if (head->b->i_flags & BLOCK_FLAG_TYPE_I)
+            {
+                msg_Dbg(p_mux, "starting CMAF segment @ %"PRId64, p_sys->i_pos);
+                p_sys->i_segment_start = i_segment_start;
+                p_sys->b_segment_started = true;
+            }
+            p_sys->i_pos += bo_size(head);
+            box_send(p_mux, head);
+        }
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += bo_size(moof);
-        assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
+        assert(p_sys->b_cmaf || (moof->b->i_flags & BLOCK_FLAG_TYPE_I)); /* http sout */
         box_send(p_mux, moof);
         msg_Dbg(p_mux, "writing mdat @ %"PRId64, p_sys->i_pos);
         WriteFragmentMDAT(p_mux, i_mdat_size);
@@ -1529,7 +1824,10 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    const vlc_tick_t i_fragment_length = p_sys->b_cmaf
+                                       ? __MAX(p_sys->i_chunk_length, 1)
+                                       : FRAGMENT_LENGTH;
+    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
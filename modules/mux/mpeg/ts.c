@@ -187,6 +187,10 @@ static const char *const ts_standards_list_text[] =
     "The encryption routines subtract the TS-header from the value before " \
     "encrypting." )
 
+#define AGGREGATE_TEXT N_("Packets per output block")
+#define AGGREGATE_LONGTEXT N_("Number of TS packets gathered in each " \
+    "block sent to the access output. 7 packets fill a typical UDP datagram.")
+
 #define SOUT_CFG_PREFIX "sout-ts-"
 #define MAX_PMT 64       /* Maximum number of programs. FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
 #define MAX_PMT_PID 64       /* Maximum pids in each pmt.  FIXME: I just chose an arbitrary number. Where is the maximum in the spec? */
@@ -229,6 +233,8 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "aggregate", 7, AGGREGATE_TEXT, AGGREGATE_LONGTEXT, true)
+        change_integer_range( 1, 64 )
 
     add_bool( SOUT_CFG_PREFIX "crypt-audio", true, ACRYPT_TEXT, ACRYPT_LONGTEXT, true)
     add_bool( SOUT_CFG_PREFIX "crypt-video", true, VCRYPT_TEXT, VCRYPT_LONGTEXT, true)
@@ -249,7 +255,7 @@ static const char *const ppsz_sout_options[] = {
     "netid", "sdtdesc",
     "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
-    "muxpmt", "program-pmt", "alignment",
+    "muxpmt", "program-pmt", "alignment", "aggregate",
     NULL
 };
 
@@ -338,8 +344,22 @@ typedef struct
     tsmux_stream_t  ts;
     pesmux_stream_t pes;
     pes_state_t  state;
+    unsigned        i_mapped_prog;
 } sout_input_sys_t;
 
+#define TS_POOL_MAX 4096 /* recycled packets kept, about 1MB */
+#define TS_STATS_PERIOD VLC_TICK_FROM_SEC(10)
+
+typedef struct
+{
+    vlc_tick_t      i_start;
+    uint64_t        i_packets;
+    uint64_t        pi_prog_packets[MAX_PMT];
+    vlc_tick_t      i_last_pcr;
+    vlc_tick_t      i_pcr_interval_min;
+    vlc_tick_t      i_pcr_interval_max;
+} ts_stats_t;
+
 typedef struct
 {
     sout_input_t    *p_pcr_input;
@@ -385,8 +405,38 @@ typedef struct
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
     bool            b_crypt_video;
+
+    /* serialized PSI, replayed until the streams change */
+    sout_buffer_chain_t psi_pat;
+    sout_buffer_chain_t psi_pmt;
+
+    /* packets already written out, reused by TSNew */
+    sout_buffer_chain_t ts_pool;
+    int             i_aggregate;
+
+    ts_stats_t      stats;
 } sout_mux_sys_t;
 
+static block_t *TSAlloc( sout_mux_sys_t *p_sys )
+{
+    block_t *p_ts = BufferChainGet( &p_sys->ts_pool );
+    if( p_ts == NULL )
+        return block_Alloc( 188 );
+
+    p_ts->i_flags = 0;
+    p_ts->i_pts = p_ts->i_dts = VLC_TICK_INVALID;
+    p_ts->i_length = 0;
+    return p_ts;
+}
+
+static void TSRecycle( sout_mux_sys_t *p_sys, block_t *p_ts )
+{
+    if( p_sys->ts_pool.i_depth >= TS_POOL_MAX )
+        block_Release( p_ts );
+    else
+        BufferChainAppend( &p_sys->ts_pool, p_ts );
+}
+
 
 static int GetNextFreePID( sout_mux_t *p_mux, int i_pid_start )
 {
@@ -482,6 +532,7 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream, bool b_pcr );
 static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts );
+static void TSStats( sout_mux_t *p_mux, vlc_tick_t i_now );
 
 static csa_t *csaSetup( vlc_object_t *p_this )
 {
@@ -740,6 +791,14 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->b_use_key_frames = var_GetBool( p_mux, SOUT_CFG_PREFIX "use-key-frames" );
 
+    p_sys->i_aggregate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "aggregate" );
+    if( p_sys->i_aggregate < 1 )
+        p_sys->i_aggregate = 1;
+
+    BufferChainInit( &p_sys->psi_pat );
+    BufferChainInit( &p_sys->psi_pmt );
+    BufferChainInit( &p_sys->ts_pool );
+
     p_mux->p_sys        = p_sys;
 
     p_sys->csa = csaSetup(p_this);
@@ -777,6 +836,10 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt.desc[i].psz_provider );
     }
 
+    BufferChainClean( &p_sys->psi_pat );
+    BufferChainClean( &p_sys->psi_pmt );
+    BufferChainClean( &p_sys->ts_pool );
+
     free( p_sys );
 }
 
@@ -972,8 +1035,14 @@ static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
     /* Init pes chain */
     BufferChainInit( &p_stream->state.chain_pes );
 
+    int i_pidinput = p_input->p_fmt->i_id;
+    pmt_map_t *p_usepid = bsearch( &i_pidinput, p_sys->pmtmap,
+                                   p_sys->i_pmtslots, sizeof(pmt_map_t), intcompare );
+    p_stream->i_mapped_prog = p_usepid ? p_usepid->i_prog : 0;
+
     /* We only change PMT version (PAT isn't changed) */
     p_sys->i_pmt_version_number = ( p_sys->i_pmt_version_number + 1 )%32;
+    BufferChainClean( &p_sys->psi_pmt );
 
     /* Update pcr_pid */
     SelectPCRStream( p_mux, NULL );
@@ -1034,6 +1103,7 @@ static void DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
     /* We only change PMT version (PAT isn't changed) */
     p_sys->i_pmt_version_number++;
     p_sys->i_pmt_version_number %= 32;
+    BufferChainClean( &p_sys->psi_pmt );
 }
 
 static void SetHeader( sout_buffer_chain_t *c,
@@ -1156,6 +1226,10 @@ static block_t *Encap_J2K( block_t *p_data, const es_format_t *p_fmt )
     {
         p_data->p_buffer += (i_offset - 38);
         p_data->i_buffer -= (i_offset - 38);
+        /* The header is written over the skipped boxes */
+        p_data = block_Unshare( p_data );
+        if( unlikely(!p_data) )
+            return NULL;
     }
 
     const int profile = j2k_get_profile( p_fmt->video.i_visible_width,
@@ -1543,6 +1617,8 @@ static bool MuxStreams(sout_mux_t *p_mux )
         {
             p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
         }
+        if( p_stream->i_mapped_prog < MAX_PMT )
+            p_sys->stats.pi_prog_packets[p_stream->i_mapped_prog]++;
         i_packet_pos++;
 
         /* Write PAT/PMT before every keyframe if use-key-frames is enabled,
@@ -1571,6 +1647,7 @@ static bool MuxStreams(sout_mux_t *p_mux )
 
     /* 4: date and send */
     TSSchedule( p_mux, &chain_ts, i_pcr_length, i_pcr_dts );
+    TSStats( p_mux, i_pcr_dts + i_pcr_length );
     return false;
 }
 
@@ -1787,6 +1864,8 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     }
 
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
+    block_t *p_out = NULL;
+    p_sys->stats.i_packets += i_packet_count;
     for (int i = 0; i < i_packet_count; i++ )
     {
         block_t *p_ts = BufferChainGet( p_chain_ts );
@@ -1799,6 +1878,18 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         {
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
             TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+
+            ts_stats_t *p_stats = &p_sys->stats;
+            if( p_stats->i_last_pcr != VLC_TICK_INVALID )
+            {
+                vlc_tick_t i_interval = p_ts->i_dts - p_stats->i_last_pcr;
+                if( p_stats->i_pcr_interval_max == 0 ||
+                    i_interval < p_stats->i_pcr_interval_min )
+                    p_stats->i_pcr_interval_min = i_interval;
+                if( i_interval > p_stats->i_pcr_interval_max )
+                    p_stats->i_pcr_interval_max = i_interval;
+            }
+            p_stats->i_last_pcr = p_ts->i_dts;
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
@@ -1810,14 +1901,47 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         /* latency */
         p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        if( p_sys->i_aggregate <= 1 )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_ts );
+            continue;
+        }
+
+        /* Gather packets, but keep the headers starting a block so that
+         * segmenters can still cut before them */
+        if( p_out != NULL &&
+            ( p_out->i_buffer >= (size_t)p_sys->i_aggregate * 188 ||
+              (p_ts->i_flags & BLOCK_FLAG_HEADER) ) )
+        {
+            sout_AccessOutWrite( p_mux->p_access, p_out );
+            p_out = NULL;
+        }
+        if( p_out == NULL )
+        {
+            p_out = block_Alloc( p_sys->i_aggregate * 188 );
+            if( unlikely(p_out == NULL) )
+            {
+                sout_AccessOutWrite( p_mux->p_access, p_ts );
+                continue;
+            }
+            p_out->i_buffer = 0;
+            p_out->i_flags = p_ts->i_flags & BLOCK_FLAG_HEADER;
+            p_out->i_dts = p_ts->i_dts;
+            p_out->i_length = 0;
+        }
+        memcpy( &p_out->p_buffer[p_out->i_buffer], p_ts->p_buffer, 188 );
+        p_out->i_buffer += 188;
+        p_out->i_length += p_ts->i_length;
+        TSRecycle( p_sys, p_ts );
     }
+
+    if( p_out != NULL )
+        sout_AccessOutWrite( p_mux->p_access, p_out );
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
                        bool b_pcr )
 {
-    VLC_UNUSED(p_mux);
     block_t *p_pes = p_stream->state.chain_pes.p_first;
 
     bool b_new_pes = false;
@@ -1837,7 +1961,7 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
         b_adaptation_field = true;
     }
 
-    block_t *p_ts = block_Alloc( 188 );
+    block_t *p_ts = TSAlloc( p_mux->p_sys );
 
     if (b_new_pes && !(p_pes->i_flags & BLOCK_FLAG_NO_KEYFRAME) && p_pes->i_flags & BLOCK_FLAG_TYPE_I)
     {
@@ -1930,43 +2054,128 @@ static void TSSetPCR( block_t *p_ts, vlc_tick_t i_dts )
     p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
 }
 
+static tsmux_stream_t *GetPSIStream( sout_mux_sys_t *p_sys, uint16_t i_pid )
+{
+    if( i_pid == p_sys->pat.i_pid )
+        return &p_sys->pat;
+    if( i_pid == p_sys->sdt.ts.i_pid )
+        return &p_sys->sdt.ts;
+    for (unsigned i = 0; i < p_sys->i_num_pmt; i++ )
+    {
+        if( i_pid == p_sys->pmt[i].i_pid )
+            return &p_sys->pmt[i];
+    }
+    return NULL;
+}
+
+/* Copies the cached PSI packets, with the running continuity counters */
+static void ReplayPSI( sout_mux_sys_t *p_sys, const sout_buffer_chain_t *p_psi,
+                       sout_buffer_chain_t *c )
+{
+    for( const block_t *p_pkt = p_psi->p_first; p_pkt; p_pkt = p_pkt->p_next )
+    {
+        block_t *p_ts = TSAlloc( p_sys );
+        if( unlikely(p_ts == NULL) )
+            return;
+        memcpy( p_ts->p_buffer, p_pkt->p_buffer, 188 );
+
+        uint16_t i_pid = ( (p_ts->p_buffer[1] & 0x1f) << 8 ) | p_ts->p_buffer[2];
+        tsmux_stream_t *p_psi_stream = GetPSIStream( p_sys, i_pid );
+        if( p_psi_stream )
+        {
+            p_ts->p_buffer[3] = ( p_ts->p_buffer[3] & 0xf0 ) |
+                                p_psi_stream->i_continuity_counter;
+            p_psi_stream->i_continuity_counter =
+                    ( p_psi_stream->i_continuity_counter + 1 )%16;
+        }
+        BufferChainAppend( c, p_ts );
+    }
+}
+
 void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
 {
     sout_mux_sys_t       *p_sys = p_mux->p_sys;
 
-    BuildPAT( p_sys->p_dvbpsi,
-              c, (PEStoTSCallback)BufferChainAppend,
-              p_sys->i_tsid, p_sys->i_pat_version_number,
-              &p_sys->pat,
-              p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
+    if( p_sys->psi_pat.i_depth == 0 )
+    {
+        /* counters are only advanced when replaying */
+        tsmux_stream_t pat = p_sys->pat;
+
+        BuildPAT( p_sys->p_dvbpsi,
+                  &p_sys->psi_pat, (PEStoTSCallback)BufferChainAppend,
+                  p_sys->i_tsid, p_sys->i_pat_version_number,
+                  &pat,
+                  p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number );
+    }
+    ReplayPSI( p_sys, &p_sys->psi_pat, c );
 }
 
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
-    pes_mapped_stream_t mappeds[p_mux->i_nb_inputs];
 
-    for (int i_stream = 0; i_stream < p_mux->i_nb_inputs; i_stream++ )
+    if( p_sys->psi_pmt.i_depth == 0 )
     {
-        sout_input_t *p_input = p_mux->pp_inputs[i_stream];
-        sout_input_sys_t *p_stream = (sout_input_sys_t*)p_input->p_sys;
+        pes_mapped_stream_t mappeds[p_mux->i_nb_inputs];
 
-        int i_pidinput = p_input->p_fmt->i_id;
-        pmt_map_t *p_usepid = bsearch( &i_pidinput, p_sys->pmtmap,
-                                       p_sys->i_pmtslots, sizeof(pmt_map_t), intcompare );
+        for (int i_stream = 0; i_stream < p_mux->i_nb_inputs; i_stream++ )
+        {
+            sout_input_t *p_input = p_mux->pp_inputs[i_stream];
+            sout_input_sys_t *p_stream = (sout_input_sys_t*)p_input->p_sys;
+
+            /* If there's an error somewhere, it was dumped to the first pmt */
+            mappeds[i_stream].i_mapped_prog = p_stream->i_mapped_prog;
+            mappeds[i_stream].fmt = p_input->p_fmt;
+            mappeds[i_stream].pes = &p_stream->pes;
+            mappeds[i_stream].ts = &p_stream->ts;
+        }
 
-        /* If there's an error somewhere, dump it to the first pmt */
-        mappeds[i_stream].i_mapped_prog = p_usepid ? p_usepid->i_prog : 0;
-        mappeds[i_stream].fmt = p_input->p_fmt;
-        mappeds[i_stream].pes = &p_stream->pes;
-        mappeds[i_stream].ts = &p_stream->ts;
+        /* counters are only advanced when replaying */
+        tsmux_stream_t pmt[MAX_PMT];
+        sdt_psi_t sdt = p_sys->sdt;
+        memcpy( pmt, p_sys->pmt, sizeof(pmt) );
+
+        BuildPMT( p_sys->p_dvbpsi, VLC_OBJECT(p_mux), p_sys->standard,
+                  &p_sys->psi_pmt, (PEStoTSCallback)BufferChainAppend,
+                  p_sys->i_tsid, p_sys->i_pmt_version_number,
+                  ((sout_input_sys_t *)p_sys->p_pcr_input->p_sys)->ts.i_pid,
+                  &sdt,
+                  p_sys->i_num_pmt, pmt, p_sys->i_pmt_program_number,
+                  p_mux->i_nb_inputs, mappeds );
     }
+    ReplayPSI( p_sys, &p_sys->psi_pmt, c );
+}
 
-    BuildPMT( p_sys->p_dvbpsi, VLC_OBJECT(p_mux), p_sys->standard,
-              c, (PEStoTSCallback)BufferChainAppend,
-              p_sys->i_tsid, p_sys->i_pmt_version_number,
-              ((sout_input_sys_t *)p_sys->p_pcr_input->p_sys)->ts.i_pid,
-              &p_sys->sdt,
-              p_sys->i_num_pmt, p_sys->pmt, p_sys->i_pmt_program_number,
-              p_mux->i_nb_inputs, mappeds );
+static void TSStats( sout_mux_t *p_mux, vlc_tick_t i_now )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    ts_stats_t *p_stats = &p_sys->stats;
+
+    if( p_stats->i_start == VLC_TICK_INVALID )
+    {
+        p_stats->i_start = i_now;
+        return;
+    }
+
+    const vlc_tick_t i_period = i_now - p_stats->i_start;
+    if( i_period < TS_STATS_PERIOD )
+        return;
+
+    msg_Dbg( p_mux, "muxed %"PRIu64" bit/s",
+             p_stats->i_packets * 188 * 8 * CLOCK_FREQ / i_period );
+    for (unsigned i = 0; i < p_sys->i_num_pmt; i++ )
+        msg_Dbg( p_mux, "    - program %d: %"PRIu64" bit/s",
+                 p_sys->i_pmt_program_number[i],
+                 p_stats->pi_prog_packets[i] * 188 * 8 * CLOCK_FREQ / i_period );
+    if( p_stats->i_pcr_interval_max > 0 )
+        msg_Dbg( p_mux, "    - PCR interval %"PRId64"-%"PRId64" us, jitter %"PRId64" us",
+                 US_FROM_VLC_TICK(p_stats->i_pcr_interval_min),
+                 US_FROM_VLC_TICK(p_stats->i_pcr_interval_max),
+                 US_FROM_VLC_TICK(p_stats->i_pcr_interval_max -
+                                  p_stats->i_pcr_interval_min) );
+
+    const vlc_tick_t i_last_pcr = p_stats->i_last_pcr;
+    memset( p_stats, 0, sizeof(*p_stats) );
+    p_stats->i_start = i_now;
+    p_stats->i_last_pcr = i_last_pcr;
 }
@@ -40,6 +40,7 @@
 #include "a52.h"
 
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 static int  Open( vlc_object_t * );
 static void Close( vlc_object_t * );
@@ -134,6 +135,17 @@ static block_t *GetOutBuffer( decoder_t *p_dec )
     return p_block;
 }
 
+static const uint8_t *SyncHelper( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_FindSync16( p, end, 0x0b, 0x77, 0xff );
+}
+
+static bool SyncMatcher( uint8_t i, size_t i_pos, const uint8_t *p_startcode )
+{
+    VLC_UNUSED(p_startcode);
+    return i == ((i_pos == 0) ? 0x0b : 0x77);
+}
+
 static block_t *PacketizeBlock( decoder_t *p_dec, block_t **pp_block )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -168,16 +180,9 @@ static block_t *PacketizeBlock( decoder_t *p_dec, block_t **pp_block )
         switch( p_sys->i_state )
         {
         case STATE_NOSYNC:
-            while( block_PeekBytes( &p_sys->bytestream, p_header, 2 )
-                   == VLC_SUCCESS )
-            {
-                if( p_header[0] == 0x0b && p_header[1] == 0x77 )
-                {
-                    p_sys->i_state = STATE_SYNC;
-                    break;
-                }
-                block_SkipByte( &p_sys->bytestream );
-            }
+            if( packetizer_SkipToSync( &p_sys->bytestream, 2, SyncHelper,
+                                       SyncMatcher ) == VLC_SUCCESS )
+                p_sys->i_state = STATE_SYNC;
             if( p_sys->i_state != STATE_SYNC )
             {
                 block_BytestreamFlush( &p_sys->bytestream );
@@ -126,6 +126,41 @@ static block_t *GetOutBuffer( decoder_t *p_dec )
     return p_block;
 }
 
+/* First 4 bytes of the sync words, checked with vlc_dts_header_IsSync() */
+static const uint8_t dts_syncwords[][4] = {
+    { 0x7F, 0xFE, 0x80, 0x01 }, /* core BE */
+    { 0xFE, 0x7F, 0x01, 0x80 }, /* core LE */
+    { 0x64, 0x58, 0x20, 0x25 }, /* substream */
+    { 0x1F, 0xFF, 0xE8, 0x00 }, /* core 14 bits BE */
+    { 0xFF, 0x1F, 0x00, 0xE8 }, /* core 14 bits LE */
+    { 0x0A, 0x80, 0x19, 0x21 }, /* substream LBR */
+};
+
+static const uint8_t *SyncHelper( const uint8_t *p, const uint8_t *end )
+{
+    for( end -= 3; p < end; p++ )
+    {
+        switch( p[0] )
+        {
+            case 0x7F: case 0xFE: case 0x64: case 0x1F: case 0xFF: case 0x0A:
+                for( size_t i = 0; i < ARRAY_SIZE(dts_syncwords); i++ )
+                    if( !memcmp( p, dts_syncwords[i], 4 ) )
+                        return p;
+                break;
+        }
+    }
+    return NULL;
+}
+
+static bool SyncMatcher( uint8_t i, size_t i_pos, const uint8_t *p_startcode )
+{
+    VLC_UNUSED(p_startcode);
+    for( size_t j = 0; j < ARRAY_SIZE(dts_syncwords); j++ )
+        if( dts_syncwords[j][i_pos] == i )
+            return true;
+    return false;
+}
+
 static block_t *PacketizeBlock( decoder_t *p_dec, block_t **pp_block )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -165,7 +200,9 @@ static block_t *PacketizeBlock( decoder_t *p_dec, block_t **pp_block )
         switch( p_sys->i_state )
         {
         case STATE_NOSYNC:
-            while( block_PeekBytes( &p_sys->bytestream, p_header, 6 )
+            while( packetizer_SkipToSync( &p_sys->bytestream, 4, SyncHelper,
+                                          SyncMatcher ) == VLC_SUCCESS
+                && block_PeekBytes( &p_sys->bytestream, p_header, 6 )
                    == VLC_SUCCESS )
             {
                 if( vlc_dts_header_IsSync( p_header, 6 ) )
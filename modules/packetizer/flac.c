@@ -35,6 +35,7 @@
 
 #include <vlc_block_helper.h>
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 #include "flac.h"
 
 /*****************************************************************************
@@ -223,6 +224,41 @@ static uint16_t flac_crc16(uint16_t crc, uint8_t byte)
 {
     return (crc << 8) ^ flac_crc16_table[(crc >> 8) ^ byte];
 }
+
+/* Slicing-by-8 tables: flac_crc16_slices[k][b] is the CRC of the byte b
+ * followed by k null bytes */
+static uint16_t flac_crc16_slices[8][256];
+static vlc_once_t flac_crc16_once = VLC_STATIC_ONCE;
+
+static void flac_crc16_init(void)
+{
+    for (unsigned i = 0; i < 256; i++)
+    {
+        uint16_t crc = flac_crc16_table[i];
+
+        flac_crc16_slices[0][i] = crc;
+        for (unsigned k = 1; k < 8; k++)
+        {
+            crc = (crc << 8) ^ flac_crc16_table[crc >> 8];
+            flac_crc16_slices[k][i] = crc;
+        }
+    }
+}
+
+static uint16_t flac_crc16_buf(uint16_t crc, const uint8_t *p, size_t len)
+{
+    /* the CRC is folded into the first 2 bytes of each 8 bytes chunk */
+    for (; len >= 8; len -= 8, p += 8)
+        crc = flac_crc16_slices[7][p[0] ^ (crc >> 8)]
+            ^ flac_crc16_slices[6][p[1] ^ (crc & 0xff)]
+            ^ flac_crc16_slices[5][p[2]] ^ flac_crc16_slices[4][p[3]]
+            ^ flac_crc16_slices[3][p[4]] ^ flac_crc16_slices[2][p[5]]
+            ^ flac_crc16_slices[1][p[6]] ^ flac_crc16_slices[0][p[7]];
+
+    while (len-- > 0)
+        crc = flac_crc16(crc, *p++);
+    return crc;
+}
 #if 0
 /* Gives the previous CRC value, before hashing last_byte through it */
 static uint16_t flac_crc16_undo(uint16_t crc, const uint8_t last_byte)
@@ -283,17 +319,7 @@ static void Flush(decoder_t *p_dec)
 
 static const uint8_t * FLACStartcodeHelper(const uint8_t *p, const uint8_t *end)
 {
-    while( p && p < end )
-    {
-        if( (p = memchr(p, 0xFF, end - p)) )
-        {
-            if( end - p > 1 && (p[1] & 0xFE) == 0xF8 )
-                return p;
-            else
-                p++;
-        }
-    }
-    return NULL;
+    return startcode_FindSync16(p, end, 0xFF, 0xF8, 0xFE);
 }
 
 static bool FLACStartcodeMatcher(uint8_t i, size_t i_pos, const uint8_t *p_startcode)
@@ -471,8 +497,10 @@ static block_t *Packetize(decoder_t *p_dec, block_t **pp_block)
                                     p_sys->i_offset - p_sys->i_frame_size );
 
             /* update crc to include this data chunk */
-            for( size_t i = p_sys->i_frame_size; i < p_sys->i_offset - 2; i++ )
-                p_sys->crc = flac_crc16( p_sys->crc, p_sys->p_buf[i] );
+            if( p_sys->i_offset - 2 > p_sys->i_frame_size )
+                p_sys->crc = flac_crc16_buf( p_sys->crc,
+                                             &p_sys->p_buf[p_sys->i_frame_size],
+                                             p_sys->i_offset - 2 - p_sys->i_frame_size );
 
             p_sys->i_frame_size = p_sys->i_offset;
 
@@ -558,6 +586,7 @@ static int Open(vlc_object_t *p_this)
     if (p_dec->fmt_in.i_codec != VLC_CODEC_FLAC)
         return VLC_EGENERIC;
 
+    vlc_once(&flac_crc16_once, flac_crc16_init);
 
     /* */
     p_dec->p_sys = p_sys = malloc(sizeof(*p_sys));
@@ -187,6 +187,23 @@ static void StorePPS( decoder_sys_t *p_sys, uint8_t i_id,
     p_sys->pps[i_id].p_pps = p_pps;
 }
 
+/* SEI payloads worth parsing in the current state */
+static unsigned GetSEITypes( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    const h264_sequence_parameter_set_t *p_sps = p_sys->p_active_sps;
+    unsigned i_types = HXXX_SEI_FLAG_USER_DATA_REGISTERED_ITU_T_T35;
+    if( p_sps && p_sps->vui.b_valid &&
+        ( p_sps->vui.b_hrd_parameters_present_flag ||
+          p_sps->vui.b_pic_struct_present_flag ) )
+        i_types |= HXXX_SEI_FLAG_PIC_TIMING;
+    if( !p_sys->b_recovered )
+        i_types |= HXXX_SEI_FLAG_RECOVERY_POINT;
+    if( p_dec->fmt_in.video.multiview_mode == MULTIVIEW_2D )
+        i_types |= HXXX_SEI_FLAG_FRAME_PACKING_ARRANGEMENT;
+    return i_types;
+}
+
 static void ActivateSets( decoder_t *p_dec, const h264_sequence_parameter_set_t *p_sps,
                                             const h264_picture_parameter_set_t *p_pps )
 {
@@ -657,7 +674,8 @@ static block_t *ParseNALBlock( decoder_t *p_dec, bool *pb_ts_used, block_t *p_fr
                         if( (p_sei->i_flags & BLOCK_FLAG_PRIVATE_SEI) == 0 )
                             continue;
                         HxxxParse_AnnexB_SEI( p_sei->p_buffer, p_sei->i_buffer,
-                                              1 /* nal header */, ParseSeiCallback, p_dec );
+                                              1 /* nal header */, GetSEITypes( p_dec ),
+                                              ParseSeiCallback, p_dec );
                     }
 
                     if( p_sys->b_slice )
@@ -784,6 +802,9 @@ static bool CanSwapPTSwithDTS( const h264_slice_t *p_slice,
 {
     if( p_slice->i_nal_ref_idc == 0 && p_slice->type == H264_SLICE_TYPE_B )
         return true;
+    /* POC type 2: output order is decoding order */
+    else if( p_sps->i_pic_order_cnt_type == 2 )
+        return true;
     else if( p_sps->vui.b_valid )
         return p_sps->vui.i_max_num_reorder_frames == 0;
     else
@@ -1064,6 +1085,14 @@ static block_t *OutputPicture( decoder_t *p_dec )
     return p_pic;
 }
 
+static bool IsSameNAL( const block_t *p_stored, const uint8_t *p_buffer, size_t i_buffer )
+{
+    const uint8_t *p_stored_buffer = p_stored->p_buffer;
+    size_t i_stored_buffer = p_stored->i_buffer;
+    return hxxx_strip_AnnexB_startcode( &p_stored_buffer, &i_stored_buffer ) &&
+           i_stored_buffer == i_buffer && !memcmp( p_stored_buffer, p_buffer, i_buffer );
+}
+
 static void PutSPS( decoder_t *p_dec, block_t *p_frag )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -1077,6 +1106,17 @@ static void PutSPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    /* Resent and unchanged, only refresh the stored NAL */
+    for( size_t i = 0; i <= H264_SPS_ID_MAX; i++ )
+    {
+        if( p_sys->sps[i].p_block && IsSameNAL( p_sys->sps[i].p_block, p_buffer, i_buffer ) )
+        {
+            block_Release( p_sys->sps[i].p_block );
+            p_sys->sps[i].p_block = p_frag;
+            return;
+        }
+    }
+
     h264_sequence_parameter_set_t *p_sps = h264_decode_sps( p_buffer, i_buffer, true );
     if( !p_sps )
     {
@@ -1104,6 +1144,17 @@ static void PutPPS( decoder_t *p_dec, block_t *p_frag )
         return;
     }
 
+    /* Resent and unchanged, only refresh the stored NAL */
+    for( size_t i = 0; i <= H264_PPS_ID_MAX; i++ )
+    {
+        if( p_sys->pps[i].p_block && IsSameNAL( p_sys->pps[i].p_block, p_buffer, i_buffer ) )
+        {
+            block_Release( p_sys->pps[i].p_block );
+            p_sys->pps[i].p_block = p_frag;
+            return;
+        }
+    }
+
     h264_picture_parameter_set_t *p_pps = h264_decode_pps( p_buffer, i_buffer, true );
     if( !p_pps )
     {
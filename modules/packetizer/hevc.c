@@ -654,6 +654,22 @@ static void GetXPSSet(uint8_t i_pps_id, void *priv,
             *pp_vps = p_sys->rg_vps[hevc_get_sps_vps_id(*pp_sps)].p_decoded;
 }
 
+/* SEI payloads worth parsing in the current state */
+static unsigned GetSEITypes( decoder_t *p_dec )
+{
+    decoder_sys_t *p_sys = p_dec->p_sys;
+    unsigned i_types = HXXX_SEI_FLAG_USER_DATA_REGISTERED_ITU_T_T35 |
+                       HXXX_SEI_FLAG_MASTERING_DISPLAY_COLOUR_VOLUME |
+                       HXXX_SEI_FLAG_CONTENT_LIGHT_LEVEL;
+    if( p_sys->p_active_sps )
+        i_types |= HXXX_SEI_FLAG_PIC_TIMING;
+    if( !p_sys->b_recovery_point )
+        i_types |= HXXX_SEI_FLAG_RECOVERY_POINT;
+    if( p_dec->fmt_in.video.multiview_mode == MULTIVIEW_2D )
+        i_types |= HXXX_SEI_FLAG_FRAME_PACKING_ARRANGEMENT;
+    return i_types;
+}
+
 static void ParseStoredSEI( decoder_t *p_dec )
 {
     decoder_sys_t *p_sys = p_dec->p_sys;
@@ -667,7 +683,8 @@ static void ParseStoredSEI( decoder_t *p_dec )
         if( hevc_getNALType(&p_nal->p_buffer[4]) == HEVC_NAL_PREF_SEI )
         {
             HxxxParse_AnnexB_SEI( p_nal->p_buffer, p_nal->i_buffer,
-                                  2 /* nal header */, ParseSEICallback, p_dec );
+                                  2 /* nal header */, GetSEITypes( p_dec ),
+                                  ParseSEICallback, p_dec );
         }
     }
 }
@@ -832,7 +849,8 @@ static block_t * ParseAUTail(decoder_t *p_dec, uint8_t i_nal_type, block_t *p_na
 
         case HEVC_NAL_SUFF_SEI:
             HxxxParse_AnnexB_SEI( p_nalb->p_buffer, p_nalb->i_buffer,
-                                  2 /* nal header */, ParseSEICallback, p_dec );
+                                  2 /* nal header */, GetSEITypes( p_dec ),
+                                  ParseSEICallback, p_dec );
             break;
     }
 
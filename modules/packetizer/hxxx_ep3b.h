@@ -20,6 +20,8 @@
  *****************************************************************************/
 #include <vlc_bits.h>
 
+#include "startcode_helper.h"
+
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
@@ -83,17 +85,23 @@ static void hxxx_bsfw_ep3b_ctx_init( struct hxxx_bsfw_ep3b_ctx_s *ctx )
 
 static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
 {
-    /* compute final size */
-    unsigned i_prev = 0;
-    size_t i = 0;
-    while( p < p_end )
+    /* compute final size, same as stepping hxxx_ep3b_to_rbsp() to the end:
+     * the first byte is never part of a 00 00 03 sequence, an 03 is never
+     * escaped if it is the last byte, and the zero history restarts after
+     * each escaped byte */
+    const uint8_t *p_start = p;
+    const uint8_t *p_min = p + 1;
+    size_t i_skipped = 0;
+
+    while( p_end - p_min >= 3 )
     {
-        uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
-        if( n > p )
-            ++i;
-        p = n;
+        const uint8_t *q = startcode_FindEP3B( p_min, p_end );
+        if( q == NULL || q + 3 >= p_end )
+            break;
+        i_skipped++;
+        p_min = q + 3;
     }
-    return i;
+    return (p_end - p_start) - i_skipped;
 }
 
 static size_t hxxx_bsfw_byte_forward_ep3b( bs_t *s, size_t i_count )
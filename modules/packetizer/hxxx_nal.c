@@ -25,6 +25,8 @@
 
 static bool block_WillRealloc( block_t *p_block, ssize_t i_prebody, size_t i_body )
 {
+    if( block_IsShared( p_block ) ) /* would be copied */
+        return false;
     if( i_prebody <= 0 && i_body <= (size_t)(-i_prebody) )
         return false;
     else
@@ -150,6 +152,17 @@ block_t *hxxx_AnnexB_to_xVC( block_t *p_block, uint8_t i_nal_length_size )
     }
     else
     {
+        /* In place conversion, on a private copy if the payload is shared */
+        if( block_IsShared( p_block ) )
+        {
+            block_t *p_newblock = block_Duplicate( p_block );
+            if( unlikely(!p_newblock) )
+                goto error;
+            for( unsigned i=0; i<i_nalcount; i++ )
+                p_list[i].p = &p_newblock->p_buffer[p_list[i].p - p_block->p_buffer];
+            block_Release( p_block );
+            p_block = p_newblock;
+        }
         p_source = p_dest = p_block->p_buffer;
         p_sourceend = &p_block->p_buffer[p_block->i_buffer];
     }
@@ -30,19 +30,49 @@
 #include "hxxx_ep3b.h"
 
 void HxxxParse_AnnexB_SEI(const uint8_t *p_buf, size_t i_buf,
-                          uint8_t i_header, pf_hxxx_sei_callback cb, void *cbdata)
+                          uint8_t i_header, unsigned i_types,
+                          pf_hxxx_sei_callback cb, void *cbdata)
 {
     if( hxxx_strip_AnnexB_startcode( &p_buf, &i_buf ) )
-        HxxxParseSEI(p_buf, i_buf, i_header, cb, cbdata);
+        HxxxParseSEI_Types(p_buf, i_buf, i_header, i_types, cb, cbdata);
 }
 
 void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
                   uint8_t i_header, pf_hxxx_sei_callback pf_callback, void *cbdata)
+{
+    HxxxParseSEI_Types(p_buf, i_buf, i_header, HXXX_SEI_FLAG_ALL,
+                       pf_callback, cbdata);
+}
+
+static unsigned HxxxSEITypeFlag( unsigned i_type )
+{
+    switch( i_type )
+    {
+        case HXXX_SEI_PIC_TIMING:
+            return HXXX_SEI_FLAG_PIC_TIMING;
+        case HXXX_SEI_USER_DATA_REGISTERED_ITU_T_T35:
+            return HXXX_SEI_FLAG_USER_DATA_REGISTERED_ITU_T_T35;
+        case HXXX_SEI_RECOVERY_POINT:
+            return HXXX_SEI_FLAG_RECOVERY_POINT;
+        case HXXX_SEI_FRAME_PACKING_ARRANGEMENT:
+            return HXXX_SEI_FLAG_FRAME_PACKING_ARRANGEMENT;
+        case HXXX_SEI_MASTERING_DISPLAY_COLOUR_VOLUME:
+            return HXXX_SEI_FLAG_MASTERING_DISPLAY_COLOUR_VOLUME;
+        case HXXX_SEI_CONTENT_LIGHT_LEVEL:
+            return HXXX_SEI_FLAG_CONTENT_LIGHT_LEVEL;
+        default:
+            return 0;
+    }
+}
+
+void HxxxParseSEI_Types(const uint8_t *p_buf, size_t i_buf,
+                        uint8_t i_header, unsigned i_types,
+                        pf_hxxx_sei_callback pf_callback, void *cbdata)
 {
     bs_t s;
     bool b_continue = true;
 
-    if( i_buf <= i_header )
+    if( i_buf <= i_header || i_types == 0 )
         return;
 
     struct hxxx_bsfw_ep3b_ctx_s bsctx;
@@ -82,7 +112,7 @@ void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
 
         /* Save start offset */
         const unsigned i_start_bit_pos = bs_pos( &s );
-        switch( i_type )
+        switch( (HxxxSEITypeFlag( i_type ) & i_types) ? i_type : 0 )
         {
             /* Look for pic timing, do not decode locally */
             case HXXX_SEI_PIC_TIMING:
@@ -94,45 +124,56 @@ void HxxxParseSEI(const uint8_t *p_buf, size_t i_buf,
             /* Look for user_data_registered_itu_t_t35 */
             case HXXX_SEI_USER_DATA_REGISTERED_ITU_T_T35:
             {
-                size_t i_t35;
-                uint8_t *p_t35 = malloc( i_size );
-                if( !p_t35 )
-                    break;
-
-                for( i_t35 = 0; i_t35<i_size && bs_remain( &s ) >= 8; i_t35++ )
-                    p_t35[i_t35] = bs_read( &s, 8 );
-
+                /* Look at the provider header first, and only copy
+                 * payloads which are going to be reported */
+                uint8_t hdr[8];
+                size_t i_hdr;
+                for( i_hdr = 0; i_hdr < __MIN(i_size, 8) && bs_remain( &s ) >= 8; i_hdr++ )
+                    hdr[i_hdr] = bs_read( &s, 8 );
+
+                size_t i_cc_offset = 0;
                 /* TS 101 154 Auxiliary Data and H264/AVC video */
-                if( i_t35 > 4 && p_t35[0] == 0xb5 /* United States */ )
+                if( i_hdr > 4 && hdr[0] == 0xb5 /* United States */ )
                 {
-                    if( p_t35[1] == 0x00 && p_t35[2] == 0x31 && /* US provider code for ATSC / DVB1 */
-                        i_t35 > 7 )
+                    if( hdr[1] == 0x00 && hdr[2] == 0x31 && /* US provider code for ATSC / DVB1 */
+                        i_size > 7 && i_hdr == 8 )
                     {
-                        switch( VLC_FOURCC(p_t35[3],p_t35[4],p_t35[5],p_t35[6]) )
+                        switch( VLC_FOURCC(hdr[3],hdr[4],hdr[5],hdr[6]) )
                         {
                             case VLC_FOURCC('G', 'A', '9', '4'):
-                                if( p_t35[7] == 0x03 )
-                                {
-                                    sei_data.itu_t35.type = HXXX_ITU_T35_TYPE_CC;
-                                    sei_data.itu_t35.u.cc.i_data = i_t35 - 8;
-                                    sei_data.itu_t35.u.cc.p_data = &p_t35[8];
-                                    b_continue = pf_callback( &sei_data, cbdata );
-                                }
+                                if( hdr[7] == 0x03 )
+                                    i_cc_offset = 8;
                                 break;
                             default:
                                 break;
                         }
                     }
-                    else if( p_t35[1] == 0x00 && p_t35[2] == 0x2f && /* US provider code for DirecTV */
-                             p_t35[3] == 0x03 && i_t35 > 5 )
+                    else if( hdr[1] == 0x00 && hdr[2] == 0x2f && /* US provider code for DirecTV */
+                             hdr[3] == 0x03 && i_size > 5 )
                     {
                         /* DirecTV does not use GA94 user_data identifier */
-                        sei_data.itu_t35.type = HXXX_ITU_T35_TYPE_CC;
-                        sei_data.itu_t35.u.cc.i_data = i_t35 - 5;
-                        sei_data.itu_t35.u.cc.p_data = &p_t35[5];
-                        b_continue = pf_callback( &sei_data, cbdata );
+                        i_cc_offset = 5;
                     }
                 }
+                if( i_cc_offset == 0 )
+                    break;
+
+                uint8_t *p_t35 = malloc( i_size );
+                if( !p_t35 )
+                    break;
+
+                memcpy( p_t35, hdr, i_hdr );
+                size_t i_t35;
+                for( i_t35 = i_hdr; i_t35<i_size && bs_remain( &s ) >= 8; i_t35++ )
+                    p_t35[i_t35] = bs_read( &s, 8 );
+
+                if( i_t35 > i_cc_offset )
+                {
+                    sei_data.itu_t35.type = HXXX_ITU_T35_TYPE_CC;
+                    sei_data.itu_t35.u.cc.i_data = i_t35 - i_cc_offset;
+                    sei_data.itu_t35.u.cc.p_data = &p_t35[i_cc_offset];
+                    b_continue = pf_callback( &sei_data, cbdata );
+                }
 
                 free( p_t35 );
             } break;
@@ -31,6 +31,18 @@ enum hxxx_sei_type_e
     HXXX_SEI_CONTENT_LIGHT_LEVEL = 144,
 };
 
+/* Selects the payload types to parse and report, others are skipped */
+enum hxxx_sei_flag_e
+{
+    HXXX_SEI_FLAG_PIC_TIMING                      = 1 << 0,
+    HXXX_SEI_FLAG_USER_DATA_REGISTERED_ITU_T_T35  = 1 << 1,
+    HXXX_SEI_FLAG_RECOVERY_POINT                  = 1 << 2,
+    HXXX_SEI_FLAG_FRAME_PACKING_ARRANGEMENT       = 1 << 3,
+    HXXX_SEI_FLAG_MASTERING_DISPLAY_COLOUR_VOLUME = 1 << 4,
+    HXXX_SEI_FLAG_CONTENT_LIGHT_LEVEL             = 1 << 5,
+};
+#define HXXX_SEI_FLAG_ALL (~0U)
+
 enum hxxx_sei_t35_type_e
 {
     HXXX_ITU_T35_TYPE_CC,
@@ -94,6 +106,9 @@ typedef struct
 
 typedef bool (*pf_hxxx_sei_callback)(const hxxx_sei_data_t *, void *);
 void HxxxParseSEI(const uint8_t *, size_t, uint8_t, pf_hxxx_sei_callback, void *);
-void HxxxParse_AnnexB_SEI(const uint8_t *, size_t, uint8_t, pf_hxxx_sei_callback, void *);
+void HxxxParseSEI_Types(const uint8_t *, size_t, uint8_t, unsigned i_types,
+                        pf_hxxx_sei_callback, void *);
+void HxxxParse_AnnexB_SEI(const uint8_t *, size_t, uint8_t, unsigned i_types,
+                          pf_hxxx_sei_callback, void *);
 
 #endif
@@ -40,6 +40,7 @@
 #include <vlc_block_helper.h>
 
 #include "packetizer_helper.h"
+#include "startcode_helper.h"
 
 /*****************************************************************************
  * decoder_sys_t : decoder descriptor
@@ -275,6 +276,17 @@ static int SyncInfo( uint32_t i_header, unsigned int * pi_channels,
     return i_frame_size;
 }
 
+static const uint8_t *SyncHelper( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_FindSync16( p, end, 0xff, 0xe0, 0xe0 );
+}
+
+static bool SyncMatcher( uint8_t i, size_t i_pos, const uint8_t *p_startcode )
+{
+    VLC_UNUSED(p_startcode);
+    return (i_pos == 0) ? i == 0xff : (i & 0xe0) == 0xe0;
+}
+
 /****************************************************************************
  * DecodeBlock: the whole thing
  ****************************************************************************
@@ -326,17 +338,10 @@ static block_t *DecodeBlock( decoder_t *p_dec, block_t **pp_block )
         {
 
         case STATE_NOSYNC:
-            while( block_PeekBytes( &p_sys->bytestream, p_header, 2 )
-                   == VLC_SUCCESS )
-            {
-                /* Look for sync word - should be 0xffe */
-                if( p_header[0] == 0xff && (p_header[1] & 0xe0) == 0xe0 )
-                {
-                    p_sys->i_state = STATE_SYNC;
-                    break;
-                }
-                block_SkipByte( &p_sys->bytestream );
-            }
+            /* Look for sync word - should be 0xffe */
+            if( packetizer_SkipToSync( &p_sys->bytestream, 2, SyncHelper,
+                                       SyncMatcher ) == VLC_SUCCESS )
+                p_sys->i_state = STATE_SYNC;
             if( p_sys->i_state != STATE_SYNC )
             {
                 block_BytestreamFlush( &p_sys->bytestream );
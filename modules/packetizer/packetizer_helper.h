@@ -275,5 +275,21 @@ static inline void packetizer_Header( packetizer_t *p_pack,
     p_pack->i_offset = 0;
 }
 
+/* Skips the bytestream up to the next sync word of i_length bytes.
+ * Returns VLC_SUCCESS if the bytestream now starts with a sync word, or an
+ * error if more data is needed (the bytes that can't start a sync word are
+ * skipped). */
+static inline int packetizer_SkipToSync( block_bytestream_t *p_bytestream,
+                                         int i_length,
+                                         block_startcode_helper_t pf_helper,
+                                         block_startcode_matcher_t pf_matcher )
+{
+    size_t i_offset = 0;
+    int i_ret = block_FindStartcodeFromOffset( p_bytestream, &i_offset, NULL,
+                                               i_length, pf_helper, pf_matcher );
+    block_SkipBytes( p_bytestream, i_offset );
+    return i_ret;
+}
+
 #endif
 
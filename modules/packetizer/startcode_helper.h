@@ -25,6 +25,84 @@
 #if !defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
    #include <emmintrin.h>
 #endif
+#if defined(HAVE_AVX2_INTRINSICS) && (defined(__i386__) || defined(__x86_64__))
+   #include <immintrin.h>
+   #define STARTCODE_AVX2 1
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+   #include <arm_neon.h>
+   #define STARTCODE_NEON 1
+#endif
+
+/* Looks up 0x00 0x00 i_last byte by byte, from p to end (excluded) */
+static inline const uint8_t * startcode_Find_C( const uint8_t *p, const uint8_t *end,
+                                                uint8_t i_last )
+{
+    for (end -= 3; p <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == i_last)
+            return p;
+    }
+    return NULL;
+}
+
+/* The vector variants below compare the 3 bytes at every offset of a
+ * chunk at once, using unaligned loads, and return the exact match */
+
+#ifdef STARTCODE_AVX2
+__attribute__ ((__target__ ("avx2")))
+static inline const uint8_t * startcode_Find_AVX2( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t i_last )
+{
+    const __m256i zeros = _mm256_setzero_si256();
+    const __m256i last = _mm256_set1_epi8( i_last );
+
+    for( ; end - p >= 32 + 2; p += 32 )
+    {
+        __m256i a = _mm256_loadu_si256( (const __m256i *)&p[0] );
+        __m256i b = _mm256_loadu_si256( (const __m256i *)&p[1] );
+        __m256i c = _mm256_loadu_si256( (const __m256i *)&p[2] );
+        uint32_t match = _mm256_movemask_epi8(
+                            _mm256_and_si256(
+                                _mm256_and_si256( _mm256_cmpeq_epi8( a, zeros ),
+                                                  _mm256_cmpeq_epi8( b, zeros ) ),
+                                _mm256_cmpeq_epi8( c, last ) ) );
+        if( match )
+            return p + __builtin_ctz( match );
+    }
+    return startcode_Find_C( p, end, i_last );
+}
+
+__attribute__ ((__target__ ("avx2")))
+static inline const uint8_t * startcode_FindAnnexB_AVX2( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_AVX2( p, end, 1 );
+}
+#endif
+
+#ifdef STARTCODE_NEON
+static inline const uint8_t * startcode_Find_NEON( const uint8_t *p, const uint8_t *end,
+                                                   uint8_t i_last )
+{
+    const uint8x16_t zeros = vdupq_n_u8( 0 );
+    const uint8x16_t last = vdupq_n_u8( i_last );
+
+    for( ; end - p >= 16 + 2; p += 16 )
+    {
+        uint8x16_t match = vandq_u8(
+                            vandq_u8( vceqq_u8( vld1q_u8( &p[0] ), zeros ),
+                                      vceqq_u8( vld1q_u8( &p[1] ), zeros ) ),
+                            vceqq_u8( vld1q_u8( &p[2] ), last ) );
+        if( vmaxvq_u8( match ) )
+            return startcode_Find_C( p, p + 16 + 2, i_last );
+    }
+    return startcode_Find_C( p, end, i_last );
+}
+
+static inline const uint8_t * startcode_FindAnnexB_NEON( const uint8_t *p, const uint8_t *end )
+{
+    return startcode_Find_NEON( p, end, 1 );
+}
+#endif
 
 /* Looks up efficiently for an AnnexB startcode 0x00 0x00 0x01
  * by using a 4 times faster trick than single byte lookup. */
@@ -143,13 +221,55 @@ static inline const uint8_t * startcode_FindAnnexB_Bits( const uint8_t *p, const
 #if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
 static inline const uint8_t * startcode_FindAnnexB( const uint8_t *p, const uint8_t *end )
 {
+#ifdef STARTCODE_AVX2
+    if (vlc_CPU_AVX2())
+        return startcode_FindAnnexB_AVX2(p, end);
+#endif
     if (vlc_CPU_SSE2())
         return startcode_FindAnnexB_SSE2(p, end);
     else
         return startcode_FindAnnexB_Bits(p, end);
 }
+#elif defined(STARTCODE_NEON)
+    #define startcode_FindAnnexB startcode_FindAnnexB_NEON
 #else
     #define startcode_FindAnnexB startcode_FindAnnexB_Bits
 #endif
 
+/* Looks up a 2 bytes audio sync word: the byte b0 followed by a byte equal
+ * to b1 for the bits set in mask. The first byte is looked up with memchr(),
+ * which is vectorized on most targets, instead of peeking byte by byte. */
+static inline const uint8_t * startcode_FindSync16( const uint8_t *p, const uint8_t *end,
+                                                    uint8_t b0, uint8_t b1, uint8_t mask )
+{
+    for (end -= 1; p < end; p++) {
+        p = memchr(p, b0, end - p);
+        if (p == NULL)
+            return NULL;
+        if ((p[1] & mask) == b1)
+            return p;
+    }
+    return NULL;
+}
+
+/* Looks up the next 0x00 0x00 0x03 emulation prevention sequence */
+static inline const uint8_t * startcode_FindEP3B( const uint8_t *p, const uint8_t *end )
+{
+#if defined(STARTCODE_AVX2)
+    if (vlc_CPU_AVX2())
+        return startcode_Find_AVX2(p, end, 3);
+#elif defined(STARTCODE_NEON)
+    return startcode_Find_NEON(p, end, 3);
+#endif
+    /* libc memchr is vectorized on most targets */
+    for (end -= 2; p < end; p++) {
+        p = memchr(p, 0, end - p);
+        if (p == NULL)
+            return NULL;
+        if (p[1] == 0 && p[2] == 3)
+            return p;
+    }
+    return NULL;
+}
+
 #endif
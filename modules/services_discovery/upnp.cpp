@@ -40,6 +40,7 @@
 #include <assert.h>
 #include <limits.h>
 #include <algorithm>
+#include <list>
 #include <set>
 #include <string>
 
@@ -52,6 +53,12 @@ const char* CONTENT_DIRECTORY_SERVICE_TYPE = "urn:schemas-upnp-org:service:Conte
 const char* SATIP_SERVER_DEVICE_TYPE = "urn:ses-com:device:SatIPServer:1";
 
 #define UPNP_SEARCH_TIMEOUT_SECONDS 15
+
+/* Browse paging: some servers don't understand "0" as "no-limit" anyway */
+#define BROWSE_PAGE_SIZE 500
+#define BROWSE_MAX_REQUESTS 4 /* pages requested concurrently */
+#define BROWSE_CACHE_ENTRIES 64
+#define BROWSE_CACHE_SIZE (32 << 20) /* bytes of DIDL-Lite */
 #define SATIP_CHANNEL_LIST N_("SAT>IP channel list")
 #define SATIP_CHANNEL_LIST_URL N_("Custom SAT>IP channel list URL")
 
@@ -183,19 +190,11 @@ vlc_module_begin()
 vlc_module_end()
 
 /*
- * Extracts the result document from a SOAP response
+ * Parses the DIDL-Lite document of a browse result
  */
-IXML_Document* parseBrowseResult( IXML_Document* p_doc )
+IXML_Document* parseBrowseResult( const char* psz_raw_didl )
 {
-    assert( p_doc );
-
-    // ixml*_getElementsByTagName will ultimately only case the pointer to a Node
-    // pointer, and pass it to a private function. Don't bother have a IXML_Document
-    // version of getChildElementValue
-    const char* psz_raw_didl = xml_getChildElementValue( (IXML_Element*)p_doc, "Result" );
-
-    if( !psz_raw_didl )
-        return NULL;
+    assert( psz_raw_didl );
 
     /* First, try parsing the buffer as is */
     IXML_Document* p_result_doc = ixmlParseBuffer( psz_raw_didl );
@@ -1171,16 +1170,19 @@ int MediaServer::sendActionCb( Upnp_EventType eventType,
 }
 
 /* Access part */
-IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
-                                           const char* psz_browser_flag_,
-                                           const char* psz_filter_,
-                                           const char* psz_requested_count_,
-                                           const char* psz_sort_criteria_ )
+Upnp_i11e_cb* MediaServer::_browseAction( const char* psz_object_id_,
+                                          const char* psz_browser_flag_,
+                                          const char* psz_filter_,
+                                          unsigned long i_starting_index_,
+                                          unsigned long i_requested_count_,
+                                          const char* psz_sort_criteria_,
+                                          IXML_Document** pp_response_ )
 {
     IXML_Document* p_action = NULL;
-    IXML_Document* p_response = NULL;
     Upnp_i11e_cb *i11eCb = NULL;
     access_sys_t *sys = (access_sys_t *)m_access->p_sys;
+    const std::string starting_index = std::to_string( i_starting_index_ );
+    const std::string requested_count = std::to_string( i_requested_count_ );
 
     int i_res;
 
@@ -1218,7 +1220,8 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex", "0" );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "StartingIndex",
+            starting_index.c_str() );
     if ( i_res != UPNP_E_SUCCESS )
     {
         msg_Dbg( m_access, "AddToAction 'StartingIndex' failed: %s",
@@ -1227,7 +1230,8 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     }
 
     i_res = UpnpAddToAction( &p_action, "Browse",
-            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount", psz_requested_count_ );
+            CONTENT_DIRECTORY_SERVICE_TYPE, "RequestedCount",
+            requested_count.c_str() );
 
     if ( i_res != UPNP_E_SUCCESS )
     {
@@ -1248,7 +1252,7 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
 
     /* Setup an interruptible callback that will call sendActionCb if not
      * interrupted by vlc_interrupt_kill */
-    i11eCb = new Upnp_i11e_cb( sendActionCb, &p_response );
+    i11eCb = new Upnp_i11e_cb( sendActionCb, pp_response_ );
     i_res = UpnpSendActionAsync( sys->p_upnp->handle(),
               m_psz_root,
               CONTENT_DIRECTORY_SERVICE_TYPE,
@@ -1260,36 +1264,50 @@ IXML_Document* MediaServer::_browseAction( const char* psz_object_id_,
     {
         msg_Err( m_access, "%s when trying the send() action with URL: %s",
                 UpnpGetErrorMessage( i_res ), m_access->psz_location );
+        /* The callback will never run */
+        delete i11eCb;
+        i11eCb = NULL;
     }
-    /* Wait for the callback to fill p_response or wait for an interrupt */
-    i11eCb->waitAndRelease();
 
 browseActionCleanup:
     ixmlDocument_free( p_action );
-    return p_response;
+    /* The caller waits for the callback to fill the response, or for an
+     * interrupt, with Upnp_i11e_cb::waitAndRelease() */
+    return i11eCb;
 }
 
 /*
- * Fetches and parses the UPNP response
+ * Extracts the DIDL-Lite document and the paging information from the SOAP
+ * response of a browse() action
  */
-bool MediaServer::fetchContents()
+bool MediaServer::parseBrowseResponse( IXML_Document* p_response,
+                                       BrowseResult& result )
 {
-    IXML_Document* p_response = _browseAction( m_psz_objectId,
-                                      "BrowseDirectChildren",
-                                      "*",
-                                      // Some servers don't understand "0" as "no-limit"
-                                      "5000", /* RequestedCount */
-                                      "" /* SortCriteria */
-                                      );
-    if ( !p_response )
-    {
-        msg_Err( m_access, "No response from browse() action" );
-        return false;
-    }
+    // ixml*_getElementsByTagName will ultimately only case the pointer to a Node
+    // pointer, and pass it to a private function. Don't bother have a IXML_Document
+    // version of getChildElementValue
+    IXML_Element* p_elem = (IXML_Element*)p_response;
+    const char* psz_didl = xml_getChildElementValue( p_elem, "Result" );
 
-    IXML_Document* p_result = parseBrowseResult( p_response );
+    if ( !psz_didl )
+        return false;
+    result.didl = psz_didl;
+
+    const char* psz = xml_getChildElementValue( p_elem, "NumberReturned" );
+    result.numberReturned = psz ? strtoul( psz, NULL, 10 ) : 0;
+    psz = xml_getChildElementValue( p_elem, "TotalMatches" );
+    result.totalMatches = psz ? strtoul( psz, NULL, 10 ) : 0;
+    psz = xml_getChildElementValue( p_elem, "UpdateID" );
+    result.updateId = psz ? psz : "";
+    return true;
+}
 
-    ixmlDocument_free( p_response );
+/*
+ * Adds the containers and items of a DIDL-Lite document to the node
+ */
+bool MediaServer::addContents( const char* psz_didl )
+{
+    IXML_Document* p_result = parseBrowseResult( psz_didl );
 
     if ( !p_result )
     {
@@ -1323,6 +1341,226 @@ bool MediaServer::fetchContents()
     return true;
 }
 
+namespace
+{
+/*
+ * Browse results of the recently visited containers. Servers bump the
+ * UpdateID of a container whenever its content changes, so going back to an
+ * unchanged container only costs its first page.
+ */
+struct BrowseCacheEntry
+{
+    std::string key; /* server URL and object ID */
+    std::string updateId;
+    unsigned long totalMatches;
+    std::vector<std::string> pages; /* DIDL-Lite documents */
+    size_t size;
+};
+
+vlc::threads::mutex browse_cache_lock;
+std::list<BrowseCacheEntry> browse_cache; /* most recently used first */
+size_t browse_cache_size;
+
+void browseCacheRemove( std::list<BrowseCacheEntry>::iterator it )
+{
+    browse_cache_size -= it->size;
+    browse_cache.erase( it );
+}
+
+/*
+ * Returns the cached pages if the container is unchanged
+ */
+bool browseCacheGet( const std::string& key, const BrowseResult& first,
+                     std::vector<std::string>& pages )
+{
+    vlc::threads::mutex_locker lock( browse_cache_lock );
+
+    auto it = std::find_if( browse_cache.begin(), browse_cache.end(),
+                            [&key]( const BrowseCacheEntry& e ) {
+                                return e.key == key;
+                            } );
+    if ( it == browse_cache.end() )
+        return false;
+
+    /* Some servers always report the same UpdateID, so also compare the
+     * first page, which was transferred anyway. */
+    if ( it->updateId != first.updateId
+      || it->totalMatches != first.totalMatches
+      || it->pages.front() != first.didl )
+    {
+        browseCacheRemove( it );
+        return false;
+    }
+
+    browse_cache.splice( browse_cache.begin(), browse_cache, it );
+    pages = it->pages;
+    return true;
+}
+
+void browseCachePut( BrowseCacheEntry&& entry )
+{
+    entry.size = 0;
+    for ( const auto& page : entry.pages )
+        entry.size += page.size();
+    if ( entry.pages.empty() || entry.size > BROWSE_CACHE_SIZE )
+        return;
+
+    vlc::threads::mutex_locker lock( browse_cache_lock );
+
+    auto it = std::find_if( browse_cache.begin(), browse_cache.end(),
+                            [&entry]( const BrowseCacheEntry& e ) {
+                                return e.key == entry.key;
+                            } );
+    if ( it != browse_cache.end() )
+        browseCacheRemove( it );
+
+    while ( !browse_cache.empty()
+         && ( browse_cache.size() >= BROWSE_CACHE_ENTRIES
+           || browse_cache_size + entry.size > BROWSE_CACHE_SIZE ) )
+        browseCacheRemove( std::prev( browse_cache.end() ) );
+
+    browse_cache_size += entry.size;
+    browse_cache.push_front( std::move( entry ) );
+}
+
+} // namespace
+
+/*
+ * Fetches the container one page at a time, so that large containers are
+ * neither truncated nor parsed as a single huge document
+ */
+bool MediaServer::fetchContents()
+{
+    const char* psz_object_id = m_psz_objectId ? m_psz_objectId : "0";
+    IXML_Document* p_response = NULL;
+    BrowseResult first;
+
+    Upnp_i11e_cb* i11eCb = _browseAction( psz_object_id,
+                                          "BrowseDirectChildren",
+                                          "*",
+                                          0, /* StartingIndex */
+                                          BROWSE_PAGE_SIZE, /* RequestedCount */
+                                          "", /* SortCriteria */
+                                          &p_response );
+    if ( i11eCb )
+        i11eCb->waitAndRelease();
+    if ( !p_response )
+    {
+        msg_Err( m_access, "No response from browse() action" );
+        return false;
+    }
+
+    bool b_ok = parseBrowseResponse( p_response, first );
+    ixmlDocument_free( p_response );
+    if ( !b_ok )
+    {
+        msg_Err( m_access, "browse() response parsing failed" );
+        return false;
+    }
+
+    BrowseCacheEntry entry;
+    entry.key = std::string( m_psz_root ) + '\n' + psz_object_id;
+    entry.updateId = first.updateId;
+    entry.totalMatches = first.totalMatches;
+
+    if ( !first.updateId.empty() && browseCacheGet( entry.key, first, entry.pages ) )
+    {
+        msg_Dbg( m_access, "container %s unchanged (update %s), "
+                 "using %zu cached page(s)", psz_object_id,
+                 first.updateId.c_str(), entry.pages.size() );
+        for ( const auto& page : entry.pages )
+            addContents( page.c_str() );
+        return true;
+    }
+
+    if ( !addContents( first.didl.c_str() ) )
+        return false;
+
+    const unsigned long total = first.totalMatches; /* 0 if unknown */
+    /* Do not ask for more than the server is willing to return */
+    const unsigned long count = first.numberReturned;
+    unsigned long index = first.numberReturned;
+    bool b_complete = count == 0 || ( total != 0 && index >= total );
+    bool b_cacheable = !first.updateId.empty();
+
+    entry.pages.push_back( std::move( first.didl ) );
+
+    while ( !b_complete )
+    {
+        IXML_Document* responses[BROWSE_MAX_REQUESTS] = { };
+        Upnp_i11e_cb* requests[BROWSE_MAX_REQUESTS];
+        unsigned n = 1;
+
+        /* With a known total, the following pages are requested at once */
+        if ( total != 0 )
+            n = std::min<unsigned long>( BROWSE_MAX_REQUESTS,
+                                         ( total - index + count - 1 ) / count );
+
+        for ( unsigned i = 0; i < n; i++ )
+            requests[i] = _browseAction( psz_object_id, "BrowseDirectChildren",
+                                         "*", index + i * count, count, "",
+                                         &responses[i] );
+
+        bool b_error = false;
+        bool b_discard = false; /* the remaining pages are out of sequence */
+        for ( unsigned i = 0; i < n; i++ )
+        {
+            BrowseResult page;
+            bool b_page = false;
+
+            if ( requests[i] )
+                requests[i]->waitAndRelease();
+            if ( responses[i] )
+            {
+                if ( !b_discard )
+                    b_page = parseBrowseResponse( responses[i], page );
+                ixmlDocument_free( responses[i] );
+            }
+            if ( b_discard )
+                continue;
+            b_discard = true;
+
+            if ( !b_page )
+            {
+                msg_Err( m_access, "No valid response from browse() action" );
+                b_error = true;
+                continue;
+            }
+            if ( page.numberReturned == 0 )
+            {
+                b_complete = true;
+                continue;
+            }
+            if ( page.updateId != entry.updateId )
+                b_cacheable = false; /* changed while browsing */
+            if ( !addContents( page.didl.c_str() ) )
+            {
+                b_error = true;
+                continue;
+            }
+            entry.pages.push_back( std::move( page.didl ) );
+            index += page.numberReturned;
+
+            if ( total != 0 ? index >= total : page.numberReturned < count )
+                b_complete = true;
+            else
+                /* After a short page, the next requests started at the wrong
+                 * index: drop them and carry on from where this one ended. */
+                b_discard = page.numberReturned < count;
+        }
+
+        if ( b_error )
+            break;
+    }
+
+    if ( !b_complete )
+        msg_Warn( m_access, "container %s truncated at %lu of %lu entries",
+                  psz_object_id, index, total );
+    else if ( b_cacheable )
+        browseCachePut( std::move( entry ) );
+    return true;
+}
+
 static int ReadDirectory( stream_t *p_access, input_item_node_t* p_node )
 {
     MediaServer server( p_access, p_node );
@@ -98,6 +98,14 @@ private:
     void*           m_cookie;
 };
 
+struct BrowseResult
+{
+    std::string didl; /* DIDL-Lite document */
+    unsigned long numberReturned;
+    unsigned long totalMatches; /* 0 if unknown */
+    std::string updateId; /* empty if not provided by the server */
+};
+
 class MediaServer
 {
 public:
@@ -112,8 +120,12 @@ private:
     bool addContainer( IXML_Element* containerElement );
     bool addItem( IXML_Element* itemElement );
 
-    IXML_Document* _browseAction(const char*, const char*,
-            const char*, const char*, const char* );
+    bool addContents( const char* psz_didl );
+
+    Upnp_i11e_cb* _browseAction(const char*, const char*,
+            const char*, unsigned long, unsigned long, const char*,
+            IXML_Document** );
+    bool parseBrowseResponse( IXML_Document*, BrowseResult& );
     static int sendActionCb( Upnp_EventType, UpnpEventPtr, void *);
 
 private:
@@ -36,6 +36,7 @@
 #include <vlc_filter.h>
 #include <vlc_image.h>
 #include <vlc_subpicture.h>
+#include <vlc_executor.h>
 
 #include "mosaic.h"
 
@@ -54,11 +55,40 @@ static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
+
+/* Conversion state of a bridged picture stream, kept across frames so that
+ * a picture is only converted once, however many frames it is shown. */
+typedef struct
+{
+    const bridged_es_t *p_es;    /* only compared, may be stale */
+    image_handler_t *p_image;
+    picture_t *p_source;         /* last converted picture */
+    picture_t *p_converted;
+    video_format_t fmt_out;      /* format of p_converted */
+    bool b_used;                 /* shown in the current frame */
+} mosaic_tile_t;
+
+/* One miniature of the current frame */
+typedef struct
+{
+    mosaic_tile_t *p_tile;       /* NULL with keep-picture */
+    picture_t *p_picture;        /* bridged picture */
+    video_format_t fmt_in;
+    video_format_t fmt_out;
+    bool b_convert;
+    int i_real_index, i_row, i_col;
+    int i_x, i_y, i_alpha;
+} mosaic_job_t;
+
 typedef struct
 {
     vlc_mutex_t lock;         /* Internal filter lock */
 
-    image_handler_t *p_image;
+    vlc_executor_t *executor; /* Miniatures are converted in parallel */
+    int i_tiles;
+    mosaic_tile_t **pp_tiles;
+    mosaic_job_t *p_jobs;
+    size_t i_jobs_max;
 
     int i_position;           /* Mosaic positioning method */
     bool b_ar;          /* Do we keep the aspect ratio ? */
@@ -328,10 +358,10 @@ static int CreateFilter( vlc_object_t *p_this )
 
     p_sys->b_keep = var_CreateGetBoolCommand( p_filter,
                                               CFG_PREFIX "keep-picture" );
-    if ( !p_sys->b_keep )
-    {
-        p_sys->p_image = image_HandlerCreate( p_filter );
-    }
+    p_sys->executor = vlc_executor_Get( p_filter );
+    TAB_INIT( p_sys->i_tiles, p_sys->pp_tiles );
+    p_sys->p_jobs = NULL;
+    p_sys->i_jobs_max = 0;
 
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
@@ -372,6 +402,80 @@ static int CreateFilter( vlc_object_t *p_this )
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * Miniature conversion cache
+ *****************************************************************************/
+static void TileDelete( mosaic_tile_t *p_tile )
+{
+    if( p_tile->p_image )
+        image_HandlerDelete( p_tile->p_image );
+    if( p_tile->p_source )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_converted )
+        picture_Release( p_tile->p_converted );
+    free( p_tile );
+}
+
+static mosaic_tile_t *TileGet( filter_t *p_filter, const bridged_es_t *p_es )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+        if( p_sys->pp_tiles[i]->p_es == p_es )
+            return p_sys->pp_tiles[i];
+
+    mosaic_tile_t *p_tile = calloc( 1, sizeof( *p_tile ) );
+    if( unlikely(p_tile == NULL) )
+        return NULL;
+    p_tile->p_es = p_es;
+    p_tile->p_image = image_HandlerCreate( p_filter );
+    if( p_tile->p_image == NULL )
+    {
+        free( p_tile );
+        return NULL;
+    }
+    TAB_APPEND( p_sys->i_tiles, p_sys->pp_tiles, p_tile );
+    return p_tile;
+}
+
+/* Forgets the streams that were not shown in the current frame */
+static void TilesPurge( filter_sys_t *p_sys )
+{
+    for( int i = p_sys->i_tiles - 1; i >= 0; i-- )
+    {
+        mosaic_tile_t *p_tile = p_sys->pp_tiles[i];
+
+        if( !p_tile->b_used )
+        {
+            TileDelete( p_tile );
+            TAB_ERASE( p_sys->i_tiles, p_sys->pp_tiles, i );
+        }
+        else
+            p_tile->b_used = false;
+    }
+}
+
+/* Runs on the executor: each job has its own image handler */
+static void ConvertTile( void *opaque, size_t i )
+{
+    mosaic_job_t *p_job = &((mosaic_job_t *)opaque)[i];
+    mosaic_tile_t *p_tile = p_job->p_tile;
+
+    if( !p_job->b_convert )
+        return;
+
+    if( p_tile->p_source )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_converted )
+        picture_Release( p_tile->p_converted );
+
+    p_tile->p_converted = image_Convert( p_tile->p_image, p_job->p_picture,
+                                         &p_job->fmt_in, &p_job->fmt_out );
+    p_tile->p_source = p_tile->p_converted ? picture_Hold( p_job->p_picture )
+                                           : NULL;
+    p_tile->fmt_out = p_job->fmt_out;
+}
+
 /*****************************************************************************
  * DestroyFilter: destroy mosaic video filter
  *****************************************************************************/
@@ -401,10 +505,10 @@ static void DestroyFilter( vlc_object_t *p_this )
     DEL_CB( order );
 #undef DEL_CB
 
-    if( !p_sys->b_keep )
-    {
-        image_HandlerDelete( p_sys->p_image );
-    }
+    for( int i = 0; i < p_sys->i_tiles; i++ )
+        TileDelete( p_sys->pp_tiles[i] );
+    TAB_CLEAN( p_sys->i_tiles, p_sys->pp_tiles );
+    free( p_sys->p_jobs );
 
     if( p_sys->i_order_length )
     {
@@ -432,7 +536,7 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
     filter_sys_t *p_sys = p_filter->p_sys;
     bridge_t *p_bridge;
 
-    int i_real_index, i_row, i_col;
+    int i_real_index;
     int i_greatest_real_index_used = p_sys->i_order_length - 1;
 
     unsigned int col_inner_width, row_inner_height;
@@ -520,11 +624,28 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
 
     i_real_index = 0;
 
+    if( p_sys->i_jobs_max < (size_t)p_bridge->i_es_num )
+    {
+        mosaic_job_t *p_jobs = realloc( p_sys->p_jobs,
+                                        p_bridge->i_es_num * sizeof( *p_jobs ) );
+        if( p_jobs == NULL )
+        {
+            vlc_global_unlock( VLC_MOSAIC_MUTEX );
+            vlc_mutex_unlock( &p_sys->lock );
+            return p_spu;
+        }
+        p_sys->p_jobs = p_jobs;
+        p_sys->i_jobs_max = p_bridge->i_es_num;
+    }
+
+    size_t i_jobs = 0, i_converts = 0;
+
+    /* Lay the miniatures out */
     for( int i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
     {
         bridged_es_t *p_es = p_bridge->pp_es[i_index];
-        video_format_t fmt_in, fmt_out;
-        picture_t *p_converted;
+        mosaic_job_t *p_job = &p_sys->p_jobs[i_jobs];
+        video_format_t *p_fmt_in = &p_job->fmt_in, *p_fmt_out = &p_job->fmt_out;
 
         if ( p_es->b_empty )
             continue;
@@ -578,93 +699,130 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             if ( i == p_sys->i_order_length )
                 i_real_index = ++i_greatest_real_index_used;
         }
-        i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
-        i_col = i_real_index % p_sys->i_cols ;
-
-        video_format_Init( &fmt_in, 0 );
-        video_format_Init( &fmt_out, 0 );
+        p_job->i_real_index = i_real_index;
+        p_job->i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
+        p_job->i_col = i_real_index % p_sys->i_cols ;
+        p_job->i_x = p_es->i_x;
+        p_job->i_y = p_es->i_y;
+        p_job->i_alpha = p_es->i_alpha;
+        p_job->p_picture = p_es->p_picture;
+        p_job->p_tile = NULL;
+        p_job->b_convert = false;
+
+        video_format_Init( p_fmt_in, 0 );
+        video_format_Init( p_fmt_out, 0 );
 
         if ( !p_sys->b_keep )
         {
             /* Convert the images */
-            fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
-            fmt_in.i_height = p_es->p_picture->format.i_height;
-            fmt_in.i_width = p_es->p_picture->format.i_width;
+            p_fmt_in->i_chroma = p_es->p_picture->format.i_chroma;
+            p_fmt_in->i_height = p_es->p_picture->format.i_height;
+            p_fmt_in->i_width = p_es->p_picture->format.i_width;
 
-            if( fmt_in.i_chroma == VLC_CODEC_YUVA ||
-                fmt_in.i_chroma == VLC_CODEC_RGBA )
-                fmt_out.i_chroma = VLC_CODEC_YUVA;
+            if( p_fmt_in->i_chroma == VLC_CODEC_YUVA ||
+                p_fmt_in->i_chroma == VLC_CODEC_RGBA )
+                p_fmt_out->i_chroma = VLC_CODEC_YUVA;
             else
-                fmt_out.i_chroma = VLC_CODEC_I420;
-            fmt_out.i_width = col_inner_width;
-            fmt_out.i_height = row_inner_height;
+                p_fmt_out->i_chroma = VLC_CODEC_I420;
+            p_fmt_out->i_width = col_inner_width;
+            p_fmt_out->i_height = row_inner_height;
 
             if( p_sys->b_ar ) /* keep aspect ratio */
             {
-                if( (float)fmt_out.i_width / (float)fmt_out.i_height
-                      > (float)fmt_in.i_width / (float)fmt_in.i_height )
+                if( (float)p_fmt_out->i_width / (float)p_fmt_out->i_height
+                      > (float)p_fmt_in->i_width / (float)p_fmt_in->i_height )
                 {
-                    fmt_out.i_width = ( fmt_out.i_height * fmt_in.i_width )
-                                         / fmt_in.i_height;
+                    p_fmt_out->i_width = ( p_fmt_out->i_height * p_fmt_in->i_width )
+                                         / p_fmt_in->i_height;
                 }
                 else
                 {
-                    fmt_out.i_height = ( fmt_out.i_width * fmt_in.i_height )
-                                        / fmt_in.i_width;
+                    p_fmt_out->i_height = ( p_fmt_out->i_width * p_fmt_in->i_height )
+                                        / p_fmt_in->i_width;
                 }
              }
 
-            fmt_out.i_visible_width = fmt_out.i_width;
-            fmt_out.i_visible_height = fmt_out.i_height;
+            p_fmt_out->i_visible_width = p_fmt_out->i_width;
+            p_fmt_out->i_visible_height = p_fmt_out->i_height;
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
-            {
-                msg_Warn( p_filter,
-                           "image resizing and chroma conversion failed" );
-                video_format_Clean( &fmt_in );
-                video_format_Clean( &fmt_out );
+            /* Only pictures that changed since the previous frame, or whose
+             * miniature changed size, need to be converted again */
+            mosaic_tile_t *p_tile = TileGet( p_filter, p_es );
+            if( p_tile == NULL )
                 continue;
-            }
+            p_tile->b_used = true;
+            p_job->p_tile = p_tile;
+            p_job->b_convert = p_tile->p_converted == NULL
+                || p_tile->p_source != p_es->p_picture
+                || p_tile->fmt_out.i_chroma != p_fmt_out->i_chroma
+                || p_tile->fmt_out.i_width != p_fmt_out->i_width
+                || p_tile->fmt_out.i_height != p_fmt_out->i_height;
+            if( p_job->b_convert )
+                i_converts++;
         }
         else
         {
-            p_converted = p_es->p_picture;
-            fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
-            fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
-            fmt_in.i_chroma = fmt_out.i_chroma = p_converted->format.i_chroma;
-            fmt_out.i_visible_width = fmt_out.i_width;
-            fmt_out.i_visible_height = fmt_out.i_height;
+            picture_t *p_pic = p_es->p_picture;
+            p_fmt_in->i_width = p_fmt_out->i_width = p_pic->format.i_width;
+            p_fmt_in->i_height = p_fmt_out->i_height = p_pic->format.i_height;
+            p_fmt_in->i_chroma = p_fmt_out->i_chroma = p_pic->format.i_chroma;
+            p_fmt_out->i_visible_width = p_fmt_out->i_width;
+            p_fmt_out->i_visible_height = p_fmt_out->i_height;
+        }
+        i_jobs++;
+    }
+
+    /* Resize and convert the new pictures in parallel */
+    if( i_converts > 1 )
+        vlc_executor_ParallelFor( p_sys->executor, i_jobs, ConvertTile,
+                                  p_sys->p_jobs );
+    else if( i_converts > 0 )
+        for( size_t i = 0; i < i_jobs; i++ )
+            ConvertTile( p_sys->p_jobs, i );
+
+    for( size_t i = 0; i < i_jobs; i++ )
+    {
+        mosaic_job_t *p_job = &p_sys->p_jobs[i];
+        video_format_t fmt_out = p_job->fmt_out;
+        picture_t *p_converted = p_job->p_picture;
+        int i_row = p_job->i_row, i_col = p_job->i_col;
+
+        if( p_job->p_tile != NULL )
+        {
+            p_converted = p_job->p_tile->p_converted;
+            if( p_converted == NULL )
+            {
+                if( p_job->b_convert )
+                    msg_Warn( p_filter,
+                              "image resizing and chroma conversion failed" );
+                continue;
+            }
         }
 
         p_region = subpicture_region_New( &fmt_out );
-        /* FIXME the copy is probably not needed anymore */
+        /* The converted picture is kept for the next frames */
         if( p_region )
             picture_Copy( p_region->p_picture, p_converted );
-        if( !p_sys->b_keep )
-            picture_Release( p_converted );
 
         if( !p_region )
         {
-            video_format_Clean( &fmt_in );
-            video_format_Clean( &fmt_out );
             msg_Err( p_filter, "cannot allocate SPU region" );
             subpicture_Delete( p_spu );
+            TilesPurge( p_sys );
             vlc_global_unlock( VLC_MOSAIC_MUTEX );
             vlc_mutex_unlock( &p_sys->lock );
             return NULL;
         }
 
-        if( p_es->i_x >= 0 && p_es->i_y >= 0 )
+        if( p_job->i_x >= 0 && p_job->i_y >= 0 )
         {
-            p_region->i_x = p_es->i_x;
-            p_region->i_y = p_es->i_y;
+            p_region->i_x = p_job->i_x;
+            p_region->i_y = p_job->i_y;
         }
         else if( p_sys->i_position == position_offsets )
         {
-            p_region->i_x = p_sys->pi_x_offsets[i_real_index];
-            p_region->i_y = p_sys->pi_y_offsets[i_real_index];
+            p_region->i_x = p_sys->pi_x_offsets[p_job->i_real_index];
+            p_region->i_y = p_sys->pi_y_offsets[p_job->i_real_index];
         }
         else
         {
@@ -705,7 +863,7 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             }
         }
         p_region->i_align = p_sys->i_align;
-        p_region->i_alpha = p_es->i_alpha;
+        p_region->i_alpha = p_job->i_alpha;
 
         if( p_region_prev == NULL )
         {
@@ -716,12 +874,10 @@ static subpicture_t *Filter( filter_t *p_filter, vlc_tick_t date )
             p_region_prev->p_next = p_region;
         }
 
-        video_format_Clean( &fmt_in );
-        video_format_Clean( &fmt_out );
-
         p_region_prev = p_region;
     }
 
+    TilesPurge( p_sys );
     vlc_global_unlock( VLC_MOSAIC_MUTEX );
     vlc_mutex_unlock( &p_sys->lock );
 
@@ -918,10 +1074,6 @@ static int MosaicCallback( vlc_object_t *p_this, char const *psz_var,
     {
         vlc_mutex_lock( &p_sys->lock );
         p_sys->b_keep = newval.b_bool;
-        if ( !p_sys->b_keep && !p_sys->p_image )
-        {
-            p_sys->p_image = image_HandlerCreate( p_this );
-        }
         vlc_mutex_unlock( &p_sys->lock );
     }
 
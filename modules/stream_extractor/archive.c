@@ -82,6 +82,19 @@ struct private_sys_t
 
     libarchive_callback_t** pp_callback_data;
     size_t i_callback_data;
+
+    /* stored (uncompressed) entry, read straight from the source */
+    struct
+    {
+        bool b_enabled;
+        bool b_positioned;
+        uint64_t i_start;
+        uint64_t i_size;
+    } direct;
+
+    /* stored entries seen while scanning, see archive_index_publish() */
+    struct archive_index_entry* p_index;
+    size_t i_index;
 };
 
 struct libarchive_callback_t {
@@ -92,6 +105,171 @@ struct libarchive_callback_t {
 
 /* ------------------------------------------------------------------------- */
 
+/* Directory of the stored entries of the recently opened archives, so that
+ * opening a sibling entry does not scan the archive again. */
+
+#define ARCHIVE_INDEX_CACHE_SIZE 4
+
+struct archive_index_entry
+{
+    char* psz_path;
+    uint64_t i_offset;
+    uint64_t i_size;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned i_next;
+    struct
+    {
+        char* psz_url;
+        uint64_t i_source_size;
+        struct archive_index_entry* p_entries;
+        size_t i_entries;
+    } slots[ ARCHIVE_INDEX_CACHE_SIZE ];
+} archive_index_cache = { .lock = VLC_STATIC_MUTEX };
+
+static bool archive_index_key( stream_t* source, uint64_t* pi_size )
+{
+    return source->psz_url != NULL && !vlc_stream_GetSize( source, pi_size );
+}
+
+static bool archive_index_lookup( stream_t* source, char const* psz_path,
+  uint64_t* pi_offset, uint64_t* pi_size )
+{
+    uint64_t i_source_size;
+    bool b_found = false;
+
+    if( !archive_index_key( source, &i_source_size ) )
+        return false;
+
+    vlc_mutex_lock( &archive_index_cache.lock );
+    for( size_t i = 0; i < ARCHIVE_INDEX_CACHE_SIZE && !b_found; ++i )
+    {
+        if( archive_index_cache.slots[i].psz_url == NULL
+         || archive_index_cache.slots[i].i_source_size != i_source_size
+         || strcmp( archive_index_cache.slots[i].psz_url, source->psz_url ) )
+            continue;
+
+        for( size_t j = 0; j < archive_index_cache.slots[i].i_entries; ++j )
+        {
+            struct archive_index_entry* p_entry =
+                &archive_index_cache.slots[i].p_entries[j];
+
+            if( strcmp( p_entry->psz_path, psz_path ) == 0 )
+            {
+                *pi_offset = p_entry->i_offset;
+                *pi_size = p_entry->i_size;
+                b_found = true;
+                break;
+            }
+        }
+    }
+    vlc_mutex_unlock( &archive_index_cache.lock );
+    return b_found;
+}
+
+static void archive_index_add( private_sys_t* p_sys, char const* psz_path,
+  uint64_t i_offset, uint64_t i_size )
+{
+    for( size_t i = 0; i < p_sys->i_index; ++i )
+        if( strcmp( p_sys->p_index[i].psz_path, psz_path ) == 0 )
+            return;
+
+    struct archive_index_entry* p_index = realloc( p_sys->p_index,
+      sizeof( *p_index ) * ( p_sys->i_index + 1 ) );
+
+    if( unlikely( !p_index ) )
+        return;
+
+    p_sys->p_index = p_index;
+    p_index[ p_sys->i_index ].psz_path = strdup( psz_path );
+    p_index[ p_sys->i_index ].i_offset = i_offset;
+    p_index[ p_sys->i_index ].i_size = i_size;
+
+    if( likely( p_index[ p_sys->i_index ].psz_path ) )
+        p_sys->i_index++;
+}
+
+/* Merges the stored entries seen by this instance into the cache */
+static void archive_index_publish( private_sys_t* p_sys )
+{
+    uint64_t i_source_size;
+
+    if( p_sys->i_index == 0
+     || !archive_index_key( p_sys->source, &i_source_size ) )
+        return;
+
+    vlc_mutex_lock( &archive_index_cache.lock );
+
+    size_t i_slot = ARCHIVE_INDEX_CACHE_SIZE;
+    for( size_t i = 0; i < ARCHIVE_INDEX_CACHE_SIZE; ++i )
+    {
+        if( archive_index_cache.slots[i].psz_url != NULL
+         && archive_index_cache.slots[i].i_source_size == i_source_size
+         && !strcmp( archive_index_cache.slots[i].psz_url,
+                     p_sys->source->psz_url ) )
+        {
+            i_slot = i;
+            break;
+        }
+    }
+
+    if( i_slot == ARCHIVE_INDEX_CACHE_SIZE )
+    {
+        /* replace the oldest archive */
+        char* psz_url = strdup( p_sys->source->psz_url );
+
+        if( unlikely( !psz_url ) )
+            goto out;
+
+        i_slot = archive_index_cache.i_next;
+        archive_index_cache.i_next =
+            ( i_slot + 1 ) % ARCHIVE_INDEX_CACHE_SIZE;
+
+        free( archive_index_cache.slots[i_slot].psz_url );
+        for( size_t j = 0; j < archive_index_cache.slots[i_slot].i_entries; ++j )
+            free( archive_index_cache.slots[i_slot].p_entries[j].psz_path );
+        free( archive_index_cache.slots[i_slot].p_entries );
+
+        archive_index_cache.slots[i_slot].psz_url = psz_url;
+        archive_index_cache.slots[i_slot].i_source_size = i_source_size;
+        archive_index_cache.slots[i_slot].p_entries = NULL;
+        archive_index_cache.slots[i_slot].i_entries = 0;
+    }
+
+    for( size_t i = 0; i < p_sys->i_index; ++i )
+    {
+        struct archive_index_entry* p_entries =
+            archive_index_cache.slots[i_slot].p_entries;
+        size_t i_entries = archive_index_cache.slots[i_slot].i_entries;
+        bool b_known = false;
+
+        for( size_t j = 0; j < i_entries && !b_known; ++j )
+            b_known = !strcmp( p_entries[j].psz_path,
+                               p_sys->p_index[i].psz_path );
+        if( b_known )
+            continue;
+
+        p_entries = realloc( p_entries, sizeof( *p_entries ) * ( i_entries + 1 ) );
+        if( unlikely( !p_entries ) )
+            break;
+
+        /* hand the path over to the cache */
+        p_entries[ i_entries ] = p_sys->p_index[i];
+        p_sys->p_index[i].psz_path = NULL;
+
+        archive_index_cache.slots[i_slot].p_entries = p_entries;
+        archive_index_cache.slots[i_slot].i_entries = i_entries + 1;
+    }
+
+out:
+    vlc_mutex_unlock( &archive_index_cache.lock );
+}
+
+/* ------------------------------------------------------------------------- */
+
 static int libarchive_exit_cb( libarchive_t* p_arc, void* p_obj )
 {
     VLC_UNUSED( p_arc );
@@ -334,6 +512,78 @@ static int archive_clean( private_sys_t* p_sys )
     return VLC_SUCCESS;
 }
 
+/**
+ * Returns the offset of the data of the current entry within the source
+ * stream, if it is stored as is (no compression, encryption or holes), or
+ * UINT64_MAX.
+ */
+static uint64_t archive_entry_stored_offset( private_sys_t* p_sys,
+  struct archive_entry* entry )
+{
+    libarchive_t* p_arc = p_sys->p_archive;
+
+    if( p_sys->i_callback_data != 1
+     || archive_filter_count( p_arc ) != 1
+     || archive_filter_code( p_arc, 0 ) != ARCHIVE_FILTER_NONE
+     || archive_entry_filetype( entry ) != AE_IFREG
+     || !archive_entry_size_is_set( entry )
+     || archive_entry_sparse_count( entry ) > 0 )
+        return UINT64_MAX;
+
+#if ARCHIVE_VERSION_NUMBER >= 3002000
+    if( archive_entry_is_encrypted( entry ) )
+        return UINT64_MAX;
+#endif
+
+    switch( archive_format( p_arc ) & ARCHIVE_FORMAT_BASE_MASK )
+    {
+        case ARCHIVE_FORMAT_TAR:
+        case ARCHIVE_FORMAT_CPIO:
+            break;
+
+        case ARCHIVE_FORMAT_ZIP:
+        {
+            /* the format name reflects the method of the current entry */
+            char const* psz_format = archive_format_name( p_arc );
+
+            if( psz_format == NULL || !strstr( psz_format, "(uncompressed)" ) )
+                return UINT64_MAX;
+            break;
+        }
+
+        default:
+            return UINT64_MAX;
+    }
+
+    /* the header has just been consumed: the data follows */
+    la_int64_t i_offset = archive_filter_bytes( p_arc, 0 );
+    uint64_t i_source_size;
+
+    if( i_offset < 0 )
+        return UINT64_MAX;
+
+    if( !vlc_stream_GetSize( p_sys->source, &i_source_size )
+     && (uint64_t)i_offset + archive_entry_size( entry ) > i_source_size )
+        return UINT64_MAX;
+
+    return i_offset;
+}
+
+static void archive_index_visit( private_sys_t* p_sys,
+  struct archive_entry* entry )
+{
+    char const* psz_path = archive_entry_pathname( entry );
+    uint64_t i_offset;
+
+    if( psz_path == NULL )
+        return;
+
+    i_offset = archive_entry_stored_offset( p_sys, entry );
+    if( i_offset != UINT64_MAX )
+        archive_index_add( p_sys, psz_path, i_offset,
+                           archive_entry_size( entry ) );
+}
+
 static int archive_seek_subentry( private_sys_t* p_sys, char const* psz_subentry )
 {
     libarchive_t* p_arc = p_sys->p_archive;
@@ -345,13 +595,23 @@ static int archive_seek_subentry( private_sys_t* p_sys, char const* psz_subentry
     {
         char const* entry_path = archive_entry_pathname( entry );
 
-        if( strcmp( entry_path, psz_subentry ) == 0 )
+        archive_index_visit( p_sys, entry );
+
+        if( entry_path && strcmp( entry_path, psz_subentry ) == 0 )
         {
             p_sys->p_entry = archive_entry_clone( entry );
 
             if( unlikely( !p_sys->p_entry ) )
                 return VLC_ENOMEM;
 
+            uint64_t i_offset = archive_entry_stored_offset( p_sys, entry );
+            if( i_offset != UINT64_MAX && p_sys->b_seekable_source )
+            {
+                p_sys->direct.b_enabled = true;
+                p_sys->direct.b_positioned = false;
+                p_sys->direct.i_start = i_offset;
+                p_sys->direct.i_size = archive_entry_size( entry );
+            }
             break;
         }
 
@@ -498,6 +758,8 @@ static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
     switch( i_query )
     {
         case STREAM_CAN_FASTSEEK:
+            if( p_sys->direct.b_enabled )
+                return vlc_stream_vaControl( p_extractor->source, i_query, args );
             *va_arg( args, bool* ) = false;
             break;
 
@@ -506,6 +768,12 @@ static int Control( stream_extractor_t* p_extractor, int i_query, va_list args )
             break;
 
         case STREAM_GET_SIZE:
+            if( p_sys->direct.b_enabled )
+            {
+                *va_arg( args, uint64_t* ) = p_sys->direct.i_size;
+                break;
+            }
+
             if( p_sys->p_entry == NULL )
                 return VLC_EGENERIC;
 
@@ -537,6 +805,8 @@ static int ReadDir( stream_directory_t* p_directory, input_item_node_t* p_node )
         if( archive_entry_filetype( entry ) == AE_IFDIR )
             continue;
 
+        archive_index_visit( p_sys, entry );
+
         char const* path = archive_entry_pathname( entry );
 
         if( unlikely( !path ) )
@@ -560,9 +830,37 @@ static int ReadDir( stream_directory_t* p_directory, input_item_node_t* p_node )
     }
 
     vlc_readdir_helper_finish( &rdh, archive_status == ARCHIVE_EOF );
+    archive_index_publish( p_sys );
     return archive_status == ARCHIVE_EOF ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
+static ssize_t ReadDirect( stream_extractor_t *p_extractor, void* p_data,
+  size_t i_size )
+{
+    private_sys_t* p_sys = p_extractor->p_sys;
+
+    if( p_sys->i_offset >= p_sys->direct.i_size )
+        return 0;
+
+    i_size = __MIN( i_size, p_sys->direct.i_size - p_sys->i_offset );
+
+    if( !p_sys->direct.b_positioned )
+    {
+        if( vlc_stream_Seek( p_extractor->source,
+                             p_sys->direct.i_start + p_sys->i_offset ) )
+            return -1;
+
+        p_sys->direct.b_positioned = true;
+    }
+
+    ssize_t i_ret = vlc_stream_Read( p_extractor->source, p_data, i_size );
+
+    if( i_ret > 0 )
+        p_sys->i_offset += i_ret;
+
+    return i_ret;
+}
+
 static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_size )
 {
     char dummy_buffer[ 8192 ];
@@ -571,6 +869,9 @@ static ssize_t Read( stream_extractor_t *p_extractor, void* p_data, size_t i_siz
     libarchive_t* p_arc = p_sys->p_archive;
     ssize_t       i_ret;
 
+    if( p_sys->direct.b_enabled )
+        return ReadDirect( p_extractor, p_data, i_size );
+
     if( p_sys->b_dead || p_sys->p_entry == NULL )
         return 0;
 
@@ -627,6 +928,14 @@ static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
 {
     private_sys_t* p_sys = p_extractor->p_sys;
 
+    if( p_sys->direct.b_enabled )
+    {
+        /* the source is positioned on the next read */
+        p_sys->i_offset = i_req;
+        p_sys->direct.b_positioned = false;
+        return VLC_SUCCESS;
+    }
+
     if( !p_sys->p_entry || !p_sys->b_seekable_source )
         return VLC_EGENERIC;
 
@@ -672,9 +981,15 @@ static int Seek( stream_extractor_t* p_extractor, uint64_t i_req )
 
 static void CommonClose( private_sys_t* p_sys )
 {
+    archive_index_publish( p_sys );
+
     p_sys->b_dead = true;
     archive_clean( p_sys );
 
+    for( size_t i = 0; i < p_sys->i_index; ++i )
+        free( p_sys->p_index[i].psz_path );
+    free( p_sys->p_index );
+
     for( size_t i = 0; i < p_sys->i_callback_data; ++i )
     {
         free( p_sys->pp_callback_data[i]->psz_url );
@@ -733,7 +1048,29 @@ static int DirectoryOpen( vlc_object_t* p_obj )
 static int ExtractorOpen( vlc_object_t* p_obj )
 {
     stream_extractor_t* p_extractor = (void*)p_obj;
-    private_sys_t* p_sys = CommonOpen( p_obj, p_extractor->source );
+    private_sys_t* p_sys;
+    uint64_t i_offset, i_size;
+    bool b_seekable;
+
+    /* A stored entry of a known archive does not need libarchive at all */
+    if( !vlc_stream_Control( p_extractor->source, STREAM_CAN_SEEK, &b_seekable )
+     && b_seekable
+     && archive_index_lookup( p_extractor->source, p_extractor->identifier,
+                              &i_offset, &i_size )
+     && ( p_sys = setup( p_obj, p_extractor->source ) ) != NULL )
+    {
+        msg_Dbg( p_obj, "reading stored entry %s at offset %"PRIu64,
+                 p_extractor->identifier, i_offset );
+
+        p_sys->b_seekable_source = true;
+        p_sys->direct.b_enabled = true;
+        p_sys->direct.b_positioned = false;
+        p_sys->direct.i_start = i_offset;
+        p_sys->direct.i_size = i_size;
+        goto done;
+    }
+
+    p_sys = CommonOpen( p_obj, p_extractor->source );
 
     if( p_sys == NULL )
         return VLC_EGENERIC;
@@ -744,6 +1081,11 @@ static int ExtractorOpen( vlc_object_t* p_obj )
         return VLC_EGENERIC;
     }
 
+    if( p_sys->direct.b_enabled )
+        msg_Dbg( p_obj, "reading stored entry %s at offset %"PRIu64,
+                 p_extractor->identifier, p_sys->direct.i_start );
+
+done:
     p_extractor->p_sys = p_sys;
     p_extractor->pf_read = Read;
     p_extractor->pf_control = Control;
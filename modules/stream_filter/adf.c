@@ -45,6 +45,9 @@ vlc_module_end()
 
 static int Control( stream_t *p_stream, int i_query, va_list args )
 {
+    /* Buffered source data is still masked */
+    if( i_query == STREAM_GET_BUFFERED )
+        return VLC_EGENERIC;
     return vlc_stream_vaControl( p_stream->s, i_query, args );
 }
 
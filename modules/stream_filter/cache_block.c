@@ -59,6 +59,10 @@
  * efficient demux probing */
 #define STREAM_CACHE_PREBUFFER_SIZE (128)
 
+/* Largest gap read through, rather than seeked over, to reach a planned
+ * range (see STREAM_SET_READAHEAD_PLAN) */
+#define STREAM_CACHE_PLAN_GAP (256*1024)
+
 /* Method: Simple, for pf_block.
  *  We get blocks and put them in the linked list.
  *  We release blocks once the total size is bigger than STREAM_CACHE_SIZE
@@ -74,6 +78,10 @@ typedef struct
         uint64_t read_bytes;
         vlc_tick_t read_time;
     } stat;
+
+    /* Ranges announced by the demuxer */
+    struct vlc_stream_range *plan;
+    size_t plan_count;
 } stream_sys_t;
 
 static int AStreamRefillBlock(stream_t *s)
@@ -179,13 +187,45 @@ static void AStreamControlReset(stream_t *s)
     AStreamPrebufferBlock(s);
 }
 
+static bool AStreamPlanHas(const stream_sys_t *sys, uint64_t i_pos)
+{
+    for (size_t i = 0; i < sys->plan_count; i++)
+        if (i_pos >= sys->plan[i].offset
+         && i_pos - sys->plan[i].offset < sys->plan[i].length)
+            return true;
+    return false;
+}
+
 static int AStreamSeekBlock(stream_t *s, uint64_t i_pos)
 {
     stream_sys_t *sys = s->p_sys;
-
-    if( block_SkipBytes( &sys->cache, i_pos) == VLC_SUCCESS )
+    /* The stream core may have buffered (peeked) data past its own offset,
+     * so locate the cache from what was actually read upstream. */
+    uint64_t i_cur = vlc_stream_Tell(s->s)
+                   - block_BytestreamRemaining( &sys->cache );
+
+    /* Skip forward within the cache */
+    if( i_pos >= i_cur &&
+        block_SkipBytes( &sys->cache, i_pos - i_cur ) == VLC_SUCCESS )
         return VLC_SUCCESS;
 
+    /* Read through a short gap to a planned range, which is cheaper than
+     * a seek on network accesses */
+    if( i_pos >= i_cur && i_pos - i_cur <= STREAM_CACHE_PLAN_GAP &&
+        AStreamPlanHas( sys, i_pos ) )
+    {
+        for (;;)
+        {
+            size_t i_remaining = block_BytestreamRemaining( &sys->cache );
+
+            if( AStreamRefillBlock(s) ||
+                block_BytestreamRemaining( &sys->cache ) == i_remaining )
+                break;
+            if( block_SkipBytes( &sys->cache, i_pos - i_cur ) == VLC_SUCCESS )
+                return VLC_SUCCESS;
+        }
+    }
+
     /* Not enought bytes, empty and seek */
     /* Do the access seek */
     if (vlc_stream_Seek(s->s, i_pos)) return VLC_EGENERIC;
@@ -257,6 +297,38 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_GET_PRIVATE_ID_STATE:
             return vlc_stream_vaControl(s->s, i_query, args);
 
+        case STREAM_GET_BUFFERED:
+            /* Buffered upstream data is not at the current offset */
+            return VLC_EGENERIC;
+
+        case STREAM_SET_READAHEAD_PLAN:
+        {
+            stream_sys_t *sys = s->p_sys;
+            va_list ap;
+
+            va_copy(ap, args);
+            const struct vlc_stream_range *ranges =
+                va_arg(ap, const struct vlc_stream_range *);
+            size_t count = va_arg(ap, size_t);
+            va_end(ap);
+
+            struct vlc_stream_range *plan = NULL;
+            if (count > 0)
+            {
+                plan = vlc_alloc(count, sizeof (*plan));
+                if (unlikely(plan == NULL))
+                    return VLC_ENOMEM;
+                memcpy(plan, ranges, count * sizeof (*plan));
+            }
+            free(sys->plan);
+            sys->plan = plan;
+            sys->plan_count = count;
+
+            /* Let the access make use of it too */
+            vlc_stream_vaControl(s->s, i_query, args);
+            return VLC_SUCCESS;
+        }
+
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
         {
@@ -281,6 +353,13 @@ static int Open(vlc_object_t *obj)
     if (s->s->pf_block == NULL)
         return VLC_EGENERIC;
 
+    /* Fast-seeking (i.e. local) sources deliver large or memory-mapped
+     * blocks already. Caching would only add a copy of each block. */
+    bool fast_seek;
+    if (vlc_stream_Control(s->s, STREAM_CAN_FASTSEEK, &fast_seek) == 0
+     && fast_seek)
+        return VLC_EGENERIC;
+
     stream_sys_t *sys = malloc(sizeof (*sys));
     if (unlikely(sys == NULL))
         return VLC_ENOMEM;
@@ -289,6 +368,8 @@ static int Open(vlc_object_t *obj)
 
     /* Init all fields of sys->block */
     block_BytestreamInit( &sys->cache );
+    sys->plan = NULL;
+    sys->plan_count = 0;
 
     s->p_sys = sys;
     /* Do the prebuffering */
@@ -316,6 +397,7 @@ static void Close(vlc_object_t *obj)
     stream_sys_t *sys = s->p_sys;
 
     block_BytestreamEmpty( &sys->cache );
+    free(sys->plan);
     free(sys);
 }
 
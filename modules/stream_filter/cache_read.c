@@ -467,8 +467,13 @@ static int AStreamControl(stream_t *s, int i_query, va_list args)
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_SET_READAHEAD_PLAN:
             return vlc_stream_vaControl(s->s, i_query, args);
 
+        case STREAM_GET_BUFFERED:
+            /* Buffered upstream data is not at the current offset */
+            return VLC_EGENERIC;
+
         case STREAM_SET_TITLE:
         case STREAM_SET_SEEKPOINT:
         {
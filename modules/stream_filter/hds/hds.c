@@ -50,6 +50,8 @@ typedef struct chunk_s
     uint8_t     *data;
     bool        failed;
     bool        eof;
+    bool        downloading; /* picked by a download thread */
+    unsigned    retries;
 } chunk_t;
 
 typedef struct segment_run_s
@@ -71,7 +73,6 @@ typedef struct hds_stream_s
     /* linked-list of chunks */
     chunk_t        *chunks_head;
     chunk_t        *chunks_livereadpos;
-    chunk_t        *chunks_downloadpos;
 
     char*          quality_segment_modifier;
 
@@ -90,9 +91,14 @@ typedef struct hds_stream_s
 
     vlc_mutex_t    abst_lock;
 
+    /* protects the chunks list and the chunks data */
     vlc_mutex_t    dl_lock;
     vlc_cond_t     dl_cond;
 
+    /* last bootstrap received, to only parse the updated ones */
+    uint8_t*       abst_data;
+    size_t         abst_len;
+
     /* can be left as null */
     char*          abst_url;
 
@@ -122,11 +128,15 @@ typedef struct hds_stream_s
 
 #define BITRATE_AS_BYTES_PER_SECOND 1024/8
 
+#define MAX_HDS_DOWNLOADS 8
+#define MAX_HDS_RETRIES 3
+
 typedef struct
 {
     char         *base_url;    /* URL common part for chunks */
     vlc_thread_t live_thread;
-    vlc_thread_t dl_thread;
+    vlc_thread_t dl_threads[MAX_HDS_DOWNLOADS];
+    unsigned     dl_thread_count;
 
     /* we pend on peek until some number of segments arrives; otherwise
      * the downstream system dies in case of playback */
@@ -202,12 +212,19 @@ static unsigned char amf_object_end[] = { 0x0, 0x0, 0x9 };
 static int  Open( vlc_object_t * );
 static void Close( vlc_object_t * );
 
+#define DOWNLOADS_TEXT N_("Concurrent fragment downloads")
+#define DOWNLOADS_LONGTEXT N_("Number of fragments downloaded in parallel. " \
+    "More downloads help keeping up with live streams on long round trip " \
+    "paths.")
+
 vlc_module_begin()
     set_category( CAT_INPUT )
     set_subcategory( SUBCAT_INPUT_STREAM_FILTER )
     set_description( N_("HTTP Dynamic Streaming") )
     set_shortname( "Dynamic Streaming")
     set_capability( "stream_filter", 330 )
+    add_integer_with_range( "hds-downloads", 3, 1, MAX_HDS_DOWNLOADS,
+                            DOWNLOADS_TEXT, DOWNLOADS_LONGTEXT, true )
     set_callbacks( Open, Close )
 vlc_module_end()
 
@@ -548,6 +565,7 @@ static void parse_BootstrapData( vlc_object_t* p_this,
     /* smtpe time code offset */
     data_p += 8;
 
+    free( s->movie_id );
     s->movie_id = strndup( (char*)data_p, data_end - data_p );
     data_p += ( strlen( s->movie_id ) + 1 );
 
@@ -560,6 +578,8 @@ static void parse_BootstrapData( vlc_object_t* p_this,
     server_entry_count = (uint8_t) *data_p;
     data_p++;
 
+    for( unsigned i = 0; i < s->server_entry_count; i++ )
+        FREENULL( s->server_entries[i] );
     s->server_entry_count = 0;
     while( server_entry_count-- > 0 )
     {
@@ -753,11 +773,12 @@ static uint32_t find_chunk_mdat( vlc_object_t* p_this,
     return chunkdata_end - ((uint8_t*)boxdata);
 }
 
-/* returns data ptr if valid (updating the chunk itself
-   tells the reader that the chunk is safe to read, which is not yet correct)*/
+/* returns the fragment data and fills its length if valid, the chunk itself
+   is not modified so that it can be called without holding the lock */
 static uint8_t* download_chunk( stream_t *s,
                                 stream_sys_t* sys,
-                                hds_stream_t* stream, chunk_t* chunk )
+                                hds_stream_t* stream, const chunk_t* chunk,
+                                uint32_t *data_len )
 {
     const char* quality = "";
     char* server_base = sys->base_url;
@@ -803,17 +824,16 @@ static uint8_t* download_chunk( stream_t *s,
     {
         msg_Err(s, "Failed to download fragment %s", fragment_url );
         free( fragment_url );
-        chunk->failed = true;
         return NULL;
     }
     free( fragment_url );
 
     int64_t size = stream_Size( download_stream );
-    chunk->data_len = (uint32_t) size;
 
     if( size > MAX_REQUEST_SIZE )
     {
         msg_Err(s, "Strangely-large chunk of %"PRIi64" Bytes", size );
+        vlc_stream_Delete( download_stream );
         return NULL;
     }
 
@@ -821,34 +841,42 @@ static uint8_t* download_chunk( stream_t *s,
     if( ! data )
     {
         msg_Err(s, "Couldn't allocate chunk" );
+        vlc_stream_Delete( download_stream );
         return NULL;
     }
 
     int read = vlc_stream_Read( download_stream, data,
                             size );
-    if( read < 0 )
-        read = 0;
-    chunk->data_len = read;
+    vlc_stream_Delete( download_stream );
 
     if( read < size )
     {
         msg_Err( s, "Requested %"PRIi64" bytes, "\
                  "but only got %d", size, read );
-        data = realloc( chunk->data, read );
-        if( data != NULL )
-            chunk->data = data;
-        chunk->failed = true;
+        free( data );
         return NULL;
     }
-    else
-    {
-        chunk->failed = false;
-    }
 
-    vlc_stream_Delete( download_stream );
+    *data_len = read;
     return data;
 }
 
+/* returns the first chunk waiting for a download, in stream order */
+static chunk_t* next_download( hds_stream_t* hds_stream )
+{
+    for( chunk_t* chunk = hds_stream->chunks_head; chunk;
+         chunk = chunk->next )
+    {
+        if( ! chunk->data && ! chunk->downloading && ! chunk->failed )
+            return chunk;
+    }
+    return NULL;
+}
+
+/* Several download threads fetch the fragments concurrently. A chunk is only
+ * published once complete, and the reader consumes the list in order, so
+ * that the fragments are reassembled in stream order whatever the order of
+ * completion. */
 static void* download_thread( void* p )
 {
     vlc_object_t* p_this = (vlc_object_t*)p;
@@ -867,46 +895,47 @@ static void* download_thread( void* p )
 
     while( ! sys->closed )
     {
-        if( ! hds_stream->chunks_downloadpos )
+        chunk_t *chunk = next_download( hds_stream );
+        if( ! chunk )
         {
-            chunk_t* chunk = hds_stream->chunks_head;
-            while(chunk && chunk->data )
-            {
-                chunk = chunk->next;
-            }
-
-            if( chunk && ! chunk->data )
-                hds_stream->chunks_downloadpos = chunk;
+            vlc_cond_wait( & hds_stream->dl_cond,
+                           & hds_stream->dl_lock );
+            continue;
         }
 
-        while( hds_stream->chunks_downloadpos )
-        {
-            chunk_t *chunk = hds_stream->chunks_downloadpos;
+        /* the reader and the live thread do not free chunks without data */
+        chunk->downloading = true;
+        vlc_mutex_unlock( & hds_stream->dl_lock );
 
-            uint8_t *data = download_chunk( (stream_t*)p_this,
-                                            sys,
-                                            hds_stream,
-                                            chunk );
+        uint32_t data_len = 0;
+        uint8_t *data = download_chunk( s, sys, hds_stream, chunk,
+                                        &data_len );
+        uint8_t *mdat_data = NULL;
+        uint32_t mdat_len = 0;
+        if( data )
+        {
+            mdat_len = find_chunk_mdat( p_this, data, data + data_len,
+                                        &mdat_data );
+            if( mdat_len == 0 )
+                mdat_len = data_len - (mdat_data - data);
+        }
 
-            if( ! chunk->failed )
-            {
-                chunk->mdat_len =
-                    find_chunk_mdat( p_this,
-                                     data,
-                                     data + chunk->data_len,
-                                     & chunk->mdat_data );
-                if( chunk->mdat_len == 0 ) {
-                    chunk->mdat_len = chunk->data_len - (chunk->mdat_data - data);
-                }
-                hds_stream->chunks_downloadpos = chunk->next;
-                chunk->data = data;
+        vlc_mutex_lock( & hds_stream->dl_lock );
+        chunk->downloading = false;
+        if( data )
+        {
+            chunk->data_len = data_len;
+            chunk->mdat_data = mdat_data;
+            chunk->mdat_len = mdat_len;
+            chunk->data = data;
 
-                sys->chunk_count++;
-            }
+            sys->chunk_count++;
+        }
+        else if( ++chunk->retries >= MAX_HDS_RETRIES )
+        {
+            msg_Err( s, "Giving up fragment %u", chunk->frag_num );
+            chunk->failed = true;
         }
-
-        vlc_cond_wait( & hds_stream->dl_cond,
-                       & hds_stream->dl_lock );
     }
 
     vlc_mutex_unlock( & hds_stream->dl_lock );
@@ -1079,10 +1108,11 @@ static void maintain_live_chunks(
     }
 
     if( dl )
-        vlc_cond_signal( & hds_stream->dl_cond );
+        vlc_cond_broadcast( & hds_stream->dl_cond );
 
     chunk = hds_stream->chunks_head;
-    while( chunk && chunk->data && chunk->mdat_pos >= chunk->mdat_len && chunk->next )
+    while( chunk && ( chunk->data || chunk->failed )
+           && chunk->mdat_pos >= chunk->mdat_len && chunk->next )
     {
         chunk_t* next_chunk = chunk->next;
         chunk_free( chunk );
@@ -1151,19 +1181,32 @@ static void* live_thread( void* p )
             {
                 msg_Err( p_this, "Requested %"PRIi64" bytes, "  \
                          "but only got %d", size, read );
-
+                free( data );
             }
             else
             {
-                vlc_mutex_lock( & hds_stream->abst_lock );
-                parse_BootstrapData( p_this, hds_stream,
-                                     data, data + read );
-                vlc_mutex_unlock( & hds_stream->abst_lock );
+                /* An unchanged bootstrap has no new fragment to schedule */
+                if( hds_stream->abst_data == NULL
+                 || hds_stream->abst_len != (size_t) read
+                 || memcmp( hds_stream->abst_data, data, read ) )
+                {
+                    vlc_mutex_lock( & hds_stream->abst_lock );
+                    parse_BootstrapData( p_this, hds_stream,
+                                         data, data + read );
+                    vlc_mutex_unlock( & hds_stream->abst_lock );
+
+                    free( hds_stream->abst_data );
+                    hds_stream->abst_data = data;
+                    hds_stream->abst_len = read;
+                }
+                else
+                    free( data );
+
+                vlc_mutex_lock( & hds_stream->dl_lock );
                 maintain_live_chunks( p_this, hds_stream );
+                vlc_mutex_unlock( & hds_stream->dl_lock );
             }
 
-            free( data );
-
             vlc_stream_Delete( download_stream );
         }
 
@@ -1608,6 +1651,7 @@ static void hds_free( hds_stream_t *p_stream )
     FREENULL( p_stream->quality_segment_modifier );
 
     FREENULL( p_stream->abst_url );
+    FREENULL( p_stream->abst_data );
 
     FREENULL( p_stream->metadata );
     FREENULL( p_stream->url );
@@ -1684,7 +1728,17 @@ static int Open( vlc_object_t *p_this )
     s->pf_seek = NULL;
     s->pf_control = Control;
 
-    if( vlc_clone( &p_sys->dl_thread, download_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
+    unsigned dl_thread_count = var_InheritInteger( s, "hds-downloads" );
+    dl_thread_count = VLC_CLIP( dl_thread_count, 1, MAX_HDS_DOWNLOADS );
+    for( p_sys->dl_thread_count = 0;
+         p_sys->dl_thread_count < dl_thread_count;
+         p_sys->dl_thread_count++ )
+    {
+        if( vlc_clone( &p_sys->dl_threads[p_sys->dl_thread_count],
+                       download_thread, s, VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+    }
+    if( p_sys->dl_thread_count == 0 )
     {
         goto error;
     }
@@ -1701,6 +1755,16 @@ static int Open( vlc_object_t *p_this )
     return VLC_SUCCESS;
 
 error:
+    if( p_sys->dl_thread_count > 0 )
+    {
+        hds_stream_t *stream = p_sys->hds_streams.pp_elems[0];
+        vlc_mutex_lock( & stream->dl_lock );
+        p_sys->closed = true;
+        vlc_cond_broadcast( & stream->dl_cond );
+        vlc_mutex_unlock( & stream->dl_lock );
+        for( unsigned i = 0; i < p_sys->dl_thread_count; i++ )
+            vlc_join( p_sys->dl_threads[i], NULL );
+    }
     SysCleanup( p_sys );
     free( p_sys );
     return VLC_EGENERIC;
@@ -1715,11 +1779,18 @@ static void Close( vlc_object_t *p_this )
     hds_stream_t *stream = vlc_array_count(&p_sys->hds_streams) ?
         p_sys->hds_streams.pp_elems[0] : NULL;
 
-    p_sys->closed = true;
     if (stream)
-        vlc_cond_signal( & stream->dl_cond );
+    {
+        vlc_mutex_lock( & stream->dl_lock );
+        p_sys->closed = true;
+        vlc_cond_broadcast( & stream->dl_cond );
+        vlc_mutex_unlock( & stream->dl_lock );
+    }
+    else
+        p_sys->closed = true;
 
-    vlc_join( p_sys->dl_thread, NULL );
+    for( unsigned i = 0; i < p_sys->dl_thread_count; i++ )
+        vlc_join( p_sys->dl_threads[i], NULL );
 
     if( p_sys->live )
     {
@@ -1762,10 +1833,17 @@ static unsigned read_chunk_data(
     uint8_t* buffer_start = buffer;
     bool dl = false;
 
+    vlc_mutex_lock( & stream->dl_lock );
+
     if( chunk && chunk->eof && chunk->mdat_pos >= chunk->mdat_len )
+    {
+        vlc_mutex_unlock( & stream->dl_lock );
         return 0;
+    }
 
-    while( chunk && chunk->data && read_len > 0 && ! (chunk->eof && chunk->mdat_pos >= chunk->mdat_len ) )
+    /* failed chunks are skipped, they have no data */
+    while( chunk && ( chunk->data || chunk->failed ) && read_len > 0
+           && ! (chunk->eof && chunk->mdat_pos >= chunk->mdat_len ) )
     {
         /* in the live case, it is necessary to store the next
          * pointer here, since as soon as we increment the mdat_pos, that
@@ -1839,9 +1917,11 @@ static unsigned read_chunk_data(
         }
 
         if( dl )
-            vlc_cond_signal( & stream->dl_cond );
+            vlc_cond_broadcast( & stream->dl_cond );
     }
 
+    vlc_mutex_unlock( & stream->dl_lock );
+
     return ( ((uint8_t*)buffer) - ((uint8_t*)buffer_start));
 }
 
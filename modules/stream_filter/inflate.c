@@ -30,74 +30,255 @@
 #include <vlc_plugin.h>
 #include <vlc_stream.h>
 
+/* Seek points are recorded at deflate block boundaries (see zran.c in the
+ * zlib examples), at least SPAN bytes of output apart. When the index is
+ * full, every other point is dropped and the span is doubled, so that memory
+ * stays bounded whatever the stream length. */
+#define SPAN       (1 << 20)
+#define MAX_POINTS 256
+#define WINDOW     32768
+
+struct inflate_point
+{
+    uint64_t out; /* offset in the decompressed stream */
+    uint64_t in; /* offset of the first full byte in the compressed stream */
+    int bits; /* bits of the previous byte to prime the decompressor with */
+    unsigned window_size;
+    unsigned char window[WINDOW]; /* dictionary for the following blocks */
+};
+
 typedef struct
 {
     z_stream zstream;
     bool eof;
+    bool can_seek;
+    int bits;
+    uint64_t offset; /* in the decompressed stream */
+    uint64_t in_start; /* compressed stream start */
+    uint64_t in_offset; /* compressed bytes read so far, from the start */
+    struct inflate_point *points;
+    size_t point_count;
+    uint64_t span;
     unsigned char buffer[16384];
 } stream_sys_t;
 
+static void AddPoint(stream_t *stream, uint64_t out)
+{
+    stream_sys_t *sys = stream->p_sys;
+    z_stream *z = &sys->zstream;
+
+    /* Only at the end of a block, and not after the last one */
+    if ((z->data_type & 128) == 0 || (z->data_type & 64) != 0 || out == 0)
+        return;
+
+    if (sys->point_count > 0
+     && out < sys->points[sys->point_count - 1].out + sys->span)
+        return; /* too close, or already indexed */
+
+    if (sys->point_count == MAX_POINTS)
+    {
+        for (size_t i = 1; i < MAX_POINTS / 2; i++)
+            sys->points[i] = sys->points[2 * i];
+        sys->point_count = MAX_POINTS / 2;
+        sys->span *= 2;
+
+        if (out < sys->points[sys->point_count - 1].out + sys->span)
+            return;
+    }
+
+    if (sys->points == NULL)
+    {
+        sys->points = malloc(MAX_POINTS * sizeof (*sys->points));
+        if (unlikely(sys->points == NULL))
+            return;
+    }
+
+    struct inflate_point *point = &sys->points[sys->point_count];
+
+    point->window_size = sizeof (point->window);
+    if (inflateGetDictionary(z, point->window, &point->window_size) != Z_OK)
+        return;
+
+    point->out = out;
+    point->in = sys->in_start + sys->in_offset - z->avail_in;
+    point->bits = z->data_type & 7;
+    sys->point_count++;
+}
+
+static size_t Refill(stream_t *stream)
+{
+    stream_sys_t *sys = stream->p_sys;
+    z_stream *z = &sys->zstream;
+
+    if (z->avail_in == 0)
+        z->next_in = sys->buffer;
+    else if (z->next_in != sys->buffer)
+    {
+        memmove(sys->buffer, z->next_in, z->avail_in);
+        z->next_in = sys->buffer;
+    }
+
+    size_t len = sizeof (sys->buffer) - z->avail_in;
+    if (len == 0)
+        return 0;
+
+    ssize_t val = vlc_stream_Read(stream->s, sys->buffer + z->avail_in, len);
+    if (val <= 0)
+        return 0;
+
+    z->avail_in += val;
+    sys->in_offset += val;
+    return val;
+}
+
 static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
 {
     stream_sys_t *sys = stream->p_sys;
+    z_stream *z = &sys->zstream;
     ssize_t val;
 
     if (sys->eof || unlikely(buflen == 0))
         return 0;
 
-    sys->zstream.next_out = buf;
-    sys->zstream.avail_out = buflen;
+    z->next_out = buf;
+    z->avail_out = buflen;
 
-    if (sys->zstream.avail_in == 0)
-        sys->zstream.next_in = sys->buffer;
+    while (z->avail_out > 0)
+    {
+        if (z->avail_in == 0)
+        {
+            if (z->avail_out < buflen)
+                break; /* do not wait for input with data to return */
+            if (Refill(stream) == 0)
+            {
+                msg_Err(stream, "unexpected end of stream");
+                break;
+            }
+        }
 
-    val = (sys->buffer + sizeof (sys->buffer))
-        - (sys->zstream.next_in + sys->zstream.avail_in);
+        /* Stop at every block boundary, to record seek points */
+        val = inflate(z, Z_BLOCK);
+        switch (val)
+        {
+            case Z_OK:
+                AddPoint(stream, sys->offset + (buflen - z->avail_out));
+                continue;
+            case Z_STREAM_END:
+                msg_Dbg(stream, "end of stream");
+                sys->eof = true;
+                goto out;
+            case Z_DATA_ERROR:
+                msg_Err(stream, "corrupt stream");
+                sys->eof = true;
+                return -1;
+            case Z_BUF_ERROR:
+                if (z->avail_out < buflen)
+                    goto out;
+                if (Refill(stream) > 0)
+                    continue;
+                msg_Err(stream, "unexpected end of stream");
+                goto out;
+        }
 
-    if (val > 0)
-    {   /* Fill input buffer if there is space left */
-        val = vlc_stream_Read(stream->s,
-                          sys->zstream.next_in + sys->zstream.avail_in, val);
-        if (val >= 0)
-            sys->zstream.avail_in += val;
+        msg_Err(stream, "unhandled decompression error (%zd)", val);
+        return -1;
     }
+out:
+    val = buflen - z->avail_out;
+    sys->offset += val;
+    return val;
+}
 
-    if (sys->zstream.avail_in == 0)
-    {
-        msg_Err(stream, "unexpected end of stream");
-        return 0;
-    }
+/**
+ * Restarts decompression from a seek point, or from the start if NULL.
+ */
+static int Restart(stream_t *stream, const struct inflate_point *point)
+{
+    stream_sys_t *sys = stream->p_sys;
+    z_stream *z = &sys->zstream;
+    uint64_t in = sys->in_start;
+
+    if (point != NULL)
+        in = point->in - (point->bits != 0);
+
+    sys->eof = true;
+    if (vlc_stream_Seek(stream->s, in))
+        return -1;
 
-    val = inflate(&sys->zstream, Z_SYNC_FLUSH);
-    switch (val)
+    z->next_in = sys->buffer;
+    z->avail_in = 0;
+    sys->in_offset = in - sys->in_start;
+
+    /* From a seek point on, the data is raw deflate */
+    if (inflateReset2(z, (point != NULL) ? -15 : sys->bits) != Z_OK)
+        return -1;
+
+    if (point != NULL)
     {
-        case Z_STREAM_END:
-            msg_Dbg(stream, "end of stream");
-            sys->eof = true;
-            /* fall through */
-        case Z_OK:
-            return buflen - sys->zstream.avail_out;
-        case Z_DATA_ERROR:
-            msg_Err(stream, "corrupt stream");
-            sys->eof = true;
-            return -1;
-        case Z_BUF_ERROR:
-            if (sys->zstream.next_in == sys->buffer)
-                break;
+        if (point->bits != 0)
+        {
+            unsigned char c;
 
-            memmove(sys->buffer, sys->zstream.next_in, sys->zstream.avail_in);
-            sys->zstream.next_in = sys->buffer;
-            return Read(stream, buf, buflen);
+            if (vlc_stream_Read(stream->s, &c, 1) < 1)
+                return -1;
+            sys->in_offset++;
+            if (inflatePrime(z, point->bits, c >> (8 - point->bits)) != Z_OK)
+                return -1;
+        }
+
+        if (inflateSetDictionary(z, point->window,
+                                 point->window_size) != Z_OK)
+            return -1;
     }
 
-    msg_Err(stream, "unhandled decompression error (%zd)", val);
-    return -1;
+    sys->offset = (point != NULL) ? point->out : 0;
+    sys->eof = false;
+    return 0;
 }
 
 static int Seek(stream_t *stream, uint64_t offset)
 {
-    (void) stream; (void) offset;
-    return -1;
+    stream_sys_t *sys = stream->p_sys;
+    const struct inflate_point *point = NULL;
+
+    /* Find the last seek point before the target */
+    size_t lo = 0, hi = sys->point_count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+
+        if (sys->points[mid].out <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > 0)
+        point = &sys->points[lo - 1];
+
+    /* Decompress on from the current position if it is closer */
+    if (offset < sys->offset
+     || (point != NULL && point->out > sys->offset))
+    {
+        if (!sys->can_seek)
+            return -1;
+        if (Restart(stream, point))
+        {
+            msg_Err(stream, "cannot restart decompression");
+            return -1;
+        }
+    }
+
+    while (sys->offset < offset)
+    {
+        unsigned char buf[16384];
+        size_t len = sizeof (buf);
+
+        if (offset - sys->offset < len)
+            len = offset - sys->offset;
+        if (Read(stream, buf, len) <= 0)
+            return -1;
+    }
+    return 0;
 }
 
 static int Control(stream_t *stream, int query, va_list args)
@@ -105,6 +286,12 @@ static int Control(stream_t *stream, int query, va_list args)
     switch (query)
     {
         case STREAM_CAN_SEEK:
+        {
+            stream_sys_t *sys = stream->p_sys;
+
+            *va_arg(args, bool *) = sys->can_seek;
+            break;
+        }
         case STREAM_CAN_FASTSEEK:
             *va_arg(args, bool *) = false;
             break;
@@ -125,6 +312,8 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_SET_PRIVATE_ID_STATE:
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
+        case STREAM_GET_BUFFERED:
+        case STREAM_SET_READAHEAD_PLAN:
             return VLC_EGENERIC;
         default:
             msg_Err(stream, "unimplemented query (%d) in control", query);
@@ -161,6 +350,15 @@ static int Open(vlc_object_t *obj)
     sys->zstream.zfree = Z_NULL;
     sys->zstream.opaque = Z_NULL;
     sys->eof = false;
+    sys->bits = bits;
+    sys->offset = 0;
+    sys->in_start = vlc_stream_Tell(stream->s);
+    sys->in_offset = 0;
+    sys->points = NULL;
+    sys->point_count = 0;
+    sys->span = SPAN;
+    sys->can_seek = false;
+    vlc_stream_Control(stream->s, STREAM_CAN_SEEK, &sys->can_seek);
 
     int ret = inflateInit2(&sys->zstream, bits);
     if (ret != Z_OK)
@@ -182,6 +380,7 @@ static void Close (vlc_object_t *obj)
     stream_sys_t *sys = stream->p_sys;
 
     inflateEnd(&sys->zstream);
+    free(sys->points);
     free(sys);
 }
 
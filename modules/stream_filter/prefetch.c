@@ -28,6 +28,9 @@
 
 #include <sys/types.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_plugin.h>
@@ -35,6 +38,13 @@
 #include <vlc_fs.h>
 #include <vlc_interrupt.h>
 
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS) && !defined(_WIN32)
+# define PREFETCH_RING 1
+#endif
+
+/* Smallest read-ahead of the adaptive mode */
+#define PREFETCH_MIN_AHEAD (1 << 20)
+
 struct stream_ctrl
 {
     struct stream_ctrl *next;
@@ -46,6 +56,11 @@ struct stream_ctrl
             int id;
             bool state;
         } id_state;
+        struct
+        {
+            struct vlc_stream_range *ranges;
+            size_t count;
+        } plan;
     };
 };
 
@@ -75,9 +90,222 @@ typedef struct
     char        *buffer;
     size_t       seek_threshold;
 
+    bool         ring; /**< buffer is mapped twice back-to-back */
+    char        *old_buffer; /**< superseded ring, pending unmapping */
+    size_t       old_size;
+
+    /* Adaptive mode */
+    vlc_tick_t   ahead_duration; /**< 0 if disabled */
+    size_t       ahead_target;
+    size_t       max_size;
+    size_t       rate; /**< consumption rate (bytes per second) */
+    vlc_tick_t   rate_start;
+    size_t       rate_bytes;
+
+    /* Ranges announced by the demuxer */
+    struct vlc_stream_range *plan;
+    size_t       plan_count;
+
     struct stream_ctrl *controls;
 } stream_sys_t;
 
+#ifdef PREFETCH_RING
+/**
+ * Maps a circular buffer twice into contiguous virtual memory, such that any
+ * run of up to size bytes starting within the buffer is contiguous.
+ * Pages are only committed when first written to.
+ */
+static char *RingMap(size_t size)
+{
+    int fd = vlc_memfd();
+    if (fd == -1)
+        return NULL;
+
+    char *base = MAP_FAILED;
+
+    if (ftruncate(fd, size) == 0)
+        base = mmap(NULL, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                    -1, 0);
+    if (base != MAP_FAILED
+     && (mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+              fd, 0) == MAP_FAILED
+      || mmap(base + size, size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED))
+    {
+        munmap(base, 2 * size);
+        base = MAP_FAILED;
+    }
+    vlc_close(fd);
+    return (base != MAP_FAILED) ? base : NULL;
+}
+
+static void RingUnmap(char *base, size_t size)
+{
+    munmap(base, 2 * size);
+}
+
+static size_t RingRound(size_t size)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    return (size + page - 1) & ~(page - 1);
+}
+#endif
+
+static void BufferFree(stream_sys_t *sys)
+{
+#ifdef PREFETCH_RING
+    if (sys->ring)
+    {
+        RingUnmap(sys->buffer, sys->buffer_size);
+        if (sys->old_buffer != NULL)
+            RingUnmap(sys->old_buffer, sys->old_size);
+        return;
+    }
+#endif
+    free(sys->buffer);
+}
+
+/**
+ * Releases the superseded ring, if any. This must be called from the reading
+ * thread, as STREAM_GET_BUFFERED may have returned a pointer into it.
+ */
+static void BufferCollect(stream_sys_t *sys)
+{
+#ifdef PREFETCH_RING
+    if (sys->old_buffer != NULL)
+    {
+        RingUnmap(sys->old_buffer, sys->old_size);
+        sys->old_buffer = NULL;
+    }
+#else
+    (void) sys;
+#endif
+}
+
+/**
+ * Grows the ring so that it can hold the adaptive read-ahead target plus as
+ * much historical data.
+ */
+static void BufferGrow(stream_t *stream)
+{
+#ifdef PREFETCH_RING
+    stream_sys_t *sys = stream->p_sys;
+
+    if (!sys->ring || sys->old_buffer != NULL
+     || sys->buffer_size >= sys->max_size
+     || sys->ahead_target <= sys->buffer_size / 2)
+        return;
+
+    size_t size = sys->buffer_size;
+    while (size < 2 * sys->ahead_target && size < sys->max_size)
+        size *= 2;
+    if (size > sys->max_size)
+        size = sys->max_size;
+    size = RingRound(size);
+
+    char *buffer = RingMap(size);
+    if (buffer == NULL)
+        return;
+
+    memcpy(buffer + sys->buffer_offset % size,
+           sys->buffer + sys->buffer_offset % sys->buffer_size,
+           sys->buffer_length);
+    sys->old_buffer = sys->buffer;
+    sys->old_size = sys->buffer_size;
+    sys->buffer = buffer;
+    sys->buffer_size = size;
+    msg_Dbg(stream, "buffer grown to %zu bytes", size);
+#else
+    (void) stream;
+#endif
+}
+
+/**
+ * Updates the consumption rate estimate and the adaptive read-ahead target.
+ */
+static void RateUpdate(stream_sys_t *sys, size_t bytes)
+{
+    if (sys->ahead_duration == 0)
+        return;
+
+    vlc_tick_t now = vlc_tick_now();
+
+    if (sys->rate_start == VLC_TICK_INVALID)
+    {
+        sys->rate_start = now;
+        sys->rate_bytes = 0;
+        return;
+    }
+
+    sys->rate_bytes += bytes;
+
+    vlc_tick_t elapsed = now - sys->rate_start;
+    if (elapsed < VLC_TICK_FROM_SEC(1))
+        return;
+
+    size_t rate = (uint64_t)sys->rate_bytes * CLOCK_FREQ / elapsed;
+
+    /* Exponentially weighted moving average */
+    sys->rate = (sys->rate == 0) ? rate : (3 * sys->rate + rate) / 4;
+    sys->rate_start = now;
+    sys->rate_bytes = 0;
+
+    uint64_t target = (uint64_t)sys->rate * sys->ahead_duration / CLOCK_FREQ;
+    if (target < PREFETCH_MIN_AHEAD)
+        target = PREFETCH_MIN_AHEAD;
+    if (target > sys->max_size)
+        target = sys->max_size;
+    sys->ahead_target = target;
+}
+
+/**
+ * Restarts the rate estimation, e.g. after a seek or pause.
+ */
+static void RateReset(stream_sys_t *sys)
+{
+    sys->rate_start = VLC_TICK_INVALID;
+}
+
+static struct vlc_stream_range *PlanDup(const struct vlc_stream_range *ranges,
+                                        size_t count)
+{
+    if (count == 0)
+        return NULL;
+
+    struct vlc_stream_range *plan = vlc_alloc(count, sizeof (*plan));
+    if (likely(plan != NULL))
+        memcpy(plan, ranges, count * sizeof (*plan));
+    return plan;
+}
+
+/**
+ * Finds the end of the planned ranges being read, merging ranges separated
+ * by less than the seek threshold.
+ *
+ * \return the end offset, or 0 if the offset is not within the plan
+ */
+static uint64_t PlanEnd(const stream_sys_t *sys, uint64_t offset)
+{
+    uint64_t end = 0;
+
+    for (size_t i = 0; i < sys->plan_count; i++)
+    {
+        const struct vlc_stream_range *r = &sys->plan[i];
+
+        if (end == 0)
+        {
+            if (offset >= r->offset && offset - r->offset < r->length)
+                end = r->offset + r->length;
+        }
+        else if (r->offset <= end + sys->seek_threshold)
+            end = __MAX(end, r->offset + r->length);
+        else
+            break;
+    }
+    return end;
+}
+
 static ssize_t ThreadRead(stream_t *stream, void *buf, size_t length)
 {
     stream_sys_t *sys = stream->p_sys;
@@ -139,8 +367,15 @@ static void *Thread(void *data)
         if (unlikely(ctrl != NULL))
         {
             sys->controls = ctrl->next;
-            ThreadControl(stream, ctrl->query, ctrl->id_state.id,
-                          ctrl->id_state.state);
+            if (ctrl->query == STREAM_SET_READAHEAD_PLAN)
+            {
+                ThreadControl(stream, ctrl->query, ctrl->plan.ranges,
+                              ctrl->plan.count);
+                free(ctrl->plan.ranges);
+            }
+            else
+                ThreadControl(stream, ctrl->query, ctrl->id_state.id,
+                              ctrl->id_state.state);
             free(ctrl);
             continue;
         }
@@ -169,6 +404,10 @@ static void *Thread(void *data)
                 sys->buffer_length = 0;
                 assert(!sys->error);
                 sys->eof = false;
+                /* Random access: do not read too far ahead until the
+                 * consumption rate is known again. */
+                if (sys->ahead_duration != 0)
+                    sys->ahead_target = PREFETCH_MIN_AHEAD;
             }
             else
             {
@@ -205,6 +444,8 @@ static void *Thread(void *data)
                 sys->buffer_length = 0;
                 assert(!sys->error);
                 assert(!sys->eof);
+                if (sys->ahead_duration != 0)
+                    sys->ahead_target = PREFETCH_MIN_AHEAD;
             }
             else
             {   /* Seek failure is not necessarily fatal here. We could read
@@ -218,6 +459,28 @@ static void *Thread(void *data)
             continue;
         }
 
+        if (sys->ahead_duration != 0)
+        {
+            if (history < sys->buffer_length
+             && sys->buffer_length - history >= sys->ahead_target)
+            {   /* Enough data read ahead */
+                vlc_cond_wait(&sys->wait_space, &sys->lock);
+                continue;
+            }
+            BufferGrow(stream);
+        }
+
+        /* Stop reading ahead at the end of the planned range being read:
+         * whatever follows is not needed next, and the access can complete
+         * its request instead of being seeked away in the middle of it. */
+        uint64_t plan_end = PlanEnd(sys, stream_offset);
+        uint64_t buffer_end = sys->buffer_offset + sys->buffer_length;
+        if (plan_end != 0 && buffer_end >= plan_end)
+        {
+            vlc_cond_wait(&sys->wait_space, &sys->lock);
+            continue;
+        }
+
         assert(sys->buffer_size >= sys->buffer_length);
 
         size_t len = sys->buffer_size - sys->buffer_length;
@@ -239,8 +502,10 @@ static void *Thread(void *data)
         size_t offset = (sys->buffer_offset + sys->buffer_length)
                         % sys->buffer_size;
          /* Do not step past the sharp edge of the circular buffer */
-        if (offset + len > sys->buffer_size)
+        if (!sys->ring && offset + len > sys->buffer_size)
             len = sys->buffer_size - offset;
+        if (plan_end != 0 && len > plan_end - buffer_end)
+            len = plan_end - buffer_end;
 
         ssize_t val = ThreadRead(stream, sys->buffer + offset, len);
         if (val < 0)
@@ -271,6 +536,9 @@ static int Seek(stream_t *stream, uint64_t offset)
     stream_sys_t *sys = stream->p_sys;
 
     vlc_mutex_lock(&sys->lock);
+    BufferCollect(sys);
+    if (offset != sys->stream_offset)
+        RateReset(sys);
     sys->stream_offset = offset;
     sys->error = false;
     vlc_cond_signal(&sys->wait_space);
@@ -304,6 +572,7 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
         return buflen;
 
     vlc_mutex_lock(&sys->lock);
+    BufferCollect(sys);
     if (sys->paused)
     {
         msg_Err(stream, "reading while paused (buggy demux?)");
@@ -330,11 +599,12 @@ static ssize_t Read(stream_t *stream, void *buf, size_t buflen)
     if (copy > buflen)
         copy = buflen;
     /* Do not step past the sharp edge of the circular buffer */
-    if (offset + copy > sys->buffer_size)
+    if (!sys->ring && offset + copy > sys->buffer_size)
         copy = sys->buffer_size - offset;
 
     memcpy(buf, sys->buffer + offset, copy);
     sys->stream_offset += copy;
+    RateUpdate(sys, copy);
     vlc_cond_signal(&sys->wait_space);
     vlc_mutex_unlock(&sys->lock);
     return copy;
@@ -379,12 +649,32 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_GET_SIGNAL:
         case STREAM_GET_TAGS:
             return VLC_EGENERIC;
+        case STREAM_GET_BUFFERED:
+        {
+            const void **bufp = va_arg(args, const void **);
+            size_t *lenp = va_arg(args, size_t *);
+            bool eof;
+
+            vlc_mutex_lock(&sys->lock);
+            BufferCollect(sys);
+
+            size_t offset = sys->stream_offset % sys->buffer_size;
+            size_t len = BufferLevel(stream, &eof);
+
+            if (!sys->ring && offset + len > sys->buffer_size)
+                len = sys->buffer_size - offset;
+            *bufp = sys->buffer + offset;
+            *lenp = len;
+            vlc_mutex_unlock(&sys->lock);
+            return (len > 0) ? VLC_SUCCESS : VLC_EGENERIC;
+        }
         case STREAM_SET_PAUSE_STATE:
         {
             bool paused = va_arg(args, unsigned);
 
             vlc_mutex_lock(&sys->lock);
             sys->paused = paused;
+            RateReset(sys);
             vlc_cond_signal(&sys->wait_space);
             vlc_mutex_unlock (&sys->lock);
             break;
@@ -412,6 +702,37 @@ static int Control(stream_t *stream, int query, va_list args)
         case STREAM_SET_PRIVATE_ID_CA:
         case STREAM_GET_PRIVATE_ID_STATE:
             return VLC_EGENERIC;
+        case STREAM_SET_READAHEAD_PLAN:
+        {
+            const struct vlc_stream_range *ranges =
+                va_arg(args, const struct vlc_stream_range *);
+            size_t count = va_arg(args, size_t);
+            struct stream_ctrl *ctrl = malloc(sizeof (*ctrl)), **pp;
+            struct vlc_stream_range *plan = PlanDup(ranges, count);
+
+            if (unlikely(ctrl == NULL || (count > 0 && plan == NULL)))
+            {
+                free(plan);
+                free(ctrl);
+                return VLC_ENOMEM;
+            }
+
+            /* The thread forwards its own copy upstream */
+            ctrl->next = NULL;
+            ctrl->query = query;
+            ctrl->plan.ranges = PlanDup(ranges, count);
+            ctrl->plan.count = (ctrl->plan.ranges != NULL) ? count : 0;
+
+            vlc_mutex_lock(&sys->lock);
+            free(sys->plan);
+            sys->plan = plan;
+            sys->plan_count = count;
+            for (pp = &sys->controls; *pp != NULL; pp = &((*pp)->next));
+            *pp = ctrl;
+            vlc_cond_signal(&sys->wait_space);
+            vlc_mutex_unlock(&sys->lock);
+            break;
+        }
         default:
             msg_Err(stream, "unimplemented query (%d) in control", query);
             return VLC_EGENERIC;
@@ -465,6 +786,14 @@ static int Open(vlc_object_t *obj)
     sys->buffer_size = var_InheritInteger(obj, "prefetch-buffer-size") << 10u;
     sys->seek_threshold = var_InheritInteger(obj, "prefetch-seek-threshold");
     sys->controls = NULL;
+    sys->plan = NULL;
+    sys->plan_count = 0;
+    sys->ring = false;
+    sys->old_buffer = NULL;
+    sys->ahead_duration =
+        VLC_TICK_FROM_SEC(var_InheritInteger(obj, "prefetch-adaptive"));
+    sys->rate = 0;
+    RateReset(sys);
 
     uint64_t size = stream_Size(stream->s);
     if (size > 0)
@@ -472,10 +801,36 @@ static int Open(vlc_object_t *obj)
         if (sys->buffer_size > size)
             sys->buffer_size = size;
     }
+    sys->max_size = sys->buffer_size;
+
+#ifdef PREFETCH_RING
+    if (sys->ahead_duration != 0)
+    {   /* Start small, and grow with the consumption rate */
+        sys->ahead_target = PREFETCH_MIN_AHEAD;
+        if (sys->buffer_size > 2 * PREFETCH_MIN_AHEAD)
+            sys->buffer_size = 2 * PREFETCH_MIN_AHEAD;
+    }
 
-    sys->buffer = malloc(sys->buffer_size);
-    if (sys->buffer == NULL)
-        goto error;
+    sys->buffer = RingMap(RingRound(sys->buffer_size));
+    if (sys->buffer != NULL)
+    {
+        sys->buffer_size = RingRound(sys->buffer_size);
+        if (sys->max_size < sys->buffer_size)
+            sys->max_size = sys->buffer_size;
+        if (sys->ahead_duration == 0)
+            sys->ahead_target = sys->buffer_size;
+        sys->ring = true;
+    }
+    else
+#endif
+    {
+        sys->ahead_duration = 0;
+        sys->buffer_size = sys->max_size;
+        sys->ahead_target = sys->buffer_size;
+        sys->buffer = malloc(sys->buffer_size);
+        if (sys->buffer == NULL)
+            goto error;
+    }
 
     sys->interrupt = vlc_interrupt_create();
     if (unlikely(sys->interrupt == NULL))
@@ -493,14 +848,16 @@ static int Open(vlc_object_t *obj)
         goto error;
     }
 
-    msg_Dbg(stream, "using %zu bytes buffer", sys->buffer_size);
+    msg_Dbg(stream, "using %zu bytes %s buffer", sys->buffer_size,
+            sys->ring ? "ring" : "heap");
     stream->pf_read = Read;
     stream->pf_seek = Seek;
     stream->pf_control = Control;
     return VLC_SUCCESS;
 
 error:
-    free(sys->buffer);
+    if (sys->buffer != NULL)
+        BufferFree(sys);
     free(sys->content_type);
     free(sys);
     return VLC_ENOMEM;
@@ -527,9 +884,12 @@ static void Close (vlc_object_t *obj)
     {
         struct stream_ctrl *ctrl = sys->controls;
         sys->controls = ctrl->next;
+        if (ctrl->query == STREAM_SET_READAHEAD_PLAN)
+            free(ctrl->plan.ranges);
         free(ctrl);
     }
-    free(sys->buffer);
+    free(sys->plan);
+    BufferFree(sys);
     free(sys->content_type);
     free(sys);
 }
@@ -549,4 +909,9 @@ vlc_module_begin()
     add_integer("prefetch-seek-threshold", 1 << 14, N_("Seek threshold"),
                 N_("Prefetch forward seek threshold (bytes)"), true)
         change_integer_range(0, UINT64_C(1) << 60)
+    add_integer("prefetch-adaptive", 0, N_("Adaptive read-ahead (s)"),
+                N_("Read ahead this many seconds of data at the measured "
+                   "consumption rate, growing the buffer as needed up to the "
+                   "buffer size (0 disables)"), true)
+        change_integer_range(0, 3600)
 vlc_module_end()
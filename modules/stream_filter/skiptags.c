@@ -184,6 +184,10 @@ static int Control(stream_t *stream, int query, va_list args)
                 *va_arg(args, uint64_t *) = size - sys->header_skip;
             return ret;
         }
+
+        case STREAM_SET_READAHEAD_PLAN:
+            /* Offsets would need to be shifted by the skipped tags */
+            return VLC_EGENERIC;
     }
 
     return vlc_stream_vaControl(stream->s, query, args);
@@ -59,7 +59,9 @@ struct sout_access_out_sys_t
 
     void clear();
     void stop();
-    void prepare(sout_stream_t *p_stream, const std::string &mime);
+    void restart();
+    void prepare(sout_stream_t *p_stream, const std::string &mime,
+                 bool fast_start);
     int url_cb(httpd_client_t *cl, httpd_message_t *answer, const httpd_message_t *query);
     void fifo_put_back(block_t *);
     ssize_t write(sout_access_out_t *p_access, block_t *p_block);
@@ -81,6 +83,7 @@ private:
     block_t           **m_copy_last;
     size_t             m_copy_size;
     bool               m_eof;
+    bool               m_fast_start;
     std::string        m_mime;
 };
 
@@ -106,6 +109,10 @@ struct sout_stream_sys_t
         , transcoding_state( TRANSCODING_NONE )
         , venc_opt_idx ( -1 )
         , out_streams_added( 0 )
+        , ts_offset( 0 )
+        , ts_origin( VLC_TICK_INVALID )
+        , ts_last( VLC_TICK_INVALID )
+        , ts_resync( false )
     {
         assert(p_intf != NULL);
         vlc_mutex_init(&lock);
@@ -122,6 +129,9 @@ struct sout_stream_sys_t
                         const std::vector<sout_stream_id_sys_t*> &new_streams,
                         const std::string &sout, int new_transcoding_state);
     void stopSoutChain(sout_stream_t* p_stream);
+    bool canReuseSoutChain(sout_stream_t* p_stream) const;
+    void flushSoutChain(sout_stream_t* p_stream);
+    void shiftTimestamps(block_t *p_buffer);
     sout_stream_id_sys_t *GetSubId( sout_stream_t*, sout_stream_id_sys_t*, bool update = true );
     bool isFlushing( sout_stream_t* );
     void setNextTranscodingState();
@@ -156,6 +166,13 @@ struct sout_stream_sys_t
     unsigned int                       out_streams_added;
     unsigned int                       spu_streams_count;
 
+    /* When the chain is kept across seeks, the timestamps sent to the muxer
+     * are shifted to stay monotonic. */
+    vlc_tick_t                         ts_offset;
+    vlc_tick_t                         ts_origin; /* first muxed timestamp */
+    vlc_tick_t                         ts_last; /* last muxed timestamp */
+    bool                               ts_resync;
+
 private:
     std::string GetAcodecOption( sout_stream_t *, vlc_fourcc_t *, const audio_format_t *, int );
     bool UpdateOutput( sout_stream_t * );
@@ -207,6 +224,13 @@ static const char *const ppsz_sout_options[] = {
 /* Fifo size after we drop packets (should not happen) */
 #define HTTPD_BUFFER_MAX INT64_C(32 * 1024 * 1024) /* 32 MB */
 #define HTTPD_BUFFER_COPY_MAX INT64_C(10 * 1024 * 1024) /* 10 MB */
+/* Minimum size of the first answer when remuxing */
+#define HTTPD_BUFFER_FAST_START INT64_C(64 * 1024) /* 64 kB */
+/* Gap between the last timestamp muxed before a seek and the first one after */
+#define SEEK_TIMESTAMP_GAP VLC_TICK_FROM_MS(100)
+
+#define FAST_SEEK_TEXT N_("Fast seek")
+#define FAST_SEEK_LONGTEXT N_("Keep the stream output running when seeking "     "while remuxing, instead of restarting it. Only the Chromecast session "     "is reloaded.")
 
 vlc_module_begin ()
 
@@ -225,6 +249,7 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "video", true, NULL, NULL, false)
         change_private()
     add_integer(SOUT_CFG_PREFIX "http-port", HTTP_PORT, HTTP_PORT_TEXT, HTTP_PORT_LONGTEXT, false)
+    add_bool(SOUT_CFG_PREFIX "fast-seek", true, FAST_SEEK_TEXT, FAST_SEEK_LONGTEXT, true)
     add_obsolete_string(SOUT_CFG_PREFIX "mux")
     add_obsolete_string(SOUT_CFG_PREFIX "mime")
     add_renderer_opts(SOUT_CFG_PREFIX)
@@ -291,12 +316,21 @@ static int ProxySend(sout_stream_t *p_stream, void *_id, block_t *p_buffer)
             }
         }
 
+        vlc_tick_t i_ts = p_buffer->i_dts != VLC_TICK_INVALID
+                        ? p_buffer->i_dts : p_buffer->i_pts;
+        if (p_sys->ts_origin == VLC_TICK_INVALID)
+            p_sys->ts_origin = i_ts;
+
         int ret = sout_StreamIdSend(p_stream->p_next, id, p_buffer);
         if (ret == VLC_SUCCESS && !p_sys->cc_has_input)
         {
             /* Start the chromecast only when all streams are added into the
-             * last sout (the http one) */
-            p_sys->p_intf->setHasInput(p_sys->mime);
+             * last sout (the http one). If the muxer was kept across a seek,
+             * the stream does not start at 0 anymore. */
+            vlc_tick_t time_base = 0;
+            if (i_ts != VLC_TICK_INVALID && p_sys->ts_origin != VLC_TICK_INVALID)
+                time_base = i_ts - p_sys->ts_origin;
+            p_sys->p_intf->setHasInput(p_sys->mime, time_base);
             p_sys->cc_has_input = true;
         }
         return ret;
@@ -344,6 +378,7 @@ sout_access_out_sys_t::sout_access_out_sys_t(httpd_host_t *httpd_host,
     , m_header(NULL)
     , m_copy_chain(NULL)
     , m_eof(true)
+    , m_fast_start(false)
 {
     m_fifo = block_FifoNew();
     if (!m_fifo)
@@ -432,7 +467,22 @@ void sout_access_out_sys_t::stop()
     vlc_fifo_Signal(m_fifo);
 }
 
-void sout_access_out_sys_t::prepare(sout_stream_t *p_stream, const std::string &mime)
+/* Drops the queued data and the client, but keeps the header, so that the
+ * next client can be served as soon as the muxer outputs new data. */
+void sout_access_out_sys_t::restart()
+{
+    vlc_fifo_Lock(m_fifo);
+    block_ChainRelease(vlc_fifo_DequeueAllUnlocked(m_fifo));
+    initCopy();
+    m_intf->setPacing(false);
+    m_client = NULL;
+    m_eof = false;
+    vlc_fifo_Unlock(m_fifo);
+    vlc_fifo_Signal(m_fifo);
+}
+
+void sout_access_out_sys_t::prepare(sout_stream_t *p_stream, const std::string &mime,
+                                    bool fast_start)
 {
     var_SetAddress(p_stream->p_sout, SOUT_CFG_PREFIX "access-out-sys", this);
 
@@ -441,6 +491,7 @@ void sout_access_out_sys_t::prepare(sout_stream_t *p_stream, const std::string &
     m_intf->setPacing(false);
     m_mime = mime;
     m_eof = false;
+    m_fast_start = fast_start;
     vlc_fifo_Unlock(m_fifo);
 }
 
@@ -468,8 +519,11 @@ int sout_access_out_sys_t::url_cb(httpd_client_t *cl, httpd_message_t *answer,
         m_client = cl;
     }
 
-    /* Send data per 512kB minimum */
+    /* Send data per 512kB minimum. When remuxing, the data flows in fast
+     * enough: start serving right away. */
     size_t i_min_buffer = 524288;
+    if (m_fast_start && answer->i_body_offset == 0)
+        i_min_buffer = HTTPD_BUFFER_FAST_START;
     while (m_client && vlc_fifo_GetBytes(m_fifo) < i_min_buffer && !m_eof)
         vlc_fifo_Wait(m_fifo);
 
@@ -819,8 +873,12 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
     out_streams = new_streams;
     spu_streams_count = 0;
     transcoding_state = new_transcoding_state;
+    ts_offset = 0;
+    ts_origin = ts_last = VLC_TICK_INVALID;
+    ts_resync = false;
 
-    access_out_live.prepare( p_stream, mime );
+    const bool remux = new_transcoding_state == TRANSCODING_NONE;
+    access_out_live.prepare( p_stream, mime, remux );
 
     p_out = sout_StreamChainNew( p_stream->p_sout, sout.c_str(), NULL, NULL);
     if (p_out == NULL) {
@@ -863,9 +921,77 @@ bool sout_stream_sys_t::startSoutChain(sout_stream_t *p_stream,
      * what we encode) */
     p_intf->setRetryOnFail(transcodingCanFallback());
 
+    /* When remuxing, the data is ready as soon as the input is: load the
+     * Chromecast now, while the muxer outputs the header, rather than after
+     * the first blocks went through. */
+    if ( remux && out_streams_added >= out_streams.size() - spu_streams_count )
+    {
+        p_intf->setHasInput( mime );
+        cc_has_input = true;
+    }
+
     return true;
 }
 
+bool sout_stream_sys_t::canReuseSoutChain(sout_stream_t *p_stream) const
+{
+    /* The transcoder is flushed on seek anyway, only reuse remuxers */
+    return p_out != NULL && transcoding_state == TRANSCODING_NONE
+        && !es_changed
+        && var_InheritBool( p_stream, SOUT_CFG_PREFIX "fast-seek" );
+}
+
+void sout_stream_sys_t::flushSoutChain(sout_stream_t *p_stream)
+{
+    msg_Dbg( p_stream, "flushing the sout chain" );
+
+    for ( size_t i = 0; i < out_streams.size(); i++ )
+    {
+        if ( out_streams[i]->p_sub_id != NULL )
+            sout_StreamFlush( p_out, out_streams[i]->p_sub_id );
+    }
+
+    access_out_live.restart();
+
+    if ( cc_has_input )
+    {
+        p_intf->requestPlayerStop();
+        cc_has_input = false;
+    }
+    /* Restart from a keyframe, without going backward */
+    first_video_keyframe_pts = -1;
+    ts_resync = true;
+}
+
+void sout_stream_sys_t::shiftTimestamps(block_t *p_buffer)
+{
+    if ( ts_resync )
+    {
+        vlc_tick_t i_first = p_buffer->i_dts != VLC_TICK_INVALID
+                           ? p_buffer->i_dts : p_buffer->i_pts;
+        if ( i_first == VLC_TICK_INVALID )
+            return;
+        ts_offset = ts_last != VLC_TICK_INVALID
+                  ? ts_last + SEEK_TIMESTAMP_GAP - i_first : 0;
+        ts_resync = false;
+    }
+
+    for ( block_t *p = p_buffer; p != NULL; p = p->p_next )
+    {
+        if ( p->i_dts != VLC_TICK_INVALID )
+            p->i_dts += ts_offset;
+        if ( p->i_pts != VLC_TICK_INVALID )
+            p->i_pts += ts_offset;
+
+        vlc_tick_t i_end = p->i_pts != VLC_TICK_INVALID ? p->i_pts : p->i_dts;
+        if ( i_end == VLC_TICK_INVALID )
+            continue;
+        i_end += p->i_length;
+        if ( ts_last == VLC_TICK_INVALID || i_end > ts_last )
+            ts_last = i_end;
+    }
+}
+
 void sout_stream_sys_t::setNextTranscodingState()
 {
     if (!(transcoding_state & TRANSCODING_VIDEO))
@@ -1156,6 +1282,8 @@ static int Send(sout_stream_t *p_stream, void *_id, block_t *p_buffer)
         return VLC_EGENERIC;
     }
 
+    p_sys->shiftTimestamps( p_buffer );
+
     int ret = sout_StreamIdSend(p_sys->p_out, next_id, p_buffer);
     if (ret != VLC_SUCCESS)
         DelInternal(p_stream, id, false);
@@ -1178,6 +1306,12 @@ static void Flush( sout_stream_t *p_stream, void *_id )
     {
         p_sys->cc_flushing = true;
 
+        if( p_sys->canReuseSoutChain( p_stream ) )
+        {
+            p_sys->flushSoutChain( p_stream );
+            return;
+        }
+
         p_sys->stopSoutChain( p_stream );
 
         p_sys->access_out_live.stop();
@@ -174,7 +174,8 @@ struct intf_sys_t
     ~intf_sys_t();
 
     void setRetryOnFail(bool);
-    void setHasInput(const std::string mime_type = "");
+    void setHasInput(const std::string mime_type = "",
+                     vlc_tick_t time_base = 0);
 
     void setOnInputEventCb(on_input_event_itf on_input_event, void *on_input_event_data);
     void setDemuxEnabled(bool enabled, on_paused_changed_itf on_paused_changed,
@@ -301,6 +302,8 @@ private:
     vlc_tick_t        m_cc_time_last_request_date;
     vlc_tick_t        m_cc_time_date;
     vlc_tick_t        m_cc_time;
+    /* stream time of the first sample served (when the muxer is reused) */
+    vlc_tick_t        m_cc_time_base;
 
     /* shared structure with the demux-filter */
     chromecast_common      m_common;
@@ -116,6 +116,7 @@ intf_sys_t::intf_sys_t(vlc_object_t * const p_this, int port, std::string device
  , m_art_idx(0)
  , m_cc_time_date( VLC_TICK_INVALID )
  , m_cc_time( VLC_TICK_INVALID )
+ , m_cc_time_base( 0 )
  , m_pingRetriesLeft( PING_WAIT_RETRIES )
 {
     m_communication = new ChromecastCommunication( p_this,
@@ -376,7 +377,8 @@ void intf_sys_t::setRetryOnFail( bool enabled )
     m_retry_on_fail = enabled;
 }
 
-void intf_sys_t::setHasInput( const std::string mime_type )
+void intf_sys_t::setHasInput( const std::string mime_type,
+                              vlc_tick_t time_base )
 {
     vlc::threads::mutex_locker locker(m_lock);
     msg_Dbg( m_module, "Loading content" );
@@ -401,6 +403,7 @@ void intf_sys_t::setHasInput( const std::string mime_type )
     m_cc_time_last_request_date = VLC_TICK_INVALID;
     m_cc_time_date = VLC_TICK_INVALID;
     m_cc_time = VLC_TICK_INVALID;
+    m_cc_time_base = time_base;
     m_mediaSessionId = 0;
 
     tryLoad();
@@ -1177,7 +1180,10 @@ vlc_tick_t intf_sys_t::getPlaybackTimestamp()
                 m_last_request_id =
                     m_communication->msgPlayerGetStatus( m_appTransportId );
             }
-            return m_cc_time + now - m_cc_time_date;
+            vlc_tick_t cc_time = m_cc_time - m_cc_time_base;
+            if( cc_time < 0 )
+                cc_time = 0;
+            return cc_time + now - m_cc_time_date;
         }
         default:
             return VLC_TICK_INVALID;
@@ -305,7 +305,8 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
 
             if( id->pp_ids[i_stream] )
             {
-                block_t *p_dup = block_Duplicate( p_buffer );
+                /* Outputs only reference the payload, copied on write */
+                block_t *p_dup = block_Share( p_buffer );
 
                 if( p_dup )
                     sout_StreamIdSend( p_dup_stream, id->pp_ids[i_stream], p_dup );
@@ -0,0 +1,637 @@
+/*****************************************************************************
+ * fanout.c: shared input fan-out stream output
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *
+ * The "fanout" stream output publishes the elementary streams of one input
+ * under a name. Any number of other inputs can then open "fanout://<name>"
+ * and receive the same packets, without opening, demuxing or decoding the
+ * source again. This lets a VLM headend offer many outputs per ingest:
+ *
+ *  new ingest broadcast enabled input udp://@239.1.1.1:1234
+ *  setup ingest output #transcode{vcodec=h264}:fanout{name=ingest}
+ *  new hls broadcast enabled input fanout://ingest output #std{...}
+ *  new rec broadcast enabled input fanout://ingest output #std{...}
+ *
+ * Outputs that share the same transcoding settings should put the
+ * transcode before the fan-out, so that it runs only once.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+#define NAME_TEXT N_("Name")
+#define NAME_LONGTEXT N_( \
+    "Name under which the elementary streams are published. Other inputs " \
+    "receive them by opening fanout://<name>.")
+
+#define QUEUE_TEXT N_("Maximum queue size")
+#define QUEUE_LONGTEXT N_( \
+    "Maximum amount of data (in kilobytes) queued for each receiving " \
+    "input. Further packets are dropped until it catches up.")
+
+static int  Open     ( vlc_object_t * );
+static void Close    ( vlc_object_t * );
+static int  TapOpen  ( vlc_object_t * );
+static void TapClose ( vlc_object_t * );
+
+#define SOUT_CFG_PREFIX "sout-fanout-"
+
+vlc_module_begin ()
+    set_description( N_("Shared input fan-out stream output") )
+    set_capability( "sout output", 50 )
+    add_shortcut( "fanout" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_STREAM )
+    add_string( SOUT_CFG_PREFIX "name", "default", NAME_TEXT,
+                NAME_LONGTEXT, false )
+    add_integer( SOUT_CFG_PREFIX "queue", 16384, QUEUE_TEXT,
+                 QUEUE_LONGTEXT, true )
+        change_integer_range( 64, 1048576 )
+    set_callbacks( Open, Close )
+
+    add_submodule ()
+    set_shortname( N_("Fan-out") )
+    set_description( N_("Shared input fan-out receiver") )
+    set_category( CAT_INPUT )
+    set_subcategory( SUBCAT_INPUT_ACCESS )
+    set_capability( "access", 0 )
+    add_shortcut( "fanout" )
+    set_callbacks( TapOpen, TapClose )
+vlc_module_end ()
+
+static const char *const ppsz_sout_options[] = {
+    "name", "queue", NULL
+};
+
+/*****************************************************************************
+ * Shared hubs
+ *****************************************************************************/
+enum
+{
+    FANOUT_ES_ADD,
+    FANOUT_ES_DEL,
+    FANOUT_ES_DATA,
+};
+
+struct fanout_item
+{
+    struct fanout_item *p_next;
+    int                 i_type;
+    unsigned            i_id;
+    es_format_t         fmt;   /* FANOUT_ES_ADD */
+    block_t            *p_block; /* FANOUT_ES_DATA */
+};
+
+/* Receiving end, owned by one fanout:// input */
+struct fanout_tap
+{
+    vlc_mutex_t          lock;
+    vlc_cond_t           wait;
+    struct fanout_item  *p_first;
+    struct fanout_item **pp_last;
+    size_t               i_bytes;
+    bool                 b_overflow;
+};
+
+struct fanout_es
+{
+    unsigned    i_id;
+    es_format_t fmt;
+};
+
+struct fanout_hub
+{
+    struct fanout_hub *p_next;
+    char              *psz_name;
+    unsigned           i_refs;
+
+    /* Protected by the hub lock */
+    vlc_mutex_t        lock;
+    bool               b_published;
+    unsigned           i_last_id;
+    int                i_es;
+    struct fanout_es **pp_es;
+    int                i_taps;
+    struct fanout_tap **pp_taps;
+};
+
+static vlc_mutex_t hubs_lock = VLC_STATIC_MUTEX;
+static struct fanout_hub *hubs = NULL;
+
+static struct fanout_hub *HubHold( const char *psz_name )
+{
+    struct fanout_hub *p_hub;
+
+    vlc_mutex_lock( &hubs_lock );
+    for( p_hub = hubs; p_hub != NULL; p_hub = p_hub->p_next )
+        if( !strcmp( p_hub->psz_name, psz_name ) )
+            break;
+
+    if( p_hub == NULL )
+    {
+        p_hub = malloc( sizeof( *p_hub ) );
+        if( p_hub == NULL || (p_hub->psz_name = strdup( psz_name )) == NULL )
+        {
+            free( p_hub );
+            vlc_mutex_unlock( &hubs_lock );
+            return NULL;
+        }
+        p_hub->i_refs = 0;
+        vlc_mutex_init( &p_hub->lock );
+        p_hub->b_published = false;
+        p_hub->i_last_id = 0;
+        TAB_INIT( p_hub->i_es, p_hub->pp_es );
+        TAB_INIT( p_hub->i_taps, p_hub->pp_taps );
+        p_hub->p_next = hubs;
+        hubs = p_hub;
+    }
+    p_hub->i_refs++;
+    vlc_mutex_unlock( &hubs_lock );
+    return p_hub;
+}
+
+static void HubRelease( struct fanout_hub *p_hub )
+{
+    vlc_mutex_lock( &hubs_lock );
+    if( --p_hub->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &hubs_lock );
+        return;
+    }
+
+    for( struct fanout_hub **pp = &hubs; *pp != NULL; pp = &(*pp)->p_next )
+        if( *pp == p_hub )
+        {
+            *pp = p_hub->p_next;
+            break;
+        }
+    vlc_mutex_unlock( &hubs_lock );
+
+    assert( p_hub->i_es == 0 && p_hub->i_taps == 0 );
+    TAB_CLEAN( p_hub->i_es, p_hub->pp_es );
+    TAB_CLEAN( p_hub->i_taps, p_hub->pp_taps );
+    free( p_hub->psz_name );
+    free( p_hub );
+}
+
+static void ItemDelete( struct fanout_item *p_item )
+{
+    if( p_item->i_type == FANOUT_ES_ADD )
+        es_format_Clean( &p_item->fmt );
+    if( p_item->p_block != NULL )
+        block_Release( p_item->p_block );
+    free( p_item );
+}
+
+/* Queues an item for a tap. The hub lock must be held.
+ * Returns false if it was dropped. */
+static bool TapPush( struct fanout_tap *p_tap, int i_type, unsigned i_id,
+                     const es_format_t *p_fmt, block_t *p_block,
+                     size_t i_max )
+{
+    struct fanout_item *p_item = malloc( sizeof( *p_item ) );
+    if( unlikely(p_item == NULL) )
+        goto error;
+
+    p_item->p_next = NULL;
+    p_item->i_type = i_type;
+    p_item->i_id = i_id;
+    p_item->p_block = p_block;
+    if( p_fmt != NULL && es_format_Copy( &p_item->fmt, p_fmt ) )
+    {
+        free( p_item );
+        goto error;
+    }
+
+    vlc_mutex_lock( &p_tap->lock );
+    if( p_block != NULL )
+    {
+        if( p_tap->i_bytes + p_block->i_buffer > i_max )
+        {
+            p_tap->b_overflow = true;
+            vlc_mutex_unlock( &p_tap->lock );
+            p_item->p_block = NULL;
+            ItemDelete( p_item );
+            goto error;
+        }
+        p_tap->i_bytes += p_block->i_buffer;
+    }
+    *p_tap->pp_last = p_item;
+    p_tap->pp_last = &p_item->p_next;
+    vlc_cond_signal( &p_tap->wait );
+    vlc_mutex_unlock( &p_tap->lock );
+    return true;
+
+error:
+    if( p_block != NULL )
+        block_Release( p_block );
+    return false;
+}
+
+/*****************************************************************************
+ * Stream output
+ *****************************************************************************/
+typedef struct
+{
+    struct fanout_hub *p_hub;
+    size_t             i_max;
+    bool               b_overflow;
+} sout_stream_sys_t;
+
+static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+    struct fanout_es *p_es = malloc( sizeof( *p_es ) );
+
+    if( unlikely(p_es == NULL) )
+        return NULL;
+    if( es_format_Copy( &p_es->fmt, p_fmt ) )
+    {
+        free( p_es );
+        return NULL;
+    }
+
+    vlc_mutex_lock( &p_hub->lock );
+    p_es->i_id = ++p_hub->i_last_id;
+    TAB_APPEND( p_hub->i_es, p_hub->pp_es, p_es );
+    for( int i = 0; i < p_hub->i_taps; i++ )
+        TapPush( p_hub->pp_taps[i], FANOUT_ES_ADD, p_es->i_id, p_fmt, NULL,
+                 p_sys->i_max );
+    vlc_mutex_unlock( &p_hub->lock );
+
+    msg_Dbg( p_stream, "publishing %4.4s stream %u on `%s'",
+             (const char *)&p_fmt->i_codec, p_es->i_id, p_hub->psz_name );
+    return p_es;
+}
+
+static void Del( sout_stream_t *p_stream, void *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+    struct fanout_es *p_es = id;
+
+    vlc_mutex_lock( &p_hub->lock );
+    TAB_REMOVE( p_hub->i_es, p_hub->pp_es, p_es );
+    for( int i = 0; i < p_hub->i_taps; i++ )
+        TapPush( p_hub->pp_taps[i], FANOUT_ES_DEL, p_es->i_id, NULL, NULL,
+                 p_sys->i_max );
+    vlc_mutex_unlock( &p_hub->lock );
+
+    es_format_Clean( &p_es->fmt );
+    free( p_es );
+}
+
+static int Send( sout_stream_t *p_stream, void *id, block_t *p_buffer )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+    struct fanout_es *p_es = id;
+    bool b_overflow = false;
+
+    vlc_mutex_lock( &p_hub->lock );
+    while( p_buffer != NULL )
+    {
+        block_t *p_next = p_buffer->p_next;
+
+        p_buffer->p_next = NULL;
+        for( int i = 0; i < p_hub->i_taps; i++ )
+        {
+            struct fanout_tap *p_tap = p_hub->pp_taps[i];
+            /* Receivers reference the payload, and copy it on their own
+             * thread if needed */
+            block_t *p_dup = (i < p_hub->i_taps - 1) ? block_Share( p_buffer )
+                                                     : p_buffer;
+
+            if( p_dup == NULL )
+                continue;
+            if( !TapPush( p_tap, FANOUT_ES_DATA, p_es->i_id, NULL, p_dup,
+                          p_sys->i_max ) )
+                b_overflow = true;
+            if( p_dup == p_buffer )
+                p_buffer = NULL;
+        }
+        if( p_buffer != NULL )
+            block_Release( p_buffer );
+        p_buffer = p_next;
+    }
+    vlc_mutex_unlock( &p_hub->lock );
+
+    if( b_overflow && !p_sys->b_overflow )
+        msg_Warn( p_stream, "receiver of `%s' too slow, dropping packets",
+                  p_hub->psz_name );
+    p_sys->b_overflow = b_overflow;
+    return VLC_SUCCESS;
+}
+
+static const struct sout_stream_operations ops = {
+    .add = Add,
+    .del = Del,
+    .send = Send,
+};
+
+static int Open( vlc_object_t *p_this )
+{
+    sout_stream_t     *p_stream = (sout_stream_t *)p_this;
+    sout_stream_sys_t *p_sys;
+
+    config_ChainParse( p_stream, SOUT_CFG_PREFIX, ppsz_sout_options,
+                       p_stream->p_cfg );
+
+    p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    char *psz_name = var_GetNonEmptyString( p_stream, SOUT_CFG_PREFIX "name" );
+    if( psz_name == NULL )
+    {
+        msg_Err( p_stream, "no fan-out name given" );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->p_hub = HubHold( psz_name );
+    free( psz_name );
+    if( p_sys->p_hub == NULL )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    struct fanout_hub *p_hub = p_sys->p_hub;
+    bool b_busy;
+
+    vlc_mutex_lock( &p_hub->lock );
+    b_busy = p_hub->b_published;
+    p_hub->b_published = true;
+    vlc_mutex_unlock( &p_hub->lock );
+    if( b_busy )
+    {
+        msg_Err( p_stream, "fan-out `%s' already published",
+                 p_hub->psz_name );
+        HubRelease( p_hub );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->i_max = var_GetInteger( p_stream, SOUT_CFG_PREFIX "queue" ) * 1024;
+    p_sys->b_overflow = false;
+
+    msg_Dbg( p_stream, "publishing fan-out `%s'", p_hub->psz_name );
+    p_stream->ops = &ops;
+    p_stream->p_sys = p_sys;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    sout_stream_t     *p_stream = (sout_stream_t *)p_this;
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+
+    vlc_mutex_lock( &p_hub->lock );
+    assert( p_hub->i_es == 0 );
+    p_hub->b_published = false;
+    vlc_mutex_unlock( &p_hub->lock );
+
+    HubRelease( p_hub );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Receiving input
+ *****************************************************************************/
+struct fanout_tap_es
+{
+    unsigned     i_id;
+    es_out_id_t *p_es;
+};
+
+typedef struct
+{
+    struct fanout_hub     *p_hub;
+    struct fanout_tap      tap;
+    int                    i_es;
+    struct fanout_tap_es **pp_es;
+    vlc_tick_t             i_pcr;
+} demux_sys_t;
+
+static struct fanout_tap_es *TapFindES( demux_sys_t *p_sys, unsigned i_id )
+{
+    for( int i = 0; i < p_sys->i_es; i++ )
+        if( p_sys->pp_es[i]->i_id == i_id )
+            return p_sys->pp_es[i];
+    return NULL;
+}
+
+static void TapProcess( demux_t *p_demux, struct fanout_item *p_item )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    struct fanout_tap_es *p_es = TapFindES( p_sys, p_item->i_id );
+
+    switch( p_item->i_type )
+    {
+        case FANOUT_ES_ADD:
+            p_es = malloc( sizeof( *p_es ) );
+            if( unlikely(p_es == NULL) )
+                break;
+            p_es->i_id = p_item->i_id;
+            p_es->p_es = es_out_Add( p_demux->out, &p_item->fmt );
+            if( p_es->p_es == NULL )
+            {
+                free( p_es );
+                break;
+            }
+            TAB_APPEND( p_sys->i_es, p_sys->pp_es, p_es );
+            break;
+
+        case FANOUT_ES_DEL:
+            if( p_es == NULL )
+                break;
+            es_out_Del( p_demux->out, p_es->p_es );
+            TAB_REMOVE( p_sys->i_es, p_sys->pp_es, p_es );
+            free( p_es );
+            break;
+
+        case FANOUT_ES_DATA:
+        {
+            block_t *p_block = p_item->p_block;
+
+            if( p_es == NULL )
+                break;
+            p_item->p_block = NULL;
+            /* The packetizers and decoders of this input own the packet and
+             * may write to it: copy it, unless the other receivers are done
+             * with it */
+            p_block = block_Unshare( p_block );
+            if( unlikely(p_block == NULL) )
+                break;
+            /* Packets are relayed as they come: the reference clock simply
+             * follows the decoding timestamps */
+            if( p_block->i_dts != VLC_TICK_INVALID
+             && (p_sys->i_pcr == VLC_TICK_INVALID
+              || p_block->i_dts > p_sys->i_pcr) )
+            {
+                p_sys->i_pcr = p_block->i_dts;
+                es_out_SetPCR( p_demux->out, p_sys->i_pcr );
+            }
+            es_out_Send( p_demux->out, p_es->p_es, p_block );
+            break;
+        }
+    }
+    ItemDelete( p_item );
+}
+
+static int Demux( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    struct fanout_tap *p_tap = &p_sys->tap;
+    struct fanout_item *p_items;
+    bool b_overflow;
+
+    vlc_mutex_lock( &p_tap->lock );
+    if( p_tap->p_first == NULL )
+        vlc_cond_timedwait( &p_tap->wait, &p_tap->lock,
+                            vlc_tick_now() + VLC_TICK_FROM_MS(50) );
+    p_items = p_tap->p_first;
+    p_tap->p_first = NULL;
+    p_tap->pp_last = &p_tap->p_first;
+    p_tap->i_bytes = 0;
+    b_overflow = p_tap->b_overflow;
+    p_tap->b_overflow = false;
+    vlc_mutex_unlock( &p_tap->lock );
+
+    if( b_overflow )
+        msg_Warn( p_demux, "packets lost (too slow)" );
+
+    while( p_items != NULL )
+    {
+        struct fanout_item *p_next = p_items->p_next;
+
+        TapProcess( p_demux, p_items );
+        p_items = p_next;
+    }
+    return VLC_DEMUXER_SUCCESS;
+}
+
+static int Control( demux_t *p_demux, int i_query, va_list args )
+{
+    switch( i_query )
+    {
+        case DEMUX_GET_PTS_DELAY:
+            *va_arg( args, vlc_tick_t * ) =
+                VLC_TICK_FROM_MS( var_InheritInteger( p_demux, "live-caching" ) );
+            return VLC_SUCCESS;
+
+        case DEMUX_CAN_PAUSE:
+        case DEMUX_CAN_CONTROL_PACE:
+        case DEMUX_CAN_CONTROL_RATE:
+        case DEMUX_CAN_SEEK:
+            *va_arg( args, bool * ) = false;
+            return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+static int TapOpen( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t *)p_this;
+
+    if( p_demux->out == NULL || p_demux->psz_location == NULL
+     || p_demux->psz_location[0] == '\0' )
+        return VLC_EGENERIC;
+
+    demux_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->p_hub = HubHold( p_demux->psz_location );
+    if( p_sys->p_hub == NULL )
+    {
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    struct fanout_tap *p_tap = &p_sys->tap;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+
+    vlc_mutex_init( &p_tap->lock );
+    vlc_cond_init( &p_tap->wait );
+    p_tap->p_first = NULL;
+    p_tap->pp_last = &p_tap->p_first;
+    p_tap->i_bytes = 0;
+    p_tap->b_overflow = false;
+    TAB_INIT( p_sys->i_es, p_sys->pp_es );
+    p_sys->i_pcr = VLC_TICK_INVALID;
+
+    /* Catch up with the streams already published, if any. Until the
+     * source is started, the input just waits for it. */
+    vlc_mutex_lock( &p_hub->lock );
+    for( int i = 0; i < p_hub->i_es; i++ )
+        TapPush( p_tap, FANOUT_ES_ADD, p_hub->pp_es[i]->i_id,
+                 &p_hub->pp_es[i]->fmt, NULL, 0 );
+    TAB_APPEND( p_hub->i_taps, p_hub->pp_taps, p_tap );
+    if( !p_hub->b_published )
+        msg_Dbg( p_demux, "waiting for fan-out `%s'", p_hub->psz_name );
+    vlc_mutex_unlock( &p_hub->lock );
+
+    p_demux->pf_demux = Demux;
+    p_demux->pf_control = Control;
+    p_demux->p_sys = p_sys;
+    return VLC_SUCCESS;
+}
+
+static void TapClose( vlc_object_t *p_this )
+{
+    demux_t *p_demux = (demux_t *)p_this;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    struct fanout_hub *p_hub = p_sys->p_hub;
+
+    vlc_mutex_lock( &p_hub->lock );
+    TAB_REMOVE( p_hub->i_taps, p_hub->pp_taps, &p_sys->tap );
+    vlc_mutex_unlock( &p_hub->lock );
+    HubRelease( p_hub );
+
+    for( struct fanout_item *p_item = p_sys->tap.p_first, *p_next;
+         p_item != NULL; p_item = p_next )
+    {
+        p_next = p_item->p_next;
+        ItemDelete( p_item );
+    }
+    for( int i = 0; i < p_sys->i_es; i++ )
+        free( p_sys->pp_es[i] );
+    TAB_CLEAN( p_sys->i_es, p_sys->pp_es );
+    free( p_sys );
+}
@@ -587,6 +587,14 @@ static int Send( sout_stream_t *p_stream, void *id, block_t *p_buffer )
         return VLC_SUCCESS;
     }
 
+    /* Decoders may write to their input */
+    if( p_buffer )
+    {
+        p_buffer = block_Unshare( p_buffer );
+        if( unlikely(p_buffer == NULL) )
+            return VLC_ENOMEM;
+    }
+
     int ret = p_sys->p_decoder->pf_decode( p_sys->p_decoder, p_buffer );
     return ret == VLCDEC_SUCCESS ? VLC_SUCCESS : VLC_EGENERIC;
 }
@@ -49,6 +49,10 @@ static void     Close   ( vlc_object_t * );
 #define DST_PREFIX_TEXT N_("Destination prefix")
 #define DST_PREFIX_LONGTEXT N_( \
     "Prefix of the destination file automatically generated" )
+#define BUFFER_TEXT N_("Write buffer size (KiB)")
+#define BUFFER_LONGTEXT N_( \
+    "Size of the buffer used to write the recording from a separate " \
+    "thread. 0 writes synchronously." )
 
 #define SOUT_CFG_PREFIX "sout-record-"
 
@@ -63,6 +67,9 @@ vlc_module_begin ()
 
     add_string( SOUT_CFG_PREFIX "dst-prefix", "", DST_PREFIX_TEXT,
                 DST_PREFIX_LONGTEXT, true )
+    add_integer( SOUT_CFG_PREFIX "buffer", 4096, BUFFER_TEXT,
+                 BUFFER_LONGTEXT, true )
+        change_integer_range( 0, 1024 * 1024 )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -70,6 +77,7 @@ vlc_module_end ()
 /* */
 static const char *const ppsz_sout_options[] = {
     "dst-prefix",
+    "buffer",
     NULL
 };
 
@@ -95,6 +103,7 @@ struct sout_stream_id_sys_t
 typedef struct
 {
     char *psz_prefix;
+    int64_t i_buffer;
 
     sout_stream_t *p_out;
 
@@ -144,6 +153,7 @@ static int Open( vlc_object_t *p_this )
         }
     }
 
+    p_sys->i_buffer = var_GetInteger( p_stream, SOUT_CFG_PREFIX "buffer" );
     p_sys->i_date_start = VLC_TICK_INVALID;
     p_sys->i_size = 0;
 #ifdef OPTIMIZE_MEMORY
@@ -336,8 +346,9 @@ static int OutputNew( sout_stream_t *p_stream,
     free( psz_tmp );
 
     if( asprintf( &psz_output,
-                  "std{access=file{no-append,no-format,no-overwrite},"
-                  "mux=%s,dst='%s'}", psz_muxer, psz_file ) < 0 )
+                  "std{access=file{no-append,no-format,no-overwrite,"
+                  "buffer=%"PRId64"},mux=%s,dst='%s'}",
+                  p_sys->i_buffer, psz_muxer, psz_file ) < 0 )
     {
         psz_output = NULL;
         goto error;
@@ -52,7 +52,8 @@
  * - it is assumed we_sent = true (could be wrong), since we are THE sender,
  * - we always send SR + SDES, while running,
  * - FIXME: we do not implement separate rate limiting for SDES,
- * - we do not implement any profile-specific extensions for the time being.
+ * - we do not implement any profile-specific extensions for the time being,
+ * - the report blocks about us from the receiver are only logged.
  */
 struct rtcp_sender_t
 {
@@ -63,6 +64,9 @@ struct rtcp_sender_t
     uint32_t packets; /* RTP packets sent */
     uint32_t bytes;   /* RTP bytes sent */
     unsigned counter; /* RTP packets sent since last RTCP packet */
+
+    vlc_object_t *obj;
+    char     peer[NI_MAXNUMERICHOST]; /* receiver, for the reports */
 };
 
 
@@ -111,15 +115,15 @@ rtcp_sender_t *OpenRTCP (vlc_object_t *obj, int rtp_fd, int proto,
 
             if (!getsockopt (rtp_fd, SOL_IP, IP_MULTICAST_TTL, &ttl, &len))
                 setsockopt (fd, SOL_IP, IP_MULTICAST_TTL, &ttl, len);
-
-            /* Ignore all incoming RTCP-RR packets */
-            setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &(int){ 0 }, sizeof (int));
         }
     }
 
     if (fd == -1)
         return NULL;
 
+    /* Only keep a few incoming RTCP-RR packets, read along the SR */
+    setsockopt (fd, SOL_SOCKET, SO_RCVBUF, &(int){ 4096 }, sizeof (int));
+
     rtcp = malloc (sizeof (*rtcp));
     if (rtcp == NULL)
     {
@@ -129,6 +133,11 @@ rtcp_sender_t *OpenRTCP (vlc_object_t *obj, int rtp_fd, int proto,
 
     rtcp->handle = fd;
     rtcp->bytes = rtcp->packets = rtcp->counter = 0;
+    rtcp->obj = obj;
+
+    int dport;
+    if (net_GetPeerAddress (rtp_fd, rtcp->peer, &dport))
+        strcpy (rtcp->peer, "?");
 
     ptr = (uint8_t *)strchr (src, '%');
     if (ptr != NULL)
@@ -199,6 +208,55 @@ void CloseRTCP (rtcp_sender_t *rtcp)
 }
 
 
+/* Logs a report block of the receiver about our source */
+static void ReportRTCP (rtcp_sender_t *restrict rtcp, const uint8_t *rb)
+{
+    int32_t lost = GetDWBE (rb + 4) & 0xffffff;
+    if (lost & 0x800000)
+        lost -= 0x1000000;
+
+    /* The round trip time cannot be told, as reports are not read as soon
+     * as they arrive */
+    msg_Dbg (rtcp->obj, "receiver %s: %u%% lost (%"PRId32" total), "
+             "sequence %"PRIu32", jitter %"PRIu32, rtcp->peer,
+             (rb[4] * 100) >> 8, lost, GetDWBE (rb + 8), GetDWBE (rb + 12));
+}
+
+/* Reads the RTCP packets queued by the receiver, if any */
+static void ReceiveRTCP (rtcp_sender_t *restrict rtcp)
+{
+#ifdef MSG_DONTWAIT
+    uint8_t buf[1500];
+    ssize_t len;
+
+    while ((len = recv (rtcp->handle, buf, sizeof (buf), MSG_DONTWAIT)) > 0)
+    {
+        const uint8_t *ptr = buf, *end = buf + len;
+
+        while (end - ptr >= 8)
+        {
+            size_t size = 4 * (GetWBE (ptr + 2) + 1);
+            if ((ptr[0] >> 6) != 2 || size > (size_t)(end - ptr))
+                break; /* not RTCP */
+
+            /* Receiver Report, or Sender Report of a sending receiver */
+            if (ptr[1] == 200 || ptr[1] == 201)
+            {
+                const uint8_t *rb = ptr + ((ptr[1] == 200) ? 28 : 8);
+
+                for (unsigned i = 0; i < (ptr[0] & 0x1f)
+                                  && rb + 24 <= ptr + size; i++, rb += 24)
+                    if (!memcmp (rb, rtcp->payload + 4, 4))
+                        ReportRTCP (rtcp, rb);
+            }
+            ptr += size;
+        }
+    }
+#else
+    VLC_UNUSED(rtcp);
+#endif
+}
+
 void SendRTCP (rtcp_sender_t *restrict rtcp, const block_t *rtp)
 {
     if ((rtcp == NULL) /* RTCP sender off */
@@ -229,4 +287,6 @@ void SendRTCP (rtcp_sender_t *restrict rtcp, const block_t *rtp)
 
     if (send (rtcp->handle, ptr, rtcp->length, 0) == (ssize_t)rtcp->length)
         rtcp->counter = 0;
+
+    ReceiveRTCP (rtcp);
 }
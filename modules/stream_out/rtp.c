@@ -152,6 +152,12 @@ static const char *const ppsz_protocols[] = {
     "DCCP", "SCTP", "TCP", "UDP", "UDP-Lite",
 };
 
+#define BATCH_TEXT N_("Batching window (ms)")
+#define BATCH_LONGTEXT N_( \
+    "All packets due within this time window, usually those of a same " \
+    "frame, are sent to each destination with a single system call. " \
+    "0 disables batching." )
+
 #define RFC3016_TEXT N_("MP4A LATM")
 #define RFC3016_LONGTEXT N_( \
     "This allows you to stream MPEG4 LATM audio streams (see RFC3016)." )
@@ -174,6 +180,8 @@ static void Close( vlc_object_t * );
 
 #define SOUT_CFG_PREFIX "sout-rtp-"
 #define MAX_EMPTY_BLOCKS 200
+/* Upper bound on the number of packets sent by a single system call */
+#define BATCH_MAX 64
 
 vlc_module_begin ()
     set_shortname( N_("RTP"))
@@ -217,6 +225,10 @@ vlc_module_begin ()
               RTCP_MUX_TEXT, RTCP_MUX_LONGTEXT, false )
     add_integer( SOUT_CFG_PREFIX "caching", MS_FROM_VLC_TICK(DEFAULT_PTS_DELAY),
                  CACHING_TEXT, CACHING_LONGTEXT, true )
+#ifdef HAVE_SENDMMSG
+    add_integer( SOUT_CFG_PREFIX "batch", 0, BATCH_TEXT, BATCH_LONGTEXT,
+                 true )
+#endif
 
 #ifdef HAVE_SRTP
     add_string( SOUT_CFG_PREFIX "key", "",
@@ -237,6 +249,9 @@ vlc_module_end ()
 static const char *const ppsz_sout_options[] = {
     "dst", "name", "cat", "port", "port-audio", "port-video", "*sdp", "ttl",
     "mux", "sap", "description", "proto", "rtcp-mux", "caching",
+#ifdef HAVE_SENDMMSG
+    "batch",
+#endif
 #ifdef HAVE_SRTP
     "key", "salt",
 #endif
@@ -253,6 +268,9 @@ static int   MuxSend( sout_stream_t *, void *, block_t * );
 
 static sout_access_out_t *GrabberCreate( sout_stream_t *p_sout );
 static void* ThreadSend( void * );
+#ifdef HAVE_SENDMMSG
+static void* ThreadSendBatch( void * );
+#endif
 static void *rtp_listen_thread( void * );
 
 static void SDPHandleUrl( sout_stream_t *, const char * );
@@ -351,6 +369,9 @@ struct sout_stream_id_sys_t
     } listen;
 
     vlc_tick_t        i_caching;
+#ifdef HAVE_SENDMMSG
+    vlc_tick_t        i_batch;
+#endif
 };
 
 /*****************************************************************************
@@ -924,6 +945,10 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
     id->b_first_packet = true;
     id->i_caching =
         VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "caching"));
+#ifdef HAVE_SENDMMSG
+    id->i_batch =
+        VLC_TICK_FROM_MS(var_GetInteger( p_stream, SOUT_CFG_PREFIX "batch"));
+#endif
 
     vlc_rand_bytes (&id->i_sequence, sizeof (id->i_sequence));
     vlc_rand_bytes (id->ssrc, sizeof (id->ssrc));
@@ -1103,8 +1128,14 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
         id->rtsp_id = RtspAddId( p_sys->rtsp, id, GetDWBE( id->ssrc ),
                                  id->rtp_fmt.clock_rate, mcast_fd );
 
+    void *(*entry)(void *) = ThreadSend;
+#ifdef HAVE_SENDMMSG
+    if( id->i_batch > 0 )
+        entry = ThreadSendBatch;
+#endif
+
     id->dead = false;
-    if( vlc_clone( &id->thread, ThreadSend, id, VLC_THREAD_PRIORITY_HIGHEST ) )
+    if( vlc_clone( &id->thread, entry, id, VLC_THREAD_PRIORITY_HIGHEST ) )
     {
         id->dead = true;
         goto error;
@@ -1304,13 +1335,64 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( void *data )
-{
 #ifdef _WIN32
 # define ENOBUFS      WSAENOBUFS
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+#ifdef HAVE_SRTP
+/* Protects a packet in place, returns NULL if it cannot be sent */
+static block_t *rtp_protect( sout_stream_id_sys_t *id, block_t *out )
+{
+    /* FIXME: this is awfully inefficient */
+    size_t len = out->i_buffer;
+    out = block_Realloc( out, 0, len + 10 );
+    if( unlikely(out == NULL) )
+        return NULL;
+    out->i_buffer = len;
+
+    int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
+    if( val )
+    {
+        msg_Dbg( id->p_stream, "SRTP sending error: %s",
+                 vlc_strerror_c(val) );
+        block_Release( out );
+        return NULL;
+    }
+    out->i_buffer = len;
+    return out;
+}
+#endif
+
+/* Handles a failed send of a packet to a sink, returns false if the sink
+ * is broken */
+static bool rtp_sink_error( const rtp_sink_t *sink, const block_t *out )
+{
+    switch( net_errno )
+    {
+        case EAGAIN:
+#if (EWOULDBLOCK != EAGAIN)
+        case EWOULDBLOCK:
+#endif
+        case ENOBUFS:
+        case ENOMEM:
+            return true;
+    }
+
+    int type;
+    getsockopt( sink->rtp_fd, SOL_SOCKET, SO_TYPE,
+                &type, &(socklen_t){ sizeof(type) });
+    if( type != SOCK_DGRAM )
+        return false; /* Broken connection */
+
+    /* ICMP soft error: ignore and retry */
+    send( sink->rtp_fd, out->p_buffer, out->i_buffer, 0 );
+    return true;
+}
+
+static void* ThreadSend( void *data )
+{
     sout_stream_id_sys_t *id = data;
     vlc_tick_t i_caching = id->i_caching;
     block_t *out;
@@ -1319,20 +1401,10 @@ static void* ThreadSend( void *data )
     {
 #ifdef HAVE_SRTP
         if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
-
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            if( val )
-            {
-                msg_Dbg( id->p_stream, "SRTP sending error: %s",
-                         vlc_strerror_c(val) );
-                block_Release( out );
+        {
+            out = rtp_protect( id, out );
+            if( out == NULL )
                 continue;
-            }
-            out->i_buffer = len;
         }
 #endif
         vlc_tick_wait (out->i_dts + i_caching);
@@ -1351,19 +1423,8 @@ static void* ThreadSend( void *data )
                 SendRTCP( id->sinkv[i].rtcp, out );
 
             if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) == -1
-             && net_errno != EAGAIN && net_errno != EWOULDBLOCK
-             && net_errno != ENOBUFS && net_errno != ENOMEM )
-            {
-                int type;
-                getsockopt( id->sinkv[i].rtp_fd, SOL_SOCKET, SO_TYPE,
-                            &type, &(socklen_t){ sizeof(type) });
-                if( type == SOCK_DGRAM )
-                    /* ICMP soft error: ignore and retry */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                else
-                    /* Broken connection */
-                    deadv[deadc++] = id->sinkv[i].rtp_fd;
-            }
+             && !rtp_sink_error( &id->sinkv[i], out ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
         }
         id->i_seq_sent_next = ntohs(((uint16_t *) out->p_buffer)[1]) + 1;
         vlc_mutex_unlock( &id->lock_sink );
@@ -1378,6 +1439,113 @@ static void* ThreadSend( void *data )
     return NULL;
 }
 
+#ifdef HAVE_SENDMMSG
+/* Sends a batch of packets to a sink, returns false if the sink is broken */
+static bool rtp_sink_send_batch( const rtp_sink_t *sink, struct mmsghdr *msgs,
+                                 block_t *const *pkts, unsigned count )
+{
+    for( unsigned i = 0; i < count; )
+    {
+        int val = sendmmsg( sink->rtp_fd, msgs + i, count - i, 0 );
+        if( val > 0 )
+            i += val;
+        else if( rtp_sink_error( sink, pkts[i] ) )
+            i++; /* skip the packet that failed */
+        else
+            return false;
+    }
+    return true;
+}
+
+/* Same as ThreadSend(), but the packets due within the batching window are
+ * sent at once, with a single system call per sink */
+static void* ThreadSendBatch( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+    vlc_tick_t i_caching = id->i_caching;
+    block_t *batch[BATCH_MAX];
+    struct iovec iov[BATCH_MAX];
+    struct mmsghdr msgs[BATCH_MAX];
+    block_t *out = NULL;
+
+    for( ;; )
+    {
+        if( out == NULL )
+        {
+            out = vlc_queue_DequeueKillable(&id->queue, &id->dead);
+            if( out == NULL )
+                break;
+        }
+
+        const vlc_tick_t i_date = out->i_dts + i_caching;
+        vlc_tick_wait( i_date );
+
+        unsigned count = 0;
+        do
+        {
+            batch[count++] = out;
+
+            vlc_queue_Lock( &id->queue );
+            out = vlc_queue_DequeueUnlocked( &id->queue );
+            vlc_queue_Unlock( &id->queue );
+        }
+        while( out != NULL && count < BATCH_MAX
+            && out->i_dts + i_caching <= i_date + id->i_batch );
+
+#ifdef HAVE_SRTP
+        if( id->srtp )
+        {
+            unsigned n = 0;
+            for( unsigned i = 0; i < count; i++ )
+                if( (batch[n] = rtp_protect( id, batch[i] )) != NULL )
+                    n++;
+            count = n;
+            if( count == 0 )
+                continue;
+        }
+#endif
+
+        memset( msgs, 0, count * sizeof (*msgs) );
+        for( unsigned i = 0; i < count; i++ )
+        {
+            iov[i].iov_base = batch[i]->p_buffer;
+            iov[i].iov_len = batch[i]->i_buffer;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        vlc_mutex_lock( &id->lock_sink );
+        unsigned deadc = 0; /* How many dead sockets? */
+        int deadv[id->sinkc ? id->sinkc : 1]; /* Dead sockets list */
+
+        for( int i = 0; i < id->sinkc; i++ )
+        {
+#ifdef HAVE_SRTP
+            if( !id->srtp ) /* FIXME: SRTCP support */
+#endif
+                for( unsigned j = 0; j < count; j++ )
+                    SendRTCP( id->sinkv[i].rtcp, batch[j] );
+
+            if( !rtp_sink_send_batch( &id->sinkv[i], msgs, batch, count ) )
+                deadv[deadc++] = id->sinkv[i].rtp_fd;
+        }
+        id->i_seq_sent_next =
+            ntohs(((uint16_t *) batch[count - 1]->p_buffer)[1]) + 1;
+        vlc_mutex_unlock( &id->lock_sink );
+
+        for( unsigned i = 0; i < count; i++ )
+            block_Release( batch[i] );
+
+        for( unsigned i = 0; i < deadc; i++ )
+        {
+            msg_Dbg( id->p_stream, "removing socket %d", deadv[i] );
+            rtp_del_sink( id, deadv[i] );
+        }
+    }
+    return NULL;
+}
+#endif
+
 
 /* This thread dequeues incoming connections (DCCP streaming) */
 static void *rtp_listen_thread( void *data )
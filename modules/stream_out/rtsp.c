@@ -65,9 +65,10 @@ struct rtsp_stream_t
     unsigned        track_id;
 
     int             sessionc;
-    rtsp_session_t **sessionv;
+    rtsp_session_t **sessionv; /* sorted by session ID */
 
     vlc_tick_t      timeout;
+    vlc_tick_t      deadline; /* armed time-out, or 0 */
     vlc_timer_t     timer;
 };
 
@@ -147,6 +148,7 @@ void RtspUnsetup( rtsp_stream_t *rtsp )
     if (rtsp->timeout != 0)
         vlc_timer_destroy(rtsp->timer);
 
+    free( rtsp->sessionv );
     free( rtsp->psz_path );
     free( rtsp );
 }
@@ -312,6 +314,7 @@ static void RtspUpdateTimer( rtsp_stream_t *rtsp )
     {
         vlc_timer_disarm(rtsp->timer);
     }
+    rtsp->deadline = timeout;
 }
 
 
@@ -329,6 +332,36 @@ static void RtspTimeOut( void *data )
 }
 
 
+/**
+ * Looks a session up by ID.
+ * rtsp must be locked
+ * @param pos set to the index of the session, or where to insert it
+ * @return whether the session exists
+ */
+static bool RtspClientFind( const rtsp_stream_t *rtsp, uint64_t id, int *pos )
+{
+    int lo = 0, hi = rtsp->sessionc;
+
+    while( lo < hi )
+    {
+        int mid = lo + (hi - lo) / 2;
+        uint64_t cur = rtsp->sessionv[mid]->id;
+
+        if( cur == id )
+        {
+            *pos = mid;
+            return true;
+        }
+        if( cur < id )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *pos = lo;
+    return false;
+}
+
+
 /** rtsp must be locked */
 static
 rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
@@ -337,12 +370,26 @@ rtsp_session_t *RtspClientNew( rtsp_stream_t *rtsp )
     if( s == NULL )
         return NULL;
 
+    rtsp_session_t **tab = realloc( rtsp->sessionv, (rtsp->sessionc + 1)
+                                                    * sizeof( *tab ) );
+    if( tab == NULL )
+    {
+        free( s );
+        return NULL;
+    }
+    rtsp->sessionv = tab;
+
+    int i;
     s->stream = rtsp;
-    vlc_rand_bytes (&s->id, sizeof (s->id));
+    do
+        vlc_rand_bytes (&s->id, sizeof (s->id));
+    while( RtspClientFind( rtsp, s->id, &i ) );
     s->trackc = 0;
     s->trackv = NULL;
 
-    TAB_APPEND( rtsp->sessionc, rtsp->sessionv, s );
+    memmove( tab + i + 1, tab + i, (rtsp->sessionc - i) * sizeof( *tab ) );
+    tab[i] = s;
+    rtsp->sessionc++;
 
     return s;
 }
@@ -364,13 +411,7 @@ rtsp_session_t *RtspClientGet( rtsp_stream_t *rtsp, const char *name )
     if( errno || *end )
         return NULL;
 
-    /* FIXME: use a hash/dictionary */
-    for( i = 0; i < rtsp->sessionc; i++ )
-    {
-        if( rtsp->sessionv[i]->id == id )
-            return rtsp->sessionv[i];
-    }
-    return NULL;
+    return RtspClientFind( rtsp, id, &i ) ? rtsp->sessionv[i] : NULL;
 }
 
 
@@ -379,7 +420,13 @@ static
 void RtspClientDel( rtsp_stream_t *rtsp, rtsp_session_t *session )
 {
     int i;
-    TAB_REMOVE( rtsp->sessionc, rtsp->sessionv, session );
+
+    if( RtspClientFind( rtsp, session->id, &i ) )
+    {
+        rtsp->sessionc--;
+        memmove( rtsp->sessionv + i, rtsp->sessionv + i + 1,
+                 (rtsp->sessionc - i) * sizeof( *rtsp->sessionv ) );
+    }
 
     for( i = 0; i < session->trackc; i++ )
         RtspTrackClose( &session->trackv[i] );
@@ -396,7 +443,16 @@ static void RtspClientAlive( rtsp_session_t *session )
         return;
 
     session->last_seen = vlc_tick_now();
-    RtspUpdateTimer(session->stream);
+    /* Deadlines only move forward: an armed timer fires no later than any
+     * session expires, and then re-arms itself for the next one. This
+     * avoids scanning every session on each request. */
+    if (session->stream->deadline == 0)
+    {
+        session->stream->deadline = session->last_seen
+                                  + session->stream->timeout;
+        vlc_timer_schedule(session->stream->timer, true,
+                           session->stream->deadline, VLC_TIMER_FIRE_ONCE);
+    }
 }
 
 static int dup_socket(int oldfd)
@@ -1000,10 +1056,7 @@ static int RtspHandler( rtsp_stream_t *rtsp, rtsp_stream_id_t *id,
             if( ses != NULL )
             {
                 if( id == NULL ) /* Delete the entire session */
-                {
                     RtspClientDel( rtsp, ses );
-                    RtspUpdateTimer(rtsp);
-                }
                 else /* Delete one track from the session */
                 {
                     for( int i = 0; i < ses->trackc; i++ )
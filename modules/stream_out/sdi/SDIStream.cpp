@@ -365,6 +365,13 @@ void AbstractDecodedStream::decoderThread()
 int AbstractDecodedStream::Send(block_t *p_block)
 {
     assert(p_decoder);
+    /* Decoders may write to their input */
+    if(p_block)
+    {
+        p_block = block_Unshare(p_block);
+        if(!p_block)
+            return VLC_ENOMEM;
+    }
     vlc_mutex_lock(&inputLock);
     inputQueue.push(p_block);
     if(p_block)
@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * shmframes.c: stream output to a shared memory frame ring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Like smem, this module expects raw video, e.g.:
+ *   --sout="#transcode{vcodec=I420}:shmframes{name=/analysis}"
+ * but the frames are published in a shared memory ring (see
+ * video_output/shmframes.h) rather than handed over to callbacks.
+ * Other elementary streams are ignored.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include "../video_output/shmframes.h"
+
+#define NAME_TEXT N_("Shared memory name")
+#define NAME_LONGTEXT N_("Name of the shared memory object, starting with " \
+    "a slash. By default, a name is generated and printed in the log.")
+
+#define SLOTS_TEXT N_("Frames")
+#define SLOTS_LONGTEXT N_("Number of frames kept in the shared memory " \
+    "ring. Readers have that many frame periods to use a frame before " \
+    "it is overwritten.")
+
+#define TIME_SYNC_TEXT N_("Time synchronized output")
+#define TIME_SYNC_LONGTEXT N_("Publish the frames at the stream pace. " \
+    "Otherwise they are published as fast as they are decoded.")
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define SOUT_CFG_PREFIX "sout-shmframes-"
+
+vlc_module_begin ()
+    set_shortname( N_("Shared memory") )
+    set_description( N_("Stream output to shared memory frames") )
+    set_capability( "sout output", 0 )
+    add_shortcut( "shmframes" )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_STREAM )
+    add_string( SOUT_CFG_PREFIX "name", NULL, NAME_TEXT, NAME_LONGTEXT,
+                false )
+    add_integer_with_range( SOUT_CFG_PREFIX "slots", 4, 2, 64,
+                            SLOTS_TEXT, SLOTS_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "time-sync", true, TIME_SYNC_TEXT,
+              TIME_SYNC_LONGTEXT, true )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+static const char *const ppsz_sout_options[] = {
+    "name", "slots", "time-sync", NULL
+};
+
+typedef struct
+{
+    vlc_shmframes_t *p_shm;
+    video_format_t fmt;
+    unsigned i_planes;
+    struct vlc_shmframes_plane planes[VLC_SHMFRAMES_PLANES];
+    size_t i_size;
+} sout_stream_id_sys_t;
+
+typedef struct
+{
+    sout_stream_id_sys_t *p_video; /* only one video ES is published */
+} sout_stream_sys_t;
+
+static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    if( p_fmt->i_cat != VIDEO_ES )
+        return NULL;
+    if( p_sys->p_video != NULL )
+    {
+        msg_Warn( p_stream, "ignoring extra video ES %d", p_fmt->i_id );
+        return NULL;
+    }
+
+    const vlc_chroma_description_t *p_desc =
+        vlc_fourcc_GetChromaDescription( p_fmt->i_codec );
+    if( p_desc == NULL || p_desc->plane_count == 0 )
+    {
+        msg_Err( p_stream, "shmframes only supports raw video, not %4.4s",
+                 (const char *)&p_fmt->i_codec );
+        return NULL;
+    }
+
+    sout_stream_id_sys_t *id = malloc( sizeof( *id ) );
+    if( unlikely(id == NULL) )
+        return NULL;
+
+    video_format_Copy( &id->fmt, &p_fmt->video );
+    id->fmt.i_chroma = p_fmt->i_codec;
+    if( id->fmt.i_visible_width == 0 || id->fmt.i_visible_height == 0 )
+    {
+        id->fmt.i_visible_width = id->fmt.i_width;
+        id->fmt.i_visible_height = id->fmt.i_height;
+    }
+    id->fmt.i_x_offset = id->fmt.i_y_offset = 0;
+
+    /* Raw video encoders pack the planes without padding */
+    const unsigned i_width = id->fmt.i_visible_width;
+    const unsigned i_height = id->fmt.i_visible_height;
+
+    memset( id->planes, 0, sizeof( id->planes ) );
+    id->i_planes = p_desc->plane_count;
+    id->i_size = 0;
+    for( unsigned i = 0; i < p_desc->plane_count; i++ )
+    {
+        unsigned i_pitch = (i_width * p_desc->p[i].w.num
+                            + p_desc->p[i].w.den - 1) / p_desc->p[i].w.den
+                         * p_desc->pixel_size;
+        unsigned i_lines = (i_height * p_desc->p[i].h.num
+                            + p_desc->p[i].h.den - 1) / p_desc->p[i].h.den;
+
+        id->planes[i].offset = id->i_size;
+        id->planes[i].pitch = id->planes[i].visible_pitch = i_pitch;
+        id->planes[i].lines = id->planes[i].visible_lines = i_lines;
+        id->i_size += (size_t)i_pitch * i_lines;
+    }
+
+    char *psz_name = var_GetNonEmptyString( p_stream, SOUT_CFG_PREFIX "name" );
+    id->p_shm = vlc_shmframes_Create( VLC_OBJECT(p_stream), psz_name,
+                        var_GetInteger( p_stream, SOUT_CFG_PREFIX "slots" ),
+                        id->i_size );
+    free( psz_name );
+    if( id->p_shm == NULL )
+    {
+        video_format_Clean( &id->fmt );
+        free( id );
+        return NULL;
+    }
+
+    p_sys->p_video = id;
+    return id;
+}
+
+static void Del( sout_stream_t *p_stream, void *_id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    sout_stream_id_sys_t *id = _id;
+
+    vlc_shmframes_Destroy( id->p_shm );
+    video_format_Clean( &id->fmt );
+    free( id );
+    p_sys->p_video = NULL;
+}
+
+static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
+{
+    sout_stream_id_sys_t *id = _id;
+
+    for( block_t *p_next; p_buffer != NULL; p_buffer = p_next )
+    {
+        p_next = p_buffer->p_next;
+
+        if( p_buffer->i_buffer < id->i_size )
+        {
+            msg_Warn( p_stream, "invalid frame size (%zu < %zu)",
+                      p_buffer->i_buffer, id->i_size );
+            block_Release( p_buffer );
+            continue;
+        }
+
+        struct vlc_shmframes_slot *p_slot;
+        uint8_t *p_pixels = vlc_shmframes_Begin( id->p_shm, &p_slot );
+
+        memcpy( p_pixels, p_buffer->p_buffer, id->i_size );
+        p_slot->pts = p_buffer->i_pts != VLC_TICK_INVALID
+                    ? US_FROM_VLC_TICK(p_buffer->i_pts - VLC_TICK_0)
+                    : INT64_MIN;
+        p_slot->chroma = id->fmt.i_chroma;
+        p_slot->width = p_slot->visible_width = id->fmt.i_visible_width;
+        p_slot->height = p_slot->visible_height = id->fmt.i_visible_height;
+        p_slot->x_offset = p_slot->y_offset = 0;
+        p_slot->sar_num = id->fmt.i_sar_num;
+        p_slot->sar_den = id->fmt.i_sar_den;
+        p_slot->plane_count = id->i_planes;
+        memcpy( p_slot->planes, id->planes, sizeof( id->planes ) );
+        p_slot->size = id->i_size;
+        vlc_shmframes_Commit( id->p_shm );
+
+        block_Release( p_buffer );
+    }
+    return VLC_SUCCESS;
+}
+
+static const struct sout_stream_operations ops = {
+    .add = Add,
+    .del = Del,
+    .send = Send,
+};
+
+static int Open( vlc_object_t *p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t *)p_this;
+    sout_stream_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    config_ChainParse( p_stream, SOUT_CFG_PREFIX, ppsz_sout_options,
+                       p_stream->p_cfg );
+
+    p_sys->p_video = NULL;
+    p_stream->p_sys = p_sys;
+    p_stream->ops = &ops;
+    p_stream->pace_nocontrol = var_GetBool( p_stream,
+                                            SOUT_CFG_PREFIX "time-sync" );
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    sout_stream_t *p_stream = (sout_stream_t *)p_this;
+    free( p_stream->p_sys );
+}
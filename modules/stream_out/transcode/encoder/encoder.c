@@ -136,6 +136,17 @@ void transcode_encoder_update_format_out( transcode_encoder_t *p_enc, const es_f
     es_format_Copy( &p_enc->p_encoder->fmt_out, fmt );
 }
 
+vlc_video_context *transcode_encoder_video_context( const transcode_encoder_t *p_enc )
+{
+    return p_enc->p_encoder->vctx_in;
+}
+
+void transcode_encoder_update_video_context( transcode_encoder_t *p_enc,
+                                             vlc_video_context *vctx )
+{
+    p_enc->p_encoder->vctx_in = vctx;
+}
+
 bool transcode_encoder_opened( const transcode_encoder_t *p_enc )
 {
     return p_enc->p_encoder && p_enc->p_encoder->p_module;
@@ -44,6 +44,7 @@ typedef struct
                 unsigned int i_count;
                 int          i_priority;
                 uint32_t     pool_size;
+                bool         b_pipeline; /* decoding/filtering thread */
             } threads;
         } video;
         struct
@@ -67,6 +68,8 @@ const es_format_t *transcode_encoder_format_in( const transcode_encoder_t * );
 const es_format_t *transcode_encoder_format_out( const transcode_encoder_t * );
 void transcode_encoder_update_format_in( transcode_encoder_t *, const es_format_t * );
 void transcode_encoder_update_format_out( transcode_encoder_t *, const es_format_t * );
+vlc_video_context *transcode_encoder_video_context( const transcode_encoder_t * );
+void transcode_encoder_update_video_context( transcode_encoder_t *, vlc_video_context * );
 
 block_t * transcode_encoder_encode( transcode_encoder_t *, void * );
 block_t * transcode_encoder_get_output_async( transcode_encoder_t * );
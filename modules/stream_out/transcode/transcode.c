@@ -79,6 +79,14 @@
 #define VFILTER_LONGTEXT N_( \
     "Video filters will be applied to the video streams (after overlays " \
     "are applied). You can enter a colon-separated list of filters." )
+#define RENDITIONS_TEXT N_("Video renditions")
+#define RENDITIONS_LONGTEXT N_( \
+    "Additional renditions of the video streams, as a colon-separated list " \
+    "of WIDTHxHEIGHT@BITRATE entries (bitrate in kb/s). Either dimension " \
+    "can be omitted to keep the aspect ratio. The video is decoded and " \
+    "filtered only once, and each rendition is scaled from the main " \
+    "transcoded picture and encoded with the same encoder and options. " \
+    "Use a fixed GOP in the encoder options to get aligned keyframes." )
 
 #define AENC_TEXT N_("Audio encoder")
 #define AENC_LONGTEXT N_( \
@@ -129,6 +137,17 @@
 #define POOL_TEXT N_("Picture pool size")
 #define POOL_LONGTEXT N_( "Defines how many pictures we allow to be in pool "\
     "between decoder/encoder threads when threads > 0" )
+#define HW_SURFACES_TEXT N_("Keep hardware surfaces")
+#define HW_SURFACES_LONGTEXT N_( \
+    "Keeps hardware decoded pictures in GPU memory through the " \
+    "deinterlacing, scaling and video filters, using their hardware " \
+    "implementations. The pictures are only copied to system memory, after " \
+    "scaling, if the encoder can't use them. Not used with overlays." )
+#define PIPELINE_TEXT N_("Pipelined video transcoding")
+#define PIPELINE_LONGTEXT N_( \
+    "Decodes and filters each video stream in its own thread, so that " \
+    "streams are processed in parallel and overlap with the encoding. " \
+    "At most pool-size blocks are queued for each stream." )
 
 
 static const char *const ppsz_deinterlace_type[] =
@@ -177,6 +196,10 @@ vlc_module_begin ()
                  MAXHEIGHT_LONGTEXT, true )
     add_module_list(SOUT_CFG_PREFIX "vfilter", "video filter", NULL,
                     VFILTER_TEXT, VFILTER_LONGTEXT)
+    add_string( SOUT_CFG_PREFIX "renditions", NULL, RENDITIONS_TEXT,
+                RENDITIONS_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "hw-surfaces", false, HW_SURFACES_TEXT,
+              HW_SURFACES_LONGTEXT, true )
 
     set_section( N_("Audio"), NULL )
     add_module(SOUT_CFG_PREFIX "aenc", "encoder", NULL,
@@ -215,6 +238,8 @@ vlc_module_begin ()
         change_integer_range( 1, 1000 )
     add_bool( SOUT_CFG_PREFIX "high-priority", false, HP_TEXT, HP_LONGTEXT,
               true )
+    add_bool( SOUT_CFG_PREFIX "pipeline", false, PIPELINE_TEXT,
+              PIPELINE_LONGTEXT, true )
 
 vlc_module_end ()
 
@@ -224,7 +249,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "aenc", "acodec", "ab", "alang",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "high-priority", "maxwidth", "maxheight", "pool-size",
-    NULL
+    "pipeline", "renditions", "hw-surfaces", NULL
 };
 
 /*****************************************************************************
@@ -325,6 +350,7 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
 
     p_cfg->video.threads.i_count = var_GetInteger( p_stream, SOUT_CFG_PREFIX "threads" );
     p_cfg->video.threads.pool_size = var_GetInteger( p_stream, SOUT_CFG_PREFIX "pool-size" );
+    p_cfg->video.threads.b_pipeline = var_GetBool( p_stream, SOUT_CFG_PREFIX "pipeline" );
 
     if( var_GetBool( p_stream, SOUT_CFG_PREFIX "high-priority" ) )
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_OUTPUT;
@@ -332,6 +358,60 @@ static void SetVideoEncoderConfig( sout_stream_t *p_stream, transcode_encoder_co
         p_cfg->video.threads.i_priority = VLC_THREAD_PRIORITY_VIDEO;
 }
 
+static void SetVideoRenditionsConfig( sout_stream_t *p_stream,
+                                      sout_stream_sys_t *p_sys )
+{
+    char *psz_string = var_GetNonEmptyString( p_stream, SOUT_CFG_PREFIX "renditions" );
+    if( !psz_string || !p_sys->venc_cfg.i_codec )
+    {
+        free( psz_string );
+        return;
+    }
+
+    char *psz_save;
+    for( char *psz = strtok_r( psz_string, ":", &psz_save ); psz;
+         psz = strtok_r( NULL, ":", &psz_save ) )
+    {
+        char *end;
+        unsigned i_width = strtoul( psz, &end, 10 );
+        unsigned i_height = 0;
+        unsigned i_bitrate = 0;
+        if( *end == 'x' )
+            i_height = strtoul( end + 1, &end, 10 );
+        if( *end == '@' )
+            i_bitrate = strtoul( end + 1, &end, 10 );
+        if( *end || (!i_width && !i_height) )
+        {
+            msg_Warn( p_stream, "invalid rendition `%s'", psz );
+            continue;
+        }
+
+        transcode_encoder_config_t *p_cfgs =
+            realloc( p_sys->p_renditions_cfg,
+                     sizeof(*p_cfgs) * (p_sys->i_renditions + 1) );
+        if( !p_cfgs )
+            break;
+        p_sys->p_renditions_cfg = p_cfgs;
+
+        transcode_encoder_config_t *p_cfg = &p_cfgs[p_sys->i_renditions++];
+        *p_cfg = p_sys->venc_cfg;
+        p_cfg->video.i_width = i_width;
+        p_cfg->video.i_height = i_height;
+        p_cfg->video.i_maxwidth = p_cfg->video.i_maxheight = 0;
+        p_cfg->video.f_scale = 0;
+        if( i_bitrate )
+        {
+            p_cfg->video.i_bitrate = i_bitrate;
+            if( p_cfg->video.i_bitrate < 16000 )
+                p_cfg->video.i_bitrate *= 1000;
+        }
+        msg_Dbg( p_stream, "rendition video=%4.4s %ux%u %ukb/s",
+                 (char *)&p_cfg->i_codec, i_width, i_height,
+                 p_cfg->video.i_bitrate / 1000 );
+    }
+    free( psz_string );
+}
+
 static void SetSPUEncoderConfig( sout_stream_t *p_stream, transcode_encoder_config_t *p_cfg )
 {
     char *psz_string = var_GetString( p_stream, SOUT_CFG_PREFIX "senc" );
@@ -420,6 +500,8 @@ static int Open( vlc_object_t *p_this )
                  p_sys->venc_cfg.video.i_bitrate / 1000 );
     }
 
+    SetVideoRenditionsConfig( p_stream, p_sys );
+
     /* Video Filter Parameters */
     sout_filters_config_init( &p_sys->vfilters_cfg );
 
@@ -462,6 +544,10 @@ static int Open( vlc_object_t *p_this )
     /* Blending can't work outside of normal orientation */
     p_sys->vfilters_cfg.video.b_reorient = p_sys->b_soverlay ||
                                            p_sys->vfilters_cfg.video.psz_spu_sources;
+    /* nor on GPU pictures */
+    p_sys->vfilters_cfg.video.b_hw_surfaces =
+        !p_sys->vfilters_cfg.video.b_reorient &&
+        var_GetBool( p_stream, SOUT_CFG_PREFIX "hw-surfaces" );
 
     p_stream->pf_add    = Add;
     p_stream->pf_del    = Del;
@@ -480,6 +566,7 @@ static void Close( vlc_object_t * p_this )
     sout_stream_t       *p_stream = (sout_stream_t*)p_this;
     sout_stream_sys_t   *p_sys = p_stream->p_sys;
 
+    free( p_sys->p_renditions_cfg );
     transcode_encoder_config_clean( &p_sys->venc_cfg );
     sout_filters_config_clean( &p_sys->vfilters_cfg );
 
@@ -611,6 +698,8 @@ static void *Add( sout_stream_t *p_stream, const es_format_t *p_fmt )
         case VIDEO_ES:
             id->p_filterscfg = &p_sys->vfilters_cfg;
             id->p_enccfg = &p_sys->venc_cfg;
+            id->renditions.p_cfgs = p_sys->p_renditions_cfg;
+            id->renditions.i_count = p_sys->i_renditions;
             break;
         case SPU_ES:
             id->p_filterscfg = NULL;
@@ -688,12 +777,13 @@ static void Del( sout_stream_t *p_stream, void *_id )
             break;
         case VIDEO_ES:
             Send( p_stream, id, NULL );
+            transcode_video_pipeline_stop( id );
             decoder_Destroy( id->p_decoder );
             vlc_mutex_lock( &p_sys->lock );
             if( id == p_sys->id_video )
                 p_sys->id_video = NULL;
             vlc_mutex_unlock( &p_sys->lock );
-            transcode_video_clean( id );
+            transcode_video_clean( p_stream, id );
             break;
         case SPU_ES:
             decoder_Destroy( id->p_decoder );
@@ -726,6 +816,14 @@ static int Send( sout_stream_t *p_stream, void *_id, block_t *p_buffer )
             goto error;
     }
 
+    /* Decoders may write to their input */
+    if( p_buffer )
+    {
+        p_buffer = block_Unshare( p_buffer );
+        if( unlikely(p_buffer == NULL) )
+            return VLC_ENOMEM;
+    }
+
     int i_ret;
     switch( id->p_decoder->fmt_in.i_cat )
     {
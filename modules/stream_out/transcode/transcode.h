@@ -3,6 +3,8 @@
 #include <vlc_codec.h>
 #include "encoder/encoder.h"
 
+#include <stdatomic.h>
+
 /*100ms is around the limit where people are noticing lipsync issues*/
 #define MASTER_SYNC_MAX_DRIFT VLC_TICK_FROM_MS(100)
 
@@ -17,6 +19,7 @@ typedef struct
             config_chain_t  *p_deinterlace_cfg;
             char            *psz_spu_sources;
             bool             b_reorient;
+            bool             b_hw_surfaces; /* keep GPU pictures */
         } video;
     };
 } sout_filters_config_t;
@@ -52,6 +55,9 @@ typedef struct
     /* Video */
     transcode_encoder_config_t venc_cfg;
     sout_filters_config_t vfilters_cfg;
+    /* Additional renditions, strings and chains borrowed from venc_cfg */
+    transcode_encoder_config_t *p_renditions_cfg;
+    size_t               i_renditions;
 
     /* SPU */
     transcode_encoder_config_t senc_cfg;
@@ -68,10 +74,29 @@ typedef struct
 
 struct aout_filters;
 
+/* Additional encoding of the video, fed with the main encoder input */
+typedef struct
+{
+    const transcode_encoder_config_t *p_cfg;
+    transcode_encoder_t *encoder;
+    filter_chain_t      *p_conv; /* scaling and conversion */
+    bool                b_error;
+    bool                b_misaligned;
+
+    /* Set by the encoding thread, output and sent from the sout thread */
+    vlc_mutex_t         lock;
+    block_t             *p_out;
+    es_format_t         fmt_out;
+    bool                b_fmt_out;
+    void                *downstream_id;
+} transcode_rendition_t;
+
+#define TRANSCODE_RENDITION_KEYFRAMES 16
+
 struct sout_stream_id_sys_t
 {
     bool            b_transcode;
-    bool            b_error;
+    atomic_bool     b_error;
 
     /* id of the out stream */
     void *downstream_id;
@@ -148,6 +173,35 @@ struct sout_stream_id_sys_t
     const transcode_encoder_config_t *p_enccfg;
     transcode_encoder_t *encoder;
 
+    /* Video renditions sharing the decoding and filtering */
+    struct
+    {
+        const transcode_encoder_config_t *p_cfgs;
+        size_t                i_count;
+        transcode_rendition_t *p_array;
+        /* last keyframes of the main output, to check the alignment */
+        vlc_tick_t            keyframes[TRANSCODE_RENDITION_KEYFRAMES];
+        size_t                i_keyframes;
+    } renditions;
+
+    /* Pipelined video decoding and filtering */
+    struct
+    {
+        bool            b_running;
+        vlc_thread_t    thread;
+        vlc_mutex_t     lock;
+        vlc_cond_t      wait_in; /* worker side */
+        vlc_cond_t      wait_room; /* sout side */
+        sout_stream_t   *p_stream;
+        block_t         *p_in;
+        block_t         **pp_in_last;
+        size_t          i_in;
+        bool            b_drain;
+        block_t         *p_out;
+        es_format_t     fmt_out; /* encoder output, for the downstream */
+        bool            b_fmt_out;
+    } pipeline;
+
     /* Sync */
     date_t          next_input_pts; /**< Incoming calculated PTS */
     vlc_tick_t      i_drift; /** how much buffer is ahead of calculated PTS */
@@ -207,11 +261,12 @@ int  transcode_audio_init   ( sout_stream_t *, const es_format_t *,
 
 /* VIDEO */
 
-void transcode_video_clean  ( sout_stream_id_sys_t * );
+void transcode_video_clean  ( sout_stream_t *, sout_stream_id_sys_t * );
 int  transcode_video_process( sout_stream_t *, sout_stream_id_sys_t *,
                                      block_t *, block_t ** );
 int transcode_video_get_output_dimensions( sout_stream_id_sys_t *,
                                            unsigned *w, unsigned *h );
 void transcode_video_push_spu( sout_stream_t *, sout_stream_id_sys_t *, subpicture_t * );
+void transcode_video_pipeline_stop( sout_stream_id_sys_t * );
 int  transcode_video_init    ( sout_stream_t *, const es_format_t *,
                                sout_stream_id_sys_t *);
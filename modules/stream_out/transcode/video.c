@@ -157,6 +157,10 @@ static void decoder_queue_video( decoder_t *p_dec, picture_t *p_pic )
     vlc_mutex_unlock(&id->fifo.lock);
 }
 
+static void transcode_video_pipeline_start( sout_stream_t *, sout_stream_id_sys_t * );
+static void transcode_video_renditions_init( sout_stream_t *, sout_stream_id_sys_t *,
+                                             const es_format_t * );
+
 static picture_t *transcode_dequeue_all_pics( sout_stream_id_sys_t *id )
 {
     vlc_mutex_lock(&id->fifo.lock);
@@ -275,8 +279,13 @@ int transcode_video_init( sout_stream_t *p_stream, const es_format_t *p_fmt,
     /* Will use this format as encoder input for now */
     transcode_encoder_update_format_in( id->encoder, &encoder_tested_fmt_in );
 
+    transcode_video_renditions_init( p_stream, id, &encoder_tested_fmt_in );
+
     es_format_Clean( &encoder_tested_fmt_in );
 
+    if( id->p_enccfg->video.threads.b_pipeline )
+        transcode_video_pipeline_start( p_stream, id );
+
     return VLC_SUCCESS;
 }
 
@@ -405,11 +414,14 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
         filter_chain_Reset( id->p_uf_chain, p_src, src_ctx, p_dst );
         filter_chain_AppendFromString( id->p_uf_chain, p_cfg->psz_filters );
         p_src = filter_chain_GetFmtOut( id->p_uf_chain );
+        src_ctx = filter_chain_GetVideoCtxOut( id->p_uf_chain );
         debug_format( p_stream, p_src );
    }
 
     /* Update encoder so it matches filters output */
     transcode_encoder_update_format_in( id->encoder, p_src );
+    if( !transcode_encoder_opened( id->encoder ) )
+        transcode_encoder_update_video_context( id->encoder, src_ctx );
 
     /* SPU Sources */
     if( p_cfg->video.psz_spu_sources )
@@ -421,8 +433,71 @@ static int transcode_video_filters_init( sout_stream_t *p_stream,
     return VLC_SUCCESS;
 }
 
-void transcode_video_clean( sout_stream_id_sys_t *id )
+/* Filters and scales the GPU pictures as they are, with the hardware
+ * filters. If the encoder wants another chroma, the final converter copies
+ * them to memory, after the scaling. */
+static int transcode_video_filters_init_hw( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id )
+{
+    es_format_t sw_fmt, hw_fmt;
+    es_format_Copy( &sw_fmt, transcode_encoder_format_in( id->encoder ) );
+    es_format_Copy( &hw_fmt, &sw_fmt );
+    hw_fmt.i_codec = hw_fmt.video.i_chroma = id->decoder_out.video.i_chroma;
+    transcode_encoder_update_format_in( id->encoder, &hw_fmt );
+    es_format_Clean( &hw_fmt );
+
+    int i_ret = transcode_video_filters_init( p_stream, id->p_filterscfg,
+                                              (id->p_enccfg->video.fps.num > 0),
+                                              &id->decoder_out,
+                                              id->decoder_vctx_out,
+                                              transcode_encoder_format_in( id->encoder ),
+                                              id );
+    if( i_ret == VLC_SUCCESS )
+    {
+        msg_Dbg( p_stream, "keeping %4.4s hardware surfaces",
+                 (char *)&id->decoder_out.video.i_chroma );
+    }
+    else
+    {
+        msg_Warn( p_stream, "cannot filter %4.4s hardware surfaces, "
+                  "using system memory", (char *)&id->decoder_out.video.i_chroma );
+        transcode_remove_filters( &id->p_f_chain );
+        transcode_remove_filters( &id->p_conv_nonstatic );
+        transcode_remove_filters( &id->p_conv_static );
+        transcode_remove_filters( &id->p_uf_chain );
+        transcode_encoder_update_format_in( id->encoder, &sw_fmt );
+        transcode_encoder_update_video_context( id->encoder, id->decoder_vctx_out );
+    }
+    es_format_Clean( &sw_fmt );
+    return i_ret;
+}
+
+void transcode_video_clean( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
 {
+    transcode_video_pipeline_stop( id );
+    if( id->pipeline.p_stream )
+    {
+        block_ChainRelease( id->pipeline.p_in );
+        block_ChainRelease( id->pipeline.p_out );
+        es_format_Clean( &id->pipeline.fmt_out );
+    }
+
+    for( size_t i = 0; id->renditions.p_array && i < id->renditions.i_count; i++ )
+    {
+        transcode_rendition_t *r = &id->renditions.p_array[i];
+        if( r->encoder )
+        {
+            transcode_encoder_close( r->encoder );
+            transcode_encoder_delete( r->encoder );
+        }
+        transcode_remove_filters( &r->p_conv );
+        block_ChainRelease( r->p_out );
+        es_format_Clean( &r->fmt_out );
+        if( r->downstream_id )
+            sout_StreamIdDel( p_stream->p_next, r->downstream_id );
+    }
+    free( id->renditions.p_array );
+
     /* Close encoder */
     transcode_encoder_close( id->encoder );
     transcode_encoder_delete( id->encoder );
@@ -446,12 +521,17 @@ void transcode_video_clean( sout_stream_id_sys_t *id )
 void transcode_video_push_spu( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                subpicture_t *p_subpicture )
 {
+    /* The pipeline thread might be rendering */
+    vlc_mutex_lock( &id->fifo.lock );
     if( !id->p_spu )
         id->p_spu = spu_Create( p_stream, NULL );
-    if( !id->p_spu )
+    spu_t *p_spu = id->p_spu;
+    vlc_mutex_unlock( &id->fifo.lock );
+
+    if( !p_spu )
         subpicture_Delete( p_subpicture );
     else
-        spu_PutSubpicture( id->p_spu, p_subpicture );
+        spu_PutSubpicture( p_spu, p_subpicture );
 }
 
 int transcode_video_get_output_dimensions( sout_stream_id_sys_t *id,
@@ -466,14 +546,17 @@ int transcode_video_get_output_dimensions( sout_stream_id_sys_t *id,
 
 static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic )
 {
-    if( !id->p_spu )
-        return p_pic;
-
     /* Check if we have a subpicture to overlay */
     video_format_t fmt, outfmt;
     vlc_mutex_lock( &id->fifo.lock );
-    video_format_Copy( &outfmt, &id->decoder_out.video );
+    spu_t *p_spu = id->p_spu;
+    if( p_spu )
+        video_format_Copy( &outfmt, &id->decoder_out.video );
     vlc_mutex_unlock( &id->fifo.lock );
+
+    if( !p_spu )
+        return p_pic;
+
     video_format_Copy( &fmt, &p_pic->format );
     if( fmt.i_visible_width <= 0 || fmt.i_visible_height <= 0 )
     {
@@ -483,7 +566,7 @@ static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic
         fmt.i_y_offset       = 0;
     }
 
-    subpicture_t *p_subpic = spu_Render( id->p_spu, NULL, &fmt,
+    subpicture_t *p_subpic = spu_Render( p_spu, NULL, &fmt,
                                          &outfmt, vlc_tick_now(), p_pic->date,
                                          false, false );
 
@@ -503,7 +586,7 @@ static picture_t * RenderSubpictures( sout_stream_id_sys_t *id, picture_t *p_pic
             }
         }
         if( unlikely( !id->p_spu_blender ) )
-            id->p_spu_blender = filter_NewBlend( VLC_OBJECT( id->p_spu ), &fmt );
+            id->p_spu_blender = filter_NewBlend( VLC_OBJECT( p_spu ), &fmt );
         if( likely( id->p_spu_blender ) )
             picture_BlendSubpicture( p_pic, id->p_spu_blender, p_subpic );
         subpicture_Delete( p_subpic );
@@ -525,8 +608,269 @@ static void tag_last_block_with_flag( block_t **out, int i_flag )
     }
 }
 
-int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
-                                    block_t *in, block_t **out )
+/* Renditions: every picture reaching the main encoder is also scaled and
+ * encoded by each rendition. Their output is queued, as the encoding can
+ * happen in the pipeline thread, and sent by transcode_video_process. */
+static void transcode_video_renditions_init( sout_stream_t *p_stream,
+                                             sout_stream_id_sys_t *id,
+                                             const es_format_t *p_fmt_in )
+{
+    if( !id->renditions.i_count )
+        return;
+
+    id->renditions.p_array = calloc( id->renditions.i_count,
+                                     sizeof(*id->renditions.p_array) );
+    if( !id->renditions.p_array )
+    {
+        id->renditions.i_count = 0;
+        return;
+    }
+
+    for( size_t i = 0; i < id->renditions.i_count; i++ )
+    {
+        transcode_rendition_t *r = &id->renditions.p_array[i];
+        r->p_cfg = &id->renditions.p_cfgs[i];
+        vlc_mutex_init( &r->lock );
+        es_format_Init( &r->fmt_out, VIDEO_ES, 0 );
+
+        struct encoder_owner *p_enc_owner = (struct encoder_owner *)
+            sout_EncoderCreate( p_stream, sizeof(struct encoder_owner) );
+        if( p_enc_owner )
+        {
+            p_enc_owner->id = id;
+            p_enc_owner->enc.cbs = &encoder_video_transcode_cbs;
+            r->encoder = transcode_encoder_new( &p_enc_owner->enc, p_fmt_in );
+        }
+        if( !r->encoder )
+        {
+            msg_Err( p_stream, "cannot create the encoder of rendition %zu", i );
+            r->b_error = true;
+        }
+    }
+}
+
+static int transcode_video_rendition_open( sout_stream_t *p_stream,
+                                           transcode_rendition_t *r,
+                                           const picture_t *p_pic )
+{
+    const video_format_t *p_src = &p_pic->format;
+    transcode_encoder_config_t cfg = *r->p_cfg;
+
+    /* Keep the aspect ratio of the main output if a dimension is missing */
+    unsigned i_src_width = p_src->i_visible_width ? p_src->i_visible_width : p_src->i_width;
+    unsigned i_src_height = p_src->i_visible_height ? p_src->i_visible_height : p_src->i_height;
+    if( !cfg.video.i_width && i_src_height )
+        cfg.video.i_width = (uint64_t)cfg.video.i_height * i_src_width / i_src_height;
+    else if( !cfg.video.i_height && i_src_width )
+        cfg.video.i_height = (uint64_t)cfg.video.i_width * i_src_height / i_src_width;
+    cfg.video.i_width = __MAX( cfg.video.i_width & ~1, 2 );
+    cfg.video.i_height = __MAX( cfg.video.i_height & ~1, 2 );
+
+    transcode_encoder_video_configure( VLC_OBJECT(p_stream), p_src, &cfg, p_src,
+                                       picture_GetVideoContext( (picture_t *) p_pic ),
+                                       r->encoder );
+
+    if( transcode_encoder_open( r->encoder, &cfg ) != VLC_SUCCESS )
+        return VLC_EGENERIC;
+
+    const es_format_t *p_enc_in = transcode_encoder_format_in( r->encoder );
+    if( p_src->i_chroma != p_enc_in->video.i_chroma ||
+        p_src->i_width != p_enc_in->video.i_width ||
+        p_src->i_height != p_enc_in->video.i_height )
+    {
+        es_format_t fmt;
+        es_format_Init( &fmt, VIDEO_ES, p_src->i_chroma );
+        video_format_Copy( &fmt.video, p_src );
+
+        r->p_conv = filter_chain_NewVideo( p_stream, false, NULL );
+        if( r->p_conv )
+        {
+            filter_chain_Reset( r->p_conv, &fmt,
+                                picture_GetVideoContext( (picture_t *) p_pic ),
+                                p_enc_in );
+            if( filter_chain_AppendConverter( r->p_conv, NULL ) != VLC_SUCCESS )
+                transcode_remove_filters( &r->p_conv );
+        }
+        es_format_Clean( &fmt );
+        if( !r->p_conv )
+        {
+            transcode_encoder_close( r->encoder );
+            return VLC_EGENERIC;
+        }
+    }
+
+    msg_Dbg( p_stream, "rendition %ux%u",
+             p_enc_in->video.i_visible_width, p_enc_in->video.i_visible_height );
+
+    vlc_mutex_lock( &r->lock );
+    if( !r->b_fmt_out )
+    {
+        es_format_Copy( &r->fmt_out, transcode_encoder_format_out( r->encoder ) );
+        r->b_fmt_out = true;
+    }
+    vlc_mutex_unlock( &r->lock );
+
+    return VLC_SUCCESS;
+}
+
+static void transcode_video_rendition_queue( transcode_rendition_t *r,
+                                             block_t *p_block )
+{
+    if( !p_block )
+        return;
+    vlc_mutex_lock( &r->lock );
+    block_ChainAppend( &r->p_out, p_block );
+    vlc_mutex_unlock( &r->lock );
+}
+
+static void transcode_video_renditions_encode( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               picture_t *p_pic )
+{
+    for( size_t i = 0; i < id->renditions.i_count; i++ )
+    {
+        transcode_rendition_t *r = &id->renditions.p_array[i];
+        if( r->b_error )
+            continue;
+
+        if( !transcode_encoder_opened( r->encoder ) &&
+            transcode_video_rendition_open( p_stream, r, p_pic ) != VLC_SUCCESS )
+        {
+            msg_Err( p_stream, "cannot open the encoder of rendition %zu", i );
+            r->b_error = true;
+            continue;
+        }
+
+        /* Not the same picture_t, as the threaded encoders queue them */
+        picture_t *p_in = picture_Clone( p_pic );
+        if( p_in )
+            picture_CopyProperties( p_in, p_pic );
+        if( p_in && r->p_conv )
+            p_in = filter_chain_VideoFilter( r->p_conv, p_in );
+        if( !p_in )
+            continue;
+
+        block_t *p_encoded = transcode_encoder_encode( r->encoder, p_in );
+        picture_Release( p_in );
+        if( id->p_enccfg->video.threads.i_count >= 1 )
+            block_ChainAppend( &p_encoded,
+                               transcode_encoder_get_output_async( r->encoder ) );
+        transcode_video_rendition_queue( r, p_encoded );
+    }
+}
+
+/* Drains, and closes on end of sequence, as the main encoder */
+static void transcode_video_renditions_drain( sout_stream_id_sys_t *id,
+                                              bool b_eos )
+{
+    for( size_t i = 0; i < id->renditions.i_count; i++ )
+    {
+        transcode_rendition_t *r = &id->renditions.p_array[i];
+        if( r->b_error || !transcode_encoder_opened( r->encoder ) )
+            continue;
+
+        block_t *p_drained = NULL;
+        transcode_encoder_drain( r->encoder, &p_drained );
+        if( b_eos )
+        {
+            transcode_encoder_close( r->encoder );
+            transcode_remove_filters( &r->p_conv );
+            tag_last_block_with_flag( &p_drained, BLOCK_FLAG_END_OF_SEQUENCE );
+        }
+        transcode_video_rendition_queue( r, p_drained );
+    }
+}
+
+static bool transcode_video_keyframe_aligned( const sout_stream_id_sys_t *id,
+                                              vlc_tick_t i_pts )
+{
+    const size_t i_count = __MIN( id->renditions.i_keyframes,
+                                  TRANSCODE_RENDITION_KEYFRAMES );
+    if( i_count == 0 )
+        return true;
+
+    vlc_tick_t i_oldest = id->renditions.keyframes[0];
+    vlc_tick_t i_newest = i_oldest;
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        const vlc_tick_t i_key = id->renditions.keyframes[i];
+        if( i_key == i_pts )
+            return true;
+        i_oldest = __MIN( i_oldest, i_key );
+        i_newest = __MAX( i_newest, i_key );
+    }
+    /* can only tell within the main keyframes we know */
+    return i_pts < i_oldest || i_pts > i_newest;
+}
+
+/* Sends the renditions output, from the sout thread */
+static void transcode_video_renditions_output( sout_stream_t *p_stream,
+                                               sout_stream_id_sys_t *id,
+                                               const block_t *p_main )
+{
+    if( !id->renditions.i_count )
+        return;
+
+    for( ; p_main; p_main = p_main->p_next )
+    {
+        if( (p_main->i_flags & BLOCK_FLAG_TYPE_I) && p_main->i_pts != VLC_TICK_INVALID )
+            id->renditions.keyframes[id->renditions.i_keyframes++ %
+                                     TRANSCODE_RENDITION_KEYFRAMES] = p_main->i_pts;
+    }
+
+    for( size_t i = 0; i < id->renditions.i_count; i++ )
+    {
+        transcode_rendition_t *r = &id->renditions.p_array[i];
+
+        vlc_mutex_lock( &r->lock );
+        block_t *p_out = r->p_out;
+        r->p_out = NULL;
+        const bool b_fmt_out = r->b_fmt_out;
+        vlc_mutex_unlock( &r->lock );
+
+        if( b_fmt_out && !r->downstream_id && !r->b_error )
+        {
+            /* distinct ES of the same program */
+            es_format_t fmt_orig = id->p_decoder->fmt_in;
+            fmt_orig.i_id = -1;
+            r->downstream_id = id->pf_transcode_downstream_add( p_stream,
+                                                                &fmt_orig,
+                                                                &r->fmt_out );
+            if( !r->downstream_id )
+            {
+                msg_Err( p_stream, "cannot output rendition %zu", i );
+                r->b_error = true;
+            }
+        }
+
+        if( !p_out )
+            continue;
+        if( !r->downstream_id )
+        {
+            block_ChainRelease( p_out );
+            continue;
+        }
+
+        for( const block_t *p_block = p_out;
+             p_block && !r->b_misaligned; p_block = p_block->p_next )
+        {
+            if( (p_block->i_flags & BLOCK_FLAG_TYPE_I) &&
+                p_block->i_pts != VLC_TICK_INVALID &&
+                !transcode_video_keyframe_aligned( id, p_block->i_pts ) )
+            {
+                msg_Warn( p_stream, "keyframes of rendition %zu are not aligned "
+                          "with the main output, consider a fixed GOP", i );
+                r->b_misaligned = true;
+            }
+        }
+
+        sout_StreamIdSend( p_stream->p_next, r->downstream_id, p_out );
+    }
+}
+
+static int transcode_video_process_sync( sout_stream_t *p_stream,
+                                         sout_stream_id_sys_t *id,
+                                         block_t *in, block_t **out )
 {
     *out = NULL;
 
@@ -583,17 +927,25 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                     filter_DeleteBlend( id->p_spu_blender );
                 id->p_spu_blender = NULL;
 
-                video_format_Clean( &id->decoder_out.video );
             }
 
+            /* also read by the SPU stream */
+            vlc_mutex_lock( &id->fifo.lock );
+            video_format_Clean( &id->decoder_out.video );
             video_format_Copy( &id->decoder_out.video, &p_pic->format );
             transcode_video_framerate_apply( &p_pic->format, &id->decoder_out.video );
             transcode_video_sar_apply( &p_pic->format, &id->decoder_out.video );
             id->decoder_vctx_out = picture_GetVideoContext(p_pic);
+            vlc_mutex_unlock( &id->fifo.lock );
 
             if( !transcode_video_filters_configured( id ) )
             {
-                if( transcode_video_filters_init( p_stream,
+                int i_ret = VLC_EGENERIC;
+                if( id->p_filterscfg->video.b_hw_surfaces && id->decoder_vctx_out &&
+                    !transcode_encoder_opened( id->encoder ) )
+                    i_ret = transcode_video_filters_init_hw( p_stream, id );
+                if( i_ret != VLC_SUCCESS &&
+                    transcode_video_filters_init( p_stream,
                                                   id->p_filterscfg,
                                                  (id->p_enccfg->video.fps.num > 0),
                                                  &id->decoder_out,
@@ -608,6 +960,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
              * if it needs any different format or chroma. */
             es_format_t filter_fmt_out;
             es_format_Copy( &filter_fmt_out, transcode_encoder_format_in( id->encoder ) );
+            vlc_video_context *filter_vctx_out =
+                transcode_encoder_video_context( id->encoder );
             bool is_encoder_open = transcode_encoder_opened( id->encoder );
 
             /* Start missing encoder */
@@ -634,8 +988,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                         filter_chain_NewVideo( p_stream, false, NULL );
                 filter_chain_Reset( id->p_final_conv_static,
                                     &filter_fmt_out,
-                                    //encoder_vctx_in,
-                                    NULL,
+                                    filter_vctx_out,
                                     encoder_fmt_in );
                 filter_chain_AppendConverter( id->p_final_conv_static, NULL );
             }
@@ -645,16 +998,31 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
                                transcode_encoder_format_in( id->encoder )->video.i_width,
                                transcode_encoder_format_in( id->encoder )->video.i_height );
 
-            if( !id->downstream_id )
-                id->downstream_id =
-                    id->pf_transcode_downstream_add( p_stream,
-                                                     &id->p_decoder->fmt_in,
-                                                     transcode_encoder_format_out( id->encoder ) );
-            if( !id->downstream_id )
+            if( id->pipeline.b_running )
             {
-                msg_Err( p_stream, "cannot output transcoded stream %4.4s",
-                                   (char *) &id->p_enccfg->i_codec );
-                goto error;
+                /* The downstream is added from the sout thread */
+                vlc_mutex_lock( &id->pipeline.lock );
+                if( !id->pipeline.b_fmt_out )
+                {
+                    es_format_Copy( &id->pipeline.fmt_out,
+                                    transcode_encoder_format_out( id->encoder ) );
+                    id->pipeline.b_fmt_out = true;
+                }
+                vlc_mutex_unlock( &id->pipeline.lock );
+            }
+            else
+            {
+                if( !id->downstream_id )
+                    id->downstream_id =
+                        id->pf_transcode_downstream_add( p_stream,
+                                                         &id->p_decoder->fmt_in,
+                                                         transcode_encoder_format_out( id->encoder ) );
+                if( !id->downstream_id )
+                {
+                    msg_Err( p_stream, "cannot output transcoded stream %4.4s",
+                                       (char *) &id->p_enccfg->i_codec );
+                    goto error;
+                }
             }
         }
 
@@ -698,6 +1066,8 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
                 if( p_in )
                 {
+                    transcode_video_renditions_encode( p_stream, id, p_in );
+
                     block_t *p_encoded = transcode_encoder_encode( id->encoder, p_in );
                     if( p_encoded )
                         block_ChainAppend( out, p_encoded );
@@ -712,6 +1082,7 @@ int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
             if( transcode_encoder_drain( id->encoder, out ) != VLC_SUCCESS )
                 goto error;
             transcode_encoder_close( id->encoder );
+            transcode_video_renditions_drain( id, true );
             /* Close filters */
             transcode_remove_filters( &id->p_f_chain );
             transcode_remove_filters( &id->p_conv_nonstatic );
@@ -733,6 +1104,13 @@ error:
     {
         /* Pick up any return data the encoder thread wants to output. */
         block_ChainAppend( out, transcode_encoder_get_output_async( id->encoder ) );
+        for( size_t i = 0; i < id->renditions.i_count; i++ )
+        {
+            transcode_rendition_t *r = &id->renditions.p_array[i];
+            if( !r->b_error )
+                transcode_video_rendition_queue( r,
+                    transcode_encoder_get_output_async( r->encoder ) );
+        }
     }
 
     /* Drain encoder */
@@ -743,6 +1121,7 @@ error:
             msg_Dbg( p_stream, "Flushing done");
         else
             msg_Warn( p_stream, "Flushing failed");
+        transcode_video_renditions_drain( id, false );
     }
 
     if( b_eos )
@@ -750,3 +1129,145 @@ error:
 
     return id->b_error ? VLC_EGENERIC : VLC_SUCCESS;
 }
+
+/* Pipelined mode: the decoding, filtering and encoding of the ES run in
+ * its own thread, fed with the input blocks through a bounded queue. The
+ * output is collected and sent downstream by the sout thread, as the sout
+ * chain is not reentrant. */
+static void *transcode_video_pipeline_thread( void *data )
+{
+    sout_stream_id_sys_t *id = data;
+    sout_stream_t *p_stream = id->pipeline.p_stream;
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    for( ;; )
+    {
+        while( !id->pipeline.p_in && !id->pipeline.b_drain )
+            vlc_cond_wait( &id->pipeline.wait_in, &id->pipeline.lock );
+
+        block_t *in = id->pipeline.p_in;
+        if( in )
+        {
+            id->pipeline.p_in = in->p_next;
+            if( !id->pipeline.p_in )
+                id->pipeline.pp_in_last = &id->pipeline.p_in;
+            in->p_next = NULL;
+            id->pipeline.i_in--;
+            vlc_cond_signal( &id->pipeline.wait_room );
+        }
+        vlc_mutex_unlock( &id->pipeline.lock );
+
+        /* without input, drains */
+        block_t *out = NULL;
+        transcode_video_process_sync( p_stream, id, in, &out );
+
+        vlc_mutex_lock( &id->pipeline.lock );
+        block_ChainAppend( &id->pipeline.p_out, out );
+        if( !in )
+            break;
+    }
+    vlc_mutex_unlock( &id->pipeline.lock );
+
+    return NULL;
+}
+
+static void transcode_video_pipeline_start( sout_stream_t *p_stream,
+                                            sout_stream_id_sys_t *id )
+{
+    id->pipeline.p_stream = p_stream;
+    vlc_mutex_init( &id->pipeline.lock );
+    vlc_cond_init( &id->pipeline.wait_in );
+    vlc_cond_init( &id->pipeline.wait_room );
+    id->pipeline.p_in = NULL;
+    id->pipeline.pp_in_last = &id->pipeline.p_in;
+    id->pipeline.i_in = 0;
+    id->pipeline.b_drain = false;
+    id->pipeline.p_out = NULL;
+    es_format_Init( &id->pipeline.fmt_out, VIDEO_ES, 0 );
+    id->pipeline.b_fmt_out = false;
+
+    id->pipeline.b_running = true;
+    if( vlc_clone( &id->pipeline.thread, transcode_video_pipeline_thread, id,
+                   id->p_enccfg->video.threads.i_priority ) )
+    {
+        msg_Warn( p_stream, "cannot start the transcoding pipeline thread" );
+        id->pipeline.b_running = false;
+    }
+}
+
+void transcode_video_pipeline_stop( sout_stream_id_sys_t *id )
+{
+    if( !id->pipeline.b_running )
+        return;
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    id->pipeline.b_drain = true;
+    vlc_cond_signal( &id->pipeline.wait_in );
+    vlc_mutex_unlock( &id->pipeline.lock );
+
+    vlc_join( id->pipeline.thread, NULL );
+    id->pipeline.b_running = false;
+}
+
+static int transcode_video_pipeline_process( sout_stream_t *p_stream,
+                                             sout_stream_id_sys_t *id,
+                                             block_t *in, block_t **out )
+{
+    *out = NULL;
+
+    if( in )
+    {
+        vlc_mutex_lock( &id->pipeline.lock );
+        while( id->pipeline.i_in >= id->p_enccfg->video.threads.pool_size )
+            vlc_cond_wait( &id->pipeline.wait_room, &id->pipeline.lock );
+        block_ChainLastAppend( &id->pipeline.pp_in_last, in );
+        id->pipeline.i_in++;
+        vlc_cond_signal( &id->pipeline.wait_in );
+        vlc_mutex_unlock( &id->pipeline.lock );
+    }
+    else /* drain everything */
+    {
+        transcode_video_pipeline_stop( id );
+    }
+
+    vlc_mutex_lock( &id->pipeline.lock );
+    *out = id->pipeline.p_out;
+    id->pipeline.p_out = NULL;
+    const bool b_fmt_out = id->pipeline.b_fmt_out;
+    vlc_mutex_unlock( &id->pipeline.lock );
+
+    /* The encoder was opened by the pipeline thread */
+    if( b_fmt_out && !id->downstream_id && !id->b_error )
+    {
+        id->downstream_id =
+            id->pf_transcode_downstream_add( p_stream,
+                                             &id->p_decoder->fmt_in,
+                                             &id->pipeline.fmt_out );
+        if( !id->downstream_id )
+        {
+            msg_Err( p_stream, "cannot output transcoded stream %4.4s",
+                               (char *) &id->p_enccfg->i_codec );
+            id->b_error = true;
+        }
+    }
+
+    if( *out && !id->downstream_id )
+    {
+        block_ChainRelease( *out );
+        *out = NULL;
+    }
+
+    return id->b_error ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+int transcode_video_process( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                             block_t *in, block_t **out )
+{
+    int i_ret = id->pipeline.b_running
+              ? transcode_video_pipeline_process( p_stream, id, in, out )
+              : transcode_video_process_sync( p_stream, id, in, out );
+
+    transcode_video_renditions_output( p_stream, id, *out );
+
+    return i_ret;
+}
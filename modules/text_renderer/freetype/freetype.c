@@ -113,6 +113,9 @@ static void Destroy( vlc_object_t * );
 #define YUVP_TEXT N_("Use YUVP renderer")
 #define YUVP_LONGTEXT N_("This renders the font using \"paletized YUV\". " \
   "This option is only needed if you want to encode into DVB subtitles" )
+#define CACHE_SIZE_TEXT N_("Glyph cache size")
+#define CACHE_SIZE_LONGTEXT N_("Number of loaded glyphs and shaped text runs " \
+  "kept to speed up the rendering of recurring text. 0 disables the caches." )
 
 static const int pi_color_values[] = {
   0x00000000, 0x00808080, 0x00C0C0C0, 0x00FFFFFF, 0x00800000,
@@ -211,6 +214,9 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-cache-size", 1024, 0, 65536,
+                            CACHE_SIZE_TEXT, CACHE_SIZE_LONGTEXT, true )
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -1519,6 +1525,10 @@ static int Create( vlc_object_t *p_this )
         goto error;
     }
 
+    if( InitLayoutCaches( p_filter,
+                          var_InheritInteger( p_filter, "freetype-cache-size" ) ) )
+        goto error;
+
     p_filter->pf_render = Render;
 
     return VLC_SUCCESS;
@@ -1553,6 +1563,8 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    CleanLayoutCaches( p_filter );
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
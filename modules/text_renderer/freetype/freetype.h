@@ -46,6 +46,8 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 
+#include "glyph_cache.h"
+
 /* Consistency between Freetype versions and platforms */
 #define FT_FLOOR(X)     ((X & -64) >> 6)
 #define FT_CEIL(X)      (((X + 63) & -64) >> 6)
@@ -115,6 +117,11 @@ typedef struct
     /* Current scaling of the text, default is 100 (%) */
     int               i_scale;
 
+    /** Glyph caches, see text_layout.c. NULL when disabled. */
+    glyph_cache_t    *p_glyph_cache;    /* loaded and stroked glyphs */
+    glyph_cache_t    *p_bitmap_cache;   /* rasterized glyphs */
+    glyph_cache_t    *p_shape_cache;    /* HarfBuzz shaped runs */
+
     /**
      * Select a font, based on the family, the styles and the codepoint
      */
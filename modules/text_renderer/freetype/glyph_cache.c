@@ -0,0 +1,199 @@
+/*****************************************************************************
+ * glyph_cache.c : bounded LRU cache for the FreeType text renderer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Bounded LRU cache of glyphs and shaped runs
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+
+#include "glyph_cache.h"
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+
+struct glyph_cache_entry_t
+{
+    struct vlc_list      node;      /**< in the LRU list, most recent first */
+    glyph_cache_entry_t *p_next;    /**< in the hash bucket */
+    uint32_t             i_hash;
+    void                *p_value;
+    size_t               i_key;
+    unsigned char        key[];
+};
+
+struct glyph_cache_t
+{
+    glyph_cache_entry_t **pp_buckets;
+    unsigned              i_mask;
+    unsigned              i_count;
+    unsigned              i_max;
+    struct vlc_list       lru;
+    void                (*pf_release)( void * );
+
+    uint64_t              i_hits;
+    uint64_t              i_misses;
+    uint64_t              i_evictions;
+};
+
+/* FNV-1a */
+static uint32_t Hash( const void *p_key, size_t i_key )
+{
+    const unsigned char *p = p_key;
+    uint32_t i_hash = 2166136261u;
+
+    for( size_t i = 0; i < i_key; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= 16777619u;
+    }
+    return i_hash;
+}
+
+glyph_cache_t *GlyphCacheNew( unsigned i_max_entries,
+                              void (*pf_release)( void * ) )
+{
+    if( i_max_entries == 0 )
+        return NULL;
+
+    glyph_cache_t *p_cache = malloc( sizeof( *p_cache ) );
+    if( !p_cache )
+        return NULL;
+
+    /* Keep the load factor at or below one */
+    unsigned i_buckets = 16;
+    while( i_buckets < i_max_entries && i_buckets < (1u << 20) )
+        i_buckets <<= 1;
+
+    p_cache->pp_buckets = calloc( i_buckets, sizeof( *p_cache->pp_buckets ) );
+    if( !p_cache->pp_buckets )
+    {
+        free( p_cache );
+        return NULL;
+    }
+    p_cache->i_mask = i_buckets - 1;
+    p_cache->i_count = 0;
+    p_cache->i_max = i_max_entries;
+    vlc_list_init( &p_cache->lru );
+    p_cache->pf_release = pf_release;
+    p_cache->i_hits = p_cache->i_misses = p_cache->i_evictions = 0;
+    return p_cache;
+}
+
+static void RemoveEntry( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    glyph_cache_entry_t **pp = &p_cache->pp_buckets[p_entry->i_hash & p_cache->i_mask];
+    while( *pp != p_entry )
+        pp = &(*pp)->p_next;
+    *pp = p_entry->p_next;
+
+    vlc_list_remove( &p_entry->node );
+    p_cache->pf_release( p_entry->p_value );
+    free( p_entry );
+    p_cache->i_count--;
+}
+
+void GlyphCacheDelete( glyph_cache_t *p_cache )
+{
+    glyph_cache_entry_t *p_entry;
+
+    vlc_list_foreach( p_entry, &p_cache->lru, node )
+    {
+        p_cache->pf_release( p_entry->p_value );
+        free( p_entry );
+    }
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+void *GlyphCacheGet( glyph_cache_t *p_cache, const void *p_key, size_t i_key )
+{
+    const uint32_t i_hash = Hash( p_key, i_key );
+
+    for( glyph_cache_entry_t *p_entry = p_cache->pp_buckets[i_hash & p_cache->i_mask];
+         p_entry != NULL; p_entry = p_entry->p_next )
+    {
+        if( p_entry->i_hash == i_hash && p_entry->i_key == i_key
+         && !memcmp( p_entry->key, p_key, i_key ) )
+        {
+            vlc_list_remove( &p_entry->node );
+            vlc_list_prepend( &p_entry->node, &p_cache->lru );
+            p_cache->i_hits++;
+            return p_entry->p_value;
+        }
+    }
+    p_cache->i_misses++;
+    return NULL;
+}
+
+void GlyphCachePut( glyph_cache_t *p_cache, const void *p_key, size_t i_key,
+                    void *p_value )
+{
+    glyph_cache_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key );
+    if( !p_entry )
+    {
+        p_cache->pf_release( p_value );
+        return;
+    }
+
+    if( p_cache->i_count >= p_cache->i_max )
+    {
+        glyph_cache_entry_t *p_last =
+            vlc_list_last_entry_or_null( &p_cache->lru, glyph_cache_entry_t, node );
+        RemoveEntry( p_cache, p_last );
+        p_cache->i_evictions++;
+    }
+
+    p_entry->i_hash = Hash( p_key, i_key );
+    p_entry->p_value = p_value;
+    p_entry->i_key = i_key;
+    memcpy( p_entry->key, p_key, i_key );
+
+    glyph_cache_entry_t **pp_bucket =
+        &p_cache->pp_buckets[p_entry->i_hash & p_cache->i_mask];
+    p_entry->p_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+    p_cache->i_count++;
+}
+
+void GlyphCacheDumpStats( vlc_object_t *p_obj, const glyph_cache_t *p_cache,
+                          const char *psz_name )
+{
+    const uint64_t i_lookups = p_cache->i_hits + p_cache->i_misses;
+
+    msg_Dbg( p_obj, "%s cache: %u/%u entries, %"PRIu64" hits, "
+             "%"PRIu64" misses (%u%% hit rate), %"PRIu64" evictions",
+             psz_name, p_cache->i_count, p_cache->i_max,
+             p_cache->i_hits, p_cache->i_misses,
+             i_lookups ? (unsigned)(100 * p_cache->i_hits / i_lookups) : 0,
+             p_cache->i_evictions );
+}
+
+/** @} */
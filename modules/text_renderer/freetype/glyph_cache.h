@@ -0,0 +1,69 @@
+/*****************************************************************************
+ * glyph_cache.h : bounded LRU cache for the FreeType text renderer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_GLYPH_CACHE_H
+#define VLC_FREETYPE_GLYPH_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Bounded LRU cache of glyphs and shaped runs
+ *
+ * Keys are opaque byte strings compared with memcmp(), so key structures must
+ * be zeroed (padding included) before being filled. Values are owned by the
+ * cache once inserted and freed with the release callback on eviction.
+ */
+
+typedef struct glyph_cache_t glyph_cache_t;
+
+/**
+ * Creates a cache holding up to \p i_max_entries values.
+ */
+glyph_cache_t *GlyphCacheNew( unsigned i_max_entries,
+                              void (*pf_release)( void * ) );
+
+/**
+ * Releases all the values and the cache itself.
+ */
+void GlyphCacheDelete( glyph_cache_t *p_cache );
+
+/**
+ * Looks up a value and marks it as most recently used.
+ *
+ * \return the value, still owned by the cache, or NULL
+ */
+void *GlyphCacheGet( glyph_cache_t *p_cache, const void *p_key, size_t i_key );
+
+/**
+ * Inserts a value, evicting the least recently used one if the cache is full.
+ * The cache takes ownership of \p p_value, even on failure.
+ */
+void GlyphCachePut( glyph_cache_t *p_cache, const void *p_key, size_t i_key,
+                    void *p_value );
+
+/**
+ * Logs the hit/miss statistics of the cache.
+ */
+void GlyphCacheDumpStats( vlc_object_t *p_obj, const glyph_cache_t *p_cache,
+                          const char *psz_name );
+
+/** @} */
+
+#endif
@@ -112,15 +112,33 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    struct cached_run_t        *p_shaped;   /**< copy of a cached shaping */
 #endif
 
 } run_desc_t;
 
+/**
+ * Identifies a loaded glyph in the glyph caches. Faces are loaded at a given
+ * size and kept until the module is closed, so the face pointer also
+ * identifies the font file and size.
+ */
+typedef struct glyph_cache_key_t
+{
+    FT_Face  p_face;               /**< NULL if the glyph can't be cached */
+    FT_UInt  i_index;
+    int      i_synthesis;          /**< emboldening and/or obliquing */
+    FT_Fixed i_outline_radius;     /**< -1 for no outline */
+} glyph_cache_key_t;
+
+#define GLYPH_SYNTHESIS_BOLD   0x1
+#define GLYPH_SYNTHESIS_ITALIC 0x2
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
 typedef struct glyph_bitmaps_t
 {
+    glyph_cache_key_t cache_key;
     FT_Glyph p_glyph;
     FT_Glyph p_outline;
     FT_Glyph p_shadow;
@@ -163,6 +181,280 @@ typedef struct paragraph_t
 
 } paragraph_t;
 
+/**
+ * Cached glyph, as loaded and stroked but not rasterized yet
+ */
+typedef struct
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_glyph_t;
+
+/**
+ * Cached bitmap: the glyph or its outline rasterized at an origin within
+ * the first pixel (the fractional part of the pen position)
+ */
+typedef struct
+{
+    glyph_cache_key_t glyph;
+    int               b_outline;
+    int               i_origin_x;    /**< 26.6, 0..63 */
+    int               i_origin_y;
+} bitmap_cache_key_t;
+
+static void ReleaseCachedGlyph( void *p_value )
+{
+    cached_glyph_t *p_cached = p_value;
+
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static void ReleaseCachedBitmap( void *p_value )
+{
+    FT_Done_Glyph( (FT_Glyph) p_value );
+}
+
+#ifdef HAVE_HARFBUZZ
+/**
+ * Cached shaping result of a run. The key is the face, script and direction
+ * followed by the code points of the run.
+ */
+typedef struct
+{
+    FT_Face        p_face;
+    hb_script_t    script;
+    hb_direction_t direction;
+} shape_cache_key_t;
+
+typedef struct cached_run_t
+{
+    unsigned int         i_glyph_count;
+    hb_glyph_info_t     *p_glyph_infos;
+    hb_glyph_position_t *p_glyph_positions;
+} cached_run_t;
+
+static void ReleaseCachedRun( void *p_value )
+{
+    cached_run_t *p_cached = p_value;
+
+    free( p_cached->p_glyph_infos );
+    free( p_cached->p_glyph_positions );
+    free( p_cached );
+}
+
+static cached_run_t *CopyRun( unsigned int i_glyph_count,
+                              const hb_glyph_info_t *p_infos,
+                              const hb_glyph_position_t *p_positions )
+{
+    cached_run_t *p_copy = malloc( sizeof( *p_copy ) );
+    if( !p_copy )
+        return NULL;
+
+    p_copy->i_glyph_count = i_glyph_count;
+    p_copy->p_glyph_infos = vlc_alloc( i_glyph_count, sizeof( *p_infos ) );
+    p_copy->p_glyph_positions = vlc_alloc( i_glyph_count, sizeof( *p_positions ) );
+    if( !p_copy->p_glyph_infos || !p_copy->p_glyph_positions )
+    {
+        ReleaseCachedRun( p_copy );
+        return NULL;
+    }
+    memcpy( p_copy->p_glyph_infos, p_infos, i_glyph_count * sizeof( *p_infos ) );
+    memcpy( p_copy->p_glyph_positions, p_positions,
+            i_glyph_count * sizeof( *p_positions ) );
+    return p_copy;
+}
+
+static void *NewRunKey( const paragraph_t *p_paragraph, const run_desc_t *p_run,
+                        size_t *pi_key )
+{
+    const size_t i_count = p_run->i_end_offset - p_run->i_start_offset;
+    shape_cache_key_t header;
+
+    memset( &header, 0, sizeof( header ) );
+    header.p_face = p_run->p_face;
+    header.script = p_run->script;
+    header.direction = p_run->direction;
+
+    *pi_key = sizeof( header ) + i_count * sizeof( uni_char_t );
+    unsigned char *p_key = malloc( *pi_key );
+    if( !p_key )
+        return NULL;
+    memcpy( p_key, &header, sizeof( header ) );
+    memcpy( p_key + sizeof( header ),
+            p_paragraph->p_code_points + p_run->i_start_offset,
+            i_count * sizeof( uni_char_t ) );
+    return p_key;
+}
+#endif
+
+int InitLayoutCaches( filter_t *p_filter, unsigned i_size )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( i_size == 0 )
+        return VLC_SUCCESS;
+
+    /* The same glyph is rasterized at up to a few sub-pixel origins */
+    p_sys->p_glyph_cache = GlyphCacheNew( i_size, ReleaseCachedGlyph );
+    p_sys->p_bitmap_cache = GlyphCacheNew( 2 * i_size, ReleaseCachedBitmap );
+#ifdef HAVE_HARFBUZZ
+    p_sys->p_shape_cache = GlyphCacheNew( i_size, ReleaseCachedRun );
+    if( !p_sys->p_shape_cache )
+        goto error;
+#endif
+    if( !p_sys->p_glyph_cache || !p_sys->p_bitmap_cache )
+        goto error;
+
+    return VLC_SUCCESS;
+
+error:
+    CleanLayoutCaches( p_filter );
+    return VLC_ENOMEM;
+}
+
+void CleanLayoutCaches( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->p_glyph_cache )
+    {
+        GlyphCacheDumpStats( VLC_OBJECT(p_filter), p_sys->p_glyph_cache, "glyph" );
+        GlyphCacheDelete( p_sys->p_glyph_cache );
+        p_sys->p_glyph_cache = NULL;
+    }
+    if( p_sys->p_bitmap_cache )
+    {
+        GlyphCacheDumpStats( VLC_OBJECT(p_filter), p_sys->p_bitmap_cache, "bitmap" );
+        GlyphCacheDelete( p_sys->p_bitmap_cache );
+        p_sys->p_bitmap_cache = NULL;
+    }
+    if( p_sys->p_shape_cache )
+    {
+        GlyphCacheDumpStats( VLC_OBJECT(p_filter), p_sys->p_shape_cache, "shaped run" );
+        GlyphCacheDelete( p_sys->p_shape_cache );
+        p_sys->p_shape_cache = NULL;
+    }
+}
+
+/**
+ * Gets copies of a cached glyph and of its outline.
+ */
+static bool GetCachedGlyph( filter_sys_t *p_sys, glyph_bitmaps_t *p_bitmaps,
+                            FT_Vector *p_advance )
+{
+    if( !p_sys->p_glyph_cache )
+        return false;
+
+    const cached_glyph_t *p_cached =
+        GlyphCacheGet( p_sys->p_glyph_cache, &p_bitmaps->cache_key,
+                       sizeof( p_bitmaps->cache_key ) );
+    if( !p_cached )
+        return false;
+
+    if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+        return false;
+    p_bitmaps->p_outline = 0;
+    if( p_cached->p_outline
+     && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+    {
+        FT_Done_Glyph( p_bitmaps->p_glyph );
+        p_bitmaps->p_glyph = 0;
+        return false;
+    }
+    *p_advance = p_cached->advance;
+    return true;
+}
+
+static void PutCachedGlyph( filter_sys_t *p_sys,
+                            const glyph_bitmaps_t *p_bitmaps,
+                            const FT_Vector *p_advance )
+{
+    if( !p_sys->p_glyph_cache )
+        return;
+
+    cached_glyph_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    p_cached->p_outline = 0;
+    p_cached->advance = *p_advance;
+    if( FT_Glyph_Copy( p_bitmaps->p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    if( p_bitmaps->p_outline
+     && FT_Glyph_Copy( p_bitmaps->p_outline, &p_cached->p_outline ) )
+    {
+        ReleaseCachedGlyph( p_cached );
+        return;
+    }
+    GlyphCachePut( p_sys->p_glyph_cache, &p_bitmaps->cache_key,
+                   sizeof( p_bitmaps->cache_key ), p_cached );
+}
+
+/**
+ * Same as FT_Glyph_To_Bitmap() in FT_RENDER_MODE_NORMAL, going through the
+ * bitmap cache when possible.
+ *
+ * Translating a glyph by whole pixels only moves its bitmap, so the glyph is
+ * rasterized at the fractional part of the pen position, and the integer part
+ * is added to the position of the (copied) cached bitmap.
+ */
+static FT_Error GlyphToBitmap( filter_sys_t *p_sys,
+                               const glyph_cache_key_t *p_glyph_key,
+                               bool b_outline, FT_Glyph *pp_glyph,
+                               const FT_Vector *p_pen, FT_Bool b_destroy )
+{
+    if( !p_sys->p_bitmap_cache || !p_glyph_key->p_face
+     || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   (FT_Vector *) p_pen, b_destroy );
+
+    bitmap_cache_key_t key;
+    memset( &key, 0, sizeof( key ) );
+    key.glyph = *p_glyph_key;
+    key.b_outline = b_outline;
+    key.i_origin_x = p_pen->x & 63;
+    key.i_origin_y = p_pen->y & 63;
+
+    FT_Glyph p_bitmap;
+    const FT_Glyph p_cached =
+        GlyphCacheGet( p_sys->p_bitmap_cache, &key, sizeof( key ) );
+    if( p_cached )
+    {
+        FT_Error i_error = FT_Glyph_Copy( p_cached, &p_bitmap );
+        if( i_error )
+            return i_error;
+    }
+    else
+    {
+        FT_Vector origin = { .x = key.i_origin_x, .y = key.i_origin_y };
+        FT_Glyph p_copy;
+
+        p_bitmap = *pp_glyph;
+        FT_Error i_error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                               &origin, 0 );
+        if( i_error )
+            return i_error;
+        if( !FT_Glyph_Copy( p_bitmap, &p_copy ) )
+            GlyphCachePut( p_sys->p_bitmap_cache, &key, sizeof( key ), p_copy );
+    }
+
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph) p_bitmap;
+    p_bitmap_glyph->left += ( p_pen->x - key.i_origin_x ) / 64;
+    p_bitmap_glyph->top  += ( p_pen->y - key.i_origin_y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
 static void FreeLine( line_desc_t *p_line )
 {
     for( int i = 0; i < p_line->i_character_count; i++ )
@@ -724,6 +1016,19 @@ static int ItemizeParagraph( filter_t *p_filter, paragraph_t *p_paragraph )
  * Glyph substitutions of base glyphs and diacritics may take place,
  * so the paragraph size may change.
  */
+static void ReleaseRunShaping( run_desc_t *p_run )
+{
+    if( p_run->p_hb_font )
+        hb_font_destroy( p_run->p_hb_font );
+    if( p_run->p_buffer )
+        hb_buffer_destroy( p_run->p_buffer );
+    if( p_run->p_shaped )
+        ReleaseCachedRun( p_run->p_shaped );
+    p_run->p_hb_font = NULL;
+    p_run->p_buffer = NULL;
+    p_run->p_shaped = NULL;
+}
+
 static int ShapeParagraphHarfBuzz( filter_t *p_filter,
                                    paragraph_t **p_old_paragraph )
 {
@@ -770,11 +1075,34 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        size_t i_key = 0;
+        void *p_key = p_sys->p_shape_cache ?
+                      NewRunKey( p_paragraph, p_run, &i_key ) : NULL;
+        if( p_key )
+        {
+            const cached_run_t *p_cached =
+                GlyphCacheGet( p_sys->p_shape_cache, p_key, i_key );
+            if( p_cached )
+                p_run->p_shaped = CopyRun( p_cached->i_glyph_count,
+                                           p_cached->p_glyph_infos,
+                                           p_cached->p_glyph_positions );
+            if( p_run->p_shaped )
+            {
+                free( p_key );
+                p_run->i_glyph_count = p_run->p_shaped->i_glyph_count;
+                p_run->p_glyph_infos = p_run->p_shaped->p_glyph_infos;
+                p_run->p_glyph_positions = p_run->p_shaped->p_glyph_positions;
+                i_total_glyphs += p_run->i_glyph_count;
+                continue;
+            }
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_ft_font_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -783,6 +1111,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz(): hb_buffer_create() error" );
+            free( p_key );
             goto error;
         }
 
@@ -809,9 +1138,20 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         {
             msg_Err( p_filter,
                      "ShapeParagraphHarfBuzz() invalid glyph count in shaped run" );
+            free( p_key );
             goto error;
         }
 
+        if( p_key )
+        {
+            cached_run_t *p_copy = CopyRun( p_run->i_glyph_count,
+                                            p_run->p_glyph_infos,
+                                            p_run->p_glyph_positions );
+            if( p_copy )
+                GlyphCachePut( p_sys->p_shape_cache, p_key, i_key, p_copy );
+            free( p_key );
+        }
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -882,10 +1222,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
     }
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
-    {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
-    }
+        ReleaseRunShaping( p_paragraph->p_runs + i );
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
 
@@ -893,12 +1230,7 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
 error:
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
-    {
-        if( p_paragraph->p_runs[ i ].p_hb_font )
-            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        if( p_paragraph->p_runs[ i ].p_buffer )
-            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
-    }
+        ReleaseRunShaping( p_paragraph->p_runs + i );
 
     if( p_new_paragraph )
         FreeParagraph( p_new_paragraph );
@@ -1039,18 +1371,27 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_radius = -1;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        int i_synthesis = 0;
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_synthesis |= GLYPH_SYNTHESIS_BOLD;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_synthesis |= GLYPH_SYNTHESIS_ITALIC;
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1101,39 +1442,51 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            memset( &p_bitmaps->cache_key, 0, sizeof( p_bitmaps->cache_key ) );
+            p_bitmaps->cache_key.p_face = p_face;
+            p_bitmaps->cache_key.i_index = i_glyph_index;
+            p_bitmaps->cache_key.i_synthesis = i_synthesis;
+            p_bitmaps->cache_key.i_outline_radius = i_radius;
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            FT_Vector advance;
+            if( !GetCachedGlyph( p_sys, p_bitmaps, &advance ) )
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( i_synthesis & GLYPH_SYNTHESIS_BOLD )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( i_synthesis & GLYPH_SYNTHESIS_ITALIC )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-#undef SKIP_GLYPH
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                p_bitmaps->p_outline = 0;
+                if( i_radius >= 0 )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+
+                advance = p_face->glyph->advance;
+                PutCachedGlyph( p_sys, p_bitmaps, &advance );
             }
 
+#undef SKIP_GLYPH
+
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
@@ -1240,8 +1593,9 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            const bool b_outline = p_bitmaps->p_shadow == p_bitmaps->p_outline;
+            if( GlyphToBitmap( p_sys, &p_bitmaps->cache_key, b_outline,
+                               &p_bitmaps->p_shadow, &pen_shadow, 0 ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1249,8 +1603,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphToBitmap( p_sys, &p_bitmaps->cache_key, false,
+                               &p_bitmaps->p_glyph, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1265,8 +1619,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( GlyphToBitmap( p_sys, &p_bitmaps->cache_key, true,
+                               &p_bitmaps->p_outline, &pen_new, 1 ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
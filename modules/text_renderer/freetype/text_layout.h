@@ -105,3 +105,16 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Creates the glyph and shaped run caches used by LayoutTextBlock().
+ *
+ * \param p_filter the FreeType module object [IN]
+ * \param i_size maximum number of entries per cache, 0 to disable them [IN]
+ */
+int InitLayoutCaches( filter_t *p_filter, unsigned i_size );
+
+/**
+ * Logs the cache statistics and releases the caches.
+ */
+void CleanLayoutCaches( filter_t *p_filter );
@@ -34,6 +34,11 @@
 #include <vlc_cpu.h>
 #include <assert.h>
 
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define COPY_AVX2 1
+#endif
+
 #include "copy.h"
 static void CopyPlane(uint8_t *dst, size_t dst_pitch,
                       const uint8_t *src, size_t src_pitch,
@@ -131,6 +136,197 @@ void CopyCleanCache(copy_cache_t *cache)
 # undef vlc_CPU_SSE2
 # define vlc_CPU_SSE2() (0)
 #endif
+#if defined(COPY_TEST_NOOPTIM) || defined(COPY_TEST_NOAVX2)
+# undef vlc_CPU_AVX2
+# define vlc_CPU_AVX2() (0)
+#endif
+
+#ifdef COPY_AVX2
+/* AVX2 variants of the SSE kernels below, selected at run time by the SSE
+ * kernels themselves. The cache lines are only 16 bytes aligned, so only the
+ * USWC loads are aligned (on 32 bytes). */
+
+__attribute__ ((__target__ ("avx2")))
+static inline __m256i AVX2_Shift16(__m256i v, int bitshift, __m128i count)
+{
+    if (bitshift > 0)
+        return _mm256_srl_epi16(v, count);
+    if (bitshift < 0)
+        return _mm256_sll_epi16(v, count);
+    return v;
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_CopyFromUswc(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *src, size_t src_pitch,
+                              unsigned width, unsigned height, int bitshift)
+{
+    const __m128i count = _mm_cvtsi32_si128(bitshift >= 0 ? bitshift
+                                                          : -bitshift);
+
+    _mm_mfence();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned unaligned = (-(uintptr_t)src) & 0x1f;
+        unsigned x = 0;
+
+        /* Do not split 16-bits samples if the plane is oddly aligned */
+        if (width >= 64 && (bitshift == 0 || !(unaligned & 1))) {
+            if (unaligned) {
+                __m256i v = _mm256_loadu_si256((const __m256i *)src);
+                _mm256_storeu_si256((__m256i *)dst,
+                                    AVX2_Shift16(v, bitshift, count));
+                x = unaligned;
+            }
+            for (; x + 63 < width; x += 64) {
+                __m256i a = _mm256_stream_load_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_stream_load_si256((const __m256i *)&src[x + 32]);
+                _mm256_storeu_si256((__m256i *)&dst[x],
+                                    AVX2_Shift16(a, bitshift, count));
+                _mm256_storeu_si256((__m256i *)&dst[x + 32],
+                                    AVX2_Shift16(b, bitshift, count));
+            }
+        }
+        if (x < width)
+            CopyPlane(&dst[x], dst_pitch - x, &src[x], src_pitch - x, 1, bitshift);
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+
+    _mm_mfence();
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_Copy2d(uint8_t *dst, size_t dst_pitch,
+                        const uint8_t *src, size_t src_pitch,
+                        unsigned width, unsigned height)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        if (((intptr_t)dst & 0x1f) == 0) {
+            for (; x + 63 < width; x += 64) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_loadu_si256((const __m256i *)&src[x + 32]);
+                _mm256_stream_si256((__m256i *)&dst[x], a);
+                _mm256_stream_si256((__m256i *)&dst[x + 32], b);
+            }
+        } else {
+            for (; x + 63 < width; x += 64) {
+                __m256i a = _mm256_loadu_si256((const __m256i *)&src[x]);
+                __m256i b = _mm256_loadu_si256((const __m256i *)&src[x + 32]);
+                _mm256_storeu_si256((__m256i *)&dst[x], a);
+                _mm256_storeu_si256((__m256i *)&dst[x + 32], b);
+            }
+        }
+
+        for (; x < width; x++)
+            dst[x] = src[x];
+
+        src += src_pitch;
+        dst += dst_pitch;
+    }
+    _mm_sfence();
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_InterleaveUV(uint8_t *dst, size_t dst_pitch,
+                              const uint8_t *srcu, size_t srcu_pitch,
+                              const uint8_t *srcv, size_t srcv_pitch,
+                              unsigned width, unsigned height,
+                              uint8_t pixel_size)
+{
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i u = _mm256_loadu_si256((const __m256i *)&srcu[x]);
+            __m256i v = _mm256_loadu_si256((const __m256i *)&srcv[x]);
+            __m256i lo, hi;
+
+            if (pixel_size == 1) {
+                lo = _mm256_unpacklo_epi8(u, v);
+                hi = _mm256_unpackhi_epi8(u, v);
+            } else {
+                lo = _mm256_unpacklo_epi16(u, v);
+                hi = _mm256_unpackhi_epi16(u, v);
+            }
+            /* Unpacking works within 128-bits lanes: put them back in order */
+            _mm256_storeu_si256((__m256i *)&dst[2*x],
+                                _mm256_permute2x128_si256(lo, hi, 0x20));
+            _mm256_storeu_si256((__m256i *)&dst[2*x + 32],
+                                _mm256_permute2x128_si256(lo, hi, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcv[x];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dst[2*x+0] = srcu[x];
+                dst[2*x+1] = srcu[x + 1];
+                dst[2*x+2] = srcv[x];
+                dst[2*x+3] = srcv[x + 1];
+            }
+        }
+        srcu += srcu_pitch;
+        srcv += srcv_pitch;
+        dst += dst_pitch;
+    }
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void AVX2_SplitUV(uint8_t *dstu, size_t dstu_pitch,
+                         uint8_t *dstv, size_t dstv_pitch,
+                         const uint8_t *src, size_t src_pitch,
+                         unsigned width, unsigned height, uint8_t pixel_size)
+{
+    /* Gather U in the low and V in the high quadword of each lane */
+    const __m256i shuffle = pixel_size == 1
+        ? _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15)
+        : _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+                           0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+    for (unsigned y = 0; y < height; y++) {
+        unsigned x = 0;
+
+        for (; x < (width & ~31); x += 32) {
+            __m256i a = _mm256_loadu_si256((const __m256i *)&src[2*x]);
+            __m256i b = _mm256_loadu_si256((const __m256i *)&src[2*x + 32]);
+
+            /* U0 V0 U1 V1 -> U0 U1 V0 V1 */
+            a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, shuffle),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+            b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, shuffle),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+            _mm256_storeu_si256((__m256i *)&dstu[x],
+                                _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)&dstv[x],
+                                _mm256_permute2x128_si256(a, b, 0x31));
+        }
+
+        if (pixel_size == 1) {
+            for (; x < width; x++) {
+                dstu[x] = src[2*x+0];
+                dstv[x] = src[2*x+1];
+            }
+        } else {
+            for (; x < width; x += 2) {
+                dstu[x] = src[2*x+0];
+                dstu[x+1] = src[2*x+1];
+                dstv[x] = src[2*x+2];
+                dstv[x+1] = src[2*x+3];
+            }
+        }
+        src  += src_pitch;
+        dstu += dstu_pitch;
+        dstv += dstv_pitch;
+    }
+}
+#endif /* COPY_AVX2 */
 
 /* Optimized copy from "Uncacheable Speculative Write Combining" memory
  * as used by some video surface.
@@ -143,6 +339,12 @@ static void CopyFromUswc(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)dst & 0x0f) == 0 && (dst_pitch & 0x0f) == 0);
 
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_CopyFromUswc(dst, dst_pitch, src, src_pitch,
+                                 width, height, bitshift);
+#endif
+
     asm volatile ("mfence");
 
 #define SSE_USWC_COPY(shiftstr16, shiftstr64) \
@@ -213,6 +415,11 @@ static void Copy2d(uint8_t *dst, size_t dst_pitch,
 {
     assert(((intptr_t)src & 0x0f) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_Copy2d(dst, dst_pitch, src, src_pitch, width, height);
+#endif
+
     for (unsigned y = 0; y < height; y++) {
         unsigned x = 0;
 
@@ -243,6 +450,12 @@ SSE_InterleaveUV(uint8_t *dst, size_t dst_pitch,
     assert(!((intptr_t)srcu & 0xf) && !(srcu_pitch & 0x0f) &&
            !((intptr_t)srcv & 0xf) && !(srcv_pitch & 0x0f));
 
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_InterleaveUV(dst, dst_pitch, srcu, srcu_pitch,
+                                 srcv, srcv_pitch, width, height, pixel_size);
+#endif
+
     static const uint8_t shuffle_8[] = { 0, 8,
                                          1, 9,
                                          2, 10,
@@ -358,6 +571,12 @@ static void SSE_SplitUV(uint8_t *dstu, size_t dstu_pitch,
     assert(pixel_size == 1 || pixel_size == 2);
     assert(((intptr_t)src & 0xf) == 0 && (src_pitch & 0x0f) == 0);
 
+#ifdef COPY_AVX2
+    if (vlc_CPU_AVX2())
+        return AVX2_SplitUV(dstu, dstu_pitch, dstv, dstv_pitch,
+                            src, src_pitch, width, height, pixel_size);
+#endif
+
 #define LOAD64 \
     "movdqa  0(%[src]), %%xmm0\n" \
     "movdqa 16(%[src]), %%xmm1\n" \
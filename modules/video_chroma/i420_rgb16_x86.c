@@ -31,7 +31,10 @@
 #include <vlc_cpu.h>
 
 #include "i420_rgb.h"
-#ifdef SSE2
+#if defined (AVX2)
+# include "i420_rgb_avx2.h"
+# define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#elif defined (SSE2)
 # include "i420_rgb_sse2.h"
 # define VLC_TARGET VLC_SSE
 #else
@@ -161,7 +164,50 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_15, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_15, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 2 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
@@ -401,7 +447,50 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_16, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_16, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 2 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
@@ -641,7 +730,50 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_ARGB, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_ARGB, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 4 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
@@ -880,7 +1012,50 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_RGBA, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_RGBA, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 4 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
@@ -1119,7 +1294,50 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_BGRA, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_BGRA, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 4 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
@@ -1358,7 +1576,50 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height) :
                     (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height);
 
-#ifdef SSE2
+#if defined (AVX2)
+
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    i_rewind = (-i_width) & 31;
+
+    /*
+    ** The loads are always unaligned, as this is free on AVX2 hardware,
+    ** but streaming stores require 32 bytes aligned lines
+    */
+
+    p_buffer = b_hscale ? p_buffer_start : p_pic;
+
+    const bool b_aligned = 0 == (31 & (p_dest->p->i_pitch|
+                                       ((intptr_t)p_buffer)));
+
+    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    {
+        p_pic_start = p_pic;
+
+        if( b_aligned )
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_ABGR, AVX2_STORE_ALIGNED )
+        }
+        else
+        {
+            AVX2_CONVERT_LINE( AVX2_UNPACK_32_ABGR, AVX2_STORE_UNALIGNED )
+        }
+        SCALE_WIDTH;
+        SCALE_HEIGHT( 420, 4 );
+
+        p_y += i_source_margin;
+        if( i_y % 2 )
+        {
+            p_u += i_source_margin_c;
+            p_v += i_source_margin_c;
+        }
+        p_buffer = b_hscale ? p_buffer_start : p_pic;
+    }
+
+    /* make sure all AVX2 stores are visible thereafter */
+    AVX2_END;
+
+#elif defined (SSE2)
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 15;
 
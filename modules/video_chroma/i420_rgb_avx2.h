@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * i420_rgb_avx2.h: AVX2 YUV transformation intrinsics
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#if defined(HAVE_AVX2_INTRINSICS)
+
+/*
+ * These are the SSE2 intrinsics widened to 32 pixels per iteration, with the
+ * same fixed point coefficients so that both plugins give the same output.
+ *
+ * The chroma samples are widened to 16 bits across the whole register, so
+ * that after AVX2_YUV_ADD, ymm0 (blue), ymm1 (red) and ymm2 (green) hold the
+ * 32 pixels in order. The unpack instructions work within each 128-bit lane
+ * though, hence the final lane permutation before each pair of stores.
+ */
+
+#include <immintrin.h>
+
+#define AVX2_CALL(AVX2_INSTRUCTIONS)        \
+    do {                                    \
+        __m256i ymm0, ymm1, ymm2, ymm3,     \
+                ymm4, ymm5, ymm6, ymm7;     \
+        AVX2_INSTRUCTIONS                   \
+    } while(0)
+
+#define AVX2_END  _mm_sfence()
+
+#define AVX2_STORE_ALIGNED(p, r)    _mm256_stream_si256((__m256i *)(p), r)
+#define AVX2_STORE_UNALIGNED(p, r)  _mm256_storeu_si256((__m256i *)(p), r)
+
+#define AVX2_INIT                                                   \
+    ymm0 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)p_u));   \
+    ymm1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)p_v));   \
+    ymm6 = _mm256_loadu_si256((__m256i *)p_y);
+
+#define AVX2_YUV_MUL                                \
+    ymm5 = _mm256_set1_epi32(0x00800080UL);         \
+    ymm0 = _mm256_subs_epi16(ymm0, ymm5);           \
+    ymm1 = _mm256_subs_epi16(ymm1, ymm5);           \
+    ymm0 = _mm256_slli_epi16(ymm0, 3);              \
+    ymm1 = _mm256_slli_epi16(ymm1, 3);              \
+    ymm5 = _mm256_set1_epi32(0xf37df37dUL);         \
+    ymm2 = _mm256_mulhi_epi16(ymm0, ymm5);          \
+    ymm5 = _mm256_set1_epi32(0xe5fce5fcUL);         \
+    ymm3 = _mm256_mulhi_epi16(ymm1, ymm5);          \
+    ymm5 = _mm256_set1_epi32(0x40934093UL);         \
+    ymm0 = _mm256_mulhi_epi16(ymm0, ymm5);          \
+    ymm5 = _mm256_set1_epi32(0x33123312UL);         \
+    ymm1 = _mm256_mulhi_epi16(ymm1, ymm5);          \
+    ymm2 = _mm256_adds_epi16(ymm2, ymm3);           \
+    \
+    ymm5 = _mm256_set1_epi32(0x10101010UL);         \
+    ymm6 = _mm256_subs_epu8(ymm6, ymm5);            \
+    ymm7 = _mm256_srli_epi16(ymm6, 8);              \
+    ymm5 = _mm256_set1_epi32(0x00ff00ffUL);         \
+    ymm6 = _mm256_and_si256(ymm6, ymm5);            \
+    ymm6 = _mm256_slli_epi16(ymm6, 3);              \
+    ymm7 = _mm256_slli_epi16(ymm7, 3);              \
+    ymm5 = _mm256_set1_epi32(0x253f253fUL);         \
+    ymm6 = _mm256_mulhi_epi16(ymm6, ymm5);          \
+    ymm7 = _mm256_mulhi_epi16(ymm7, ymm5);
+
+#define AVX2_YUV_ADD                                \
+    ymm3 = _mm256_adds_epi16(ymm0, ymm7);           \
+    ymm4 = _mm256_adds_epi16(ymm1, ymm7);           \
+    ymm5 = _mm256_adds_epi16(ymm2, ymm7);           \
+    ymm0 = _mm256_adds_epi16(ymm0, ymm6);           \
+    ymm1 = _mm256_adds_epi16(ymm1, ymm6);           \
+    ymm2 = _mm256_adds_epi16(ymm2, ymm6);           \
+    \
+    ymm0 = _mm256_packus_epi16(ymm0, ymm0);         \
+    ymm1 = _mm256_packus_epi16(ymm1, ymm1);         \
+    ymm2 = _mm256_packus_epi16(ymm2, ymm2);         \
+    \
+    ymm3 = _mm256_packus_epi16(ymm3, ymm3);         \
+    ymm4 = _mm256_packus_epi16(ymm4, ymm4);         \
+    ymm5 = _mm256_packus_epi16(ymm5, ymm5);         \
+    \
+    ymm0 = _mm256_unpacklo_epi8(ymm0, ymm3);        \
+    ymm1 = _mm256_unpacklo_epi8(ymm1, ymm4);        \
+    ymm2 = _mm256_unpacklo_epi8(ymm2, ymm5);
+
+/* ymm3 and ymm5 hold pixels 0-7 and 16-23, 8-15 and 24-31 respectively */
+#define AVX2_STORE_16(STORE)                                                \
+    STORE(p_buffer,      _mm256_permute2x128_si256(ymm3, ymm5, 0x20));      \
+    STORE(p_buffer + 16, _mm256_permute2x128_si256(ymm3, ymm5, 0x31));
+
+#define AVX2_UNPACK_15(STORE)                       \
+    ymm5 = _mm256_set1_epi32(0xf8f8f8f8UL);         \
+    ymm0 = _mm256_and_si256(ymm0, ymm5);            \
+    ymm0 = _mm256_srli_epi16(ymm0, 3);              \
+    ymm2 = _mm256_and_si256(ymm2, ymm5);            \
+    ymm1 = _mm256_and_si256(ymm1, ymm5);            \
+    ymm1 = _mm256_srli_epi16(ymm1, 1);              \
+    ymm4 = _mm256_setzero_si256();                  \
+    \
+    ymm6 = _mm256_unpacklo_epi8(ymm2, ymm4);        \
+    ymm7 = _mm256_unpackhi_epi8(ymm2, ymm4);        \
+    ymm6 = _mm256_slli_epi16(ymm6, 2);              \
+    ymm7 = _mm256_slli_epi16(ymm7, 2);              \
+    ymm3 = _mm256_unpacklo_epi8(ymm0, ymm1);        \
+    ymm5 = _mm256_unpackhi_epi8(ymm0, ymm1);        \
+    ymm3 = _mm256_or_si256(ymm3, ymm6);             \
+    ymm5 = _mm256_or_si256(ymm5, ymm7);             \
+    AVX2_STORE_16(STORE)
+
+#define AVX2_UNPACK_16(STORE)                       \
+    ymm5 = _mm256_set1_epi32(0xf8f8f8f8UL);         \
+    ymm0 = _mm256_and_si256(ymm0, ymm5);            \
+    ymm1 = _mm256_and_si256(ymm1, ymm5);            \
+    ymm5 = _mm256_set1_epi32(0xfcfcfcfcUL);         \
+    ymm2 = _mm256_and_si256(ymm2, ymm5);            \
+    ymm0 = _mm256_srli_epi16(ymm0, 3);              \
+    ymm4 = _mm256_setzero_si256();                  \
+    \
+    ymm6 = _mm256_unpacklo_epi8(ymm2, ymm4);        \
+    ymm7 = _mm256_unpackhi_epi8(ymm2, ymm4);        \
+    ymm6 = _mm256_slli_epi16(ymm6, 3);              \
+    ymm7 = _mm256_slli_epi16(ymm7, 3);              \
+    ymm3 = _mm256_unpacklo_epi8(ymm0, ymm1);        \
+    ymm5 = _mm256_unpackhi_epi8(ymm0, ymm1);        \
+    ymm3 = _mm256_or_si256(ymm3, ymm6);             \
+    ymm5 = _mm256_or_si256(ymm5, ymm7);             \
+    AVX2_STORE_16(STORE)
+
+/* Interleaves the bytes B0, B1, B2 and B3 (in memory order) of each pixel.
+ * ymm3 is the alpha (zero) component. */
+#define AVX2_UNPACK_32(B0, B1, B2, B3, STORE)                               \
+    ymm3 = _mm256_setzero_si256();                                          \
+    ymm4 = _mm256_unpacklo_epi8(B0, B1);                                    \
+    ymm5 = _mm256_unpacklo_epi8(B2, B3);                                    \
+    ymm6 = _mm256_unpacklo_epi16(ymm4, ymm5);                               \
+    ymm7 = _mm256_unpackhi_epi16(ymm4, ymm5);                               \
+    STORE(p_buffer,      _mm256_permute2x128_si256(ymm6, ymm7, 0x20));      \
+    STORE(p_buffer + 16, _mm256_permute2x128_si256(ymm6, ymm7, 0x31));      \
+    ymm4 = _mm256_unpackhi_epi8(B0, B1);                                    \
+    ymm5 = _mm256_unpackhi_epi8(B2, B3);                                    \
+    ymm6 = _mm256_unpacklo_epi16(ymm4, ymm5);                               \
+    ymm7 = _mm256_unpackhi_epi16(ymm4, ymm5);                               \
+    STORE(p_buffer + 8,  _mm256_permute2x128_si256(ymm6, ymm7, 0x20));      \
+    STORE(p_buffer + 24, _mm256_permute2x128_si256(ymm6, ymm7, 0x31));
+
+#define AVX2_UNPACK_32_ARGB(STORE) AVX2_UNPACK_32(ymm0, ymm2, ymm1, ymm3, STORE)
+#define AVX2_UNPACK_32_RGBA(STORE) AVX2_UNPACK_32(ymm3, ymm0, ymm2, ymm1, STORE)
+#define AVX2_UNPACK_32_BGRA(STORE) AVX2_UNPACK_32(ymm3, ymm1, ymm2, ymm0, STORE)
+#define AVX2_UNPACK_32_ABGR(STORE) AVX2_UNPACK_32(ymm1, ymm2, ymm0, ymm3, STORE)
+
+/*
+ * Converts one line: 32 pixels at a time, then the last 32 pixels again
+ * (overlapping) if the width is not a multiple of 32.
+ */
+#define AVX2_CONVERT_LINE(UNPACK, STORE)                                    \
+    for( i_x = i_width / 32; i_x--; )                                       \
+    {                                                                       \
+        AVX2_CALL (                                                         \
+            AVX2_INIT                                                       \
+            AVX2_YUV_MUL                                                    \
+            AVX2_YUV_ADD                                                    \
+            UNPACK(STORE)                                                   \
+        );                                                                  \
+        p_y += 32;                                                          \
+        p_u += 16;                                                          \
+        p_v += 16;                                                          \
+        p_buffer += 32;                                                     \
+    }                                                                       \
+    if( i_rewind )                                                          \
+    {                                                                       \
+        p_y -= i_rewind;                                                    \
+        p_u -= i_rewind >> 1;                                               \
+        p_v -= i_rewind >> 1;                                               \
+        p_buffer -= i_rewind;                                               \
+        AVX2_CALL (                                                         \
+            AVX2_INIT                                                       \
+            AVX2_YUV_MUL                                                    \
+            AVX2_YUV_ADD                                                    \
+            UNPACK(AVX2_STORE_UNALIGNED)                                    \
+        );                                                                  \
+        p_y += 32;                                                          \
+        p_u += 16;                                                          \
+        p_v += 16;                                                          \
+    }
+
+#endif
@@ -38,6 +38,13 @@
 #include <libswscale/swscale.h>
 #include <libswscale/version.h>
 
+/* Slice threading needs the frame API of libswscale 6.1 */
+#if LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100)
+# define CAN_THREAD_SWSCALE 1
+# include <libavutil/frame.h>
+# include <libavutil/opt.h>
+#endif
+
 #ifdef __APPLE__
 # include <TargetConditionals.h>
 #endif
@@ -57,6 +64,10 @@ static void CloseScaler( vlc_object_t * );
 #define SCALEMODE_TEXT N_("Scaling mode")
 #define SCALEMODE_LONGTEXT N_("Scaling mode to use.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads converting slices of each " \
+    "picture in parallel (0: one per CPU, 1: no threading).")
+
 static const int pi_mode_values[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
 static const char *const ppsz_mode_descriptions[] =
 { N_("Fast bilinear"), N_("Bilinear"), N_("Bicubic (good quality)"),
@@ -73,6 +84,7 @@ vlc_module_begin ()
     set_callbacks( OpenScaler, CloseScaler )
     add_integer( "swscale-mode", 2, SCALEMODE_TEXT, SCALEMODE_LONGTEXT, true )
         change_integer_list( pi_mode_values, ppsz_mode_descriptions )
+    add_integer( "swscale-threads", 0, THREADS_TEXT, THREADS_LONGTEXT, true )
 vlc_module_end ()
 
 /* Version checking */
@@ -88,6 +100,7 @@ typedef struct
 {
     SwsFilter *p_filter;
     int i_cpu_mask, i_sws_flags;
+    int i_threads;
 
     video_format_t fmt_in;
     video_format_t fmt_out;
@@ -96,6 +109,7 @@ typedef struct
 
     struct SwsContext *ctx;
     struct SwsContext *ctxA;
+    int i_fmti, i_fmto; /* libavutil pixel formats of ctx */
     picture_t *p_src_a;
     picture_t *p_dst_a;
     int i_extend_factor;
@@ -179,6 +193,13 @@ static int OpenScaler( vlc_object_t *p_this )
     default: p_sys->i_sws_flags = SWS_BICUBIC; i_sws_mode = 2; break;
     }
 
+    p_sys->i_threads = var_InheritInteger( p_filter, "swscale-threads" );
+    if( p_sys->i_threads <= 0 )
+        p_sys->i_threads = vlc_GetCPUCount();
+#ifndef CAN_THREAD_SWSCALE
+    p_sys->i_threads = 1;
+#endif
+
     /* Misc init */
     memset( &p_sys->fmt_in,  0, sizeof(p_sys->fmt_in) );
     memset( &p_sys->fmt_out, 0, sizeof(p_sys->fmt_out) );
@@ -202,6 +223,8 @@ static int OpenScaler( vlc_object_t *p_this )
              p_filter->fmt_out.video.i_width, p_filter->fmt_out.video.i_height,
              (char *)&p_filter->fmt_out.video.i_chroma,
              ppsz_mode_descriptions[i_sws_mode] );
+    if( p_sys->i_threads > 1 )
+        msg_Dbg( p_filter, "converting with %d threads", p_sys->i_threads );
 
     return VLC_SUCCESS;
 }
@@ -349,6 +372,41 @@ static int GetParameters( ScalerConfiguration *p_cfg,
     return VLC_SUCCESS;
 }
 
+static struct SwsContext *CreateContext( filter_sys_t *p_sys,
+                                         int i_srcw, int i_srch, int i_srcfmt,
+                                         int i_dstw, int i_dsth, int i_dstfmt,
+                                         int i_flags )
+{
+#ifdef CAN_THREAD_SWSCALE
+    if( p_sys->i_threads > 1 )
+    {
+        /* Same as sws_getContext(), with the thread count set before the
+         * context initialization */
+        struct SwsContext *ctx = sws_alloc_context();
+        if( ctx == NULL )
+            return NULL;
+
+        av_opt_set_int( ctx, "sws_flags", i_flags, 0 );
+        av_opt_set_int( ctx, "srcw", i_srcw, 0 );
+        av_opt_set_int( ctx, "srch", i_srch, 0 );
+        av_opt_set_int( ctx, "src_format", i_srcfmt, 0 );
+        av_opt_set_int( ctx, "dstw", i_dstw, 0 );
+        av_opt_set_int( ctx, "dsth", i_dsth, 0 );
+        av_opt_set_int( ctx, "dst_format", i_dstfmt, 0 );
+        av_opt_set_int( ctx, "threads", p_sys->i_threads, 0 );
+
+        if( sws_init_context( ctx, p_sys->p_filter, NULL ) < 0 )
+        {
+            sws_freeContext( ctx );
+            return NULL;
+        }
+        return ctx;
+    }
+#endif
+    return sws_getContext( i_srcw, i_srch, i_srcfmt, i_dstw, i_dsth, i_dstfmt,
+                           i_flags, p_sys->p_filter, NULL, 0 );
+}
+
 static int Init( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -403,10 +461,10 @@ static int Init( filter_t *p_filter )
         const int i_fmto = n == 0 ? cfg.i_fmto : AV_PIX_FMT_GRAY8;
         struct SwsContext *ctx;
 
-        ctx = sws_getContext( i_fmti_visible_width, p_fmti->i_visible_height, i_fmti,
-                              i_fmto_visible_width, p_fmto->i_visible_height, i_fmto,
-                              cfg.i_sws_flags | p_sys->i_cpu_mask,
-                              p_sys->p_filter, NULL, 0 );
+        ctx = CreateContext( p_sys,
+                             i_fmti_visible_width, p_fmti->i_visible_height, i_fmti,
+                             i_fmto_visible_width, p_fmto->i_visible_height, i_fmto,
+                             cfg.i_sws_flags | p_sys->i_cpu_mask );
         if( n == 0 )
             p_sys->ctx = ctx;
         else
@@ -457,6 +515,8 @@ static int Init( filter_t *p_filter )
         p_fmto->i_sar_den = i_sar_den;
     }
 
+    p_sys->i_fmti = cfg.i_fmti;
+    p_sys->i_fmto = cfg.i_fmto;
     p_sys->b_add_a = cfg.b_add_a;
     p_sys->b_copy = cfg.b_copy;
     p_sys->fmt_in  = *p_fmti;
@@ -583,6 +643,56 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
     picture_CopyPixels( p_dst, &tmp );
 }
 
+#ifdef CAN_THREAD_SWSCALE
+static void NoRelease( void *opaque, uint8_t *data )
+{
+    VLC_UNUSED(opaque); VLC_UNUSED(data);
+}
+
+/**
+ * Converts through the frame API, which is the only one spreading the work
+ * over the context threads. The frames wrap the picture planes without
+ * taking ownership, so that libswscale neither copies nor allocates them.
+ */
+static int ConvertFrame( filter_t *p_filter, struct SwsContext *ctx,
+                         uint8_t *const src[4], const int src_stride[4],
+                         uint8_t *const dst[4], const int dst_stride[4],
+                         int i_height )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const bool b_alpha = ctx == p_sys->ctxA;
+    AVFrame *p_srcf = av_frame_alloc();
+    AVFrame *p_dstf = av_frame_alloc();
+    int i_ret = AVERROR(ENOMEM);
+
+    if( unlikely(p_srcf == NULL || p_dstf == NULL) )
+        goto out;
+
+    for( int i = 0; i < 4; i++ )
+    {
+        p_srcf->data[i] = src[i];
+        p_srcf->linesize[i] = src_stride[i];
+        p_dstf->data[i] = dst[i];
+        p_dstf->linesize[i] = dst_stride[i];
+    }
+    p_srcf->format = b_alpha ? AV_PIX_FMT_GRAY8 : p_sys->i_fmti;
+    p_srcf->width  = p_filter->fmt_in.video.i_visible_width * p_sys->i_extend_factor;
+    p_srcf->height = i_height;
+    p_dstf->format = b_alpha ? AV_PIX_FMT_GRAY8 : p_sys->i_fmto;
+    p_dstf->width  = p_filter->fmt_out.video.i_visible_width * p_sys->i_extend_factor;
+    p_dstf->height = p_filter->fmt_out.video.i_visible_height;
+
+    p_srcf->buf[0] = av_buffer_create( src[0], 0, NoRelease, NULL, 0 );
+    p_dstf->buf[0] = av_buffer_create( dst[0], 0, NoRelease, NULL, 0 );
+    if( likely(p_srcf->buf[0] != NULL && p_dstf->buf[0] != NULL) )
+        i_ret = sws_scale_frame( ctx, p_dstf, p_srcf );
+out:
+    av_frame_free( &p_srcf );
+    av_frame_free( &p_dstf );
+    return i_ret;
+}
+#endif
+
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
                      picture_t *p_dst, picture_t *p_src, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
@@ -608,6 +718,14 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
                p_dst, i_plane_count, b_swap_uvo );
 
+#ifdef CAN_THREAD_SWSCALE
+    /* Fall back to the single threaded API if the frame API fails */
+    if( p_sys->i_threads > 1 &&
+        ConvertFrame( p_filter, ctx, src, src_stride, dst, dst_stride,
+                      i_height ) >= 0 )
+        return;
+#endif
+
     for (size_t i = 0; i < ARRAY_SIZE(src); i++)
         csrc[i] = src[i];
 
@@ -31,8 +31,22 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#if defined(CAN_COMPILE_SSE4_1) && defined(HAVE_SSE2_INTRINSICS)
+# include <smmintrin.h>
+# define BLEND_SSE4_1 1
+#endif
+#if defined(CAN_COMPILE_SSE4_1) && defined(HAVE_AVX2_INTRINSICS)
+# include <immintrin.h>
+# define BLEND_AVX2 1
+#endif
+#if defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BLEND_NEON 1
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -80,6 +94,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -558,16 +584,485 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+
+/*
+ * Vectorized blending of 8-bits YUVA and RGBA regions into 4:2:0 pictures,
+ * which is what subtitles and logos are burnt into most of the time.
+ *
+ * The results are the same as the generic Blend() above: chroma samples are
+ * taken from the source pixel on the even column of even lines, and the
+ * merges are done with 16-bits lanes, as (255 - a) * dst + a * src and the
+ * div255() approximation fit in 16 bits for 8-bits samples.
+ *
+ * Each instruction set provides a kernel class with the following functions,
+ * all processing n source pixels:
+ *  - Merge() blends contiguous samples (luma),
+ *  - MergeChroma() blends the even source samples into a planar chroma line,
+ *  - MergeUV() blends the even source samples into an interleaved chroma line,
+ *  - RgbaToYuva() converts RGBA pixels to planar YUVA samples.
+ */
+namespace {
+
+struct KernelsC {
+    static void Merge(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                      unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i++)
+            ::merge(&dst[i], src[i], div255(alpha * srca[i]));
+    }
+    static void MergeChroma(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; 2 * i < n; i++)
+            ::merge(&dst[i], src[2 * i], div255(alpha * srca[2 * i]));
+    }
+    static void MergeUV(uint8_t *dst, const uint8_t *srcu, const uint8_t *srcv,
+                        const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        for (unsigned i = 0; 2 * i < n; i++) {
+            const unsigned a = div255(alpha * srca[2 * i]);
+            ::merge(&dst[2 * i + 0], srcu[2 * i], a);
+            ::merge(&dst[2 * i + 1], srcv[2 * i], a);
+        }
+    }
+    static void RgbaToYuva(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                           const uint8_t *rgba, unsigned n)
+    {
+        for (unsigned i = 0; i < n; i++) {
+            rgb_to_yuv(&y[i], &u[i], &v[i],
+                       rgba[4 * i + 0], rgba[4 * i + 1], rgba[4 * i + 2]);
+            a[i] = rgba[4 * i + 3];
+        }
+    }
+};
+
+#ifdef BLEND_SSE4_1
+# define SSE4_1_TARGET __attribute__ ((__target__ ("sse4.1")))
+
+SSE4_1_TARGET
+static inline __m128i Div255SSE4(__m128i v)
+{
+    v = _mm_add_epi16(v, _mm_srli_epi16(v, 8));
+    return _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(1)), 8);
+}
+
+/* Blends 16-bits lanes, alpha being the global alpha in all lanes */
+SSE4_1_TARGET
+static inline __m128i MergeSSE4(__m128i d, __m128i s, __m128i sa,
+                                __m128i alpha)
+{
+    const __m128i a = Div255SSE4(_mm_mullo_epi16(sa, alpha));
+    const __m128i v = _mm_add_epi16(
+        _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), a)),
+        _mm_mullo_epi16(s, a));
+    return Div255SSE4(v);
+}
+
+struct KernelsSSE4_1 {
+    SSE4_1_TARGET
+    static void Merge(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                      unsigned alpha, unsigned n)
+    {
+        const __m128i va = _mm_set1_epi16(alpha);
+        const __m128i zero = _mm_setzero_si128();
+        unsigned i = 0;
+
+        for (; i + 16 <= n; i += 16) {
+            const __m128i d  = _mm_loadu_si128((const __m128i *)&dst[i]);
+            const __m128i s  = _mm_loadu_si128((const __m128i *)&src[i]);
+            const __m128i sa = _mm_loadu_si128((const __m128i *)&srca[i]);
+            const __m128i lo = MergeSSE4(_mm_cvtepu8_epi16(d),
+                                         _mm_cvtepu8_epi16(s),
+                                         _mm_cvtepu8_epi16(sa), va);
+            const __m128i hi = MergeSSE4(_mm_unpackhi_epi8(d, zero),
+                                         _mm_unpackhi_epi8(s, zero),
+                                         _mm_unpackhi_epi8(sa, zero), va);
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+        }
+        KernelsC::Merge(&dst[i], &src[i], &srca[i], alpha, n - i);
+    }
+    SSE4_1_TARGET
+    static void MergeChroma(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const __m128i va = _mm_set1_epi16(alpha);
+        const __m128i even = _mm_set1_epi16(0xff);
+        unsigned i = 0;
+
+        for (; 2 * i + 16 <= n; i += 8) {
+            const __m128i d  = _mm_loadl_epi64((const __m128i *)&dst[i]);
+            const __m128i s  = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+            const __m128i sa = _mm_loadu_si128((const __m128i *)&srca[2 * i]);
+            const __m128i r = MergeSSE4(_mm_cvtepu8_epi16(d),
+                                        _mm_and_si128(s, even),
+                                        _mm_and_si128(sa, even), va);
+            _mm_storel_epi64((__m128i *)&dst[i], _mm_packus_epi16(r, r));
+        }
+        KernelsC::MergeChroma(&dst[i], &src[2 * i], &srca[2 * i], alpha,
+                              n - 2 * i);
+    }
+    SSE4_1_TARGET
+    static void MergeUV(uint8_t *dst, const uint8_t *srcu, const uint8_t *srcv,
+                        const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const __m128i va = _mm_set1_epi16(alpha);
+        const __m128i even = _mm_set1_epi16(0xff);
+        const __m128i zero = _mm_setzero_si128();
+        unsigned i = 0;
+
+        for (; i + 16 <= n; i += 16) {
+            const __m128i d  = _mm_loadu_si128((const __m128i *)&dst[i]);
+            const __m128i u  = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srcu[i]), even);
+            const __m128i v  = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srcv[i]), even);
+            const __m128i sa = _mm_and_si128(_mm_loadu_si128((const __m128i *)&srca[i]), even);
+            const __m128i lo = MergeSSE4(_mm_cvtepu8_epi16(d),
+                                         _mm_unpacklo_epi16(u, v),
+                                         _mm_unpacklo_epi16(sa, sa), va);
+            const __m128i hi = MergeSSE4(_mm_unpackhi_epi8(d, zero),
+                                         _mm_unpackhi_epi16(u, v),
+                                         _mm_unpackhi_epi16(sa, sa), va);
+            _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+        }
+        KernelsC::MergeUV(&dst[i], &srcu[i], &srcv[i], &srca[i], alpha, n - i);
+    }
+    SSE4_1_TARGET
+    static void RgbaToYuva(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                           const uint8_t *rgba, unsigned n)
+    {
+        const __m128i mask = _mm_set1_epi32(0xff);
+        const __m128i round = _mm_set1_epi16(128);
+        unsigned i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m128i p0 = _mm_loadu_si128((const __m128i *)&rgba[4 * i]);
+            const __m128i p1 = _mm_loadu_si128((const __m128i *)&rgba[4 * i + 16]);
+            const __m128i r = _mm_packus_epi32(_mm_and_si128(p0, mask),
+                                               _mm_and_si128(p1, mask));
+            const __m128i g = _mm_packus_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), mask),
+                                               _mm_and_si128(_mm_srli_epi32(p1, 8), mask));
+            const __m128i b = _mm_packus_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), mask),
+                                               _mm_and_si128(_mm_srli_epi32(p1, 16), mask));
+            const __m128i al = _mm_packus_epi32(_mm_srli_epi32(p0, 24),
+                                                _mm_srli_epi32(p1, 24));
+
+            /* The sums wrap around, but the shifted results fit */
+            __m128i vy = _mm_add_epi16(_mm_add_epi16(
+                _mm_mullo_epi16(r, _mm_set1_epi16(66)),
+                _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), round));
+            vy = _mm_add_epi16(_mm_srli_epi16(vy, 8), _mm_set1_epi16(16));
+            __m128i vu = _mm_add_epi16(_mm_add_epi16(
+                _mm_mullo_epi16(r, _mm_set1_epi16(-38)),
+                _mm_mullo_epi16(g, _mm_set1_epi16(-74))),
+                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(112)), round));
+            vu = _mm_add_epi16(_mm_srai_epi16(vu, 8), round);
+            __m128i vv = _mm_add_epi16(_mm_add_epi16(
+                _mm_mullo_epi16(r, _mm_set1_epi16(112)),
+                _mm_mullo_epi16(g, _mm_set1_epi16(-94))),
+                _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(-18)), round));
+            vv = _mm_add_epi16(_mm_srai_epi16(vv, 8), round);
+
+            _mm_storel_epi64((__m128i *)&y[i], _mm_packus_epi16(vy, vy));
+            _mm_storel_epi64((__m128i *)&u[i], _mm_packus_epi16(vu, vu));
+            _mm_storel_epi64((__m128i *)&v[i], _mm_packus_epi16(vv, vv));
+            _mm_storel_epi64((__m128i *)&a[i], _mm_packus_epi16(al, al));
+        }
+        KernelsC::RgbaToYuva(&y[i], &u[i], &v[i], &a[i], &rgba[4 * i], n - i);
+    }
+};
+#endif
+
+#ifdef BLEND_AVX2
+# define AVX2_TARGET __attribute__ ((__target__ ("avx2")))
+
+AVX2_TARGET
+static inline __m256i Div255AVX2(__m256i v)
+{
+    v = _mm256_add_epi16(v, _mm256_srli_epi16(v, 8));
+    return _mm256_srli_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(1)), 8);
+}
+
+AVX2_TARGET
+static inline __m256i MergeAVX2(__m256i d, __m256i s, __m256i sa,
+                                __m256i alpha)
+{
+    const __m256i a = Div255AVX2(_mm256_mullo_epi16(sa, alpha));
+    const __m256i v = _mm256_add_epi16(
+        _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), a)),
+        _mm256_mullo_epi16(s, a));
+    return Div255AVX2(v);
+}
+
+/* Packs two vectors of 16 lanes into 32 bytes, in order */
+AVX2_TARGET
+static inline __m256i PackAVX2(__m256i lo, __m256i hi)
+{
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+}
+
+/* The RGBA conversion is a minor part of the work, and is shared with SSE4.1.
+ * The upper halves of the registers are cleared before running the SSE4.1
+ * code on the remaining pixels, to avoid the transition penalty. */
+struct KernelsAVX2 : public KernelsSSE4_1 {
+    AVX2_TARGET
+    static void Merge(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                      unsigned alpha, unsigned n)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        unsigned i = 0;
+
+        for (; i + 32 <= n; i += 32) {
+            const __m256i d  = _mm256_loadu_si256((const __m256i *)&dst[i]);
+            const __m256i s  = _mm256_loadu_si256((const __m256i *)&src[i]);
+            const __m256i sa = _mm256_loadu_si256((const __m256i *)&srca[i]);
+            const __m256i lo = MergeAVX2(
+                _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)),
+                _mm256_cvtepu8_epi16(_mm256_castsi256_si128(s)),
+                _mm256_cvtepu8_epi16(_mm256_castsi256_si128(sa)), va);
+            const __m256i hi = MergeAVX2(
+                _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)),
+                _mm256_cvtepu8_epi16(_mm256_extracti128_si256(s, 1)),
+                _mm256_cvtepu8_epi16(_mm256_extracti128_si256(sa, 1)), va);
+            _mm256_storeu_si256((__m256i *)&dst[i], PackAVX2(lo, hi));
+        }
+        _mm256_zeroupper();
+        KernelsSSE4_1::Merge(&dst[i], &src[i], &srca[i], alpha, n - i);
+    }
+    AVX2_TARGET
+    static void MergeChroma(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        const __m256i even = _mm256_set1_epi16(0xff);
+        unsigned i = 0;
+
+        for (; 2 * i + 32 <= n; i += 16) {
+            const __m128i d  = _mm_loadu_si128((const __m128i *)&dst[i]);
+            const __m256i s  = _mm256_loadu_si256((const __m256i *)&src[2 * i]);
+            const __m256i sa = _mm256_loadu_si256((const __m256i *)&srca[2 * i]);
+            const __m256i r = MergeAVX2(_mm256_cvtepu8_epi16(d),
+                                        _mm256_and_si256(s, even),
+                                        _mm256_and_si256(sa, even), va);
+            _mm_storeu_si128((__m128i *)&dst[i],
+                             _mm256_castsi256_si128(PackAVX2(r, r)));
+        }
+        _mm256_zeroupper();
+        KernelsSSE4_1::MergeChroma(&dst[i], &src[2 * i], &srca[2 * i], alpha,
+                                   n - 2 * i);
+    }
+    AVX2_TARGET
+    static void MergeUV(uint8_t *dst, const uint8_t *srcu, const uint8_t *srcv,
+                        const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const __m256i va = _mm256_set1_epi16(alpha);
+        const __m256i even = _mm256_set1_epi16(0xff);
+        unsigned i = 0;
+
+        for (; i + 32 <= n; i += 32) {
+            const __m256i d  = _mm256_loadu_si256((const __m256i *)&dst[i]);
+            const __m256i u  = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srcu[i]), even);
+            const __m256i v  = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srcv[i]), even);
+            const __m256i sa = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)&srca[i]), even);
+            /* The unpacking works within 128-bits lanes */
+            const __m256i uvl = _mm256_unpacklo_epi16(u, v);
+            const __m256i uvh = _mm256_unpackhi_epi16(u, v);
+            const __m256i aal = _mm256_unpacklo_epi16(sa, sa);
+            const __m256i aah = _mm256_unpackhi_epi16(sa, sa);
+            const __m256i lo = MergeAVX2(
+                _mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)),
+                _mm256_permute2x128_si256(uvl, uvh, 0x20),
+                _mm256_permute2x128_si256(aal, aah, 0x20), va);
+            const __m256i hi = MergeAVX2(
+                _mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)),
+                _mm256_permute2x128_si256(uvl, uvh, 0x31),
+                _mm256_permute2x128_si256(aal, aah, 0x31), va);
+            _mm256_storeu_si256((__m256i *)&dst[i], PackAVX2(lo, hi));
+        }
+        _mm256_zeroupper();
+        KernelsSSE4_1::MergeUV(&dst[i], &srcu[i], &srcv[i], &srca[i], alpha,
+                               n - i);
+    }
+};
+#endif
+
+#ifdef BLEND_NEON
+static inline uint8x8_t Div255NEON(uint16x8_t v)
+{
+    return vshrn_n_u16(vaddq_u16(vsraq_n_u16(v, v, 8), vdupq_n_u16(1)), 8);
+}
+
+static inline uint8x8_t MergeNEON(uint8x8_t d, uint8x8_t s, uint8x8_t sa,
+                                  uint8x8_t alpha)
+{
+    const uint8x8_t a = Div255NEON(vmull_u8(sa, alpha));
+    return Div255NEON(vmlal_u8(vmull_u8(d, vmvn_u8(a)), s, a));
+}
+
+struct KernelsNEON {
+    static void Merge(uint8_t *dst, const uint8_t *src, const uint8_t *srca,
+                      unsigned alpha, unsigned n)
+    {
+        const uint8x8_t va = vdup_n_u8(alpha);
+        unsigned i = 0;
+
+        for (; i + 16 <= n; i += 16) {
+            const uint8x16_t d  = vld1q_u8(&dst[i]);
+            const uint8x16_t s  = vld1q_u8(&src[i]);
+            const uint8x16_t sa = vld1q_u8(&srca[i]);
+            vst1q_u8(&dst[i], vcombine_u8(
+                MergeNEON(vget_low_u8(d), vget_low_u8(s), vget_low_u8(sa), va),
+                MergeNEON(vget_high_u8(d), vget_high_u8(s), vget_high_u8(sa), va)));
+        }
+        KernelsC::Merge(&dst[i], &src[i], &srca[i], alpha, n - i);
+    }
+    static void MergeChroma(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const uint8x8_t va = vdup_n_u8(alpha);
+        unsigned i = 0;
+
+        for (; 2 * i + 16 <= n; i += 8) {
+            const uint8x8x2_t s  = vld2_u8(&src[2 * i]);
+            const uint8x8x2_t sa = vld2_u8(&srca[2 * i]);
+            vst1_u8(&dst[i], MergeNEON(vld1_u8(&dst[i]), s.val[0], sa.val[0], va));
+        }
+        KernelsC::MergeChroma(&dst[i], &src[2 * i], &srca[2 * i], alpha,
+                              n - 2 * i);
+    }
+    static void MergeUV(uint8_t *dst, const uint8_t *srcu, const uint8_t *srcv,
+                        const uint8_t *srca, unsigned alpha, unsigned n)
+    {
+        const uint8x8_t va = vdup_n_u8(alpha);
+        unsigned i = 0;
+
+        for (; i + 16 <= n; i += 16) {
+            const uint8x8x2_t u  = vld2_u8(&srcu[i]);
+            const uint8x8x2_t v  = vld2_u8(&srcv[i]);
+            const uint8x8x2_t sa = vld2_u8(&srca[i]);
+            uint8x8x2_t d = vld2_u8(&dst[i]);
+
+            d.val[0] = MergeNEON(d.val[0], u.val[0], sa.val[0], va);
+            d.val[1] = MergeNEON(d.val[1], v.val[0], sa.val[0], va);
+            vst2_u8(&dst[i], d);
+        }
+        KernelsC::MergeUV(&dst[i], &srcu[i], &srcv[i], &srca[i], alpha, n - i);
+    }
+    static void RgbaToYuva(uint8_t *y, uint8_t *u, uint8_t *v, uint8_t *a,
+                           const uint8_t *rgba, unsigned n)
+    {
+        const uint16x8_t round = vdupq_n_u16(128);
+        unsigned i = 0;
+
+        for (; i + 8 <= n; i += 8) {
+            const uint8x8x4_t px = vld4_u8(&rgba[4 * i]);
+            const uint8x8_t r = px.val[0], g = px.val[1], b = px.val[2];
+            uint16x8_t t;
+
+            t = vmlal_u8(vmlal_u8(vmull_u8(r, vdup_n_u8(66)),
+                                  g, vdup_n_u8(129)), b, vdup_n_u8(25));
+            vst1_u8(&y[i], vadd_u8(vshrn_n_u16(vaddq_u16(t, round), 8),
+                                   vdup_n_u8(16)));
+            /* The differences wrap around, but the shifted results fit */
+            t = vmlsl_u8(vmlsl_u8(vmull_u8(b, vdup_n_u8(112)),
+                                  r, vdup_n_u8(38)), g, vdup_n_u8(74));
+            t = vaddq_u16(t, round);
+            vst1_u8(&u[i], vadd_u8(vreinterpret_u8_s8(vshrn_n_s16(
+                            vreinterpretq_s16_u16(t), 8)), vdup_n_u8(128)));
+            t = vmlsl_u8(vmlsl_u8(vmull_u8(r, vdup_n_u8(112)),
+                                  g, vdup_n_u8(94)), b, vdup_n_u8(18));
+            t = vaddq_u16(t, round);
+            vst1_u8(&v[i], vadd_u8(vreinterpret_u8_s8(vshrn_n_s16(
+                            vreinterpretq_s16_u16(t), 8)), vdup_n_u8(128)));
+            vst1_u8(&a[i], px.val[3]);
+        }
+        KernelsC::RgbaToYuva(&y[i], &u[i], &v[i], &a[i], &rgba[4 * i], n - i);
+    }
+};
+#endif
+
+} // namespace
+
+template <class K, bool semiplanar, bool swap_uv, bool rgba>
+void BlendSIMD(const CPicture &dst_data, const CPicture &src_data,
+               unsigned width, unsigned height, int alpha)
+{
+    /* RGBA pixels are converted in chunks, of an even size to keep the
+     * chroma sampling phase */
+    enum { CHUNK = 256 };
+    uint8_t yuva[4][CHUNK];
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+
+    for (unsigned y = 0; y < height; y++) {
+        const unsigned line = dy + y;
+        uint8_t *dst_y = &dst->p[0].p_pixels[line * dst->p[0].i_pitch + dx];
+        uint8_t *dst_u, *dst_v;
+        if (semiplanar) {
+            dst_u = &dst->p[1].p_pixels[line / 2 * dst->p[1].i_pitch];
+            dst_v = NULL;
+        } else {
+            dst_u = &dst->p[swap_uv ? 2 : 1].p_pixels[line / 2 * dst->p[swap_uv ? 2 : 1].i_pitch];
+            dst_v = &dst->p[swap_uv ? 1 : 2].p_pixels[line / 2 * dst->p[swap_uv ? 1 : 2].i_pitch];
+        }
+
+        for (unsigned x = 0; x < width; x += CHUNK) {
+            const unsigned n = __MIN(width - x, (unsigned)CHUNK);
+            const uint8_t *src_y, *src_u, *src_v, *src_a;
+
+            if (rgba) {
+                K::RgbaToYuva(yuva[0], yuva[1], yuva[2], yuva[3],
+                              &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch + (sx + x) * 4],
+                              n);
+                src_y = yuva[0];
+                src_u = yuva[1];
+                src_v = yuva[2];
+                src_a = yuva[3];
+            } else {
+                src_y = &src->p[0].p_pixels[(sy + y) * src->p[0].i_pitch + sx + x];
+                src_u = &src->p[1].p_pixels[(sy + y) * src->p[1].i_pitch + sx + x];
+                src_v = &src->p[2].p_pixels[(sy + y) * src->p[2].i_pitch + sx + x];
+                src_a = &src->p[3].p_pixels[(sy + y) * src->p[3].i_pitch + sx + x];
+            }
+
+            K::Merge(&dst_y[x], src_y, src_a, alpha, n);
+
+            /* The chroma is sampled from the pixels on the even columns */
+            const unsigned phase = (dx + x) % 2;
+            if ((line % 2) != 0 || n <= phase)
+                continue;
+
+            const unsigned c = (dx + x + phase) / 2;
+            if (semiplanar) {
+                if (swap_uv)
+                    K::MergeUV(&dst_u[2 * c], &src_v[phase], &src_u[phase],
+                               &src_a[phase], alpha, n - phase);
+                else
+                    K::MergeUV(&dst_u[2 * c], &src_u[phase], &src_v[phase],
+                               &src_a[phase], alpha, n - phase);
+            } else {
+                K::MergeChroma(&dst_u[c], &src_u[phase], &src_a[phase],
+                               alpha, n - phase);
+                K::MergeChroma(&dst_v[c], &src_v[phase], &src_a[phase],
+                               alpha, n - phase);
+            }
+        }
+    }
+}
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
 namespace {
 
-static const struct {
+struct blend_entry {
     vlc_fourcc_t     dst;
     vlc_fourcc_t     src;
     blend_function_t blend;
-} blends[] = {
+};
+
+static const blend_entry blends[] = {
 #undef RGB
 #undef YUV
 #define RGB(csp, picture, cvt) \
@@ -637,6 +1132,38 @@ static const struct {
 #undef YUV
 };
 
+#define SIMD(K) \
+    { VLC_CODEC_I420, VLC_CODEC_YUVA, BlendSIMD<K, false, false, false> }, \
+    { VLC_CODEC_I420, VLC_CODEC_RGBA, BlendSIMD<K, false, false, true > }, \
+    { VLC_CODEC_J420, VLC_CODEC_YUVA, BlendSIMD<K, false, false, false> }, \
+    { VLC_CODEC_J420, VLC_CODEC_RGBA, BlendSIMD<K, false, false, true > }, \
+    { VLC_CODEC_YV12, VLC_CODEC_YUVA, BlendSIMD<K, false, true,  false> }, \
+    { VLC_CODEC_YV12, VLC_CODEC_RGBA, BlendSIMD<K, false, true,  true > }, \
+    { VLC_CODEC_NV12, VLC_CODEC_YUVA, BlendSIMD<K, true,  false, false> }, \
+    { VLC_CODEC_NV12, VLC_CODEC_RGBA, BlendSIMD<K, true,  false, true > }, \
+    { VLC_CODEC_NV21, VLC_CODEC_YUVA, BlendSIMD<K, true,  true,  false> }, \
+    { VLC_CODEC_NV21, VLC_CODEC_RGBA, BlendSIMD<K, true,  true,  true > }
+#ifdef BLEND_AVX2
+static const blend_entry blends_avx2[] = { SIMD(KernelsAVX2) };
+#endif
+#ifdef BLEND_SSE4_1
+static const blend_entry blends_sse4_1[] = { SIMD(KernelsSSE4_1) };
+#endif
+#ifdef BLEND_NEON
+static const blend_entry blends_neon[] = { SIMD(KernelsNEON) };
+#endif
+#undef SIMD
+
+static blend_function_t FindBlend(const blend_entry *table, size_t count,
+                                  vlc_fourcc_t dst, vlc_fourcc_t src)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (table[i].src == src && table[i].dst == dst)
+            return table[i].blend;
+    }
+    return NULL;
+}
+
 struct filter_sys_t {
     filter_sys_t() : blend(NULL)
     {
@@ -687,10 +1214,27 @@ static int Open(vlc_object_t *object)
     const vlc_fourcc_t dst = filter->fmt_out.video.i_chroma;
 
     filter_sys_t *sys = new filter_sys_t();
-    for (size_t i = 0; i < sizeof(blends) / sizeof(*blends); i++) {
-        if (blends[i].src == src && blends[i].dst == dst)
-            sys->blend = blends[i].blend;
-    }
+#ifdef BLEND_AVX2
+    if (!sys->blend && vlc_CPU_AVX2())
+        sys->blend = FindBlend(blends_avx2,
+                               sizeof(blends_avx2) / sizeof(*blends_avx2),
+                               dst, src);
+#endif
+#ifdef BLEND_SSE4_1
+    if (!sys->blend && vlc_CPU_SSE4_1())
+        sys->blend = FindBlend(blends_sse4_1,
+                               sizeof(blends_sse4_1) / sizeof(*blends_sse4_1),
+                               dst, src);
+#endif
+#ifdef BLEND_NEON
+    if (!sys->blend && vlc_CPU_ARM_NEON())
+        sys->blend = FindBlend(blends_neon,
+                               sizeof(blends_neon) / sizeof(*blends_neon),
+                               dst, src);
+#endif
+    if (!sys->blend)
+        sys->blend = FindBlend(blends, sizeof(blends) / sizeof(*blends),
+                               dst, src);
 
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
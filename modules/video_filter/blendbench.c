@@ -59,14 +59,17 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BASE_IMAGE_LONGTEXT N_("The image which will be used to blend onto")
 
 #define BASE_CHROMA_TEXT N_("Chroma for the base image")
-#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded in")
+#define BASE_CHROMA_LONGTEXT N_("Chroma which the base image will be loaded " \
+                                "in. A comma separated list benchmarks " \
+                                "each chroma in turn.")
 
 #define BLEND_IMAGE_TEXT N_("Image which will be blended")
 #define BLEND_IMAGE_LONGTEXT N_("The image blended onto the base image")
 
 #define BLEND_CHROMA_TEXT N_("Chroma for the blend image")
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
-                                 " in")
+                                 " in. A comma separated list benchmarks " \
+                                 "each chroma in turn.")
 
 #define CFG_PREFIX "blendbench-"
 
@@ -103,6 +106,8 @@ static const char *const ppsz_filter_options[] = {
     "blend-chroma", NULL
 };
 
+#define MAX_CHROMAS 16
+
 /*****************************************************************************
  * filter_sys_t: filter method descriptor
  *****************************************************************************/
@@ -111,11 +116,11 @@ typedef struct
     bool b_done;
     int i_loops, i_alpha;
 
-    picture_t *p_base_image;
-    picture_t *p_blend_image;
-
-    vlc_fourcc_t i_base_chroma;
-    vlc_fourcc_t i_blend_chroma;
+    /* One image per requested chroma */
+    picture_t *pp_base_images[MAX_CHROMAS];
+    picture_t *pp_blend_images[MAX_CHROMAS];
+    unsigned i_base_images;
+    unsigned i_blend_images;
 } filter_sys_t;
 
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
@@ -144,6 +149,45 @@ static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
     return VLC_SUCCESS;
 }
 
+/* Loads the image once for each chroma of the comma separated list */
+static int blendbench_LoadImages( vlc_object_t *p_this, picture_t **pp_pics,
+                                  unsigned *pi_count, const char *psz_chromas,
+                                  char *psz_file, const char *psz_name )
+{
+    char *psz_list = strdup( psz_chromas ? psz_chromas : "" );
+    char *psz_save = NULL;
+
+    *pi_count = 0;
+    if( unlikely(psz_list == NULL) )
+        return VLC_ENOMEM;
+
+    for( const char *psz = strtok_r( psz_list, ",", &psz_save );
+         psz != NULL && *pi_count < MAX_CHROMAS;
+         psz = strtok_r( NULL, ",", &psz_save ) )
+    {
+        vlc_fourcc_t i_chroma = strlen( psz ) != 4 ? 0 :
+            VLC_FOURCC( psz[0], psz[1], psz[2], psz[3] );
+
+        if( blendbench_LoadImage( p_this, &pp_pics[*pi_count], i_chroma,
+                                  psz_file, psz_name ) != VLC_SUCCESS )
+        {
+            while( *pi_count > 0 )
+                picture_Release( pp_pics[--*pi_count] );
+            free( psz_list );
+            return VLC_EGENERIC;
+        }
+        (*pi_count)++;
+    }
+    free( psz_list );
+
+    if( *pi_count == 0 )
+    {
+        msg_Err( p_this, "No chroma for %s image", psz_name );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * Create: allocates video thread output method
  *****************************************************************************/
@@ -175,11 +219,10 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "alpha" );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
-    p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
-        VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+    i_ret = blendbench_LoadImages( p_this, p_sys->pp_base_images,
+                                   &p_sys->i_base_images, psz_temp, psz_cmd,
+                                   "Base" );
     free( psz_temp );
     free( psz_cmd );
     if( i_ret != VLC_SUCCESS )
@@ -190,18 +233,18 @@ static int Create( vlc_object_t *p_this )
 
     psz_temp = var_CreateGetStringCommand( p_filter,
                                            CFG_PREFIX "blend-chroma" );
-    p_sys->i_blend_chroma = !psz_temp || strlen( psz_temp ) != 4
-        ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
-    i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
+    i_ret = blendbench_LoadImages( p_this, p_sys->pp_blend_images,
+                                   &p_sys->i_blend_images, psz_temp, psz_cmd,
+                                   "Blend" );
 
     free( psz_temp );
     free( psz_cmd );
 
     if( i_ret != VLC_SUCCESS )
     {
-        picture_Release( p_sys->p_base_image );
+        for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+            picture_Release( p_sys->pp_base_images[i] );
         free( p_sys );
 
         return VLC_EGENERIC;
@@ -218,57 +261,82 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+        picture_Release( p_sys->pp_base_images[i] );
+    for( unsigned i = 0; i < p_sys->i_blend_images; i++ )
+        picture_Release( p_sys->pp_blend_images[i] );
+    free( p_sys );
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * Bench: blends one image onto another and reports the speed
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void Bench( filter_t *p_filter, picture_t *p_base, picture_t *p_blend )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
-
-    if( p_sys->b_done )
-        return p_pic;
-
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
+    const vlc_fourcc_t i_src = p_blend->format.i_chroma;
+    const vlc_fourcc_t i_dst = p_base->format.i_chroma;
+    filter_t *p_blend_filter;
+
+    p_blend_filter = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_blend_filter )
+        return;
+    p_blend_filter->fmt_out.video = p_base->format;
+    p_blend_filter->fmt_in.video = p_blend->format;
+    p_blend_filter->p_module = module_need( p_blend_filter, "video blending",
+                                            NULL, false );
+    if( !p_blend_filter->p_module )
     {
-        picture_Release( p_pic );
-        return NULL;
-    }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
-    {
-        picture_Release( p_pic );
-        vlc_object_delete(p_blend);
-        return NULL;
+        msg_Err( p_filter, "Cannot blend %4.4s onto %4.4s",
+                 (const char *)&i_src, (const char *)&i_dst );
+        vlc_object_delete(p_blend_filter);
+        return;
     }
 
     vlc_tick_t time = vlc_tick_now();
     for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
+        p_blend_filter->pf_video_blend( p_blend_filter, p_base, p_blend,
+                                        0, 0, p_sys->i_alpha );
     }
     time = vlc_tick_now() - time;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    /* Only the area covered by both images is blended */
+    const double f_pixels = (double)p_sys->i_loops *
+        __MIN( p_base->format.i_visible_width,
+               p_blend->format.i_visible_width ) *
+        __MIN( p_base->format.i_visible_height,
+               p_blend->format.i_visible_height );
+    const double f_time = secf_from_vlc_tick(time);
+
+    msg_Info( p_filter, "%4.4s -> %4.4s: blended %d images in %f sec",
+              (const char *)&i_src, (const char *)&i_dst,
+              p_sys->i_loops, f_time );
+    if( time > 0 && f_pixels > 0 )
+        msg_Info( p_filter, "%4.4s -> %4.4s: %f images/second, "
+                  "%f pixels/second, %.3f ns/pixel",
+                  (const char *)&i_src, (const char *)&i_dst,
+                  p_sys->i_loops / f_time, f_pixels / f_time,
+                  f_time * 1e9 / f_pixels );
+
+    module_unneed( p_blend_filter, p_blend_filter->p_module );
+    vlc_object_delete(p_blend_filter);
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
 
-    module_unneed( p_blend, p_blend->p_module );
+    if( p_sys->b_done )
+        return p_pic;
 
-    vlc_object_delete(p_blend);
+    for( unsigned i = 0; i < p_sys->i_base_images; i++ )
+        for( unsigned j = 0; j < p_sys->i_blend_images; j++ )
+            Bench( p_filter, p_sys->pp_base_images[i],
+                   p_sys->pp_blend_images[j] );
 
     p_sys->b_done = true;
     return p_pic;
@@ -511,9 +511,19 @@ static inline void XDeintBand8x8MMXEXT( uint8_t *dst, int i_dst,
  * Public functions
  *****************************************************************************/
 
-int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+struct x_job
+{
+    picture_t *p_outpic;
+    picture_t *p_pic;
+};
+
+/* The 8 lines bands only read the source picture, so they can be rendered
+   in any order. The last slice also handles the last, partial, band. */
+static void XSlice( void *p_opaque, unsigned i_slice, unsigned i_slices )
 {
-    VLC_UNUSED(p_filter);
+    const struct x_job *job = p_opaque;
+    picture_t *p_outpic = job->p_outpic;
+    picture_t *p_pic = job->p_pic;
     int i_plane;
 #if defined (CAN_COMPILE_MMXEXT)
     const bool mmxext = vlc_CPU_MMXEXT();
@@ -531,9 +541,13 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
         const int i_dst = p_outpic->p[i_plane].i_pitch;
         const int i_src = p_pic->p[i_plane].i_pitch;
 
+        unsigned i_start, i_end;
         int y, x;
 
-        for( y = 0; y < i_mby; y++ )
+        SliceRange( i_mby > 0 ? i_mby : 0, i_slice, i_slices,
+                    &i_start, &i_end );
+
+        for( y = i_start; y < (int)i_end; y++ )
         {
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
@@ -547,8 +561,10 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
         }
 
         /* Last line (C only)*/
-        if( i_mody )
+        if( i_mody && i_slice == i_slices - 1 )
         {
+            y = i_mby;
+
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
 
@@ -569,5 +585,16 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
     if( mmxext )
         emms();
 #endif
+}
+
+int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct x_job job = {
+        .p_outpic = p_outpic,
+        .p_pic = p_pic,
+    };
+
+    SlicesRun( &p_sys->slices, XSlice, &job );
     return VLC_SUCCESS;
 }
@@ -287,6 +287,12 @@ static void Close( vlc_object_t *p_this );
                                     "Best simulation, but requires more CPU "\
                                     "and memory bandwidth.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads rendering horizontal bands "\
+                            "of the picture with the Yadif and X "\
+                            "algorithms. 0 selects a count suited to the "\
+                            "picture height and the number of CPUs.")
+
 #define PHOSPHOR_DIMMER_TEXT N_("Phosphor old field dimmer strength")
 #define PHOSPHOR_DIMMER_LONGTEXT N_("This controls the strength of the "\
                                     "darkening filter that simulates CRT TV "\
@@ -313,6 +319,8 @@ vlc_module_begin ()
                 PHOSPHOR_DIMMER_LONGTEXT, true )
         change_integer_list( phosphor_dimmer_list, phosphor_dimmer_list_text )
         change_safe ()
+    add_integer_with_range( FILTER_CFG_PREFIX "threads", 0, 0, 16,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
     add_shortcut( "deinterlace" )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -328,7 +336,7 @@ vlc_module_end ()
  * and reading logic for them implemented in Open().
  */
 static const char *const ppsz_filter_options[] = {
-    "mode", "phosphor-chroma", "phosphor-dimmer",
+    "mode", "phosphor-chroma", "phosphor-dimmer", "threads",
     NULL
 };
 
@@ -347,30 +355,31 @@ struct filter_mode_t
     deinterlace_algo     settings;
     bool                 can_pack;         /**< can handle packed pixel */
     bool                 b_high_bit_depth; /**< can handle high bit depth */
+    bool                 b_sliced;         /**< renders in horizontal bands */
 };
 static struct filter_mode_t filter_mode [] = {
     { "discard", .pf_render_single_pic = RenderDiscard,
-                 { false, false, false, true }, true, true },
+                 { false, false, false, true }, true, true, false },
     { "bob", .pf_render_ordered = RenderBob,
-                 { true, false, false, false }, true, true },
+                 { true, false, false, false }, true, true, false },
     { "progressive-scan", .pf_render_ordered = RenderBob,
-                 { true, false, false, false }, true, true },
+                 { true, false, false, false }, true, true, false },
     { "linear", .pf_render_ordered = RenderLinear,
-                 { true, false, false, false }, true, true },
+                 { true, false, false, false }, true, true, false },
     { "mean", .pf_render_single_pic = RenderMean,
-                 { false, false, false, true }, true, true },
+                 { false, false, false, true }, true, true, false },
     { "blend", .pf_render_single_pic = RenderBlend,
-                 { false, false, false, false }, true, true },
+                 { false, false, false, false }, true, true, false },
     { "yadif", .pf_render_single_pic = RenderYadifSingle,
-                 { false, true, false, false }, false, true },
+                 { false, true, false, false }, false, true, true },
     { "yadif2x", .pf_render_ordered = RenderYadif,
-                 { true, true, false, false }, false, true },
+                 { true, true, false, false }, false, true, true },
     { "x", .pf_render_single_pic = RenderX,
-                 { false, false, false, false }, false, false },
+                 { false, false, false, false }, false, false, true },
     { "phosphor", .pf_render_ordered = RenderPhosphor,
-                 { true, true, false, false }, false, false },
+                 { true, true, false, false }, false, false, false },
     { "ivtc", .pf_render_single_pic = RenderIVTC,
-                 { false, true, true, false }, false, false },
+                 { false, true, true, false }, false, false, false },
 };
 
 /**
@@ -382,7 +391,7 @@ static struct filter_mode_t filter_mode [] = {
  * @param mode Desired method. See mode_list for available choices.
  * @see mode_list
  */
-static void SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
+static bool SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
@@ -397,25 +406,41 @@ static void SetFilterMethod( filter_t *p_filter, const char *mode, bool pack )
             {
                 msg_Err( p_filter, "unknown or incompatible deinterlace mode \"%s\""
                         " for packed format", mode );
-                SetFilterMethod( p_filter, "blend", pack );
-                return;
+                return SetFilterMethod( p_filter, "blend", pack );
             }
             if( p_sys->chroma->pixel_size > 1 && !filter_mode[i].b_high_bit_depth )
             {
                 msg_Err( p_filter, "unknown or incompatible deinterlace mode \"%s\""
                         " for high depth format", mode );
-                SetFilterMethod( p_filter, "blend", pack );
-                return;
+                return SetFilterMethod( p_filter, "blend", pack );
             }
 
             msg_Dbg( p_filter, "using %s deinterlace method", mode );
             p_sys->context.settings = filter_mode[i].settings;
             p_sys->context.pf_render_ordered = filter_mode[i].pf_render_ordered;
-            return;
+            return filter_mode[i].b_sliced;
         }
     }
 
     msg_Err( p_filter, "unknown deinterlace mode \"%s\"", mode );
+    return false;
+}
+
+/**
+ * Get the number of slices to render the picture with.
+ *
+ * @param p_filter The filter instance.
+ * @param i_threads Configured thread count, 0 for automatic.
+ */
+static unsigned GetSliceCount( filter_t *p_filter, int i_threads )
+{
+    if( i_threads > 0 )
+        return i_threads;
+
+    /* Synchronization is not worth it for small pictures */
+    unsigned i_slices = p_filter->fmt_in.video.i_visible_height / 256;
+    i_slices = __MIN( i_slices, vlc_GetCPUCount() );
+    return __MAX( i_slices, 1 );
 }
 
 /**
@@ -533,7 +558,11 @@ notsupp:
     config_ChainParse( p_filter, FILTER_CFG_PREFIX, ppsz_filter_options,
                        p_filter->p_cfg );
     char *psz_mode = var_InheritString( p_filter, FILTER_CFG_PREFIX "mode" );
-    SetFilterMethod( p_filter, psz_mode, packed );
+    bool b_sliced = SetFilterMethod( p_filter, psz_mode, packed );
+
+    int i_threads = var_GetInteger( p_filter, FILTER_CFG_PREFIX "threads" );
+    SlicesInit( VLC_OBJECT(p_filter), &p_sys->slices,
+                b_sliced ? GetSliceCount( p_filter, i_threads ) : 1, false );
 
     IVTCClearState( p_filter );
 
@@ -661,7 +690,9 @@ notsupp:
 void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t*)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     Flush( p_filter );
-    free( p_filter->p_sys );
+    SlicesClean( &p_sys->slices );
+    free( p_sys );
 }
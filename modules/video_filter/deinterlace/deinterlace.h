@@ -42,6 +42,7 @@ struct vlc_object_t;
 #include "algo_phosphor.h"
 #include "algo_ivtc.h"
 #include "common.h"
+#include "slices.h"
 
 /*****************************************************************************
  * Local data
@@ -77,6 +78,9 @@ typedef struct
 
     struct deinterlace_ctx   context;
 
+    /** Worker threads for the algorithms rendering in horizontal bands */
+    deinterlace_slices_t     slices;
+
     /* Algorithm-specific substructures */
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
@@ -0,0 +1,179 @@
+/*****************************************************************************
+ * slices.c : slice threading for the deinterlacer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#   include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+
+#include "slices.h"
+
+struct slice_worker
+{
+    deinterlace_slices_t *p_owner;
+    unsigned              i_slice;
+    vlc_thread_t          thread;
+};
+
+static void *SliceThread( void *data )
+{
+    struct slice_worker *p_worker = data;
+    deinterlace_slices_t *p_slices = p_worker->p_owner;
+    unsigned i_generation = 0;
+
+    vlc_mutex_lock( &p_slices->lock );
+    for( ;; )
+    {
+        while( !p_slices->b_quit && p_slices->i_generation == i_generation )
+            vlc_cond_wait( &p_slices->wait_job, &p_slices->lock );
+        if( p_slices->b_quit )
+            break;
+
+        i_generation = p_slices->i_generation;
+        slice_job_t pf_job = p_slices->pf_job;
+        void *p_opaque = p_slices->p_opaque;
+        unsigned i_slices = p_slices->i_workers + 1;
+        vlc_mutex_unlock( &p_slices->lock );
+
+        pf_job( p_opaque, p_worker->i_slice, i_slices );
+
+        vlc_mutex_lock( &p_slices->lock );
+        if( --p_slices->i_pending == 0 )
+            vlc_cond_signal( &p_slices->wait_done );
+    }
+    vlc_mutex_unlock( &p_slices->lock );
+    return NULL;
+}
+
+void SlicesInit( vlc_object_t *p_obj, deinterlace_slices_t *p_slices,
+                 unsigned i_slices, bool b_concurrent )
+{
+    vlc_mutex_init( &p_slices->lock );
+    vlc_cond_init( &p_slices->wait_job );
+    vlc_cond_init( &p_slices->wait_done );
+    p_slices->pf_job = NULL;
+    p_slices->p_opaque = NULL;
+    p_slices->i_generation = 0;
+    p_slices->i_pending = 0;
+    p_slices->b_quit = false;
+    p_slices->i_workers = 0;
+    p_slices->p_workers = NULL;
+    p_slices->p_executor = NULL;
+    p_slices->i_slices = 1;
+
+    if( i_slices <= 1 )
+        return;
+
+    if( !b_concurrent )
+    {
+        p_slices->p_executor = vlc_executor_Get( p_obj );
+        p_slices->i_slices = i_slices;
+        msg_Dbg( p_obj, "rendering with %u slices in the shared executor",
+                 i_slices );
+        return;
+    }
+
+    p_slices->p_workers = malloc( (i_slices - 1)
+                                  * sizeof( *p_slices->p_workers ) );
+    if( unlikely(p_slices->p_workers == NULL) )
+        return;
+
+    for( unsigned i = 0; i < i_slices - 1; i++ )
+    {
+        struct slice_worker *p_worker = &p_slices->p_workers[i];
+
+        p_worker->p_owner = p_slices;
+        p_worker->i_slice = i + 1;
+        if( vlc_clone( &p_worker->thread, SliceThread, p_worker,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+        {
+            msg_Warn( p_obj, "cannot start slice thread %u", i + 1 );
+            break;
+        }
+        p_slices->i_workers++;
+    }
+    msg_Dbg( p_obj, "rendering with %u slices", p_slices->i_workers + 1 );
+}
+
+void SlicesClean( deinterlace_slices_t *p_slices )
+{
+    vlc_mutex_lock( &p_slices->lock );
+    p_slices->b_quit = true;
+    vlc_cond_broadcast( &p_slices->wait_job );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    for( unsigned i = 0; i < p_slices->i_workers; i++ )
+        vlc_join( p_slices->p_workers[i].thread, NULL );
+    free( p_slices->p_workers );
+}
+
+struct slice_run
+{
+    slice_job_t pf_job;
+    void       *p_opaque;
+    unsigned    i_slices;
+};
+
+static void SliceRun( void *p_opaque, size_t i_slice )
+{
+    const struct slice_run *p_run = p_opaque;
+
+    p_run->pf_job( p_run->p_opaque, i_slice, p_run->i_slices );
+}
+
+void SlicesRun( deinterlace_slices_t *p_slices, slice_job_t pf_job,
+                void *p_opaque )
+{
+    if( p_slices->p_executor != NULL )
+    {
+        struct slice_run run = {
+            .pf_job = pf_job,
+            .p_opaque = p_opaque,
+            .i_slices = p_slices->i_slices,
+        };
+        vlc_executor_ParallelFor( p_slices->p_executor, run.i_slices,
+                                  SliceRun, &run );
+        return;
+    }
+
+    if( p_slices->i_workers == 0 )
+    {
+        pf_job( p_opaque, 0, 1 );
+        return;
+    }
+
+    vlc_mutex_lock( &p_slices->lock );
+    p_slices->pf_job = pf_job;
+    p_slices->p_opaque = p_opaque;
+    p_slices->i_pending = p_slices->i_workers;
+    p_slices->i_generation++;
+    vlc_cond_broadcast( &p_slices->wait_job );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    pf_job( p_opaque, 0, p_slices->i_workers + 1 );
+
+    vlc_mutex_lock( &p_slices->lock );
+    while( p_slices->i_pending > 0 )
+        vlc_cond_wait( &p_slices->wait_done, &p_slices->lock );
+    vlc_mutex_unlock( &p_slices->lock );
+}
@@ -0,0 +1,100 @@
+/*****************************************************************************
+ * slices.h : slice threading for the deinterlacer
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_DEINTERLACE_SLICES_H
+#define VLC_DEINTERLACE_SLICES_H 1
+
+#include <vlc_common.h>
+#include <vlc_threads.h>
+#include <vlc_executor.h>
+
+/**
+ * \file
+ * Split a picture into horizontal bands rendered in parallel.
+ *
+ * Independent slices are rendered by the executor shared by all modules.
+ * Slices that wait for each other must all run at the same time: they get a
+ * fixed set of worker threads. The calling thread always renders slice 0
+ * itself, and SlicesRun() returns once all slices are done.
+ */
+
+/**
+ * Renders one slice out of i_slices.
+ *
+ * It is up to the job to map the slice index to a range of lines, typically
+ * with SliceRange().
+ */
+typedef void (*slice_job_t)( void *p_opaque, unsigned i_slice,
+                             unsigned i_slices );
+
+struct slice_worker;
+
+typedef struct
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_job;  /**< workers wait for a job here */
+    vlc_cond_t  wait_done; /**< SlicesRun() waits for the workers here */
+
+    slice_job_t pf_job;
+    void       *p_opaque;
+    unsigned    i_generation; /**< incremented for each new job */
+    unsigned    i_pending;    /**< workers still running the current job */
+    bool        b_quit;
+
+    unsigned             i_workers;
+    struct slice_worker *p_workers;
+
+    vlc_executor_t *p_executor; /**< shared executor, or NULL */
+    unsigned        i_slices;   /**< slice count with the executor */
+} deinterlace_slices_t;
+
+/**
+ * Prepares the rendering in i_slices slices.
+ *
+ * If b_concurrent is false, the slices are rendered by the shared executor.
+ * Otherwise, up to i_slices - 1 worker threads are started. If some threads
+ * cannot be started, the work is split in fewer slices.
+ * With i_slices <= 1, SlicesRun() calls the job directly.
+ *
+ * \param b_concurrent whether the slices wait for each other
+ */
+void SlicesInit( vlc_object_t *p_obj, deinterlace_slices_t *p_slices,
+                 unsigned i_slices, bool b_concurrent );
+
+/** Stops and joins the worker threads. */
+void SlicesClean( deinterlace_slices_t *p_slices );
+
+/** Runs the job over all slices and waits for its completion. */
+void SlicesRun( deinterlace_slices_t *p_slices, slice_job_t pf_job,
+                void *p_opaque );
+
+/**
+ * Splits i_count items (lines, blocks...) evenly and returns the range of
+ * the given slice as [*pi_start, *pi_end).
+ */
+static inline void SliceRange( unsigned i_count, unsigned i_slice,
+                               unsigned i_slices,
+                               unsigned *pi_start, unsigned *pi_end )
+{
+    *pi_start = (uint64_t)i_count * i_slice / i_slices;
+    *pi_end   = (uint64_t)i_count * (i_slice + 1) / i_slices;
+}
+
+#endif
@@ -93,6 +93,101 @@ static void yadif_filter_line_c_16bit(uint8_t *dst8, uint8_t *prev8, uint8_t *cu
     FILTER
 }
 
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define YADIF_NEON 1
+
+static inline int16x8_t yadif_load_neon(const uint8_t *p) {
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+/* Vector form of CHECK(j): lanes are only updated where valid is set,
+ * and the lanes that were updated are returned for the nested check. */
+static inline uint16x8_t yadif_check_neon(const uint8_t *cur, int prefs, int mrefs, int j,
+                                          uint16x8_t valid,
+                                          int16x8_t *spatial_score, int16x8_t *spatial_pred) {
+    int16x8_t score = vaddq_s16(vaddq_s16(
+        vabdq_s16(yadif_load_neon(&cur[mrefs-1+j]), yadif_load_neon(&cur[prefs-1-j])),
+        vabdq_s16(yadif_load_neon(&cur[mrefs  +j]), yadif_load_neon(&cur[prefs  -j]))),
+        vabdq_s16(yadif_load_neon(&cur[mrefs+1+j]), yadif_load_neon(&cur[prefs+1-j])));
+    int16x8_t pred = vshrq_n_s16(vaddq_s16(yadif_load_neon(&cur[mrefs+j]),
+                                           yadif_load_neon(&cur[prefs-j])), 1);
+    uint16x8_t better = vandq_u16(valid, vcltq_s16(score, *spatial_score));
+
+    *spatial_score = vbslq_s16(better, score, *spatial_score);
+    *spatial_pred = vbslq_s16(better, pred, *spatial_pred);
+    return better;
+}
+
+/* Same as yadif_filter_line_c(), 8 pixels at a time with 16-bit lanes. */
+static void yadif_filter_line_neon(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode) {
+    uint8_t *prev2= parity ? prev : cur ;
+    uint8_t *next2= parity ? cur  : next;
+    const uint16x8_t all = vdupq_n_u16(0xffff);
+    int x;
+
+    for (x = 0; x + 8 <= w; x += 8) {
+        int16x8_t c = yadif_load_neon(&cur[mrefs]);
+        int16x8_t e = yadif_load_neon(&cur[prefs]);
+        int16x8_t p2 = yadif_load_neon(prev2);
+        int16x8_t n2 = yadif_load_neon(next2);
+        int16x8_t d = vshrq_n_s16(vaddq_s16(p2, n2), 1);
+        int16x8_t temporal_diff0 = vabdq_s16(p2, n2);
+        int16x8_t temporal_diff1 = vshrq_n_s16(vaddq_s16(
+            vabdq_s16(yadif_load_neon(&prev[mrefs]), c),
+            vabdq_s16(yadif_load_neon(&prev[prefs]), e)), 1);
+        int16x8_t temporal_diff2 = vshrq_n_s16(vaddq_s16(
+            vabdq_s16(yadif_load_neon(&next[mrefs]), c),
+            vabdq_s16(yadif_load_neon(&next[prefs]), e)), 1);
+        int16x8_t diff = vmaxq_s16(vmaxq_s16(vshrq_n_s16(temporal_diff0, 1),
+                                             temporal_diff1), temporal_diff2);
+        int16x8_t spatial_pred = vshrq_n_s16(vaddq_s16(c, e), 1);
+        int16x8_t spatial_score = vsubq_s16(vaddq_s16(vaddq_s16(
+            vabdq_s16(yadif_load_neon(&cur[mrefs-1]), yadif_load_neon(&cur[prefs-1])),
+            vabdq_s16(c, e)),
+            vabdq_s16(yadif_load_neon(&cur[mrefs+1]), yadif_load_neon(&cur[prefs+1]))),
+            vdupq_n_s16(1));
+
+        yadif_check_neon(cur, prefs, mrefs, -2,
+                         yadif_check_neon(cur, prefs, mrefs, -1, all,
+                                          &spatial_score, &spatial_pred),
+                         &spatial_score, &spatial_pred);
+        yadif_check_neon(cur, prefs, mrefs, 2,
+                         yadif_check_neon(cur, prefs, mrefs, 1, all,
+                                          &spatial_score, &spatial_pred),
+                         &spatial_score, &spatial_pred);
+
+        if (mode < 2) {
+            int16x8_t b = vshrq_n_s16(vaddq_s16(yadif_load_neon(&prev2[2*mrefs]),
+                                                yadif_load_neon(&next2[2*mrefs])), 1);
+            int16x8_t f = vshrq_n_s16(vaddq_s16(yadif_load_neon(&prev2[2*prefs]),
+                                                yadif_load_neon(&next2[2*prefs])), 1);
+            int16x8_t de = vsubq_s16(d, e), dc = vsubq_s16(d, c);
+            int16x8_t bc = vsubq_s16(b, c), fe = vsubq_s16(f, e);
+            int16x8_t max = vmaxq_s16(vmaxq_s16(de, dc), vminq_s16(bc, fe));
+            int16x8_t min = vminq_s16(vminq_s16(de, dc), vmaxq_s16(bc, fe));
+
+            diff = vmaxq_s16(vmaxq_s16(diff, min), vnegq_s16(max));
+        }
+
+        /* diff is never negative, so this is the same as the C clipping */
+        spatial_pred = vminq_s16(vmaxq_s16(spatial_pred, vsubq_s16(d, diff)),
+                                 vaddq_s16(d, diff));
+        vst1_u8(dst, vqmovun_s16(spatial_pred));
+
+        dst += 8;
+        cur += 8;
+        prev += 8;
+        next += 8;
+        prev2 += 8;
+        next2 += 8;
+    }
+
+    if (x < w)
+        yadif_filter_line_c(dst, prev, cur, next, w - x, prefs, mrefs, parity, mode);
+}
+#endif
+
 #if defined(__i386__) || defined(__x86_64__)
 void vlcpriv_yadif_filter_line_ssse3(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode);
 void vlcpriv_yadif_filter_line_sse2(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next, int w, int prefs, int mrefs, int parity, int mode);
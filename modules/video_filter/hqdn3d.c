@@ -36,6 +36,7 @@
 
 
 #include "hqdn3d.h"
+#include "deinterlace/slices.h"
 
 /*****************************************************************************
  * Local protypes
@@ -57,6 +58,9 @@ static int DenoiseCallback( vlc_object_t *p_this, char const *psz_var,
 #define CHROMA_SPAT_TEXT        N_("Spatial chroma strength (0-254)")
 #define LUMA_TEMP_TEXT          N_("Temporal luma strength (0-254)")
 #define CHROMA_TEMP_TEXT        N_("Temporal chroma strength (0-254)")
+#define THREADS_TEXT            N_("Threads")
+#define THREADS_LONGTEXT        N_("Number of threads denoising each plane " \
+    "(0: automatic). The output does not depend on this setting.")
 
 vlc_module_begin()
     set_shortname(N_("HQ Denoiser 3D"))
@@ -73,6 +77,8 @@ vlc_module_begin()
             LUMA_TEMP_TEXT, LUMA_TEMP_TEXT, false)
     add_float_with_range(FILTER_PREFIX "chroma-temp", 4.5, 0.0, 254.0,
             CHROMA_TEMP_TEXT, CHROMA_TEMP_TEXT, false)
+    add_integer_with_range(FILTER_PREFIX "threads", 0, 0, 16,
+            THREADS_TEXT, THREADS_LONGTEXT, true)
 
     add_shortcut("hqdn3d")
 
@@ -80,9 +86,15 @@ vlc_module_begin()
 vlc_module_end()
 
 static const char *const filter_options[] = {
-    "luma-spat", "chroma-spat", "luma-temp", "chroma-temp", NULL
+    "luma-spat", "chroma-spat", "luma-temp", "chroma-temp", "threads", NULL
 };
 
+/* Width of the line segments a thread hands over to the next one */
+#define SEGMENT_WIDTH 64
+
+/* Set in the progress of a line while a thread is sleeping on it */
+#define PROGRESS_WAITING 0x80000000u
+
 /*****************************************************************************
  * filter_sys_t
  *****************************************************************************/
@@ -92,11 +104,150 @@ typedef struct
     int w[3], h[3];
 
     struct vf_priv_s cfg;
+    deinterlace_slices_t slices;
+    atomic_uint *progress; /**< number of pixels done per line */
+    vlc_mutex_t lock;      /**< protects sleeping on the progress */
+    vlc_cond_t wait;
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
 } filter_sys_t;
 
+/*****************************************************************************
+ * Slices
+ *****************************************************************************/
+typedef struct
+{
+    filter_sys_t *sys;
+    unsigned char *src, *dst;
+    int src_pitch, dst_pitch;
+    int w, h;
+    unsigned short *prev; /**< previous frame, NULL if spatial only */
+    unsigned int *line;
+    atomic_uint *progress;
+    int *horizontal, *vertical, *temporal;
+} denoise_job_t;
+
+static void WaitLine(filter_sys_t *sys, atomic_uint *progress, unsigned x)
+{
+    unsigned val = atomic_load_explicit(progress, memory_order_acquire);
+
+    for (unsigned spin = 0; val < x && spin < 256; spin++)
+        val = atomic_load_explicit(progress, memory_order_acquire);
+    if ((val & ~PROGRESS_WAITING) >= x)
+        return;
+
+    vlc_mutex_lock(&sys->lock);
+    for (;;)
+    {
+        if (!(val & PROGRESS_WAITING)
+         && !atomic_compare_exchange_strong_explicit(progress, &val,
+                                            val | PROGRESS_WAITING,
+                                            memory_order_acquire,
+                                            memory_order_acquire))
+            continue;
+        if ((val & ~PROGRESS_WAITING) >= x)
+            break;
+        vlc_cond_wait(&sys->wait, &sys->lock);
+        val = atomic_load_explicit(progress, memory_order_acquire);
+    }
+    vlc_mutex_unlock(&sys->lock);
+}
+
+static void PostLine(filter_sys_t *sys, atomic_uint *progress, unsigned x)
+{
+    if (atomic_exchange_explicit(progress, x, memory_order_acq_rel)
+         & PROGRESS_WAITING)
+    {
+        vlc_mutex_lock(&sys->lock);
+        vlc_cond_broadcast(&sys->wait);
+        vlc_mutex_unlock(&sys->lock);
+    }
+}
+
+static void DenoiseSlice(void *opaque, unsigned slice, unsigned slices)
+{
+    const denoise_job_t *job = opaque;
+
+    if (!job->horizontal[0] && !job->vertical[0])
+    {
+        /* Temporal only: the lines are independent */
+        unsigned start, end;
+        SliceRange(job->h, slice, slices, &start, &end);
+        deNoiseTemporal(job->src + start * job->src_pitch,
+                        job->dst + start * job->dst_pitch,
+                        job->prev + start * job->w,
+                        job->w, end - start, job->src_pitch, job->dst_pitch,
+                        job->temporal);
+        return;
+    }
+
+    /* The lines are interleaved between the slices. Each segment of a line
+     * depends on the same segment of the previous line, which is processed by
+     * another slice: the slices run as a wavefront, and the result is the
+     * same as with a single thread. */
+    for (unsigned y = slice; y < (unsigned)job->h; y += slices)
+    {
+        unsigned char *src = job->src + y * job->src_pitch;
+        unsigned char *dst = job->dst + y * job->dst_pitch;
+        unsigned int pixel_ant = 0;
+
+        for (unsigned x0 = 0; x0 < (unsigned)job->w; x0 += SEGMENT_WIDTH)
+        {
+            const unsigned x1 = __MIN(x0 + SEGMENT_WIDTH, (unsigned)job->w);
+
+            if (slices > 1 && y > 0)
+                WaitLine(job->sys, &job->progress[y - 1], x1);
+
+            if (job->prev != NULL)
+                deNoiseSegment(src, dst, job->line, job->prev + y * job->w,
+                               &pixel_ant, y, x0, x1,
+                               job->horizontal, job->vertical, job->temporal);
+            else
+                deNoiseSpacialSegment(src, dst, job->line, &pixel_ant,
+                                      y, x0, x1,
+                                      job->horizontal, job->vertical);
+
+            if (slices > 1)
+                PostLine(job->sys, &job->progress[y], x1);
+        }
+    }
+}
+
+static void DenoisePlane(filter_sys_t *sys, const plane_t *src,
+                         const plane_t *dst, unsigned plane,
+                         int *horizontal, int *vertical, int *temporal)
+{
+    struct vf_priv_s *cfg = &sys->cfg;
+    const int w = sys->w[plane], h = sys->h[plane];
+
+    if (!deNoiseInit(src->p_pixels, &cfg->Frame[plane], w, h, src->i_pitch))
+        return;
+
+    denoise_job_t job = {
+        .sys = sys,
+        .src = src->p_pixels,
+        .dst = dst->p_pixels,
+        .src_pitch = src->i_pitch,
+        .dst_pitch = dst->i_pitch,
+        .w = w,
+        .h = h,
+        .prev = cfg->Frame[plane],
+        .line = cfg->Line,
+        .progress = sys->progress,
+        .horizontal = horizontal,
+        .vertical = vertical,
+        .temporal = temporal,
+    };
+    if ((horizontal[0] || vertical[0]) && !temporal[0])
+        job.prev = NULL;
+
+    for (int y = 0; y < h; y++)
+        atomic_store_explicit(&sys->progress[y], 0, memory_order_relaxed);
+
+    SlicesRun(&sys->slices, DenoiseSlice, &job);
+}
+
 /*****************************************************************************
  * Open
  *****************************************************************************/
@@ -109,7 +260,7 @@ static int Open(vlc_object_t *this)
     const video_format_t *fmt_out = &filter->fmt_out.video;
     const vlc_fourcc_t fourcc_in  = fmt_in->i_chroma;
     const vlc_fourcc_t fourcc_out = fmt_out->i_chroma;
-    int wmax = 0;
+    int wmax = 0, hmax = 0;
 
     const vlc_chroma_description_t *chroma =
             vlc_fourcc_GetChromaDescription(fourcc_in);
@@ -136,9 +287,13 @@ static int Open(vlc_object_t *this)
         sys->w[i] = fmt_in->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        if (sys->h[i] > hmax) hmax = sys->h[i];
     }
     cfg->Line = malloc(wmax*sizeof(unsigned int));
-    if (!cfg->Line) {
+    sys->progress = vlc_alloc(hmax, sizeof(*sys->progress));
+    if (!cfg->Line || !sys->progress) {
+        free(sys->progress);
+        free(cfg->Line);
         free(sys);
         return VLC_ENOMEM;
     }
@@ -146,6 +301,14 @@ static int Open(vlc_object_t *this)
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
                       filter->p_cfg);
 
+    /* Each thread needs a few segments of lead over the next one */
+    int threads = var_CreateGetInteger(filter, FILTER_PREFIX "threads");
+    if (threads <= 0)
+        threads = __MIN((int)vlc_GetCPUCount(), wmax / (4 * SEGMENT_WIDTH));
+    vlc_mutex_init(&sys->lock);
+    vlc_cond_init(&sys->wait);
+    SlicesInit(VLC_OBJECT(filter), &sys->slices, __MAX(threads, 1), true);
+
 
     vlc_mutex_init( &sys->coefs_mutex );
     sys->b_recalc_coefs = true;
@@ -179,10 +342,13 @@ static void Close(vlc_object_t *this)
     var_DelCallback( filter, FILTER_PREFIX "luma-temp", DenoiseCallback, sys );
     var_DelCallback( filter, FILTER_PREFIX "chroma-temp", DenoiseCallback, sys );
 
+    SlicesClean(&sys->slices);
+
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
     }
     free(cfg->Line);
+    free(sys->progress);
     free(sys);
 }
 
@@ -218,24 +384,18 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    DenoisePlane(sys, &src->p[0], &dst->p[0], 0,
+                 cfg->Coefs[0],
+                 cfg->Coefs[0],
+                 cfg->Coefs[1]);
+    DenoisePlane(sys, &src->p[1], &dst->p[1], 1,
+                 cfg->Coefs[2],
+                 cfg->Coefs[2],
+                 cfg->Coefs[3]);
+    DenoisePlane(sys, &src->p[2], &dst->p[2], 2,
+                 cfg->Coefs[2],
+                 cfg->Coefs[2],
+                 cfg->Coefs[3]);
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
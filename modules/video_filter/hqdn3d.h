@@ -67,111 +67,127 @@ static void deNoiseTemporal(
     }
 }
 
-static void deNoiseSpacial(
-                    unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
+/* Spatial denoising of the pixels [X0, X1) of a line.
+ *
+ * Each pixel depends on its left neighbor (PixelAnt, carried from one
+ * segment of the line to the next) and on the pixel above it (LineAnt, which
+ * holds the previous line of the plane). A segment can thus be processed as
+ * soon as the same segment of the previous line is done. */
+static void deNoiseSpacialSegment(
+                    unsigned char *Frame,        // line of mpi->planes[x]
+                    unsigned char *FrameDest,    // line of dmpi->planes[x]
                     unsigned int *LineAnt,       // vf->priv->Line (width bytes)
-                    int W, int H, int sStride, int dStride,
+                    unsigned int *PixelAntPtr,
+                    long Y, long X0, long X1,
                     int *Horizontal, int *Vertical)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
+    unsigned int PixelAnt = *PixelAntPtr;
     unsigned int PixelDst;
 
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor, only left. */
-    for (long X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
+    if (Y == 0){
+        if (X0 == 0){
+            /* First pixel has no left nor top neighbor. */
+            PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
+            FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+            X0 = 1;
+        }
 
-    for (long Y = 1; Y < H; Y++){
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
+        /* First line has no top neighbor, only left. */
+        for (long X = X0; X < X1; X++){
+            PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+        }
+    } else {
+        if (X0 == 0){
+            /* First pixel on each line doesn't have previous pixel */
+            PixelAnt = Frame[0]<<16;
+            PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
+            FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+            X0 = 1;
+        }
 
-        for (long X = 1; X < W; X++){
+        for (long X = X0; X < X1; X++){
             /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
+            PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
             PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
         }
     }
+    *PixelAntPtr = PixelAnt;
 }
 
-static void deNoise(unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
-                    int W, int H, int sStride, int dStride,
+/* Spatial and temporal denoising of the pixels [X0, X1) of a line, with the
+ * same dependencies as deNoiseSpacialSegment(). */
+static void deNoiseSegment(
+                    unsigned char *Frame,        // line of mpi->planes[x]
+                    unsigned char *FrameDest,    // line of dmpi->planes[x]
+                    unsigned int *LineAnt,       // vf->priv->Line (width bytes)
+                    unsigned short *LinePrev,    // line of the previous frame
+                    unsigned int *PixelAntPtr,
+                    long Y, long X0, long X1,
                     int *Horizontal, int *Vertical, int *Temporal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
+    unsigned int PixelAnt = *PixelAntPtr;
     unsigned int PixelDst;
+
+    if (Y == 0){
+        if (X0 == 0){
+            /* First pixel has no left nor top neighbor. Only previous frame */
+            LineAnt[0] = PixelAnt = Frame[0]<<16;
+            PixelDst = LowPassMul(LinePrev[0]<<8, PixelAnt, Temporal);
+            LinePrev[0] = ((PixelDst+0x1000007F)>>8);
+            FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+            X0 = 1;
+        }
+
+        /* First line has no top neighbor. Only left one for each pixel and
+         * last frame */
+        for (long X = X0; X < X1; X++){
+            LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
+            PixelDst = LowPassMul(LinePrev[X]<<8, PixelAnt, Temporal);
+            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+        }
+    } else {
+        if (X0 == 0){
+            /* First pixel on each line doesn't have previous pixel */
+            PixelAnt = Frame[0]<<16;
+            LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
+            PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
+            LinePrev[0] = ((PixelDst+0x1000007F)>>8);
+            FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+            X0 = 1;
+        }
+
+        for (long X = X0; X < X1; X++){
+            /* The rest are normal */
+            PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
+            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
+            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
+            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+        }
+    }
+    *PixelAntPtr = PixelAnt;
+}
+
+/* Allocates and initializes the previous frame from the first one. */
+static bool deNoiseInit(unsigned char *Frame, unsigned short **FrameAntPtr,
+                        int W, int H, int sStride)
+{
     unsigned short* FrameAnt=(*FrameAntPtr);
 
     if(!FrameAnt){
         (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
         if(!FrameAnt)
-            return;
+            return false;
         for (long Y = 0; Y < H; Y++){
             unsigned short* dst=&FrameAnt[Y*W];
             unsigned char* src=Frame+Y*sStride;
             for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
         }
     }
-
-    if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
-    }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
-        return;
-    }
-
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (long X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (long Y = 1; Y < H; Y++){
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
-        }
-    }
+    return true;
 }
 
 
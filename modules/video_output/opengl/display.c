@@ -143,6 +143,8 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
 
     vd->sys = sys;
     vd->info.subpicture_chromas = spu_chromas;
+    /* subpictures are scaled by the GPU */
+    vd->info.can_scale_spu = true;
     vd->prepare = PictureRender;
     vd->display = PictureDisplay;
     vd->control = Control;
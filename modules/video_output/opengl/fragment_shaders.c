@@ -379,7 +379,23 @@ opengl_init_swizzle(const struct vlc_gl_interop *interop,
     else
         oneplane_texfmt = GL_LUMINANCE;
 
-    if (desc->plane_count == 3)
+    if (interop->texs_split16)
+    {
+        /* Each component is given by a pair of texel components, the low
+         * byte first */
+#ifdef WORDS_BIGENDIAN
+        const char *swizzle = oneplane_texfmt == GL_RED ? "gr" : "ax";
+        const char *swizzle_uv = "grab";
+#else
+        const char *swizzle = oneplane_texfmt == GL_RED ? "rg" : "xa";
+        const char *swizzle_uv = "rgba";
+#endif
+        assert(desc->plane_count == 3 || desc->plane_count == 2);
+        swizzle_per_tex[0] = swizzle_per_tex[1] = swizzle_per_tex[2] = swizzle;
+        if (desc->plane_count == 2)
+            swizzle_per_tex[1] = swizzle_uv;
+    }
+    else if (desc->plane_count == 3)
         swizzle_per_tex[0] = swizzle_per_tex[1] = swizzle_per_tex[2] = "r";
     else if (desc->plane_count == 2)
     {
@@ -599,6 +615,19 @@ opengl_fragment_shader_init(struct vlc_gl_renderer *renderer, GLenum tex_target,
                      "                   tex_coords.y * TexSize%u.y);\n", i, i);
             }
             ADDF(" texel = %s(Texture%u, tex_coords);\n", lookup, i);
+            if (interop->texs_split16)
+            {
+                /* Recombine the bytes into a normalized 16-bit value */
+                for (unsigned j = 0; j + 1 < swizzle_count; j += 2)
+                {
+                    ADDF(" pixel[%u] = (texel.%c + texel.%c * 256.0)"
+                         " * (255.0 / 65535.0);\n",
+                         color_idx, swizzle[j], swizzle[j + 1]);
+                    color_idx++;
+                    assert(color_idx <= PICTURE_PLANE_MAX);
+                }
+                continue;
+            }
             for (unsigned j = 0; j < swizzle_count; ++j)
             {
                 ADDF(" pixel[%u] = texel.%c;\n", color_idx, swizzle[j]);
@@ -219,12 +219,23 @@ interop_yuv_base_init(struct vlc_gl_interop *interop, GLenum tex_target,
         twoplanes16_texfmt = 0;
     }
 
+    /* Without 16-bit textures (notably on OpenGL ES), upload the two bytes of
+     * each sample in two 8-bit components rather than converting the picture
+     * to 8 bits on the CPU. Linear filtering stays exact, since it is
+     * applied to both bytes with the same weights. */
+    bool split16 = false;
     if (desc->pixel_size == 2)
     {
         if (GetTexFormatSize(interop->vt, tex_target, oneplane_texfmt,
                              oneplane16_texfmt, GL_UNSIGNED_SHORT) != 16)
-            return VLC_EGENERIC;
+            split16 = true;
+        else if (desc->plane_count == 2
+              && (twoplanes16_texfmt == 0
+               || GetTexFormatSize(interop->vt, tex_target, twoplanes_texfmt,
+                                   twoplanes16_texfmt, GL_UNSIGNED_SHORT) != 16))
+            split16 = true;
     }
+    interop->texs_split16 = split16;
 
     if (desc->plane_count == 3)
     {
@@ -236,6 +247,11 @@ interop_yuv_base_init(struct vlc_gl_interop *interop, GLenum tex_target,
             internal = oneplane_texfmt;
             type = GL_UNSIGNED_BYTE;
         }
+        else if (desc->pixel_size == 2 && split16)
+        {
+            internal = twoplanes_texfmt;
+            type = GL_UNSIGNED_BYTE;
+        }
         else if (desc->pixel_size == 2)
         {
             internal = oneplane16_texfmt;
@@ -246,13 +262,14 @@ interop_yuv_base_init(struct vlc_gl_interop *interop, GLenum tex_target,
 
         assert(internal != 0 && type != 0);
 
+        const GLenum format = split16 ? twoplanes_texfmt : oneplane_texfmt;
         interop->tex_count = 3;
         for (unsigned i = 0; i < interop->tex_count; ++i )
         {
             interop->texs[i] = (struct vlc_gl_tex_cfg) {
                 { desc->p[i].w.num, desc->p[i].w.den },
                 { desc->p[i].h.num, desc->p[i].h.den },
-                internal, oneplane_texfmt, type
+                internal, format, type
             };
         }
     }
@@ -271,12 +288,18 @@ interop_yuv_base_init(struct vlc_gl_interop *interop, GLenum tex_target,
                 GL_UNSIGNED_BYTE
             };
         }
+        else if (desc->pixel_size == 2 && split16)
+        {
+            interop->texs[0] = (struct vlc_gl_tex_cfg) {
+                { 1, 1 }, { 1, 1 }, twoplanes_texfmt, twoplanes_texfmt,
+                GL_UNSIGNED_BYTE
+            };
+            interop->texs[1] = (struct vlc_gl_tex_cfg) {
+                { 1, 2 }, { 1, 2 }, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE
+            };
+        }
         else if (desc->pixel_size == 2)
         {
-            if (twoplanes16_texfmt == 0
-             || GetTexFormatSize(interop->vt, tex_target, twoplanes_texfmt,
-                                 twoplanes16_texfmt, GL_UNSIGNED_SHORT) != 16)
-                return VLC_EGENERIC;
             interop->texs[0] = (struct vlc_gl_tex_cfg) {
                 { 1, 1 }, { 1, 1 }, oneplane16_texfmt, oneplane_texfmt,
                 GL_UNSIGNED_SHORT
@@ -358,6 +381,7 @@ opengl_interop_init_impl(struct vlc_gl_interop *interop, GLenum tex_target,
     interop->sw_fmt.i_chroma = chroma;
     interop->sw_fmt.space = yuv_space;
     interop->tex_target = tex_target;
+    interop->texs_split16 = false;
 
     if (chroma == VLC_CODEC_XYZ12)
     {
@@ -125,6 +125,11 @@ struct vlc_gl_interop {
     /* Set to true if textures are generated from pf_update() */
     bool handle_texs_gen;
 
+    /* Set to true if 16-bit samples are uploaded as two 8-bit components,
+     * for implementations lacking 16-bit normalized textures. The fragment
+     * shader recombines them. */
+    bool texs_split16;
+
     /* Initialized by the interop */
     struct vlc_gl_tex_cfg {
         /*
@@ -31,6 +31,8 @@
 #include "internal.h"
 
 #define PBO_DISPLAY_COUNT 2 /* Double buffering */
+#define PERSISTENT_RING_COUNT 3 /* Triple buffering */
+#define PERSISTENT_FENCE_TIMEOUT UINT64_C(1000000000) /* 1s, in ns */
 typedef struct
 {
     PFNGLDELETEBUFFERSPROC DeleteBuffers;
@@ -47,6 +49,15 @@ struct priv
         picture_t *display_pics[PBO_DISPLAY_COUNT];
         size_t display_idx;
     } pbo;
+    struct {
+        GLuint buffer;
+        uint8_t *map;
+        size_t slot_size;
+        size_t offsets[PICTURE_PLANE_MAX];
+        size_t bytes[PICTURE_PLANE_MAX];
+        GLsync fences[PERSISTENT_RING_COUNT];
+        size_t idx;
+    } persistent;
 };
 
 static void
@@ -190,6 +201,82 @@ tc_pbo_update(const struct vlc_gl_interop *interop, GLuint *textures,
     return VLC_SUCCESS;
 }
 
+static int
+persistent_alloc(const struct vlc_gl_interop *interop)
+{
+    struct priv *priv = interop->priv;
+    picture_t layout;
+
+    memset(&layout, 0, sizeof(layout));
+    if (picture_Setup(&layout, &interop->fmt))
+        return VLC_EGENERIC;
+
+    /* All the planes of a picture are stored in one slot of the ring, each
+     * one aligned like the planes allocated by the core */
+    size_t slot_size = 0;
+    for (int i = 0; i < layout.i_planes; ++i)
+    {
+        const plane_t *p = &layout.p[i];
+
+        if( p->i_pitch <= 0 || p->i_lines <= 0 ||
+            (size_t)p->i_pitch > SIZE_MAX/p->i_lines )
+            return VLC_EGENERIC;
+        priv->persistent.offsets[i] = slot_size;
+        priv->persistent.bytes[i] = p->i_pitch * p->i_lines;
+        slot_size = vlc_align(slot_size + priv->persistent.bytes[i], 64);
+    }
+    if (slot_size > SIZE_MAX / PERSISTENT_RING_COUNT
+     || slot_size * PERSISTENT_RING_COUNT > PTRDIFF_MAX)
+        return VLC_EGENERIC;
+
+    const GLsizeiptr size = slot_size * PERSISTENT_RING_COUNT;
+    const GLbitfield flags =
+        GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    interop->vt->GetError();
+
+    interop->vt->GenBuffers(1, &priv->persistent.buffer);
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->persistent.buffer);
+    interop->vt->BufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL, flags);
+    priv->persistent.map =
+        interop->vt->MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags);
+
+    if (priv->persistent.map == NULL
+     || interop->vt->GetError() != GL_NO_ERROR)
+    {
+        msg_Err(interop->gl, "could not map persistent buffer");
+        interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        interop->vt->DeleteBuffers(1, &priv->persistent.buffer);
+        priv->persistent.buffer = 0;
+        priv->persistent.map = NULL;
+        return VLC_EGENERIC;
+    }
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    priv->persistent.slot_size = slot_size;
+    return VLC_SUCCESS;
+}
+
+static void
+persistent_release(const struct vlc_gl_interop *interop)
+{
+    struct priv *priv = interop->priv;
+
+    if (priv->persistent.buffer == 0)
+        return;
+
+    for (size_t i = 0; i < PERSISTENT_RING_COUNT; ++i)
+        if (priv->persistent.fences[i] != NULL)
+            interop->vt->DeleteSync(priv->persistent.fences[i]);
+
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->persistent.buffer);
+    interop->vt->UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    interop->vt->DeleteBuffers(1, &priv->persistent.buffer);
+}
+
 static int
 tc_common_allocate_textures(const struct vlc_gl_interop *interop, GLuint *textures,
                             const GLsizei *tex_width, const GLsizei *tex_height)
@@ -283,12 +370,81 @@ tc_common_update(const struct vlc_gl_interop *interop, GLuint *textures,
     return ret;
 }
 
+static int
+tc_persistent_update(const struct vlc_gl_interop *interop, GLuint *textures,
+                     const GLsizei *tex_width, const GLsizei *tex_height,
+                     picture_t *pic, const size_t *plane_offset)
+{
+    (void) plane_offset; assert(plane_offset == NULL);
+    struct priv *priv = interop->priv;
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        /* Pictures not matching the ring layout go through the plain path */
+        if ((size_t)pic->p[i].i_lines * pic->p[i].i_pitch
+                > priv->persistent.bytes[i])
+            return tc_common_update(interop, textures, tex_width, tex_height,
+                                    pic, NULL);
+    }
+
+    const size_t idx = priv->persistent.idx;
+    priv->persistent.idx = (idx + 1) % PERSISTENT_RING_COUNT;
+
+    /* The slot was last used PERSISTENT_RING_COUNT frames ago: this only
+     * blocks if the GPU is that far behind */
+    GLsync fence = priv->persistent.fences[idx];
+    if (fence != NULL)
+    {
+        GLenum ret = interop->vt->ClientWaitSync(fence,
+                                                 GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                 PERSISTENT_FENCE_TIMEOUT);
+        if (ret == GL_TIMEOUT_EXPIRED || ret == GL_WAIT_FAILED)
+            msg_Warn(interop->gl, "persistent buffer fence wait failed");
+        interop->vt->DeleteSync(fence);
+        priv->persistent.fences[idx] = NULL;
+    }
+
+    const size_t slot_offset = idx * priv->persistent.slot_size;
+
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, priv->persistent.buffer);
+
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        const size_t offset = slot_offset + priv->persistent.offsets[i];
+
+        /* The mapping is coherent: no flush nor unmap is needed before the
+         * upload */
+        memcpy(&priv->persistent.map[offset], pic->p[i].p_pixels,
+               (size_t)pic->p[i].i_lines * pic->p[i].i_pitch);
+
+        interop->vt->ActiveTexture(GL_TEXTURE0 + i);
+        interop->vt->BindTexture(interop->tex_target, textures[i]);
+
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, pic->p[i].i_pitch
+            * tex_width[i] / (pic->p[i].i_visible_pitch ? pic->p[i].i_visible_pitch : 1));
+
+        interop->vt->TexSubImage2D(interop->tex_target, 0, 0, 0, tex_width[i], tex_height[i],
+                                   interop->texs[i].format, interop->texs[i].type,
+                                   (const GLvoid *)(uintptr_t)offset);
+        interop->vt->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    priv->persistent.fences[idx] =
+        interop->vt->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    /* turn off pbo */
+    interop->vt->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return VLC_SUCCESS;
+}
+
 void
 opengl_interop_generic_deinit(struct vlc_gl_interop *interop)
 {
     struct priv *priv = interop->priv;
     for (size_t i = 0; i < PBO_DISPLAY_COUNT && priv->pbo.display_pics[i]; ++i)
         picture_Release(priv->pbo.display_pics[i]);
+    persistent_release(interop);
     free(priv->texture_temp_buf);
     free(priv);
 }
@@ -374,9 +530,29 @@ opengl_interop_generic_init(struct vlc_gl_interop *interop, bool allow_dr)
             (vlc_gl_StrHasToken(interop->api->extensions, "GL_ARB_pixel_buffer_object") ||
              vlc_gl_StrHasToken(interop->api->extensions, "GL_EXT_pixel_buffer_object"));
 
+        /* Persistent mapping needs OpenGL 4.4 or GL_ARB_buffer_storage */
+        const bool has_persistent = has_pbo && !interop->api->is_gles &&
+            (strverscmp((const char *)ogl_version, "4.4") >= 0 ||
+             vlc_gl_StrHasToken(interop->api->extensions, "GL_ARB_buffer_storage"));
+
+        const bool supports_persistent = has_persistent
+            && interop->vt->BufferStorage && interop->vt->MapBufferRange
+            && interop->vt->UnmapBuffer && interop->vt->FenceSync
+            && interop->vt->DeleteSync && interop->vt->ClientWaitSync;
+
         const bool supports_pbo = has_pbo && interop->vt->BufferData
             && interop->vt->BufferSubData;
-        if (supports_pbo && pbo_pics_alloc(interop) == VLC_SUCCESS)
+        if (supports_persistent && persistent_alloc(interop) == VLC_SUCCESS)
+        {
+            static const struct vlc_gl_interop_ops persistent_ops = {
+                .allocate_textures = tc_common_allocate_textures,
+                .update_textures = tc_persistent_update,
+                .close = opengl_interop_generic_deinit,
+            };
+            interop->ops = &persistent_ops;
+            msg_Dbg(interop->gl, "Persistent mapping support enabled");
+        }
+        else if (supports_pbo && pbo_pics_alloc(interop) == VLC_SUCCESS)
         {
             static const struct vlc_gl_interop_ops pbo_ops = {
                 .allocate_textures = tc_common_allocate_textures,
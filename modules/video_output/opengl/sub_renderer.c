@@ -43,6 +43,7 @@
 
 typedef struct {
     GLuint   texture;
+    GLuint   palette; /* palette of YUVP regions, 0 for RGBA regions */
     GLsizei  width;
     GLsizei  height;
 
@@ -68,29 +69,39 @@ struct vlc_gl_sub_renderer
     gl_region_t *regions;
     unsigned region_count;
 
-    GLuint program_id;
-    struct {
-        GLint vertex_pos;
-        GLint tex_coords_in;
-    } aloc;
-    struct {
-        GLint sampler;
-        GLint alpha;
-    } uloc;
+    struct sub_program {
+        GLuint id;
+        struct {
+            GLint vertex_pos;
+            GLint tex_coords_in;
+        } aloc;
+        struct {
+            GLint sampler;
+            GLint palette;
+            GLint alpha;
+        } uloc;
+    } rgba, yuvp;
+
+    /* YUVP regions are uploaded as is, and drawn through a palette lookup */
+    GLint index_format;
+    bool has_unpack_subimage;
+    uint8_t *index_buf;
+    size_t index_buf_size;
 
     GLuint *buffer_objects;
     unsigned buffer_object_count;
 };
 
 static int
-FetchLocations(struct vlc_gl_sub_renderer *sr)
+FetchLocations(struct vlc_gl_sub_renderer *sr, struct sub_program *prog,
+               bool palette)
 {
-    assert(sr->program_id);
+    assert(prog->id);
 
     const opengl_vtable_t *vt = sr->vt;
 
 #define GET_LOC(type, x, str) do { \
-    x = vt->Get##type##Location(sr->program_id, str); \
+    x = vt->Get##type##Location(prog->id, str); \
     assert(x != -1); \
     if (x == -1) { \
         msg_Err(sr->gl, "Unable to Get"#type"Location(%s)", str); \
@@ -99,10 +110,14 @@ FetchLocations(struct vlc_gl_sub_renderer *sr)
 } while (0)
 #define GET_ULOC(x, str) GET_LOC(Uniform, x, str)
 #define GET_ALOC(x, str) GET_LOC(Attrib, x, str)
-    GET_ULOC(sr->uloc.sampler, "sampler");
-    GET_ULOC(sr->uloc.alpha, "alpha");
-    GET_ALOC(sr->aloc.vertex_pos, "vertex_pos");
-    GET_ALOC(sr->aloc.tex_coords_in, "tex_coords_in");
+    GET_ULOC(prog->uloc.sampler, "sampler");
+    if (palette)
+        GET_ULOC(prog->uloc.palette, "palette");
+    else
+        prog->uloc.palette = -1;
+    GET_ULOC(prog->uloc.alpha, "alpha");
+    GET_ALOC(prog->aloc.vertex_pos, "vertex_pos");
+    GET_ALOC(prog->aloc.tex_coords_in, "tex_coords_in");
 
 #undef GET_LOC
 #undef GET_ULOC
@@ -134,6 +149,15 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
     sr->vt = vt;
     sr->region_count = 0;
     sr->regions = NULL;
+    sr->yuvp.id = 0;
+    sr->index_buf = NULL;
+    sr->index_buf_size = 0;
+    sr->index_format =
+        vlc_gl_StrHasToken(api->extensions, "GL_ARB_texture_rg") ? GL_RED
+                                                                 : GL_LUMINANCE;
+    /* OpenGL or OpenGL ES2 with GL_EXT_unpack_subimage ext */
+    sr->has_unpack_subimage =
+        !api->is_gles || vlc_gl_StrHasToken(api->extensions, "GL_EXT_unpack_subimage");
 
     static const char *const VERTEX_SHADER_SRC =
 #if defined(USE_OPENGL_ES2)
@@ -165,17 +189,54 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
         "  gl_FragColor = color;\n"
         "}\n";
 
-    sr->program_id =
+    /* The indices are sampled without filtering, then looked up in the
+     * 256x1 YUVA palette, converted with the BT.601 limited range matrix like
+     * the yuvp converter. */
+    static const char *const PALETTE_FRAGMENT_SHADER_SRC =
+#if defined(USE_OPENGL_ES2)
+        "#version 100\n"
+        "precision mediump float;\n"
+#else
+        "#version 120\n"
+#endif
+        "uniform sampler2D sampler;\n"
+        "uniform sampler2D palette;\n"
+        "uniform float alpha;\n"
+        "varying vec2 tex_coords;\n"
+        "const mat3 yuv2rgb = mat3(1.164383,  1.164383, 1.164383,\n"
+        "                          0.0,      -0.391762, 2.017232,\n"
+        "                          1.596027, -0.812968, 0.0);\n"
+        "void main() {\n"
+        "  float index = texture2D(sampler, tex_coords).r;\n"
+        "  vec4 yuva = texture2D(palette,\n"
+        "                        vec2(index * (255.0 / 256.0) + (0.5 / 256.0), 0.5));\n"
+        "  vec3 rgb = yuv2rgb * (yuva.rgb - vec3(16.0 / 255.0, 0.5, 0.5));\n"
+        "  gl_FragColor = vec4(clamp(rgb, 0.0, 1.0), yuva.a * alpha);\n"
+        "}\n";
+
+    sr->rgba.id =
         vlc_gl_BuildProgram(VLC_OBJECT(sr->gl), vt,
                             1, (const char **) &VERTEX_SHADER_SRC,
                             1, (const char **) &FRAGMENT_SHADER_SRC);
-    if (!sr->program_id)
+    if (!sr->rgba.id)
         goto error_2;
 
-    int ret = FetchLocations(sr);
+    int ret = FetchLocations(sr, &sr->rgba, false);
     if (ret != VLC_SUCCESS)
         goto error_3;
 
+    sr->yuvp.id =
+        vlc_gl_BuildProgram(VLC_OBJECT(sr->gl), vt,
+                            1, (const char **) &VERTEX_SHADER_SRC,
+                            1, (const char **) &PALETTE_FRAGMENT_SHADER_SRC);
+    if (sr->yuvp.id && FetchLocations(sr, &sr->yuvp, true) != VLC_SUCCESS)
+    {
+        vt->DeleteProgram(sr->yuvp.id);
+        sr->yuvp.id = 0;
+    }
+    if (!sr->yuvp.id)
+        msg_Warn(gl, "palette subpictures rendering unavailable");
+
     /* Initial number of allocated buffer objects for subpictures, will grow dynamically. */
     static const unsigned INITIAL_BUFFER_OBJECT_COUNT = 8;
     sr->buffer_objects = vlc_alloc(INITIAL_BUFFER_OBJECT_COUNT, sizeof(GLuint));
@@ -189,7 +250,9 @@ vlc_gl_sub_renderer_New(vlc_gl_t *gl, const struct vlc_gl_api *api)
     return sr;
 
 error_3:
-    vt->DeleteProgram(sr->program_id);
+    if (sr->yuvp.id)
+        vt->DeleteProgram(sr->yuvp.id);
+    vt->DeleteProgram(sr->rgba.id);
 error_2:
     vlc_object_delete(sr->interop);
 error_1:
@@ -209,14 +272,110 @@ vlc_gl_sub_renderer_Delete(struct vlc_gl_sub_renderer *sr)
     {
         if (sr->regions[i].texture)
             sr->vt->DeleteTextures(1, &sr->regions[i].texture);
+        if (sr->regions[i].palette)
+            sr->vt->DeleteTextures(1, &sr->regions[i].palette);
     }
     free(sr->regions);
+    free(sr->index_buf);
+
+    if (sr->yuvp.id)
+        sr->vt->DeleteProgram(sr->yuvp.id);
+    sr->vt->DeleteProgram(sr->rgba.id);
 
     vlc_gl_interop_Delete(sr->interop);
 
     free(sr);
 }
 
+static void
+GeneratePaletteTextures(struct vlc_gl_sub_renderer *sr, gl_region_t *glr)
+{
+    const opengl_vtable_t *vt = sr->vt;
+    GLuint textures[2];
+
+    vt->GenTextures(2, textures);
+    for (unsigned i = 0; i < 2; i++)
+    {
+        vt->BindTexture(GL_TEXTURE_2D, textures[i]);
+        /* Indices must not be interpolated */
+        vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        vt->TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    vt->BindTexture(GL_TEXTURE_2D, textures[0]);
+    vt->TexImage2D(GL_TEXTURE_2D, 0, sr->index_format, glr->width, glr->height,
+                   0, sr->index_format, GL_UNSIGNED_BYTE, NULL);
+    vt->BindTexture(GL_TEXTURE_2D, textures[1]);
+    vt->TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE, NULL);
+
+    glr->texture = textures[0];
+    glr->palette = textures[1];
+}
+
+static int
+UploadPaletteRegion(struct vlc_gl_sub_renderer *sr, const gl_region_t *glr,
+                    const subpicture_region_t *r)
+{
+    const opengl_vtable_t *vt = sr->vt;
+    const plane_t *plane = &r->p_picture->p[0];
+    const unsigned width = r->fmt.i_visible_width;
+    const unsigned height = r->fmt.i_visible_height;
+    const uint8_t *pixels = plane->p_pixels
+                          + r->fmt.i_y_offset * plane->i_pitch
+                          + r->fmt.i_x_offset;
+
+    uint8_t palette[256][4];
+    const video_palette_t *p_palette = r->fmt.p_palette;
+    unsigned entries = p_palette ? __MIN(p_palette->i_entries, 256) : 0;
+    if (entries > 0)
+        memcpy(palette, p_palette->palette, entries * sizeof (palette[0]));
+    memset(&palette[entries], 0, (256 - entries) * sizeof (palette[0]));
+
+    vt->BindTexture(GL_TEXTURE_2D, glr->palette);
+    vt->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    vt->TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 256, 1, GL_RGBA,
+                      GL_UNSIGNED_BYTE, palette);
+
+    vt->BindTexture(GL_TEXTURE_2D, glr->texture);
+    vt->PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if ((unsigned) plane->i_pitch == width)
+        vt->TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                          sr->index_format, GL_UNSIGNED_BYTE, pixels);
+    else if (sr->has_unpack_subimage)
+    {
+        vt->PixelStorei(GL_UNPACK_ROW_LENGTH, plane->i_pitch);
+        vt->TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                          sr->index_format, GL_UNSIGNED_BYTE, pixels);
+        vt->PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+    else
+    {
+        size_t size = (size_t)width * height;
+        if (sr->index_buf_size < size)
+        {
+            sr->index_buf = realloc_or_free(sr->index_buf, size);
+            if (sr->index_buf == NULL)
+            {
+                sr->index_buf_size = 0;
+                vt->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+                return VLC_ENOMEM;
+            }
+            sr->index_buf_size = size;
+        }
+        for (unsigned y = 0; y < height; y++)
+            memcpy(&sr->index_buf[y * width], &pixels[y * plane->i_pitch],
+                   width);
+        vt->TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                          sr->index_format, GL_UNSIGNED_BYTE, sr->index_buf);
+    }
+    vt->PixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    return VLC_SUCCESS;
+}
+
 int
 vlc_gl_sub_renderer_Prepare(struct vlc_gl_sub_renderer *sr, subpicture_t *subpicture)
 {
@@ -255,25 +414,48 @@ vlc_gl_sub_renderer_Prepare(struct vlc_gl_sub_renderer *sr, subpicture_t *subpic
                 glr->tex_width  = 1.0;
                 glr->tex_height = 1.0;
             }
+            /* Regions left unscaled by the core (see can_scale_spu) */
+            float zoom_h = 1.f, zoom_v = 1.f;
+            if (r->zoom_h.num != 0 && r->zoom_h.den != 0)
+                zoom_h = (float) r->zoom_h.num / r->zoom_h.den;
+            if (r->zoom_v.num != 0 && r->zoom_v.den != 0)
+                zoom_v = (float) r->zoom_v.num / r->zoom_v.den;
+
             glr->alpha  = (float)subpicture->i_alpha * r->i_alpha / 255 / 255;
-            glr->left   =  2.0 * (r->i_x                          ) / subpicture->i_original_picture_width  - 1.0;
-            glr->top    = -2.0 * (r->i_y                          ) / subpicture->i_original_picture_height + 1.0;
-            glr->right  =  2.0 * (r->i_x + r->fmt.i_visible_width ) / subpicture->i_original_picture_width  - 1.0;
-            glr->bottom = -2.0 * (r->i_y + r->fmt.i_visible_height) / subpicture->i_original_picture_height + 1.0;
+            glr->left   =  2.0 * zoom_h * (r->i_x                          ) / subpicture->i_original_picture_width  - 1.0;
+            glr->top    = -2.0 * zoom_v * (r->i_y                          ) / subpicture->i_original_picture_height + 1.0;
+            glr->right  =  2.0 * zoom_h * (r->i_x + r->fmt.i_visible_width ) / subpicture->i_original_picture_width  - 1.0;
+            glr->bottom = -2.0 * zoom_v * (r->i_y + r->fmt.i_visible_height) / subpicture->i_original_picture_height + 1.0;
+
+            const bool paletted = r->fmt.i_chroma == VLC_CODEC_YUVP;
+            /* only advertised with a palette program */
+            assert(!paletted || sr->yuvp.id);
 
             glr->texture = 0;
+            glr->palette = 0;
             /* Try to recycle the textures allocated by the previous
                call to this function. */
             for (int j = 0; j < last_count; j++) {
                 if (last[j].texture &&
+                    (last[j].palette != 0) == paletted &&
                     last[j].width  == glr->width &&
                     last[j].height == glr->height) {
                     glr->texture = last[j].texture;
+                    glr->palette = last[j].palette;
                     memset(&last[j], 0, sizeof(last[j]));
                     break;
                 }
             }
 
+            if (paletted)
+            {
+                if (!glr->texture)
+                    GeneratePaletteTextures(sr, glr);
+                if (UploadPaletteRegion(sr, glr, r) != VLC_SUCCESS)
+                    break;
+                continue;
+            }
+
             const size_t pixels_offset =
                 r->fmt.i_y_offset * r->p_picture->p->i_pitch +
                 r->fmt.i_x_offset * r->p_picture->p->i_pixel_pitch;
@@ -303,6 +485,8 @@ vlc_gl_sub_renderer_Prepare(struct vlc_gl_sub_renderer *sr, subpicture_t *subpic
     }
 
     for (int i = 0; i < last_count; i++) {
+        if (last[i].palette)
+            sr->vt->DeleteTextures(1, &last[i].palette);
         if (last[i].texture)
             vlc_gl_interop_DeleteTextures(interop, &last[i].texture);
     }
@@ -321,9 +505,6 @@ vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr)
 
     GL_ASSERT_NOERROR(vt);
 
-    assert(sr->program_id);
-    vt->UseProgram(sr->program_id);
-
     vt->Enable(GL_BLEND);
     vt->BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
@@ -342,9 +523,18 @@ vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr)
         vt->GenBuffers(sr->buffer_object_count, sr->buffer_objects);
     }
 
-    vt->ActiveTexture(GL_TEXTURE0 + 0);
+    const struct sub_program *prog = NULL;
     for (unsigned i = 0; i < sr->region_count; i++) {
         gl_region_t *glr = &sr->regions[i];
+        const struct sub_program *region_prog = glr->palette ? &sr->yuvp
+                                                             : &sr->rgba;
+        if (region_prog != prog) {
+            prog = region_prog;
+            assert(prog->id);
+            vt->UseProgram(prog->id);
+            if (prog->uloc.palette != -1)
+                vt->Uniform1i(prog->uloc.palette, 1);
+        }
         const GLfloat vertexCoord[] = {
             glr->left,  glr->top,
             glr->left,  glr->bottom,
@@ -359,19 +549,27 @@ vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr)
         };
 
         assert(glr->texture != 0);
-        vt->BindTexture(interop->tex_target, glr->texture);
+        if (glr->palette) {
+            vt->ActiveTexture(GL_TEXTURE0 + 1);
+            vt->BindTexture(GL_TEXTURE_2D, glr->palette);
+            vt->ActiveTexture(GL_TEXTURE0 + 0);
+            vt->BindTexture(GL_TEXTURE_2D, glr->texture);
+        } else {
+            vt->ActiveTexture(GL_TEXTURE0 + 0);
+            vt->BindTexture(interop->tex_target, glr->texture);
+        }
 
-        vt->Uniform1f(sr->uloc.alpha, glr->alpha);
+        vt->Uniform1f(prog->uloc.alpha, glr->alpha);
 
         vt->BindBuffer(GL_ARRAY_BUFFER, sr->buffer_objects[2 * i]);
         vt->BufferData(GL_ARRAY_BUFFER, sizeof(textureCoord), textureCoord, GL_STATIC_DRAW);
-        vt->EnableVertexAttribArray(sr->aloc.tex_coords_in);
-        vt->VertexAttribPointer(sr->aloc.tex_coords_in, 2, GL_FLOAT, 0, 0, 0);
+        vt->EnableVertexAttribArray(prog->aloc.tex_coords_in);
+        vt->VertexAttribPointer(prog->aloc.tex_coords_in, 2, GL_FLOAT, 0, 0, 0);
 
         vt->BindBuffer(GL_ARRAY_BUFFER, sr->buffer_objects[2 * i + 1]);
         vt->BufferData(GL_ARRAY_BUFFER, sizeof(vertexCoord), vertexCoord, GL_STATIC_DRAW);
-        vt->EnableVertexAttribArray(sr->aloc.vertex_pos);
-        vt->VertexAttribPointer(sr->aloc.vertex_pos, 2, GL_FLOAT, 0, 0, 0);
+        vt->EnableVertexAttribArray(prog->aloc.vertex_pos);
+        vt->VertexAttribPointer(prog->aloc.vertex_pos, 2, GL_FLOAT, 0, 0, 0);
 
         vt->DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
     }
@@ -381,3 +579,15 @@ vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr)
 
     return VLC_SUCCESS;
 }
+
+const vlc_fourcc_t *
+vlc_gl_sub_renderer_Chromas(const struct vlc_gl_sub_renderer *sr)
+{
+    /* RGBA first: the core converts other chromas to the first one */
+    static const vlc_fourcc_t rgba[] = { VLC_CODEC_RGBA, 0 };
+    static const vlc_fourcc_t rgba_yuvp[] = {
+        VLC_CODEC_RGBA, VLC_CODEC_YUVP, 0
+    };
+
+    return sr->yuvp.id ? rgba_yuvp : rgba;
+}
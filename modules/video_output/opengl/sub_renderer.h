@@ -32,7 +32,7 @@
 #include "gl_common.h"
 
 /**
- * A subpictures renderer handles the rendering of RGB subpictures.
+ * A subpictures renderer handles the rendering of RGB and palette subpictures.
  */
 struct vlc_gl_sub_renderer;
 
@@ -76,4 +76,15 @@ vlc_gl_sub_renderer_Prepare(struct vlc_gl_sub_renderer *sr,
 int
 vlc_gl_sub_renderer_Draw(struct vlc_gl_sub_renderer *sr);
 
+/**
+ * Get the subpicture chromas supported by the renderer
+ *
+ * YUVP subpictures are uploaded as is and converted by the shader.
+ *
+ * \param sr the renderer
+ * \return a zero-terminated list, most preferred first
+ */
+const vlc_fourcc_t *
+vlc_gl_sub_renderer_Chromas(const struct vlc_gl_sub_renderer *sr);
+
 #endif
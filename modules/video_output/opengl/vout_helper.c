@@ -55,11 +55,6 @@ struct vout_display_opengl_t {
     struct vlc_gl_sub_renderer *sub_renderer;
 };
 
-static const vlc_fourcc_t gl_subpicture_chromas[] = {
-    VLC_CODEC_RGBA,
-    0
-};
-
 static void
 ResizeFormatToGLMaxTexSize(video_format_t *fmt, unsigned int max_tex_size)
 {
@@ -164,7 +159,7 @@ vout_display_opengl_t *vout_display_opengl_New(video_format_t *fmt,
 
     *fmt = renderer->fmt;
     if (subpicture_chromas) {
-        *subpicture_chromas = gl_subpicture_chromas;
+        *subpicture_chromas = vlc_gl_sub_renderer_Chromas(vgl->sub_renderer);
     }
 
     GL_ASSERT_NOERROR(vt);
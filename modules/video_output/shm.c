@@ -0,0 +1,238 @@
+/*****************************************************************************
+ * shm.c: shared memory video output
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Publishes the displayed pictures into a shared memory ring (see
+ * shmframes.h), so that other processes can analyse them in place.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_vout_display.h>
+#include <vlc_picture.h>
+#include "shmframes.h"
+
+#define NAME_TEXT N_("Shared memory name")
+#define NAME_LONGTEXT N_("Name of the shared memory object, starting with " \
+    "a slash. By default, a name is generated and printed in the log.")
+
+#define SLOTS_TEXT N_("Frames")
+#define SLOTS_LONGTEXT N_("Number of frames kept in the shared memory " \
+    "ring. Readers have that many frame periods to use a frame before " \
+    "it is overwritten.")
+
+#define CHROMA_TEXT N_("Chroma")
+#define CHROMA_LONGTEXT N_("Force the chroma of the published frames as a " \
+    "4-character string, eg. \"RV32\". By default, the decoded chroma is " \
+    "kept.")
+
+static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
+                video_format_t *fmtp, vlc_video_context *context);
+
+vlc_module_begin()
+    set_shortname(N_("Shared memory"))
+    set_description(N_("Shared memory video output"))
+    set_category(CAT_VIDEO)
+    set_subcategory(SUBCAT_VIDEO_VOUT)
+    add_string("shmframes-name", NULL, NAME_TEXT, NAME_LONGTEXT, false)
+    add_integer_with_range("shmframes-slots", 4, 2, 64,
+                           SLOTS_TEXT, SLOTS_LONGTEXT, true)
+    add_string("shmframes-chroma", NULL, CHROMA_TEXT, CHROMA_LONGTEXT, true)
+    add_shortcut("shmframes")
+    set_callback_display(Open, 0)
+vlc_module_end()
+
+struct vout_display_sys_t
+{
+    vlc_shmframes_t *shm;
+    struct vlc_shmframes_slot *slot; /* prepared, not yet displayed */
+    uint8_t *pixels;
+    struct vlc_shmframes_plane planes[VLC_SHMFRAMES_PLANES];
+    unsigned plane_count;
+    size_t size;
+};
+
+static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
+                    vlc_tick_t date)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct vlc_shmframes_slot *slot = sys->slot;
+    picture_resource_t rsc = { .p_sys = NULL };
+
+    /* Rewrite the pending slot if the previous picture was not displayed */
+    if (slot == NULL)
+        sys->pixels = vlc_shmframes_Begin(sys->shm, &slot);
+
+    uint8_t *pixels = sys->pixels;
+
+    for (unsigned i = 0; i < sys->plane_count; i++)
+    {
+        rsc.p[i].p_pixels = pixels + sys->planes[i].offset;
+        rsc.p[i].i_lines = sys->planes[i].lines;
+        rsc.p[i].i_pitch = sys->planes[i].pitch;
+    }
+
+    /* The one and only copy: the readers use the pixels in place. */
+    picture_t *dst = picture_NewFromResource(&vd->fmt, &rsc);
+    if (likely(dst != NULL))
+    {
+        picture_CopyPixels(dst, pic);
+        picture_Release(dst);
+    }
+
+    slot->pts = pic->date != VLC_TICK_INVALID
+              ? US_FROM_VLC_TICK(pic->date - VLC_TICK_0) : INT64_MIN;
+    slot->chroma = vd->fmt.i_chroma;
+    slot->width = vd->fmt.i_width;
+    slot->height = vd->fmt.i_height;
+    slot->x_offset = vd->fmt.i_x_offset;
+    slot->y_offset = vd->fmt.i_y_offset;
+    slot->visible_width = vd->fmt.i_visible_width;
+    slot->visible_height = vd->fmt.i_visible_height;
+    slot->sar_num = vd->fmt.i_sar_num;
+    slot->sar_den = vd->fmt.i_sar_den;
+    slot->plane_count = sys->plane_count;
+    memcpy(slot->planes, sys->planes, sizeof (sys->planes));
+    slot->size = sys->size;
+    sys->slot = slot;
+
+    (void) subpic; (void) date;
+}
+
+static void Display(vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+
+    /* Publish at display time, not when the picture is prepared */
+    if (sys->slot != NULL)
+    {
+        vlc_shmframes_Commit(sys->shm);
+        sys->slot = NULL;
+    }
+    (void) pic;
+}
+
+static int Control(vout_display_t *vd, int query, va_list args)
+{
+    (void) vd; (void) args;
+
+    switch (query)
+    {
+        case VOUT_DISPLAY_CHANGE_DISPLAY_SIZE:
+        case VOUT_DISPLAY_CHANGE_DISPLAY_FILLED:
+        case VOUT_DISPLAY_CHANGE_ZOOM:
+        case VOUT_DISPLAY_CHANGE_SOURCE_ASPECT:
+        case VOUT_DISPLAY_CHANGE_SOURCE_CROP:
+            return VLC_SUCCESS;
+    }
+    return VLC_EGENERIC;
+}
+
+static void Close(vout_display_t *vd)
+{
+    vout_display_sys_t *sys = vd->sys;
+
+    if (sys->slot != NULL) /* prepared but not displayed */
+        vlc_shmframes_Commit(sys->shm);
+    vlc_shmframes_Destroy(sys->shm);
+    free(sys);
+}
+
+static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
+                video_format_t *fmtp, vlc_video_context *context)
+{
+    video_format_t fmt;
+
+    video_format_ApplyRotation(&fmt, fmtp);
+
+    char *chroma = var_InheritString(vd, "shmframes-chroma");
+    if (chroma != NULL)
+    {
+        fmt.i_chroma = vlc_fourcc_GetCodecFromString(VIDEO_ES, chroma);
+        if (fmt.i_chroma == 0)
+        {
+            msg_Err(vd, "invalid chroma %s", chroma);
+            free(chroma);
+            return VLC_EGENERIC;
+        }
+        free(chroma);
+    }
+
+    /* Opaque (hardware) pictures cannot be shared: let the core convert. */
+    const vlc_chroma_description_t *desc =
+        vlc_fourcc_GetChromaDescription(fmt.i_chroma);
+    if (context != NULL || desc == NULL || desc->plane_count == 0)
+        fmt.i_chroma = VLC_CODEC_I420;
+    video_format_FixRgb(&fmt);
+
+    vout_display_sys_t *sys = malloc(sizeof (*sys));
+    if (unlikely(sys == NULL))
+        return VLC_ENOMEM;
+
+    /* Let the core compute the plane layout (alignment, margins). */
+    picture_t *layout = picture_NewFromFormat(&fmt);
+    if (layout == NULL)
+    {
+        free(sys);
+        return VLC_ENOMEM;
+    }
+
+    memset(sys->planes, 0, sizeof (sys->planes));
+    sys->plane_count = layout->i_planes;
+    sys->size = 0;
+    for (int i = 0; i < layout->i_planes; i++)
+    {
+        const plane_t *p = &layout->p[i];
+
+        sys->planes[i].offset = sys->size;
+        sys->planes[i].pitch = p->i_pitch;
+        sys->planes[i].lines = p->i_lines;
+        sys->planes[i].visible_pitch = p->i_visible_pitch;
+        sys->planes[i].visible_lines = p->i_visible_lines;
+        sys->size += (size_t) p->i_pitch * p->i_lines;
+        sys->size = (sys->size + 63) & ~(size_t)63;
+    }
+    picture_Release(layout);
+
+    char *name = var_InheritString(vd, "shmframes-name");
+    sys->shm = vlc_shmframes_Create(VLC_OBJECT(vd), name,
+                                    var_InheritInteger(vd, "shmframes-slots"),
+                                    sys->size);
+    free(name);
+    if (sys->shm == NULL)
+    {
+        free(sys);
+        return VLC_EGENERIC;
+    }
+    sys->slot = NULL;
+
+    *fmtp = fmt;
+    vd->sys = sys;
+    vd->prepare = Prepare;
+    vd->display = Display;
+    vd->control = Control;
+    vd->close = Close;
+    (void) cfg;
+    return VLC_SUCCESS;
+}
@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * shmframes.c: shared memory frame ring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef __linux__
+# include <linux/futex.h>
+# include <sys/syscall.h>
+#endif
+
+#include <vlc_common.h>
+#include "shmframes.h"
+
+struct vlc_shmframes
+{
+    vlc_object_t *obj;
+    char *name;
+    struct vlc_shmframes_header *header;
+    size_t length;
+    uint8_t *data;
+    size_t slot_size;
+    unsigned slot_count;
+    uint64_t frame; /* next frame number */
+};
+
+static void vlc_shmframes_wake(_Atomic uint32_t *addr)
+{
+#ifdef __linux__
+    /* Not FUTEX_PRIVATE_FLAG: the waiters live in other processes. */
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void) addr;
+#endif
+}
+
+vlc_shmframes_t *vlc_shmframes_Create(vlc_object_t *obj, const char *name,
+                                      unsigned slot_count, size_t slot_size)
+{
+    static atomic_uint counter = 0;
+    const long page_size = sysconf(_SC_PAGESIZE);
+
+    assert(slot_count > 0);
+    if (slot_size == 0 || slot_size > UINT32_MAX)
+        return NULL;
+
+    vlc_shmframes_t *shm = malloc(sizeof (*shm));
+    if (unlikely(shm == NULL))
+        return NULL;
+
+    if (name != NULL && *name != '\0')
+        shm->name = strdup(name);
+    else if (asprintf(&shm->name, "/vlc-frames-%ld-%u", (long) getpid(),
+                      atomic_fetch_add(&counter, 1)) == -1)
+        shm->name = NULL;
+    if (unlikely(shm->name == NULL))
+    {
+        free(shm);
+        return NULL;
+    }
+
+    /* Pixels are aligned on pages, so that readers can map them apart */
+    size_t header_size = sizeof (struct vlc_shmframes_header)
+                       + slot_count * sizeof (struct vlc_shmframes_slot);
+    header_size = (header_size + page_size - 1) & ~(size_t)(page_size - 1);
+    slot_size = (slot_size + 63) & ~(size_t)63;
+
+    shm->obj = obj;
+    shm->slot_size = slot_size;
+    shm->slot_count = slot_count;
+    shm->length = header_size + slot_count * slot_size;
+    shm->frame = 0;
+
+    int fd = shm_open(shm->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1)
+    {
+        msg_Err(obj, "cannot create shared memory %s: %s", shm->name,
+                vlc_strerror_c(errno));
+        goto error;
+    }
+
+    if (ftruncate(fd, shm->length))
+    {
+        msg_Err(obj, "cannot allocate %zu bytes of shared memory: %s",
+                shm->length, vlc_strerror_c(errno));
+        close(fd);
+        goto error_unlink;
+    }
+
+    void *base = mmap(NULL, shm->length, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        msg_Err(obj, "cannot map shared memory: %s", vlc_strerror_c(errno));
+        goto error_unlink;
+    }
+
+    struct vlc_shmframes_header *header = base;
+
+    /* The object is new, hence zeroed */
+    header->version = VLC_SHMFRAMES_VERSION;
+    header->header_size = sizeof (*header);
+    header->slot_header_size = sizeof (header->slots[0]);
+    header->slot_count = slot_count;
+    header->slot_size = slot_size;
+    header->data_offset = header_size;
+    atomic_init(&header->frame_count, 0);
+    atomic_init(&header->closed, 0);
+    for (unsigned i = 0; i < slot_count; i++)
+        atomic_init(&header->slots[i].sequence, 0);
+    /* Readers check the magic last */
+    atomic_thread_fence(memory_order_release);
+    header->magic = VLC_SHMFRAMES_MAGIC;
+
+    shm->header = header;
+    shm->data = (uint8_t *)base + header_size;
+    msg_Info(obj, "publishing frames in shared memory %s (%u x %zu bytes)",
+             shm->name, slot_count, slot_size);
+    return shm;
+
+error_unlink:
+    shm_unlink(shm->name);
+error:
+    free(shm->name);
+    free(shm);
+    return NULL;
+}
+
+void vlc_shmframes_Destroy(vlc_shmframes_t *shm)
+{
+    atomic_store_explicit(&shm->header->closed, 1, memory_order_release);
+    vlc_shmframes_wake(&shm->header->closed);
+    vlc_shmframes_wake(&shm->header->frame_count);
+
+    /* Readers that already mapped the object keep it until they unmap it */
+    munmap(shm->header, shm->length);
+    shm_unlink(shm->name);
+    free(shm->name);
+    free(shm);
+}
+
+uint8_t *vlc_shmframes_Begin(vlc_shmframes_t *shm,
+                             struct vlc_shmframes_slot **meta)
+{
+    unsigned index = shm->frame % shm->slot_count;
+    struct vlc_shmframes_slot *slot = &shm->header->slots[index];
+    uint64_t seq = atomic_load_explicit(&slot->sequence,
+                                        memory_order_relaxed);
+
+    assert(!(seq & 1));
+    atomic_store_explicit(&slot->sequence, seq + 1, memory_order_relaxed);
+    /* Order the odd sequence before the slot stores */
+    atomic_thread_fence(memory_order_release);
+
+    slot->frame = shm->frame;
+    *meta = slot;
+    return shm->data + index * shm->slot_size;
+}
+
+void vlc_shmframes_Commit(vlc_shmframes_t *shm)
+{
+    unsigned index = shm->frame % shm->slot_count;
+    struct vlc_shmframes_slot *slot = &shm->header->slots[index];
+    uint64_t seq = atomic_load_explicit(&slot->sequence,
+                                        memory_order_relaxed);
+
+    assert(seq & 1);
+    atomic_store_explicit(&slot->sequence, seq + 1, memory_order_release);
+    shm->frame++;
+    atomic_store_explicit(&shm->header->frame_count, (uint32_t) shm->frame,
+                          memory_order_release);
+    vlc_shmframes_wake(&shm->header->frame_count);
+}
@@ -0,0 +1,125 @@
+/*****************************************************************************
+ * shmframes.h: shared memory frame ring
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_SHMFRAMES_H
+#define VLC_SHMFRAMES_H 1
+
+/*
+ * Layout of the shared memory object (see shm_open()):
+ *
+ *   struct vlc_shmframes_header
+ *   struct vlc_shmframes_slot[slot_count]
+ *   (padding up to data_offset)
+ *   slot_count times slot_size bytes of pixels
+ *
+ * There is a single writer and any number of readers. The writer never
+ * waits for the readers: it fills the slots in turn, overwriting the
+ * oldest frame. Each slot is protected by a sequence counter, which is odd
+ * while the slot is being written. A reader:
+ *  1. waits for frame_count to change (polling, or futex on Linux),
+ *  2. loads the sequence of slot (frame_count - 1) % slot_count,
+ *     with acquire semantics, and skips the slot if it is odd,
+ *  3. uses the metadata and the pixels (in place),
+ *  4. reloads the sequence, and discards its work if it changed, as the
+ *     frame was overwritten in the mean time.
+ *
+ * All fields are in host byte order. Readers shall check the magic and the
+ * version.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define VLC_SHMFRAMES_MAGIC   0x4d48534c /* "LSHM" */
+#define VLC_SHMFRAMES_VERSION 1
+#define VLC_SHMFRAMES_PLANES  5
+
+struct vlc_shmframes_plane
+{
+    uint32_t offset; /**< from the start of the slot pixels */
+    uint32_t pitch; /**< bytes per line */
+    uint32_t lines;
+    uint32_t visible_pitch;
+    uint32_t visible_lines;
+};
+
+struct vlc_shmframes_slot
+{
+    _Atomic uint64_t sequence; /**< odd while being written */
+    uint64_t frame; /**< frame number, from 0 */
+    int64_t  pts; /**< microseconds, INT64_MIN if unknown */
+    uint32_t chroma; /**< VLC four character code */
+    uint32_t width;
+    uint32_t height;
+    uint32_t x_offset;
+    uint32_t y_offset;
+    uint32_t visible_width;
+    uint32_t visible_height;
+    uint32_t sar_num;
+    uint32_t sar_den;
+    uint32_t plane_count;
+    struct vlc_shmframes_plane planes[VLC_SHMFRAMES_PLANES];
+    uint32_t size; /**< bytes of pixels used */
+    uint32_t reserved;
+};
+
+struct vlc_shmframes_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size; /**< sizeof (struct vlc_shmframes_header) */
+    uint32_t slot_header_size; /**< sizeof (struct vlc_shmframes_slot) */
+    uint32_t slot_count;
+    uint32_t slot_size; /**< bytes of pixels per slot */
+    uint64_t data_offset; /**< offset of the first slot pixels */
+    _Atomic uint32_t frame_count; /**< frames published (wraps) */
+    _Atomic uint32_t closed; /**< set when the writer goes away */
+    struct vlc_shmframes_slot slots[];
+};
+
+typedef struct vlc_shmframes vlc_shmframes_t;
+
+/**
+ * Creates a shared memory frame ring.
+ *
+ * \param name object name, starting with a slash (or NULL for a generated
+ *             name, printed in the log)
+ */
+vlc_shmframes_t *vlc_shmframes_Create(vlc_object_t *obj, const char *name,
+                                      unsigned slot_count, size_t slot_size);
+
+void vlc_shmframes_Destroy(vlc_shmframes_t *);
+
+/**
+ * Starts writing the next slot.
+ *
+ * \param meta pointer to the slot metadata [OUT], to be filled in
+ * \return the slot pixels
+ */
+uint8_t *vlc_shmframes_Begin(vlc_shmframes_t *,
+                             struct vlc_shmframes_slot **meta);
+
+/**
+ * Publishes the slot started by vlc_shmframes_Begin() and wakes up the
+ * readers.
+ */
+void vlc_shmframes_Commit(vlc_shmframes_t *);
+
+#endif
@@ -39,15 +39,30 @@
 #include <libplacebo/swapchain.h>
 #include <libplacebo/vulkan.h>
 
+// Textures used by one frame in flight. Each frame gets its own set, so that
+// uploading the next picture does not have to wait for the GPU to be done
+// rendering the previous ones from the same textures.
+struct frame_res
+{
+    const struct pl_tex *plane_tex[4];
+
+    // Pool of textures for the subpictures
+    const struct pl_tex **overlay_tex;
+    int num_overlay_tex;
+};
+
 struct vout_display_sys_t
 {
     vlc_vk_t *vk;
-    const struct pl_tex *plane_tex[4];
     struct pl_renderer *renderer;
 
-    // Pool of textures for the subpictures
+    // Ring of per-frame resources, sized to the swapchain depth
+    struct frame_res *frames;
+    int num_frames;
+    int frame_idx;
+
+    // Subpicture descriptors for the frame being rendered
     struct pl_overlay *overlays;
-    const struct pl_tex **overlay_tex;
     int num_overlays;
 
     // Dynamic during rendering
@@ -102,6 +117,13 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     if (!sys->renderer)
         goto error;
 
+    // One more set than the swapchain depth, for the frame being recorded
+    sys->num_frames = __MAX(sys->vk->swapchain_depth, 1) + 1;
+    sys->frames = calloc(sys->num_frames, sizeof(*sys->frames));
+    if (!sys->frames)
+        goto error;
+    msg_Dbg(vd, "Using %d frames in flight", sys->num_frames);
+
     // Attempt using the input format as the display format
     if (vlc_placebo_FormatSupported(gpu, vd->source.i_chroma)) {
         fmt->i_chroma = vd->source.i_chroma;
@@ -149,6 +171,7 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     return VLC_SUCCESS;
 
 error:
+    free(sys->frames);
     pl_renderer_destroy(&sys->renderer);
     if (sys->vk != NULL)
         vlc_vk_Release(sys->vk);
@@ -160,15 +183,16 @@ static void Close(vout_display_t *vd)
     vout_display_sys_t *sys = vd->sys;
     const struct pl_gpu *gpu = sys->vk->vulkan->gpu;
 
-    for (int i = 0; i < 4; i++)
-        pl_tex_destroy(gpu, &sys->plane_tex[i]);
-    for (int i = 0; i < sys->num_overlays; i++)
-        pl_tex_destroy(gpu, &sys->overlay_tex[i]);
-
-    if (sys->overlays) {
-        free(sys->overlays);
-        free(sys->overlay_tex);
+    for (int f = 0; f < sys->num_frames; f++) {
+        struct frame_res *res = &sys->frames[f];
+        for (int i = 0; i < 4; i++)
+            pl_tex_destroy(gpu, &res->plane_tex[i]);
+        for (int i = 0; i < res->num_overlay_tex; i++)
+            pl_tex_destroy(gpu, &res->overlay_tex[i]);
+        free(res->overlay_tex);
     }
+    free(sys->frames);
+    free(sys->overlays);
 
     pl_renderer_destroy(&sys->renderer);
 
@@ -187,6 +211,11 @@ static void PictureRender(vout_display_t *vd, picture_t *pic,
     if (!pl_swapchain_start_frame(sys->vk->swapchain, &frame))
         return; // Probably benign error, ignore it
 
+    // The swapchain keeps at most num_frames - 1 frames in flight, so the
+    // textures of the oldest set are no longer in use by the GPU
+    struct frame_res *res = &sys->frames[sys->frame_idx];
+    sys->frame_idx = (sys->frame_idx + 1) % sys->num_frames;
+
     struct pl_image img = {
         .signature  = sys->counter++,
         .num_planes = pic->i_planes,
@@ -211,7 +240,7 @@ static void PictureRender(vout_display_t *vd, picture_t *pic,
 
     for (int i = 0; i < pic->i_planes; i++) {
         struct pl_plane *plane = &img.planes[i];
-        if (!pl_upload_plane(gpu, plane, &sys->plane_tex[i], &data[i])) {
+        if (!pl_upload_plane(gpu, plane, &res->plane_tex[i], &data[i])) {
             msg_Err(vd, "Failed uploading image data!");
             failed = true;
             goto done;
@@ -257,19 +286,30 @@ static void PictureRender(vout_display_t *vd, picture_t *pic,
         // Grow the overlays array if needed
         if (num_regions > sys->num_overlays) {
             sys->overlays = realloc(sys->overlays, num_regions * sizeof(struct pl_overlay));
-            sys->overlay_tex = realloc(sys->overlay_tex, num_regions * sizeof(struct pl_tex *));
-            if (!sys->overlays || !sys->overlay_tex) {
+            if (!sys->overlays) {
                 // Unlikely OOM, just do whatever
                 sys->num_overlays = 0;
                 failed = true;
                 goto done;
             }
-            // Clear the newly added texture pointers for pl_upload_plane
-            for (int i = sys->num_overlays; i < num_regions; i++)
-                sys->overlay_tex[i] = NULL;
             sys->num_overlays = num_regions;
         }
 
+        // Grow the textures pool of this frame if needed
+        if (num_regions > res->num_overlay_tex) {
+            const struct pl_tex **tex = realloc(res->overlay_tex,
+                                                num_regions * sizeof(*tex));
+            if (!tex) {
+                failed = true;
+                goto done;
+            }
+            // Clear the newly added texture pointers for pl_upload_plane
+            for (int i = res->num_overlay_tex; i < num_regions; i++)
+                tex[i] = NULL;
+            res->overlay_tex = tex;
+            res->num_overlay_tex = num_regions;
+        }
+
         // Upload all of the regions
         subpicture_region_t *r = subpicture->p_region;
         for (int i = 0; i < num_regions; i++) {
@@ -291,7 +331,7 @@ static void PictureRender(vout_display_t *vd, picture_t *pic,
                 .repr  = vlc_placebo_ColorRepr(&r->fmt),
             };
 
-            if (!pl_upload_plane(gpu, &overlay->plane, &sys->overlay_tex[i], &subdata)) {
+            if (!pl_upload_plane(gpu, &overlay->plane, &res->overlay_tex[i], &subdata)) {
                 msg_Err(vd, "Failed uploading subpicture region!");
                 num_regions = i; // stop here
                 break;
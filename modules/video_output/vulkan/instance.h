@@ -47,6 +47,7 @@ typedef struct vlc_vk_t
     const struct pl_swapchain *swapchain;
     VkSurfaceKHR surface;
     struct vout_window_t *window;
+    int swapchain_depth; // maximum number of frames in flight
 } vlc_vk_t;
 
 vlc_vk_t *vlc_vk_Create(struct vout_window_t *, const char *) VLC_USED;
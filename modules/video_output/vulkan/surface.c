@@ -87,6 +87,7 @@ static int Open (vlc_object_t *obj)
     vk->swapchain = pl_vulkan_create_swapchain(vk->vulkan, &swap_params);
     if (!vk->swapchain)
         goto error;
+    vk->swapchain_depth = swap_params.swapchain_depth;
 
     return VLC_SUCCESS;
 
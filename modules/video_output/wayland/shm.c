@@ -29,8 +29,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <wayland-client.h>
@@ -42,7 +44,22 @@
 #include <vlc_vout_display.h>
 #include <vlc_fs.h>
 
-#define MAX_PICTURES 4
+#define MAX_BUFFERS 8 /* cached server buffers */
+#define MAX_ACTIVE_BUFFERS 2 /* before waiting for the server */
+
+struct buffer_data
+{
+    struct wl_buffer *buffer; /* NULL if the entry is unused */
+    picture_t *picture; /* non-NULL while the server uses the buffer */
+    size_t *counter;
+    int fd; /* keeps the memory object, hence its inode number, alive */
+    dev_t dev;
+    ino_t ino;
+    off_t offset;
+    unsigned width;
+    unsigned height;
+    size_t stride;
+};
 
 struct vout_display_sys_t
 {
@@ -53,28 +70,26 @@ struct vout_display_sys_t
     struct wp_viewport *viewport;
 
     size_t active_buffers;
+    bool damage_buffer;
 
     unsigned display_width;
     unsigned display_height;
-};
 
-struct buffer_data
-{
-    picture_t *picture;
-    size_t *counter;
+    /* Pictures come from a pool, so the same memory is displayed over and
+     * over again: keep the server buffers rather than creating (and having
+     * the server map) a pool and a buffer for every frame. */
+    struct buffer_data buffers[MAX_BUFFERS];
 };
 
-static_assert (sizeof (vout_display_sys_t) >= MAX_PICTURES,
-               "Pointer arithmetic error");
-
 static void buffer_release_cb(void *data, struct wl_buffer *buffer)
 {
     struct buffer_data *d = data;
 
+    assert(d->buffer == buffer);
     picture_Release(d->picture);
+    d->picture = NULL;
     (*(d->counter))--;
-    free(d);
-    wl_buffer_destroy(buffer);
+    (void) buffer;
 }
 
 static const struct wl_buffer_listener buffer_cbs =
@@ -82,57 +97,137 @@ static const struct wl_buffer_listener buffer_cbs =
     buffer_release_cb,
 };
 
-static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
-                    vlc_tick_t date)
+static void BufferDestroy(struct buffer_data *d)
 {
-    VLC_UNUSED(date);
-    vout_display_sys_t *sys = vd->sys;
-    struct wl_display *display = sys->embed->display.wl;
-    struct wl_surface *surface = sys->embed->handle.wl;
-    struct picture_buffer_t *picbuf = pic->p_sys;
+    assert(d->picture == NULL);
+    wl_buffer_destroy(d->buffer);
+    vlc_close(d->fd);
+    d->buffer = NULL;
+}
 
-    if (picbuf->fd == -1)
-        return;
+static void BuffersFlush(vout_display_sys_t *sys)
+{
+    for (size_t i = 0; i < MAX_BUFFERS; i++)
+    {
+        struct buffer_data *d = &sys->buffers[i];
 
-    struct buffer_data *d = malloc(sizeof (*d));
-    if (unlikely(d == NULL))
-        return;
+        if (d->buffer != NULL && d->picture == NULL)
+            BufferDestroy(d);
+    }
+}
 
-    d->picture = pic;
-    d->counter = &sys->active_buffers;
+static struct buffer_data *BufferGet(vout_display_t *vd, picture_t *pic)
+{
+    vout_display_sys_t *sys = vd->sys;
+    struct picture_buffer_t *picbuf = pic->p_sys;
+    struct stat st;
+
+    if (fstat(picbuf->fd, &st))
+        return NULL;
 
     off_t offset = picbuf->offset;
     const size_t stride = pic->p->i_pitch;
     const size_t size = pic->p->i_lines * stride;
-    struct wl_shm_pool *pool;
-    struct wl_buffer *buf;
-
-    pool = wl_shm_create_pool(sys->shm, picbuf->fd, offset + size);
-    if (pool == NULL)
-    {
-        free(d);
-        return;
-    }
+    const off_t pool_size = offset + size;
 
     if (sys->viewport == NULL) /* Poor man's crop */
         offset += 4 * vd->fmt.i_x_offset
                   + pic->p->i_pitch * vd->fmt.i_y_offset;
 
-    buf = wl_shm_pool_create_buffer(pool, offset, vd->fmt.i_visible_width,
-                                    vd->fmt.i_visible_height, stride,
-                                    WL_SHM_FORMAT_XRGB8888);
+    const unsigned width = vd->fmt.i_visible_width;
+    const unsigned height = vd->fmt.i_visible_height;
+    struct buffer_data *d = NULL;
+
+    for (size_t i = 0; i < MAX_BUFFERS; i++)
+    {
+        struct buffer_data *e = &sys->buffers[i];
+
+        if (e->buffer == NULL)
+        {
+            if (d == NULL || d->buffer != NULL)
+                d = e;
+            continue;
+        }
+        if (e->picture != NULL)
+            continue; /* still in use by the server */
+
+        if (e->dev == st.st_dev && e->ino == st.st_ino
+         && e->offset == offset && e->stride == stride
+         && e->width == width && e->height == height)
+            return e;
+
+        if (d == NULL || d->buffer != NULL)
+            d = e; /* least preferable: evict an idle buffer */
+    }
+
+    if (d == NULL)
+    {   /* The server holds all cached buffers. */
+        msg_Warn(vd, "too many active buffers");
+        return NULL;
+    }
+
+    int fd = vlc_dup(picbuf->fd);
+    if (fd == -1)
+        return NULL;
+
+    struct wl_shm_pool *pool = wl_shm_create_pool(sys->shm, fd, pool_size);
+    if (pool == NULL)
+    {
+        vlc_close(fd);
+        return NULL;
+    }
+
+    struct wl_buffer *buf = wl_shm_pool_create_buffer(pool, offset,
+                                                      width, height, stride,
+                                                      WL_SHM_FORMAT_XRGB8888);
     wl_shm_pool_destroy(pool);
     if (buf == NULL)
     {
-        free(d);
-        return;
+        vlc_close(fd);
+        return NULL;
     }
 
-    picture_Hold(pic);
+    if (d->buffer != NULL)
+        BufferDestroy(d);
 
+    d->buffer = buf;
+    d->picture = NULL;
+    d->counter = &sys->active_buffers;
+    d->fd = fd;
+    d->dev = st.st_dev;
+    d->ino = st.st_ino;
+    d->offset = offset;
+    d->width = width;
+    d->height = height;
+    d->stride = stride;
     wl_buffer_add_listener(buf, &buffer_cbs, d);
-    wl_surface_attach(surface, buf, 0, 0);
-    wl_surface_damage(surface, 0, 0, sys->display_width, sys->display_height);
+    return d;
+}
+
+static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
+                    vlc_tick_t date)
+{
+    VLC_UNUSED(date);
+    vout_display_sys_t *sys = vd->sys;
+    struct wl_display *display = sys->embed->display.wl;
+    struct wl_surface *surface = sys->embed->handle.wl;
+    struct picture_buffer_t *picbuf = pic->p_sys;
+
+    if (picbuf->fd == -1)
+        return;
+
+    struct buffer_data *d = BufferGet(vd, pic);
+    if (d == NULL)
+        return;
+
+    d->picture = picture_Hold(pic);
+
+    wl_surface_attach(surface, d->buffer, 0, 0);
+    if (sys->damage_buffer)
+        wl_surface_damage_buffer(surface, 0, 0, d->width, d->height);
+    else
+        wl_surface_damage(surface, 0, 0,
+                          sys->display_width, sys->display_height);
     wl_display_flush(display);
 
     sys->active_buffers++;
@@ -147,7 +242,23 @@ static void Display(vout_display_t *vd, picture_t *pic)
     struct wl_surface *surface = sys->embed->handle.wl;
 
     wl_surface_commit(surface);
-    wl_display_roundtrip_queue(display, sys->eventq);
+
+    /* Process the buffer releases received so far, without waiting. */
+    while (wl_display_prepare_read_queue(display, sys->eventq) != 0)
+        wl_display_dispatch_queue_pending(display, sys->eventq);
+    wl_display_flush(display);
+
+    struct pollfd ufd = { .fd = wl_display_get_fd(display), .events = POLLIN };
+
+    if (poll(&ufd, 1, 0) > 0)
+        wl_display_read_events(display);
+    else
+        wl_display_cancel_read(display);
+    wl_display_dispatch_queue_pending(display, sys->eventq);
+
+    /* Only wait if the server lags behind, or the pool would run dry. */
+    if (sys->active_buffers > MAX_ACTIVE_BUFFERS)
+        wl_display_roundtrip_queue(display, sys->eventq);
 
     (void) pic;
 }
@@ -166,6 +277,9 @@ static int Control(vout_display_t *vd, int query, va_list ap)
             video_format_t src;
             assert(sys->viewport == NULL);
 
+            /* The cached buffers would never match again */
+            BuffersFlush(sys);
+
             vout_display_PlacePicture(&place, &vd->source, cfg);
             video_format_ApplyRotation(&src, &vd->source);
 
@@ -253,6 +367,7 @@ static void Close(vout_display_t *vd)
         wl_display_roundtrip_queue(display, sys->eventq);
     }
     msg_Dbg(vd, "no active buffers left");
+    BuffersFlush(sys);
 
     if (sys->viewport != NULL)
         wp_viewport_destroy(sys->viewport);
@@ -279,6 +394,8 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     sys->eventq = NULL;
     sys->shm = NULL;
     sys->active_buffers = 0;
+    for (size_t i = 0; i < MAX_BUFFERS; i++)
+        sys->buffers[i].buffer = NULL;
     sys->display_width = cfg->display.width;
     sys->display_height = cfg->display.height;
 
@@ -314,6 +431,9 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     else
         sys->viewport = NULL;
 
+    sys->damage_buffer = wl_proxy_get_version((struct wl_proxy *)surface)
+                         >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+
     /* Determine our pixel format */
     static const enum wl_output_transform transforms[8] = {
         [ORIENT_TOP_LEFT] = WL_OUTPUT_TRANSFORM_NORMAL,
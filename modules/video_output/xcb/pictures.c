@@ -29,11 +29,14 @@
 #include <errno.h>
 
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include <xcb/xcb.h>
 #include <xcb/shm.h>
 
 #include <vlc_common.h>
+#include <vlc_fs.h>
 
 #include "pictures.h"
 
@@ -170,3 +173,211 @@ fail:
     msg_Warn(obj, "display will be slow");
     return false;
 }
+
+#define VLC_XCB_SHM_BUFFERS 3
+
+struct vlc_xcb_shm
+{
+    vlc_object_t *obj;
+    xcb_connection_t *conn;
+    uint8_t event_base;
+    unsigned next;
+    struct vlc_xcb_shm_buffer buffers[VLC_XCB_SHM_BUFFERS];
+};
+
+vlc_xcb_shm_t *vlc_xcb_shm_Create(vlc_object_t *obj, xcb_connection_t *conn)
+{
+    if (!XCB_shm_Check(obj, conn))
+        return NULL;
+
+    const xcb_query_extension_reply_t *ext =
+        xcb_get_extension_data(conn, &xcb_shm_id);
+    if (ext == NULL || !ext->present)
+        return NULL;
+
+    vlc_xcb_shm_t *shm = malloc(sizeof (*shm));
+    if (unlikely(shm == NULL))
+        return NULL;
+
+    shm->obj = obj;
+    shm->conn = conn;
+    shm->event_base = ext->first_event;
+    shm->next = 0;
+    for (unsigned i = 0; i < VLC_XCB_SHM_BUFFERS; i++)
+    {
+        struct vlc_xcb_shm_buffer *buf = &shm->buffers[i];
+
+        buf->segment = 0;
+        buf->base = NULL;
+        buf->size = 0;
+        buf->busy = false;
+    }
+    return shm;
+}
+
+static void vlc_xcb_shm_Free(vlc_xcb_shm_t *shm,
+                             struct vlc_xcb_shm_buffer *buf)
+{
+    if (buf->base == NULL)
+        return;
+
+    xcb_shm_detach(shm->conn, buf->segment);
+    munmap(buf->base, buf->size);
+    buf->base = NULL;
+    buf->size = 0;
+}
+
+static int vlc_xcb_shm_Alloc(vlc_xcb_shm_t *shm,
+                             struct vlc_xcb_shm_buffer *buf, size_t size)
+{
+    int fd = vlc_memfd();
+    if (fd == -1)
+        return -1;
+
+    if (ftruncate(fd, size))
+    {
+        vlc_close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        vlc_close(fd);
+        return -1;
+    }
+
+    /* XCB closes the file descriptor once sent */
+    xcb_shm_seg_t segment = xcb_generate_id(shm->conn);
+    xcb_void_cookie_t c = xcb_shm_attach_fd_checked(shm->conn, segment, fd, 1);
+    xcb_generic_error_t *e = xcb_request_check(shm->conn, c);
+    if (e != NULL) /* attach failure (likely remote access) */
+    {
+        msg_Dbg(shm->obj, "cannot attach shared memory segment");
+        free(e);
+        munmap(base, size);
+        return -1;
+    }
+
+    buf->segment = segment;
+    buf->base = base;
+    buf->size = size;
+    return 0;
+}
+
+void vlc_xcb_shm_Destroy(vlc_xcb_shm_t *shm)
+{
+    for (unsigned i = 0; i < VLC_XCB_SHM_BUFFERS; i++)
+        vlc_xcb_shm_Free(shm, &shm->buffers[i]);
+    free(shm);
+}
+
+static bool vlc_xcb_shm_HandleEvent(vlc_xcb_shm_t *shm,
+                                    const xcb_generic_event_t *ev)
+{
+    if ((ev->response_type & 0x7f) == shm->event_base + XCB_SHM_COMPLETION)
+    {
+        const xcb_shm_completion_event_t *ce =
+            (const xcb_shm_completion_event_t *)ev;
+
+        for (unsigned i = 0; i < VLC_XCB_SHM_BUFFERS; i++)
+            if (shm->buffers[i].segment == ce->shmseg)
+                shm->buffers[i].busy = false;
+        return true;
+    }
+
+    if (ev->response_type == 0)
+    {   /* A failed upload never completes */
+        const xcb_generic_error_t *err = (const xcb_generic_error_t *)ev;
+
+        for (unsigned i = 0; i < VLC_XCB_SHM_BUFFERS; i++)
+        {
+            struct vlc_xcb_shm_buffer *buf = &shm->buffers[i];
+
+            if (buf->busy && buf->sequence == err->full_sequence)
+            {
+                msg_Err(shm->obj, "%s: X11 error %d", "cannot put image",
+                        err->error_code);
+                buf->busy = false;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void vlc_xcb_shm_ProcessEvent(vlc_xcb_shm_t *shm,
+                                     xcb_generic_event_t *ev)
+{
+    if (!vlc_xcb_shm_HandleEvent(shm, ev))
+        switch (ev->response_type & 0x7f)
+        {
+            case 0:
+                msg_Err(shm->obj, "X11 error %d",
+                        ((xcb_generic_error_t *)ev)->error_code);
+                break;
+
+            case XCB_MAPPING_NOTIFY:
+                break;
+
+            default:
+                msg_Dbg(shm->obj, "unhandled event %"PRIu8, ev->response_type);
+        }
+    free(ev);
+}
+
+void vlc_xcb_shm_Manage(vlc_xcb_shm_t *shm)
+{
+    xcb_generic_event_t *ev;
+
+    while ((ev = xcb_poll_for_event(shm->conn)) != NULL)
+        vlc_xcb_shm_ProcessEvent(shm, ev);
+}
+
+struct vlc_xcb_shm_buffer *vlc_xcb_shm_Get(vlc_xcb_shm_t *shm, size_t size)
+{
+    struct vlc_xcb_shm_buffer *buf = &shm->buffers[shm->next];
+
+    vlc_xcb_shm_Manage(shm);
+    if (buf->busy)
+    {   /* All the segments are in flight: wait for the oldest one */
+        xcb_flush(shm->conn);
+        do
+        {
+            xcb_generic_event_t *ev = xcb_wait_for_event(shm->conn);
+            if (ev == NULL)
+                return NULL; /* connection failure */
+            vlc_xcb_shm_ProcessEvent(shm, ev);
+        }
+        while (buf->busy);
+    }
+
+    if (buf->size != size)
+    {
+        vlc_xcb_shm_Free(shm, buf);
+        if (vlc_xcb_shm_Alloc(shm, buf, size))
+            return NULL;
+    }
+    return buf;
+}
+
+void vlc_xcb_shm_PutImage(vlc_xcb_shm_t *shm, struct vlc_xcb_shm_buffer *buf,
+                          xcb_drawable_t drawable, xcb_gcontext_t gc,
+                          uint16_t total_width, uint16_t total_height,
+                          int16_t src_x, int16_t src_y,
+                          uint16_t width, uint16_t height,
+                          int16_t dst_x, int16_t dst_y, uint8_t depth)
+{
+    assert(buf == &shm->buffers[shm->next]);
+    assert(!buf->busy);
+
+    xcb_void_cookie_t ck = xcb_shm_put_image(shm->conn, drawable, gc,
+                                             total_width, total_height,
+                                             src_x, src_y, width, height,
+                                             dst_x, dst_y, depth,
+                                             XCB_IMAGE_FORMAT_Z_PIXMAP, 1,
+                                             buf->segment, 0);
+    buf->sequence = ck.sequence;
+    buf->busy = true;
+    shm->next = (shm->next + 1) % VLC_XCB_SHM_BUFFERS;
+}
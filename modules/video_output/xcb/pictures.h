@@ -37,3 +37,51 @@ bool vlc_xcb_VisualToFormat(const xcb_setup_t *, uint_fast8_t depth,
                             const xcb_visualtype_t *, video_format_t *);
 
 bool XCB_shm_Check (vlc_object_t *obj, xcb_connection_t *conn);
+
+/**
+ * Ring of MIT-SHM segments, attached once, to upload pictures without
+ * waiting for the X server: each upload requests a completion event, and a
+ * segment is reused only once the X server is done reading it.
+ */
+typedef struct vlc_xcb_shm vlc_xcb_shm_t;
+
+struct vlc_xcb_shm_buffer
+{
+    uint32_t segment; /**< xcb_shm_seg_t */
+    void *base;
+    size_t size;
+    unsigned sequence; /**< of the pending upload request */
+    bool busy; /**< until the upload completes */
+};
+
+/**
+ * Checks the MIT-SHM extension and creates a ring of segments.
+ *
+ * \return the ring or NULL if shared memory is not usable
+ */
+vlc_xcb_shm_t *vlc_xcb_shm_Create(vlc_object_t *obj, xcb_connection_t *conn);
+void vlc_xcb_shm_Destroy(vlc_xcb_shm_t *);
+
+/**
+ * Gets an idle segment of at least the given size, waiting for the
+ * completion of an earlier upload if needed.
+ *
+ * \return a segment, or NULL on error (e.g. remote X server): the ring
+ * should then be destroyed, and the pictures uploaded without it
+ */
+struct vlc_xcb_shm_buffer *vlc_xcb_shm_Get(vlc_xcb_shm_t *, size_t size);
+
+/**
+ * Uploads the content of a segment (see xcb_shm_put_image()).
+ */
+void vlc_xcb_shm_PutImage(vlc_xcb_shm_t *, struct vlc_xcb_shm_buffer *,
+                          xcb_drawable_t, xcb_gcontext_t,
+                          uint16_t total_width, uint16_t total_height,
+                          int16_t src_x, int16_t src_y,
+                          uint16_t width, uint16_t height,
+                          int16_t dst_x, int16_t dst_y, uint8_t depth);
+
+/**
+ * Processes the pending X11 events, including upload completions.
+ */
+void vlc_xcb_shm_Manage(vlc_xcb_shm_t *);
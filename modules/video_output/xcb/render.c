@@ -32,11 +32,9 @@
 
 #include <xcb/xcb.h>
 #include <xcb/render.h>
-#include <xcb/shm.h>
 
 #include <vlc_common.h>
 #include <vlc_charset.h>
-#include <vlc_fs.h>
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
 
@@ -68,7 +66,7 @@ struct vout_display_sys_t {
     } format;
 
     xcb_gcontext_t gc;
-    xcb_shm_seg_t segment;
+    vlc_xcb_shm_t *shm; /**< shared memory segments, or NULL */
     xcb_window_t root;
     char *filter;
 
@@ -76,38 +74,49 @@ struct vout_display_sys_t {
     int32_t src_x;
     int32_t src_y;
     vlc_fourcc_t spu_chromas[2];
+
+    /* size of the subpicture region pixmaps, kept from frame to frame */
+    unsigned subpic_width;
+    unsigned subpic_height;
 };
 
-static size_t PictureAttach(vout_display_t *vd, picture_t *pic)
+static void DeleteRegionBuffers(vout_display_t *vd)
 {
     vout_display_sys_t *sys = vd->sys;
     xcb_connection_t *conn = sys->conn;
-    xcb_shm_seg_t segment = sys->segment;
-    const picture_buffer_t *buf = pic->p_sys;
-
-    if (segment == 0  /* SHM extension not supported */
-     || buf->fd == -1 /* picture buffer not in shared memory */)
-        return -1;
 
-    int fd = vlc_dup(buf->fd);
-    if (fd == -1)
-        return -1;
+    if (sys->subpic_width == 0)
+        return;
 
-    xcb_void_cookie_t c = xcb_shm_attach_fd_checked(conn, segment, fd, 1);
-    xcb_generic_error_t *e = xcb_request_check(conn, c);
-    if (e != NULL) /* attach failure (likely remote access) */
-    {
-        free(e);
-        return -1;
-    }
-    return buf->offset;
+    xcb_render_free_picture(conn, sys->picture.alpha);
+    xcb_render_free_picture(conn, sys->picture.subpic);
+    xcb_free_pixmap(conn, sys->drawable.alpha);
+    xcb_free_pixmap(conn, sys->drawable.subpic);
+    sys->subpic_width = sys->subpic_height = 0;
 }
 
-static void PictureDetach(vout_display_t *vd)
+/**
+ * (Re)creates the region pixmaps and pictures, unless the previous region
+ * had the same size. */
+static void CreateRegionBuffers(vout_display_t *vd, unsigned sw, unsigned sh)
 {
     vout_display_sys_t *sys = vd->sys;
+    xcb_connection_t *conn = sys->conn;
+
+    /* The pixmaps must have the exact region size: the area outside the
+     * source picture is transparent when compositing. */
+    if (sys->subpic_width == sw && sys->subpic_height == sh)
+        return;
 
-    xcb_shm_detach(sys->conn, sys->segment);
+    DeleteRegionBuffers(vd);
+    xcb_create_pixmap(conn, 32, sys->drawable.subpic, sys->root, sw, sh);
+    xcb_create_pixmap(conn, 8, sys->drawable.alpha, sys->root, sw, sh);
+    xcb_render_create_picture(conn, sys->picture.subpic, sys->drawable.subpic,
+                              sys->format.argb, 0, NULL);
+    xcb_render_create_picture(conn, sys->picture.alpha, sys->drawable.alpha,
+                              sys->format.alpha, 0, NULL);
+    sys->subpic_width = sw;
+    sys->subpic_height = sh;
 }
 
 static void RenderRegion(vout_display_t *vd, const subpicture_t *subpic,
@@ -121,12 +130,7 @@ static void RenderRegion(vout_display_t *vd, const subpicture_t *subpic,
     unsigned sh = reg->fmt.i_height;
     xcb_rectangle_t rects[] = { { 0, 0, sw, sh }, };
 
-    xcb_create_pixmap(conn, 32, sys->drawable.subpic, sys->root, sw, sh);
-    xcb_create_pixmap(conn, 8, sys->drawable.alpha, sys->root, sw, sh);
-    xcb_render_create_picture(conn, sys->picture.subpic, sys->drawable.subpic,
-                              sys->format.argb, 0, NULL);
-    xcb_render_create_picture(conn, sys->picture.alpha, sys->drawable.alpha,
-                              sys->format.alpha, 0, NULL);
+    CreateRegionBuffers(vd, sw, sh);
 
     /* Upload region (TODO: use FD passing for SPU?) */
     xcb_put_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP, sys->drawable.subpic,
@@ -173,11 +177,6 @@ static void RenderRegion(vout_display_t *vd, const subpicture_t *subpic,
     xcb_render_composite(conn, XCB_RENDER_PICT_OP_OVER,
                          sys->picture.subpic, sys->picture.alpha,
                          sys->picture.scale, 0, 0, 0, 0, dx, dy, dw, dh);
-
-    xcb_render_free_picture(conn, sys->picture.alpha);
-    xcb_render_free_picture(conn, sys->picture.subpic);
-    xcb_free_pixmap(conn, sys->drawable.alpha);
-    xcb_free_pixmap(conn, sys->drawable.subpic);
 }
 
 static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
@@ -187,14 +186,26 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
     vout_display_sys_t *sys = vd->sys;
     xcb_connection_t *conn = sys->conn;
 
-    size_t offset = PictureAttach(vd, pic);
-    if (offset != (size_t)-1) {
-        xcb_shm_put_image(conn, sys->drawable.source, sys->gc,
-                          pic->p->i_pitch / pic->p->i_pixel_pitch,
-                          pic->p->i_lines, 0, 0,
-                          pic->p->i_pitch / pic->p->i_pixel_pitch,
-                          pic->p->i_lines, 0, 0, 32, XCB_IMAGE_FORMAT_Z_PIXMAP,
-                          0, sys->segment, offset);
+    /* Upload through an idle segment of the ring: no round trip to attach
+     * the picture buffer, and no waiting for the X server to read it. */
+    size_t size = pic->p->i_pitch * pic->p->i_lines;
+    struct vlc_xcb_shm_buffer *buf = NULL;
+
+    if (sys->shm != NULL) {
+        buf = vlc_xcb_shm_Get(sys->shm, size);
+        if (buf == NULL) {
+            msg_Warn(vd, "cannot use shared memory, display will be slow");
+            vlc_xcb_shm_Destroy(sys->shm);
+            sys->shm = NULL;
+        }
+    }
+    if (buf != NULL) {
+        memcpy(buf->base, pic->p->p_pixels, size);
+        vlc_xcb_shm_PutImage(sys->shm, buf, sys->drawable.source, sys->gc,
+                             pic->p->i_pitch / pic->p->i_pixel_pitch,
+                             pic->p->i_lines, 0, 0,
+                             pic->p->i_pitch / pic->p->i_pixel_pitch,
+                             pic->p->i_lines, 0, 0, 32);
     } else {
         xcb_put_image(conn, XCB_IMAGE_FORMAT_Z_PIXMAP, sys->drawable.source,
                       sys->gc, pic->p->i_pitch / pic->p->i_pixel_pitch,
@@ -225,8 +236,6 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
                          sys->picture.scale, sys->src_x, sys->src_y, 0, 0,
                          sys->place.x, sys->place.y,
                          sys->place.width, sys->place.height);
-    if (offset != (size_t)-1)
-        PictureDetach(vd);
 
     /* Blend subpictures */
     if (subpic != NULL)
@@ -242,13 +251,28 @@ static void Display(vout_display_t *vd, picture_t *pic)
 {
     vout_display_sys_t *sys = vd->sys;
     xcb_connection_t *conn = sys->conn;
-    xcb_void_cookie_t ck;
 
+    if (sys->shm != NULL)
+        vlc_xcb_shm_Manage(sys->shm);
     vlc_xcb_Manage(vd, conn);
 
     /* Copy the scaled picture into the target picture, in other words
      * copy the rendered pixmap into the window.
      */
+    if (sys->shm != NULL) {
+        /* Errors are reported as events. The segment ring throttles. */
+        xcb_render_composite(conn, XCB_RENDER_PICT_OP_SRC,
+                             sys->picture.scale, XCB_RENDER_PICTURE_NONE,
+                             sys->picture.dest, 0, 0, 0, 0, 0, 0,
+                             vd->cfg->display.width,
+                             vd->cfg->display.height);
+        xcb_flush(conn);
+        (void) pic;
+        return;
+    }
+
+    xcb_void_cookie_t ck;
+
     ck = xcb_render_composite_checked(conn, XCB_RENDER_PICT_OP_SRC,
                                       sys->picture.scale,
                                       XCB_RENDER_PICTURE_NONE,
@@ -417,6 +441,8 @@ static void Close(vout_display_t *vd)
 {
     vout_display_sys_t *sys = vd->sys;
 
+    if (sys->shm != NULL)
+        vlc_xcb_shm_Destroy(sys->shm);
     free(sys->filter);
     xcb_disconnect(sys->conn);
 }
@@ -646,10 +672,9 @@ static int Open(vout_display_t *vd, const vout_display_cfg_t *cfg,
     sys->picture.dest = xcb_generate_id(conn);
     sys->gc = xcb_generate_id(conn);
 
-    if (XCB_shm_Check(obj, conn))
-        sys->segment = xcb_generate_id(conn);
-    else
-        sys->segment = 0;
+    sys->shm = vlc_xcb_shm_Create(obj, conn);
+    sys->subpic_width = 0;
+    sys->subpic_height = 0;
 
     xcb_colormap_t cmap = xcb_generate_id(conn);
     uint32_t cw_mask =
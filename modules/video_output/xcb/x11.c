@@ -25,13 +25,12 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include <xcb/xcb.h>
-#include <xcb/shm.h>
 
 #include <vlc_common.h>
-#include <vlc_fs.h>
 #include <vlc_plugin.h>
 #include <vlc_vout_display.h>
 
@@ -44,8 +43,8 @@ struct vout_display_sys_t
 
     xcb_window_t window; /* drawable X window */
     xcb_gcontext_t gc; /* context to put images */
-    xcb_shm_seg_t segment; /**< shared memory segment XID */
-    bool attached;
+    vlc_xcb_shm_t *shm; /**< shared memory segments, or NULL */
+    struct vlc_xcb_shm_buffer *buffer; /**< prepared segment */
     uint8_t depth; /* useful bits per pixel */
     video_format_t fmt;
 };
@@ -54,29 +53,27 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic,
                     vlc_tick_t date)
 {
     vout_display_sys_t *sys = vd->sys;
-    const picture_buffer_t *buf = pic->p_sys;
-    xcb_connection_t *conn = sys->conn;
 
-    sys->attached = false;
+    sys->buffer = NULL;
 
-    if (sys->segment == 0)
+    if (sys->shm == NULL)
         return; /* SHM extension not supported */
-    if (buf->fd == -1)
-        return; /* not a shareable picture buffer */
-
-    int fd = vlc_dup(buf->fd);
-    if (fd == -1)
-        return;
 
-    xcb_void_cookie_t c = xcb_shm_attach_fd_checked(conn, sys->segment, fd, 1);
-    xcb_generic_error_t *e = xcb_request_check(conn, c);
-    if (e != NULL) /* attach failure (likely remote access) */
+    /* Copy the picture into an idle segment of the ring, rather than
+     * attaching the picture buffer and waiting for the X server to read it
+     * before the picture can be released. */
+    size_t size = pic->p->i_pitch * pic->p->i_lines;
+    struct vlc_xcb_shm_buffer *buf = vlc_xcb_shm_Get(sys->shm, size);
+    if (buf == NULL)
     {
-        free(e);
+        msg_Warn(vd, "cannot use shared memory, display will be slow");
+        vlc_xcb_shm_Destroy(sys->shm);
+        sys->shm = NULL;
         return;
     }
 
-    sys->attached = true;
+    memcpy(buf->base, pic->p->p_pixels, size);
+    sys->buffer = buf;
     (void) subpic; (void) date;
 }
 
@@ -87,51 +84,46 @@ static void Display (vout_display_t *vd, picture_t *pic)
 {
     vout_display_sys_t *sys = vd->sys;
     xcb_connection_t *conn = sys->conn;
-    const picture_buffer_t *buf = pic->p_sys;
-    xcb_shm_seg_t segment = sys->segment;
-    xcb_void_cookie_t ck;
 
+    if (sys->shm != NULL)
+        vlc_xcb_shm_Manage(sys->shm);
     vlc_xcb_Manage(vd, sys->conn);
 
-    if (sys->attached)
-        ck = xcb_shm_put_image_checked(conn, sys->window, sys->gc,
+    if (sys->buffer != NULL) {
+        /* The completion event releases the segment: do not wait for it */
+        vlc_xcb_shm_PutImage(sys->shm, sys->buffer, sys->window, sys->gc,
               /* real width */ pic->p->i_pitch / pic->p->i_pixel_pitch,
              /* real height */ pic->p->i_lines,
                        /* x */ sys->fmt.i_x_offset,
                        /* y */ sys->fmt.i_y_offset,
                    /* width */ sys->fmt.i_visible_width,
                   /* height */ sys->fmt.i_visible_height,
-                               0, 0, sys->depth, XCB_IMAGE_FORMAT_Z_PIXMAP,
-                               0, segment, buf->offset);
-    else {
-        const size_t offset = sys->fmt.i_y_offset * pic->p->i_pitch;
-        const unsigned lines = pic->p->i_lines - sys->fmt.i_y_offset;
+                               0, 0, sys->depth);
+        sys->buffer = NULL;
+        xcb_flush(conn);
+        return;
+    }
 
-        ck = xcb_put_image_checked(conn, XCB_IMAGE_FORMAT_Z_PIXMAP,
+    const size_t offset = sys->fmt.i_y_offset * pic->p->i_pitch;
+    const unsigned lines = pic->p->i_lines - sys->fmt.i_y_offset;
+    xcb_void_cookie_t ck;
+
+    ck = xcb_put_image_checked(conn, XCB_IMAGE_FORMAT_Z_PIXMAP,
                                sys->window, sys->gc,
                                pic->p->i_pitch / pic->p->i_pixel_pitch,
                                lines, -sys->fmt.i_x_offset, 0, 0, sys->depth,
                                pic->p->i_pitch * lines,
                                pic->p->p_pixels + offset);
-    }
 
     /* Wait for reply. This makes sure that the X server gets CPU time to
-     * display the picture. xcb_flush() is *not* sufficient: especially
-     * with shared memory the PUT requests are so short that many of them
-     * can fit in X11 socket output buffer before the kernel preempts VLC.
+     * display the picture. xcb_flush() is *not* sufficient: the PUT
+     * requests could pile up in the X11 socket output buffer.
      */
    xcb_generic_error_t *e = xcb_request_check(conn, ck);
    if (e != NULL) {
        msg_Err(vd, "%s: X11 error %d", "cannot put image", e->error_code);
        free(e);
    }
-
-    /* FIXME might be WAY better to wait in some case (be carefull with
-     * VOUT_DISPLAY_RESET_PICTURES if done) + does not work with
-     * vout_display wrapper. */
-
-    if (sys->attached)
-        xcb_shm_detach(conn, segment);
 }
 
 static int Control(vout_display_t *vd, int query, va_list ap)
@@ -199,6 +191,8 @@ static void Close(vout_display_t *vd)
 {
     vout_display_sys_t *sys = vd->sys;
 
+    if (sys->shm != NULL)
+        vlc_xcb_shm_Destroy(sys->shm);
     /* colormap, window and context are garbage-collected by X */
     xcb_disconnect(sys->conn);
     free(sys);
@@ -271,6 +265,8 @@ static int Open (vout_display_t *vd, const vout_display_cfg_t *cfg,
         return VLC_EGENERIC;
     }
     sys->conn = conn;
+    sys->shm = NULL;
+    sys->buffer = NULL;
 
     const xcb_setup_t *setup = xcb_get_setup (conn);
 
@@ -327,10 +323,7 @@ static int Open (vout_display_t *vd, const vout_display_cfg_t *cfg,
     msg_Dbg (vd, "using X11 window %08"PRIx32, sys->window);
     msg_Dbg (vd, "using X11 graphic context %08"PRIx32, sys->gc);
 
-    if (XCB_shm_Check (VLC_OBJECT(vd), conn))
-        sys->segment = xcb_generate_id(conn);
-    else
-        sys->segment = 0;
+    sys->shm = vlc_xcb_shm_Create(VLC_OBJECT(vd), conn);
 
     sys->fmt = *fmtp;
     /* Setup vout_display_t once everything is fine */
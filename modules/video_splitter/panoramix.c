@@ -36,6 +36,8 @@
 #include <vlc_video_splitter.h>
 #include <vlc_vout_window.h>
 
+#include "../video_filter/deinterlace/slices.h"
+
 #define OVERLAP
 
 #ifdef OVERLAP
@@ -252,6 +254,7 @@ typedef struct
 
     /* Filter configuration to use to create the output */
     panoramix_filter_t filter;
+    bool b_crop; /* no borders nor attenuation: the output is a plain crop */
 
 } panoramix_output_t;
 
@@ -290,6 +293,11 @@ typedef struct
     int i_col;
     int i_row;
     panoramix_output_t pp_output[COL_MAX][ROW_MAX]; /* [x][y] */
+
+    /* Outputs that need filtering, rendered in parallel */
+    const panoramix_output_t *pp_filtered[COL_MAX*ROW_MAX];
+    unsigned i_filtered;
+    deinterlace_slices_t slices;
 } video_splitter_sys_t;
 
 /* */
@@ -681,6 +689,20 @@ static int Open( vlc_object_t *p_this )
     }
 
 
+    /* */
+    p_sys->i_filtered = 0;
+    for( int y = 0; y < p_sys->i_row; y++ )
+    {
+        for( int x = 0; x < p_sys->i_col; x++ )
+        {
+            const panoramix_output_t *p_output = &p_sys->pp_output[x][y];
+            if( p_output->b_active && !p_output->b_crop )
+                p_sys->pp_filtered[p_sys->i_filtered++] = p_output;
+        }
+    }
+    SlicesInit( VLC_OBJECT(p_splitter), &p_sys->slices,
+                __MIN( p_sys->i_filtered, vlc_GetCPUCount() ), false );
+
     /* */
     p_splitter->pf_filter = Filter;
     p_splitter->mouse = Mouse;
@@ -696,10 +718,78 @@ static void Close( vlc_object_t *p_this )
     video_splitter_t *p_splitter = (video_splitter_t*)p_this;
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
 
+    SlicesClean( &p_sys->slices );
     free( p_splitter->p_output );
     free( p_sys );
 }
 
+/**
+ * It renders one output from the source picture
+ */
+static void RenderOutput( video_splitter_sys_t *p_sys,
+                          const panoramix_output_t *p_output,
+                          picture_t *p_dst, const picture_t *p_src )
+{
+    for( int i_plane = 0; i_plane < p_src->i_planes; i_plane++ )
+    {
+        const int i_div_w = p_sys->p_chroma->pi_div_w[i_plane];
+        const int i_div_h = p_sys->p_chroma->pi_div_h[i_plane];
+
+        if( !i_div_w || !i_div_h )
+            continue;
+
+        const plane_t *p_srcp = &p_src->p[i_plane];
+        const plane_t *p_dstp = &p_dst->p[i_plane];
+
+        /* */
+        panoramix_filter_t filter;
+        filter.black.i_right  = p_output->filter.black.i_right / i_div_w;
+        filter.black.i_left   = p_output->filter.black.i_left / i_div_w;
+        filter.black.i_top    = p_output->filter.black.i_top / i_div_h;
+        filter.black.i_bottom = p_output->filter.black.i_bottom / i_div_h;
+
+        filter.attenuate.i_right  = p_output->filter.attenuate.i_right / i_div_w;
+        filter.attenuate.i_left   = p_output->filter.attenuate.i_left / i_div_w;
+        filter.attenuate.i_top    = p_output->filter.attenuate.i_top / i_div_h;
+        filter.attenuate.i_bottom = p_output->filter.attenuate.i_bottom / i_div_h;
+
+        /* */
+        const int i_x = p_output->i_src_x/i_div_w;
+        const int i_y = p_output->i_src_y/i_div_h;
+
+        assert( p_sys->p_chroma->b_planar );
+        FilterPlanar( p_dstp->p_pixels, p_dstp->i_pitch,
+                      &p_srcp->p_pixels[i_y * p_srcp->i_pitch + i_x * p_srcp->i_pixel_pitch], p_srcp->i_pitch,
+                      p_output->i_src_width/i_div_w, p_output->i_src_height/i_div_h,
+                      p_sys->p_chroma->pi_black[i_plane],
+                      &filter,
+                      p_sys->p_lut[i_plane],
+                      p_sys->lambdav[i_plane],
+                      p_sys->lambdah[i_plane] );
+    }
+}
+
+typedef struct
+{
+    video_splitter_sys_t *p_sys;
+    picture_t **pp_dst;
+    const picture_t *p_src;
+} panoramix_job_t;
+
+static void RenderSlice( void *p_opaque, unsigned i_slice, unsigned i_slices )
+{
+    const panoramix_job_t *p_job = p_opaque;
+    video_splitter_sys_t *p_sys = p_job->p_sys;
+
+    for( unsigned i = i_slice; i < p_sys->i_filtered; i += i_slices )
+    {
+        const panoramix_output_t *p_output = p_sys->pp_filtered[i];
+
+        RenderOutput( p_sys, p_output, p_job->pp_dst[p_output->i_output],
+                      p_job->p_src );
+    }
+}
+
 /**
  * It creates multiples pictures from the source one
  */
@@ -707,11 +797,8 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
 {
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
 
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
-    {
-        picture_Release( p_src );
-        return VLC_EGENERIC;
-    }
+    for( int i = 0; i < p_splitter->i_output; i++ )
+        pp_dst[i] = NULL;
 
     for( int y = 0; y < p_sys->i_row; y++ )
     {
@@ -721,53 +808,41 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
             if( !p_output->b_active )
                 continue;
 
-            /* */
-            picture_t *p_dst = pp_dst[p_output->i_output];
-
-            /* */
-            picture_CopyProperties( p_dst, p_src );
-
-            /* */
-            for( int i_plane = 0; i_plane < p_src->i_planes; i_plane++ )
+            /* Crop-only outputs reference the source pixels */
+            picture_t *p_dst;
+            if( p_output->b_crop )
+                p_dst = video_splitter_NewView( p_splitter, p_output->i_output,
+                                                p_src, p_output->i_src_x,
+                                                p_output->i_src_y );
+            else
             {
-                const int i_div_w = p_sys->p_chroma->pi_div_w[i_plane];
-                const int i_div_h = p_sys->p_chroma->pi_div_h[i_plane];
-
-                if( !i_div_w || !i_div_h )
-                    continue;
+                p_dst = picture_NewFromFormat(
+                            &p_splitter->p_output[p_output->i_output].fmt );
+                if( p_dst != NULL )
+                    picture_CopyProperties( p_dst, p_src );
+            }
 
-                const plane_t *p_srcp = &p_src->p[i_plane];
-                const plane_t *p_dstp = &p_dst->p[i_plane];
-
-                /* */
-                panoramix_filter_t filter;
-                filter.black.i_right  = p_output->filter.black.i_right / i_div_w;
-                filter.black.i_left   = p_output->filter.black.i_left / i_div_w;
-                filter.black.i_top    = p_output->filter.black.i_top / i_div_h;
-                filter.black.i_bottom = p_output->filter.black.i_bottom / i_div_h;
-
-                filter.attenuate.i_right  = p_output->filter.attenuate.i_right / i_div_w;
-                filter.attenuate.i_left   = p_output->filter.attenuate.i_left / i_div_w;
-                filter.attenuate.i_top    = p_output->filter.attenuate.i_top / i_div_h;
-                filter.attenuate.i_bottom = p_output->filter.attenuate.i_bottom / i_div_h;
-
-                /* */
-                const int i_x = p_output->i_src_x/i_div_w;
-                const int i_y = p_output->i_src_y/i_div_h;
-
-                assert( p_sys->p_chroma->b_planar );
-                FilterPlanar( p_dstp->p_pixels, p_dstp->i_pitch,
-                              &p_srcp->p_pixels[i_y * p_srcp->i_pitch + i_x * p_srcp->i_pixel_pitch], p_srcp->i_pitch,
-                              p_output->i_src_width/i_div_w, p_output->i_src_height/i_div_h,
-                              p_sys->p_chroma->pi_black[i_plane],
-                              &filter,
-                              p_sys->p_lut[i_plane],
-                              p_sys->lambdav[i_plane],
-                              p_sys->lambdah[i_plane] );
+            if( p_dst == NULL )
+            {
+                for( int i = 0; i < p_splitter->i_output; i++ )
+                    if( pp_dst[i] != NULL )
+                        picture_Release( pp_dst[i] );
+                picture_Release( p_src );
+                msg_Warn( p_splitter, "can't get output pictures" );
+                return VLC_EGENERIC;
             }
+            pp_dst[p_output->i_output] = p_dst;
         }
     }
 
+    panoramix_job_t job = {
+        .p_sys = p_sys,
+        .pp_dst = pp_dst,
+        .p_src = p_src,
+    };
+    if( p_sys->i_filtered > 0 )
+        SlicesRun( &p_sys->slices, RenderSlice, &job );
+
     picture_Release( p_src );
     return VLC_SUCCESS;
 }
@@ -901,6 +976,10 @@ static int Configuration( panoramix_output_t pp_output[ROW_MAX][COL_MAX],
 
             /* */
             p_output->filter = cfg;
+            p_output->b_crop = !cfg.black.i_left && !cfg.black.i_right &&
+                               !cfg.black.i_top && !cfg.black.i_bottom &&
+                               !cfg.attenuate.i_left && !cfg.attenuate.i_right &&
+                               !cfg.attenuate.i_top && !cfg.attenuate.i_bottom;
 
             /* */
             p_output->i_width  = cfg.black.i_left + p_output->i_src_width  + cfg.black.i_right;
@@ -252,12 +252,8 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
 {
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
 
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
-    {
-        picture_Release( p_src );
-        return VLC_EGENERIC;
-    }
-
+    /* The tiles are plain crops of the source: reference its pixels rather
+     * than copying them */
     for( int y = 0; y < p_sys->i_row; y++ )
     {
         for( int x = 0; x < p_sys->i_col; x++ )
@@ -266,20 +262,19 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
             if( !p_output->b_active )
                 continue;
 
-            picture_t *p_dst = pp_dst[p_output->i_output];
-
-            /* */
-            picture_t tmp = *p_src;
-            for( int i = 0; i < tmp.i_planes; i++ )
+            picture_t *p_dst = video_splitter_NewView( p_splitter,
+                                                       p_output->i_output, p_src,
+                                                       p_output->i_left,
+                                                       p_output->i_top );
+            if( p_dst == NULL )
             {
-                plane_t *p0 = &tmp.p[0];
-                plane_t *p = &tmp.p[i];
-                const int i_y = p_output->i_top  * p->i_visible_pitch / p0->i_visible_pitch;
-                const int i_x = p_output->i_left * p->i_visible_lines / p0->i_visible_lines;
-
-                p->p_pixels += i_y * p->i_pitch + ( i_x - (i_x % p->i_pixel_pitch));
+                for( int i = 0; i < p_output->i_output; i++ )
+                    picture_Release( pp_dst[i] );
+                picture_Release( p_src );
+                msg_Warn( p_splitter, "can't get output pictures" );
+                return VLC_EGENERIC;
             }
-            picture_Copy( p_dst, &tmp );
+            pp_dst[p_output->i_output] = p_dst;
         }
     }
 
@@ -355,6 +355,20 @@ static void *Thread( void *p_data )
 
     float height[NB_BANDS] = {0};
 
+    fft_state *p_state = visual_fft_init(); /* internal FFT data */
+    if (!p_state)
+    {
+        msg_Err(p_filter,"unable to initialize FFT transform");
+        return NULL;
+    }
+    DEFINE_WIND_CONTEXT(wind_ctx); /* internal window data */
+    if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &wind_ctx))
+    {
+        msg_Err(p_filter,"unable to initialize FFT window");
+        fft_close(p_state);
+        return NULL;
+    }
+
     while ((block = vlc_queue_DequeueKillable(&p_sys->queue, &p_sys->dead)))
     {
         unsigned win_width, win_height;
@@ -367,9 +381,6 @@ static void *Thread( void *p_data )
         const unsigned xscale[] = {0,1,2,3,4,5,6,7,8,11,15,20,27,
                                    36,47,62,82,107,141,184,255};
 
-        fft_state *p_state = NULL; /* internal FFT data */
-        DEFINE_WIND_CONTEXT(wind_ctx); /* internal window data */
-
         unsigned i, j;
         float p_output[FFT_BUFFER_SIZE];           /* Raw FFT Result  */
         int16_t p_buffer1[FFT_BUFFER_SIZE];        /* Buffer on which we perform
@@ -414,17 +425,6 @@ static void *Thread( void *p_data )
 
             p_buffl++; p_buffs++;
         }
-        p_state = visual_fft_init();
-        if (!p_state)
-        {
-            msg_Err(p_filter,"unable to initialize FFT transform");
-            goto release;
-        }
-        if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &wind_ctx))
-        {
-            msg_Err(p_filter,"unable to initialize FFT window");
-            goto release;
-        }
         p_buffs = p_s16_buff;
         for (i = 0 ; i < FFT_BUFFER_SIZE; i++)
         {
@@ -483,11 +483,11 @@ static void *Thread( void *p_data )
         vlc_gl_Swap(gl);
 
 release:
-        window_close(&wind_ctx);
-        fft_close(p_state);
         vlc_gl_ReleaseCurrent(gl);
         block_Release(block);
     }
 
+    window_close(&wind_ctx);
+    fft_close(p_state);
     return NULL;
 }
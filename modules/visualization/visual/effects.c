@@ -74,6 +74,8 @@ typedef struct spectrum_data
     int16_t *p_prev_s16_buff;
 
     window_param wind_param;
+    fft_state *p_state;             /* internal FFT data */
+    window_context wind_ctx;        /* internal window data */
 } spectrum_data;
 
 static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
@@ -104,7 +106,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const int *xscale;
 
     fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
 
     int i , j , y , k;
     int i_line;
@@ -137,6 +138,8 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->p_prev_s16_buff = NULL;
 
         window_get_param( p_aout, &p_data->wind_param );
+        p_data->p_state = NULL;
+        p_data->wind_ctx = (window_context){ NULL, 0 };
     }
     peaks = (int *)p_data->peaks;
     prev_heights = (int *)p_data->prev_heights;
@@ -185,20 +188,27 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
+    /* The transform tables and the window only depend on the parameters */
+    if( p_data->p_state == NULL )
     {
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
+        p_data->p_state = visual_fft_init();
+        if( !p_data->p_state )
+        {
+            free( height );
+            msg_Err(p_aout,"unable to initialize FFT transform");
+            return -1;
+        }
+        if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param,
+                          &p_data->wind_ctx ) )
+        {
+            fft_close( p_data->p_state );
+            p_data->p_state = NULL;
+            free( height );
+            msg_Err(p_aout,"unable to initialize FFT window");
+            return -1;
+        }
     }
+    p_state = p_data->p_state;
     p_buffs = p_s16_buff;
     for ( i = 0 ; i < FFT_BUFFER_SIZE ; i++)
     {
@@ -210,7 +220,7 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
             p_buffs = p_s16_buff;
 
     }
-    window_scale_in_place( p_buffer1, &wind_ctx );
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
     fft_perform( p_buffer1, p_output, p_state);
     for( i = 0; i< FFT_BUFFER_SIZE ; i++ )
         p_dest[i] = p_output[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
@@ -358,10 +368,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -376,6 +382,8 @@ static void spectrum_Free( void *data )
         free( p_data->peaks );
         free( p_data->prev_heights );
         free( p_data->p_prev_s16_buff );
+        window_close( &p_data->wind_ctx );
+        fft_close( p_data->p_state );
         free( p_data );
     }
 }
@@ -392,6 +400,8 @@ typedef struct
     int16_t *p_prev_s16_buff;
 
     window_param wind_param;
+    fft_state *p_state;             /* internal FFT data */
+    window_context wind_ctx;        /* internal window data */
 } spectrometer_data;
 
 static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
@@ -442,7 +452,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const double y_scale =  3.60673760222;  /* (log 256) */
 
     fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
 
     int i , j , k;
     int i_line = 0;
@@ -476,6 +485,8 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->i_prev_nb_samples = 0;
         p_data->p_prev_s16_buff = NULL;
         window_get_param( p_aout, &p_data->wind_param );
+        p_data->p_state = NULL;
+        p_data->wind_ctx = (window_context){ NULL, 0 };
         p_effect->p_data = (void*)p_data;
     }
     peaks = p_data->peaks;
@@ -533,20 +544,27 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
+    /* The transform tables and the window only depend on the parameters */
+    if( p_data->p_state == NULL )
     {
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        free( height );
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
+        p_data->p_state = visual_fft_init();
+        if( !p_data->p_state )
+        {
+            free( height );
+            msg_Err(p_aout,"unable to initialize FFT transform");
+            return -1;
+        }
+        if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param,
+                          &p_data->wind_ctx ) )
+        {
+            fft_close( p_data->p_state );
+            p_data->p_state = NULL;
+            free( height );
+            msg_Err(p_aout,"unable to initialize FFT window");
+            return -1;
+        }
     }
+    p_state = p_data->p_state;
     p_buffs = p_s16_buff;
     for ( i = 0 ; i < FFT_BUFFER_SIZE; i++)
     {
@@ -557,7 +575,7 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
             p_buffs = p_s16_buff;
     }
-    window_scale_in_place( p_buffer1, &wind_ctx );
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
     fft_perform( p_buffer1, p_output, p_state);
     for(i = 0; i < FFT_BUFFER_SIZE; i++)
     {
@@ -855,10 +873,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -872,6 +886,8 @@ static void spectrometer_Free( void *data )
     {
         free( p_data->peaks );
         free( p_data->p_prev_s16_buff );
+        window_close( &p_data->wind_ctx );
+        fft_close( p_data->p_state );
         free( p_data );
     }
 }
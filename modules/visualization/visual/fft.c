@@ -22,9 +22,22 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
 #include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
 #include "fft.h"
 
+#if defined(CAN_COMPILE_SSE2) && defined(HAVE_SSE2_INTRINSICS)
+# include <emmintrin.h>
+# define FFT_SSE2 1
+#endif
+
 #include <math.h>
 #ifndef PI
  #ifdef M_PI
@@ -67,11 +80,17 @@ fft_state *visual_fft_init(void)
     {
         p_state->bitReverse[i] = reverseBits(i);
     }
-    for(i = 0; i < FFT_BUFFER_SIZE / 2; i++)
+    p_state->costable[0] = p_state->sintable[0] = 0.f; /* unused */
+    for(unsigned exchanges = 1; exchanges < FFT_BUFFER_SIZE; exchanges <<= 1)
     {
-        float j = 2 * PI * i / FFT_BUFFER_SIZE;
-        p_state->costable[i] = cos(j);
-        p_state->sintable[i] = sin(j);
+        unsigned factfact = FFT_BUFFER_SIZE / 2 / exchanges;
+
+        for(i = 0; i < exchanges; i++)
+        {
+            float j = 2 * PI * (i * factfact) / FFT_BUFFER_SIZE;
+            p_state->costable[exchanges + i] = cos(j);
+            p_state->sintable[exchanges + i] = sin(j);
+        }
     }
 
     return p_state;
@@ -148,49 +167,77 @@ static void fft_output(const float * re, const float * im, float *output)
 }
 
 
+#ifdef FFT_SSE2
+/*
+ * Butterflies of one group, four exchanges at a time
+ */
+__attribute__ ((__target__ ("sse2")))
+static void fft_group_sse2(float *re, float *im, const float *costable,
+                           const float *sintable, unsigned exchanges)
+{
+    for(unsigned j = 0; j < exchanges; j += 4) {
+        __m128 fact_real = _mm_loadu_ps(costable + j);
+        __m128 fact_imag = _mm_loadu_ps(sintable + j);
+        __m128 re0 = _mm_loadu_ps(re + j);
+        __m128 im0 = _mm_loadu_ps(im + j);
+        __m128 re1 = _mm_loadu_ps(re + j + exchanges);
+        __m128 im1 = _mm_loadu_ps(im + j + exchanges);
+        __m128 tmp_real = _mm_sub_ps(_mm_mul_ps(fact_real, re1),
+                                     _mm_mul_ps(fact_imag, im1));
+        __m128 tmp_imag = _mm_add_ps(_mm_mul_ps(fact_real, im1),
+                                     _mm_mul_ps(fact_imag, re1));
+
+        _mm_storeu_ps(re + j + exchanges, _mm_sub_ps(re0, tmp_real));
+        _mm_storeu_ps(im + j + exchanges, _mm_sub_ps(im0, tmp_imag));
+        _mm_storeu_ps(re + j, _mm_add_ps(re0, tmp_real));
+        _mm_storeu_ps(im + j, _mm_add_ps(im0, tmp_imag));
+    }
+}
+#endif
+
 /*
  * Actually perform the FFT
  */
 static void fft_calculate(float * re, float * im, const float *costable, const float *sintable )
 {
-    unsigned int i, j, k;
     unsigned int exchanges;
-    float fact_real, fact_imag;
-    float tmp_real, tmp_imag;
-    unsigned int factfact;
-
-    /* Set up some variables to reduce calculation in the loops */
-    exchanges = 1;
-    factfact = FFT_BUFFER_SIZE / 2;
+#ifdef FFT_SSE2
+    const bool sse2 = vlc_CPU_SSE2();
+#endif
 
     /* Loop through the divide and conquer steps */
-    for(i = FFT_BUFFER_SIZE_LOG; i != 0; i--) {
-        /* In this step, we have 2 ^ (i - 1) exchange groups, each with
-         * 2 ^ (FFT_BUFFER_SIZE_LOG - i) exchanges
-         */
-        /* Loop through the exchanges in a group */
-        for(j = 0; j != exchanges; j++) {
-            /* Work out factor for this exchange
-             * factor ^ (exchanges) = -1
-             * So, real = cos(j * PI / exchanges),
-             *     imag = sin(j * PI / exchanges)
-             */
-            fact_real = costable[j * factfact];
-            fact_imag = sintable[j * factfact];
-
-            /* Loop through all the exchange groups */
-            for(k = j; k < FFT_BUFFER_SIZE; k += exchanges << 1) {
-                int k1 = k + exchanges;
-                tmp_real = fact_real * re[k1] - fact_imag * im[k1];
-                tmp_imag = fact_real * im[k1] + fact_imag * re[k1];
-                re[k1] = re[k] - tmp_real;
-                im[k1] = im[k] - tmp_imag;
-                re[k]  += tmp_real;
-                im[k]  += tmp_imag;
+    for(exchanges = 1; exchanges < FFT_BUFFER_SIZE; exchanges <<= 1) {
+        /* In this step, there are FFT_BUFFER_SIZE / (2 * exchanges) groups,
+         * each with exchanges butterflies. The factor of exchange j is
+         *     real = cos(j * PI / exchanges),
+         *     imag = sin(j * PI / exchanges),
+         * stored contiguously from index exchanges in the tables. */
+        const float *fact_reals = costable + exchanges;
+        const float *fact_imags = sintable + exchanges;
+
+        /* Loop through all the exchange groups */
+        for(unsigned k = 0; k < FFT_BUFFER_SIZE; k += exchanges << 1) {
+#ifdef FFT_SSE2
+            if(sse2 && exchanges >= 4) {
+                fft_group_sse2(re + k, im + k, fact_reals, fact_imags,
+                               exchanges);
+                continue;
+            }
+#endif
+            /* Loop through the exchanges in a group */
+            for(unsigned j = 0; j < exchanges; j++) {
+                int k0 = k + j;
+                int k1 = k0 + exchanges;
+                float fact_real = fact_reals[j];
+                float fact_imag = fact_imags[j];
+                float tmp_real = fact_real * re[k1] - fact_imag * im[k1];
+                float tmp_imag = fact_real * im[k1] + fact_imag * re[k1];
+                re[k1] = re[k0] - tmp_real;
+                im[k1] = im[k0] - tmp_imag;
+                re[k0] += tmp_real;
+                im[k0] += tmp_imag;
             }
         }
-        exchanges <<= 1;
-        factfact >>= 1;
     }
 }
 
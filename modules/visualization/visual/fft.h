@@ -39,10 +39,10 @@ struct _struct_fft_state {
      /* */
      unsigned int bitReverse[FFT_BUFFER_SIZE];
 
-     /* The next two tables could be made to use less space in memory, since they
-      * overlap hugely, but hey. */
-     float sintable[FFT_BUFFER_SIZE / 2];
-     float costable[FFT_BUFFER_SIZE / 2];
+     /* Twiddle factors, stored contiguously for each step: the factors of
+      * the step with n exchanges per group start at index n. */
+     float sintable[FFT_BUFFER_SIZE];
+     float costable[FFT_BUFFER_SIZE];
 };
 
 /* FFT prototypes */
@@ -415,13 +415,14 @@ getstatus = function (includecategories)
     local s ={}
 
     --update api version when new data/commands added
-    s.apiversion=3
+    s.apiversion=4
     s.version=vlc.misc.version()
     s.volume=vlc.volume.get()
 
     s.time = vlc.player.get_time() / 1000000
     s.position = vlc.player.get_position()
     s.currentplid = vlc.playlist.current()
+    s.playlistrevision = vlc.playlist.revision()
     s.audiodelay = vlc.player.get_audio_delay()
     s.rate = vlc.player.get_rate()
     s.subtitledelay = vlc.player.get_subtitle_delay()
@@ -40,6 +40,7 @@ enum {
 
 typedef struct aout_volume aout_volume_t;
 typedef struct aout_dev aout_dev_t;
+struct vlc_audio_pool;
 
 typedef struct
 {
@@ -96,8 +97,12 @@ typedef struct
 
     atomic_uint buffers_lost;
     atomic_uint buffers_played;
+    _Atomic vlc_tick_t drift; /**< Last reported drift, or VLC_TICK_INVALID */
     atomic_uchar restart;
 
+    struct vlc_tracer *tracer; /**< Tracer, or NULL */
+    struct vlc_audio_pool *pool; /**< Buffers of the stream, or NULL */
+
     vlc_atomic_rc_t rc;
 } aout_owner_t;
 
@@ -147,10 +152,12 @@ void aout_FormatsPrint(vlc_object_t *, const char *,
 #define AOUT_DEC_FAILED VLC_EGENERIC
 
 int aout_DecNew(audio_output_t *, const audio_sample_format_t *, int profile,
-                struct vlc_clock_t *clock, const audio_replay_gain_t *);
+                struct vlc_clock_t *clock, struct vlc_audio_pool *pool,
+                const audio_replay_gain_t *);
 void aout_DecDelete(audio_output_t *);
 int aout_DecPlay(audio_output_t *aout, block_t *block);
-void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *);
+void aout_DecGetResetStats(audio_output_t *, unsigned *, unsigned *,
+                           vlc_tick_t *);
 void aout_DecChangePause(audio_output_t *, bool b_paused, vlc_tick_t i_date);
 void aout_DecChangeRate(audio_output_t *aout, float rate);
 void aout_DecChangeDelay(audio_output_t *aout, vlc_tick_t delay);
@@ -184,8 +191,10 @@ static inline void aout_SetWavePhysicalChannels(audio_sample_format_t *fmt)
  *
  * The clock, that is not mandatory, will be used to create a new slave clock
  * for the filter vizualisation plugins.
+ * The filters allocate their output buffers from the pool, if not NULL.
  */
 aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *, const vlc_clock_t *,
+                                         struct vlc_audio_pool *,
                                          const audio_sample_format_t *,
                                          const audio_sample_format_t *,
                                          const aout_filters_cfg_t *cfg) VLC_USED;
@@ -33,6 +33,7 @@
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_tracer.h>
 
 #include "aout_internal.h"
 #include "clock/clock.h"
@@ -54,7 +55,7 @@ static void aout_Drain(audio_output_t *aout)
  * Creates an audio output
  */
 int aout_DecNew(audio_output_t *p_aout, const audio_sample_format_t *p_format,
-                int profile, vlc_clock_t *clock,
+                int profile, vlc_clock_t *clock, struct vlc_audio_pool *pool,
                 const audio_replay_gain_t *p_replay_gain)
 {
     assert(p_aout);
@@ -97,6 +98,7 @@ int aout_DecNew(audio_output_t *p_aout, const audio_sample_format_t *p_format,
     owner->filter_format = owner->mixer_format = owner->input_format = *p_format;
 
     owner->sync.clock = clock;
+    owner->pool = pool;
 
     owner->filters = NULL;
     owner->filters_cfg = AOUT_FILTERS_CFG_INIT;
@@ -108,6 +110,7 @@ int aout_DecNew(audio_output_t *p_aout, const audio_sample_format_t *p_format,
     {
         /* Create the audio filtering "input" pipeline */
         owner->filters = aout_FiltersNewWithClock(VLC_OBJECT(p_aout), clock,
+                                                  pool,
                                                   &owner->filter_format,
                                                   &owner->mixer_format,
                                                   &owner->filters_cfg);
@@ -129,6 +132,7 @@ error:
 
     atomic_init (&owner->buffers_lost, 0);
     atomic_init (&owner->buffers_played, 0);
+    atomic_init (&owner->drift, VLC_TICK_INVALID);
     atomic_store_explicit(&owner->vp.update, true, memory_order_relaxed);
     return 0;
 }
@@ -149,6 +153,7 @@ void aout_DecDelete (audio_output_t *aout)
     }
     aout_volume_Delete (owner->volume);
     owner->volume = NULL;
+    owner->pool = NULL;
 }
 
 static int aout_CheckReady (audio_output_t *aout)
@@ -193,6 +198,7 @@ static int aout_CheckReady (audio_output_t *aout)
         {
             owner->filters = aout_FiltersNewWithClock(VLC_OBJECT(aout),
                                                       owner->sync.clock,
+                                                      owner->pool,
                                                       &owner->filter_format,
                                                       &owner->mixer_format,
                                                       &owner->filters_cfg);
@@ -323,6 +329,10 @@ void aout_RequestRetiming(audio_output_t *aout, vlc_tick_t system_ts,
     if (unlikely(drift == INT64_MAX) || owner->bitexact)
         return; /* cf. INT64_MAX comment in aout_DecPlay() */
 
+    atomic_store_explicit(&owner->drift, drift, memory_order_relaxed);
+    vlc_tracer_Counter(owner->tracer, "aout", "drift", aout,
+                       US_FROM_VLC_TICK(drift));
+
     /* Late audio output.
      * This can happen due to insufficient caching, scheduling jitter
      * or bug in the decoder. Ideally, the output would seek backward. But that
@@ -488,7 +498,9 @@ int aout_DecPlay(audio_output_t *aout, block_t *block)
     }
     /* Output */
     owner->sync.discontinuity = false;
+    vlc_tick_t play_start = vlc_tracer_Begin(owner->tracer);
     aout->play(aout, block, play_date);
+    vlc_tracer_End(owner->tracer, "aout", "play", aout, play_start);
 
     atomic_fetch_add_explicit(&owner->buffers_played, 1, memory_order_relaxed);
     return ret;
@@ -501,7 +513,8 @@ drop:
 }
 
 void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
-                           unsigned *restrict played)
+                           unsigned *restrict played,
+                           vlc_tick_t *restrict drift)
 {
     aout_owner_t *owner = aout_owner (aout);
 
@@ -509,6 +522,7 @@ void aout_DecGetResetStats(audio_output_t *aout, unsigned *restrict lost,
                                      memory_order_relaxed);
     *played = atomic_exchange_explicit(&owner->buffers_played, 0,
                                        memory_order_relaxed);
+    *drift = atomic_load_explicit(&owner->drift, memory_order_relaxed);
 }
 
 void aout_DecChangePause (audio_output_t *aout, bool paused, vlc_tick_t date)
@@ -39,8 +39,29 @@
 #include <libvlc.h>
 #include "aout_internal.h"
 #include "../video_output/vout_internal.h" /* for vout_Request */
+#include "../input/audio_pool.h"
 
-static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
+/* Owner of the filters of a chain */
+struct aout_filter_owner
+{
+    vlc_clock_t *clock; /**< Clock of the visualizations, or NULL */
+    struct vlc_audio_pool *pool; /**< Pool of the stream, or NULL */
+};
+
+static block_t *aout_filter_NewBuffer(filter_t *filter, size_t length)
+{
+    struct aout_filter_owner *owner = filter->owner.sys;
+
+    return vlc_audio_pool_Get(owner->pool, length);
+}
+
+static const struct filter_audio_callbacks aout_filter_cbs =
+{
+    .buffer_new = aout_filter_NewBuffer,
+};
+
+static filter_t *CreateFilter(vlc_object_t *obj,
+                              struct aout_filter_owner *owner,
                               const char *type, const char *name,
                               const audio_sample_format_t *infmt,
                               const audio_sample_format_t *outfmt,
@@ -50,7 +71,9 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
     if (unlikely(filter == NULL))
         return NULL;
 
-    filter->owner.sys = clock;
+    filter->owner.sys = owner;
+    if (owner != NULL && owner->pool != NULL)
+        filter->owner.audio = &aout_filter_cbs;
     filter->p_cfg = cfg;
     filter->fmt_in.audio = *infmt;
     filter->fmt_in.i_codec = infmt->i_format;
@@ -88,24 +111,46 @@ static filter_t *CreateFilter(vlc_object_t *obj, vlc_clock_t *clock,
 }
 
 static filter_t *FindConverter (vlc_object_t *obj,
+                                struct aout_filter_owner *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter(obj, NULL, "audio converter", NULL, infmt, outfmt,
+    return CreateFilter(obj, owner, "audio converter", NULL, infmt, outfmt,
                         NULL, true);
 }
 
 static filter_t *FindResampler (vlc_object_t *obj,
+                                struct aout_filter_owner *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
     char *modlist = var_InheritString(obj, "audio-resampler");
-    filter_t *filter = CreateFilter(obj, NULL, "audio resampler", modlist,
+    filter_t *filter = CreateFilter(obj, owner, "audio resampler", modlist,
                                     infmt, outfmt, NULL, true);
     free(modlist);
     return filter;
 }
 
+static filter_t *FindRemixer (vlc_object_t *obj,
+                              struct aout_filter_owner *owner,
+                              const audio_sample_format_t *infmt,
+                              const audio_sample_format_t *outfmt,
+                              bool headphones)
+{
+    const char *filter_type =
+        infmt->channel_type != outfmt->channel_type ?
+        "audio renderer" : "audio converter";
+
+    config_chain_t *cfg = NULL;
+    if (headphones)
+        config_ChainParseOptions(&cfg, "{headphones=true}");
+    filter_t *filter = CreateFilter(obj, owner, filter_type, NULL,
+                                    infmt, outfmt, cfg, true);
+    if (cfg)
+        config_ChainDestroy(cfg);
+    return filter;
+}
+
 /**
  * Destroys a chain of audio filters.
  */
@@ -120,7 +165,8 @@ static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, struct aout_filter_owner *owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -129,7 +175,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -138,6 +184,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param owner owner of the new filters, or NULL
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -145,7 +192,9 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj,
+                                      struct aout_filter_owner *owner,
+                                      filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt,
@@ -171,45 +220,49 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
     if (infmt->i_physical_channels != outfmt->i_physical_channels
      || infmt->i_chan_mode != outfmt->i_chan_mode
      || infmt->channel_type != outfmt->channel_type)
-    {   /* Remixing currently requires FL32... TODO: S16N */
-        if (input.i_format != VLC_CODEC_FL32)
-        {
-            if (n == max)
-                goto overflow;
-
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
-            if (f == NULL)
-            {
-                msg_Err (obj, "cannot find %s for conversion pipeline",
-                         "pre-mix converter");
-                goto error;
-            }
-
-            filters[n++] = f;
-        }
-
+    {
         if (n == max)
             goto overflow;
 
+        /* Remixing currently outputs FL32 */
         audio_sample_format_t output;
-        output.i_format = input.i_format;
+        output.i_format = VLC_CODEC_FL32;
         output.i_rate = input.i_rate;
         output.i_physical_channels = outfmt->i_physical_channels;
         output.channel_type = outfmt->channel_type;
         output.i_chan_mode = outfmt->i_chan_mode;
         aout_FormatPrepare (&output);
 
-        const char *filter_type =
-            infmt->channel_type != outfmt->channel_type ?
-            "audio renderer" : "audio converter";
+        /* Some remixers convert the input while mixing, saving a pass and
+         * a buffer: try them before inserting a pre-mix converter. */
+        filter_t *f = NULL;
+        if (input.i_format != VLC_CODEC_FL32)
+        {
+            f = FindRemixer (obj, owner, &input, &output, headphones);
+            if (f != NULL)
+                msg_Dbg(obj, "remixing from %4.4s without conversion",
+                        (const char *)&input.i_format);
+        }
 
-        config_chain_t *cfg = NULL;
-        if (headphones)
-            config_ChainParseOptions(&cfg, "{headphones=true}");
-        filter_t *f = CreateFilter(obj, NULL, filter_type, NULL,
-                                   &input, &output, cfg, true);
-        if (cfg)
-            config_ChainDestroy(cfg);
+        if (f == NULL)
+        {
+            if (input.i_format != VLC_CODEC_FL32)
+            {
+                f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
+                if (f == NULL)
+                {
+                    msg_Err (obj, "cannot find %s for conversion pipeline",
+                             "pre-mix converter");
+                    goto error;
+                }
+
+                filters[n++] = f;
+                if (n == max)
+                    goto overflow;
+            }
+
+            f = FindRemixer (obj, owner, &input, &output, headphones);
+        }
 
         if (f == NULL)
         {
@@ -231,7 +284,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -249,7 +302,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -259,7 +312,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         filters[n++] = f;
     }
 
-    msg_Dbg (obj, "conversion pipeline complete");
+    msg_Dbg (obj, "conversion pipeline complete with %u filter(s)", n);
     *count += n;
     return 0;
 
@@ -348,7 +401,7 @@ struct aout_filters
         (either the scaletempo filter or a resampler) */
     filter_t *resampler; /**< The resampler */
     int resampling; /**< Current resampling (Hz) */
-    vlc_clock_t *clock;
+    struct aout_filter_owner owner;
 
     unsigned count; /**< Number of filters */
     filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
@@ -388,9 +441,11 @@ vout_thread_t *aout_filter_GetVout(filter_t *filter, const video_format_t *fmt)
     if (unlikely(vout == NULL))
         return NULL;
 
+    struct aout_filter_owner *owner = filter->owner.sys;
     video_format_t adj_fmt = *fmt;
     vout_configuration_t cfg = {
-        .vout = vout, .clock = filter->owner.sys, .fmt = &adj_fmt,
+        .vout = vout, .clock = owner != NULL ? owner->clock : NULL,
+        .fmt = &adj_fmt,
     };
 
     video_format_AdjustColorSpace(&adj_fmt);
@@ -415,7 +470,7 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
         return -1;
     }
 
-    filter_t *filter = CreateFilter(obj, filters->clock, type, name,
+    filter_t *filter = CreateFilter(obj, &filters->owner, type, name,
                                     infmt, outfmt, cfg, false);
     if (filter == NULL)
     {
@@ -424,8 +479,9 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio, false))
+    if (aout_FiltersPipelineCreate (obj, &filters->owner, filters->tab,
+                                    &filters->count, max - 1, infmt,
+                                    &filter->fmt_in.audio, false))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         module_unneed (filter, filter->p_module);
@@ -487,6 +543,7 @@ static int AppendRemapFilter(vlc_object_t *obj, aout_filters_t *restrict filters
 }
 
 aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *clock,
+                                         struct vlc_audio_pool *pool,
                                          const audio_sample_format_t *restrict infmt,
                                          const audio_sample_format_t *restrict outfmt,
                                          const aout_filters_cfg_t *cfg)
@@ -501,12 +558,13 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     filters->count = 0;
     if (clock)
     {
-        filters->clock = vlc_clock_CreateSlave(clock, AUDIO_ES);
-        if (!filters->clock)
+        filters->owner.clock = vlc_clock_CreateSlave(clock, AUDIO_ES);
+        if (!filters->owner.clock)
             goto error;
     }
     else
-        filters->clock = NULL;
+        filters->owner.clock = NULL;
+    filters->owner.pool = pool;
 
     /* Prepare format structure */
     aout_FormatPrint (obj, "input", infmt);
@@ -521,7 +579,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, &filters->owner, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -545,8 +603,9 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
 
         /* convert to the output format (minus resampling) if necessary */
         output_format.i_rate = input_format.i_rate;
-        if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                  AOUT_MAX_FILTERS, &input_format, &output_format,
+        if (aout_FiltersPipelineCreate (obj, &filters->owner, filters->tab,
+                                  &filters->count, AOUT_MAX_FILTERS,
+                                  &input_format, &output_format,
                                   cfg->headphones))
         {
             msg_Warn (obj, "cannot setup audio renderer pipeline");
@@ -569,7 +628,8 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
         audio_sample_format_t input_phys_format = input_format;
         aout_SetWavePhysicalChannels(&input_phys_format);
 
-        filter_t *f = FindConverter (obj, &input_format, &input_phys_format);
+        filter_t *f = FindConverter (obj, &filters->owner, &input_format,
+                                     &input_phys_format);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find channel converter");
@@ -621,8 +681,9 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                              AOUT_MAX_FILTERS, &input_format, &output_format, false))
+    if (aout_FiltersPipelineCreate (obj, &filters->owner, filters->tab,
+                              &filters->count, AOUT_MAX_FILTERS,
+                              &input_format, &output_format, false))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
         goto error;
@@ -632,7 +693,7 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler = FindResampler (obj, &input_format,
+    filters->resampler = FindResampler (obj, &filters->owner, &input_format,
                                         &output_format);
     if (filters->resampler == NULL && input_format.i_rate != outfmt->i_rate)
     {
@@ -647,22 +708,22 @@ aout_filters_t *aout_FiltersNewWithClock(vlc_object_t *obj, const vlc_clock_t *c
 error:
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
-    if (filters->clock)
-        vlc_clock_Delete(filters->clock);
+    if (filters->owner.clock)
+        vlc_clock_Delete(filters->owner.clock);
     free (filters);
     return NULL;
 }
 
 void aout_FiltersResetClock(aout_filters_t *filters)
 {
-    assert(filters->clock);
-    vlc_clock_Reset(filters->clock);
+    assert(filters->owner.clock);
+    vlc_clock_Reset(filters->owner.clock);
 }
 
 void aout_FiltersSetClockDelay(aout_filters_t *filters, vlc_tick_t delay)
 {
-    assert(filters->clock);
-    vlc_clock_SetDelay(filters->clock, delay);
+    assert(filters->owner.clock);
+    vlc_clock_SetDelay(filters->owner.clock, delay);
 }
 
 #undef aout_FiltersNew
@@ -679,7 +740,7 @@ aout_filters_t *aout_FiltersNew(vlc_object_t *obj,
                                 const audio_sample_format_t *restrict outfmt,
                                 const aout_filters_cfg_t *cfg)
 {
-    return aout_FiltersNewWithClock(obj, NULL, infmt, outfmt, cfg);
+    return aout_FiltersNewWithClock(obj, NULL, NULL, infmt, outfmt, cfg);
 }
 
 #undef aout_FiltersDelete
@@ -694,8 +755,8 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
         aout_FiltersPipelineDestroy (&filters->resampler, 1);
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     var_DelCallback(obj, "visual", VisualizationCallback, NULL);
-    if (filters->clock)
-        vlc_clock_Delete(filters->clock);
+    if (filters->owner.clock)
+        vlc_clock_Delete(filters->owner.clock);
     free (filters);
 }
 
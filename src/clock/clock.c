@@ -23,11 +23,36 @@
 
 #include <vlc_common.h>
 #include <vlc_aout.h>
+#include <vlc_list.h>
 #include <assert.h>
 #include <limits.h>
 #include "clock.h"
 #include "clock_internal.h"
 
+/**
+ * Main clocks sharing the time base of a leader
+ *
+ * The leader is the first member whose master clock is updated. The other
+ * members (followers) convert their timestamps with the linear function of
+ * the leader, so that all their outputs are slaved to the leader master.
+ */
+struct vlc_clock_group
+{
+    char *name;
+    unsigned refs;
+    struct vlc_list node;
+
+    vlc_clock_main_t *leader;
+    /* Linear function of the leader, offset is VLC_TICK_INVALID if there is
+     * no valid reference */
+    double coeff;
+    double rate;
+    vlc_tick_t offset;
+};
+
+static vlc_mutex_t group_lock = VLC_STATIC_MUTEX;
+static struct vlc_list groups = VLC_LIST_INITIALIZER(&groups);
+
 struct vlc_clock_main_t
 {
     vlc_mutex_t lock;
@@ -56,6 +81,11 @@ struct vlc_clock_main_t
     vlc_tick_t output_dejitter; /* Delay used to absorb the output clock jitter */
     vlc_tick_t input_dejitter; /* Delay used to absorb the input jitter */
     bool abort;
+
+    /* Time base sharing, protected by group_lock */
+    struct vlc_clock_group *group;
+    enum vlc_clock_group_align group_align;
+    vlc_tick_t group_ts_offset; /* Added to the ts of a follower */
 };
 
 struct vlc_clock_t
@@ -76,9 +106,68 @@ struct vlc_clock_t
     void *cbs_data;
 };
 
+/* Must be called with group_lock held */
+static bool group_is_follower(const vlc_clock_main_t *main_clock)
+{
+    const struct vlc_clock_group *group = main_clock->group;
+    return group != NULL && group->leader != NULL
+        && group->leader != main_clock;
+}
+
+static bool vlc_clock_main_is_follower(const vlc_clock_main_t *main_clock)
+{
+    if (main_clock->group == NULL)
+        return false;
+    vlc_mutex_lock(&group_lock);
+    bool follower = group_is_follower(main_clock);
+    vlc_mutex_unlock(&group_lock);
+    return follower;
+}
+
+/* Publish the linear function of a leader, or take the lead if the group has
+ * none */
+static void vlc_clock_main_publish(vlc_clock_main_t *main_clock)
+{
+    struct vlc_clock_group *group = main_clock->group;
+    if (group == NULL)
+        return;
+
+    vlc_mutex_lock(&group_lock);
+    if (group->leader == NULL && main_clock->offset != VLC_TICK_INVALID)
+        group->leader = main_clock;
+    if (group->leader == main_clock)
+    {
+        group->coeff = main_clock->coeff;
+        group->rate = main_clock->rate;
+        group->offset = main_clock->offset;
+    }
+    vlc_mutex_unlock(&group_lock);
+}
+
+static vlc_tick_t group_stream_to_system(vlc_clock_main_t *main_clock,
+                                         vlc_tick_t ts)
+{
+    vlc_tick_t system = VLC_TICK_INVALID;
+
+    vlc_mutex_lock(&group_lock);
+    const struct vlc_clock_group *group = main_clock->group;
+    if (group_is_follower(main_clock) && group->offset != VLC_TICK_INVALID)
+        system = (ts + main_clock->group_ts_offset) * group->coeff
+               / group->rate + group->offset;
+    vlc_mutex_unlock(&group_lock);
+    return system;
+}
+
 static vlc_tick_t main_stream_to_system(vlc_clock_main_t *main_clock,
                                         vlc_tick_t ts)
 {
+    if (main_clock->group != NULL)
+    {
+        vlc_tick_t system = group_stream_to_system(main_clock, ts);
+        if (system != VLC_TICK_INVALID)
+            return system;
+    }
+
     if (main_clock->offset == VLC_TICK_INVALID)
         return VLC_TICK_INVALID;
     return (vlc_tick_t)
@@ -95,6 +184,7 @@ static void vlc_clock_main_reset(vlc_clock_main_t *main_clock)
     main_clock->wait_sync_ref_priority = UINT_MAX;
     main_clock->wait_sync_ref =
         main_clock->last = clock_point_Create(VLC_TICK_INVALID, VLC_TICK_INVALID);
+    vlc_clock_main_publish(main_clock);
     vlc_cond_broadcast(&main_clock->cond);
 }
 
@@ -109,6 +199,12 @@ static inline void vlc_clock_on_update(vlc_clock_t *clock,
                               clock->cbs_data);
 }
 
+static vlc_tick_t vlc_clock_slave_update(vlc_clock_t *clock,
+                                         vlc_tick_t system_now,
+                                         vlc_tick_t ts, double rate,
+                                         unsigned frame_rate,
+                                         unsigned frame_rate_base);
+
 static vlc_tick_t vlc_clock_master_update(vlc_clock_t *clock,
                                           vlc_tick_t system_now,
                                           vlc_tick_t original_ts, double rate,
@@ -121,6 +217,12 @@ static vlc_tick_t vlc_clock_master_update(vlc_clock_t *clock,
      || system_now == VLC_TICK_INVALID))
         return VLC_TICK_INVALID;
 
+    /* The master of a follower is driven by the leader of its group, as a
+     * slave, and returns its drift so that it can be compensated */
+    if (vlc_clock_main_is_follower(main_clock))
+        return vlc_clock_slave_update(clock, system_now, original_ts, rate,
+                                      frame_rate, frame_rate_base);
+
     const vlc_tick_t ts = original_ts + clock->delay;
 
     vlc_mutex_lock(&main_clock->lock);
@@ -154,6 +256,7 @@ static vlc_tick_t vlc_clock_master_update(vlc_clock_t *clock,
         main_clock->last = clock_point_Create(system_now, ts);
 
         main_clock->rate = rate;
+        vlc_clock_main_publish(main_clock);
         vlc_cond_broadcast(&main_clock->cond);
     }
 
@@ -384,6 +487,10 @@ vlc_clock_main_t *vlc_clock_main_New(void)
     main_clock->output_dejitter = AOUT_MAX_PTS_ADVANCE * 2;
     main_clock->abort = false;
 
+    main_clock->group = NULL;
+    main_clock->group_align = VLC_CLOCK_GROUP_ALIGN_TIMESTAMPS;
+    main_clock->group_ts_offset = 0;
+
     AvgInit(&main_clock->coeff_avg, 10);
 
     return main_clock;
@@ -417,6 +524,26 @@ void vlc_clock_main_SetFirstPcr(vlc_clock_main_t *main_clock,
         main_clock->wait_sync_ref_priority = UINT_MAX;
         main_clock->wait_sync_ref =
             clock_point_Create(VLC_TICK_INVALID, VLC_TICK_INVALID);
+
+        if (main_clock->group_align == VLC_CLOCK_GROUP_ALIGN_START)
+        {
+            /* Render the first reference along with what the leader renders
+             * once this input has buffered as much */
+            vlc_mutex_lock(&group_lock);
+            const struct vlc_clock_group *group = main_clock->group;
+            if (group_is_follower(main_clock)
+             && group->offset != VLC_TICK_INVALID)
+            {
+                const vlc_tick_t system =
+                    system_now + main_clock->input_dejitter;
+                const vlc_tick_t leader_ts = (system - group->offset)
+                                           * group->rate / group->coeff;
+                main_clock->group_ts_offset = leader_ts - ts;
+            }
+            else
+                main_clock->group_ts_offset = 0;
+            vlc_mutex_unlock(&group_lock);
+        }
     }
     vlc_mutex_unlock(&main_clock->lock);
 }
@@ -462,14 +589,81 @@ void vlc_clock_main_ChangePause(vlc_clock_main_t *main_clock, vlc_tick_t now,
         if (main_clock->wait_sync_ref.system != VLC_TICK_INVALID)
             main_clock->wait_sync_ref.system += delay;
         main_clock->pause_date = VLC_TICK_INVALID;
+        vlc_clock_main_publish(main_clock);
         vlc_cond_broadcast(&main_clock->cond);
     }
     vlc_mutex_unlock(&main_clock->lock);
 }
 
+int vlc_clock_main_JoinGroup(vlc_clock_main_t *main_clock, const char *name,
+                             enum vlc_clock_group_align align)
+{
+    assert(main_clock->group == NULL);
+
+    vlc_mutex_lock(&group_lock);
+    struct vlc_clock_group *group;
+    vlc_list_foreach(group, &groups, node)
+        if (!strcmp(group->name, name))
+            goto join;
+
+    group = malloc(sizeof (*group));
+    if (group == NULL)
+        goto error;
+    group->name = strdup(name);
+    if (group->name == NULL)
+    {
+        free(group);
+        goto error;
+    }
+    group->refs = 0;
+    group->leader = NULL;
+    group->coeff = 1.0f;
+    group->rate = 1.0f;
+    group->offset = VLC_TICK_INVALID;
+    vlc_list_append(&group->node, &groups);
+
+join:
+    group->refs++;
+    vlc_mutex_unlock(&group_lock);
+
+    vlc_mutex_lock(&main_clock->lock);
+    main_clock->group_align = align;
+    main_clock->group = group;
+    vlc_mutex_unlock(&main_clock->lock);
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_unlock(&group_lock);
+    return VLC_ENOMEM;
+}
+
+static void vlc_clock_main_LeaveGroup(vlc_clock_main_t *main_clock)
+{
+    struct vlc_clock_group *group = main_clock->group;
+
+    vlc_mutex_lock(&group_lock);
+    if (group->leader == main_clock)
+    {
+        /* The followers fall back to their own time base until an other
+         * member takes the lead */
+        group->leader = NULL;
+        group->offset = VLC_TICK_INVALID;
+    }
+    if (--group->refs == 0)
+    {
+        vlc_list_remove(&group->node);
+        free(group->name);
+        free(group);
+    }
+    main_clock->group = NULL;
+    vlc_mutex_unlock(&group_lock);
+}
+
 void vlc_clock_main_Delete(vlc_clock_main_t *main_clock)
 {
     assert(main_clock->rc == 1);
+    if (main_clock->group != NULL)
+        vlc_clock_main_LeaveGroup(main_clock);
     free(main_clock);
 }
 
@@ -27,6 +27,17 @@ enum vlc_clock_master_source
     VLC_CLOCK_MASTER_DEFAULT = VLC_CLOCK_MASTER_AUDIO,
 };
 
+/**
+ * How the timestamps of the members of a clock group are aligned
+ */
+enum vlc_clock_group_align
+{
+    /** The members share the same time base */
+    VLC_CLOCK_GROUP_ALIGN_TIMESTAMPS = 0,
+    /** The first clock reference of a member is aligned with the leader */
+    VLC_CLOCK_GROUP_ALIGN_START,
+};
+
 typedef struct vlc_clock_main_t vlc_clock_main_t;
 typedef struct vlc_clock_t vlc_clock_t;
 
@@ -87,6 +98,21 @@ void vlc_clock_main_SetInputDejitter(vlc_clock_main_t *main_clock,
 void vlc_clock_main_SetDejitter(vlc_clock_main_t *main_clock, vlc_tick_t dejitter);
 
 
+/**
+ * Join a group of main clocks sharing a time base
+ *
+ * The first member with an updated master clock leads the group: the
+ * outputs of all the other members, including their master, are slaved to
+ * it. The group is left when the main clock is deleted.
+ *
+ * @param name name of the group, shared by all the inputs of the process
+ * @param align how the timestamps of this member are aligned with the ones
+ * of the leader
+ * @return VLC_SUCCESS or VLC_ENOMEM
+ */
+int vlc_clock_main_JoinGroup(vlc_clock_main_t *main_clock, const char *name,
+                             enum vlc_clock_group_align align);
+
 /**
  * This function allows changing the pause status.
  */
@@ -33,6 +33,7 @@
 #include "input_clock.h"
 #include "clock_internal.h"
 #include <assert.h>
+#include <math.h>
 
 /* TODO:
  * - clean up locking once clock code is stable
@@ -101,6 +102,32 @@
 /* */
 #define INPUT_CLOCK_LATE_COUNT (3)
 
+/* Number of mean absolute deviations of the PCR arrival jitter covered by
+ * the jitter-adaptive buffering (about 3 standard deviations) */
+#define INPUT_CLOCK_JITTER_MARGIN (4)
+
+/* Weight of a new sample in the jitter estimation (as in RFC 3550) */
+#define INPUT_CLOCK_JITTER_WEIGHT (16)
+
+/*
+ * The drift between the stream and the system clocks is tracked by a
+ * critically damped alpha-beta filter, that is a second order PLL: it
+ * estimates both the drift and its slope, so that a constant frequency
+ * offset between the server and the client is followed without lag, where
+ * a plain moving average always lags behind (and makes the outputs
+ * resample back and forth). Samples deviating from the prediction by more
+ * than the jitter margin are clipped before updating the loop.
+ */
+typedef struct
+{
+    double offset; /* Estimated drift, in stream ticks */
+    double slope; /* Drift variation per system tick */
+    double jitter; /* Mean absolute deviation of the samples */
+    vlc_tick_t date; /* System date of the last loop update */
+    int count; /* Number of loop updates, up to range */
+    int range; /* Loop time constant, in loop updates */
+} drift_estimator_t;
+
 /* */
 struct input_clock_t
 {
@@ -119,7 +146,7 @@ struct input_clock_t
 
     /* Clock drift */
     vlc_tick_t i_next_drift_update;
-    average_t drift;
+    drift_estimator_t drift;
 
     /* Late statistics */
     struct
@@ -148,6 +175,12 @@ static vlc_tick_t ClockSystemToStream( input_clock_t *, vlc_tick_t i_system );
 
 static vlc_tick_t ClockGetTsOffset( input_clock_t * );
 
+static void DriftInit( drift_estimator_t *, int range );
+static void DriftReset( drift_estimator_t * );
+static void DriftUpdate( drift_estimator_t *, bool b_loop,
+                         vlc_tick_t i_system, vlc_tick_t i_sample );
+static vlc_tick_t DriftGet( const drift_estimator_t * );
+
 /*****************************************************************************
  * input_clock_New: create a new clock
  *****************************************************************************/
@@ -169,7 +202,7 @@ input_clock_t *input_clock_New( float rate )
     cl->i_buffering_duration = 0;
 
     cl->i_next_drift_update = VLC_TICK_INVALID;
-    AvgInit( &cl->drift, 10 );
+    DriftInit( &cl->drift, 10 );
 
     cl->late.i_index = 0;
     for( int i = 0; i < INPUT_CLOCK_LATE_COUNT; i++ )
@@ -188,7 +221,6 @@ input_clock_t *input_clock_New( float rate )
  *****************************************************************************/
 void input_clock_Delete( input_clock_t *cl )
 {
-    AvgClean( &cl->drift );
     free( cl );
 }
 
@@ -232,7 +264,7 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
     if( b_reset_reference )
     {
         cl->i_next_drift_update = VLC_TICK_INVALID;
-        AvgReset( &cl->drift );
+        DriftReset( &cl->drift );
 
         /* Feed synchro with a new reference point. */
         cl->b_has_reference = true;
@@ -243,13 +275,19 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* Compute the drift between the stream clock and the system clock
      * when we don't control the source pace */
-    if( !b_can_pace_control && cl->i_next_drift_update < i_ck_system )
+    if( !b_can_pace_control )
     {
         const vlc_tick_t i_converted = ClockSystemToStream( cl, i_ck_system );
+        /* Every sample feeds the jitter estimation, the loop itself is
+         * updated at a fixed pace so that its time constant only depends on
+         * cr-average */
+        const bool b_loop = cl->i_next_drift_update < i_ck_system;
 
-        AvgUpdate( &cl->drift, i_converted - i_ck_stream );
+        DriftUpdate( &cl->drift, b_loop, i_ck_system,
+                     i_converted - i_ck_stream );
 
-        cl->i_next_drift_update = i_ck_system + VLC_TICK_FROM_MS(200); /* FIXME why that */
+        if( b_loop )
+            cl->i_next_drift_update = i_ck_system + VLC_TICK_FROM_MS(200); /* FIXME why that */
     }
 
     /* Update the extra buffering value */
@@ -275,7 +313,7 @@ vlc_tick_t input_clock_Update( input_clock_t *cl, vlc_object_t *p_log,
 
     /* It does not take the decoder latency into account but it is not really
      * the goal of the clock here */
-    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + AvgGet( &cl->drift ) );
+    const vlc_tick_t i_system_expected = ClockStreamToSystem( cl, i_ck_stream + DriftGet( &cl->drift ) );
     const vlc_tick_t i_late = ( i_ck_system - cl->i_pts_delay ) - i_system_expected;
     if( i_late > 0 )
     {
@@ -356,7 +394,7 @@ vlc_tick_t input_clock_GetWakeup( input_clock_t *cl )
 
     /* Synchronized, we can wait */
     if( cl->b_has_reference )
-        i_wakeup = ClockStreamToSystem( cl, cl->last.stream + AvgGet( &cl->drift ) - cl->i_buffering_duration );
+        i_wakeup = ClockStreamToSystem( cl, cl->last.stream + DriftGet( &cl->drift ) - cl->i_buffering_duration );
 
     vlc_mutex_unlock( &cl->lock );
 
@@ -394,7 +432,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* */
     if( *pi_ts0 != VLC_TICK_INVALID )
     {
-        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + AvgGet( &cl->drift ) );
+        *pi_ts0 = ClockStreamToSystem( cl, *pi_ts0 + DriftGet( &cl->drift ) );
         if( *pi_ts0 > cl->i_ts_max )
             cl->i_ts_max = *pi_ts0;
         *pi_ts0 += i_ts_delay;
@@ -403,7 +441,7 @@ int input_clock_ConvertTS( vlc_object_t *p_object, input_clock_t *cl,
     /* XXX we do not update i_ts_max on purpose */
     if( pi_ts1 && *pi_ts1 != VLC_TICK_INVALID )
     {
-        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + AvgGet( &cl->drift ) ) +
+        *pi_ts1 = ClockStreamToSystem( cl, *pi_ts1 + DriftGet( &cl->drift ) ) +
                   i_ts_delay;
     }
 
@@ -530,8 +568,9 @@ void input_clock_SetJitter( input_clock_t *cl,
     if( i_cr_average < 10 )
         i_cr_average = 10;
 
-    if( cl->drift.range != i_cr_average )
-        AvgRescale( &cl->drift, i_cr_average );
+    cl->drift.range = i_cr_average;
+    if( cl->drift.count > i_cr_average )
+        cl->drift.count = i_cr_average;
 
     vlc_mutex_unlock( &cl->lock );
 }
@@ -553,9 +592,32 @@ vlc_tick_t input_clock_GetJitter( input_clock_t *cl )
     vlc_tick_t i_late_median = p[0] + p[1] + p[2] - __MIN(__MIN(p[0],p[1]),p[2]) - __MAX(__MAX(p[0],p[1]),p[2]);
     vlc_tick_t i_pts_delay = cl->i_pts_delay ;
 
+    /* Cover the measured PCR jitter, even if the last late values were
+     * not representative of it */
+    const vlc_tick_t i_jitter = INPUT_CLOCK_JITTER_MARGIN * cl->drift.jitter;
+
     vlc_mutex_unlock( &cl->lock );
 
-    return i_pts_delay + i_late_median;
+    return i_pts_delay + __MAX( i_late_median, i_jitter );
+}
+
+int input_clock_GetDrift( input_clock_t *cl, vlc_tick_t *pi_drift,
+                          vlc_tick_t *pi_jitter )
+{
+    vlc_mutex_lock( &cl->lock );
+
+    if( !cl->b_has_reference || cl->drift.date == VLC_TICK_INVALID )
+    {
+        vlc_mutex_unlock( &cl->lock );
+        return VLC_EGENERIC;
+    }
+
+    *pi_drift = DriftGet( &cl->drift );
+    *pi_jitter = cl->drift.jitter;
+
+    vlc_mutex_unlock( &cl->lock );
+
+    return VLC_SUCCESS;
 }
 
 /*****************************************************************************
@@ -589,3 +651,68 @@ static vlc_tick_t ClockGetTsOffset( input_clock_t *cl )
     return cl->i_pts_delay * ( 1.0f / cl->rate - 1.0f );
 }
 
+
+/*****************************************************************************
+ * Drift estimator
+ *****************************************************************************/
+static void DriftInit( drift_estimator_t *d, int range )
+{
+    d->range = range;
+    DriftReset( d );
+}
+
+static void DriftReset( drift_estimator_t *d )
+{
+    d->offset = 0.;
+    d->slope = 0.;
+    d->jitter = 0.;
+    d->date = VLC_TICK_INVALID;
+    d->count = 0;
+}
+
+static void DriftUpdate( drift_estimator_t *d, bool b_loop,
+                         vlc_tick_t i_system, vlc_tick_t i_sample )
+{
+    if( d->date == VLC_TICK_INVALID )
+    {
+        d->offset = i_sample;
+        d->date = i_system;
+        d->count = 1;
+        return;
+    }
+
+    const vlc_tick_t i_elapsed = i_system - d->date;
+    double error = i_sample - ( d->offset + d->slope * i_elapsed );
+
+    d->jitter += ( fabs( error ) - d->jitter ) / INPUT_CLOCK_JITTER_WEIGHT;
+
+    if( !b_loop || i_elapsed <= 0 )
+        return;
+
+    /* Clip the outliers once the jitter is known */
+    if( d->count >= INPUT_CLOCK_JITTER_WEIGHT )
+    {
+        const double max = INPUT_CLOCK_JITTER_MARGIN * d->jitter;
+        if( error > max )
+            error = max;
+        else if( error < -max )
+            error = -max;
+    }
+
+    /* Behave as a cumulative average until range samples are known, and
+     * only track the slope once the offset is settled */
+    if( d->count < d->range )
+        d->count++;
+    const double alpha = 1. / d->count;
+    const double beta = d->count < d->range ? 0.
+                      : 2. * ( 2. - alpha ) - 4. * sqrt( 1. - alpha );
+
+    d->offset += d->slope * i_elapsed + alpha * error;
+    d->slope += beta * error / i_elapsed;
+    d->date = i_system;
+}
+
+static vlc_tick_t DriftGet( const drift_estimator_t *d )
+{
+    return d->offset;
+}
@@ -135,4 +135,12 @@ void input_clock_SetJitter( input_clock_t *,
  */
 vlc_tick_t input_clock_GetJitter( input_clock_t * );
 
+/**
+ * This function returns the estimated drift between the stream and the system
+ * clocks, and the mean deviation of the clock references arrival (jitter).
+ * It returns VLC_EGENERIC if the pace is controlled or without reference.
+ */
+int input_clock_GetDrift( input_clock_t *, vlc_tick_t *pi_drift,
+                          vlc_tick_t *pi_jitter );
+
 #endif
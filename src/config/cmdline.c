@@ -63,7 +63,7 @@ int config_LoadCmdLine( vlc_object_t *p_this, int i_argc,
 #define b_ignore_errors (pindex == NULL)
 
     /* Short options */
-    const module_config_t *pp_shortopts[256];
+    const struct vlc_config_ref *pp_shortopts[256];
     char *psz_shortopts;
 
     /*
@@ -112,62 +112,59 @@ int config_LoadCmdLine( vlc_object_t *p_this, int i_argc,
 
     /* Fill the p_longopts and psz_shortopts structures */
     i_index = 0;
-    for (const vlc_plugin_t *p = vlc_plugins; p != NULL; p = p->next)
-    {
-        for (const module_config_t *p_item = p->conf.items,
-                                   *p_end = p_item + p->conf.size;
-             p_item < p_end;
-             p_item++)
-        {
-            /* Ignore hints */
-            if( !CONFIG_ITEM(p_item->i_type) )
-                continue;
-
-            /* Add item to long options */
-            p_longopts[i_index].name = strdup( p_item->psz_name );
-            if( p_longopts[i_index].name == NULL ) continue;
-            p_longopts[i_index].flag = &flag;
-            p_longopts[i_index].val = 0;
+    const struct vlc_config_ref *refs;
+    size_t refc = config_GetRefs(&refs);
 
-            if( CONFIG_CLASS(p_item->i_type) != CONFIG_ITEM_BOOL )
-                p_longopts[i_index].has_arg = true;
-            else
-            /* Booleans also need --no-foo and --nofoo options */
-            {
-                char *psz_name;
+    /* Use the configuration index, so that the items of plugins that are
+     * not used do not need to be resolved. Hints are not indexed. */
+    for (const struct vlc_config_ref *p_item = refs, *p_end = refs + refc;
+         p_item < p_end;
+         p_item++)
+    {
+        /* Add item to long options */
+        p_longopts[i_index].name = strdup( p_item->name );
+        if( p_longopts[i_index].name == NULL ) continue;
+        p_longopts[i_index].flag = &flag;
+        p_longopts[i_index].val = 0;
 
-                p_longopts[i_index].has_arg = false;
-                i_index++;
+        if( CONFIG_CLASS(p_item->type) != CONFIG_ITEM_BOOL )
+            p_longopts[i_index].has_arg = true;
+        else
+        /* Booleans also need --no-foo and --nofoo options */
+        {
+            char *psz_name;
 
-                if( asprintf( &psz_name, "no%s", p_item->psz_name ) == -1 )
-                    continue;
-                p_longopts[i_index].name = psz_name;
-                p_longopts[i_index].has_arg = false;
-                p_longopts[i_index].flag = &flag;
-                p_longopts[i_index].val = 1;
-                i_index++;
+            p_longopts[i_index].has_arg = false;
+            i_index++;
 
-                if( asprintf( &psz_name, "no-%s", p_item->psz_name ) == -1 )
-                    continue;
-                p_longopts[i_index].name = psz_name;
-                p_longopts[i_index].has_arg = false;
-                p_longopts[i_index].flag = &flag;
-                p_longopts[i_index].val = 1;
-            }
+            if( asprintf( &psz_name, "no%s", p_item->name ) == -1 )
+                continue;
+            p_longopts[i_index].name = psz_name;
+            p_longopts[i_index].has_arg = false;
+            p_longopts[i_index].flag = &flag;
+            p_longopts[i_index].val = 1;
             i_index++;
 
-            /* If item also has a short option, add it */
-            if( p_item->i_short )
+            if( asprintf( &psz_name, "no-%s", p_item->name ) == -1 )
+                continue;
+            p_longopts[i_index].name = psz_name;
+            p_longopts[i_index].has_arg = false;
+            p_longopts[i_index].flag = &flag;
+            p_longopts[i_index].val = 1;
+        }
+        i_index++;
+
+        /* If item also has a short option, add it */
+        if( p_item->shortname )
+        {
+            pp_shortopts[(int)p_item->shortname] = p_item;
+            psz_shortopts[i_shortopts] = p_item->shortname;
+            i_shortopts++;
+            if( p_item->type != CONFIG_ITEM_BOOL
+             && p_item->shortname != 'v' )
             {
-                pp_shortopts[(int)p_item->i_short] = p_item;
-                psz_shortopts[i_shortopts] = p_item->i_short;
+                psz_shortopts[i_shortopts] = ':';
                 i_shortopts++;
-                if( p_item->i_type != CONFIG_ITEM_BOOL
-                 && p_item->i_short != 'v' )
-                {
-                    psz_shortopts[i_shortopts] = ':';
-                    i_shortopts++;
-                }
             }
         }
     }
@@ -242,8 +239,8 @@ int config_LoadCmdLine( vlc_object_t *p_this, int i_argc,
         /* A short option has been recognized */
         if( pp_shortopts[i_cmd] != NULL )
         {
-            const char *name = pp_shortopts[i_cmd]->psz_name;
-            switch( CONFIG_CLASS(pp_shortopts[i_cmd]->i_type) )
+            const char *name = pp_shortopts[i_cmd]->name;
+            switch( CONFIG_CLASS(pp_shortopts[i_cmd]->type) )
             {
                 case CONFIG_ITEM_STRING:
                     var_Create( p_this, name, VLC_VAR_STRING );
@@ -41,6 +41,19 @@ bool config_PrintHelp (vlc_object_t *);
 int config_SortConfig (void);
 void config_UnsortConfig (void);
 
+/** Entry in the index of configuration items */
+struct vlc_config_ref
+{
+    const char *name; /**< Option name */
+    struct vlc_plugin_t *plugin; /**< Plugin owning the item */
+    unsigned index; /**< Index of the item within the plugin */
+    uint8_t type; /**< Configuration type */
+    char shortname; /**< Optional short option name */
+};
+
+size_t config_GetRefs(const struct vlc_config_ref **);
+module_config_t *config_ResolveRef(const struct vlc_config_ref *);
+
 #define CONFIG_CLASS(x) ((x) & ~0x1F)
 
 #define IsConfigStringType(type) \
@@ -36,6 +36,7 @@
 
 #include "configuration.h"
 #include "modules/modules.h"
+#include "misc/variables.h"
 
 vlc_rwlock_t config_lock = VLC_STATIC_RWLOCK;
 bool config_dirty = false;
@@ -45,17 +46,19 @@ static inline char *strdupnull (const char *src)
     return src ? strdup (src) : NULL;
 }
 
+static const struct vlc_config_ref *config_FindRef(const char *);
+
 int config_GetType(const char *psz_name)
 {
-    module_config_t *p_config = config_FindConfig(psz_name);
+    const struct vlc_config_ref *ref = config_FindRef(psz_name);
 
     /* sanity checks */
-    if( !p_config )
+    if( !ref )
     {
         return 0;
     }
 
-    switch( CONFIG_CLASS(p_config->i_type) )
+    switch( CONFIG_CLASS(ref->type) )
     {
         case CONFIG_ITEM_FLOAT:
             return VLC_VAR_FLOAT;
@@ -148,6 +151,7 @@ void config_PutPsz(const char *psz_name, const char *psz_value)
     p_config->value.psz = str;
     config_dirty = true;
     vlc_rwlock_unlock (&config_lock);
+    var_InvalidateValues();
 
     free (oldstr);
 }
@@ -169,6 +173,7 @@ void config_PutInt(const char *psz_name, int64_t i_value )
     p_config->value.i = i_value;
     config_dirty = true;
     vlc_rwlock_unlock (&config_lock);
+    var_InvalidateValues();
 }
 
 void config_PutFloat(const char *psz_name, float f_value)
@@ -191,6 +196,7 @@ void config_PutFloat(const char *psz_name, float f_value)
     p_config->value.f = f_value;
     config_dirty = true;
     vlc_rwlock_unlock (&config_lock);
+    var_InvalidateValues();
 }
 
 ssize_t config_GetIntChoices(const char *name,
@@ -384,24 +390,42 @@ error:
 
 static int confcmp (const void *a, const void *b)
 {
-    const module_config_t *const *ca = a, *const *cb = b;
+    const struct vlc_config_ref *ca = a, *cb = b;
 
-    return strcmp ((*ca)->psz_name, (*cb)->psz_name);
+    return strcmp (ca->name, cb->name);
 }
 
 static int confnamecmp (const void *key, const void *elem)
 {
-    const module_config_t *const *conf = elem;
+    const struct vlc_config_ref *conf = elem;
 
-    return strcmp (key, (*conf)->psz_name);
+    return strcmp (key, conf->name);
 }
 
 static struct
 {
-    module_config_t **list;
+    struct vlc_config_ref *list;
     size_t count;
 } config = { NULL, 0 };
 
+static void config_DescribeItem(vlc_plugin_t *p, size_t i,
+                                struct vlc_config_ref *ref)
+{
+    ref->plugin = p;
+    ref->index = i;
+#ifdef HAVE_DYNAMIC_PLUGINS
+    /* Do not resolve cached configuration items just to index them */
+    if (vlc_cache_describe_config(p, i, &ref->type, &ref->name,
+                                  &ref->shortname))
+        return;
+#endif
+    const module_config_t *item = vlc_plugin_conf(p) + i;
+
+    ref->type = item->i_type;
+    ref->name = item->psz_name;
+    ref->shortname = item->i_short;
+}
+
 /**
  * Index the configuration items by name for faster lookups.
  */
@@ -411,24 +435,23 @@ int config_SortConfig (void)
     size_t nconf = 0;
 
     for (p = vlc_plugins; p != NULL; p = p->next)
-         nconf += p->conf.size;
+         nconf += p->conf.count;
 
-    module_config_t **clist = vlc_alloc (nconf, sizeof (*clist));
+    struct vlc_config_ref *clist = vlc_alloc (nconf, sizeof (*clist));
     if (unlikely(clist == NULL))
         return VLC_ENOMEM;
 
     nconf = 0;
     for (p = vlc_plugins; p != NULL; p = p->next)
     {
-        module_config_t *item, *end;
-
-        for (item = p->conf.items, end = item + p->conf.size;
-             item < end;
-             item++)
+        for (size_t i = 0; i < p->conf.size; i++)
         {
-            if (!CONFIG_ITEM(item->i_type))
+            struct vlc_config_ref *ref = clist + nconf;
+
+            config_DescribeItem(p, i, ref);
+            if (!CONFIG_ITEM(ref->type))
                 continue; /* ignore hints */
-            clist[nconf++] = item;
+            nconf++;
         }
     }
 
@@ -441,7 +464,7 @@ int config_SortConfig (void)
 
 void config_UnsortConfig (void)
 {
-    module_config_t **clist;
+    struct vlc_config_ref *clist;
 
     clist = config.list;
     config.list = NULL;
@@ -450,14 +473,31 @@ void config_UnsortConfig (void)
     free (clist);
 }
 
-module_config_t *config_FindConfig(const char *name)
+size_t config_GetRefs(const struct vlc_config_ref **refs)
+{
+    *refs = config.list;
+    return config.count;
+}
+
+module_config_t *config_ResolveRef(const struct vlc_config_ref *ref)
+{
+    return vlc_plugin_conf(ref->plugin) + ref->index;
+}
+
+static const struct vlc_config_ref *config_FindRef(const char *name)
 {
     if (unlikely(name == NULL))
         return NULL;
 
-    module_config_t *const *p;
-    p = bsearch (name, config.list, config.count, sizeof (*p), confnamecmp);
-    return p ? *p : NULL;
+    return bsearch (name, config.list, config.count, sizeof (*config.list),
+                    confnamecmp);
+}
+
+module_config_t *config_FindConfig(const char *name)
+{
+    const struct vlc_config_ref *ref = config_FindRef(name);
+
+    return (ref != NULL) ? config_ResolveRef(ref) : NULL;
 }
 
 /**
@@ -489,6 +529,11 @@ void config_ResetAll(void)
     vlc_rwlock_wrlock (&config_lock);
     for (vlc_plugin_t *p = vlc_plugins; p != NULL; p = p->next)
     {
+#ifdef HAVE_DYNAMIC_PLUGINS
+        /* Unresolved items cannot have been changed */
+        if (atomic_load_explicit(&p->conf.cache, memory_order_acquire))
+            continue;
+#endif
         for (size_t i = 0; i < p->conf.size; i++ )
         {
             module_config_t *p_config = p->conf.items + i;
@@ -508,4 +553,5 @@ void config_ResetAll(void)
         }
     }
     vlc_rwlock_unlock (&config_lock);
+    var_InvalidateValues();
 }
@@ -439,7 +439,7 @@ int config_SaveConfigFile (vlc_object_t *p_this)
         else
             fprintf( file, "\n\n" );
 
-        for (p_item = p->conf.items, p_end = p_item + p->conf.size;
+        for (p_item = vlc_plugin_conf(p), p_end = p_item + p->conf.size;
              p_item < p_end;
              p_item++)
         {
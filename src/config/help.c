@@ -565,9 +565,11 @@ static bool module_match(const module_t *m, const char *pattern, bool strict)
 
 static bool plugin_show(const vlc_plugin_t *plugin)
 {
+    const module_config_t *items = vlc_plugin_conf(plugin);
+
     for (size_t i = 0; i < plugin->conf.size; i++)
     {
-        const module_config_t *item = plugin->conf.items + i;
+        const module_config_t *item = items + i;
 
         if (!CONFIG_ITEM(item->i_type))
             continue;
@@ -620,9 +622,11 @@ static void Usage (vlc_object_t *p_this, char const *psz_search)
                    module_gettext(m, m->psz_help));
 
         /* Print module options */
+        const module_config_t *items = vlc_plugin_conf(p);
+
         for (size_t j = 0; j < p->conf.size; j++)
         {
-            const module_config_t *item = p->conf.items + j;
+            const module_config_t *item = items + j;
 
             if (item->b_removed)
                 continue; /* Skip removed options */
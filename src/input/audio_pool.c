@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * audio_pool.c: recycling pool of audio decoder buffers
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+
+#include "audio_pool.h"
+#include "../libvlc.h"
+
+/* Most recycled buffers; more are only needed while the output is late */
+#define AUDIO_POOL_MAX 32
+/* Same alignment and padding as block_Alloc() */
+#define AUDIO_POOL_ALIGN 32
+#define AUDIO_POOL_PADDING 32
+#define AUDIO_POOL_OVERHEAD (AUDIO_POOL_ALIGN + 2 * AUDIO_POOL_PADDING)
+
+struct vlc_audio_pool
+{
+    vlc_atomic_rc_t rc; /* owner and buffers in use */
+    vlc_mutex_t lock;
+    block_t *free; /* recycled buffers, linked by p_next */
+    unsigned free_count;
+    size_t size; /* payload capacity of the recycled buffers */
+    bool closed; /* no owner anymore */
+    atomic_uint hits;
+    atomic_uint misses;
+};
+
+struct vlc_audio_buffer
+{
+    block_t self;
+    struct vlc_audio_pool *pool;
+    size_t capacity;
+    unsigned char storage[];
+};
+
+static void vlc_audio_buffers_Free(block_t *chain)
+{
+    while (chain != NULL)
+    {
+        block_t *block = chain;
+
+        chain = block->p_next;
+        free(container_of(block, struct vlc_audio_buffer, self));
+    }
+}
+
+static void vlc_audio_pool_Unref(struct vlc_audio_pool *pool)
+{
+    if (!vlc_atomic_rc_dec(&pool->rc))
+        return;
+
+    assert(pool->free == NULL);
+    free(pool);
+}
+
+static void vlc_audio_buffer_Release(block_t *block)
+{
+    struct vlc_audio_buffer *b = container_of(block, struct vlc_audio_buffer,
+                                              self);
+    struct vlc_audio_pool *pool = b->pool;
+
+    vlc_mutex_lock(&pool->lock);
+    bool recycle = !pool->closed && b->capacity == pool->size
+                && pool->free_count < AUDIO_POOL_MAX;
+    if (recycle)
+    {
+        block->p_next = pool->free;
+        pool->free = block;
+        pool->free_count++;
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    if (!recycle)
+        free(b);
+    vlc_audio_pool_Unref(pool);
+}
+
+static const struct vlc_block_callbacks vlc_audio_buffer_cbs =
+{
+    vlc_audio_buffer_Release,
+};
+
+struct vlc_audio_pool *vlc_audio_pool_New(void)
+{
+    struct vlc_audio_pool *pool = malloc(sizeof (*pool));
+    if (unlikely(pool == NULL))
+        return NULL;
+
+    vlc_atomic_rc_init(&pool->rc);
+    vlc_mutex_init(&pool->lock);
+    pool->free = NULL;
+    pool->free_count = 0;
+    pool->size = 0;
+    pool->closed = false;
+    atomic_init(&pool->hits, 0);
+    atomic_init(&pool->misses, 0);
+    return pool;
+}
+
+/* Takes the recycled buffers out of the pool (with the lock held) */
+static block_t *vlc_audio_pool_TakeAll(struct vlc_audio_pool *pool)
+{
+    block_t *chain = pool->free;
+
+    pool->free = NULL;
+    pool->free_count = 0;
+    return chain;
+}
+
+void vlc_audio_pool_Release(struct vlc_audio_pool *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->closed = true;
+    block_t *chain = vlc_audio_pool_TakeAll(pool);
+    vlc_mutex_unlock(&pool->lock);
+
+    vlc_audio_buffers_Free(chain);
+    vlc_audio_pool_Unref(pool);
+}
+
+void vlc_audio_pool_Reset(struct vlc_audio_pool *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    block_t *chain = vlc_audio_pool_TakeAll(pool);
+    pool->size = 0;
+    vlc_mutex_unlock(&pool->lock);
+
+    vlc_audio_buffers_Free(chain);
+}
+
+block_t *vlc_audio_pool_Get(struct vlc_audio_pool *pool, size_t size)
+{
+    block_t *stale = NULL, *block;
+    size_t capacity;
+
+    vlc_mutex_lock(&pool->lock);
+    if (size > pool->size)
+    {   /* Recycled buffers are too small: use the new size from now on */
+        stale = vlc_audio_pool_TakeAll(pool);
+        pool->size = size;
+    }
+    capacity = pool->size;
+    block = pool->free;
+    if (block != NULL)
+    {
+        pool->free = block->p_next;
+        pool->free_count--;
+    }
+    vlc_mutex_unlock(&pool->lock);
+
+    vlc_audio_buffers_Free(stale);
+
+    struct vlc_audio_buffer *b;
+
+    if (block != NULL)
+    {
+        b = container_of(block, struct vlc_audio_buffer, self);
+        assert(b->capacity >= size);
+        atomic_fetch_add_explicit(&pool->hits, 1, memory_order_relaxed);
+    }
+    else
+    {
+        if (unlikely(capacity > SIZE_MAX - sizeof (*b) - AUDIO_POOL_OVERHEAD))
+            return NULL;
+
+        vlc_mem_CountAllocation();
+        b = malloc(sizeof (*b) + AUDIO_POOL_OVERHEAD + capacity);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        b->pool = pool;
+        b->capacity = capacity;
+        atomic_fetch_add_explicit(&pool->misses, 1, memory_order_relaxed);
+    }
+
+    vlc_atomic_rc_inc(&pool->rc);
+    block = block_Init(&b->self, &vlc_audio_buffer_cbs, b->storage,
+                       AUDIO_POOL_OVERHEAD + b->capacity);
+    block->p_buffer += AUDIO_POOL_PADDING + AUDIO_POOL_ALIGN - 1;
+    block->p_buffer = (void *)(((uintptr_t)block->p_buffer)
+                               & ~(uintptr_t)(AUDIO_POOL_ALIGN - 1));
+    block->i_buffer = size;
+    return block;
+}
+
+void vlc_audio_pool_GetResetStats(struct vlc_audio_pool *pool,
+                                  unsigned *hits, unsigned *misses)
+{
+    *hits = atomic_exchange_explicit(&pool->hits, 0, memory_order_relaxed);
+    *misses = atomic_exchange_explicit(&pool->misses, 0,
+                                       memory_order_relaxed);
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * audio_pool.h: recycling pool of audio decoder buffers
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef LIBVLC_INPUT_AUDIO_POOL_H
+#define LIBVLC_INPUT_AUDIO_POOL_H 1
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+/**
+ * Pool of audio buffers of one decoder.
+ *
+ * The size of the decoded buffers is constant for a given output format. The
+ * pool keeps the released buffers of the current size, and hands them out
+ * again instead of allocating new ones.
+ *
+ * Buffers may outlive the decoder, e.g. when the audio output keeps them:
+ * each buffer holds a reference to the pool.
+ */
+struct vlc_audio_pool;
+
+/**
+ * Creates an audio buffer pool.
+ *
+ * \return the pool, or NULL on memory error
+ */
+struct vlc_audio_pool *vlc_audio_pool_New(void);
+
+/**
+ * Releases the pool reference of its owner.
+ *
+ * The pool is destroyed once all its buffers are released too.
+ */
+void vlc_audio_pool_Release(struct vlc_audio_pool *);
+
+/**
+ * Drops the recycled buffers (e.g. when the output format changes).
+ */
+void vlc_audio_pool_Reset(struct vlc_audio_pool *);
+
+/**
+ * Gets a buffer from the pool.
+ *
+ * The buffer is released with block_Release(), which returns it to the pool.
+ *
+ * \param size payload size in bytes
+ * \return a buffer, or NULL on memory error
+ */
+block_t *vlc_audio_pool_Get(struct vlc_audio_pool *, size_t size);
+
+/**
+ * Gets and resets the counters of the pool.
+ *
+ * \param hits storage for the number of recycled buffers [OUT]
+ * \param misses storage for the number of allocated buffers [OUT]
+ */
+void vlc_audio_pool_GetResetStats(struct vlc_audio_pool *,
+                                  unsigned *hits, unsigned *misses);
+
+#endif
@@ -43,10 +43,13 @@
 #include <vlc_modules.h>
 #include <vlc_decoder.h>
 #include <vlc_picture_pool.h>
+#include <vlc_tracer.h>
+#include <vlc_memstats.h>
 
 #include "audio_output/aout_internal.h"
 #include "stream_output/stream_output.h"
 #include "../clock/clock.h"
+#include "audio_pool.h"
 #include "decoder.h"
 #include "resource.h"
 
@@ -62,6 +65,9 @@ enum reload
     RELOAD_DECODER_AOUT /* Stop the aout and reload the decoder module */
 };
 
+/* Number of block arrival dates kept to measure the latency */
+#define DECODER_ARRIVALS 32
+
 struct vlc_input_decoder_t
 {
     decoder_t        dec;
@@ -79,6 +85,9 @@ struct vlc_input_decoder_t
 
     vlc_thread_t     thread;
 
+    /* Optional output stage (NULL if outputting from the ModuleThread) */
+    struct decoder_output *output;
+
     /* Some decoders require already packetized data (ie. not truncated) */
     decoder_t *p_packetizer;
     bool b_packetizer;
@@ -87,6 +96,14 @@ struct vlc_input_decoder_t
     es_format_t    fmt;
     vlc_video_context *vctx;
 
+    /* Inherited options read by the decoder thread */
+    struct
+    {
+        vlc_var_snapshot_t snapshot;
+        bool hw_dec;
+        int force_dolby;
+    } opts;
+
     /* */
     atomic_bool    b_fmt_description;
     vlc_meta_t     *p_description;
@@ -103,6 +120,8 @@ struct vlc_input_decoder_t
 
     /* pool to use when the decoder doesn't use its own */
     struct picture_pool_t *out_pool;
+    /* pool of the audio decoder buffers, or NULL */
+    struct vlc_audio_pool *audio_pool;
 
     /*
      * 3 threads can read/write these output variables, the DecoderThread, the
@@ -152,6 +171,27 @@ struct vlc_input_decoder_t
     bool b_first;
     bool b_has_data;
 
+    /* Thumbnailing */
+    bool b_thumbnailing;
+    bool b_keyframes_only;
+
+    /* Tracer, or NULL */
+    struct vlc_tracer *tracer;
+
+    /* Memory account of the FIFO, or NULL */
+    vlc_mem_account_t *fifo_account;
+
+    /* Statistics: the arrival dates of the last queued blocks, by timestamp,
+     * protected by the FIFO lock, and the depth of the FIFO when the current
+     * block was dequeued */
+    struct
+    {
+        vlc_tick_t ts;
+        vlc_tick_t date;
+    } arrivals[DECODER_ARRIVALS];
+    unsigned arrival_next;
+    unsigned fifo_depth;
+
     /* Flushing */
     bool flushing;
     bool b_draining;
@@ -194,6 +234,107 @@ static inline vlc_input_decoder_t *dec_get_owner( decoder_t *p_dec )
     return container_of( p_dec, vlc_input_decoder_t, dec );
 }
 
+/*
+ * Optional output stage: decoded pictures or audio buffers are handed over to
+ * a dedicated thread through a bounded queue, so that the DecoderThread can
+ * decode the next block while the previous frame is prerolled and queued to
+ * the output.
+ *
+ * Whenever the DecoderThread or the ModuleThread needs a consistent output
+ * state (flush, drain, pause, rate or delay changes, output (re)creation,
+ * going idle), it first waits for the stage with DecoderOutput_Sync(), so
+ * the output is never used concurrently and the queue is transparent.
+ */
+struct decoder_output
+{
+    vlc_thread_t thread;
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait_data; /* an item was queued, or closing */
+    vlc_cond_t   wait_done; /* an item was dequeued or output */
+
+    void (*play)( vlc_input_decoder_t *, void * );
+    void (*discard)( void * );
+
+    unsigned head;
+    unsigned count;
+    unsigned size;
+    bool     busy; /* the output thread is outputting an item */
+    bool     closing;
+    void    *items[];
+};
+
+static void DecoderOutput_Queue( struct decoder_output *out, void *item )
+{
+    vlc_mutex_lock( &out->lock );
+    while( out->count >= out->size )
+        vlc_cond_wait( &out->wait_done, &out->lock );
+
+    out->items[(out->head + out->count) % out->size] = item;
+    out->count++;
+    vlc_cond_signal( &out->wait_data );
+    vlc_mutex_unlock( &out->lock );
+}
+
+/**
+ * Drops all the queued items (but not the one being output, if any).
+ */
+static void DecoderOutput_Discard( struct decoder_output *out )
+{
+    vlc_mutex_lock( &out->lock );
+    while( out->count > 0 )
+    {
+        out->discard( out->items[out->head] );
+        out->head = (out->head + 1) % out->size;
+        out->count--;
+    }
+    vlc_cond_broadcast( &out->wait_done );
+    vlc_mutex_unlock( &out->lock );
+}
+
+static bool DecoderOutput_IsPending( struct decoder_output *out )
+{
+    vlc_mutex_lock( &out->lock );
+    bool pending = out->count > 0 || out->busy;
+    vlc_mutex_unlock( &out->lock );
+    return pending;
+}
+
+/**
+ * Waits until all the queued items have been output.
+ */
+static void DecoderOutput_Sync( struct decoder_output *out )
+{
+    vlc_mutex_lock( &out->lock );
+    while( out->count > 0 || out->busy )
+        vlc_cond_wait( &out->wait_done, &out->lock );
+    vlc_mutex_unlock( &out->lock );
+}
+
+/**
+ * Inherits the options again if any variable changed since the last time.
+ */
+static void DecoderThread_UpdateOptions( vlc_input_decoder_t *p_owner )
+{
+    decoder_t *p_dec = &p_owner->dec;
+
+    if( !var_SnapshotUpdate( &p_owner->opts.snapshot ) )
+        return;
+
+    p_owner->opts.hw_dec = var_InheritBool( p_dec, "hw-dec" );
+    p_owner->opts.force_dolby =
+        var_InheritInteger( p_dec, "force-dolby-surround" );
+}
+
+static void DecoderThread_SyncOutput( vlc_input_decoder_t *p_owner,
+                                      bool discard )
+{
+    if( p_owner->output == NULL )
+        return;
+    if( discard )
+        DecoderOutput_Discard( p_owner->output );
+    DecoderOutput_Sync( p_owner->output );
+}
+
 /**
  * Load a decoder module
  */
@@ -233,6 +374,8 @@ static int DecoderThread_Reload( vlc_input_decoder_t *p_owner,
     /* Copy p_fmt since it can be destroyed by decoder_Clean */
     decoder_t *p_dec = &p_owner->dec;
     es_format_t fmt_in;
+
+    DecoderThread_SyncOutput( p_owner, false );
     if( es_format_Copy( &fmt_in, p_fmt ) != VLC_SUCCESS )
     {
         p_owner->error = true;
@@ -328,6 +471,7 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
         audio_output_t *p_aout = p_owner->p_aout;
 
         /* Parameters changed, restart the aout */
+        DecoderThread_SyncOutput( p_owner, false );
         vlc_mutex_lock( &p_owner->lock );
         p_owner->p_aout = NULL; // the DecoderThread should not use the old aout anymore
         vlc_mutex_unlock( &p_owner->lock );
@@ -350,12 +494,14 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
 
     if( p_owner->p_aout == NULL )
     {
+        DecoderThread_SyncOutput( p_owner, false );
         p_dec->fmt_out.audio.i_format = p_dec->fmt_out.i_codec;
 
         audio_sample_format_t format = p_dec->fmt_out.audio;
         aout_FormatPrepare( &format );
 
-        const int i_force_dolby = var_InheritInteger( p_dec, "force-dolby-surround" );
+        DecoderThread_UpdateOptions( p_owner );
+        const int i_force_dolby = p_owner->opts.force_dolby;
         if( i_force_dolby &&
             format.i_physical_channels == (AOUT_CHAN_LEFT|AOUT_CHAN_RIGHT) )
         {
@@ -371,7 +517,7 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
         if( p_aout )
         {
             if( aout_DecNew( p_aout, &format, p_dec->fmt_out.i_profile,
-                             p_owner->p_clock,
+                             p_owner->p_clock, p_owner->audio_pool,
                              &p_dec->fmt_out.audio_replay_gain ) )
             {
                 input_resource_PutAout( p_owner->p_resource, p_aout );
@@ -397,6 +543,10 @@ static int ModuleThread_UpdateAudioFormat( decoder_t *p_dec )
         p_dec->fmt_out.audio.i_frame_length =
             p_owner->fmt.audio.i_frame_length;
 
+        /* The buffer size follows the new format */
+        if( p_owner->audio_pool != NULL )
+            vlc_audio_pool_Reset( p_owner->audio_pool );
+
         vlc_fifo_Lock( p_owner->p_fifo );
         p_owner->reset_out_state = true;
         vlc_fifo_Unlock( p_owner->p_fifo );
@@ -550,6 +700,7 @@ static int CreateVoutIfNeeded(vlc_input_decoder_t *p_owner,
         return 0; // vout unchanged
     }
 
+    DecoderThread_SyncOutput( p_owner, false );
     vlc_mutex_lock( &p_owner->lock );
 
     vout_thread_t *p_vout = p_owner->p_vout;
@@ -603,7 +754,8 @@ static vlc_decoder_device * ModuleThread_GetDecoderDevice( decoder_t *p_dec )
     vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
 
     /* Requesting a decoder device will automatically enable hw decoding */
-    if( !var_InheritBool( p_dec, "hw-dec" ) )
+    DecoderThread_UpdateOptions( p_owner );
+    if( !p_owner->opts.hw_dec )
         return NULL;
 
     enum vlc_vout_order vout_order;
@@ -809,7 +961,9 @@ block_t *decoder_NewAudioBuffer( decoder_t *dec, int samples )
 
     size_t length = samples * dec->fmt_out.audio.i_bytes_per_frame
                             / dec->fmt_out.audio.i_frame_length;
-    block_t *block = block_Alloc( length );
+    block_t *block = ( dec->cbs != NULL && dec->cbs->audio.buffer_new != NULL )
+                   ? dec->cbs->audio.buffer_new( dec, length )
+                   : block_Alloc( length );
     if( likely(block != NULL) )
     {
         block->i_nb_samples = samples;
@@ -818,6 +972,15 @@ block_t *decoder_NewAudioBuffer( decoder_t *dec, int samples )
     return block;
 }
 
+static block_t *ModuleThread_NewAudioBuffer( decoder_t *p_dec, size_t length )
+{
+    vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
+
+    if( p_owner->audio_pool == NULL )
+        return block_Alloc( length );
+    return vlc_audio_pool_Get( p_owner->audio_pool, length );
+}
+
 static void RequestReload( vlc_input_decoder_t *p_owner )
 {
     /* Don't override reload if it's RELOAD_DECODER_AOUT */
@@ -882,6 +1045,16 @@ static int DecoderThread_PlaySout( vlc_input_decoder_t *p_owner, block_t *p_sout
     return sout_InputSendBuffer( p_owner->p_sout_input, p_sout_block );
 }
 
+/* Packetizers allocate on behalf of their own stage */
+static block_t *DecoderPacketize( decoder_t *p_packetizer, block_t **pp_block )
+{
+    enum vlc_mem_stage stage = vlc_mem_SetStage( VLC_MEM_STAGE_PACKETIZER );
+    block_t *p_block = p_packetizer->pf_packetize( p_packetizer, pp_block );
+
+    vlc_mem_SetStage( stage );
+    return p_block;
+}
+
 /* This function process a block for sout
  */
 static void DecoderThread_ProcessSout( vlc_input_decoder_t *p_owner, block_t *p_block )
@@ -890,8 +1063,7 @@ static void DecoderThread_ProcessSout( vlc_input_decoder_t *p_owner, block_t *p_
     block_t *p_sout_block;
     block_t **pp_block = p_block ? &p_block : NULL;
 
-    while( ( p_sout_block =
-                 p_dec->pf_packetize( p_dec, pp_block ) ) )
+    while( ( p_sout_block = DecoderPacketize( p_dec, pp_block ) ) )
     {
         if( p_owner->p_sout_input == NULL )
         {
@@ -1049,6 +1221,24 @@ static void ModuleThread_QueueCc( decoder_t *p_videodec, block_t *p_cc,
     }
 }
 
+/* Returns the delay since the block with the given timestamp was queued */
+static vlc_tick_t DecoderGetLatency( vlc_input_decoder_t *p_owner,
+                                     vlc_tick_t ts )
+{
+    vlc_tick_t latency = VLC_TICK_INVALID;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    for( unsigned i = 0; i < DECODER_ARRIVALS; i++ )
+        if( p_owner->arrivals[i].ts == ts )
+        {
+            latency = vlc_tick_now() - p_owner->arrivals[i].date;
+            p_owner->arrivals[i].ts = VLC_TICK_INVALID;
+            break;
+        }
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    return latency;
+}
+
 static int ModuleThread_PlayVideo( vlc_input_decoder_t *p_owner, picture_t *p_picture )
 {
     decoder_t *p_dec = &p_owner->dec;
@@ -1137,14 +1327,27 @@ static void ModuleThread_UpdateStatVideo( vlc_input_decoder_t *p_owner,
     decoder_Notify(p_owner, on_new_video_stats, 1, vout_lost, displayed);
 }
 
+static void ModuleThread_OutputVideo( vlc_input_decoder_t *p_owner,
+                                      void *p_pic )
+{
+    vlc_tick_t date = ((picture_t *)p_pic)->date;
+    int success = ModuleThread_PlayVideo( p_owner, p_pic );
+
+    ModuleThread_UpdateStatVideo( p_owner, success != VLC_SUCCESS );
+    if( success == VLC_SUCCESS )
+        decoder_Notify( p_owner, on_new_output_timing,
+                        DecoderGetLatency( p_owner, date ), VLC_TICK_INVALID );
+}
+
 static void ModuleThread_QueueVideo( decoder_t *p_dec, picture_t *p_pic )
 {
     assert( p_pic );
     vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
 
-    int success = ModuleThread_PlayVideo( p_owner, p_pic );
-
-    ModuleThread_UpdateStatVideo( p_owner, success != VLC_SUCCESS );
+    if( p_owner->output != NULL )
+        DecoderOutput_Queue( p_owner->output, p_pic );
+    else
+        ModuleThread_OutputVideo( p_owner, p_pic );
 }
 
 static vlc_decoder_device * thumbnailer_get_device( decoder_t *p_dec )
@@ -1242,7 +1445,9 @@ static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, block_t *p_audi
         return VLC_EGENERIC;
     }
 
+    enum vlc_mem_stage stage = vlc_mem_SetStage( VLC_MEM_STAGE_AOUT );
     int status = aout_DecPlay( p_aout, p_audio );
+    vlc_mem_SetStage( stage );
     if( status == AOUT_DEC_CHANGED )
     {
         /* Only reload the decoder */
@@ -1259,26 +1464,46 @@ static int ModuleThread_PlayAudio( vlc_input_decoder_t *p_owner, block_t *p_audi
 }
 
 static void ModuleThread_UpdateStatAudio( vlc_input_decoder_t *p_owner,
-                                          bool lost )
+                                          bool lost, vlc_tick_t date )
 {
     unsigned played = 0;
     unsigned aout_lost = 0;
+    vlc_tick_t drift = VLC_TICK_INVALID;
     if( p_owner->p_aout != NULL )
     {
-        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played );
+        aout_DecGetResetStats( p_owner->p_aout, &aout_lost, &played, &drift );
     }
     if (lost) aout_lost++;
 
-    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played);
+    unsigned pool_hits = 0, pool_misses = 0;
+    if( p_owner->audio_pool != NULL )
+        vlc_audio_pool_GetResetStats( p_owner->audio_pool, &pool_hits,
+                                      &pool_misses );
+
+    decoder_Notify(p_owner, on_new_audio_stats, 1, aout_lost, played,
+                   pool_hits, pool_misses);
+    if( !lost )
+        decoder_Notify( p_owner, on_new_output_timing,
+                        DecoderGetLatency( p_owner, date ), drift );
+}
+
+static void ModuleThread_OutputAudio( vlc_input_decoder_t *p_owner,
+                                      void *p_aout_buf )
+{
+    vlc_tick_t date = ((block_t *)p_aout_buf)->i_pts;
+    int success = ModuleThread_PlayAudio( p_owner, p_aout_buf );
+
+    ModuleThread_UpdateStatAudio( p_owner, success != VLC_SUCCESS, date );
 }
 
 static void ModuleThread_QueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
 {
     vlc_input_decoder_t *p_owner = dec_get_owner( p_dec );
 
-    int success = ModuleThread_PlayAudio( p_owner, p_aout_buf );
-
-    ModuleThread_UpdateStatAudio( p_owner, success != VLC_SUCCESS );
+    if( p_owner->output != NULL )
+        DecoderOutput_Queue( p_owner->output, p_aout_buf );
+    else
+        ModuleThread_OutputAudio( p_owner, p_aout_buf );
 }
 
 static void ModuleThread_PlaySpu( vlc_input_decoder_t *p_owner, subpicture_t *p_subpic )
@@ -1344,7 +1569,29 @@ static void DecoderThread_DecodeBlock( vlc_input_decoder_t *p_owner, block_t *p_
 {
     decoder_t *p_dec = &p_owner->dec;
 
+    if( p_owner->b_thumbnailing && p_block != NULL )
+    {
+        /* Once the thumbnail is generated, nothing else is needed until the
+         * next position. In keyframes only mode, skip the other frames. */
+        vlc_mutex_lock( &p_owner->lock );
+        bool drop = !p_owner->b_first;
+        vlc_mutex_unlock( &p_owner->lock );
+        if( p_owner->b_keyframes_only
+         && ( p_block->i_flags & ( BLOCK_FLAG_TYPE_P | BLOCK_FLAG_TYPE_B ) ) )
+            drop = true;
+        if( drop )
+        {
+            block_Release( p_block );
+            return;
+        }
+    }
+
+    vlc_tick_t start = vlc_tick_now();
     int ret = p_dec->pf_decode( p_dec, p_block );
+    vlc_tracer_End( p_owner->tracer, "decoder", "decode", p_dec, start );
+    if( p_block != NULL )
+        decoder_Notify( p_owner, on_new_decode_timing, p_owner->fifo_depth,
+                        vlc_tick_now() - start );
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1426,7 +1673,7 @@ static void DecoderThread_ProcessInput( vlc_input_decoder_t *p_owner, block_t *p
         decoder_t *p_packetizer = p_owner->p_packetizer;
 
         while( (p_packetized_block =
-                p_packetizer->pf_packetize( p_packetizer, pp_block ) ) )
+                DecoderPacketize( p_packetizer, pp_block ) ) )
         {
             if( !es_format_IsSimilar( &p_dec->fmt_in, &p_packetizer->fmt_out ) )
             {
@@ -1479,6 +1726,8 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     decoder_t *p_dec = &p_owner->dec;
     decoder_t *p_packetizer = p_owner->p_packetizer;
 
+    DecoderThread_SyncOutput( p_owner, true );
+
     if( p_owner->error )
         return;
 
@@ -1526,6 +1775,9 @@ static void DecoderThread_Flush( vlc_input_decoder_t *p_owner )
     }
 
     p_owner->i_preroll_end = PREROLL_NONE;
+    /* A new thumbnail is generated after each seek */
+    if( p_owner->b_thumbnailing )
+        p_owner->b_first = true;
     vlc_mutex_unlock( &p_owner->lock );
 }
 
@@ -1534,6 +1786,7 @@ static void DecoderThread_ChangePause( vlc_input_decoder_t *p_owner, bool paused
     decoder_t *p_dec = &p_owner->dec;
 
     msg_Dbg( p_dec, "toggling %s", paused ? "resume" : "pause" );
+    DecoderThread_SyncOutput( p_owner, false );
     switch( p_dec->fmt_out.i_cat )
     {
         case VIDEO_ES:
@@ -1560,6 +1813,7 @@ static void DecoderThread_ChangeRate( vlc_input_decoder_t *p_owner, float rate )
     decoder_t *p_dec = &p_owner->dec;
 
     msg_Dbg( p_dec, "changing rate: %f", rate );
+    DecoderThread_SyncOutput( p_owner, false );
     vlc_mutex_lock( &p_owner->lock );
     switch( p_dec->fmt_out.i_cat )
     {
@@ -1591,6 +1845,7 @@ static void DecoderThread_ChangeDelay( vlc_input_decoder_t *p_owner, vlc_tick_t
     decoder_t *p_dec = &p_owner->dec;
 
     msg_Dbg( p_dec, "changing delay: %"PRId64, delay );
+    DecoderThread_SyncOutput( p_owner, false );
 
     switch( p_dec->fmt_out.i_cat )
     {
@@ -1621,6 +1876,23 @@ static void DecoderThread_ChangeDelay( vlc_input_decoder_t *p_owner, vlc_tick_t
     }
 }
 
+/**
+ * Waits for the output stage before going idle, so that idle still means
+ * that everything decoded so far was output.
+ *
+ * \return true if the FIFO lock was released meanwhile
+ */
+static bool DecoderThread_SyncOutputLocked( vlc_input_decoder_t *p_owner )
+{
+    if( p_owner->output == NULL || !DecoderOutput_IsPending( p_owner->output ) )
+        return false;
+
+    vlc_fifo_Unlock( p_owner->p_fifo );
+    DecoderOutput_Sync( p_owner->output );
+    vlc_fifo_Lock( p_owner->p_fifo );
+    return true;
+}
+
 /**
  * The decoding main loop
  *
@@ -1633,6 +1905,8 @@ static void *DecoderThread( void *p_data )
     vlc_tick_t delay = 0;
     bool paused = false;
 
+    vlc_mem_SetStage( VLC_MEM_STAGE_DECODER );
+
     /* The decoder's main loop */
     vlc_fifo_Lock( p_owner->p_fifo );
 
@@ -1704,6 +1978,8 @@ static void *DecoderThread( void *p_data )
 
         if( p_owner->paused && p_owner->frames_countdown == 0 )
         {   /* Wait for resumption from pause */
+            if( DecoderThread_SyncOutputLocked( p_owner ) )
+                continue;
             p_owner->b_idle = true;
             vlc_cond_signal( &p_owner->wait_acknowledge );
             vlc_fifo_Wait( p_owner->p_fifo );
@@ -1718,6 +1994,8 @@ static void *DecoderThread( void *p_data )
         {
             if( likely(!p_owner->b_draining) )
             {   /* Wait for a block to decode (or a request to drain) */
+                if( DecoderThread_SyncOutputLocked( p_owner ) )
+                    continue;
                 p_owner->b_idle = true;
                 vlc_cond_signal( &p_owner->wait_acknowledge );
                 vlc_fifo_Wait( p_owner->p_fifo );
@@ -1728,10 +2006,16 @@ static void *DecoderThread( void *p_data )
              * drain. Pass p_block = NULL to decoder just once. */
         }
 
+        p_owner->fifo_depth = vlc_fifo_GetCount( p_owner->p_fifo );
+        vlc_tracer_Counter( p_owner->tracer, "decoder", "queue depth",
+                            &p_owner->dec, p_owner->fifo_depth );
         vlc_fifo_Unlock( p_owner->p_fifo );
 
         DecoderThread_ProcessInput( p_owner, p_block );
 
+        if( p_block == NULL )
+            DecoderThread_SyncOutput( p_owner, false );
+
         if( p_block == NULL && p_owner->dec.fmt_out.i_cat == AUDIO_ES )
         {   /* Draining: the decoder is drained and all decoded buffers are
              * queued to the output at this point. Now drain the output. */
@@ -1755,6 +2039,104 @@ static void *DecoderThread( void *p_data )
     return NULL;
 }
 
+static void *DecoderOutputThread( void *data )
+{
+    vlc_input_decoder_t *p_owner = data;
+    struct decoder_output *out = p_owner->output;
+
+    vlc_mutex_lock( &out->lock );
+    for( ;; )
+    {
+        while( out->count == 0 && !out->closing )
+            vlc_cond_wait( &out->wait_data, &out->lock );
+        if( out->count == 0 )
+            break;
+
+        void *item = out->items[out->head];
+        out->head = (out->head + 1) % out->size;
+        out->count--;
+        out->busy = true;
+        vlc_mutex_unlock( &out->lock );
+
+        out->play( p_owner, item );
+
+        vlc_mutex_lock( &out->lock );
+        out->busy = false;
+        vlc_cond_broadcast( &out->wait_done );
+    }
+    vlc_mutex_unlock( &out->lock );
+    return NULL;
+}
+
+static void DecoderOutput_DiscardPicture( void *pic )
+{
+    picture_Release( pic );
+}
+
+static void DecoderOutput_DiscardBlock( void *block )
+{
+    block_Release( block );
+}
+
+static void DecoderOutput_New( vlc_input_decoder_t *p_owner, int priority )
+{
+    decoder_t *p_dec = &p_owner->dec;
+    int64_t size = var_InheritInteger( p_dec, "dec-output-queue" );
+
+    if( size <= 0 )
+        return;
+
+    struct decoder_output *out = malloc( sizeof (*out)
+                                         + size * sizeof (out->items[0]) );
+    if( unlikely(out == NULL) )
+        return;
+
+    vlc_mutex_init( &out->lock );
+    vlc_cond_init( &out->wait_data );
+    vlc_cond_init( &out->wait_done );
+    if( p_dec->fmt_in.i_cat == VIDEO_ES )
+    {
+        out->play = ModuleThread_OutputVideo;
+        out->discard = DecoderOutput_DiscardPicture;
+    }
+    else
+    {
+        out->play = ModuleThread_OutputAudio;
+        out->discard = DecoderOutput_DiscardBlock;
+    }
+    out->head = out->count = 0;
+    out->size = size;
+    out->busy = out->closing = false;
+
+    p_owner->output = out;
+    if( vlc_clone( &out->thread, DecoderOutputThread, p_owner, priority ) )
+    {
+        msg_Err( p_dec, "cannot spawn decoder output thread" );
+        p_owner->output = NULL;
+        free( out );
+        return;
+    }
+    msg_Dbg( p_dec, "output queue of %u buffers", out->size );
+}
+
+static void DecoderOutput_Delete( vlc_input_decoder_t *p_owner )
+{
+    struct decoder_output *out = p_owner->output;
+
+    if( out == NULL )
+        return;
+
+    DecoderOutput_Discard( out );
+    vlc_mutex_lock( &out->lock );
+    out->closing = true;
+    vlc_cond_signal( &out->wait_data );
+    vlc_mutex_unlock( &out->lock );
+
+    vlc_join( out->thread, NULL );
+    p_owner->output = NULL;
+    free( out );
+}
+
 static const struct decoder_owner_callbacks dec_video_cbs =
 {
     .video = {
@@ -1783,6 +2165,7 @@ static const struct decoder_owner_callbacks dec_audio_cbs =
     .audio = {
         .format_update = ModuleThread_UpdateAudioFormat,
         .queue = ModuleThread_QueueAudio,
+        .buffer_new = ModuleThread_NewAudioBuffer,
     },
     .get_attachments = InputThread_GetInputAttachments,
 };
@@ -1833,9 +2216,11 @@ CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
     p_owner->p_packetizer = NULL;
+    p_owner->output = NULL;
 
     atomic_init( &p_owner->b_fmt_description, false );
     p_owner->p_description = NULL;
+    var_SnapshotInit( &p_owner->opts.snapshot );
 
     p_owner->reset_out_state = false;
     p_owner->delay = 0;
@@ -1848,6 +2233,20 @@ CreateDecoder( vlc_object_t *p_parent,
     p_owner->b_first = true;
     p_owner->b_has_data = false;
 
+    p_owner->b_thumbnailing = b_thumbnailing && fmt->i_cat == VIDEO_ES;
+    /* set on the input by the thumbnailer */
+    p_owner->b_keyframes_only = p_owner->b_thumbnailing
+        && var_Type( p_parent, "thumbnail-keyframes" ) != 0
+        && var_GetBool( p_parent, "thumbnail-keyframes" );
+
+    p_owner->tracer = vlc_object_get_tracer( p_parent );
+    p_owner->audio_pool = NULL;
+
+    for( unsigned i = 0; i < DECODER_ARRIVALS; i++ )
+        p_owner->arrivals[i].ts = VLC_TICK_INVALID;
+    p_owner->arrival_next = 0;
+    p_owner->fifo_depth = 0;
+
     p_owner->error = false;
 
     p_owner->flushing = false;
@@ -1869,6 +2268,11 @@ CreateDecoder( vlc_object_t *p_parent,
         return NULL;
     }
 
+    p_owner->fifo_account = vlc_mem_account_New( p_dec, "decoder FIFO" );
+    vlc_fifo_Lock( p_owner->p_fifo );
+    vlc_fifo_SetAccount( p_owner->p_fifo, p_owner->fifo_account );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
     vlc_mutex_init( &p_owner->lock );
     vlc_mutex_init( &p_owner->mouse_lock );
     vlc_cond_init( &p_owner->wait_request );
@@ -1905,6 +2309,8 @@ CreateDecoder( vlc_object_t *p_parent,
             break;
         case AUDIO_ES:
             p_dec->cbs = &dec_audio_cbs;
+            /* Without a pool, the buffers are allocated one by one */
+            p_owner->audio_pool = vlc_audio_pool_New();
             break;
         case SPU_ES:
             p_dec->cbs = &dec_spu_cbs;
@@ -1963,6 +2369,7 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner )
              (char*)&p_dec->fmt_in.i_codec );
 
     const enum es_format_category_e i_cat =p_dec->fmt_in.i_cat;
+    DecoderOutput_Delete( p_owner );
     decoder_Clean( p_dec );
     if ( p_owner->out_pool )
     {
@@ -1975,6 +2382,7 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner )
 
     /* Free all packets still in the decoder fifo. */
     block_FifoRelease( p_owner->p_fifo );
+    vlc_mem_account_Delete( p_owner->fifo_account );
 
     /* Cleanup */
 #ifdef ENABLE_SOUT
@@ -1995,6 +2403,9 @@ static void DeleteDecoder( vlc_input_decoder_t *p_owner )
                 aout_DecDelete( p_owner->p_aout );
                 input_resource_PutAout( p_owner->p_resource, p_owner->p_aout );
             }
+            /* Buffers still in use keep the pool alive */
+            if( p_owner->audio_pool != NULL )
+                vlc_audio_pool_Release( p_owner->audio_pool );
             break;
         case VIDEO_ES: {
             vout_thread_t *vout = p_owner->p_vout;
@@ -2113,6 +2524,10 @@ decoder_New( vlc_object_t *p_parent, const es_format_t *fmt,
     }
 #endif
 
+    if( !thumbnailing && p_sout == NULL &&
+        (p_dec->fmt_in.i_cat == VIDEO_ES || p_dec->fmt_in.i_cat == AUDIO_ES) )
+        DecoderOutput_New( p_owner, i_priority );
+
     /* Spawn the decoder thread */
     if( vlc_clone( &p_owner->thread, DecoderThread, p_owner, i_priority ) )
     {
@@ -2237,6 +2652,15 @@ void vlc_input_decoder_Decode( vlc_input_decoder_t *p_owner, block_t *p_block,
             vlc_fifo_WaitCond( p_owner->p_fifo, &p_owner->wait_fifo );
     }
 
+    vlc_tick_t ts = p_block->i_pts != VLC_TICK_INVALID ? p_block->i_pts
+                                                        : p_block->i_dts;
+    if( ts != VLC_TICK_INVALID )
+    {
+        unsigned i = p_owner->arrival_next++ % DECODER_ARRIVALS;
+        p_owner->arrivals[i].ts = ts;
+        p_owner->arrivals[i].date = vlc_tick_now();
+    }
+
     vlc_fifo_QueueUnlocked( p_owner->p_fifo, p_block );
     vlc_fifo_Unlock( p_owner->p_fifo );
 }
@@ -2299,6 +2723,11 @@ void vlc_input_decoder_Flush( vlc_input_decoder_t *p_owner )
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
 
+    /* And the output queue; the item being output, if any, is waited for by
+     * the DecoderThread flush */
+    if( p_owner->output != NULL )
+        DecoderOutput_Discard( p_owner->output );
+
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
      * dequeued by DecoderThread and there is no need to flush a second time in
@@ -41,8 +41,21 @@ struct vlc_input_decoder_callbacks {
     void (*on_new_video_stats)(vlc_input_decoder_t *decoder, unsigned decoded,
                                unsigned lost, unsigned displayed,
                                void *userdata);
+    /* pool_hits and pool_misses: output buffers recycled and allocated */
     void (*on_new_audio_stats)(vlc_input_decoder_t *decoder, unsigned decoded,
-                               unsigned lost, unsigned played, void *userdata);
+                               unsigned lost, unsigned played,
+                               unsigned pool_hits, unsigned pool_misses,
+                               void *userdata);
+    /* fifo_depth: blocks waiting in the decoder FIFO when the block was
+     * dequeued; decode_time: time spent in the decoder module */
+    void (*on_new_decode_timing)(vlc_input_decoder_t *decoder,
+                                 unsigned fifo_depth, vlc_tick_t decode_time,
+                                 void *userdata);
+    /* latency: delay from the demuxer to the output, or VLC_TICK_INVALID if
+     * unknown; drift: audio output drift, or VLC_TICK_INVALID */
+    void (*on_new_output_timing)(vlc_input_decoder_t *decoder,
+                                 vlc_tick_t latency, vlc_tick_t drift,
+                                 void *userdata);
 
     /* requests */
     int (*get_attachments)(vlc_input_decoder_t *decoder,
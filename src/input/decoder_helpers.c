@@ -32,6 +32,8 @@
 #include <vlc_meta.h>
 #include <vlc_modules.h>
 #include <vlc_picture.h>
+#include <vlc_list.h>
+#include <vlc_vout_window.h>
 #include "libvlc.h"
 
 void decoder_Init( decoder_t *p_dec, const es_format_t *restrict p_fmt )
@@ -170,8 +172,21 @@ struct vlc_decoder_device_priv
 {
     struct vlc_decoder_device device;
     vlc_atomic_rc_t rc;
+
+    /* Devices shared across the players of a libvlc instance */
+    bool shared;
+    struct vlc_list node;
+    libvlc_int_t *libvlc;
+    char *name;
+    int window_type;
+    char *display_x11;
+    void *display_wl;
 };
 
+static vlc_mutex_t shared_devices_lock = VLC_STATIC_MUTEX;
+static struct vlc_list shared_devices =
+    VLC_LIST_INITIALIZER(&shared_devices);
+
 static int decoder_device_Open(void *func, bool forced, va_list ap)
 {
     VLC_UNUSED(forced);
@@ -181,18 +196,43 @@ static int decoder_device_Open(void *func, bool forced, va_list ap)
     return open(device, window);
 }
 
-vlc_decoder_device *
-vlc_decoder_device_Create(vlc_object_t *o, vout_window_t *window)
+static bool
+decoder_device_Matches(const struct vlc_decoder_device_priv *priv,
+                       libvlc_int_t *libvlc, const char *name,
+                       const vout_window_t *window)
+{
+    if (priv->libvlc != libvlc || strcmp(priv->name, name) != 0)
+        return false;
+
+    int type = window != NULL ? (int)window->type : -1;
+    if (priv->window_type != type)
+        return false;
+
+    /* The device is bound to the display server, not to the window */
+    switch (type)
+    {
+        case VOUT_WINDOW_TYPE_XID:
+            if (priv->display_x11 == NULL || window->display.x11 == NULL)
+                return priv->display_x11 == window->display.x11;
+            return strcmp(priv->display_x11, window->display.x11) == 0;
+        case VOUT_WINDOW_TYPE_WAYLAND:
+            return priv->display_wl == (void *)window->display.wl;
+        default:
+            return true;
+    }
+}
+
+static struct vlc_decoder_device_priv *
+decoder_device_Load(vlc_object_t *parent, const char *name,
+                    vout_window_t *window)
 {
     struct vlc_decoder_device_priv *priv =
-            vlc_object_create(o, sizeof (*priv));
+            vlc_object_create(parent, sizeof (*priv));
     if (!priv)
         return NULL;
-    char *name = var_InheritString(o, "dec-dev");
     module_t *module = vlc_module_load(&priv->device, "decoder device", name,
                                     true, decoder_device_Open, &priv->device,
                                     window);
-    free(name);
     if (module == NULL)
     {
         vlc_objres_clear(VLC_OBJECT(&priv->device));
@@ -201,7 +241,70 @@ vlc_decoder_device_Create(vlc_object_t *o, vout_window_t *window)
     }
     assert(priv->device.ops != NULL);
     vlc_atomic_rc_init(&priv->rc);
-    return &priv->device;
+    priv->shared = false;
+    return priv;
+}
+
+static vlc_decoder_device *
+decoder_device_CreateShared(vlc_object_t *o, const char *name,
+                            vout_window_t *window)
+{
+    libvlc_int_t *libvlc = vlc_object_instance(o);
+    struct vlc_decoder_device_priv *priv;
+
+    vlc_mutex_lock(&shared_devices_lock);
+    vlc_list_foreach(priv, &shared_devices, node)
+        if (decoder_device_Matches(priv, libvlc, name, window))
+        {
+            vlc_atomic_rc_inc(&priv->rc);
+            vlc_mutex_unlock(&shared_devices_lock);
+            msg_Dbg(o, "reusing shared decoder device");
+            return &priv->device;
+        }
+
+    /* Parent the device to the instance, it outlives the requesting vout */
+    priv = decoder_device_Load(VLC_OBJECT(libvlc), name, window);
+    if (priv != NULL)
+    {
+        priv->name = strdup(name);
+        priv->window_type = window != NULL ? (int)window->type : -1;
+        priv->display_x11 = NULL;
+        priv->display_wl = NULL;
+        if (window != NULL && window->type == VOUT_WINDOW_TYPE_XID
+         && window->display.x11 != NULL)
+            priv->display_x11 = strdup(window->display.x11);
+        else if (window != NULL && window->type == VOUT_WINDOW_TYPE_WAYLAND)
+            priv->display_wl = window->display.wl;
+
+        if (likely(priv->name != NULL))
+        {
+            priv->shared = true;
+            priv->libvlc = libvlc;
+            vlc_list_append(&priv->node, &shared_devices);
+        }
+        else
+            free(priv->display_x11);
+    }
+    vlc_mutex_unlock(&shared_devices_lock);
+    return priv != NULL ? &priv->device : NULL;
+}
+
+vlc_decoder_device *
+vlc_decoder_device_Create(vlc_object_t *o, vout_window_t *window)
+{
+    char *name = var_InheritString(o, "dec-dev");
+    vlc_decoder_device *device;
+
+    if (var_InheritBool(o, "dec-dev-shared"))
+        device = decoder_device_CreateShared(o, name ? name : "any", window);
+    else
+    {
+        struct vlc_decoder_device_priv *priv =
+            decoder_device_Load(o, name, window);
+        device = priv != NULL ? &priv->device : NULL;
+    }
+    free(name);
+    return device;
 }
 
 vlc_decoder_device *
@@ -218,13 +321,27 @@ vlc_decoder_device_Release(vlc_decoder_device *device)
 {
     struct vlc_decoder_device_priv *priv =
             container_of(device, struct vlc_decoder_device_priv, device);
-    if (vlc_atomic_rc_dec(&priv->rc))
+
+    if (priv->shared)
     {
-        if (device->ops->close != NULL)
-            device->ops->close(device);
-        vlc_objres_clear(VLC_OBJECT(device));
-        vlc_object_delete(device);
+        /* Serialize with lookups, which revive the device from the list */
+        vlc_mutex_lock(&shared_devices_lock);
+        bool last = vlc_atomic_rc_dec(&priv->rc);
+        if (last)
+            vlc_list_remove(&priv->node);
+        vlc_mutex_unlock(&shared_devices_lock);
+        if (!last)
+            return;
+        free(priv->name);
+        free(priv->display_x11);
     }
+    else if (!vlc_atomic_rc_dec(&priv->rc))
+        return;
+
+    if (device->ops->close != NULL)
+        device->ops->close(device);
+    vlc_objres_clear(VLC_OBJECT(device));
+    vlc_object_delete(device);
 }
 
 /* video context */
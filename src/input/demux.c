@@ -138,6 +138,91 @@ static const char* DemuxNameFromExtension( char const* ext,
     return result ? result->name : NULL;
 }
 
+/* Remembers which demuxer accepted streams with the same extension, MIME
+ * type and first bytes, so that it is probed first the next time */
+#define DEMUX_PROBE_CACHE_SIZE 32
+#define DEMUX_PROBE_SIGNATURE 8
+
+struct demux_probe_key
+{
+    char ext[8];
+    char mime[32];
+    uint8_t sig[DEMUX_PROBE_SIGNATURE];
+    uint8_t sig_len;
+    bool preparsing;
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned next;
+    struct
+    {
+        struct demux_probe_key key;
+        char module[32];
+    } entries[DEMUX_PROBE_CACHE_SIZE];
+} demux_probe_cache = { .lock = VLC_STATIC_MUTEX, };
+
+static void DemuxProbeKey( struct demux_probe_key *key, const char *ext,
+                           const char *mime, stream_t *s, bool b_preparsing )
+{
+    memset( key, 0, sizeof( *key ) );
+    if( ext != NULL )
+        for( size_t i = 0; i < sizeof( key->ext ) - 1 && ext[i]; i++ )
+            key->ext[i] = vlc_ascii_tolower( ext[i] );
+    if( mime != NULL )
+        strncpy( key->mime, mime, sizeof( key->mime ) - 1 );
+
+    const uint8_t *peek;
+    ssize_t len = vlc_stream_Peek( s, &peek, DEMUX_PROBE_SIGNATURE );
+    if( len > 0 )
+    {
+        memcpy( key->sig, peek, len );
+        key->sig_len = len;
+    }
+    key->preparsing = b_preparsing;
+}
+
+static bool DemuxProbeCacheGet( const struct demux_probe_key *key,
+                                char *module, size_t size )
+{
+    bool found = false;
+
+    vlc_mutex_lock( &demux_probe_cache.lock );
+    for( size_t i = 0; i < DEMUX_PROBE_CACHE_SIZE; i++ )
+    {
+        if( demux_probe_cache.entries[i].module[0] != '\0'
+         && !memcmp( &demux_probe_cache.entries[i].key, key, sizeof( *key ) ) )
+        {
+            strlcpy( module, demux_probe_cache.entries[i].module, size );
+            found = true;
+            break;
+        }
+    }
+    vlc_mutex_unlock( &demux_probe_cache.lock );
+    return found;
+}
+
+static void DemuxProbeCachePut( const struct demux_probe_key *key,
+                                const char *module )
+{
+    vlc_mutex_lock( &demux_probe_cache.lock );
+    size_t i;
+    for( i = 0; i < DEMUX_PROBE_CACHE_SIZE; i++ )
+        if( !memcmp( &demux_probe_cache.entries[i].key, key, sizeof( *key ) ) )
+            break;
+    if( i == DEMUX_PROBE_CACHE_SIZE )
+    {
+        /* Replace the oldest entry */
+        i = demux_probe_cache.next;
+        demux_probe_cache.next = ( i + 1 ) % DEMUX_PROBE_CACHE_SIZE;
+        demux_probe_cache.entries[i].key = *key;
+    }
+    strlcpy( demux_probe_cache.entries[i].module, module,
+             sizeof( demux_probe_cache.entries[i].module ) );
+    vlc_mutex_unlock( &demux_probe_cache.lock );
+}
+
 demux_t *demux_New( vlc_object_t *p_obj, const char *psz_name,
                     stream_t *s, es_out_t *out )
 {
@@ -197,14 +282,12 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_input,
     assert(s != NULL);
     priv = vlc_stream_Private(p_demux);
 
+    char *mime = NULL;
     if (!strcasecmp( psz_demux, "any" ) || !psz_demux[0])
     {   /* Look up demux by mime-type for hard to detect formats */
-        char *type = stream_MimeType( s );
-        if( type != NULL )
-        {
-            psz_demux = demux_NameFromMimeType( type );
-            free( type );
-        }
+        mime = stream_MimeType( s );
+        if( mime != NULL )
+            psz_demux = demux_NameFromMimeType( mime );
     }
 
     p_demux->p_input_item = p_input ? input_GetItem(p_input) : NULL;
@@ -233,13 +316,33 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_input,
     p_demux->p_sys      = NULL;
 
     const char *psz_module = NULL;
+    char const* psz_ext = NULL;
 
     if( !strcmp( p_demux->psz_name, "any" ) && p_demux->psz_filepath )
     {
-        char const* psz_ext = strrchr( p_demux->psz_filepath, '.' );
+        psz_ext = strrchr( p_demux->psz_filepath, '.' );
 
         if( psz_ext )
-            psz_module = DemuxNameFromExtension( psz_ext + 1, b_preparsing );
+        {
+            psz_ext++;
+            psz_module = DemuxNameFromExtension( psz_ext, b_preparsing );
+        }
+    }
+
+    /* Probe the demuxer that won for a similar stream first */
+    struct demux_probe_key key;
+    char cached[sizeof( demux_probe_cache.entries[0].module )];
+    const bool b_cache = psz_module == NULL
+                      && !strcmp( p_demux->psz_name, "any" )
+                      && var_InheritBool( p_obj, "demux-probe-cache" );
+    if( b_cache )
+    {
+        DemuxProbeKey( &key, psz_ext, mime, s, b_preparsing );
+        if( DemuxProbeCacheGet( &key, cached, sizeof( cached ) ) )
+        {
+            msg_Dbg( p_obj, "probing demux \"%s\" first", cached );
+            psz_module = cached;
+        }
     }
 
     if( psz_module == NULL )
@@ -254,8 +357,13 @@ demux_t *demux_NewAdvanced( vlc_object_t *p_obj, input_thread_t *p_input,
         goto error;
     }
 
+    if( b_cache )
+        DemuxProbeCachePut( &key, module_get_object( priv->module ) );
+
+    free( mime );
     return p_demux;
 error:
+    free( mime );
     free( p_demux->psz_name );
     stream_CommonDelete( p_demux );
     return NULL;
@@ -40,6 +40,7 @@
 #include <vlc_list.h>
 #include <vlc_decoder.h>
 #include <vlc_memstream.h>
+#include <vlc_tracer.h>
 
 #include "input_internal.h"
 #include "../clock/input_clock.h"
@@ -130,6 +131,7 @@ struct es_out_id_t
     vlc_input_decoder_t   *p_dec;
     vlc_input_decoder_t   *p_dec_record;
     vlc_clock_t *p_clock;
+    struct input_es_stats *stats; /* NULL if statistics are disabled */
 
     /* Used by vlc_clock_cbs, need to be const during the lifetime of the clock */
     bool master;
@@ -226,6 +228,9 @@ typedef struct
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
 
+    /* EPG changed since the last interface update */
+    bool        b_epg_changed;
+
     es_out_t out;
 } es_out_sys_t;
 
@@ -366,11 +371,17 @@ decoder_on_new_video_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsig
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->displayed_pictures, displayed,
                               memory_order_relaxed);
+
+    if (decoded > 0)
+        input_SetStartupMilestone(p_sys->p_input, INPUT_STARTUP_FIRST_DECODED);
+    if (displayed > 0)
+        input_SetStartupMilestone(p_sys->p_input, INPUT_STARTUP_FIRST_OUTPUT);
 }
 
 static void
 decoder_on_new_audio_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsigned lost,
-                           unsigned played, void *userdata)
+                           unsigned played, unsigned pool_hits,
+                           unsigned pool_misses, void *userdata)
 {
     (void) decoder;
 
@@ -391,6 +402,37 @@ decoder_on_new_audio_stats(vlc_input_decoder_t *decoder, unsigned decoded, unsig
                               memory_order_relaxed);
     atomic_fetch_add_explicit(&stats->played_abuffers, played,
                               memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->pooled_abuffers, pool_hits,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats->allocated_abuffers, pool_misses,
+                              memory_order_relaxed);
+
+    if (decoded > 0)
+        input_SetStartupMilestone(p_sys->p_input, INPUT_STARTUP_FIRST_DECODED);
+    if (played > 0)
+        input_SetStartupMilestone(p_sys->p_input, INPUT_STARTUP_FIRST_OUTPUT);
+}
+
+static void
+decoder_on_new_decode_timing(vlc_input_decoder_t *decoder, unsigned fifo_depth,
+                             vlc_tick_t decode_time, void *userdata)
+{
+    (void) decoder;
+
+    es_out_id_t *id = userdata;
+    if (id->stats != NULL)
+        input_es_stats_AddDecode(id->stats, fifo_depth, decode_time);
+}
+
+static void
+decoder_on_new_output_timing(vlc_input_decoder_t *decoder, vlc_tick_t latency,
+                             vlc_tick_t drift, void *userdata)
+{
+    (void) decoder;
+
+    es_out_id_t *id = userdata;
+    if (id->stats != NULL)
+        input_es_stats_AddOutput(id->stats, latency, drift);
 }
 
 static int
@@ -416,6 +458,8 @@ static const struct vlc_input_decoder_callbacks decoder_cbs = {
     .on_thumbnail_ready = decoder_on_thumbnail_ready,
     .on_new_video_stats = decoder_on_new_video_stats,
     .on_new_audio_stats = decoder_on_new_audio_stats,
+    .on_new_decode_timing = decoder_on_new_decode_timing,
+    .on_new_output_timing = decoder_on_new_output_timing,
     .get_attachments = decoder_get_attachments,
 };
 
@@ -655,6 +699,7 @@ static void EsOutTerminate( es_out_t *out )
 
     input_item_SetEpgOffline( input_priv(p_sys->p_input)->p_item );
     input_SendEventMetaEpg( p_sys->p_input );
+    p_sys->b_epg_changed = false;
 }
 
 static vlc_tick_t EsOutGetWakeup( es_out_t *out )
@@ -1383,6 +1428,19 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, input_source_t *source, in
     }
     if( p_sys->b_paused )
         input_clock_ChangePause( p_pgrm->p_input_clock, p_sys->b_paused, p_sys->i_pause_date );
+
+    char *psz_clock_group = var_InheritString( p_input, "clock-group" );
+    if( psz_clock_group != NULL )
+    {
+        enum vlc_clock_group_align align =
+            var_InheritInteger( p_input, "clock-group-align" );
+        if( vlc_clock_main_JoinGroup( p_pgrm->p_main_clock, psz_clock_group,
+                                      align ) != VLC_SUCCESS )
+            msg_Warn( p_input, "cannot join the clock group %s",
+                      psz_clock_group );
+        free( psz_clock_group );
+    }
+
     const vlc_tick_t pts_delay = p_sys->i_pts_delay + p_sys->i_pts_jitter
                                + p_sys->i_tracks_pts_delay;
     input_clock_SetJitter( p_pgrm->p_input_clock, pts_delay, p_sys->i_cr_average );
@@ -1668,7 +1726,8 @@ static void EsOutProgramEpgEvent( es_out_t *out, input_source_t *source,
     if( !p_pgrm )
         return;
 
-    input_item_SetEpgEvent( p_item, p_event );
+    if( input_item_SetEpgEvent( p_item, p_event ) )
+        p_sys->b_epg_changed = true;
 }
 
 static void EsOutProgramEpg( es_out_t *out, input_source_t *source,
@@ -1697,11 +1756,21 @@ static void EsOutProgramEpg( es_out_t *out, input_source_t *source,
     epg = *p_epg;
     epg.psz_name = EsOutProgramGetProgramName( p_pgrm );
 
-    input_item_SetEpg( p_item, &epg, p_sys->p_pgrm && (p_epg->i_source_id == p_sys->p_pgrm->i_id) );
-    input_SendEventMetaEpg( p_sys->p_input );
-
+    bool b_changed = input_item_SetEpg( p_item, &epg,
+                                        p_sys->p_pgrm && (p_epg->i_source_id == p_sys->p_pgrm->i_id) );
     free( epg.psz_name );
 
+    /* Repeated table, nothing else to update */
+    if( !b_changed )
+    {
+        free( psz_cat );
+        return;
+    }
+
+    /* The event is sent with the next interface update, not for each of
+     * the tables of a full schedule */
+    p_sys->b_epg_changed = true;
+
     /* Update now playing */
     if( p_epg->b_present && p_pgrm->p_meta &&
        ( p_epg->p_current || p_epg->i_event == 0 ) )
@@ -2075,6 +2144,7 @@ static es_out_id_t *EsOutAddLocked( es_out_t *out, input_source_t *source,
     es->psz_title = EsGetTitle(es);
     es->p_dec = NULL;
     es->p_dec_record = NULL;
+    es->stats = NULL;
     es->p_clock = NULL;
     es->master = false;
     es->cc.type = 0;
@@ -2179,11 +2249,15 @@ static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     }
 
     input_thread_private_t *priv = input_priv(p_input);
+    if( priv->stats != NULL )
+        p_es->stats = input_stats_AcquireEs( priv->stats, p_es->fmt.i_id,
+                                             p_es->fmt.i_cat );
     dec = vlc_input_decoder_New( VLC_OBJECT(p_input), &p_es->fmt, p_es->p_clock,
                                  priv->p_resource, priv->p_sout,
                                  priv->b_thumbnailing, &decoder_cbs, p_es );
     if( dec != NULL )
     {
+        input_SetStartupMilestone( p_input, INPUT_STARTUP_DECODER_OPENED );
         vlc_input_decoder_ChangeRate( dec, p_sys->rate );
 
         if( p_sys->b_buffering )
@@ -2207,6 +2281,11 @@ static void EsOutCreateDecoder( es_out_t *out, es_out_id_t *p_es )
     {
         vlc_clock_Delete( p_es->p_clock );
         p_es->p_clock = NULL;
+        if( p_es->stats != NULL )
+        {
+            input_stats_ReleaseEs( p_es->stats );
+            p_es->stats = NULL;
+        }
     }
     p_es->p_dec = dec;
 
@@ -2223,6 +2302,11 @@ static void EsOutDestroyDecoder( es_out_t *out, es_out_id_t *p_es )
 
     vlc_input_decoder_Delete( p_es->p_dec );
     p_es->p_dec = NULL;
+    if( p_es->stats != NULL )
+    {
+        input_stats_ReleaseEs( p_es->stats );
+        p_es->stats = NULL;
+    }
     if( p_es->p_pgrm->p_master_clock == p_es->p_clock )
         p_es->p_pgrm->p_master_clock = NULL;
     vlc_clock_Delete( p_es->p_clock );
@@ -2705,33 +2789,40 @@ static void EsOutCreateCCChannels( es_out_t *out, vlc_fourcc_t codec, uint64_t i
 }
 
 /**
- * Send a block for the given es_out
+ * Send a chain of blocks for the given es_out
+ *
+ * The es_out lock is taken once for the whole chain and the decoder fifo is
+ * fed with it in one go.
  *
  * \param out the es_out to send from
  * \param es the es_out_id
- * \param p_block the data block to send
+ * \param p_chain the data blocks to send, linked by p_next
  */
-static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
+static int EsOutSendChain( es_out_t *out, es_out_id_t *es, block_t *p_chain )
 {
     es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
     input_thread_t *p_input = p_sys->p_input;
 
-    assert( p_block->p_next == NULL );
+    if( p_chain == NULL )
+        return VLC_SUCCESS;
 
     struct input_stats *stats = input_priv(p_input)->stats;
     if( stats != NULL )
     {
-        input_rate_Add( &stats->demux_bitrate, p_block->i_buffer );
+        for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+        {
+            input_rate_Add( &stats->demux_bitrate, p_block->i_buffer );
 
-        /* Update number of corrupted data packats */
-        if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
-            atomic_fetch_add_explicit(&stats->demux_corrupted, 1,
-                                      memory_order_relaxed);
+            /* Update number of corrupted data packats */
+            if( p_block->i_flags & BLOCK_FLAG_CORRUPTED )
+                atomic_fetch_add_explicit(&stats->demux_corrupted, 1,
+                                          memory_order_relaxed);
 
-        /* Update number of discontinuities */
-        if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
-            atomic_fetch_add_explicit(&stats->demux_discontinuity, 1,
-                                      memory_order_relaxed);
+            /* Update number of discontinuities */
+            if( p_block->i_flags & BLOCK_FLAG_DISCONTINUITY )
+                atomic_fetch_add_explicit(&stats->demux_discontinuity, 1,
+                                          memory_order_relaxed);
+        }
     }
 
     vlc_mutex_lock( &p_sys->lock );
@@ -2739,17 +2830,20 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     /* Mark preroll blocks */
     if( p_sys->i_preroll_end >= 0 )
     {
-        vlc_tick_t i_date = p_block->i_pts;
-        if( p_block->i_pts == VLC_TICK_INVALID )
-            i_date = p_block->i_dts;
+        for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+        {
+            vlc_tick_t i_date = p_block->i_pts;
+            if( p_block->i_pts == VLC_TICK_INVALID )
+                i_date = p_block->i_dts;
 
-        if( i_date + p_block->i_length < p_sys->i_preroll_end )
-            p_block->i_flags |= BLOCK_FLAG_PREROLL;
+            if( i_date + p_block->i_length < p_sys->i_preroll_end )
+                p_block->i_flags |= BLOCK_FLAG_PREROLL;
+        }
     }
 
     if( !es->p_dec )
     {
-        block_Release( p_block );
+        block_ChainRelease( p_chain );
         vlc_mutex_unlock( &p_sys->lock );
         return VLC_SUCCESS;
     }
@@ -2770,12 +2864,19 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     /* Decode */
     if( es->p_dec_record )
     {
-        block_t *p_dup = block_Duplicate( p_block );
-        if( p_dup )
-            vlc_input_decoder_Decode( es->p_dec_record, p_dup,
+        block_t *p_dups = NULL;
+        block_t **pp_last = &p_dups;
+        for( block_t *p_block = p_chain; p_block; p_block = p_block->p_next )
+        {
+            block_t *p_dup = block_Duplicate( p_block );
+            if( p_dup )
+                block_ChainLastAppend( &pp_last, p_dup );
+        }
+        if( p_dups )
+            vlc_input_decoder_Decode( es->p_dec_record, p_dups,
                                       input_priv(p_input)->b_out_pace_control );
     }
-    vlc_input_decoder_Decode( es->p_dec, p_block,
+    vlc_input_decoder_Decode( es->p_dec, p_chain,
                               input_priv(p_input)->b_out_pace_control );
 
     es_format_t fmt_dsc;
@@ -2807,6 +2908,26 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     return VLC_SUCCESS;
 }
 
+/**
+ * Send a block for the given es_out
+ *
+ * \param out the es_out to send from
+ * \param es the es_out_id
+ * \param p_block the data block to send
+ */
+static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
+{
+    es_out_sys_t *p_sys = container_of(out, es_out_sys_t, out);
+    struct vlc_tracer *tracer = input_priv(p_sys->p_input)->tracer;
+
+    assert( p_block->p_next == NULL );
+
+    vlc_tick_t start = vlc_tracer_Begin( tracer );
+    int ret = EsOutSendChain( out, es, p_block );
+    vlc_tracer_End( tracer, "input", "es_out_Send", es, start );
+    return ret;
+}
+
 static void
 EsOutDrainDecoder( es_out_t *out, es_out_id_t *es )
 {
@@ -3159,6 +3280,16 @@ static int EsOutVaControlLocked( es_out_t *out, input_source_t *source,
         if( !p_sys->p_pgrm )
             return VLC_SUCCESS;
 
+        struct input_stats *stats = input_priv(p_sys->p_input)->stats;
+        if( stats != NULL && p_pgrm == p_sys->p_pgrm )
+        {
+            vlc_tick_t i_drift, i_jitter;
+            if( input_clock_GetDrift( p_pgrm->p_input_clock,
+                                      &i_drift, &i_jitter ) != VLC_SUCCESS )
+                i_drift = i_jitter = VLC_TICK_INVALID;
+            input_stats_SetClock( stats, i_drift, i_jitter );
+        }
+
         if( p_sys->b_buffering )
         {
             /* Check buffering state on master clock update */
@@ -3634,6 +3765,12 @@ static int EsOutVaPrivControlLocked( es_out_t *out, int query, va_list args )
         vlc_tick_t i_normal_time = va_arg( args, vlc_tick_t );
         vlc_tick_t i_length = va_arg( args, vlc_tick_t );
 
+        if( p_sys->b_epg_changed )
+        {
+            p_sys->b_epg_changed = false;
+            input_SendEventMetaEpg( p_sys->p_input );
+        }
+
         if( !p_sys->b_buffering )
         {
             vlc_tick_t i_delay;
@@ -3790,6 +3927,7 @@ static const struct es_out_callbacks es_out_cbs =
     .control = EsOutControl,
     .destroy = EsOutDelete,
     .priv_control = EsOutPrivControl,
+    .send_chain = EsOutSendChain,
 };
 
 /****************************************************************************
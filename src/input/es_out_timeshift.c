@@ -29,22 +29,21 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <errno.h>
-#if defined (_WIN32)
-#  include <direct.h>
-#endif
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef HAVE_MMAP
+#   include <sys/mman.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
 #include <vlc_mouse.h>
-#ifdef _WIN32
-#  include <vlc_charset.h>
-#endif
 #include <vlc_es_out.h>
 #include <vlc_block.h>
+#include <vlc_memstats.h>
 #include "input_internal.h"
 #include "es_out.h"
 
@@ -83,9 +82,15 @@ typedef struct attribute_packed
 {
     es_out_id_t *p_es;
     block_t *p_block;
-    int     i_offset;  /* We do not use file > INT_MAX */
+    uint64_t i_offset; /* Offset in the storage, TS_DROPPED if dropped */
+    uint32_t i_size;   /* Size in the storage */
 } ts_cmd_send_t;
 
+#define TS_DROPPED UINT64_MAX
+
+/* Amount of the oldest data dropped at once when the storage is full */
+#define TS_DROP_STEP VLC_TICK_FROM_MS(500)
+
 typedef struct attribute_packed
 {
     input_source_t *in;
@@ -172,33 +177,48 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
-typedef struct ts_storage_t ts_storage_t;
-struct ts_storage_t
+/* Block meta-data, stored in front of the payload */
+typedef struct
 {
-    ts_storage_t *p_next;
-
-    /* */
-#ifdef _WIN32
-    char    *psz_file;  /* Filename */
-#endif
-    size_t  i_file_max; /* Max size in bytes */
-    int64_t i_file_size;/* Current size in bytes */
-    FILE    *p_filew;   /* FILE handle for data writing */
-    FILE    *p_filer;   /* FILE handle for data reading */
-
-    /* */
-    int      i_cmd_r;
-    int      i_cmd_w;
-    int      i_cmd_max;
+    vlc_tick_t i_dts;
+    vlc_tick_t i_pts;
+    vlc_tick_t i_length;
+    uint32_t   i_flags;
+    unsigned   i_nb_samples;
+} ts_block_header_t;
+
+/*
+ * The storage is a fixed-size circular buffer of block data, backed by a
+ * memory mapping of a temporary file, or of anonymous memory, and a queue of
+ * commands in chronological order. When it is full, the oldest block data is
+ * dropped (the commands themselves are kept).
+ */
+typedef struct
+{
+    /* Commands queue (circular) */
     ts_cmd_t *p_cmd;
-};
+    size_t   i_cmd_max;   /* Allocated entries, power of two */
+    size_t   i_cmd_first; /* Index of the first (oldest) command */
+    size_t   i_cmd_count;
+    size_t   i_cmd_drop;  /* Index of the first command not dropped yet */
+
+    /* Data ring */
+    uint8_t  *p_data;
+    size_t   i_data_size;
+    uint64_t i_data_r;    /* Offset of the oldest retained data */
+    uint64_t i_data_w;    /* Offset of the next data to write */
+    bool     b_mapped;
+
+    /* Memory account of the heap data ring, or NULL */
+    vlc_mem_account_t *account;
+} ts_storage_t;
 
 typedef struct
 {
     vlc_thread_t   thread;
     input_thread_t *p_input;
     es_out_t       *p_out;
-    int64_t        i_tmp_size_max;
+    size_t         i_tmp_size_max;
     const char     *psz_tmp_path;
 
     /* Lock for all following fields */
@@ -220,16 +240,17 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
-    ts_storage_t   *p_storage_r;
-    ts_storage_t   *p_storage_w;
+    ts_storage_t   *p_storage;
 
     vlc_tick_t     i_cmd_delay;
+    vlc_tick_t     i_drop_date; /* Date of the first skipped dropped data */
 
 } ts_thread_t;
 
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    bool        b_discontinuity; /* Data was dropped */
 };
 
 typedef struct
@@ -238,7 +259,7 @@ typedef struct
     es_out_t       *p_out;
 
     /* Configuration */
-    int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
+    size_t         i_tmp_size_max;    /* Storage size in bytes */
     char           *psz_tmp_path;     /* Path for temporary files */
 
     /* Lock for all following fields */
@@ -276,12 +297,10 @@ static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( input_thread_t *, const char *psz_path, size_t i_size );
 static void         TsStorageDelete( ts_storage_t * );
-static void         TsStoragePack( ts_storage_t *p_storage );
-static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
-static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, bool b_flush );
+static int          TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd );
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
@@ -305,7 +324,9 @@ static int  CmdExecuteControl( es_out_t *, ts_cmd_t * );
 static int  CmdExecutePrivControl( es_out_t *, ts_cmd_t * );
 
 /* File helpers */
+#ifdef HAVE_MMAP
 static int GetTmpFile( char **ppsz_file, const char *psz_path );
+#endif
 
 static const struct es_out_callbacks es_out_timeshift_cbs;
 
@@ -336,57 +357,18 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     TAB_INIT( p_sys->i_es, p_sys->pp_es );
 
     /* */
-    const int i_tmp_size_max = var_CreateGetInteger( p_input, "input-timeshift-granularity" );
-    if( i_tmp_size_max < 0 )
-        p_sys->i_tmp_size_max = 50*1024*1024;
-    else
-        p_sys->i_tmp_size_max = __MAX( i_tmp_size_max, 1*1024*1024 );
-    msg_Dbg( p_input, "using timeshift granularity of %d MiB",
-             (int)p_sys->i_tmp_size_max/(1024*1024) );
+    uint64_t i_tmp_size_max = var_InheritInteger( p_input, "input-timeshift-size" );
+    i_tmp_size_max = __MAX( i_tmp_size_max, 1 ) << 20;
+    /* Leave some address space on 32-bit systems */
+    p_sys->i_tmp_size_max = __MIN( i_tmp_size_max, SIZE_MAX / 4 + 1 );
+    msg_Dbg( p_input, "using timeshift storage of %zu MiB",
+             p_sys->i_tmp_size_max >> 20 );
 
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
-#if defined (_WIN32) && !VLC_WINSTORE_APP
-    if( p_sys->psz_tmp_path == NULL )
-    {
-        const DWORD count = GetTempPath( 0, NULL );
-        if( count > 0 )
-        {
-            WCHAR *path = vlc_alloc( count + 1, sizeof(WCHAR) );
-            if( path != NULL )
-            {
-                DWORD ret = GetTempPath( count + 1, path );
-                if( ret != 0 && ret <= count )
-                    p_sys->psz_tmp_path = FromWide( path );
-                free( path );
-            }
-        }
-    }
-    if( p_sys->psz_tmp_path == NULL )
-    {
-        wchar_t *wpath = _wgetcwd( NULL, 0 );
-        if( wpath != NULL )
-        {
-            p_sys->psz_tmp_path = FromWide( wpath );
-            free( wpath );
-        }
-    }
-    if( p_sys->psz_tmp_path == NULL )
-        p_sys->psz_tmp_path = strdup( "C:" );
-
-    if( p_sys->psz_tmp_path != NULL )
-    {
-        size_t len = strlen( p_sys->psz_tmp_path );
-
-        while( len > 0 && p_sys->psz_tmp_path[len - 1] == DIR_SEP_CHAR )
-            len--;
-
-        p_sys->psz_tmp_path[len] = '\0';
-    }
-#endif
     if( p_sys->psz_tmp_path != NULL )
         msg_Dbg( p_input, "using timeshift path: %s", p_sys->psz_tmp_path );
     else
-        msg_Dbg( p_input, "using default timeshift path" );
+        msg_Dbg( p_input, "using memory for timeshift" );
 
 #if 0
 #define S(t) msg_Err( p_input, "SIZEOF("#t")=%d", sizeof(t) )
@@ -430,6 +412,7 @@ static es_out_id_t *Add( es_out_t *p_out, input_source_t *in, const es_format_t
     es_out_id_t *p_es = malloc( sizeof( *p_es ) );
     if( !p_es )
         return NULL;
+    p_es->b_discontinuity = false;
 
     vlc_mutex_lock( &p_sys->lock );
 
@@ -473,6 +456,41 @@ static int Send( es_out_t *p_out, es_out_id_t *p_es, block_t *p_block )
 
     return i_ret;
 }
+static int SendChain( es_out_t *p_out, es_out_id_t *p_es, block_t *p_chain )
+{
+    es_out_sys_t *p_sys = container_of(p_out, es_out_sys_t, out);
+    int i_ret = VLC_SUCCESS;
+
+    vlc_mutex_lock( &p_sys->lock );
+
+    TsAutoStop( p_out );
+
+    if( p_sys->b_delayed )
+    {
+        /* Commands are stored per block */
+        while( p_chain )
+        {
+            block_t *p_block = p_chain;
+            p_chain = p_block->p_next;
+            p_block->p_next = NULL;
+
+            ts_cmd_t cmd;
+            CmdInitSend( &cmd, p_es, p_block );
+            TsPushCmd( p_sys->p_ts, &cmd );
+        }
+    }
+    else if( p_es->p_es )
+        i_ret = es_out_SendChain( p_sys->p_out, p_es->p_es, p_chain );
+    else
+    {
+        block_ChainRelease( p_chain );
+        i_ret = VLC_EGENERIC;
+    }
+
+    vlc_mutex_unlock( &p_sys->lock );
+
+    return i_ret;
+}
 static void Del( es_out_t *p_out, es_out_id_t *p_es )
 {
     es_out_sys_t *p_sys = container_of(p_out, es_out_sys_t, out);
@@ -856,6 +874,7 @@ static const struct es_out_callbacks es_out_timeshift_cbs =
     .control = Control,
     .destroy = Destroy,
     .priv_control = PrivControl,
+    .send_chain = SendChain,
 };
 
 /*****************************************************************************
@@ -891,8 +910,8 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
-    p_ts->p_storage_r = NULL;
-    p_ts->p_storage_w = NULL;
+    p_ts->i_drop_date = VLC_TICK_INVALID;
+    p_ts->p_storage = NULL;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -937,9 +956,8 @@ static void TsStop( ts_thread_t *p_ts )
 
         CmdClean( &cmd );
     }
-    assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    if( p_ts->p_storage )
+        TsStorageDelete( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
@@ -948,32 +966,22 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
-    if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
+    if( !p_ts->p_storage )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
-
-        if( !p_storage )
+        p_ts->p_storage = TsStorageNew( p_ts->p_input, p_ts->psz_tmp_path,
+                                        p_ts->i_tmp_size_max );
+        if( !p_ts->p_storage )
         {
             CmdClean( p_cmd );
             vlc_mutex_unlock( &p_ts->lock );
             /* TODO warn the user (but only once) */
             return;
         }
-
-        if( !p_ts->p_storage_w )
-        {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
-        }
-        else
-        {
-            TsStoragePack( p_ts->p_storage_w );
-            p_ts->p_storage_w->p_next = p_storage;
-            p_ts->p_storage_w = p_storage;
-        }
     }
 
     /* TODO return error and warn the user (but only once) */
-    TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    if( TsStoragePushCmd( p_ts->p_storage, p_cmd ) )
+        CmdClean( p_cmd );
 
     vlc_cond_signal( &p_ts->wait );
 
@@ -983,21 +991,29 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
 {
     vlc_mutex_assert( &p_ts->lock );
 
-    if( TsStorageIsEmpty( p_ts->p_storage_r ) )
-        return VLC_EGENERIC;
+    for( ;; )
+    {
+        if( TsStorageIsEmpty( p_ts->p_storage ) )
+            return VLC_EGENERIC;
 
-    TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+        TsStoragePopCmd( p_ts->p_storage, p_cmd, b_flush );
 
-    while( TsStorageIsEmpty( p_ts->p_storage_r ) )
-    {
-        ts_storage_t *p_next = p_ts->p_storage_r->p_next;
-        if( !p_next )
+        if( p_cmd->i_type != C_SEND ||
+            p_cmd->u.send.i_offset != TS_DROPPED )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
-        p_ts->p_storage_r = p_next;
+        /* Skip dropped data */
+        if( p_ts->i_drop_date == VLC_TICK_INVALID )
+            p_ts->i_drop_date = p_cmd->i_date;
     }
 
+    if( p_ts->i_drop_date != VLC_TICK_INVALID )
+    {   /* Catch up with the oldest retained data */
+        p_ts->i_cmd_delay -= p_cmd->i_date - p_ts->i_drop_date;
+        if( p_ts->i_cmd_delay < 0 )
+            p_ts->i_cmd_delay = 0;
+        p_ts->i_drop_date = VLC_TICK_INVALID;
+    }
     return VLC_SUCCESS;
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
@@ -1005,7 +1021,7 @@ static bool TsHasCmd( ts_thread_t *p_ts )
     bool b_cmd;
 
     vlc_mutex_lock( &p_ts->lock );
-    b_cmd = !TsStorageIsEmpty( p_ts->p_storage_r );
+    b_cmd = !TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_cmd;
@@ -1017,7 +1033,7 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->rate == p_ts->rate_source &&
-               TsStorageIsEmpty( p_ts->p_storage_r );
+               TsStorageIsEmpty( p_ts->p_storage );
     vlc_mutex_unlock( &p_ts->lock );
 
     return b_unused;
@@ -1179,70 +1195,91 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static void *TsStorageMap( input_thread_t *p_input, const char *psz_tmp_path,
+                           size_t i_size )
 {
-    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
-    if( unlikely(p_storage == NULL) )
-        return NULL;
+#ifdef HAVE_MMAP
+    int fd;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
+    if( psz_tmp_path != NULL )
     {
-        free( p_storage );
-        return NULL;
-    }
+        char *psz_file;
 
-    p_storage->p_filew = fdopen( fd, "w+b" );
-    if( p_storage->p_filew == NULL )
-    {
-        vlc_close( fd );
-        vlc_unlink( psz_file );
-        goto error;
+        fd = GetTmpFile( &psz_file, psz_tmp_path );
+        if( fd != -1 )
+        {
+            vlc_unlink( psz_file );
+            free( psz_file );
+        }
     }
+    else
+        fd = vlc_memfd();
 
-    p_storage->p_filer = vlc_fopen( psz_file, "rb" );
-    if( p_storage->p_filer == NULL )
-    {
-        fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
-        goto error;
-    }
+    if( fd == -1 )
+        return NULL;
 
-#ifndef _WIN32
-    vlc_unlink( psz_file );
-    free( psz_file );
+    void *p_data = MAP_FAILED;
+    if( ftruncate( fd, i_size ) == 0 )
+        p_data = mmap( NULL, i_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd, 0 );
+    else
+        msg_Err( p_input, "cannot size timeshift storage: %s",
+                 vlc_strerror_c(errno) );
+    vlc_close( fd );
+    return (p_data != MAP_FAILED) ? p_data : NULL;
 #else
-    p_storage->psz_file = psz_file;
+    VLC_UNUSED(p_input); VLC_UNUSED(psz_tmp_path); VLC_UNUSED(i_size);
+    return NULL;
 #endif
-    p_storage->p_next = NULL;
+}
 
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
+static ts_storage_t *TsStorageNew( input_thread_t *p_input,
+                                   const char *psz_tmp_path, size_t i_size )
+{
+    ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
+    if( unlikely(p_storage == NULL) )
+        return NULL;
+
+    p_storage->p_data = TsStorageMap( p_input, psz_tmp_path, i_size );
+    p_storage->b_mapped = p_storage->p_data != NULL;
+    if( !p_storage->b_mapped )
+    {
+        p_storage->p_data = malloc( i_size );
+        if( p_storage->p_data == NULL )
+        {
+            free( p_storage );
+            return NULL;
+        }
+    }
+    p_storage->i_data_size = i_size;
+    p_storage->i_data_r = 0;
+    p_storage->i_data_w = 0;
+
+    /* Mapped temporary files are not accounted: they do not use memory */
+    p_storage->account = NULL;
+    if( !p_storage->b_mapped )
+    {
+        p_storage->account = vlc_mem_account_New( p_input, "timeshift buffer" );
+        vlc_mem_account_Add( p_storage->account, 1, i_size );
+    }
 
     /* */
-    p_storage->i_cmd_w = 0;
-    p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
+    p_storage->i_cmd_max = 1024;
+    p_storage->i_cmd_first = 0;
+    p_storage->i_cmd_count = 0;
+    p_storage->i_cmd_drop = 0;
     p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
-
     if( !p_storage->p_cmd )
     {
         TsStorageDelete( p_storage );
         return NULL;
     }
     return p_storage;
-error:
-    free( psz_file );
-    free( p_storage );
-    return NULL;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
 {
-    while( p_storage->i_cmd_r < p_storage->i_cmd_w )
+    while( p_storage->i_cmd_count > 0 )
     {
         ts_cmd_t cmd;
 
@@ -1252,108 +1289,203 @@ static void TsStorageDelete( ts_storage_t *p_storage )
     }
     free( p_storage->p_cmd );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
-#ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
-    free( p_storage->psz_file );
+#ifdef HAVE_MMAP
+    if( p_storage->b_mapped )
+        munmap( p_storage->p_data, p_storage->i_data_size );
+    else
 #endif
+        free( p_storage->p_data );
+    vlc_mem_account_Delete( p_storage->account );
     free( p_storage );
 }
 
-static void TsStoragePack( ts_storage_t *p_storage )
+static ts_cmd_t *TsStorageCmd( ts_storage_t *p_storage, size_t i_index )
 {
-    /* Try to release a bit of memory */
-    if( p_storage->i_cmd_w >= p_storage->i_cmd_max )
-        return;
+    return &p_storage->p_cmd[i_index & (p_storage->i_cmd_max - 1)];
+}
 
-    p_storage->i_cmd_max = __MAX( p_storage->i_cmd_w, 1 );
+/**
+ * Finds the first command at or after a given date, within a range of the
+ * queue. Commands are queued in chronological order.
+ */
+static size_t TsStorageFind( ts_storage_t *p_storage, size_t i_lo, size_t i_hi,
+                             vlc_tick_t i_date )
+{
+    while( i_lo < i_hi )
+    {
+        size_t i_mid = i_lo + (i_hi - i_lo) / 2;
 
-    ts_cmd_t *p_new = realloc( p_storage->p_cmd, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) );
-    if( p_new )
-        p_storage->p_cmd = p_new;
+        if( TsStorageCmd( p_storage, i_mid )->i_date < i_date )
+            i_lo = i_mid + 1;
+        else
+            i_hi = i_mid;
+    }
+    return i_lo;
 }
-static bool TsStorageIsFull( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
+
+/**
+ * Drops the oldest retained data, by steps of TS_DROP_STEP.
+ */
+static void TsStorageDrop( ts_storage_t *p_storage )
 {
-    if( p_cmd && p_cmd->i_type == C_SEND && p_storage->i_cmd_w > 0 )
+    const size_t i_end = p_storage->i_cmd_first + p_storage->i_cmd_count;
+    size_t i_drop = __MAX( p_storage->i_cmd_drop, p_storage->i_cmd_first );
+
+    if( i_drop >= i_end )
+    {
+        p_storage->i_data_r = p_storage->i_data_w;
+        return;
+    }
+
+    vlc_tick_t i_date = TsStorageCmd( p_storage, i_drop )->i_date;
+    size_t i_stop = TsStorageFind( p_storage, i_drop, i_end,
+                                   i_date + TS_DROP_STEP );
+    if( i_stop == i_drop )
+        i_stop++;
+
+    for( ; i_drop < i_stop; i_drop++ )
     {
-        size_t i_size = sizeof(*p_cmd->u.send.p_block) + p_cmd->u.send.p_block->i_buffer;
+        ts_cmd_t *p_cmd = TsStorageCmd( p_storage, i_drop );
 
-        if( p_storage->i_file_size + i_size >= p_storage->i_file_max )
-            return true;
+        if( p_cmd->i_type != C_SEND || p_cmd->u.send.i_offset == TS_DROPPED )
+            continue;
+
+        p_storage->i_data_r = p_cmd->u.send.i_offset + p_cmd->u.send.i_size;
+        p_cmd->u.send.i_offset = TS_DROPPED;
+        p_cmd->u.send.p_es->b_discontinuity = true;
     }
-    return p_storage->i_cmd_w >= p_storage->i_cmd_max;
+    p_storage->i_cmd_drop = i_stop;
+    if( i_stop >= i_end )
+        p_storage->i_data_r = p_storage->i_data_w;
+}
+
+static void TsStorageWrite( ts_storage_t *p_storage, const void *p_buf,
+                            size_t i_len )
+{
+    size_t i_offset = p_storage->i_data_w % p_storage->i_data_size;
+    size_t i_copy = __MIN( i_len, p_storage->i_data_size - i_offset );
+
+    memcpy( &p_storage->p_data[i_offset], p_buf, i_copy );
+    memcpy( p_storage->p_data, (const uint8_t *)p_buf + i_copy, i_len - i_copy );
+    p_storage->i_data_w += i_len;
 }
+
+static void TsStorageRead( ts_storage_t *p_storage, uint64_t i_pos,
+                           void *p_buf, size_t i_len )
+{
+    size_t i_offset = i_pos % p_storage->i_data_size;
+    size_t i_copy = __MIN( i_len, p_storage->i_data_size - i_offset );
+
+    memcpy( p_buf, &p_storage->p_data[i_offset], i_copy );
+    memcpy( (uint8_t *)p_buf + i_copy, p_storage->p_data, i_len - i_copy );
+}
+
 static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 {
-    return !p_storage || p_storage->i_cmd_r >= p_storage->i_cmd_w;
+    return !p_storage || p_storage->i_cmd_count == 0;
 }
-static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
+static int TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd )
 {
     ts_cmd_t cmd = *p_cmd;
 
-    assert( !TsStorageIsFull( p_storage, p_cmd ) );
+    if( p_storage->i_cmd_count >= p_storage->i_cmd_max )
+    {   /* Grow the queue, keeping the commands in order */
+        ts_cmd_t *p_new = vlc_reallocarray( p_storage->p_cmd,
+                                            2 * p_storage->i_cmd_max,
+                                            sizeof(*p_storage->p_cmd) );
+        if( unlikely(p_new == NULL) )
+            return VLC_ENOMEM;
+
+        size_t i_first = p_storage->i_cmd_first & (p_storage->i_cmd_max - 1);
+        size_t i_drop = __MAX( p_storage->i_cmd_drop, p_storage->i_cmd_first )
+                        - p_storage->i_cmd_first;
+
+        memcpy( &p_new[p_storage->i_cmd_max], p_new, i_first * sizeof(*p_new) );
+        p_storage->p_cmd = p_new;
+        p_storage->i_cmd_first = i_first;
+        p_storage->i_cmd_drop = i_first + i_drop;
+        p_storage->i_cmd_max *= 2;
+    }
 
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
+        const size_t i_size = sizeof(ts_block_header_t) + p_block->i_buffer;
 
         cmd.u.send.p_block = NULL;
-        cmd.u.send.i_offset = ftell( p_storage->p_filew );
+        cmd.u.send.i_size = i_size;
 
-        if( fwrite( p_block, sizeof(*p_block), 1, p_storage->p_filew ) != 1 )
+        if( likely(i_size <= p_storage->i_data_size) )
         {
-            block_Release( p_block );
-            return;
+            const ts_block_header_t hdr = {
+                .i_dts = p_block->i_dts,
+                .i_pts = p_block->i_pts,
+                .i_length = p_block->i_length,
+                .i_flags = p_block->i_flags,
+                .i_nb_samples = p_block->i_nb_samples,
+            };
+
+            while( p_storage->i_data_w + i_size - p_storage->i_data_r
+                    > p_storage->i_data_size )
+                TsStorageDrop( p_storage );
+
+            cmd.u.send.i_offset = p_storage->i_data_w;
+            TsStorageWrite( p_storage, &hdr, sizeof(hdr) );
+            TsStorageWrite( p_storage, p_block->p_buffer, p_block->i_buffer );
         }
-        p_storage->i_file_size += sizeof(*p_block);
-        if( p_block->i_buffer > 0 )
+        else
         {
-            if( fwrite( p_block->p_buffer, p_block->i_buffer, 1, p_storage->p_filew ) != 1 )
-            {
-                block_Release( p_block );
-                return;
-            }
+            cmd.u.send.i_offset = TS_DROPPED;
+            cmd.u.send.p_es->b_discontinuity = true;
         }
-        p_storage->i_file_size += p_block->i_buffer;
         block_Release( p_block );
-
-        if( b_flush )
-            fflush( p_storage->p_filew );
     }
-    p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+
+    *TsStorageCmd( p_storage, p_storage->i_cmd_first
+                              + p_storage->i_cmd_count++ ) = cmd;
+    return VLC_SUCCESS;
 }
 static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush )
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
-    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
-    {
-        block_t block;
+    *p_cmd = *TsStorageCmd( p_storage, p_storage->i_cmd_first++ );
+    p_storage->i_cmd_count--;
 
-        if( !b_flush &&
-            !fseek( p_storage->p_filer, p_cmd->u.send.i_offset, SEEK_SET ) &&
-            fread( &block, sizeof(block), 1, p_storage->p_filer ) == 1 )
-        {
-            block_t *p_block = block_Alloc( block.i_buffer );
-            if( p_block )
-            {
-                p_block->i_dts      = block.i_dts;
-                p_block->i_pts      = block.i_pts;
-                p_block->i_flags    = block.i_flags;
-                p_block->i_length   = block.i_length;
-                p_block->i_nb_samples = block.i_nb_samples;
-                p_block->i_buffer = fread( p_block->p_buffer, 1, block.i_buffer, p_storage->p_filer );
-            }
-            p_cmd->u.send.p_block = p_block;
-        }
-        else
+    if( p_cmd->i_type != C_SEND )
+        return;
+
+    p_cmd->u.send.p_block = NULL;
+    if( p_cmd->u.send.i_offset == TS_DROPPED )
+        return;
+
+    const uint64_t i_offset = p_cmd->u.send.i_offset;
+    const size_t i_size = p_cmd->u.send.i_size;
+
+    p_storage->i_data_r = i_offset + i_size;
+    if( b_flush )
+        return;
+
+    ts_block_header_t hdr;
+    block_t *p_block = block_Alloc( i_size - sizeof(hdr) );
+
+    if( p_block )
+    {
+        TsStorageRead( p_storage, i_offset, &hdr, sizeof(hdr) );
+        TsStorageRead( p_storage, i_offset + sizeof(hdr), p_block->p_buffer,
+                       p_block->i_buffer );
+        p_block->i_dts      = hdr.i_dts;
+        p_block->i_pts      = hdr.i_pts;
+        p_block->i_flags    = hdr.i_flags;
+        p_block->i_length   = hdr.i_length;
+        p_block->i_nb_samples = hdr.i_nb_samples;
+        if( p_cmd->u.send.p_es->b_discontinuity )
         {
-            //perror( "TsStoragePopCmd" );
-            p_cmd->u.send.p_block = block_Alloc( 1 );
+            p_block->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+            p_cmd->u.send.p_es->b_discontinuity = false;
         }
     }
+    p_cmd->u.send.p_block = p_block;
 }
 
 /*****************************************************************************
@@ -1768,6 +1900,7 @@ static int CmdExecutePrivControl( es_out_t *p_out, ts_cmd_t *p_cmd )
     }
 }
 
+#ifdef HAVE_MMAP
 static int GetTmpFile( char **filename, const char *dirname )
 {
     if( dirname != NULL
@@ -1794,3 +1927,4 @@ static int GetTmpFile( char **filename, const char *dirname )
     free( *filename );
     return -1;
 }
+#endif
@@ -88,6 +88,16 @@ static inline void input_SendEventStatistics(input_thread_t *p_input,
     });
 }
 
+static inline void input_SendEventStartup(input_thread_t *p_input,
+                                          enum input_startup_milestone milestone,
+                                          vlc_tick_t delay)
+{
+    input_SendEvent(p_input, &(struct vlc_input_event) {
+        .type = INPUT_EVENT_STARTUP,
+        .startup = { milestone, delay },
+    });
+}
+
 static inline void input_SendEventRate(input_thread_t *p_input, float rate)
 {
     input_SendEvent(p_input, &(struct vlc_input_event) {
@@ -55,6 +55,8 @@
 #include <vlc_stream_extractor.h>
 #include <vlc_renderer_discovery.h>
 #include <vlc_hash.h>
+#include <vlc_tracer.h>
+#include <vlc_memstats.h>
 
 /*****************************************************************************
  * Local prototypes
@@ -73,6 +75,7 @@ static input_thread_t * Create  ( vlc_object_t *, input_thread_events_cb, void *
                                   input_resource_t *, vlc_renderer_item_t * );
 static void             Destroy ( input_thread_t *p_input );
 static  int             Init    ( input_thread_t *p_input );
+static void             InitPrograms( input_thread_t *p_input );
 static void             End     ( input_thread_t *p_input );
 static void             MainLoop( input_thread_t *p_input, bool b_interactive );
 
@@ -161,7 +164,8 @@ input_thread_t *input_CreateThumbnailer(vlc_object_t *obj,
 /**
  * Start a input_thread_t created by input_Create.
  *
- * You must not start an already running input_thread_t.
+ * You must not start an already running input_thread_t, unless it was
+ * opened with input_Preload().
  *
  * \param the input thread to start
  */
@@ -173,7 +177,21 @@ int input_Start( input_thread_t *p_input )
     if( priv->b_preparsing )
         func = Preparse;
 
+    if( priv->is_running )
+    {
+        vlc_mutex_lock( &priv->lock_control );
+        assert( priv->is_preloading );
+        priv->is_preloading = false;
+        if( priv->stats != NULL )
+            priv->stats->start_date = vlc_tick_now();
+        vlc_cond_signal( &priv->wait_control );
+        vlc_mutex_unlock( &priv->lock_control );
+        return VLC_SUCCESS;
+    }
+
     assert( !priv->is_running );
+    if( priv->stats != NULL && !priv->b_preload )
+        priv->stats->start_date = vlc_tick_now();
     /* Create thread and wait for its readiness. */
     priv->is_running = !vlc_clone( &priv->thread, func, priv,
                                    VLC_THREAD_PRIORITY_INPUT );
@@ -185,6 +203,42 @@ int input_Start( input_thread_t *p_input )
     return VLC_SUCCESS;
 }
 
+int input_Preload( input_thread_t *p_input )
+{
+    input_thread_private_t *priv = input_priv(p_input);
+
+    assert( !priv->b_preparsing && !priv->is_running );
+    priv->b_preload = priv->is_preloading = true;
+    if( input_Start( p_input ) != VLC_SUCCESS )
+    {
+        priv->b_preload = priv->is_preloading = false;
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+void input_SetStartupMilestone( input_thread_t *p_input,
+                                enum input_startup_milestone milestone )
+{
+    static const char names[][16] = {
+        [INPUT_STARTUP_SOURCE_OPENED] = "source opened",
+        [INPUT_STARTUP_TRACKS_SELECTED] = "tracks selected",
+        [INPUT_STARTUP_DECODER_OPENED] = "decoder opened",
+        [INPUT_STARTUP_FIRST_DECODED] = "first decoded",
+        [INPUT_STARTUP_FIRST_OUTPUT] = "first output",
+    };
+    input_thread_private_t *priv = input_priv(p_input);
+    vlc_tick_t delay;
+
+    if( priv->stats == NULL
+     || !input_stats_SetMilestone( priv->stats, milestone, &delay ) )
+        return;
+
+    msg_Dbg( p_input, "startup: %s after %"PRId64" ms", names[milestone],
+             MS_FROM_VLC_TICK( delay ) );
+    input_SendEventStartup( p_input, milestone, delay );
+}
+
 /**
  * Request a running input thread to stop and die
  *
@@ -312,6 +366,8 @@ static input_thread_t *Create( vlc_object_t *p_parent,
     priv->i_state = INIT_S;
     priv->is_running = false;
     priv->is_stopped = false;
+    priv->b_preload = false;
+    priv->is_preloading = false;
     priv->b_recording = false;
     priv->rate = 1.f;
     priv->normal_time = VLC_TICK_0;
@@ -378,6 +434,7 @@ static input_thread_t *Create( vlc_object_t *p_parent,
 
     /* No slave */
     priv->i_slave = 0;
+    priv->subtitles_scan = NULL;
     priv->slave   = NULL;
 
     /* */
@@ -407,6 +464,7 @@ static input_thread_t *Create( vlc_object_t *p_parent,
         priv->stats = input_stats_Create();
     else
         priv->stats = NULL;
+    priv->tracer = vlc_object_get_tracer( p_input );
 
     priv->p_es_out_display = input_EsOutNew( p_input, priv->master, priv->rate );
     if( !priv->p_es_out_display )
@@ -464,9 +522,28 @@ static void *Run( void *data )
     input_thread_t *p_input = &priv->input;
 
     vlc_interrupt_set(&priv->interrupt);
+    vlc_mem_SetStage(VLC_MEM_STAGE_DEMUX);
 
     if( !Init( p_input ) )
     {
+        if( priv->b_preload )
+        {
+            vlc_mutex_lock( &priv->lock_control );
+            while( priv->is_preloading && !priv->is_stopped )
+                vlc_cond_wait( &priv->wait_control, &priv->lock_control );
+            const bool b_stopped = priv->is_stopped;
+            vlc_mutex_unlock( &priv->lock_control );
+
+            /* Deferred by Init() */
+            if( !b_stopped )
+            {
+                InitPrograms( p_input );
+                input_SetStartupMilestone( p_input,
+                                           INPUT_STARTUP_TRACKS_SELECTED );
+                input_ChangeState( p_input, PLAYING_S, vlc_tick_now() );
+            }
+        }
+
         if( priv->b_can_pace_control && priv->b_out_pace_control )
         {
             /* We don't want a high input priority here or we'll
@@ -490,6 +567,7 @@ static void *Preparse( void *data )
     input_thread_t *p_input = &priv->input;
 
     vlc_interrupt_set(&priv->interrupt);
+    vlc_mem_SetStage(VLC_MEM_STAGE_DEMUX);
 
     if( !Init( p_input ) )
     {   /* if the demux is a playlist, call Mainloop that will call
@@ -547,7 +625,11 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
     }
 
     if( i_ret == VLC_DEMUXER_SUCCESS )
+    {
+        vlc_tick_t start = vlc_tracer_Begin( p_priv->tracer );
         i_ret = demux_Demux( p_demux );
+        vlc_tracer_End( p_priv->tracer, "input", "demux", p_demux, start );
+    }
 
     i_ret = i_ret > 0 ? VLC_DEMUXER_SUCCESS : ( i_ret < 0 ? VLC_DEMUXER_EGENERIC : VLC_DEMUXER_EOF);
 
@@ -1032,13 +1114,24 @@ static void LoadSlaves( input_thread_t *p_input )
         }
     }
 
-    if( var_GetBool( p_input, "sub-autodetect-file" ) )
+    struct subtitles_scan *p_scan = input_priv(p_input)->subtitles_scan;
+    input_priv(p_input)->subtitles_scan = NULL;
+    if( p_scan != NULL || var_GetBool( p_input, "sub-autodetect-file" ) )
     {
         /* Add local subtitles */
-        char *psz_autopath = var_GetNonEmptyString( p_input, "sub-autodetect-path" );
+        char *psz_autopath = NULL;
+        int i_ret;
 
-        if( subtitles_Detect( p_input, psz_autopath, input_priv(p_input)->p_item->psz_uri,
-                              &pp_slaves, &i_slaves ) == VLC_SUCCESS )
+        if( p_scan != NULL ) /* started by Init() */
+            i_ret = subtitles_DetectWait( p_scan, &pp_slaves, &i_slaves );
+        else
+        {
+            psz_autopath = var_GetNonEmptyString( p_input, "sub-autodetect-path" );
+            i_ret = subtitles_Detect( p_input, psz_autopath,
+                                      input_priv(p_input)->p_item->psz_uri,
+                                      &pp_slaves, &i_slaves );
+        }
+        if( i_ret == VLC_SUCCESS )
         {
             /* check that we did not add the subtitle through sub-file */
             if( psz_subtitle != NULL )
@@ -1278,6 +1371,17 @@ static int Init( input_thread_t * p_input )
     master = priv->master;
     if( master == NULL )
         goto error;
+
+    /* Look for subtitles files while the master demuxer is being opened:
+     * listing (network) directories can take a while */
+    if( !priv->b_preparsing && var_GetBool( p_input, "sub-autodetect-file" ) )
+    {
+        char *psz_autopath = var_GetNonEmptyString( p_input, "sub-autodetect-path" );
+        priv->subtitles_scan = subtitles_DetectAsync( p_input, psz_autopath,
+                                                      priv->p_item->psz_uri );
+        free( psz_autopath );
+    }
+
     int ret = InputSourceInit( master, p_input, priv->p_item->psz_uri,
                                NULL, false );
     if( ret != VLC_SUCCESS )
@@ -1285,6 +1389,7 @@ static int Init( input_thread_t * p_input )
         InputSourceDestroy( master );
         goto error;
     }
+    input_SetStartupMilestone( p_input, INPUT_STARTUP_SOURCE_OPENED );
 
     InitTitle( p_input, false );
 
@@ -1304,7 +1409,12 @@ static int Init( input_thread_t * p_input )
         StartTitle( p_input );
         SetSubtitlesOptions( p_input );
         LoadSlaves( p_input );
-        InitPrograms( p_input );
+        /* Selecting the tracks creates the decoders and the outputs */
+        if( !priv->b_preload )
+        {
+            InitPrograms( p_input );
+            input_SetStartupMilestone( p_input, INPUT_STARTUP_TRACKS_SELECTED );
+        }
 
         double f_rate = var_GetFloat( p_input, "rate" );
         if( f_rate != 0.0 && f_rate != 1.0 )
@@ -1346,13 +1456,20 @@ static int Init( input_thread_t * p_input )
              input_priv(p_input)->p_item->psz_uri );
 
     /* initialization is complete */
-    input_ChangeState( p_input, PLAYING_S, vlc_tick_now() );
+    if( !priv->b_preload )
+        input_ChangeState( p_input, PLAYING_S, vlc_tick_now() );
 
     return VLC_SUCCESS;
 
 error:
     input_ChangeState( p_input, ERROR_S, VLC_TICK_INVALID );
 
+    if( priv->subtitles_scan != NULL )
+    {
+        subtitles_DetectWait( priv->subtitles_scan, NULL, NULL );
+        priv->subtitles_scan = NULL;
+    }
+
     if( input_priv(p_input)->p_es_out )
         es_out_Delete( input_priv(p_input)->p_es_out );
     es_out_SetMode( input_priv(p_input)->p_es_out_display, ES_OUT_MODE_END );
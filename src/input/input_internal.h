@@ -118,6 +118,8 @@ typedef enum input_event_type_e
 
     /* Input statistics have been updated */
     INPUT_EVENT_STATISTICS,
+    /* A startup milestone was reached */
+    INPUT_EVENT_STARTUP,
     /* At least one of "signal-quality" or "signal-strength" has changed */
     INPUT_EVENT_SIGNAL,
 
@@ -247,6 +249,12 @@ struct vlc_input_event_signal {
     float strength;
 };
 
+struct vlc_input_event_startup {
+    enum input_startup_milestone milestone;
+    /* since the input start */
+    vlc_tick_t delay;
+};
+
 struct vlc_input_event_vout
 {
     enum {
@@ -285,6 +293,8 @@ struct vlc_input_event
         bool record;
         /* INPUT_EVENT_STATISTICS */
         const struct input_stats_t *stats;
+        /* INPUT_EVENT_STARTUP */
+        struct vlc_input_event_startup startup;
         /* INPUT_EVENT_SIGNAL */
         struct vlc_input_event_signal signal;
         /* INPUT_EVENT_CACHE */
@@ -341,6 +351,15 @@ VLC_USED;
 
 int input_Start( input_thread_t * );
 
+/**
+ * Open an input ahead of time
+ *
+ * The input thread opens the access and the demuxer, then waits for
+ * input_Start() before selecting the tracks and demuxing, so that no
+ * decoder nor output is created yet.
+ */
+int input_Preload( input_thread_t * );
+
 void input_Stop( input_thread_t * );
 
 void input_Close( input_thread_t * );
@@ -479,6 +498,8 @@ typedef struct input_thread_private_t
     int         i_state;
     bool        is_running;
     bool        is_stopped;
+    bool        b_preload; /* opened by input_Preload() */
+    bool        is_preloading; /* waiting for input_Start() */
     bool        b_recording;
     bool        b_thumbnailing;
     float       rate;
@@ -520,6 +541,8 @@ typedef struct input_thread_private_t
     int            i_slave;
     input_source_t **slave;
     float          slave_subs_rate;
+    /* Subtitles autodetection, running while the master is opened */
+    struct subtitles_scan *subtitles_scan;
 
     /* Resources */
     input_resource_t *p_resource;
@@ -527,6 +550,9 @@ typedef struct input_thread_private_t
     /* Stats counters */
     struct input_stats *stats;
 
+    /* Tracer, or NULL */
+    struct vlc_tracer *tracer;
+
     /* Buffer of pending actions */
     vlc_mutex_t lock_control;
     vlc_cond_t  wait_control;
@@ -701,6 +727,8 @@ void input_ConfigVarInit ( input_thread_t * );
 /* Subtitles */
 int subtitles_Detect( input_thread_t *, char *, const char *, input_item_slave_t ***, int * );
 int subtitles_Filter( const char *);
+struct subtitles_scan *subtitles_DetectAsync( input_thread_t *, const char *, const char * );
+int subtitles_DetectWait( struct subtitles_scan *, input_item_slave_t ***, int * );
 
 /* meta.c */
 void vlc_audio_replay_gain_MergeFromMeta( audio_replay_gain_t *p_dst,
@@ -719,6 +747,20 @@ typedef struct input_rate_t
     } samples[2];
 } input_rate_t;
 
+/* Timing histograms: bucket n counts the durations below 2^n microseconds */
+#define INPUT_STATS_TIMING_BUCKETS 24
+
+/* Statistics of an elementary stream, updated without locking */
+struct input_es_stats {
+    atomic_int id; /* ES input ID if positive, 0 if the slot is free */
+    int cat;
+    atomic_uint fifo_depth;
+    atomic_uint fifo_depth_max;
+    atomic_uint decode_time[INPUT_STATS_TIMING_BUCKETS];
+    atomic_uint latency[INPUT_STATS_TIMING_BUCKETS];
+    _Atomic vlc_tick_t drift;
+};
+
 struct input_stats {
     input_rate_t input_bitrate;
     input_rate_t demux_bitrate;
@@ -726,15 +768,42 @@ struct input_stats {
     atomic_uintmax_t demux_discontinuity;
     atomic_uintmax_t decoded_audio;
     atomic_uintmax_t decoded_video;
+    atomic_uintmax_t pooled_abuffers;
+    atomic_uintmax_t allocated_abuffers;
     atomic_uintmax_t played_abuffers;
     atomic_uintmax_t lost_abuffers;
     atomic_uintmax_t displayed_pictures;
     atomic_uintmax_t lost_pictures;
+    vlc_tick_t start_date;
+    atomic_uintmax_t startup[INPUT_STARTUP_COUNT]; /* dates, 0 if not reached */
+    _Atomic vlc_tick_t clock_drift;
+    _Atomic vlc_tick_t clock_jitter;
+    struct {
+        vlc_tick_t date;
+        uint64_t count[VLC_MEM_STAGE_COUNT];
+    } allocs[2]; /* latest and previous samples, owned by the input thread */
+    struct input_es_stats es[INPUT_STATS_MAX_ES];
 };
 
 struct input_stats *input_stats_Create(void);
 void input_stats_Destroy(struct input_stats *);
 void input_rate_Add(input_rate_t *, uintmax_t);
 void input_stats_Compute(struct input_stats *, input_stats_t*);
+bool input_stats_SetMilestone(struct input_stats *,
+                              enum input_startup_milestone, vlc_tick_t *);
+struct input_es_stats *input_stats_AcquireEs(struct input_stats *, int id,
+                                             int cat);
+void input_stats_ReleaseEs(struct input_es_stats *);
+void input_es_stats_AddDecode(struct input_es_stats *, unsigned fifo_depth,
+                              vlc_tick_t decode_time);
+void input_es_stats_AddOutput(struct input_es_stats *, vlc_tick_t latency,
+                              vlc_tick_t drift);
+void input_stats_SetClock(struct input_stats *, vlc_tick_t drift,
+                          vlc_tick_t jitter);
+
+/**
+ * Record a startup milestone of the input, and report it the first time
+ */
+void input_SetStartupMilestone(input_thread_t *, enum input_startup_milestone);
 
 #endif
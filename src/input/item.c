@@ -859,7 +859,51 @@ void input_item_MergeInfos( input_item_t *p_item, info_category_t *p_cat )
                     &(vlc_event_t) { .type = vlc_InputItemInfoChanged } );
 }
 
-void input_item_SetEpgEvent( input_item_t *p_item, const vlc_epg_event_t *p_epg_evt )
+static bool EpgStringEquals( const char *a, const char *b )
+{
+    return a == b || ( a && b && !strcmp( a, b ) );
+}
+
+static bool EpgEventEquals( const vlc_epg_event_t *a, const vlc_epg_event_t *b )
+{
+    if( a->i_start != b->i_start || a->i_duration != b->i_duration ||
+        a->i_id != b->i_id || a->i_rating != b->i_rating ||
+        a->i_description_items != b->i_description_items ||
+        !EpgStringEquals( a->psz_name, b->psz_name ) ||
+        !EpgStringEquals( a->psz_short_description, b->psz_short_description ) ||
+        !EpgStringEquals( a->psz_description, b->psz_description ) )
+        return false;
+
+    for( int i = 0; i < a->i_description_items; i++ )
+    {
+        if( !EpgStringEquals( a->description_items[i].psz_key,
+                              b->description_items[i].psz_key ) ||
+            !EpgStringEquals( a->description_items[i].psz_value,
+                              b->description_items[i].psz_value ) )
+            return false;
+    }
+    return true;
+}
+
+/* Broadcasters repeat their tables continuously: detect the updates that
+ * do not change anything, so as not to replace and signal the table. */
+static bool EpgEquals( const vlc_epg_t *a, const vlc_epg_t *b )
+{
+    if( a->i_event != b->i_event || a->b_present != b->b_present ||
+        !EpgStringEquals( a->psz_name, b->psz_name ) ||
+        ( a->p_current == NULL ) != ( b->p_current == NULL ) )
+        return false;
+
+    for( size_t i = 0; i < a->i_event; i++ )
+    {
+        if( ( a->p_current == a->pp_event[i] ) != ( b->p_current == b->pp_event[i] ) ||
+            !EpgEventEquals( a->pp_event[i], b->pp_event[i] ) )
+            return false;
+    }
+    return true;
+}
+
+bool input_item_SetEpgEvent( input_item_t *p_item, const vlc_epg_event_t *p_epg_evt )
 {
     bool b_changed = false;
     vlc_mutex_lock( &p_item->lock );
@@ -872,6 +916,9 @@ void input_item_SetEpgEvent( input_item_t *p_item, const vlc_epg_event_t *p_epg_
             /* Same event can exist in more than one table */
             if( p_epg->pp_event[j]->i_id == p_epg_evt->i_id )
             {
+                if( EpgEventEquals( p_epg->pp_event[j], p_epg_evt ) )
+                    break;
+
                 vlc_epg_event_t *p_dup = vlc_epg_event_Duplicate( p_epg_evt );
                 if( p_dup )
                 {
@@ -892,6 +939,7 @@ void input_item_SetEpgEvent( input_item_t *p_item, const vlc_epg_event_t *p_epg_
         vlc_event_send( &p_item->event_manager,
                         &(vlc_event_t) { .type = vlc_InputItemInfoChanged } );
     }
+    return b_changed;
 }
 
 //#define EPG_DEBUG
@@ -911,12 +959,8 @@ static int InputItemAddInfo( input_item_t *p_i,
 }
 #endif
 
-void input_item_SetEpg( input_item_t *p_item, const vlc_epg_t *p_update, bool b_current_source )
+bool input_item_SetEpg( input_item_t *p_item, const vlc_epg_t *p_update, bool b_current_source )
 {
-    vlc_epg_t *p_epg = vlc_epg_Duplicate( p_update );
-    if( !p_epg )
-        return;
-
     vlc_mutex_lock( &p_item->lock );
 
     /* */
@@ -931,6 +975,22 @@ void input_item_SetEpg( input_item_t *p_item, const vlc_epg_t *p_update, bool b_
         }
     }
 
+    /* unchanged repetition of the table */
+    if( pp_epg && EpgEquals( *pp_epg, p_update ) )
+    {
+        if( b_current_source && (*pp_epg)->b_present )
+            p_item->p_epg_table = *pp_epg;
+        vlc_mutex_unlock( &p_item->lock );
+        return false;
+    }
+
+    vlc_epg_t *p_epg = vlc_epg_Duplicate( p_update );
+    if( !p_epg )
+    {
+        vlc_mutex_unlock( &p_item->lock );
+        return false;
+    }
+
     /* replace with new version */
     if( pp_epg )
     {
@@ -986,6 +1046,7 @@ signal:
 #endif
     vlc_event_send( &p_item->event_manager,
                     &(vlc_event_t){ .type = vlc_InputItemInfoChanged, } );
+    return true;
 }
 
 void input_item_ChangeEPGSource( input_item_t *p_item, int i_source_id )
@@ -1263,6 +1324,7 @@ input_item_node_t *input_item_node_Create( input_item_t *p_input )
 
     p_node->i_children = 0;
     p_node->pp_children = NULL;
+    p_node->b_partial = false;
 
     return p_node;
 }
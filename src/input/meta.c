@@ -26,10 +26,12 @@
 #endif
 
 #include <assert.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_url.h>
 #include <vlc_arrays.h>
+#include <vlc_hashmap.h>
 #include <vlc_modules.h>
 #include <vlc_charset.h>
 
@@ -38,13 +40,124 @@
 
 struct vlc_meta_t
 {
-    char * ppsz_meta[VLC_META_TYPE_COUNT];
+    char * ppsz_meta[VLC_META_TYPE_COUNT]; /* vlc_meta_str_t strings */
 
-    vlc_dictionary_t extra_tags;
+    vlc_hashmap_t extra_tags;
 
     int i_status;
 };
 
+/*
+ * The values of the meta table are reference counted, so that copying a
+ * meta (e.g. for each copy of an input item) shares them. The values that
+ * many items have in common, such as artists and albums, are furthermore
+ * interned in a process-wide pool.
+ */
+typedef struct
+{
+    atomic_uint refs;
+    bool interned;
+    char str[];
+} vlc_meta_str_t;
+
+static const bool vlc_meta_interned[VLC_META_TYPE_COUNT] =
+{
+    [vlc_meta_Artist]      = true,
+    [vlc_meta_Genre]       = true,
+    [vlc_meta_Copyright]   = true,
+    [vlc_meta_Album]       = true,
+    [vlc_meta_Date]        = true,
+    [vlc_meta_Setting]     = true,
+    [vlc_meta_Language]    = true,
+    [vlc_meta_Publisher]   = true,
+    [vlc_meta_EncodedBy]   = true,
+    [vlc_meta_TrackTotal]  = true,
+    [vlc_meta_Director]    = true,
+    [vlc_meta_ShowName]    = true,
+    [vlc_meta_AlbumArtist] = true,
+    [vlc_meta_DiscTotal]   = true,
+};
+
+static vlc_mutex_t vlc_meta_pool_lock = VLC_STATIC_MUTEX;
+static vlc_hashmap_t vlc_meta_pool = { .str_keys = true };
+
+static vlc_meta_str_t *vlc_meta_str_Alloc( const char *psz, bool interned )
+{
+    size_t len = strlen( psz ) + 1;
+    vlc_meta_str_t *str = malloc( sizeof (*str) + len );
+    if( unlikely(str == NULL) )
+        return NULL;
+
+    atomic_init( &str->refs, 1 );
+    str->interned = interned;
+    memcpy( str->str, psz, len );
+    return str;
+}
+
+static char *vlc_meta_str_New( const char *psz, bool interned )
+{
+    vlc_meta_str_t *str;
+
+    if( !interned )
+    {
+        str = vlc_meta_str_Alloc( psz, false );
+        return likely(str != NULL) ? str->str : NULL;
+    }
+
+    vlc_mutex_lock( &vlc_meta_pool_lock );
+    str = vlc_hashmap_str_get( &vlc_meta_pool, psz );
+    if( str != NULL )
+        atomic_fetch_add_explicit( &str->refs, 1, memory_order_relaxed );
+    else
+    {
+        str = vlc_meta_str_Alloc( psz, true );
+        if( likely(str != NULL)
+         && vlc_hashmap_str_insert( &vlc_meta_pool, psz, str ) )
+        {
+            /* Cannot be shared, but still usable */
+            str->interned = false;
+        }
+    }
+    vlc_mutex_unlock( &vlc_meta_pool_lock );
+    return likely(str != NULL) ? str->str : NULL;
+}
+
+static char *vlc_meta_str_Hold( char *psz )
+{
+    vlc_meta_str_t *str = container_of( psz, vlc_meta_str_t, str );
+
+    atomic_fetch_add_explicit( &str->refs, 1, memory_order_relaxed );
+    return psz;
+}
+
+static void vlc_meta_str_Release( char *psz )
+{
+    if( psz == NULL )
+        return;
+
+    vlc_meta_str_t *str = container_of( psz, vlc_meta_str_t, str );
+
+    if( !str->interned )
+    {
+        if( atomic_fetch_sub_explicit( &str->refs, 1,
+                                       memory_order_acq_rel ) == 1 )
+            free( str );
+        return;
+    }
+
+    /* The pool can only hand out a new reference with the lock held */
+    vlc_mutex_lock( &vlc_meta_pool_lock );
+    if( atomic_fetch_sub_explicit( &str->refs, 1,
+                                   memory_order_relaxed ) == 1 )
+    {
+        vlc_hashmap_str_remove( &vlc_meta_pool, str->str );
+        free( str );
+        if( vlc_hashmap_count( &vlc_meta_pool ) == 0 )
+            vlc_hashmap_clear( &vlc_meta_pool, NULL, NULL );
+    }
+    vlc_mutex_unlock( &vlc_meta_pool_lock );
+}
+
 /* FIXME bad name convention */
 const char * vlc_meta_TypeToLocalizedString( vlc_meta_type_t meta_type )
 {
@@ -94,11 +207,11 @@ vlc_meta_t *vlc_meta_New( void )
         return NULL;
     memset( m->ppsz_meta, 0, sizeof(m->ppsz_meta) );
     m->i_status = 0;
-    vlc_dictionary_init( &m->extra_tags, 0 );
+    vlc_hashmap_init_str( &m->extra_tags );
     return m;
 }
 
-/* Free a dictonary key allocated by strdup() in vlc_meta_AddExtra() */
+/* Free a value allocated by strdup() in vlc_meta_AddExtra() */
 static void vlc_meta_FreeExtraKey( void *p_data, void *p_obj )
 {
     VLC_UNUSED( p_obj );
@@ -108,8 +221,8 @@ static void vlc_meta_FreeExtraKey( void *p_data, void *p_obj )
 void vlc_meta_Delete( vlc_meta_t *m )
 {
     for( int i = 0; i < VLC_META_TYPE_COUNT ; i++ )
-        free( m->ppsz_meta[i] );
-    vlc_dictionary_clear( &m->extra_tags, vlc_meta_FreeExtraKey, NULL );
+        vlc_meta_str_Release( m->ppsz_meta[i] );
+    vlc_hashmap_clear( &m->extra_tags, vlc_meta_FreeExtraKey, NULL );
     free( m );
 }
 
@@ -121,9 +234,10 @@ void vlc_meta_Delete( vlc_meta_t *m )
 
 void vlc_meta_Set( vlc_meta_t *p_meta, vlc_meta_type_t meta_type, const char *psz_val )
 {
-    free( p_meta->ppsz_meta[meta_type] );
+    vlc_meta_str_Release( p_meta->ppsz_meta[meta_type] );
     assert( psz_val == NULL || IsUTF8( psz_val ) );
-    p_meta->ppsz_meta[meta_type] = psz_val ? strdup( psz_val ) : NULL;
+    p_meta->ppsz_meta[meta_type] = psz_val ?
+        vlc_meta_str_New( psz_val, vlc_meta_interned[meta_type] ) : NULL;
 }
 
 const char *vlc_meta_Get( const vlc_meta_t *p_meta, vlc_meta_type_t meta_type )
@@ -133,26 +247,43 @@ const char *vlc_meta_Get( const vlc_meta_t *p_meta, vlc_meta_type_t meta_type )
 
 void vlc_meta_AddExtra( vlc_meta_t *m, const char *psz_name, const char *psz_value )
 {
-    char *psz_oldvalue = (char *)vlc_dictionary_value_for_key( &m->extra_tags, psz_name );
-    if( psz_oldvalue != kVLCDictionaryNotFound )
-        vlc_dictionary_remove_value_for_key( &m->extra_tags, psz_name,
-                                            vlc_meta_FreeExtraKey, NULL );
-    vlc_dictionary_insert( &m->extra_tags, psz_name, strdup(psz_value) );
+    char *psz_copy = strdup( psz_value );
+    if( unlikely(psz_copy == NULL) )
+        return;
+
+    void **pp_value = vlc_hashmap_str_lookup( &m->extra_tags, psz_name );
+    if( pp_value != NULL )
+    {
+        free( *pp_value );
+        *pp_value = psz_copy;
+    }
+    else if( vlc_hashmap_str_insert( &m->extra_tags, psz_name, psz_copy ) )
+        free( psz_copy );
 }
 
 const char * vlc_meta_GetExtra( const vlc_meta_t *m, const char *psz_name )
 {
-    return (char *)vlc_dictionary_value_for_key(&m->extra_tags, psz_name);
+    return (char *)vlc_hashmap_str_get(&m->extra_tags, psz_name);
 }
 
 unsigned vlc_meta_GetExtraCount( const vlc_meta_t *m )
 {
-    return vlc_dictionary_keys_count(&m->extra_tags);
+    return vlc_hashmap_count(&m->extra_tags);
 }
 
 char** vlc_meta_CopyExtraNames( const vlc_meta_t *m )
 {
-    return vlc_dictionary_all_keys(&m->extra_tags);
+    char **ppsz_names = malloc( (vlc_hashmap_count( &m->extra_tags ) + 1)
+                                * sizeof (*ppsz_names) );
+    if( unlikely(ppsz_names == NULL) )
+        return NULL;
+
+    struct vlc_hashmap_slot *slot;
+    size_t i = 0;
+    vlc_hashmap_foreach( slot, &m->extra_tags )
+        ppsz_names[i++] = strdup( slot->key.str );
+    ppsz_names[i] = NULL;
+    return ppsz_names;
 }
 
 /**
@@ -179,25 +310,16 @@ void vlc_meta_Merge( vlc_meta_t *dst, const vlc_meta_t *src )
 
     for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
     {
-        if( src->ppsz_meta[i] )
+        if( src->ppsz_meta[i] && src->ppsz_meta[i] != dst->ppsz_meta[i] )
         {
-            free( dst->ppsz_meta[i] );
-            dst->ppsz_meta[i] = strdup( src->ppsz_meta[i] );
+            vlc_meta_str_Release( dst->ppsz_meta[i] );
+            dst->ppsz_meta[i] = vlc_meta_str_Hold( src->ppsz_meta[i] );
         }
     }
 
-    /* XXX: If speed up are needed, it is possible */
-    char **ppsz_all_keys = vlc_dictionary_all_keys( &src->extra_tags );
-    for( int i = 0; ppsz_all_keys && ppsz_all_keys[i]; i++ )
-    {
-        /* Always try to remove the previous value */
-        vlc_dictionary_remove_value_for_key( &dst->extra_tags, ppsz_all_keys[i], vlc_meta_FreeExtraKey, NULL );
-
-        void *p_value = vlc_dictionary_value_for_key( &src->extra_tags, ppsz_all_keys[i] );
-        vlc_dictionary_insert( &dst->extra_tags, ppsz_all_keys[i], strdup( (const char*)p_value ) );
-        free( ppsz_all_keys[i] );
-    }
-    free( ppsz_all_keys );
+    struct vlc_hashmap_slot *slot;
+    vlc_hashmap_foreach( slot, &src->extra_tags )
+        vlc_meta_AddExtra( dst, slot->key.str, slot->value );
 }
 
 
@@ -210,7 +332,7 @@ void input_ExtractAttachmentAndCacheArt( input_thread_t *p_input,
     {   /* XXX Weird, we should not end up with attachment:// art URL
          * unless there is a race condition */
         msg_Warn( p_input, "art already fetched" );
-        if( likely(input_FindArtInCache( p_item ) == VLC_SUCCESS) )
+        if( likely(input_FindArtInCache( VLC_OBJECT(p_input), p_item ) == VLC_SUCCESS) )
             return;
     }
 
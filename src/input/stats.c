@@ -24,6 +24,7 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -63,10 +64,21 @@ struct input_stats *input_stats_Create(void)
     atomic_init(&stats->demux_discontinuity, 0);
     atomic_init(&stats->decoded_audio, 0);
     atomic_init(&stats->decoded_video, 0);
+    atomic_init(&stats->pooled_abuffers, 0);
+    atomic_init(&stats->allocated_abuffers, 0);
     atomic_init(&stats->played_abuffers, 0);
     atomic_init(&stats->lost_abuffers, 0);
     atomic_init(&stats->displayed_pictures, 0);
     atomic_init(&stats->lost_pictures, 0);
+    stats->start_date = VLC_TICK_INVALID;
+    for (size_t i = 0; i < INPUT_STARTUP_COUNT; i++)
+        atomic_init(&stats->startup[i], 0);
+    atomic_init(&stats->clock_drift, VLC_TICK_INVALID);
+    atomic_init(&stats->clock_jitter, VLC_TICK_INVALID);
+    stats->allocs[0].date = VLC_TICK_INVALID;
+    stats->allocs[1].date = VLC_TICK_INVALID;
+    for (size_t i = 0; i < INPUT_STATS_MAX_ES; i++)
+        atomic_init(&stats->es[i].id, 0);
     return stats;
 }
 
@@ -75,6 +87,183 @@ void input_stats_Destroy(struct input_stats *stats)
     free(stats);
 }
 
+static void input_es_stats_Reset(struct input_es_stats *es)
+{
+    atomic_init(&es->fifo_depth, 0);
+    atomic_init(&es->fifo_depth_max, 0);
+    for (size_t i = 0; i < INPUT_STATS_TIMING_BUCKETS; i++)
+    {
+        atomic_init(&es->decode_time[i], 0);
+        atomic_init(&es->latency[i], 0);
+    }
+    atomic_init(&es->drift, VLC_TICK_INVALID);
+}
+
+static void stats_AddTiming(atomic_uint *hist, vlc_tick_t duration)
+{
+    unsigned bucket = 0;
+    uint64_t us = __MAX(US_FROM_VLC_TICK(duration), 0);
+
+    while (us > 0 && bucket < INPUT_STATS_TIMING_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&hist[bucket], 1, memory_order_relaxed);
+}
+
+/* Resets a timing histogram, and estimates its percentiles as the upper
+ * bounds of the buckets where they fall */
+static void stats_GetResetPercentiles(atomic_uint *hist, vlc_tick_t *out)
+{
+    static const unsigned percents[INPUT_STATS_PERCENTILE_COUNT] = {
+        50, 95, 99
+    };
+    unsigned counts[INPUT_STATS_TIMING_BUCKETS];
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < INPUT_STATS_TIMING_BUCKETS; i++)
+    {
+        counts[i] = atomic_exchange_explicit(&hist[i], 0,
+                                             memory_order_relaxed);
+        total += counts[i];
+    }
+
+    for (size_t p = 0; p < INPUT_STATS_PERCENTILE_COUNT; p++)
+    {
+        if (total == 0)
+        {
+            out[p] = VLC_TICK_INVALID;
+            continue;
+        }
+
+        uint64_t rank = (total * percents[p] + 99) / 100;
+        uint64_t seen = 0;
+        size_t i = 0;
+
+        while ((seen += counts[i]) < rank)
+            i++;
+        out[p] = VLC_TICK_FROM_US(UINT64_C(1) << i);
+    }
+}
+
+/** Allocate the statistics of an ES
+ * \return the statistics, or NULL if all the slots are in use
+ */
+struct input_es_stats *input_stats_AcquireEs(struct input_stats *stats,
+                                             int id, int cat)
+{
+    for (size_t i = 0; i < INPUT_STATS_MAX_ES; i++)
+    {
+        struct input_es_stats *es = &stats->es[i];
+        int expected = 0;
+
+        /* Reserve the slot, then publish it once initialized */
+        if (!atomic_compare_exchange_strong_explicit(&es->id, &expected, -1,
+                                                     memory_order_acquire,
+                                                     memory_order_relaxed))
+            continue;
+
+        es->cat = cat;
+        input_es_stats_Reset(es);
+        atomic_store_explicit(&es->id, __MAX(id, 0) + 1,
+                              memory_order_release);
+        return es;
+    }
+    return NULL;
+}
+
+void input_stats_ReleaseEs(struct input_es_stats *es)
+{
+    atomic_store_explicit(&es->id, 0, memory_order_release);
+}
+
+void input_es_stats_AddDecode(struct input_es_stats *es, unsigned fifo_depth,
+                              vlc_tick_t decode_time)
+{
+    atomic_store_explicit(&es->fifo_depth, fifo_depth, memory_order_relaxed);
+
+    unsigned max = atomic_load_explicit(&es->fifo_depth_max,
+                                        memory_order_relaxed);
+    while (fifo_depth > max
+        && !atomic_compare_exchange_weak_explicit(&es->fifo_depth_max, &max,
+                                                  fifo_depth,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+
+    stats_AddTiming(es->decode_time, decode_time);
+}
+
+void input_es_stats_AddOutput(struct input_es_stats *es, vlc_tick_t latency,
+                              vlc_tick_t drift)
+{
+    if (latency != VLC_TICK_INVALID)
+        stats_AddTiming(es->latency, latency);
+    if (drift != VLC_TICK_INVALID)
+        atomic_store_explicit(&es->drift, drift, memory_order_relaxed);
+}
+
+/** Publish the input clock estimations of the master program */
+void input_stats_SetClock(struct input_stats *stats, vlc_tick_t drift,
+                          vlc_tick_t jitter)
+{
+    atomic_store_explicit(&stats->clock_drift, drift, memory_order_relaxed);
+    atomic_store_explicit(&stats->clock_jitter, jitter, memory_order_relaxed);
+}
+
+static void input_es_stats_Compute(struct input_stats *stats,
+                                   input_stats_t *st)
+{
+    st->i_es = 0;
+    for (size_t i = 0; i < INPUT_STATS_MAX_ES; i++)
+    {
+        struct input_es_stats *es = &stats->es[i];
+        int id = atomic_load_explicit(&es->id, memory_order_acquire);
+        if (id <= 0)
+            continue;
+
+        struct input_es_stats_t *out = &st->es[st->i_es++];
+        out->i_id = id - 1;
+        out->i_cat = es->cat;
+        out->i_fifo_depth = atomic_load_explicit(&es->fifo_depth,
+                                                 memory_order_relaxed);
+        out->i_fifo_depth_max = atomic_exchange_explicit(&es->fifo_depth_max,
+                                                         out->i_fifo_depth,
+                                                         memory_order_relaxed);
+        stats_GetResetPercentiles(es->decode_time, out->decode_time);
+        stats_GetResetPercentiles(es->latency, out->latency);
+        out->drift = atomic_load_explicit(&es->drift, memory_order_relaxed);
+    }
+}
+
+static void input_stats_ComputeAllocations(struct input_stats *stats,
+                                           input_stats_t *st)
+{
+    vlc_tick_t now = vlc_tick_now();
+
+    /* Sample the counters at most once per second */
+    if (stats->allocs[0].date == VLC_TICK_INVALID
+     || now - stats->allocs[0].date >= VLC_TICK_FROM_SEC(1))
+    {
+        stats->allocs[1] = stats->allocs[0];
+        stats->allocs[0].date = now;
+        vlc_mem_GetAllocations(stats->allocs[0].count);
+    }
+
+    for (size_t i = 0; i < VLC_MEM_STAGE_COUNT; i++)
+    {
+        if (stats->allocs[1].date == VLC_TICK_INVALID)
+        {
+            st->f_allocations[i] = 0.f;
+            continue;
+        }
+
+        uint64_t count = stats->allocs[0].count[i] - stats->allocs[1].count[i];
+        st->f_allocations[i] = count * (float)CLOCK_FREQ
+            / (float)(stats->allocs[0].date - stats->allocs[1].date);
+    }
+}
+
 void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
 {
     /* Input */
@@ -96,6 +285,10 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
     /* Aout */
     st->i_decoded_audio = atomic_load_explicit(&stats->decoded_audio,
                                                memory_order_relaxed);
+    st->i_pooled_abuffers = atomic_load_explicit(&stats->pooled_abuffers,
+                                                 memory_order_relaxed);
+    st->i_allocated_abuffers = atomic_load_explicit(
+                    &stats->allocated_abuffers, memory_order_relaxed);
     st->i_played_abuffers = atomic_load_explicit(&stats->played_abuffers,
                                                  memory_order_relaxed);
     st->i_lost_abuffers = atomic_load_explicit(&stats->lost_abuffers,
@@ -108,6 +301,44 @@ void input_stats_Compute(struct input_stats *stats, input_stats_t *st)
                                                     memory_order_relaxed);
     st->i_lost_pictures = atomic_load_explicit(&stats->lost_pictures,
                                                memory_order_relaxed);
+
+    /* Startup */
+    for (size_t i = 0; i < INPUT_STARTUP_COUNT; i++)
+    {
+        vlc_tick_t date = atomic_load_explicit(&stats->startup[i],
+                                               memory_order_relaxed);
+        st->startup[i] = date != 0 && stats->start_date != VLC_TICK_INVALID ?
+            __MAX(date - stats->start_date, 0) : VLC_TICK_INVALID;
+    }
+
+    /* Clock */
+    st->clock_drift = atomic_load_explicit(&stats->clock_drift,
+                                           memory_order_relaxed);
+    st->clock_jitter = atomic_load_explicit(&stats->clock_jitter,
+                                            memory_order_relaxed);
+
+    input_stats_ComputeAllocations(stats, st);
+    input_es_stats_Compute(stats, st);
+}
+
+/** Record the date of a startup milestone
+ * \return true the first time the milestone is reached, with its delay since
+ * the start of the input
+ */
+bool input_stats_SetMilestone(struct input_stats *stats,
+                              enum input_startup_milestone milestone,
+                              vlc_tick_t *delay)
+{
+    assert(milestone < INPUT_STARTUP_COUNT);
+    uintmax_t expected = 0;
+    vlc_tick_t now = vlc_tick_now();
+    if (!atomic_compare_exchange_strong(&stats->startup[milestone],
+                                        &expected, now))
+        return false;
+    /* Reached while preloading: already there when started */
+    *delay = stats->start_date != VLC_TICK_INVALID ?
+             __MAX(now - stats->start_date, 0) : 0;
+    return true;
 }
 
 /** Update a counter element with new values
@@ -81,6 +81,7 @@ stream_t *vlc_stream_CustomNew(vlc_object_t *parent,
     s->pf_read = NULL;
     s->pf_block = NULL;
     s->pf_readdir = NULL;
+    s->i_readdir_batch = 0;
     s->pf_seek = NULL;
     s->pf_control = NULL;
     s->p_sys = NULL;
@@ -699,6 +700,18 @@ int vlc_stream_vaControl(stream_t *s, int cmd, va_list args)
 
             return VLC_SUCCESS;
         }
+
+        case STREAM_GET_BUFFERED:
+        {
+            block_t *block = (priv->peek != NULL) ? priv->peek : priv->block;
+
+            if (block == NULL || block->i_buffer == 0)
+                break;
+
+            *va_arg(args, const void **) = block->p_buffer;
+            *va_arg(args, size_t *) = block->i_buffer;
+            return VLC_SUCCESS;
+        }
     }
     return s->pf_control(s, cmd, args);
 }
@@ -737,3 +750,13 @@ int vlc_stream_ReadDir( stream_t *s, input_item_node_t *p_node )
     assert(s->pf_readdir != NULL);
     return s->pf_readdir( s, p_node );
 }
+
+int vlc_stream_ReadDirBatch( stream_t *s, input_item_node_t *p_node,
+                             size_t max )
+{
+    assert(s->pf_readdir != NULL);
+    s->i_readdir_batch = max;
+    int ret = s->pf_readdir( s, p_node );
+    s->i_readdir_batch = 0;
+    return ret;
+}
@@ -31,12 +31,14 @@
 #endif
 
 #include <ctype.h> /* isalnum() */
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
 #include <vlc_common.h>
 #include <vlc_fs.h>
 #include <vlc_url.h>
+#include <vlc_arrays.h>
 
 #include "input_internal.h"
 
@@ -93,15 +95,6 @@ static void strcpy_strip_ext( char *d, const char *s )
     }
 }
 
-static void strcpy_get_ext( char *d, const char *s )
-{
-    const char *tmp = strrchr(s, '.');
-    if( !tmp )
-        strcpy(d, "");
-    else
-        strcpy( d, tmp + 1 );
-}
-
 static int whiteonly( const char *s )
 {
     unsigned char c;
@@ -194,6 +187,194 @@ static char **paths_to_list( const char *psz_dir, char *psz_path )
     return subdirs;
 }
 
+/**
+ * Listings of the subtitle files of the recently scanned directories.
+ *
+ * Each entry is the file name followed by its normalized form (see
+ * strcpy_trim()), in the same allocation. A listing is valid as long as the
+ * modification time of its directory does not change.
+ */
+struct subtitles_dir
+{
+    char *psz_dir;
+    time_t i_mtime;
+    int i_entries;
+    char **pp_entries;
+};
+
+#define SUBTITLES_DIR_CACHE 8
+
+static struct
+{
+    vlc_mutex_t lock;
+    unsigned i_next;
+    struct subtitles_dir *dirs[SUBTITLES_DIR_CACHE];
+} subtitles_cache = { VLC_STATIC_MUTEX, 0, { NULL } };
+
+static const char *subtitles_entry_trim( const char *psz_entry )
+{
+    return psz_entry + strlen( psz_entry ) + 1;
+}
+
+static void subtitles_dir_Delete( struct subtitles_dir *p_dir )
+{
+    for( int i = 0; i < p_dir->i_entries; i++ )
+        free( p_dir->pp_entries[i] );
+    TAB_CLEAN( p_dir->i_entries, p_dir->pp_entries );
+    free( p_dir->psz_dir );
+    free( p_dir );
+}
+
+static struct subtitles_dir *subtitles_dir_List( const char *psz_dir,
+                                                 time_t i_mtime )
+{
+    DIR *dir = vlc_opendir( psz_dir );
+    if( dir == NULL )
+        return NULL;
+
+    struct subtitles_dir *p_dir = malloc( sizeof( *p_dir ) );
+    if( unlikely(p_dir == NULL) )
+    {
+        closedir( dir );
+        return NULL;
+    }
+    p_dir->psz_dir = strdup( psz_dir );
+    p_dir->i_mtime = i_mtime;
+    TAB_INIT( p_dir->i_entries, p_dir->pp_entries );
+
+    const char *psz_name;
+    while( p_dir->psz_dir != NULL && (psz_name = vlc_readdir( dir )) )
+    {
+        if( psz_name[0] == '.' || !subtitles_Filter( psz_name ) )
+            continue;
+
+        size_t i_len = strlen( psz_name );
+        char tmp_fname_noext[i_len + 1];
+        char *psz_entry = malloc( 2 * (i_len + 1) );
+        if( unlikely(psz_entry == NULL) )
+            continue;
+
+        memcpy( psz_entry, psz_name, i_len + 1 );
+        strcpy_strip_ext( tmp_fname_noext, psz_name );
+        strcpy_trim( psz_entry + i_len + 1, tmp_fname_noext );
+        TAB_APPEND( p_dir->i_entries, p_dir->pp_entries, psz_entry );
+    }
+    closedir( dir );
+
+    if( unlikely(p_dir->psz_dir == NULL) )
+    {
+        subtitles_dir_Delete( p_dir );
+        return NULL;
+    }
+    return p_dir;
+}
+
+/* The cache lock must be held */
+static struct subtitles_dir *subtitles_cache_Get( const char *psz_dir,
+                                                  time_t i_mtime )
+{
+    for( unsigned i = 0; i < SUBTITLES_DIR_CACHE; i++ )
+    {
+        struct subtitles_dir *p_dir = subtitles_cache.dirs[i];
+        if( p_dir != NULL && p_dir->i_mtime == i_mtime
+         && !strcmp( p_dir->psz_dir, psz_dir ) )
+            return p_dir;
+    }
+    return NULL;
+}
+
+/* The cache lock must be held */
+static void subtitles_cache_Put( struct subtitles_dir *p_new )
+{
+    unsigned i_slot = subtitles_cache.i_next;
+
+    /* Replace the outdated listing of the same directory, if any */
+    for( unsigned i = 0; i < SUBTITLES_DIR_CACHE; i++ )
+    {
+        struct subtitles_dir *p_dir = subtitles_cache.dirs[i];
+        if( p_dir != NULL && !strcmp( p_dir->psz_dir, p_new->psz_dir ) )
+        {
+            i_slot = i;
+            break;
+        }
+    }
+    if( i_slot == subtitles_cache.i_next )
+        subtitles_cache.i_next = (i_slot + 1) % SUBTITLES_DIR_CACHE;
+
+    if( subtitles_cache.dirs[i_slot] != NULL )
+        subtitles_dir_Delete( subtitles_cache.dirs[i_slot] );
+    subtitles_cache.dirs[i_slot] = p_new;
+}
+
+struct subtitles_match
+{
+    int i_prio;
+    char psz_path[];
+};
+
+/**
+ * Compares the listing of a directory with the (normalized) media name.
+ */
+static void subtitles_dir_Match( const struct subtitles_dir *p_dir,
+                                 const char *f_fname_trim, bool b_media_dir,
+                                 int i_fuzzy, int *pi_matches,
+                                 struct subtitles_match ***ppp_matches )
+{
+    size_t i_dir_len = strlen( p_dir->psz_dir );
+    if( i_dir_len == 0 )
+        return;
+    const char *psz_sep =
+        p_dir->psz_dir[i_dir_len - 1] == DIR_SEP_CHAR ? "" : DIR_SEP;
+    size_t i_fname_trim_len = strlen( f_fname_trim );
+
+    for( int i = 0; i < p_dir->i_entries; i++ )
+    {
+        const char *psz_name = p_dir->pp_entries[i];
+        const char *tmp_fname_trim = subtitles_entry_trim( psz_name );
+        const char *tmp;
+        int i_prio = 0;
+
+        if( !strcmp( tmp_fname_trim, f_fname_trim ) )
+        {
+            /* matches the movie name exactly */
+            i_prio = SLAVE_PRIORITY_MATCH_ALL;
+        }
+        else if( (tmp = strstr( tmp_fname_trim, f_fname_trim )) )
+        {
+            /* contains the movie name */
+            tmp += i_fname_trim_len;
+            if( whiteonly( tmp ) )
+            {
+                /* chars in front of the movie name */
+                i_prio = SLAVE_PRIORITY_MATCH_RIGHT;
+            }
+            else
+            {
+                /* chars after (and possibly in front of)
+                 * the movie name */
+                i_prio = SLAVE_PRIORITY_MATCH_LEFT;
+            }
+        }
+        else if( b_media_dir )
+        {
+            /* doesn't contain the movie name, prefer files in f_dir over subdirs */
+            i_prio = SLAVE_PRIORITY_MATCH_NONE;
+        }
+        if( i_prio < i_fuzzy )
+            continue;
+
+        struct subtitles_match *p_match =
+            malloc( sizeof( *p_match ) + i_dir_len + strlen( psz_sep )
+                    + strlen( psz_name ) + 1 );
+        if( unlikely(p_match == NULL) )
+            continue;
+        p_match->i_prio = i_prio;
+        sprintf( p_match->psz_path, "%s%s%s", p_dir->psz_dir, psz_sep,
+                 psz_name );
+        TAB_APPEND( *pi_matches, *ppp_matches, p_match );
+    }
+}
+
 /**
  * Detect subtitle files.
  *
@@ -270,95 +451,66 @@ int subtitles_Detect( input_thread_t *p_this, char *psz_path, const char *psz_na
         if( psz_dir == NULL || ( j >= 0 && !strcmp( psz_dir, f_dir ) ) )
             continue;
 
-        /* parse psz_src dir */
-        DIR *dir = vlc_opendir( psz_dir );
-        if( dir == NULL )
+        struct stat st;
+        if( vlc_stat( psz_dir, &st ) || !S_ISDIR( st.st_mode ) )
             continue;
 
-        msg_Dbg( p_this, "looking for a subtitle file in %s", psz_dir );
-
-        const char *psz_name;
-        while( (psz_name = vlc_readdir( dir )) )
+        /* Do not keep listings of directories being modified, as changes
+         * within the same second would go unnoticed */
+        bool b_cache = time( NULL ) - st.st_mtime > 1;
+        int i_matches;
+        struct subtitles_match **pp_matches;
+        TAB_INIT( i_matches, pp_matches );
+
+        vlc_mutex_lock( &subtitles_cache.lock );
+        struct subtitles_dir *p_dir = subtitles_cache_Get( psz_dir,
+                                                           st.st_mtime );
+        if( p_dir == NULL )
         {
-            if( psz_name[0] == '.' || !subtitles_Filter( psz_name ) )
+            vlc_mutex_unlock( &subtitles_cache.lock );
+
+            msg_Dbg( p_this, "looking for a subtitle file in %s", psz_dir );
+            p_dir = subtitles_dir_List( psz_dir, st.st_mtime );
+            if( p_dir == NULL )
                 continue;
 
-            char tmp_fname_noext[strlen( psz_name ) + 1];
-            char tmp_fname_trim[strlen( psz_name ) + 1];
-            char tmp_fname_ext[strlen( psz_name ) + 1];
-            const char *tmp;
-            int i_prio = 0;
+            vlc_mutex_lock( &subtitles_cache.lock );
+            if( b_cache )
+                subtitles_cache_Put( p_dir );
+        }
+        subtitles_dir_Match( p_dir, f_fname_trim, j == -1, i_fuzzy,
+                             &i_matches, &pp_matches );
+        vlc_mutex_unlock( &subtitles_cache.lock );
+        if( !b_cache )
+            subtitles_dir_Delete( p_dir );
 
-            /* retrieve various parts of the filename */
-            strcpy_strip_ext( tmp_fname_noext, psz_name );
-            strcpy_get_ext( tmp_fname_ext, psz_name );
-            strcpy_trim( tmp_fname_trim, tmp_fname_noext );
+        for( int i = 0; i < i_matches; i++ )
+        {
+            struct subtitles_match *p_match = pp_matches[i];
+            const char *path = p_match->psz_path;
 
-            if( !strcmp( tmp_fname_trim, f_fname_trim ) )
-            {
-                /* matches the movie name exactly */
-                i_prio = SLAVE_PRIORITY_MATCH_ALL;
-            }
-            else if( (tmp = strstr( tmp_fname_trim, f_fname_trim )) )
-            {
-                /* contains the movie name */
-                tmp += strlen( f_fname_trim );
-                if( whiteonly( tmp ) )
-                {
-                    /* chars in front of the movie name */
-                    i_prio = SLAVE_PRIORITY_MATCH_RIGHT;
-                }
-                else
-                {
-                    /* chars after (and possibly in front of)
-                     * the movie name */
-                    i_prio = SLAVE_PRIORITY_MATCH_LEFT;
-                }
-            }
-            else if( j == -1 )
-            {
-                /* doesn't contain the movie name, prefer files in f_dir over subdirs */
-                i_prio = SLAVE_PRIORITY_MATCH_NONE;
-            }
-            if( i_prio >= i_fuzzy )
+            if( strcmp( path, psz_fname )
+             && vlc_stat( path, &st ) == 0
+             && S_ISREG( st.st_mode ) )
             {
-                struct stat st;
-                char *path;
-
-                size_t i_len = strlen( psz_dir );
-                const char *psz_format;
-                if ( i_len == 0 )
-                    continue;
-                if( psz_dir[i_len - 1] == DIR_SEP_CHAR )
-                    psz_format = "%s%s";
-                else
-                    psz_format = "%s"DIR_SEP"%s";
-
-                if( asprintf( &path, psz_format, psz_dir, psz_name ) < 0 )
-                    continue;
-
-                if( strcmp( path, psz_fname )
-                 && vlc_stat( path, &st ) == 0
-                 && S_ISREG( st.st_mode ) )
+                msg_Dbg( p_this,
+                        "autodetected subtitle: %s with priority %d",
+                        path, p_match->i_prio );
+                char *psz_uri = vlc_path2uri( path, NULL );
+                input_item_slave_t *p_sub = psz_uri != NULL ?
+                    input_item_slave_New( psz_uri, SLAVE_TYPE_SPU,
+                                          p_match->i_prio )
+                    : NULL;
+                if( p_sub )
                 {
-                    msg_Dbg( p_this,
-                            "autodetected subtitle: %s with priority %d",
-                            path, i_prio );
-                    char *psz_uri = vlc_path2uri( path, NULL );
-                    input_item_slave_t *p_sub = psz_uri != NULL ?
-                        input_item_slave_New( psz_uri, SLAVE_TYPE_SPU, i_prio )
-                        : NULL;
-                    if( p_sub )
-                    {
-                        p_sub->b_forced = true;
-                        TAB_APPEND(i_slaves, pp_slaves, p_sub);
-                    }
-                    free( psz_uri );
+                    p_sub->b_forced = true;
+                    TAB_APPEND(i_slaves, pp_slaves, p_sub);
                 }
-                free( path );
+                free( psz_uri );
             }
+            free( p_match );
         }
-        closedir( dir );
+        TAB_CLEAN( i_matches, pp_matches );
     }
     if( subdirs )
     {
@@ -429,3 +581,91 @@ int subtitles_Detect( input_thread_t *p_this, char *psz_path, const char *psz_na
     *p_slaves = i_slaves;
     return VLC_SUCCESS;
 }
+
+struct subtitles_scan
+{
+    input_thread_t *p_input;
+    char *psz_path;
+    char *psz_uri;
+    vlc_thread_t thread;
+
+    int i_ret;
+    int i_slaves;
+    input_item_slave_t **pp_slaves;
+};
+
+static void *subtitles_ScanThread( void *data )
+{
+    struct subtitles_scan *p_scan = data;
+
+    p_scan->i_ret = subtitles_Detect( p_scan->p_input, p_scan->psz_path,
+                                      p_scan->psz_uri, &p_scan->pp_slaves,
+                                      &p_scan->i_slaves );
+    return NULL;
+}
+
+/**
+ * Starts subtitles_Detect() on a thread of its own, so that the directories
+ * are listed while the media is being opened.
+ *
+ * \return the scan to pass to subtitles_DetectWait(), or NULL on error
+ */
+struct subtitles_scan *subtitles_DetectAsync( input_thread_t *p_input,
+                                              const char *psz_path,
+                                              const char *psz_name_org )
+{
+    if( psz_name_org == NULL )
+        return NULL;
+
+    struct subtitles_scan *p_scan = malloc( sizeof( *p_scan ) );
+    if( unlikely(p_scan == NULL) )
+        return NULL;
+
+    p_scan->p_input = p_input;
+    p_scan->psz_path = psz_path != NULL ? strdup( psz_path ) : NULL;
+    p_scan->psz_uri = strdup( psz_name_org );
+    p_scan->i_ret = VLC_EGENERIC;
+    TAB_INIT( p_scan->i_slaves, p_scan->pp_slaves );
+
+    if( unlikely(p_scan->psz_uri == NULL
+              || (psz_path != NULL && p_scan->psz_path == NULL))
+     || vlc_clone( &p_scan->thread, subtitles_ScanThread, p_scan,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        free( p_scan->psz_uri );
+        free( p_scan->psz_path );
+        free( p_scan );
+        return NULL;
+    }
+    return p_scan;
+}
+
+/**
+ * Waits for the end of a scan started by subtitles_DetectAsync(), and
+ * appends the detected subtitles to the given slave list.
+ *
+ * \param ppp_slaves the slave list, or NULL to discard the subtitles
+ * \return the subtitles_Detect() result
+ */
+int subtitles_DetectWait( struct subtitles_scan *p_scan,
+                          input_item_slave_t ***ppp_slaves, int *p_slaves )
+{
+    vlc_join( p_scan->thread, NULL );
+
+    int i_ret = p_scan->i_ret;
+    for( int i = 0; i < p_scan->i_slaves; i++ )
+    {
+        input_item_slave_t *p_sub = p_scan->pp_slaves[i];
+        if( p_sub == NULL ) /* rejected */
+            continue;
+        if( ppp_slaves != NULL )
+            TAB_APPEND( *p_slaves, *ppp_slaves, p_sub );
+        else
+            input_item_slave_Delete( p_sub );
+    }
+    TAB_CLEAN( p_scan->i_slaves, p_scan->pp_slaves );
+    free( p_scan->psz_uri );
+    free( p_scan->psz_path );
+    free( p_scan );
+    return i_ret;
+}
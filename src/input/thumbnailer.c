@@ -47,6 +47,10 @@ typedef struct vlc_thumbnailer_params_t
         VLC_THUMBNAILER_SEEK_POS,
     } type;
     bool fast_seek;
+    bool keyframes_only;
+    /* times of a batch request, NULL for single requests */
+    vlc_tick_t *batch;
+    size_t batch_count;
     input_item_t* input_item;
     /**
      * A positive value will be used as the timeout duration
@@ -54,6 +58,7 @@ typedef struct vlc_thumbnailer_params_t
      */
     vlc_tick_t timeout;
     vlc_thumbnailer_cb cb;
+    vlc_thumbnailer_batch_cb batch_cb;
     void* user_data;
 } vlc_thumbnailer_params_t;
 
@@ -66,8 +71,61 @@ struct vlc_thumbnailer_request_t
 
     vlc_mutex_t lock;
     bool done;
+    /* next batch time to report */
+    size_t batch_index;
 };
 
+/* Must be called with the request lock held */
+static void thumbnailer_request_Abort( vlc_thumbnailer_request_t *request )
+{
+    if ( request->params.batch != NULL )
+    {
+        if ( request->params.batch_cb != NULL )
+            for ( ; request->batch_index < request->params.batch_count;
+                  request->batch_index++ )
+                request->params.batch_cb( request->params.user_data,
+                                          request->batch_index, NULL );
+        request->params.batch_cb = NULL;
+    }
+    else if ( request->params.cb != NULL )
+    {
+        request->params.cb( request->params.user_data, NULL );
+        request->params.cb = NULL;
+    }
+}
+
+/* Must be called with the request lock held, returns true if more
+ * thumbnails are expected from the same input */
+static bool thumbnailer_request_Report( vlc_thumbnailer_request_t *request,
+                                        picture_t *pic )
+{
+    if ( request->params.batch == NULL )
+    {
+        /*
+         * If the request has not been cancelled, we can invoke the completion
+         * callback.
+         */
+        if ( request->params.cb )
+        {
+            request->params.cb( request->params.user_data, pic );
+            request->params.cb = NULL;
+        }
+        return false;
+    }
+
+    if ( request->params.batch_cb == NULL )
+        return false;
+    request->params.batch_cb( request->params.user_data,
+                              request->batch_index++, pic );
+    if ( request->batch_index == request->params.batch_count )
+        return false;
+    /* The decoder is re-armed by the flush of the seek */
+    input_SetTime( request->input_thread,
+                   request->params.batch[request->batch_index],
+                   request->params.fast_seek );
+    return true;
+}
+
 static void
 on_thumbnailer_input_event( input_thread_t *input,
                             const struct vlc_input_event *event, void *userdata )
@@ -79,28 +137,24 @@ on_thumbnailer_input_event( input_thread_t *input,
          return;
 
     vlc_thumbnailer_request_t* request = userdata;
-    picture_t *pic = NULL;
 
+    vlc_mutex_lock( &request->lock );
     if ( event->type == INPUT_EVENT_THUMBNAIL_READY )
     {
+        if ( thumbnailer_request_Report( request, event->thumbnail ) )
+        {
+            vlc_mutex_unlock( &request->lock );
+            return;
+        }
         /*
          * Stop the input thread ASAP, delegate its release to
          * thumbnailer_request_Release
          */
         input_Stop( request->input_thread );
-        pic = event->thumbnail;
     }
-    vlc_mutex_lock( &request->lock );
+    else
+        thumbnailer_request_Abort( request );
     request->done = true;
-    /*
-     * If the request has not been cancelled, we can invoke the completion
-     * callback.
-     */
-    if ( request->params.cb )
-    {
-        request->params.cb( request->params.user_data, pic );
-        request->params.cb = NULL;
-    }
     vlc_mutex_unlock( &request->lock );
     background_worker_RequestProbe( request->thumbnailer->worker );
 }
@@ -117,6 +171,7 @@ static void thumbnailer_request_Release( void* data )
         input_Close( request->input_thread );
 
     input_item_Release( request->params.input_item );
+    free( request->params.batch );
     free( request );
 }
 
@@ -129,9 +184,12 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                                      on_thumbnailer_input_event, request,
                                      request->params.input_item );
     if ( unlikely( input == NULL ) )
+        goto error;
+    if ( request->params.keyframes_only )
     {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
+        /* read by the video decoder, skips the non key pictures */
+        var_Create( input, "thumbnail-keyframes", VLC_VAR_BOOL );
+        var_SetBool( input, "thumbnail-keyframes", true );
     }
     if ( request->params.type == VLC_THUMBNAILER_SEEK_TIME )
     {
@@ -145,12 +203,15 @@ static int thumbnailer_request_Start( void* owner, void* entity, void** out )
                        request->params.fast_seek );
     }
     if ( input_Start( input ) != VLC_SUCCESS )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        return VLC_EGENERIC;
-    }
+        goto error;
     *out = request;
     return VLC_SUCCESS;
+
+error:
+    vlc_mutex_lock( &request->lock );
+    thumbnailer_request_Abort( request );
+    vlc_mutex_unlock( &request->lock );
+    return VLC_EGENERIC;
 }
 
 static void thumbnailer_request_Stop( void* owner, void* handle )
@@ -163,11 +224,7 @@ static void thumbnailer_request_Stop( void* owner, void* handle )
      * If the callback hasn't been invoked yet, we assume a timeout and
      * signal it back to the user
      */
-    if ( request->params.cb != NULL )
-    {
-        request->params.cb( request->params.user_data, NULL );
-        request->params.cb = NULL;
-    }
+    thumbnailer_request_Abort( request );
     vlc_mutex_unlock( &request->lock );
     assert( request->input_thread != NULL );
     input_Stop( request->input_thread );
@@ -189,11 +246,15 @@ thumbnailer_RequestCommon( vlc_thumbnailer_t* thumbnailer,
 {
     vlc_thumbnailer_request_t *request = malloc( sizeof( *request ) );
     if ( unlikely( request == NULL ) )
+    {
+        free( params->batch );
         return NULL;
+    }
     request->thumbnailer = thumbnailer;
     request->input_thread = NULL;
     request->params = *(vlc_thumbnailer_params_t*)params;
     request->done = false;
+    request->batch_index = 0;
     input_item_Hold( request->params.input_item );
     vlc_mutex_init( &request->lock );
 
@@ -219,7 +280,8 @@ vlc_thumbnailer_RequestByTime( vlc_thumbnailer_t *thumbnailer,
             &(const vlc_thumbnailer_params_t){
                 .time = time,
                 .type = VLC_THUMBNAILER_SEEK_TIME,
-                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframes_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
                 .input_item = input_item,
                 .timeout = timeout,
                 .cb = cb,
@@ -237,7 +299,8 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
             &(const vlc_thumbnailer_params_t){
                 .pos = pos,
                 .type = VLC_THUMBNAILER_SEEK_POS,
-                .fast_seek = speed == VLC_THUMBNAILER_SEEK_FAST,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframes_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
                 .input_item = input_item,
                 .timeout = timeout,
                 .cb = cb,
@@ -245,12 +308,43 @@ vlc_thumbnailer_RequestByPos( vlc_thumbnailer_t *thumbnailer,
         });
 }
 
+vlc_thumbnailer_request_t*
+vlc_thumbnailer_RequestBatch( vlc_thumbnailer_t *thumbnailer,
+                              const vlc_tick_t *times, size_t count,
+                              enum vlc_thumbnailer_seek_speed speed,
+                              input_item_t *input_item, vlc_tick_t timeout,
+                              vlc_thumbnailer_batch_cb cb, void* user_data )
+{
+    assert( count > 0 );
+    vlc_tick_t *batch = vlc_alloc( count, sizeof( *batch ) );
+    if ( unlikely( batch == NULL ) )
+        return NULL;
+    memcpy( batch, times, count * sizeof( *batch ) );
+
+    vlc_thumbnailer_request_t *request = thumbnailer_RequestCommon( thumbnailer,
+            &(const vlc_thumbnailer_params_t){
+                .time = batch[0],
+                .type = VLC_THUMBNAILER_SEEK_TIME,
+                .fast_seek = speed != VLC_THUMBNAILER_SEEK_PRECISE,
+                .keyframes_only = speed == VLC_THUMBNAILER_SEEK_KEYFRAME,
+                .batch = batch,
+                .batch_count = count,
+                .input_item = input_item,
+                .timeout = timeout,
+                .batch_cb = cb,
+                .user_data = user_data,
+        });
+    /* on failure, the batch was released with the request */
+    return request;
+}
+
 void vlc_thumbnailer_Cancel( vlc_thumbnailer_t* thumbnailer,
                              vlc_thumbnailer_request_t* req )
 {
     vlc_mutex_lock( &req->lock );
     /* Ensure we won't invoke the callback if the input was running. */
     req->params.cb = NULL;
+    req->params.batch_cb = NULL;
     vlc_mutex_unlock( &req->lock );
     background_worker_Cancel( thumbnailer->worker, req );
 }
@@ -263,7 +357,7 @@ vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t* parent)
     thumbnailer->parent = parent;
     struct background_worker_config cfg = {
         .default_timeout = -1,
-        .max_threads = 1,
+        .max_threads = var_InheritInteger( parent, "thumbnail-threads" ),
         .pf_release = thumbnailer_request_Release,
         .pf_hold = thumbnailer_request_Hold,
         .pf_start = thumbnailer_request_Start,
@@ -89,6 +89,24 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Pass the messages to the logger from a dedicated thread, so that " \
+    "slow logging does not stall playback. Messages may be dropped if " \
+    "they are emitted faster than they can be logged.")
+
+#define TRACER_TEXT N_("Tracer module")
+#define TRACER_LONGTEXT N_( \
+    "This is the module recording the timings of the playback pipeline. " \
+    "Tracing is disabled if none is selected.")
+
+#define MEM_STATS_TEXT N_("Memory usage report period (seconds)")
+#define MEM_STATS_LONGTEXT N_( \
+    "Account the memory held by the blocks, the pictures and the object " \
+    "queues, and log the current and peak usage with this period. " \
+    "The heap allocations are also counted per pipeline stage, and " \
+    "reported in the input statistics. 0 disables the accounting.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -556,6 +574,26 @@ static const char *const ppsz_clock_master_descriptions[] = {
     N_("Monotonic")
 };
 
+#define CLOCK_GROUP_TEXT N_("Clock group")
+#define CLOCK_GROUP_LONGTEXT N_( \
+    "Inputs of the same clock group share a time base: the outputs of all " \
+    "of them are synchronized on the master output of the first one to " \
+    "play. Use this to play several views of one event in sync." )
+
+#define CLOCK_GROUP_ALIGN_TEXT N_("Clock group alignment")
+#define CLOCK_GROUP_ALIGN_LONGTEXT N_( \
+    "This defines how the timestamps of an input are aligned with the ones " \
+    "of the input leading its clock group." )
+
+static const int pi_clock_group_align_values[] = {
+    VLC_CLOCK_GROUP_ALIGN_TIMESTAMPS,
+    VLC_CLOCK_GROUP_ALIGN_START,
+};
+static const char *const ppsz_clock_group_align_descriptions[] = {
+    N_("Same timestamps"),
+    N_("Start together")
+};
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -724,12 +762,13 @@ static const char *const ppsz_prefres[] = {
 
 #define INPUT_TIMESHIFT_PATH_TEXT N_("Timeshift directory")
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
-    "Directory used to store the timeshift temporary files." )
+    "Directory used to store the timeshift temporary file. " \
+    "If not set, the timeshifted streams are kept in memory." )
 
-#define INPUT_TIMESHIFT_GRANULARITY_TEXT N_("Timeshift granularity")
-#define INPUT_TIMESHIFT_GRANULARITY_LONGTEXT N_( \
-    "This is the maximum size in bytes of the temporary files " \
-    "that will be used to store the timeshifted streams." )
+#define INPUT_TIMESHIFT_SIZE_TEXT N_("Timeshift size (MiB)")
+#define INPUT_TIMESHIFT_SIZE_LONGTEXT N_( \
+    "This is the size of the storage for the timeshifted streams. " \
+    "When it is full, the oldest data is dropped." )
 
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
@@ -862,6 +901,12 @@ static const char *const ppsz_prefres[] = {
 #define TIMEOUT_LONGTEXT N_( \
     "Default TCP connection timeout (in milliseconds)." )
 
+#define DNS_CACHE_TTL_TEXT N_("DNS cache duration")
+#define DNS_CACHE_TTL_LONGTEXT N_( \
+    "Duration (in seconds) for which resolved host names are kept, so that " \
+    "reopening media from the same servers does not wait for the DNS. " \
+    "0 disables the cache." )
+
 #define HTTP_HOST_TEXT N_( "HTTP server address" )
 #define HOST_LONGTEXT N_( \
     "By default, the server will listen on any local IP address. " \
@@ -979,6 +1024,12 @@ static const char *const ppsz_prefres[] = {
     "VLC will fallback automatically to software decoders in case of " \
     "hardware decoder failure." )
 
+#define DEC_OUTPUT_QUEUE_TEXT N_("Decoder output queue")
+#define DEC_OUTPUT_QUEUE_LONGTEXT N_( \
+    "Number of decoded pictures or audio buffers that can be handed over " \
+    "to a separate output thread, so that decoding continues while the " \
+    "output is busy. 0 outputs from the decoder thread." )
+
 #define ENCODER_TEXT N_("Preferred encoders list")
 #define ENCODER_LONGTEXT N_( \
     "This allows you to select a list of encoders that VLC will use in " \
@@ -987,6 +1038,13 @@ static const char *const ppsz_prefres[] = {
 #define DEC_DEV_TEXT N_("Preferred decoder hardware device")
 #define DEC_DEV_LONGTEXT N_("This allows hardware decoding when available.")
 
+#define DEC_DEV_SHARED_TEXT N_("Share decoder devices")
+#define DEC_DEV_SHARED_LONGTEXT N_( \
+    "Share a single hardware decoder device between all the video outputs " \
+    "of the instance that use the same display server, instead of opening " \
+    "one device per video output. This saves GPU memory when many players " \
+    "run concurrently.")
+
 /*****************************************************************************
  * Sout
  ****************************************************************************/
@@ -1089,6 +1147,11 @@ static const char *const ppsz_prefres[] = {
     "the correct demuxer is not automatically detected. You should not "\
     "set this as a global option unless you really know what you are doing." )
 
+#define DEMUX_PROBE_CACHE_TEXT N_("Remember the demuxers")
+#define DEMUX_PROBE_CACHE_LONGTEXT N_( \
+    "Probe first the demultiplexer that opened the last stream with the " \
+    "same extension, type and first bytes." )
+
 #define VOD_SERVER_TEXT N_("VoD server module")
 #define VOD_SERVER_LONGTEXT N_( \
     "You can select which VoD server module you want to use. Set this " \
@@ -1194,10 +1257,24 @@ static const char *const clock_sources_text[] = {
 #define PREPARSE_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to preparse items" )
 
+#define PREPARSE_CACHE_TEXT N_( "Cache preparsing results" )
+#define PREPARSE_CACHE_LONGTEXT N_( \
+    "Store the meta data and tracks found when preparsing local files, " \
+    "and reuse them as long as the files are not modified" )
+
+#define THUMBNAIL_THREADS_TEXT N_( "Thumbnailing threads" )
+#define THUMBNAIL_THREADS_LONGTEXT N_( \
+    "Maximum number of threads used to generate thumbnails" )
+
 #define FETCH_ART_THREADS_TEXT N_( "Fetch-art threads" )
 #define FETCH_ART_THREADS_LONGTEXT N_( \
     "Maximum number of threads used to fetch art" )
 
+#define ART_CACHE_SIZE_TEXT N_( "Art cache size (MiB)" )
+#define ART_CACHE_SIZE_LONGTEXT N_( \
+    "Maximum size of the album art cache on disk. The least recently used " \
+    "art is removed once it is exceeded. 0 means no limit." )
+
 #define METADATA_NETWORK_TEXT N_( "Allow metadata network access" )
 
 static const char *const psz_recursive_list[] = {
@@ -1256,6 +1333,12 @@ static const char *const psz_recursive_list_text[] = {
 #define SP_LONGTEXT N_( \
     "Pause each item in the playlist on the first frame." )
 
+#define PRELOAD_TEXT N_("Preload the next item")
+#define PRELOAD_LONGTEXT N_( \
+    "Open the next item of the playlist this many milliseconds before " \
+    "the end of the current one, to reduce the gap between them " \
+    "(0 to disable)." )
+
 #define AUTOSTART_TEXT N_( "Auto start" )
 #define AUTOSTART_LONGTEXT N_( "Automatically start playing the playlist " \
                 "content once it's loaded." )
@@ -1893,6 +1976,9 @@ vlc_module_begin ()
     add_integer( "ipv4-timeout", 5 * 1000, TIMEOUT_TEXT,
                  TIMEOUT_LONGTEXT, true )
         change_integer_range( 0, INT_MAX )
+    add_integer( "dns-cache-ttl", 60, DNS_CACHE_TTL_TEXT,
+                 DNS_CACHE_TTL_LONGTEXT, true )
+        change_integer_range( 0, 86400 )
 
     add_string( "http-host", NULL, HTTP_HOST_TEXT, HOST_LONGTEXT, true )
     add_integer( "http-port", 8080, HTTP_PORT_TEXT, HTTP_PORT_LONGTEXT, true )
@@ -2015,6 +2101,14 @@ vlc_module_begin ()
     add_integer( "clock-master", VLC_CLOCK_MASTER_DEFAULT,
                  CLOCK_MASTER_TEXT, NULL, true )
         change_integer_list( pi_clock_master_values, ppsz_clock_master_descriptions )
+    add_string( "clock-group", NULL, CLOCK_GROUP_TEXT,
+                CLOCK_GROUP_LONGTEXT, true )
+        change_safe()
+    add_integer( "clock-group-align", VLC_CLOCK_GROUP_ALIGN_START,
+                 CLOCK_GROUP_ALIGN_TEXT, CLOCK_GROUP_ALIGN_LONGTEXT, true )
+        change_integer_list( pi_clock_group_align_values,
+                             ppsz_clock_group_align_descriptions )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -2026,8 +2120,10 @@ vlc_module_begin ()
 
     add_directory("input-timeshift-path", NULL,
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
-    add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
-                 INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-size", 256, INPUT_TIMESHIFT_SIZE_TEXT,
+                 INPUT_TIMESHIFT_SIZE_LONGTEXT, true )
+        change_integer_range( 1, 4096 )
+    add_obsolete_integer( "input-timeshift-granularity" ) /* since 4.0.0 */
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
@@ -2039,9 +2135,14 @@ vlc_module_begin ()
     add_string( "codec", NULL, CODEC_TEXT,
                 CODEC_LONGTEXT, true )
     add_bool( "hw-dec", true, HW_DEC_TEXT, HW_DEC_LONGTEXT, true )
+    add_integer( "dec-output-queue", 0, DEC_OUTPUT_QUEUE_TEXT,
+                 DEC_OUTPUT_QUEUE_LONGTEXT, true )
+        change_integer_range( 0, 16 )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
     add_module("dec-dev", "decoder device", "any", DEC_DEV_TEXT, DEC_DEV_LONGTEXT)
+    add_bool( "dec-dev-shared", false, DEC_DEV_SHARED_TEXT,
+              DEC_DEV_SHARED_LONGTEXT, true )
 
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_category_hint(N_("Input"), INPUT_CAT_LONGTEXT)
@@ -2049,6 +2150,8 @@ vlc_module_begin ()
 
     set_subcategory( SUBCAT_INPUT_DEMUX )
     add_module("demux", "demux", "any", DEMUX_TEXT, DEMUX_LONGTEXT)
+    add_bool( "demux-probe-cache", true, DEMUX_PROBE_CACHE_TEXT,
+              DEMUX_PROBE_CACHE_LONGTEXT, true )
     set_subcategory( SUBCAT_INPUT_ACODEC )
     set_subcategory( SUBCAT_INPUT_SCODEC )
     add_obsolete_bool( "prefer-system-codecs" )
@@ -2183,6 +2286,9 @@ vlc_module_begin ()
     add_bool( "play-and-pause", 0, PAP_TEXT, PAP_LONGTEXT, true )
         change_safe()
     add_bool( "start-paused", 0, SP_TEXT, SP_LONGTEXT, false )
+    add_integer( "playlist-preload", 0, PRELOAD_TEXT, PRELOAD_LONGTEXT,
+                 true )
+        change_integer_range( 0, 60000 )
     add_bool( "playlist-autostart", true,
               AUTOSTART_TEXT, AUTOSTART_LONGTEXT, false )
     add_bool( "playlist-cork", true, CORK_TEXT, CORK_LONGTEXT, false )
@@ -2215,8 +2321,18 @@ vlc_module_begin ()
     add_integer( "preparse-threads", 1, PREPARSE_THREADS_TEXT,
                  PREPARSE_THREADS_LONGTEXT, false )
 
+    add_bool( "preparse-cache", false, PREPARSE_CACHE_TEXT,
+              PREPARSE_CACHE_LONGTEXT, false )
+
+    add_integer( "thumbnail-threads", 1, THUMBNAIL_THREADS_TEXT,
+                 THUMBNAIL_THREADS_LONGTEXT, false )
+        change_integer_range( 1, 32 )
+
     add_integer( "fetch-art-threads", 1, FETCH_ART_THREADS_TEXT,
                  FETCH_ART_THREADS_LONGTEXT, false )
+    add_integer( "art-cache-size", 0, ART_CACHE_SIZE_TEXT,
+                 ART_CACHE_SIZE_LONGTEXT, true )
+        change_integer_range( 0, 1048576 )
 
     add_obsolete_integer( "album-art" )
     add_bool( "metadata-network-access", false, METADATA_NETWORK_TEXT,
@@ -2246,6 +2362,10 @@ vlc_module_begin ()
                  false )
         change_short('v')
         change_volatile ()
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
+    add_module( "tracer", "tracer", NULL, TRACER_TEXT, TRACER_LONGTEXT )
+    add_integer( "mem-stats", 0, MEM_STATS_TEXT, MEM_STATS_LONGTEXT, true )
+        change_integer_range( 0, 86400 )
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
 #if !defined(_WIN32) && !defined(__OS2__)
     add_obsolete_bool( "daemon" ) /* since 4.0.0 */
@@ -41,6 +41,7 @@
 #include "modules/modules.h"
 #include "config/configuration.h"
 #include "preparser/preparser.h"
+#include "preparser/art.h"
 #include "media_source/media_source.h"
 
 #include <stdio.h>                                              /* sprintf() */
@@ -63,6 +64,7 @@
 #include <vlc_modules.h>
 #include <vlc_media_library.h>
 #include <vlc_thumbnailer.h>
+#include <vlc_executor.h>
 
 #include "libvlc.h"
 
@@ -95,6 +97,10 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv->main_playlist = NULL;
     priv->p_vlm = NULL;
     priv->media_source_provider = NULL;
+    priv->art_cache = NULL;
+    priv->executor = NULL;
+    priv->tracer = NULL;
+    priv->mem_stats_enabled = false;
 
     vlc_ExitInit( &priv->exit );
 
@@ -179,6 +185,8 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
         goto error;
 
     vlc_LogInit(p_libvlc);
+    priv->tracer = vlc_tracer_Create(VLC_OBJECT(p_libvlc));
+    vlc_mem_stats_Init(p_libvlc);
 
     /*
      * Support for gettext
@@ -222,9 +230,14 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
     if( libvlc_InternalActionsInit( p_libvlc ) != VLC_SUCCESS )
         goto error;
 
+    priv->executor = vlc_executor_New(vlc_GetCPUCount());
+    if (priv->executor == NULL)
+        goto error;
+
     /*
      * Meta data handling
      */
+    priv->art_cache = vlc_art_cache_New(VLC_OBJECT(p_libvlc));
     priv->parser = input_preparser_New(VLC_OBJECT(p_libvlc));
     if( !priv->parser )
         goto error;
@@ -385,12 +398,22 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if ( priv->p_media_library )
         libvlc_MlRelease( priv->p_media_library );
 
+    if (priv->art_cache != NULL)
+        vlc_art_cache_Delete(priv->art_cache);
+
+    if (priv->executor != NULL)
+        vlc_executor_Delete(priv->executor);
+
     libvlc_InternalActionsClean( p_libvlc );
 
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
         config_AutoSaveConfigFile( VLC_OBJECT(p_libvlc) );
 
+    vlc_mem_stats_Deinit(p_libvlc);
+    vlc_block_cache_Purge(VLC_OBJECT(p_libvlc));
+    if (priv->tracer != NULL)
+        vlc_tracer_Destroy(priv->tracer);
     vlc_LogDestroy(p_libvlc->obj.logger);
     /* Free module bank. It is refcounted, so we call this each time  */
     module_EndBank (true);
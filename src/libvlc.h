@@ -40,6 +40,15 @@ void system_End(void);
 #endif
 void vlc_CPU_dump(vlc_object_t *);
 
+/*
+ * Blocks
+ */
+
+/**
+ * Prints the block cache statistics and returns cached blocks to the heap.
+ */
+void vlc_block_cache_Purge(vlc_object_t *);
+
 /*
  * Threads subsystem
  */
@@ -62,6 +71,29 @@ typedef struct vlc_logger vlc_logger_t;
 int vlc_LogPreinit(libvlc_int_t *) VLC_USED;
 void vlc_LogInit(libvlc_int_t *);
 
+/*
+ * Tracing
+ */
+struct vlc_tracer *vlc_tracer_Create(vlc_object_t *parent);
+void vlc_tracer_Destroy(struct vlc_tracer *);
+
+/*
+ * Memory accounting
+ */
+enum vlc_mem_core_account
+{
+    VLC_MEM_BLOCKS,
+    VLC_MEM_PICTURES,
+};
+#define VLC_MEM_CORE_COUNT (VLC_MEM_PICTURES + 1)
+
+/** Returns a core memory account, or NULL if the accounting is disabled */
+struct vlc_mem_account *vlc_mem_GetCoreAccount(enum vlc_mem_core_account);
+/** Counts an allocation in the pipeline stage of the calling thread */
+void vlc_mem_CountAllocation(void);
+int vlc_mem_stats_Init(libvlc_int_t *);
+void vlc_mem_stats_Deinit(libvlc_int_t *);
+
 /*
  * LibVLC exit event handling
  */
@@ -190,6 +222,11 @@ typedef struct libvlc_priv_t
     intf_thread_t *interfaces;  ///< Linked-list of interfaces
     vlc_playlist_t *main_playlist;
     struct input_preparser_t *parser; ///< Input item meta data handler
+    struct vlc_art_cache *art_cache; ///< Album art cache index
+    struct vlc_executor *executor; ///< Worker threads shared by the modules
+    struct vlc_tracer *tracer; ///< Timing tracer (or NULL)
+    bool mem_stats_enabled; ///< Periodic memory usage report
+    vlc_timer_t mem_stats_timer;
     vlc_media_source_provider_t *media_source_provider;
     vlc_actions_t *actions; ///< Hotkeys handler
     struct vlc_medialibrary_t *p_media_library; ///< Media library instance
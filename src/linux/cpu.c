@@ -54,6 +54,9 @@ unsigned vlc_CPU_raw(void)
     {
         char *p = line, *cap;
         uint_fast32_t core_caps = 0;
+#if defined (__i386__) || defined (__x86_64__)
+        unsigned avx512 = 0;
+#endif
 
 #if defined (__arm__)
         unsigned ver;
@@ -71,6 +74,8 @@ unsigned vlc_CPU_raw(void)
 # if defined (__aarch64__)
             if (!strcmp (cap, "sve"))
                 core_caps |= VLC_CPU_ARM_SVE;
+            if (!strcmp (cap, "sve2"))
+                core_caps |= VLC_CPU_ARM_SVE2;
 # endif
 
 #elif defined (__i386__) || defined (__x86_64__)
@@ -102,12 +107,29 @@ unsigned vlc_CPU_raw(void)
                 core_caps |= VLC_CPU_XOP;
             if (!strcmp (cap, "fma4"))
                 core_caps |= VLC_CPU_FMA4;
+            if (!strcmp (cap, "avx_vnni"))
+                core_caps |= VLC_CPU_AVX_VNNI;
+            /* VLC_CPU_AVX512 requires all of the x86-64-v4 subset */
+            if (!strcmp (cap, "avx512f"))
+                avx512 |= 0x01;
+            if (!strcmp (cap, "avx512cd"))
+                avx512 |= 0x02;
+            if (!strcmp (cap, "avx512bw"))
+                avx512 |= 0x04;
+            if (!strcmp (cap, "avx512dq"))
+                avx512 |= 0x08;
+            if (!strcmp (cap, "avx512vl"))
+                avx512 |= 0x10;
 
 #elif defined (__powerpc__) || defined (__powerpc64__)
             if (!strcmp (cap, "altivec supported"))
                 core_caps |= VLC_CPU_ALTIVEC;
 #endif
         }
+#if defined (__i386__) || defined (__x86_64__)
+        if (avx512 == 0x1f)
+            core_caps |= VLC_CPU_AVX512;
+#endif
 
         /* Take the intersection of capabilities of each processor */
         all_caps &= core_caps;
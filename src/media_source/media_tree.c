@@ -65,6 +65,7 @@ vlc_media_tree_New(void)
     input_item_node_t *root = &tree->root;
     root->p_item = NULL;
     TAB_INIT(root->i_children, root->pp_children);
+    root->b_partial = false;
 
     return tree;
 }
@@ -162,9 +163,23 @@ media_subtree_changed(input_item_t *media, input_item_node_t *node,
         return;
     }
 
-    vlc_media_tree_ClearChildren(subtree_root);
-    vlc_media_tree_AddSubtree(subtree_root, node);
-    vlc_media_tree_Notify(tree, on_children_reset, subtree_root);
+    if (subtree_root->b_partial)
+    {
+        /* continuation of the previous part, append the new children */
+        int count = subtree_root->i_children;
+        vlc_media_tree_AddSubtree(subtree_root, node);
+        if (subtree_root->i_children > count)
+            vlc_media_tree_Notify(tree, on_children_added, subtree_root,
+                                  &subtree_root->pp_children[count],
+                                  (size_t) (subtree_root->i_children - count));
+    }
+    else
+    {
+        vlc_media_tree_ClearChildren(subtree_root);
+        vlc_media_tree_AddSubtree(subtree_root, node);
+        vlc_media_tree_Notify(tree, on_children_reset, subtree_root);
+    }
+    subtree_root->b_partial = node->b_partial;
     vlc_media_tree_Unlock(tree);
 }
 
@@ -0,0 +1,185 @@
+/*****************************************************************************
+ * arena.c: arena memory allocator
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_arena.h>
+
+#define ARENA_ALIGN        alignof (max_align_t)
+#define ARENA_CHUNK_SIZE   4096
+
+struct vlc_arena_chunk
+{
+    struct vlc_arena_chunk *next;
+    size_t size; /* usable bytes */
+    size_t used;
+    max_align_t data[];
+};
+
+static unsigned char *vlc_arena_ChunkData(struct vlc_arena_chunk *chunk)
+{
+    return (unsigned char *)chunk->data;
+}
+
+void vlc_arena_Init(vlc_arena_t *arena, size_t chunk_size)
+{
+    arena->chunks = NULL;
+    arena->chunk_size = (chunk_size > 0) ? chunk_size : ARENA_CHUNK_SIZE;
+}
+
+void vlc_arena_Clean(vlc_arena_t *arena)
+{
+    struct vlc_arena_chunk *chunk = arena->chunks;
+
+    while (chunk != NULL)
+    {
+        struct vlc_arena_chunk *next = chunk->next;
+
+        free(chunk);
+        chunk = next;
+    }
+    arena->chunks = NULL;
+}
+
+static struct vlc_arena_chunk *vlc_arena_NewChunk(size_t size)
+{
+    struct vlc_arena_chunk *chunk;
+    size_t total;
+
+    if (add_overflow(sizeof (*chunk), size, &total))
+        return NULL;
+
+    chunk = malloc(total);
+    if (unlikely(chunk == NULL))
+        return NULL;
+
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void *vlc_arena_Alloc(vlc_arena_t *arena, size_t size)
+{
+    struct vlc_arena_chunk *chunk = arena->chunks;
+
+    if (add_overflow(size, ARENA_ALIGN - 1, &size))
+        return NULL;
+    size &= ~(ARENA_ALIGN - 1);
+
+    if (chunk != NULL && chunk->size - chunk->used >= size)
+    {
+        void *ptr = vlc_arena_ChunkData(chunk) + chunk->used;
+
+        chunk->used += size;
+        return ptr;
+    }
+
+    if (size > arena->chunk_size / 4)
+    {
+        /* Large allocation: dedicated chunk, behind the current one so that
+         * the latter remains available for small allocations. */
+        struct vlc_arena_chunk *large = vlc_arena_NewChunk(size);
+        if (unlikely(large == NULL))
+            return NULL;
+
+        large->used = size;
+        if (chunk != NULL)
+        {
+            large->next = chunk->next;
+            chunk->next = large;
+        }
+        else
+            arena->chunks = large;
+        return vlc_arena_ChunkData(large);
+    }
+
+    chunk = vlc_arena_NewChunk(arena->chunk_size);
+    if (unlikely(chunk == NULL))
+        return NULL;
+
+    chunk->next = arena->chunks;
+    chunk->used = size;
+    arena->chunks = chunk;
+    return vlc_arena_ChunkData(chunk);
+}
+
+void *vlc_arena_Calloc(vlc_arena_t *arena, size_t count, size_t size)
+{
+    size_t total;
+
+    if (mul_overflow(count, size, &total))
+        return NULL;
+
+    void *ptr = vlc_arena_Alloc(arena, total);
+    if (likely(ptr != NULL))
+        memset(ptr, 0, total);
+    return ptr;
+}
+
+void *vlc_arena_Realloc(vlc_arena_t *arena, void *ptr, size_t old_size,
+                        size_t size)
+{
+    if (ptr == NULL)
+        return vlc_arena_Alloc(arena, size);
+    if (size <= old_size)
+        return ptr;
+
+    struct vlc_arena_chunk *chunk = arena->chunks;
+    size_t old_aligned = (old_size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    size_t aligned;
+
+    /* Grow the last allocation of the current chunk in place */
+    if (chunk != NULL && old_aligned <= chunk->used
+     && vlc_arena_ChunkData(chunk) + chunk->used - old_aligned == ptr
+     && !add_overflow(size, ARENA_ALIGN - 1, &aligned))
+    {
+        aligned &= ~(ARENA_ALIGN - 1);
+        if (aligned - old_aligned <= chunk->size - chunk->used)
+        {
+            chunk->used += aligned - old_aligned;
+            return ptr;
+        }
+    }
+
+    void *copy = vlc_arena_Alloc(arena, size);
+    if (likely(copy != NULL))
+        memcpy(copy, ptr, old_size);
+    return copy;
+}
+
+char *vlc_arena_Strdup(vlc_arena_t *arena, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *copy = vlc_arena_Alloc(arena, len);
+
+    if (likely(copy != NULL))
+        memcpy(copy, str, len);
+    return copy;
+}
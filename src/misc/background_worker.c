@@ -57,6 +57,7 @@ struct background_worker {
     struct vlc_list threads; /**< list of active background_thread instances */
 
     struct vlc_list queue; /**< queue of tasks */
+    struct vlc_list queue_high; /**< queue of tasks taken first */
     vlc_cond_t queue_wait; /**< wait for the queue to be non-empty */
 
     vlc_cond_t nothreads_wait; /**< wait for nthreads == 0 */
@@ -89,33 +90,37 @@ static struct task *QueueTake(struct background_worker *worker, int timeout_ms)
 
     vlc_tick_t deadline = vlc_tick_now() + VLC_TICK_FROM_MS(timeout_ms);
     bool timeout = false;
-    while (!timeout && !worker->closing && vlc_list_is_empty(&worker->queue))
+    while (!timeout && !worker->closing && vlc_list_is_empty(&worker->queue)
+           && vlc_list_is_empty(&worker->queue_high))
         timeout = vlc_cond_timedwait(&worker->queue_wait,
                                      &worker->lock, deadline) != 0;
 
     if (worker->closing || timeout)
         return NULL;
 
-    struct task *task = vlc_list_first_entry_or_null(&worker->queue,
+    struct task *task = vlc_list_first_entry_or_null(&worker->queue_high,
                                                      struct task, node);
+    if (!task)
+        task = vlc_list_first_entry_or_null(&worker->queue, struct task, node);
     assert(task);
     vlc_list_remove(&task->node);
 
     return task;
 }
 
-static void QueuePush(struct background_worker *worker, struct task *task)
+static void QueuePush(struct background_worker *worker, struct task *task,
+                      bool high)
 {
     vlc_mutex_assert(&worker->lock);
-    vlc_list_append(&task->node, &worker->queue);
+    vlc_list_append(&task->node, high ? &worker->queue_high : &worker->queue);
     vlc_cond_signal(&worker->queue_wait);
 }
 
-static void QueueRemoveAll(struct background_worker *worker, void *id)
+static void QueueRemoveList(struct background_worker *worker,
+                            struct vlc_list *queue, void *id)
 {
-    vlc_mutex_assert(&worker->lock);
     struct task *task;
-    vlc_list_foreach(task, &worker->queue, node)
+    vlc_list_foreach(task, queue, node)
     {
         if (!id || task->id == id)
         {
@@ -125,6 +130,13 @@ static void QueueRemoveAll(struct background_worker *worker, void *id)
     }
 }
 
+static void QueueRemoveAll(struct background_worker *worker, void *id)
+{
+    vlc_mutex_assert(&worker->lock);
+    QueueRemoveList(worker, &worker->queue_high, id);
+    QueueRemoveList(worker, &worker->queue, id);
+}
+
 static struct background_thread *
 background_thread_Create(struct background_worker *owner)
 {
@@ -160,6 +172,7 @@ static struct background_worker *background_worker_Create(void *owner,
     worker->nthreads = 0;
     vlc_list_init(&worker->threads);
     vlc_list_init(&worker->queue);
+    vlc_list_init(&worker->queue_high);
     vlc_cond_init(&worker->queue_wait);
     vlc_cond_init(&worker->nothreads_wait);
     worker->closing = false;
@@ -288,15 +301,15 @@ struct background_worker* background_worker_New( void* owner,
     return background_worker_Create(owner, conf);
 }
 
-int background_worker_Push( struct background_worker* worker, void* entity,
-                        void* id, int timeout )
+static int BackgroundWorkerPush(struct background_worker *worker, void *entity,
+                                void *id, int timeout, bool high)
 {
     struct task *task = task_Create(worker, id, entity, timeout);
     if (unlikely(!task))
         return VLC_ENOMEM;
 
     vlc_mutex_lock(&worker->lock);
-    QueuePush(worker, task);
+    QueuePush(worker, task, high);
     if (++worker->uncompleted > worker->nthreads
             && worker->nthreads < worker->conf.max_threads)
         SpawnThread(worker);
@@ -305,6 +318,18 @@ int background_worker_Push( struct background_worker* worker, void* entity,
     return VLC_SUCCESS;
 }
 
+int background_worker_Push( struct background_worker* worker, void* entity,
+                        void* id, int timeout )
+{
+    return BackgroundWorkerPush(worker, entity, id, timeout, false);
+}
+
+int background_worker_PushPriority( struct background_worker* worker,
+                                    void* entity, void* id, int timeout )
+{
+    return BackgroundWorkerPush(worker, entity, id, timeout, true);
+}
+
 static void BackgroundWorkerCancelLocked(struct background_worker *worker,
                                          void *id)
 {
@@ -171,6 +171,17 @@ void background_worker_RequestProbe( struct background_worker* worker );
 int background_worker_Push( struct background_worker* worker, void* entity,
     void* id, int timeout );
 
+/**
+ * Push an entity into the background-worker, ahead of the pending ones
+ *
+ * Same as \ref background_worker_Push, except that the entity will be
+ * processed before all the entities pushed by \ref background_worker_Push
+ * that are still queued. Entities pushed by this function are processed in
+ * the order in which they are received.
+ **/
+int background_worker_PushPriority( struct background_worker* worker,
+    void* entity, void* id, int timeout );
+
 /**
  * Remove entities from the background-worker
  *
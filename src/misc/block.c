@@ -28,12 +28,15 @@
 #include <sys/stat.h>
 #include <assert.h>
 #include <errno.h>
+#include <stdatomic.h>
 #include <unistd.h>
 #include <fcntl.h>
 
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include <vlc_memstats.h>
+#include "libvlc.h"
 
 #ifndef NDEBUG
 static void block_Check (block_t *block)
@@ -87,6 +90,25 @@ static const struct vlc_block_callbacks block_generic_cbs =
     block_generic_Release,
 };
 
+/* Blocks allocated while the memory accounting is enabled are tagged with
+ * their own callbacks, so that each release matches one allocation. */
+static void block_Unaccount(block_t *block)
+{
+    vlc_mem_account_Sub(vlc_mem_GetCoreAccount(VLC_MEM_BLOCKS), 1,
+                        sizeof (*block) + block->i_size);
+}
+
+static void block_generic_accounted_Release(block_t *block)
+{
+    block_Unaccount(block);
+    block_generic_Release(block);
+}
+
+static const struct vlc_block_callbacks block_generic_accounted_cbs =
+{
+    block_generic_accounted_Release,
+};
+
 static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 {
     out->p_next    = in->p_next;
@@ -105,6 +127,258 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/* 2 * BLOCK_PADDING: pre + post padding */
+#define BLOCK_OVERHEAD (sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING))
+
+#if !defined(__SANITIZE_ADDRESS__)
+/*
+ * Block cache
+ *
+ * Blocks with a payload of up to 64 KiB are rounded up to a power of two
+ * size class, and recycled through a small set of caches instead of being
+ * returned to the heap. Each thread is bound to one cache, so threads of
+ * the same pipeline normally do not contend. Blocks are released into the
+ * cache of the releasing thread, or of another thread if it is full, and a
+ * thread whose cache is empty takes them from the other caches before
+ * falling back to the heap: this moves
+ * buffers from the consuming threads back to the producing ones, so that a
+ * pipeline in steady state does not allocate.
+ *
+ * There is no portable thread exit hook for thread_local storage, so the
+ * caches are shared by threads rather than owned by them. Thus nothing is
+ * stranded when a thread exits.
+ */
+# define BLOCK_CACHE_SHARDS    8
+# define BLOCK_CACHE_MIN_SHIFT 8  /* 256 bytes */
+# define BLOCK_CACHE_MAX_SHIFT 16 /* 64 KiB */
+# define BLOCK_CACHE_CLASSES   (BLOCK_CACHE_MAX_SHIFT - BLOCK_CACHE_MIN_SHIFT + 1)
+/** Maximum payload bytes kept per size class and per cache */
+# define BLOCK_CACHE_BYTES     (256u << 10)
+/** Minimum count of blocks kept per size class and per cache */
+# define BLOCK_CACHE_MIN_COUNT 8u
+
+struct block_cache_class
+{
+    block_t *head;
+    unsigned count;
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long stolen; /* taken by threads of other caches */
+    unsigned long long overflows;
+};
+
+struct block_cache
+{
+    vlc_mutex_t lock;
+    struct block_cache_class classes[BLOCK_CACHE_CLASSES];
+};
+
+static struct block_cache block_caches[BLOCK_CACHE_SHARDS];
+static vlc_once_t block_caches_once = VLC_STATIC_ONCE;
+static atomic_uint block_caches_next = ATOMIC_VAR_INIT(0);
+static thread_local struct block_cache *block_cache_self;
+
+static void block_CacheInit(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(block_caches); i++)
+        vlc_mutex_init(&block_caches[i].lock);
+}
+
+static struct block_cache *block_CacheGet(void)
+{
+    struct block_cache *cache = block_cache_self;
+
+    if (unlikely(cache == NULL))
+    {
+        unsigned idx = atomic_fetch_add_explicit(&block_caches_next, 1,
+                                                 memory_order_relaxed);
+
+        vlc_once(&block_caches_once, block_CacheInit);
+        cache = &block_caches[idx % BLOCK_CACHE_SHARDS];
+        block_cache_self = cache;
+    }
+    return cache;
+}
+
+static unsigned block_CacheClass(size_t size)
+{
+    if (size <= (1u << BLOCK_CACHE_MIN_SHIFT))
+        return 0;
+    return (sizeof (unsigned long long) * 8 - vlc_clzll(size - 1))
+           - BLOCK_CACHE_MIN_SHIFT;
+}
+
+static unsigned block_CacheMax(unsigned cls)
+{
+    unsigned max = BLOCK_CACHE_BYTES >> (cls + BLOCK_CACHE_MIN_SHIFT);
+
+    return (max > BLOCK_CACHE_MIN_COUNT) ? max : BLOCK_CACHE_MIN_COUNT;
+}
+
+/* Puts a block in another cache, without waiting for busy caches */
+static block_t *block_CacheSpill(struct block_cache *self, unsigned cls,
+                                 block_t *b)
+{
+    size_t idx = self - block_caches;
+
+    for (size_t i = 1; i < BLOCK_CACHE_SHARDS && b != NULL; i++)
+    {
+        struct block_cache *cache =
+            &block_caches[(idx + i) % BLOCK_CACHE_SHARDS];
+        struct block_cache_class *c = &cache->classes[cls];
+
+        if (vlc_mutex_trylock(&cache->lock))
+            continue;
+        if (c->count < block_CacheMax(cls))
+        {
+            b->p_next = c->head;
+            c->head = b;
+            c->count++;
+            b = NULL;
+        }
+        vlc_mutex_unlock(&cache->lock);
+    }
+    return b;
+}
+
+static void block_cache_Release(block_t *block)
+{
+    assert(block->p_start == (unsigned char *)(block + 1));
+
+    size_t size = block->i_size - (BLOCK_OVERHEAD - sizeof (*block));
+    unsigned cls = block_CacheClass(size);
+    assert(size == (1u << (cls + BLOCK_CACHE_MIN_SHIFT)));
+
+    struct block_cache *cache = block_CacheGet();
+    struct block_cache_class *c = &cache->classes[cls];
+
+    vlc_mutex_lock(&cache->lock);
+    if (c->count < block_CacheMax(cls))
+    {
+        block->p_next = c->head;
+        c->head = block;
+        c->count++;
+        block = NULL;
+    }
+    else
+        c->overflows++;
+    vlc_mutex_unlock(&cache->lock);
+
+    if (block != NULL)
+        free(block_CacheSpill(cache, cls, block));
+}
+
+static const struct vlc_block_callbacks block_cache_cbs =
+{
+    block_cache_Release,
+};
+
+static void block_cache_accounted_Release(block_t *block)
+{
+    block_Unaccount(block);
+    block_cache_Release(block);
+}
+
+static const struct vlc_block_callbacks block_cache_accounted_cbs =
+{
+    block_cache_accounted_Release,
+};
+
+/* Takes a block from another cache, without waiting for busy caches */
+static block_t *block_CacheSteal(struct block_cache *self, unsigned cls)
+{
+    size_t idx = self - block_caches;
+    block_t *b = NULL;
+
+    for (size_t i = 1; i < BLOCK_CACHE_SHARDS && b == NULL; i++)
+    {
+        struct block_cache *cache =
+            &block_caches[(idx + i) % BLOCK_CACHE_SHARDS];
+        struct block_cache_class *c = &cache->classes[cls];
+
+        if (vlc_mutex_trylock(&cache->lock))
+            continue;
+        b = c->head;
+        if (b != NULL)
+        {
+            c->head = b->p_next;
+            c->count--;
+            c->stolen++;
+        }
+        vlc_mutex_unlock(&cache->lock);
+    }
+    return b;
+}
+
+static block_t *block_CacheAlloc(size_t size)
+{
+    unsigned cls = block_CacheClass(size);
+    struct block_cache *cache = block_CacheGet();
+    struct block_cache_class *c = &cache->classes[cls];
+    block_t *b;
+
+    vlc_mutex_lock(&cache->lock);
+    b = c->head;
+    if (b != NULL)
+    {
+        c->head = b->p_next;
+        c->count--;
+        c->hits++;
+    }
+    else
+        c->misses++;
+    vlc_mutex_unlock(&cache->lock);
+
+    if (b == NULL)
+        b = block_CacheSteal(cache, cls);
+    if (b == NULL)
+    {
+        vlc_mem_CountAllocation();
+        b = malloc(BLOCK_OVERHEAD + (1u << (cls + BLOCK_CACHE_MIN_SHIFT)));
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+    return b;
+}
+
+void vlc_block_cache_Purge(vlc_object_t *obj)
+{
+    vlc_once(&block_caches_once, block_CacheInit);
+
+    for (size_t i = 0; i < ARRAY_SIZE(block_caches); i++)
+    {
+        struct block_cache *cache = &block_caches[i];
+
+        vlc_mutex_lock(&cache->lock);
+        for (unsigned cls = 0; cls < BLOCK_CACHE_CLASSES; cls++)
+        {
+            struct block_cache_class *c = &cache->classes[cls];
+
+            if (c->hits + c->misses > 0)
+                msg_Dbg(obj, "block cache %zu, %u bytes: %llu hits, "
+                        "%llu misses, %llu stolen, %llu overflows", i,
+                        1u << (cls + BLOCK_CACHE_MIN_SHIFT),
+                        c->hits, c->misses, c->stolen, c->overflows);
+
+            while (c->head != NULL)
+            {
+                block_t *b = c->head;
+
+                c->head = b->p_next;
+                free(b);
+            }
+            c->count = 0;
+        }
+        vlc_mutex_unlock(&cache->lock);
+    }
+}
+#else
+void vlc_block_cache_Purge(vlc_object_t *obj)
+{
+    (void) obj;
+}
+#endif
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -113,17 +387,40 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
-    /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
-    if (unlikely(alloc <= size))
-        return NULL;
+    vlc_mem_account_t *account = vlc_mem_GetCoreAccount(VLC_MEM_BLOCKS);
+    block_t *b;
+    size_t alloc;
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+#if !defined(__SANITIZE_ADDRESS__)
+    if (size <= (1u << BLOCK_CACHE_MAX_SHIFT))
+    {
+        b = block_CacheAlloc(size);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        alloc = BLOCK_OVERHEAD
+              + (1u << (block_CacheClass(size) + BLOCK_CACHE_MIN_SHIFT));
+        block_Init(b, (account != NULL) ? &block_cache_accounted_cbs
+                                        : &block_cache_cbs,
+                   b + 1, alloc - sizeof (*b));
+    }
+    else
+#endif
+    {
+        alloc = BLOCK_OVERHEAD + size;
+        if (unlikely(alloc <= size))
+            return NULL;
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+        vlc_mem_CountAllocation();
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, (account != NULL) ? &block_generic_accounted_cbs
+                                        : &block_generic_cbs,
+                   b + 1, alloc - sizeof (*b));
+    }
+    vlc_mem_account_Add(account, 1, alloc);
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -153,6 +450,9 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     assert( p_block->p_start + p_block->i_size
                                     >= p_block->p_buffer + p_block->i_buffer );
 
+    /* Other references must not see the payload or its padding change */
+    const bool shared = block_IsShared( p_block );
+
     /* First, shrink payload */
 
     /* Pull payload start */
@@ -177,7 +477,7 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
 
     if( p_block->i_buffer == 0 )
     {   /* Corner case: nothing to preserve */
-        if( requested <= p_block->i_size )
+        if( requested <= p_block->i_size && !shared )
         {   /* Enough room: recycle buffer */
             size_t extra = p_block->i_size - requested;
 
@@ -202,7 +502,8 @@ block_t *block_TryRealloc (block_t *p_block, ssize_t i_prebody, size_t i_body)
     /* Second, reallocate the buffer if we lack space. */
     assert( i_prebody >= 0 );
     if( (size_t)(p_block->p_buffer - p_start) < (size_t)i_prebody
-     || (size_t)(p_end - p_block->p_buffer) < i_body )
+     || (size_t)(p_end - p_block->p_buffer) < i_body
+     || (shared && (i_prebody > 0 || i_body > p_block->i_buffer)) )
     {
         block_t *p_rea = block_Alloc( requested );
         if( p_rea == NULL )
@@ -240,6 +541,90 @@ block_t *block_Realloc (block_t *block, ssize_t prebody, size_t body)
     return rea;
 }
 
+/*
+ * Shared payload blocks
+ *
+ * The owner block, which holds the payload, is kept until all the blocks
+ * sharing it are released. Its callbacks are replaced with the shared
+ * payload ones, embedded in the payload reference count.
+ */
+struct block_shared
+{
+    struct vlc_block_callbacks cbs; /* replacing the owner ones */
+    const struct vlc_block_callbacks *owner_cbs;
+    block_t *owner;
+    atomic_uint refs;
+};
+
+static void block_shared_Release(block_t *block)
+{
+    struct block_shared *sh = container_of(block->cbs, struct block_shared,
+                                           cbs);
+    if (block != sh->owner)
+        free(block);
+
+    if (atomic_fetch_sub_explicit(&sh->refs, 1, memory_order_acq_rel) == 1)
+    {
+        block_t *owner = sh->owner;
+
+        owner->cbs = sh->owner_cbs;
+        free(sh);
+        owner->cbs->free(owner);
+    }
+}
+
+block_t *block_Share(block_t *block)
+{
+    struct block_shared *sh;
+
+    block_Check(block);
+
+    if (block->cbs->free == block_shared_Release)
+        sh = container_of(block->cbs, struct block_shared, cbs);
+    else
+    {
+        sh = malloc(sizeof (*sh));
+        if (unlikely(sh == NULL))
+            return NULL;
+        sh->cbs.free = block_shared_Release;
+        sh->owner_cbs = block->cbs;
+        sh->owner = block;
+        atomic_init(&sh->refs, 1);
+        block->cbs = &sh->cbs;
+    }
+
+    block_t *ref = malloc(sizeof (*ref));
+    if (unlikely(ref == NULL))
+        return NULL;
+
+    block_Init(ref, &sh->cbs, block->p_start, block->i_size);
+    ref->p_buffer = block->p_buffer;
+    ref->i_buffer = block->i_buffer;
+    block_CopyProperties(ref, block);
+    atomic_fetch_add_explicit(&sh->refs, 1, memory_order_relaxed);
+    return ref;
+}
+
+bool block_IsShared(const block_t *block)
+{
+    if (block->cbs->free != block_shared_Release)
+        return false;
+
+    struct block_shared *sh = container_of(block->cbs, struct block_shared,
+                                           cbs);
+    return atomic_load_explicit(&sh->refs, memory_order_acquire) > 1;
+}
+
+block_t *block_Unshare(block_t *block)
+{
+    if (!block_IsShared(block))
+        return block;
+
+    block_t *dup = block_Duplicate(block);
+    block_Release(block);
+    return dup;
+}
+
 static void block_heap_Release (block_t *block)
 {
     free (block->p_start);
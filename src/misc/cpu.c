@@ -121,24 +121,26 @@ VLC_WEAK unsigned vlc_CPU_raw(void)
 
 #if defined( __i386__ ) || defined( __x86_64__ )
     unsigned int i_eax, i_ebx, i_ecx, i_edx;
+    unsigned int i_max;
     bool b_amd;
 
     /* Needed for x86 CPU capabilities detection */
 # if defined (__i386__) && defined (__PIC__)
-#  define cpuid(reg) \
+#  define cpuidex(reg, sub) \
     asm volatile ("xchgl %%ebx,%1\n\t" \
                   "cpuid\n\t" \
                   "xchgl %%ebx,%1\n\t" \
                   : "=a" (i_eax), "=r" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                  : "a" (reg) \
+                  : "a" (reg), "c" (sub) \
                   : "cc");
 # else
-#  define cpuid(reg) \
+#  define cpuidex(reg, sub) \
     asm volatile ("cpuid\n\t" \
                   : "=a" (i_eax), "=b" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                  : "a" (reg) \
+                  : "a" (reg), "c" (sub) \
                   : "cc");
 # endif
+# define cpuid(reg) cpuidex(reg, 0)
      /* Check if the OS really supports the requested instructions */
 # if defined (__i386__) && !defined (__i486__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -165,6 +167,7 @@ VLC_WEAK unsigned vlc_CPU_raw(void)
 
     /* the CPU supports the CPUID instruction - get its level */
     cpuid( 0x00000000 );
+    i_max = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -205,6 +208,37 @@ VLC_WEAK unsigned vlc_CPU_raw(void)
             i_capabilities |= VLC_CPU_SSE4_2;
     }
 
+    /* The AVX registers must be saved by the OS (OSXSAVE and XCR0) */
+    if ((i_ecx & 0x18000000) == 0x18000000)
+    {
+        unsigned int i_xcr0, i_xcr0_high;
+
+        asm volatile ("xgetbv\n\t"
+                      : "=a" (i_xcr0), "=d" (i_xcr0_high)
+                      : "c" (0));
+        (void) i_xcr0_high;
+
+        if ((i_xcr0 & 0x06) == 0x06) /* XMM and YMM */
+        {
+            i_capabilities |= VLC_CPU_AVX;
+
+            if (i_max >= 7)
+            {
+                cpuidex( 0x00000007, 0 );
+                if (i_ebx & 0x00000020)
+                    i_capabilities |= VLC_CPU_AVX2;
+                /* F, DQ, CD, BW and VL, with the opmask and ZMM states */
+                if ((i_ebx & 0xd0030000) == 0xd0030000
+                 && (i_xcr0 & 0xe0) == 0xe0)
+                    i_capabilities |= VLC_CPU_AVX512;
+
+                cpuidex( 0x00000007, 1 );
+                if (i_eax & 0x00000010)
+                    i_capabilities |= VLC_CPU_AVX_VNNI;
+            }
+        }
+    }
+
     /* test for additional capabilities */
     cpuid( 0x80000000 );
 
@@ -297,6 +331,10 @@ void vlc_CPU_dump (vlc_object_t *obj)
         vlc_memstream_puts(&stream, "XOP ");
     if (vlc_CPU_FMA4())
         vlc_memstream_puts(&stream, "FMA4 ");
+    if (vlc_CPU_AVX512())
+        vlc_memstream_puts(&stream, "AVX-512 ");
+    if (vlc_CPU_AVX_VNNI())
+        vlc_memstream_puts(&stream, "AVX-VNNI ");
 
 #elif defined (__powerpc__) || defined (__ppc__) || defined (__ppc64__)
     if (vlc_CPU_ALTIVEC())
@@ -306,6 +344,14 @@ void vlc_CPU_dump (vlc_object_t *obj)
     if (vlc_CPU_ARM_NEON())
         vlc_memstream_puts(&stream, "ARM_NEON ");
 
+#elif defined (__aarch64__)
+    if (vlc_CPU_ARM_NEON())
+        vlc_memstream_puts(&stream, "ARM_NEON ");
+    if (vlc_CPU_ARM_SVE())
+        vlc_memstream_puts(&stream, "SVE ");
+    if (vlc_CPU_ARM_SVE2())
+        vlc_memstream_puts(&stream, "SVE2 ");
+
 #endif
 
 #if HAVE_FPU
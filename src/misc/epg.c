@@ -130,40 +130,35 @@ static void vlc_epg_Clean( vlc_epg_t *p_epg )
     free( p_epg->psz_name );
 }
 
-bool vlc_epg_AddEvent( vlc_epg_t *p_epg, vlc_epg_event_t *p_evt )
+/* Returns the index of the first event starting at or after i_start,
+ * or i_event if there is none. Events are sorted by start time. */
+static size_t vlc_epg_Lookup( const vlc_epg_t *p_epg, int64_t i_start )
 {
-    ssize_t i_pos = -1;
+    size_t i_lower = 0;
+    size_t i_upper = p_epg->i_event;
 
     /* Insertions are supposed in sequential order first */
-    if( p_epg->i_event )
-    {
-        if( p_epg->pp_event[0]->i_start > p_evt->i_start )
-        {
-            i_pos = 0;
-        }
-        else if ( p_epg->pp_event[p_epg->i_event - 1]->i_start >= p_evt->i_start )
-        {
-            /* Do bisect search lower start time entry */
-            size_t i_lower = 0;
-            size_t i_upper = p_epg->i_event - 1;
+    if( i_upper == 0 || p_epg->pp_event[i_upper - 1]->i_start < i_start )
+        return i_upper;
 
-            while( i_lower < i_upper )
-            {
-                size_t i_split = ( i_lower + i_upper ) / 2;
-                vlc_epg_event_t *p_cur = p_epg->pp_event[i_split];
+    while( i_lower < i_upper )
+    {
+        size_t i_split = ( i_lower + i_upper ) / 2;
 
-                if( p_cur->i_start < p_evt->i_start )
-                {
-                    i_lower = i_split + 1;
-                }
-                else if ( p_cur->i_start >= p_evt->i_start )
-                {
-                    i_upper = i_split;
-                }
-            }
-            i_pos = i_lower;
-        }
+        if( p_epg->pp_event[i_split]->i_start < i_start )
+            i_lower = i_split + 1;
+        else
+            i_upper = i_split;
     }
+    return i_lower;
+}
+
+bool vlc_epg_AddEvent( vlc_epg_t *p_epg, vlc_epg_event_t *p_evt )
+{
+    ssize_t i_pos = vlc_epg_Lookup( p_epg, p_evt->i_start );
+
+    if( (size_t) i_pos == p_epg->i_event )
+        i_pos = -1;
 
     if( i_pos != -1 )
     {
@@ -203,19 +198,13 @@ void vlc_epg_Delete( vlc_epg_t *p_epg )
 
 void vlc_epg_SetCurrent( vlc_epg_t *p_epg, int64_t i_start )
 {
-    size_t i;
     p_epg->p_current = NULL;
     if( i_start < 0 )
         return;
 
-    for( i = 0; i < p_epg->i_event; i++ )
-    {
-        if( p_epg->pp_event[i]->i_start == i_start )
-        {
-            p_epg->p_current = p_epg->pp_event[i];
-            break;
-        }
-    }
+    size_t i = vlc_epg_Lookup( p_epg, i_start );
+    if( i < p_epg->i_event && p_epg->pp_event[i]->i_start == i_start )
+        p_epg->p_current = p_epg->pp_event[i];
 }
 
 vlc_epg_t * vlc_epg_Duplicate( const vlc_epg_t *p_src )
@@ -32,6 +32,7 @@
 
 #include <vlc_common.h>
 #include <vlc_es.h>
+#include "../libvlc.h"
 
 /* */
 void video_format_FixRgb( video_format_t *p_fmt )
@@ -418,6 +419,7 @@ int es_format_Copy(es_format_t *restrict dst, const es_format_t *src)
 {
     int ret = VLC_SUCCESS;
 
+    vlc_mem_CountAllocation();
     *dst = *src;
 
     if (src->psz_language != NULL)
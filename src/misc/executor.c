@@ -0,0 +1,466 @@
+/*****************************************************************************
+ * executor.c: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_executor.h>
+#include "../libvlc.h"
+
+struct vlc_executor_worker
+{
+    vlc_executor_t *owner;
+    vlc_mutex_t lock;
+    /* Own tasks are taken from the head, stolen tasks from the tail */
+    struct vlc_list queue;
+    vlc_thread_t thread;
+};
+
+struct vlc_executor
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    atomic_uint started; /**< number of running workers */
+    unsigned idle; /**< number of workers waiting for tasks */
+    unsigned next; /**< next worker to queue a foreign task to */
+    bool closing;
+    atomic_size_t pending; /**< number of queued tasks */
+    unsigned max_threads;
+    struct vlc_executor_worker workers[];
+};
+
+struct vlc_task_group
+{
+    vlc_executor_t *executor;
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    size_t pending; /**< number of tasks queued or running */
+    atomic_bool cancelled;
+};
+
+static thread_local struct vlc_executor_worker *current_worker;
+
+static void TaskGroupDone(vlc_task_group_t *group)
+{
+    vlc_mutex_lock(&group->lock);
+    assert(group->pending > 0);
+    if (--group->pending == 0)
+        vlc_cond_broadcast(&group->wait);
+    vlc_mutex_unlock(&group->lock);
+}
+
+static void RunnableRun(struct vlc_runnable *runnable)
+{
+    /* The runnable may be freed by its own callback */
+    vlc_task_group_t *group = runnable->group;
+
+    runnable->run(runnable->userdata);
+
+    if (group != NULL)
+        TaskGroupDone(group);
+}
+
+/**
+ * Takes a task from the queue of a worker.
+ *
+ * \param head whether to take the most recently queued task
+ * \param group NULL to take any task, or the group of the task to take
+ */
+static struct vlc_runnable *WorkerTake(struct vlc_executor_worker *worker,
+                                       bool head, vlc_task_group_t *group)
+{
+    struct vlc_runnable *runnable = NULL, *r;
+
+    vlc_mutex_lock(&worker->lock);
+    if (group == NULL)
+    {
+        if (head)
+            runnable = vlc_list_first_entry_or_null(&worker->queue,
+                                                    struct vlc_runnable, node);
+        else
+            runnable = vlc_list_last_entry_or_null(&worker->queue,
+                                                   struct vlc_runnable, node);
+    }
+    else
+    {
+        vlc_list_foreach(r, &worker->queue, node)
+            if (r->group == group)
+            {
+                runnable = r;
+                break;
+            }
+    }
+
+    if (runnable != NULL)
+    {
+        vlc_list_remove(&runnable->node);
+        atomic_fetch_sub_explicit(&worker->owner->pending, 1,
+                                  memory_order_relaxed);
+    }
+    vlc_mutex_unlock(&worker->lock);
+    return runnable;
+}
+
+/**
+ * Takes a task from the queue of the calling worker, or steals one from
+ * another worker.
+ */
+static struct vlc_runnable *ExecutorTake(vlc_executor_t *executor,
+                                         vlc_task_group_t *group)
+{
+    struct vlc_executor_worker *self = current_worker;
+    struct vlc_runnable *runnable;
+    unsigned first = 0;
+
+    if (self != NULL && self->owner == executor)
+    {
+        runnable = WorkerTake(self, true, group);
+        if (runnable != NULL)
+            return runnable;
+        first = self - executor->workers + 1;
+    }
+
+    unsigned count = atomic_load_explicit(&executor->started,
+                                          memory_order_acquire);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct vlc_executor_worker *victim =
+            &executor->workers[(first + i) % count];
+
+        if (victim == self)
+            continue;
+        runnable = WorkerTake(victim, false, group);
+        if (runnable != NULL)
+            return runnable;
+    }
+    return NULL;
+}
+
+static void *WorkerThread(void *data)
+{
+    struct vlc_executor_worker *worker = data;
+    vlc_executor_t *executor = worker->owner;
+
+    current_worker = worker;
+
+    for (;;)
+    {
+        struct vlc_runnable *runnable = ExecutorTake(executor, NULL);
+        if (runnable != NULL)
+        {
+            RunnableRun(runnable);
+            continue;
+        }
+
+        vlc_mutex_lock(&executor->lock);
+        if (atomic_load_explicit(&executor->pending,
+                                 memory_order_relaxed) == 0)
+        {
+            if (executor->closing)
+            {
+                vlc_mutex_unlock(&executor->lock);
+                break;
+            }
+            executor->idle++;
+            vlc_cond_wait(&executor->wait, &executor->lock);
+            executor->idle--;
+        }
+        vlc_mutex_unlock(&executor->lock);
+    }
+    return NULL;
+}
+
+vlc_executor_t *vlc_executor_New(unsigned max_threads)
+{
+    assert(max_threads > 0);
+
+    vlc_executor_t *executor =
+        malloc(sizeof (*executor) + max_threads * sizeof (executor->workers[0]));
+    if (unlikely(executor == NULL))
+        return NULL;
+
+    vlc_mutex_init(&executor->lock);
+    vlc_cond_init(&executor->wait);
+    atomic_init(&executor->started, 0);
+    executor->idle = 0;
+    executor->next = 0;
+    executor->closing = false;
+    atomic_init(&executor->pending, 0);
+    executor->max_threads = max_threads;
+
+    for (unsigned i = 0; i < max_threads; i++)
+    {
+        struct vlc_executor_worker *worker = &executor->workers[i];
+
+        worker->owner = executor;
+        vlc_mutex_init(&worker->lock);
+        vlc_list_init(&worker->queue);
+    }
+    return executor;
+}
+
+void vlc_executor_Delete(vlc_executor_t *executor)
+{
+    vlc_mutex_lock(&executor->lock);
+    executor->closing = true;
+    vlc_cond_broadcast(&executor->wait);
+    vlc_mutex_unlock(&executor->lock);
+
+    /* No more workers can be started once closing */
+    unsigned count = atomic_load(&executor->started);
+    for (unsigned i = 0; i < count; i++)
+        vlc_join(executor->workers[i].thread, NULL);
+
+    assert(atomic_load(&executor->pending) == 0);
+    free(executor);
+}
+
+vlc_executor_t *(vlc_executor_Get)(vlc_object_t *obj)
+{
+    return libvlc_priv(vlc_object_instance(obj))->executor;
+}
+
+static int ExecutorSubmit(vlc_executor_t *executor,
+                          struct vlc_runnable *runnable)
+{
+    struct vlc_executor_worker *worker = current_worker;
+
+    vlc_mutex_lock(&executor->lock);
+    assert(!executor->closing);
+
+    unsigned count = atomic_load_explicit(&executor->started,
+                                          memory_order_relaxed);
+    if (executor->idle == 0 && count < executor->max_threads)
+    {
+        struct vlc_executor_worker *fresh = &executor->workers[count];
+
+        /* The jobs render video slices on behalf of the video output */
+        if (vlc_clone(&fresh->thread, WorkerThread, fresh,
+                      VLC_THREAD_PRIORITY_VIDEO) == 0)
+            atomic_store_explicit(&executor->started, ++count,
+                                  memory_order_release);
+        else if (count == 0)
+        {
+            vlc_mutex_unlock(&executor->lock);
+            return VLC_ENOMEM;
+        }
+    }
+
+    bool own = worker != NULL && worker->owner == executor;
+    if (!own)
+        worker = &executor->workers[executor->next++ % count];
+
+    vlc_mutex_lock(&worker->lock);
+    if (own)
+        vlc_list_prepend(&runnable->node, &worker->queue);
+    else
+        vlc_list_append(&runnable->node, &worker->queue);
+    vlc_mutex_unlock(&worker->lock);
+
+    atomic_fetch_add_explicit(&executor->pending, 1, memory_order_relaxed);
+    if (executor->idle > 0)
+        vlc_cond_signal(&executor->wait);
+    vlc_mutex_unlock(&executor->lock);
+    return VLC_SUCCESS;
+}
+
+int vlc_executor_Submit(vlc_executor_t *executor,
+                        struct vlc_runnable *runnable)
+{
+    runnable->group = NULL;
+    return ExecutorSubmit(executor, runnable);
+}
+
+static bool ExecutorRemove(vlc_executor_t *executor,
+                           struct vlc_runnable *runnable,
+                           vlc_task_group_t *group)
+{
+    bool found = false;
+
+    unsigned count = atomic_load_explicit(&executor->started,
+                                          memory_order_acquire);
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        struct vlc_executor_worker *worker = &executor->workers[i];
+        struct vlc_runnable *r;
+
+        vlc_mutex_lock(&worker->lock);
+        vlc_list_foreach(r, &worker->queue, node)
+        {
+            if (r != runnable && (group == NULL || r->group != group))
+                continue;
+
+            vlc_list_remove(&r->node);
+            atomic_fetch_sub_explicit(&executor->pending, 1,
+                                      memory_order_relaxed);
+            if (r->group != NULL)
+                TaskGroupDone(r->group);
+            found = true;
+            if (runnable != NULL)
+                break;
+        }
+        vlc_mutex_unlock(&worker->lock);
+
+        if (found && runnable != NULL)
+            break;
+    }
+    return found;
+}
+
+bool vlc_executor_Cancel(vlc_executor_t *executor,
+                         struct vlc_runnable *runnable)
+{
+    return ExecutorRemove(executor, runnable, NULL);
+}
+
+static void TaskGroupInit(vlc_task_group_t *group, vlc_executor_t *executor)
+{
+    group->executor = executor;
+    vlc_mutex_init(&group->lock);
+    vlc_cond_init(&group->wait);
+    group->pending = 0;
+    atomic_init(&group->cancelled, false);
+}
+
+vlc_task_group_t *vlc_task_group_New(vlc_executor_t *executor)
+{
+    vlc_task_group_t *group = malloc(sizeof (*group));
+    if (likely(group != NULL))
+        TaskGroupInit(group, executor);
+    return group;
+}
+
+void vlc_task_group_Delete(vlc_task_group_t *group)
+{
+    vlc_task_group_Cancel(group);
+    vlc_task_group_Wait(group);
+    free(group);
+}
+
+int vlc_task_group_Submit(vlc_task_group_t *group,
+                          struct vlc_runnable *runnable)
+{
+    if (atomic_load_explicit(&group->cancelled, memory_order_relaxed))
+        return VLC_EGENERIC;
+
+    runnable->group = group;
+
+    vlc_mutex_lock(&group->lock);
+    group->pending++;
+    vlc_mutex_unlock(&group->lock);
+
+    int ret = ExecutorSubmit(group->executor, runnable);
+    if (ret != VLC_SUCCESS)
+        TaskGroupDone(group);
+    return ret;
+}
+
+void vlc_task_group_Cancel(vlc_task_group_t *group)
+{
+    atomic_store_explicit(&group->cancelled, true, memory_order_relaxed);
+    ExecutorRemove(group->executor, NULL, group);
+}
+
+bool vlc_task_group_IsCancelled(vlc_task_group_t *group)
+{
+    return atomic_load_explicit(&group->cancelled, memory_order_relaxed);
+}
+
+void vlc_task_group_Wait(vlc_task_group_t *group)
+{
+    struct vlc_runnable *runnable;
+
+    /* Help rather than block a worker that the tasks may need */
+    while ((runnable = ExecutorTake(group->executor, group)) != NULL)
+        RunnableRun(runnable);
+
+    vlc_mutex_lock(&group->lock);
+    while (group->pending > 0)
+        vlc_cond_wait(&group->wait, &group->lock);
+    vlc_mutex_unlock(&group->lock);
+}
+
+struct parallel_for
+{
+    void (*func)(void *opaque, size_t index);
+    void *opaque;
+    size_t count;
+    atomic_size_t next;
+};
+
+static void ParallelForRun(void *data)
+{
+    struct parallel_for *pf = data;
+    size_t index;
+
+    while ((index = atomic_fetch_add_explicit(&pf->next, 1,
+                                              memory_order_relaxed))
+           < pf->count)
+        pf->func(pf->opaque, index);
+}
+
+void vlc_executor_ParallelFor(vlc_executor_t *executor, size_t count,
+                              void (*func)(void *opaque, size_t index),
+                              void *opaque)
+{
+    struct parallel_for pf = {
+        .func = func,
+        .opaque = opaque,
+        .count = count,
+    };
+    atomic_init(&pf.next, 0);
+
+    /* The calling thread takes its share of the work */
+    size_t helpers = (count > 1) ? __MIN(count - 1, executor->max_threads - 1)
+                                 : 0;
+    struct vlc_runnable *runnables =
+        (helpers > 0) ? vlc_alloc(helpers, sizeof (*runnables)) : NULL;
+    if (runnables == NULL)
+    {
+        ParallelForRun(&pf);
+        return;
+    }
+
+    vlc_task_group_t group;
+    TaskGroupInit(&group, executor);
+
+    for (size_t i = 0; i < helpers; i++)
+    {
+        runnables[i].run = ParallelForRun;
+        runnables[i].userdata = &pf;
+        if (vlc_task_group_Submit(&group, &runnables[i]) != VLC_SUCCESS)
+            break;
+    }
+
+    ParallelForRun(&pf);
+
+    /* All indices are taken: the helpers that did not start are useless */
+    vlc_task_group_Cancel(&group);
+    vlc_task_group_Wait(&group);
+    free(runnables);
+}
@@ -30,6 +30,7 @@
 
 #include <vlc_common.h>
 #include <vlc_block.h>
+#include <vlc_memstats.h>
 #include "libvlc.h"
 
 /**
@@ -40,6 +41,7 @@ struct block_fifo_t
     vlc_queue_t         q;
     size_t              i_depth;
     size_t              i_size;
+    vlc_mem_account_t  *account;
 };
 
 static_assert (offsetof (block_fifo_t, q) == 0, "Problems in <vlc_block.h>");
@@ -56,12 +58,25 @@ size_t vlc_fifo_GetBytes(const vlc_fifo_t *fifo)
     return fifo->i_size;
 }
 
+void vlc_fifo_SetAccount(vlc_fifo_t *fifo, vlc_mem_account_t *account)
+{
+    vlc_mutex_assert(&fifo->q.lock);
+    vlc_mem_account_Sub(fifo->account, fifo->i_depth, fifo->i_size);
+    fifo->account = account;
+    vlc_mem_account_Add(fifo->account, fifo->i_depth, fifo->i_size);
+}
+
 void vlc_fifo_QueueUnlocked(block_fifo_t *fifo, block_t *block)
 {
+    size_t depth = 0, size = 0;
+
     for (block_t *b = block; b != NULL; b = b->p_next) {
-        fifo->i_depth++;
-        fifo->i_size += block->i_buffer;
+        depth++;
+        size += b->i_buffer;
     }
+    fifo->i_depth += depth;
+    fifo->i_size += size;
+    vlc_mem_account_Add(fifo->account, depth, size);
 
     vlc_queue_EnqueueUnlocked(&fifo->q, block);
 }
@@ -75,6 +90,7 @@ block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
         assert(fifo->i_size >= block->i_buffer);
         fifo->i_depth--;
         fifo->i_size -= block->i_buffer;
+        vlc_mem_account_Sub(fifo->account, 1, block->i_buffer);
     }
 
     return block;
@@ -82,6 +98,7 @@ block_t *vlc_fifo_DequeueUnlocked(block_fifo_t *fifo)
 
 block_t *vlc_fifo_DequeueAllUnlocked(block_fifo_t *fifo)
 {
+    vlc_mem_account_Sub(fifo->account, fifo->i_depth, fifo->i_size);
     fifo->i_depth = 0;
     fifo->i_size = 0;
     return vlc_queue_DequeueAllUnlocked(&fifo->q);
@@ -95,6 +112,7 @@ block_fifo_t *block_FifoNew( void )
         vlc_queue_Init(&p_fifo->q, offsetof (block_t, p_next));
         p_fifo->i_depth = 0;
         p_fifo->i_size = 0;
+        p_fifo->account = NULL;
     }
 
     return p_fifo;
@@ -0,0 +1,230 @@
+/*****************************************************************************
+ * fifo_spsc.c: single-producer single-consumer block queue
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+/*
+ * The blocks are stored in a linked list of fixed size chunks of slots. The
+ * producer only writes the tail chunk and the consumer only reads the head
+ * chunk. The depth counter publishes the slots: the producer increments it
+ * with release semantics after filling the slots (and linking a new chunk),
+ * and the consumer reads it with acquire semantics before reading them.
+ *
+ * The consumer sleeps on the sleeping flag. The producer checks the flag
+ * only when the queue turns from empty to non-empty.
+ */
+#define SPSC_CHUNK_SLOTS 64
+
+struct vlc_spsc_chunk
+{
+    block_t *slots[SPSC_CHUNK_SLOTS];
+    struct vlc_spsc_chunk *next;
+};
+
+struct vlc_spsc_fifo
+{
+    /* Producer side */
+    struct vlc_spsc_chunk *tail;
+    unsigned tail_index;
+
+    /* Consumer side */
+    struct vlc_spsc_chunk *head;
+    unsigned head_index;
+
+    /* Shared */
+    atomic_size_t depth;
+    atomic_size_t bytes;
+    atomic_uint sleeping;
+    atomic_bool dead;
+    /* A single chunk freed by the consumer, for reuse by the producer */
+    _Atomic(struct vlc_spsc_chunk *) spare;
+};
+
+vlc_spsc_fifo_t *vlc_spsc_fifo_New(void)
+{
+    vlc_spsc_fifo_t *fifo = malloc(sizeof (*fifo));
+    struct vlc_spsc_chunk *chunk = malloc(sizeof (*chunk));
+
+    if (unlikely(fifo == NULL || chunk == NULL))
+    {
+        free(chunk);
+        free(fifo);
+        return NULL;
+    }
+
+    chunk->next = NULL;
+    fifo->tail = fifo->head = chunk;
+    fifo->tail_index = fifo->head_index = 0;
+    atomic_init(&fifo->depth, 0);
+    atomic_init(&fifo->bytes, 0);
+    atomic_init(&fifo->sleeping, 0);
+    atomic_init(&fifo->dead, false);
+    atomic_init(&fifo->spare, NULL);
+    return fifo;
+}
+
+void vlc_spsc_fifo_Delete(vlc_spsc_fifo_t *fifo)
+{
+    block_t *block;
+
+    while ((block = vlc_spsc_fifo_Dequeue(fifo)) != NULL)
+        block_Release(block);
+
+    assert(fifo->head == fifo->tail);
+    free(fifo->head);
+    free(atomic_load_explicit(&fifo->spare, memory_order_relaxed));
+    free(fifo);
+}
+
+static struct vlc_spsc_chunk *vlc_spsc_fifo_NewChunk(vlc_spsc_fifo_t *fifo)
+{
+    struct vlc_spsc_chunk *chunk =
+        atomic_exchange_explicit(&fifo->spare, NULL, memory_order_acquire);
+
+    if (chunk == NULL)
+    {
+        chunk = malloc(sizeof (*chunk));
+        if (unlikely(chunk == NULL))
+            return NULL;
+    }
+    chunk->next = NULL;
+    return chunk;
+}
+
+static void vlc_spsc_fifo_Wake(vlc_spsc_fifo_t *fifo)
+{
+    if (atomic_load(&fifo->sleeping))
+    {
+        atomic_store(&fifo->sleeping, 0);
+        vlc_atomic_notify_one(&fifo->sleeping);
+    }
+}
+
+void vlc_spsc_fifo_Queue(vlc_spsc_fifo_t *fifo, block_t *block)
+{
+    size_t count = 0, bytes = 0;
+
+    while (block != NULL)
+    {
+        if (fifo->tail_index == SPSC_CHUNK_SLOTS)
+        {
+            struct vlc_spsc_chunk *chunk = vlc_spsc_fifo_NewChunk(fifo);
+            if (unlikely(chunk == NULL))
+            {
+                block_ChainRelease(block);
+                break;
+            }
+
+            fifo->tail->next = chunk;
+            fifo->tail = chunk;
+            fifo->tail_index = 0;
+        }
+
+        block_t *next = block->p_next;
+
+        block->p_next = NULL;
+        fifo->tail->slots[fifo->tail_index++] = block;
+        count++;
+        bytes += block->i_buffer;
+        block = next;
+    }
+
+    if (count == 0)
+        return;
+
+    atomic_fetch_add_explicit(&fifo->bytes, bytes, memory_order_relaxed);
+    /* Sequentially consistent against the sleeping flag */
+    if (atomic_fetch_add(&fifo->depth, count) == 0)
+        vlc_spsc_fifo_Wake(fifo);
+}
+
+block_t *vlc_spsc_fifo_Dequeue(vlc_spsc_fifo_t *fifo)
+{
+    if (atomic_load_explicit(&fifo->depth, memory_order_acquire) == 0)
+        return NULL;
+
+    if (fifo->head_index == SPSC_CHUNK_SLOTS)
+    {
+        struct vlc_spsc_chunk *old = fifo->head;
+
+        /* The producer linked the next chunk before publishing its slots */
+        assert(old->next != NULL);
+        fifo->head = old->next;
+        fifo->head_index = 0;
+        free(atomic_exchange_explicit(&fifo->spare, old,
+                                      memory_order_release));
+    }
+
+    block_t *block = fifo->head->slots[fifo->head_index++];
+
+    atomic_fetch_sub_explicit(&fifo->bytes, block->i_buffer,
+                              memory_order_relaxed);
+    atomic_fetch_sub_explicit(&fifo->depth, 1, memory_order_relaxed);
+    return block;
+}
+
+block_t *vlc_spsc_fifo_DequeueKillable(vlc_spsc_fifo_t *fifo)
+{
+    for (;;)
+    {
+        block_t *block = vlc_spsc_fifo_Dequeue(fifo);
+        if (block != NULL)
+            return block;
+
+        atomic_store(&fifo->sleeping, 1);
+        /* Check again: the producer may have missed the flag */
+        if (atomic_load(&fifo->depth) > 0)
+        {
+            atomic_store(&fifo->sleeping, 0);
+            continue;
+        }
+        if (atomic_load(&fifo->dead))
+        {
+            atomic_store(&fifo->sleeping, 0);
+            return NULL;
+        }
+        vlc_atomic_wait(&fifo->sleeping, 1);
+    }
+}
+
+void vlc_spsc_fifo_Kill(vlc_spsc_fifo_t *fifo)
+{
+    atomic_store(&fifo->dead, true);
+    vlc_spsc_fifo_Wake(fifo);
+}
+
+size_t vlc_spsc_fifo_GetCount(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->depth, memory_order_relaxed);
+}
+
+size_t vlc_spsc_fifo_GetBytes(const vlc_spsc_fifo_t *fifo)
+{
+    return atomic_load_explicit(&fifo->bytes, memory_order_relaxed);
+}
@@ -29,9 +29,13 @@
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
 #include <vlc_spu.h>
+#include <vlc_picture_pool.h>
 #include <libvlc.h>
 #include <assert.h>
 
+/* Number of recycled output pictures per intermediate filter */
+#define CHAINED_POOL_SIZE 3
+
 typedef struct chained_filter_t
 {
     /* Public part of the filter structure */
@@ -40,6 +44,17 @@ typedef struct chained_filter_t
     struct chained_filter_t *prev, *next;
     vlc_mouse_t *mouse;
     picture_t *pending;
+
+    /* Output pictures of intermediate filters, recycled across frames */
+    picture_pool_t *pool;
+    video_format_t pool_fmt;
+    bool pool_failed;
+
+    /* Statistics */
+    unsigned pictures_in;
+    unsigned pictures_pooled; /**< output pictures taken from the pool */
+    unsigned pictures_allocated; /**< output pictures allocated */
+    unsigned pictures_in_place; /**< input pictures returned as output */
 } chained_filter_t;
 
 /* */
@@ -95,6 +110,50 @@ filter_chain_t *filter_chain_NewSPU( vlc_object_t *obj, const char *cap )
     return filter_chain_NewInner( obj, cap, NULL, false, SPU_ES );
 }
 
+static bool FormatIsPoolCompatible( const video_format_t *a,
+                                    const video_format_t *b )
+{
+    return video_format_IsSimilar( a, b ) &&
+           a->primaries == b->primaries && a->transfer == b->transfer &&
+           a->space == b->space && a->color_range == b->color_range &&
+           a->chroma_location == b->chroma_location;
+}
+
+static void ChainedPoolRelease( chained_filter_t *chained )
+{
+    if( chained->pool != NULL )
+        picture_pool_Release( chained->pool );
+    chained->pool = NULL;
+    chained->pool_failed = false;
+}
+
+/**
+ * Gets an output picture for an intermediate filter from its pool, so that
+ * the pictures passed between filters are recycled instead of being allocated
+ * for every frame. Returns NULL if the pool is exhausted or cannot be used,
+ * the caller then allocates a picture instead.
+ */
+static picture_t *ChainedPoolGet( chained_filter_t *chained )
+{
+    const video_format_t *fmt = &chained->filter.fmt_out.video;
+
+    if( ( chained->pool != NULL || chained->pool_failed ) &&
+        !FormatIsPoolCompatible( &chained->pool_fmt, fmt ) )
+        ChainedPoolRelease( chained );
+
+    if( chained->pool == NULL && !chained->pool_failed )
+    {
+        chained->pool_fmt = *fmt;
+        chained->pool_fmt.p_palette = NULL;
+        /* Palettized and opaque formats cannot be pooled in system memory */
+        if( fmt->p_palette == NULL )
+            chained->pool = picture_pool_NewFromFormat( fmt, CHAINED_POOL_SIZE );
+        chained->pool_failed = chained->pool == NULL;
+    }
+
+    return chained->pool != NULL ? picture_pool_Get( chained->pool ) : NULL;
+}
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
@@ -102,6 +161,13 @@ static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
     chained_filter_t *chained = container_of(filter, chained_filter_t, filter);
     if( chained->next != NULL )
     {
+        pic = ChainedPoolGet( chained );
+        if( pic != NULL )
+        {
+            chained->pictures_pooled++;
+            return pic;
+        }
+
         // HACK as intermediate filters may not have the same video format as
         // the last one handled by the owner
         filter_owner_t saved_owner = filter->owner;
@@ -110,6 +176,8 @@ static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
         filter->owner = saved_owner;
         if( pic == NULL )
             msg_Err( filter, "Failed to allocate picture" );
+        else
+            chained->pictures_allocated++;
     }
     else
     {
@@ -121,6 +189,8 @@ static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
         filter->owner = chain->parent_video_owner;
         pic = filter_NewPicture( filter );
         filter->owner = saved_owner;
+        if( pic != NULL )
+            chained->pictures_allocated++;
     }
     return pic;
 }
@@ -275,6 +345,12 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
         vlc_mouse_Init( mouse );
     chained->mouse = mouse;
     chained->pending = NULL;
+    chained->pool = NULL;
+    chained->pool_failed = false;
+    chained->pictures_in = 0;
+    chained->pictures_pooled = 0;
+    chained->pictures_allocated = 0;
+    chained->pictures_in_place = 0;
 
     msg_Dbg( chain->obj, "Filter '%s' (%p) appended to chain",
              (name != NULL) ? name : module_get_name(filter->p_module, false),
@@ -330,8 +406,14 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
 
     module_unneed( filter, filter->p_module );
 
+    if( filter->fmt_in.i_cat == VIDEO_ES && chained->pictures_in > 0 )
+        msg_Dbg( chain->obj, "Filter %p processed %u pictures: %u in place, "
+                 "%u recycled and %u allocated outputs", (void *)filter,
+                 chained->pictures_in, chained->pictures_in_place,
+                 chained->pictures_pooled, chained->pictures_allocated );
     msg_Dbg( chain->obj, "Filter %p removed from chain", (void *)filter );
     FilterDeletePictures( chained->pending );
+    ChainedPoolRelease( chained );
 
     free( chained->mouse );
     es_format_Clean( &filter->fmt_out );
@@ -427,9 +509,14 @@ static picture_t *FilterChainVideoFilter( chained_filter_t *f, picture_t *p_pic
     for( ; f != NULL; f = f->next )
     {
         filter_t *p_filter = &f->filter;
+        picture_t *p_in = p_pic;
+
+        f->pictures_in++;
         p_pic = p_filter->pf_video_filter( p_filter, p_pic );
         if( !p_pic )
             break;
+        if( p_pic == p_in )
+            f->pictures_in_place++;
         if( f->pending )
         {
             msg_Warn( p_filter, "dropping pictures" );
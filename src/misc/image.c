@@ -175,6 +175,11 @@ static picture_t *ImageRead( image_handler_t *p_image, block_t *p_block,
         }
     }
 
+    /* Let the decoder downscale while decoding, if it can (e.g. JPEG) */
+    var_SetInteger( p_image->p_dec, "image-decode-width", p_fmt_out->i_width );
+    var_SetInteger( p_image->p_dec, "image-decode-height",
+                    p_fmt_out->i_height );
+
     p_block->i_pts = p_block->i_dts = vlc_tick_now();
     int ret = p_image->p_dec->pf_decode( p_image->p_dec, p_block );
     if( ret == VLCDEC_SUCCESS )
@@ -674,6 +679,8 @@ static decoder_t *CreateDecoder( image_handler_t *p_image, const es_format_t *fm
     p_owner->p_image = p_image;
 
     decoder_Init( p_dec, fmt );
+    var_Create( p_dec, "image-decode-width", VLC_VAR_INTEGER );
+    var_Create( p_dec, "image-decode-height", VLC_VAR_INTEGER );
 
     static const struct decoder_owner_callbacks dec_cbs =
     {
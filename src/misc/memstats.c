@@ -0,0 +1,263 @@
+/*****************************************************************************
+ * memstats.c: memory accounting
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+#include <vlc_memstats.h>
+#include "../libvlc.h"
+
+struct vlc_mem_account
+{
+    struct vlc_list node;
+    const void *owner;
+    char name[64];
+    atomic_size_t count;
+    atomic_size_t bytes;
+    atomic_size_t peak;
+};
+
+#define VLC_MEM_ACCOUNT_INITIALIZER(n) \
+    { VLC_LIST_INITIALIZER(NULL), NULL, n, \
+      ATOMIC_VAR_INIT(0), ATOMIC_VAR_INIT(0), ATOMIC_VAR_INIT(0) }
+
+/* Once enabled by an instance, the accounting remains enabled: the objects
+ * created meanwhile keep their accounts. */
+static atomic_bool vlc_mem_enabled = ATOMIC_VAR_INIT(false);
+
+static struct vlc_mem_account vlc_mem_core[VLC_MEM_CORE_COUNT] = {
+    [VLC_MEM_BLOCKS] = VLC_MEM_ACCOUNT_INITIALIZER("blocks"),
+    [VLC_MEM_PICTURES] = VLC_MEM_ACCOUNT_INITIALIZER("pictures"),
+};
+
+static _Atomic uint64_t vlc_mem_allocs[VLC_MEM_STAGE_COUNT];
+static thread_local enum vlc_mem_stage vlc_mem_stage = VLC_MEM_STAGE_OTHER;
+
+static const char *const vlc_mem_stage_names[VLC_MEM_STAGE_COUNT] = {
+    [VLC_MEM_STAGE_OTHER] = "other",
+    [VLC_MEM_STAGE_DEMUX] = "demux",
+    [VLC_MEM_STAGE_PACKETIZER] = "packetizer",
+    [VLC_MEM_STAGE_DECODER] = "decoder",
+    [VLC_MEM_STAGE_VOUT] = "video output",
+    [VLC_MEM_STAGE_AOUT] = "audio output",
+};
+
+static vlc_mutex_t vlc_mem_lock = VLC_STATIC_MUTEX;
+static struct vlc_list vlc_mem_accounts =
+    VLC_LIST_INITIALIZER(&vlc_mem_accounts);
+
+vlc_mem_account_t *vlc_mem_GetCoreAccount(enum vlc_mem_core_account type)
+{
+    assert(type < VLC_MEM_CORE_COUNT);
+    if (!atomic_load_explicit(&vlc_mem_enabled, memory_order_relaxed))
+        return NULL;
+    return &vlc_mem_core[type];
+}
+
+vlc_mem_account_t *(vlc_mem_account_New)(vlc_object_t *owner,
+                                         const char *name)
+{
+    if (!atomic_load_explicit(&vlc_mem_enabled, memory_order_relaxed))
+        return NULL;
+
+    vlc_mem_account_t *account = malloc(sizeof (*account));
+    if (unlikely(account == NULL))
+        return NULL;
+
+    account->owner = owner;
+    snprintf(account->name, sizeof (account->name), "%s %s",
+             vlc_object_typename(owner), name);
+    atomic_init(&account->count, 0);
+    atomic_init(&account->bytes, 0);
+    atomic_init(&account->peak, 0);
+
+    vlc_mutex_lock(&vlc_mem_lock);
+    vlc_list_append(&account->node, &vlc_mem_accounts);
+    vlc_mutex_unlock(&vlc_mem_lock);
+    return account;
+}
+
+void vlc_mem_account_Delete(vlc_mem_account_t *account)
+{
+    if (account == NULL)
+        return;
+
+    vlc_mutex_lock(&vlc_mem_lock);
+    vlc_list_remove(&account->node);
+    vlc_mutex_unlock(&vlc_mem_lock);
+    free(account);
+}
+
+void vlc_mem_account_Add(vlc_mem_account_t *account, size_t count,
+                         size_t bytes)
+{
+    if (account == NULL)
+        return;
+
+    atomic_fetch_add_explicit(&account->count, count, memory_order_relaxed);
+
+    size_t size = atomic_fetch_add_explicit(&account->bytes, bytes,
+                                            memory_order_relaxed) + bytes;
+    size_t peak = atomic_load_explicit(&account->peak, memory_order_relaxed);
+
+    while (size > peak
+        && !atomic_compare_exchange_weak_explicit(&account->peak, &peak, size,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
+
+void vlc_mem_account_Sub(vlc_mem_account_t *account, size_t count,
+                         size_t bytes)
+{
+    if (account == NULL)
+        return;
+
+    atomic_fetch_sub_explicit(&account->count, count, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&account->bytes, bytes, memory_order_relaxed);
+}
+
+enum vlc_mem_stage vlc_mem_SetStage(enum vlc_mem_stage stage)
+{
+    enum vlc_mem_stage prev = vlc_mem_stage;
+
+    assert(stage < VLC_MEM_STAGE_COUNT);
+    vlc_mem_stage = stage;
+    return prev;
+}
+
+void vlc_mem_CountAllocation(void)
+{
+    if (!atomic_load_explicit(&vlc_mem_enabled, memory_order_relaxed))
+        return;
+    atomic_fetch_add_explicit(&vlc_mem_allocs[vlc_mem_stage], 1,
+                              memory_order_relaxed);
+}
+
+void vlc_mem_GetAllocations(uint64_t tab[VLC_MEM_STAGE_COUNT])
+{
+    for (size_t i = 0; i < VLC_MEM_STAGE_COUNT; i++)
+        tab[i] = atomic_load_explicit(&vlc_mem_allocs[i],
+                                      memory_order_relaxed);
+}
+
+static void vlc_mem_GetAccountUsage(const vlc_mem_account_t *account,
+                                    struct vlc_mem_usage *usage)
+{
+    strcpy(usage->name, account->name);
+    usage->owner = account->owner;
+    usage->count = atomic_load_explicit(&account->count,
+                                        memory_order_relaxed);
+    usage->bytes = atomic_load_explicit(&account->bytes,
+                                        memory_order_relaxed);
+    usage->peak = atomic_load_explicit(&account->peak, memory_order_relaxed);
+}
+
+size_t vlc_mem_GetUsage(struct vlc_mem_usage *tab, size_t max)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < VLC_MEM_CORE_COUNT; i++, n++)
+        if (n < max)
+            vlc_mem_GetAccountUsage(&vlc_mem_core[i], &tab[n]);
+
+    vlc_mutex_lock(&vlc_mem_lock);
+    vlc_mem_account_t *account;
+    vlc_list_foreach(account, &vlc_mem_accounts, node)
+    {
+        if (n < max)
+            vlc_mem_GetAccountUsage(account, &tab[n]);
+        n++;
+    }
+    vlc_mutex_unlock(&vlc_mem_lock);
+    return n;
+}
+
+static void vlc_mem_Report(libvlc_int_t *libvlc)
+{
+    struct vlc_mem_usage tab[64];
+    size_t count = vlc_mem_GetUsage(tab, ARRAY_SIZE(tab));
+    uint64_t allocs[VLC_MEM_STAGE_COUNT];
+
+    vlc_mem_GetAllocations(allocs);
+    for (size_t i = 0; i < VLC_MEM_STAGE_COUNT; i++)
+        if (allocs[i] > 0)
+            msg_Info(libvlc, "memory: %s stage: %"PRIu64" allocations",
+                     vlc_mem_stage_names[i], allocs[i]);
+
+    for (size_t i = 0; i < __MIN(count, ARRAY_SIZE(tab)); i++)
+    {
+        const struct vlc_mem_usage *u = &tab[i];
+
+        /* Skip the accounts that never held anything */
+        if (u->peak == 0)
+            continue;
+        msg_Info(libvlc, "memory: %s (%p): %zu allocations, %zu KiB, "
+                 "peak %zu KiB", u->name, u->owner, u->count,
+                 u->bytes >> 10, u->peak >> 10);
+    }
+    if (count > ARRAY_SIZE(tab))
+        msg_Info(libvlc, "memory: %zu more accounts",
+                 count - ARRAY_SIZE(tab));
+}
+
+static void vlc_mem_Timer(void *data)
+{
+    vlc_mem_Report(data);
+}
+
+int vlc_mem_stats_Init(libvlc_int_t *libvlc)
+{
+    libvlc_priv_t *priv = libvlc_priv(libvlc);
+    vlc_tick_t period =
+        VLC_TICK_FROM_SEC(var_InheritInteger(libvlc, "mem-stats"));
+
+    priv->mem_stats_enabled = period > 0;
+    if (!priv->mem_stats_enabled)
+        return VLC_SUCCESS;
+
+    atomic_store_explicit(&vlc_mem_enabled, true, memory_order_relaxed);
+
+    if (vlc_timer_create(&priv->mem_stats_timer, vlc_mem_Timer, libvlc))
+    {
+        priv->mem_stats_enabled = false;
+        return VLC_ENOMEM;
+    }
+    vlc_timer_schedule(priv->mem_stats_timer, false, period, period);
+    return VLC_SUCCESS;
+}
+
+void vlc_mem_stats_Deinit(libvlc_int_t *libvlc)
+{
+    libvlc_priv_t *priv = libvlc_priv(libvlc);
+
+    if (!priv->mem_stats_enabled)
+        return;
+
+    vlc_timer_destroy(priv->mem_stats_timer);
+    vlc_mem_Report(libvlc);
+}
@@ -33,6 +33,8 @@
 
 #include <stdlib.h>
 #include <stdarg.h>                                       /* va_list for BSD */
+#include <stdatomic.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <assert.h>
 
@@ -439,6 +441,253 @@ static struct vlc_logger *vlc_LogModuleCreate(vlc_object_t *parent)
     return &module->frontend;
 }
 
+/**
+ * Asynchronous message log.
+ *
+ * Messages are formatted by the calling thread, then queued in a bounded
+ * lock-free ring buffer. A dedicated thread passes them to the backend, so
+ * that slow logging (e.g. to a file) does not block the decoders and outputs.
+ * Messages are dropped and counted if the ring buffer is full.
+ */
+#define LOG_ASYNC_SIZE 4096 /* must be a power of two */
+
+struct vlc_log_record {
+    int type;
+    vlc_log_t meta;
+    char msg[]; /* followed by the module name and the header */
+};
+
+struct vlc_log_slot {
+    atomic_size_t seq;
+    struct vlc_log_record *record;
+};
+
+struct vlc_logger_async {
+    struct vlc_logger frontend;
+    struct vlc_logger *backend;
+    int verbosity;
+    vlc_thread_t thread;
+    atomic_bool stop;
+    atomic_uint sleeping;
+    atomic_size_t enqueue_pos;
+    size_t dequeue_pos;
+    atomic_size_t dropped;
+    struct vlc_log_slot slots[LOG_ASYNC_SIZE];
+};
+
+static void vlc_LogAsyncWake(struct vlc_logger_async *async)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&async->sleeping, memory_order_relaxed)
+     && atomic_exchange_explicit(&async->sleeping, 0, memory_order_relaxed))
+        vlc_atomic_notify_one(&async->sleeping);
+}
+
+static void vlc_vaLogAsync(void *d, int type, const vlc_log_t *item,
+                           const char *format, va_list ap)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+
+    if (async->verbosity < type)
+        return;
+
+    char buf[256];
+    va_list aq;
+
+    va_copy(aq, ap);
+    int len = vsnprintf(buf, sizeof (buf), format, aq);
+    va_end(aq);
+    if (len < 0)
+        return;
+
+    size_t modlen = strlen(item->psz_module) + 1;
+    size_t headlen = (item->psz_header != NULL)
+                   ? strlen(item->psz_header) + 1 : 0;
+    struct vlc_log_record *rec = malloc(sizeof (*rec) + len + 1 + modlen
+                                        + headlen);
+    if (unlikely(rec == NULL))
+        goto drop;
+
+    if ((size_t)len < sizeof (buf))
+        memcpy(rec->msg, buf, len + 1);
+    else
+        vsnprintf(rec->msg, len + 1, format, ap);
+
+    rec->type = type;
+    rec->meta = *item;
+    rec->meta.psz_module = memcpy(rec->msg + len + 1, item->psz_module,
+                                  modlen);
+    if (headlen > 0)
+        rec->meta.psz_header = memcpy(rec->msg + len + 1 + modlen,
+                                      item->psz_header, headlen);
+
+    /* Bounded multiple producers queue, see D. Vyukov's MPMC queue */
+    size_t pos = atomic_load_explicit(&async->enqueue_pos,
+                                      memory_order_relaxed);
+    for (;;)
+    {
+        struct vlc_log_slot *slot = &async->slots[pos & (LOG_ASYNC_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&async->enqueue_pos,
+                                                      &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                slot->record = rec;
+                atomic_store_explicit(&slot->seq, pos + 1,
+                                      memory_order_release);
+                vlc_LogAsyncWake(async);
+                return;
+            }
+        }
+        else if (diff < 0)
+        {   /* full */
+            free(rec);
+            goto drop;
+        }
+        else
+            pos = atomic_load_explicit(&async->enqueue_pos,
+                                       memory_order_relaxed);
+    }
+
+drop:
+    atomic_fetch_add_explicit(&async->dropped, 1, memory_order_relaxed);
+}
+
+static struct vlc_log_record *vlc_LogAsyncPop(struct vlc_logger_async *async)
+{
+    size_t pos = async->dequeue_pos;
+    struct vlc_log_slot *slot = &async->slots[pos & (LOG_ASYNC_SIZE - 1)];
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1)
+        return NULL;
+
+    struct vlc_log_record *rec = slot->record;
+    atomic_store_explicit(&slot->seq, pos + LOG_ASYNC_SIZE,
+                          memory_order_release);
+    async->dequeue_pos = pos + 1;
+    return rec;
+}
+
+static void vlc_LogAsyncDrain(struct vlc_logger_async *async)
+{
+    struct vlc_log_record *rec;
+
+    while ((rec = vlc_LogAsyncPop(async)) != NULL)
+    {
+        vlc_LogCallback(async->backend, rec->type, &rec->meta, "%s",
+                        rec->msg);
+        free(rec);
+    }
+
+    size_t dropped = atomic_exchange_explicit(&async->dropped, 0,
+                                              memory_order_relaxed);
+    if (dropped > 0)
+    {
+        vlc_log_t meta = {
+            .i_object_id = (uintptr_t)(void *)async,
+            .psz_object_type = "logger",
+            .psz_module = "main",
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .tid = vlc_thread_id(),
+        };
+        vlc_LogCallback(async->backend, VLC_MSG_WARN, &meta,
+                        "%zu log messages dropped", dropped);
+    }
+}
+
+static void *vlc_LogAsyncThread(void *data)
+{
+    struct vlc_logger_async *async = data;
+
+    for (;;)
+    {
+        vlc_LogAsyncDrain(async);
+
+        atomic_store_explicit(&async->sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        /* check again, a message may have been queued meanwhile */
+        size_t pos = async->dequeue_pos;
+        struct vlc_log_slot *slot = &async->slots[pos & (LOG_ASYNC_SIZE - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1)
+        {
+            atomic_store_explicit(&async->sleeping, 0, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_load(&async->stop))
+            break;
+        vlc_atomic_wait(&async->sleeping, 1);
+    }
+
+    vlc_LogAsyncDrain(async);
+    return NULL;
+}
+
+static void vlc_LogAsyncClose(void *d)
+{
+    struct vlc_logger *logger = d;
+    struct vlc_logger_async *async =
+        container_of(logger, struct vlc_logger_async, frontend);
+    struct vlc_logger *backend = async->backend;
+
+    atomic_store(&async->stop, true);
+    atomic_store_explicit(&async->sleeping, 0, memory_order_relaxed);
+    vlc_atomic_notify_one(&async->sleeping);
+    vlc_join(async->thread, NULL);
+
+    backend->ops->destroy(backend);
+    free(async);
+}
+
+static const struct vlc_logger_operations async_ops = {
+    vlc_vaLogAsync,
+    vlc_LogAsyncClose,
+};
+
+static struct vlc_logger *vlc_LogAsyncCreate(vlc_object_t *obj,
+                                             struct vlc_logger *backend)
+{
+    struct vlc_logger_async *async = malloc(sizeof (*async));
+    if (unlikely(async == NULL))
+        return NULL;
+
+    /* Do not format the messages that the backend would not show anyway */
+    const char *str = getenv("VLC_VERBOSE");
+    int verbosity = (str != NULL) ? atoi(str)
+                                  : var_InheritInteger(obj, "verbose");
+    if (verbosity < 0)
+        verbosity = 0;
+
+    async->frontend.ops = &async_ops;
+    async->backend = backend;
+    async->verbosity = VLC_MSG_ERR + verbosity;
+    atomic_init(&async->stop, false);
+    atomic_init(&async->sleeping, 0);
+    atomic_init(&async->enqueue_pos, 0);
+    async->dequeue_pos = 0;
+    atomic_init(&async->dropped, 0);
+    for (size_t i = 0; i < LOG_ASYNC_SIZE; i++)
+        atomic_init(&async->slots[i].seq, i);
+
+    if (vlc_clone(&async->thread, vlc_LogAsyncThread, async,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        free(async);
+        return NULL;
+    }
+    return &async->frontend;
+}
+
 /**
  * Initializes the messages logging subsystem and drain the early messages to
  * the configured log.
@@ -448,6 +697,12 @@ void vlc_LogInit(libvlc_int_t *vlc)
     struct vlc_logger *logger = vlc_LogModuleCreate(VLC_OBJECT(vlc));
     if (logger == NULL)
         logger = &discard_log;
+    else if (var_InheritBool(vlc, "log-async"))
+    {
+        struct vlc_logger *async = vlc_LogAsyncCreate(VLC_OBJECT(vlc), logger);
+        if (async != NULL)
+            logger = async;
+    }
 
     vlc_LogSwitch(vlc->obj.logger, logger);
 }
@@ -67,7 +67,10 @@ int vlc_object_init(vlc_object_t *restrict obj, vlc_object_t *parent,
 
     priv->parent = parent;
     priv->typename = typename;
-    priv->var_root = NULL;
+    priv->var_table = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
+    priv->var_inherit = NULL;
     vlc_mutex_init (&priv->var_lock);
     vlc_cond_init (&priv->var_wait);
     priv->resources = NULL;
@@ -37,6 +37,8 @@
 #include "picture.h"
 #include <vlc_image.h>
 #include <vlc_block.h>
+#include <vlc_memstats.h>
+#include "libvlc.h"
 
 static void PictureDestroyContext( picture_t *p_picture )
 {
@@ -71,6 +73,20 @@ static void picture_DestroyFromFormat(picture_t *pic)
         picture_Deallocate(res->fd, res->base, res->size);
 }
 
+/**
+ * Destroys a picture allocated with picture_NewFromFormat() while the memory
+ * accounting was enabled.
+ */
+static void picture_DestroyFromFormatAccounted(picture_t *pic)
+{
+    picture_buffer_t *res = pic->p_sys;
+
+    if (res != NULL)
+        vlc_mem_account_Sub(vlc_mem_GetCoreAccount(VLC_MEM_PICTURES), 1,
+                            res->size);
+    picture_DestroyFromFormat(pic);
+}
+
 VLC_WEAK void *picture_Allocate(int *restrict fdp, size_t size)
 {
     assert((size % 64) == 0);
@@ -212,6 +228,7 @@ static bool picture_InitPrivate(const video_format_t *restrict p_fmt,
 
     atomic_init(&p_picture->refs, 1);
     priv->gc.opaque = NULL;
+    priv->gc.external = false;
 
     p_picture->p_sys = p_resource->p_sys;
 
@@ -223,19 +240,12 @@ static bool picture_InitPrivate(const video_format_t *restrict p_fmt,
     return true;
 }
 
-picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_resource_t *p_resource )
+static bool picture_InitFromResource(const video_format_t *restrict p_fmt,
+                                     picture_priv_t *priv,
+                                     const picture_resource_t *p_resource)
 {
-    assert(p_resource != NULL);
-
-    picture_priv_t *priv = malloc(sizeof(*priv));
-    if (unlikely(priv == NULL))
-        return NULL;
-
     if (!picture_InitPrivate(p_fmt, priv, p_resource))
-    {
-        free(priv);
-        return NULL;
-    }
+        return false;
 
     picture_t *p_picture = &priv->picture;
 
@@ -245,8 +255,24 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
         p_picture->p[i].i_lines  = p_resource->p[i].i_lines;
         p_picture->p[i].i_pitch  = p_resource->p[i].i_pitch;
     }
+    return true;
+}
 
-    return p_picture;
+picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_resource_t *p_resource )
+{
+    assert(p_resource != NULL);
+
+    vlc_mem_CountAllocation();
+    picture_priv_t *priv = malloc(sizeof(*priv));
+    if (unlikely(priv == NULL))
+        return NULL;
+
+    if (!picture_InitFromResource(p_fmt, priv, p_resource))
+    {
+        free(priv);
+        return NULL;
+    }
+    return &priv->picture;
 }
 
 #define PICTURE_SW_SIZE_MAX (UINT32_C(1) << 28) /* 256MB: 8K * 8K * 4*/
@@ -261,15 +287,18 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
     static_assert(offsetof(struct picture_priv_buffer_t, priv)==0,
                   "misplaced picture_priv_t, destroy won't work");
 
+    vlc_mem_CountAllocation();
     struct picture_priv_buffer_t *privbuf = malloc(sizeof(*privbuf));
     if (unlikely(privbuf == NULL))
         return NULL;
 
     picture_buffer_t *res = &privbuf->res;
+    vlc_mem_account_t *account = vlc_mem_GetCoreAccount(VLC_MEM_PICTURES);
 
     picture_resource_t pic_res = {
         .p_sys = res,
-        .pf_destroy = picture_DestroyFromFormat,
+        .pf_destroy = (account != NULL) ? picture_DestroyFromFormatAccounted
+                                        : picture_DestroyFromFormat,
     };
 
     picture_priv_t *priv = &privbuf->priv;
@@ -306,6 +335,7 @@ picture_t *picture_NewFromFormat(const video_format_t *restrict fmt)
     res->base = buf;
     res->size = pic_size;
     res->offset = 0;
+    vlc_mem_account_Add(account, 1, pic_size);
 
     /* Fill the p_pixels field for each plane */
     for (int i = 0; i < pic->i_planes; i++)
@@ -344,9 +374,12 @@ void picture_Destroy(picture_t *picture)
     PictureDestroyContext(picture);
 
     picture_priv_t *priv = container_of(picture, picture_priv_t, picture);
+    bool external = priv->gc.external;
+
     assert(priv->gc.destroy != NULL);
     priv->gc.destroy(picture);
-    free(priv);
+    if (!external)
+        free(priv);
 }
 
 /*****************************************************************************
@@ -423,6 +456,16 @@ static void picture_DestroyClone(picture_t *clone)
     picture_Release(picture);
 }
 
+static void picture_CloneResource(const picture_t *picture,
+                                  picture_resource_t *res)
+{
+    for (int i = 0; i < picture->i_planes; i++) {
+        res->p[i].p_pixels = picture->p[i].p_pixels;
+        res->p[i].i_lines = picture->p[i].i_lines;
+        res->p[i].i_pitch = picture->p[i].i_pitch;
+    }
+}
+
 picture_t *picture_InternalClone(picture_t *picture,
                                  void (*pf_destroy)(picture_t *), void *opaque)
 {
@@ -431,11 +474,7 @@ picture_t *picture_InternalClone(picture_t *picture,
         .pf_destroy = pf_destroy,
     };
 
-    for (int i = 0; i < picture->i_planes; i++) {
-        res.p[i].p_pixels = picture->p[i].p_pixels;
-        res.p[i].i_lines = picture->p[i].i_lines;
-        res.p[i].i_pitch = picture->p[i].i_pitch;
-    }
+    picture_CloneResource(picture, &res);
 
     picture_t *clone = picture_NewFromResource(&picture->format, &res);
     if (likely(clone != NULL)) {
@@ -445,6 +484,25 @@ picture_t *picture_InternalClone(picture_t *picture,
     return clone;
 }
 
+bool picture_InternalCloneInit(picture_priv_t *clone, picture_t *picture,
+                               void (*pf_destroy)(picture_t *), void *opaque)
+{
+    picture_resource_t res = {
+        .p_sys = picture->p_sys,
+        .pf_destroy = pf_destroy,
+    };
+
+    picture_CloneResource(picture, &res);
+
+    if (!picture_InitFromResource(&picture->format, clone, &res))
+        return false;
+
+    clone->gc.opaque = opaque;
+    clone->gc.external = true;
+    picture_Hold(picture);
+    return true;
+}
+
 picture_t *picture_Clone(picture_t *picture)
 {
     picture_t *clone = picture_InternalClone(picture, picture_DestroyClone, picture);
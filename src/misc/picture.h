@@ -30,6 +30,7 @@ typedef struct
     {
         void (*destroy)(picture_t *);
         void *opaque;
+        bool external; /* storage owned by the creator, not freed */
     } gc;
 } picture_priv_t;
 
@@ -37,3 +38,11 @@ void *picture_Allocate(int *, size_t);
 void picture_Deallocate(int, void *, size_t);
 
 picture_t * picture_InternalClone(picture_t *, void (*pf_destroy)(picture_t *), void *);
+
+/**
+ * Initializes a clone in storage provided by the caller, which is not freed
+ * when the clone is destroyed. The destroy callback is the last access to
+ * the storage, which can then be reused.
+ */
+bool picture_InternalCloneInit(picture_priv_t *, picture_t *,
+                               void (*pf_destroy)(picture_t *), void *);
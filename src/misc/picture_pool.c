@@ -34,19 +34,31 @@
 #include <vlc_picture_pool.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
+#define POOL_WORD_BITS (CHAR_BIT * sizeof (unsigned long long))
+#define POOL_MAX USHRT_MAX
 
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+struct picture_pool_slot {
+    picture_pool_t *pool;
+    picture_t      *picture;
+    picture_priv_t  clone; /* handed out while the slot is taken */
+};
 
+/*
+ * Free pictures are tracked by a bitmap of atomic words, so that getting and
+ * releasing pictures is lock-free. The mutex and condition variable are only
+ * used by picture_pool_Wait() when no pictures are available.
+ */
 struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
+    atomic_bool        canceled;
+    atomic_uint        waiters;
     atomic_ushort      refs;
     unsigned short     picture_count;
-    picture_t  *picture[];
+    unsigned short     word_count;
+    _Atomic unsigned long long *available;
+    struct picture_pool_slot slots[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -55,31 +67,39 @@ static void picture_pool_Destroy(picture_pool_t *pool)
         return;
 
     atomic_thread_fence(memory_order_acquire);
-    aligned_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slots[i].picture);
     picture_pool_Destroy(pool);
 }
 
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+    unsigned offset = slot - pool->slots;
+    unsigned long long bit = 1ULL << (offset % POOL_WORD_BITS);
 
-    picture_Release(picture);
+    picture_Release(slot->picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    unsigned long long prev = atomic_fetch_or(
+                                &pool->available[offset / POOL_WORD_BITS], bit);
+    assert(!(prev & bit));
+    (void) prev;
+
+    /* This pairs with the increment in picture_pool_Wait(): either the waiter
+     * sees the picture, or the waiter count is seen here. */
+    if (atomic_load(&pool->waiters) > 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
 
     picture_pool_Destroy(pool);
 }
@@ -87,11 +107,14 @@ static void picture_pool_ReleasePicture(picture_t *clone)
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
+    struct picture_pool_slot *slot = &pool->slots[offset];
 
-    return picture_InternalClone(picture, picture_pool_ReleasePicture,
-                                 (void*)sys);
+    /* The clone lives in the slot, so that taking a picture does not
+     * allocate: it is not freed when released. */
+    if (!picture_InternalCloneInit(&slot->clone, slot->picture,
+                                   picture_pool_ReleasePicture, slot))
+        return NULL;
+    return &slot->clone.picture;
 }
 
 picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
@@ -100,23 +123,36 @@ picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
         return NULL;
 
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + count * sizeof (picture_t *);
+    unsigned words = (count + POOL_WORD_BITS - 1) / POOL_WORD_BITS;
+    size_t size = sizeof (*pool) + count * sizeof (pool->slots[0]);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    size += (-size) & (sizeof (unsigned long long) - 1);
+    pool = malloc(size + words * sizeof (*pool->available));
     if (unlikely(pool == NULL))
         return NULL;
 
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << count) - 1;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
     pool->picture_count = count;
-    memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
+    pool->word_count = words;
+    pool->available = (void *)(((char *)pool) + size);
+
+    for (unsigned i = 0; i < words; i++)
+    {
+        unsigned bits = count - i * POOL_WORD_BITS;
+
+        atomic_init(&pool->available[i], (bits >= POOL_WORD_BITS)
+                                         ? ~0ULL : (1ULL << bits) - 1);
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        pool->slots[i].pool = pool;
+        pool->slots[i].picture = tab[i];
+    }
     return pool;
 }
 
@@ -167,70 +203,89 @@ error:
     return NULL;
 }
 
-picture_t *picture_pool_Get(picture_pool_t *pool)
+/**
+ * Takes a free picture slot, if any, without locking.
+ * \return the slot offset, or -1 if none is available.
+ */
+static int picture_pool_TakeSlot(picture_pool_t *pool)
 {
-    unsigned long long available;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
-
-    while (available != 0)
+    for (unsigned w = 0; w < pool->word_count; w++)
     {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
-            break;
+        unsigned long long available =
+            atomic_load_explicit(&pool->available[w], memory_order_relaxed);
 
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
+        while (available != 0)
+        {
+            int i = ctz(available);
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+            if (atomic_compare_exchange_weak_explicit(&pool->available[w],
+                    &available, available & ~(1ULL << i),
+                    memory_order_acquire, memory_order_relaxed))
+                return w * POOL_WORD_BITS + i;
         }
-        return clone;
     }
+    return -1;
+}
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+static picture_t *picture_pool_GetSlot(picture_pool_t *pool, int i)
+{
+    picture_t *clone = picture_pool_ClonePicture(pool, i);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    }
+    return clone;
+}
+
+picture_t *picture_pool_Get(picture_pool_t *pool)
+{
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
+
+    if (unlikely(atomic_load_explicit(&pool->canceled, memory_order_relaxed)))
+        return NULL;
+
+    int i = picture_pool_TakeSlot(pool);
+    if (i < 0)
+        return NULL;
+    return picture_pool_GetSlot(pool, i);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
+    int i;
+
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
+
+    /* Cancellation only interrupts waiting, not taking a free picture */
+    i = picture_pool_TakeSlot(pool);
+    if (i >= 0)
+        return picture_pool_GetSlot(pool, i);
+
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    atomic_fetch_add(&pool->waiters, 1);
+    atomic_thread_fence(memory_order_seq_cst);
 
-    while (pool->available == 0)
+    while ((i = picture_pool_TakeSlot(pool)) < 0)
     {
-        if (pool->canceled)
-        {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
-        }
+        if (atomic_load_explicit(&pool->canceled, memory_order_relaxed))
+            break;
         vlc_cond_wait(&pool->wait, &pool->lock);
     }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
+    atomic_fetch_sub(&pool->waiters, 1);
     vlc_mutex_unlock(&pool->lock);
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-    }
-    return clone;
+    if (i < 0)
+        return NULL;
+    return picture_pool_GetSlot(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    vlc_mutex_lock(&pool->lock);
+    atomic_store_explicit(&pool->canceled, canceled, memory_order_relaxed);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
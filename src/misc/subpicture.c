@@ -33,6 +33,7 @@
 #include <vlc_image.h>
 #include <vlc_subpicture.h>
 #include "subpicture.h"
+#include "../libvlc.h"
 
 struct subpicture_private_t
 {
@@ -42,6 +43,7 @@ struct subpicture_private_t
 
 subpicture_t *subpicture_New( const subpicture_updater_t *p_upd )
 {
+    vlc_mem_CountAllocation();
     subpicture_t *p_subpic = calloc( 1, sizeof(*p_subpic) );
     if( !p_subpic )
         return NULL;
@@ -191,6 +193,9 @@ subpicture_region_private_t *subpicture_region_private_New( video_format_t *p_fm
     }
 
     p_private->p_picture = NULL;
+    p_private->p_source = NULL;
+    p_private->place.valid = false;
+    p_private->place.crop_valid = false;
     return p_private;
 }
 
@@ -198,6 +203,8 @@ void subpicture_region_private_Delete( subpicture_region_private_t *p_private )
 {
     if( p_private->p_picture )
         picture_Release( p_private->p_picture );
+    if( p_private->p_source )
+        picture_Release( p_private->p_source );
     video_format_Clean( &p_private->fmt );
     free( p_private );
 }
@@ -258,6 +265,19 @@ subpicture_region_t *subpicture_region_New( const video_format_t *p_fmt )
     return p_region;
 }
 
+subpicture_region_t *subpicture_region_ForPicture( picture_t *p_picture )
+{
+    assert( p_picture->format.i_chroma != VLC_CODEC_YUVP );
+
+    subpicture_region_t *p_region =
+        subpicture_region_NewInternal( &p_picture->format );
+    if( !p_region )
+        return NULL;
+
+    p_region->p_picture = picture_Hold( p_picture );
+    return p_region;
+}
+
 void subpicture_region_Delete( subpicture_region_t *p_region )
 {
     if( !p_region )
@@ -20,9 +20,45 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+/* Everything the placement of a region depends on, besides the region
+ * picture itself. Only ints, so that it can be compared with memcmp(). */
+typedef struct {
+    int generation;     /* spu layout settings generation */
+    int dst_width;      /* output visible size */
+    int dst_height;
+    int scale_w;
+    int scale_h;
+    int x;              /* region position and alignment */
+    int y;
+    int align;
+    int order;          /* channel order */
+    int width;          /* region visible size */
+    int height;
+    int max_width;
+    int max_height;
+    int orig_width;     /* subpicture original picture size */
+    int orig_height;
+    int absolute;
+} subpicture_region_place_key_t;
+
 struct subpicture_region_private_t {
     video_format_t fmt;
-    picture_t      *p_picture;
+    picture_t      *p_picture;     /* scaled/converted picture, or NULL */
+    picture_t      *p_source;      /* picture p_picture was created from */
+
+    /* Last placement of the region, reused while its key is unchanged */
+    struct {
+        bool valid;
+        subpicture_region_place_key_t key;
+        int area_x, area_y, area_width, area_height;
+        int x_offset, y_offset;
+
+        /* Cropping also depends on the size of the picture to blend */
+        bool     crop_valid;
+        unsigned picture_width, picture_height;
+        unsigned fmt_x_offset, fmt_y_offset, fmt_width, fmt_height;
+        int      crop_x_offset, crop_y_offset;
+    } place;
 };
 
 subpicture_region_t * subpicture_region_NewInternal( const video_format_t *p_fmt );
@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * tracer.c: tracing interface
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_tracer.h>
+#include "../libvlc.h"
+
+struct vlc_tracer
+{
+    struct vlc_object_t obj;
+    const struct vlc_tracer_operations *ops;
+    void *sys;
+};
+
+static int vlc_tracer_load(void *func, bool forced, va_list ap)
+{
+    const struct vlc_tracer_operations *(*activate)(vlc_object_t *,
+                                                    void **) = func;
+    struct vlc_tracer *tracer = va_arg(ap, struct vlc_tracer *);
+
+    (void) forced;
+    tracer->ops = activate(VLC_OBJECT(tracer), &tracer->sys);
+    return (tracer->ops != NULL) ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+struct vlc_tracer *vlc_tracer_Create(vlc_object_t *parent)
+{
+    char *name = var_InheritString(parent, "tracer");
+    if (name == NULL)
+        return NULL; /* tracing disabled */
+
+    struct vlc_tracer *tracer = vlc_custom_create(parent, sizeof (*tracer),
+                                                  "tracer");
+    if (likely(tracer != NULL)
+     && vlc_module_load(VLC_OBJECT(tracer), "tracer", name, true,
+                        vlc_tracer_load, tracer) == NULL)
+    {
+        vlc_object_delete(VLC_OBJECT(tracer));
+        tracer = NULL;
+    }
+    free(name);
+    return tracer;
+}
+
+void vlc_tracer_Destroy(struct vlc_tracer *tracer)
+{
+    if (tracer->ops->destroy != NULL)
+        tracer->ops->destroy(tracer->sys);
+    vlc_object_delete(VLC_OBJECT(tracer));
+}
+
+struct vlc_tracer *(vlc_object_get_tracer)(vlc_object_t *obj)
+{
+    return libvlc_priv(vlc_object_instance(obj))->tracer;
+}
+
+void vlc_tracer_Emit(struct vlc_tracer *tracer,
+                     struct vlc_trace_event *event)
+{
+    event->thread = vlc_thread_id();
+    tracer->ops->trace(tracer->sys, event);
+}
@@ -27,13 +27,11 @@
 # include "config.h"
 #endif
 
-#ifdef HAVE_SEARCH_H
-# include <search.h>
-#endif
 #include <assert.h>
 #include <float.h>
 #include <math.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include <vlc_common.h>
 #include <vlc_arrays.h>
@@ -67,7 +65,8 @@ typedef struct variable_ops_t
  */
 struct variable_t
 {
-    char *       psz_name; /**< The variable unique name (must be first) */
+    char *       psz_name; /**< The variable unique name */
+    uint32_t     i_hash;   /**< Hash of the name */
 
     /** The variable's exported value */
     vlc_value_t  val;
@@ -136,23 +135,222 @@ int_ops    = { CmpInt,     DupDummy,  FreeDummy,  },
 string_ops = { CmpString,  DupString, FreeString, },
 coords_ops = { NULL,       DupDummy,  FreeDummy,  };
 
-static int varcmp( const void *a, const void *b )
+/*
+ * Variables are kept in a per-object open-addressing hash table with linear
+ * probing, at most half full. The name hash is stored in each variable so
+ * that probing only compares strings when the full hashes match.
+ */
+#define VAR_TABLE_MIN 16
+
+static uint32_t HashName( const char *psz_name )
 {
-    const variable_t *va = a, *vb = b;
+    uint32_t hash = 2166136261u; /* FNV-1a */
 
-    /* psz_name must be first */
-    assert( va == (const void *)&va->psz_name );
-    return strcmp( va->psz_name, vb->psz_name );
+    while( *psz_name )
+    {
+        hash ^= (unsigned char)*(psz_name++);
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
-static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+/**
+ * Finds the slot of a variable, or the free slot where it would be inserted.
+ * The table must have been allocated.
+ */
+static variable_t **LookupSlot( vlc_object_internals_t *priv,
+                                const char *psz_name, uint32_t hash )
+{
+    const size_t mask = priv->var_mask;
+
+    for( size_t i = hash & mask;; i = (i + 1) & mask )
+    {
+        variable_t *var = priv->var_table[i];
+
+        if( var == NULL
+         || (var->i_hash == hash && !strcmp( var->psz_name, psz_name )) )
+            return &priv->var_table[i];
+    }
+}
+
+static variable_t *LookupHash( vlc_object_t *obj, const char *psz_name,
+                               uint32_t hash )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
-    void **pp_var;
 
     vlc_mutex_lock(&priv->var_lock);
-    pp_var = tfind( &psz_name, &priv->var_root, varcmp );
-    return (pp_var != NULL) ? *pp_var : NULL;
+    if( priv->var_count == 0 )
+        return NULL;
+    return *LookupSlot( priv, psz_name, hash );
+}
+
+static variable_t *Lookup( vlc_object_t *obj, const char *psz_name )
+{
+    return LookupHash( obj, psz_name, HashName( psz_name ) );
+}
+
+static int GrowTable( vlc_object_internals_t *priv )
+{
+    variable_t **old = priv->var_table;
+    size_t old_size = (old != NULL) ? priv->var_mask + 1 : 0;
+    size_t size = (old != NULL) ? 2 * old_size : VAR_TABLE_MIN;
+    variable_t **table = calloc( size, sizeof (*table) );
+
+    if( unlikely(table == NULL) )
+        return VLC_ENOMEM;
+
+    priv->var_table = table;
+    priv->var_mask = size - 1;
+
+    for( size_t i = 0; i < old_size; i++ )
+        if( old[i] != NULL )
+            *LookupSlot( priv, old[i]->psz_name, old[i]->i_hash ) = old[i];
+    free( old );
+    return VLC_SUCCESS;
+}
+
+/**
+ * Inserts a variable unless one with the same name already exists.
+ * \return the variable in the table, or NULL on memory error
+ */
+static variable_t *Insert( vlc_object_internals_t *priv, variable_t *var )
+{
+    variable_t **slot;
+
+    if( priv->var_table != NULL )
+    {
+        slot = LookupSlot( priv, var->psz_name, var->i_hash );
+        if( *slot != NULL )
+            return *slot;
+    }
+
+    if( 2 * (priv->var_count + 1) > priv->var_mask + 1
+     || priv->var_table == NULL )
+    {
+        if( GrowTable( priv ) )
+            return NULL;
+        slot = LookupSlot( priv, var->psz_name, var->i_hash );
+    }
+
+    *slot = var;
+    priv->var_count++;
+    return var;
+}
+
+/**
+ * Removes a variable from the table, shifting back the entries that follow
+ * it in the same probe sequence so that no tombstones are needed.
+ */
+static void Remove( vlc_object_internals_t *priv, variable_t **slot )
+{
+    const size_t mask = priv->var_mask;
+    size_t i = slot - priv->var_table;
+
+    for( size_t j = (i + 1) & mask; priv->var_table[j] != NULL;
+         j = (j + 1) & mask )
+    {
+        size_t home = priv->var_table[j]->i_hash & mask;
+
+        /* Move the entry back if the hole is between its home and itself */
+        if( ((j - home) & mask) >= ((j - i) & mask) )
+        {
+            priv->var_table[i] = priv->var_table[j];
+            i = j;
+        }
+    }
+    priv->var_table[i] = NULL;
+    priv->var_count--;
+}
+
+/*
+ * var_Inherit() results are cached per object: each entry remembers which
+ * ancestor held the variable (or NULL for the configuration). Entries are
+ * only valid for the generation at which they were resolved; the generation
+ * changes whenever a variable is created or destroyed anywhere. Values are
+ * never cached, only where to find them.
+ */
+#define VAR_INHERIT_SLOTS 8
+#define VAR_INHERIT_NAME  32
+
+struct vlc_var_inherit
+{
+    struct
+    {
+        vlc_object_t *holder;
+        unsigned generation;
+        uint32_t hash;
+        char name[VAR_INHERIT_NAME];
+    } slots[VAR_INHERIT_SLOTS];
+};
+
+static atomic_uint var_generation = ATOMIC_VAR_INIT(1);
+
+/* Generation of the values, for var_GetGeneration(). It is incremented by
+ * two so that it is always odd, and never matches a zeroed snapshot. */
+static atomic_uint var_value_generation = ATOMIC_VAR_INIT(1);
+
+void var_InvalidateValues( void )
+{
+    atomic_fetch_add_explicit( &var_value_generation, 2,
+                               memory_order_release );
+}
+
+unsigned var_GetGeneration( void )
+{
+    return atomic_load_explicit( &var_value_generation,
+                                 memory_order_acquire );
+}
+
+static void InvalidateInherit( void )
+{
+    atomic_fetch_add_explicit( &var_generation, 1, memory_order_release );
+    var_InvalidateValues();
+}
+
+static bool InheritCacheGet( vlc_object_t *obj, const char *psz_name,
+                             uint32_t hash, unsigned generation,
+                             vlc_object_t **holder )
+{
+    vlc_object_internals_t *priv = vlc_internals( obj );
+    bool found = false;
+
+    vlc_mutex_lock( &priv->var_lock );
+    if( priv->var_inherit != NULL )
+    {
+        const typeof (priv->var_inherit->slots[0]) *slot =
+            &priv->var_inherit->slots[hash % VAR_INHERIT_SLOTS];
+
+        if( slot->generation == generation && slot->hash == hash
+         && !strcmp( slot->name, psz_name ) )
+        {
+            *holder = slot->holder;
+            found = true;
+        }
+    }
+    vlc_mutex_unlock( &priv->var_lock );
+    return found;
+}
+
+static void InheritCachePut( vlc_object_t *obj, const char *psz_name,
+                             uint32_t hash, unsigned generation,
+                             vlc_object_t *holder )
+{
+    vlc_object_internals_t *priv = vlc_internals( obj );
+
+    vlc_mutex_lock( &priv->var_lock );
+    if( priv->var_inherit == NULL )
+        priv->var_inherit = calloc( 1, sizeof (*priv->var_inherit) );
+    if( likely(priv->var_inherit != NULL) )
+    {
+        typeof (priv->var_inherit->slots[0]) *slot =
+            &priv->var_inherit->slots[hash % VAR_INHERIT_SLOTS];
+
+        slot->holder = holder;
+        slot->generation = generation;
+        slot->hash = hash;
+        strcpy( slot->name, psz_name );
+    }
+    vlc_mutex_unlock( &priv->var_lock );
 }
 
 static void Destroy( variable_t *p_var )
@@ -295,6 +493,7 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         return VLC_ENOMEM;
 
     p_var->psz_name = strdup( psz_name );
+    p_var->i_hash = HashName( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
@@ -352,17 +551,20 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
         var_Inherit(p_this, psz_name, i_type, &p_var->val);
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
-    void **pp_var;
     variable_t *p_oldvar;
     int ret = VLC_SUCCESS;
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    pp_var = tsearch( p_var, &p_priv->var_root, varcmp );
-    if( unlikely(pp_var == NULL) )
+    if( unlikely(p_var->psz_name == NULL) )
         ret = VLC_ENOMEM;
-    else if( (p_oldvar = *pp_var) == p_var ) /* Variable create */
+    else if( unlikely((p_oldvar = Insert( p_priv, p_var )) == NULL) )
+        ret = VLC_ENOMEM;
+    else if( p_oldvar == p_var ) /* Variable create */
+    {
         p_var = NULL; /* Variable created */
+        InvalidateInherit();
+    }
     else /* Variable already exists */
     {
         assert (((i_type ^ p_oldvar->i_type) & VLC_VAR_CLASS) == 0);
@@ -379,20 +581,27 @@ int (var_Create)( vlc_object_t *p_this, const char *psz_name, int i_type )
 
 void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
 {
-    variable_t *p_var;
+    variable_t *p_var = NULL, **pp_var = NULL;
 
     assert( p_this );
 
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
 
-    p_var = Lookup( p_this, psz_name );
+    vlc_mutex_lock( &p_priv->var_lock );
+    if( p_priv->var_count > 0 )
+    {
+        pp_var = LookupSlot( p_priv, psz_name, HashName( psz_name ) );
+        p_var = *pp_var;
+    }
+
     if( p_var == NULL )
         msg_Dbg( p_this, "attempt to destroy nonexistent variable \"%s\"",
                  psz_name );
     else if( --p_var->i_usage == 0 )
     {
         assert(!p_var->b_incallback);
-        tdelete( p_var, &p_priv->var_root, varcmp );
+        Remove( p_priv, pp_var );
+        InvalidateInherit();
     }
     else
     {
@@ -405,17 +614,23 @@ void (var_Destroy)(vlc_object_t *p_this, const char *psz_name)
         Destroy( p_var );
 }
 
-static void CleanupVar( void *var )
-{
-    Destroy( var );
-}
-
 void var_DestroyAll( vlc_object_t *obj )
 {
     vlc_object_internals_t *priv = vlc_internals( obj );
 
-    tdestroy( priv->var_root, CleanupVar );
-    priv->var_root = NULL;
+    if( priv->var_table != NULL )
+    {
+        for( size_t i = 0; i <= priv->var_mask; i++ )
+            if( priv->var_table[i] != NULL )
+                Destroy( priv->var_table[i] );
+        free( priv->var_table );
+        InvalidateInherit();
+    }
+    priv->var_table = NULL;
+    priv->var_mask = 0;
+    priv->var_count = 0;
+    free( priv->var_inherit );
+    priv->var_inherit = NULL;
 }
 
 int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
@@ -539,6 +754,7 @@ int (var_Change)(vlc_object_t *p_this, const char *psz_name, int i_action, ...)
             CheckValue( p_var, &newval );
             /* Set the variable */
             p_var->val = newval;
+            var_InvalidateValues();
             /* Free data if needed */
             p_var->ops->pf_free( &oldval );
             break;
@@ -642,6 +858,7 @@ int (var_GetAndSet)(vlc_object_t *p_this, const char *psz_name, int i_action,
     /*  Check boundaries */
     CheckValue( p_var, &p_var->val );
     *p_val = p_var->val;
+    var_InvalidateValues();
 
     /* Deal with callbacks.*/
     TriggerCallback( p_this, p_var, psz_name, oldval );
@@ -705,6 +922,7 @@ int (var_SetChecked)(vlc_object_t *p_this, const char *psz_name,
 
     /* Set the variable */
     p_var->val = val;
+    var_InvalidateValues();
 
     /* Deal with callbacks */
     TriggerCallback( p_this, p_var, psz_name, oldval );
@@ -721,8 +939,8 @@ int (var_Set)(vlc_object_t *p_this, const char *psz_name, vlc_value_t val)
     return var_SetChecked( p_this, psz_name, 0, val );
 }
 
-int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
-                     int expected_type, vlc_value_t *p_val)
+static int GetChecked( vlc_object_t *p_this, const char *psz_name,
+                       uint32_t hash, int expected_type, vlc_value_t *p_val )
 {
     assert( p_this );
 
@@ -730,7 +948,7 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     variable_t *p_var;
     int err = VLC_SUCCESS;
 
-    p_var = Lookup( p_this, psz_name );
+    p_var = LookupHash( p_this, psz_name, hash );
     if( p_var != NULL )
     {
         assert( expected_type == 0 ||
@@ -750,6 +968,13 @@ int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
     return err;
 }
 
+int (var_GetChecked)(vlc_object_t *p_this, const char *psz_name,
+                     int expected_type, vlc_value_t *p_val)
+{
+    return GetChecked( p_this, psz_name, HashName( psz_name ), expected_type,
+                       p_val );
+}
+
 int (var_Get)(vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val)
 {
     return var_GetChecked( p_this, psz_name, 0, p_val );
@@ -1037,13 +1262,36 @@ int (var_LocationParse)(vlc_object_t *obj, const char *mrl, const char *pref)
 int var_Inherit( vlc_object_t *p_this, const char *psz_name, int i_type,
                  vlc_value_t *p_val )
 {
+    const uint32_t hash = HashName( psz_name );
+    const unsigned generation = atomic_load_explicit( &var_generation,
+                                                      memory_order_acquire );
+    const bool cacheable = strlen( psz_name ) < VAR_INHERIT_NAME;
+    vlc_object_t *obj = p_this;
+
     i_type &= VLC_VAR_CLASS;
-    for (vlc_object_t *obj = p_this; obj != NULL; obj = vlc_object_parent(obj))
+    if( cacheable
+     && InheritCacheGet( p_this, psz_name, hash, generation, &obj ) )
     {
-        if( var_GetChecked( obj, psz_name, i_type, p_val ) == VLC_SUCCESS )
+        if( obj == NULL )
+            goto config;
+        if( GetChecked( obj, psz_name, hash, i_type, p_val ) == VLC_SUCCESS )
             return VLC_SUCCESS;
+        obj = p_this; /* destroyed meanwhile, walk again */
     }
 
+    for( ; obj != NULL; obj = vlc_object_parent(obj) )
+    {
+        if( GetChecked( obj, psz_name, hash, i_type, p_val ) == VLC_SUCCESS )
+        {
+            if( cacheable )
+                InheritCachePut( p_this, psz_name, hash, generation, obj );
+            return VLC_SUCCESS;
+        }
+    }
+
+    if( cacheable )
+        InheritCachePut( p_this, psz_name, hash, generation, NULL );
+config:
     /* else take value from config */
     switch( i_type & VLC_VAR_CLASS )
     {
@@ -1135,21 +1383,6 @@ error:
     return VLC_EGENERIC;
 }
 
-static thread_local void *twalk_ctx;
-
-static void TwalkGetNames(const void *data, const VISIT which, const int depth)
-{
-    if (which != postorder && which != leaf)
-        return;
-    (void) depth;
-
-    const variable_t *var = *(const variable_t **)data;
-    DECL_ARRAY(char *) *names = twalk_ctx;
-    char *dup = strdup(var->psz_name);
-    if (dup != NULL)
-        ARRAY_APPEND(*names, dup);
-}
-
 char **var_GetAllNames(vlc_object_t *obj)
 {
     vlc_object_internals_t *priv = vlc_internals(obj);
@@ -1157,9 +1390,17 @@ char **var_GetAllNames(vlc_object_t *obj)
     DECL_ARRAY(char *) names;
     ARRAY_INIT(names);
 
-    twalk_ctx = &names;
     vlc_mutex_lock(&priv->var_lock);
-    twalk(priv->var_root, TwalkGetNames);
+    for (size_t i = 0; priv->var_table != NULL && i <= priv->var_mask; i++)
+    {
+        const variable_t *var = priv->var_table[i];
+        if (var == NULL)
+            continue;
+
+        char *dup = strdup(var->psz_name);
+        if (dup != NULL)
+            ARRAY_APPEND(names, dup);
+    }
     vlc_mutex_unlock(&priv->var_lock);
 
     if (names.i_size == 0)
@@ -26,6 +26,7 @@
 # include <vlc_list.h>
 
 struct vlc_res;
+struct vlc_var_inherit;
 
 /**
  * Private LibVLC data for each object.
@@ -38,7 +39,10 @@ struct vlc_object_internals
     const char *typename; /**< Object type human-readable name */
 
     /* Object variables */
-    void           *var_root;
+    struct variable_t **var_table; /**< Hash table of variables */
+    size_t          var_mask; /**< Table size minus one */
+    size_t          var_count; /**< Number of variables in the table */
+    struct vlc_var_inherit *var_inherit; /**< var_Inherit() cache */
     vlc_mutex_t     var_lock;
     vlc_cond_t      var_wait;
 
@@ -51,6 +55,11 @@ struct vlc_object_internals
 
 extern void var_DestroyAll( vlc_object_t * );
 
+/**
+ * Invalidates all the snapshots of inherited values (see var_GetGeneration()).
+ */
+extern void var_InvalidateValues( void );
+
 /**
  * Return a list of all variable names
  *
@@ -35,6 +35,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <assert.h>
+#ifdef HAVE_SEARCH_H
+# include <search.h>
+#endif
 
 #include <vlc_common.h>
 #include <vlc_block.h>
@@ -56,292 +59,384 @@
 #ifdef HAVE_DYNAMIC_PLUGINS
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 36
+#define CACHE_SUBVERSION_NUM 37
 
 /* Cache filename */
 #define CACHE_NAME "plugins.dat"
 /* Magic for the cache filename */
 #define CACHE_STRING "cache "PACKAGE_NAME" "PACKAGE_VERSION
 
+#ifdef DISTRO_VERSION
+# define CACHE_MAGIC_SIZE (sizeof (CACHE_STRING) + sizeof (DISTRO_VERSION) - 2)
+#else
+# define CACHE_MAGIC_SIZE (sizeof (CACHE_STRING) - 1)
+#endif
+/* The header follows the magic, the sub-version and the header marker */
+#define CACHE_HEADER_OFFSET ((CACHE_MAGIC_SIZE + 8 + 7) & ~(size_t)7)
 
-static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
+/*
+ * The cache file is mapped and used in place: records have fixed sizes and
+ * refer to one another by their offset within the file. Strings are
+ * referenced by their offset within the string table, zero meaning NULL.
+ *
+ * Configuration items are only converted to module_config_t when the
+ * configuration of a plugin is first needed, see vlc_plugin_conf().
+ */
+struct vlc_cache_header
 {
-    if (in->i_buffer < size)
-        return -1;
-
-    memcpy(out, in->p_buffer, size);
-    in->p_buffer += size;
-    in->i_buffer -= size;
-    return 0;
-}
-
-static int vlc_cache_load_bool(bool *out, block_t *in)
+    uint32_t size; /**< File size */
+    uint32_t plugins; /**< Offset of the plugins table */
+    uint32_t plugins_count;
+    uint32_t strings; /**< Offset of the string table */
+    uint32_t strings_size;
+};
+
+struct vlc_cache_plugin
 {
-    unsigned char b;
-
-    if (vlc_cache_load_immediate(&b, in, 1) || b > 1)
-        return -1;
+    int64_t mtime;
+    uint64_t size;
+    uint32_t path;
+    uint32_t textdomain;
+    uint32_t modules; /**< Offset of the modules table */
+    uint32_t modules_count;
+    uint32_t config; /**< Offset of the configuration items table */
+    uint32_t config_size;
+    uint32_t config_count;
+    uint32_t config_booleans;
+    uint8_t unloadable;
+};
+
+struct vlc_cache_module
+{
+    uint32_t shortname;
+    uint32_t longname;
+    uint32_t help;
+    uint32_t capability;
+    int32_t score;
+    uint32_t activate;
+    uint32_t deactivate;
+    uint32_t shortcuts; /**< Offset of the shortcuts table */
+    uint32_t shortcuts_count;
+};
+
+typedef union
+{
+    int64_t i;
+    float f;
+} vlc_cache_value_t;
 
-    *out = b;
-    return 0;
+struct vlc_cache_config
+{
+    vlc_cache_value_t orig; /**< Default value (string reference if string) */
+    vlc_cache_value_t min;
+    vlc_cache_value_t max;
+    uint32_t psz_type;
+    uint32_t psz_name;
+    uint32_t psz_text;
+    uint32_t psz_longtext;
+    uint32_t list; /**< Offset of the choices table */
+    uint32_t list_text; /**< Offset of the choices names table */
+    uint16_t list_count;
+    uint8_t i_type;
+    char i_short;
+    uint8_t flags;
+};
+
+#define CACHE_CONFIG_INTERNAL   0x1
+#define CACHE_CONFIG_UNSAVEABLE 0x2
+#define CACHE_CONFIG_SAFE       0x4
+#define CACHE_CONFIG_REMOVED    0x8
+
+struct vlc_cache_file
+{
+    const unsigned char *base;
+    size_t size;
+    const char *strings;
+    size_t strings_size;
+};
+
+static void vlc_cache_file_init(struct vlc_cache_file *file,
+                                const struct vlc_cache_header *hdr)
+{
+    file->base = (const unsigned char *)hdr - CACHE_HEADER_OFFSET;
+    file->size = hdr->size;
+    file->strings = (const char *)file->base + hdr->strings;
+    file->strings_size = hdr->strings_size;
 }
 
-static int vlc_cache_load_array(const void **p, size_t size, size_t n,
-                                block_t *file)
+static const char *vlc_cache_string(const struct vlc_cache_file *file,
+                                    uint32_t ref)
 {
-    if (n == 0)
-    {
-        *p = NULL;
-        return 0;
-    }
-
-    if (unlikely(size * n < size))
-        return -1;
-
-    size *= n;
-
-    if (file->i_buffer < size)
-        return -1;
-
-    *p = file->p_buffer;
-    file->p_buffer += size;
-    file->i_buffer -= size;
-    return 0;
+    /* The string table is nul-terminated, and so is any string within it. */
+    return (ref != 0 && ref < file->strings_size) ? file->strings + ref
+                                                  : NULL;
 }
 
-static int vlc_cache_load_string(const char **restrict p, block_t *file)
+static const void *vlc_cache_table_at(const struct vlc_cache_file *file,
+                                      uint32_t offset, size_t count,
+                                      size_t size, size_t align)
 {
-    uint16_t size;
-
-    if (vlc_cache_load_immediate(&size, file, sizeof (size)) || size > 16384)
-        return -1;
-
-    if (size == 0)
-    {
-        *p = NULL;
-        return 0;
-    }
+    if (offset > file->size || count > (file->size - offset) / size
+     || ((uintptr_t)(file->base + offset) % align) != 0)
+        return NULL;
+    return file->base + offset;
+}
 
-    const char *str = (char *)file->p_buffer;
+#define vlc_cache_table(file, offset, count, type) \
+    ((const type *)vlc_cache_table_at(file, offset, count, sizeof (type), \
+                                      alignof (type)))
 
-    if (file->i_buffer < size || str[size - 1] != '\0')
+static int vlc_cache_load_immediate(void *out, block_t *in, size_t size)
+{
+    if (in->i_buffer < size)
         return -1;
 
-    file->p_buffer += size;
-    file->i_buffer -= size;
-    *p = str;
+    memcpy(out, in->p_buffer, size);
+    in->p_buffer += size;
+    in->i_buffer -= size;
     return 0;
 }
 
-static int vlc_cache_load_align(size_t align, block_t *file)
+static const char **vlc_cache_load_strings(const struct vlc_cache_file *file,
+                                           uint32_t offset, size_t count)
 {
-    assert(align > 0);
-
-    size_t skip = (-(uintptr_t)file->p_buffer) % align;
-    if (skip == 0)
-        return 0;
-
-    assert(skip < align);
+    const uint32_t *refs = vlc_cache_table(file, offset, count, uint32_t);
+    if (refs == NULL)
+        return NULL;
 
-    if (file->i_buffer < skip)
-        return -1;
+    const char **tab = vlc_alloc(count, sizeof (*tab));
+    if (likely(tab != NULL))
+        for (size_t i = 0; i < count; i++)
+        {
+            const char *str = vlc_cache_string(file, refs[i]);
 
-    file->p_buffer += skip;
-    file->i_buffer -= skip;
-    assert((((uintptr_t)file->p_buffer) % align) == 0);
-    return 0;
+            tab[i] = (str != NULL) ? str : ""; /* NULL -> empty string */
+        }
+    return tab;
 }
 
-#define LOAD_IMMEDIATE(a) \
-    if (vlc_cache_load_immediate(&(a), file, sizeof (a))) \
-        goto error
-#define LOAD_FLAG(a) \
-    do \
-    { \
-        bool b; \
-        if (vlc_cache_load_bool(&b, file)) \
-            goto error; \
-        (a) = b; \
-    } while (0)
-#define LOAD_ARRAY(a,n) \
-    do \
-    { \
-        const void *base; \
-        if (vlc_cache_load_array(&base, sizeof (*(a)), (n), file)) \
-            goto error; \
-        (a) = base; \
-    } while (0)
-#define LOAD_STRING(a) \
-    if (vlc_cache_load_string(&(a), file)) \
-        goto error
-#define LOAD_ALIGNOF(t) \
-    if (vlc_cache_load_align(alignof(t), file)) \
-        goto error
-
-static int vlc_cache_load_config(module_config_t *cfg, block_t *file)
+static void vlc_cache_load_config(module_config_t *cfg,
+                                  const struct vlc_cache_config *c,
+                                  const struct vlc_cache_file *file)
 {
-    LOAD_IMMEDIATE (cfg->i_type);
-    LOAD_IMMEDIATE (cfg->i_short);
-    LOAD_FLAG (cfg->b_internal);
-    LOAD_FLAG (cfg->b_unsaveable);
-    LOAD_FLAG (cfg->b_safe);
-    LOAD_FLAG (cfg->b_removed);
-    LOAD_STRING (cfg->psz_type);
-    LOAD_STRING (cfg->psz_name);
-    LOAD_STRING (cfg->psz_text);
-    LOAD_STRING (cfg->psz_longtext);
-    LOAD_IMMEDIATE (cfg->list_count);
-
-    if (IsConfigStringType (cfg->i_type))
+    cfg->i_type = c->i_type;
+    cfg->i_short = c->i_short;
+    cfg->b_internal = (c->flags & CACHE_CONFIG_INTERNAL) != 0;
+    cfg->b_unsaveable = (c->flags & CACHE_CONFIG_UNSAVEABLE) != 0;
+    cfg->b_safe = (c->flags & CACHE_CONFIG_SAFE) != 0;
+    cfg->b_removed = (c->flags & CACHE_CONFIG_REMOVED) != 0;
+    cfg->psz_type = vlc_cache_string(file, c->psz_type);
+    cfg->psz_name = vlc_cache_string(file, c->psz_name);
+    cfg->psz_text = vlc_cache_string(file, c->psz_text);
+    cfg->psz_longtext = vlc_cache_string(file, c->psz_longtext);
+    if (CONFIG_ITEM(cfg->i_type) && cfg->psz_name == NULL)
+        cfg->psz_name = ""; /* corrupted */
+
+    cfg->list_count = c->list_count;
+    cfg->list_text = NULL;
+
+    if (IsConfigStringType(cfg->i_type))
     {
-        const char *psz;
-        LOAD_STRING(psz);
+        const char *psz = vlc_cache_string(file, c->orig.i);
+
         cfg->orig.psz = (char *)psz;
-        cfg->value.psz = (psz != NULL) ? strdup (cfg->orig.psz) : NULL;
+        cfg->value.psz = (psz != NULL) ? strdup(psz) : NULL;
+        cfg->list.psz = NULL;
 
-        if (cfg->list_count)
-            cfg->list.psz = xmalloc (cfg->list_count * sizeof (char *));
-        for (unsigned i = 0; i < cfg->list_count; i++)
+        if (cfg->list_count > 0)
         {
-            LOAD_STRING (cfg->list.psz[i]);
-            if (cfg->list.psz[i] == NULL /* NULL -> empty string */
-             && (cfg->list.psz[i] = calloc (1, 1)) == NULL)
-                goto error;
+            cfg->list.psz = vlc_cache_load_strings(file, c->list,
+                                                   cfg->list_count);
+            if (cfg->list.psz == NULL)
+                cfg->list_count = 0;
         }
     }
     else
     {
-        LOAD_IMMEDIATE (cfg->orig);
-        LOAD_IMMEDIATE (cfg->min);
-        LOAD_IMMEDIATE (cfg->max);
+        if (IsConfigFloatType(cfg->i_type))
+        {
+            cfg->orig.f = c->orig.f;
+            cfg->min.f = c->min.f;
+            cfg->max.f = c->max.f;
+        }
+        else
+        {
+            cfg->orig.i = c->orig.i;
+            cfg->min.i = c->min.i;
+            cfg->max.i = c->max.i;
+        }
         cfg->value = cfg->orig;
+        cfg->list.i = NULL;
 
-        if (cfg->list_count)
+        if (cfg->list_count > 0)
         {
-            LOAD_ALIGNOF(*cfg->list.i);
+            cfg->list.i = vlc_cache_table(file, c->list, cfg->list_count,
+                                          int);
+            if (cfg->list.i == NULL)
+                cfg->list_count = 0;
         }
-
-        LOAD_ARRAY(cfg->list.i, cfg->list_count);
     }
 
-    cfg->list_text = xmalloc (cfg->list_count * sizeof (char *));
-    for (unsigned i = 0; i < cfg->list_count; i++)
+    if (cfg->list_count > 0)
     {
-        LOAD_STRING (cfg->list_text[i]);
-        if (cfg->list_text[i] == NULL /* NULL -> empty string */
-         && (cfg->list_text[i] = calloc (1, 1)) == NULL)
-            goto error;
+        cfg->list_text = vlc_cache_load_strings(file, c->list_text,
+                                                cfg->list_count);
+        if (cfg->list_text == NULL)
+        {
+            if (IsConfigStringType(cfg->i_type))
+                free(cfg->list.psz);
+            cfg->list_count = 0;
+        }
     }
-
-    return 0;
-error:
-    return -1; /* FIXME: leaks */
 }
 
-static int vlc_cache_load_plugin_config(vlc_plugin_t *plugin, block_t *file)
+/**
+ * Converts the cached configuration items of a plugin.
+ */
+void vlc_cache_resolve_config(vlc_plugin_t *plugin)
 {
-    uint16_t lines;
+    static vlc_mutex_t lock = VLC_STATIC_MUTEX;
 
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE (lines);
+    vlc_mutex_lock(&lock);
 
-    /* Allocate memory */
-    if (lines)
-    {
-        plugin->conf.items = calloc(sizeof (module_config_t), lines);
-        if (unlikely(plugin->conf.items == NULL))
-        {
-            plugin->conf.size = 0;
-            return -1;
-        }
-    }
-    else
-        plugin->conf.items = NULL;
-
-    plugin->conf.size = lines;
+    const struct vlc_cache_config *cache =
+        atomic_load_explicit(&plugin->conf.cache, memory_order_relaxed);
 
-    /* Do the duplication job */
-    for (size_t i = 0; i < lines; i++)
+    if (cache != NULL) /* not resolved by another thread in the mean time */
     {
-        module_config_t *item = plugin->conf.items + i;
+        struct vlc_cache_file file;
+        module_config_t *items = calloc(plugin->conf.size, sizeof (*items));
 
-        if (vlc_cache_load_config(item, file))
-            return -1;
+        if (unlikely(items == NULL))
+            abort();
 
-        if (CONFIG_ITEM(item->i_type))
+        vlc_cache_file_init(&file, plugin->conf.cache_file);
+
+        for (size_t i = 0; i < plugin->conf.size; i++)
         {
-            plugin->conf.count++;
-            if (item->i_type == CONFIG_ITEM_BOOL)
-                plugin->conf.booleans++;
+            vlc_cache_load_config(items + i, cache + i, &file);
+            items[i].owner = plugin;
         }
-        item->owner = plugin;
+
+        plugin->conf.items = items;
+        atomic_store_explicit(&plugin->conf.cache, NULL,
+                              memory_order_release);
     }
 
-    return 0;
-error:
-    return -1; /* FIXME: leaks */
+    vlc_mutex_unlock(&lock);
+}
+
+/**
+ * Describes a cached configuration item without resolving it.
+ *
+ * \retval false if the configuration of the plugin is already resolved
+ */
+bool vlc_cache_describe_config(const vlc_plugin_t *plugin, size_t i,
+                               uint8_t *restrict type,
+                               const char **restrict name,
+                               char *restrict shortname)
+{
+    const struct vlc_cache_config *cache =
+        atomic_load_explicit(&plugin->conf.cache, memory_order_relaxed);
+
+    if (cache == NULL)
+        return false;
+
+    struct vlc_cache_file file;
+
+    assert(i < plugin->conf.size);
+    vlc_cache_file_init(&file, plugin->conf.cache_file);
+    cache += i;
+    *type = cache->i_type;
+    *name = vlc_cache_string(&file, cache->psz_name);
+    if (*name == NULL)
+        *name = ""; /* corrupted */
+    *shortname = cache->i_short;
+    return true;
 }
 
-static int vlc_cache_load_module(vlc_plugin_t *plugin, block_t *file)
+static int vlc_cache_load_module(vlc_plugin_t *plugin,
+                                 const struct vlc_cache_module *m,
+                                 const struct vlc_cache_file *file)
 {
+    if (m->shortcuts_count > MODULE_SHORTCUT_MAX)
+        return -1;
+
+    const uint32_t *shortcuts = vlc_cache_table(file, m->shortcuts,
+                                                m->shortcuts_count, uint32_t);
+    if (shortcuts == NULL)
+        return -1;
+
     module_t *module = vlc_module_create(plugin);
     if (unlikely(module == NULL))
         return -1;
 
-    LOAD_STRING(module->psz_shortname);
-    LOAD_STRING(module->psz_longname);
-    LOAD_STRING(module->psz_help);
+    module->psz_shortname = vlc_cache_string(file, m->shortname);
+    module->psz_longname = vlc_cache_string(file, m->longname);
+    module->psz_help = vlc_cache_string(file, m->help);
 
-    LOAD_IMMEDIATE(module->i_shortcuts);
-    if (module->i_shortcuts > MODULE_SHORTCUT_MAX)
-        goto error;
-    else
+    if (m->shortcuts_count > 0)
     {
-        module->pp_shortcuts =
-            xmalloc (sizeof (*module->pp_shortcuts) * module->i_shortcuts);
+        module->pp_shortcuts = vlc_alloc(m->shortcuts_count,
+                                         sizeof (*module->pp_shortcuts));
+        if (unlikely(module->pp_shortcuts == NULL))
+            return -1;
+
+        module->i_shortcuts = m->shortcuts_count;
         for (unsigned j = 0; j < module->i_shortcuts; j++)
-            LOAD_STRING(module->pp_shortcuts[j]);
+            module->pp_shortcuts[j] = vlc_cache_string(file, shortcuts[j]);
     }
 
-    LOAD_STRING(module->activate_name);
-    LOAD_STRING(module->deactivate_name);
-    LOAD_STRING(module->psz_capability);
-    LOAD_IMMEDIATE(module->i_score);
+    module->activate_name = vlc_cache_string(file, m->activate);
+    module->deactivate_name = vlc_cache_string(file, m->deactivate);
+    module->psz_capability = vlc_cache_string(file, m->capability);
+    module->i_score = m->score;
     return 0;
-error:
-    return -1;
 }
 
-static vlc_plugin_t *vlc_cache_load_plugin(block_t *file)
+static vlc_plugin_t *vlc_cache_load_plugin(const struct vlc_cache_plugin *p,
+                                           const struct vlc_cache_header *hdr,
+                                           const struct vlc_cache_file *file)
 {
+    const char *path = vlc_cache_string(file, p->path);
+    const struct vlc_cache_module *modules =
+        vlc_cache_table(file, p->modules, p->modules_count,
+                        struct vlc_cache_module);
+    const struct vlc_cache_config *config =
+        vlc_cache_table(file, p->config, p->config_size,
+                        struct vlc_cache_config);
+
+    if (path == NULL || modules == NULL || config == NULL
+     || p->config_size > UINT16_MAX || p->config_count > p->config_size
+     || p->config_booleans > p->config_count)
+        return NULL;
+
     vlc_plugin_t *plugin = vlc_plugin_create();
     if (unlikely(plugin == NULL))
         return NULL;
 
-    uint32_t modules;
-    LOAD_IMMEDIATE(modules);
-
-    for (size_t i = 0; i < modules; i++)
-        if (vlc_cache_load_module(plugin, file))
+    for (size_t i = 0; i < p->modules_count; i++)
+        if (vlc_cache_load_module(plugin, modules + i, file))
             goto error;
 
-    if (vlc_cache_load_plugin_config(plugin, file))
-        goto error;
-
-    LOAD_STRING(plugin->textdomain);
+    /* Configuration items are resolved later, if ever needed */
+    plugin->conf.size = p->config_size;
+    plugin->conf.count = p->config_count;
+    plugin->conf.booleans = p->config_booleans;
+    plugin->conf.cache_file = hdr;
+    if (p->config_size > 0)
+        atomic_store_explicit(&plugin->conf.cache, config,
+                              memory_order_relaxed);
 
-    const char *path;
-    LOAD_STRING(path);
-    if (path == NULL)
-        goto error;
+    plugin->textdomain = vlc_cache_string(file, p->textdomain);
 
     plugin->path = strdup(path);
     if (unlikely(plugin->path == NULL))
         goto error;
 
-    LOAD_FLAG(plugin->unloadable);
-    LOAD_IMMEDIATE(plugin->mtime);
-    LOAD_IMMEDIATE(plugin->size);
+    plugin->unloadable = p->unloadable != 0;
+    plugin->mtime = p->mtime;
+    plugin->size = p->size;
 
     if (plugin->textdomain != NULL)
         vlc_bindtextdomain(plugin->textdomain);
@@ -381,6 +476,9 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
     if (file == NULL)
         return NULL;
 
+    const unsigned char *base = file->p_buffer;
+    size_t size = file->i_buffer;
+
     /* Check the file is a plugins cache */
     char cachestr[sizeof (CACHE_STRING) - 1];
 
@@ -433,10 +531,28 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
     }
 
     vlc_plugin_t *cache = NULL;
+    const struct vlc_cache_header *hdr = (const void *)(base + CACHE_HEADER_OFFSET);
+    struct vlc_cache_file cf;
+
+    if (size < CACHE_HEADER_OFFSET + sizeof (*hdr) || hdr->size != size
+     || hdr->strings > size || hdr->strings_size == 0
+     || hdr->strings_size > size - hdr->strings)
+        goto error;
+
+    vlc_cache_file_init(&cf, hdr);
+
+    if (cf.strings[0] != '\0' || cf.strings[cf.strings_size - 1] != '\0')
+        goto error;
 
-    while (file->i_buffer > 0)
+    const struct vlc_cache_plugin *plugins =
+        vlc_cache_table(&cf, hdr->plugins, hdr->plugins_count,
+                        struct vlc_cache_plugin);
+    if (plugins == NULL)
+        goto error;
+
+    for (size_t i = 0; i < hdr->plugins_count; i++)
     {
-        vlc_plugin_t *plugin = vlc_cache_load_plugin(file);
+        vlc_plugin_t *plugin = vlc_cache_load_plugin(plugins + i, hdr, &cf);
         if (plugin == NULL)
             goto error;
 
@@ -459,184 +575,301 @@ vlc_plugin_t *vlc_cache_load(vlc_object_t *p_this, const char *dir,
 error:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
 
-    /* TODO: cleanup */
+    while (cache != NULL)
+    {
+        vlc_plugin_t *plugin = cache;
+
+        cache = plugin->next;
+        vlc_plugin_destroy(plugin);
+    }
     block_Release(file);
     return NULL;
 }
 
-#define SAVE_IMMEDIATE( a ) \
-    if (fwrite (&(a), sizeof(a), 1, file) != 1) \
-        goto error
-#define SAVE_FLAG(a) \
-    do { \
-        char b = (a); \
-        SAVE_IMMEDIATE(b); \
-    } while (0)
+struct vlc_cache_buffer
+{
+    unsigned char *data;
+    size_t size;
+    size_t alloc;
+};
+
+struct vlc_cache_string
+{
+    const char *str;
+    uint32_t ref;
+};
+
+struct vlc_cache_writer
+{
+    struct vlc_cache_buffer data;
+    struct vlc_cache_buffer strings;
+    void *strings_tree; /**< Already written strings (for deduplication) */
+    bool error;
+};
 
-static int CacheSaveString (FILE *file, const char *str)
+/**
+ * Appends data (or zeroes if data is NULL) to a cache buffer.
+ * \return the offset of the data within the buffer
+ */
+static uint32_t CacheAppend(struct vlc_cache_writer *w,
+                            struct vlc_cache_buffer *buf,
+                            const void *data, size_t size, size_t align)
 {
-    uint16_t size = (str != NULL) ? (strlen (str) + 1) : 0;
+    size_t offset = (buf->size + align - 1) & ~(align - 1);
 
-    SAVE_IMMEDIATE (size);
-    if (size != 0 && fwrite(str, 1, size, file) != size)
+    if (w->error || offset + size > UINT32_MAX)
     {
-error:
-        return -1;
+        w->error = true;
+        return 0;
     }
-    return 0;
+
+    if (offset + size > buf->alloc)
+    {
+        size_t alloc = __MAX(__MAX(2 * buf->alloc, offset + size), 65536);
+        unsigned char *p = realloc(buf->data, alloc);
+
+        if (unlikely(p == NULL))
+        {
+            w->error = true;
+            return 0;
+        }
+        buf->data = p;
+        buf->alloc = alloc;
+    }
+
+    memset(buf->data + buf->size, 0, offset - buf->size);
+    if (data != NULL)
+        memcpy(buf->data + offset, data, size);
+    else
+        memset(buf->data + offset, 0, size);
+    buf->size = offset + size;
+    return offset;
 }
 
-#define SAVE_STRING( a ) \
-    if (CacheSaveString (file, (a))) \
-        goto error
+#define CacheAppendTable(w, count, type) \
+    CacheAppend(w, &(w)->data, NULL, (count) * sizeof (type), alignof (type))
 
-static int CacheSaveAlign(FILE *file, size_t align)
+static void CachePatch(struct vlc_cache_writer *w, uint32_t offset,
+                       const void *data, size_t size)
 {
-    assert(align > 0);
+    if (!w->error)
+        memcpy(w->data.data + offset, data, size);
+}
 
-    size_t skip = (-ftell(file)) % align;
-    if (skip == 0)
-        return 0;
+static int CacheStringCmp(const void *a, const void *b)
+{
+    const struct vlc_cache_string *sa = a, *sb = b;
 
-    assert(((ftell(file) + skip) % align) == 0);
-    return fseek(file, skip, SEEK_CUR);
+    return strcmp(sa->str, sb->str);
 }
 
-#define SAVE_ALIGNOF(t) \
-    if (CacheSaveAlign(file, alignof (t))) \
-        goto error
+static uint32_t CacheString(struct vlc_cache_writer *w, const char *str)
+{
+    if (str == NULL)
+        return 0;
+
+    struct vlc_cache_string *node = malloc(sizeof (*node));
+    if (unlikely(node == NULL))
+    {
+        w->error = true;
+        return 0;
+    }
 
-static int CacheSaveConfig (FILE *file, const module_config_t *cfg)
+    node->str = str;
+
+    struct vlc_cache_string **p = tsearch(node, &w->strings_tree,
+                                          CacheStringCmp);
+    if (unlikely(p == NULL))
+    {
+        free(node);
+        w->error = true;
+        return 0;
+    }
+
+    if (*p != node)
+    {   /* Duplicate string */
+        free(node);
+        return (*p)->ref;
+    }
+
+    node->ref = CacheAppend(w, &w->strings, str, strlen(str) + 1, 1);
+    return node->ref;
+}
+
+static uint32_t CacheStrings(struct vlc_cache_writer *w,
+                             const char *const *tab, size_t count)
 {
-    SAVE_IMMEDIATE (cfg->i_type);
-    SAVE_IMMEDIATE (cfg->i_short);
-    SAVE_FLAG (cfg->b_internal);
-    SAVE_FLAG (cfg->b_unsaveable);
-    SAVE_FLAG (cfg->b_safe);
-    SAVE_FLAG (cfg->b_removed);
-    SAVE_STRING (cfg->psz_type);
-    SAVE_STRING (cfg->psz_name);
-    SAVE_STRING (cfg->psz_text);
-    SAVE_STRING (cfg->psz_longtext);
-    SAVE_IMMEDIATE (cfg->list_count);
-
-    if (IsConfigStringType (cfg->i_type))
+    uint32_t offset = CacheAppendTable(w, count, uint32_t);
+
+    for (size_t i = 0; i < count; i++)
     {
-        SAVE_STRING (cfg->orig.psz);
+        uint32_t ref = CacheString(w, tab[i]);
 
-        for (unsigned i = 0; i < cfg->list_count; i++)
-            SAVE_STRING (cfg->list.psz[i]);
+        CachePatch(w, offset + i * sizeof (ref), &ref, sizeof (ref));
     }
-    else
+    return offset;
+}
+
+static void CacheSaveConfig(struct vlc_cache_writer *w,
+                            struct vlc_cache_config *c,
+                            const module_config_t *cfg)
+{
+    c->i_type = cfg->i_type;
+    c->i_short = cfg->i_short;
+    c->flags = (cfg->b_internal ? CACHE_CONFIG_INTERNAL : 0)
+             | (cfg->b_unsaveable ? CACHE_CONFIG_UNSAVEABLE : 0)
+             | (cfg->b_safe ? CACHE_CONFIG_SAFE : 0)
+             | (cfg->b_removed ? CACHE_CONFIG_REMOVED : 0);
+    c->psz_type = CacheString(w, cfg->psz_type);
+    c->psz_name = CacheString(w, cfg->psz_name);
+    c->psz_text = CacheString(w, cfg->psz_text);
+    c->psz_longtext = CacheString(w, cfg->psz_longtext);
+    c->list_count = cfg->list_count;
+
+    if (IsConfigStringType(cfg->i_type))
     {
-        SAVE_IMMEDIATE (cfg->orig);
-        SAVE_IMMEDIATE (cfg->min);
-        SAVE_IMMEDIATE (cfg->max);
+        c->orig.i = CacheString(w, cfg->orig.psz);
 
         if (cfg->list_count > 0)
+            c->list = CacheStrings(w, cfg->list.psz, cfg->list_count);
+    }
+    else
+    {
+        if (IsConfigFloatType(cfg->i_type))
+        {
+            c->orig.f = cfg->orig.f;
+            c->min.f = cfg->min.f;
+            c->max.f = cfg->max.f;
+        }
+        else
         {
-            SAVE_ALIGNOF(*cfg->list.i);
+            c->orig.i = cfg->orig.i;
+            c->min.i = cfg->min.i;
+            c->max.i = cfg->max.i;
         }
 
-        for (unsigned i = 0; i < cfg->list_count; i++)
-             SAVE_IMMEDIATE (cfg->list.i[i]);
+        if (cfg->list_count > 0)
+            c->list = CacheAppend(w, &w->data, cfg->list.i,
+                                  cfg->list_count * sizeof (*cfg->list.i),
+                                  alignof (int));
     }
-    for (unsigned i = 0; i < cfg->list_count; i++)
-        SAVE_STRING (cfg->list_text[i]);
 
-    return 0;
-error:
-    return -1;
+    if (cfg->list_count > 0)
+        c->list_text = CacheStrings(w, cfg->list_text, cfg->list_count);
 }
 
-static int CacheSaveModuleConfig(FILE *file, const vlc_plugin_t *plugin)
+static void CacheSaveModule(struct vlc_cache_writer *w,
+                            struct vlc_cache_module *m,
+                            const module_t *module)
 {
-    uint16_t lines = plugin->conf.size;
+    m->shortname = CacheString(w, module->psz_shortname);
+    m->longname = CacheString(w, module->psz_longname);
+    m->help = CacheString(w, module->psz_help);
+    m->shortcuts = CacheStrings(w, module->pp_shortcuts, module->i_shortcuts);
+    m->shortcuts_count = module->i_shortcuts;
+    m->activate = CacheString(w, module->activate_name);
+    m->deactivate = CacheString(w, module->deactivate_name);
+    m->capability = CacheString(w, module->psz_capability);
+    m->score = module->i_score;
+}
 
-    SAVE_IMMEDIATE (lines);
+static void CacheSavePlugin(struct vlc_cache_writer *w,
+                            struct vlc_cache_plugin *p, vlc_plugin_t *plugin)
+{
+    const module_config_t *items = vlc_plugin_conf(plugin);
+    size_t i = 0;
 
-    for (size_t i = 0; i < lines; i++)
-        if (CacheSaveConfig(file, plugin->conf.items + i))
-           goto error;
+    p->modules = CacheAppendTable(w, plugin->modules_count,
+                                  struct vlc_cache_module);
+    p->modules_count = plugin->modules_count;
 
-    return 0;
-error:
-    return -1;
-}
+    for (const module_t *module = plugin->module;
+         module != NULL;
+         module = module->next, i++)
+    {
+        struct vlc_cache_module m;
 
-static int CacheSaveModule(FILE *file, const module_t *module)
-{
-    SAVE_STRING(module->psz_shortname);
-    SAVE_STRING(module->psz_longname);
-    SAVE_STRING(module->psz_help);
-    SAVE_IMMEDIATE(module->i_shortcuts);
-
-    for (size_t j = 0; j < module->i_shortcuts; j++)
-         SAVE_STRING(module->pp_shortcuts[j]);
-
-    SAVE_STRING(module->activate_name);
-    SAVE_STRING(module->deactivate_name);
-    SAVE_STRING(module->psz_capability);
-    SAVE_IMMEDIATE(module->i_score);
-    return 0;
-error:
-    return -1;
+        memset(&m, 0, sizeof (m));
+        CacheSaveModule(w, &m, module);
+        CachePatch(w, p->modules + i * sizeof (m), &m, sizeof (m));
+    }
+    assert(i == plugin->modules_count);
+
+    p->config = CacheAppendTable(w, plugin->conf.size,
+                                 struct vlc_cache_config);
+    p->config_size = plugin->conf.size;
+    p->config_count = plugin->conf.count;
+    p->config_booleans = plugin->conf.booleans;
+
+    for (i = 0; i < plugin->conf.size && !w->error; i++)
+    {
+        struct vlc_cache_config c;
+
+        memset(&c, 0, sizeof (c));
+        CacheSaveConfig(w, &c, items + i);
+        CachePatch(w, p->config + i * sizeof (c), &c, sizeof (c));
+    }
+
+    p->textdomain = CacheString(w, plugin->textdomain);
+    p->path = CacheString(w, plugin->path);
+    p->unloadable = plugin->unloadable;
+    p->mtime = plugin->mtime;
+    p->size = plugin->size;
 }
 
 static int CacheSaveBank(FILE *file, vlc_plugin_t *const *cache, size_t n)
 {
-    uint32_t i_file_size = 0;
+    struct vlc_cache_writer w = { .error = false };
+    struct vlc_cache_header hdr = { .plugins_count = n };
+    uint32_t marker;
+    int ret = -1;
 
     /* Contains version number */
-    if (fputs (CACHE_STRING, file) == EOF)
-        goto error;
+    CacheAppend(&w, &w.data, CACHE_STRING, sizeof (CACHE_STRING) - 1, 1);
 #ifdef DISTRO_VERSION
     /* Allow binary maintaner to pass a string to detect new binary version*/
-    if (fputs( DISTRO_VERSION, file ) == EOF)
-        goto error;
+    CacheAppend(&w, &w.data, DISTRO_VERSION, sizeof (DISTRO_VERSION) - 1, 1);
 #endif
     /* Sub-version number (to avoid breakage in the dev version when cache
      * structure changes) */
-    i_file_size = CACHE_SUBVERSION_NUM;
-    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1 )
-        goto error;
+    marker = CACHE_SUBVERSION_NUM;
+    CacheAppend(&w, &w.data, &marker, sizeof (marker), 1);
 
     /* Header marker */
-    i_file_size = ftell( file );
-    if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
-        goto error;
+    marker = w.data.size;
+    CacheAppend(&w, &w.data, &marker, sizeof (marker), 1);
 
-    for (size_t i = 0; i < n; i++)
-    {
-        const vlc_plugin_t *plugin = cache[i];
-        uint32_t count = plugin->modules_count;
+    uint32_t offset = CacheAppend(&w, &w.data, NULL, sizeof (hdr), 8);
+    assert(w.error || offset == CACHE_HEADER_OFFSET);
 
-        SAVE_IMMEDIATE(count);
+    /* Reference zero is the NULL string */
+    CacheAppend(&w, &w.strings, "", 1, 1);
 
-        for (module_t *module = plugin->module;
-             module != NULL;
-             module = module->next)
-            if (CacheSaveModule(file, module))
-                goto error;
+    hdr.plugins = CacheAppendTable(&w, n, struct vlc_cache_plugin);
 
-        /* Config stuff */
-        if (CacheSaveModuleConfig(file, plugin))
-            goto error;
+    for (size_t i = 0; i < n; i++)
+    {
+        struct vlc_cache_plugin p;
 
-        /* Save common info */
-        SAVE_STRING(plugin->textdomain);
-        SAVE_STRING(plugin->path);
-        SAVE_FLAG(plugin->unloadable);
-        SAVE_IMMEDIATE(plugin->mtime);
-        SAVE_IMMEDIATE(plugin->size);
+        memset(&p, 0, sizeof (p));
+        CacheSavePlugin(&w, &p, cache[i]);
+        CachePatch(&w, hdr.plugins + i * sizeof (p), &p, sizeof (p));
     }
 
-    if (fflush (file)) /* flush libc buffers */
-        goto error;
-    return 0; /* success! */
+    hdr.strings = CacheAppend(&w, &w.data, w.strings.data, w.strings.size, 1);
+    hdr.strings_size = w.strings.size;
+    hdr.size = w.data.size;
+    CachePatch(&w, offset, &hdr, sizeof (hdr));
 
-error:
-    return -1;
+    if (!w.error
+     && fwrite(w.data.data, 1, w.data.size, file) == w.data.size
+     && fflush(file) == 0) /* flush libc buffers */
+        ret = 0; /* success! */
+
+    tdestroy(w.strings_tree, free);
+    free(w.strings.data);
+    free(w.data.data);
+    return ret;
 }
 
 /**
@@ -104,6 +104,7 @@ vlc_plugin_t *vlc_plugin_create(void)
     plugin->conf.count = 0;
     plugin->conf.booleans = 0;
 #ifdef HAVE_DYNAMIC_PLUGINS
+    atomic_init(&plugin->conf.cache, NULL);
     plugin->abspath = NULL;
     plugin->unloadable = true;
     atomic_init(&plugin->handle, 0);
@@ -130,7 +131,8 @@ void vlc_plugin_destroy(vlc_plugin_t *plugin)
     if (plugin->module != NULL)
         vlc_module_destroy(plugin->module);
 
-    config_Free(plugin->conf.items, plugin->conf.size);
+    if (plugin->conf.items != NULL) /* not if unresolved from the cache */
+        config_Free(plugin->conf.items, plugin->conf.size);
 #ifdef HAVE_DYNAMIC_PLUGINS
     free(plugin->abspath);
     free(plugin->path);
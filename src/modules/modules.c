@@ -117,10 +117,18 @@ static int module_load(vlc_logger_t *log, module_t *m,
     if (m->pf_activate != NULL)
     {
         va_list ap;
+        vlc_tick_t start = vlc_tick_now();
 
         va_copy (ap, args);
         ret = init(m->pf_activate, forced, ap);
         va_end (ap);
+
+        /* Failed probes are pure overhead, report the costly ones */
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+        if (ret != VLC_SUCCESS && elapsed >= VLC_TICK_FROM_MS(1))
+            vlc_debug(log, "%s module \"%s\" probe failed in %"PRId64" ms",
+                      m->psz_capability, module_get_object(m),
+                      MS_FROM_VLC_TICK(elapsed));
     }
 
     return ret;
@@ -167,6 +175,8 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
     }
 
     module_t *module = NULL;
+    unsigned probed = 0;
+    vlc_tick_t start = vlc_tick_now();
     va_list args;
 
     va_start(args, probe);
@@ -191,6 +201,7 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
                 continue;
             mods[i] = NULL; // only try each module once at most...
 
+            probed++;
             int ret = module_load(log, cand, probe, force, args);
             switch (ret)
             {
@@ -212,6 +223,7 @@ module_t *(vlc_module_load)(struct vlc_logger *log, const char *capability,
             if (cand == NULL || module_get_score (cand) <= 0)
                 continue;
 
+            probed++;
             int ret = module_load(log, cand, probe, false, args);
             switch (ret)
             {
@@ -230,7 +242,11 @@ done:
     if (module != NULL)
         vlc_debug(log, "using %s module \"%s\"", capability,
                   module_get_object (module));
-    else
+    vlc_tick_t elapsed = vlc_tick_now() - start;
+    if (probed > 1 && elapsed >= VLC_TICK_FROM_MS(1))
+        vlc_debug(log, "%u %s modules probed in %"PRId64" ms", probed,
+                  capability, MS_FROM_VLC_TICK(elapsed));
+    if (module == NULL)
         vlc_debug(log, "no %s modules matched", capability);
     return module;
 }
@@ -316,6 +332,7 @@ module_config_t *module_config_get( const module_t *module, unsigned *restrict p
     }
 
     unsigned i,j;
+    const module_config_t *items = vlc_plugin_conf(plugin);
     size_t size = plugin->conf.size;
     module_config_t *config = vlc_alloc( size, sizeof( *config ) );
 
@@ -327,7 +344,7 @@ module_config_t *module_config_get( const module_t *module, unsigned *restrict p
 
     for( i = 0, j = 0; i < size; i++ )
     {
-        const module_config_t *item = plugin->conf.items + i;
+        const module_config_t *item = items + i;
         if( item->b_internal /* internal option */
          || item->b_removed /* removed option */ )
             continue;
@@ -43,6 +43,11 @@ typedef struct vlc_plugin_t
         size_t size; /**< Size of items table */
         size_t count; /**< Number of configuration items */
         size_t booleans; /**< Number of booleal config items */
+#ifdef HAVE_DYNAMIC_PLUGINS
+        /** Unresolved items in the plugins cache (or NULL if resolved) */
+        const struct vlc_cache_config *_Atomic cache;
+        const struct vlc_cache_header *cache_file; /**< Plugins cache */
+#endif
     } conf;
 
 #ifdef HAVE_DYNAMIC_PLUGINS
@@ -164,7 +169,28 @@ char *vlc_dlerror(void) VLC_USED;
 /* Plugins cache */
 vlc_plugin_t *vlc_cache_load(vlc_object_t *, const char *, block_t **);
 vlc_plugin_t *vlc_cache_lookup(vlc_plugin_t **, const char *relpath);
+void vlc_cache_resolve_config(vlc_plugin_t *);
+bool vlc_cache_describe_config(const vlc_plugin_t *, size_t, uint8_t *,
+                               const char **, char *);
 
 void CacheSave(vlc_object_t *, const char *, vlc_plugin_t *const *, size_t);
 
+/**
+ * Gets the configuration items of a plugin.
+ *
+ * Items loaded from the plugins cache are only resolved on first use, so
+ * that the configuration of plugins that are never probed is never parsed.
+ *
+ * \return the table of plugin->conf.size items
+ */
+static inline module_config_t *vlc_plugin_conf(const vlc_plugin_t *plugin)
+{
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if (atomic_load_explicit(&plugin->conf.cache,
+                             memory_order_acquire) != NULL)
+        vlc_cache_resolve_config((vlc_plugin_t *)plugin);
+#endif
+    return plugin->conf.items;
+}
+
 #endif /* !LIBVLC_MODULES_H */
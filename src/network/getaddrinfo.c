@@ -35,6 +35,10 @@
 
 #include <sys/types.h>
 #include <vlc_network.h>
+#include <vlc_list.h>
+#include <vlc_variables.h>
+
+#include "../libvlc.h"
 
 int vlc_getnameinfo( const struct sockaddr *sa, int salen,
                      char *host, int hostlen, int *portnum, int flags )
@@ -129,3 +133,266 @@ int vlc_getaddrinfo_i11e(const char *node, unsigned port,
     return vlc_getaddrinfo(node, port, hints, res);
 }
 #endif
+
+/*
+ * Process-wide cache of host names resolutions.
+ *
+ * getaddrinfo() does not report the DNS records TTL, so the entries are kept
+ * for the fixed "dns-cache-ttl" duration.
+ */
+#define DNS_CACHE_MAX 32
+#define DNS_PREFETCH_MAX 4
+
+struct vlc_dns_entry
+{
+    struct vlc_list node; /**< most recently resolved first */
+    char *name;
+    struct addrinfo hints;
+    vlc_tick_t expiry;
+    struct addrinfo *res; /**< resolved without port */
+};
+
+static vlc_mutex_t dns_lock = VLC_STATIC_MUTEX;
+static struct vlc_list dns_entries = VLC_LIST_INITIALIZER(&dns_entries);
+static unsigned dns_count;
+static unsigned dns_prefetching;
+
+static bool vlc_dns_HintsMatch(const struct addrinfo *a,
+                               const struct addrinfo *b)
+{
+    return a->ai_family == b->ai_family && a->ai_socktype == b->ai_socktype
+        && a->ai_protocol == b->ai_protocol && a->ai_flags == b->ai_flags;
+}
+
+static void vlc_dns_EntryDelete(struct vlc_dns_entry *entry)
+{
+    vlc_list_remove(&entry->node);
+    dns_count--;
+    freeaddrinfo(entry->res);
+    free(entry->name);
+    free(entry);
+}
+
+/* Copy a resolution for the caller, with the requested port */
+static int vlc_dns_Copy(const struct addrinfo *src, unsigned port,
+                        struct addrinfo **res)
+{
+    struct addrinfo *head = NULL, **pp = &head;
+
+    for (const struct addrinfo *p = src; p != NULL; p = p->ai_next)
+    {
+        struct addrinfo *ai = malloc(sizeof (*ai) + p->ai_addrlen);
+        if (unlikely(ai == NULL))
+        {
+            vlc_dns_Free(head);
+            return EAI_MEMORY;
+        }
+        *ai = *p;
+        ai->ai_addr = (struct sockaddr *)(ai + 1);
+        memcpy(ai->ai_addr, p->ai_addr, p->ai_addrlen);
+        ai->ai_canonname = NULL;
+        if (p->ai_canonname != NULL)
+            ai->ai_canonname = strdup(p->ai_canonname);
+        ai->ai_next = NULL;
+
+        switch (ai->ai_family)
+        {
+            case AF_INET:
+                ((struct sockaddr_in *)ai->ai_addr)->sin_port = htons(port);
+                break;
+#ifdef AF_INET6
+            case AF_INET6:
+                ((struct sockaddr_in6 *)ai->ai_addr)->sin6_port = htons(port);
+                break;
+#endif
+        }
+
+        *pp = ai;
+        pp = &ai->ai_next;
+    }
+
+    *res = head;
+    return 0;
+}
+
+/* Looks the name up in the cache, the lock must be held */
+static struct vlc_dns_entry *vlc_dns_Lookup(const char *name,
+                                            const struct addrinfo *hints)
+{
+    vlc_tick_t now = vlc_tick_now();
+    struct vlc_dns_entry *entry;
+
+    vlc_list_foreach(entry, &dns_entries, node)
+    {
+        if (entry->expiry <= now)
+            vlc_dns_EntryDelete(entry);
+        else if (!strcmp(entry->name, name)
+              && vlc_dns_HintsMatch(&entry->hints, hints))
+            return entry;
+    }
+    return NULL;
+}
+
+/* Takes ownership of the resolution */
+static void vlc_dns_Store(const char *name, const struct addrinfo *hints,
+                          struct addrinfo *res, vlc_tick_t ttl)
+{
+    struct vlc_dns_entry *entry = malloc(sizeof (*entry));
+    if (unlikely(entry == NULL))
+    {
+        freeaddrinfo(res);
+        return;
+    }
+    entry->name = strdup(name);
+    if (unlikely(entry->name == NULL))
+    {
+        free(entry);
+        freeaddrinfo(res);
+        return;
+    }
+    entry->hints = *hints;
+    entry->expiry = vlc_tick_now() + ttl;
+    entry->res = res;
+
+    vlc_mutex_lock(&dns_lock);
+    struct vlc_dns_entry *old = vlc_dns_Lookup(name, hints);
+    if (old != NULL)
+        vlc_dns_EntryDelete(old);
+    if (dns_count >= DNS_CACHE_MAX)
+        vlc_dns_EntryDelete(vlc_list_last_entry_or_null(&dns_entries,
+                                                        struct vlc_dns_entry,
+                                                        node));
+    vlc_list_prepend(&entry->node, &dns_entries);
+    dns_count++;
+    vlc_mutex_unlock(&dns_lock);
+}
+
+static const struct addrinfo vlc_dns_no_hints;
+
+int vlc_dns_Resolve(vlc_object_t *obj, const char *name, unsigned port,
+                    const struct addrinfo *hints, struct addrinfo **res)
+{
+    /* Without an object (e.g. plain HTTP proxies), there is no cache TTL */
+    vlc_tick_t ttl = (obj != NULL)
+        ? VLC_TICK_FROM_SEC(var_InheritInteger(obj, "dns-cache-ttl")) : 0;
+    struct addrinfo *ai;
+    int val;
+
+    if (hints == NULL)
+        hints = &vlc_dns_no_hints;
+
+    if (port > 65535)
+        return EAI_SERVICE;
+
+    if (ttl <= 0 || name == NULL || name[0] == '\0'
+     || (hints->ai_flags & AI_PASSIVE))
+    {
+        val = vlc_getaddrinfo_i11e(name, port, hints, &ai);
+        if (val == 0)
+        {
+            val = vlc_dns_Copy(ai, port, res);
+            freeaddrinfo(ai);
+        }
+        return val;
+    }
+
+    vlc_mutex_lock(&dns_lock);
+    struct vlc_dns_entry *entry = vlc_dns_Lookup(name, hints);
+    if (entry != NULL)
+    {
+        val = vlc_dns_Copy(entry->res, port, res);
+        vlc_mutex_unlock(&dns_lock);
+        msg_Dbg(obj, "resolved %s from the cache", name);
+        return val;
+    }
+    vlc_mutex_unlock(&dns_lock);
+
+    val = vlc_getaddrinfo_i11e(name, 0, hints, &ai);
+    if (val != 0)
+        return val;
+
+    val = vlc_dns_Copy(ai, port, res);
+    vlc_dns_Store(name, hints, ai, ttl);
+    return val;
+}
+
+void vlc_dns_Free(struct addrinfo *res)
+{
+    while (res != NULL)
+    {
+        struct addrinfo *next = res->ai_next;
+
+        free(res->ai_canonname);
+        free(res);
+        res = next;
+    }
+}
+
+struct vlc_dns_prefetch
+{
+    vlc_tick_t ttl;
+    char name[];
+};
+
+static void *vlc_dns_PrefetchThread(void *data)
+{
+    struct vlc_dns_prefetch *req = data;
+    static const struct addrinfo hints =
+    {
+        .ai_socktype = SOCK_STREAM,
+        .ai_protocol = IPPROTO_TCP,
+    };
+    struct addrinfo *res;
+
+    /* same hints as vlc_tls_SocketOpenTCP() and vlc_tls_SocketOpenTLS() */
+    if (vlc_getaddrinfo(req->name, 0, &hints, &res) == 0)
+        vlc_dns_Store(req->name, &hints, res, req->ttl);
+
+    vlc_mutex_lock(&dns_lock);
+    dns_prefetching--;
+    vlc_mutex_unlock(&dns_lock);
+    free(req);
+    return NULL;
+}
+
+void vlc_dns_Prefetch(vlc_object_t *obj, const char *name)
+{
+    vlc_tick_t ttl = VLC_TICK_FROM_SEC(var_InheritInteger(obj,
+                                                          "dns-cache-ttl"));
+    if (ttl <= 0 || name == NULL || name[0] == '\0')
+        return;
+
+    static const struct addrinfo hints =
+    {
+        .ai_socktype = SOCK_STREAM,
+        .ai_protocol = IPPROTO_TCP,
+    };
+
+    vlc_mutex_lock(&dns_lock);
+    if (dns_prefetching >= DNS_PREFETCH_MAX || vlc_dns_Lookup(name, &hints))
+    {
+        vlc_mutex_unlock(&dns_lock);
+        return;
+    }
+    dns_prefetching++;
+    vlc_mutex_unlock(&dns_lock);
+
+    size_t len = strlen(name) + 1;
+    struct vlc_dns_prefetch *req = malloc(sizeof (*req) + len);
+    if (likely(req != NULL))
+    {
+        req->ttl = ttl;
+        memcpy(req->name, name, len);
+        if (vlc_clone_detach(NULL, vlc_dns_PrefetchThread, req,
+                             VLC_THREAD_PRIORITY_LOW) == 0)
+        {
+            msg_Dbg(obj, "prefetching %s address", name);
+            return;
+        }
+        free(req);
+    }
+
+    vlc_mutex_lock(&dns_lock);
+    dns_prefetching--;
+    vlc_mutex_unlock(&dns_lock);
+}
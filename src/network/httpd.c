@@ -29,6 +29,7 @@
 #include <stdatomic.h>
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include <vlc_httpd.h>
 
 #include <assert.h>
@@ -54,6 +55,15 @@
 #ifdef HAVE_POLL
 # include <poll.h>
 #endif
+#if defined(HAVE_SYS_EPOLL_H)
+# include <sys/epoll.h>
+# define HTTPD_EVENT_LOOP 1
+#elif defined(HAVE_SYS_EVENT_H)
+# include <sys/types.h>
+# include <sys/event.h>
+# include <sys/time.h>
+# define HTTPD_EVENT_LOOP 1
+#endif
 
 #if defined(_WIN32)
 #   include <winsock2.h>
@@ -68,8 +78,28 @@
 #define HTTPD_CL_BUFSIZE 10000
 #endif
 
+/* Maximum number of ready sockets handled per event loop iteration */
+#define HTTPD_EVENTS_MAX 64
+
+/* Maximum number of shared stream segments sent with a single writev() */
+#define HTTPD_SEGMENTS_MAX 32
+
 static void httpd_ClientDestroy(httpd_client_t *cl);
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data);
+
+/* Stream data chunk, shared by all the clients of a stream */
+typedef struct httpd_segment_t
+{
+    vlc_atomic_rc_t rc;
+    int64_t i_pos;      /* absolute position of the first byte */
+    size_t  i_size;
+    uint8_t p_data[];
+} httpd_segment_t;
+
+static void httpd_SegmentRelease(httpd_segment_t *seg)
+{
+    if (vlc_atomic_rc_dec(&seg->rc))
+        free(seg);
+}
 
 /* each host run in his own thread */
 struct httpd_host_t
@@ -97,6 +127,9 @@ struct httpd_host_t
     size_t client_count;
     struct vlc_list clients;
 
+    /* epoll/kqueue handle with persistent registrations, or -1 for poll() */
+    int poller;
+
     /* TLS data */
     vlc_tls_server_t *p_tls;
 };
@@ -161,6 +194,15 @@ struct httpd_client_t
      */
     int64_t i_keyframe_wait_to_pass;
 
+    /* file descriptor and events registered with the host poller */
+    int     poll_fd;
+    short   poll_events;
+
+    /* stream data to send after p_buffer, without copying */
+    httpd_segment_t *segments[HTTPD_SEGMENTS_MAX];
+    unsigned i_segments;
+    size_t   i_segment_offset;  /* bytes of segments[0] already sent */
+
     /* */
     httpd_message_t query;  /* client -> httpd */
     httpd_message_t answer; /* httpd -> client */
@@ -606,68 +648,125 @@ struct httpd_stream_t
     bool        b_has_keyframes;
     int64_t     i_last_keyframe_seen_pos;
 
-    /* circular buffer */
-    int         i_buffer_size;      /* buffer size, can't be reallocated smaller */
-    uint8_t     *p_buffer;          /* buffer */
+    /* Replayed streams keep all their data: new connections get it from
+     * the start, and are closed once they got it all after the end */
+    bool        b_replay;
+    bool        b_ended;
+
+    /* ring of shared segments */
+    int64_t     i_buffer_size;      /* maximum amount of buffered data */
     int64_t     i_buffer_pos;       /* absolute position from beginning */
     int64_t     i_buffer_last_pos;  /* a new connection will start with that */
+    httpd_segment_t **pp_segments;
+    size_t      i_segments_alloc;   /* ring capacity (power of two) */
+    size_t      i_segments_first;   /* ring index of the oldest segment */
+    size_t      i_segments;
+    int64_t     i_segments_bytes;
 
     /* custom headers */
     size_t        i_http_headers;
     httpd_header * p_http_headers;
 };
 
-static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
-                                 httpd_client_t *cl, httpd_message_t *answer,
-                                 const httpd_message_t *query)
+static httpd_segment_t *httpd_StreamSegment(const httpd_stream_t *stream,
+                                            size_t i)
 {
-    httpd_stream_t *stream = (httpd_stream_t*)p_sys;
+    assert(i < stream->i_segments);
+    return stream->pp_segments[(stream->i_segments_first + i)
+                               & (stream->i_segments_alloc - 1)];
+}
 
-    if (!answer || !query || !cl)
-        return VLC_SUCCESS;
+/* Finds the segment containing a given stream position */
+static size_t httpd_StreamFind(const httpd_stream_t *stream, int64_t i_pos)
+{
+    size_t lo = 0, hi = stream->i_segments;
 
-    if (answer->i_body_offset > 0) {
-        int     i_pos;
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+
+        if (httpd_StreamSegment(stream, mid)->i_pos <= i_pos)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
 
-        if (answer->i_body_offset >= stream->i_buffer_pos)
+/* Attaches the next buffered segments to the client. The payloads are
+ * shared with the other clients and sent from httpd_ClientSend(). */
+static int httpd_StreamAttach(httpd_stream_t *stream, httpd_client_t *cl,
+                              httpd_message_t *answer)
+{
+    if (answer->i_body_offset >= stream->i_buffer_pos) {
+        if (!stream->b_ended)
             return VLC_EGENERIC;    /* wait, no data available */
 
-        if (cl->i_keyframe_wait_to_pass >= 0) {
-            if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
-                /* still waiting for the next keyframe */
-                return VLC_EGENERIC;
+        /* everything was sent, an empty answer ends the connection */
+        answer->i_proto  = HTTPD_PROTO_HTTP;
+        answer->i_version= 0;
+        answer->i_type   = HTTPD_MSG_ANSWER;
+        answer->i_body = 0;
+        answer->p_body = NULL;
+        answer->i_body_offset = 0;
+        httpd_MsgAdd(answer, "Connection", "close");
+        return VLC_SUCCESS;
+    }
 
-            /* seek to the new keyframe */
-            answer->i_body_offset = stream->i_last_keyframe_seen_pos;
-            cl->i_keyframe_wait_to_pass = -1;
-        }
+    if (cl->i_keyframe_wait_to_pass >= 0) {
+        if (stream->i_last_keyframe_seen_pos <= cl->i_keyframe_wait_to_pass)
+            /* still waiting for the next keyframe */
+            return VLC_EGENERIC;
 
-        if (answer->i_body_offset + stream->i_buffer_size < stream->i_buffer_pos)
-            answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
+        /* seek to the new keyframe */
+        answer->i_body_offset = stream->i_last_keyframe_seen_pos;
+        cl->i_keyframe_wait_to_pass = -1;
+    }
 
-        i_pos   = answer->i_body_offset % stream->i_buffer_size;
-        int64_t i_write = stream->i_buffer_pos - answer->i_body_offset;
+    assert(stream->i_segments > 0);
+    if (answer->i_body_offset < httpd_StreamSegment(stream, 0)->i_pos)
+        answer->i_body_offset = stream->i_buffer_last_pos; /* this client isn't fast enough */
 
-        if (i_write > HTTPD_CL_BUFSIZE)
-            i_write = HTTPD_CL_BUFSIZE;
-        else if (i_write <= 0)
-            return VLC_EGENERIC;    /* wait, no data available */
+    size_t i = httpd_StreamFind(stream, answer->i_body_offset);
+    httpd_segment_t *seg = httpd_StreamSegment(stream, i);
+    int64_t i_write = seg->i_pos - answer->i_body_offset;
 
-        /* Don't go past the end of the circular buffer */
-        i_write = __MIN(i_write, stream->i_buffer_size - i_pos);
+    assert(cl->i_segments == 0);
+    cl->i_segment_offset = answer->i_body_offset - seg->i_pos;
 
-        /* using HTTPD_MSG_ANSWER -> data available */
-        answer->i_proto  = HTTPD_PROTO_HTTP;
-        answer->i_version= 0;
-        answer->i_type   = HTTPD_MSG_ANSWER;
+    while (i < stream->i_segments && cl->i_segments < HTTPD_SEGMENTS_MAX) {
+        seg = httpd_StreamSegment(stream, i++);
+        vlc_atomic_rc_inc(&seg->rc);
+        cl->segments[cl->i_segments++] = seg;
+        i_write += seg->i_size;
+    }
 
-        answer->i_body = i_write;
-        answer->p_body = xmalloc(i_write);
-        memcpy(answer->p_body, &stream->p_buffer[i_pos], i_write);
+    /* using HTTPD_MSG_ANSWER -> data available */
+    answer->i_proto  = HTTPD_PROTO_HTTP;
+    answer->i_version= 0;
+    answer->i_type   = HTTPD_MSG_ANSWER;
+
+    answer->i_body = 0;
+    answer->p_body = NULL;
+
+    answer->i_body_offset += i_write;
+
+    return VLC_SUCCESS;
+}
 
-        answer->i_body_offset += i_write;
+static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
+                                 httpd_client_t *cl, httpd_message_t *answer,
+                                 const httpd_message_t *query)
+{
+    httpd_stream_t *stream = (httpd_stream_t*)p_sys;
 
+    if (!answer || !query || !cl)
         return VLC_SUCCESS;
+
+    if (answer->i_body_offset > 0) {
+        vlc_mutex_lock(&stream->lock);
+        int ret = httpd_StreamAttach(stream, cl, answer);
+        vlc_mutex_unlock(&stream->lock);
+        return ret;
     } else {
         answer->i_proto  = HTTPD_PROTO_HTTP;
         answer->i_version= 0;
@@ -701,7 +800,10 @@ static int httpd_StreamCallBack(httpd_callback_sys_t *p_sys,
                 memcpy(answer->p_body, stream->p_header, stream->i_header);
             }
             answer->i_body_offset = stream->i_buffer_last_pos;
-            if (stream->b_has_keyframes)
+            if (stream->b_replay) {
+                answer->i_body_offset = 1;
+                cl->i_keyframe_wait_to_pass = -1;
+            } else if (stream->b_has_keyframes)
                 cl->i_keyframe_wait_to_pass = stream->i_last_keyframe_seen_pos;
             else
                 cl->i_keyframe_wait_to_pass = -1;
@@ -751,7 +853,7 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
         return NULL;
 
     stream->psz_mime = NULL;
-    stream->p_buffer = NULL;
+    stream->pp_segments = NULL;
 
     stream->url = httpd_UrlNew(host, psz_url, psz_user, psz_password);
     if (!stream->url)
@@ -769,8 +871,13 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->p_header = NULL;
     stream->i_buffer_size = 5000000;    /* 5 Mo per stream */
 
-    stream->p_buffer = malloc(stream->i_buffer_size);
-    if (stream->p_buffer == NULL)
+    stream->i_segments_alloc = 64;
+    stream->i_segments_first = 0;
+    stream->i_segments = 0;
+    stream->i_segments_bytes = 0;
+    stream->pp_segments = malloc(stream->i_segments_alloc
+                                 * sizeof (*stream->pp_segments));
+    if (stream->pp_segments == NULL)
         goto error;
 
     /* We set to 1 to make life simpler
@@ -779,6 +886,8 @@ httpd_stream_t *httpd_StreamNew(httpd_host_t *host,
     stream->i_buffer_last_pos = 1;
     stream->b_has_keyframes = false;
     stream->i_last_keyframe_seen_pos = 0;
+    stream->b_replay = false;
+    stream->b_ended = false;
     stream->i_http_headers = 0;
     stream->p_http_headers = NULL;
 
@@ -802,6 +911,29 @@ error:
     return NULL;
 }
 
+httpd_stream_t *httpd_StreamNewReplay(httpd_host_t *host,
+                                      const char *psz_url, const char *psz_mime,
+                                      const char *psz_user,
+                                      const char *psz_password)
+{
+    httpd_stream_t *stream = httpd_StreamNew(host, psz_url, psz_mime,
+                                             psz_user, psz_password);
+    if (stream) {
+        vlc_mutex_lock(&stream->lock);
+        stream->b_replay = true;
+        stream->i_buffer_size = INT64_MAX;
+        vlc_mutex_unlock(&stream->lock);
+    }
+    return stream;
+}
+
+void httpd_StreamEnd(httpd_stream_t *stream)
+{
+    vlc_mutex_lock(&stream->lock);
+    stream->b_ended = true;
+    vlc_mutex_unlock(&stream->lock);
+}
+
 int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
 {
     vlc_mutex_lock(&stream->lock);
@@ -818,30 +950,58 @@ int httpd_StreamHeader(httpd_stream_t *stream, uint8_t *p_data, int i_data)
     return VLC_SUCCESS;
 }
 
-static void httpd_AppendData(httpd_stream_t *stream, uint8_t *p_data, int i_data)
+/* Appends a segment to the ring, and drops the oldest ones beyond the
+ * buffer size */
+static int httpd_StreamAppend(httpd_stream_t *stream, httpd_segment_t *seg)
 {
-    int i_pos = stream->i_buffer_pos % stream->i_buffer_size;
-    int i_count = i_data;
-    while (i_count > 0) {
-        int i_copy = __MIN(i_count, stream->i_buffer_size - i_pos);
-
-        /* Ok, we can't go past the end of our buffer */
-        memcpy(&stream->p_buffer[i_pos], p_data, i_copy);
-
-        i_pos = (i_pos + i_copy) % stream->i_buffer_size;
-        i_count -= i_copy;
-        p_data  += i_copy;
+    if (stream->i_segments == stream->i_segments_alloc) {
+        size_t alloc = stream->i_segments_alloc;
+        httpd_segment_t **pp = realloc(stream->pp_segments,
+                                       2 * alloc * sizeof (*pp));
+        if (unlikely(pp == NULL))
+            return VLC_ENOMEM;
+
+        /* unwrap the ring into the new space */
+        memcpy(pp + alloc, pp, stream->i_segments_first * sizeof (*pp));
+        stream->pp_segments = pp;
+        stream->i_segments_alloc = 2 * alloc;
     }
 
-    stream->i_buffer_pos += i_data;
+    stream->pp_segments[(stream->i_segments_first + stream->i_segments)
+                        & (stream->i_segments_alloc - 1)] = seg;
+    stream->i_segments++;
+    stream->i_segments_bytes += seg->i_size;
+    stream->i_buffer_pos += seg->i_size;
+
+    while (stream->i_segments > 1
+        && stream->i_segments_bytes > stream->i_buffer_size) {
+        httpd_segment_t *old = httpd_StreamSegment(stream, 0);
+
+        stream->i_segments_first = (stream->i_segments_first + 1)
+                                   & (stream->i_segments_alloc - 1);
+        stream->i_segments--;
+        stream->i_segments_bytes -= old->i_size;
+        httpd_SegmentRelease(old);
+    }
+    return VLC_SUCCESS;
 }
 
 int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
 {
-    if (!p_block || !p_block->p_buffer)
+    if (!p_block || !p_block->p_buffer || p_block->i_buffer == 0)
         return VLC_SUCCESS;
 
+    /* copy the data once, all the clients then share the same segment */
+    httpd_segment_t *seg = malloc(sizeof (*seg) + p_block->i_buffer);
+    if (unlikely(seg == NULL))
+        return VLC_ENOMEM;
+
+    vlc_atomic_rc_init(&seg->rc);
+    seg->i_size = p_block->i_buffer;
+    memcpy(seg->p_data, p_block->p_buffer, p_block->i_buffer);
+
     vlc_mutex_lock(&stream->lock);
+    seg->i_pos = stream->i_buffer_pos;
 
     /* save this pointer (to be used by new connection) */
     stream->i_buffer_last_pos = stream->i_buffer_pos;
@@ -851,10 +1011,12 @@ int httpd_StreamSend(httpd_stream_t *stream, const block_t *p_block)
         stream->i_last_keyframe_seen_pos = stream->i_buffer_pos;
     }
 
-    httpd_AppendData(stream, p_block->p_buffer, p_block->i_buffer);
+    int ret = httpd_StreamAppend(stream, seg);
 
     vlc_mutex_unlock(&stream->lock);
-    return VLC_SUCCESS;
+    if (ret != VLC_SUCCESS)
+        free(seg);
+    return ret;
 }
 
 void httpd_StreamDelete(httpd_stream_t *stream)
@@ -867,7 +1029,9 @@ void httpd_StreamDelete(httpd_stream_t *stream)
     free(stream->p_http_headers);
     free(stream->psz_mime);
     free(stream->p_header);
-    free(stream->p_buffer);
+    for (size_t i = 0; i < stream->i_segments; i++)
+        httpd_SegmentRelease(httpd_StreamSegment(stream, i));
+    free(stream->pp_segments);
     free(stream);
 }
 
@@ -877,6 +1041,8 @@ void httpd_StreamDelete(httpd_stream_t *stream)
 static void* httpd_HostThread(void *);
 static httpd_host_t *httpd_HostCreate(vlc_object_t *, const char *,
                                        const char *, vlc_tls_server_t *);
+static int httpd_PollerCreate(httpd_host_t *);
+static void httpd_PollerClose(httpd_host_t *);
 
 /* create a new host */
 httpd_host_t *vlc_http_HostNew(vlc_object_t *p_this)
@@ -950,6 +1116,7 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
                                               "http host");
     if (!host)
         goto error;
+    host->poller = -1;
 
     vlc_mutex_init(&host->lock);
     atomic_init(&host->ref, 1);
@@ -970,6 +1137,7 @@ static httpd_host_t *httpd_HostCreate(vlc_object_t *p_this,
     host->client_count = 0;
     vlc_list_init(&host->clients);
     host->p_tls    = p_tls;
+    host->poller   = httpd_PollerCreate(host);
 
     /* create the thread */
     if (vlc_clone(&host->thread, httpd_HostThread, host,
@@ -988,6 +1156,7 @@ error:
     vlc_mutex_unlock(&httpd.mutex);
 
     if (host) {
+        httpd_PollerClose(host);
         net_ListenClose(host->fds);
         vlc_object_delete(host);
     }
@@ -1023,6 +1192,7 @@ void httpd_HostDelete(httpd_host_t *host)
 
     assert(vlc_list_is_empty(&host->urls));
     vlc_tls_ServerDelete(host->p_tls);
+    httpd_PollerClose(host);
     net_ListenClose(host->fds);
     vlc_object_delete(host);
     vlc_mutex_unlock(&httpd.mutex);
@@ -1117,10 +1287,12 @@ void httpd_UrlDelete(httpd_url_t *url)
         if (client->url != url)
             continue;
 
-        /* TODO complete it */
+        /* The host thread destroys the client. Shutting the socket down
+         * wakes it up if it is waiting for that client. */
         msg_Warn(host, "force closing connections");
-        host->client_count--;
-        httpd_ClientDestroy(client);
+        client->url = NULL;
+        client->i_state = HTTPD_CLIENT_DEAD;
+        shutdown(vlc_tls_GetFD(client->sock), SHUT_RDWR);
     }
     free(url);
     vlc_mutex_unlock(&host->lock);
@@ -1227,6 +1399,8 @@ static void httpd_ClientDestroy(httpd_client_t *cl)
     httpd_MsgClean(&cl->answer);
     httpd_MsgClean(&cl->query);
 
+    for (unsigned i = 0; i < cl->i_segments; i++)
+        httpd_SegmentRelease(cl->segments[i]);
     free(cl->p_buffer);
     free(cl);
 }
@@ -1239,6 +1413,10 @@ static httpd_client_t *httpd_ClientNew(vlc_tls_t *sock, vlc_tick_t now)
 
     cl->sock    = sock;
     cl->url     = NULL;
+    cl->poll_fd = -1;
+    cl->poll_events = 0;
+    cl->i_segments = 0;
+    cl->i_segment_offset = 0;
 
     httpd_ClientInit(cl, now);
     return cl;
@@ -1260,6 +1438,37 @@ ssize_t httpd_NetSend (httpd_client_t *cl, const uint8_t *p, size_t i_len)
     return sock->ops->writev(sock, &iov, 1);
 }
 
+/* Sends the attached stream segments, and releases those fully sent */
+static ssize_t httpd_ClientSendSegments(httpd_client_t *cl)
+{
+    vlc_tls_t *sock = cl->sock;
+    struct iovec iov[HTTPD_SEGMENTS_MAX];
+
+    for (unsigned i = 0; i < cl->i_segments; i++) {
+        iov[i].iov_base = cl->segments[i]->p_data;
+        iov[i].iov_len = cl->segments[i]->i_size;
+    }
+    iov[0].iov_base = (uint8_t *)iov[0].iov_base + cl->i_segment_offset;
+    iov[0].iov_len -= cl->i_segment_offset;
+
+    ssize_t val = sock->ops->writev(sock, iov, cl->i_segments);
+    if (val <= 0)
+        return val;
+
+    size_t len = val;
+    unsigned i = 0;
+
+    while (i < cl->i_segments && len >= iov[i].iov_len) {
+        len -= iov[i].iov_len;
+        httpd_SegmentRelease(cl->segments[i++]);
+    }
+    cl->i_segments -= i;
+    memmove(cl->segments, cl->segments + i,
+            cl->i_segments * sizeof (cl->segments[0]));
+    cl->i_segment_offset = (i > 0) ? len : cl->i_segment_offset + len;
+    return val;
+}
+
 
 static const struct
 {
@@ -1602,11 +1811,18 @@ static void httpd_ClientSend(httpd_client_t *cl)
         cl->i_buffer_size = (uint8_t*)p - cl->p_buffer;
     }
 
-    i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
-                           cl->i_buffer_size - cl->i_buffer);
-    if (i_len >= 0) {
-        cl->i_buffer += i_len;
+    if (cl->i_segments > 0 && cl->i_buffer >= cl->i_buffer_size) {
+        i_len = httpd_ClientSendSegments(cl);
+        if (i_len >= 0 && cl->i_segments > 0)
+            return; /* shared data left to send */
+    } else {
+        i_len = httpd_NetSend(cl, &cl->p_buffer[cl->i_buffer],
+                               cl->i_buffer_size - cl->i_buffer);
+        if (i_len >= 0)
+            cl->i_buffer += i_len;
+    }
 
+    if (i_len >= 0) {
         if (cl->i_buffer >= cl->i_buffer_size) {
             if (cl->answer.i_body == 0  && cl->answer.i_body_offset > 0) {
                 /* catch more body data */
@@ -1629,7 +1845,7 @@ static void httpd_ClientSend(httpd_client_t *cl)
 
                 cl->answer.i_body = 0;
                 cl->answer.p_body = NULL;
-            } else /* send finished */
+            } else if (cl->i_segments == 0) /* send finished */
                 cl->i_state = HTTPD_CLIENT_SEND_DONE;
         }
     } else {
@@ -1696,258 +1912,321 @@ auth_failed:
     return false;
 }
 
-static void httpdLoop(httpd_host_t *host)
+/* Runs the client state machine, and returns the events to wait for */
+static short httpd_ClientPrepare(httpd_host_t *host, httpd_client_t *cl)
 {
-    struct pollfd ufd[host->nfd + host->client_count];
-    unsigned nfd;
-    for (nfd = 0; nfd < host->nfd; nfd++) {
-        ufd[nfd].fd = host->fds[nfd];
-        ufd[nfd].events = POLLIN;
-        ufd[nfd].revents = 0;
-    }
+    short events = 0;
+    int64_t i_offset;
 
-    vlc_mutex_lock(&host->lock);
-    /* add all socket that should be read/write and close dead connection */
-    vlc_tick_t now = vlc_tick_now();
-    bool b_low_delay = false;
-    httpd_client_t *cl;
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING:
+        case HTTPD_CLIENT_TLS_HS_IN:
+            events = POLLIN;
+            break;
 
-    int canc = vlc_savecancel();
-    vlc_list_foreach(cl, &host->clients, node) {
-        int64_t i_offset;
+        case HTTPD_CLIENT_SENDING:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            events = POLLOUT;
+            break;
 
-        if (cl->i_state == HTTPD_CLIENT_DEAD
-         || (cl->i_activity_timeout > 0
-          && cl->i_activity_date + cl->i_activity_timeout < now)) {
-            host->client_count--;
-            httpd_ClientDestroy(cl);
-            continue;
-        }
+        case HTTPD_CLIENT_RECEIVE_DONE: {
+            httpd_message_t *answer = &cl->answer;
+            httpd_message_t *query  = &cl->query;
+
+            httpd_MsgInit(answer);
+
+            /* Handle what we received */
+            switch (query->i_type) {
+                case HTTPD_MSG_ANSWER:
+                    cl->url     = NULL;
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                    break;
+
+                case HTTPD_MSG_OPTIONS:
+                    answer->i_type   = HTTPD_MSG_ANSWER;
+                    answer->i_proto  = query->i_proto;
+                    answer->i_status = 200;
+                    answer->i_body = 0;
+                    answer->p_body = NULL;
+
+                    httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
+                    httpd_MsgAdd(answer, "Content-Length", "0");
+
+                    switch(query->i_proto) {
+                    case HTTPD_PROTO_HTTP:
+                        answer->i_version = 1;
+                        httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
+                        break;
 
-        struct pollfd *pufd = ufd + nfd;
-        assert (pufd < ufd + ARRAY_SIZE (ufd));
+                    case HTTPD_PROTO_RTSP:
+                        answer->i_version = 0;
 
-        pufd->events = pufd->revents = 0;
+                        const char *p = httpd_MsgGet(query, "Cseq");
+                        if (p)
+                            httpd_MsgAdd(answer, "Cseq", "%s", p);
+                        p = httpd_MsgGet(query, "Timestamp");
+                        if (p)
+                            httpd_MsgAdd(answer, "Timestamp", "%s", p);
 
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING:
-            case HTTPD_CLIENT_TLS_HS_IN:
-                pufd->events = POLLIN;
-                break;
+                        p = httpd_MsgGet(query, "Require");
+                        if (p) {
+                            answer->i_status = 551;
+                            httpd_MsgAdd(query, "Unsupported", "%s", p);
+                        }
 
-            case HTTPD_CLIENT_SENDING:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                pufd->events = POLLOUT;
-                break;
+                        httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
+                                "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
+                        break;
+                    }
 
-            case HTTPD_CLIENT_RECEIVE_DONE: {
-                httpd_message_t *answer = &cl->answer;
-                httpd_message_t *query  = &cl->query;
+                    if (httpd_MsgGet(&cl->query, "Connection") != NULL)
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-                httpd_MsgInit(answer);
+                    cl->i_buffer = -1;  /* Force the creation of the answer in
+                                         * httpd_ClientSend */
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                    break;
 
-                /* Handle what we received */
-                switch (query->i_type) {
-                    case HTTPD_MSG_ANSWER:
-                        cl->url     = NULL;
+                case HTTPD_MSG_NONE:
+                    if (query->i_proto == HTTPD_PROTO_NONE) {
+                        cl->url = NULL;
                         cl->i_state = HTTPD_CLIENT_DEAD;
-                        break;
-
-                    case HTTPD_MSG_OPTIONS:
+                    } else {
+                        /* unimplemented */
+                        answer->i_proto  = query->i_proto ;
                         answer->i_type   = HTTPD_MSG_ANSWER;
-                        answer->i_proto  = query->i_proto;
-                        answer->i_status = 200;
-                        answer->i_body = 0;
-                        answer->p_body = NULL;
+                        answer->i_version= 0;
+                        answer->i_status = 501;
 
-                        httpd_MsgAdd(answer, "Server", "VLC/%s", VERSION);
-                        httpd_MsgAdd(answer, "Content-Length", "0");
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, 501, NULL);
+                        answer->p_body = (uint8_t *)p;
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Connection", "close");
 
-                        switch(query->i_proto) {
-                        case HTTPD_PROTO_HTTP:
-                            answer->i_version = 1;
-                            httpd_MsgAdd(answer, "Allow", "GET,HEAD,POST,OPTIONS");
-                            break;
-
-                        case HTTPD_PROTO_RTSP:
-                            answer->i_version = 0;
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        cl->i_state = HTTPD_CLIENT_SENDING;
+                    }
+                    break;
 
-                            const char *p = httpd_MsgGet(query, "Cseq");
-                            if (p)
-                                httpd_MsgAdd(answer, "Cseq", "%s", p);
-                            p = httpd_MsgGet(query, "Timestamp");
-                            if (p)
-                                httpd_MsgAdd(answer, "Timestamp", "%s", p);
+                default: {
+                    httpd_url_t *url;
+                    int i_msg = query->i_type;
+                    bool b_auth_failed = false;
 
-                            p = httpd_MsgGet(query, "Require");
-                            if (p) {
-                                answer->i_status = 551;
-                                httpd_MsgAdd(query, "Unsupported", "%s", p);
-                            }
+                    /* Search the url and trigger callbacks */
+                    vlc_list_foreach(url, &host->urls, node) {
+                        if (strcmp(url->psz_url, query->psz_url))
+                            continue;
+                        if (!url->catch[i_msg].cb)
+                            continue;
 
-                            httpd_MsgAdd(answer, "Public", "DESCRIBE,SETUP,"
-                                    "TEARDOWN,PLAY,PAUSE,GET_PARAMETER");
-                            break;
+                        if (answer) {
+                            b_auth_failed = !httpdAuthOk(url->psz_user,
+                               url->psz_password,
+                               httpd_MsgGet(query, "Authorization")); /* BASIC id */
+                            if (b_auth_failed)
+                               break;
                         }
 
-                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                            httpd_MsgAdd(answer, "Connection", "close");
+                        if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
+                            continue;
 
-                        cl->i_buffer = -1;  /* Force the creation of the answer in
-                                             * httpd_ClientSend */
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                        break;
+                        if (answer->i_proto == HTTPD_PROTO_NONE)
+                            cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
+                        else
+                            cl->i_buffer = -1;
 
-                    case HTTPD_MSG_NONE:
-                        if (query->i_proto == HTTPD_PROTO_NONE) {
-                            cl->url = NULL;
-                            cl->i_state = HTTPD_CLIENT_DEAD;
-                        } else {
-                            /* unimplemented */
-                            answer->i_proto  = query->i_proto ;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-                            answer->i_status = 501;
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, 501, NULL);
-                            answer->p_body = (uint8_t *)p;
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        /* only one url can answer */
+                        answer = NULL;
+                        if (!cl->url)
+                            cl->url = url;
+                    }
+
+                    if (answer) {
+                        answer->i_proto  = query->i_proto;
+                        answer->i_type   = HTTPD_MSG_ANSWER;
+                        answer->i_version= 0;
+
+                       if (b_auth_failed) {
+                            httpd_MsgAdd(answer, "WWW-Authenticate",
+                                    "Basic realm=\"VLC stream\"");
+                            answer->i_status = 401;
+                        } else
+                            answer->i_status = 404; /* no url registered */
+
+                        char *p;
+                        answer->i_body = httpd_HtmlError (&p, answer->i_status,
+                                query->psz_url);
+                        answer->p_body = (uint8_t *)p;
+
+                        cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
+                        httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
+                        httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
+                        if (httpd_MsgGet(&cl->query, "Connection") != NULL)
                             httpd_MsgAdd(answer, "Connection", "close");
+                    }
 
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            cl->i_state = HTTPD_CLIENT_SENDING;
-                        }
-                        break;
+                    cl->i_state = HTTPD_CLIENT_SENDING;
+                }
+            }
+            break;
+        }
 
-                    default: {
-                        httpd_url_t *url;
-                        int i_msg = query->i_type;
-                        bool b_auth_failed = false;
-
-                        /* Search the url and trigger callbacks */
-                        vlc_list_foreach(url, &host->urls, node) {
-                            if (strcmp(url->psz_url, query->psz_url))
-                                continue;
-                            if (!url->catch[i_msg].cb)
-                                continue;
-
-                            if (answer) {
-                                b_auth_failed = !httpdAuthOk(url->psz_user,
-                                   url->psz_password,
-                                   httpd_MsgGet(query, "Authorization")); /* BASIC id */
-                                if (b_auth_failed)
-                                   break;
-                            }
-
-                            if (url->catch[i_msg].cb(url->catch[i_msg].p_sys, cl, answer, query))
-                                continue;
-
-                            if (answer->i_proto == HTTPD_PROTO_NONE)
-                                cl->i_buffer = cl->i_buffer_size; /* Raw answer from a CGI */
-                            else
-                                cl->i_buffer = -1;
-
-                            /* only one url can answer */
-                            answer = NULL;
-                            if (!cl->url)
-                                cl->url = url;
-                        }
+        case HTTPD_CLIENT_SEND_DONE:
+            if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
+                bool do_close = false;
 
-                        if (answer) {
-                            answer->i_proto  = query->i_proto;
-                            answer->i_type   = HTTPD_MSG_ANSWER;
-                            answer->i_version= 0;
-
-                           if (b_auth_failed) {
-                                httpd_MsgAdd(answer, "WWW-Authenticate",
-                                        "Basic realm=\"VLC stream\"");
-                                answer->i_status = 401;
-                            } else
-                                answer->i_status = 404; /* no url registered */
-
-                            char *p;
-                            answer->i_body = httpd_HtmlError (&p, answer->i_status,
-                                    query->psz_url);
-                            answer->p_body = (uint8_t *)p;
-
-                            cl->i_buffer = -1;  /* Force the creation of the answer in httpd_ClientSend */
-                            httpd_MsgAdd(answer, "Content-Length", "%d", answer->i_body);
-                            httpd_MsgAdd(answer, "Content-Type", "%s", "text/html");
-                            if (httpd_MsgGet(&cl->query, "Connection") != NULL)
-                                httpd_MsgAdd(answer, "Connection", "close");
-                        }
+                cl->url = NULL;
 
-                        cl->i_state = HTTPD_CLIENT_SENDING;
-                    }
+                if (cl->query.i_proto != HTTPD_PROTO_HTTP
+                 || cl->query.i_version > 0)
+                {
+                    const char *psz_connection = httpd_MsgGet(&cl->answer,
+                                                             "Connection");
+                    if (psz_connection != NULL)
+                        do_close = !strcasecmp(psz_connection, "close");
                 }
-                break;
+                else
+                    do_close = true;
+
+                if (!do_close) {
+                    httpd_MsgClean(&cl->query);
+                    httpd_MsgInit(&cl->query);
+
+                    cl->i_buffer = 0;
+                    cl->i_buffer_size = 1000;
+                    free(cl->p_buffer);
+                    // Allocate an extra byte for the null terminating byte
+                    cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
+                    cl->i_state = HTTPD_CLIENT_RECEIVING;
+                } else
+                    cl->i_state = HTTPD_CLIENT_DEAD;
+                httpd_MsgClean(&cl->answer);
+            } else {
+                i_offset = cl->answer.i_body_offset;
+                httpd_MsgClean(&cl->answer);
+
+                cl->answer.i_body_offset = i_offset;
+                free(cl->p_buffer);
+                cl->p_buffer = NULL;
+                cl->i_buffer = 0;
+                cl->i_buffer_size = 0;
+
+                cl->i_state = HTTPD_CLIENT_WAITING;
             }
+            break;
 
-            case HTTPD_CLIENT_SEND_DONE:
-                if (!cl->b_stream_mode || cl->answer.i_body_offset == 0) {
-                    bool do_close = false;
+        case HTTPD_CLIENT_WAITING:
+            i_offset = cl->answer.i_body_offset;
+            int i_msg = cl->query.i_type;
 
-                    cl->url = NULL;
+            httpd_MsgInit(&cl->answer);
+            cl->answer.i_body_offset = i_offset;
 
-                    if (cl->query.i_proto != HTTPD_PROTO_HTTP
-                     || cl->query.i_version > 0)
-                    {
-                        const char *psz_connection = httpd_MsgGet(&cl->answer,
-                                                                 "Connection");
-                        if (psz_connection != NULL)
-                            do_close = !strcasecmp(psz_connection, "close");
-                    }
-                    else
-                        do_close = true;
-
-                    if (!do_close) {
-                        httpd_MsgClean(&cl->query);
-                        httpd_MsgInit(&cl->query);
-
-                        cl->i_buffer = 0;
-                        cl->i_buffer_size = 1000;
-                        free(cl->p_buffer);
-                        // Allocate an extra byte for the null terminating byte
-                        cl->p_buffer = xmalloc(cl->i_buffer_size + 1);
-                        cl->i_state = HTTPD_CLIENT_RECEIVING;
-                    } else
-                        cl->i_state = HTTPD_CLIENT_DEAD;
-                    httpd_MsgClean(&cl->answer);
-                } else {
-                    i_offset = cl->answer.i_body_offset;
-                    httpd_MsgClean(&cl->answer);
+            cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
+                    &cl->answer, &cl->query);
+            if (cl->answer.i_type != HTTPD_MSG_NONE) {
+                /* we have new data, so re-enter send mode */
+                cl->i_buffer      = 0;
+                cl->p_buffer      = cl->answer.p_body;
+                cl->i_buffer_size = cl->answer.i_body;
+                cl->answer.p_body = NULL;
+                cl->answer.i_body = 0;
+                cl->i_state = HTTPD_CLIENT_SENDING;
+            }
+    }
+    return events;
+}
 
-                    cl->answer.i_body_offset = i_offset;
-                    free(cl->p_buffer);
-                    cl->p_buffer = NULL;
-                    cl->i_buffer = 0;
-                    cl->i_buffer_size = 0;
+static void httpd_ClientHandle(httpd_host_t *host, httpd_client_t *cl,
+                               vlc_tick_t now)
+{
+    cl->i_activity_date = now;
 
-                    cl->i_state = HTTPD_CLIENT_WAITING;
-                }
-                break;
+    switch (cl->i_state) {
+        case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
+        case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
+        case HTTPD_CLIENT_TLS_HS_IN:
+        case HTTPD_CLIENT_TLS_HS_OUT:
+            httpd_ClientTlsHandshake(host, cl);
+            break;
+    }
+}
 
-            case HTTPD_CLIENT_WAITING:
-                i_offset = cl->answer.i_body_offset;
-                int i_msg = cl->query.i_type;
+/* Accepts a new connection on a listening socket */
+static void httpd_HostAccept(httpd_host_t *host, int fd, vlc_tick_t now)
+{
+    httpd_client_t *cl;
 
-                httpd_MsgInit(&cl->answer);
-                cl->answer.i_body_offset = i_offset;
+    /* */
+    fd = vlc_accept (fd, NULL, NULL, true);
+    if (fd == -1)
+        return;
+    setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
+            &(int){ 1 }, sizeof(int));
 
-                cl->url->catch[i_msg].cb(cl->url->catch[i_msg].p_sys, cl,
-                        &cl->answer, &cl->query);
-                if (cl->answer.i_type != HTTPD_MSG_NONE) {
-                    /* we have new data, so re-enter send mode */
-                    cl->i_buffer      = 0;
-                    cl->p_buffer      = cl->answer.p_body;
-                    cl->i_buffer_size = cl->answer.i_body;
-                    cl->answer.p_body = NULL;
-                    cl->answer.i_body = 0;
-                    cl->i_state = HTTPD_CLIENT_SENDING;
-                }
+    vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
+    if (unlikely(sk == NULL))
+    {
+        vlc_close(fd);
+        return;
+    }
+
+    if (host->p_tls != NULL)
+    {
+        const char *alpn[] = { "http/1.1", NULL };
+        vlc_tls_t *tls;
+
+        tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
+        if (tls == NULL)
+        {
+            vlc_tls_SessionDelete(sk);
+            return;
         }
+        sk = tls;
+    }
 
+    cl = httpd_ClientNew(sk, now);
+
+    if (host->p_tls != NULL)
+        cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+
+    host->client_count++;
+    vlc_list_append(&cl->node, &host->clients);
+}
+
+static void httpdLoop(httpd_host_t *host)
+{
+    struct pollfd ufd[host->nfd + host->client_count];
+    unsigned nfd;
+    for (nfd = 0; nfd < host->nfd; nfd++) {
+        ufd[nfd].fd = host->fds[nfd];
+        ufd[nfd].events = POLLIN;
+        ufd[nfd].revents = 0;
+    }
+
+    vlc_mutex_lock(&host->lock);
+    /* add all socket that should be read/write and close dead connection */
+    vlc_tick_t now = vlc_tick_now();
+    bool b_low_delay = false;
+    httpd_client_t *cl;
+
+    int canc = vlc_savecancel();
+    vlc_list_foreach(cl, &host->clients, node) {
+        if (cl->i_state == HTTPD_CLIENT_DEAD
+         || (cl->i_activity_timeout > 0
+          && cl->i_activity_date + cl->i_activity_timeout < now)) {
+            host->client_count--;
+            httpd_ClientDestroy(cl);
+            continue;
+        }
+
+        struct pollfd *pufd = ufd + nfd;
+        assert (pufd < ufd + ARRAY_SIZE (ufd));
+
+        pufd->revents = 0;
+        pufd->events = httpd_ClientPrepare(host, cl);
         pufd->fd = vlc_tls_GetPollFD(cl->sock, &pufd->events);
 
         if (pufd->events != 0)
@@ -1983,74 +2262,232 @@ static void httpdLoop(httpd_host_t *host)
         if (pufd->revents == 0)
             continue; // no event received
 
-        cl->i_activity_date = now;
-
-        switch (cl->i_state) {
-            case HTTPD_CLIENT_RECEIVING: httpd_ClientRecv(cl); break;
-            case HTTPD_CLIENT_SENDING:   httpd_ClientSend(cl); break;
-            case HTTPD_CLIENT_TLS_HS_IN:
-            case HTTPD_CLIENT_TLS_HS_OUT:
-                httpd_ClientTlsHandshake(host, cl);
-                break;
-        }
+        httpd_ClientHandle(host, cl, now);
     }
 
     /* Handle server sockets (accept new connections) */
     for (nfd = 0; nfd < host->nfd; nfd++) {
-        int fd = ufd[nfd].fd;
-
-        assert (fd == host->fds[nfd]);
+        assert (ufd[nfd].fd == host->fds[nfd]);
 
         if (ufd[nfd].revents == 0)
             continue;
 
-        /* */
-        fd = vlc_accept (fd, NULL, NULL, true);
-        if (fd == -1)
-            continue;
-        setsockopt (fd, SOL_SOCKET, SO_REUSEADDR,
-                &(int){ 1 }, sizeof(int));
+        httpd_HostAccept(host, ufd[nfd].fd, now);
+    }
 
-        vlc_tls_t *sk = vlc_tls_SocketOpen(fd);
-        if (unlikely(sk == NULL))
+    vlc_mutex_unlock(&host->lock);
+    vlc_restorecancel(canc);
+}
+
+#ifdef HTTPD_EVENT_LOOP
+/*
+ * Event loop backend: sockets stay registered with the kernel, and
+ * registrations are only updated when a client changes the events it waits
+ * for, so that waiting and dispatching do not scale with the client count.
+ * Level-triggered notifications are used, as the client handlers process at
+ * most one chunk of data per wake-up.
+ */
+static int httpd_PollerCreate(httpd_host_t *host)
+{
+# ifdef HAVE_SYS_EPOLL_H
+    int fd = epoll_create1(EPOLL_CLOEXEC);
+# else
+    int fd = kqueue();
+# endif
+    if (fd == -1) {
+        msg_Warn(host, "cannot create event poller: %s",
+                 vlc_strerror_c(errno));
+        return -1;
+    }
+
+    for (unsigned i = 0; i < host->nfd; i++) {
+# ifdef HAVE_SYS_EPOLL_H
+        struct epoll_event ev = {
+            .events = EPOLLIN,
+            .data.ptr = &host->fds[i],
+        };
+        if (epoll_ctl(fd, EPOLL_CTL_ADD, host->fds[i], &ev))
+# else
+        struct kevent ev;
+
+        EV_SET(&ev, host->fds[i], EVFILT_READ, EV_ADD, 0, 0, &host->fds[i]);
+        if (kevent(fd, &ev, 1, NULL, 0, NULL))
+# endif
         {
+            msg_Warn(host, "cannot register listening socket: %s",
+                     vlc_strerror_c(errno));
             vlc_close(fd);
-            continue;
+            return -1;
         }
+    }
+    return fd;
+}
 
-        if (host->p_tls != NULL)
-        {
-            const char *alpn[] = { "http/1.1", NULL };
-            vlc_tls_t *tls;
-
-            tls = vlc_tls_ServerSessionCreate(host->p_tls, sk, alpn);
-            if (tls == NULL)
-            {
-                vlc_tls_SessionDelete(sk);
-                continue;
-            }
-            sk = tls;
+static void httpd_PollerClose(httpd_host_t *host)
+{
+    if (host->poller != -1)
+        vlc_close(host->poller);
+}
+
+/* Updates the events the poller waits for, for a given client */
+static void httpd_PollerUpdate(httpd_host_t *host, httpd_client_t *cl,
+                               int fd, short events)
+{
+    if (fd == cl->poll_fd && events == cl->poll_events)
+        return;
+
+# ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev = {
+        .events = ((events & POLLIN) ? EPOLLIN : 0)
+                | ((events & POLLOUT) ? EPOLLOUT : 0),
+        .data.ptr = cl,
+    };
+    int val = 0;
+
+    if (cl->poll_events != 0 && (events == 0 || fd != cl->poll_fd))
+        val = epoll_ctl(host->poller, EPOLL_CTL_DEL, cl->poll_fd, NULL);
+    if (val == 0 && events != 0)
+        val = epoll_ctl(host->poller,
+                        (cl->poll_events != 0 && fd == cl->poll_fd)
+                            ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+# else
+    struct kevent ev[4];
+    int n = 0;
+    const bool refd = fd != cl->poll_fd;
+
+    if ((cl->poll_events & POLLIN) && (refd || !(events & POLLIN)))
+        EV_SET(&ev[n++], cl->poll_fd, EVFILT_READ, EV_DELETE, 0, 0, cl);
+    if ((cl->poll_events & POLLOUT) && (refd || !(events & POLLOUT)))
+        EV_SET(&ev[n++], cl->poll_fd, EVFILT_WRITE, EV_DELETE, 0, 0, cl);
+    if ((events & POLLIN) && (refd || !(cl->poll_events & POLLIN)))
+        EV_SET(&ev[n++], fd, EVFILT_READ, EV_ADD, 0, 0, cl);
+    if ((events & POLLOUT) && (refd || !(cl->poll_events & POLLOUT)))
+        EV_SET(&ev[n++], fd, EVFILT_WRITE, EV_ADD, 0, 0, cl);
+
+    int val = kevent(host->poller, ev, n, NULL, 0, NULL);
+# endif
+    if (val) {
+        msg_Err(host, "cannot register client socket: %s",
+                vlc_strerror_c(errno));
+        cl->i_state = HTTPD_CLIENT_DEAD;
+        events = 0;
+    }
+
+    cl->poll_fd = fd;
+    cl->poll_events = events;
+}
+
+/* Waits for ready sockets and returns their registration data */
+static int httpd_PollerWait(httpd_host_t *host, void **ready, int timeout)
+{
+# ifdef HAVE_SYS_EPOLL_H
+    struct epoll_event ev[HTTPD_EVENTS_MAX];
+    int n = epoll_wait(host->poller, ev, HTTPD_EVENTS_MAX, timeout);
+
+    for (int i = 0; i < n; i++)
+        ready[i] = ev[i].data.ptr;
+# else
+    /* kevent() is not a cancellation point, but poll() is */
+    struct pollfd ufd = { .fd = host->poller, .events = POLLIN };
+    struct kevent ev[HTTPD_EVENTS_MAX];
+
+    if (poll(&ufd, 1, timeout) < 0)
+        return -1;
+
+    int n = kevent(host->poller, NULL, 0, ev, HTTPD_EVENTS_MAX,
+                   &(struct timespec){ 0, 0 });
+    for (int i = 0; i < n; i++)
+        ready[i] = ev[i].udata;
+# endif
+    return n;
+}
+
+static void httpdEventLoop(httpd_host_t *host)
+{
+    void *ready[HTTPD_EVENTS_MAX];
+    httpd_client_t *cl;
+    bool b_low_delay = false;
+
+    vlc_mutex_lock(&host->lock);
+    vlc_tick_t now = vlc_tick_now();
+
+    int canc = vlc_savecancel();
+    vlc_list_foreach(cl, &host->clients, node) {
+        if (cl->i_state == HTTPD_CLIENT_DEAD
+         || (cl->i_activity_timeout > 0
+          && cl->i_activity_date + cl->i_activity_timeout < now)) {
+            httpd_PollerUpdate(host, cl, cl->poll_fd, 0);
+            host->client_count--;
+            httpd_ClientDestroy(cl);
+            continue;
         }
 
-        cl = httpd_ClientNew(sk, now);
+        short events = httpd_ClientPrepare(host, cl);
+        int fd = vlc_tls_GetPollFD(cl->sock, &events);
 
-        if (host->p_tls != NULL)
-            cl->i_state = HTTPD_CLIENT_TLS_HS_OUT;
+        httpd_PollerUpdate(host, cl, fd, events);
+        if (events == 0)
+            b_low_delay = true;
+    }
+    vlc_mutex_unlock(&host->lock);
+    vlc_restorecancel(canc);
 
-        host->client_count++;
-        vlc_list_append(&cl->node, &host->clients);
+    /* we will wait 20ms (not too big) if HTTPD_CLIENT_WAITING */
+    int n;
+    while ((n = httpd_PollerWait(host, ready, b_low_delay ? 20 : -1)) < 0)
+    {
+        if (errno != EINTR)
+            msg_Err(host, "polling error: %s", vlc_strerror_c(errno));
+    }
+
+    canc = vlc_savecancel();
+    vlc_mutex_lock(&host->lock);
+    now = vlc_tick_now();
+
+    /* Clients are only destroyed by this thread, so the registration data
+     * of ready sockets is still valid here. */
+    for (int i = 0; i < n; i++) {
+        uintptr_t ptr = (uintptr_t)ready[i];
+
+        if (ptr >= (uintptr_t)host->fds
+         && ptr < (uintptr_t)(host->fds + host->nfd)) {
+            /* Listening socket: accept new connections */
+            httpd_HostAccept(host, *(int *)ready[i], now);
+            continue;
+        }
+
+        cl = ready[i];
+        if (cl->poll_events != 0)
+            httpd_ClientHandle(host, cl, now);
     }
 
     vlc_mutex_unlock(&host->lock);
     vlc_restorecancel(canc);
 }
+#else
+static int httpd_PollerCreate(httpd_host_t *host)
+{
+    (void) host;
+    return -1;
+}
+
+static void httpd_PollerClose(httpd_host_t *host)
+{
+    (void) host;
+}
+#endif
 
 static void* httpd_HostThread(void *data)
 {
     httpd_host_t *host = data;
 
     while (atomic_load_explicit(&host->ref, memory_order_relaxed) > 0)
-        httpdLoop(host);
+#ifdef HTTPD_EVENT_LOOP
+        if (host->poller != -1)
+            httpdEventLoop(host);
+        else
+#endif
+            httpdLoop(host);
     return NULL;
 }
 
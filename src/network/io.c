@@ -122,7 +122,7 @@ int (net_Connect)(vlc_object_t *obj, const char *host, int serv,
     }, *res;
     int ret = -1;
 
-    int val = vlc_getaddrinfo_i11e(host, serv, &hints, &res);
+    int val = vlc_dns_Resolve(obj, host, serv, &hints, &res);
     if (val)
     {
         msg_Err(obj, "cannot resolve %s port %d : %s", host, serv,
@@ -203,7 +203,7 @@ next_ai: /* failure */
         net_Close(fd);
     }
 
-    freeaddrinfo(res);
+    vlc_dns_Free(res);
     return ret;
 }
 
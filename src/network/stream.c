@@ -438,7 +438,7 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
     assert(name != NULL);
     msg_Dbg(obj, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_dns_Resolve(obj, name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(obj, "cannot resolve %s port %u: %s", name, port,
@@ -458,10 +458,10 @@ vlc_tls_t *vlc_tls_SocketOpenTCP(vlc_object_t *obj, const char *name,
             continue;
         }
 
-        freeaddrinfo(res);
+        vlc_dns_Free(res);
         return tls;
     }
 
-    freeaddrinfo(res);
+    vlc_dns_Free(res);
     return NULL;
 }
@@ -230,7 +230,7 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
 
     msg_Dbg(creds, "resolving %s ...", name);
 
-    int val = vlc_getaddrinfo_i11e(name, port, &hints, &res);
+    int val = vlc_dns_Resolve(VLC_OBJECT(creds), name, port, &hints, &res);
     if (val != 0)
     {   /* TODO: C locale for gai_strerror() */
         msg_Err(creds, "cannot resolve %s port %u: %s", name, port,
@@ -251,7 +251,7 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
                                                      alpn, alp);
         if (tls != NULL)
         {   /* Success! */
-            freeaddrinfo(res);
+            vlc_dns_Free(res);
             return tls;
         }
 
@@ -260,6 +260,6 @@ vlc_tls_t *vlc_tls_SocketOpenTLS(vlc_tls_client_t *creds, const char *name,
     }
 
     /* Failure! */
-    freeaddrinfo(res);
+    vlc_dns_Free(res);
     return NULL;
 }
@@ -97,6 +97,13 @@ vlc_player_input_Start(struct vlc_player_input *input)
     if (ret != VLC_SUCCESS)
         return ret;
     input->started = true;
+    if (input->preloaded)
+    {
+        /* The OPENING_S state was received while preloading */
+        input->preloaded = false;
+        vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STARTED,
+                                     VLC_TICK_INVALID);
+    }
     return ret;
 }
 
@@ -236,6 +243,14 @@ static void
 vlc_player_input_HandleStateEvent(struct vlc_player_input *input,
                                   input_state_e state, vlc_tick_t state_date)
 {
+    if (input->preloading)
+    {
+        /* Reported by vlc_player_input_EndPreload() */
+        if (state == ERROR_S)
+            input->error = VLC_PLAYER_ERROR_GENERIC;
+        return;
+    }
+
     switch (state)
     {
         case OPENING_S:
@@ -273,7 +288,6 @@ static void
 vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                                     const struct vlc_input_event_program *ev)
 {
-    vlc_player_t *player = input->player;
     struct vlc_player_program *prgm;
     vlc_player_program_vector *vec = &input->program_vector;
 
@@ -289,8 +303,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                 vlc_player_program_Delete(prgm);
                 break;
             }
-            vlc_player_SendEvent(player, on_program_list_changed,
-                                 VLC_PLAYER_LIST_ADDED, prgm);
+            vlc_player_input_SendEvent(input, on_program_list_changed,
+                                       VLC_PLAYER_LIST_ADDED, prgm);
             break;
         case VLC_INPUT_PROGRAM_DELETED:
         {
@@ -298,8 +312,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
             prgm = vlc_player_program_vector_FindById(vec, ev->id, &idx);
             if (prgm)
             {
-                vlc_player_SendEvent(player, on_program_list_changed,
-                                     VLC_PLAYER_LIST_REMOVED, prgm);
+                vlc_player_input_SendEvent(input, on_program_list_changed,
+                                           VLC_PLAYER_LIST_REMOVED, prgm);
                 vlc_vector_remove(vec, idx);
                 vlc_player_program_Delete(prgm);
             }
@@ -317,8 +331,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
             }
             else
                 prgm->scrambled = ev->scrambled;
-            vlc_player_SendEvent(player, on_program_list_changed,
-                                 VLC_PLAYER_LIST_UPDATED, prgm);
+            vlc_player_input_SendEvent(input, on_program_list_changed,
+                                       VLC_PLAYER_LIST_UPDATED, prgm);
             break;
         case VLC_INPUT_PROGRAM_SELECTED:
         {
@@ -345,8 +359,8 @@ vlc_player_input_HandleProgramEvent(struct vlc_player_input *input,
                 }
             }
             if (unselected_id != -1 || selected_id != -1)
-                vlc_player_SendEvent(player, on_program_selection_changed,
-                                     unselected_id, selected_id);
+                vlc_player_input_SendEvent(input, on_program_selection_changed,
+                                           unselected_id, selected_id);
             break;
         }
         default:
@@ -373,7 +387,7 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
             if (!input->teletext_menu)
                 return;
 
-            vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+            vlc_player_input_SendEvent(input, on_teletext_menu_changed, true);
             break;
         case VLC_INPUT_ES_DELETED:
         {
@@ -383,7 +397,8 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
 
                 vlc_player_track_priv_Delete(input->teletext_menu);
                 input->teletext_menu = NULL;
-                vlc_player_SendEvent(player, on_teletext_menu_changed, false);
+                vlc_player_input_SendEvent(input, on_teletext_menu_changed,
+                                           false);
             }
             break;
         }
@@ -394,8 +409,8 @@ vlc_player_input_HandleTeletextMenu(struct vlc_player_input *input,
             if (input->teletext_menu->t.es_id == ev->id)
             {
                 input->teletext_enabled = ev->action == VLC_INPUT_ES_SELECTED;
-                vlc_player_SendEvent(player, on_teletext_enabled_changed,
-                                     input->teletext_enabled);
+                vlc_player_input_SendEvent(input, on_teletext_enabled_changed,
+                                           input->teletext_enabled);
             }
             break;
         default:
@@ -436,8 +451,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 vlc_player_track_priv_Delete(trackpriv);
                 break;
             }
-            vlc_player_SendEvent(player, on_track_list_changed,
-                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+            vlc_player_input_SendEvent(input, on_track_list_changed,
+                                       VLC_PLAYER_LIST_ADDED, &trackpriv->t);
             break;
         case VLC_INPUT_ES_DELETED:
         {
@@ -445,8 +460,9 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
             trackpriv = vlc_player_track_vector_FindById(vec, ev->id, &idx);
             if (trackpriv)
             {
-                vlc_player_SendEvent(player, on_track_list_changed,
-                                     VLC_PLAYER_LIST_REMOVED, &trackpriv->t);
+                vlc_player_input_SendEvent(input, on_track_list_changed,
+                                           VLC_PLAYER_LIST_REMOVED,
+                                           &trackpriv->t);
                 vlc_vector_remove(vec, idx);
                 vlc_player_track_priv_Delete(trackpriv);
             }
@@ -458,8 +474,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 break;
             if (vlc_player_track_priv_Update(trackpriv, ev->title, ev->fmt) != 0)
                 break;
-            vlc_player_SendEvent(player, on_track_list_changed,
-                                 VLC_PLAYER_LIST_UPDATED, &trackpriv->t);
+            vlc_player_input_SendEvent(input, on_track_list_changed,
+                                       VLC_PLAYER_LIST_UPDATED, &trackpriv->t);
             break;
         case VLC_INPUT_ES_SELECTED:
             trackpriv = vlc_player_track_vector_FindById(vec, ev->id, NULL);
@@ -467,8 +483,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
             {
                 trackpriv->t.selected = true;
                 trackpriv->selected_by_user = ev->forced;
-                vlc_player_SendEvent(player, on_track_selection_changed,
-                                     NULL, trackpriv->t.es_id);
+                vlc_player_input_SendEvent(input, on_track_selection_changed,
+                                           NULL, trackpriv->t.es_id);
             }
             break;
         case VLC_INPUT_ES_UNSELECTED:
@@ -478,8 +494,8 @@ vlc_player_input_HandleEsEvent(struct vlc_player_input *input,
                 vlc_player_RemoveTimerSource(player, ev->id);
                 trackpriv->t.selected = false;
                 trackpriv->selected_by_user = false;
-                vlc_player_SendEvent(player, on_track_selection_changed,
-                                     trackpriv->t.es_id, NULL);
+                vlc_player_input_SendEvent(input, on_track_selection_changed,
+                                           trackpriv->t.es_id, NULL);
             }
             break;
         default:
@@ -491,7 +507,6 @@ static void
 vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
                                   const struct vlc_input_event_title *ev)
 {
-    vlc_player_t *player = input->player;
     switch (ev->action)
     {
         case VLC_INPUT_TITLE_NEW_LIST:
@@ -506,15 +521,18 @@ vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
             input->titles =
                 vlc_player_title_list_Create(ev->list.array, ev->list.count,
                                              title_offset, chapter_offset);
-            vlc_player_SendEvent(player, on_titles_changed, input->titles);
+            vlc_player_input_SendEvent(input, on_titles_changed, input->titles);
             if (input->titles)
             {
-                vlc_player_SendEvent(player, on_title_selection_changed,
-                                     &input->titles->array[0], 0);
+                vlc_player_input_SendEvent(input, on_title_selection_changed,
+                                           &input->titles->array[0], 0);
                 if (input->ml.restore == VLC_RESTOREPOINT_TITLE &&
                     (size_t)input->ml.states.current_title < ev->list.count)
                 {
-                    vlc_player_SelectTitleIdx(player, input->ml.states.current_title);
+                    /* Not necessarily the current input if preloading */
+                    input_ControlPushHelper(input->thread,
+                        INPUT_CONTROL_SET_TITLE,
+                        &(vlc_value_t){ .i_int = input->ml.states.current_title });
                 }
                 input->ml.restore = VLC_RESTOREPOINT_POSITION;
             }
@@ -526,9 +544,9 @@ vlc_player_input_HandleTitleEvent(struct vlc_player_input *input,
                 return; /* a previous VLC_INPUT_TITLE_NEW_LIST failed */
             assert(ev->selected_idx < input->titles->count);
             input->title_selected = ev->selected_idx;
-            vlc_player_SendEvent(player, on_title_selection_changed,
-                                 &input->titles->array[input->title_selected],
-                                 input->title_selected);
+            vlc_player_input_SendEvent(input, on_title_selection_changed,
+                                &input->titles->array[input->title_selected],
+                                input->title_selected);
             if (input->ml.restore == VLC_RESTOREPOINT_POSITION &&
                 input->ml.states.current_title >= 0 &&
                 (size_t)input->ml.states.current_title == ev->selected_idx &&
@@ -550,7 +568,6 @@ static void
 vlc_player_input_HandleChapterEvent(struct vlc_player_input *input,
                                     const struct vlc_input_event_chapter *ev)
 {
-    vlc_player_t *player = input->player;
     if (!input->titles || ev->title < 0 || ev->seekpoint < 0)
         return; /* a previous VLC_INPUT_TITLE_NEW_LIST failed */
 
@@ -564,8 +581,8 @@ vlc_player_input_HandleChapterEvent(struct vlc_player_input *input,
     input->chapter_selected = ev->seekpoint;
 
     const struct vlc_player_chapter *chapter = &title->chapters[ev->seekpoint];
-    vlc_player_SendEvent(player, on_chapter_selection_changed, title, ev->title,
-                         chapter, ev->seekpoint);
+    vlc_player_input_SendEvent(input, on_chapter_selection_changed, title,
+                               ev->title, chapter, ev->seekpoint);
 }
 
 static void
@@ -661,18 +678,34 @@ input_thread_Events(input_thread_t *input_thread,
             break;
         case INPUT_EVENT_RATE:
             input->rate = event->rate;
-            vlc_player_SendEvent(player, on_rate_changed, input->rate);
+            vlc_player_input_SendEvent(input, on_rate_changed, input->rate);
             break;
         case INPUT_EVENT_CAPABILITIES:
         {
             int old_caps = input->capabilities;
             input->capabilities = event->capabilities;
-            vlc_player_SendEvent(player, on_capabilities_changed,
-                                 old_caps, input->capabilities);
+            vlc_player_input_SendEvent(input, on_capabilities_changed,
+                                       old_caps, input->capabilities);
             break;
         }
         case INPUT_EVENT_TIMES:
         {
+            if (input->preloading)
+            {
+                /* The timer only follows the current input */
+                input->time = event->times.ms;
+                input->position = event->times.percentage;
+                if (event->times.normal_time != VLC_TICK_INVALID)
+                    input->normal_time = event->times.normal_time;
+                if (input->length != event->times.length)
+                {
+                    input->length = event->times.length;
+                    input_item_SetDuration(input_GetItem(input->thread),
+                                           event->times.length);
+                }
+                break;
+            }
+
             bool changed = false;
             vlc_tick_t system_date = VLC_TICK_INVALID;
 
@@ -716,6 +749,22 @@ input_thread_Events(input_thread_t *input_thread,
                 vlc_player_UpdateTimer(player, NULL, false, &point,
                                        input->normal_time, 0, 0);
             }
+
+            if (input == player->input
+             && input->length != VLC_TICK_INVALID
+             && input->time != VLC_TICK_INVALID)
+            {
+                vlc_tick_t remaining = input->length - input->time;
+                if (player->preload_delay > 0)
+                {
+                    if (remaining <= player->preload_delay)
+                        vlc_player_PreloadNextMedia(player);
+                }
+                /* Without preloading, at least warm the next media
+                 * connection up */
+                else if (remaining <= VLC_PLAYER_WARM_DELAY && player->started)
+                    vlc_player_PrepareNextMedia(player);
+            }
             break;
         }
         case INPUT_EVENT_PROGRAM:
@@ -732,21 +781,30 @@ input_thread_Events(input_thread_t *input_thread,
             break;
         case INPUT_EVENT_RECORD:
             input->recording = event->record;
-            vlc_player_SendEvent(player, on_recording_changed, input->recording);
+            vlc_player_input_SendEvent(input, on_recording_changed,
+                                       input->recording);
             break;
         case INPUT_EVENT_STATISTICS:
             input->stats = *event->stats;
-            vlc_player_SendEvent(player, on_statistics_changed, &input->stats);
+            vlc_player_input_SendEvent(input, on_statistics_changed,
+                                       &input->stats);
+            break;
+        case INPUT_EVENT_STARTUP:
+            vlc_player_input_SendEvent(input, on_startup_milestone,
+                                       event->startup.milestone,
+                                       event->startup.delay);
             break;
         case INPUT_EVENT_SIGNAL:
             input->signal_quality = event->signal.quality;
             input->signal_strength = event->signal.strength;
-            vlc_player_SendEvent(player, on_signal_changed,
-                                 input->signal_quality, input->signal_strength);
+            vlc_player_input_SendEvent(input, on_signal_changed,
+                                       input->signal_quality,
+                                       input->signal_strength);
             break;
         case INPUT_EVENT_CACHE:
             input->cache = event->cache;
-            vlc_player_SendEvent(player, on_buffering_changed, event->cache);
+            vlc_player_input_SendEvent(input, on_buffering_changed,
+                                       event->cache);
             break;
         case INPUT_EVENT_VOUT:
             vlc_player_input_HandleVoutEvent(input, &event->vout);
@@ -764,6 +822,19 @@ input_thread_Events(input_thread_t *input_thread,
                                  input_GetItem(input->thread), event->subitems);
             break;
         case INPUT_EVENT_DEAD:
+            if (input->preloaded)
+            {
+                /* Failed or cancelled before being started */
+                if (player->next_input == input)
+                    player->next_input = NULL;
+                if (input->titles)
+                {
+                    vlc_player_title_list_Release(input->titles);
+                    input->titles = NULL;
+                    vlc_player_input_SendEvent(input, on_titles_changed, NULL);
+                }
+                input->preloading = input->preloaded = false;
+            }
             if (input->started) /* Can happen with early input_thread fails */
                 vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STOPPING,
                                              VLC_TICK_INVALID);
@@ -771,13 +842,13 @@ input_thread_Events(input_thread_t *input_thread,
             break;
         case INPUT_EVENT_VBI_PAGE:
             input->teletext_page = event->vbi_page < 999 ? event->vbi_page : 100;
-            vlc_player_SendEvent(player, on_teletext_page_changed,
-                                 input->teletext_page);
+            vlc_player_input_SendEvent(input, on_teletext_page_changed,
+                                       input->teletext_page);
             break;
         case INPUT_EVENT_VBI_TRANSPARENCY:
             input->teletext_transparent = event->vbi_transparent;
-            vlc_player_SendEvent(player, on_teletext_transparency_changed,
-                                 input->teletext_transparent);
+            vlc_player_input_SendEvent(input, on_teletext_transparency_changed,
+                                       input->teletext_transparent);
             break;
         default:
             break;
@@ -827,7 +898,7 @@ vlc_player_input_GetSelectedTrackStringIds(struct vlc_player_input *input,
 }
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item)
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool preload)
 {
     struct vlc_player_input *input = malloc(sizeof(*input));
     if (!input)
@@ -835,6 +906,8 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
 
     input->player = player;
     input->started = false;
+    input->preloading = preload;
+    input->preloaded = false;
 
     input->state = VLC_PLAYER_STATE_STOPPED;
     input->error = VLC_PLAYER_ERROR_NONE;
@@ -887,15 +960,17 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
     }
     vlc_player_input_RestoreMlStates(input, false);
 
-    if (player->video_string_ids)
+    /* The string ids of the current media must not be applied to the
+     * preloaded one */
+    if (!preload && player->video_string_ids)
         vlc_player_input_SelectTracksByStringIds(input, VIDEO_ES,
                                                  player->video_string_ids);
 
-    if (player->audio_string_ids)
+    if (!preload && player->audio_string_ids)
         vlc_player_input_SelectTracksByStringIds(input, AUDIO_ES,
                                                  player->audio_string_ids);
 
-    if (player->sub_string_ids)
+    if (!preload && player->sub_string_ids)
         vlc_player_input_SelectTracksByStringIds(input, SPU_ES,
                                                  player->sub_string_ids);
 
@@ -919,13 +994,81 @@ vlc_player_input_New(vlc_player_t *player, input_item_t *item)
                                         INPUT_CONTROL_SET_CATEGORY_DELAY,
                                         &param);
             if (ret == VLC_SUCCESS)
-                vlc_player_SendEvent(player, on_category_delay_changed, i,
-                                     cat_delays[i]);
+                vlc_player_input_SendEvent(input, on_category_delay_changed, i,
+                                           cat_delays[i]);
         }
     }
     return input;
 }
 
+void
+vlc_player_input_EndPreload(struct vlc_player_input *input)
+{
+    vlc_player_t *player = input->player;
+
+    assert(input->preloading);
+    input->preloading = false;
+
+    /* Send the events that were held back while preloading */
+    if (input->error != VLC_PLAYER_ERROR_NONE)
+        vlc_player_SendEvent(player, on_error_changed, input->error);
+    if (input->capabilities != 0)
+        vlc_player_SendEvent(player, on_capabilities_changed, 0,
+                             input->capabilities);
+    if (input->rate != 1.f)
+        vlc_player_SendEvent(player, on_rate_changed, input->rate);
+    if (input->length != VLC_TICK_INVALID)
+        vlc_player_SendEvent(player, on_length_changed, input->length);
+
+    for (enum es_format_category_e i = UNKNOWN_ES; i < DATA_ES; ++i)
+        if (input->cat_delays[i] != 0)
+            vlc_player_SendEvent(player, on_category_delay_changed, i,
+                                 input->cat_delays[i]);
+
+    struct vlc_player_program *prgm;
+    vlc_vector_foreach(prgm, &input->program_vector)
+    {
+        vlc_player_SendEvent(player, on_program_list_changed,
+                             VLC_PLAYER_LIST_ADDED, prgm);
+        if (prgm->selected)
+            vlc_player_SendEvent(player, on_program_selection_changed,
+                                 -1, prgm->group_id);
+    }
+
+    static const enum es_format_category_e cats[] = {
+        VIDEO_ES, AUDIO_ES, SPU_ES,
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(cats); ++i)
+    {
+        vlc_player_track_vector *vec =
+            vlc_player_input_GetTrackVector(input, cats[i]);
+        struct vlc_player_track_priv *trackpriv;
+        vlc_vector_foreach(trackpriv, vec)
+        {
+            vlc_player_SendEvent(player, on_track_list_changed,
+                                 VLC_PLAYER_LIST_ADDED, &trackpriv->t);
+            if (trackpriv->t.selected)
+                vlc_player_SendEvent(player, on_track_selection_changed,
+                                     NULL, trackpriv->t.es_id);
+        }
+    }
+
+    if (input->teletext_menu)
+    {
+        vlc_player_SendEvent(player, on_teletext_menu_changed, true);
+        if (input->teletext_enabled)
+            vlc_player_SendEvent(player, on_teletext_enabled_changed, true);
+    }
+
+    if (input->titles)
+    {
+        vlc_player_SendEvent(player, on_titles_changed, input->titles);
+        vlc_player_SendEvent(player, on_title_selection_changed,
+                             &input->titles->array[input->title_selected],
+                             input->title_selected);
+    }
+}
+
 void
 vlc_player_input_Delete(struct vlc_player_input *input)
 {
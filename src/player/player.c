@@ -31,6 +31,8 @@
 #include <vlc_tick.h>
 #include <vlc_decoder.h>
 #include <vlc_memstream.h>
+#include <vlc_network.h>
+#include <vlc_url.h>
 
 #include "libvlc.h"
 #include "input/resource.h"
@@ -49,6 +51,23 @@ static_assert(VLC_PLAYER_TITLE_MENU == INPUT_TITLE_MENU &&
 #define vlc_player_foreach_inputs(it) \
     for (struct vlc_player_input *it = player->input; it != NULL; it = NULL)
 
+static void
+vlc_player_WarmMedia(vlc_player_t *player, input_item_t *media)
+{
+    /* Resolve the server address of the next media ahead of its opening */
+    vlc_mutex_lock(&media->lock);
+    char *uri = media->b_net && media->psz_uri ? strdup(media->psz_uri) : NULL;
+    vlc_mutex_unlock(&media->lock);
+    if (!uri)
+        return;
+
+    vlc_url_t url;
+    if (vlc_UrlParse(&url, uri) == 0 && url.psz_host)
+        vlc_dns_Prefetch(VLC_OBJECT(player), url.psz_host);
+    vlc_UrlClean(&url);
+    free(uri);
+}
+
 void
 vlc_player_PrepareNextMedia(vlc_player_t *player)
 {
@@ -63,6 +82,44 @@ vlc_player_PrepareNextMedia(vlc_player_t *player)
     player->next_media =
         player->media_provider->get_next(player, player->media_provider_data);
     player->next_media_requested = true;
+    if (player->next_media)
+        vlc_player_WarmMedia(player, player->next_media);
+}
+
+void
+vlc_player_PreloadNextMedia(vlc_player_t *player)
+{
+    vlc_player_assert_locked(player);
+
+    if (player->next_input || !player->started || player->deleting)
+        return;
+
+    vlc_player_PrepareNextMedia(player);
+    if (!player->next_media)
+        return;
+
+    /* The stream output can't be shared by two inputs */
+    if (player->renderer)
+        return;
+    char *sout = var_GetNonEmptyString(player, "sout");
+    if (sout)
+    {
+        free(sout);
+        return;
+    }
+
+    struct vlc_player_input *input =
+        vlc_player_input_New(player, player->next_media, true);
+    if (!input)
+        return;
+    if (input_Preload(input->thread) != VLC_SUCCESS)
+    {
+        vlc_player_input_Delete(input);
+        return;
+    }
+    input->preloaded = true;
+    player->next_input = input;
+    msg_Dbg(player, "preloading the next media");
 }
 
 int
@@ -97,8 +154,13 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
         player->media = player->next_media;
         player->next_media = NULL;
 
-        struct vlc_player_input *input = player->input =
-            vlc_player_input_New(player, player->media);
+        struct vlc_player_input *input = player->input = player->next_input;
+        player->next_input = NULL;
+        if (input)
+            assert(input_GetItem(input->thread) == player->media);
+        else
+            input = player->input =
+                vlc_player_input_New(player, player->media, false);
         if (!input)
         {
             input_item_Release(player->media);
@@ -107,6 +169,8 @@ vlc_player_OpenNextMedia(vlc_player_t *player)
         }
     }
     vlc_player_SendEvent(player, on_current_media_changed, player->media);
+    if (player->input && player->input->preloading)
+        vlc_player_input_EndPreload(player->input);
     if (player->input && player->input->ml.delay_restore)
     {
         vlc_player_SendEvent(player, on_playback_restore_queried);
@@ -141,7 +205,7 @@ static void
 vlc_player_destructor_AddInput(vlc_player_t *player,
                                struct vlc_player_input *input)
 {
-    if (input->started)
+    if (input->started || input->preloaded)
     {
         input->started = false;
         /* Add this input to the stop list: it will be stopped by the
@@ -215,11 +279,14 @@ vlc_player_destructor_Thread(void *data)
         struct vlc_player_input *input;
         vlc_list_foreach(input, &player->destructor.inputs, node)
         {
-            vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STOPPING,
-                                         VLC_TICK_INVALID);
+            /* A preloaded input was never played */
+            if (!input->preloaded)
+                vlc_player_input_HandleState(input, VLC_PLAYER_STATE_STOPPING,
+                                             VLC_TICK_INVALID);
             vlc_player_destructor_AddStoppingInput(player, input);
 
-            vlc_player_UpdateMLStates(player, input);
+            if (!input->preloaded)
+                vlc_player_UpdateMLStates(player, input);
             input_Stop(input->thread);
         }
 
@@ -1140,6 +1207,11 @@ vlc_player_InvalidateNextMedia(vlc_player_t *player)
         input_item_Release(player->next_media);
         player->next_media = NULL;
     }
+    if (player->next_input)
+    {
+        vlc_player_destructor_AddInput(player, player->next_input);
+        player->next_input = NULL;
+    }
     player->next_media_requested = false;
 
 }
@@ -1171,7 +1243,7 @@ vlc_player_Start(vlc_player_t *player)
     if (!player->input)
     {
         /* Possible if the player was stopped by the user */
-        player->input = vlc_player_input_New(player, player->media);
+        player->input = vlc_player_input_New(player, player->media, false);
 
         if (!player->input)
             return VLC_ENOMEM;
@@ -1887,6 +1959,11 @@ vlc_player_Delete(vlc_player_t *player)
 
     if (player->input)
         vlc_player_destructor_AddInput(player, player->input);
+    if (player->next_input)
+    {
+        vlc_player_destructor_AddInput(player, player->next_input);
+        player->next_input = NULL;
+    }
 
     player->deleting = true;
     vlc_cond_signal(&player->destructor.wait);
@@ -1955,6 +2032,9 @@ vlc_player_New(vlc_object_t *parent, enum vlc_player_lock_type lock_type,
     player->releasing_media = false;
     player->next_media_requested = false;
     player->next_media = NULL;
+    player->next_input = NULL;
+    player->preload_delay =
+        VLC_TICK_FROM_MS(var_InheritInteger(player, "playlist-preload"));
 
     player->video_string_ids = player->audio_string_ids =
     player->sub_string_ids = NULL;
@@ -29,6 +29,10 @@
 
 #include "input/input_internal.h"
 
+/* Remaining playback time from which the next media is prepared and its
+ * server address resolved, when the playlist preloading is disabled */
+#define VLC_PLAYER_WARM_DELAY VLC_TICK_FROM_SEC(10)
+
 struct vlc_player_track_priv
 {
     struct vlc_player_track t;
@@ -58,6 +62,10 @@ struct vlc_player_input
     input_thread_t *thread;
     vlc_player_t *player;
     bool started;
+    /* opened ahead of the current input, its events are not sent */
+    bool preloading;
+    /* the thread is running, waiting for vlc_player_input_Start() */
+    bool preloaded;
 
     enum vlc_player_state state;
     enum vlc_player_error error;
@@ -235,6 +243,9 @@ struct vlc_player_t
     bool releasing_media;
     bool next_media_requested;
     input_item_t *next_media;
+    /* next_media opened ahead of time, see vlc_player_PreloadNextMedia() */
+    struct vlc_player_input *next_input;
+    vlc_tick_t preload_delay;
 
     char *video_string_ids;
     char *audio_string_ids;
@@ -292,6 +303,13 @@ vlc_player_get_input_locked(vlc_player_t *player)
     } \
 } while(0)
 
+/* The events of a preloading input are sent by vlc_player_input_EndPreload()
+ * once it becomes the current one */
+#define vlc_player_input_SendEvent(input, event, ...) do { \
+    if (!(input)->preloading) \
+        vlc_player_SendEvent((input)->player, event, ##__VA_ARGS__); \
+} while(0)
+
 static inline const char *
 es_format_category_to_string(enum es_format_category_e cat)
 {
@@ -317,6 +335,9 @@ vlc_player_OpenNextMedia(vlc_player_t *player);
 void
 vlc_player_PrepareNextMedia(vlc_player_t *player);
 
+void
+vlc_player_PreloadNextMedia(vlc_player_t *player);
+
 void
 vlc_player_destructor_AddStoppingInput(vlc_player_t *player,
                                        struct vlc_player_input *input);
@@ -391,7 +412,10 @@ vlc_player_input_FindTrackById(struct vlc_player_input *input, vlc_es_id_t *id,
                                size_t *idx);
 
 struct vlc_player_input *
-vlc_player_input_New(vlc_player_t *player, input_item_t *item);
+vlc_player_input_New(vlc_player_t *player, input_item_t *item, bool preload);
+
+void
+vlc_player_input_EndPreload(struct vlc_player_input *input);
 
 void
 vlc_player_input_Delete(struct vlc_player_input *input);
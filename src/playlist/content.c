@@ -37,6 +37,7 @@ vlc_playlist_ClearItems(vlc_playlist_t *playlist)
     vlc_vector_foreach(item, &playlist->items)
         vlc_playlist_item_Release(item);
     vlc_vector_clear(&playlist->items);
+    vlc_playlist_index_Clear(&playlist->index);
 }
 
 static void
@@ -197,9 +198,8 @@ vlc_playlist_IndexOf(vlc_playlist_t *playlist, const vlc_playlist_item_t *item)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    ssize_t index;
-    vlc_vector_index_of(&playlist->items, item, &index);
-    return index;
+    return vlc_playlist_index_Find(&playlist->index, playlist->items.data,
+                                   playlist->items.size, item);
 }
 
 ssize_t
@@ -207,11 +207,8 @@ vlc_playlist_IndexOfMedia(vlc_playlist_t *playlist, const input_item_t *media)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->media == media)
-            return i;
-    return -1;
+    return vlc_playlist_index_FindMedia(&playlist->index, playlist->items.data,
+                                        playlist->items.size, media);
 }
 
 ssize_t
@@ -219,11 +216,8 @@ vlc_playlist_IndexOfId(vlc_playlist_t *playlist, uint64_t id)
 {
     vlc_playlist_AssertLocked(playlist);
 
-    playlist_item_vector_t *items = &playlist->items;
-    for (size_t i = 0; i < items->size; ++i)
-        if (items->data[i]->id == id)
-            return i;
-    return -1;
+    return vlc_playlist_index_FindId(&playlist->index, playlist->items.data,
+                                     playlist->items.size, id);
 }
 
 void
@@ -250,12 +244,20 @@ vlc_playlist_MediaToItems(vlc_playlist_t *playlist, input_item_t *const media[],
         items[i] = vlc_playlist_item_New(media[i], id);
         if (unlikely(!items[i]))
             break;
+        if (unlikely(!vlc_playlist_index_Add(&playlist->index, items[i])))
+        {
+            vlc_playlist_item_Release(items[i]);
+            break;
+        }
     }
     if (i < count)
     {
         /* allocation failure, release partial items */
         while (i)
-            vlc_playlist_item_Release(items[--i]);
+        {
+            vlc_playlist_index_Remove(&playlist->index, items[--i]);
+            vlc_playlist_item_Release(items[i]);
+        }
         return VLC_ENOMEM;
     }
     return VLC_SUCCESS;
@@ -282,6 +284,7 @@ vlc_playlist_Insert(vlc_playlist_t *playlist, size_t index,
         return ret;
     }
 
+    vlc_playlist_index_Invalidate(&playlist->index, index);
     vlc_playlist_ItemsInserted(playlist, index, count);
     vlc_player_InvalidateNextMedia(playlist->player);
 
@@ -297,6 +300,7 @@ vlc_playlist_Move(vlc_playlist_t *playlist, size_t index, size_t count,
     assert(target + count <= playlist->items.size);
 
     vlc_vector_move_slice(&playlist->items, index, count, target);
+    vlc_playlist_index_Invalidate(&playlist->index, __MIN(index, target));
 
     vlc_playlist_ItemsMoved(playlist, index, count, target);
     vlc_player_InvalidateNextMedia(playlist->player);
@@ -311,9 +315,14 @@ vlc_playlist_Remove(vlc_playlist_t *playlist, size_t index, size_t count)
     vlc_playlist_ItemsRemoving(playlist, index, count);
 
     for (size_t i = 0; i < count; ++i)
-        vlc_playlist_item_Release(playlist->items.data[index + i]);
+    {
+        vlc_playlist_item_t *item = playlist->items.data[index + i];
+        vlc_playlist_index_Remove(&playlist->index, item);
+        vlc_playlist_item_Release(item);
+    }
 
     vlc_vector_remove_slice(&playlist->items, index, count);
+    vlc_playlist_index_Invalidate(&playlist->index, index);
 
     bool current_media_changed = vlc_playlist_ItemsRemoved(playlist, index,
                                                            count);
@@ -335,6 +344,12 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
     if (!item)
         return VLC_ENOMEM;
 
+    if (!vlc_playlist_index_Add(&playlist->index, item))
+    {
+        vlc_playlist_item_Release(item);
+        return VLC_ENOMEM;
+    }
+
     if (playlist->order == VLC_PLAYLIST_PLAYBACK_ORDER_RANDOM)
     {
         randomizer_Remove(&playlist->randomizer,
@@ -342,8 +357,10 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
         randomizer_Add(&playlist->randomizer, &item, 1);
     }
 
+    vlc_playlist_index_Remove(&playlist->index, playlist->items.data[index]);
     vlc_playlist_item_Release(playlist->items.data[index]);
     playlist->items.data[index] = item;
+    vlc_playlist_index_Invalidate(&playlist->index, index);
 
     vlc_playlist_ItemReplaced(playlist, index);
     return VLC_SUCCESS;
@@ -351,7 +368,7 @@ vlc_playlist_Replace(vlc_playlist_t *playlist, size_t index,
 
 int
 vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
-                    input_item_t *const media[], size_t count)
+                    input_item_t *const media[], size_t count, bool partial)
 {
     vlc_playlist_AssertLocked(playlist);
     assert(index < playlist->items.size);
@@ -379,11 +396,17 @@ vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
                 vlc_vector_remove_slice(&playlist->items, index + 1, count - 1);
                 return ret;
             }
+            vlc_playlist_index_Invalidate(&playlist->index, index + 1);
             vlc_playlist_ItemsInserted(playlist, index + 1, count - 1);
         }
 
         if ((ssize_t) index == playlist->current)
-            vlc_playlist_SetCurrentMedia(playlist, playlist->current);
+        {
+            /* the player may still be reading the next parts from the
+             * expanded media, do not interrupt it */
+            if (!partial)
+                vlc_playlist_SetCurrentMedia(playlist, playlist->current);
+        }
         else
             vlc_player_InvalidateNextMedia(playlist->player);
     }
@@ -21,6 +21,8 @@
 #ifndef VLC_PLAYLIST_CONTENT_H
 #define VLC_PLAYLIST_CONTENT_H
 
+#include <vlc_common.h>
+
 typedef struct vlc_playlist vlc_playlist_t;
 typedef struct input_item_t input_item_t;
 
@@ -28,9 +30,10 @@ typedef struct input_item_t input_item_t;
 void
 vlc_playlist_ClearItems(vlc_playlist_t *playlist);
 
-/* expand an item (replace it by the given media array) */
+/* expand an item (replace it by the given media array); if partial, more
+ * media will be inserted after them */
 int
 vlc_playlist_Expand(vlc_playlist_t *playlist, size_t index,
-                    input_item_t *const media[], size_t count);
+                    input_item_t *const media[], size_t count, bool partial);
 
 #endif
@@ -78,6 +78,9 @@ vlc_playlist_Export(struct vlc_playlist *playlist, const char *filename,
         goto close_file;
     }
 
+    /* exporters write many small fields, write them to disk in large chunks */
+    setvbuf(export->file, NULL, _IOFBF, 64 * 1024);
+
     // this will actually export
     module_t *module = module_need(export, "playlist export", type, true);
 
@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * playlist/index.c
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "index.h"
+
+#include <assert.h>
+
+#include "item.h"
+
+#define INDEX_MIN_BITS 6
+
+static inline size_t
+HashId(uint64_t id, unsigned bits)
+{
+    /* Fibonacci hashing, the ids are sequential */
+    return (id * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits);
+}
+
+static inline size_t
+HashMedia(const input_item_t *media, unsigned bits)
+{
+    return HashId((uintptr_t) media >> 4, bits);
+}
+
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index)
+{
+    index->by_id = NULL;
+    index->by_media = NULL;
+    index->bits = 0;
+    index->count = 0;
+    index->valid = 0;
+}
+
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index)
+{
+    free(index->by_id);
+    free(index->by_media);
+    vlc_playlist_index_Init(index);
+}
+
+static void
+InsertId(vlc_playlist_item_t **table, unsigned bits, vlc_playlist_item_t *item)
+{
+    vlc_playlist_item_t **bucket = &table[HashId(item->id, bits)];
+    item->next_by_id = *bucket;
+    *bucket = item;
+}
+
+static void
+InsertMedia(vlc_playlist_item_t **table, unsigned bits,
+            vlc_playlist_item_t *item)
+{
+    vlc_playlist_item_t **bucket = &table[HashMedia(item->media, bits)];
+    item->next_by_media = *bucket;
+    *bucket = item;
+}
+
+static bool
+Rehash(struct vlc_playlist_index *index, unsigned bits)
+{
+    size_t size = (size_t) 1 << bits;
+    vlc_playlist_item_t **by_id = calloc(size, sizeof (*by_id));
+    vlc_playlist_item_t **by_media = calloc(size, sizeof (*by_media));
+    if (unlikely(!by_id || !by_media))
+    {
+        free(by_id);
+        free(by_media);
+        return false;
+    }
+
+    if (index->bits)
+    {
+        size_t old_size = (size_t) 1 << index->bits;
+        for (size_t i = 0; i < old_size; ++i)
+        {
+            vlc_playlist_item_t *item = index->by_id[i];
+            while (item)
+            {
+                vlc_playlist_item_t *next = item->next_by_id;
+                InsertId(by_id, bits, item);
+                item = next;
+            }
+
+            item = index->by_media[i];
+            while (item)
+            {
+                vlc_playlist_item_t *next = item->next_by_media;
+                InsertMedia(by_media, bits, item);
+                item = next;
+            }
+        }
+    }
+
+    free(index->by_id);
+    free(index->by_media);
+    index->by_id = by_id;
+    index->by_media = by_media;
+    index->bits = bits;
+    return true;
+}
+
+bool
+vlc_playlist_index_Add(struct vlc_playlist_index *index,
+                       vlc_playlist_item_t *item)
+{
+    if (!index->bits)
+    {
+        if (!Rehash(index, INDEX_MIN_BITS))
+            return false;
+    }
+    else if (index->count >= ((size_t) 1 << index->bits)
+          && index->bits < sizeof (size_t) * 8 - 1)
+        /* on failure, keep the current tables with longer chains */
+        Rehash(index, index->bits + 1);
+
+    InsertId(index->by_id, index->bits, item);
+    InsertMedia(index->by_media, index->bits, item);
+    index->count++;
+    return true;
+}
+
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *item)
+{
+    assert(index->count > 0);
+
+    vlc_playlist_item_t **pp = &index->by_id[HashId(item->id, index->bits)];
+    while (*pp != item)
+    {
+        assert(*pp);
+        pp = &(*pp)->next_by_id;
+    }
+    *pp = item->next_by_id;
+
+    pp = &index->by_media[HashMedia(item->media, index->bits)];
+    while (*pp != item)
+    {
+        assert(*pp);
+        pp = &(*pp)->next_by_media;
+    }
+    *pp = item->next_by_media;
+
+    index->count--;
+}
+
+static void
+Renumber(struct vlc_playlist_index *index, vlc_playlist_item_t *const items[],
+         size_t count)
+{
+    assert(index->count == count);
+    for (size_t i = index->valid; i < count; ++i)
+        items[i]->index = i;
+    index->valid = count;
+}
+
+ssize_t
+vlc_playlist_index_Find(struct vlc_playlist_index *index,
+                        vlc_playlist_item_t *const items[], size_t count,
+                        const vlc_playlist_item_t *item)
+{
+    Renumber(index, items, count);
+    /* the item may not belong to the playlist (anymore) */
+    if (item->index < count && items[item->index] == item)
+        return item->index;
+    return -1;
+}
+
+ssize_t
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             vlc_playlist_item_t *const items[], size_t count,
+                             const input_item_t *media)
+{
+    if (!index->count)
+        return -1;
+
+    Renumber(index, items, count);
+
+    /* the same media may be inserted several times, return the first one */
+    ssize_t ret = -1;
+    vlc_playlist_item_t *item = index->by_media[HashMedia(media, index->bits)];
+    for (; item; item = item->next_by_media)
+        if (item->media == media && (ret == -1 || (size_t) ret > item->index))
+            ret = item->index;
+    return ret;
+}
+
+ssize_t
+vlc_playlist_index_FindId(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t count,
+                          uint64_t id)
+{
+    if (!index->count)
+        return -1;
+
+    Renumber(index, items, count);
+
+    vlc_playlist_item_t *item = index->by_id[HashId(id, index->bits)];
+    for (; item; item = item->next_by_id)
+        if (item->id == id)
+            return item->index;
+    return -1;
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************
+ * playlist/index.h
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_PLAYLIST_INDEX_H
+#define VLC_PLAYLIST_INDEX_H
+
+#include <vlc_common.h>
+
+typedef struct vlc_playlist_item vlc_playlist_item_t;
+typedef struct input_item_t input_item_t;
+
+/**
+ * Lookup tables of the playlist items.
+ *
+ * The items are hashed by id and by media. In addition, each item caches its
+ * position in the playlist; the positions are renumbered lazily, from the
+ * first modified position, on the next lookup. That way, a sequence of
+ * modifications followed by a sequence of lookups costs a single pass.
+ */
+struct vlc_playlist_index
+{
+    vlc_playlist_item_t **by_id;
+    vlc_playlist_item_t **by_media;
+    unsigned bits; /* log2 of the number of buckets */
+    size_t count;
+    size_t valid; /* the cached positions are valid below this one */
+};
+
+void
+vlc_playlist_index_Init(struct vlc_playlist_index *index);
+
+/* remove all the items and release the tables */
+void
+vlc_playlist_index_Clear(struct vlc_playlist_index *index);
+
+bool
+vlc_playlist_index_Add(struct vlc_playlist_index *index,
+                       vlc_playlist_item_t *item);
+
+void
+vlc_playlist_index_Remove(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *item);
+
+/* to be called when the items from the given position have moved */
+static inline void
+vlc_playlist_index_Invalidate(struct vlc_playlist_index *index, size_t from)
+{
+    if (from < index->valid)
+        index->valid = from;
+}
+
+ssize_t
+vlc_playlist_index_Find(struct vlc_playlist_index *index,
+                        vlc_playlist_item_t *const items[], size_t count,
+                        const vlc_playlist_item_t *item);
+
+ssize_t
+vlc_playlist_index_FindMedia(struct vlc_playlist_index *index,
+                             vlc_playlist_item_t *const items[], size_t count,
+                             const input_item_t *media);
+
+ssize_t
+vlc_playlist_index_FindId(struct vlc_playlist_index *index,
+                          vlc_playlist_item_t *const items[], size_t count,
+                          uint64_t id);
+
+#endif
@@ -41,6 +41,9 @@ player_on_current_media_changed(vlc_player_t *player, input_item_t *new_media,
     /* the playlist and the player share the lock */
     vlc_playlist_AssertLocked(playlist);
 
+    /* the previous media will not post any more subtrees */
+    vlc_playlist_CancelExpansions(playlist, NULL, VLC_PLAYLIST_EXPAND_PLAYER);
+
     input_item_t *media = playlist->current != -1
                         ? playlist->items.data[playlist->current]->media
                         : NULL;
@@ -109,7 +112,8 @@ on_player_media_subitems_changed(vlc_player_t *player, input_item_t *media,
     VLC_UNUSED(player);
     VLC_UNUSED(media);
     vlc_playlist_t *playlist = userdata;
-    vlc_playlist_ExpandItemFromNode(playlist, subitems);
+    vlc_playlist_ExpandItemFromNode(playlist, subitems,
+                                    VLC_PLAYLIST_EXPAND_PLAYER);
 }
 
 static input_item_t *
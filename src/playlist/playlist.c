@@ -45,7 +45,9 @@ vlc_playlist_New(vlc_object_t *parent)
     }
 
     vlc_vector_init(&playlist->items);
+    vlc_playlist_index_Init(&playlist->index);
     randomizer_Init(&playlist->randomizer);
+    vlc_vector_init(&playlist->expansions);
     playlist->current = -1;
     playlist->has_prev = false;
     playlist->has_next = false;
@@ -72,6 +74,7 @@ vlc_playlist_Delete(vlc_playlist_t *playlist)
 
     vlc_playlist_PlayerDestroy(playlist);
     randomizer_Destroy(&playlist->randomizer);
+    vlc_playlist_ClearExpansions(playlist);
     vlc_playlist_ClearItems(playlist);
     free(playlist);
 }
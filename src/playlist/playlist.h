@@ -25,6 +25,8 @@
 #include <vlc_playlist.h>
 #include <vlc_vector.h>
 #include "../player/player.h"
+#include "index.h"
+#include "preparse.h"
 #include "randomizer.h"
 
 typedef struct input_item_t input_item_t;
@@ -44,6 +46,8 @@ typedef struct input_item_t input_item_t;
 #endif /* TEST_PLAYLIST */
 
 typedef struct VLC_VECTOR(vlc_playlist_item_t *) playlist_item_vector_t;
+typedef struct VLC_VECTOR(struct vlc_playlist_expansion)
+    playlist_expansion_vector_t;
 
 struct vlc_playlist
 {
@@ -53,7 +57,9 @@ struct vlc_playlist
     /* all remaining fields are protected by the lock of the player */
     struct vlc_player_listener_id *player_listener;
     playlist_item_vector_t items;
+    struct vlc_playlist_index index;
     struct randomizer randomizer;
+    playlist_expansion_vector_t expansions;
     ssize_t current;
     bool has_prev;
     bool has_next;
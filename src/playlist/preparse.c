@@ -25,6 +25,7 @@
 #include "preparse.h"
 
 #include "content.h"
+#include "control.h"
 #include "item.h"
 #include "playlist.h"
 #include "notify.h"
@@ -47,33 +48,173 @@ vlc_playlist_CollectChildren(vlc_playlist_t *playlist,
     }
 }
 
-int
-vlc_playlist_ExpandItem(vlc_playlist_t *playlist, size_t index,
-                        input_item_node_t *node)
+static int
+vlc_playlist_ExpandNode(vlc_playlist_t *playlist, size_t index,
+                        input_item_node_t *node, bool partial)
 {
     vlc_playlist_AssertLocked(playlist);
 
     media_vector_t flatten = VLC_VECTOR_INITIALIZER;
     vlc_playlist_CollectChildren(playlist, &flatten, node);
 
-    int ret = vlc_playlist_Expand(playlist, index, flatten.data, flatten.size);
+    int ret = vlc_playlist_Expand(playlist, index, flatten.data, flatten.size,
+                                  partial);
     vlc_vector_destroy(&flatten);
 
     return ret;
 }
 
+int
+vlc_playlist_ExpandItem(vlc_playlist_t *playlist, size_t index,
+                        input_item_node_t *node)
+{
+    return vlc_playlist_ExpandNode(playlist, index, node, false);
+}
+
+static struct vlc_playlist_expansion *
+vlc_playlist_FindExpansion(vlc_playlist_t *playlist, input_item_t *media,
+                           enum vlc_playlist_expand_source source)
+{
+    for (size_t i = 0; i < playlist->expansions.size; ++i)
+    {
+        struct vlc_playlist_expansion *exp = &playlist->expansions.data[i];
+        if (exp->media == media && exp->source == source)
+            return exp;
+    }
+    return NULL;
+}
+
+static void
+vlc_playlist_RemoveExpansion(vlc_playlist_t *playlist,
+                             struct vlc_playlist_expansion *exp)
+{
+    input_item_Release(exp->media);
+    input_item_Release(exp->last);
+    vlc_vector_remove(&playlist->expansions, exp - playlist->expansions.data);
+}
+
+void
+vlc_playlist_CancelExpansions(vlc_playlist_t *playlist, input_item_t *media,
+                              enum vlc_playlist_expand_source source)
+{
+    vlc_playlist_AssertLocked(playlist);
+
+    for (size_t i = playlist->expansions.size; i > 0; --i)
+    {
+        struct vlc_playlist_expansion *exp = &playlist->expansions.data[i - 1];
+        if (exp->source == source && (!media || exp->media == media))
+            vlc_playlist_RemoveExpansion(playlist, exp);
+    }
+}
+
+void
+vlc_playlist_ClearExpansions(vlc_playlist_t *playlist)
+{
+    for (size_t i = 0; i < playlist->expansions.size; ++i)
+    {
+        input_item_Release(playlist->expansions.data[i].media);
+        input_item_Release(playlist->expansions.data[i].last);
+    }
+    vlc_vector_destroy(&playlist->expansions);
+}
+
+static input_item_t *
+vlc_playlist_LastMedia(input_item_node_t *node)
+{
+    /* the subtree is flattened in pre-order */
+    while (node->i_children > 0)
+        node = node->pp_children[node->i_children - 1];
+    return node->p_item;
+}
+
+static int
+vlc_playlist_ContinueExpansion(vlc_playlist_t *playlist,
+                               struct vlc_playlist_expansion *exp,
+                               input_item_node_t *subitems)
+{
+    int ret = VLC_SUCCESS;
+    ssize_t index = vlc_playlist_IndexOfMedia(playlist, exp->last);
+    if (index == -1)
+    {
+        /* the items inserted so far have been removed */
+        vlc_playlist_RemoveExpansion(playlist, exp);
+        return VLC_ENOITEM;
+    }
+
+    if (subitems->i_children > 0)
+    {
+        media_vector_t flatten = VLC_VECTOR_INITIALIZER;
+        vlc_playlist_CollectChildren(playlist, &flatten, subitems);
+
+        ret = vlc_playlist_Insert(playlist, index + 1, flatten.data,
+                                  flatten.size);
+        vlc_vector_destroy(&flatten);
+        if (ret == VLC_SUCCESS)
+        {
+            input_item_Release(exp->last);
+            exp->last = input_item_Hold(vlc_playlist_LastMedia(subitems));
+        }
+    }
+
+    if (!subitems->b_partial || ret != VLC_SUCCESS)
+    {
+        bool current = exp->current;
+        vlc_playlist_RemoveExpansion(playlist, exp);
+        /* the player may now move to the first item of the expansion */
+        if (current && playlist->current != -1)
+            vlc_playlist_SetCurrentMedia(playlist, playlist->current);
+    }
+
+    return ret;
+}
+
 int
 vlc_playlist_ExpandItemFromNode(vlc_playlist_t *playlist,
-                                input_item_node_t *subitems)
+                                input_item_node_t *subitems,
+                                enum vlc_playlist_expand_source source)
 {
     vlc_playlist_AssertLocked(playlist);
     input_item_t *media = subitems->p_item;
     ssize_t index = vlc_playlist_IndexOfMedia(playlist, media);
     if (index == -1)
-        return VLC_ENOITEM;
+    {
+        /* the media has already been replaced by a previous part */
+        struct vlc_playlist_expansion *exp =
+            vlc_playlist_FindExpansion(playlist, media, source);
+        if (!exp)
+            return VLC_ENOITEM;
+        return vlc_playlist_ContinueExpansion(playlist, exp, subitems);
+    }
+
+    /* a new parse of the media restarts its expansion */
+    vlc_playlist_CancelExpansions(playlist, media, source);
+
+    /* if the player is reading the current media, let it post all the parts
+     * before moving to the first expanded item */
+    bool current = index == playlist->current
+                && source == VLC_PLAYLIST_EXPAND_PLAYER && subitems->b_partial;
+    int ret = vlc_playlist_ExpandNode(playlist, index, subitems, current);
+    if (ret != VLC_SUCCESS)
+        return ret;
+
+    if (subitems->b_partial && subitems->i_children > 0)
+    {
+        struct vlc_playlist_expansion exp = {
+            .source = source,
+            .media = input_item_Hold(media),
+            .last = input_item_Hold(vlc_playlist_LastMedia(subitems)),
+            .current = current,
+        };
+        if (!vlc_vector_push(&playlist->expansions, exp))
+        {
+            input_item_Release(exp.media);
+            input_item_Release(exp.last);
+            if (current)
+                vlc_playlist_SetCurrentMedia(playlist, playlist->current);
+        }
+    }
 
-    /* replace the item by its flatten subtree */
-    return vlc_playlist_ExpandItem(playlist, index, subitems);
+    return VLC_SUCCESS;
 }
 
 static void
@@ -84,7 +225,8 @@ on_subtree_added(input_item_t *media, input_item_node_t *subtree,
     vlc_playlist_t *playlist = userdata;
 
     vlc_playlist_Lock(playlist);
-    vlc_playlist_ExpandItemFromNode(playlist, subtree);
+    vlc_playlist_ExpandItemFromNode(playlist, subtree,
+                                    VLC_PLAYLIST_EXPAND_PREPARSER);
     vlc_playlist_Unlock(playlist);
 }
 
@@ -95,10 +237,21 @@ on_preparse_ended(input_item_t *media,
     VLC_UNUSED(media); /* retrieved by subtree->p_item */
     vlc_playlist_t *playlist = userdata;
 
-    if (status != ITEM_PREPARSE_DONE)
+    /* a skipped item is reported synchronously, from vlc_playlist_Preparse()
+     * with the playlist locked, and it never posted any subtree */
+    if (status == ITEM_PREPARSE_SKIPPED)
         return;
 
     vlc_playlist_Lock(playlist);
+    /* the preparser will not post any more subtrees */
+    vlc_playlist_CancelExpansions(playlist, media,
+                                  VLC_PLAYLIST_EXPAND_PREPARSER);
+    if (status != ITEM_PREPARSE_DONE)
+    {
+        vlc_playlist_Unlock(playlist);
+        return;
+    }
+
     ssize_t index = vlc_playlist_IndexOfMedia(playlist, media);
     if (index != -1)
         vlc_playlist_Notify(playlist, on_items_updated, index,
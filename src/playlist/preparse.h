@@ -26,6 +26,22 @@
 typedef struct vlc_playlist vlc_playlist_t;
 typedef struct input_item_node_t input_item_node_t;
 
+/* who posts the subtrees of an expanded item */
+enum vlc_playlist_expand_source
+{
+    VLC_PLAYLIST_EXPAND_PLAYER,
+    VLC_PLAYLIST_EXPAND_PREPARSER,
+};
+
+/* an item whose subtree is received in several parts */
+struct vlc_playlist_expansion
+{
+    enum vlc_playlist_expand_source source;
+    input_item_t *media; /* the expanded media */
+    input_item_t *last; /* the last media inserted so far */
+    bool current; /* the expanded media was the current one */
+};
+
 void
 vlc_playlist_AutoPreparse(vlc_playlist_t *playlist, input_item_t *input);
 
@@ -35,6 +51,16 @@ vlc_playlist_ExpandItem(vlc_playlist_t *playlist, size_t index,
 
 int
 vlc_playlist_ExpandItemFromNode(vlc_playlist_t *playlist,
-                                input_item_node_t *subitems);
+                                input_item_node_t *subitems,
+                                enum vlc_playlist_expand_source source);
+
+/* forget the pending expansions of a media (NULL for all) from a source */
+void
+vlc_playlist_CancelExpansions(vlc_playlist_t *playlist, input_item_t *media,
+                              enum vlc_playlist_expand_source source);
+
+/* called by vlc_playlist_Delete() in playlist.c */
+void
+vlc_playlist_ClearExpansions(vlc_playlist_t *playlist);
 
 #endif
@@ -256,6 +256,11 @@
  * previous shuffle and the start of the new shuffle). */
 #define NOT_SAME_BEFORE 1
 
+/* On auto-reshuffle, only keep the end of the last cycle as ordered history.
+ * The history is the only part that must be shifted on insertions, so this
+ * bounds the cost of edits in loop mode, whatever the playlist size. */
+#define HISTORY_MAX 512
+
 void
 randomizer_Init(struct randomizer *r)
 {
@@ -321,7 +326,19 @@ randomizer_DetermineOne_(struct randomizer *r, size_t avoid_last_n)
     assert(r->items.size - r->head > avoid_last_n);
     size_t range_len = r->items.size - r->head - avoid_last_n;
     size_t selected = r->head + (nrand48(r->xsubi) % range_len);
-    swap_items(r, r->head, selected);
+    if (r->head < r->history && selected >= r->history)
+    {
+        /* extract the item from the history, keeping the history ordered */
+        vlc_playlist_item_t *item = r->items.data[selected];
+        memmove(&r->items.data[r->history + 1],
+                &r->items.data[r->history],
+                (selected - r->history) * sizeof(item));
+        r->items.data[r->history] = r->items.data[r->head];
+        r->items.data[r->head] = item;
+        r->history++;
+    }
+    else
+        swap_items(r, r->head, selected);
 
     if (r->head == r->history)
         r->history++;
@@ -343,7 +360,10 @@ randomizer_AutoReshuffle(struct randomizer *r)
     assert(r->items.size > 0);
     r->head = 0;
     r->next = 0;
-    r->history = 0; /* the whole content is history */
+    /* the whole content is history, but only the last items are kept in
+     * order */
+    r->history = r->items.size > HISTORY_MAX ? r->items.size - HISTORY_MAX
+                                             : 0;
     size_t avoid_last_n = NOT_SAME_BEFORE;
     if (avoid_last_n > r->items.size - 1)
         /* cannot ignore all */
@@ -524,12 +544,64 @@ randomizer_RemoveOne(struct randomizer *r, const vlc_playlist_item_t *item)
     randomizer_RemoveAt(r, index);
 }
 
+static int
+cmp_items(const void *lhs, const void *rhs)
+{
+    uintptr_t a = (uintptr_t) *(vlc_playlist_item_t *const *) lhs;
+    uintptr_t b = (uintptr_t) *(vlc_playlist_item_t *const *) rhs;
+    return a < b ? -1 : a > b;
+}
+
+static int
+cmp_indices_desc(const void *lhs, const void *rhs)
+{
+    size_t a = *(const size_t *) lhs;
+    size_t b = *(const size_t *) rhs;
+    return a > b ? -1 : a < b;
+}
+
+static bool
+randomizer_RemoveBatch(struct randomizer *r, vlc_playlist_item_t *const items[],
+                       size_t count)
+{
+    vlc_playlist_item_t **sorted = vlc_alloc(count, sizeof(*sorted));
+    size_t *indices = vlc_alloc(count, sizeof(*indices));
+    if (unlikely(!sorted || !indices))
+    {
+        free(sorted);
+        free(indices);
+        return false;
+    }
+
+    /* locate all the items in a single pass, instead of one pass per item */
+    memcpy(sorted, items, count * sizeof(*sorted));
+    qsort(sorted, count, sizeof(*sorted), cmp_items);
+
+    size_t found = 0;
+    for (size_t i = 0; i < r->items.size && found < count; ++i)
+        if (bsearch(&r->items.data[i], sorted, count, sizeof(*sorted),
+                    cmp_items))
+            indices[found++] = i;
+    assert(found == count); /* items must exist */
+
+    /* removing an item only moves the items located after it, so removing in
+     * decreasing order keeps the remaining indices valid */
+    qsort(indices, found, sizeof(*indices), cmp_indices_desc);
+    for (size_t i = 0; i < found; ++i)
+        randomizer_RemoveAt(r, indices[i]);
+
+    free(sorted);
+    free(indices);
+    return true;
+}
+
 void
 randomizer_Remove(struct randomizer *r, vlc_playlist_item_t *const items[],
                   size_t count)
 {
-    for (size_t i = 0; i < count; ++i)
-        randomizer_RemoveOne(r, items[i]);
+    if (count == 1 || !randomizer_RemoveBatch(r, items, count))
+        for (size_t i = 0; i < count; ++i)
+            randomizer_RemoveOne(r, items[i]);
 
     vlc_vector_autoshrink(&r->items);
 }
@@ -1209,6 +1281,99 @@ test_has_prev_next_empty(void)
     randomizer_Destroy(&randomizer);
 }
 
+static void
+test_prev_across_reshuffle_bounded_history(void)
+{
+    struct randomizer randomizer;
+    randomizer_Init(&randomizer);
+
+    #define SIZE (HISTORY_MAX + 100)
+    vlc_playlist_item_t **items = malloc(SIZE * sizeof(*items));
+    vlc_playlist_item_t **actual = malloc(SIZE * sizeof(*actual));
+    assert(items && actual);
+    ArrayInit(items, SIZE);
+
+    bool ok = randomizer_Add(&randomizer, items, SIZE);
+    assert(ok);
+
+    for (int i = 0; i < SIZE; ++i)
+    {
+        assert(randomizer_HasNext(&randomizer));
+        actual[i] = randomizer_Next(&randomizer);
+        assert(actual[i]);
+    }
+
+    randomizer_SetLoop(&randomizer, true);
+    vlc_playlist_item_t *first = randomizer_Next(&randomizer);
+    assert(first);
+
+    /* only the end of the last cycle is kept as history, in order */
+    int index_in_actual = SIZE - 1;
+    int count = 0;
+    while (randomizer_HasPrev(&randomizer))
+    {
+        vlc_playlist_item_t *item = randomizer_Prev(&randomizer);
+        if (actual[index_in_actual] == first)
+            /* selected for the new cycle, not in the history anymore */
+            index_in_actual--;
+        assert(item == actual[index_in_actual]);
+        index_in_actual--;
+        count++;
+    }
+    assert(count >= HISTORY_MAX - 1);
+    assert(count <= HISTORY_MAX);
+
+    ArrayDestroy(items, SIZE);
+    free(items);
+    free(actual);
+    randomizer_Destroy(&randomizer);
+    #undef SIZE
+}
+
+static void
+test_remove_batch(void)
+{
+    struct randomizer randomizer;
+    randomizer_Init(&randomizer);
+
+    #define SIZE 100
+    vlc_playlist_item_t *items[SIZE];
+    ArrayInit(items, SIZE);
+
+    bool ok = randomizer_Add(&randomizer, items, SIZE);
+    assert(ok);
+
+    bool selected[SIZE] = {0};
+    for (int i = 0; i < 30; ++i)
+    {
+        vlc_playlist_item_t *item = randomizer_Next(&randomizer);
+        selected[item->index] = true;
+    }
+
+    /* remove every other item at once */
+    vlc_playlist_item_t *removed[SIZE / 2];
+    for (int i = 0; i < SIZE / 2; ++i)
+        removed[i] = items[2 * i];
+    randomizer_Remove(&randomizer, removed, SIZE / 2);
+    assert(randomizer.items.size == SIZE / 2);
+
+    /* the remaining items not selected yet are all selected exactly once */
+    while (randomizer_HasNext(&randomizer))
+    {
+        vlc_playlist_item_t *item = randomizer_Next(&randomizer);
+        assert(item->index % 2 == 1);
+        assert(!selected[item->index]);
+        selected[item->index] = true;
+    }
+
+    for (int i = 1; i < SIZE; i += 2)
+        assert(selected[i]);
+
+    ArrayDestroy(items, SIZE);
+    randomizer_Destroy(&randomizer);
+    #undef SIZE
+}
+
 int main(void)
 {
     test_all_items_selected_exactly_once();
@@ -1222,6 +1387,8 @@ int main(void)
     test_prev();
     test_prev_with_select();
     test_prev_across_reshuffle_loops();
+    test_prev_across_reshuffle_bounded_history();
+    test_remove_batch();
     test_loop_respect_not_same_before();
     test_loop_respect_not_same_before_impossible();
     test_has_prev_next_empty();
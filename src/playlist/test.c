@@ -1065,6 +1065,67 @@ test_index_of(void)
     vlc_playlist_Delete(playlist);
 }
 
+static void
+CheckIndexes(vlc_playlist_t *playlist)
+{
+    size_t count = vlc_playlist_Count(playlist);
+    for (size_t i = 0; i < count; ++i)
+    {
+        vlc_playlist_item_t *item = vlc_playlist_Get(playlist, i);
+        assert(vlc_playlist_IndexOf(playlist, item) == (ssize_t) i);
+        assert(vlc_playlist_IndexOfId(playlist, item->id) == (ssize_t) i);
+    }
+}
+
+static void
+test_index_of_after_changes(void)
+{
+    vlc_playlist_t *playlist = vlc_playlist_New(NULL);
+    assert(playlist);
+
+    /* enough items to grow the hash tables several times */
+    input_item_t *media[1000];
+    CreateDummyMediaArray(media, 1000);
+
+    int ret = vlc_playlist_Append(playlist, media, 1000);
+    assert(ret == VLC_SUCCESS);
+    CheckIndexes(playlist);
+
+    vlc_playlist_Move(playlist, 100, 50, 700);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[100]) == 700);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[150]) == 100);
+    CheckIndexes(playlist);
+
+    vlc_playlist_item_t *item = vlc_playlist_Get(playlist, 10);
+    uint64_t id = item->id;
+    vlc_playlist_Remove(playlist, 10, 20);
+    assert(vlc_playlist_IndexOfId(playlist, id) == -1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[10]) == -1);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[30]) == 10);
+    CheckIndexes(playlist);
+
+    /* the same media twice, the first occurrence is reported */
+    ret = vlc_playlist_Insert(playlist, 500, &media[999], 1);
+    assert(ret == VLC_SUCCESS);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[999]) == 500);
+    vlc_playlist_RemoveOne(playlist, 500);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[999]) == 979);
+    CheckIndexes(playlist);
+
+    vlc_playlist_Shuffle(playlist);
+    CheckIndexes(playlist);
+
+    vlc_playlist_Clear(playlist);
+    assert(vlc_playlist_IndexOfMedia(playlist, media[0]) == -1);
+
+    ret = vlc_playlist_Append(playlist, media, 10);
+    assert(ret == VLC_SUCCESS);
+    CheckIndexes(playlist);
+
+    DestroyMediaArray(media, 1000);
+    vlc_playlist_Delete(playlist);
+}
+
 static void
 test_prev(void)
 {
@@ -2367,6 +2428,7 @@ int main(void)
     test_playback_order_changed_callbacks();
     test_callbacks_on_add_listener();
     test_index_of();
+    test_index_of_after_changes();
     test_prev();
     test_next();
     test_goto();
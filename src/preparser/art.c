@@ -27,6 +27,7 @@
 
 #include <sys/stat.h>
 #include <errno.h>
+#include <time.h>
 
 #include <vlc_common.h>
 #include <vlc_input_item.h>
@@ -34,8 +35,38 @@
 #include <vlc_strings.h>
 #include <vlc_url.h>
 #include <vlc_hash.h>
+#include <vlc_hashmap.h>
+#include <vlc_list.h>
 
 #include "art.h"
+#include "../libvlc.h"
+
+/* In-memory index of the art cache directory, so that lookups do not hit the
+ * file system, and the total size of the cache can be bounded */
+struct art_cache_entry
+{
+    struct vlc_list node; /**< vlc_art_cache.lru, most recently used first */
+    char *psz_dir;
+    char *psz_file;
+    uint64_t i_size;
+    time_t i_mtime;
+};
+
+struct vlc_art_cache
+{
+    vlc_mutex_t lock;
+    char *psz_cachedir;
+    vlc_hashmap_t entries; /**< art_cache_entry by cache directory */
+    struct vlc_list lru;
+    uint64_t i_size;
+    uint64_t i_max_size; /**< 0 if unbounded */
+    bool b_scanned;
+};
+
+static struct vlc_art_cache *ArtCacheGet( vlc_object_t *obj )
+{
+    return libvlc_priv( vlc_object_instance( obj ) )->art_cache;
+}
 
 static void ArtCacheCreateDir( const char *psz_dir )
 {
@@ -57,27 +88,23 @@ static void ArtCacheCreateDir( const char *psz_dir )
     vlc_mkdir( psz_dir, 0700 );
 }
 
-static char* ArtCacheGetDirPath( const char *psz_arturl, const char *psz_artist,
+static char* ArtCacheGetDirPath( const char *psz_cachedir,
+                                 const char *psz_arturl, const char *psz_artist,
                                  const char *psz_album,  const char *psz_date,
                                  const char *psz_title )
 {
     char *psz_dir;
-    char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
 
     if( !EMPTY_STR(psz_artist) && !EMPTY_STR(psz_album) )
     {
         char *psz_album_sanitized = strdup( psz_album );
         if (!psz_album_sanitized)
-        {
-            free( psz_cachedir );
             return NULL;
-        }
         filename_sanitize( psz_album_sanitized );
 
         char *psz_artist_sanitized = strdup( psz_artist );
         if (!psz_artist_sanitized)
         {
-            free( psz_cachedir );
             free( psz_album_sanitized );
             return NULL;
         }
@@ -119,11 +146,10 @@ static char* ArtCacheGetDirPath( const char *psz_arturl, const char *psz_artist,
                       "%s", psz_cachedir, psz_arturl_sanitized ) == -1 )
             psz_dir = NULL;
     }
-    free( psz_cachedir );
     return psz_dir;
 }
 
-static char *ArtCachePath( input_item_t *p_item )
+static char *ArtCachePath( struct vlc_art_cache *cache, input_item_t *p_item )
 {
     char* psz_path = NULL;
     const char *psz_artist;
@@ -150,16 +176,29 @@ static char *ArtCachePath( input_item_t *p_item )
     if( (EMPTY_STR(psz_artist) || EMPTY_STR(psz_album) ) && !psz_arturl )
         goto end;
 
-    psz_path = ArtCacheGetDirPath( psz_arturl, psz_artist, psz_album, psz_date, psz_title );
+    if( cache != NULL )
+        psz_path = ArtCacheGetDirPath( cache->psz_cachedir, psz_arturl,
+                                       psz_artist, psz_album, psz_date,
+                                       psz_title );
+    else
+    {
+        char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
+        if( psz_cachedir != NULL )
+            psz_path = ArtCacheGetDirPath( psz_cachedir, psz_arturl,
+                                           psz_artist, psz_album, psz_date,
+                                           psz_title );
+        free( psz_cachedir );
+    }
 
 end:
     vlc_mutex_unlock( &p_item->lock );
     return psz_path;
 }
 
-static char *ArtCacheName( input_item_t *p_item, const char *psz_type )
+static char *ArtCacheName( struct vlc_art_cache *cache, input_item_t *p_item,
+                           const char *psz_type )
 {
-    char *psz_path = ArtCachePath( p_item );
+    char *psz_path = ArtCachePath( cache, p_item );
     char *psz_ext = strdup( psz_type ? psz_type : "" );
     char *psz_filename = NULL;
 
@@ -179,21 +218,206 @@ end:
     return psz_filename;
 }
 
-/* */
-int input_FindArtInCache( input_item_t *p_item )
+static void ArtCacheRemove( struct vlc_art_cache *cache,
+                            struct art_cache_entry *entry )
 {
-    char *psz_path = ArtCachePath( p_item );
+    vlc_hashmap_str_remove( &cache->entries, entry->psz_dir );
+    vlc_list_remove( &entry->node );
+    cache->i_size -= entry->i_size;
+    free( entry->psz_dir );
+    free( entry->psz_file );
+    free( entry );
+}
 
-    if( !psz_path )
-        return VLC_EGENERIC;
+static struct art_cache_entry *
+ArtCacheAdd( struct vlc_art_cache *cache, const char *psz_dir,
+             const char *psz_file, uint64_t i_size, time_t i_mtime )
+{
+    struct art_cache_entry *entry =
+        vlc_hashmap_str_get( &cache->entries, psz_dir );
+    if( entry != NULL )
+        ArtCacheRemove( cache, entry );
+
+    entry = malloc( sizeof( *entry ) );
+    if( unlikely(entry == NULL) )
+        return NULL;
+    entry->psz_dir = strdup( psz_dir );
+    entry->psz_file = strdup( psz_file );
+    if( unlikely(entry->psz_dir == NULL || entry->psz_file == NULL)
+     || vlc_hashmap_str_insert( &cache->entries, psz_dir, entry ) )
+    {
+        free( entry->psz_dir );
+        free( entry->psz_file );
+        free( entry );
+        return NULL;
+    }
+    entry->i_size = i_size;
+    entry->i_mtime = i_mtime;
+
+    vlc_list_prepend( &entry->node, &cache->lru );
+    cache->i_size += i_size;
+    return entry;
+}
+
+/* Remove the least recently used art until the cache fits its size limit */
+static void ArtCacheEvict( vlc_object_t *obj, struct vlc_art_cache *cache,
+                           const struct art_cache_entry *keep )
+{
+    while( cache->i_max_size != 0 && cache->i_size > cache->i_max_size )
+    {
+        struct art_cache_entry *entry =
+            vlc_list_last_entry_or_null( &cache->lru, struct art_cache_entry,
+                                         node );
+        if( entry == NULL || entry == keep )
+            break;
+
+        msg_Dbg( obj, "evicting album art %s", entry->psz_file );
+        vlc_unlink( entry->psz_file );
+        ArtCacheRemove( cache, entry );
+    }
+}
+
+static void ArtCacheScanDir( struct vlc_art_cache *cache, const char *psz_dir,
+                             unsigned i_depth )
+{
+    DIR *p_dir = vlc_opendir( psz_dir );
+    if( !p_dir )
+        return;
+
+    const char *psz_filename;
+    while( (psz_filename = vlc_readdir( p_dir )) != NULL )
+    {
+        if( psz_filename[0] == '.' )
+            continue;
+
+        char *psz_file;
+        if( asprintf( &psz_file, "%s" DIR_SEP "%s", psz_dir,
+                      psz_filename ) == -1 )
+            continue;
+
+        struct stat st;
+        if( !vlc_stat( psz_file, &st ) )
+        {
+            /* art/artistalbum/<artist>/<date>/<album>/art* is the deepest */
+            if( S_ISDIR( st.st_mode ) )
+            {
+                if( i_depth < 4 )
+                    ArtCacheScanDir( cache, psz_file, i_depth + 1 );
+            }
+            else if( !strncmp( psz_filename, "art", 3 )
+                  && vlc_hashmap_str_lookup( &cache->entries, psz_dir ) == NULL )
+                ArtCacheAdd( cache, psz_dir, psz_file, st.st_size,
+                             st.st_mtime );
+        }
+        free( psz_file );
+    }
+    closedir( p_dir );
+}
+
+static int ArtCacheCompareMtime( const void *a, const void *b )
+{
+    const struct art_cache_entry *ea = *(const struct art_cache_entry **)a;
+    const struct art_cache_entry *eb = *(const struct art_cache_entry **)b;
+    /* most recent first */
+    return (ea->i_mtime < eb->i_mtime) - (ea->i_mtime > eb->i_mtime);
+}
+
+/* Index the existing cache on first use; the lock must be held */
+static void ArtCacheScan( vlc_object_t *obj, struct vlc_art_cache *cache )
+{
+    if( cache->b_scanned )
+        return;
+    cache->b_scanned = true;
+
+    char *psz_root;
+    if( asprintf( &psz_root, "%s" DIR_SEP "art", cache->psz_cachedir ) == -1 )
+        return;
+    vlc_tick_t start = vlc_tick_now();
+    ArtCacheScanDir( cache, psz_root, 0 );
+    free( psz_root );
+
+    /* there is no use time on disk, start from the modification times */
+    size_t i_count = vlc_hashmap_count( &cache->entries );
+    struct art_cache_entry **pp_entries =
+        vlc_alloc( i_count, sizeof( *pp_entries ) );
+    if( pp_entries != NULL )
+    {
+        size_t i = 0;
+        struct art_cache_entry *entry;
+        vlc_list_foreach( entry, &cache->lru, node )
+        {
+            vlc_list_remove( &entry->node );
+            pp_entries[i++] = entry;
+        }
+        qsort( pp_entries, i, sizeof( *pp_entries ), ArtCacheCompareMtime );
+        for( size_t j = 0; j < i; j++ )
+            vlc_list_append( &pp_entries[j]->node, &cache->lru );
+        free( pp_entries );
+    }
+
+    msg_Dbg( obj, "indexed %zu album art (%"PRIu64" KiB) in %"PRId64" ms",
+             i_count, cache->i_size / 1024,
+             MS_FROM_VLC_TICK( vlc_tick_now() - start ) );
+    ArtCacheEvict( obj, cache, NULL );
+}
+
+/* Look the directory up in the index, the lock must be held */
+static struct art_cache_entry *
+ArtCacheLookup( vlc_object_t *obj, struct vlc_art_cache *cache,
+                const char *psz_dir )
+{
+    ArtCacheScan( obj, cache );
+
+    struct art_cache_entry *entry =
+        vlc_hashmap_str_get( &cache->entries, psz_dir );
+    if( entry != NULL )
+    {
+        vlc_list_remove( &entry->node );
+        vlc_list_prepend( &entry->node, &cache->lru );
+    }
+    return entry;
+}
+
+struct vlc_art_cache *vlc_art_cache_New( vlc_object_t *obj )
+{
+    struct vlc_art_cache *cache = malloc( sizeof( *cache ) );
+    if( unlikely(cache == NULL) )
+        return NULL;
+
+    cache->psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( cache->psz_cachedir == NULL )
+    {
+        free( cache );
+        return NULL;
+    }
+
+    vlc_mutex_init( &cache->lock );
+    vlc_hashmap_init_str( &cache->entries );
+    vlc_list_init( &cache->lru );
+    cache->i_size = 0;
+    cache->i_max_size = (uint64_t)var_InheritInteger( obj, "art-cache-size" )
+                      * 1024 * 1024;
+    cache->b_scanned = false;
+    return cache;
+}
+
+void vlc_art_cache_Delete( struct vlc_art_cache *cache )
+{
+    struct art_cache_entry *entry;
+    vlc_list_foreach( entry, &cache->lru, node )
+        ArtCacheRemove( cache, entry );
+    vlc_hashmap_clear( &cache->entries, NULL, NULL );
+    free( cache->psz_cachedir );
+    free( cache );
+}
+
+static int ArtCacheFindOnDisk( input_item_t *p_item, char *psz_path )
+{
 
     /* Check if file exists */
     DIR *p_dir = vlc_opendir( psz_path );
     if( !p_dir )
-    {
-        free( psz_path );
         return VLC_EGENERIC;
-    }
 
     bool b_found = false;
     const char *psz_filename;
@@ -220,10 +444,40 @@ int input_FindArtInCache( input_item_t *p_item )
 
     /* */
     closedir( p_dir );
-    free( psz_path );
     return b_found ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
+/* */
+int input_FindArtInCache( vlc_object_t *obj, input_item_t *p_item )
+{
+    struct vlc_art_cache *cache = ArtCacheGet( obj );
+    char *psz_path = ArtCachePath( cache, p_item );
+
+    if( !psz_path )
+        return VLC_EGENERIC;
+
+    if( cache == NULL )
+    {
+        int ret = ArtCacheFindOnDisk( p_item, psz_path );
+        free( psz_path );
+        return ret;
+    }
+
+    char *psz_uri = NULL;
+    vlc_mutex_lock( &cache->lock );
+    struct art_cache_entry *entry = ArtCacheLookup( obj, cache, psz_path );
+    if( entry != NULL )
+        psz_uri = vlc_path2uri( entry->psz_file, "file" );
+    vlc_mutex_unlock( &cache->lock );
+    free( psz_path );
+
+    if( psz_uri == NULL )
+        return VLC_EGENERIC;
+    input_item_SetArtURL( p_item, psz_uri );
+    free( psz_uri );
+    return VLC_SUCCESS;
+}
+
 static char * GetDirByItemUIDs( char *psz_uid )
 {
     char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
@@ -249,8 +503,9 @@ static char * GetFileByItemUID( char *psz_dir, const char *psz_type )
     return psz_file;
 }
 
-int input_FindArtInCacheUsingItemUID( input_item_t *p_item )
+int input_FindArtInCacheUsingItemUID( vlc_object_t *obj, input_item_t *p_item )
 {
+    struct vlc_art_cache *cache = ArtCacheGet( obj );
     char *uid = input_item_GetInfo( p_item, "uid", "md5" );
     if ( ! *uid )
     {
@@ -272,8 +527,24 @@ int input_FindArtInCacheUsingItemUID( input_item_t *p_item )
             /* read the cache hash url */
             if ( fgets( sz_cachefile, 2048, fd ) != NULL )
             {
-                input_item_SetArtURL( p_item, sz_cachefile );
-                b_done = true;
+                /* the art may have been evicted since */
+                char *psz_file = cache != NULL ? vlc_uri2path( sz_cachefile )
+                                               : NULL;
+                char *psz_sep = psz_file != NULL
+                              ? strrchr( psz_file, DIR_SEP_CHAR ) : NULL;
+                if( cache == NULL )
+                    b_done = true;
+                else if( psz_sep != NULL )
+                {
+                    *psz_sep = '\0';
+                    vlc_mutex_lock( &cache->lock );
+                    b_done = ArtCacheLookup( obj, cache, psz_file ) != NULL;
+                    vlc_mutex_unlock( &cache->lock );
+                }
+                free( psz_file );
+
+                if( b_done )
+                    input_item_SetArtURL( p_item, sz_cachefile );
             }
             fclose( fd );
         }
@@ -289,7 +560,8 @@ int input_FindArtInCacheUsingItemUID( input_item_t *p_item )
 int input_SaveArt( vlc_object_t *obj, input_item_t *p_item,
                    const void *data, size_t length, const char *psz_type )
 {
-    char *psz_filename = ArtCacheName( p_item, psz_type );
+    struct vlc_art_cache *cache = ArtCacheGet( obj );
+    char *psz_filename = ArtCacheName( cache, p_item, psz_type );
 
     if( !psz_filename )
         return VLC_EGENERIC;
@@ -312,6 +584,7 @@ int input_SaveArt( vlc_object_t *obj, input_item_t *p_item,
     }
 
     /* Dump it otherwise */
+    bool b_saved = false;
     FILE *f = vlc_fopen( psz_filename, "wb" );
     if( f )
     {
@@ -323,9 +596,23 @@ int input_SaveArt( vlc_object_t *obj, input_item_t *p_item,
         {
             msg_Dbg( obj, "album art saved to %s", psz_filename );
             input_item_SetArtURL( p_item, psz_uri );
+            b_saved = true;
         }
         fclose( f );
     }
+
+    char *psz_dir = b_saved && cache != NULL ? strdup( psz_filename ) : NULL;
+    if( psz_dir != NULL )
+    {
+        *strrchr( psz_dir, DIR_SEP_CHAR ) = '\0';
+        vlc_mutex_lock( &cache->lock );
+        ArtCacheScan( obj, cache );
+        const struct art_cache_entry *entry =
+            ArtCacheAdd( cache, psz_dir, psz_filename, length, time( NULL ) );
+        ArtCacheEvict( obj, cache, entry );
+        vlc_mutex_unlock( &cache->lock );
+        free( psz_dir );
+    }
     free( psz_uri );
 
     /* save uid info */
@@ -24,8 +24,19 @@
 #ifndef _INPUT_ART_H
 #define _INPUT_ART_H 1
 
-int input_FindArtInCache( input_item_t * );
-int input_FindArtInCacheUsingItemUID( input_item_t * );
+struct vlc_art_cache;
+
+/**
+ * Creates the in-memory index of the art cache directory.
+ *
+ * The cache is bounded by the "art-cache-size" option, least recently used
+ * art being removed from the disk first.
+ */
+struct vlc_art_cache *vlc_art_cache_New( vlc_object_t * );
+void vlc_art_cache_Delete( struct vlc_art_cache * );
+
+int input_FindArtInCache( vlc_object_t *, input_item_t * );
+int input_FindArtInCacheUsingItemUID( vlc_object_t *, input_item_t * );
 
 int input_SaveArt( vlc_object_t *, input_item_t *,
                    const void *, size_t, const char *psz_type );
@@ -0,0 +1,357 @@
+/*****************************************************************************
+ * cache.c
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_es.h>
+#include <vlc_fs.h>
+#include <vlc_hash.h>
+#include <vlc_input_item.h>
+#include <vlc_strings.h>
+#include <vlc_url.h>
+
+#include "input/item.h"
+#include "cache.h"
+
+#define CACHE_MAGIC "vlc-preparse 1"
+
+/* Returns the URI of a local file, and its status */
+static char *CacheGetSource( input_item_t *item, struct stat *st )
+{
+    vlc_mutex_lock( &item->lock );
+    bool cacheable = item->i_type == ITEM_TYPE_FILE && !item->b_net;
+    vlc_mutex_unlock( &item->lock );
+    if( !cacheable )
+        return NULL;
+
+    char *uri = input_item_GetURI( item );
+    if( uri == NULL )
+        return NULL;
+
+    char *path = vlc_uri2path( uri );
+    if( path == NULL || vlc_stat( path, st ) || !S_ISREG( st->st_mode ) )
+    {
+        free( path );
+        free( uri );
+        return NULL;
+    }
+    free( path );
+    return uri;
+}
+
+static char *CacheGetPath( const char *uri, bool create )
+{
+    char *cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( cachedir == NULL )
+        return NULL;
+
+    char hash[VLC_HASH_MD5_DIGEST_HEX_SIZE];
+    vlc_hash_md5_t md5;
+    vlc_hash_md5_Init( &md5 );
+    vlc_hash_md5_Update( &md5, uri, strlen( uri ) );
+    vlc_hash_FinishHex( &md5, hash );
+
+    char *path;
+    if( asprintf( &path, "%s" DIR_SEP "preparse", cachedir ) == -1 )
+        path = NULL;
+    else if( create )
+    {
+        vlc_mkdir( cachedir, 0700 );
+        vlc_mkdir( path, 0700 );
+    }
+    free( cachedir );
+
+    if( path != NULL )
+    {
+        char *file;
+        if( asprintf( &file, "%s" DIR_SEP "%s", path, hash ) == -1 )
+            file = NULL;
+        free( path );
+        path = file;
+    }
+    return path;
+}
+
+/* Strings are stored one per line, with backslashes and newlines escaped */
+static void CacheWriteString( FILE *file, const char *key, const char *str )
+{
+    fprintf( file, "%s ", key );
+    for( ; *str; str++ )
+    {
+        if( *str == '\\' )
+            fputs( "\\\\", file );
+        else if( *str == '\n' )
+            fputs( "\\n", file );
+        else if( *str == '\r' )
+            fputs( "\\r", file );
+        else
+            fputc( *str, file );
+    }
+    fputc( '\n', file );
+}
+
+static void CacheUnescape( char *str )
+{
+    char *out = str;
+    for( ; *str; str++ )
+    {
+        if( *str == '\\' && str[1] )
+        {
+            str++;
+            *(out++) = *str == 'n' ? '\n' : *str == 'r' ? '\r' : *str;
+        }
+        else
+            *(out++) = *str;
+    }
+    *out = '\0';
+}
+
+bool input_preparser_cache_Load( vlc_object_t *obj, input_item_t *item )
+{
+    struct stat st;
+    char *uri = CacheGetSource( item, &st );
+    if( uri == NULL )
+        return false;
+
+    char *path = CacheGetPath( uri, false );
+    FILE *file = path ? vlc_fopen( path, "rt" ) : NULL;
+    free( path );
+    if( file == NULL )
+    {
+        free( uri );
+        return false;
+    }
+
+    char *line = NULL;
+    size_t linesize = 0;
+    ssize_t len;
+    bool valid = false;
+    unsigned checked = 0;
+    es_format_t *es = NULL;
+    es_format_t **es_list = NULL;
+    size_t es_count = 0;
+    vlc_tick_t duration = INPUT_DURATION_UNSET;
+    char *meta[VLC_META_TYPE_COUNT] = { NULL };
+
+    if( getline( &line, &linesize, file ) < 0
+     || strcmp( line, CACHE_MAGIC "\n" ) )
+        goto end;
+
+    while( (len = getline( &line, &linesize, file )) > 0 )
+    {
+        if( line[len - 1] != '\n' )
+            goto end; /* truncated */
+        line[len - 1] = '\0';
+
+        char *value = strchr( line, ' ' );
+        if( value == NULL )
+            goto end;
+        *(value++) = '\0';
+
+        if( !strcmp( line, "uri" ) )
+        {
+            CacheUnescape( value );
+            if( strcmp( value, uri ) )
+                goto end; /* hash collision */
+            checked |= 1;
+        }
+        else if( !strcmp( line, "mtime" ) )
+        {
+            if( strtoll( value, NULL, 10 ) != (long long) st.st_mtime )
+                goto end;
+            checked |= 2;
+        }
+        else if( !strcmp( line, "size" ) )
+        {
+            if( strtoll( value, NULL, 10 ) != (long long) st.st_size )
+                goto end;
+            checked |= 4;
+        }
+        else if( !strcmp( line, "duration" ) )
+            duration = strtoll( value, NULL, 10 );
+        else if( !strcmp( line, "meta" ) )
+        {
+            char *str;
+            unsigned long type = strtoul( value, &str, 10 );
+            if( type >= VLC_META_TYPE_COUNT || *str != ' ' )
+                goto end;
+            CacheUnescape( ++str );
+            free( meta[type] );
+            meta[type] = strdup( str );
+        }
+        else if( !strcmp( line, "es" ) )
+        {
+            int cat, id;
+            unsigned codec, original, a, b, c, d;
+            if( sscanf( value, "%d %d %x %x %u %u %u %u", &cat, &id, &codec,
+                        &original, &a, &b, &c, &d ) != 8
+             || cat < UNKNOWN_ES || cat > DATA_ES )
+                goto end;
+
+            es = malloc( sizeof (*es) );
+            if( es == NULL )
+                goto end;
+            es_format_Init( es, cat, codec );
+            es->i_id = id;
+            es->i_original_fourcc = original;
+            if( cat == VIDEO_ES )
+            {
+                es->video.i_width = es->video.i_visible_width = a;
+                es->video.i_height = es->video.i_visible_height = b;
+                es->video.i_frame_rate = c;
+                es->video.i_frame_rate_base = d;
+            }
+            else if( cat == AUDIO_ES )
+            {
+                es->audio.i_channels = a;
+                es->audio.i_rate = b;
+            }
+            TAB_APPEND( es_count, es_list, es );
+        }
+        else if( !strcmp( line, "es-language" ) && es != NULL )
+        {
+            CacheUnescape( value );
+            free( es->psz_language );
+            es->psz_language = strdup( value );
+        }
+        else if( !strcmp( line, "es-description" ) && es != NULL )
+        {
+            CacheUnescape( value );
+            free( es->psz_description );
+            es->psz_description = strdup( value );
+        }
+        /* unknown lines are skipped */
+    }
+    valid = checked == 7;
+
+    if( valid )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+            if( meta[i] != NULL )
+                input_item_SetMeta( item, i, meta[i] );
+        if( duration != INPUT_DURATION_UNSET )
+            input_item_SetDuration( item, duration );
+        for( size_t i = 0; i < es_count; i++ )
+            input_item_UpdateTracksInfo( item, es_list[i] );
+        msg_Dbg( obj, "preparsed %s from cache", uri );
+    }
+
+end:
+    for( size_t i = 0; i < es_count; i++ )
+    {
+        es_format_Clean( es_list[i] );
+        free( es_list[i] );
+    }
+    TAB_CLEAN( es_count, es_list );
+    for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+        free( meta[i] );
+    free( line );
+    fclose( file );
+    free( uri );
+    return valid;
+}
+
+void input_preparser_cache_Store( vlc_object_t *obj, input_item_t *item )
+{
+    struct stat st;
+    char *uri = CacheGetSource( item, &st );
+    if( uri == NULL )
+        return;
+
+    char *path = CacheGetPath( uri, true );
+    char *tmp;
+    if( path == NULL
+     || asprintf( &tmp, "%s.%lu", path, vlc_thread_id() ) == -1 )
+    {
+        free( path );
+        free( uri );
+        return;
+    }
+
+    FILE *file = vlc_fopen( tmp, "wt" );
+    if( file == NULL )
+    {
+        msg_Dbg( obj, "cannot write preparse cache %s: %s", tmp,
+                 vlc_strerror_c(errno) );
+        goto end;
+    }
+
+    fputs( CACHE_MAGIC "\n", file );
+    CacheWriteString( file, "uri", uri );
+    fprintf( file, "mtime %lld\nsize %lld\n", (long long) st.st_mtime,
+             (long long) st.st_size );
+
+    vlc_mutex_lock( &item->lock );
+    if( item->i_duration != INPUT_DURATION_UNSET )
+        fprintf( file, "duration %"PRId64"\n", item->i_duration );
+    if( item->p_meta != NULL )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+        {
+            const char *value = vlc_meta_Get( item->p_meta, i );
+            if( value != NULL )
+            {
+                char key[16];
+                snprintf( key, sizeof (key), "meta %d", i );
+                CacheWriteString( file, key, value );
+            }
+        }
+    }
+    for( int i = 0; i < item->i_es; i++ )
+    {
+        const es_format_t *es = item->es[i];
+        unsigned a = 0, b = 0, c = 0, d = 0;
+
+        if( es->i_cat == VIDEO_ES )
+        {
+            a = es->video.i_visible_width;
+            b = es->video.i_visible_height;
+            c = es->video.i_frame_rate;
+            d = es->video.i_frame_rate_base;
+        }
+        else if( es->i_cat == AUDIO_ES )
+        {
+            a = es->audio.i_channels;
+            b = es->audio.i_rate;
+        }
+        fprintf( file, "es %d %d %x %x %u %u %u %u\n", es->i_cat, es->i_id,
+                 es->i_codec, es->i_original_fourcc, a, b, c, d );
+        if( es->psz_language != NULL )
+            CacheWriteString( file, "es-language", es->psz_language );
+        if( es->psz_description != NULL )
+            CacheWriteString( file, "es-description", es->psz_description );
+    }
+    vlc_mutex_unlock( &item->lock );
+
+    if( fclose( file ) || vlc_rename( tmp, path ) )
+        vlc_unlink( tmp );
+end:
+    free( tmp );
+    free( path );
+    free( uri );
+}
@@ -0,0 +1,47 @@
+/*****************************************************************************
+ * cache.h
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _INPUT_PREPARSER_CACHE_H
+#define _INPUT_PREPARSER_CACHE_H 1
+
+#include <vlc_input_item.h>
+
+/**
+ * Persistent cache of the preparsing results.
+ *
+ * Only local files are cached, keyed by their URI, and the entries are
+ * invalidated when the modification time or the size of the file changes.
+ * The meta data, the duration and the main properties of the elementary
+ * streams are stored.
+ */
+
+/**
+ * Fills the item from the cache.
+ *
+ * \return true if an up to date entry was found
+ */
+bool input_preparser_cache_Load( vlc_object_t *, input_item_t * );
+
+/**
+ * Stores the preparsing result of the item in the cache.
+ */
+void input_preparser_cache_Store( vlc_object_t *, input_item_t * );
+
+#endif
@@ -28,6 +28,7 @@
 #include <vlc_modules.h>
 #include <vlc_interrupt.h>
 #include <vlc_arrays.h>
+#include <vlc_hashmap.h>
 #include <vlc_threads.h>
 #include <vlc_memstream.h>
 #include <vlc_meta_fetcher.h>
@@ -44,7 +45,7 @@ struct input_fetcher_t {
     struct background_worker* network;
     struct background_worker* downloader;
 
-    vlc_dictionary_t album_cache;
+    vlc_hashmap_t album_cache;
     vlc_object_t* owner;
     vlc_mutex_t lock;
 };
@@ -113,8 +114,7 @@ static int ReadAlbumCache( input_fetcher_t* fetcher, input_item_t* item )
         return VLC_EGENERIC;
 
     vlc_mutex_lock( &fetcher->lock );
-    char const* art = vlc_dictionary_value_for_key( &fetcher->album_cache,
-                                                    key );
+    char const* art = vlc_hashmap_str_get( &fetcher->album_cache, key );
     if( art )
         input_item_SetArtURL( item, art );
     vlc_mutex_unlock( &fetcher->lock );
@@ -132,11 +132,18 @@ static void AddAlbumCache( input_fetcher_t* fetcher, input_item_t* item,
     if( key && art && strncasecmp( art, "attachment://", 13 ) )
     {
         vlc_mutex_lock( &fetcher->lock );
-        if( overwrite || !vlc_dictionary_has_key( &fetcher->album_cache, key ) )
+        void **cached = vlc_hashmap_str_lookup( &fetcher->album_cache, key );
+        if( cached != NULL )
         {
-            vlc_dictionary_insert( &fetcher->album_cache, key, art );
-            art = NULL;
+            if( overwrite )
+            {
+                free( *cached );
+                *cached = art;
+                art = NULL;
+            }
         }
+        else if( !vlc_hashmap_str_insert( &fetcher->album_cache, key, art ) )
+            art = NULL;
         vlc_mutex_unlock( &fetcher->lock );
     }
 
@@ -204,8 +211,8 @@ static int SearchByScope( input_fetcher_t* fetcher,
 
     if( ! CheckArt( item )                         ||
         ! ReadAlbumCache( fetcher, item )          ||
-        ! input_FindArtInCacheUsingItemUID( item ) ||
-        ! input_FindArtInCache( item )             ||
+        ! input_FindArtInCacheUsingItemUID( fetcher->owner, item ) ||
+        ! input_FindArtInCache( fetcher->owner, item )             ||
         ! SearchArt( fetcher, item, scope ) )
     {
         AddAlbumCache( fetcher, req->item, false );
@@ -442,7 +449,7 @@ input_fetcher_t* input_fetcher_New( vlc_object_t* owner )
     }
 
     vlc_mutex_init( &fetcher->lock );
-    vlc_dictionary_init( &fetcher->album_cache, 0 );
+    vlc_hashmap_init_str( &fetcher->album_cache );
 
     return fetcher;
 }
@@ -480,6 +487,6 @@ void input_fetcher_Delete( input_fetcher_t* fetcher )
     background_worker_Delete( fetcher->network );
     background_worker_Delete( fetcher->downloader );
 
-    vlc_dictionary_clear( &fetcher->album_cache, FreeCacheEntry, NULL );
+    vlc_hashmap_clear( &fetcher->album_cache, FreeCacheEntry, NULL );
     free( fetcher );
 }
@@ -30,6 +30,7 @@
 #include "input/input_internal.h"
 #include "preparser.h"
 #include "fetcher.h"
+#include "cache.h"
 
 struct input_preparser_t
 {
@@ -37,6 +38,7 @@ struct input_preparser_t
     input_fetcher_t* fetcher;
     struct background_worker* worker;
     atomic_bool deactivated;
+    bool use_cache;
 };
 
 typedef struct input_preparser_req_t
@@ -56,6 +58,8 @@ typedef struct input_preparser_task_t
     input_item_parser_id_t *parser;
     atomic_int state;
     atomic_bool done;
+    bool cached; /* filled from the cache, without parser */
+    bool subtree; /* sub items were found, the result is not cacheable */
 } input_preparser_task_t;
 
 static input_preparser_req_t *ReqCreate(input_item_t *item,
@@ -109,6 +113,7 @@ static void OnParserSubtreeAdded(input_item_t *item, input_item_node_t *subtree,
     input_preparser_task_t* task = task_;
     input_preparser_req_t *req = task->req;
 
+    task->subtree = true;
     if (req->cbs && req->cbs->on_subtree_added)
         req->cbs->on_subtree_added(req->item, subtree, req->userdata);
 }
@@ -133,6 +138,20 @@ static int PreparserOpenInput( void* preparser_, void* req_, void** out )
     task->preparser = preparser_;
     task->req = req;
     task->preparse_status = -1;
+    task->subtree = false;
+    task->cached = preparser->use_cache
+                && input_preparser_cache_Load( preparser->owner, req->item );
+    if( task->cached )
+    {
+        /* nothing to wait for, let the worker probe the task at once */
+        task->parser = NULL;
+        atomic_store( &task->state, VLC_SUCCESS );
+        atomic_store( &task->done, true );
+        *out = task;
+        background_worker_RequestProbe( preparser->worker );
+        return VLC_SUCCESS;
+    }
+
     task->parser = input_item_Parse( req->item, preparser->owner, &cbs,
                                      task );
     if( !task->parser )
@@ -198,7 +217,12 @@ static void PreparserCloseInput( void* preparser_, void* task_ )
             break;
     }
 
-    input_item_parser_id_Release( task->parser );
+    if( task->parser != NULL )
+        input_item_parser_id_Release( task->parser );
+
+    if( status == ITEM_PREPARSE_DONE && preparser->use_cache
+     && !task->cached && !task->subtree )
+        input_preparser_cache_Store( preparser->owner, item );
 
     if( preparser->fetcher && (req->options & META_REQUEST_OPTION_FETCH_ANY) )
     {
@@ -250,6 +274,7 @@ input_preparser_t* input_preparser_New( vlc_object_t *parent )
     preparser->owner = parent;
     preparser->fetcher = input_fetcher_New( parent );
     atomic_init( &preparser->deactivated, false );
+    preparser->use_cache = var_InheritBool( parent, "preparse-cache" );
 
     if( unlikely( !preparser->fetcher ) )
         msg_Warn( parent, "unable to create art fetcher" );
@@ -290,7 +315,10 @@ void input_preparser_Push( input_preparser_t *preparser,
     struct input_preparser_req_t *req = ReqCreate(item, i_options,
                                                   cbs, cbs_userdata);
 
-    if (background_worker_Push(preparser->worker, req, id, timeout))
+    int ret = (i_options & META_REQUEST_OPTION_PRIORITY)
+            ? background_worker_PushPriority(preparser->worker, req, id, timeout)
+            : background_worker_Push(preparser->worker, req, id, timeout);
+    if (ret)
         if (req->cbs && cbs->on_preparse_ended)
             cbs->on_preparse_ended(item, ITEM_PREPARSE_FAILED, cbs_userdata);
 
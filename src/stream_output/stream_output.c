@@ -45,6 +45,7 @@
 #include <vlc_meta.h>
 #include <vlc_block.h>
 #include <vlc_codec.h>
+#include <vlc_memstats.h>
 #include <vlc_modules.h>
 
 #include "input/input_interface.h"
@@ -464,11 +465,28 @@ void sout_MuxDelete( sout_mux_t *p_mux )
     vlc_object_delete(p_mux);
 }
 
+typedef struct
+{
+    sout_input_t input;
+    vlc_mem_account_t *account; /* memory account of the FIFO, or NULL */
+} sout_mux_input_t;
+
+static void sout_MuxInputDelete( sout_input_t *p_input )
+{
+    sout_mux_input_t *priv = container_of( p_input, sout_mux_input_t, input );
+
+    block_FifoRelease( p_input->p_fifo );
+    vlc_mem_account_Delete( priv->account );
+    es_format_Clean( &p_input->fmt );
+    free( priv );
+}
+
 /*****************************************************************************
  * sout_MuxAddStream:
  *****************************************************************************/
 sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
 {
+    sout_mux_input_t *priv;
     sout_input_t *p_input;
 
     if( !p_mux->b_add_stream_any_time && !p_mux->b_waiting_stream )
@@ -481,25 +499,35 @@ sout_input_t *sout_MuxAddStream( sout_mux_t *p_mux, const es_format_t *p_fmt )
     msg_Dbg( p_mux, "adding a new input" );
 
     /* create a new sout input */
-    p_input = malloc( sizeof( sout_input_t ) );
-    if( !p_input )
+    priv = malloc( sizeof( *priv ) );
+    if( !priv )
         return NULL;
+    p_input = &priv->input;
 
     // FIXME: remove either fmt or p_fmt...
     es_format_Copy( &p_input->fmt, p_fmt );
     p_input->p_fmt = &p_input->fmt;
 
     p_input->p_fifo = block_FifoNew();
+    if( unlikely(p_input->p_fifo == NULL) )
+    {
+        es_format_Clean( &p_input->fmt );
+        free( priv );
+        return NULL;
+    }
     p_input->p_sys  = NULL;
 
+    priv->account = vlc_mem_account_New( p_mux, "mux FIFO" );
+    vlc_fifo_Lock( p_input->p_fifo );
+    vlc_fifo_SetAccount( p_input->p_fifo, priv->account );
+    vlc_fifo_Unlock( p_input->p_fifo );
+
     TAB_APPEND( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
     if( p_mux->pf_addstream( p_mux, p_input ) < 0 )
     {
         msg_Err( p_mux, "cannot add this stream" );
         TAB_REMOVE( p_mux->i_nb_inputs, p_mux->pp_inputs, p_input );
-        block_FifoRelease( p_input->p_fifo );
-        es_format_Clean( &p_input->fmt );
-        free( p_input );
+        sout_MuxInputDelete( p_input );
         return NULL;
     }
 
@@ -535,9 +563,7 @@ void sout_MuxDeleteStream( sout_mux_t *p_mux, sout_input_t *p_input )
             msg_Warn( p_mux, "no more input streams for this mux" );
         }
 
-        block_FifoRelease( p_input->p_fifo );
-        es_format_Clean( &p_input->fmt );
-        free( p_input );
+        sout_MuxInputDelete( p_input );
     }
 }
 
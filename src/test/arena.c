@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * arena.c: Test for the arena allocator
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_arena.h>
+
+static void test_alloc(vlc_arena_t *arena)
+{
+    unsigned char *ptrs[1000];
+
+    /* Allocations are aligned and do not overlap */
+    for (size_t i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size_t size = 1 + (i * 37) % 300;
+
+        ptrs[i] = vlc_arena_Alloc(arena, size);
+        assert(ptrs[i] != NULL);
+        assert(((uintptr_t)ptrs[i] % alignof (max_align_t)) == 0);
+        memset(ptrs[i], i, size);
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(ptrs); i++)
+    {
+        size_t size = 1 + (i * 37) % 300;
+
+        for (size_t j = 0; j < size; j++)
+            assert(ptrs[i][j] == (unsigned char)i);
+    }
+
+    /* Large allocation */
+    unsigned char *large = vlc_arena_Calloc(arena, 100, 1000);
+    assert(large != NULL);
+    for (size_t i = 0; i < 100 * 1000; i++)
+        assert(large[i] == 0);
+
+    /* Small allocations still fit in the current chunk */
+    unsigned char *small = vlc_arena_Alloc(arena, 16);
+    assert(small != NULL && (small < large || small >= large + 100000));
+
+    assert(vlc_arena_Calloc(arena, SIZE_MAX / 2, 4) == NULL);
+}
+
+static void test_realloc(vlc_arena_t *arena)
+{
+    /* The last allocation grows in place */
+    char *str = vlc_arena_Strdup(arena, "Hello");
+    assert(str != NULL && !strcmp(str, "Hello"));
+
+    char *grown = vlc_arena_Realloc(arena, str, 6, 12);
+    assert(grown == str);
+    strcat(grown, " world");
+
+    /* Others are copied */
+    char *other = vlc_arena_Alloc(arena, 8);
+    assert(other != NULL);
+    grown = vlc_arena_Realloc(arena, str, 12, 100);
+    assert(grown != NULL && grown != str);
+    assert(!strcmp(grown, "Hello world"));
+
+    assert(vlc_arena_Realloc(arena, grown, 100, 50) == grown);
+}
+
+int main(void)
+{
+    vlc_arena_t arena;
+
+    vlc_arena_Init(&arena, 0);
+    test_alloc(&arena);
+    test_realloc(&arena);
+    vlc_arena_Clean(&arena);
+
+    /* Reusable after cleaning, with small chunks */
+    vlc_arena_Init(&arena, 64);
+    test_alloc(&arena);
+    test_realloc(&arena);
+    vlc_arena_Clean(&arena);
+    vlc_arena_Clean(&arena);
+    return 0;
+}
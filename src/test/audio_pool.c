@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * audio_pool.c: Test for the audio decoder buffer pool
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdint.h>
+#include <string.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+
+#include "../input/audio_pool.h"
+
+const char vlc_module_name[] = "test_audio_pool";
+
+/* Not exported by the core */
+void vlc_mem_CountAllocation(void)
+{
+}
+
+static void check_buffer(block_t *block, size_t size)
+{
+    assert(block != NULL);
+    assert(block->i_buffer == size);
+    assert(((uintptr_t)block->p_buffer % 32) == 0);
+    assert(block->p_buffer >= block->p_start);
+    assert(block->p_buffer + size <= block->p_start + block->i_size);
+    assert(block->p_next == NULL);
+    assert(block->i_flags == 0);
+    assert(block->i_pts == VLC_TICK_INVALID);
+    memset(block->p_buffer, 0x55, size);
+}
+
+static void test_recycle(void)
+{
+    struct vlc_audio_pool *pool = vlc_audio_pool_New();
+    unsigned hits, misses;
+    block_t *blocks[4];
+
+    assert(pool != NULL);
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++)
+    {
+        blocks[i] = vlc_audio_pool_Get(pool, 4608);
+        check_buffer(blocks[i], 4608);
+    }
+    vlc_audio_pool_GetResetStats(pool, &hits, &misses);
+    assert(hits == 0 && misses == ARRAY_SIZE(blocks));
+
+    /* Released buffers are handed out again */
+    void *p_start = blocks[0]->p_start;
+    blocks[0]->i_flags = BLOCK_FLAG_DISCONTINUITY;
+    blocks[0]->i_pts = VLC_TICK_0;
+    block_Release(blocks[0]);
+    blocks[0] = vlc_audio_pool_Get(pool, 4608);
+    check_buffer(blocks[0], 4608);
+    assert(blocks[0]->p_start == p_start);
+
+    /* Smaller buffers too */
+    block_Release(blocks[1]);
+    blocks[1] = vlc_audio_pool_Get(pool, 1000);
+    check_buffer(blocks[1], 1000);
+    vlc_audio_pool_GetResetStats(pool, &hits, &misses);
+    assert(hits == 2 && misses == 0);
+
+    /* Larger buffers replace the recycled ones */
+    block_Release(blocks[2]);
+    blocks[2] = vlc_audio_pool_Get(pool, 9216);
+    check_buffer(blocks[2], 9216);
+    block_Release(blocks[3]); /* too small, not recycled */
+    blocks[3] = vlc_audio_pool_Get(pool, 9216);
+    check_buffer(blocks[3], 9216);
+    vlc_audio_pool_GetResetStats(pool, &hits, &misses);
+    assert(hits == 0 && misses == 2);
+
+    /* After a reset, the size follows the new format */
+    block_Release(blocks[3]);
+    vlc_audio_pool_Reset(pool);
+    blocks[3] = vlc_audio_pool_Get(pool, 512);
+    check_buffer(blocks[3], 512);
+    block_Release(blocks[3]);
+    blocks[3] = vlc_audio_pool_Get(pool, 512);
+    check_buffer(blocks[3], 512);
+    vlc_audio_pool_GetResetStats(pool, &hits, &misses);
+    assert(hits == 1 && misses == 1);
+
+    for (size_t i = 0; i < ARRAY_SIZE(blocks); i++)
+        block_Release(blocks[i]);
+    vlc_audio_pool_Release(pool);
+}
+
+static void test_outlive(void)
+{
+    struct vlc_audio_pool *pool = vlc_audio_pool_New();
+    assert(pool != NULL);
+
+    block_t *block = vlc_audio_pool_Get(pool, 2048);
+    check_buffer(block, 2048);
+
+    /* Buffers remain valid after the owner is gone */
+    vlc_audio_pool_Release(pool);
+    memset(block->p_buffer, 0xAA, block->i_buffer);
+
+    block = block_Realloc(block, 0, 4096);
+    assert(block != NULL && block->i_buffer == 4096);
+    assert(block->p_buffer[0] == 0xAA);
+    block_Release(block);
+}
+
+int main(void)
+{
+    test_recycle();
+    test_outlive();
+    return 0;
+}
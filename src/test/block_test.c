@@ -86,11 +86,178 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+static void *test_block_CacheThread(void *data)
+{
+    _Atomic(block_t *) *blocks = data;
+
+    for (unsigned i = 0; i < 10000; i++)
+    {
+        size_t size = (i * 997) % 70000;
+        block_t *b = block_Alloc(size);
+
+        assert(b != NULL);
+        assert(b->i_buffer == size);
+        assert(((uintptr_t)b->p_buffer % 32) == 0);
+        memset(b->p_buffer, i, size);
+
+        /* Release blocks allocated by the other thread, and vice versa */
+        b = atomic_exchange(blocks, b);
+        if (b != NULL)
+            block_Release(b);
+    }
+    return NULL;
+}
+
+static void test_block_Cache(void)
+{
+    _Atomic(block_t *) block = NULL;
+    vlc_thread_t th[2];
+
+    for (size_t i = 0; i < ARRAY_SIZE(th); i++)
+        assert(vlc_clone(&th[i], test_block_CacheThread, &block,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (size_t i = 0; i < ARRAY_SIZE(th); i++)
+        vlc_join(th[i], NULL);
+    if (block != NULL)
+        block_Release(block);
+
+    /* Recycled blocks are as good as new */
+    block_t *b = block_Alloc(188);
+    assert(b != NULL);
+    b->i_flags = BLOCK_FLAG_DISCONTINUITY;
+    b->i_pts = VLC_TICK_0;
+    block_Release(b);
+    b = block_Alloc(188);
+    assert(b != NULL);
+    assert(b->i_buffer == 188 && b->i_flags == 0);
+    assert(b->i_pts == VLC_TICK_INVALID && b->p_next == NULL);
+    block_Release(b);
+}
+
+static void test_block_Share(void)
+{
+    block_t *block = block_Alloc(sizeof (text));
+    assert(block != NULL);
+    memcpy(block->p_buffer, text, sizeof (text));
+    block->i_pts = VLC_TICK_0;
+    assert(!block_IsShared(block));
+
+    block_t *ref = block_Share(block);
+    assert(ref != NULL);
+    assert(ref->p_buffer == block->p_buffer);
+    assert(ref->i_buffer == sizeof (text) && ref->i_pts == VLC_TICK_0);
+    assert(block_IsShared(block) && block_IsShared(ref));
+
+    block_t *ref2 = block_Share(ref);
+    assert(ref2 != NULL && ref2->p_buffer == block->p_buffer);
+
+    /* Growing a shared payload must not touch the other references */
+    ref2 = block_Realloc(ref2, 16, sizeof (text) + 16);
+    assert(ref2 != NULL && ref2->p_buffer + 16 != block->p_buffer);
+    assert(!block_IsShared(ref2));
+    assert(!memcmp(ref2->p_buffer + 16, text, sizeof (text)));
+    block_Release(ref2);
+
+    /* Shrinking only changes boundaries */
+    ref->p_buffer += 5;
+    ref->i_buffer -= 5;
+    ref = block_Realloc(ref, 0, 4);
+    assert(ref != NULL && ref->p_buffer == block->p_buffer + 5);
+
+    /* The payload survives its owner */
+    block_Release(block);
+    assert(!block_IsShared(ref));
+    assert(!memcmp(ref->p_buffer, text + 5, 4));
+
+    block = block_Share(ref);
+    assert(block != NULL);
+    block = block_Unshare(block);
+    assert(block != NULL && block->p_buffer != ref->p_buffer);
+    assert(!memcmp(block->p_buffer, text + 5, 4));
+    block_Release(block);
+    block_Release(ref);
+}
+
+#define SPSC_COUNT 10000
+
+static void *test_block_SpscProducer(void *data)
+{
+    vlc_spsc_fifo_t *fifo = data;
+
+    for (unsigned i = 0; i < SPSC_COUNT; )
+    {
+        /* Mix single blocks and chains, crossing the chunk boundaries */
+        block_t *chain = NULL, **pp = &chain;
+        unsigned n = 1 + (i % 3);
+
+        for (unsigned j = 0; j < n && i < SPSC_COUNT; j++, i++)
+        {
+            block_t *b = block_Alloc(sizeof (i));
+            assert(b != NULL);
+            memcpy(b->p_buffer, &i, sizeof (i));
+            *pp = b;
+            pp = &b->p_next;
+        }
+        vlc_spsc_fifo_Queue(fifo, chain);
+    }
+    vlc_spsc_fifo_Kill(fifo);
+    return NULL;
+}
+
+static void test_block_Spsc(void)
+{
+    vlc_spsc_fifo_t *fifo = vlc_spsc_fifo_New();
+    assert(fifo != NULL);
+    assert(vlc_spsc_fifo_Dequeue(fifo) == NULL);
+
+    /* Single thread */
+    for (unsigned i = 0; i < 200; i++)
+        vlc_spsc_fifo_Queue(fifo, block_Alloc(i));
+    assert(vlc_spsc_fifo_GetCount(fifo) == 200);
+    assert(vlc_spsc_fifo_GetBytes(fifo) == 199 * 200 / 2);
+    for (unsigned i = 0; i < 150; i++)
+    {
+        block_t *b = vlc_spsc_fifo_Dequeue(fifo);
+        assert(b != NULL && b->i_buffer == i && b->p_next == NULL);
+        block_Release(b);
+    }
+    assert(vlc_spsc_fifo_GetCount(fifo) == 50);
+    vlc_spsc_fifo_Delete(fifo); /* releases the rest */
+
+    /* Producer and consumer threads */
+    vlc_thread_t th;
+
+    fifo = vlc_spsc_fifo_New();
+    assert(fifo != NULL);
+    assert(vlc_clone(&th, test_block_SpscProducer, fifo,
+                     VLC_THREAD_PRIORITY_LOW) == 0);
+
+    unsigned expected = 0;
+    block_t *b;
+
+    while ((b = vlc_spsc_fifo_DequeueKillable(fifo)) != NULL)
+    {
+        unsigned i;
+
+        memcpy(&i, b->p_buffer, sizeof (i));
+        assert(i == expected);
+        expected++;
+        block_Release(b);
+    }
+    assert(expected == SPSC_COUNT);
+    vlc_join(th, NULL);
+    assert(vlc_spsc_fifo_GetCount(fifo) == 0);
+    vlc_spsc_fifo_Delete(fifo);
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Cache ();
+    test_block_Share ();
+    test_block_Spsc ();
     return 0;
 }
 
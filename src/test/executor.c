@@ -0,0 +1,189 @@
+/*****************************************************************************
+ * executor.c: Test for the executor API
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_executor.h>
+
+#define COUNT 1000
+
+static void Count(void *opaque, size_t index)
+{
+    atomic_uchar *hits = opaque;
+
+    atomic_fetch_add(&hits[index], 1);
+}
+
+static void test_parallel_for(vlc_executor_t *executor)
+{
+    static atomic_uchar hits[COUNT];
+
+    for (size_t i = 0; i < COUNT; i++)
+        atomic_init(&hits[i], 0);
+
+    vlc_executor_ParallelFor(executor, COUNT, Count, hits);
+    for (size_t i = 0; i < COUNT; i++)
+        assert(atomic_load(&hits[i]) == 1);
+
+    /* Degenerate counts */
+    vlc_executor_ParallelFor(executor, 0, Count, hits);
+    vlc_executor_ParallelFor(executor, 1, Count, hits);
+    assert(atomic_load(&hits[0]) == 2);
+}
+
+struct nested
+{
+    vlc_executor_t *executor;
+    atomic_uint total;
+};
+
+static void NestedInner(void *opaque, size_t index)
+{
+    struct nested *n = opaque;
+
+    atomic_fetch_add(&n->total, index);
+}
+
+static void NestedOuter(void *opaque, size_t index)
+{
+    struct nested *n = opaque;
+
+    (void) index;
+    vlc_executor_ParallelFor(n->executor, 10, NestedInner, n);
+}
+
+static void test_nested(vlc_executor_t *executor)
+{
+    struct nested n = { .executor = executor };
+
+    atomic_init(&n.total, 0);
+    vlc_executor_ParallelFor(executor, 20, NestedOuter, &n);
+    assert(atomic_load(&n.total) == 20 * 45);
+}
+
+struct blocker
+{
+    vlc_sem_t started;
+    vlc_sem_t release;
+};
+
+static void Block(void *opaque)
+{
+    struct blocker *b = opaque;
+
+    vlc_sem_post(&b->started);
+    vlc_sem_wait(&b->release);
+}
+
+static void Increment(void *opaque)
+{
+    atomic_uint *counter = opaque;
+
+    atomic_fetch_add(counter, 1);
+}
+
+static void test_cancel(void)
+{
+    /* A single worker, kept busy so that the other tasks remain queued */
+    vlc_executor_t *executor = vlc_executor_New(1);
+    assert(executor != NULL);
+
+    struct blocker b;
+    vlc_sem_init(&b.started, 0);
+    vlc_sem_init(&b.release, 0);
+
+    struct vlc_runnable blocker = { .run = Block, .userdata = &b };
+    assert(vlc_executor_Submit(executor, &blocker) == VLC_SUCCESS);
+    vlc_sem_wait(&b.started);
+
+    atomic_uint counter;
+    atomic_init(&counter, 0);
+
+    struct vlc_runnable single = { .run = Increment, .userdata = &counter };
+    assert(vlc_executor_Submit(executor, &single) == VLC_SUCCESS);
+    assert(vlc_executor_Cancel(executor, &single));
+    assert(!vlc_executor_Cancel(executor, &single));
+
+    vlc_task_group_t *group = vlc_task_group_New(executor);
+    assert(group != NULL);
+
+    struct vlc_runnable tasks[10];
+    for (size_t i = 0; i < ARRAY_SIZE(tasks); i++)
+    {
+        tasks[i].run = Increment;
+        tasks[i].userdata = &counter;
+        assert(vlc_task_group_Submit(group, &tasks[i]) == VLC_SUCCESS);
+    }
+
+    assert(!vlc_task_group_IsCancelled(group));
+    vlc_task_group_Cancel(group);
+    assert(vlc_task_group_IsCancelled(group));
+    assert(vlc_task_group_Submit(group, &tasks[0]) != VLC_SUCCESS);
+    vlc_task_group_Wait(group);
+    vlc_task_group_Delete(group);
+
+    vlc_sem_post(&b.release);
+    vlc_executor_Delete(executor);
+    assert(atomic_load(&counter) == 0);
+}
+
+static void test_wait(vlc_executor_t *executor)
+{
+    vlc_task_group_t *group = vlc_task_group_New(executor);
+    assert(group != NULL);
+
+    atomic_uint counter;
+    atomic_init(&counter, 0);
+
+    struct vlc_runnable tasks[100];
+    for (size_t i = 0; i < ARRAY_SIZE(tasks); i++)
+    {
+        tasks[i].run = Increment;
+        tasks[i].userdata = &counter;
+        assert(vlc_task_group_Submit(group, &tasks[i]) == VLC_SUCCESS);
+    }
+
+    vlc_task_group_Wait(group);
+    assert(atomic_load(&counter) == ARRAY_SIZE(tasks));
+    vlc_task_group_Delete(group);
+}
+
+int main(void)
+{
+    vlc_executor_t *executor = vlc_executor_New(4);
+    assert(executor != NULL);
+
+    test_parallel_for(executor);
+    test_nested(executor);
+    test_wait(executor);
+    vlc_executor_Delete(executor);
+
+    test_cancel();
+    return 0;
+}
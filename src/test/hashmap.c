@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * hashmap.c: Test for the hash maps
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_hashmap.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void FreeValue(void *value, void *opaque)
+{
+    unsigned *freed = opaque;
+
+    (*freed)++;
+    free(value);
+}
+
+static void test_str(void)
+{
+    static const char *keys[] = {
+        "Hello", "Hella", "flowmeter", "Frostnipped", "frostnipped",
+        "remiform", "quadrifoliolate", "singularity", "unafflicted", "",
+    };
+    const size_t size = ARRAY_SIZE(keys);
+    vlc_hashmap_t map;
+
+    vlc_hashmap_init_str(&map);
+    assert(vlc_hashmap_count(&map) == 0);
+    assert(vlc_hashmap_str_get(&map, "Hello") == NULL);
+    assert(vlc_hashmap_str_remove(&map, "Hello") == NULL);
+
+    for (uintptr_t i = 0; i < size; i++)
+    {
+        assert(vlc_hashmap_str_insert(&map, keys[i], (void *)(i + 1)) == 0);
+        for (uintptr_t j = 0; j <= i; j++)
+            assert(vlc_hashmap_str_get(&map, keys[j]) == (void *)(j + 1));
+        for (size_t j = i + 1; j < size; j++)
+            assert(vlc_hashmap_str_lookup(&map, keys[j]) == NULL);
+    }
+    assert(vlc_hashmap_count(&map) == size);
+
+    /* Replacement */
+    assert(vlc_hashmap_str_insert(&map, "Hello", (void *)42) == 0);
+    assert(vlc_hashmap_count(&map) == size);
+    assert(vlc_hashmap_str_get(&map, "Hello") == (void *)42);
+    *vlc_hashmap_str_lookup(&map, "Hello") = (void *)1;
+
+    /* NULL values are distinguished from missing keys */
+    assert(vlc_hashmap_str_insert(&map, "null", NULL) == 0);
+    assert(vlc_hashmap_str_lookup(&map, "null") != NULL);
+    assert(vlc_hashmap_str_remove(&map, "null") == NULL);
+    assert(vlc_hashmap_str_lookup(&map, "null") == NULL);
+
+    struct vlc_hashmap_slot *slot;
+    size_t count = 0;
+    vlc_hashmap_foreach(slot, &map)
+    {
+        uintptr_t i = (uintptr_t)slot->value - 1;
+
+        assert(i < size);
+        assert(strcmp(slot->key.str, keys[i]) == 0);
+        count++;
+    }
+    assert(count == size);
+
+    for (uintptr_t i = 0; i < size; i += 2)
+        assert(vlc_hashmap_str_remove(&map, keys[i]) == (void *)(i + 1));
+    for (uintptr_t i = 0; i < size; i++)
+        assert(vlc_hashmap_str_get(&map, keys[i])
+               == ((i & 1) ? (void *)(i + 1) : NULL));
+
+    vlc_hashmap_clear(&map, NULL, NULL);
+    assert(vlc_hashmap_count(&map) == 0);
+    assert(vlc_hashmap_str_get(&map, keys[1]) == NULL);
+
+    /* Values released on clear */
+    unsigned freed = 0;
+    for (size_t i = 0; i < size; i++)
+        assert(vlc_hashmap_str_insert(&map, keys[i], strdup(keys[i])) == 0);
+    vlc_hashmap_clear(&map, FreeValue, &freed);
+    assert(freed == size);
+}
+
+static void test_int(void)
+{
+    const uint64_t count = 10000;
+    vlc_hashmap_t map;
+
+    vlc_hashmap_init_int(&map);
+
+    for (uint64_t i = 0; i < count; i++)
+        assert(vlc_hashmap_int_insert(&map, i * 4096, (void *)(uintptr_t)i)
+               == 0);
+    assert(vlc_hashmap_count(&map) == count);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        void **value = vlc_hashmap_int_lookup(&map, i * 4096);
+        assert(value != NULL && *value == (void *)(uintptr_t)i);
+        assert(vlc_hashmap_int_lookup(&map, i * 4096 + 1) == NULL);
+    }
+
+    /* Remove every third key: the probe chains must survive the shifts */
+    for (uint64_t i = 0; i < count; i += 3)
+        assert(vlc_hashmap_int_remove(&map, i * 4096)
+               == (void *)(uintptr_t)i);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        void **value = vlc_hashmap_int_lookup(&map, i * 4096);
+        if (i % 3 == 0)
+            assert(value == NULL);
+        else
+            assert(value != NULL && *value == (void *)(uintptr_t)i);
+    }
+    assert(vlc_hashmap_count(&map) == count - (count + 2) / 3);
+
+    vlc_hashmap_clear(&map, NULL, NULL);
+    assert(vlc_hashmap_count(&map) == 0);
+}
+
+int main(void)
+{
+    test_str();
+    test_int();
+    return 0;
+}
@@ -108,6 +108,30 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void test_large(void)
+{
+    const unsigned count = 200;
+    picture_t *pics[count];
+
+    pool = picture_pool_NewFromFormat(&fmt, count);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == count);
+
+    for (unsigned i = 0; i < count; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_Release(pics[count - 1]);
+    pics[count - 1] = picture_pool_Wait(pool);
+    assert(pics[count - 1] != NULL);
+
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -124,6 +148,7 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
 
     return 0;
 }
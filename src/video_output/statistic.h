@@ -24,18 +24,40 @@
 # define LIBVLC_VOUT_STATISTIC_H
 # include <stdatomic.h>
 
+/* Timings of the steps of the vout thread */
+enum vout_timing {
+    VOUT_TIMING_PREPARE,  /* static filters (deinterlacing, conversion...) */
+    VOUT_TIMING_FILTER,   /* interactive filters */
+    VOUT_TIMING_RENDER,   /* filters, subpictures and display prepare */
+    VOUT_TIMING_DISPLAY,  /* display */
+    VOUT_TIMING_LATENESS, /* display date past the picture date */
+    VOUT_TIMING_COUNT,
+};
+
+/* Histogram buckets, on a logarithmic scale: the first one holds durations
+ * below 256us, each following one is twice as wide as the previous one, and
+ * the last one holds everything above */
+#define VOUT_TIMING_BUCKETS 14
+#define VOUT_TIMING_FIRST_SHIFT 8
+
 /* NOTE: Both statistics are atomic on their own, so one might be older than
  * the other one. Currently, only one of them is updated at a time, so this
  * is a non-issue. */
 typedef struct {
     atomic_uint displayed;
     atomic_uint lost;
+    atomic_uint early_dropped;
+    atomic_uint timing[VOUT_TIMING_COUNT][VOUT_TIMING_BUCKETS];
 } vout_statistic_t;
 
 static inline void vout_statistic_Init(vout_statistic_t *stat)
 {
     atomic_init(&stat->displayed, 0);
     atomic_init(&stat->lost, 0);
+    atomic_init(&stat->early_dropped, 0);
+    for (unsigned i = 0; i < VOUT_TIMING_COUNT; i++)
+        for (unsigned j = 0; j < VOUT_TIMING_BUCKETS; j++)
+            atomic_init(&stat->timing[i][j], 0);
 }
 
 static inline void vout_statistic_Clean(vout_statistic_t *stat)
@@ -64,4 +86,49 @@ static inline void vout_statistic_AddLost(vout_statistic_t *stat, int lost)
     atomic_fetch_add_explicit(&stat->lost, lost, memory_order_relaxed);
 }
 
+/* Pictures dropped before filtering, because they would have been late */
+static inline void vout_statistic_AddEarlyDropped(vout_statistic_t *stat,
+                                                  int dropped)
+{
+    atomic_fetch_add_explicit(&stat->early_dropped, dropped,
+                              memory_order_relaxed);
+    vout_statistic_AddLost(stat, dropped);
+}
+
+static inline void vout_statistic_AddTiming(vout_statistic_t *stat,
+                                            enum vout_timing timing,
+                                            vlc_tick_t duration)
+{
+    unsigned bucket = 0;
+    int64_t us = US_FROM_VLC_TICK(duration) >> VOUT_TIMING_FIRST_SHIFT;
+
+    while (us > 0 && bucket < VOUT_TIMING_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&stat->timing[timing][bucket], 1,
+                              memory_order_relaxed);
+}
+
+static inline unsigned vout_statistic_GetResetTiming(vout_statistic_t *stat,
+                                                     enum vout_timing timing,
+                                                     unsigned *restrict hist)
+{
+    unsigned total = 0;
+    for (unsigned i = 0; i < VOUT_TIMING_BUCKETS; i++)
+    {
+        hist[i] = atomic_exchange_explicit(&stat->timing[timing][i], 0,
+                                           memory_order_relaxed);
+        total += hist[i];
+    }
+    return total;
+}
+
+static inline unsigned vout_statistic_GetResetEarlyDropped(vout_statistic_t *stat)
+{
+    return atomic_exchange_explicit(&stat->early_dropped, 0,
+                                    memory_order_relaxed);
+}
+
 #endif
@@ -48,6 +48,9 @@
 #include <vlc_image.h>
 #include <vlc_plugin.h>
 #include <vlc_codec.h>
+#include <vlc_memstream.h>
+#include <vlc_tracer.h>
+#include <vlc_memstats.h>
 
 #include <libvlc.h>
 #include "vout_internal.h"
@@ -873,6 +876,56 @@ static void ThreadChangeFilters(vout_thread_t *vout,
         vlc_mutex_unlock(&vout->p->filter.lock);
 }
 
+static const char vout_timing_names[VOUT_TIMING_COUNT][9] = {
+    [VOUT_TIMING_PREPARE] = "prepare",
+    [VOUT_TIMING_FILTER] = "filter",
+    [VOUT_TIMING_RENDER] = "render",
+    [VOUT_TIMING_DISPLAY] = "display",
+    [VOUT_TIMING_LATENESS] = "lateness",
+};
+
+/* Accounts a pipeline step that ended now, or the lateness of a picture */
+static void ThreadAddTiming(vout_thread_t *vout, enum vout_timing timing,
+                            vlc_tick_t duration)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vout_statistic_AddTiming(&sys->statistic, timing, duration);
+
+    if (sys->tracer == NULL)
+        return;
+    if (timing == VOUT_TIMING_LATENESS)
+        vlc_tracer_Counter(sys->tracer, "vout", vout_timing_names[timing],
+                           vout, US_FROM_VLC_TICK(duration));
+    else
+        vlc_tracer_End(sys->tracer, "vout", vout_timing_names[timing], vout,
+                       vlc_tick_now() - duration);
+}
+
+/* Returns whether a picture, currently late by the given amount (negative if
+ * early), is bound to miss its date given the measured costs of the static
+ * filters and of the rendering, while the next decoded picture is not: in
+ * that case, it is better to skip it before spending any time on it. */
+static bool ThreadPredictLate(vout_thread_t *vout, vlc_tick_t now,
+                              vlc_tick_t late)
+{
+    vout_thread_sys_t *sys = vout->p;
+    const vlc_tick_t cost = vout_chrono_GetHigh(&sys->prepare) +
+                            vout_chrono_GetHigh(&sys->render);
+
+    if (late + cost <= 0)
+        return false;
+
+    picture_t *next = picture_fifo_Peek(sys->decoder_fifo);
+    if (next == NULL)
+        return false;
+
+    const vlc_tick_t next_system_pts =
+        vlc_clock_ConvertToSystem(sys->clock, now, next->date, sys->rate);
+    picture_Release(next);
+
+    return next_system_pts != INT64_MAX && next_system_pts - now >= cost;
+}
 
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
@@ -922,6 +975,11 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
                         picture_Release(decoded);
                         vout_statistic_AddLost(&vout->p->statistic, 1);
                         continue;
+                    } else if (!*paused && ThreadPredictLate(vout, date, late)) {
+                        msg_Dbg(vout, "picture would be displayed late, skipping it (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
+                        picture_Release(decoded);
+                        vout_statistic_AddEarlyDropped(&vout->p->statistic, 1);
+                        continue;
                     } else if (late > 0) {
                         msg_Dbg(vout, "picture might be displayed late (missing %"PRId64" ms)", MS_FROM_VLC_TICK(late));
                     }
@@ -953,7 +1011,10 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse,
         vout->p->displayed.timestamp     = decoded->date;
         vout->p->displayed.is_interlaced = !decoded->b_progressive;
 
+        vout_chrono_Start(&sys->prepare);
         picture = filter_chain_VideoFilter(vout->p->filter.chain_static, decoded);
+        ThreadAddTiming(vout, VOUT_TIMING_PREPARE,
+                        vout_chrono_Stop(&sys->prepare));
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
@@ -1040,9 +1101,12 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
 
     vout_chrono_Start(&sys->render);
 
+    const vlc_tick_t filter_start = vlc_tick_now();
     vlc_mutex_lock(&sys->filter.lock);
     picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_interactive, torender);
     vlc_mutex_unlock(&sys->filter.lock);
+    ThreadAddTiming(vout, VOUT_TIMING_FILTER,
+                    vlc_tick_now() - filter_start);
 
     if (!filtered)
         return VLC_EGENERIC;
@@ -1222,7 +1286,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     if (vd->prepare != NULL)
         vd->prepare(vd, todisplay, do_dr_spu ? subpic : NULL, system_pts);
 
-    vout_chrono_Stop(&sys->render);
+    ThreadAddTiming(vout, VOUT_TIMING_RENDER,
+                    vout_chrono_Stop(&sys->render));
 #if 0
         {
         static int i = 0;
@@ -1235,6 +1300,8 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
     system_now = vlc_tick_now();
     if (!is_forced)
     {
+        ThreadAddTiming(vout, VOUT_TIMING_LATENESS,
+                        __MAX(system_now - system_pts, 0));
         if (unlikely(system_now > system_pts))
         {
             /* vd->prepare took too much time. Tell the clock that the pts was
@@ -1262,7 +1329,10 @@ static int ThreadDisplayRenderPicture(vout_thread_t *vout, bool is_forced)
                           frame_rate, frame_rate_base);
 
     /* Display the direct buffer returned by vout_RenderPicture */
+    const vlc_tick_t display_start = vlc_tick_now();
     vout_display_Display(vd, todisplay);
+    ThreadAddTiming(vout, VOUT_TIMING_DISPLAY,
+                    vlc_tick_now() - display_start);
     vlc_mutex_unlock(&sys->display_lock);
 
     if (subpic)
@@ -1680,6 +1750,8 @@ static void *Thread(void *object)
     vlc_tick_t deadline = VLC_TICK_INVALID;
     bool wait = false;
 
+    vlc_mem_SetStage(VLC_MEM_STAGE_VOUT);
+
     for (;;) {
         vout_control_cmd_t cmd;
 
@@ -1764,6 +1836,41 @@ static void vout_ReleaseDisplay(vout_thread_t *vout)
     video_format_Clean(&sys->original);
 }
 
+static void vout_DumpTimingStatistic(vout_thread_t *vout)
+{
+    vout_statistic_t *stat = &vout->p->statistic;
+
+    for (unsigned i = 0; i < VOUT_TIMING_COUNT; i++)
+    {
+        unsigned hist[VOUT_TIMING_BUCKETS];
+        if (vout_statistic_GetResetTiming(stat, i, hist) == 0)
+            continue;
+
+        struct vlc_memstream ms;
+        if (vlc_memstream_open(&ms))
+            return;
+        for (unsigned j = 0; j < VOUT_TIMING_BUCKETS; j++)
+        {
+            if (hist[j] == 0)
+                continue;
+            const double bound = (1 << (VOUT_TIMING_FIRST_SHIFT + j)) / 1000.;
+            if (j < VOUT_TIMING_BUCKETS - 1)
+                vlc_memstream_printf(&ms, " <%.2fms:%u", bound, hist[j]);
+            else
+                vlc_memstream_printf(&ms, " >=%.2fms:%u", bound / 2, hist[j]);
+        }
+        if (vlc_memstream_close(&ms) == 0)
+        {
+            msg_Dbg(vout, "%s timings:%s", vout_timing_names[i], ms.ptr);
+            free(ms.ptr);
+        }
+    }
+
+    unsigned dropped = vout_statistic_GetResetEarlyDropped(stat);
+    if (dropped > 0)
+        msg_Dbg(vout, "%u pictures skipped before filtering", dropped);
+}
+
 void vout_StopDisplay(vout_thread_t *vout)
 {
     vout_thread_sys_t *sys = vout->p;
@@ -1771,6 +1878,7 @@ void vout_StopDisplay(vout_thread_t *vout)
     vout_control_PushVoid(&sys->control, VOUT_CONTROL_TERMINATE);
     vlc_join(sys->thread, NULL);
 
+    vout_DumpTimingStatistic(vout);
     vout_ReleaseDisplay(vout);
 }
 
@@ -1810,6 +1918,7 @@ void vout_Close(vout_thread_t *vout)
     vout_snapshot_End(sys->snapshot);
     vout_control_Dead(&sys->control);
     vout_chrono_Clean(&sys->render);
+    vout_chrono_Clean(&sys->prepare);
 
     if (sys->spu)
         spu_Destroy(sys->spu);
@@ -1947,6 +2056,8 @@ vout_thread_t *vout_Create(vlc_object_t *object)
 
     /* Arbitrary initial time */
     vout_chrono_Init(&sys->render, 5, VLC_TICK_FROM_MS(10));
+    vout_chrono_Init(&sys->prepare, 5, VLC_TICK_FROM_MS(1));
+    sys->tracer = vlc_object_get_tracer(vout);
 
     if (var_InheritBool(vout, "video-wallpaper"))
         vout_window_SetState(sys->display_cfg.window, VOUT_WINDOW_STATE_BELOW);
@@ -184,6 +184,8 @@ struct vout_thread_sys_t
     picture_pool_t  *display_pool;
     picture_fifo_t  *decoder_fifo;
     vout_chrono_t   render;           /**< picture render time estimator */
+    vout_chrono_t   prepare;          /**< static filters time estimator */
+    struct vlc_tracer *tracer;        /**< tracer, or NULL */
 
     vlc_atomic_rc_t rc;
 };
@@ -103,6 +103,7 @@ struct spu_private_t {
     int secondary_margin;
     int secondary_alignment;       /**< Force alignment for secondary subs */
     video_palette_t palette;              /**< force palette of subpicture */
+    unsigned layout_generation;  /**< bumped when the settings above change */
 
     /* Subpiture filters */
     char           *source_chain_current;
@@ -776,6 +777,16 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
 /**
  * It will transform the provided region into another region suitable for rendering.
  */
+/**
+ * Returns the render cache of a region, creating it on first use.
+ */
+static subpicture_region_private_t *SpuRegionGetPrivate(subpicture_region_t *region)
+{
+    if (!region->p_private)
+        region->p_private = subpicture_region_private_New(&region->fmt);
+    return region->p_private;
+}
+
 static void SpuRenderRegion(spu_t *spu,
                             subpicture_region_t **dst_ptr, spu_area_t *dst_area,
                             const spu_render_entry_t *entry, subpicture_region_t *region,
@@ -812,6 +823,41 @@ static void SpuRenderRegion(spu_t *spu,
 
     video_format_AdjustColorSpace(&region->fmt);
 
+    /* The placement of a region is reused from the previous frames unless
+     * something it depends on has changed. Subtitles that are not absolute
+     * yet depend on the other regions (overlap) and are always placed. */
+    subpicture_region_private_t *private = SpuRegionGetPrivate(region);
+    subpicture_region_place_key_t place_key;
+    const bool cacheable = private != NULL &&
+                           !(subpic->b_subtitle && !subpic->b_absolute);
+    bool placed = false;
+
+    if (cacheable) {
+        memset(&place_key, 0, sizeof(place_key));
+        place_key.generation = sys->layout_generation;
+        place_key.dst_width  = fmt->i_visible_width;
+        place_key.dst_height = fmt->i_visible_height;
+        place_key.scale_w    = scale_size.w;
+        place_key.scale_h    = scale_size.h;
+        place_key.x          = region->i_x;
+        place_key.y          = region->i_y;
+        place_key.align      = region->i_align;
+        place_key.order      = entry->channel_order;
+        place_key.width      = region->fmt.i_visible_width;
+        place_key.height     = region->fmt.i_visible_height;
+        place_key.max_width  = region->i_max_width;
+        place_key.max_height = region->i_max_height;
+        place_key.orig_width  = subpic->i_original_picture_width;
+        place_key.orig_height = subpic->i_original_picture_height;
+        place_key.absolute   = subpic->b_absolute;
+
+        if (private->place.valid &&
+            !memcmp(&private->place.key, &place_key, sizeof(place_key)))
+            placed = true;
+        else
+            private->place.valid = private->place.crop_valid = false;
+    }
+
     /* Force palette if requested
      * FIXME b_force_palette and force_crop are applied to all subpictures using palette
      * instead of only the right one (being the dvd spu).
@@ -822,72 +868,93 @@ static void SpuRenderRegion(spu_t *spu,
                                 region->i_max_width || region->i_max_height;
     bool changed_palette     = false;
 
-    /* Compute the margin which is expressed in destination pixel unit
-     * The margin is applied only to subtitle and when no forced crop is
-     * requested (dvd menu).
-     * Note: Margin will also be applied to secondary subtitles if they exist
-     * to ensure that overlap does not occur. */
-    int y_margin = 0;
-    if (!crop_requested && subpic->b_subtitle)
-        y_margin = spu_invscale_h(sys->margin, scale_size);
-
-    /* Place the picture
-     * We compute the position in the rendered size */
-
-    int i_align = region->i_align;
-    if (entry->channel_order == VLC_VOUT_ORDER_SECONDARY)
-        i_align = sys->secondary_alignment >= 0 ? sys->secondary_alignment : i_align;
-
-    SpuRegionPlace(&x_offset, &y_offset,
-                   subpic, region, i_align);
-
-    if (entry->channel_order == VLC_VOUT_ORDER_SECONDARY)
-    {
-        int secondary_margin =
-            spu_invscale_h(sys->secondary_margin, scale_size);
-        if (!subpic->b_absolute)
-        {
-            /* Move the secondary subtitles by the secondary margin before
-             * overlap detection. This way, overlaps will be resolved if they
-             * still exist.  */
-            y_offset -= secondary_margin;
-        }
-        else
+    if (placed) {
+        *dst_area = spu_area_create(private->place.area_x,
+                                    private->place.area_y,
+                                    private->place.area_width,
+                                    private->place.area_height,
+                                    scale_size);
+        x_offset = private->place.x_offset;
+        y_offset = private->place.y_offset;
+    } else {
+        /* Compute the margin which is expressed in destination pixel unit
+         * The margin is applied only to subtitle and when no forced crop is
+         * requested (dvd menu).
+         * Note: Margin will also be applied to secondary subtitles if they exist
+         * to ensure that overlap does not occur. */
+        int y_margin = 0;
+        if (!crop_requested && subpic->b_subtitle)
+            y_margin = spu_invscale_h(sys->margin, scale_size);
+
+        /* Place the picture
+         * We compute the position in the rendered size */
+
+        int i_align = region->i_align;
+        if (entry->channel_order == VLC_VOUT_ORDER_SECONDARY)
+            i_align = sys->secondary_alignment >= 0 ? sys->secondary_alignment : i_align;
+
+        SpuRegionPlace(&x_offset, &y_offset,
+                       subpic, region, i_align);
+
+        if (entry->channel_order == VLC_VOUT_ORDER_SECONDARY)
         {
-            /* Use an absolute margin for secondary subpictures that have
-             * already been placed but have been moved by the user */
-            y_margin += secondary_margin;
+            int secondary_margin =
+                spu_invscale_h(sys->secondary_margin, scale_size);
+            if (!subpic->b_absolute)
+            {
+                /* Move the secondary subtitles by the secondary margin before
+                 * overlap detection. This way, overlaps will be resolved if they
+                 * still exist.  */
+                y_offset -= secondary_margin;
+            }
+            else
+            {
+                /* Use an absolute margin for secondary subpictures that have
+                 * already been placed but have been moved by the user */
+                y_margin += secondary_margin;
+            }
         }
-    }
-
-    /* Save this position for subtitle overlap support
-     * it is really important that there are given without scale_size applied */
-    *dst_area = spu_area_create(x_offset, y_offset,
-                                region->fmt.i_visible_width,
-                                region->fmt.i_visible_height,
-                                scale_size);
-
-    /* Handle overlapping subtitles when possible */
-    if (subpic->b_subtitle && !subpic->b_absolute)
-        SpuAreaFixOverlap(dst_area, subtitle_area, subtitle_area_count,
-                          i_align);
 
-    /* we copy the area: for the subtitle overlap support we want
-     * to only save the area without margin applied */
-    spu_area_t restrained = *dst_area;
+        /* Save this position for subtitle overlap support
+         * it is really important that there are given without scale_size applied */
+        *dst_area = spu_area_create(x_offset, y_offset,
+                                    region->fmt.i_visible_width,
+                                    region->fmt.i_visible_height,
+                                    scale_size);
 
-    /* apply margin to subtitles and correct if they go over the picture edge */
-    if (subpic->b_subtitle)
-        restrained.y -= y_margin;
+        /* Handle overlapping subtitles when possible */
+        if (subpic->b_subtitle && !subpic->b_absolute)
+            SpuAreaFixOverlap(dst_area, subtitle_area, subtitle_area_count,
+                              i_align);
 
-    spu_area_t display = spu_area_create(0, 0, fmt->i_visible_width,
-                                         fmt->i_visible_height,
-                                         spu_scale_unit());
-    SpuAreaFitInside(&restrained, &display);
+        /* we copy the area: for the subtitle overlap support we want
+         * to only save the area without margin applied */
+        spu_area_t restrained = *dst_area;
 
-    /* Fix the position for the current scale_size */
-    x_offset = spu_scale_w(restrained.x, restrained.scale);
-    y_offset = spu_scale_h(restrained.y, restrained.scale);
+        /* apply margin to subtitles and correct if they go over the picture edge */
+        if (subpic->b_subtitle)
+            restrained.y -= y_margin;
+
+        spu_area_t display = spu_area_create(0, 0, fmt->i_visible_width,
+                                             fmt->i_visible_height,
+                                             spu_scale_unit());
+        SpuAreaFitInside(&restrained, &display);
+
+        /* Fix the position for the current scale_size */
+        x_offset = spu_scale_w(restrained.x, restrained.scale);
+        y_offset = spu_scale_h(restrained.y, restrained.scale);
+
+        if (cacheable) {
+            private->place.key         = place_key;
+            private->place.area_x      = dst_area->x;
+            private->place.area_y      = dst_area->y;
+            private->place.area_width  = dst_area->width;
+            private->place.area_height = dst_area->height;
+            private->place.x_offset    = x_offset;
+            private->place.y_offset    = y_offset;
+            private->place.valid       = true;
+        }
+    }
 
     /* */
     if (force_palette) {
@@ -952,10 +1019,13 @@ static void SpuRenderRegion(spu_t *spu,
         const unsigned dst_height = spu_scale_h(region->fmt.i_visible_height, scale_size);
 
         /* Destroy the cache if unusable */
-        if (region->p_private) {
-            subpicture_region_private_t *private = region->p_private;
+        if (private && private->p_picture) {
             bool is_changed = false;
 
+            /* Check source picture changes */
+            if (private->p_source != region->p_picture)
+                is_changed = true;
+
             /* Check resize changes */
             if (dst_width  != private->fmt.i_visible_width ||
                 dst_height != private->fmt.i_visible_height)
@@ -969,13 +1039,13 @@ static void SpuRenderRegion(spu_t *spu,
                 is_changed = true;
 
             if (is_changed) {
-                subpicture_region_private_Delete(private);
-                region->p_private = NULL;
+                picture_Release(private->p_picture);
+                private->p_picture = NULL;
             }
         }
 
         /* Scale if needed into cache */
-        if (!region->p_private && dst_width > 0 && dst_height > 0) {
+        if (private && !private->p_picture && dst_width > 0 && dst_height > 0) {
             filter_t *scale = sys->scale;
 
             picture_t *picture = region->p_picture;
@@ -1028,13 +1098,12 @@ static void SpuRenderRegion(spu_t *spu,
 
             /* */
             if (picture) {
-                region->p_private = subpicture_region_private_New(&picture->format);
-                if (region->p_private) {
-                    region->p_private->p_picture = picture;
-                    if (!region->p_private->p_picture) {
-                        subpicture_region_private_Delete(region->p_private);
-                        region->p_private = NULL;
-                    }
+                video_format_Clean(&private->fmt);
+                if (video_format_Copy(&private->fmt, &picture->format) == VLC_SUCCESS) {
+                    private->p_picture = picture;
+                    if (private->p_source)
+                        picture_Release(private->p_source);
+                    private->p_source = picture_Hold(region->p_picture);
                 } else {
                     picture_Release(picture);
                 }
@@ -1042,14 +1111,25 @@ static void SpuRenderRegion(spu_t *spu,
         }
 
         /* And use the scaled picture */
-        if (region->p_private) {
-            region_fmt     = region->p_private->fmt;
-            region_picture = region->p_private->p_picture;
+        if (private && private->p_picture) {
+            region_fmt     = private->fmt;
+            region_picture = private->p_picture;
         }
     }
 
     /* Force cropping if requested */
-    if (crop_requested) {
+    if (crop_requested && placed && private->place.crop_valid &&
+        private->place.picture_width  == region_fmt.i_visible_width &&
+        private->place.picture_height == region_fmt.i_visible_height) {
+        region_fmt.i_x_offset       = private->place.fmt_x_offset;
+        region_fmt.i_y_offset       = private->place.fmt_y_offset;
+        region_fmt.i_visible_width  = private->place.fmt_width;
+        region_fmt.i_visible_height = private->place.fmt_height;
+        x_offset = private->place.crop_x_offset;
+        y_offset = private->place.crop_y_offset;
+    } else if (crop_requested) {
+        const unsigned picture_width  = region_fmt.i_visible_width;
+        const unsigned picture_height = region_fmt.i_visible_height;
         int crop_x, crop_y, crop_width, crop_height;
         if(sys->force_crop){
             crop_x     = spu_scale_w(sys->crop.x, scale_size);
@@ -1096,6 +1176,18 @@ static void SpuRenderRegion(spu_t *spu,
             x_offset = __MAX(x, 0);
             y_offset = __MAX(y, 0);
         }
+
+        if (cacheable && private->place.valid) {
+            private->place.picture_width  = picture_width;
+            private->place.picture_height = picture_height;
+            private->place.fmt_x_offset   = region_fmt.i_x_offset;
+            private->place.fmt_y_offset   = region_fmt.i_y_offset;
+            private->place.fmt_width      = region_fmt.i_visible_width;
+            private->place.fmt_height     = region_fmt.i_visible_height;
+            private->place.crop_x_offset  = x_offset;
+            private->place.crop_y_offset  = y_offset;
+            private->place.crop_valid     = true;
+        }
     }
 
     subpicture_region_t *dst = *dst_ptr = subpicture_region_NewInternal(&region_fmt);
@@ -1289,6 +1381,7 @@ static void UpdateSPU(spu_t *spu, const vlc_spu_highlight_t *hl)
 
     sys->palette.i_entries = 0;
     sys->force_crop = false;
+    sys->layout_generation++;
 
     if (hl == NULL)
         return;
@@ -1654,6 +1747,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
 
     sys->secondary_alignment = var_InheritInteger(spu,
                                                   "secondary-sub-alignment");
+    sys->layout_generation = 0;
 
     sys->source_chain_update = NULL;
     sys->filter_chain_update = NULL;
@@ -2108,6 +2202,7 @@ void spu_ChangeChannelOrderMargin(spu_t *spu, enum vlc_vout_order order,
         default:
             vlc_assert_unreachable();
     }
+    sys->layout_generation++;
     vlc_mutex_unlock(&sys->lock);
 }
 
@@ -0,0 +1,43 @@
+/*
+ * bench.h - libvlc benchmark common definitions
+ *
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2024 VLC authors and VideoLAN                       *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+#include "test.h"
+
+/*********************************************************************
+ * Some useful common functions
+ */
+
+/* Same as test_init(), then creates the LibVLC instance of the benchmark */
+static inline libvlc_instance_t *bench_init (int argc, const char *const *argv)
+{
+    /* Benchmarks may take longer than the test time-out, unless
+     * VLC_TEST_TIMEOUT says otherwise */
+    setenv( "VLC_TEST_TIMEOUT", "0", 0 );
+    test_init();
+
+    return libvlc_new( argc, argv );
+}
+
+#endif /* TEST_BENCH_H */
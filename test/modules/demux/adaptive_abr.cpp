@@ -0,0 +1,493 @@
+/*****************************************************************************
+ * adaptive_abr.cpp: adaptation logics trace replay
+ *****************************************************************************
+ * Copyright (C) 2024 VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Replays network traces against the adaptation logics, in simulated time,
+ * and reports startup time, rebuffering ratio, average bitrate and
+ * switches for each of them.
+ *
+ * Without arguments, runs the built-in traces and checks the basic
+ * expectations. Otherwise:
+ *   adaptive_abr [-m manifest] [-l kbps,kbps,...] [-d segment_ms]
+ *                [-t duration_s] trace...
+ * A trace is a text file of "<duration ms> <throughput kbps>" lines,
+ * replayed in a loop. The bitrate ladder is read from the bandwidth
+ * attributes of a DASH, HLS or Smooth manifest, or given with -l.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../modules/demux/adaptive/playlist/AbstractPlaylist.hpp"
+#include "../modules/demux/adaptive/playlist/BasePeriod.h"
+#include "../modules/demux/adaptive/playlist/BaseAdaptationSet.h"
+#include "../modules/demux/adaptive/playlist/BaseRepresentation.h"
+#include "../modules/demux/adaptive/logic/AlwaysBestAdaptationLogic.h"
+#include "../modules/demux/adaptive/logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/NearOptimalAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/PredictiveAdaptationLogic.hpp"
+#include "../modules/demux/adaptive/logic/RateBasedAdaptationLogic.h"
+#include "../modules/demux/adaptive/logic/BufferingLogic.hpp"
+
+#include <vlc_common.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char vlc_module_name[] = "test_adaptive_abr";
+
+using namespace adaptive;
+using namespace adaptive::playlist;
+using namespace adaptive::logic;
+
+class TracePlaylist : public AbstractPlaylist
+{
+    public:
+        TracePlaylist() : AbstractPlaylist(NULL) {}
+        virtual bool isLive() const { return false; }
+        virtual void debug() {}
+};
+
+/* piecewise constant throughput, looped */
+class Trace
+{
+    public:
+        std::string name;
+        std::vector<std::pair<vlc_tick_t, uint64_t> > steps;
+
+        vlc_tick_t length() const
+        {
+            vlc_tick_t total = 0;
+            for(size_t i=0; i<steps.size(); i++)
+                total += steps[i].first;
+            return total;
+        }
+
+        /* returns the time needed to transfer size bytes starting at now */
+        vlc_tick_t transfer(vlc_tick_t now, uint64_t size) const
+        {
+            const vlc_tick_t total = length();
+            vlc_tick_t elapsed = 0;
+            double bits = size * 8.0;
+            vlc_tick_t offset = now % total;
+            size_t i = 0;
+            while(offset >= steps[i].first)
+                offset -= steps[i++].first;
+            for(;;)
+            {
+                const vlc_tick_t remain = steps[i].first - offset;
+                const double capacity = (double) steps[i].second *
+                                        remain / CLOCK_FREQ;
+                if(steps[i].second && capacity >= bits)
+                    return elapsed + (vlc_tick_t)(bits * CLOCK_FREQ / steps[i].second);
+                bits -= capacity;
+                elapsed += remain;
+                offset = 0;
+                i = (i + 1) % steps.size();
+            }
+        }
+
+        void add(vlc_tick_t duration, uint64_t kbps)
+        {
+            steps.push_back(std::make_pair(duration, kbps * 1000));
+        }
+};
+
+struct Results
+{
+    vlc_tick_t startup;
+    vlc_tick_t rebuffering;
+    vlc_tick_t played;
+    uint64_t   bitratesum;
+    unsigned   segments;
+    unsigned   switches;
+    uint64_t   lowest;
+    uint64_t   highest;
+};
+
+struct Session
+{
+    TracePlaylist playlist;
+    BaseAdaptationSet *set;
+    vlc_tick_t segmentduration;
+    vlc_tick_t duration;
+    vlc_tick_t rtt;
+
+    Session(const std::vector<uint64_t> &ladder)
+    {
+        BasePeriod *period = new BasePeriod(&playlist);
+        playlist.addPeriod(period);
+        set = new BaseAdaptationSet(period);
+        set->setID(ID("abr"));
+        for(size_t i=0; i<ladder.size(); i++)
+        {
+            BaseRepresentation *rep = new BaseRepresentation(set);
+            rep->setBandwidth(ladder[i]);
+            rep->setID(ID(i));
+            set->addRepresentation(rep);
+        }
+        period->addAdaptationSet(set);
+        segmentduration = VLC_TICK_FROM_SEC(2);
+        duration = VLC_TICK_FROM_SEC(300);
+        rtt = VLC_TICK_FROM_MS(50);
+    }
+};
+
+static Results Replay(Session &session, AbstractAdaptationLogic *logic,
+                      const Trace &trace)
+{
+    const vlc_tick_t minbuffer = AbstractBufferingLogic::DEFAULT_MIN_BUFFERING;
+    const vlc_tick_t maxbuffer = AbstractBufferingLogic::DEFAULT_MAX_BUFFERING;
+    const ID &id = session.set->getID();
+
+    Results res;
+    memset(&res, 0, sizeof(res));
+    res.startup = VLC_TICK_INVALID;
+    res.lowest = UINT64_MAX;
+
+    vlc_tick_t now = 0;
+    vlc_tick_t buffer = 0;
+    vlc_tick_t queued = 0;
+    BaseRepresentation *prev = NULL;
+
+    logic->trackerEvent(SegmentTrackerEvent(id, true));
+
+    while(queued < session.duration)
+    {
+        BaseRepresentation *rep = logic->getNextRepresentation(session.set, prev);
+        if(rep == NULL)
+            break;
+        if(rep != prev)
+        {
+            logic->trackerEvent(SegmentTrackerEvent(prev, rep));
+            if(prev)
+                res.switches++;
+            prev = rep;
+        }
+        logic->trackerEvent(SegmentTrackerEvent(id, session.segmentduration));
+
+        const uint64_t size = rep->getBandwidth() *
+                              session.segmentduration / CLOCK_FREQ / 8;
+        const vlc_tick_t dltime = session.rtt + trace.transfer(now + session.rtt, size);
+        now += dltime;
+
+        if(res.startup != VLC_TICK_INVALID)
+        {
+            /* playback drains the buffer, stalls when empty */
+            if(buffer < dltime)
+            {
+                res.rebuffering += dltime - buffer;
+                res.played += buffer;
+                buffer = 0;
+            }
+            else
+            {
+                res.played += dltime;
+                buffer -= dltime;
+            }
+        }
+
+        buffer += session.segmentduration;
+        queued += session.segmentduration;
+        res.bitratesum += rep->getBandwidth();
+        res.segments++;
+        res.lowest = std::min(res.lowest, rep->getBandwidth());
+        res.highest = std::max(res.highest, rep->getBandwidth());
+
+        if(res.startup == VLC_TICK_INVALID &&
+           (buffer >= minbuffer || queued >= session.duration))
+            res.startup = now;
+
+        logic->updateDownloadRate(id, size, dltime);
+        logic->trackerEvent(SegmentTrackerEvent(id, minbuffer, buffer, maxbuffer));
+
+        /* full, wait for playback to free a segment */
+        if(res.startup != VLC_TICK_INVALID &&
+           buffer + session.segmentduration > maxbuffer)
+        {
+            const vlc_tick_t wait = buffer + session.segmentduration - maxbuffer;
+            now += wait;
+            res.played += wait;
+            buffer -= wait;
+        }
+    }
+
+    res.played += buffer;
+    logic->trackerEvent(SegmentTrackerEvent(id, false));
+    return res;
+}
+
+struct LogicEntry
+{
+    const char *name;
+    AbstractAdaptationLogic::LogicType type;
+};
+
+static const LogicEntry logics[] = {
+    { "rate",        AbstractAdaptationLogic::RateBased },
+    { "predictive",  AbstractAdaptationLogic::Predictive },
+    { "nearoptimal", AbstractAdaptationLogic::NearOptimal },
+    { "highest",     AbstractAdaptationLogic::AlwaysBest },
+    { "lowest",      AbstractAdaptationLogic::AlwaysLowest },
+};
+
+static AbstractAdaptationLogic *CreateLogic(AbstractAdaptationLogic::LogicType type)
+{
+    switch(type)
+    {
+        case AbstractAdaptationLogic::RateBased:
+            return new RateBasedAdaptationLogic(NULL);
+        case AbstractAdaptationLogic::Predictive:
+            return new PredictiveAdaptationLogic(NULL);
+        case AbstractAdaptationLogic::NearOptimal:
+            return new NearOptimalAdaptationLogic(NULL);
+        case AbstractAdaptationLogic::AlwaysBest:
+            return new AlwaysBestAdaptationLogic(NULL);
+        case AbstractAdaptationLogic::AlwaysLowest:
+        default:
+            return new AlwaysLowestAdaptationLogic(NULL);
+    }
+}
+
+static void Report(const char *trace, const char *logic, const Results &res)
+{
+    printf("%-12s %-12s %8.2f %8.2f%% %9" PRIu64 " %8u\n", trace, logic,
+           secf_from_vlc_tick(res.startup),
+           res.played ? 100.0 * res.rebuffering / (res.played + res.rebuffering) : 0.0,
+           res.segments ? res.bitratesum / res.segments / 1000 : 0,
+           res.switches);
+}
+
+static int RunAll(Session &session, const std::vector<Trace> &traces,
+                  std::vector<std::vector<Results> > *results)
+{
+    printf("%-12s %-12s %8s %9s %9s %8s\n", "trace", "logic",
+           "startup", "rebuffer", "avg kbps", "switches");
+    for(size_t i=0; i<traces.size(); i++)
+    {
+        std::vector<Results> row;
+        for(size_t j=0; j<ARRAY_SIZE(logics); j++)
+        {
+            AbstractAdaptationLogic *logic = CreateLogic(logics[j].type);
+            Results res = Replay(session, logic, traces[i]);
+            delete logic;
+            Report(traces[i].name.c_str(), logics[j].name, res);
+            row.push_back(res);
+        }
+        if(results)
+            results->push_back(row);
+    }
+    return 0;
+}
+
+static bool LoadTrace(const char *path, Trace &trace)
+{
+    std::ifstream in(path);
+    if(!in.is_open())
+        return false;
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream ss(line);
+        double ms, kbps;
+        if(line.empty() || line[0] == '#' || !(ss >> ms >> kbps) ||
+           ms <= 0 || kbps < 0)
+            continue;
+        trace.add(VLC_TICK_FROM_MS(ms), kbps);
+    }
+    const char *name = strrchr(path, '/');
+    trace.name = name ? name + 1 : path;
+    return !trace.steps.empty() && trace.length() > 0;
+}
+
+/* collects the bandwidth attributes of any adaptive manifest */
+static void LoadManifestLadder(const char *path, std::vector<uint64_t> &ladder)
+{
+    std::ifstream in(path);
+    std::string content((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    static const char *const keys[] = { "bandwidth=", "BANDWIDTH=", "Bitrate=" };
+    for(size_t k=0; k<ARRAY_SIZE(keys); k++)
+    {
+        std::string::size_type pos = 0;
+        while((pos = content.find(keys[k], pos)) != std::string::npos)
+        {
+            pos += strlen(keys[k]);
+            if(pos < content.size() && content[pos] == '"')
+                pos++;
+            uint64_t bw = strtoull(content.c_str() + pos, NULL, 10);
+            if(bw)
+                ladder.push_back(bw);
+        }
+    }
+}
+
+static void ParseLadder(const char *list, std::vector<uint64_t> &ladder)
+{
+    std::istringstream ss(list);
+    std::string item;
+    while(std::getline(ss, item, ','))
+    {
+        uint64_t kbps = strtoull(item.c_str(), NULL, 10);
+        if(kbps)
+            ladder.push_back(kbps * 1000);
+    }
+}
+
+static std::vector<Trace> BuiltinTraces()
+{
+    std::vector<Trace> traces;
+
+    Trace ample;
+    ample.name = "ample";
+    ample.add(VLC_TICK_FROM_SEC(60), 50000);
+    traces.push_back(ample);
+
+    Trace constant;
+    constant.name = "constant";
+    constant.add(VLC_TICK_FROM_SEC(60), 2500);
+    traces.push_back(constant);
+
+    Trace step;
+    step.name = "step";
+    step.add(VLC_TICK_FROM_SEC(60), 8000);
+    step.add(VLC_TICK_FROM_SEC(40), 900);
+    step.add(VLC_TICK_FROM_SEC(60), 8000);
+    traces.push_back(step);
+
+    /* cellular like: fades, handovers and short outages */
+    Trace mobile;
+    mobile.name = "mobile";
+    uint32_t seed = 0x5eed;
+    for(unsigned i=0; i<120; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        const unsigned r = (seed >> 16) % 100;
+        uint64_t kbps;
+        if(r < 5)
+            kbps = 0;
+        else if(r < 30)
+            kbps = 300 + r * 20;
+        else
+            kbps = 1000 + r * 60;
+        mobile.add(VLC_TICK_FROM_MS(500 + (seed >> 8) % 2000), kbps);
+    }
+    traces.push_back(mobile);
+
+    return traces;
+}
+
+static int Check(const Session &session, const std::vector<Trace> &traces,
+                 const std::vector<std::vector<Results> > &results)
+{
+    uint64_t lowest = UINT64_MAX, highest = 0;
+    std::vector<BaseRepresentation *>::const_iterator it;
+    for(it = session.set->getRepresentations().begin();
+        it != session.set->getRepresentations().end(); ++it)
+    {
+        lowest = std::min(lowest, (*it)->getBandwidth());
+        highest = std::max(highest, (*it)->getBandwidth());
+    }
+
+    for(size_t i=0; i<traces.size(); i++)
+    {
+        for(size_t j=0; j<ARRAY_SIZE(logics); j++)
+        {
+            const Results &res = results[i][j];
+            if(res.startup == VLC_TICK_INVALID ||
+               res.segments * session.segmentduration < session.duration)
+                return 1;
+            if(logics[j].type == AbstractAdaptationLogic::AlwaysLowest &&
+               (res.switches || res.highest != lowest))
+                return 1;
+            if(logics[j].type == AbstractAdaptationLogic::AlwaysBest &&
+               (res.switches || res.lowest != highest))
+                return 1;
+            /* everything fits, no logic should stall and the
+             * throughput based ones should reach the top */
+            if(traces[i].name == "ample")
+            {
+                if(res.rebuffering)
+                    return 1;
+                if((logics[j].type == AbstractAdaptationLogic::RateBased ||
+                    logics[j].type == AbstractAdaptationLogic::NearOptimal) &&
+                   res.highest != highest)
+                    return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint64_t> ladder;
+    std::vector<Trace> traces;
+    vlc_tick_t segmentduration = 0, duration = 0;
+
+    for(int i=1; i<argc; i++)
+    {
+        if(!strcmp(argv[i], "-m") && i + 1 < argc)
+            LoadManifestLadder(argv[++i], ladder);
+        else if(!strcmp(argv[i], "-l") && i + 1 < argc)
+            ParseLadder(argv[++i], ladder);
+        else if(!strcmp(argv[i], "-d") && i + 1 < argc)
+            segmentduration = VLC_TICK_FROM_MS(atoi(argv[++i]));
+        else if(!strcmp(argv[i], "-t") && i + 1 < argc)
+            duration = VLC_TICK_FROM_SEC(atoi(argv[++i]));
+        else
+        {
+            Trace trace;
+            if(!LoadTrace(argv[i], trace))
+            {
+                std::cerr << "cannot load trace " << argv[i] << std::endl;
+                return 1;
+            }
+            traces.push_back(trace);
+        }
+    }
+
+    std::sort(ladder.begin(), ladder.end());
+    ladder.erase(std::unique(ladder.begin(), ladder.end()), ladder.end());
+    if(ladder.empty())
+        ParseLadder("400,800,1500,3000,6000", ladder);
+
+    Session session(ladder);
+    if(segmentduration > 0)
+        session.segmentduration = segmentduration;
+    if(duration > 0)
+        session.duration = duration;
+
+    if(!traces.empty())
+        return RunAll(session, traces, NULL);
+
+    traces = BuiltinTraces();
+    std::vector<std::vector<Results> > results;
+    RunAll(session, traces, &results);
+    return Check(session, traces, results);
+}
@@ -0,0 +1,780 @@
+/*****************************************************************************
+ * bench.c: packetizer micro-benchmarks
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Feeds elementary streams through the packetizers in input blocks of
+ * various sizes and reports the cost per input byte.
+ *
+ * Usage: test_modules_packetizer_bench [-s MiB] [-r runs] [codec[=file]...]
+ *
+ * Without a file, a synthetic stream of the given size is generated for the
+ * codec. Raw AV1 files must use the low overhead OBU format.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/bench.h"
+
+#include <string.h>
+#include <getopt.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_codec.h>
+#include <vlc_meta.h>
+
+struct bench_buf
+{
+    uint8_t *p;
+    size_t   i;
+    size_t   i_alloc;
+};
+
+static uint32_t bench_seed = 0x12345678;
+
+static unsigned bench_rand(unsigned lo, unsigned hi)
+{
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return lo + (bench_seed >> 8) % (hi - lo + 1);
+}
+
+static uint8_t *buf_reserve(struct bench_buf *b, size_t i)
+{
+    if (b->i + i > b->i_alloc)
+    {
+        size_t i_alloc = __MAX(b->i_alloc * 2, b->i + i);
+        uint8_t *p = realloc(b->p, i_alloc);
+        if (p == NULL)
+            abort();
+        b->p = p;
+        b->i_alloc = i_alloc;
+    }
+    uint8_t *p = &b->p[b->i];
+    b->i += i;
+    return p;
+}
+
+static void buf_append(struct bench_buf *b, const void *p, size_t i)
+{
+    memcpy(buf_reserve(b, i), p, i);
+}
+
+static void buf_fill(struct bench_buf *b, size_t i, unsigned lo, unsigned hi)
+{
+    uint8_t *p = buf_reserve(b, i);
+    for (size_t j = 0; j < i; j++)
+        p[j] = bench_rand(lo, hi);
+}
+
+/* MSB first bit writer over a zeroed buffer */
+struct bits
+{
+    uint8_t p[64];
+    size_t  i_bit;
+};
+
+static void bits_put(struct bits *w, uint32_t v, unsigned n)
+{
+    while (n-- > 0)
+    {
+        if ((v >> n) & 1)
+            w->p[w->i_bit / 8] |= 0x80 >> (w->i_bit % 8);
+        w->i_bit++;
+    }
+}
+
+static void bits_ue(struct bits *w, uint32_t v)
+{
+    unsigned n = 0;
+    while ((v + 1) >> (n + 1))
+        n++;
+    bits_put(w, 0, n);
+    bits_put(w, v + 1, n + 1);
+}
+
+static size_t bits_trailing(struct bits *w)
+{
+    bits_put(w, 1, 1);
+    return (w->i_bit + 7) / 8;
+}
+
+/* Appends an Annex B NAL with emulation prevention */
+static void buf_nal(struct bench_buf *b, const uint8_t *p, size_t i)
+{
+    static const uint8_t startcode[4] = { 0, 0, 0, 1 };
+    unsigned zeros = 0;
+
+    buf_append(b, startcode, 4);
+    for (size_t j = 0; j < i; j++)
+    {
+        if (zeros >= 2 && p[j] <= 3)
+        {
+            *buf_reserve(b, 1) = 3;
+            zeros = 0;
+        }
+        zeros = p[j] ? 0 : zeros + 1;
+        *buf_reserve(b, 1) = p[j];
+    }
+}
+
+/* 720x576 baseline, 4 bits frame_num, POC type 2 */
+static void gen_h264(struct bench_buf *b, size_t i_size)
+{
+    struct bits w = { .i_bit = 0 };
+    memset(w.p, 0, sizeof (w.p));
+    bits_put(&w, 0x67, 8);
+    bits_put(&w, 66, 8);    /* profile_idc */
+    bits_put(&w, 0xC0, 8);  /* constraint flags */
+    bits_put(&w, 30, 8);    /* level_idc */
+    bits_ue(&w, 0);         /* seq_parameter_set_id */
+    bits_ue(&w, 0);         /* log2_max_frame_num_minus4 */
+    bits_ue(&w, 2);         /* pic_order_cnt_type */
+    bits_ue(&w, 1);         /* max_num_ref_frames */
+    bits_put(&w, 0, 1);     /* gaps_in_frame_num_value_allowed_flag */
+    bits_ue(&w, 44);        /* pic_width_in_mbs_minus1 */
+    bits_ue(&w, 35);        /* pic_height_in_map_units_minus1 */
+    bits_put(&w, 1, 1);     /* frame_mbs_only_flag */
+    bits_put(&w, 1, 1);     /* direct_8x8_inference_flag */
+    bits_put(&w, 0, 1);     /* frame_cropping_flag */
+    bits_put(&w, 0, 1);     /* vui_parameters_present_flag */
+    const size_t i_sps = bits_trailing(&w);
+    uint8_t sps[sizeof (w.p)];
+    memcpy(sps, w.p, i_sps);
+
+    memset(w.p, 0, sizeof (w.p));
+    w.i_bit = 0;
+    bits_put(&w, 0x68, 8);
+    bits_ue(&w, 0);         /* pic_parameter_set_id */
+    bits_ue(&w, 0);         /* seq_parameter_set_id */
+    bits_put(&w, 0, 2);     /* entropy_coding, bottom_field_pic_order */
+    bits_ue(&w, 0);         /* num_slice_groups_minus1 */
+    bits_ue(&w, 0);         /* num_ref_idx_l0_default_active_minus1 */
+    bits_ue(&w, 0);         /* num_ref_idx_l1_default_active_minus1 */
+    bits_put(&w, 0, 3);     /* weighted_pred_flag, weighted_bipred_idc */
+    bits_ue(&w, 0);         /* pic_init_qp_minus26 (se) */
+    bits_ue(&w, 0);         /* pic_init_qs_minus26 (se) */
+    bits_ue(&w, 0);         /* chroma_qp_index_offset (se) */
+    bits_put(&w, 1, 1);     /* deblocking_filter_control_present_flag */
+    bits_put(&w, 0, 2);     /* constrained_intra, redundant_pic_cnt */
+    const size_t i_pps = bits_trailing(&w);
+    uint8_t pps[sizeof (w.p)];
+    memcpy(pps, w.p, i_pps);
+
+    for (unsigned i_frame = 0; b->i < i_size; i_frame++)
+    {
+        const bool b_idr = (i_frame % 25) == 0;
+        if (b_idr)
+        {
+            buf_nal(b, sps, i_sps);
+            buf_nal(b, pps, i_pps);
+        }
+
+        memset(w.p, 0, sizeof (w.p));
+        w.i_bit = 0;
+        bits_put(&w, b_idr ? 0x65 : 0x41, 8);
+        bits_ue(&w, 0);                     /* first_mb_in_slice */
+        bits_ue(&w, b_idr ? 7 : 5);         /* slice_type */
+        bits_ue(&w, 0);                     /* pic_parameter_set_id */
+        bits_put(&w, (i_frame % 25) & 15, 4); /* frame_num */
+        if (b_idr)
+        {
+            bits_ue(&w, (i_frame / 25) % 2);/* idr_pic_id */
+            bits_put(&w, 0, 2);             /* dec_ref_pic_marking */
+        }
+        else
+            bits_put(&w, 0, 3);             /* override, reordering, marking */
+        bits_ue(&w, 0);                     /* slice_qp_delta (se) */
+        bits_ue(&w, 0);                     /* disable_deblocking_filter_idc */
+        bits_ue(&w, 0);                     /* slice_alpha_c0_offset_div2 */
+        bits_ue(&w, 0);                     /* slice_beta_offset_div2 */
+        buf_nal(b, w.p, (w.i_bit + 7) / 8);
+        /* Slice data without start code emulation */
+        buf_fill(b, b_idr ? 30000 : bench_rand(20, 80) * 100, 1, 255);
+    }
+}
+
+/* Parameter sets of the 16x16 sample of the HEVC packetizer test */
+static const uint8_t hevc_vps[] = {
+    0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x04, 0x08, 0x00, 0x00, 0x03, 0x00,
+    0x9e, 0x08, 0x00, 0x00, 0x03, 0x00, 0x00, 0x1e, 0x95, 0x98, 0x09,
+};
+static const uint8_t hevc_sps[] = {
+    0x42, 0x01, 0x01, 0x04, 0x08, 0x00, 0x00, 0x03, 0x00, 0x9e, 0x08, 0x00,
+    0x00, 0x03, 0x00, 0x00, 0x1e, 0x90, 0x11, 0x08, 0xb2, 0xca, 0xcd, 0x57,
+    0x95, 0xcd, 0x40, 0x80, 0x80, 0x01, 0x00, 0x00, 0x03, 0x00, 0x01, 0x00,
+    0x00, 0x03, 0x00, 0x19, 0x08,
+};
+static const uint8_t hevc_pps[] = {
+    0x44, 0x01, 0xc1, 0x73, 0x18, 0x31, 0x08, 0x90,
+};
+
+static void buf_raw_nal(struct bench_buf *b, const uint8_t *p, size_t i)
+{
+    static const uint8_t startcode[4] = { 0, 0, 0, 1 };
+    buf_append(b, startcode, 4);
+    buf_append(b, p, i);
+}
+
+static void gen_hevc(struct bench_buf *b, size_t i_size)
+{
+    static const uint8_t idr[] = { 0x28, 0x01, 0xaf, 0x19, 0x80, 0xef };
+    static const uint8_t trail[] = { 0x02, 0x01, 0xd0, 0x29, 0x4b, 0xe1 };
+
+    for (unsigned i_frame = 0; b->i < i_size; i_frame++)
+    {
+        const bool b_idr = (i_frame % 25) == 0;
+        if (b_idr)
+        {
+            buf_raw_nal(b, hevc_vps, sizeof (hevc_vps));
+            buf_raw_nal(b, hevc_sps, sizeof (hevc_sps));
+            buf_raw_nal(b, hevc_pps, sizeof (hevc_pps));
+            buf_raw_nal(b, idr, sizeof (idr));
+        }
+        else
+            buf_raw_nal(b, trail, sizeof (trail));
+        buf_fill(b, b_idr ? 30000 : bench_rand(20, 80) * 100, 1, 255);
+    }
+}
+
+/* MPEG-1 720x576 25 fps, 36 slices per picture */
+static void gen_mpegv(struct bench_buf *b, size_t i_size)
+{
+    static const uint8_t seq[] = {
+        0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x23,
+        0xFF, 0xFF, 0xE3, 0x80,
+    };
+    static const uint8_t gop[] = {
+        0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x40,
+    };
+
+    for (unsigned i_frame = 0; b->i < i_size; i_frame++)
+    {
+        const bool b_intra = (i_frame % 12) == 0;
+        if (b_intra)
+        {
+            buf_append(b, seq, sizeof (seq));
+            buf_append(b, gop, sizeof (gop));
+        }
+
+        struct bits w = { .i_bit = 0 };
+        memset(w.p, 0, sizeof (w.p));
+        bits_put(&w, 0x00000100, 32);
+        bits_put(&w, i_frame % 12, 10);     /* temporal_reference */
+        bits_put(&w, b_intra ? 1 : 2, 3);   /* picture_coding_type */
+        bits_put(&w, 0xFFFF, 16);           /* vbv_delay */
+        if (!b_intra)
+            bits_put(&w, 1, 4);             /* full_pel, forward_f_code */
+        buf_append(b, w.p, (w.i_bit + 1 + 7) / 8);
+
+        for (unsigned i_slice = 1; i_slice <= 36; i_slice++)
+        {
+            const uint8_t slice[4] = { 0x00, 0x00, 0x01, i_slice };
+            buf_append(b, slice, 4);
+            buf_fill(b, b_intra ? 800 : bench_rand(5, 20) * 10, 1, 255);
+        }
+    }
+}
+
+/* ADTS AAC-LC 48 kHz stereo */
+static void gen_mp4a(struct bench_buf *b, size_t i_size)
+{
+    while (b->i < i_size)
+    {
+        const unsigned i_frame = 7 + bench_rand(200, 700);
+        const uint8_t adts[7] = {
+            0xFF, 0xF1, (1 << 6) | (3 << 2), (2 << 6) | (i_frame >> 11),
+            (i_frame >> 3) & 0xFF, ((i_frame & 7) << 5) | 0x1F, 0xFC,
+        };
+        buf_append(b, adts, 7);
+        buf_fill(b, i_frame - 7, 0, 254);
+    }
+}
+
+/* A/52 48 kHz 384 kb/s stereo */
+static void gen_a52(struct bench_buf *b, size_t i_size)
+{
+    static const uint8_t header[] = {
+        0x0B, 0x77, 0x00, 0x00, 0x1C, 0x40, 0x40,
+    };
+
+    while (b->i < i_size)
+    {
+        buf_append(b, header, sizeof (header));
+        buf_fill(b, 1536 - sizeof (header), 0, 255);
+    }
+}
+
+/* DTS core 48 kHz stereo, 512 samples per frame */
+static void gen_dts(struct bench_buf *b, size_t i_size)
+{
+    struct bits w = { .i_bit = 0 };
+    memset(w.p, 0, sizeof (w.p));
+    bits_put(&w, 0x7FFE8001, 32);
+    bits_put(&w, 1, 1);         /* FTYPE */
+    bits_put(&w, 31, 5);        /* SHORT */
+    bits_put(&w, 0, 1);         /* CPF */
+    bits_put(&w, 15, 7);        /* NBLKS */
+    bits_put(&w, 2012 - 1, 14); /* FSIZE */
+    bits_put(&w, 2, 6);         /* AMODE */
+    bits_put(&w, 13, 4);        /* SFREQ */
+    bits_put(&w, 15, 5);        /* RATE */
+    bits_put(&w, 0, 10);        /* flags, EXT_AUDIO_ID, ASPF */
+    bits_put(&w, 0, 2);         /* LFF */
+    const size_t i_header = 14;
+
+    while (b->i < i_size)
+    {
+        buf_append(b, w.p, i_header);
+        buf_fill(b, 2012 - i_header, 0, 255);
+    }
+}
+
+static uint8_t flac_crc8(const uint8_t *p, size_t i)
+{
+    uint8_t crc = 0;
+    while (i-- > 0)
+    {
+        crc ^= *p++;
+        for (unsigned j = 0; j < 8; j++)
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+static uint16_t flac_crc16(const uint8_t *p, size_t i)
+{
+    uint16_t crc = 0;
+    while (i-- > 0)
+    {
+        crc ^= *p++ << 8;
+        for (unsigned j = 0; j < 8; j++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+    }
+    return crc;
+}
+
+/* FLAC 44.1 kHz stereo 16 bits, 4096 samples per frame */
+static const uint8_t flac_streaminfo[34] = {
+    0x10, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0A, 0xC4, 0x42, 0xF0,
+};
+
+static void gen_flac(struct bench_buf *b, size_t i_size)
+{
+    for (uint32_t i_frame = 0; b->i < i_size; i_frame = (i_frame + 1) & 0xFFFF)
+    {
+        const size_t i_start = b->i;
+        uint8_t header[16] = { 0xFF, 0xF8, 0xC9, 0x18 };
+        size_t i_header = 4;
+
+        /* UTF-8 coded frame number */
+        if (i_frame < 0x80)
+            header[i_header++] = i_frame;
+        else if (i_frame < 0x800)
+        {
+            header[i_header++] = 0xC0 | (i_frame >> 6);
+            header[i_header++] = 0x80 | (i_frame & 0x3F);
+        }
+        else
+        {
+            header[i_header++] = 0xE0 | ((i_frame >> 12) & 0x0F);
+            header[i_header++] = 0x80 | ((i_frame >> 6) & 0x3F);
+            header[i_header++] = 0x80 | (i_frame & 0x3F);
+        }
+        header[i_header] = flac_crc8(header, i_header);
+        buf_append(b, header, i_header + 1);
+        buf_fill(b, bench_rand(40, 120) * 100, 0, 254);
+
+        const uint16_t crc = flac_crc16(&b->p[i_start], b->i - i_start);
+        const uint8_t footer[2] = { crc >> 8, crc & 0xFF };
+        buf_append(b, footer, 2);
+    }
+}
+
+static void buf_obu(struct bench_buf *b, unsigned i_type, const uint8_t *p,
+                    size_t i)
+{
+    uint8_t header[1 + 8];
+    size_t i_header = 1;
+
+    header[0] = (i_type << 3) | 0x02; /* obu_has_size_field */
+    size_t i_leb = i;
+    do
+    {
+        header[i_header] = i_leb & 0x7F;
+        i_leb >>= 7;
+        if (i_leb)
+            header[i_header] |= 0x80;
+        i_header++;
+    } while (i_leb);
+    buf_append(b, header, i_header);
+    if (p)
+        buf_append(b, p, i);
+    else
+        buf_fill(b, i, 0, 255);
+}
+
+/* AV1 main profile 1920x1080, one key frame every 25 frames */
+static void gen_av1(struct bench_buf *b, size_t i_size)
+{
+    struct bits w = { .i_bit = 0 };
+    memset(w.p, 0, sizeof (w.p));
+    bits_put(&w, 0, 3);         /* seq_profile */
+    bits_put(&w, 0, 2);         /* still_picture, reduced_still_picture */
+    bits_put(&w, 0, 2);         /* timing_info, initial_display_delay */
+    bits_put(&w, 0, 5);         /* operating_points_cnt_minus_1 */
+    bits_put(&w, 0, 12);        /* operating_point_idc[0] */
+    bits_put(&w, 8, 5);         /* seq_level_idx[0] */
+    bits_put(&w, 0, 1);         /* seq_tier[0] */
+    bits_put(&w, 15, 4);        /* frame_width_bits_minus_1 */
+    bits_put(&w, 15, 4);        /* frame_height_bits_minus_1 */
+    bits_put(&w, 1919, 16);     /* max_frame_width_minus_1 */
+    bits_put(&w, 1079, 16);     /* max_frame_height_minus_1 */
+    bits_put(&w, 0, 9);         /* frame_id_numbers_present ... order_hint */
+    bits_put(&w, 1, 1);         /* seq_choose_screen_content_tools */
+    bits_put(&w, 1, 1);         /* seq_choose_integer_mv */
+    bits_put(&w, 0, 3);         /* superres, cdef, restoration */
+    bits_put(&w, 0, 3);         /* high_bitdepth, mono_chrome, color_desc */
+    bits_put(&w, 0, 1);         /* color_range */
+    bits_put(&w, 0, 2);         /* chroma_sample_position */
+    bits_put(&w, 0, 1);         /* separate_uv_delta_q */
+    bits_put(&w, 0, 1);         /* film_grain_params_present */
+    const size_t i_seq = bits_trailing(&w);
+
+    for (unsigned i_frame = 0; b->i < i_size; i_frame++)
+    {
+        const bool b_key = (i_frame % 25) == 0;
+        buf_obu(b, 2 /* TEMPORAL_DELIMITER */, NULL, 0);
+        if (b_key)
+            buf_obu(b, 1 /* SEQUENCE_HEADER */, w.p, i_seq);
+
+        const size_t i_payload = b_key ? 30000 : bench_rand(20, 80) * 100;
+        buf_obu(b, 6 /* FRAME */, NULL, i_payload);
+        uint8_t *p = &b->p[b->i - i_payload];
+        /* show_existing_frame = 0, frame_type, show_frame = 1 */
+        p[0] = b_key ? 0x10 : 0x30;
+    }
+}
+
+/* Returns the size of the OBU at the start of the buffer, or 0 */
+static size_t av1_obu_size(const uint8_t *p, size_t i)
+{
+    if (i < 2 || !(p[0] & 0x02))
+        return 0;
+    size_t i_header = (p[0] & 0x04) ? 2 : 1;
+    uint64_t i_size = 0;
+    for (unsigned j = 0; j < 8; j++)
+    {
+        if (i_header >= i)
+            return 0;
+        const uint8_t v = p[i_header++];
+        i_size |= (uint64_t)(v & 0x7F) << (7 * j);
+        if (!(v & 0x80))
+            break;
+    }
+    if (i_size > i - i_header)
+        return 0;
+    return i_header + i_size;
+}
+
+struct bench_codec
+{
+    const char *psz_name;
+    vlc_fourcc_t i_codec;
+    vlc_fourcc_t i_original_fourcc;
+    enum es_format_category_e i_cat;
+    void (*pf_generate)(struct bench_buf *, size_t);
+    bool b_obu;
+    const uint8_t *p_extra;
+    size_t i_extra;
+};
+
+static const struct bench_codec codecs[] =
+{
+    { "h264",  VLC_CODEC_H264, 0, VIDEO_ES, gen_h264,  false, NULL, 0 },
+    { "hevc",  VLC_CODEC_HEVC, 0, VIDEO_ES, gen_hevc,  false, NULL, 0 },
+    { "av1",   VLC_CODEC_AV1,  0, VIDEO_ES, gen_av1,   true,  NULL, 0 },
+    { "mpgv",  VLC_CODEC_MPGV, 0, VIDEO_ES, gen_mpegv, false, NULL, 0 },
+    { "mp4a",  VLC_CODEC_MP4A, VLC_FOURCC('A','D','T','S'), AUDIO_ES,
+      gen_mp4a, false, NULL, 0 },
+    { "a52",   VLC_CODEC_A52,  0, AUDIO_ES, gen_a52,   false, NULL, 0 },
+    { "dts",   VLC_CODEC_DTS,  0, AUDIO_ES, gen_dts,   false, NULL, 0 },
+    { "flac",  VLC_CODEC_FLAC, 0, AUDIO_ES, gen_flac,  false,
+      flac_streaminfo, sizeof (flac_streaminfo) },
+};
+
+static const size_t chunk_sizes[] = { 188, 1316, 4096, 65536 };
+
+static void delete_packetizer(decoder_t *p_pack)
+{
+    if(p_pack->p_module)
+        module_unneed(p_pack, p_pack->p_module);
+    es_format_Clean(&p_pack->fmt_in);
+    es_format_Clean(&p_pack->fmt_out);
+    if(p_pack->p_description)
+        vlc_meta_Delete(p_pack->p_description);
+    vlc_object_delete(p_pack);
+}
+
+static decoder_t *create_packetizer(vlc_object_t *obj,
+                                    const struct bench_codec *codec)
+{
+    decoder_t *p_pack = vlc_object_create(obj, sizeof(*p_pack));
+    if(!p_pack)
+        return NULL;
+    p_pack->pf_decode = NULL;
+    p_pack->pf_packetize = NULL;
+
+    es_format_Init(&p_pack->fmt_in, codec->i_cat, codec->i_codec);
+    es_format_Init(&p_pack->fmt_out, codec->i_cat, 0);
+    p_pack->fmt_in.i_original_fourcc = codec->i_original_fourcc;
+    if(codec->i_cat == VIDEO_ES)
+    {
+        p_pack->fmt_in.video.i_frame_rate = 25;
+        p_pack->fmt_in.video.i_frame_rate_base = 1;
+    }
+    p_pack->fmt_in.b_packetized = false;
+    if(codec->i_extra)
+    {
+        p_pack->fmt_in.p_extra = malloc(codec->i_extra);
+        if(!p_pack->fmt_in.p_extra)
+        {
+            delete_packetizer(p_pack);
+            return NULL;
+        }
+        memcpy(p_pack->fmt_in.p_extra, codec->p_extra, codec->i_extra);
+        p_pack->fmt_in.i_extra = codec->i_extra;
+    }
+
+    p_pack->p_module = module_need( p_pack, "packetizer", NULL, false );
+    if(!p_pack->p_module)
+    {
+        delete_packetizer(p_pack);
+        return NULL;
+    }
+    return p_pack;
+}
+
+/* Splits the stream into input blocks, outside of the measured section */
+static block_t *split_stream(const struct bench_buf *b, size_t i_chunk,
+                             bool b_obu)
+{
+    block_t *p_chain = NULL;
+    block_t **pp_last = &p_chain;
+
+    for (size_t i_offset = 0; i_offset < b->i;)
+    {
+        size_t i = __MIN(i_chunk, b->i - i_offset);
+        if (b_obu)
+        {   /* Blocks must carry whole OBUs */
+            i = 0;
+            for (;;)
+            {
+                size_t i_obu = av1_obu_size(&b->p[i_offset + i],
+                                            b->i - i_offset - i);
+                if (i_obu == 0 || (i > 0 && i + i_obu > i_chunk))
+                    break;
+                i += i_obu;
+            }
+            if (i == 0)
+                break;
+        }
+
+        block_t *p_block = block_Alloc(i);
+        if (p_block == NULL)
+            abort();
+        memcpy(p_block->p_buffer, &b->p[i_offset], i);
+        if (p_chain == NULL)
+            p_block->i_dts = p_block->i_pts = VLC_TICK_0;
+        block_ChainLastAppend(&pp_last, p_block);
+        i_offset += i;
+    }
+    return p_chain;
+}
+
+static int bench_run(vlc_object_t *obj, const struct bench_codec *codec,
+                     const struct bench_buf *b, const char *psz_input,
+                     unsigned i_runs)
+{
+    for (size_t k = 0; k < ARRAY_SIZE(chunk_sizes); k++)
+    {
+        vlc_tick_t i_best = INT64_MAX;
+        size_t i_bytes = 0;
+        unsigned i_out = 0;
+        size_t i_out_bytes = 0;
+
+        for (unsigned r = 0; r < i_runs; r++)
+        {
+            decoder_t *p = create_packetizer(obj, codec);
+            if (p == NULL)
+            {
+                fprintf(stderr, "no packetizer for %s\n", codec->psz_name);
+                return 1;
+            }
+
+            block_t *p_chain = split_stream(b, chunk_sizes[k], codec->b_obu);
+            i_bytes = 0;
+            i_out = 0;
+            i_out_bytes = 0;
+
+            vlc_tick_t i_start = vlc_tick_now();
+            while (p_chain != NULL)
+            {
+                block_t *in = p_chain;
+                p_chain = p_chain->p_next;
+                in->p_next = NULL;
+                i_bytes += in->i_buffer;
+
+                block_t *out;
+                while ((out = p->pf_packetize(p, &in)) != NULL)
+                {
+                    for (block_t *o = out; o != NULL; o = o->p_next)
+                    {
+                        i_out++;
+                        i_out_bytes += o->i_buffer;
+                    }
+                    block_ChainRelease(out);
+                }
+            }
+            block_t *out;
+            while ((out = p->pf_packetize(p, NULL)) != NULL)
+            {
+                for (block_t *o = out; o != NULL; o = o->p_next)
+                {
+                    i_out++;
+                    i_out_bytes += o->i_buffer;
+                }
+                block_ChainRelease(out);
+            }
+            vlc_tick_t i_elapsed = vlc_tick_now() - i_start;
+
+            delete_packetizer(p);
+            if (i_elapsed < i_best)
+                i_best = i_elapsed;
+        }
+
+        const double ns = (double) US_FROM_VLC_TICK(i_best) * 1000.;
+        printf("%-5s %-10s %6zu %10zu %9.3f ns/B %9.1f MB/s "
+               "%8u blocks %10zu bytes\n",
+               codec->psz_name, psz_input, chunk_sizes[k], i_bytes,
+               i_bytes ? ns / i_bytes : 0.,
+               ns > 0. ? i_bytes * 1000. / ns : 0., i_out, i_out_bytes);
+    }
+    return 0;
+}
+
+static int load_file(struct bench_buf *b, const char *psz_path)
+{
+    FILE *f = fopen(psz_path, "rb");
+    if (f == NULL)
+    {
+        perror(psz_path);
+        return -1;
+    }
+
+    for (;;)
+    {
+        size_t i_read = fread(buf_reserve(b, 65536), 1, 65536, f);
+        b->i -= 65536 - i_read;
+        if (i_read < 65536)
+            break;
+    }
+    fclose(f);
+    return 0;
+}
+
+static int bench_codec(vlc_object_t *obj, const char *psz_arg,
+                       size_t i_size, unsigned i_runs)
+{
+    const char *psz_path = strchr(psz_arg, '=');
+    size_t i_name = psz_path ? (size_t)(psz_path - psz_arg) : strlen(psz_arg);
+    const struct bench_codec *codec = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(codecs); i++)
+        if (strlen(codecs[i].psz_name) == i_name &&
+            !strncmp(codecs[i].psz_name, psz_arg, i_name))
+            codec = &codecs[i];
+    if (codec == NULL)
+    {
+        fprintf(stderr, "unknown codec %.*s\n", (int) i_name, psz_arg);
+        return 1;
+    }
+
+    struct bench_buf b = { NULL, 0, 0 };
+    if (psz_path != NULL)
+    {
+        if (load_file(&b, psz_path + 1))
+            return 1;
+    }
+    else
+        codec->pf_generate(&b, i_size);
+
+    int ret = bench_run(obj, codec, &b,
+                        psz_path ? psz_path + 1 : "synthetic", i_runs);
+    free(b.p);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t i_size = 16 << 20;
+    unsigned i_runs = 3;
+    int c;
+
+    while ((c = getopt(argc, argv, "r:s:")) != -1)
+        switch (c)
+        {
+            case 'r':
+                i_runs = __MAX(atoi(optarg), 1);
+                break;
+            case 's':
+                i_size = (size_t) __MAX(atoi(optarg), 1) << 20;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-s MiB] [-r runs] "
+                        "[codec[=file]...]\n", argv[0]);
+                return 1;
+        }
+
+    const char *const args[] = { "--quiet" };
+    libvlc_instance_t *vlc = bench_init(ARRAY_SIZE(args), args);
+    if(!vlc)
+        return 1;
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    int ret = 0;
+    if (optind < argc)
+    {
+        for (int i = optind; i < argc; i++)
+            ret |= bench_codec(obj, argv[i], i_size, i_runs);
+    }
+    else
+    {
+        for (size_t i = 0; i < ARRAY_SIZE(codecs); i++)
+            ret |= bench_codec(obj, codecs[i].psz_name, i_size, i_runs);
+    }
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -30,6 +30,7 @@
 #include <vlc_block_helper.h>
 
 #include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
 
 struct results_s
 {
@@ -87,6 +88,78 @@ static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
     }
     else printf("asm not built in, skipping test:\n");
 
+#ifdef STARTCODE_AVX2
+    if( vlc_CPU_AVX2() )
+    {
+        printf("checking avx2:\n");
+        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                           startcode_FindAnnexB_AVX2 );
+        if( i_ret != 0 )
+            return i_ret;
+    }
+#endif
+#ifdef STARTCODE_NEON
+    printf("checking neon:\n");
+    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                       startcode_FindAnnexB_NEON );
+    if( i_ret != 0 )
+        return i_ret;
+#endif
+
+    return 0;
+}
+
+static int check_ep3b_size( const uint8_t *p, const uint8_t *p_end )
+{
+    /* reference: byte per byte unescaping */
+    unsigned i_prev = 0;
+    size_t i_ref = 0;
+    for( const uint8_t *q = p; q < p_end; i_ref++ )
+        q = hxxx_ep3b_to_rbsp( (uint8_t *)q, (uint8_t *)p_end, &i_prev, 1 );
+
+    size_t i_size = hxxx_ep3b_total_size( p, p_end );
+    if( i_size != i_ref )
+    {
+        printf("ep3b size %zu, expected %zu\n", i_size, i_ref);
+        return 1;
+    }
+
+    /* as seen by the bitstream reader */
+    struct hxxx_bsfw_ep3b_ctx_s bsctx;
+    hxxx_bsfw_ep3b_ctx_init( &bsctx );
+    bs_t bs;
+    bs_init_custom( &bs, p, p_end - p, &hxxx_bsfw_ep3b_callbacks, &bsctx );
+    if( bs_remain( &bs ) != 8 * i_ref )
+        return 1;
+    return 0;
+}
+
+static int run_ep3b_sets( void )
+{
+    const uint8_t test_ep3b[] = { 0, 0, 3, 0, 0, 3, 3, 0, 0, 3, 0, 0, 0, 3,
+                                  0x42, 0, 0, 3, 0, 3, 0, 0, 3 };
+
+    printf("* Running ep3b tests:\n");
+    for( size_t i = 0; i < sizeof(test_ep3b); i++ )
+        for( size_t j = i; j <= sizeof(test_ep3b); j++ )
+            if( check_ep3b_size( &test_ep3b[i], &test_ep3b[j] ) )
+                return 1;
+
+    /* sparse zeros and threes, crossing the vector sizes */
+    uint8_t data[300];
+    unsigned seed = 1;
+    for( int k = 0; k < 200; k++ )
+    {
+        for( size_t i = 0; i < sizeof(data); i++ )
+        {
+            seed = seed * 1103515245 + 12345;
+            unsigned v = (seed >> 16) % 8;
+            data[i] = v < 4 ? 0 : v < 6 ? 3 : 0x42;
+        }
+        for( size_t i = 0; i < 40; i++ )
+            if( check_ep3b_size( &data[i], &data[sizeof(data) - i] ) )
+                return 1;
+    }
     return 0;
 }
 
@@ -134,5 +207,5 @@ int main( void )
             return i_ret;
     }
 
-    return 0;
+    return run_ep3b_sets();
 }
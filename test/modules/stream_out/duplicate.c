@@ -0,0 +1,183 @@
+/*****************************************************************************
+ * duplicate.c: test for the duplicate stream output
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#define MODULE_NAME test_sout_capture
+#define MODULE_STRING "test_sout_capture"
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_es.h>
+#include <vlc_aout.h>
+
+#include "../../libvlc/test.h"
+#include "../../../lib/libvlc_internal.h"
+
+const char vlc_module_name[] = MODULE_STRING;
+
+#define SAMPLES 256
+#define CHANNELS 6
+
+/* Blocks received by the capture output */
+static block_t *captured;
+static block_t **captured_last = &captured;
+
+static void *CaptureAdd(sout_stream_t *stream, const es_format_t *fmt)
+{
+    (void) stream; (void) fmt;
+    return &captured;
+}
+
+static void CaptureDel(sout_stream_t *stream, void *id)
+{
+    (void) stream; (void) id;
+}
+
+static int CaptureSend(sout_stream_t *stream, void *id, block_t *block)
+{
+    (void) stream; (void) id;
+    block_ChainLastAppend(&captured_last, block);
+    return VLC_SUCCESS;
+}
+
+static const struct sout_stream_operations capture_ops = {
+    .add = CaptureAdd,
+    .del = CaptureDel,
+    .send = CaptureSend,
+};
+
+static int CaptureOpen(vlc_object_t *obj)
+{
+    sout_stream_t *stream = (sout_stream_t *)obj;
+
+    stream->ops = &capture_ops;
+    return VLC_SUCCESS;
+}
+
+vlc_module_begin()
+    set_capability("sout output", 0)
+    add_shortcut("capture")
+    set_callback(CaptureOpen)
+vlc_module_end()
+
+typedef int (*vlc_plugin_cb)(vlc_set_cb, void *);
+
+/* Picked up by the module bank, along with the dynamic plugins */
+VLC_EXPORT vlc_plugin_cb vlc_static_modules[] = {
+    VLC_SYMBOL(vlc_entry),
+    NULL
+};
+
+static uint8_t Sample(size_t i)
+{
+    return (i * 7 + 1) & 0xff;
+}
+
+static void test_chain(vlc_object_t *obj, const char *chain)
+{
+    test_log("chain: %s\n", chain);
+
+    sout_instance_t *sout = vlc_object_create(obj, sizeof (*sout));
+    assert(sout != NULL);
+    sout->psz_sout = NULL;
+    sout->i_out_pace_nocontrol = 0;
+    sout->b_wants_substreams = false;
+    vlc_mutex_init(&sout->lock);
+
+    sout->p_stream = sout_StreamChainNew(sout, chain, NULL, NULL);
+    assert(sout->p_stream != NULL);
+
+    /* Side and rear channels, that the WAV muxer reorders in place */
+    es_format_t fmt;
+    es_format_Init(&fmt, AUDIO_ES, VLC_CODEC_S16L);
+    fmt.audio.i_format = VLC_CODEC_S16L;
+    fmt.audio.i_rate = 48000;
+    fmt.audio.i_channels = CHANNELS;
+    fmt.audio.i_physical_channels = AOUT_CHANS_FRONT | AOUT_CHANS_MIDDLE
+                                  | AOUT_CHANS_REAR;
+    fmt.audio.i_bitspersample = 16;
+    fmt.audio.i_blockalign = 2 * CHANNELS;
+
+    void *id = sout_StreamIdAdd(sout->p_stream, &fmt);
+    assert(id != NULL);
+
+    for (unsigned i = 0; i < 4; i++)
+    {
+        block_t *block = block_Alloc(SAMPLES * 2 * CHANNELS);
+        assert(block != NULL);
+        for (size_t j = 0; j < block->i_buffer; j++)
+            block->p_buffer[j] = Sample(j);
+        block->i_dts = block->i_pts = VLC_TICK_0
+                                    + i * vlc_tick_from_samples(SAMPLES, 48000);
+        block->i_length = vlc_tick_from_samples(SAMPLES, 48000);
+        block->i_nb_samples = SAMPLES;
+        assert(sout_StreamIdSend(sout->p_stream, id, block) == VLC_SUCCESS);
+    }
+
+    sout_StreamIdDel(sout->p_stream, id);
+    sout_StreamChainDelete(sout->p_stream, NULL);
+    vlc_object_delete(sout);
+
+    /* The other output still sees the original samples */
+    unsigned count = 0;
+    for (block_t *block = captured; block != NULL; block = block->p_next)
+    {
+        assert(block->i_buffer == SAMPLES * 2 * CHANNELS);
+        for (size_t j = 0; j < block->i_buffer; j++)
+            assert(block->p_buffer[j] == Sample(j));
+        count++;
+    }
+    assert(count == 4);
+
+    block_ChainRelease(captured);
+    captured = NULL;
+    captured_last = &captured;
+}
+
+int main(void)
+{
+    static const char *argv[] = {
+        "-v", "--sout-mux-caching=0",
+    };
+
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(argv), argv);
+    assert(vlc != NULL);
+
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* The muxer gets a new reference to the payload */
+    test_chain(obj, "duplicate{dst=std{mux=wav,access=dummy,dst=dummy},"
+                              "dst=capture}");
+    /* The muxer gets the original block while the capture holds another */
+    test_chain(obj, "duplicate{dst=capture,"
+                              "dst=std{mux=wav,access=dummy,dst=dummy}}");
+
+    libvlc_release(vlc);
+    return 0;
+}
@@ -0,0 +1,462 @@
+/*****************************************************************************
+ * bench.c: video converter and filter benchmarks
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Runs frames through a "video converter" (or, with -f, a "video filter")
+ * module and reports the throughput. With -c, times the plane copies of the
+ * chroma copy helpers (as used by the hardware decoders) instead.
+ *
+ * Usage: test_modules_video_chroma_bench [-f] [-n frames] [-s WxH] [-o WxH]
+ *            <module|any> <input chroma> [output chroma]
+ *        test_modules_video_chroma_bench -c [-n frames] [-s WxH]
+ *            <input chroma> <output chroma>
+ *
+ * e.g. test_modules_video_chroma_bench -s 1920x1080 swscale I420 RV32
+ *      test_modules_video_chroma_bench -c -s 3840x2160 NV12 I420
+ *
+ * Memory traffic is the size of the visible planes read and written, not
+ * a hardware counter.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/bench.h"
+
+#include <string.h>
+#include <getopt.h>
+#if defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+# define HAVE_RDTSC 1
+#endif
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_picture_pool.h>
+
+#include "../../../modules/video_chroma/copy.h"
+
+#define BENCH_INPUTS 4
+#define BENCH_WARMUP 10
+
+static uint64_t bench_cycles(void)
+{
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static picture_t *BufferNew(filter_t *filter)
+{
+    picture_pool_t *pool = filter->owner.sys;
+    return picture_pool_Get(pool);
+}
+
+static const struct filter_video_callbacks bench_video_cbs =
+{
+    .buffer_new = BufferNew,
+};
+
+static size_t picture_bytes(const picture_t *pic)
+{
+    size_t i_bytes = 0;
+    for (int i = 0; i < pic->i_planes; i++)
+        i_bytes += (size_t) pic->p[i].i_visible_lines
+                 * pic->p[i].i_visible_pitch;
+    return i_bytes;
+}
+
+static void picture_fill(picture_t *pic, uint32_t seed)
+{
+    for (int i = 0; i < pic->i_planes; i++)
+    {
+        plane_t *plane = &pic->p[i];
+        for (int y = 0; y < plane->i_lines; y++)
+        {
+            uint8_t *p = &plane->p_pixels[y * plane->i_pitch];
+            for (int x = 0; x < plane->i_pitch; x++)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                p[x] = seed >> 24;
+            }
+        }
+    }
+}
+
+static void release_output(picture_t *pic, size_t *pi_bytes)
+{
+    while (pic != NULL)
+    {
+        picture_t *next = pic->p_next;
+        pic->p_next = NULL;
+        *pi_bytes += picture_bytes(pic);
+        picture_Release(pic);
+        pic = next;
+    }
+}
+
+static int parse_size(const char *psz, unsigned *pi_width, unsigned *pi_height)
+{
+    if (sscanf(psz, "%ux%u", pi_width, pi_height) != 2
+     || *pi_width == 0 || *pi_height == 0)
+    {
+        fprintf(stderr, "invalid size %s\n", psz);
+        return -1;
+    }
+    return 0;
+}
+
+static int bench(vlc_object_t *obj, const char *psz_module,
+                 const char *psz_capability,
+                 const video_format_t *fmt_in, const video_format_t *fmt_out,
+                 unsigned i_frames)
+{
+    filter_t *filter = vlc_object_create(obj, sizeof (*filter));
+    if (filter == NULL)
+        return 1;
+
+    es_format_InitFromVideo(&filter->fmt_in, fmt_in);
+    es_format_InitFromVideo(&filter->fmt_out, fmt_out);
+    filter->b_allow_fmt_out_change = false;
+
+    picture_pool_t *pool = picture_pool_NewFromFormat(fmt_out, 4);
+    picture_t *inputs[BENCH_INPUTS] = { NULL };
+    int ret = 1;
+
+    if (pool == NULL)
+    {
+        fprintf(stderr, "cannot allocate %4.4s pictures\n",
+                (const char *) &fmt_out->i_chroma);
+        goto error;
+    }
+    filter->owner.video = &bench_video_cbs;
+    filter->owner.sys = pool;
+
+    for (unsigned i = 0; i < BENCH_INPUTS; i++)
+    {
+        inputs[i] = picture_NewFromFormat(fmt_in);
+        if (inputs[i] == NULL)
+        {
+            fprintf(stderr, "cannot allocate %4.4s pictures\n",
+                    (const char *) &fmt_in->i_chroma);
+            goto error;
+        }
+        picture_fill(inputs[i], i + 1);
+    }
+
+    filter->p_module = module_need(filter, psz_capability, psz_module,
+                                   psz_module != NULL);
+    if (filter->p_module == NULL)
+    {
+        fprintf(stderr, "no %s for %4.4s %ux%u -> %4.4s %ux%u\n",
+                psz_capability,
+                (const char *) &fmt_in->i_chroma,
+                fmt_in->i_visible_width, fmt_in->i_visible_height,
+                (const char *) &fmt_out->i_chroma,
+                fmt_out->i_visible_width, fmt_out->i_visible_height);
+        goto error;
+    }
+
+    vlc_tick_t i_date = VLC_TICK_0;
+    vlc_tick_t i_start = 0;
+    uint64_t i_cycles = 0;
+    size_t i_in_bytes = 0, i_out_bytes = 0;
+    unsigned i_out = 0;
+
+    for (unsigned i = 0; i < BENCH_WARMUP + i_frames; i++)
+    {
+        if (i == BENCH_WARMUP)
+        {
+            i_in_bytes = i_out_bytes = 0;
+            i_out = 0;
+            i_start = vlc_tick_now();
+            i_cycles = bench_cycles();
+        }
+
+        picture_t *in = picture_Hold(inputs[i % BENCH_INPUTS]);
+        in->date = i_date;
+        in->b_force = false;
+        i_date += VLC_TICK_FROM_MS(40);
+        i_in_bytes += picture_bytes(in);
+
+        picture_t *out = filter->pf_video_filter(filter, in);
+        if (out != NULL)
+            i_out++;
+        release_output(out, &i_out_bytes);
+    }
+
+    const double seconds = secf_from_vlc_tick(vlc_tick_now() - i_start);
+    i_cycles = bench_cycles() - i_cycles;
+    const double pixels = (double) i_frames
+                        * fmt_in->i_visible_width * fmt_in->i_visible_height;
+
+    printf("%s %4.4s %ux%u -> %4.4s %ux%u: %u frames, %u output, "
+           "%.1f fps, %.3f ns/px",
+           module_get_object(filter->p_module),
+           (const char *) &fmt_in->i_chroma,
+           fmt_in->i_visible_width, fmt_in->i_visible_height,
+           (const char *) &filter->fmt_out.video.i_chroma,
+           filter->fmt_out.video.i_visible_width,
+           filter->fmt_out.video.i_visible_height,
+           i_frames, i_out, seconds > 0. ? i_frames / seconds : 0.,
+           pixels > 0. ? seconds * 1e9 / pixels : 0.);
+#ifdef HAVE_RDTSC
+    printf(", %.2f cycles/px", pixels > 0. ? i_cycles / pixels : 0.);
+#endif
+    printf(", %.1f + %.1f MB/frame, %.2f GB/s\n",
+           i_in_bytes / (1e6 * i_frames), i_out_bytes / (1e6 * i_frames),
+           seconds > 0. ? (i_in_bytes + i_out_bytes) / (seconds * 1e9) : 0.);
+
+    if (filter->pf_flush != NULL)
+        filter->pf_flush(filter);
+    module_unneed(filter, filter->p_module);
+    ret = 0;
+error:
+    for (unsigned i = 0; i < BENCH_INPUTS; i++)
+        if (inputs[i] != NULL)
+            picture_Release(inputs[i]);
+    es_format_Clean(&filter->fmt_in);
+    es_format_Clean(&filter->fmt_out);
+    vlc_object_delete(filter);
+    if (pool != NULL)
+        picture_pool_Release(pool);
+    return ret;
+}
+
+struct bench_copy
+{
+    vlc_fourcc_t src_chroma;
+    vlc_fourcc_t dst_chroma;
+    int bitshift;
+    union
+    {
+        void (*conv)(picture_t *, const uint8_t *[], const size_t [], unsigned,
+                     const copy_cache_t *);
+        void (*conv16)(picture_t *, const uint8_t *[], const size_t [],
+                       unsigned, int, const copy_cache_t *);
+    };
+};
+
+static const struct bench_copy copies[] = {
+    { VLC_CODEC_NV12, VLC_CODEC_I420, 0, .conv = Copy420_SP_to_P },
+    { VLC_CODEC_NV12, VLC_CODEC_NV12, 0, .conv = Copy420_SP_to_SP },
+    { VLC_CODEC_I420, VLC_CODEC_I420, 0, .conv = Copy420_P_to_P },
+    { VLC_CODEC_I420, VLC_CODEC_NV12, 0, .conv = Copy420_P_to_SP },
+    { VLC_CODEC_P010, VLC_CODEC_I420_10L, 6, .conv16 = Copy420_16_SP_to_P },
+    { VLC_CODEC_I420_10L, VLC_CODEC_P010, -6, .conv16 = Copy420_16_P_to_SP },
+};
+
+static int bench_copy(const video_format_t *fmt_in,
+                      const video_format_t *fmt_out, unsigned i_frames)
+{
+    const struct bench_copy *copy = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(copies); i++)
+        if (copies[i].src_chroma == fmt_in->i_chroma
+         && copies[i].dst_chroma == fmt_out->i_chroma)
+        {
+            copy = &copies[i];
+            break;
+        }
+    if (copy == NULL)
+    {
+        fprintf(stderr, "no copy for %4.4s -> %4.4s\n",
+                (const char *) &fmt_in->i_chroma,
+                (const char *) &fmt_out->i_chroma);
+        return 1;
+    }
+
+    const vlc_chroma_description_t *dsc =
+        vlc_fourcc_GetChromaDescription(fmt_in->i_chroma);
+    picture_t *src = picture_NewFromFormat(fmt_in);
+    picture_t *dst = picture_NewFromFormat(fmt_out);
+    copy_cache_t cache;
+    int ret = 1;
+
+    if (src == NULL || dst == NULL
+     || CopyInitCache(&cache, fmt_in->i_width * dsc->pixel_size))
+    {
+        fprintf(stderr, "cannot allocate %4.4s pictures\n",
+                (const char *) &fmt_in->i_chroma);
+        goto error;
+    }
+    picture_fill(src, 1);
+
+    const uint8_t *src_planes[3] = { src->p[Y_PLANE].p_pixels,
+                                     src->p[U_PLANE].p_pixels,
+                                     src->p[V_PLANE].p_pixels };
+    const size_t src_pitches[3] = { src->p[Y_PLANE].i_pitch,
+                                    src->p[U_PLANE].i_pitch,
+                                    src->p[V_PLANE].i_pitch };
+    vlc_tick_t i_start = 0;
+    uint64_t i_cycles = 0;
+
+    for (unsigned i = 0; i < BENCH_WARMUP + i_frames; i++)
+    {
+        if (i == BENCH_WARMUP)
+        {
+            i_start = vlc_tick_now();
+            i_cycles = bench_cycles();
+        }
+
+        if (copy->bitshift == 0)
+            copy->conv(dst, src_planes, src_pitches,
+                       fmt_in->i_visible_height, &cache);
+        else
+            copy->conv16(dst, src_planes, src_pitches,
+                         fmt_in->i_visible_height, copy->bitshift, &cache);
+    }
+
+    const double seconds = secf_from_vlc_tick(vlc_tick_now() - i_start);
+    i_cycles = bench_cycles() - i_cycles;
+    const double pixels = (double) i_frames
+                        * fmt_in->i_visible_width * fmt_in->i_visible_height;
+    const size_t i_bytes = picture_bytes(src) + picture_bytes(dst);
+
+    printf("copy %4.4s %ux%u -> %4.4s: %u frames, %.1f fps, %.3f ns/px",
+           (const char *) &fmt_in->i_chroma,
+           fmt_in->i_visible_width, fmt_in->i_visible_height,
+           (const char *) &fmt_out->i_chroma,
+           i_frames, seconds > 0. ? i_frames / seconds : 0.,
+           pixels > 0. ? seconds * 1e9 / pixels : 0.);
+#ifdef HAVE_RDTSC
+    printf(", %.2f cycles/px", pixels > 0. ? i_cycles / pixels : 0.);
+#endif
+    printf(", %.1f MB/frame, %.2f GB/s\n", i_bytes / 1e6,
+           seconds > 0. ? (double) i_bytes * i_frames / (seconds * 1e9) : 0.);
+
+    CopyCleanCache(&cache);
+    ret = 0;
+error:
+    if (dst != NULL)
+        picture_Release(dst);
+    if (src != NULL)
+        picture_Release(src);
+    return ret;
+}
+
+static void usage(const char *psz_name)
+{
+    fprintf(stderr, "Usage: %s [-f] [-n frames] [-s WxH] [-o WxH] "
+            "<module|any> <input chroma> [output chroma]\n"
+            "       %s -c [-n frames] [-s WxH] "
+            "<input chroma> <output chroma>\n", psz_name, psz_name);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned i_width = 1920, i_height = 1080;
+    unsigned i_out_width = 0, i_out_height = 0;
+    unsigned i_frames = 200;
+    const char *psz_capability = "video converter";
+    bool b_copy = false;
+    int c;
+
+    while ((c = getopt(argc, argv, "cfn:o:s:")) != -1)
+        switch (c)
+        {
+            case 'c':
+                b_copy = true;
+                break;
+            case 'f':
+                psz_capability = "video filter";
+                break;
+            case 'n':
+                i_frames = __MAX(atoi(optarg), 1);
+                break;
+            case 'o':
+                if (parse_size(optarg, &i_out_width, &i_out_height))
+                    return 1;
+                break;
+            case 's':
+                if (parse_size(optarg, &i_width, &i_height))
+                    return 1;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+
+    if (argc - optind < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const char *psz_module = NULL;
+    if (!b_copy)
+    {
+        psz_module = argv[optind++];
+        if (!strcmp(psz_module, "any"))
+            psz_module = NULL;
+    }
+
+    vlc_fourcc_t i_chroma_in =
+        vlc_fourcc_GetCodecFromString(VIDEO_ES, argv[optind]);
+    vlc_fourcc_t i_chroma_out = i_chroma_in;
+    if (argc - optind > 1)
+        i_chroma_out = vlc_fourcc_GetCodecFromString(VIDEO_ES,
+                                                     argv[optind + 1]);
+    if (i_chroma_in == 0 || i_chroma_out == 0)
+    {
+        fprintf(stderr, "unknown chroma\n");
+        return 1;
+    }
+    if (i_out_width == 0 || b_copy)
+    {
+        i_out_width = i_width;
+        i_out_height = i_height;
+    }
+
+    video_format_t fmt_in, fmt_out;
+    video_format_Init(&fmt_in, i_chroma_in);
+    video_format_Setup(&fmt_in, i_chroma_in, i_width, i_height,
+                       i_width, i_height, 1, 1);
+    video_format_Init(&fmt_out, i_chroma_out);
+    video_format_Setup(&fmt_out, i_chroma_out, i_out_width, i_out_height,
+                       i_out_width, i_out_height, 1, 1);
+
+    int ret = 1;
+
+    if (b_copy)
+        ret = bench_copy(&fmt_in, &fmt_out, i_frames);
+    else
+    {
+        const char *const args[] = { "--quiet" };
+        libvlc_instance_t *vlc = bench_init(ARRAY_SIZE(args), args);
+        if (vlc != NULL)
+        {
+            ret = bench(VLC_OBJECT(vlc->p_libvlc_int), psz_module,
+                        psz_capability, &fmt_in, &fmt_out, i_frames);
+            libvlc_release(vlc);
+        }
+    }
+
+    video_format_Clean(&fmt_in);
+    video_format_Clean(&fmt_out);
+    return ret;
+}
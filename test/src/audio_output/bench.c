@@ -0,0 +1,392 @@
+/*****************************************************************************
+ * bench.c: audio filters chain benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Pushes synthetic audio through aout_FiltersNew() chains and reports, for
+ * each resampler backend:
+ *  - the real-time factor of the whole chain (processing time / duration),
+ *  - the cost of each user filter, as the difference with a chain without
+ *    user filters,
+ *  - the latency introduced by the chain, i.e. the audio consumed but not
+ *    output yet before draining.
+ *
+ * With -t, scaletempo is inserted as the rate filter as the audio output
+ * does by default, otherwise the resampler changes the playback rate.
+ *
+ * Usage: test_src_audio_output_bench [-i rate] [-o rate] [-c channels]
+ *            [-f format] [-d seconds] [-b ms] [-R playback rate] [-t]
+ *            [-a filter[:filter...]] [-O libvlc option] [resampler...]
+ *
+ * e.g. test_src_audio_output_bench -i 44100 -o 48000 -a equalizer:spatializer
+ *          -O "--equalizer-bands=4 2 0 -2 -4 -2 0 2 4 6" speex soxr
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/bench.h"
+
+#include <math.h>
+#include <string.h>
+#include <getopt.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_variables.h>
+#include <vlc_interface.h>
+
+struct bench_params
+{
+    audio_sample_format_t fmt_in;
+    audio_sample_format_t fmt_out;
+    unsigned i_seconds;
+    unsigned i_block_ms;
+    float f_rate;
+    bool b_time_stretch;
+};
+
+struct bench_result
+{
+    double seconds;     /**< processing time */
+    double latency;     /**< audio retained by the chain (seconds) */
+    double duration;    /**< output duration (seconds) */
+    unsigned skipped;   /**< user filters that failed to load */
+};
+
+static unsigned skipped_filters;
+
+static void LogCallback(void *data, int type, const vlc_log_t *item,
+                        const char *fmt, va_list ap)
+{
+    /* Only keep track of the user filters that failed to load */
+    if (type == VLC_MSG_ERR && !strncmp(fmt, "cannot add user", 15))
+        skipped_filters++;
+    (void) data; (void) item; (void) ap;
+}
+
+static const struct vlc_logger_operations log_ops = { LogCallback, NULL };
+
+static void fill_samples(block_t *block, const audio_sample_format_t *fmt,
+                         uint64_t i_start)
+{
+    for (unsigned i = 0; i < block->i_nb_samples; i++)
+    {
+        /* 440 Hz tone with a slower 3 kHz partial */
+        const double t = (double) (i_start + i) / fmt->i_rate;
+        const double v = 0.5 * sin(2. * M_PI * 440. * t)
+                       + 0.25 * sin(2. * M_PI * 3000. * t);
+
+        for (unsigned c = 0; c < fmt->i_channels; c++)
+        {
+            const size_t j = (size_t) i * fmt->i_channels + c;
+            if (fmt->i_format == VLC_CODEC_FL32)
+                ((float *) block->p_buffer)[j] = v;
+            else
+                ((int16_t *) block->p_buffer)[j] = lrint(v * INT16_MAX);
+        }
+    }
+}
+
+static block_t *generate(const struct bench_params *params)
+{
+    const audio_sample_format_t *fmt = &params->fmt_in;
+    const unsigned i_samples = fmt->i_rate * params->i_block_ms / 1000;
+    const uint64_t i_total = (uint64_t) fmt->i_rate * params->i_seconds;
+    block_t *chain = NULL;
+    block_t **pp_last = &chain;
+
+    for (uint64_t i = 0; i < i_total; i += i_samples)
+    {
+        block_t *block = block_Alloc(i_samples * fmt->i_bytes_per_frame);
+        if (block == NULL)
+            abort();
+        block->i_nb_samples = i_samples;
+        block->i_pts = block->i_dts =
+            VLC_TICK_0 + vlc_tick_from_samples(i, fmt->i_rate);
+        block->i_length = vlc_tick_from_samples(i_samples, fmt->i_rate);
+        fill_samples(block, fmt, i);
+        block_ChainLastAppend(&pp_last, block);
+    }
+    return chain;
+}
+
+static int bench_run(vlc_object_t *parent, const struct bench_params *params,
+                     const char *psz_resampler, const char *psz_filters,
+                     struct bench_result *res)
+{
+    vlc_object_t *obj = vlc_object_create(parent, sizeof (*obj));
+    if (obj == NULL)
+        return -1;
+
+    char *psz_modlist;
+    if (asprintf(&psz_modlist, "%s,none", psz_resampler) < 0)
+    {
+        vlc_object_delete(obj);
+        return -1;
+    }
+
+    /* Do what the audio output does */
+    var_Create(obj, "audio-resampler", VLC_VAR_STRING);
+    var_SetString(obj, "audio-resampler", psz_modlist);
+    var_Create(obj, "audio-filter", VLC_VAR_STRING);
+    var_SetString(obj, "audio-filter", psz_filters);
+    var_Create(obj, "audio-visual", VLC_VAR_STRING);
+    var_SetString(obj, "audio-visual", "none");
+    var_Create(obj, "audio-time-stretch", VLC_VAR_BOOL);
+    var_SetBool(obj, "audio-time-stretch", params->b_time_stretch);
+    var_Create(obj, "visual", VLC_VAR_STRING);
+    var_Create(obj, "equalizer-preset", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
+    var_Create(obj, "equalizer-bands", VLC_VAR_STRING | VLC_VAR_DOINHERIT);
+    free(psz_modlist);
+
+    skipped_filters = 0;
+    aout_filters_t *filters = aout_FiltersNew(obj, &params->fmt_in,
+                                              &params->fmt_out, NULL);
+    if (filters == NULL)
+    {
+        vlc_object_delete(obj);
+        return -1;
+    }
+
+    res->skipped = skipped_filters;
+
+    block_t *chain = generate(params);
+    uint64_t i_in = 0, i_out = 0;
+
+    vlc_tick_t i_start = vlc_tick_now();
+    while (chain != NULL)
+    {
+        block_t *block = chain;
+        chain = chain->p_next;
+        block->p_next = NULL;
+        i_in += block->i_nb_samples;
+
+        block = aout_FiltersPlay(filters, block, params->f_rate);
+        for (block_t *out = block; out != NULL; out = out->p_next)
+            i_out += out->i_nb_samples;
+        block_ChainRelease(block);
+    }
+    const vlc_tick_t i_play = vlc_tick_now() - i_start;
+
+    /* What is still retained at this point is latency */
+    const double in = (double) i_in / params->fmt_in.i_rate / params->f_rate;
+    res->latency = in - (double) i_out / params->fmt_out.i_rate;
+
+    i_start = vlc_tick_now();
+    block_t *block = aout_FiltersDrain(filters);
+    for (block_t *out = block; out != NULL; out = out->p_next)
+        i_out += out->i_nb_samples;
+    block_ChainRelease(block);
+    res->seconds = secf_from_vlc_tick(i_play + vlc_tick_now() - i_start);
+    res->duration = (double) i_out / params->fmt_out.i_rate;
+
+    aout_FiltersDelete(obj, filters);
+    vlc_object_delete(obj);
+    return 0;
+}
+
+static void bench_resampler(vlc_object_t *obj,
+                            const struct bench_params *params,
+                            const char *psz_resampler,
+                            const char *psz_filters)
+{
+    const double duration = params->i_seconds / params->f_rate;
+    struct bench_result base, res;
+
+    if (bench_run(obj, params, psz_resampler, "", &base))
+    {
+        printf("%-12s unavailable\n", psz_resampler);
+        return;
+    }
+    printf("%-12s %-24s %7.4f RTF %8.1f x %8.2f ms latency\n",
+           psz_resampler, "(conversions only)", base.seconds / duration,
+           base.seconds > 0. ? duration / base.seconds : 0.,
+           base.latency * 1000.);
+
+    if (*psz_filters == '\0')
+        return;
+
+    char *psz_list = strdup(psz_filters);
+    if (psz_list == NULL)
+        return;
+
+    char *p = psz_list, *psz_name;
+    unsigned i_count = 0;
+    while ((psz_name = strsep(&p, " :")) != NULL)
+    {
+        if (*psz_name == '\0')
+            continue;
+        i_count++;
+        if (bench_run(obj, params, psz_resampler, psz_name, &res)
+         || res.skipped > 0)
+        {
+            printf("%-12s %-24s unavailable\n", "", psz_name);
+            continue;
+        }
+        printf("%-12s %-24s %7.4f RTF %8.3f ms/s %5.2f ms latency\n",
+               "", psz_name, (res.seconds - base.seconds) / duration,
+               (res.seconds - base.seconds) * 1000. / duration,
+               (res.latency - base.latency) * 1000.);
+    }
+    free(psz_list);
+
+    if (i_count > 1 && !bench_run(obj, params, psz_resampler, psz_filters,
+                                  &res))
+    {
+        char psz_label[32];
+        snprintf(psz_label, sizeof (psz_label), "(chain of %u/%u filters)",
+                 i_count - res.skipped, i_count);
+        printf("%-12s %-24s %7.4f RTF %8.1f x %8.2f ms latency\n",
+               "", psz_label, res.seconds / duration,
+               res.seconds > 0. ? duration / res.seconds : 0.,
+               res.latency * 1000.);
+    }
+}
+
+static void format_init(audio_sample_format_t *fmt, vlc_fourcc_t i_format,
+                        unsigned i_rate, unsigned i_channels)
+{
+    static const uint16_t masks[] = {
+        0, AOUT_CHAN_CENTER, AOUT_CHANS_STEREO, AOUT_CHANS_2_1,
+        AOUT_CHANS_4_0, AOUT_CHANS_5_0, AOUT_CHANS_5_1, AOUT_CHANS_6_1_MIDDLE,
+        AOUT_CHANS_7_1,
+    };
+
+    memset(fmt, 0, sizeof (*fmt));
+    fmt->i_format = i_format;
+    fmt->i_rate = i_rate;
+    fmt->i_physical_channels = masks[i_channels];
+    fmt->channel_type = AUDIO_CHANNEL_TYPE_BITMAP;
+    aout_FormatPrepare(fmt);
+}
+
+static void usage(const char *psz_name)
+{
+    fprintf(stderr, "Usage: %s [-i rate] [-o rate] [-c channels] "
+            "[-f fl32|s16n] [-d seconds] [-b ms] [-R playback rate] [-t] "
+            "[-a filter[:filter...]] [-O libvlc option] [resampler...]\n",
+            psz_name);
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *const resamplers[] = {
+        "bandlimited", "speex", "soxr", "src", "ugly",
+    };
+    struct bench_params params = {
+        .i_seconds = 60,
+        .i_block_ms = 20,
+        .f_rate = 1.f,
+    };
+    unsigned i_rate_in = 44100, i_rate_out = 48000, i_channels = 2;
+    vlc_fourcc_t i_format = VLC_CODEC_FL32;
+    const char *psz_filters = "";
+    /* The equalizer does not load without bands */
+    const char *args[2 + argc];
+    int i_args = 0;
+    int c;
+
+    args[i_args++] = "--quiet";
+    args[i_args++] = "--equalizer-bands=0 0 0 0 0 0 0 0 0 0";
+
+    while ((c = getopt(argc, argv, "a:b:c:d:f:i:o:O:R:t")) != -1)
+        switch (c)
+        {
+            case 'a':
+                psz_filters = optarg;
+                break;
+            case 'b':
+                params.i_block_ms = __MAX(atoi(optarg), 1);
+                break;
+            case 'c':
+                i_channels = atoi(optarg);
+                if (i_channels < 1 || i_channels > 8)
+                {
+                    fprintf(stderr, "invalid channels count %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'd':
+                params.i_seconds = __MAX(atoi(optarg), 1);
+                break;
+            case 'f':
+                if (!strcasecmp(optarg, "s16n") || !strcasecmp(optarg, "s16l"))
+                    i_format = VLC_CODEC_S16N;
+                else if (!strcasecmp(optarg, "fl32"))
+                    i_format = VLC_CODEC_FL32;
+                else
+                {
+                    fprintf(stderr, "unsupported format %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'i':
+                i_rate_in = __MAX(atoi(optarg), 1);
+                break;
+            case 'o':
+                i_rate_out = __MAX(atoi(optarg), 1);
+                break;
+            case 'O':
+                args[i_args++] = optarg;
+                break;
+            case 'R':
+                params.f_rate = atof(optarg);
+                if (!(params.f_rate > 0.f))
+                {
+                    fprintf(stderr, "invalid playback rate %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                params.b_time_stretch = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+
+    format_init(&params.fmt_in, i_format, i_rate_in, i_channels);
+    format_init(&params.fmt_out, VLC_CODEC_FL32, i_rate_out, i_channels);
+
+    libvlc_instance_t *vlc = bench_init(i_args, args);
+    if (vlc == NULL)
+        return 1;
+    vlc_LogSet(vlc->p_libvlc_int, &log_ops, NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    printf("%u Hz -> %u Hz, %u channels, %u s in %u ms blocks, rate %.2f%s\n",
+           i_rate_in, i_rate_out, i_channels, params.i_seconds,
+           params.i_block_ms, params.f_rate,
+           params.b_time_stretch ? " (time-stretched)" : "");
+
+    if (optind < argc)
+        for (int i = optind; i < argc; i++)
+            bench_resampler(obj, &params, argv[i], psz_filters);
+    else
+        for (size_t i = 0; i < ARRAY_SIZE(resamplers); i++)
+            bench_resampler(obj, &params, resamplers[i], psz_filters);
+
+    libvlc_release(vlc);
+    return 0;
+}
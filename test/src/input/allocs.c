@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * allocs.c: steady-state allocations of the input pipeline
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Plays a mock video through the raw video decoder and the dummy video
+ * output, and checks that the demuxer, the decoder and the video output do
+ * not allocate anymore once the pipeline is running: the blocks and the
+ * pictures must be recycled.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <inttypes.h>
+
+#include <vlc_common.h>
+#include <vlc_player.h>
+#include <vlc_memstats.h>
+
+#define WARMUP_DELAY VLC_TICK_FROM_SEC(3)
+#define MEASURE_DELAY VLC_TICK_FROM_SEC(2)
+
+static const char *const stage_names[VLC_MEM_STAGE_COUNT] = {
+    "other", "demux", "packetizer", "decoder", "video output", "audio output",
+};
+
+struct ctx
+{
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+    unsigned stats_count;
+    bool stopped;
+};
+
+static void
+player_on_state_changed(vlc_player_t *player, enum vlc_player_state state,
+                        void *data)
+{
+    struct ctx *ctx = data;
+    (void) player;
+
+    if (state != VLC_PLAYER_STATE_STOPPED)
+        return;
+    vlc_mutex_lock(&ctx->lock);
+    ctx->stopped = true;
+    vlc_cond_signal(&ctx->wait);
+    vlc_mutex_unlock(&ctx->lock);
+}
+
+static void
+player_on_statistics_changed(vlc_player_t *player,
+                             const struct input_stats_t *stats, void *data)
+{
+    struct ctx *ctx = data;
+    (void) player;
+
+    for (size_t i = 0; i < VLC_MEM_STAGE_COUNT; i++)
+        assert(stats->f_allocations[i] >= 0.f);
+
+    vlc_mutex_lock(&ctx->lock);
+    ctx->stats_count++;
+    vlc_mutex_unlock(&ctx->lock);
+}
+
+/* Waits without any allocation from the test thread */
+static bool
+ctx_sleep(struct ctx *ctx, vlc_tick_t delay)
+{
+    const vlc_tick_t deadline = vlc_tick_now() + delay;
+    bool stopped;
+
+    vlc_mutex_lock(&ctx->lock);
+    while (!ctx->stopped
+        && vlc_cond_timedwait(&ctx->wait, &ctx->lock, deadline) == 0);
+    stopped = ctx->stopped;
+    vlc_mutex_unlock(&ctx->lock);
+    return !stopped;
+}
+
+int
+main(void)
+{
+    test_init();
+
+    static const char *const args[] = {
+        "-v",
+        "--ignore-config",
+        "--no-media-library",
+        "--mem-stats=3600",
+        "--codec=rawvideo,none",
+        "--dec-dev=none",
+        "--vout=dummy",
+        "--no-video-title-show",
+        "--no-spu",
+        "--no-osd",
+    };
+    libvlc_instance_t *vlc = libvlc_new(ARRAY_SIZE(args), args);
+    assert(vlc != NULL);
+
+    struct ctx ctx = { .stats_count = 0, .stopped = false };
+    vlc_mutex_init(&ctx.lock);
+    vlc_cond_init(&ctx.wait);
+
+    static const struct vlc_player_cbs cbs = {
+        .on_state_changed = player_on_state_changed,
+        .on_statistics_changed = player_on_statistics_changed,
+    };
+
+    vlc_player_t *player = vlc_player_New(VLC_OBJECT(vlc->p_libvlc_int),
+                                          VLC_PLAYER_LOCK_NORMAL, NULL, NULL);
+    assert(player != NULL);
+
+    input_item_t *item =
+        input_item_New("mock://video_track_count=1;audio_track_count=0;"
+                       "video_width=160;video_height=120;"
+                       "video_frame_rate=50;video_frame_rate_base=1;"
+                       "length=60000000", "allocs");
+    assert(item != NULL);
+
+    vlc_player_Lock(player);
+    vlc_player_listener_id *listener =
+        vlc_player_AddListener(player, &cbs, &ctx);
+    assert(listener != NULL);
+    int ret = vlc_player_SetCurrentMedia(player, item);
+    assert(ret == VLC_SUCCESS);
+    ret = vlc_player_Start(player);
+    assert(ret == VLC_SUCCESS);
+    vlc_player_Unlock(player);
+    input_item_Release(item);
+
+    /* Let the pools and the caches fill up */
+    bool running = ctx_sleep(&ctx, WARMUP_DELAY);
+    assert(running);
+
+    uint64_t before[VLC_MEM_STAGE_COUNT], after[VLC_MEM_STAGE_COUNT];
+
+    vlc_mem_GetAllocations(before);
+    running = ctx_sleep(&ctx, MEASURE_DELAY);
+    vlc_mem_GetAllocations(after);
+    assert(running);
+
+    for (size_t i = 0; i < VLC_MEM_STAGE_COUNT; i++)
+        fprintf(stderr, "%s: %"PRIu64" allocations in steady state\n",
+                stage_names[i], after[i] - before[i]);
+
+    assert(after[VLC_MEM_STAGE_DEMUX] == before[VLC_MEM_STAGE_DEMUX]);
+    assert(after[VLC_MEM_STAGE_DECODER] == before[VLC_MEM_STAGE_DECODER]);
+    assert(after[VLC_MEM_STAGE_VOUT] == before[VLC_MEM_STAGE_VOUT]);
+
+    vlc_mutex_lock(&ctx.lock);
+    assert(ctx.stats_count > 0);
+    vlc_mutex_unlock(&ctx.lock);
+
+    vlc_player_Lock(player);
+    vlc_player_Stop(player);
+    vlc_player_RemoveListener(player, listener);
+    vlc_player_Unlock(player);
+
+    vlc_player_Delete(player);
+    libvlc_release(vlc);
+    return 0;
+}
@@ -37,6 +37,9 @@ struct vlc_run_args
 
     /* true to test demux controls */
     bool test_demux_controls;
+
+    /* number of benchmark runs per input, 0 to not benchmark */
+    unsigned benchmark;
 };
 
 void vlc_run_args_init(struct vlc_run_args *args);
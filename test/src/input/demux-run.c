@@ -46,13 +46,24 @@
 
 #include <vlc/vlc.h>
 
+#ifdef HAVE_GETRUSAGE
+# include <sys/resource.h>
+#endif
+
 #include "demux-run.h"
 #include "decoder.h"
 
+struct demux_stats
+{
+    uintmax_t packets; /* blocks sent to the ES output */
+    uintmax_t bytes; /* payload of these blocks */
+};
+
 struct test_es_out_t
 {
     struct es_out_t out;
     struct es_out_id_t *ids;
+    struct demux_stats stats;
 #ifdef HAVE_DECODERS
     vlc_object_t *parent;
 #endif
@@ -67,9 +78,11 @@ struct es_out_id_t
 #endif
 };
 
-static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+static es_out_id_t *EsOutAdd(es_out_t *out, input_source_t *in,
+                             const es_format_t *fmt)
 {
     struct test_es_out_t *ctx = (struct test_es_out_t *) out;
+    (void) in;
 
     if (fmt->i_group < 0)
         return NULL;
@@ -106,6 +119,8 @@ static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *block)
 
     //debug("[%p] Sent    ES: %zu\n", (void *)idd, block->i_buffer);
     EsOutCheckId(ctx, id);
+    ctx->stats.packets++;
+    ctx->stats.bytes += block->i_buffer;
 #ifdef HAVE_DECODERS
     if (id->decoder)
         test_decoder_process(id->decoder, block);
@@ -146,9 +161,11 @@ static void EsOutDelete(es_out_t *out, es_out_id_t *id)
     IdDelete(id);
 }
 
-static int EsOutControl(es_out_t *out, int query, va_list args)
+static int EsOutControl(es_out_t *out, input_source_t *in, int query,
+                        va_list args)
 {
     struct test_es_out_t *ctx = (struct test_es_out_t *) out;
+    (void) in;
 
     switch (query)
     {
@@ -230,6 +247,8 @@ static es_out_t *test_es_out_create(vlc_object_t *parent)
     }
 
     ctx->ids = NULL;
+    ctx->stats.packets = 0;
+    ctx->stats.bytes = 0;
 
     es_out_t *out = &ctx->out;
     out->cbs = &es_out_cbs;
@@ -279,7 +298,8 @@ static void demux_get_meta(demux_t *demux)
     vlc_meta_Delete(p_meta);
 }
 
-static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
+static int demux_process_stream(const struct vlc_run_args *args, stream_t *s,
+                                struct demux_stats *stats)
 {
     const char *name = args->name;
     if (name == NULL)
@@ -329,6 +349,8 @@ static int demux_process_stream(const struct vlc_run_args *args, stream_t *s)
     }
 
     demux_Delete(demux);
+    if (stats != NULL)
+        *stats = ((struct test_es_out_t *)out)->stats;
     es_out_Delete(out);
 
     debug("Completed with %" PRIuMAX " iteration(s).\n", i);
@@ -346,13 +368,138 @@ int vlc_demux_process_url(const struct vlc_run_args *args, const char *url)
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream: %s\n", url);
 
-    int ret = demux_process_stream(args, s);
+    int ret = demux_process_stream(args, s, NULL);
+    libvlc_release(vlc);
+    return ret;
+}
+
+static void print_json_string(const char *str)
+{
+    putchar('"');
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+    {
+        if (*p == '"' || *p == '\\')
+            printf("\\%c", *p);
+        else if (*p < 0x20)
+            printf("\\u%04x", *p);
+        else
+            putchar(*p);
+    }
+    putchar('"');
+}
+
+static long peak_rss_kib(void)
+{
+#ifdef HAVE_GETRUSAGE
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+# ifdef __APPLE__
+        return usage.ru_maxrss / 1024; /* bytes */
+# else
+        return usage.ru_maxrss;
+# endif
+#endif
+    return -1;
+}
+
+/**
+ * Benchmarks a demuxer (and decoders if enabled) on a file.
+ *
+ * The file is loaded in memory first so that I/O is not measured. The
+ * fastest of the runs is reported as one JSON object per line on the
+ * standard output.
+ */
+static int demux_bench_path(const struct vlc_run_args *args, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        fprintf(stderr, "Error: cannot open file: %s\n", path);
+        return -1;
+    }
+
+    unsigned char *buf = NULL;
+    size_t length = 0, size = 0;
+
+    for (;;)
+    {
+        if (length == size)
+        {
+            size = size ? size * 2 : 1 << 20;
+            unsigned char *p = realloc(buf, size);
+            if (unlikely(p == NULL))
+            {
+                free(buf);
+                fclose(file);
+                return -1;
+            }
+            buf = p;
+        }
+
+        size_t val = fread(buf + length, 1, size - length, file);
+        if (val == 0)
+            break;
+        length += val;
+    }
+    fclose(file);
+
+    libvlc_instance_t *vlc = libvlc_create(args);
+    if (vlc == NULL)
+    {
+        free(buf);
+        return -1;
+    }
+
+    struct demux_stats stats = { 0, 0 };
+    vlc_tick_t best = INT64_MAX;
+    int ret = 0;
+
+    for (unsigned i = 0; i < args->benchmark && ret == 0; i++)
+    {
+        stream_t *s = vlc_stream_MemoryNew(VLC_OBJECT(vlc->p_libvlc_int),
+                                           buf, length, true);
+        if (s == NULL)
+            fprintf(stderr, "Error: cannot create input stream\n");
+
+        vlc_tick_t start = vlc_tick_now();
+        ret = demux_process_stream(args, s, &stats);
+        vlc_tick_t elapsed = vlc_tick_now() - start;
+
+        if (elapsed < best)
+            best = elapsed;
+    }
+
     libvlc_release(vlc);
+    free(buf);
+
+    double seconds = secf_from_vlc_tick(best > 0 ? best : 1);
+
+    printf("{\"input\":");
+    print_json_string(path);
+    printf(",\"demux\":");
+    print_json_string(args->name != NULL ? args->name : "any");
+#ifdef HAVE_DECODERS
+    printf(",\"decoders\":true");
+#else
+    printf(",\"decoders\":false");
+#endif
+    printf(",\"status\":\"%s\",\"runs\":%u,\"bytes\":%zu"
+           ",\"packets\":%"PRIuMAX",\"es_bytes\":%"PRIuMAX
+           ",\"seconds\":%.6f,\"mb_per_s\":%.2f,\"packets_per_s\":%.0f"
+           ",\"peak_rss_kib\":%ld}\n",
+           ret == 0 ? "ok" : "error", args->benchmark, length,
+           stats.packets, stats.bytes, seconds, length / seconds / 1e6,
+           stats.packets / seconds, peak_rss_kib());
+    fflush(stdout);
     return ret;
 }
 
 int vlc_demux_process_path(const struct vlc_run_args *args, const char *path)
 {
+    if (args->benchmark > 0)
+        return demux_bench_path(args, path);
+
     char *url = vlc_path2uri(path, NULL);
     if (url == NULL)
     {
@@ -374,7 +521,7 @@ int libvlc_demux_process_memory(libvlc_instance_t *vlc,
     if (s == NULL)
         fprintf(stderr, "Error: cannot create input stream\n");
 
-    return demux_process_stream(args, s);
+    return demux_process_stream(args, s, NULL);
 }
 
 int vlc_demux_process_memory(const struct vlc_run_args *args,
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * meta.c: test for the meta table
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "../../libvlc/test.h"
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <vlc_common.h>
+#include <vlc_meta.h>
+#include <assert.h>
+
+int main( void )
+{
+    test_init();
+
+    vlc_meta_t *a = vlc_meta_New();
+    vlc_meta_t *b = vlc_meta_New();
+    assert( a && b );
+
+    /* Interned values are shared between metas */
+    vlc_meta_Set( a, vlc_meta_Artist, "artist" );
+    vlc_meta_Set( b, vlc_meta_Artist, "artist" );
+    assert( vlc_meta_Get( a, vlc_meta_Artist ) == vlc_meta_Get( b, vlc_meta_Artist ) );
+
+    /* Other values are shared by copies only */
+    vlc_meta_Set( a, vlc_meta_Title, "title" );
+    vlc_meta_AddExtra( a, "key", "value" );
+    vlc_meta_Merge( b, a );
+    assert( vlc_meta_Get( a, vlc_meta_Title ) == vlc_meta_Get( b, vlc_meta_Title ) );
+    assert( !strcmp( vlc_meta_GetExtra( b, "key" ), "value" ) );
+
+    /* Changing a copy does not change the original */
+    vlc_meta_Set( b, vlc_meta_Title, "other title" );
+    vlc_meta_Set( b, vlc_meta_Artist, NULL );
+    assert( !strcmp( vlc_meta_Get( a, vlc_meta_Title ), "title" ) );
+    assert( !strcmp( vlc_meta_Get( b, vlc_meta_Title ), "other title" ) );
+    assert( !strcmp( vlc_meta_Get( a, vlc_meta_Artist ), "artist" ) );
+    assert( vlc_meta_Get( b, vlc_meta_Artist ) == NULL );
+
+    /* Values outlive the meta they were copied from */
+    vlc_meta_Merge( b, a );
+    vlc_meta_Delete( a );
+    assert( !strcmp( vlc_meta_Get( b, vlc_meta_Title ), "title" ) );
+    assert( !strcmp( vlc_meta_Get( b, vlc_meta_Artist ), "artist" ) );
+
+    /* The pool is emptied, then reused */
+    vlc_meta_Delete( b );
+    a = vlc_meta_New();
+    assert( a );
+    vlc_meta_Set( a, vlc_meta_Album, "album" );
+    assert( !strcmp( vlc_meta_Get( a, vlc_meta_Album ), "album" ) );
+    vlc_meta_Delete( a );
+    return 0;
+}
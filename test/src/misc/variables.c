@@ -444,6 +444,106 @@ static void test_creation_and_type( libvlc_int_t *p_libvlc )
     assert( var_Get( p_libvlc, "bla", &val ) == VLC_ENOVAR );
 }
 
+#define BENCH_DEPTH 4
+#define BENCH_VARS  64
+#define BENCH_LOOPS 200000
+
+static void bench_log( const char *what, vlc_tick_t start )
+{
+    vlc_tick_t total = vlc_tick_now() - start;
+
+    test_log( "  %-32s %6.1f ns/call\n", what,
+              (double)NS_FROM_VLC_TICK(total) / BENCH_LOOPS );
+}
+
+static void test_inherit( libvlc_int_t *p_libvlc )
+{
+    vlc_object_t *chain[BENCH_DEPTH + 1];
+    char name[16];
+
+    chain[0] = VLC_OBJECT(p_libvlc);
+    for( unsigned i = 1; i <= BENCH_DEPTH; i++ )
+    {
+        chain[i] = vlc_object_create( chain[i - 1], sizeof (vlc_object_t) );
+        assert( chain[i] != NULL );
+    }
+
+    /* Give every object a realistic amount of unrelated variables */
+    for( unsigned i = 0; i <= BENCH_DEPTH; i++ )
+        for( unsigned j = 0; j < BENCH_VARS; j++ )
+        {
+            snprintf( name, sizeof (name), "bench-%u-%u", i, j );
+            var_Create( chain[i], name, VLC_VAR_INTEGER );
+        }
+
+    vlc_object_t *leaf = chain[BENCH_DEPTH];
+    vlc_object_t *mid = chain[BENCH_DEPTH / 2];
+
+    var_Create( p_libvlc, "bench-inherit", VLC_VAR_INTEGER );
+    var_SetInteger( p_libvlc, "bench-inherit", 1 );
+    assert( var_InheritInteger( leaf, "bench-inherit" ) == 1 );
+
+    /* Creating and destroying a closer variable must be seen immediately */
+    var_Create( mid, "bench-inherit", VLC_VAR_INTEGER );
+    var_SetInteger( mid, "bench-inherit", 2 );
+    assert( var_InheritInteger( leaf, "bench-inherit" ) == 2 );
+    var_SetInteger( mid, "bench-inherit", 3 );
+    assert( var_InheritInteger( leaf, "bench-inherit" ) == 3 );
+    var_Destroy( mid, "bench-inherit" );
+    assert( var_InheritInteger( leaf, "bench-inherit" ) == 1 );
+    var_SetInteger( p_libvlc, "bench-inherit", 4 );
+    assert( var_InheritInteger( leaf, "bench-inherit" ) == 4 );
+
+    /* Falling back to the configuration must not hide new variables */
+    int64_t caching = var_InheritInteger( leaf, "file-caching" );
+    var_Create( mid, "file-caching", VLC_VAR_INTEGER );
+    var_SetInteger( mid, "file-caching", caching + 1 );
+    assert( var_InheritInteger( leaf, "file-caching" ) == caching + 1 );
+    var_Destroy( mid, "file-caching" );
+    assert( var_InheritInteger( leaf, "file-caching" ) == caching );
+
+    /* Snapshots go stale on any change */
+    vlc_var_snapshot_t snapshot;
+    var_SnapshotInit( &snapshot );
+    assert( var_SnapshotUpdate( &snapshot ) );
+    assert( !var_SnapshotUpdate( &snapshot ) );
+    var_SetInteger( p_libvlc, "bench-inherit", 5 );
+    assert( var_SnapshotUpdate( &snapshot ) );
+    assert( !var_SnapshotUpdate( &snapshot ) );
+    config_PutInt( "file-caching", caching );
+    assert( var_SnapshotUpdate( &snapshot ) );
+
+    vlc_tick_t start = vlc_tick_now();
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        var_GetInteger( p_libvlc, "bench-inherit" );
+    bench_log( "var_GetInteger()", start );
+
+    start = vlc_tick_now();
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        var_InheritInteger( leaf, "bench-inherit" );
+    bench_log( "var_InheritInteger() from parent", start );
+
+    start = vlc_tick_now();
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        var_InheritInteger( leaf, "file-caching" );
+    bench_log( "var_InheritInteger() from config", start );
+
+    start = vlc_tick_now();
+    for( unsigned i = 0; i < BENCH_LOOPS; i++ )
+        if( var_SnapshotUpdate( &snapshot ) )
+            caching = var_InheritInteger( leaf, "file-caching" );
+    bench_log( "var_SnapshotUpdate()", start );
+
+    var_Destroy( p_libvlc, "bench-inherit" );
+    for( unsigned i = BENCH_DEPTH; i > 0; i-- )
+        vlc_object_delete( chain[i] );
+    for( unsigned j = 0; j < BENCH_VARS; j++ )
+    {
+        snprintf( name, sizeof (name), "bench-0-%u", j );
+        var_Destroy( p_libvlc, name );
+    }
+}
+
 static void test_variables( libvlc_instance_t *p_vlc )
 {
     libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
@@ -481,6 +581,9 @@ static void test_variables( libvlc_instance_t *p_vlc )
 
     test_log( "Testing type at creation\n" );
     test_creation_and_type( p_libvlc );
+
+    test_log( "Testing inheritance\n" );
+    test_inherit( p_libvlc );
 }
 
 
@@ -0,0 +1,629 @@
+/*****************************************************************************
+ * latency.c: player open/seek/switch latency benchmark
+ *****************************************************************************
+ * Copyright (C) 2024 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Plays mock medias through the dummy outputs and measures, in wall clock
+ * time, how long the player takes to display a frame after:
+ *  - vlc_player_Start() (time to first frame),
+ *  - a precise or a fast seek,
+ *  - a video track switch,
+ *  - the end of the previous media (gap between two medias).
+ *
+ * Usage: test_src_player_latency [-a] [-n iterations] [-f fps] [-s WxH]
+ *            [-o open_ms] [-k seek_ms] [-r read_ms] [-p pts_delay_ms]
+ *
+ * The -o, -k and -r options make the mock demuxer sleep when opening,
+ * seeking and for each demux call, to emulate a slow access.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/bench.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+
+#include <vlc_common.h>
+#include <vlc_player.h>
+
+#define BENCH_TIMEOUT VLC_TICK_FROM_SEC(10)
+#define BENCH_SEEK_LENGTH VLC_TICK_FROM_SEC(120)
+#define BENCH_GAP_LENGTH VLC_TICK_FROM_MS(400)
+/* Frames displayed after a seek but that far from the target were already
+ * queued before the flush (the discontinuity may come from the audio) */
+#define BENCH_SEEK_WINDOW VLC_TICK_FROM_SEC(1)
+
+struct stats
+{
+    vlc_tick_t min, max, sum;
+    unsigned count, failed;
+    vlc_tick_t offset_sum;
+};
+
+struct bench_params
+{
+    unsigned width, height, fps;
+    bool audio;
+    vlc_tick_t open_delay, seek_delay, read_delay;
+    unsigned pts_delay_ms;
+};
+
+struct bench
+{
+    vlc_player_t *player;
+    const struct bench_params *params;
+
+    vlc_mutex_t lock;
+    vlc_cond_t wait;
+
+    /* Measurement in progress, protected by lock */
+    bool armed;
+    bool need_discontinuity;
+    bool need_media_change;
+    bool need_track_change;
+    vlc_tick_t target_ts;
+    vlc_tick_t hit_date;
+    vlc_tick_t hit_ts;
+    vlc_tick_t gap_start;
+
+    vlc_tick_t last_frame_date;
+    bool stopped;
+
+    /* Number of medias returned by get_next(), protected by the player lock */
+    unsigned next_count;
+};
+
+static input_item_t *
+bench_media_new(const struct bench_params *params, vlc_tick_t length,
+                unsigned video_tracks)
+{
+    char *url;
+    if (asprintf(&url,
+        "mock://video_track_count=%u;audio_track_count=%u;"
+        "video_width=%u;video_height=%u;"
+        "video_frame_rate=%u;video_frame_rate_base=1;"
+        "length=%"PRId64";pts_delay=%u;"
+        "open_delay=%"PRId64";seek_delay=%"PRId64";read_delay=%"PRId64,
+        video_tracks, params->audio ? 1 : 0, params->width, params->height,
+        params->fps, length, params->pts_delay_ms,
+        params->open_delay, params->seek_delay, params->read_delay) == -1)
+        return NULL;
+
+    input_item_t *item = input_item_New(url, "latency");
+    free(url);
+    return item;
+}
+
+static input_item_t *
+player_get_next(vlc_player_t *player, void *data)
+{
+    struct bench *bench = data;
+    (void) player;
+
+    if (bench->next_count == 0)
+        return NULL;
+    bench->next_count--;
+    return bench_media_new(bench->params, BENCH_GAP_LENGTH, 1);
+}
+
+static void
+player_on_current_media_changed(vlc_player_t *player, input_item_t *new_media,
+                                void *data)
+{
+    struct bench *bench = data;
+    (void) player;
+
+    vlc_mutex_lock(&bench->lock);
+    if (bench->armed && bench->need_media_change && new_media != NULL)
+    {
+        bench->gap_start = bench->last_frame_date;
+        bench->need_media_change = false;
+    }
+    vlc_mutex_unlock(&bench->lock);
+}
+
+static void
+player_on_state_changed(vlc_player_t *player, enum vlc_player_state state,
+                        void *data)
+{
+    struct bench *bench = data;
+    (void) player;
+
+    if (state != VLC_PLAYER_STATE_STOPPED)
+        return;
+    vlc_mutex_lock(&bench->lock);
+    bench->stopped = true;
+    vlc_cond_signal(&bench->wait);
+    vlc_mutex_unlock(&bench->lock);
+}
+
+static void
+player_on_track_selection_changed(vlc_player_t *player,
+                                  vlc_es_id_t *unselected_id,
+                                  vlc_es_id_t *selected_id, void *data)
+{
+    struct bench *bench = data;
+    (void) player; (void) unselected_id;
+
+    if (selected_id == NULL || vlc_es_id_GetCat(selected_id) != VIDEO_ES)
+        return;
+    vlc_mutex_lock(&bench->lock);
+    if (bench->armed)
+        bench->need_track_change = false;
+    vlc_mutex_unlock(&bench->lock);
+}
+
+static void
+timer_on_update(const struct vlc_player_timer_point *point, void *data)
+{
+    (void) point; (void) data;
+}
+
+static void
+timer_on_discontinuity(vlc_tick_t system_date, void *data)
+{
+    struct bench *bench = data;
+
+    /* A VLC_TICK_INVALID date is a flush (seek, track change), otherwise
+     * this is a pause */
+    if (system_date != VLC_TICK_INVALID)
+        return;
+    vlc_mutex_lock(&bench->lock);
+    if (bench->armed)
+        bench->need_discontinuity = false;
+    vlc_mutex_unlock(&bench->lock);
+}
+
+/* Called each time a new video frame is displayed */
+static void
+timer_smpte_on_update(const struct vlc_player_timer_smpte_timecode *tc,
+                      void *data)
+{
+    struct bench *bench = data;
+    const vlc_tick_t now = vlc_tick_now();
+    const vlc_tick_t ts =
+        VLC_TICK_FROM_SEC((tc->hours * 60 + tc->minutes) * 60 + tc->seconds)
+      + VLC_TICK_FROM_SEC(tc->frames) / bench->params->fps;
+
+    vlc_mutex_lock(&bench->lock);
+    bench->last_frame_date = now;
+    if (bench->armed && !bench->need_discontinuity
+     && !bench->need_media_change && !bench->need_track_change
+     && (bench->target_ts == VLC_TICK_INVALID
+      || (ts > bench->target_ts - BENCH_SEEK_WINDOW
+       && ts < bench->target_ts + BENCH_SEEK_WINDOW)))
+    {
+        bench->armed = false;
+        bench->hit_date = now;
+        bench->hit_ts = ts;
+        vlc_cond_signal(&bench->wait);
+    }
+    vlc_mutex_unlock(&bench->lock);
+}
+
+/* Must be called with the player locked, the measurement starts now */
+static vlc_tick_t
+bench_arm(struct bench *bench, bool discontinuity, bool media_change,
+          bool track_change, vlc_tick_t target_ts)
+{
+    vlc_mutex_lock(&bench->lock);
+    bench->armed = true;
+    bench->target_ts = target_ts;
+    bench->need_discontinuity = discontinuity;
+    bench->need_media_change = media_change;
+    bench->need_track_change = track_change;
+    bench->hit_date = VLC_TICK_INVALID;
+    bench->gap_start = VLC_TICK_INVALID;
+    vlc_mutex_unlock(&bench->lock);
+    return vlc_tick_now();
+}
+
+/* Waits for the armed measurement, returns the date of the displayed frame
+ * or VLC_TICK_INVALID on time-out */
+static vlc_tick_t
+bench_wait(struct bench *bench, vlc_tick_t *ts, vlc_tick_t *gap_start)
+{
+    const vlc_tick_t deadline = vlc_tick_now() + BENCH_TIMEOUT;
+
+    vlc_mutex_lock(&bench->lock);
+    while (bench->armed)
+        if (vlc_cond_timedwait(&bench->wait, &bench->lock, deadline))
+            break;
+    bench->armed = false;
+    vlc_tick_t date = bench->hit_date;
+    if (ts != NULL)
+        *ts = bench->hit_ts;
+    if (gap_start != NULL)
+        *gap_start = bench->gap_start;
+    vlc_mutex_unlock(&bench->lock);
+    return date;
+}
+
+static void
+bench_stop(struct bench *bench)
+{
+    vlc_player_Lock(bench->player);
+    vlc_mutex_lock(&bench->lock);
+    bench->stopped = false;
+    vlc_mutex_unlock(&bench->lock);
+    bench->next_count = 0;
+    vlc_player_Stop(bench->player);
+    vlc_player_Unlock(bench->player);
+
+    const vlc_tick_t deadline = vlc_tick_now() + BENCH_TIMEOUT;
+    vlc_mutex_lock(&bench->lock);
+    while (!bench->stopped)
+        if (vlc_cond_timedwait(&bench->wait, &bench->lock, deadline))
+            break;
+    vlc_mutex_unlock(&bench->lock);
+}
+
+static void
+stats_add(struct stats *stats, vlc_tick_t start, vlc_tick_t end)
+{
+    if (start == VLC_TICK_INVALID || end == VLC_TICK_INVALID)
+    {
+        stats->failed++;
+        return;
+    }
+    const vlc_tick_t value = end - start;
+    if (stats->count == 0 || value < stats->min)
+        stats->min = value;
+    if (stats->count == 0 || value > stats->max)
+        stats->max = value;
+    stats->sum += value;
+    stats->count++;
+}
+
+static void
+stats_print(const char *name, const struct stats *stats, bool offset)
+{
+    printf("%-16s", name);
+    if (stats->count == 0)
+        printf(" no measurement");
+    else
+    {
+        printf(" min %7.2f avg %7.2f max %7.2f ms",
+               MS_FROM_VLC_TICK((double) stats->min),
+               MS_FROM_VLC_TICK((double) stats->sum / stats->count),
+               MS_FROM_VLC_TICK((double) stats->max));
+        if (offset)
+            printf(", landed %6.2f ms from target",
+                   MS_FROM_VLC_TICK((double) stats->offset_sum / stats->count));
+    }
+    if (stats->failed > 0)
+        printf(", %u timed out", stats->failed);
+    printf("\n");
+}
+
+/* Lets the playback reach its steady state after the forced first frame */
+static void
+bench_settle(struct bench *bench)
+{
+    vlc_tick_sleep(VLC_TICK_FROM_MS(bench->params->pts_delay_ms)
+                   + VLC_TICK_FROM_MS(200));
+}
+
+/* Opens media and waits for its first frame, returns the latency start */
+static vlc_tick_t
+bench_start(struct bench *bench, input_item_t *media, vlc_tick_t *date)
+{
+    vlc_player_Lock(bench->player);
+    int ret = vlc_player_SetCurrentMedia(bench->player, media);
+    vlc_tick_t start = bench_arm(bench, false, false, false, VLC_TICK_INVALID);
+    if (ret == VLC_SUCCESS)
+        ret = vlc_player_Start(bench->player);
+    vlc_player_Unlock(bench->player);
+    input_item_Release(media);
+
+    *date = ret == VLC_SUCCESS ? bench_wait(bench, NULL, NULL)
+                               : VLC_TICK_INVALID;
+    return start;
+}
+
+static void
+bench_first_frame(struct bench *bench, unsigned iterations)
+{
+    struct stats stats = { 0 };
+
+    for (unsigned i = 0; i < iterations; i++)
+    {
+        input_item_t *media =
+            bench_media_new(bench->params, BENCH_SEEK_LENGTH, 1);
+        if (media == NULL)
+            break;
+        vlc_tick_t date;
+        vlc_tick_t start = bench_start(bench, media, &date);
+        stats_add(&stats, start, date);
+        bench_stop(bench);
+    }
+    stats_print("first frame", &stats, false);
+}
+
+static void
+bench_seek(struct bench *bench, unsigned iterations,
+           enum vlc_player_seek_speed speed)
+{
+    struct stats stats = { 0 };
+    input_item_t *media =
+        bench_media_new(bench->params, BENCH_SEEK_LENGTH, 1);
+    if (media == NULL)
+        return;
+
+    vlc_tick_t date;
+    bench_start(bench, media, &date);
+    if (date != VLC_TICK_INVALID)
+        bench_settle(bench);
+
+    const vlc_tick_t frame_length = VLC_TICK_FROM_SEC(1) / bench->params->fps;
+    const unsigned frame_count =
+        (BENCH_SEEK_LENGTH - VLC_TICK_FROM_SEC(2)) / frame_length;
+    uint32_t seed = 1;
+
+    for (unsigned i = 0; date != VLC_TICK_INVALID && i < iterations; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const vlc_tick_t target = (seed >> 8) % frame_count * frame_length;
+
+        vlc_player_Lock(bench->player);
+        vlc_tick_t start = bench_arm(bench, true, false, false, target);
+        vlc_player_SeekByTime(bench->player, target, speed,
+                              VLC_PLAYER_WHENCE_ABSOLUTE);
+        vlc_player_Unlock(bench->player);
+
+        vlc_tick_t ts;
+        date = bench_wait(bench, &ts, NULL);
+        stats_add(&stats, start, date);
+        if (date != VLC_TICK_INVALID)
+            stats.offset_sum += ts > target ? ts - target : target - ts;
+    }
+    bench_stop(bench);
+    stats_print(speed == VLC_PLAYER_SEEK_PRECISE ? "seek (precise)"
+                                                 : "seek (fast)",
+                &stats, true);
+}
+
+static void
+bench_track_switch(struct bench *bench, unsigned iterations)
+{
+    struct stats stats = { 0 };
+    input_item_t *media =
+        bench_media_new(bench->params, BENCH_SEEK_LENGTH, 2);
+    if (media == NULL)
+        return;
+
+    vlc_tick_t date;
+    bench_start(bench, media, &date);
+    if (date != VLC_TICK_INVALID)
+        bench_settle(bench);
+
+    for (unsigned i = 0; date != VLC_TICK_INVALID && i < iterations; i++)
+    {
+        vlc_player_Lock(bench->player);
+        const struct vlc_player_track *track =
+            vlc_player_GetTrackAt(bench->player, VIDEO_ES, (i + 1) % 2);
+        if (track == NULL)
+        {
+            vlc_player_Unlock(bench->player);
+            break;
+        }
+        vlc_tick_t start = bench_arm(bench, false, false, true, VLC_TICK_INVALID);
+        vlc_player_SelectTrack(bench->player, track,
+                               VLC_PLAYER_SELECT_EXCLUSIVE);
+        vlc_player_Unlock(bench->player);
+
+        date = bench_wait(bench, NULL, NULL);
+        stats_add(&stats, start, date);
+    }
+    bench_stop(bench);
+    stats_print("track switch", &stats, false);
+}
+
+static void
+bench_next_media(struct bench *bench, unsigned iterations)
+{
+    struct stats stats = { 0 };
+
+    for (unsigned i = 0; i < iterations; i++)
+    {
+        input_item_t *media =
+            bench_media_new(bench->params, BENCH_GAP_LENGTH, 1);
+        if (media == NULL)
+            break;
+
+        vlc_player_Lock(bench->player);
+        bench->next_count = 1;
+        vlc_player_Unlock(bench->player);
+
+        vlc_tick_t date;
+        bench_start(bench, media, &date);
+        if (date != VLC_TICK_INVALID)
+        {
+            /* Arm before the end of the first media */
+            vlc_player_Lock(bench->player);
+            bench_arm(bench, false, true, false, VLC_TICK_INVALID);
+            vlc_player_Unlock(bench->player);
+
+            vlc_tick_t gap_start;
+            date = bench_wait(bench, NULL, &gap_start);
+            stats_add(&stats, gap_start, date);
+        }
+        else
+            stats.failed++;
+        bench_stop(bench);
+    }
+    stats_print("next media gap", &stats, false);
+}
+
+static int
+parse_size(const char *psz, unsigned *pi_width, unsigned *pi_height)
+{
+    if (sscanf(psz, "%ux%u", pi_width, pi_height) != 2
+     || *pi_width == 0 || *pi_height == 0)
+    {
+        fprintf(stderr, "invalid size %s\n", psz);
+        return -1;
+    }
+    return 0;
+}
+
+static void
+usage(const char *psz_name)
+{
+    fprintf(stderr, "Usage: %s [-a] [-v] [-n iterations] [-f fps] [-s WxH] "
+            "[-o open_ms] [-k seek_ms] [-r read_ms] [-p pts_delay_ms]\n",
+            psz_name);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct bench_params params = {
+        .width = 320, .height = 240, .fps = 25,
+        .pts_delay_ms = MS_FROM_VLC_TICK(DEFAULT_PTS_DELAY),
+    };
+    unsigned iterations = 20;
+    bool verbose = false;
+    int c;
+
+    while ((c = getopt(argc, argv, "af:k:n:o:p:r:s:v")) != -1)
+        switch (c)
+        {
+            case 'a':
+                params.audio = true;
+                break;
+            case 'f':
+                params.fps = __MAX(atoi(optarg), 1);
+                break;
+            case 'k':
+                params.seek_delay = VLC_TICK_FROM_MS(atoi(optarg));
+                break;
+            case 'n':
+                iterations = __MAX(atoi(optarg), 1);
+                break;
+            case 'o':
+                params.open_delay = VLC_TICK_FROM_MS(atoi(optarg));
+                break;
+            case 'p':
+                params.pts_delay_ms = atoi(optarg);
+                break;
+            case 'r':
+                params.read_delay = VLC_TICK_FROM_MS(atoi(optarg));
+                break;
+            case 's':
+                if (parse_size(optarg, &params.width, &params.height))
+                    return 1;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+
+    const char *const args[] = {
+        verbose ? "-v" : "--quiet",
+        "--ignore-config",
+        "-Idummy",
+        "--no-media-library",
+        "--no-drop-late-frames",
+        "--codec=araw,rawvideo,none",
+        "--dec-dev=none",
+        "--vout=dummy",
+        "--aout=dummy",
+    };
+    libvlc_instance_t *vlc = bench_init(ARRAY_SIZE(args), args);
+    if (vlc == NULL)
+        return 1;
+    var_SetString(vlc->p_libvlc_int, "window", "wdummy");
+
+    static const struct vlc_player_media_provider provider = {
+        .get_next = player_get_next,
+    };
+    static const struct vlc_player_cbs cbs = {
+        .on_current_media_changed = player_on_current_media_changed,
+        .on_state_changed = player_on_state_changed,
+        .on_track_selection_changed = player_on_track_selection_changed,
+    };
+    static const struct vlc_player_timer_cbs timer_cbs = {
+        .on_update = timer_on_update,
+        .on_discontinuity = timer_on_discontinuity,
+    };
+    static const struct vlc_player_timer_smpte_cbs smpte_cbs = {
+        .on_update = timer_smpte_on_update,
+    };
+
+    struct bench bench = { .params = &params };
+    vlc_mutex_init(&bench.lock);
+    vlc_cond_init(&bench.wait);
+
+    int ret = 1;
+    bench.player = vlc_player_New(VLC_OBJECT(vlc->p_libvlc_int),
+                                  VLC_PLAYER_LOCK_NORMAL, &provider, &bench);
+    if (bench.player == NULL)
+        goto end;
+
+    vlc_player_Lock(bench.player);
+    vlc_player_listener_id *listener =
+        vlc_player_AddListener(bench.player, &cbs, &bench);
+    vlc_player_Unlock(bench.player);
+    vlc_player_timer_id *timer =
+        vlc_player_AddTimer(bench.player, VLC_TICK_INVALID, &timer_cbs,
+                            &bench);
+    vlc_player_timer_id *smpte_timer =
+        vlc_player_AddSmpteTimer(bench.player, &smpte_cbs, &bench);
+
+    if (listener != NULL && timer != NULL && smpte_timer != NULL)
+    {
+        printf("%ux%u@%u%s, open %"PRId64" ms, seek %"PRId64" ms, "
+               "read %"PRId64" ms, pts-delay %u ms, %u iterations\n",
+               params.width, params.height, params.fps,
+               params.audio ? " + audio" : "",
+               MS_FROM_VLC_TICK(params.open_delay),
+               MS_FROM_VLC_TICK(params.seek_delay),
+               MS_FROM_VLC_TICK(params.read_delay),
+               params.pts_delay_ms, iterations);
+
+        bench_first_frame(&bench, iterations);
+        bench_seek(&bench, iterations, VLC_PLAYER_SEEK_PRECISE);
+        bench_seek(&bench, iterations, VLC_PLAYER_SEEK_FAST);
+        bench_track_switch(&bench, iterations);
+        bench_next_media(&bench, iterations);
+        ret = 0;
+    }
+
+    if (smpte_timer != NULL)
+        vlc_player_RemoveTimer(bench.player, smpte_timer);
+    if (timer != NULL)
+        vlc_player_RemoveTimer(bench.player, timer);
+    vlc_player_Lock(bench.player);
+    if (listener != NULL)
+        vlc_player_RemoveListener(bench.player, listener);
+    vlc_player_Unlock(bench.player);
+    vlc_player_Delete(bench.player);
+end:
+    libvlc_release(vlc);
+    return ret;
+}